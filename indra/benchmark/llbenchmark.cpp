@@ -0,0 +1,210 @@
+/**
+ * @file llbenchmark.cpp
+ * @brief Microbenchmark registry, runner and main().
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+#include "llbenchmark.h"
+
+#include "llapr.h"
+#include "llerrorcontrol.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	struct Benchmark
+	{
+		const char* mName;
+		benchmark_func_t mFunc;
+	};
+
+	// function local so registration from other files' statics is safe
+	std::vector<Benchmark>& benchmarks()
+	{
+		static std::vector<Benchmark> sBenchmarks;
+		return sBenchmarks;
+	}
+
+	const void* volatile sEscaped = NULL;
+}
+
+LLBenchmarkState::LLBenchmarkState(U64 iterations)
+:	mIterations(iterations),
+	mRemaining(iterations),
+	mItems(0),
+	mElapsed(0.0),
+	mRunning(false)
+{
+}
+
+void LLBenchmarkState::pauseTiming()
+{
+	if (mRunning)
+	{
+		mElapsed += mTimer.getElapsedTimeF64();
+		mRunning = false;
+	}
+}
+
+void LLBenchmarkState::resumeTiming()
+{
+	if (!mRunning)
+	{
+		mTimer.reset();
+		mRunning = true;
+	}
+}
+
+bool llbenchmark::registerBenchmark(const char* name, benchmark_func_t func)
+{
+	benchmarks().push_back({ name, func });
+	return true;
+}
+
+void llbenchmark::escape(const void* value)
+{
+	sEscaped = value;
+}
+
+static void usage(const char* program)
+{
+	std::cout << "Usage: " << program << " [--filter=substring] [--min-time=seconds] [--csv=file] [--list]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+	std::string csv_file;
+	F64 min_time = 0.5;
+	bool list = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if (arg.compare(0, 9, "--filter=") == 0)
+		{
+			filter = arg.substr(9);
+		}
+		else if (arg.compare(0, 11, "--min-time=") == 0)
+		{
+			min_time = atof(arg.substr(11).c_str());
+		}
+		else if (arg.compare(0, 6, "--csv=") == 0)
+		{
+			csv_file = arg.substr(6);
+		}
+		else if (arg == "--list")
+		{
+			list = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	LLError::initForApplication(".", ".", false);
+	LLError::setDefaultLevel(LLError::LEVEL_WARN);
+	ll_init_apr();
+
+	std::ofstream csv;
+	if (!csv_file.empty())
+	{
+		csv.open(csv_file.c_str());
+		if (!csv.is_open())
+		{
+			std::cerr << "Unable to write " << csv_file << std::endl;
+			return 1;
+		}
+		csv << "name,iterations,ns_per_iteration,items_per_second\n";
+	}
+
+	std::cout << std::left << std::setw(40) << "benchmark" << std::right
+			  << std::setw(14) << "iterations" << std::setw(16) << "ns/iter" << std::setw(16) << "items/s" << std::endl;
+
+	for (const Benchmark& benchmark : benchmarks())
+	{
+		if (!filter.empty() && strstr(benchmark.mName, filter.c_str()) == NULL)
+		{
+			continue;
+		}
+		if (list)
+		{
+			std::cout << benchmark.mName << std::endl;
+			continue;
+		}
+
+		// grow the iteration count until one run takes at least min_time,
+		// guessing from the last run so short bodies don't take forever
+		U64 iterations = 1;
+		F64 elapsed = 0.0;
+		U64 items = 0;
+		while (true)
+		{
+			LLBenchmarkState state(iterations);
+			benchmark.mFunc(state);
+			elapsed = state.getElapsed();
+			items = state.getItemsProcessed();
+			if (elapsed >= min_time || iterations >= (1ULL << 40))
+			{
+				break;
+			}
+			F64 scale = elapsed > 0.0 ? llclamp(min_time * 1.4 / elapsed, 2.0, 10.0) : 10.0;
+			iterations = (U64)(iterations * scale) + 1;
+		}
+
+		F64 ns_per_iteration = elapsed * 1.0e9 / (F64)iterations;
+		F64 items_per_second = elapsed > 0.0 ? (F64)items / elapsed : 0.0;
+
+		std::cout << std::left << std::setw(40) << benchmark.mName << std::right
+				  << std::setw(14) << iterations
+				  << std::setw(16) << std::fixed << std::setprecision(1) << ns_per_iteration
+				  << std::setw(16) << std::setprecision(0);
+		if (items)
+		{
+			std::cout << items_per_second;
+		}
+		std::cout << std::endl;
+
+		if (csv.is_open())
+		{
+			csv << benchmark.mName << "," << iterations << "," << ns_per_iteration << ",";
+			if (items)
+			{
+				csv << items_per_second;
+			}
+			csv << "\n";
+		}
+	}
+
+	ll_cleanup_apr();
+	return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file llbenchmark.h
+ * @brief Minimal microbenchmark harness.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#ifndef LL_LLBENCHMARK_H
+#define LL_LLBENCHMARK_H
+
+#include "lltimer.h"
+
+#include <string>
+
+// Passed to every benchmark. The body runs the code under test once per
+// keepRunning() call; timing starts at the first call, so setup written
+// before the loop is not measured.
+//
+//	LL_BENCHMARK(uuid_hash)
+//	{
+//		LLUUID id;
+//		id.generate();
+//		while (state.keepRunning())
+//		{
+//			llbenchmark::doNotOptimize(boost::hash<LLUUID>()(id));
+//		}
+//	}
+class LLBenchmarkState
+{
+public:
+	LLBenchmarkState(U64 iterations);
+
+	bool keepRunning()
+	{
+		if (mRemaining == mIterations)
+		{
+			mTimer.reset();
+			mRunning = true;
+		}
+		if (mRemaining == 0)
+		{
+			pauseTiming();
+			return false;
+		}
+		--mRemaining;
+		return true;
+	}
+
+	// exclude per-iteration setup, both are expensive next to a tiny body
+	void pauseTiming();
+	void resumeTiming();
+
+	// for a throughput column, e.g. messages or bytes per iteration * iterations
+	void setItemsProcessed(U64 items) { mItems = items; }
+
+	U64 getIterations() const { return mIterations; }
+	U64 getItemsProcessed() const { return mItems; }
+	F64 getElapsed() const { return mElapsed; }
+
+private:
+	U64 mIterations;
+	U64 mRemaining;
+	U64 mItems;
+	F64 mElapsed;
+	bool mRunning;
+	LLTimer mTimer;
+};
+
+typedef void (*benchmark_func_t)(LLBenchmarkState& state);
+
+namespace llbenchmark
+{
+	// returns true so it can initialize a static at namespace scope
+	bool registerBenchmark(const char* name, benchmark_func_t func);
+
+	// defined in another translation unit so the compiler can't drop the
+	// computation that produced value
+	void escape(const void* value);
+
+	template <typename T>
+	inline void doNotOptimize(const T& value)
+	{
+		escape(&value);
+	}
+}
+
+#define LL_BENCHMARK(name) \
+	static void bench_##name(LLBenchmarkState& state); \
+	static bool bench_##name##_registered = llbenchmark::registerBenchmark(#name, bench_##name); \
+	static void bench_##name(LLBenchmarkState& state)
+
+#endif // LL_LLBENCHMARK_H
@@ -0,0 +1,292 @@
+/**
+ * @file llmath_bench.cpp
+ * @brief LLVector4a, LLMatrix4a and LLOctree benchmarks.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+#include "llbenchmark.h"
+
+#include "llmath.h"
+#include "llvector4a.h"
+#include "llmatrix4a.h"
+#include "lloctree.h"
+
+#include <vector>
+
+namespace
+{
+	const U32 NUM_VECTORS = 1024;
+
+	U32 sSeed = 12345;
+
+	// deterministic so runs compare
+	F32 nextRandom()
+	{
+		sSeed = sSeed * 1664525 + 1013904223;
+		return (F32)(sSeed >> 8) / (F32)(1 << 24);
+	}
+
+	std::vector<LLVector4a> makeVectors(U32 count)
+	{
+		std::vector<LLVector4a> vectors(count);
+		for (LLVector4a& v : vectors)
+		{
+			v.set(nextRandom() * 256.f, nextRandom() * 256.f, nextRandom() * 256.f, 1.f);
+		}
+		return vectors;
+	}
+
+	LLMatrix4a makeMatrix()
+	{
+		LLMatrix4a mat;
+		mat.setIdentity();
+		mat.mMatrix[0].set(0.8f, 0.6f, 0.f, 0.f);
+		mat.mMatrix[1].set(-0.6f, 0.8f, 0.f, 0.f);
+		mat.mMatrix[3].set(10.f, 20.f, 30.f, 1.f);
+		return mat;
+	}
+
+	// same element shape as the one the octree unit test uses
+	class BenchElement
+	{
+	public:
+		BenchElement(const LLVector4a& position, F32 radius) :
+			mPosition(position),
+			mRadius(radius),
+			mBinIndex(-1)
+		{}
+
+		const LLVector4a& getPositionGroup() const { return mPosition; }
+		F32 getBinRadius() const { return mRadius; }
+		S32 getBinIndex() const { return mBinIndex; }
+		void setBinIndex(S32 idx) const { mBinIndex = idx; }
+
+	private:
+		LLVector4a mPosition;
+		F32 mRadius;
+		mutable S32 mBinIndex;
+	};
+
+	typedef LLOctreeNode<BenchElement, BenchElement*> BenchNode;
+	typedef LLOctreeRoot<BenchElement, BenchElement*> BenchRoot;
+
+	class CountTraveler : public LLOctreeTraveler<BenchElement, BenchElement*>
+	{
+	public:
+		void visit(const BenchNode* branch) override
+		{
+			mElements += branch->getElementCount();
+		}
+
+		U32 mElements = 0;
+	};
+
+	const U32 NUM_ELEMENTS = 10000;
+
+	std::vector<BenchElement> makeElements()
+	{
+		// the viewer's defaults for OctreeMaxNodeCapacity and OctreeMinimumNodeSize
+		gOctreeMaxCapacity = 128;
+		gOctreeMinSize = 0.01f;
+
+		std::vector<BenchElement> elements;
+		elements.reserve(NUM_ELEMENTS);
+		for (U32 i = 0; i < NUM_ELEMENTS; ++i)
+		{
+			LLVector4a pos(nextRandom() * 256.f, nextRandom() * 256.f, nextRandom() * 256.f);
+			elements.emplace_back(pos, 0.1f + nextRandom() * 4.f);
+		}
+		return elements;
+	}
+
+	BenchRoot* makeRoot()
+	{
+		LLVector4a center(128.f, 128.f, 128.f);
+		LLVector4a size(128.f, 128.f, 128.f);
+		return new BenchRoot(center, size, NULL);
+	}
+}
+
+LL_BENCHMARK(llvector4a_dot3)
+{
+	std::vector<LLVector4a> vectors = makeVectors(NUM_VECTORS);
+	F32 sum = 0.f;
+	U32 i = 0;
+	while (state.keepRunning())
+	{
+		sum += vectors[i].dot3(vectors[(i + 1) % NUM_VECTORS]).getF32();
+		i = (i + 1) % NUM_VECTORS;
+	}
+	llbenchmark::doNotOptimize(sum);
+}
+
+LL_BENCHMARK(llvector4a_cross3_normalize3fast)
+{
+	std::vector<LLVector4a> vectors = makeVectors(NUM_VECTORS);
+	LLVector4a sum;
+	sum.clear();
+	U32 i = 0;
+	while (state.keepRunning())
+	{
+		LLVector4a cross;
+		cross.setCross3(vectors[i], vectors[(i + 1) % NUM_VECTORS]);
+		cross.normalize3fast();
+		sum.add(cross);
+		i = (i + 1) % NUM_VECTORS;
+	}
+	llbenchmark::doNotOptimize(sum);
+}
+
+LL_BENCHMARK(llvector4a_bounding_box)
+{
+	std::vector<LLVector4a> vectors = makeVectors(NUM_VECTORS);
+	while (state.keepRunning())
+	{
+		LLVector4a min = vectors[0];
+		LLVector4a max = vectors[0];
+		for (const LLVector4a& v : vectors)
+		{
+			min.setMin(min, v);
+			max.setMax(max, v);
+		}
+		llbenchmark::doNotOptimize(min);
+		llbenchmark::doNotOptimize(max);
+	}
+	state.setItemsProcessed(state.getIterations() * NUM_VECTORS);
+}
+
+LL_BENCHMARK(llmatrix4a_affine_transform)
+{
+	std::vector<LLVector4a> vectors = makeVectors(NUM_VECTORS);
+	std::vector<LLVector4a> results(NUM_VECTORS);
+	LLMatrix4a mat = makeMatrix();
+	while (state.keepRunning())
+	{
+		for (U32 i = 0; i < NUM_VECTORS; ++i)
+		{
+			mat.affineTransform(vectors[i], results[i]);
+		}
+		llbenchmark::doNotOptimize(results);
+	}
+	state.setItemsProcessed(state.getIterations() * NUM_VECTORS);
+}
+
+LL_BENCHMARK(llmatrix4a_mat_mul)
+{
+	LLMatrix4a a = makeMatrix();
+	LLMatrix4a b = makeMatrix();
+	LLMatrix4a res;
+	while (state.keepRunning())
+	{
+		matMul(a, b, res);
+		a = res;
+	}
+	llbenchmark::doNotOptimize(res);
+}
+
+LL_BENCHMARK(llmatrix4a_bound_box)
+{
+	LLMatrix4a mat = makeMatrix();
+	LLVector4a in[2];
+	in[0].set(-1.f, -2.f, -3.f);
+	in[1].set(1.f, 2.f, 3.f);
+	LLVector4a out[2];
+	while (state.keepRunning())
+	{
+		matMulBoundBox(mat, in, out);
+		llbenchmark::doNotOptimize(out);
+	}
+}
+
+LL_BENCHMARK(lloctree_insert)
+{
+	std::vector<BenchElement> elements = makeElements();
+	while (state.keepRunning())
+	{
+		BenchRoot* root = makeRoot();
+		for (BenchElement& element : elements)
+		{
+			root->insert(&element);
+		}
+
+		state.pauseTiming();
+		for (BenchElement& element : elements)
+		{
+			root->remove(&element);
+		}
+		delete root;
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.getIterations() * NUM_ELEMENTS);
+}
+
+LL_BENCHMARK(lloctree_remove)
+{
+	std::vector<BenchElement> elements = makeElements();
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		BenchRoot* root = makeRoot();
+		for (BenchElement& element : elements)
+		{
+			root->insert(&element);
+		}
+		state.resumeTiming();
+
+		for (BenchElement& element : elements)
+		{
+			root->remove(&element);
+		}
+
+		state.pauseTiming();
+		delete root;
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.getIterations() * NUM_ELEMENTS);
+}
+
+LL_BENCHMARK(lloctree_traverse)
+{
+	std::vector<BenchElement> elements = makeElements();
+	BenchRoot* root = makeRoot();
+	for (BenchElement& element : elements)
+	{
+		root->insert(&element);
+	}
+
+	while (state.keepRunning())
+	{
+		CountTraveler traveler;
+		traveler.traverse(root);
+		llbenchmark::doNotOptimize(traveler.mElements);
+	}
+	state.setItemsProcessed(state.getIterations() * NUM_ELEMENTS);
+
+	for (BenchElement& element : elements)
+	{
+		root->remove(&element);
+	}
+	delete root;
+}
@@ -0,0 +1,361 @@
+/**
+ * @file llmessage_bench.cpp
+ * @brief Data packer and template message benchmarks.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+#include "llbenchmark.h"
+
+#include "lldatapacker.h"
+#include "llhost.h"
+#include "llmessagetemplate.h"
+#include "llpacketreceiver.h"
+#include "llpacketring.h"
+#include "llrand.h"
+#include "lltemplatemessagebuilder.h"
+#include "lltemplatemessagereader.h"
+#include "lluuid.h"
+#include "llzerocode.h"
+#include "message.h"
+#include "message_prehash.h"
+#include "v3math.h"
+
+namespace
+{
+	const S32 PACKER_BUFFER_SIZE = 1024;
+	const S32 NUM_BLOCKS = 32;
+
+	// pack the fields of a typical object update
+	void packObject(LLDataPackerBinaryBuffer& dp, const LLUUID& id, U32 i)
+	{
+		dp.packUUID(id, "id");
+		dp.packU32(i, "local_id");
+		dp.packU8((U8)i, "material");
+		dp.packU16((U16)i, "flags");
+		dp.packVector3(LLVector3(128.f, 64.f, 22.5f), "position");
+		dp.packVector3(LLVector3(0.5f, 0.5f, 0.5f), "scale");
+		dp.packF32(0.25f, "alpha");
+		dp.packString("object name", "name");
+	}
+
+	void unpackObject(LLDataPackerBinaryBuffer& dp, LLUUID& id, U32& local_id, LLVector3& position)
+	{
+		U8 material;
+		U16 flags;
+		LLVector3 scale;
+		F32 alpha;
+		std::string name;
+		dp.unpackUUID(id, "id");
+		dp.unpackU32(local_id, "local_id");
+		dp.unpackU8(material, "material");
+		dp.unpackU16(flags, "flags");
+		dp.unpackVector3(position, "position");
+		dp.unpackVector3(scale, "scale");
+		dp.unpackF32(alpha, "alpha");
+		dp.unpackString(name, "name");
+	}
+
+	void noHandler(LLMessageSystem*, void**)
+	{
+	}
+
+	// The template reader reports through gMessageSystem, so one has to
+	// exist. The port is not the unit tests' so both can run at once.
+	LLMessageTemplate* testTemplate()
+	{
+		static LLMessageTemplate* sTemplate = NULL;
+		if (!sTemplate)
+		{
+			start_messaging_system("notafile", 13036, 1, 0, 0, FALSE, "notasharedsecret", NULL, false, 5.f, 100.f);
+
+			sTemplate = new LLMessageTemplate(_PREHASH_TestMessage, 1, MFT_HIGH);
+			LLMessageBlock* block = new LLMessageBlock(const_cast<char*>(_PREHASH_Test0), MBT_VARIABLE);
+			block->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+			block->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_LLVector3, 12);
+			block->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_LLUUID, 16);
+			sTemplate->addBlock(block);
+			sTemplate->setHandlerFunc(noHandler, NULL);
+		}
+		return sTemplate;
+	}
+
+	const size_t MAX_TEST_PACKETS = 1024;
+
+	// Datagrams as they come off the wire. LL_BENCHMARK_PACKETS can name a
+	// capture written with PacketCaptureFile; otherwise they're made up to
+	// look like object updates, short runs of data between runs of zeroes.
+	const std::vector<std::vector<U8> >& testPackets()
+	{
+		static std::vector<std::vector<U8> > sPackets;
+		if (sPackets.empty())
+		{
+			const char* capture = getenv("LL_BENCHMARK_PACKETS");
+			if (capture)
+			{
+				LLPacketRing::readCapture(capture, sPackets);
+				if (sPackets.size() > MAX_TEST_PACKETS)
+				{
+					sPackets.resize(MAX_TEST_PACKETS);
+				}
+			}
+		}
+		if (sPackets.empty())
+		{
+			U8 body[MAX_BUFFER_SIZE];
+			U8 encoded[2 * MAX_BUFFER_SIZE];
+			for (S32 i = 0; i < 256; ++i)
+			{
+				S32 size = LL_PACKET_ID_SIZE + 200 + ll_rand(1000);
+				memset(body, 0, LL_PACKET_ID_SIZE);
+				body[0] = LL_RELIABLE_FLAG;
+				for (S32 pos = LL_PACKET_ID_SIZE; pos < size; )
+				{
+					S32 run = llmin(1 + ll_rand(24), size - pos);
+					bool zeroes = ll_rand(2) != 0;
+					for (S32 j = 0; j < run; ++j)
+					{
+						body[pos + j] = zeroes ? 0 : (U8)(1 + ll_rand(255));
+					}
+					pos += run;
+				}
+
+				S32 encoded_size = ll_zero_code(body, size, encoded);
+				if (encoded_size < size)
+				{
+					encoded[0] |= LL_ZERO_CODE_FLAG;
+					sPackets.push_back(std::vector<U8>(encoded, encoded + encoded_size));
+				}
+				else
+				{
+					sPackets.push_back(std::vector<U8>(body, body + size));
+				}
+			}
+		}
+		return sPackets;
+	}
+
+	// expanded bodies of the zero coded test packets, header included
+	const std::vector<std::vector<U8> >& testBodies()
+	{
+		static std::vector<std::vector<U8> > sBodies;
+		if (sBodies.empty())
+		{
+			LLReceivedPacket packet;
+			for (const std::vector<U8>& data : testPackets())
+			{
+				memcpy(packet.mData, &data[0], data.size());	/* Flawfinder: ignore */
+				packet.mSize = (S32)data.size();
+				packet.parse();
+				if (packet.mCompressedSize && !packet.mExpandOverflow)
+				{
+					sBodies.push_back(std::vector<U8>(packet.mMessage, packet.mMessage + packet.mMessageSize));
+				}
+			}
+		}
+		return sBodies;
+	}
+
+	void buildTestMessage(LLTemplateMessageBuilder& builder, const LLUUID& id)
+	{
+		builder.newMessage(_PREHASH_TestMessage);
+		for (S32 i = 0; i < NUM_BLOCKS; ++i)
+		{
+			builder.nextBlock(_PREHASH_Test0);
+			builder.addU32(_PREHASH_Test0, i);
+			builder.addVector3(_PREHASH_Test1, LLVector3(128.f, 64.f, (F32)i));
+			builder.addUUID(_PREHASH_Test2, id);
+		}
+	}
+}
+
+LL_BENCHMARK(lldatapacker_pack)
+{
+	U8 buffer[PACKER_BUFFER_SIZE];
+	LLDataPackerBinaryBuffer dp(buffer, PACKER_BUFFER_SIZE);
+	LLUUID id;
+	id.generate();
+	U32 i = 0;
+	while (state.keepRunning())
+	{
+		dp.reset();
+		packObject(dp, id, ++i);
+		llbenchmark::doNotOptimize(buffer);
+	}
+	state.setItemsProcessed(state.getIterations() * dp.getCurrentSize());
+}
+
+LL_BENCHMARK(lldatapacker_unpack)
+{
+	U8 buffer[PACKER_BUFFER_SIZE];
+	LLDataPackerBinaryBuffer dp(buffer, PACKER_BUFFER_SIZE);
+	LLUUID id;
+	id.generate();
+	packObject(dp, id, 42);
+	S32 size = dp.getCurrentSize();
+
+	while (state.keepRunning())
+	{
+		dp.reset();
+		LLUUID out_id;
+		U32 local_id;
+		LLVector3 position;
+		unpackObject(dp, out_id, local_id, position);
+		llbenchmark::doNotOptimize(local_id);
+	}
+	state.setItemsProcessed(state.getIterations() * size);
+}
+
+LL_BENCHMARK(template_message_build)
+{
+	LLTemplateMessageBuilder::message_template_name_map_t name_map;
+	name_map[_PREHASH_TestMessage] = testTemplate();
+	LLTemplateMessageBuilder builder(name_map);
+	LLUUID id;
+	id.generate();
+
+	U8 buffer[MAX_BUFFER_SIZE];
+	while (state.keepRunning())
+	{
+		buildTestMessage(builder, id);
+		memset(buffer, 0, LL_PACKET_ID_SIZE);
+		U32 size = builder.buildMessage(buffer, MAX_BUFFER_SIZE, 0);
+		llbenchmark::doNotOptimize(size);
+	}
+	state.setItemsProcessed(state.getIterations());
+}
+
+LL_BENCHMARK(template_message_read)
+{
+	LLTemplateMessageBuilder::message_template_name_map_t name_map;
+	name_map[_PREHASH_TestMessage] = testTemplate();
+	LLTemplateMessageReader::message_template_number_map_t number_map;
+	number_map[1] = testTemplate();
+
+	LLTemplateMessageBuilder builder(name_map);
+	LLUUID id;
+	id.generate();
+	buildTestMessage(builder, id);
+	U8 buffer[MAX_BUFFER_SIZE];
+	memset(buffer, 0, LL_PACKET_ID_SIZE);
+	U32 size = builder.buildMessage(buffer, MAX_BUFFER_SIZE, 0);
+
+	LLTemplateMessageReader reader(number_map);
+	LLHost host;
+	while (state.keepRunning())
+	{
+		reader.validateMessage(buffer, size, host);
+		reader.readMessage(buffer, host);
+		U32 sum = 0;
+		S32 blocks = reader.getNumberOfBlocks(_PREHASH_Test0);
+		for (S32 i = 0; i < blocks; ++i)
+		{
+			U32 value;
+			LLVector3 position;
+			LLUUID out_id;
+			reader.getU32(_PREHASH_Test0, _PREHASH_Test0, value, i);
+			reader.getVector3(_PREHASH_Test0, _PREHASH_Test1, position, i);
+			reader.getUUID(_PREHASH_Test0, _PREHASH_Test2, out_id, i);
+			sum += value;
+		}
+		reader.clearMessage();
+		llbenchmark::doNotOptimize(sum);
+	}
+	state.setItemsProcessed(state.getIterations());
+}
+
+LL_BENCHMARK(zerocode_encode)
+{
+	const std::vector<std::vector<U8> >& bodies = testBodies();
+	U8 encoded[2 * MAX_BUFFER_SIZE];
+	U64 bytes = 0;
+	for (const std::vector<U8>& body : bodies)
+	{
+		bytes += body.size();
+	}
+
+	while (state.keepRunning())
+	{
+		for (const std::vector<U8>& body : bodies)
+		{
+			llbenchmark::doNotOptimize(ll_zero_code(&body[0], (S32)body.size(), encoded));
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * bytes);
+}
+
+LL_BENCHMARK(zerocode_expand)
+{
+	std::vector<std::vector<U8> > encoded;
+	U64 bytes = 0;
+	for (const std::vector<U8>& body : testBodies())
+	{
+		U8 buffer[2 * MAX_BUFFER_SIZE];
+		S32 size = ll_zero_code(&body[0], (S32)body.size(), buffer);
+		encoded.push_back(std::vector<U8>(buffer, buffer + size));
+		bytes += body.size();
+	}
+
+	U8 expanded[NET_BUFFER_SIZE];
+	while (state.keepRunning())
+	{
+		for (const std::vector<U8>& data : encoded)
+		{
+			llbenchmark::doNotOptimize(ll_zero_expand(&data[0], (S32)data.size(), expanded, NET_BUFFER_SIZE));
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * bytes);
+}
+
+// what the receive thread does for each datagram: split off the acks and
+// expand the body in place in its ring slot
+LL_BENCHMARK(packet_parse)
+{
+	const std::vector<std::vector<U8> >& packets = testPackets();
+	std::vector<LLReceivedPacket*> slots;
+	for (const std::vector<U8>& data : packets)
+	{
+		LLReceivedPacket* packet = new LLReceivedPacket;
+		memcpy(packet->mData, &data[0], data.size());	/* Flawfinder: ignore */
+		packet->mSize = (S32)data.size();
+		slots.push_back(packet);
+	}
+
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			// parse() clears the zero coding flag
+			slots[i]->mData[0] = packets[i][0];
+			slots[i]->parse();
+			llbenchmark::doNotOptimize(slots[i]->mMessageSize);
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * slots.size());
+
+	for (LLReceivedPacket* packet : slots)
+	{
+		delete packet;
+	}
+}
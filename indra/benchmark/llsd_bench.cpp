@@ -0,0 +1,390 @@
+/**
+ * @file llsd_bench.cpp
+ * @brief LLSD construction and serializer benchmarks.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+#include "llbenchmark.h"
+
+#include "llbase64.h"
+#include "llfile.h"
+#include "llsd.h"
+#include "llsdserialize.h"
+#include "llsys.h"
+#include "lluuid.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace
+{
+	// roughly the shape of a capability response: a map of arrays of maps
+	LLSD makeDocument()
+	{
+		LLSD doc;
+		doc["agent_id"] = LLUUID("a2e76fcd-9360-4f6d-a924-000000000003");
+		doc["region_handle"] = LLSD::Integer(256000);
+		doc["name"] = "Benchmark Region";
+		LLSD& objects = doc["objects"];
+		for (S32 i = 0; i < 64; ++i)
+		{
+			LLSD object;
+			object["local_id"] = i;
+			object["scale"] = 0.5 + i;
+			object["description"] = "object description text";
+			object["flags"] = LLSD::Boolean(i & 1);
+			LLSD position;
+			position.append(128.0 + i);
+			position.append(64.0);
+			position.append(22.5);
+			object["position"] = position;
+			objects.append(object);
+		}
+		return doc;
+	}
+
+	const LLSD& document()
+	{
+		static LLSD sDocument = makeDocument();
+		return sDocument;
+	}
+
+	// typical shape of a message or capability reply: a few short keys
+	const char* const SMALL_MAP_KEYS[] = { "agent_id", "position", "region_id", "flags",
+										   "name", "rotation", "scale", "type" };
+	const size_t SMALL_MAP_SIZE = sizeof(SMALL_MAP_KEYS) / sizeof(SMALL_MAP_KEYS[0]);
+
+	// build a small map in reverse key order, so it isn't all appends, then
+	// look every key up a few times
+	template <typename MAP>
+	S32 buildAndLookUp(MAP& map)
+	{
+		for (size_t k = SMALL_MAP_SIZE; k--; )
+		{
+			map[SMALL_MAP_KEYS[k]] = LLSD::Integer(k);
+		}
+		S32 sum = 0;
+		for (size_t l = 0; l < 8; ++l)
+		{
+			for (size_t k = 0; k < SMALL_MAP_SIZE; ++k)
+			{
+				sum += map[SMALL_MAP_KEYS[k]].asInteger();
+			}
+		}
+		return sum;
+	}
+
+	// an item the way LLInventoryModel caches it, one notation line each
+	LLSD makeItem(S32 i)
+	{
+		LLUUID owner("a2e76fcd-9360-4f6d-a924-000000000003");
+		LLSD item;
+		item["item_id"] = LLUUID::generateNewID();
+		item["parent_id"] = LLUUID::generateNewID();
+		LLSD& permissions = item["permissions"];
+		permissions["creator_id"] = owner;
+		permissions["owner_id"] = owner;
+		permissions["last_owner_id"] = owner;
+		permissions["group_id"] = LLUUID::null;
+		permissions["base_mask"] = LLSD::Integer(0x7FFFFFFF);
+		permissions["owner_mask"] = LLSD::Integer(0x7FFFFFFF);
+		permissions["group_mask"] = 0;
+		permissions["everyone_mask"] = 0;
+		permissions["next_owner_mask"] = LLSD::Integer(0x82000);
+		permissions["is_owner_group"] = false;
+		item["asset_id"] = LLUUID::generateNewID();
+		item["type"] = "object";
+		item["inv_type"] = "object";
+		item["flags"] = 0;
+		item["sale_info"]["sale_price"] = 10;
+		item["sale_info"]["sale_type"] = "not";
+		item["name"] = llformat("Resident's object %d", i);
+		item["desc"] = "(No Description)";
+		item["creation_date"] = 1690000000 + i;
+		return item;
+	}
+
+	// Entries of the cache LL_BENCHMARK_INVENTORY names, gzipped or not, or
+	// made up items.
+	const std::vector<LLSD>& inventoryCache()
+	{
+		static std::vector<LLSD> sEntries;
+		if (sEntries.empty())
+		{
+			const char* cache = getenv("LL_BENCHMARK_INVENTORY");
+			if (cache)
+			{
+				std::string filename(cache);
+				std::string unzipped(filename);
+				if (filename.size() > 3 && filename.compare(filename.size() - 3, 3, ".gz") == 0)
+				{
+					unzipped = filename + ".bench";
+					gunzip_file(filename, unzipped);
+				}
+				std::ifstream lines(unzipped.c_str());
+				std::string line;
+				while (std::getline(lines, line))
+				{
+					LLSD entry;
+					std::istringstream str(line);
+					if (LLSDSerialize::fromNotation(entry, str, line.size()) > 0)
+					{
+						sEntries.push_back(entry);
+					}
+				}
+				if (unzipped != filename)
+				{
+					LLFile::remove(unzipped);
+				}
+			}
+		}
+		if (sEntries.empty())
+		{
+			for (S32 i = 0; i < 4096; ++i)
+			{
+				sEntries.push_back(makeItem(i));
+			}
+		}
+		return sEntries;
+	}
+
+	std::string inventoryCacheText()
+	{
+		std::ostringstream str;
+		for (const LLSD& entry : inventoryCache())
+		{
+			str << LLSDOStreamer<LLSDNotationFormatter>(entry) << std::endl;
+		}
+		return str.str();
+	}
+
+	const std::vector<U8>& binaryData()
+	{
+		static std::vector<U8> sData;
+		if (sData.empty())
+		{
+			for (U32 i = 0; i < 64 * 1024; ++i)
+			{
+				sData.push_back((U8)(i * 131 + (i >> 8)));
+			}
+		}
+		return sData;
+	}
+
+	template <typename FORMAT>
+	std::string formatted(FORMAT format)
+	{
+		std::ostringstream str;
+		format(document(), str);
+		return str.str();
+	}
+}
+
+LL_BENCHMARK(llsd_construct)
+{
+	while (state.keepRunning())
+	{
+		LLSD doc = makeDocument();
+		llbenchmark::doNotOptimize(doc);
+	}
+}
+
+LL_BENCHMARK(llsd_map_lookup)
+{
+	const LLSD& doc = document();
+	while (state.keepRunning())
+	{
+		const LLSD& objects = doc["objects"];
+		llbenchmark::doNotOptimize(objects[32]["position"][0].asReal());
+	}
+}
+
+LL_BENCHMARK(llsd_small_map)
+{
+	while (state.keepRunning())
+	{
+		LLSD map;
+		llbenchmark::doNotOptimize(buildAndLookUp(map));
+		llbenchmark::doNotOptimize(map);
+	}
+}
+
+// the same work through the std::map LLSD maps used to be
+LL_BENCHMARK(llsd_small_std_map)
+{
+	while (state.keepRunning())
+	{
+		std::map<std::string, LLSD> map;
+		llbenchmark::doNotOptimize(buildAndLookUp(map));
+		llbenchmark::doNotOptimize(map);
+	}
+}
+
+LL_BENCHMARK(llsd_format_xml)
+{
+	const LLSD& doc = document();
+	while (state.keepRunning())
+	{
+		std::ostringstream str;
+		LLSDSerialize::toXML(doc, str);
+		llbenchmark::doNotOptimize(str);
+	}
+}
+
+LL_BENCHMARK(llsd_format_notation)
+{
+	const LLSD& doc = document();
+	while (state.keepRunning())
+	{
+		std::ostringstream str;
+		LLSDSerialize::toNotation(doc, str);
+		llbenchmark::doNotOptimize(str);
+	}
+}
+
+LL_BENCHMARK(llsd_format_binary)
+{
+	const LLSD& doc = document();
+	while (state.keepRunning())
+	{
+		std::ostringstream str;
+		LLSDSerialize::toBinary(doc, str);
+		llbenchmark::doNotOptimize(str);
+	}
+}
+
+LL_BENCHMARK(llsd_parse_xml)
+{
+	std::string text = formatted([](const LLSD& sd, std::ostream& str) { LLSDSerialize::toXML(sd, str); });
+	while (state.keepRunning())
+	{
+		std::istringstream str(text);
+		LLSD doc;
+		LLSDSerialize::fromXML(doc, str);
+		llbenchmark::doNotOptimize(doc);
+	}
+	state.setItemsProcessed(state.getIterations() * text.size());
+}
+
+LL_BENCHMARK(llsd_parse_notation)
+{
+	std::string text = formatted([](const LLSD& sd, std::ostream& str) { LLSDSerialize::toNotation(sd, str); });
+	while (state.keepRunning())
+	{
+		std::istringstream str(text);
+		LLSD doc;
+		LLSDSerialize::fromNotation(doc, str, text.size());
+		llbenchmark::doNotOptimize(doc);
+	}
+	state.setItemsProcessed(state.getIterations() * text.size());
+}
+
+LL_BENCHMARK(llsd_parse_binary)
+{
+	std::string text = formatted([](const LLSD& sd, std::ostream& str) { LLSDSerialize::toBinary(sd, str); });
+	while (state.keepRunning())
+	{
+		std::istringstream str(text);
+		LLSD doc;
+		LLSDSerialize::fromBinary(doc, str, text.size());
+		llbenchmark::doNotOptimize(doc);
+	}
+	state.setItemsProcessed(state.getIterations() * text.size());
+}
+
+// The inventory cache is written at logout: notation escaping and UUIDs
+LL_BENCHMARK(llsd_inventory_cache_format)
+{
+	const std::vector<LLSD>& entries = inventoryCache();
+	size_t bytes = 0;
+	while (state.keepRunning())
+	{
+		std::ostringstream str;
+		for (const LLSD& entry : entries)
+		{
+			str << LLSDOStreamer<LLSDNotationFormatter>(entry) << std::endl;
+		}
+		bytes += (size_t)str.tellp();
+		llbenchmark::doNotOptimize(str);
+	}
+	state.setItemsProcessed(bytes);
+}
+
+// and read at login
+LL_BENCHMARK(llsd_inventory_cache_parse)
+{
+	std::string text = inventoryCacheText();
+	while (state.keepRunning())
+	{
+		std::istringstream str(text);
+		std::string line;
+		while (std::getline(str, line))
+		{
+			LLSD entry;
+			std::istringstream line_str(line);
+			LLSDSerialize::fromNotation(entry, line_str, line.size());
+			llbenchmark::doNotOptimize(entry);
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * text.size());
+}
+
+LL_BENCHMARK(llsd_format_xml_strings)
+{
+	LLSD doc;
+	for (const LLSD& entry : inventoryCache())
+	{
+		doc.append(entry["name"]);
+		doc.append(entry["desc"]);
+	}
+	while (state.keepRunning())
+	{
+		std::ostringstream str;
+		LLSDSerialize::toXML(doc, str);
+		llbenchmark::doNotOptimize(str);
+	}
+}
+
+LL_BENCHMARK(llsd_base64_encode)
+{
+	const std::vector<U8>& data = binaryData();
+	while (state.keepRunning())
+	{
+		llbenchmark::doNotOptimize(LLBase64::encode(&data[0], data.size()));
+	}
+	state.setItemsProcessed(state.getIterations() * data.size());
+}
+
+LL_BENCHMARK(llsd_base64_decode)
+{
+	const std::vector<U8>& data = binaryData();
+	std::string encoded = LLBase64::encode(&data[0], data.size());
+	while (state.keepRunning())
+	{
+		llbenchmark::doNotOptimize(LLBase64::decode(encoded));
+	}
+	state.setItemsProcessed(state.getIterations() * encoded.size());
+}
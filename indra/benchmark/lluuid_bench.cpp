@@ -0,0 +1,236 @@
+/**
+ * @file lluuid_bench.cpp
+ * @brief LLUUID hashing and map benchmarks.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+#include "llbenchmark.h"
+
+#include "lluuid.h"
+#include "lluuidmap.h"
+
+#include <boost/unordered_map.hpp>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	const U32 NUM_IDS = 4096;
+
+	const std::vector<LLUUID>& ids()
+	{
+		static std::vector<LLUUID> sIds;
+		if (sIds.empty())
+		{
+			sIds.resize(NUM_IDS);
+			for (LLUUID& id : sIds)
+			{
+				id.generate();
+			}
+		}
+		return sIds;
+	}
+
+	template <typename MAP>
+	void lookup(LLBenchmarkState& state)
+	{
+		const std::vector<LLUUID>& keys = ids();
+		MAP map;
+		for (U32 i = 0; i < NUM_IDS; ++i)
+		{
+			map[keys[i]] = i;
+		}
+
+		U32 i = 0;
+		U32 sum = 0;
+		while (state.keepRunning())
+		{
+			sum += map.find(keys[i])->second;
+			i = (i + 1) % NUM_IDS;
+		}
+		llbenchmark::doNotOptimize(sum);
+		state.setItemsProcessed(state.getIterations());
+	}
+
+	// half the lookups miss, as they do for e.g. objects not seen yet
+	template <typename MAP>
+	void lookupHalfMissing(LLBenchmarkState& state)
+	{
+		const std::vector<LLUUID>& keys = ids();
+		MAP map;
+		for (U32 i = 0; i < NUM_IDS; i += 2)
+		{
+			map[keys[i]] = i;
+		}
+
+		U32 i = 0;
+		U32 sum = 0;
+		while (state.keepRunning())
+		{
+			auto it = map.find(keys[i]);
+			if (it != map.end())
+			{
+				sum += it->second;
+			}
+			i = (i + 1) % NUM_IDS;
+		}
+		llbenchmark::doNotOptimize(sum);
+		state.setItemsProcessed(state.getIterations());
+	}
+
+	template <typename MAP>
+	void insert(LLBenchmarkState& state)
+	{
+		const std::vector<LLUUID>& keys = ids();
+		while (state.keepRunning())
+		{
+			MAP map;
+			for (U32 i = 0; i < NUM_IDS; ++i)
+			{
+				map[keys[i]] = i;
+			}
+			llbenchmark::doNotOptimize(map);
+		}
+		state.setItemsProcessed(state.getIterations() * NUM_IDS);
+	}
+}
+
+LL_BENCHMARK(lluuid_generate)
+{
+	LLUUID id;
+	while (state.keepRunning())
+	{
+		id.generate();
+		llbenchmark::doNotOptimize(id);
+	}
+}
+
+LL_BENCHMARK(lluuid_to_string)
+{
+	const std::vector<LLUUID>& keys = ids();
+	std::string str;
+	U32 i = 0;
+	while (state.keepRunning())
+	{
+		keys[i].toString(str);
+		llbenchmark::doNotOptimize(str);
+		i = (i + 1) % NUM_IDS;
+	}
+}
+
+LL_BENCHMARK(lluuid_from_string)
+{
+	std::vector<std::string> strings;
+	for (const LLUUID& id : ids())
+	{
+		strings.push_back(id.asString());
+	}
+	LLUUID id;
+	U32 i = 0;
+	while (state.keepRunning())
+	{
+		id.set(strings[i]);
+		llbenchmark::doNotOptimize(id);
+		i = (i + 1) % NUM_IDS;
+	}
+}
+
+LL_BENCHMARK(lluuid_hash)
+{
+	const std::vector<LLUUID>& keys = ids();
+	std::hash<LLUUID> hasher;
+	U32 i = 0;
+	size_t sum = 0;
+	while (state.keepRunning())
+	{
+		sum += hasher(keys[i]);
+		i = (i + 1) % NUM_IDS;
+	}
+	llbenchmark::doNotOptimize(sum);
+}
+
+LL_BENCHMARK(lluuid_compare)
+{
+	const std::vector<LLUUID>& keys = ids();
+	U32 i = 0;
+	U32 less = 0;
+	while (state.keepRunning())
+	{
+		less += keys[i] < keys[(i + 1) % NUM_IDS];
+		i = (i + 1) % NUM_IDS;
+	}
+	llbenchmark::doNotOptimize(less);
+}
+
+LL_BENCHMARK(lluuid_std_map_find)
+{
+	lookup<std::map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_std_unordered_map_find)
+{
+	lookup<std::unordered_map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_boost_unordered_map_find)
+{
+	lookup<boost::unordered_map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_uuid_map_find)
+{
+	lookup<LLUUIDMap<U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_std_map_find_half_missing)
+{
+	lookupHalfMissing<std::map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_boost_unordered_map_find_half_missing)
+{
+	lookupHalfMissing<boost::unordered_map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_uuid_map_find_half_missing)
+{
+	lookupHalfMissing<LLUUIDMap<U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_std_map_insert)
+{
+	insert<std::map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_std_unordered_map_insert)
+{
+	insert<std::unordered_map<LLUUID, U32> >(state);
+}
+
+LL_BENCHMARK(lluuid_uuid_map_insert)
+{
+	insert<LLUUIDMap<U32> >(state);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file workqueue_bench.cpp
+ * @brief LL::WorkQueue throughput benchmarks.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+#include "llbenchmark.h"
+
+#include "llmpmcring.h"
+#include "llthreadsafequeue.h"
+#include "workqueue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// below the default capacity so a single thread never blocks in post()
+	const U32 BATCH_SIZE = 512;
+
+	template <typename QUEUE>
+	void postAndRun(LLBenchmarkState& state)
+	{
+		QUEUE queue;
+		U32 count = 0;
+		while (state.keepRunning())
+		{
+			for (U32 i = 0; i < BATCH_SIZE; ++i)
+			{
+				queue.post([&count]() { ++count; });
+			}
+			queue.runPending();
+		}
+		queue.close();
+		llbenchmark::doNotOptimize(count);
+		state.setItemsProcessed(state.getIterations() * BATCH_SIZE);
+	}
+
+	const S32 CONTENTION_THREADS = 4;
+	const S32 CONTENTION_ITEMS = 10000;		// per producer, per iteration
+
+	// CONTENTION_THREADS producers and as many consumers through one small
+	// queue, so producers keep running into a full queue; thread startup is
+	// timed too but is small next to the items
+	template <typename QUEUE>
+	void contention(LLBenchmarkState& state)
+	{
+		std::atomic<S64> total(0);
+		while (state.keepRunning())
+		{
+			QUEUE queue(256);
+			std::vector<std::thread> consumers;
+			for (S32 c = 0; c < CONTENTION_THREADS; ++c)
+			{
+				consumers.emplace_back([&queue, &total]()
+				{
+					try
+					{
+						while (true)
+						{
+							total += queue.pop();
+						}
+					}
+					catch (const LLThreadSafeQueueInterrupt&)
+					{
+					}
+				});
+			}
+			std::vector<std::thread> producers;
+			for (S32 p = 0; p < CONTENTION_THREADS; ++p)
+			{
+				producers.emplace_back([&queue]()
+				{
+					for (S32 i = 0; i < CONTENTION_ITEMS; ++i)
+					{
+						queue.push(i);
+					}
+				});
+			}
+			for (std::thread& producer : producers)
+			{
+				producer.join();
+			}
+			queue.close();
+			for (std::thread& consumer : consumers)
+			{
+				consumer.join();
+			}
+		}
+		llbenchmark::doNotOptimize(total.load());
+		state.setItemsProcessed(state.getIterations() * CONTENTION_THREADS * CONTENTION_ITEMS);
+	}
+}
+
+LL_BENCHMARK(workqueue_post_run_pending)
+{
+	postAndRun<LL::WorkQueue>(state);
+}
+
+LL_BENCHMARK(workschedule_post_run_pending)
+{
+	postAndRun<LL::WorkSchedule>(state);
+}
+
+// the way thread pools are fed: main thread posts, one worker runs
+LL_BENCHMARK(workqueue_post_to_worker)
+{
+	LL::WorkQueue queue;
+	std::atomic<U64> done(0);
+	std::thread worker([&queue]() { queue.runUntilClose(); });
+
+	U64 posted = 0;
+	while (state.keepRunning())
+	{
+		for (U32 i = 0; i < BATCH_SIZE; ++i)
+		{
+			queue.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+		}
+		posted += BATCH_SIZE;
+		while (done.load(std::memory_order_relaxed) < posted)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	queue.close();
+	worker.join();
+	state.setItemsProcessed(state.getIterations() * BATCH_SIZE);
+}
+
+LL_BENCHMARK(threadsafequeue_ring_contention)
+{
+	contention<LLThreadSafeQueue<S32, LL::MPMCRing<S32>>>(state);
+}
+
+// the mutex-based queue WorkQueue used before the ring
+LL_BENCHMARK(threadsafequeue_mutex_contention)
+{
+	contention<LLThreadSafeQueue<S32>>(state);
+}
@@ -38,6 +38,7 @@
 #include "llimagebmp.h"
 #include "llimagetga.h"
 #include "llimagej2c.h"
+#include "llimageworker.h"
 #include "lldir.h"
 #include "lldiriterator.h"
 #include "v4coloru.h"
@@ -45,6 +46,7 @@
 #include "llcleanup.h"
 
 // system libraries
+#include <atomic>
 #include <iostream>
 
 // doc string provided when invoking the program with --help 
@@ -97,6 +99,16 @@ static const char USAGE[] = "\n"
 "        Results in <metric>_report.csv\n"
 " -s, --image-stats\n"
 "        Output stats for each input and output image.\n"
+" -bench, --benchmark <n>\n"
+"        Time <n> runs (default 10) of the scaling, mip, compositing and channel conversion\n"
+"        code on each input image, with and without the SIMD kernels, and check that both\n"
+"        give the same result.\n"
+" -dbench, --decode-benchmark <n>\n"
+"        Time <n> decodes (default 10) of each j2c input at every discard level, then time\n"
+"        reading and decoding the whole j2c input set through the LLImageDecodeThread pool\n"
+"        with 1, 2, 4... up to -threads workers. Reports the J2C engine in use.\n"
+" -threads, --decode-threads <n>\n"
+"        Largest worker count for -dbench. Default is 8.\n"
 "\n";
 
 // true when all image loading is done. Used by metric logging thread to know when to stop the thread.
@@ -313,6 +325,203 @@ void store_output_file(std::list<std::string> &output_filenames, std::list<std::
 	}
 }
 
+// Time runs of one raw image operation with LLImage::sUseSIMD off then on and
+// report whether the two results match.
+template<typename OP>
+void benchmark_op(const std::string &op_name, int runs, OP op)
+{
+	LLPointer<LLImageRaw> results[2];
+	F64 times[2];
+	for (int simd = 0; simd < 2; ++simd)
+	{
+		LLImage::sUseSIMD = (simd != 0);
+		LLTimer timer;
+		for (int run = 0; run < runs; ++run)
+		{
+			results[simd] = op();
+		}
+		times[simd] = timer.getElapsedTimeF64() * 1000.0 / runs;
+	}
+	LLImage::sUseSIMD = true;
+
+	bool match = (results[0]->getDataSize() == results[1]->getDataSize())
+		&& !memcmp(results[0]->getData(), results[1]->getData(), results[0]->getDataSize());
+	std::cout << "    " << op_name << " : scalar " << times[0] << " ms, simd " << times[1] << " ms"
+		<< (match ? "" : ", RESULTS DIFFER") << std::endl;
+}
+
+// Benchmark the LLImageRaw pixel loops on a decoded image
+void benchmark_image(LLPointer<LLImageRaw> raw_image, const std::string &filename, int runs)
+{
+	S32 width = raw_image->getWidth();
+	S32 height = raw_image->getHeight();
+	std::cout << "Benchmark for : " << filename << ", " << width << "x" << height << ", " << runs << " runs" << std::endl;
+
+	LLPointer<LLImageRaw> rgba = new LLImageRaw(width, height, 4);
+	rgba->copy(raw_image);
+	LLPointer<LLImageRaw> rgb = new LLImageRaw(width, height, 3);
+	rgb->copy(raw_image);
+
+	benchmark_op("downscale", runs, [&]()
+	{
+		return rgba->scaled(llmax(width * 5 / 8, 1), llmax(height * 5 / 8, 1));
+	});
+	if (width > 1 && height > 1)
+	{
+		benchmark_op("mip", runs, [&]()
+		{
+			LLPointer<LLImageRaw> mip = new LLImageRaw(width / 2, height / 2, 4);
+			LLImageBase::generateMip(rgba->getData(), mip->getData(), width / 2, height / 2, 4);
+			return mip;
+		});
+	}
+	benchmark_op("composite", runs, [&]()
+	{
+		LLPointer<LLImageRaw> dst = new LLImageRaw(rgb->getData(), width, height, 3);
+		dst->composite(rgba);
+		return dst;
+	});
+	benchmark_op("rgba to rgb", runs, [&]()
+	{
+		LLPointer<LLImageRaw> dst = new LLImageRaw(width, height, 3);
+		dst->copy(rgba);
+		return dst;
+	});
+	benchmark_op("rgb to rgba", runs, [&]()
+	{
+		LLPointer<LLImageRaw> dst = new LLImageRaw(width, height, 4);
+		dst->copy(rgb);
+		return dst;
+	});
+}
+
+// Load a whole j2c file, returns NULL if it isn't a usable j2c image
+LLPointer<LLImageJ2C> load_j2c(const std::string &filename)
+{
+	if (LLImageBase::getCodecFromExtension(gDirUtilp->getExtension(filename)) != IMG_CODEC_J2C)
+	{
+		return NULL;
+	}
+	LLPointer<LLImageJ2C> j2c = new LLImageJ2C;
+	if (!j2c->load(filename) || ((j2c->getComponents() != 3) && (j2c->getComponents() != 4)))
+	{
+		return NULL;
+	}
+	return j2c;
+}
+
+// Time decodes of one j2c image at each of its discard levels
+void benchmark_decode_levels(LLPointer<LLImageJ2C> source, const std::string &filename, int runs)
+{
+	std::cout << "Decode benchmark for : " << filename << ", " << source->getWidth() << "x" << source->getHeight()
+		<< ", " << (int)source->getComponents() << " comp, " << runs << " runs" << std::endl;
+
+	S32 max_discard = llclamp((S32)source->getLevels(), 0, MAX_DISCARD_LEVEL);
+	for (S32 discard = 0; discard <= max_discard; ++discard)
+	{
+		F64 total_ms = 0.0;
+		S32 width = 0;
+		S32 height = 0;
+		bool ok = true;
+		for (int run = 0; (run < runs) && ok; ++run)
+		{
+			// decode consumes state in the formatted image so start each run from a fresh copy
+			LLPointer<LLImageJ2C> j2c = new LLImageJ2C;
+			U8* data = j2c->allocateData(source->getDataSize());
+			if (!data)
+			{
+				ok = false;
+				break;
+			}
+			memcpy(data, source->getData(), source->getDataSize());
+			j2c->updateData();
+			j2c->setDiscardLevel(discard);
+			LLPointer<LLImageRaw> raw = new LLImageRaw(j2c->getWidth(), j2c->getHeight(), j2c->getComponents());
+
+			LLTimer timer;
+			ok = j2c->decode(raw, 0.0f);
+			total_ms += timer.getElapsedTimeF64() * 1000.0;
+			width = raw->getWidth();
+			height = raw->getHeight();
+		}
+		if (ok)
+		{
+			std::cout << "    discard " << discard << " (" << width << "x" << height << ") : " << total_ms / runs << " ms" << std::endl;
+		}
+		else
+		{
+			std::cout << "    discard " << discard << " : decode failed" << std::endl;
+		}
+	}
+}
+
+// Counts finished decodes for benchmark_decode_threads
+class BenchmarkResponder : public LLImageDecodeThread::Responder
+{
+public:
+	BenchmarkResponder(std::atomic<int>& done, std::atomic<int>& failed) : mDone(done), mFailed(failed) {}
+	virtual void completed(bool success, LLImageRaw* raw, LLImageRaw* aux)
+	{
+		if (!success)
+		{
+			++mFailed;
+		}
+		++mDone;
+	}
+private:
+	std::atomic<int>& mDone;
+	std::atomic<int>& mFailed;
+};
+
+// Time reading then decoding every j2c file through the decode pool, as the
+// texture fetcher does after a cache hit, with a growing number of workers
+void benchmark_decode_threads(const std::list<std::string> &filenames, int runs, int max_threads)
+{
+	std::cout << "Threaded decode benchmark, " << filenames.size() << " files, " << runs << " runs" << std::endl;
+	for (int threads = 1; ; threads = llmin(threads * 2, max_threads))
+	{
+		LLImageDecodeThread* decode_thread = new LLImageDecodeThread(true, threads);
+		std::atomic<int> done(0);
+		std::atomic<int> failed(0);
+		int requested = 0;
+		F64 megapixels = 0.0;
+
+		LLTimer timer;
+		for (int run = 0; run < runs; ++run)
+		{
+			for (std::list<std::string>::const_iterator it = filenames.begin(); it != filenames.end(); ++it)
+			{
+				LLPointer<LLImageJ2C> j2c = load_j2c(*it);
+				if (j2c.isNull())
+				{
+					continue;
+				}
+				megapixels += (F64)j2c->getWidth() * j2c->getHeight() / 1000000.0;
+				decode_thread->decodeImage(j2c, 0, FALSE, new BenchmarkResponder(done, failed));
+				++requested;
+			}
+		}
+		while (done < requested)
+		{
+			ms_sleep(1);
+		}
+		F64 seconds = timer.getElapsedTimeF64();
+
+		std::cout << "    " << threads << " workers : " << seconds * 1000.0 << " ms, "
+			<< (seconds > 0.0 ? requested / seconds : 0.0) << " images/s, "
+			<< (seconds > 0.0 ? megapixels / seconds : 0.0) << " MP/s"
+			<< (failed > 0 ? ", some decodes failed" : "") << std::endl;
+
+		decode_thread->shutdown();
+		delete decode_thread;
+
+		if (threads >= max_threads)
+		{
+			break;
+		}
+	}
+}
+
 // Holds the metric gathering output in a thread safe way
 class LogThread : public LLThread
 {
@@ -349,6 +558,9 @@ int main(int argc, char** argv)
 	// Other optional parsed arguments
 	bool analyze_performance = false;
 	bool image_stats = false;
+	int benchmark_runs = 0;
+	int decode_benchmark_runs = 0;
+	int decode_threads = 8;
 	int* region = NULL;
 	int discard_level = -1;
 	int load_size = 0;
@@ -557,6 +769,36 @@ int main(int argc, char** argv)
 		{
 			image_stats = true;
 		}
+		else if (!strcmp(argv[arg], "--benchmark") || !strcmp(argv[arg], "-bench"))
+		{
+			benchmark_runs = 10;
+			if (((arg + 1) < argc) && (argv[arg+1][0] != '-'))
+			{
+				benchmark_runs = llmax(atoi(argv[arg+1]), 1);
+				arg += 1;
+			}
+		}
+		else if (!strcmp(argv[arg], "--decode-benchmark") || !strcmp(argv[arg], "-dbench"))
+		{
+			decode_benchmark_runs = 10;
+			if (((arg + 1) < argc) && (argv[arg+1][0] != '-'))
+			{
+				decode_benchmark_runs = llmax(atoi(argv[arg+1]), 1);
+				arg += 1;
+			}
+		}
+		else if (!strcmp(argv[arg], "--decode-threads") || !strcmp(argv[arg], "-threads"))
+		{
+			if (((arg + 1) < argc) && (argv[arg+1][0] != '-'))
+			{
+				decode_threads = llmax(atoi(argv[arg+1]), 1);
+				arg += 1;
+			}
+			else
+			{
+				std::cout << "No valid --decode-threads argument given, default (8) will be used" << std::endl;
+			}
+		}
 	}
 		
 	// Check arguments consistency. Exit with proper message if inconsistent.
@@ -580,6 +822,20 @@ int main(int argc, char** argv)
 		fast_timer_log_thread->start();
 	}
     
+	if (decode_benchmark_runs)
+	{
+		std::cout << "J2C engine : " << LLImageJ2C::getEngineInfo() << std::endl;
+		for (std::list<std::string>::iterator it = input_filenames.begin(); it != input_filenames.end(); ++it)
+		{
+			LLPointer<LLImageJ2C> j2c = load_j2c(*it);
+			if (j2c.notNull())
+			{
+				benchmark_decode_levels(j2c, *it, decode_benchmark_runs);
+			}
+		}
+		benchmark_decode_threads(input_filenames, decode_benchmark_runs, decode_threads);
+	}
+
     // Load the filter once and for all
     LLImageFilter filter(filter_name);
 
@@ -598,6 +854,11 @@ int main(int argc, char** argv)
 			continue;
 		}
         
+		if (benchmark_runs)
+		{
+			benchmark_image(raw_image, *in_file, benchmark_runs);
+		}
+
         // Apply the filter
         filter.executeFilter(raw_image);
 
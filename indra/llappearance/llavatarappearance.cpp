@@ -911,8 +911,9 @@ BOOL LLAvatarAppearance::loadAvatar()
 		return FALSE;
 	}
 
-	// initialize mJointAliasMap
-	getJointAliases();
+	// initialize mJointAliasMap, and intern the aliases so getJoint() can
+	// find joints by them
+	getInternedJointAliases();
 
 	// avatar_lad.xml : <skeleton>
 	if( !loadSkeletonNode() )
@@ -1741,6 +1742,18 @@ const LLAvatarAppearance::joint_alias_map_t& LLAvatarAppearance::getJointAliases
     return mJointAliasMap;
 } 
 
+const LLAvatarAppearance::interned_alias_map_t& LLAvatarAppearance::getInternedJointAliases()
+{
+    if (mInternedJointAliasMap.empty())
+    {
+        for (const joint_alias_map_t::value_type& alias : getJointAliases())
+        {
+            mInternedJointAliasMap[LLInternedString(alias.first)] = LLInternedString(alias.second);
+        }
+    }
+    return mInternedJointAliasMap;
+}
+
 
 //-----------------------------------------------------------------------------
 // parseXmlSkeletonNode(): parses <skeleton> nodes from XML tree
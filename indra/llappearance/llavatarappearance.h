@@ -35,6 +35,8 @@
 #include "llviewervisualparam.h"
 #include "llxmltree.h"
 
+#include <unordered_map>
+
 class LLTexLayerSet;
 class LLTexGlobalColor;
 class LLTexGlobalColorInfo;
@@ -138,7 +140,7 @@ public:
 	LLVector3			mHeadOffset; // current head position
 	LLAvatarJoint		*mRoot;
 
-	typedef std::map<std::string, LLJoint*> joint_map_t;
+	typedef std::unordered_map<LLInternedString, LLJoint*> joint_map_t;
 	joint_map_t			mJointMap;
 
     typedef std::map<std::string, LLVector3> joint_state_map_t;
@@ -153,6 +155,9 @@ public:
     const avatar_joint_list_t& getSkeleton() { return mSkeleton; }
     typedef std::map<std::string, std::string> joint_alias_map_t;
     const joint_alias_map_t& getJointAliases();
+    // the same aliases, for getJoint()
+    typedef std::unordered_map<LLInternedString, LLInternedString> interned_alias_map_t;
+    const interned_alias_map_t& getInternedJointAliases();
 
 
 protected:
@@ -169,6 +174,7 @@ protected:
 	avatar_joint_list_t	mSkeleton;
 	LLVector3OverrideMap	mPelvisFixups;
     joint_alias_map_t   mJointAliasMap;
+    interned_alias_map_t mInternedJointAliasMap;
 
 	//--------------------------------------------------------------------
 	// Pelvis height adjustment members.
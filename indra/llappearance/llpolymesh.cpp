@@ -40,6 +40,8 @@
 #include "llvolume.h"
 #include "llendianswizzle.h"
 
+#include <algorithm>
+
 
 #define HEADER_ASCII "Linden Mesh 1.0"
 #define HEADER_BINARY "Linden Binary Mesh 1.0"
@@ -60,6 +62,10 @@ LLPolyMorphData *clone_morph_param_cleavage(const LLPolyMorphData *src_data,
 //-----------------------------------------------------------------------------
 LLPolyMesh::LLPolyMeshSharedDataTable LLPolyMesh::sGlobalSharedMeshList;
 
+// open morph batches on this thread and the meshes with vertices waiting in them
+static thread_local S32 sMorphBatchDepth = 0;
+static thread_local std::vector<LLPolyMesh*> sBatchedMeshes;
+
 //-----------------------------------------------------------------------------
 // LLPolyMeshSharedData()
 //-----------------------------------------------------------------------------
@@ -810,6 +816,10 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
 //-----------------------------------------------------------------------------
 LLPolyMesh::~LLPolyMesh()
 {
+	if (!mBatchedVertices.empty())
+	{
+		sBatchedMeshes.erase(std::find(sBatchedMeshes.begin(), sBatchedMeshes.end(), this));
+	}
 	delete_and_clear(mJointRenderData);
 	ll_aligned_free_16(mVertexData);
 }
@@ -856,6 +866,101 @@ LLPolyMesh *LLPolyMesh::getMesh(const std::string &name, LLPolyMesh* reference_m
         return poly_mesh;
 }
 
+//-----------------------------------------------------------------------------
+// LLPolyMesh::beginMorphBatch()
+//-----------------------------------------------------------------------------
+// static
+void LLPolyMesh::beginMorphBatch()
+{
+	++sMorphBatchDepth;
+}
+
+//-----------------------------------------------------------------------------
+// LLPolyMesh::endMorphBatch()
+//-----------------------------------------------------------------------------
+// static
+void LLPolyMesh::endMorphBatch()
+{
+	llassert(sMorphBatchDepth > 0);
+	if (--sMorphBatchDepth > 0)
+	{
+		return;
+	}
+
+	for (LLPolyMesh* mesh : sBatchedMeshes)
+	{
+		mesh->deriveNormals(mesh->mBatchedVertices.data(), (U32)mesh->mBatchedVertices.size());
+		for (U32 vert_index : mesh->mBatchedVertices)
+		{
+			mesh->mBatchedVertexFlags[vert_index] = false;
+		}
+		mesh->mBatchedVertices.clear();
+	}
+	sBatchedMeshes.clear();
+}
+
+//-----------------------------------------------------------------------------
+// LLPolyMesh::updateMorphedNormals()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::updateMorphedNormals(const U32* vertex_indices, U32 count)
+{
+	if (sMorphBatchDepth == 0)
+	{
+		deriveNormals(vertex_indices, count);
+		return;
+	}
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (mBatchedVertices.empty())
+	{
+		sBatchedMeshes.push_back(this);
+	}
+	if (mBatchedVertexFlags.size() < getNumVertices())
+	{
+		mBatchedVertexFlags.resize(getNumVertices(), false);
+	}
+	for (U32 i = 0; i < count; ++i)
+	{
+		const U32 vert_index = vertex_indices[i];
+		if (!mBatchedVertexFlags[vert_index])
+		{
+			mBatchedVertexFlags[vert_index] = true;
+			mBatchedVertices.push_back(vert_index);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLPolyMesh::deriveNormals()
+//-----------------------------------------------------------------------------
+void LLPolyMesh::deriveNormals(const U32* vertex_indices, U32 count)
+{
+	LLVector4a* scaled_normals = getScaledNormals();
+	LLVector4a* normals = getWritableNormals();
+	LLVector4a* scaled_binormals = getScaledBinormals();
+	LLVector4a* binormals = getWritableBinormals();
+
+	// the normals and binormals are derived from the accumulated values,
+	// using half angles
+	for (U32 i = 0; i < count; ++i)
+	{
+		const U32 vert_index = vertex_indices[i];
+
+		LLVector4a norm = scaled_normals[vert_index];
+		norm.normalize3fast();
+		normals[vert_index] = norm;
+
+		LLVector4a tangent;
+		tangent.setCross3(scaled_binormals[vert_index], norm);
+		LLVector4a& normalized_binormal = binormals[vert_index];
+		normalized_binormal.setCross3(norm, tangent);
+		normalized_binormal.normalize3fast();
+	}
+}
+
 //-----------------------------------------------------------------------------
 // LLPolyMesh::freeAllMeshes()
 //-----------------------------------------------------------------------------
@@ -173,6 +173,18 @@ public:
 	// references to these objects.  Generally, upon exit of the application.
 	static void freeAllMeshes();
 
+	// Morph targets applied between beginMorphBatch() and endMorphBatch()
+	// only accumulate their deltas, and the normals and binormals of the
+	// vertices they moved are derived once when the batch ends instead of
+	// once per morph.  An appearance update moves dozens of morphs on the
+	// same mesh.  Batches may nest, only the outermost one counts.
+	static void beginMorphBatch();
+	static void endMorphBatch();
+
+	// Derive the output normals and binormals of the given vertices from
+	// their scaled ones, now or at the end of the open batch.
+	void updateMorphedNormals(const U32* vertex_indices, U32 count);
+
 	//--------------------------------------------------------------------
 	// Transform Data Access
 	//--------------------------------------------------------------------
@@ -331,6 +343,12 @@ public:
 private:
 	void initializeForMorph();
 
+	void deriveNormals(const U32* vertex_indices, U32 count);
+
+	// vertices waiting for updateMorphedNormals() while a batch is open
+	std::vector<U32> mBatchedVertices;
+	std::vector<bool> mBatchedVertexFlags;
+
 	// Dumps diagnostic information about the global mesh table
 	static void dumpDiagInfo();
 
@@ -364,5 +382,13 @@ protected:
 	LLAvatarAppearance* mAvatarp;
 };
 
+// Keeps a morph batch open for its lifetime, see LLPolyMesh::beginMorphBatch()
+class LLScopedMorphBatch
+{
+public:
+	LLScopedMorphBatch() { LLPolyMesh::beginMorphBatch(); }
+	~LLScopedMorphBatch() { LLPolyMesh::endMorphBatch(); }
+};
+
 #endif // LL_LLPOLYMESHINTERFACE_H
 
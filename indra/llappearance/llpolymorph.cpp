@@ -197,6 +197,12 @@ BOOL LLPolyMorphData::loadBinary(LLFILE *fp, LLPolyMeshSharedData *mesh)
 			LL_WARNS() << "Can't read morph target binormal" << LL_ENDL;
 			return FALSE;
 		}
+		// guard against degenerate input data here, once, rather than on
+		// every apply()
+		if (!mBinormals[v].isFinite3() || (mBinormals[v].dot3(mBinormals[v]).getF32() <= F_APPROXIMATELY_ZERO))
+		{
+			mBinormals[v].set(1,0,0,1);
+		}
 
 
 		numRead = fread(&mTexCoords[v].mV, sizeof(F32), 2, fp);
@@ -571,73 +577,69 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
 		LLVector4a *coords = mMesh->getWritableCoords();
 
 		LLVector4a *scaled_normals = mMesh->getScaledNormals();
-		LLVector4a *normals = mMesh->getWritableNormals();
-
 		LLVector4a *scaled_binormals = mMesh->getScaledBinormals();
-		LLVector4a *binormals = mMesh->getWritableBinormals();
 
 		LLVector4a *clothing_weights = mMesh->getWritableClothingWeights();
 		LLVector2 *tex_coords = mMesh->getWritableTexCoords();
 
 		F32 *maskWeightArray = (mVertMask) ? mVertMask->getMorphMaskWeights() : NULL;
 
-		for(U32 vert_index_morph = 0; vert_index_morph < mMorphData->mNumIndices; vert_index_morph++)
+		const U32 num_indices = mMorphData->mNumIndices;
+		const U32* vertex_indices = mMorphData->mVertexIndices;
+		const LLVector4a* morph_coords = mMorphData->mCoords;
+		const LLVector4a* morph_normals = mMorphData->mNormals;
+		const LLVector4a* morph_binormals = mMorphData->mBinormals;
+		const LLVector2* morph_tex_coords = mMorphData->mTexCoords;
+		if (!(getInfo()->mIsClothingMorph))
 		{
-			S32 vert_index_mesh = mMorphData->mVertexIndices[vert_index_morph];
+			clothing_weights = NULL;
+		}
+
+		// First accumulate the weighted deltas. Every attribute is a
+		// multiply-add of a splatted weight, with no per vertex branching
+		// beyond the optional mask.
+		LLVector4a weight;
+		LLVector4a soft_weight;
+		weight.splat(delta_weight);
+		soft_weight.splat(delta_weight*NORMAL_SOFTEN_FACTOR);
+		for (U32 vert_index_morph = 0; vert_index_morph < num_indices; vert_index_morph++)
+		{
+			const U32 vert_index_mesh = vertex_indices[vert_index_morph];
 
 			F32 maskWeight = 1.f;
 			if (maskWeightArray)
 			{
 				maskWeight = maskWeightArray[vert_index_morph];
+				weight.splat(delta_weight*maskWeight);
+				soft_weight.splat(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
 			}
 
+			LLVector4a offset;
+			offset.setMul(morph_coords[vert_index_morph], weight);
+			coords[vert_index_mesh].add(offset);
 
-			LLVector4a pos = mMorphData->mCoords[vert_index_morph];
-			pos.mul(delta_weight*maskWeight);
-			coords[vert_index_mesh].add(pos);
-
-			if (getInfo()->mIsClothingMorph && clothing_weights)
+			if (clothing_weights)
 			{
-				LLVector4a clothing_offset = mMorphData->mCoords[vert_index_morph];
-				clothing_offset.mul(delta_weight * maskWeight);
-				LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
-				clothing_weight->add(clothing_offset);
-				clothing_weight->getF32ptr()[VW] = maskWeight;
+				LLVector4a& clothing_weight = clothing_weights[vert_index_mesh];
+				clothing_weight.add(offset);
+				clothing_weight.getF32ptr()[VW] = maskWeight;
 			}
 
-			// calculate new normals based on half angles
-			LLVector4a norm = mMorphData->mNormals[vert_index_morph];
-			norm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-			scaled_normals[vert_index_mesh].add(norm);
-			norm = scaled_normals[vert_index_mesh];
+			LLVector4a delta;
+			delta.setMul(morph_normals[vert_index_morph], soft_weight);
+			scaled_normals[vert_index_mesh].add(delta);
 
-			// guard against degenerate input data before we create NaNs below!
-			//
-			norm.normalize3fast();
-			normals[vert_index_mesh] = norm;
+			// binormals were checked for degenerate input when loaded
+			delta.setMul(morph_binormals[vert_index_morph], soft_weight);
+			scaled_binormals[vert_index_mesh].add(delta);
 
-			// calculate new binormals
-			LLVector4a binorm = mMorphData->mBinormals[vert_index_morph];
-
-			// guard against degenerate input data before we create NaNs below!
-			//
-			if (!binorm.isFinite3() || (binorm.dot3(binorm).getF32() <= F_APPROXIMATELY_ZERO))
-			{
-				binorm.set(1,0,0,1);
-			}
-
-			binorm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-			scaled_binormals[vert_index_mesh].add(binorm);
-			LLVector4a tangent;
-			tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
-			LLVector4a& normalized_binormal = binormals[vert_index_mesh];
-
-			normalized_binormal.setCross3(norm, tangent); 
-			normalized_binormal.normalize3fast();
-			
-			tex_coords[vert_index_mesh] += mMorphData->mTexCoords[vert_index_morph] * delta_weight * maskWeight;
+			tex_coords[vert_index_mesh] += morph_tex_coords[vert_index_morph] * (delta_weight * maskWeight);
 		}
 
+		// then derive the normals and binormals of the touched vertices from
+		// the accumulated values, once per batch when one is open
+		mMesh->updateMorphedNormals(vertex_indices, num_indices);
+
 		// now apply volume changes
 		for(LLPolyVolumeMorph& volume_morph : mVolumeMorphs)
 		{
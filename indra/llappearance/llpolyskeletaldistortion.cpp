@@ -193,6 +193,12 @@ void LLPolySkeletalDistortion::apply( ESex avatar_sex )
 
     LLJoint* joint;
 
+    // BENTO for detailed stack tracing of params, formatted once per apply
+    // rather than once per joint
+    std::stringstream ostr;
+    ostr << "LLPolySkeletalDistortion::apply, id " << getID() << " " << getName() << " effective wt " << effective_weight << " last wt " << mLastWeight;
+    LLScopedContextString str(ostr.str());
+
     for (joint_vec_map_t::value_type& scale_pair : mJointScales)
     {
         joint = scale_pair.first;
@@ -204,11 +210,6 @@ void LLPolySkeletalDistortion::apply( ESex avatar_sex )
         // needed? 
         // joint->storeScaleForReset( newScale );				
 
-        // BENTO for detailed stack tracing of params.
-        std::stringstream ostr;
-        ostr << "LLPolySkeletalDistortion::apply, id " << getID() << " " << getName() << " effective wt " << effective_weight << " last wt " << mLastWeight << " scaleDelta " << scaleDelta << " offset " << offset;
-        LLScopedContextString str(ostr.str());
-
         joint->setScale(newScale, true);
     }
 
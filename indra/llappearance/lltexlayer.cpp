@@ -1812,6 +1812,7 @@ void LLTexLayerStaticImageList::deleteCachedImages()
 		
 		mStaticImageListTGA.clear();
 		mStaticImageList.clear();
+		mGradientTextureList.clear();
 		
 		mGLBytes = 0;
 		mTGABytes = 0;
@@ -1819,7 +1820,8 @@ void LLTexLayerStaticImageList::deleteCachedImages()
 }
 
 // Note: in general, for a given image image we'll call either getImageTga() or getTexture().
-// We call getImageTga() if the image is used as an alpha gradient.
+// We call getImageTga() if the image is used as an alpha gradient, and getGradientTexture() as well
+// when the gradient is drawn with gAlphaGradientProgram.
 // Otherwise, we call getTexture()
 
 // Returns an LLImageTGA that contains the encoded data from a tga file named file_name.
@@ -1851,6 +1853,38 @@ LLImageTGA* LLTexLayerStaticImageList::getImageTGA(const std::string& file_name)
 	}
 }
 
+// Returns a GL Image (without a backing ImageRaw) that holds the decoded alpha gradient named file_name,
+// for drawing with gAlphaGradientProgram.  Caches the result, failures included.
+LLGLTexture* LLTexLayerStaticImageList::getGradientTexture(const std::string& file_name)
+{
+    LL_PROFILE_ZONE_SCOPED;
+	const char *namekey = mImageNames.addString(file_name);
+	texture_map_t::const_iterator iter = mGradientTextureList.find(namekey);
+	if( iter != mGradientTextureList.end() )
+	{
+		return iter->second;
+	}
+
+	LLPointer<LLGLTexture> tex;
+	LLImageTGA* image_tga = getImageTGA(file_name);
+	LLPointer<LLImageRaw> image_raw = new LLImageRaw;
+	if( image_tga && image_tga->decode( image_raw ) && (image_raw->getComponents() == 1) )
+	{
+		llassert(gTextureManagerBridgep);
+		tex = gTextureManagerBridgep->getLocalTexture(image_raw->getWidth(), image_raw->getHeight(), 1, FALSE);
+		tex->setExplicitFormat(GL_ALPHA8, GL_ALPHA);
+		tex->createGLTexture(0, image_raw, 0, TRUE, LLGLTexture::LOCAL);
+
+		gGL.getTexUnit(0)->bind(tex);
+		tex->setAddressMode(LLTexUnit::TAM_CLAMP);
+
+		mGLBytes += (S32)tex->getWidth() * tex->getHeight() * tex->getComponents();
+	}
+
+	mGradientTextureList[ namekey ] = tex;
+	return tex;
+}
+
 // Returns a GL Image (without a backing ImageRaw) that contains the decoded data from a tga file named file_name.
 // Caches the result to speed identical subsequent requests.
 LLGLTexture* LLTexLayerStaticImageList::getTexture(const std::string& file_name, BOOL is_mask)
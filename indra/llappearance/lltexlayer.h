@@ -296,6 +296,9 @@ class LLTexLayerStaticImageList : public LLSingleton<LLTexLayerStaticImageList>
 public:
 	LLGLTexture*		getTexture(const std::string& file_name, BOOL is_mask);
 	LLImageTGA*			getImageTGA(const std::string& file_name);
+	// The unprocessed alpha gradient as an alpha texture, shared by every
+	// avatar.  gAlphaGradientProgram applies the domain and weight to it.
+	LLGLTexture*		getGradientTexture(const std::string& file_name);
 	void				deleteCachedImages();
 	void				dumpByteCount() const;
 protected:
@@ -304,6 +307,7 @@ private:
 	LLStringTable 		mImageNames;
 	typedef std::map<const char*, LLPointer<LLGLTexture> > texture_map_t;
 	texture_map_t 		mStaticImageList;
+	texture_map_t 		mGradientTextureList;
 	typedef std::map<const char*, LLPointer<LLImageTGA> > image_tga_map_t;
 	image_tga_map_t 	mStaticImageListTGA;
 	S32 				mGLBytes;
@@ -29,6 +29,7 @@
 #include "lltexlayerparams.h"
 
 #include "llavatarappearance.h"
+#include "llglslshader.h"
 #include "llimagetga.h"
 #include "llquantize.h"
 #include "lltexlayer.h"
@@ -304,6 +305,52 @@ BOOL LLTexLayerParamAlpha::render(S32 x, S32 y, S32 width, S32 height)
 			}
 		}
 
+		// With the gradient shader every avatar draws from the one unprocessed
+		// gradient texture, so moving a slider costs no decode and no upload.
+		LLGLTexture* gradient_tex = gAlphaGradientProgram.isComplete() ?
+			LLTexLayerStaticImageList::getInstance()->getGradientTexture(info->mStaticImageFileName) : NULL;
+		if (gradient_tex)
+		{
+			static LLStaticHashedString gradient_scale("gradient_scale");
+			static LLStaticHashedString gradient_bias("gradient_bias");
+			static LLStaticHashedString gradient_threshold("gradient_threshold");
+
+			// same ramp and step as LLImageTGA::decodeAndProcess()
+			F32 scale = 0.f;
+			F32 bias = 0.f;
+			if (info->mDomain > 0.f)
+			{
+				scale = 1.f / info->mDomain;
+				bias = -scale * (1.f - info->mDomain) * llclampf(1.f - effective_weight);
+			}
+			F32 threshold = (F32)(U8)(0xFF * llclampf(1.f - effective_weight)) / 255.f;
+
+			LLGLSLShader* prev_shader = LLGLSLShader::sCurBoundShaderPtr;
+			gAlphaGradientProgram.bind();
+			gAlphaGradientProgram.uniform1f(gradient_scale, scale);
+			gAlphaGradientProgram.uniform1f(gradient_bias, bias);
+			gAlphaGradientProgram.uniform1f(gradient_threshold, threshold);
+
+			gGL.getTexUnit(0)->bind(gradient_tex);
+			gl_rect_2d_simple_tex(width, height);
+			gGL.flush();
+			gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+			stop_glerror();
+
+			if (prev_shader)
+			{
+				prev_shader->bind();
+			}
+			else
+			{
+				gAlphaGradientProgram.unbind();
+			}
+			mCachedEffectiveWeight = effective_weight;
+			mCachedProcessedTexture = NULL;
+			mStaticImageRaw = NULL;
+			return success;
+		}
+
 		const S32 image_tga_width = mStaticImageTGA->getWidth();
 		const S32 image_tga_height = mStaticImageTGA->getHeight(); 
 		if (!mCachedProcessedTexture ||
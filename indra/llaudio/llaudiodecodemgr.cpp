@@ -42,8 +42,10 @@
 
 #include "vorbis/codec.h"
 #include "vorbis/vorbisfile.h"
+#include <algorithm>
 #include <iterator>
 #include <deque>
+#include <list>
 
 extern LLAudioEngine *gAudiop;
 
@@ -68,6 +70,7 @@ public:
 		LLPointer<LLVorbisDecodeState> mDecoder;
 	};
 	
+	// an empty out_filename keeps the decoded WAV in memory, see takeWAV()
 	LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename);
 
 	BOOL initDecode();
@@ -80,6 +83,8 @@ public:
 	BOOL isValid() const				{ return mValid; }
 	BOOL isDone() const					{ return mDone; }
 	const LLUUID &getUUID() const		{ return mUUID; }
+	bool isInMemory() const				{ return mWAVInMemory; }
+	LLAudioDecodeMgr::wav_ptr_t takeWAV();
 
 protected:
 	virtual ~LLVorbisDecodeState();
@@ -90,6 +95,7 @@ protected:
 	LLUUID mUUID;
 
 	std::vector<U8> mWAVBuffer;
+	bool mWAVInMemory;
 	std::string mOutFilename;
 	LLLFSThread::handle_t mFileHandle;
 	
@@ -170,6 +176,7 @@ LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &
 	mUUID = uuid;
 	mInFilep = NULL;
 	mCurrentSection = 0;
+	mWAVInMemory = false;
 	mOutFilename = out_filename;
 	mFileHandle = LLLFSThread::nullHandle();
 
@@ -417,6 +424,11 @@ BOOL LLVorbisDecodeState::finishDecode()
 		return TRUE; // We've finished
 	}
 
+	if (mWAVInMemory)
+	{
+		return TRUE;
+	}
+
 	if (mFileHandle == LLLFSThread::nullHandle())
 	{
 		ov_clear(&mVF);
@@ -490,6 +502,14 @@ BOOL LLVorbisDecodeState::finishDecode()
 			mValid = FALSE;
 			return TRUE; // we've finished
 		}
+		if (mOutFilename.empty())
+		{
+			mWAVInMemory = true;
+			mDone = TRUE;
+			LL_DEBUGS("AudioEngine") << "Finished decode to memory for " << getUUID() << LL_ENDL;
+			return TRUE;
+		}
+
 		mBytesRead = -1;
 		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
 							 new WriteResponder(this));
@@ -519,6 +539,12 @@ BOOL LLVorbisDecodeState::finishDecode()
 	return TRUE;
 }
 
+LLAudioDecodeMgr::wav_ptr_t LLVorbisDecodeState::takeWAV()
+{
+	llassert(mWAVInMemory);
+	return std::make_shared<std::vector<U8> >(std::move(mWAVBuffer));
+}
+
 void LLVorbisDecodeState::flushBadFile()
 {
 	if (mInFilep)
@@ -541,22 +567,37 @@ class LLAudioDecodeMgr::Impl
     void startMoreDecodes();
     void enqueueFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState>& decode_state);
     void checkDecodesFinished();
+    // Return true if finished
+    bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state);
+
+    void addToMemoryCache(const LLUUID &uuid, const LLAudioDecodeMgr::wav_ptr_t &wav);
+    void trimMemoryCache();
 
   protected:
     std::deque<LLUUID> mDecodeQueue;
+    // priority of every id in mDecodeQueue
+    std::map<LLUUID, F32> mQueuedPriorities;
     std::map<LLUUID, LLPointer<LLVorbisDecodeState>> mDecodes;
+
+    // decoded sounds, most recently used at the front
+    typedef std::list<std::pair<LLUUID, LLAudioDecodeMgr::wav_ptr_t> > wav_lru_t;
+    wav_lru_t mMemoryCache;
+    std::map<LLUUID, wav_lru_t::iterator> mMemoryCacheIndex;
+    size_t mMemoryCacheBytes;
+    size_t mMemoryCacheLimit;
 };
 
 LLAudioDecodeMgr::Impl::Impl()
+:   mMemoryCacheBytes(0),
+    mMemoryCacheLimit(0)
 {
 }
 
 // Returns the in-progress decode_state, which may be an empty LLPointer if
 // there was an error and there is no more work to be done.
-LLPointer<LLVorbisDecodeState> beginDecodingAndWritingAudio(const LLUUID &decode_id);
-
-// Return true if finished
-bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state);
+// With to_memory the decoded WAV stays in the state instead of being written
+// to the cache.
+LLPointer<LLVorbisDecodeState> beginDecodingAndWritingAudio(const LLUUID &decode_id, bool to_memory);
 
 void LLAudioDecodeMgr::Impl::processQueue()
 {
@@ -590,10 +631,21 @@ void LLAudioDecodeMgr::Impl::startMoreDecodes()
     // -Cosmic,2022-05-11
     const size_t max_decodes = general_thread_pool->getWidth() * 2;
 
+    if (mDecodeQueue.size() > 1 && mDecodes.size() < max_decodes)
+    {
+        // loudest and closest first, otherwise in the order they were asked for
+        std::stable_sort(mDecodeQueue.begin(), mDecodeQueue.end(),
+                         [this](const LLUUID& lhs, const LLUUID& rhs)
+                         { return mQueuedPriorities[lhs] > mQueuedPriorities[rhs]; });
+    }
+
+    const bool to_memory = mMemoryCacheLimit > 0;
+
     while (!mDecodeQueue.empty() && mDecodes.size() < max_decodes)
     {
         const LLUUID decode_id = mDecodeQueue.front();
         mDecodeQueue.pop_front();
+        mQueuedPriorities.erase(decode_id);
 
         // Don't decode the same file twice
         if (mDecodes.find(decode_id) != mDecodes.end())
@@ -609,9 +661,9 @@ void LLAudioDecodeMgr::Impl::startMoreDecodes()
         mDecodes[decode_id] = LLPointer<LLVorbisDecodeState>(NULL);
         bool posted = main_queue->postTo(
             general_queue,
-            [decode_id]() // Work done on general queue
+            [decode_id, to_memory]() // Work done on general queue
             {
-                LLPointer<LLVorbisDecodeState> decode_state = beginDecodingAndWritingAudio(decode_id);
+                LLPointer<LLVorbisDecodeState> decode_state = beginDecodingAndWritingAudio(decode_id, to_memory);
 
                 if (!decode_state)
                 {
@@ -647,13 +699,17 @@ void LLAudioDecodeMgr::Impl::startMoreDecodes()
     }
 }
 
-LLPointer<LLVorbisDecodeState> beginDecodingAndWritingAudio(const LLUUID &decode_id)
+LLPointer<LLVorbisDecodeState> beginDecodingAndWritingAudio(const LLUUID &decode_id, bool to_memory)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_MEDIA;
 
     LL_DEBUGS() << "Decoding " << decode_id << " from audio queue!" << LL_ENDL;
 
-    std::string                    d_path       = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, decode_id.asString()) + ".dsf";
+    std::string                    d_path;
+    if (!to_memory)
+    {
+        d_path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, decode_id.asString()) + ".dsf";
+    }
     LLPointer<LLVorbisDecodeState> decode_state = new LLVorbisDecodeState(decode_id, d_path);
 
     if (!decode_state->initDecode())
@@ -727,7 +783,7 @@ void LLAudioDecodeMgr::Impl::checkDecodesFinished()
     }
 }
 
-bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state)
+bool LLAudioDecodeMgr::Impl::tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state)
 {
     // decode_state is a file write in progress unless finished is true
     bool finished = decode_state && decode_state->finishDecode();
@@ -746,13 +802,17 @@ bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> deco
     }
 
     bool valid = decode_state && decode_state->isValid();
+    if (valid && decode_state->isInMemory())
+    {
+        addToMemoryCache(decode_id, decode_state->takeWAV());
+    }
     // Mark current decode finished regardless of success or failure
     adp->setHasCompletedDecode(true);
     // Flip flags for decoded data
     adp->setHasDecodeFailed(!valid);
     adp->setHasDecodedData(valid);
     // When finished decoding, there will also be a decoded wav file cached on
-    // disk with the .dsf extension
+    // disk with the .dsf extension, or in the memory cache
     if (valid)
     {
         adp->setHasWAVLoadFailed(false);
@@ -761,6 +821,35 @@ bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> deco
     return true;
 }
 
+void LLAudioDecodeMgr::Impl::addToMemoryCache(const LLUUID &uuid, const LLAudioDecodeMgr::wav_ptr_t &wav)
+{
+    auto found = mMemoryCacheIndex.find(uuid);
+    if (found != mMemoryCacheIndex.end())
+    {
+        mMemoryCacheBytes -= found->second->second->size();
+        mMemoryCache.erase(found->second);
+        mMemoryCacheIndex.erase(found);
+    }
+
+    mMemoryCache.push_front(std::make_pair(uuid, wav));
+    mMemoryCacheIndex[uuid] = mMemoryCache.begin();
+    mMemoryCacheBytes += wav->size();
+
+    trimMemoryCache();
+}
+
+void LLAudioDecodeMgr::Impl::trimMemoryCache()
+{
+    // always keep the newest sound, even if it alone is over the limit
+    while (mMemoryCacheBytes > mMemoryCacheLimit && mMemoryCache.size() > (mMemoryCacheLimit ? 1 : 0))
+    {
+        const wav_lru_t::value_type& oldest = mMemoryCache.back();
+        mMemoryCacheBytes -= oldest.second->size();
+        mMemoryCacheIndex.erase(oldest.first);
+        mMemoryCache.pop_back();
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 LLAudioDecodeMgr::LLAudioDecodeMgr()
@@ -779,7 +868,41 @@ void LLAudioDecodeMgr::processQueue()
     mImpl->processQueue();
 }
 
-BOOL LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
+void LLAudioDecodeMgr::setMemoryCacheSize(U32 bytes)
+{
+    mImpl->mMemoryCacheLimit = bytes;
+    mImpl->trimMemoryCache();
+}
+
+bool LLAudioDecodeMgr::isDecodingToMemory() const
+{
+    return mImpl->mMemoryCacheLimit > 0;
+}
+
+size_t LLAudioDecodeMgr::getMemoryCacheBytes() const
+{
+    return mImpl->mMemoryCacheBytes;
+}
+
+bool LLAudioDecodeMgr::hasDecodedWAV(const LLUUID &uuid) const
+{
+    return mImpl->mMemoryCacheIndex.find(uuid) != mImpl->mMemoryCacheIndex.end();
+}
+
+LLAudioDecodeMgr::wav_ptr_t LLAudioDecodeMgr::getDecodedWAV(const LLUUID &uuid)
+{
+    auto found = mImpl->mMemoryCacheIndex.find(uuid);
+    if (found == mImpl->mMemoryCacheIndex.end())
+    {
+        return wav_ptr_t();
+    }
+
+    // move to the front, iterators into the list stay valid
+    mImpl->mMemoryCache.splice(mImpl->mMemoryCache.begin(), mImpl->mMemoryCache, found->second);
+    return found->second->second;
+}
+
+BOOL LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid, F32 priority)
 {
 	if (gAudiop && gAudiop->hasDecodedFile(uuid))
 	{
@@ -792,7 +915,16 @@ BOOL LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
 	{
 		// Just put it on the decode queue.
 		LL_DEBUGS("AudioEngine") << "addDecodeRequest for " << uuid << " has local asset file already" << LL_ENDL;
-        mImpl->mDecodeQueue.push_back(uuid);
+        auto queued = mImpl->mQueuedPriorities.find(uuid);
+        if (queued == mImpl->mQueuedPriorities.end())
+        {
+            mImpl->mQueuedPriorities[uuid] = priority;
+            mImpl->mDecodeQueue.push_back(uuid);
+        }
+        else
+        {
+            queued->second = llmax(queued->second, priority);
+        }
 		return TRUE;
 	}
 
@@ -34,6 +34,9 @@
 #include "llframetimer.h"
 #include "llsingleton.h"
 
+#include <memory>
+#include <vector>
+
 template<class T> class LLPointer;
 class LLVorbisDecodeState;
 
@@ -42,9 +45,24 @@ class LLAudioDecodeMgr : public LLSingleton<LLAudioDecodeMgr>
     LLSINGLETON(LLAudioDecodeMgr);
     ~LLAudioDecodeMgr();
 public:
+	// a complete WAV image, header included
+	typedef std::shared_ptr<const std::vector<U8> > wav_ptr_t;
+
 	void processQueue();
-	BOOL addDecodeRequest(const LLUUID &uuid);
+	// Requests with a higher priority (see LLAudioSource::getPriority())
+	// are decoded first, asking again only raises it.
+	BOOL addDecodeRequest(const LLUUID &uuid, F32 priority = 0.f);
 	void addAudioRequest(const LLUUID &uuid);
+
+	// Decoded sounds are kept in memory up to this many bytes and dropped
+	// least recently used first, instead of going through a .dsf file in
+	// the cache. 0 writes every decode to the cache.
+	void setMemoryCacheSize(U32 bytes);
+	bool isDecodingToMemory() const;
+	size_t getMemoryCacheBytes() const;
+	bool hasDecodedWAV(const LLUUID &uuid) const;
+	// NULL if the sound isn't in memory, marks it as recently used
+	wav_ptr_t getDecodedWAV(const LLUUID &uuid);
 	
 protected:
 	class Impl;
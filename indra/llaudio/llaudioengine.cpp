@@ -100,6 +100,9 @@ void LLAudioEngine::setDefaults()
 
 	for (U32 i = 0; i < LLAudioEngine::AUDIO_TYPE_COUNT; i++)
 		mSecondaryGain[i] = 1.0f;
+
+	mSourceCullDistance = 0.f;
+	mIdleFrame = 0;
 }
 
 
@@ -238,6 +241,11 @@ void LLAudioEngine::idle()
 		}
 	}
 
+	// culled sources are looked at once every this many frames
+	const U32 CULLED_SOURCE_UPDATE_FRAMES = 8;
+	const F32 cull_dist_squared = mSourceCullDistance * mSourceCullDistance;
+	++mIdleFrame;
+
 	F32 max_priority = -1.f;
 	LLAudioSource *max_sourcep = NULL; // Maximum priority source without a channel
 	source_map::iterator iter;
@@ -245,6 +253,12 @@ void LLAudioEngine::idle()
 	{
 		LLAudioSource *sourcep = iter->second;
 
+		if (sourcep->mCulled && (mIdleFrame + sourcep->mCullSlot) % CULLED_SOURCE_UPDATE_FRAMES != 0)
+		{
+			++iter;
+			continue;
+		}
+
 		// Update this source
 		sourcep->update();
 		sourcep->updatePriority();
@@ -257,6 +271,32 @@ void LLAudioEngine::idle()
 			continue;
 		}
 
+		if (cull_dist_squared > 0.f && !sourcep->isForcedPriority())
+		{
+			LLVector3 dist_vec;
+			dist_vec.setVec(sourcep->getPositionGlobal());
+			dist_vec -= getListenerPos();
+			sourcep->mCulled = dist_vec.magVecSquared() > cull_dist_squared;
+		}
+		else
+		{
+			sourcep->mCulled = false;
+		}
+
+		if (sourcep->mCulled)
+		{
+			LLAudioChannel *channelp = sourcep->getChannel();
+			if (channelp)
+			{
+				// Out of earshot, free the channel for something audible.
+				// A looped source picks a channel up again once back in range.
+				channelp->setSource(NULL);
+				sourcep->setChannel(NULL);
+			}
+			++iter;
+			continue;
+		}
+
 		if (sourcep->isMuted())
 		{
 			++iter;
@@ -315,9 +355,9 @@ void LLAudioEngine::idle()
 		// attached to each channel, since only those with active channels
 		// can have anything interesting happen with their queue? (Maybe not true)
 		LLAudioSource *sourcep = src_pair.second;
-		if (!sourcep->mQueuedDatap || sourcep->isMuted())
+		if (!sourcep->mQueuedDatap || sourcep->isMuted() || sourcep->mCulled)
 		{
-			// Muted, or nothing queued, so we don't care.
+			// Muted, out of range or nothing queued, so we don't care.
 			continue;
 		}
 
@@ -481,7 +521,7 @@ void LLAudioEngine::idle()
 
 
 
-bool LLAudioEngine::updateBufferForData(LLAudioData *adp, const LLUUID &audio_uuid)
+bool LLAudioEngine::updateBufferForData(LLAudioData *adp, const LLUUID &audio_uuid, F32 priority)
 {
 	if (!adp)
 	{
@@ -503,7 +543,7 @@ bool LLAudioEngine::updateBufferForData(LLAudioData *adp, const LLUUID &audio_uu
 		{
 			if (audio_uuid.notNull())
 			{
-                LLAudioDecodeMgr::getInstance()->addDecodeRequest(audio_uuid);
+                LLAudioDecodeMgr::getInstance()->addDecodeRequest(audio_uuid, priority);
 			}
 		}
 		else
@@ -529,6 +569,20 @@ void LLAudioEngine::enableWind(bool enable)
 }
 
 
+U64 LLAudioEngine::getBufferBytes()
+{
+	U64 bytes = 0;
+	for (S32 i = 0; i < LL_MAX_AUDIO_BUFFERS; i++)
+	{
+		if (mBuffers[i])
+		{
+			bytes += mBuffers[i]->getSize();
+		}
+	}
+	return bytes;
+}
+
+
 LLAudioBuffer * LLAudioEngine::getFreeBuffer()
 {
 	S32 i;
@@ -966,6 +1020,11 @@ void LLAudioEngine::cleanupAudioSource(LLAudioSource *asp)
 
 bool LLAudioEngine::hasDecodedFile(const LLUUID &uuid)
 {
+	if (LLAudioDecodeMgr::getInstance()->hasDecodedWAV(uuid))
+	{
+		return true;
+	}
+
 	std::string uuid_str;
 	uuid.toString(uuid_str);
 
@@ -1252,11 +1311,14 @@ LLAudioSource::LLAudioSource(const LLUUID& id, const LLUUID& owner_id, const F32
 	mQueueSounds(false),
 	mPlayedOnce(false),
 	mCorrupted(false),
+	mCulled(false),
 	mType(type),
 	mChannelp(NULL),
 	mCurrentDatap(NULL),
 	mQueuedDatap(NULL)
 {
+	static U32 next_cull_slot = 0;
+	mCullSlot = next_cull_slot++;
 }
 
 
@@ -1422,7 +1484,7 @@ bool LLAudioSource::play(const LLUUID &audio_uuid)
 		return false;
 	}
 
-	bool has_buffer = gAudiop->updateBufferForData(adp, audio_uuid);
+	bool has_buffer = gAudiop->updateBufferForData(adp, audio_uuid, getPriority());
 	if (!has_buffer)
 	{
 		// Don't bother trying to set up a channel or anything, we don't have an audio buffer.
@@ -1817,12 +1879,32 @@ bool LLAudioData::load()
 		return true;
 	}
 
-	std::string uuid_str;
-	std::string wav_path;
-	mID.toString(uuid_str);
-	wav_path= gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
+	LLAudioDecodeMgr::wav_ptr_t wav = LLAudioDecodeMgr::getInstance()->getDecodedWAV(mID);
+	if (wav)
+	{
+		mHasWAVLoadFailed = !mBufferp->loadWAVMemory(wav->data(), (U32)wav->size());
+	}
+	else if (mHasLocalData && LLAudioDecodeMgr::getInstance()->isDecodingToMemory() && !gAudiop->hasDecodedFile(mID))
+	{
+		// Dropped from the decoded memory cache, decode it again
+		// rather than treating the sound as broken.
+		gAudiop->cleanupBuffer(mBufferp);
+		mBufferp = NULL;
+		mHasDecodedData = false;
+		mHasCompletedDecode = false;
+		LLAudioDecodeMgr::getInstance()->addDecodeRequest(mID);
+		return true;
+	}
+	else
+	{
+		std::string uuid_str;
+		std::string wav_path;
+		mID.toString(uuid_str);
+		wav_path= gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
+
+		mHasWAVLoadFailed = !mBufferp->loadWAV(wav_path);
+	}
 
-    mHasWAVLoadFailed = !mBufferp->loadWAV(wav_path);
     if (mHasWAVLoadFailed)
 	{
 		// Hrm.  Right now, let's unset the buffer, since it's empty.
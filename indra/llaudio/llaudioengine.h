@@ -121,6 +121,11 @@ public:
 	F32 getSecondaryGain(S32 type);
 	void setSecondaryGain(S32 type, F32 gain);
 
+	// Sources farther than this from the listener give up their channel and
+	// are only revisited every few frames until they come back in range.
+	// 0 updates every source every frame.
+	void setSourceCullDistance(F32 meters)	{ mSourceCullDistance = meters; }
+
 	F32 getInternetStreamGain();
 
 	virtual void setDopplerFactor(F32 factor);
@@ -162,13 +167,15 @@ public:
 	virtual LLVector3 getListenerPos();
 
 	LLAudioBuffer *getFreeBuffer(); // Get a free buffer, or flush an existing one if you have to.
+	U64 getBufferBytes(); // sample data in all buffers
 	LLAudioChannel *getFreeChannel(const F32 priority); // Get a free channel or flush an existing one if your priority is higher
 	void cleanupBuffer(LLAudioBuffer *bufferp);
 
 	bool hasDecodedFile(const LLUUID &uuid);
 	bool hasLocalFile(const LLUUID &uuid);
 
-	bool updateBufferForData(LLAudioData *adp, const LLUUID &audio_uuid = LLUUID::null);
+	// priority orders the decode this may request, see LLAudioDecodeMgr
+	bool updateBufferForData(LLAudioData *adp, const LLUUID &audio_uuid = LLUUID::null, F32 priority = 0.f);
 
 
 	// Asset callback when we're retrieved a sound from the asset server.
@@ -235,6 +242,9 @@ protected:
 	F32 mInternalGain;			// Actual gain set; either mMasterGain or 0 when mMuted is true.
 	F32 mSecondaryGain[AUDIO_TYPE_COUNT];
 
+	F32 mSourceCullDistance;
+	U32 mIdleFrame;
+
 	F32 mNextWindUpdate;
 
 	LLFrameTimer mWindUpdateTimer;
@@ -334,6 +344,10 @@ protected:
 	bool			mQueueSounds;
 	bool			mPlayedOnce;
 	bool            mCorrupted;
+	// beyond the engine's cull distance, see LLAudioEngine::setSourceCullDistance()
+	bool            mCulled;
+	// frame offset culled sources are revisited on, spreads them over frames
+	U32             mCullSlot;
 	S32             mType;
 	LLVector3d		mPositionGlobal;
 	LLVector3		mVelocity;
@@ -447,7 +461,12 @@ class LLAudioBuffer
 public:
 	virtual ~LLAudioBuffer() {};
 	virtual bool loadWAV(const std::string& filename) = 0;
+	// same as loadWAV() from a complete WAV image already in memory,
+	// the buffer keeps its own copy of the samples
+	virtual bool loadWAVMemory(const U8* data, U32 size) = 0;
 	virtual U32 getLength() = 0;
+	// bytes of sample data held, for memory statistics
+	virtual U32 getSize() = 0;
 
 	friend class LLAudioEngine;
 	friend class LLAudioChannel;
@@ -118,7 +118,9 @@ public:
     virtual ~LLAudioBufferFMODSTUDIO();
 
 	/*virtual*/ bool loadWAV(const std::string& filename);
+	/*virtual*/ bool loadWAVMemory(const U8* data, U32 size);
 	/*virtual*/ U32 getLength();
+	/*virtual*/ U32 getSize();
 	friend class LLAudioChannelFMODSTUDIO;
 protected:
 	FMOD::System *getSystem()	const {return mSystemp;}
@@ -360,6 +360,21 @@ bool LLAudioBufferOpenAL::loadWAV(const std::string& filename)
 	return true;
 }
 
+bool LLAudioBufferOpenAL::loadWAVMemory(const U8* data, U32 size)
+{
+	cleanup();
+	mALBuffer = alutCreateBufferFromFileImage(data, size);
+	if(mALBuffer == AL_NONE)
+	{
+		ALenum error = alutGetError();
+		LL_WARNS() << "LLAudioBufferOpenAL::loadWAVMemory() Error loading "
+			<< size << " bytes " << alutGetErrorString(error) << LL_ENDL;
+		return false;
+	}
+
+	return true;
+}
+
 U32 LLAudioBufferOpenAL::getLength()
 {
 	if(mALBuffer == AL_NONE)
@@ -371,6 +386,17 @@ U32 LLAudioBufferOpenAL::getLength()
 	return length / 2; // convert size in bytes to size in (16-bit) samples
 }
 
+U32 LLAudioBufferOpenAL::getSize()
+{
+	if(mALBuffer == AL_NONE)
+	{
+		return 0;
+	}
+	ALint size;
+	alGetBufferi(mALBuffer, AL_SIZE, &size);
+	return size;
+}
+
 // ------------
 
 bool LLAudioEngine_OpenAL::initWind()
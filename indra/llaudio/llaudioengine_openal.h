@@ -95,7 +95,9 @@ class LLAudioBufferOpenAL : public LLAudioBuffer{
 		virtual ~LLAudioBufferOpenAL();
 
 		bool loadWAV(const std::string& filename);
+		bool loadWAVMemory(const U8* data, U32 size);
 		U32 getLength();
+		U32 getSize();
 
 		friend class LLAudioChannelOpenAL;
 	protected:
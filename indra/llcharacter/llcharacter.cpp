@@ -36,8 +36,6 @@
 
 #define SKEL_HEADER "Linden Skeleton 1.0"
 
-LLStringTable LLCharacter::sVisualParamNames(1024);
-
 std::vector< LLCharacter* > LLCharacter::sInstances;
 BOOL LLCharacter::sAllowInstancesChange = TRUE ;
 
@@ -95,6 +93,12 @@ LLCharacter::~LLCharacter()
 // getJoint()
 //-----------------------------------------------------------------------------
 LLJoint *LLCharacter::getJoint( const std::string &name )
+{
+	// a name nobody interned can't belong to a joint, but still warn
+	return getJoint(LLInternedString::find(name));
+}
+
+LLJoint *LLCharacter::getJoint( const LLInternedString &name )
 {
 	LLJoint* joint = NULL;
 
@@ -210,6 +214,19 @@ void LLCharacter::updateMotions(e_update_t update_type)
 }
 
 
+//-----------------------------------------------------------------------------
+// prepareDeferredMotionUpdate()
+//-----------------------------------------------------------------------------
+bool LLCharacter::prepareDeferredMotionUpdate()
+{
+	// unpause if the number of outstanding pause requests has dropped to the initial one
+	if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
+	{
+		mMotionController.unpauseAllMotions();
+	}
+	return mMotionController.prepareDeferredUpdate();
+}
+
 //-----------------------------------------------------------------------------
 // deactivateAllMotions()
 //-----------------------------------------------------------------------------
@@ -292,14 +309,27 @@ BOOL LLCharacter::setVisualParamWeight(const LLVisualParam* which_param, F32 wei
 }
 
 //-----------------------------------------------------------------------------
-// setVisualParamWeight()
+// findVisualParamName()
 //-----------------------------------------------------------------------------
-BOOL LLCharacter::setVisualParamWeight(const char* param_name, F32 weight)
+LLCharacter::visual_param_name_map_t::iterator LLCharacter::findVisualParamName(const char* param_name)
 {
+	// names are interned in lower case by addVisualParam()
 	std::string tname(param_name);
 	LLStringUtil::toLower(tname);
-	char *tableptr = sVisualParamNames.checkString(tname);
-	visual_param_name_map_t::iterator name_iter = mVisualParamNameMap.find(tableptr);
+	LLInternedString interned = LLInternedString::find(tname);
+	if (interned.empty())
+	{
+		return mVisualParamNameMap.end();
+	}
+	return mVisualParamNameMap.find(interned);
+}
+
+//-----------------------------------------------------------------------------
+// setVisualParamWeight()
+//-----------------------------------------------------------------------------
+BOOL LLCharacter::setVisualParamWeight(const char* param_name, F32 weight)
+{
+	visual_param_name_map_t::iterator name_iter = findVisualParamName(param_name);
 	if (name_iter != mVisualParamNameMap.end())
 	{
 		name_iter->second->setWeight(weight);
@@ -347,10 +377,7 @@ F32 LLCharacter::getVisualParamWeight(LLVisualParam *which_param)
 //-----------------------------------------------------------------------------
 F32 LLCharacter::getVisualParamWeight(const char* param_name)
 {
-	std::string tname(param_name);
-	LLStringUtil::toLower(tname);
-	char *tableptr = sVisualParamNames.checkString(tname);
-	visual_param_name_map_t::iterator name_iter = mVisualParamNameMap.find(tableptr);
+	visual_param_name_map_t::iterator name_iter = findVisualParamName(param_name);
 	if (name_iter != mVisualParamNameMap.end())
 	{
 		return name_iter->second->getWeight();
@@ -397,10 +424,7 @@ void LLCharacter::clearVisualParamWeights()
 //-----------------------------------------------------------------------------
 LLVisualParam*	LLCharacter::getVisualParam(const char *param_name)
 {
-	std::string tname(param_name);
-	LLStringUtil::toLower(tname);
-	char *tableptr = sVisualParamNames.checkString(tname);
-	visual_param_name_map_t::iterator name_iter = mVisualParamNameMap.find(tableptr);
+	visual_param_name_map_t::iterator name_iter = findVisualParamName(param_name);
 	if (name_iter != mVisualParamNameMap.end())
 	{
 		return name_iter->second;
@@ -457,9 +481,8 @@ void LLCharacter::addVisualParam(LLVisualParam *param)
 		// Add name map
 		std::string tname(param->getName());
 		LLStringUtil::toLower(tname);
-		char *tableptr = sVisualParamNames.addString(tname);
 		std::pair<visual_param_name_map_t::iterator, bool> nameres;
-		nameres = mVisualParamNameMap.insert(visual_param_name_map_t::value_type(tableptr, param));
+		nameres = mVisualParamNameMap.insert(visual_param_name_map_t::value_type(LLInternedString(tname), param));
 		if (!nameres.second)
 		{
 			// Already exists, copy param
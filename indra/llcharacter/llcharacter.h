@@ -31,10 +31,12 @@
 // Header Files
 //-----------------------------------------------------------------------------
 #include <string>
+#include <unordered_map>
 
 #include "lljoint.h"
 #include "llmotioncontroller.h"
 #include "llvisualparam.h"
+#include "llinternedstring.h"
 #include "llstringtable.h"
 #include "llpointer.h"
 #include "llrefcount.h"
@@ -76,7 +78,8 @@ public:
 	// get the specified joint
 	// default implementation does recursive search,
 	// subclasses may optimize/cache results.
-	virtual LLJoint *getJoint( const std::string &name );
+	virtual LLJoint *getJoint( const LLInternedString &name );
+	LLJoint *getJoint( const std::string &name );
 
 	// get the position of the character
 	virtual LLVector3 getCharacterPosition() = 0;
@@ -155,6 +158,10 @@ public:
 	enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
 	void updateMotions(e_update_t update_type);
 
+	// NORMAL_UPDATE version of updateMotions() that may leave evaluating the
+	// motions to another thread, see LLMotionController::prepareDeferredUpdate()
+	bool prepareDeferredMotionUpdate();
+
 	LLAnimPauseRequest requestPause();
 	BOOL areAnimationsPaused() const { return mMotionController.isPaused(); }
 	void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
@@ -276,13 +283,13 @@ protected:
 private:
 	// visual parameter stuff
 	typedef std::map<S32, LLVisualParam *> 		visual_param_index_map_t;
-	typedef std::map<char *, LLVisualParam *> 	visual_param_name_map_t;
+	typedef std::unordered_map<LLInternedString, LLVisualParam *> visual_param_name_map_t;
 
 	visual_param_index_map_t::iterator 			mCurIterator;
 	visual_param_index_map_t 					mVisualParamIndexMap;
 	visual_param_name_map_t  					mVisualParamNameMap;
 
-	static LLStringTable sVisualParamNames;	
+	visual_param_name_map_t::iterator findVisualParamName(const char* param_name);
 
 	LLVector3 mHoverOffset;
 };
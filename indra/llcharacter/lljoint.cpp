@@ -35,8 +35,9 @@
 #include "llcallstack.h"
 #include <boost/algorithm/string.hpp>
 
-S32 LLJoint::sNumUpdates = 0;
-S32 LLJoint::sNumTouches = 0;
+std::atomic<S32> LLJoint::sNumUpdates(0);
+std::atomic<S32> LLJoint::sNumTouches(0);
+std::atomic<U32> LLJoint::sHierarchyGeneration(1);
 
 template <class T> 
 bool attachment_map_iter_compare_key(const T& a, const T& b)
@@ -103,12 +104,13 @@ void LLVector3OverrideMap::clear()
 
 void LLJoint::init()
 {
-	mName = "unnamed";
+	setName("unnamed");
 	mParent = NULL;
 	mXform.setScaleChildOffset(TRUE);
 	mXform.setScale(LLVector3(1.0f, 1.0f, 1.0f));
 	mDirtyFlags = MATRIX_DIRTY | ROTATION_DIRTY | POSITION_DIRTY;
 	mUpdateXform = TRUE;
+	mFlatHierarchyGeneration = 0;
     mSupport = SUPPORT_BASE;
     mEnd = LLVector3(0.0f, 0.0f, 0.0f);
 }
@@ -245,7 +247,18 @@ LLJoint *LLJoint::getRoot()
 //-----------------------------------------------------------------------------
 LLJoint *LLJoint::findJoint( const std::string &name )
 {
-	if (name == getName())
+	// no joint can have a name that was never interned
+	LLInternedString interned = LLInternedString::find(name);
+	if (interned.empty() && !name.empty())
+	{
+		return NULL;
+	}
+	return findJoint(interned);
+}
+
+LLJoint *LLJoint::findJoint( const LLInternedString &name )
+{
+	if (name == mName)
 		return this;
 
 	for (LLJoint* joint : mChildren)
@@ -273,6 +286,7 @@ void LLJoint::addChild(LLJoint* joint)
 	joint->mXform.setParent(&mXform);
 	joint->mParent = this;	
 	joint->touch();
+	sHierarchyGeneration++;
 }
 
 
@@ -289,6 +303,7 @@ void LLJoint::removeChild(LLJoint* joint)
 		joint->mXform.setParent(NULL);
 		joint->mParent = NULL;
 		joint->touch();
+		sHierarchyGeneration++;
 	}
 }
 
@@ -309,6 +324,7 @@ void LLJoint::removeAllChildren()
         }
 	}
     mChildren.clear();
+	sHierarchyGeneration++;
 }
 
 
@@ -978,14 +994,53 @@ void LLJoint::updateWorldMatrixChildren()
 {	
 	if (!this->mUpdateXform) return;
 
-	if (mDirtyFlags & MATRIX_DIRTY)
+	U32 generation = sHierarchyGeneration;
+	// a copied joint brings along its original's list
+	if (mFlatHierarchyGeneration != generation || mFlatHierarchy.empty() || mFlatHierarchy.front().mJoint != this)
 	{
-		updateWorldMatrix();
+		mFlatHierarchy.clear();
+		appendFlatHierarchy(this, mFlatHierarchy);
+		mFlatHierarchyGeneration = generation;
 	}
-	for (LLJoint* joint : mChildren)
+
+	// Parents come before their children, so each joint sees its parent's
+	// new world transform, just as the recursion did.
+	const U32 count = (U32)mFlatHierarchy.size();
+	for (U32 i = 0; i < count; )
+	{
+		const FlatJoint& flat_joint = mFlatHierarchy[i];
+		LLJoint* joint = flat_joint.mJoint;
+		if (!joint->mUpdateXform)
+		{
+			// nor anything below it
+			i = flat_joint.mSubtreeEnd;
+			continue;
+		}
+		if (joint->mDirtyFlags & MATRIX_DIRTY)
+		{
+			joint->updateWorldMatrix();
+		}
+		++i;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// appendFlatHierarchy()
+//-----------------------------------------------------------------------------
+//static
+void LLJoint::appendFlatHierarchy(LLJoint* joint, std::vector<FlatJoint>& flat_hierarchy)
+{
+	U32 index = (U32)flat_hierarchy.size();
+	FlatJoint flat_joint = { joint, 0 };
+	flat_hierarchy.push_back(flat_joint);
+	for (LLJoint* child : joint->mChildren)
 	{
-		joint->updateWorldMatrixChildren();
+		if (child)
+		{
+			appendFlatHierarchy(child, flat_hierarchy);
+		}
 	}
+	flat_hierarchy[index].mSubtreeEnd = (U32)flat_hierarchy.size();
 }
 
 //-----------------------------------------------------------------------------
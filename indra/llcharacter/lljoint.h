@@ -30,9 +30,12 @@
 //-----------------------------------------------------------------------------
 // Header Files
 //-----------------------------------------------------------------------------
+#include <atomic>
 #include <string>
 #include <list>
+#include <vector>
 
+#include "llinternedstring.h"
 #include "v3math.h"
 #include "v4math.h"
 #include "m4math.h"
@@ -121,7 +124,7 @@ protected:
     LL_ALIGN_16(LLMatrix4a          mWorldMatrix);
     LLXformMatrix       mXform;
 	
-    std::string	mName;
+    LLInternedString mName;
 
 	SupportCategory mSupport;
 
@@ -130,6 +133,19 @@ protected:
 
     LLVector3       mDefaultPosition;
     LLVector3       mDefaultScale;
+
+	// this joint and its descendants in depth first order, for
+	// updateWorldMatrixChildren()
+	struct FlatJoint
+	{
+		LLJoint*	mJoint;
+		U32			mSubtreeEnd;	// index just past the joint's descendants
+	};
+	std::vector<FlatJoint>	mFlatHierarchy;
+	U32						mFlatHierarchyGeneration;
+	static std::atomic<U32>	sHierarchyGeneration;	// bumped on every change of parent
+
+	static void appendFlatHierarchy(LLJoint* joint, std::vector<FlatJoint>& flat_hierarchy);
     
 public:
 	U32				mDirtyFlags;
@@ -148,9 +164,9 @@ public:
 	typedef std::vector<LLJoint*> joints_t;
 	joints_t mChildren;
 
-	// debug statics
-	static S32		sNumTouches;
-	static S32		sNumUpdates;
+	// debug statics, atomic as motions may be evaluated off the main thread
+	static std::atomic<S32>	sNumTouches;
+	static std::atomic<S32>	sNumUpdates;
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
@@ -199,8 +215,9 @@ public:
 	void touch(U32 flags = ALL_DIRTY);
 
 	// get/set name
-	const std::string& getName() const { return mName; }
-	void setName( const std::string &name ) { mName = name; }
+	const std::string& getName() const { return mName.str(); }
+	const LLInternedString& getInternedName() const { return mName; }
+	void setName( const std::string &name ) { mName = LLInternedString(name); }
 
     // joint num
 	S32 getJointNum() const { return mJointNum; }
@@ -223,6 +240,7 @@ public:
 
 	// search for child joints by name
 	LLJoint *findJoint( const std::string &name );
+	LLJoint *findJoint( const LLInternedString &name );
 
 	// add/remove children
 	void addChild( LLJoint *joint );
@@ -265,6 +283,9 @@ public:
 
     const LLMatrix4a& getWorldMatrix4a();
 
+	// Updates this joint and everything below it in one linear pass over a
+	// depth first copy of the hierarchy, rebuilt whenever any joint gains or
+	// loses a child, instead of recursing through the children.
 	void updateWorldMatrixChildren();
 	void updateWorldMatrixParent();
 
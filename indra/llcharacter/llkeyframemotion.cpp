@@ -42,11 +42,16 @@
 #include "m3math.h"
 #include "message.h"
 #include "llfilesystem.h"
+#include "lltimer.h"
 
 //-----------------------------------------------------------------------------
 // Static Definitions
 //-----------------------------------------------------------------------------
 LLKeyframeDataCache::keyframe_data_map_t	LLKeyframeDataCache::sKeyframeDataMap;
+U32 LLKeyframeDataCache::sDecodes = 0;
+F64 LLKeyframeDataCache::sDecodeTime = 0.0;
+U32 LLKeyframeDataCache::sShares = 0;
+F64 LLKeyframeDataCache::sDecodeTimeSaved = 0.0;
 
 //-----------------------------------------------------------------------------
 // Globals
@@ -73,18 +78,107 @@ LLKeyframeMotion::JointMotionList::JointMotionList()
 	  mEaseOutDuration(0.f),
 	  mBasePriority(LLJoint::LOW_PRIORITY),
 	  mHandPose(LLHandMotion::HAND_POSE_SPREAD),
-	  mMaxPriority(LLJoint::LOW_PRIORITY)
+	  mMaxPriority(LLJoint::LOW_PRIORITY),
+	  mDecodeTime(0.f)
 {
 }
 
+LLKeyframeMotion::JointMotionList::JointMotionList(const JointMotionList& other)
+	: LLRefCount(),
+	  mDuration(other.mDuration),
+	  mLoop(other.mLoop),
+	  mLoopInPoint(other.mLoopInPoint),
+	  mLoopOutPoint(other.mLoopOutPoint),
+	  mEaseInDuration(other.mEaseInDuration),
+	  mEaseOutDuration(other.mEaseOutDuration),
+	  mBasePriority(other.mBasePriority),
+	  mHandPose(other.mHandPose),
+	  mMaxPriority(other.mMaxPriority),
+	  mConstraints(other.mConstraints),
+	  mPelvisBBox(other.mPelvisBBox),
+	  mEmoteName(other.mEmoteName),
+	  mDecodeTime(other.mDecodeTime)
+{
+	mJointMotionArray.reserve(other.mJointMotionArray.size());
+	for (JointMotion* joint_motion : other.mJointMotionArray)
+	{
+		mJointMotionArray.push_back(new JointMotion(*joint_motion));
+	}
+}
+
 LLKeyframeMotion::JointMotionList::~JointMotionList()
 {
-	for_each(mConstraints.begin(), mConstraints.end(), DeletePointer());
 	mConstraints.clear();
 	for_each(mJointMotionArray.begin(), mJointMotionArray.end(), DeletePointer());
 	mJointMotionArray.clear();
 }
 
+LLKeyframeMotion::JointMotionList* LLKeyframeMotion::JointMotionList::clone() const
+{
+	return new JointMotionList(*this);
+}
+
+U32 LLKeyframeMotion::JointMotionList::getSize() const
+{
+	U32 total_size = sizeof(JointMotionList);
+
+	for (JointMotion* joint_motion_p : mJointMotionArray)
+	{
+		total_size += sizeof(JointMotion);
+		total_size += joint_motion_p->mScaleCurve.mNumKeys * sizeof(ScaleKey);
+		total_size += joint_motion_p->mRotationCurve.mNumKeys * sizeof(RotationKey);
+		total_size += joint_motion_p->mPositionCurve.mNumKeys * sizeof(PositionKey);
+	}
+	for (const JointConstraintSharedData* shared_constraintp : mConstraints)
+	{
+		total_size += sizeof(JointConstraintSharedData) + (shared_constraintp->mChainLength + 1) * sizeof(S32);
+	}
+
+	return total_size;
+}
+
+void LLKeyframeMotion::JointMotionList::setLoopInPoint(F32 in_point)
+{
+	mLoopInPoint = in_point;
+
+	// set up loop keys
+	for (JointMotion* joint_motion : mJointMotionArray)
+	{
+		PositionCurve* pos_curve = &joint_motion->mPositionCurve;
+		RotationCurve* rot_curve = &joint_motion->mRotationCurve;
+		ScaleCurve* scale_curve = &joint_motion->mScaleCurve;
+
+		pos_curve->mLoopInKey.mTime = mLoopInPoint;
+		rot_curve->mLoopInKey.mTime = mLoopInPoint;
+		scale_curve->mLoopInKey.mTime = mLoopInPoint;
+
+		pos_curve->mLoopInKey.mPosition = pos_curve->getValue(mLoopInPoint, mDuration);
+		rot_curve->mLoopInKey.mRotation = rot_curve->getValue(mLoopInPoint, mDuration);
+		scale_curve->mLoopInKey.mScale = scale_curve->getValue(mLoopInPoint, mDuration);
+	}
+}
+
+void LLKeyframeMotion::JointMotionList::setLoopOutPoint(F32 out_point)
+{
+	mLoopOutPoint = out_point;
+
+	// set up loop keys
+	for (JointMotion* joint_motion : mJointMotionArray)
+	{
+		PositionCurve* pos_curve = &joint_motion->mPositionCurve;
+		RotationCurve* rot_curve = &joint_motion->mRotationCurve;
+		ScaleCurve* scale_curve = &joint_motion->mScaleCurve;
+
+		pos_curve->mLoopOutKey.mTime = mLoopOutPoint;
+		rot_curve->mLoopOutKey.mTime = mLoopOutPoint;
+		scale_curve->mLoopOutKey.mTime = mLoopOutPoint;
+
+		pos_curve->mLoopOutKey.mPosition = pos_curve->getValue(mLoopOutPoint, mDuration);
+		rot_curve->mLoopOutKey.mRotation = rot_curve->getValue(mLoopOutPoint, mDuration);
+		scale_curve->mLoopOutKey.mScale = scale_curve->getValue(mLoopOutPoint, mDuration);
+	}
+}
+
 U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 {
 	S32	total_size = sizeof(JointMotionList);
@@ -530,31 +624,7 @@ LLMotion::LLMotionInitStatus LLKeyframeMotion::onInitialize(LLCharacter *charact
 	if(joint_motion_list)
 	{
 		// motion already existed in cache, so grab it
-		mJointMotionList = joint_motion_list;
-
-		mJointStates.reserve(mJointMotionList->getNumJointMotions());
-		
-		// don't forget to allocate joint states
-		// set up joint states to point to character joints
-		for(U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
-		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-			if (LLJoint *joint = mCharacter->getJoint(joint_motion->mJointName))
-			{
-				LLPointer<LLJointState> joint_state = new LLJointState;
-				mJointStates.push_back(joint_state);
-				joint_state->setJoint(joint);
-				joint_state->setUsage(joint_motion->mUsage);
-				joint_state->setPriority(joint_motion->mPriority);
-			}
-			else
-			{
-				// add dummy joint state with no associated joint
-				mJointStates.push_back(new LLJointState);
-			}
-		}
-		mAssetStatus = ASSET_LOADED;
-		setupPose();
+		shareJointMotionList(joint_motion_list);
 		return STATUS_SUCCESS;
 	}
 
@@ -649,13 +719,59 @@ BOOL LLKeyframeMotion::setupPose()
 		}
 	}
 
-	// setup loop keys
-	setLoopIn(mJointMotionList->mLoopInPoint);
-	setLoopOut(mJointMotionList->mLoopOutPoint);
-
 	return TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// shareJointMotionList()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::shareJointMotionList(JointMotionList* joint_motion_list)
+{
+	mJointMotionList = joint_motion_list;
+	LLKeyframeDataCache::sShares++;
+	LLKeyframeDataCache::sDecodeTimeSaved += joint_motion_list->mDecodeTime;
+
+	mJointStates.clear();
+	mJointStates.reserve(mJointMotionList->getNumJointMotions());
+	
+	// don't forget to allocate joint states
+	// set up joint states to point to character joints
+	for(U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
+	{
+		JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
+		if (LLJoint *joint = mCharacter->getJoint(joint_motion->mJointName))
+		{
+			LLPointer<LLJointState> joint_state = new LLJointState;
+			mJointStates.push_back(joint_state);
+			joint_state->setJoint(joint);
+			joint_state->setUsage(joint_motion->mUsage);
+			joint_state->setPriority(joint_motion->mPriority);
+		}
+		else
+		{
+			// add dummy joint state with no associated joint
+			mJointStates.push_back(new LLJointState);
+		}
+	}
+	mAssetStatus = ASSET_LOADED;
+	setupPose();
+}
+
+//-----------------------------------------------------------------------------
+// getWritableJointMotionList()
+//-----------------------------------------------------------------------------
+LLKeyframeMotion::JointMotionList* LLKeyframeMotion::getWritableJointMotionList()
+{
+	// the cache's reference doesn't count, the owner of a motion that is
+	// being edited (the upload preview) expects the edits to be cached
+	S32 owners = (LLKeyframeDataCache::getKeyframeData(getID()) == mJointMotionList.get()) ? 2 : 1;
+	if (mJointMotionList->getNumRefs() > owners)
+	{
+		mJointMotionList = mJointMotionList->clone();
+	}
+	return mJointMotionList;
+}
+
 //-----------------------------------------------------------------------------
 // LLKeyframeMotion::onActivate()
 //-----------------------------------------------------------------------------
@@ -1228,7 +1344,8 @@ void LLKeyframeMotion::applyConstraint(JointConstraint* constraint, F32 time, U8
 BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, bool allow_invalid_joints)
 {
 	BOOL old_version = FALSE;
-	std::unique_ptr<LLKeyframeMotion::JointMotionList> joint_motion_list(new LLKeyframeMotion::JointMotionList);
+	LLTimer decode_timer;
+	LLPointer<LLKeyframeMotion::JointMotionList> joint_motion_list = new LLKeyframeMotion::JointMotionList;
 
 	//-------------------------------------------------------------------------
 	// get base priority
@@ -1781,7 +1898,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 		for(S32 i = 0; i < num_constraints; ++i)
 		{
 			// read in constraint data
-			std::unique_ptr<JointConstraintSharedData> constraintp(new JointConstraintSharedData);
+			LLPointer<JointConstraintSharedData> constraintp = new JointConstraintSharedData;
 			U8 byte = 0;
 
 			if (!dp.unpackU8(byte, "chain_length"))
@@ -1981,12 +2098,16 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 				}
 			}
 
-			joint_motion_list->mConstraints.push_front(constraintp.release());
+			joint_motion_list->mConstraints.push_front(constraintp);
 		}
 	}
 
-	// *FIX: support cleanup of old keyframe data
-    mJointMotionList = joint_motion_list.release(); // release from unique_ptr to member;
+	// setup loop keys, the list is shared and read only from here on
+	joint_motion_list->setLoopInPoint(joint_motion_list->mLoopInPoint);
+	joint_motion_list->setLoopOutPoint(joint_motion_list->mLoopOutPoint);
+	joint_motion_list->mDecodeTime = decode_timer.getElapsedTimeF32();
+
+	mJointMotionList = joint_motion_list;
 	LLKeyframeDataCache::addKeyframeData(getID(),  mJointMotionList);
 	mAssetStatus = ASSET_LOADED;
 
@@ -2216,13 +2337,14 @@ void LLKeyframeMotion::setPriority(S32 priority)
 {
 	if (mJointMotionList) 
 	{
-		S32 priority_delta = priority - mJointMotionList->mBasePriority;
-		mJointMotionList->mBasePriority = (LLJoint::JointPriority)priority;
-		mJointMotionList->mMaxPriority = mJointMotionList->mBasePriority;
+		JointMotionList* joint_motion_list = getWritableJointMotionList();
+		S32 priority_delta = priority - joint_motion_list->mBasePriority;
+		joint_motion_list->mBasePriority = (LLJoint::JointPriority)priority;
+		joint_motion_list->mMaxPriority = joint_motion_list->mBasePriority;
 
-		for (U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
+		for (U32 i = 0; i < joint_motion_list->getNumJointMotions(); i++)
 		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);			
+			JointMotion* joint_motion = joint_motion_list->getJointMotion(i);			
 			joint_motion->mPriority = (LLJoint::JointPriority)llclamp(
 				(S32)joint_motion->mPriority + priority_delta,
 				(S32)LLJoint::LOW_PRIORITY, 
@@ -2237,14 +2359,19 @@ void LLKeyframeMotion::setPriority(S32 priority)
 //-----------------------------------------------------------------------------
 void LLKeyframeMotion::setEmote(const LLUUID& emote_id)
 {
+	if (!mJointMotionList)
+	{
+		return;
+	}
+
 	const char* emote_name = gAnimLibrary.animStateToString(emote_id);
 	if (emote_name)
 	{
-		mJointMotionList->mEmoteName = emote_name;
+		getWritableJointMotionList()->mEmoteName = emote_name;
 	}
 	else
 	{
-		mJointMotionList->mEmoteName = "";
+		getWritableJointMotionList()->mEmoteName = "";
 	}
 }
 
@@ -2255,7 +2382,7 @@ void LLKeyframeMotion::setEaseIn(F32 ease_in)
 {
 	if (mJointMotionList)
 	{
-		mJointMotionList->mEaseInDuration = llmax(ease_in, 0.f);
+		getWritableJointMotionList()->mEaseInDuration = llmax(ease_in, 0.f);
 	}
 }
 
@@ -2266,7 +2393,7 @@ void LLKeyframeMotion::setEaseOut(F32 ease_in)
 {
 	if (mJointMotionList)
 	{
-		mJointMotionList->mEaseOutDuration = llmax(ease_in, 0.f);
+		getWritableJointMotionList()->mEaseOutDuration = llmax(ease_in, 0.f);
 	}
 }
 
@@ -2276,8 +2403,8 @@ void LLKeyframeMotion::setEaseOut(F32 ease_in)
 //-----------------------------------------------------------------------------
 void LLKeyframeMotion::flushKeyframeCache()
 {
-	// TODO: Make this safe to do
-// 	LLKeyframeDataCache::clear();
+	// motions that are playing keep their data alive
+	LLKeyframeDataCache::clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -2287,7 +2414,7 @@ void LLKeyframeMotion::setLoop(BOOL loop)
 {
 	if (mJointMotionList) 
 	{
-		mJointMotionList->mLoop = loop; 
+		getWritableJointMotionList()->mLoop = loop; 
 		mSendStopTimestamp = F32_MAX;
 	}
 }
@@ -2300,25 +2427,7 @@ void LLKeyframeMotion::setLoopIn(F32 in_point)
 {
 	if (mJointMotionList)
 	{
-		mJointMotionList->mLoopInPoint = in_point; 
-		
-		// set up loop keys
-		for (U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
-		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-			
-			PositionCurve* pos_curve = &joint_motion->mPositionCurve;
-			RotationCurve* rot_curve = &joint_motion->mRotationCurve;
-			ScaleCurve* scale_curve = &joint_motion->mScaleCurve;
-			
-			pos_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
-			rot_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
-			scale_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
-
-			pos_curve->mLoopInKey.mPosition = pos_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-			rot_curve->mLoopInKey.mRotation = rot_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-			scale_curve->mLoopInKey.mScale = scale_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-		}
+		getWritableJointMotionList()->setLoopInPoint(in_point);
 	}
 }
 
@@ -2329,25 +2438,7 @@ void LLKeyframeMotion::setLoopOut(F32 out_point)
 {
 	if (mJointMotionList)
 	{
-		mJointMotionList->mLoopOutPoint = out_point; 
-		
-		// set up loop keys
-		for (U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
-		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-			
-			PositionCurve* pos_curve = &joint_motion->mPositionCurve;
-			RotationCurve* rot_curve = &joint_motion->mRotationCurve;
-			ScaleCurve* scale_curve = &joint_motion->mScaleCurve;
-			
-			pos_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
-			rot_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
-			scale_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
-
-			pos_curve->mLoopOutKey.mPosition = pos_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-			rot_curve->mLoopOutKey.mRotation = rot_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-			scale_curve->mLoopOutKey.mScale = scale_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-		}
+		getWritableJointMotionList()->setLoopOutPoint(out_point);
 	}
 }
 
@@ -2388,6 +2479,12 @@ void LLKeyframeMotion::onLoadComplete(const LLUUID& asset_uuid,
 				// asset already loaded
 				return;
 			}
+			if (JointMotionList* joint_motion_list = LLKeyframeDataCache::getKeyframeData(asset_uuid))
+			{
+				// another character fetching the same animation has already decoded it
+				motionp->shareJointMotionList(joint_motion_list);
+				return;
+			}
 			LLFileSystem file(asset_uuid, type, LLFileSystem::READ);
 			S32 size = file.getSize();
 			
@@ -2463,6 +2560,8 @@ void LLKeyframeDataCache::dumpDiagInfo()
 void LLKeyframeDataCache::addKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* joint_motion_listp)
 {
 	sKeyframeDataMap[id] = joint_motion_listp;
+	sDecodes++;
+	sDecodeTime += joint_motion_listp->mDecodeTime;
 }
 
 //--------------------------------------------------------------------
@@ -2473,7 +2572,6 @@ void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 	keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
 	if (found_data != sKeyframeDataMap.end())
 	{
-		delete found_data->second;
 		sKeyframeDataMap.erase(found_data);
 	}
 }
@@ -2504,10 +2602,36 @@ LLKeyframeDataCache::~LLKeyframeDataCache()
 //-----------------------------------------------------------------------------
 void LLKeyframeDataCache::clear()
 {
-	for_each(sKeyframeDataMap.begin(), sKeyframeDataMap.end(), DeletePairedPointer());
 	sKeyframeDataMap.clear();
 }
 
+//-----------------------------------------------------------------------------
+// getStats()
+//-----------------------------------------------------------------------------
+void LLKeyframeDataCache::getStats(Stats& stats)
+{
+	stats.mAnimations = (U32)sKeyframeDataMap.size();
+	stats.mMotions = 0;
+	stats.mBytes = 0;
+	stats.mBytesSaved = 0;
+	for (keyframe_data_map_t::value_type& data_pair : sKeyframeDataMap)
+	{
+		U32 size = data_pair.second->getSize();
+		// one of the references is the cache's
+		U32 motions = (U32)data_pair.second->getNumRefs() - 1;
+		stats.mMotions += motions;
+		stats.mBytes += size;
+		if (motions > 1)
+		{
+			stats.mBytesSaved += size * (motions - 1);
+		}
+	}
+	stats.mDecodes = sDecodes;
+	stats.mDecodeTime = sDecodeTime;
+	stats.mShares = sShares;
+	stats.mDecodeTimeSaved = sDecodeTimeSaved;
+}
+
 //-----------------------------------------------------------------------------
 // JointConstraint()
 //-----------------------------------------------------------------------------
@@ -157,7 +157,7 @@ public:
 	U32		getFileSize();
 	BOOL	serialize(LLDataPacker& dp) const;
 	BOOL	deserialize(LLDataPacker& dp, const LLUUID& asset_id, bool allow_invalid_joints = true);
-	BOOL	isLoaded() { return mJointMotionList != NULL; }
+	BOOL	isLoaded() { return mJointMotionList.notNull(); }
     bool	dumpToFile(const std::string& name);
 
 
@@ -177,7 +177,7 @@ public:
 	void setLoopOut(F32 out_point);
 
 	void setHandPose(LLHandMotion::eHandPose pose) {
-		if (mJointMotionList) mJointMotionList->mHandPose = pose;
+		if (mJointMotionList) getWritableJointMotionList()->mHandPose = pose;
 	}
 
 	LLHandMotion::eHandPose getHandPose() { 
@@ -202,7 +202,7 @@ protected:
 	//-------------------------------------------------------------------------
 	// JointConstraintSharedData
 	//-------------------------------------------------------------------------
-	class JointConstraintSharedData
+	class JointConstraintSharedData : public LLRefCount
 	{
 	public:
 		JointConstraintSharedData() :
@@ -392,8 +392,13 @@ public:
 	
 	//-------------------------------------------------------------------------
 	// JointMotionList
+	//
+	// The decoded curves of an animation. One list is shared by every
+	// LLKeyframeMotion playing the same animation id (see LLKeyframeDataCache)
+	// so it must be treated as read only once it has been cached, the
+	// motions only keep their own playback state.
 	//-------------------------------------------------------------------------
-	class JointMotionList
+	class JointMotionList : public LLRefCount
 	{
 	public:
 		std::vector<JointMotion*> mJointMotionArray;
@@ -406,23 +411,38 @@ public:
 		LLJoint::JointPriority	mBasePriority;
 		LLHandMotion::eHandPose mHandPose;
 		LLJoint::JointPriority  mMaxPriority;
-		typedef std::list<JointConstraintSharedData*> constraint_list_t;
+		typedef std::list<LLPointer<JointConstraintSharedData> > constraint_list_t;
 		constraint_list_t		mConstraints;
 		LLBBoxLocal				mPelvisBBox;
 		// mEmoteName is a facial motion, but it's necessary to appear here so that it's cached.
 		// TODO: LLKeyframeDataCache::getKeyframeData should probably return a class containing 
 		// JointMotionList and mEmoteName, see LLKeyframeMotion::onInitialize.
 		std::string				mEmoteName; 
+		F32						mDecodeTime;	// seconds spent in deserialize()
 	public:
 		JointMotionList();
-		~JointMotionList();
 		U32 dumpDiagInfo();
+		U32 getSize() const;
+		// deep copy of the curves, the constraints are shared
+		JointMotionList* clone() const;
+		// move the loop point and recompute the loop keys of every curve
+		void setLoopInPoint(F32 in_point);
+		void setLoopOutPoint(F32 out_point);
 		JointMotion* getJointMotion(U32 index) const { llassert(index < mJointMotionArray.size()); return mJointMotionArray[index]; }
 		U32 getNumJointMotions() const { return mJointMotionArray.size(); }
+	protected:
+		JointMotionList(const JointMotionList& other);
+		~JointMotionList();
 	};
 
 protected:
-	JointMotionList*				mJointMotionList;
+	// use a decoded list from LLKeyframeDataCache instead of deserializing
+	void shareJointMotionList(JointMotionList* joint_motion_list);
+
+	// the list to modify, copied first if other motions share it
+	JointMotionList* getWritableJointMotionList();
+
+	LLPointer<JointMotionList>		mJointMotionList;
 	std::vector<LLPointer<LLJointState> > mJointStates;
 	LLJoint*						mPelvisp;
 	LLCharacter*					mCharacter;
@@ -444,17 +464,40 @@ public:
 	LLKeyframeDataCache(){};
 	~LLKeyframeDataCache();
 
-	typedef std::map<LLUUID, class LLKeyframeMotion::JointMotionList*> keyframe_data_map_t; 
+	typedef std::map<LLUUID, LLPointer<LLKeyframeMotion::JointMotionList> > keyframe_data_map_t; 
 	static keyframe_data_map_t sKeyframeDataMap;
 
 	static void addKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList*);
 	static LLKeyframeMotion::JointMotionList* getKeyframeData(const LLUUID& id);
 
+	// removing an entry (or clearing) only drops the cache's reference,
+	// motions that are using the data keep it alive
 	static void removeKeyframeData(const LLUUID& id);
 
 	//print out diagnostic info
 	static void dumpDiagInfo();
 	static void clear();
+
+	// memory held by the cache and how much sharing it saved
+	struct Stats
+	{
+		U32 mAnimations;		// decoded animations in the cache
+		U32 mMotions;			// motions using them
+		U32 mBytes;				// size of the decoded animations
+		U32 mBytesSaved;		// size of the copies the sharing motions would have made
+		U32 mDecodes;			// number of times an animation was decoded
+		F64 mDecodeTime;		// seconds spent decoding
+		U32 mShares;			// number of times a decode was skipped
+		F64 mDecodeTimeSaved;	// seconds those decodes would have taken
+	};
+	static void getStats(Stats& stats);
+
+private:
+	friend class LLKeyframeMotion;
+	static U32 sDecodes;
+	static F64 sDecodeTime;
+	static U32 sShares;
+	static F64 sDecodeTimeSaved;
 };
 
 #endif // LL_LLKEYFRAMEMOTION_H
@@ -817,11 +817,7 @@ void LLMotionController::updateMotions(bool force_update)
     // Currently setting mTimeStep to nonzero is disabled elsewhere.
 	BOOL use_quantum = (mTimeStep != 0.f);
 
-	// Always update mPrevTimerElapsed
-	F32 cur_time = mTimer.getElapsedTimeF32();
-	F32 delta_time = cur_time - mPrevTimerElapsed;
-	mPrevTimerElapsed = cur_time;
-	mLastTime = mAnimTime;
+	F32 delta_time = updateTimer();
 
 	// Always cap the number of loaded motions
 	purgeExcessMotions();
@@ -897,6 +893,60 @@ void LLMotionController::updateMotions(bool force_update)
 //	LL_INFOS() << "Motion controller time " << motionTimer.getElapsedTimeF32() << LL_ENDL;
 }
 
+//-----------------------------------------------------------------------------
+// prepareDeferredUpdate()
+//-----------------------------------------------------------------------------
+bool LLMotionController::prepareDeferredUpdate(bool force_update)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	if (mTimeStep != 0.f || (mPaused && !force_update))
+	{
+		// quantized and paused updates don't evaluate every motion, just do them now
+		updateMotions(force_update);
+		return false;
+	}
+
+	// same as updateMotions() up to evaluating the motions
+	F32 delta_time = updateTimer();
+	purgeExcessMotions();
+	if (!mPaused)
+	{
+		mAnimTime = mAnimTime + delta_time * mTimeFactor;
+	}
+	updateLoadingMotions();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateDeferredUpdate()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateDeferredUpdate()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	resetJointSignatures();
+
+	updateAdditiveMotions();
+
+	resetJointSignatures();
+
+	updateRegularMotions();
+
+	// start from the current pose and blend into the joint caches
+	mPoseBlender.blendAndCache(TRUE);
+}
+
+//-----------------------------------------------------------------------------
+// applyDeferredUpdate()
+//-----------------------------------------------------------------------------
+void LLMotionController::applyDeferredUpdate()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	mPoseBlender.interpolate(1.f);
+	mPoseBlender.clearBlenders();
+
+	mHasRunOnce = TRUE;
+}
+
 //-----------------------------------------------------------------------------
 // updateMotionsMinimal()
 // minimal update (e.g. while hidden)
@@ -916,6 +966,20 @@ void LLMotionController::updateMotionsMinimal()
 	mHasRunOnce = TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// updateTimer()
+// returns the time elapsed since the last update
+//-----------------------------------------------------------------------------
+F32 LLMotionController::updateTimer()
+{
+	// Always update mPrevTimerElapsed
+	F32 cur_time = mTimer.getElapsedTimeF32();
+	F32 delta_time = cur_time - mPrevTimerElapsed;
+	mPrevTimerElapsed = cur_time;
+	mLastTime = mAnimTime;
+	return delta_time;
+}
+
 //-----------------------------------------------------------------------------
 // activateMotionInstance()
 //-----------------------------------------------------------------------------
@@ -135,6 +135,18 @@ public:
 	// minimal update (e.g. while hidden)
 	void updateMotionsMinimal();
 
+	// updateMotions() split up so the motions of several characters can be
+	// evaluated in parallel. prepareDeferredUpdate() runs on the main thread
+	// and returns true if the motions still need evaluating, otherwise it has
+	// done the whole update itself. evaluateDeferredUpdate() may then run on
+	// any thread so long as nothing else touches the character meanwhile.
+	// It blends the new pose into the pose blender's joint caches rather than
+	// the skeleton, which keeps the old pose until applyDeferredUpdate()
+	// swaps the new one in back on the main thread.
+	bool prepareDeferredUpdate(bool force_update = false);
+	void evaluateDeferredUpdate();
+	void applyDeferredUpdate();
+
 	void clearBlenders() { mPoseBlender.clearBlenders(); }
 
 	// flush motions
@@ -191,6 +203,7 @@ protected:
 	void updateIdleActiveMotions();
 	void purgeExcessMotions();
 	void deactivateStoppedMotions();
+	F32 updateTimer();
 
 protected:
 	F32					mTimeFactor;			// 1.f for normal speed
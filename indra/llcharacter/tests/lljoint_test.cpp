@@ -221,6 +221,37 @@ namespace tut
 		ensure("2. addChild failed to remove prior parent", llparent1.findJoint("child2") == NULL);
 	}
 
+	template<> template<>
+	void lljoint_object::test<15>()
+	{
+		LLJoint llroot("root");
+		LLJoint llparent("parent");
+		LLJoint llchild("child");
+		LLJoint llsibling("sibling");
+		llroot.addChild(&llparent);
+		llparent.addChild(&llchild);
+		llroot.addChild(&llsibling);
+		llparent.setPosition(LLVector3(1.f, 0.f, 0.f));
+		llchild.setPosition(LLVector3(0.f, 2.f, 0.f));
+		llsibling.setPosition(LLVector3(0.f, 0.f, 3.f));
+
+		llroot.updateWorldMatrixChildren();
+		ensure("1. updateWorldMatrixChildren() failed", llchild.getXform()->getWorldMatrix().getTranslation() == LLVector3(1.f, 2.f, 0.f));
+		ensure("2. updateWorldMatrixChildren() failed", llsibling.getXform()->getWorldMatrix().getTranslation() == LLVector3(0.f, 0.f, 3.f));
+
+		// joints that don't update their xform skip their whole subtree
+		llparent.mUpdateXform = FALSE;
+		llparent.setPosition(LLVector3(4.f, 0.f, 0.f));
+		llroot.updateWorldMatrixChildren();
+		ensure("3. updateWorldMatrixChildren() updated a skipped joint", llchild.getXform()->getWorldMatrix().getTranslation() == LLVector3(1.f, 2.f, 0.f));
+
+		// a new parent is picked up
+		llparent.mUpdateXform = TRUE;
+		llsibling.addChild(&llchild);
+		llroot.updateWorldMatrixChildren();
+		ensure("4. updateWorldMatrixChildren() missed a reparented joint", llchild.getXform()->getWorldMatrix().getTranslation() == LLVector3(0.f, 2.f, 3.f));
+	}
+
 
 	/*
 		Test cases for the following not added. They perform operations 
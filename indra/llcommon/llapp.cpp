@@ -384,6 +384,9 @@ void LLApp::setErrorHandler(LLAppErrorHandler handler)
 // static
 void LLApp::runErrorHandler()
 {
+	// the error handler may well not return, get the log onto disk first
+	LLError::flushRecorders();
+
 	if (LLApp::sErrorHandler)
 	{
 		LLApp::sErrorHandler();
@@ -1,6 +1,6 @@
 /** 
  * @file llbase64.cpp
- * @brief Wrapper for apr base64 encoding that returns a std::string
+ * @brief Base64 encoding and decoding
  * @author James Cook
  *
  * $LicenseInfo:firstyear=2007&license=viewerlgpl$
@@ -31,8 +31,124 @@
 
 #include <string>
 
-#include "apr_base64.h"
+#include "llprocessor.h"
 
+#include <tmmintrin.h>
+
+// The SSSE3 loops are compiled for it whatever the build's baseline and
+// only called after checking the processor.
+#if LL_WINDOWS
+#define LL_TARGET_SSSE3
+#else
+#define LL_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+namespace
+{
+	const char ENCODE_TABLE[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	const U8 INVALID = 0xFF;
+
+	struct DecodeTable
+	{
+		U8 mValues[256];
+
+		DecodeTable()
+		{
+			memset(mValues, INVALID, sizeof(mValues));
+			for (U8 i = 0; i < 64; ++i)
+			{
+				mValues[(U8)ENCODE_TABLE[i]] = i;
+			}
+		}
+	};
+	const DecodeTable DECODE_TABLE;
+
+	bool use_ssse3()
+	{
+		static const bool sSSSE3 = LLProcessorInfo().hasSSE3S();
+		return sSSSE3;
+	}
+
+	// Splits 12 of the 16 bytes loaded into 16 six bit values, one per byte.
+	LL_TARGET_SSSE3 inline __m128i encode_reshuffle(__m128i in)
+	{
+		in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+		const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+		const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+		const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+		const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+		return _mm_or_si128(t1, t3);
+	}
+
+	// Six bit values to their characters: one offset per range of the alphabet.
+	LL_TARGET_SSSE3 inline __m128i encode_translate(__m128i in)
+	{
+		const __m128i offsets = _mm_setr_epi8('A', 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+											  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+											  '0' - 52, '+' - 62, '/' - 63, 0, 0);
+		// 0 for A-Z, 1 for a-z, 2..11 for the digits, 12 for + and 13 for /
+		__m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+		indices = _mm_sub_epi8(indices, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+		return _mm_add_epi8(in, _mm_shuffle_epi8(offsets, indices));
+	}
+
+	// Encodes 12 bytes at a time while 16 can be read, returns the bytes used.
+	LL_TARGET_SSSE3 size_t encode_ssse3(const U8* input, size_t input_size, char* output)
+	{
+		size_t pos = 0;
+		for (; pos + 16 <= input_size; pos += 12)
+		{
+			const __m128i in = _mm_loadu_si128((const __m128i*)(input + pos));
+			_mm_storeu_si128((__m128i*)output, encode_translate(encode_reshuffle(in)));
+			output += 16;
+		}
+		return pos;
+	}
+
+	// Decodes 16 characters at a time to 12 bytes, writing 16, while 16 can
+	// be read. Stops before the first block holding a character outside the
+	// alphabet, returns the characters used.
+	LL_TARGET_SSSE3 size_t decode_ssse3(const char* input, size_t input_size, U8* output)
+	{
+		// Bits set in both lookups mark a character outside the alphabet
+		const __m128i valid_low = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+												0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m128i valid_high = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+												 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		// Offset from a character to its value, by high nibble ('/' apart)
+		const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+											  0, 0, 0, 0, 0, 0, 0, 0);
+		const __m128i mask_2F = _mm_set1_epi8(0x2F);
+		const __m128i zero = _mm_setzero_si128();
+
+		size_t pos = 0;
+		for (; pos + 16 <= input_size; pos += 16)
+		{
+			__m128i in = _mm_loadu_si128((const __m128i*)(input + pos));
+			const __m128i high_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask_2F);
+			const __m128i low_nibbles = _mm_and_si128(in, mask_2F);
+			const __m128i high = _mm_shuffle_epi8(valid_high, high_nibbles);
+			const __m128i low = _mm_shuffle_epi8(valid_low, low_nibbles);
+			if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(low, high), zero)))
+			{
+				break;
+			}
+			const __m128i is_slash = _mm_cmpeq_epi8(in, mask_2F);
+			in = _mm_add_epi8(in, _mm_shuffle_epi8(offsets, _mm_add_epi8(is_slash, high_nibbles)));
+
+			// Pack the four six bit values of each 32 bit lane into three bytes
+			const __m128i pairs = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+			const __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+			_mm_storeu_si128((__m128i*)output,
+							 _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+																	 -1, -1, -1, -1)));
+			output += 12;
+		}
+		return pos;
+	}
+}
 
 // static
 std::string LLBase64::encode(const U8* input, size_t input_size)
@@ -41,21 +157,91 @@ std::string LLBase64::encode(const U8* input, size_t input_size)
 	if (input
 		&& input_size > 0)
 	{
-		// Yes, it returns int.
-		int b64_buffer_length = apr_base64_encode_len(narrow(input_size));
-		char* b64_buffer = new char[b64_buffer_length];
-		
-		// This is faster than apr_base64_encode() if you know
-		// you're not on an EBCDIC machine.  Also, the output is
-		// null terminated, even though the documentation doesn't
-		// specify.  See apr_base64.c for details. JC
-		b64_buffer_length = apr_base64_encode_binary(
-			b64_buffer,
-			input,
-			narrow(input_size));
-		output.assign(b64_buffer);
-		delete[] b64_buffer;
+		output.resize(((input_size + 2) / 3) * 4);
+		char* out = &output[0];
+
+		size_t pos = 0;
+		if (use_ssse3())
+		{
+			pos = encode_ssse3(input, input_size, out);
+			out += pos / 3 * 4;
+		}
+		for (; pos + 3 <= input_size; pos += 3)
+		{
+			U32 bits = (input[pos] << 16) | (input[pos + 1] << 8) | input[pos + 2];
+			*out++ = ENCODE_TABLE[(bits >> 18) & 0x3F];
+			*out++ = ENCODE_TABLE[(bits >> 12) & 0x3F];
+			*out++ = ENCODE_TABLE[(bits >> 6) & 0x3F];
+			*out++ = ENCODE_TABLE[bits & 0x3F];
+		}
+		if (pos < input_size)
+		{
+			U32 bits = input[pos] << 16;
+			if (pos + 1 < input_size)
+			{
+				bits |= input[pos + 1] << 8;
+			}
+			*out++ = ENCODE_TABLE[(bits >> 18) & 0x3F];
+			*out++ = ENCODE_TABLE[(bits >> 12) & 0x3F];
+			*out++ = (pos + 1 < input_size) ? ENCODE_TABLE[(bits >> 6) & 0x3F] : '=';
+			*out++ = '=';
+		}
 	}
 	return output;
 }
 
+// static
+std::vector<U8> LLBase64::decode(const char* input, size_t input_size)
+{
+	std::vector<U8> output;
+	if (!input || input_size == 0)
+	{
+		return output;
+	}
+
+	// decode_ssse3() writes 4 bytes past the 12 it produces
+	output.resize((input_size / 4) * 3 + 2 + 4);
+	U8* out = &output[0];
+
+	size_t pos = 0;
+	if (use_ssse3())
+	{
+		pos = decode_ssse3(input, input_size, out);
+		out += pos / 4 * 3;
+	}
+
+	const U8* values = DECODE_TABLE.mValues;
+	U32 bits = 0;
+	S32 count = 0;
+	for (; pos < input_size; ++pos)
+	{
+		U8 value = values[(U8)input[pos]];
+		if (value == INVALID)
+		{
+			break;
+		}
+		bits = (bits << 6) | value;
+		if (++count == 4)
+		{
+			*out++ = (U8)(bits >> 16);
+			*out++ = (U8)(bits >> 8);
+			*out++ = (U8)bits;
+			bits = 0;
+			count = 0;
+		}
+	}
+	// A trailing 2 or 3 characters hold 1 or 2 bytes; a single one is
+	// not enough for a byte and is dropped.
+	if (count == 2)
+	{
+		*out++ = (U8)(bits >> 4);
+	}
+	else if (count == 3)
+	{
+		*out++ = (U8)(bits >> 10);
+		*out++ = (U8)(bits >> 2);
+	}
+
+	output.resize(out - &output[0]);
+	return output;
+}
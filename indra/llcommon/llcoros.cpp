@@ -35,7 +35,9 @@
 // STL headers
 // std headers
 #include <atomic>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 // external library headers
 #include <boost/bind.hpp>
 #include <boost/fiber/fiber.hpp>
@@ -252,6 +254,129 @@ void LLCoros::printActiveCoroutines(const std::string& when)
     }
 }
 
+namespace
+{
+
+// Finished coroutine stacks kept for reuse. Coroutines can end on any
+// thread, so the pool is shared and locked. It is never destroyed, since
+// a detached fiber may hand its stack back during static destruction.
+class StackPool
+{
+public:
+    typedef boost::fibers::protected_fixedsize_stack allocator_t;
+
+    static StackPool& instance()
+    {
+        static StackPool* sPool = new StackPool;
+        return *sPool;
+    }
+
+    boost::context::stack_context allocate(std::size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (! mStacks.empty() && mSize == size)
+            {
+                boost::context::stack_context sctx = mStacks.back();
+                mStacks.pop_back();
+                ++mReused;
+                return sctx;
+            }
+        }
+        // allocate() throws std::bad_alloc when out of memory
+        boost::context::stack_context sctx = allocator_t(size).allocate();
+        ++mCreated;
+        return sctx;
+    }
+
+    void deallocate(std::size_t size, boost::context::stack_context& sctx) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (size != mSize)
+            {
+                // the stack size changed, the pooled stacks are no use now
+                for (auto& pooled : mStacks)
+                {
+                    allocator_t(mSize).deallocate(pooled);
+                }
+                mStacks.clear();
+                mSize = size;
+            }
+            if (mStacks.size() < mMaxStacks)
+            {
+                mStacks.push_back(sctx);
+                return;
+            }
+        }
+        allocator_t(size).deallocate(sctx);
+    }
+
+    void setMaxStacks(U32 count)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxStacks = count;
+        while (mStacks.size() > mMaxStacks)
+        {
+            allocator_t(mSize).deallocate(mStacks.back());
+            mStacks.pop_back();
+        }
+    }
+
+    void getStats(U32& created, U32& reused, U32& pooled)
+    {
+        created = mCreated.exchange(0);
+        reused = mReused.exchange(0);
+        std::lock_guard<std::mutex> lock(mMutex);
+        pooled = (U32)mStacks.size();
+    }
+
+private:
+    std::mutex mMutex;
+    std::vector<boost::context::stack_context> mStacks;
+    std::size_t mSize{ 0 };
+    U32 mMaxStacks{ 0 };
+    std::atomic<U32> mCreated{ 0 };
+    std::atomic<U32> mReused{ 0 };
+};
+
+// StackAllocator handed to each fiber, which keeps a copy of it until the
+// fiber ends
+class PooledStack
+{
+public:
+    PooledStack(std::size_t size):
+        mSize(size)
+    {}
+
+    boost::context::stack_context allocate()
+    {
+        return StackPool::instance().allocate(mSize);
+    }
+
+    void deallocate(boost::context::stack_context& sctx) noexcept
+    {
+        StackPool::instance().deallocate(mSize, sctx);
+    }
+
+private:
+    std::size_t mSize;
+};
+
+} // anonymous namespace
+
+void LLCoros::setStackPoolSize(U32 count)
+{
+    LL_DEBUGS("LLCoros") << "Keeping up to " << count << " coroutine stacks for reuse" << LL_ENDL;
+    StackPool::instance().setMaxStacks(count);
+}
+
+// static
+void LLCoros::getStackStats(U32& created, U32& reused, U32& pooled)
+{
+    StackPool::instance().getStats(created, reused, pooled);
+}
+
 std::string LLCoros::launch(const std::string& prefix, const callable_t& callable)
 {
     std::string name(generateDistinctName(prefix));
@@ -259,15 +384,16 @@ std::string LLCoros::launch(const std::string& prefix, const callable_t& callabl
     // when the fiber yields for whatever reason.
     // std::allocator_arg is a flag to indicate that the following argument is
     // a StackAllocator.
-    // protected_fixedsize_stack sets a guard page past the end of the new
-    // stack so that stack underflow will result in an access violation
-    // instead of weird, subtle, possibly undiagnosed memory stomps.
+    // PooledStack gets its stacks from protected_fixedsize_stack, which sets
+    // a guard page past the end of the new stack so that stack underflow
+    // will result in an access violation instead of weird, subtle, possibly
+    // undiagnosed memory stomps, or reuses the stack of a finished coroutine.
 
     try
     {
         boost::fibers::fiber newCoro(boost::fibers::launch::dispatch,
             std::allocator_arg,
-            boost::fibers::protected_fixedsize_stack(mStackSize),
+            PooledStack(mStackSize),
             [this, &name, &callable]() { toplevel(name, callable); });
 
         // You have two choices with a fiber instance: you can join() it or you
@@ -186,6 +186,20 @@ public:
      */
     void setStackSize(S32 stacksize);
 
+    /**
+     * Keep up to count stacks of finished coroutines and hand them to new
+     * ones, which saves mapping the stack and its guard page and faulting in
+     * its pages again. With 0, the default, each stack is freed as its
+     * coroutine ends.
+     */
+    void setStackPoolSize(U32 count);
+
+    /**
+     * Stacks newly allocated and stacks taken from the pool since the last
+     * call, and how many stacks are waiting in the pool now.
+     */
+    static void getStackStats(U32& created, U32& reused, U32& pooled);
+
     /// diagnostic
     void printActiveCoroutines(const std::string& when=std::string());
 
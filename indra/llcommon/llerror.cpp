@@ -31,7 +31,9 @@
 #include "llerrorcontrol.h"
 #include "llsdutil.h"
 
+#include <atomic>
 #include <cctype>
+#include <condition_variable>
 #ifdef __GNUC__
 # include <cxxabi.h>
 #endif // __GNUC__
@@ -43,6 +45,7 @@
 #else
 # include <io.h>
 #endif // !LL_WINDOWS
+#include <thread>
 #include <vector>
 #include "string.h"
 
@@ -121,6 +124,8 @@ namespace {
 			
 			syslog(syslogPriority, "%s", message.c_str());
 		}
+
+        virtual bool canRecordAsync() override { return true; }
 	private:
 		std::string mIdentity;
 	};
@@ -178,6 +183,8 @@ namespace {
             }
         }
 
+        virtual bool canRecordAsync() override { return true; }
+
 	private:
 		const std::string mName;
 		llofstream mFile;
@@ -268,6 +275,8 @@ namespace {
                  fprintf(stderr, "%s\n", message.c_str());
             }
 		}
+
+        virtual bool canRecordAsync() override { return true; }
 	
 	private:
 		bool mUseANSI;
@@ -341,6 +350,8 @@ namespace {
             LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
 			debugger_print(message);
 		}
+
+        virtual bool canRecordAsync() override { return true; }
 	};
 #endif
 }
@@ -494,6 +505,8 @@ namespace
 
         bool 								mLogAlwaysFlush;
 
+        bool 								mAsyncRecording;
+
         U32 								mEnabledLogTypesMask;
 
         LevelMap                            mFunctionLevelMap;
@@ -520,6 +533,7 @@ namespace
         : LLRefCount(),
         mDefaultLevel(LLError::LEVEL_DEBUG),
         mLogAlwaysFlush(true),
+        mAsyncRecording(false),
         mEnabledLogTypesMask(255),
         mFunctionLevelMap(),
         mClassLevelMap(),
@@ -929,6 +943,10 @@ namespace LLError
         {
             setAlwaysFlush(config["log-always-flush"]);
         }
+        if (config.has("log-async"))
+        {
+            setAsyncRecording(config["log-async"]);
+        }
         if (config.has("enabled-log-types-mask"))
         {
             setEnabledLogTypesMask(config["enabled-log-types-mask"].asInteger());
@@ -1213,6 +1231,193 @@ namespace
         return out.str();
     }
 
+	// Hands formatted messages for recorders that canRecordAsync() to a
+	// logger thread, so the thread that logs doesn't wait on the disk or the
+	// console. Producers push with a single atomic exchange (Vyukov's
+	// intrusive MPSC queue); only the thread holding mDrainMutex pops, which
+	// is normally the logger thread, but drainAll() lets a caller that has to
+	// know everything is written, such as LL_ERRS, take over.
+	class AsyncLog
+	{
+	public:
+		static AsyncLog* getInstance();
+
+		void push(const LLError::RecorderPtr& recorder, LLError::ELevel level, std::string&& message);
+
+		// write everything pushed so far, then leave the queue locked until
+		// the returned lock is released so nothing else writes meanwhile
+		std::unique_lock<std::mutex> drainAll();
+
+	private:
+		AsyncLog();
+		~AsyncLog();
+
+		struct Record
+		{
+			std::atomic<Record*> mNext{ nullptr };
+			LLError::RecorderPtr mRecorder;
+			LLError::ELevel mLevel = LLError::LEVEL_NONE;
+			std::string mMessage;
+		};
+
+		void enqueue(Record* record);
+		Record* pop();
+		// call with mDrainMutex locked
+		void drain(bool wait);
+		void run();
+
+		static std::atomic<bool> sDeleted;
+
+		std::atomic<Record*> mHead;		// most recently pushed
+		Record* mTail;					// next to pop, under mDrainMutex
+		Record mStub;
+		std::mutex mDrainMutex;
+
+		std::mutex mWakeMutex;
+		std::condition_variable mWake;
+		std::atomic<bool> mSleeping;
+		std::atomic<bool> mDone;
+		std::thread mThread;
+	};
+
+	std::atomic<bool> AsyncLog::sDeleted(false);
+
+	AsyncLog* AsyncLog::getInstance()
+	{
+		// static destructors can still log after this one has gone, they get
+		// NULL and write synchronously
+		static AsyncLog inst;
+		return sDeleted ? NULL : &inst;
+	}
+
+	AsyncLog::AsyncLog()
+		: mHead(&mStub),
+		mTail(&mStub),
+		mSleeping(false),
+		mDone(false)
+	{
+		mThread = std::thread([this]{ run(); });
+	}
+
+	AsyncLog::~AsyncLog()
+	{
+		sDeleted = true;
+		mDone = true;
+		{
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+			mWake.notify_one();
+		}
+		mThread.join();
+		std::lock_guard<std::mutex> lock(mDrainMutex);
+		drain(true);
+	}
+
+	void AsyncLog::push(const LLError::RecorderPtr& recorder, LLError::ELevel level, std::string&& message)
+	{
+		Record* record = new Record;
+		record->mRecorder = recorder;
+		record->mLevel = level;
+		record->mMessage = std::move(message);
+		enqueue(record);
+
+		if (mSleeping.load(std::memory_order_relaxed))
+		{
+			mWake.notify_one();
+		}
+	}
+
+	void AsyncLog::enqueue(Record* record)
+	{
+		record->mNext.store(nullptr, std::memory_order_relaxed);
+		Record* prev = mHead.exchange(record, std::memory_order_acq_rel);
+		// between the exchange and this store the queue is briefly broken in
+		// two, pop() sees the second half only once it's linked
+		prev->mNext.store(record, std::memory_order_release);
+	}
+
+	AsyncLog::Record* AsyncLog::pop()
+	{
+		Record* tail = mTail;
+		Record* next = tail->mNext.load(std::memory_order_acquire);
+		if (tail == &mStub)
+		{
+			if (!next)
+			{
+				return NULL;
+			}
+			mTail = next;
+			tail = next;
+			next = next->mNext.load(std::memory_order_acquire);
+		}
+		if (next)
+		{
+			mTail = next;
+			return tail;
+		}
+		if (tail != mHead.load(std::memory_order_acquire))
+		{
+			// a push is half done
+			return NULL;
+		}
+		// tail is the last record, put the stub behind it so it can go
+		enqueue(&mStub);
+		next = tail->mNext.load(std::memory_order_acquire);
+		if (next)
+		{
+			mTail = next;
+			return tail;
+		}
+		return NULL;
+	}
+
+	void AsyncLog::drain(bool wait)
+	{
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
+		while (true)
+		{
+			Record* record = pop();
+			if (record)
+			{
+				record->mRecorder->recordMessage(record->mLevel, record->mMessage);
+				delete record;
+			}
+			else if (wait && mTail != mHead.load(std::memory_order_acquire))
+			{
+				// wait out a push that another thread is in the middle of
+				std::this_thread::yield();
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	std::unique_lock<std::mutex> AsyncLog::drainAll()
+	{
+		std::unique_lock<std::mutex> lock(mDrainMutex);
+		drain(true);
+		return lock;
+	}
+
+	void AsyncLog::run()
+	{
+		LL_PROFILER_SET_THREAD_NAME("Logger");
+		while (!mDone)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mDrainMutex);
+				drain(false);
+			}
+
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mSleeping = true;
+			// a push that misses the flag is picked up on the timeout
+			mWake.wait_for(lock, std::chrono::milliseconds(10));
+			mSleeping = false;
+		}
+	}
+
 	void writeToRecorders(const LLError::CallSite& site, const std::string& message)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
@@ -1221,6 +1426,16 @@ namespace
 
         std::string escaped_message;
 
+        AsyncLog* async_log = s->mAsyncRecording ? AsyncLog::getInstance() : NULL;
+        std::unique_lock<std::mutex> drained;
+        if (async_log && level == LLError::LEVEL_ERROR)
+        {
+            // the last message before the crash: write out everything queued
+            // ahead of it, then write it directly
+            drained = async_log->drainAll();
+            async_log = NULL;
+        }
+
         LLMutexLock lock(&s->mRecorderMutex);
 		for (LLError::RecorderPtr& r : s->mRecorders)
 		{
@@ -1274,7 +1489,47 @@ namespace
                 message_stream << escaped_message;
             }
 
-			r->recordMessage(level, message_stream.str());
+			if (async_log && r->canRecordAsync())
+			{
+				async_log->push(r, level, message_stream.str());
+			}
+			else
+			{
+				r->recordMessage(level, message_stream.str());
+			}
+		}
+	}
+}
+
+namespace LLError
+{
+	void setAsyncRecording(bool async)
+	{
+		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+		if (s->mAsyncRecording && !async)
+		{
+			// anything still queued goes out before messages written directly
+			flushRecorders();
+		}
+		s->mAsyncRecording = async;
+	}
+
+	bool getAsyncRecording()
+	{
+		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+		return s->mAsyncRecording;
+	}
+
+	void flushRecorders()
+	{
+		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+		if (s->mAsyncRecording)
+		{
+			AsyncLog* async_log = AsyncLog::getInstance();
+			if (async_log)
+			{
+				async_log->drainAll();
+			}
 		}
 	}
 }
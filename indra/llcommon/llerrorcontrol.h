@@ -76,6 +76,14 @@ namespace LLError
 	LL_COMMON_API ELevel getDefaultLevel();
 	LL_COMMON_API void setAlwaysFlush(bool flush);
     LL_COMMON_API bool getAlwaysFlush();
+	LL_COMMON_API void setAsyncRecording(bool async);
+	LL_COMMON_API bool getAsyncRecording();
+		// Recorders that canRecordAsync() are written to by a logger thread
+		// rather than by the thread doing the logging. LL_ERRS still writes
+		// everything before it returns.
+	LL_COMMON_API void flushRecorders();
+		// Wait until everything logged so far has been written, e.g. before
+		// a crash report picks up the log file.
 	LL_COMMON_API void setEnabledLogTypesMask(U32 mask);
 	LL_COMMON_API U32 getEnabledLogTypesMask();
 	LL_COMMON_API void setFunctionLevel(const std::string& function_name, LLError::ELevel);
@@ -151,6 +159,11 @@ namespace LLError
 
 		virtual bool enabled() { return true; }
 
+		virtual bool canRecordAsync() { return false; }
+			// true if recordMessage() may be called from the logger thread
+			// when async recording is on. Recorders that touch state owned
+			// by another thread, like the debug console, keep the default.
+
 		bool wantsTime();
 		bool wantsTags();
 		bool wantsLevel();
@@ -27,6 +27,7 @@
 #ifndef LL_FASTTIMER_H
 #define LL_FASTTIMER_H
 
+#include "llhitchrecorder.h"
 #include "llinstancetracker.h"
 #include "lltrace.h"
 #include "lltreeiterators.h"
@@ -327,6 +328,8 @@ LL_FORCE_INLINE BlockTimer::~BlockTimer()
 	// do this in the destructor in case of recursion to get topmost caller
 	accumulator.mLastCaller = mParentTimerData.mTimeBlock;
 
+	LLHitchRecorder::record(cur_timer_data->mTimeBlock, mStartTime, mStartTime + total_time);
+
 	// we are only tracking self time, so subtract our total time delta from parents
 	mParentTimerData.mChildTime += total_time;
 
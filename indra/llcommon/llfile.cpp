@@ -33,6 +33,9 @@
 #include <vector>
 #else
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #include "linden_common.h"
@@ -361,6 +364,178 @@ const char *LLFile::tmpdir()
 }
 
 
+/************** read-only memory mapped file *******************/
+
+LLMappedFile::LLMappedFile() :
+	mData(nullptr),
+	mSize(0),
+	mWritable(false),
+#if LL_WINDOWS
+	mFileHandle(INVALID_HANDLE_VALUE),
+	mMappingHandle(nullptr)
+#else
+	mFileDescriptor(-1)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+	close();
+}
+
+bool LLMappedFile::open(const std::string& filename)
+{
+	close();
+
+#if LL_WINDOWS
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	// let others write the file as they could on posix, appending to a
+	// mapped file is fine, it's truncating it that isn't
+	mFileHandle = CreateFileW(utf16filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							  NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER size;
+	if (mFileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFileHandle, &size) || size.QuadPart <= 0)
+	{
+		close();
+		return false;
+	}
+	mMappingHandle = CreateFileMappingW(mFileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* data = mMappingHandle ? MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!data)
+	{
+		close();
+		return false;
+	}
+	mSize = (size_t)size.QuadPart;
+#else
+	mFileDescriptor = ::open(filename.c_str(), O_RDONLY);
+	llstat st;
+	if (mFileDescriptor < 0 || fstat(mFileDescriptor, &st) != 0 || st.st_size <= 0)
+	{
+		close();
+		return false;
+	}
+	void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, mFileDescriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	mSize = (size_t)st.st_size;
+#endif
+
+	mData = (const U8*)data;
+	return true;
+}
+
+bool LLMappedFile::openWritable(const std::string& filename, size_t size)
+{
+	close();
+	if (!size)
+	{
+		return false;
+	}
+
+#if LL_WINDOWS
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	mFileHandle = CreateFileW(utf16filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							  NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER file_size;
+	file_size.QuadPart = (LONGLONG)size;
+	if (mFileHandle == INVALID_HANDLE_VALUE
+		|| !SetFilePointerEx(mFileHandle, file_size, NULL, FILE_BEGIN)
+		|| !SetEndOfFile(mFileHandle))
+	{
+		close();
+		return false;
+	}
+	mMappingHandle = CreateFileMappingW(mFileHandle, NULL, PAGE_READWRITE, 0, 0, NULL);
+	void* data = mMappingHandle ? MapViewOfFile(mMappingHandle, FILE_MAP_WRITE, 0, 0, 0) : NULL;
+	if (!data)
+	{
+		close();
+		return false;
+	}
+#else
+	mFileDescriptor = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+	if (mFileDescriptor < 0 || ftruncate(mFileDescriptor, (off_t)size) != 0)
+	{
+		close();
+		return false;
+	}
+	void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFileDescriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+#endif
+
+	mData = (const U8*)data;
+	mSize = size;
+	mWritable = true;
+	return true;
+}
+
+void LLMappedFile::willNeed() const
+{
+	if (!mData)
+	{
+		return;
+	}
+#if LL_WINDOWS
+	// PrefetchVirtualMemory() is Windows 8 and later
+	struct MemoryRange
+	{
+		PVOID VirtualAddress;
+		SIZE_T NumberOfBytes;
+	};
+	typedef BOOL (WINAPI *prefetch_fn_t)(HANDLE, ULONG_PTR, MemoryRange*, ULONG);
+	static prefetch_fn_t prefetch = (prefetch_fn_t)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory");
+	if (prefetch)
+	{
+		MemoryRange range = { (PVOID)mData, mSize };
+		prefetch(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	posix_madvise((void*)mData, mSize, POSIX_MADV_WILLNEED);
+#endif
+}
+
+void LLMappedFile::close()
+{
+#if LL_WINDOWS
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle(mMappingHandle);
+		mMappingHandle = nullptr;
+	}
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFileHandle);
+		mFileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mData)
+	{
+		munmap((void*)mData, mSize);
+	}
+	if (mFileDescriptor >= 0)
+	{
+		::close(mFileDescriptor);
+		mFileDescriptor = -1;
+	}
+#endif
+	mData = nullptr;
+	mSize = 0;
+	mWritable = false;
+}
+
 /***************** Modified file stream created to overcome the incorrect behaviour of posix fopen in windows *******************/
 
 #if LL_WINDOWS
@@ -149,6 +149,42 @@ private:
     LLFILE* mFileHandle;
 };
 
+/// RAII memory mapping of a whole file, read-only unless opened with openWritable()
+class LL_COMMON_API LLMappedFile
+{
+public:
+    LLMappedFile();
+    LLMappedFile(const LLMappedFile&) = delete;
+    LLMappedFile& operator=(const LLMappedFile&) = delete;
+    ~LLMappedFile();
+
+    // map filename, returns false if it can't be opened or is empty
+    bool open(const std::string& filename);
+    // create or resize filename to size bytes and map it for writing,
+    // changes go back to the file without any explicit write
+    bool openWritable(const std::string& filename, size_t size);
+    void close();
+
+    bool isOpen() const { return mData != nullptr; }
+    const U8* getData() const { return mData; }
+    U8* getWritableData() const { return mWritable ? const_cast<U8*>(mData) : nullptr; }
+    size_t getSize() const { return mSize; }
+
+    // ask the OS to start reading the whole file in, without waiting for it
+    void willNeed() const;
+
+private:
+    const U8* mData;
+    size_t mSize;
+    bool mWritable;
+#if LL_WINDOWS
+    void* mFileHandle;
+    void* mMappingHandle;
+#else
+    int mFileDescriptor;
+#endif
+};
+
 #if LL_WINDOWS
 /**
  *  @brief  Controlling input for files.
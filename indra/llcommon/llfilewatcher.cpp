@@ -0,0 +1,502 @@
+/**
+ * @file llfilewatcher.cpp
+ * @brief Background notification of changes to watched files
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#endif
+
+#include "linden_common.h"
+
+#include "llfilewatcher.h"
+
+#include "llstring.h"
+
+#if LL_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// how long the thread waits for events before looking for new directories
+static const int WAIT_MS = 250;
+
+#if LL_WINDOWS
+// one wait handle per directory
+static const size_t MAX_DIRECTORIES = MAXIMUM_WAIT_OBJECTS;
+#endif
+
+struct LLFileWatcher::Directory
+{
+	struct File
+	{
+		U32 mRefs = 0;
+		U32 mChanges = 1;
+	};
+
+	std::string mPath;
+	std::map<std::string, File> mFiles;
+	bool mOpen = false;		// the watch is working
+	bool mFailed = false;	// don't try to open it again
+
+#if LL_LINUX
+	int mWatch = -1;
+#elif LL_WINDOWS
+	HANDLE mHandle = INVALID_HANDLE_VALUE;
+	OVERLAPPED mOverlapped;
+	std::vector<DWORD> mBuffer;
+
+	Directory() { memset(&mOverlapped, 0, sizeof(mOverlapped)); }
+	bool issueRead();
+#endif
+};
+
+LLFileWatcher::LLFileWatcher()
+:	mQuit(false),
+	mNotifyFD(-1)
+{
+#if LL_LINUX
+	mNotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mNotifyFD < 0)
+	{
+		LL_WARNS() << "inotify unavailable, watched files will be polled" << LL_ENDL;
+		return;
+	}
+#endif
+#if LL_LINUX || LL_WINDOWS
+	mThread = std::thread([this]() { run(); });
+#endif
+}
+
+LLFileWatcher::~LLFileWatcher()
+{
+	cleanupSingleton();
+}
+
+void LLFileWatcher::cleanupSingleton()
+{
+	mQuit = true;
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	LLMutexLock lock(&mMutex);
+	for (directory_map_t::iterator iter = mDirectories.begin(); iter != mDirectories.end(); ++iter)
+	{
+		closeDirectory(*iter->second);
+	}
+	mDirectories.clear();
+	for (size_t i = 0; i < mClosing.size(); ++i)
+	{
+		closeDirectory(*mClosing[i]);
+	}
+	mClosing.clear();
+
+#if LL_LINUX
+	if (mNotifyFD >= 0)
+	{
+		close(mNotifyFD);
+		mNotifyFD = -1;
+	}
+#endif
+}
+
+// static
+void LLFileWatcher::splitPath(const std::string& filename, std::string& dir, std::string& name)
+{
+	size_t slash = filename.find_last_of("/\\");
+	if (slash == std::string::npos)
+	{
+		dir = ".";
+		name = filename;
+	}
+	else
+	{
+		dir = filename.substr(0, slash + 1);
+		name = filename.substr(slash + 1);
+	}
+#if LL_WINDOWS
+	// notifications don't keep the case the file was asked for with
+	LLStringUtil::toLower(dir);
+	LLStringUtil::toLower(name);
+#endif
+}
+
+void LLFileWatcher::watch(const std::string& filename)
+{
+	if (!mThread.joinable())
+	{
+		return;
+	}
+
+	std::string dir_path, name;
+	splitPath(filename, dir_path, name);
+
+	LLMutexLock lock(&mMutex);
+	std::unique_ptr<Directory>& dir = mDirectories[dir_path];
+	if (!dir)
+	{
+		// the thread opens it, until then getChangeCount() says it isn't watched
+		dir.reset(new Directory);
+		dir->mPath = dir_path;
+	}
+	dir->mFiles[name].mRefs++;
+}
+
+void LLFileWatcher::unwatch(const std::string& filename)
+{
+	std::string dir_path, name;
+	splitPath(filename, dir_path, name);
+
+	LLMutexLock lock(&mMutex);
+	directory_map_t::iterator dir = mDirectories.find(dir_path);
+	if (dir == mDirectories.end())
+	{
+		return;
+	}
+
+	std::map<std::string, Directory::File>::iterator file = dir->second->mFiles.find(name);
+	if (file != dir->second->mFiles.end() && --file->second.mRefs == 0)
+	{
+		dir->second->mFiles.erase(file);
+	}
+
+	if (dir->second->mFiles.empty())
+	{
+		// the thread may be waiting on it, so it is closed there
+		mClosing.push_back(std::move(dir->second));
+		mDirectories.erase(dir);
+	}
+}
+
+bool LLFileWatcher::getChangeCount(const std::string& filename, U32& count)
+{
+	std::string dir_path, name;
+	splitPath(filename, dir_path, name);
+
+	LLMutexLock lock(&mMutex);
+	directory_map_t::const_iterator dir = mDirectories.find(dir_path);
+	if (dir == mDirectories.end() || !dir->second->mOpen)
+	{
+		return false;
+	}
+
+	std::map<std::string, Directory::File>::const_iterator file = dir->second->mFiles.find(name);
+	if (file == dir->second->mFiles.end())
+	{
+		return false;
+	}
+
+	count = file->second.mChanges;
+	return true;
+}
+
+// static
+void LLFileWatcher::touchAll(Directory& dir)
+{
+	for (std::map<std::string, Directory::File>::iterator iter = dir.mFiles.begin(); iter != dir.mFiles.end(); ++iter)
+	{
+		iter->second.mChanges = llmax(iter->second.mChanges + 1, 1U);
+	}
+}
+
+// static
+void LLFileWatcher::touch(Directory& dir, const std::string& name)
+{
+	std::map<std::string, Directory::File>::iterator iter = dir.mFiles.find(name);
+	if (iter != dir.mFiles.end())
+	{
+		iter->second.mChanges = llmax(iter->second.mChanges + 1, 1U);
+	}
+}
+
+#if LL_LINUX
+
+bool LLFileWatcher::openDirectory(Directory& dir)
+{
+	dir.mWatch = inotify_add_watch(mNotifyFD, dir.mPath.c_str(),
+		IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+	return dir.mWatch >= 0;
+}
+
+void LLFileWatcher::closeDirectory(Directory& dir)
+{
+	if (dir.mWatch >= 0)
+	{
+		inotify_rm_watch(mNotifyFD, dir.mWatch);
+		dir.mWatch = -1;
+	}
+	dir.mOpen = false;
+}
+
+void LLFileWatcher::run()
+{
+	LL_PROFILER_SET_THREAD_NAME("FileWatcher");
+
+	// big enough for many events, aligned for struct inotify_event
+	std::vector<U64> buffer(4096 / sizeof(U64));
+
+	while (!mQuit)
+	{
+		{
+			LLMutexLock lock(&mMutex);
+			for (size_t i = 0; i < mClosing.size(); ++i)
+			{
+				closeDirectory(*mClosing[i]);
+			}
+			mClosing.clear();
+
+			for (directory_map_t::iterator iter = mDirectories.begin(); iter != mDirectories.end(); ++iter)
+			{
+				Directory& dir = *iter->second;
+				if (!dir.mOpen && !dir.mFailed)
+				{
+					dir.mOpen = openDirectory(dir);
+					dir.mFailed = !dir.mOpen;
+					// anything may have changed before the watch began
+					touchAll(dir);
+				}
+			}
+		}
+
+		pollfd pfd;
+		pfd.fd = mNotifyFD;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, WAIT_MS) <= 0)
+		{
+			continue;
+		}
+
+		ssize_t size = read(mNotifyFD, &buffer[0], buffer.size() * sizeof(U64));
+		if (size <= 0)
+		{
+			continue;
+		}
+
+		LLMutexLock lock(&mMutex);
+		const char* data = (const char*)&buffer[0];
+		for (ssize_t pos = 0; pos < size; )
+		{
+			const inotify_event* event = (const inotify_event*)(data + pos);
+			pos += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				// events were dropped, we can't know which files changed
+				for (directory_map_t::iterator iter = mDirectories.begin(); iter != mDirectories.end(); ++iter)
+				{
+					touchAll(*iter->second);
+				}
+				continue;
+			}
+
+			Directory* dir = NULL;
+			for (directory_map_t::iterator iter = mDirectories.begin(); iter != mDirectories.end(); ++iter)
+			{
+				if (iter->second->mOpen && iter->second->mWatch == event->wd)
+				{
+					dir = iter->second.get();
+					break;
+				}
+			}
+			if (!dir)
+			{
+				continue;
+			}
+
+			if (event->mask & IN_IGNORED)
+			{
+				// the directory went away, leave its files to be checked by their owners
+				dir->mWatch = -1;
+				dir->mOpen = false;
+				dir->mFailed = true;
+				touchAll(*dir);
+			}
+			else if (event->len)
+			{
+				touch(*dir, std::string(event->name));
+			}
+		}
+	}
+}
+
+#elif LL_WINDOWS
+
+bool LLFileWatcher::Directory::issueRead()
+{
+	ResetEvent(mOverlapped.hEvent);
+	return ReadDirectoryChangesW(mHandle, &mBuffer[0], (DWORD)(mBuffer.size() * sizeof(DWORD)), FALSE,
+		FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+		NULL, &mOverlapped, NULL) != 0;
+}
+
+bool LLFileWatcher::openDirectory(Directory& dir)
+{
+	dir.mHandle = CreateFileW(ll_convert_string_to_wide(dir.mPath).c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (dir.mHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	dir.mOverlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	dir.mBuffer.resize(16384 / sizeof(DWORD));
+	if (!dir.mOverlapped.hEvent || !dir.issueRead())
+	{
+		closeDirectory(dir);
+		return false;
+	}
+	return true;
+}
+
+void LLFileWatcher::closeDirectory(Directory& dir)
+{
+	if (dir.mHandle != INVALID_HANDLE_VALUE)
+	{
+		if (dir.mOpen)
+		{
+			// the read must be finished before its buffer and event go away
+			DWORD bytes = 0;
+			CancelIoEx(dir.mHandle, &dir.mOverlapped);
+			GetOverlappedResult(dir.mHandle, &dir.mOverlapped, &bytes, TRUE);
+		}
+		CloseHandle(dir.mHandle);
+		dir.mHandle = INVALID_HANDLE_VALUE;
+	}
+	if (dir.mOverlapped.hEvent)
+	{
+		CloseHandle(dir.mOverlapped.hEvent);
+		dir.mOverlapped.hEvent = NULL;
+	}
+	dir.mOpen = false;
+}
+
+void LLFileWatcher::run()
+{
+	LL_PROFILER_SET_THREAD_NAME("FileWatcher");
+
+	std::vector<HANDLE> events;
+	std::vector<Directory*> waiting;
+
+	while (!mQuit)
+	{
+		events.clear();
+		waiting.clear();
+		{
+			LLMutexLock lock(&mMutex);
+			for (size_t i = 0; i < mClosing.size(); ++i)
+			{
+				closeDirectory(*mClosing[i]);
+			}
+			mClosing.clear();
+
+			for (directory_map_t::iterator iter = mDirectories.begin(); iter != mDirectories.end(); ++iter)
+			{
+				Directory& dir = *iter->second;
+				if (!dir.mOpen && !dir.mFailed)
+				{
+					dir.mOpen = (waiting.size() < MAX_DIRECTORIES) && openDirectory(dir);
+					dir.mFailed = !dir.mOpen;
+					// anything may have changed before the watch began
+					touchAll(dir);
+				}
+				if (dir.mOpen)
+				{
+					events.push_back(dir.mOverlapped.hEvent);
+					waiting.push_back(&dir);
+				}
+			}
+		}
+
+		if (events.empty())
+		{
+			Sleep(WAIT_MS);
+			continue;
+		}
+
+		// only this thread closes directories, so the ones we wait on stay alive
+		DWORD result = WaitForMultipleObjects((DWORD)events.size(), &events[0], FALSE, WAIT_MS);
+		if (result < WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + events.size())
+		{
+			continue;
+		}
+
+		Directory& dir = *waiting[result - WAIT_OBJECT_0];
+		LLMutexLock lock(&mMutex);
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(dir.mHandle, &dir.mOverlapped, &bytes, FALSE) || !bytes)
+		{
+			// the buffer overflowed or the read failed, we can't know which files changed
+			touchAll(dir);
+		}
+		else
+		{
+			const char* data = (const char*)&dir.mBuffer[0];
+			for (DWORD pos = 0; ; )
+			{
+				const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)(data + pos);
+				std::string name = ll_convert_wide_to_string(std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+				LLStringUtil::toLower(name);
+				touch(dir, name);
+				if (!info->NextEntryOffset)
+				{
+					break;
+				}
+				pos += info->NextEntryOffset;
+			}
+		}
+
+		if (!dir.issueRead())
+		{
+			// the directory went away, leave its files to be checked by their owners.
+			// No read is pending, so closing it doesn't wait for one.
+			dir.mOpen = false;
+			dir.mFailed = true;
+			closeDirectory(dir);
+			touchAll(dir);
+		}
+	}
+}
+
+#else
+
+bool LLFileWatcher::openDirectory(Directory& dir)
+{
+	return false;
+}
+
+void LLFileWatcher::closeDirectory(Directory& dir)
+{
+	dir.mOpen = false;
+}
+
+void LLFileWatcher::run()
+{
+}
+
+#endif
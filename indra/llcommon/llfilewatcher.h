@@ -0,0 +1,91 @@
+/**
+ * @file llfilewatcher.h
+ * @brief Background notification of changes to watched files
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFILEWATCHER_H
+#define LL_LLFILEWATCHER_H
+
+#include "llsingleton.h"
+#include "llmutex.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches the directories of the files it is asked about, with inotify on
+// Linux and ReadDirectoryChangesW on Windows, on a background thread.  Every
+// change to a watched file bumps a count for it.  Code that used to stat its
+// files on a timer keeps its timer but only looks at a file again when the
+// count moved on, so any number of changes between two checks costs it one
+// reload and unchanged files cost nothing.
+class LL_COMMON_API LLFileWatcher : public LLSingleton<LLFileWatcher>
+{
+	LLSINGLETON(LLFileWatcher);
+	~LLFileWatcher();
+	LOG_CLASS(LLFileWatcher);
+
+public:
+	// Start or stop watching a file, calls are counted per file name.
+	void watch(const std::string& filename);
+	void unwatch(const std::string& filename);
+
+	// Sets count to the number of changes (writes, renames, creation or
+	// removal) seen so far for a watched file.  Returns false if the file is
+	// not covered by a working watch, in which case the caller has to check
+	// the file itself.  A count of 0 is never returned, so a caller can start
+	// from 0 and will look at the file once when the watch begins.
+	bool getChangeCount(const std::string& filename, U32& count);
+
+private:
+	void cleanupSingleton() override;
+
+	struct Directory;
+	typedef std::map<std::string, std::unique_ptr<Directory> > directory_map_t;
+
+	static void splitPath(const std::string& filename, std::string& dir, std::string& name);
+
+	// bump the count of every file in dir, for when its events were lost
+	static void touchAll(Directory& dir);
+	// bump the count of one file in dir
+	static void touch(Directory& dir, const std::string& name);
+
+	// the background thread and the platform pieces it uses
+	void run();
+	bool openDirectory(Directory& dir);
+	void closeDirectory(Directory& dir);
+
+	LLMutex mMutex;
+	directory_map_t mDirectories;					// mMutex
+	std::vector<std::unique_ptr<Directory> > mClosing;	// mMutex, to be closed by the thread
+
+	std::thread mThread;
+	std::atomic<bool> mQuit;
+	int mNotifyFD;	// inotify descriptor on Linux
+};
+
+#endif // LL_LLFILEWATCHER_H
@@ -0,0 +1,165 @@
+/**
+ * @file   llframearena.cpp
+ * @date   2023-06-23
+ * @brief  Implementation for llframearena.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframearena.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace
+{
+	// the first block, and the least a block grows by
+	const size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+	std::atomic<size_t> sTotalReserved(0);
+	std::atomic<size_t> sHighWater(0);
+
+	size_t round_up(size_t bytes)
+	{
+		size_t size = MIN_BLOCK_SIZE;
+		while (size < bytes)
+		{
+			size <<= 1;
+		}
+		return size;
+	}
+}
+
+//static
+LLFrameArena& LLFrameArena::instance()
+{
+	static thread_local LLFrameArena sArena;
+	return sArena;
+}
+
+LLFrameArena::LLFrameArena()
+:	mPos(NULL),
+	mEnd(NULL),
+	mUsed(0),
+	mPeak(0),
+	mReserved(0),
+	mLive(0)
+{
+}
+
+LLFrameArena::~LLFrameArena()
+{
+	// only at thread exit, when no frame can still be running
+	freeBlocks();
+}
+
+void* LLFrameArena::allocate(size_t bytes, size_t alignment)
+{
+	char* start = (char*)(((uintptr_t)mPos + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	if (!mPos || start + bytes > mEnd)
+	{
+		// double up, so a frame that keeps growing needs few blocks
+		addBlock(llmax(bytes + alignment, mReserved));
+		start = (char*)(((uintptr_t)mPos + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+	mUsed += (start + bytes) - mPos;
+	mPos = start + bytes;
+	mPeak = llmax(mPeak, mUsed);
+	++mLive;
+	return start;
+}
+
+void LLFrameArena::deallocate(void* ptr, size_t bytes)
+{
+	llassert(mLive > 0);
+	--mLive;
+	// give back the last allocation, which is what a growing vector frees
+	if ((char*)ptr + bytes == mPos)
+	{
+		mPos = (char*)ptr;
+		mUsed -= bytes;
+	}
+}
+
+void LLFrameArena::reset()
+{
+	if (mLive)
+	{
+		LL_WARNS_ONCE("FrameArena") << mLive << " frame arena allocations outlived their frame" << LL_ENDL;
+		return;
+	}
+
+	size_t high_water = sHighWater.load(std::memory_order_relaxed);
+	while (mPeak > high_water
+		   && !sHighWater.compare_exchange_weak(high_water, mPeak, std::memory_order_relaxed))
+	{
+	}
+
+	if (mBlocks.size() > 1)
+	{
+		// this frame needed more than one block: replace them with one
+		// that fits it all
+		size_t reserved = mReserved;
+		freeBlocks();
+		addBlock(reserved);
+	}
+	if (!mBlocks.empty())
+	{
+		mPos = mBlocks.back().mData;
+		mEnd = mPos + mBlocks.back().mSize;
+	}
+	mUsed = 0;
+	mPeak = 0;
+}
+
+//static
+void LLFrameArena::getStats(size_t& reserved, size_t& high_water)
+{
+	reserved = sTotalReserved.load(std::memory_order_relaxed);
+	high_water = sHighWater.exchange(0, std::memory_order_relaxed);
+}
+
+void LLFrameArena::addBlock(size_t bytes)
+{
+	Block block;
+	block.mSize = round_up(bytes);
+	block.mData = new char[block.mSize];
+	mBlocks.push_back(block);
+	mPos = block.mData;
+	mEnd = block.mData + block.mSize;
+	mReserved += block.mSize;
+	sTotalReserved += block.mSize;
+}
+
+void LLFrameArena::freeBlocks()
+{
+	for (const Block& block : mBlocks)
+	{
+		delete[] block.mData;
+	}
+	mBlocks.clear();
+	sTotalReserved -= mReserved;
+	mReserved = 0;
+	mPos = mEnd = NULL;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file   llframearena.h
+ * @date   2023-06-23
+ * @brief  Per-thread linear allocator for containers that only live for
+ *         one frame, or one work item on a worker thread.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLFRAMEARENA_H)
+#define LL_LLFRAMEARENA_H
+
+#include "llpreprocessor.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Every thread has an LLFrameArena. Allocating from it is a pointer bump,
+ * freeing is free, and reset() makes all of it available again: the main
+ * thread resets at the end of each frame, worker threads after each work
+ * item. Once the arena has grown to what a frame needs, a frame's temporary
+ * vectors and strings never reach malloc.
+ *
+ * Use it through LLFrameAllocator, for locals that don't outlive the
+ * function that made them. Don't keep frame containers in members, and
+ * don't hand them to another thread. reset() checks that nothing allocated
+ * is still alive, and leaves the arena alone (with a warning) if something
+ * is, so a mistake costs memory rather than corrupting it.
+ */
+class LL_COMMON_API LLFrameArena
+{
+public:
+	// the calling thread's arena
+	static LLFrameArena& instance();
+
+	void* allocate(size_t bytes, size_t alignment);
+	void deallocate(void* ptr, size_t bytes);
+
+	void reset();
+
+	size_t getUsed() const { return mUsed; }
+	size_t getReserved() const { return mReserved; }
+
+	// Bytes held by all arenas, and the most any arena used between two
+	// resets since the last call.
+	static void getStats(size_t& reserved, size_t& high_water);
+
+	LLFrameArena(const LLFrameArena&) = delete;
+	LLFrameArena& operator=(const LLFrameArena&) = delete;
+	~LLFrameArena();
+
+private:
+	LLFrameArena();
+
+	void addBlock(size_t bytes);
+	void freeBlocks();
+
+	struct Block
+	{
+		char* mData;
+		size_t mSize;
+	};
+	std::vector<Block> mBlocks;
+	char* mPos;
+	char* mEnd;
+	size_t mUsed;		// since the last reset
+	size_t mPeak;		// most used since the last reset
+	size_t mReserved;	// all blocks
+	size_t mLive;		// allocations not yet deallocated
+};
+
+// Standard allocator adapter. A container keeps the arena of the thread
+// that made it.
+template <typename T>
+class LLFrameAllocator
+{
+public:
+	typedef T value_type;
+
+	LLFrameAllocator() : mArena(&LLFrameArena::instance()) {}
+	template <typename U>
+	LLFrameAllocator(const LLFrameAllocator<U>& other) : mArena(other.mArena) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(mArena->allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T* ptr, size_t count)
+	{
+		mArena->deallocate(ptr, count * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const LLFrameAllocator<U>& other) const { return mArena == other.mArena; }
+	template <typename U>
+	bool operator!=(const LLFrameAllocator<U>& other) const { return mArena != other.mArena; }
+
+private:
+	template <typename U> friend class LLFrameAllocator;
+	LLFrameArena* mArena;
+};
+
+template <typename T>
+using LLFrameVector = std::vector<T, LLFrameAllocator<T> >;
+typedef std::basic_string<char, std::char_traits<char>, LLFrameAllocator<char> > LLFrameString;
+
+#endif // LL_LLFRAMEARENA_H
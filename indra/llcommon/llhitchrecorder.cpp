@@ -0,0 +1,240 @@
+/**
+ * @file   llhitchrecorder.cpp
+ * @date   2023-06-20
+ * @brief  Implementation for llhitchrecorder.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llhitchrecorder.h"
+
+#include "llfasttimer.h"
+#include "llfile.h"
+#include "llthread.h"
+#include "stringize.h"
+
+#include <iomanip>
+#include <mutex>
+
+namespace
+{
+	// one ring per thread that records. Only the owning thread writes, the
+	// fields are atomic so capture() may read them from another thread
+	struct Ring
+	{
+		struct Slot
+		{
+			std::atomic<const LLTrace::BlockTimerStatHandle*> mTimer;
+			std::atomic<U64> mStart;
+			std::atomic<U64> mEnd;
+		};
+
+		Ring(U32 capacity, U32 index, const std::string& name)
+		:	mSlots(new Slot[capacity]),
+			mMask(capacity - 1),
+			mHead(0),
+			mIndex(index),
+			mName(name)
+		{
+		}
+
+		std::unique_ptr<Slot[]> mSlots;
+		const U64 mMask;
+		std::atomic<U64> mHead;		// total events ever recorded
+		const U32 mIndex;
+		const std::string mName;
+	};
+
+	// rings live until exit, so a capture can still read the last moments
+	// of a thread that has gone away
+	struct Rings
+	{
+		std::mutex mMutex;
+		std::vector<std::unique_ptr<Ring> > mRings;
+		U32 mCapacity = 65536;
+	};
+
+	Rings& get_rings()
+	{
+		static Rings rings;
+		return rings;
+	}
+
+	thread_local Ring* sThreadRing = NULL;
+
+	Ring* new_thread_ring()
+	{
+		Rings& rings = get_rings();
+		std::lock_guard<std::mutex> lock(rings.mMutex);
+		U32 index = (U32)rings.mRings.size();
+		std::string name = on_main_thread() ? std::string("Main") : stringize("Thread ", index);
+		rings.mRings.emplace_back(new Ring(rings.mCapacity, index, name));
+		return rings.mRings.back().get();
+	}
+
+	void write_escaped(std::ostream& out, const std::string& str)
+	{
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\';
+			}
+			if ((unsigned char)c >= 0x20)
+			{
+				out << c;
+			}
+		}
+	}
+}
+
+std::atomic<bool> LLHitchRecorder::sEnabled(false);
+
+//static
+void LLHitchRecorder::setCapacity(U32 events)
+{
+	U32 capacity = 1024;
+	while (capacity < events && capacity < (1U << 24))
+	{
+		capacity <<= 1;
+	}
+
+	Rings& rings = get_rings();
+	std::lock_guard<std::mutex> lock(rings.mMutex);
+	rings.mCapacity = capacity;
+}
+
+//static
+void LLHitchRecorder::recordEvent(const LLTrace::BlockTimerStatHandle* timer, U64 start, U64 end)
+{
+	Ring* ring = sThreadRing;
+	if (!ring)
+	{
+		ring = sThreadRing = new_thread_ring();
+	}
+
+	U64 head = ring->mHead.load(std::memory_order_relaxed);
+	Ring::Slot& slot = ring->mSlots[head & ring->mMask];
+	slot.mTimer.store(timer, std::memory_order_relaxed);
+	slot.mStart.store(start, std::memory_order_relaxed);
+	slot.mEnd.store(end, std::memory_order_relaxed);
+	ring->mHead.store(head + 1, std::memory_order_release);
+}
+
+//static
+LLHitchRecorder::CapturePtr LLHitchRecorder::capture(F32 seconds)
+{
+	LL_PROFILE_ZONE_SCOPED;
+	CapturePtr capture(new Capture);
+	capture->mCountsPerSecond = LLTrace::BlockTimer::countsPerSecond();
+	U64 now = LLTrace::BlockTimer::getCPUClockCount64();
+	U64 window = (U64)(llmax(seconds, 0.f) * (F64)capture->mCountsPerSecond);
+	capture->mStart = now > window ? now - window : 0;
+
+	Rings& rings = get_rings();
+	std::lock_guard<std::mutex> lock(rings.mMutex);
+	for (const std::unique_ptr<Ring>& ring : rings.mRings)
+	{
+		capture->mThreadNames.push_back(ring->mName);
+
+		U64 head = ring->mHead.load(std::memory_order_acquire);
+		U64 capacity = ring->mMask + 1;
+		U64 first = head > capacity ? head - capacity : 0;
+		size_t start = capture->mEvents.size();
+
+		for (U64 i = first; i < head; ++i)
+		{
+			const Ring::Slot& slot = ring->mSlots[i & ring->mMask];
+			Event event;
+			event.mTimer = slot.mTimer.load(std::memory_order_relaxed);
+			event.mStart = slot.mStart.load(std::memory_order_relaxed);
+			event.mEnd = slot.mEnd.load(std::memory_order_relaxed);
+			event.mThread = ring->mIndex;
+			if (event.mTimer && event.mEnd >= capture->mStart)
+			{
+				capture->mEvents.push_back(event);
+			}
+		}
+
+		// The thread kept recording while we copied, so the oldest slots may
+		// have been overwritten under us. Events are in the ring in the order
+		// they ended, so what we kept is the newest run of indices up to head.
+		U64 new_head = ring->mHead.load(std::memory_order_acquire);
+		U64 valid = new_head > capacity ? new_head - capacity : 0;
+		U64 copied = capture->mEvents.size() - start;
+		U64 kept_first = head - copied;
+		if (valid > kept_first)
+		{
+			size_t drop = (size_t)llmin(valid - kept_first, copied);
+			capture->mEvents.erase(capture->mEvents.begin() + start,
+								   capture->mEvents.begin() + start + drop);
+		}
+	}
+	return capture;
+}
+
+//static
+bool LLHitchRecorder::writeChromeTrace(const Capture& capture, const std::string& filename)
+{
+	LL_PROFILE_ZONE_SCOPED;
+	llofstream out(filename.c_str());
+	if (!out.is_open())
+	{
+		LL_WARNS() << "Unable to write hitch trace " << filename << LL_ENDL;
+		return false;
+	}
+
+	// Chrome trace timestamps are in microseconds
+	F64 to_usec = 1000000.0 / (F64)llmax(capture.mCountsPerSecond, (U64)1);
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	const char* delim = "\n";
+	for (size_t i = 0; i < capture.mThreadNames.size(); ++i)
+	{
+		out << delim << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"";
+		write_escaped(out, capture.mThreadNames[i]);
+		out << "\"}}";
+		delim = ",\n";
+	}
+
+	for (const Event& event : capture.mEvents)
+	{
+		// zones that started before the window get a negative start
+		F64 ts = (F64)(S64)(event.mStart - capture.mStart) * to_usec;
+		F64 dur = (F64)(event.mEnd - event.mStart) * to_usec;
+		out << delim << "{\"ph\":\"X\",\"name\":\"";
+		write_escaped(out, event.mTimer->getName());
+		out << "\",\"pid\":1,\"tid\":" << event.mThread
+			<< ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+		delim = ",\n";
+	}
+	out << "\n]}\n";
+
+	bool ok = out.good();
+	out.close();
+	LL_INFOS() << "Wrote hitch trace of " << capture.mEvents.size() << " zones to " << filename << LL_ENDL;
+	return ok;
+}
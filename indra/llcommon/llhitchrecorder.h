@@ -0,0 +1,106 @@
+/**
+ * @file   llhitchrecorder.h
+ * @date   2023-06-20
+ * @brief  Always-on recording of block timer zones into per-thread ring
+ *         buffers, written out as a Chrome trace after a hitch.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLHITCHRECORDER_H)
+#define LL_LLHITCHRECORDER_H
+
+#include "llpreprocessor.h"
+#include "stdtypes.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace LLTrace
+{
+	class BlockTimerStatHandle;
+}
+
+/**
+ * LLHitchRecorder keeps the last few seconds of LL_RECORD_BLOCK_TIME zones
+ * from every thread that runs block timers, cheaply enough to leave on in
+ * release builds. Each finished zone is one write of its timer and its
+ * start and end clock counts into a ring owned by the thread, so nothing is
+ * shared between threads on the recording side. When something notices a
+ * hitch, capture() copies out the recent part of every ring and
+ * writeChromeTrace() turns that into a file chrome://tracing and Perfetto
+ * can open.
+ *
+ * Only zones that have ended are recorded, so a capture taken during a
+ * stall shows everything up to the stall but not the zone that is stuck.
+ */
+class LL_COMMON_API LLHitchRecorder
+{
+public:
+	struct Event
+	{
+		const LLTrace::BlockTimerStatHandle* mTimer;
+		U64 mStart;
+		U64 mEnd;
+		U32 mThread;
+	};
+
+	struct Capture
+	{
+		std::vector<Event> mEvents;
+		std::vector<std::string> mThreadNames;	// indexed by Event::mThread
+		U64 mStart;								// clock count
+		U64 mCountsPerSecond;
+	};
+	typedef std::shared_ptr<Capture> CapturePtr;
+
+	static void setEnabled(bool enabled) { sEnabled.store(enabled, std::memory_order_relaxed); }
+	static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+	// events kept per thread, rounded up to a power of 2. Only affects rings
+	// for threads that haven't recorded anything yet.
+	static void setCapacity(U32 events);
+
+	// called by ~BlockTimer()
+	static void record(const LLTrace::BlockTimerStatHandle* timer, U64 start, U64 end)
+	{
+		if (sEnabled.load(std::memory_order_relaxed))
+		{
+			recordEvent(timer, start, end);
+		}
+	}
+
+	// copy out the zones that ended in the last seconds, from any thread
+	static CapturePtr capture(F32 seconds);
+
+	// may be called on any thread, and takes a while for a big capture
+	static bool writeChromeTrace(const Capture& capture, const std::string& filename);
+
+private:
+	static void recordEvent(const LLTrace::BlockTimerStatHandle* timer, U64 start, U64 end);
+
+	static std::atomic<bool> sEnabled;
+};
+
+#endif // LL_LLHITCHRECORDER_H
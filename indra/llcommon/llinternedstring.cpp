@@ -0,0 +1,115 @@
+/**
+ * @file   llinternedstring.cpp
+ * @date   2023-06-22
+ * @brief  Implementation for llinternedstring.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinternedstring.h"
+
+#include <boost/unordered_set.hpp>
+#include <mutex>
+#include <ostream>
+
+namespace
+{
+	typedef LLInternedString::Entry Entry;
+
+	struct EntryHash
+	{
+		size_t operator()(const Entry& entry) const { return entry.mHash; }
+		size_t operator()(const std::string& str) const { return std::hash<std::string>()(str); }
+	};
+
+	struct EntryEqual
+	{
+		bool operator()(const Entry& a, const Entry& b) const { return a.mString == b.mString; }
+		bool operator()(const std::string& a, const Entry& b) const { return a == b.mString; }
+	};
+
+	// node based, so entries never move
+	typedef boost::unordered_set<Entry, EntryHash, EntryEqual> entry_set_t;
+
+	struct Table
+	{
+		std::mutex mMutex;
+		entry_set_t mEntries;
+	};
+
+	// deliberately leaked: handles may be used by static destructors
+	Table& get_table()
+	{
+		static Table* table = new Table;
+		return *table;
+	}
+}
+
+const LLInternedString::Entry LLInternedString::sEmpty = { std::string(), std::hash<std::string>()(std::string()) };
+
+LLInternedString::LLInternedString(const std::string& str)
+:	mEntry(lookup(str, true))
+{
+}
+
+LLInternedString::LLInternedString(const char* str)
+:	mEntry(str ? lookup(std::string(str), true) : &sEmpty)
+{
+}
+
+//static
+LLInternedString LLInternedString::find(const std::string& str)
+{
+	return LLInternedString(lookup(str, false));
+}
+
+//static
+const LLInternedString::Entry* LLInternedString::lookup(const std::string& str, bool insert)
+{
+	if (str.empty())
+	{
+		return &sEmpty;
+	}
+
+	EntryHash hasher;
+	size_t hash = hasher(str);
+	Table& table = get_table();
+	std::lock_guard<std::mutex> lock(table.mMutex);
+	entry_set_t::iterator found = table.mEntries.find(str, hasher, EntryEqual());
+	if (found != table.mEntries.end())
+	{
+		return &*found;
+	}
+	if (!insert)
+	{
+		return &sEmpty;
+	}
+	Entry entry = { str, hash };
+	return &*table.mEntries.insert(entry).first;
+}
+
+std::ostream& operator<<(std::ostream& out, const LLInternedString& str)
+{
+	return out << str.str();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file   llinternedstring.h
+ * @date   2023-06-22
+ * @brief  Global table of unique strings, handed out as handles that
+ *         compare and hash without looking at the characters.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLINTERNEDSTRING_H)
+#define LL_LLINTERNEDSTRING_H
+
+#include "llpreprocessor.h"
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+/**
+ * LLInternedString is a handle to the one copy of a string kept in a global
+ * table, like LLStdStringTable but shared by the whole process and safe to
+ * use from any thread. Making one from a std::string costs a hash and a
+ * table lookup; after that, copying, comparing and hashing handles only
+ * touches a pointer, so names that are looked up over and over (joints,
+ * attachment points, visual params) should be interned once and kept.
+ *
+ * The table never shrinks, so only intern names from a bounded set. To look
+ * up an arbitrary string, such as a name read from an asset, use find(),
+ * which doesn't add to the table.
+ */
+class LL_COMMON_API LLInternedString
+{
+public:
+	LLInternedString() : mEntry(&sEmpty) {}
+	explicit LLInternedString(const std::string& str);
+	explicit LLInternedString(const char* str);
+
+	// The handle for str if it is already interned, otherwise the empty
+	// string. Nothing that was looked up by an interned name can match str
+	// in the latter case.
+	static LLInternedString find(const std::string& str);
+
+	const std::string& str() const { return mEntry->mString; }
+	const char* c_str() const { return mEntry->mString.c_str(); }
+	bool empty() const { return mEntry == &sEmpty; }
+	size_t hash() const { return mEntry->mHash; }
+
+	bool operator==(const LLInternedString& other) const { return mEntry == other.mEntry; }
+	bool operator!=(const LLInternedString& other) const { return mEntry != other.mEntry; }
+	// consistent for the life of the process, but not alphabetical
+	bool operator<(const LLInternedString& other) const { return mEntry < other.mEntry; }
+
+	struct Entry
+	{
+		std::string mString;
+		size_t mHash;
+	};
+
+private:
+	explicit LLInternedString(const Entry* entry) : mEntry(entry) {}
+	static const Entry* lookup(const std::string& str, bool insert);
+
+	const Entry* mEntry;
+
+	static const Entry sEmpty;
+};
+
+LL_COMMON_API std::ostream& operator<<(std::ostream& out, const LLInternedString& str);
+
+// for boost::unordered containers
+inline size_t hash_value(const LLInternedString& str)
+{
+	return str.hash();
+}
+
+namespace std
+{
+	template <>
+	struct hash<LLInternedString>
+	{
+		size_t operator()(const LLInternedString& str) const noexcept
+		{
+			return str.hash();
+		}
+	};
+}
+
+#endif // LL_LLINTERNEDSTRING_H
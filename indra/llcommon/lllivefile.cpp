@@ -28,6 +28,7 @@
 #include "lllivefile.h"
 #include "llframetimer.h"
 #include "lleventtimer.h"
+#include "llfilewatcher.h"
 
 const F32 DEFAULT_CONFIG_FILE_REFRESH = 5.0f;
 
@@ -49,6 +50,8 @@ public:
 	time_t mLastModTime;
 	time_t mLastStatTime;
 	bool mLastExists;
+	bool mWatched;
+	U32 mWatchChanges;
 	
 	LLEventTimer* mEventTimer;
 private:
@@ -63,12 +66,18 @@ LLLiveFile::Impl::Impl(const std::string& filename, const F32 refresh_period)
 	mLastModTime(0),
 	mLastStatTime(0),
 	mLastExists(false),
+	mWatched(false),
+	mWatchChanges(0),
 	mEventTimer(NULL)
 {
 }
 
 LLLiveFile::Impl::~Impl()
 {
+	if (mWatched && LLFileWatcher::instanceExists())
+	{
+		LLFileWatcher::instance().unwatch(mFilename);
+	}
 	delete mEventTimer;
 }
 
@@ -90,9 +99,25 @@ bool LLLiveFile::Impl::check()
     // forcing a check of the file
 	if (mForceCheck || mRefreshTimer.getElapsedTimeF32() >= mRefreshPeriod)
 	{
-        mForceCheck = false;   // force only forces one check
         mRefreshTimer.reset(); // don't check again until mRefreshPeriod has passed
 
+        if (!mWatched)
+        {
+            // watched from the first check on, rather than from construction
+            LLFileWatcher::instance().watch(mFilename);
+            mWatched = true;
+        }
+
+        // Skip the stat if the watcher saw nothing happen to the file
+        U32 changes = 0;
+        bool watching = LLFileWatcher::instance().getChangeCount(mFilename, changes);
+        if (watching && !mForceCheck && changes == mWatchChanges)
+        {
+            return false;
+        }
+        mWatchChanges = watching ? changes : 0;
+        mForceCheck = false;   // force only forces one check
+
         // Stat the file to see if it exists and when it was last modified.
         llstat stat_data;
         if (LLFile::stat(mFilename, &stat_data))
@@ -0,0 +1,172 @@
+/**
+ * @file   llmpmcring.h
+ * @date   2023-06-26
+ * @brief  Bounded lock-free multi-producer, multi-consumer ring.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLMPMCRING_H)
+#define LL_LLMPMCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace LL
+{
+    /**
+     * MPMCRing is a fixed size FIFO that any number of threads may push to
+     * and pop from without taking a lock (Dmitry Vyukov's bounded queue).
+     * It never blocks: tryPush() fails when the ring is full, tryPop() when
+     * it's empty.
+     *
+     * Passing MPMCRing<T> as LLThreadSafeQueue's QueueT selects the lock-free
+     * LLThreadSafeQueue, which adds capacity, close() and blocking on top.
+     *
+     * T must be default constructible and move assignable.
+     */
+    template <typename T>
+    class MPMCRing
+    {
+    public:
+        typedef T value_type;
+
+        // size is rounded up to a power of 2
+        MPMCRing(size_t size)
+        {
+            size_t slots = 2;
+            while (slots < size)
+            {
+                slots <<= 1;
+            }
+            mMask = slots - 1;
+            mSlots.reset(new Slot[slots]);
+            for (size_t i = 0; i < slots; ++i)
+            {
+                mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+            }
+            mHead.store(0, std::memory_order_relaxed);
+            mTail.store(0, std::memory_order_relaxed);
+        }
+
+        MPMCRing(const MPMCRing&) = delete;
+        MPMCRing& operator=(const MPMCRing&) = delete;
+
+        // Returns false if the ring is full, in which case value is left
+        // untouched, even if passed as an rvalue.
+        template <typename U>
+        bool tryPush(U&& value)
+        {
+            size_t pos = mTail.load(std::memory_order_relaxed);
+            Slot* slot;
+            while (true)
+            {
+                slot = &mSlots[pos & mMask];
+                size_t sequence = slot->mSequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+                if (diff == 0)
+                {
+                    // slot is free: claim it
+                    if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    // slot still holds the value from one lap ago
+                    return false;
+                }
+                else
+                {
+                    // another producer got there first
+                    pos = mTail.load(std::memory_order_relaxed);
+                }
+            }
+            slot->mValue = std::forward<U>(value);
+            slot->mSequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool tryPop(T& value)
+        {
+            size_t pos = mHead.load(std::memory_order_relaxed);
+            Slot* slot;
+            while (true)
+            {
+                slot = &mSlots[pos & mMask];
+                size_t sequence = slot->mSequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(pos + 1);
+                if (diff == 0)
+                {
+                    if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    // nothing pushed here yet
+                    return false;
+                }
+                else
+                {
+                    pos = mHead.load(std::memory_order_relaxed);
+                }
+            }
+            value = std::move(slot->mValue);
+            // don't let the slot keep whatever the moved-from value still holds
+            slot->mValue = T();
+            slot->mSequence.store(pos + mMask + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const { return mMask + 1; }
+
+        // only a snapshot while other threads are pushing or popping
+        size_t size() const
+        {
+            size_t head = mHead.load(std::memory_order_relaxed);
+            size_t tail = mTail.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+        bool empty() const { return size() == 0; }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> mSequence;
+            T mValue;
+        };
+
+        // Keep the two ends on separate cache lines so producers and
+        // consumers don't invalidate each other's.
+        enum { CACHE_LINE = 64 };
+        std::unique_ptr<Slot[]> mSlots;
+        size_t mMask;
+        char mPad0[CACHE_LINE];
+        std::atomic<size_t> mHead;  // next slot to pop
+        char mPad1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> mTail;  // next slot to push
+        char mPad2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    };
+} // namespace LL
+
+#endif // LL_LLMPMCRING_H
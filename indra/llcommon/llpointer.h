@@ -72,6 +72,21 @@ public:
 		ref();
 	}
 
+	// Moving takes over the reference held by ptr, leaving it null, so the
+	// reference count is not touched at all.
+	LLPointer(LLPointer<Type>&& ptr) noexcept :
+		mPointer(ptr.mPointer)
+	{
+		ptr.mPointer = NULL;
+	}
+
+	template<typename Subclass>
+	LLPointer(LLPointer<Subclass>&& ptr) noexcept :
+		mPointer(ptr.mPointer)
+	{
+		ptr.mPointer = NULL;
+	}
+
 	~LLPointer()								
 	{
 		unref();
@@ -115,6 +130,24 @@ public:
 		assign(ptr.get());
 		return *this; 
 	}
+
+	// Only drops the reference we held before, if any. Going through a
+	// temporary means our old object is released after the assignment is
+	// complete, and self-assignment is harmless.
+	LLPointer<Type>& operator =(LLPointer<Type>&& ptr) noexcept
+	{
+		LLPointer<Type> temp(std::move(ptr));
+		swap(*this, temp);
+		return *this;
+	}
+
+	template<typename Subclass>
+	LLPointer<Type>& operator =(LLPointer<Subclass>&& ptr) noexcept
+	{
+		LLPointer<Type> temp(std::move(ptr));
+		swap(*this, temp);
+		return *this;
+	}
 	
 	// Just exchange the pointers, which will not change the reference counts.
 	static void swap(LLPointer<Type>& a, LLPointer<Type>& b)
@@ -125,6 +158,8 @@ public:
 	}
 
 protected:
+	template <class Other> friend class LLPointer;
+
 #ifdef LL_LIBRARY_INCLUDE
 	void ref();                             
 	void unref();
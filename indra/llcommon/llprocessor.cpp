@@ -123,6 +123,7 @@ namespace
         eSSE4_1_Features = 38,
         eSSE4_2_Features = 39,
         eSSE4a_Features = 40,
+        eAVX2_Features = 41,
 	};
 
 	const char* cpu_feature_names[] =
@@ -170,6 +171,7 @@ namespace
         "SSE4.1 Instructions",
         "SSE4.2 Instructions",
         "SSE4a Instructions",
+        "AVX2 Instructions",
 	};
 
 	std::string intel_CPUFamilyName(int composed_family) 
@@ -283,6 +285,11 @@ public:
         return hasExtension(cpu_feature_names[eSSE4a_Features]);
     }
 
+    bool hasAVX2() const
+    {
+        return hasExtension(cpu_feature_names[eAVX2_Features]);
+    }
+
 	bool hasAltivec() const 
 	{
 		return hasExtension("Altivec"); 
@@ -513,6 +520,9 @@ private:
             is_amd = true;
         }
 
+        // AVX registers are only usable if the OS saves them on a context switch
+        bool os_saves_ymm = false;
+
 		// Get the information associated with each valid Id
 		for(unsigned int i=0; i<=ids; ++i)
 		{
@@ -572,6 +582,12 @@ private:
                     setExtension(cpu_feature_names[eSSE4_2_Features]);
                 }
 
+                // OSXSAVE and AVX, then check XCR0 for the XMM and YMM state
+                if ((cpu_info[2] & 0x18000000) == 0x18000000)
+                {
+                    os_saves_ymm = (_xgetbv(0) & 0x6) == 0x6;
+                }
+
 				unsigned int feature_info = (unsigned int) cpu_info[3];
 				for(unsigned int index = 0, bit = 1; index < eSSE3_Features; ++index, bit <<= 1)
 				{
@@ -581,6 +597,15 @@ private:
 					}
 				}
 			}
+			else if (i == 7)
+			{
+				// leaf 7 has sub-leaves, the extended features are in sub-leaf 0
+				__cpuidex(cpu_info, 7, 0);
+				if (os_saves_ymm && (cpu_info[1] & 0x20))
+				{
+					setExtension(cpu_feature_names[eAVX2_Features]);
+				}
+			}
 		}
 
 		// Calling __cpuid with 0x80000000 as the InfoType argument
@@ -789,6 +814,19 @@ private:
             // Not supposed to happen?
             setExtension(cpu_feature_names[eSSE4a_Features]);
         }
+
+        char cpu_leaf7_features[1024];
+        len = sizeof(cpu_leaf7_features);
+        memset(cpu_leaf7_features, 0, len);
+        sysctlbyname("machdep.cpu.leaf7_features", (void*)cpu_leaf7_features, &len, NULL, 0);
+
+        std::string cpu_leaf7_features_str(cpu_leaf7_features);
+        cpu_leaf7_features_str = " " + cpu_leaf7_features_str + " ";
+
+        if (cpu_leaf7_features_str.find(" AVX2 ") != std::string::npos)
+        {
+            setExtension(cpu_feature_names[eAVX2_Features]);
+        }
 	}
 };
 
@@ -924,6 +962,11 @@ private:
         {
             setExtension(cpu_feature_names[eSSE4a_Features]);
         }
+
+        if (flags.find(" avx2 ") != std::string::npos)
+        {
+            setExtension(cpu_feature_names[eAVX2_Features]);
+        }
 	
 # endif // LL_X86
 	}
@@ -989,6 +1032,7 @@ bool LLProcessorInfo::hasSSE3S() const { return mImpl->hasSSE3S(); }
 bool LLProcessorInfo::hasSSE41() const { return mImpl->hasSSE41(); }
 bool LLProcessorInfo::hasSSE42() const { return mImpl->hasSSE42(); }
 bool LLProcessorInfo::hasSSE4a() const { return mImpl->hasSSE4a(); }
+bool LLProcessorInfo::hasAVX2() const { return mImpl->hasAVX2(); }
 bool LLProcessorInfo::hasAltivec() const { return mImpl->hasAltivec(); }
 std::string LLProcessorInfo::getCPUFamilyName() const { return mImpl->getCPUFamilyName(); }
 std::string LLProcessorInfo::getCPUBrandName() const { return mImpl->getCPUBrandName(); }
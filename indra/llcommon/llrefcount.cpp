@@ -29,6 +29,12 @@
 
 #include "llerror.h"
 
+#if LL_REFCOUNT_AUDIT
+#include <map>
+#include <mutex>
+#include <typeindex>
+#endif
+
 // maximum reference count before sounding memory leak alarm
 const S32 gMaxRefCount = S32_MAX;
 
@@ -56,3 +62,91 @@ LLRefCount::~LLRefCount()
 	}
 }
 
+#if LL_REFCOUNT_AUDIT
+namespace
+{
+	struct AuditCounts
+	{
+		AuditCounts() : mThreadSafe(false), mObjects(0), mShared(0) {}
+		bool mThreadSafe;
+		U32 mObjects;
+		U32 mShared;
+	};
+
+	struct AuditRegistry
+	{
+		std::mutex mMutex;
+		std::map<std::type_index, AuditCounts> mTypes;
+	};
+
+	// Refcounted objects come and go during static initialization and
+	// destruction, so this is never destroyed.
+	AuditRegistry& audit_registry()
+	{
+		static AuditRegistry* sRegistry = new AuditRegistry;
+		return *sRegistry;
+	}
+
+	// small ids rather than std::thread::id, so the tracker can be atomic
+	U32 audit_thread()
+	{
+		static std::atomic<U32> sNextThread(1);
+		thread_local U32 sThread = sNextThread++;
+		return sThread;
+	}
+
+	void audit_record(const std::type_info& type, bool thread_safe, bool shared)
+	{
+		AuditRegistry& registry = audit_registry();
+		std::lock_guard<std::mutex> lock(registry.mMutex);
+		AuditCounts& counts = registry.mTypes[std::type_index(type)];
+		counts.mThreadSafe = thread_safe;
+		if (shared)
+		{
+			++counts.mShared;
+		}
+		else
+		{
+			++counts.mObjects;
+		}
+	}
+}
+
+void LLRefCountAudit::Tracker::touch(const std::type_info& type, bool thread_safe) const
+{
+	U32 thread = audit_thread();
+	U32 owner = 0;
+	if (mThread.compare_exchange_strong(owner, thread))
+	{
+		// first reference: just count the object
+		audit_record(type, thread_safe, false);
+	}
+	else if (owner != thread && ! mShared.exchange(true))
+	{
+		audit_record(type, thread_safe, true);
+	}
+}
+
+//static
+void LLRefCountAudit::dump()
+{
+	AuditRegistry& registry = audit_registry();
+	std::lock_guard<std::mutex> lock(registry.mMutex);
+	for (const auto& pair : registry.mTypes)
+	{
+		const AuditCounts& counts = pair.second;
+		std::string name(LLError::Log::demangle(pair.first.name()));
+		if (counts.mShared && ! counts.mThreadSafe)
+		{
+			LL_WARNS("RefCountAudit") << name << " (LLRefCount): " << counts.mShared << " of "
+									  << counts.mObjects << " objects referenced from more than one thread" << LL_ENDL;
+		}
+		else
+		{
+			LL_INFOS("RefCountAudit") << name << (counts.mThreadSafe ? " (LLThreadSafeRefCount): " : " (LLRefCount): ")
+									  << counts.mShared << " of " << counts.mObjects
+									  << " objects referenced from more than one thread" << LL_ENDL;
+		}
+	}
+}
+#endif
@@ -32,6 +32,45 @@
 
 class LLMutex;
 
+// Build with LL_REFCOUNT_AUDIT=1 to find out which refcounted types are
+// really referenced from more than one thread. LLRefCount's count is not
+// atomic, so any LLRefCount type reported as shared is a race; conversely an
+// LLThreadSafeRefCount type that is never shared could use LLRefCount
+// instead. This adds a member to every refcounted object, so the whole build
+// must agree on it.
+#ifndef LL_REFCOUNT_AUDIT
+#define LL_REFCOUNT_AUDIT 0
+#endif
+
+#if LL_REFCOUNT_AUDIT
+#include <atomic>
+#include <typeinfo>
+
+class LL_COMMON_API LLRefCountAudit
+{
+public:
+	// Embedded in each refcounted object: remembers the first thread to
+	// reference it and reports the object's type when another one does.
+	class Tracker
+	{
+	public:
+		Tracker() : mThread(0), mShared(false) {}
+		// never copied along with the object, like the count itself
+		Tracker(const Tracker&) : mThread(0), mShared(false) {}
+		Tracker& operator=(const Tracker&) { return *this; }
+
+		void touch(const std::type_info& type, bool thread_safe) const;
+
+	private:
+		mutable std::atomic<U32> mThread;
+		mutable std::atomic<bool> mShared;
+	};
+
+	// log every type seen so far, with how many of its objects were shared
+	static void dump();
+};
+#endif
+
 //----------------------------------------------------------------------------
 // RefCount objects should generally only be accessed by way of LLPointer<>'s
 // see llthread.h for LLThreadSafeRefCount
@@ -59,12 +98,18 @@ public:
 
 	inline void ref() const
 	{ 
+#if LL_REFCOUNT_AUDIT
+		mAudit.touch(typeid(*this), false);
+#endif
 		mRef++; 
         validateRefCount();
 	} 
 
 	inline S32 unref() const
 	{
+#if LL_REFCOUNT_AUDIT
+		mAudit.touch(typeid(*this), false);
+#endif
         validateRefCount();
 		if (0 == --mRef)
 		{
@@ -84,6 +129,9 @@ public:
 
 private: 
 	mutable S32	mRef; 
+#if LL_REFCOUNT_AUDIT
+	LLRefCountAudit::Tracker mAudit;
+#endif
 };
 
 
@@ -114,11 +162,17 @@ public:
 
 	void ref()
 	{
+#if LL_REFCOUNT_AUDIT
+		mAudit.touch(typeid(*this), true);
+#endif
 		mRef++; 
 	} 
 
 	void unref()
 	{
+#if LL_REFCOUNT_AUDIT
+		mAudit.touch(typeid(*this), true);
+#endif
 		llassert(mRef >= 1);
 		if ((--mRef) == 0)
 		{
@@ -138,6 +192,9 @@ public:
 
 private: 
 	LLAtomicS32 mRef; 
+#if LL_REFCOUNT_AUDIT
+	LLRefCountAudit::Tracker mAudit;
+#endif
 };
 
 /**
@@ -36,7 +36,11 @@
 #include "llsdserialize.h"
 #include "stringize.h"
 
+#include <algorithm>
 #include <limits>
+#include <memory>
+
+#include <boost/container/small_vector.hpp>
 
 // Defend against a caller forcibly passing a negative number into an unsigned
 // size_t index param
@@ -154,7 +158,7 @@ public:
 	virtual const LLSD& ref(size_t) const		{ return undef(); }
 
 	virtual LLSD::map_const_iterator beginMap() const { return endMap(); }
-	virtual LLSD::map_const_iterator endMap() const { static const std::map<String, LLSD> empty; return empty.end(); }
+	virtual LLSD::map_const_iterator endMap() const { return LLSD::map_const_iterator(); }
 	virtual LLSD::array_const_iterator beginArray() const { return endArray(); }
 	virtual LLSD::array_const_iterator endArray() const { static const std::vector<LLSD> empty; return empty.end(); }
 
@@ -371,21 +375,53 @@ namespace
 	class ImplMap : public LLSD::Impl
 	{
 	private:
-		typedef std::map<LLSD::String, LLSD>	DataMap;
-		
-		DataMap mData;
-		
+		// Most maps hold a handful of keys, so rather than a tree the map is
+		// a sorted vector of pointers to its entries, searched by bisection.
+		// The entries themselves never move: the first INLINE_ENTRIES live
+		// in the map and the rest in blocks that double in size, with erased
+		// ones reused, so an LLSD& from ref() survives other keys coming and
+		// going just as it did with std::map.
+		typedef LLSD::map_entry		Entry;
+
+		static const size_t INLINE_ENTRIES = 4;
+		typedef boost::container::small_vector<Entry*, INLINE_ENTRIES>	Index;
+
+		union Slot
+		{
+			Slot() { }
+			~Slot() { }
+
+			Entry mEntry;
+			Slot* mNextFree;
+		};
+
+		Index mIndex;
+		Slot mInline[INLINE_ENTRIES];
+		std::vector<std::unique_ptr<Slot[]> > mBlocks;
+		Slot* mFree;		// erased slots
+		Slot* mNext;		// unused slots in the newest block
+		size_t mNextLeft;
+
+		Entry* newEntry(const LLSD::String& k, const LLSD& v);
+		void deleteEntry(Entry* e);
+
+		template <typename ITER>
+		static ITER lowerBound(ITER begin, ITER end, const LLSD::String& k);
+		Index::iterator find(const LLSD::String& k);
+		Index::const_iterator find(const LLSD::String& k) const;
+
 	protected:
-		ImplMap(const DataMap& data) : mData(data) { }
+		ImplMap(const ImplMap& other);
 		
 	public:
-		ImplMap() { }
+		ImplMap();
+		~ImplMap();
 		
 		virtual ImplMap& makeMap(LLSD::Impl*&);
 
 		virtual LLSD::Type type() const { return LLSD::TypeMap; }
 
-		virtual LLSD::Boolean asBoolean() const { return !mData.empty(); }
+		virtual LLSD::Boolean asBoolean() const { return !mIndex.empty(); }
 
 		virtual bool has(const LLSD::String&) const; 
 
@@ -399,23 +435,104 @@ namespace
 		              LLSD& ref(const LLSD::String&);
 		virtual const LLSD& ref(const LLSD::String&) const;
 
-		virtual size_t size() const { return mData.size(); }
+		virtual size_t size() const { return mIndex.size(); }
 
-		LLSD::map_iterator beginMap() { return mData.begin(); }
-		LLSD::map_iterator endMap() { return mData.end(); }
-		virtual LLSD::map_const_iterator beginMap() const { return mData.begin(); }
-		virtual LLSD::map_const_iterator endMap() const { return mData.end(); }
+		LLSD::map_iterator beginMap() { return LLSD::map_iterator(mIndex.data()); }
+		LLSD::map_iterator endMap() { return LLSD::map_iterator(mIndex.data() + mIndex.size()); }
+		virtual LLSD::map_const_iterator beginMap() const { return LLSD::map_const_iterator(mIndex.data()); }
+		virtual LLSD::map_const_iterator endMap() const { return LLSD::map_const_iterator(mIndex.data() + mIndex.size()); }
 
 		virtual void dumpStats() const;
 		virtual void calcStats(S32 type_counts[], S32 share_counts[]) const;
 	};
+
+	ImplMap::ImplMap()
+	:	mFree(NULL),
+		mNext(mInline),
+		mNextLeft(INLINE_ENTRIES)
+	{
+	}
+
+	ImplMap::ImplMap(const ImplMap& other)
+	:	mFree(NULL),
+		mNext(mInline),
+		mNextLeft(INLINE_ENTRIES)
+	{
+		// other is already in order, so this is all appends
+		mIndex.reserve(other.mIndex.size());
+		for (const Entry* e : other.mIndex)
+		{
+			mIndex.push_back(newEntry(e->first, e->second));
+		}
+	}
+
+	ImplMap::~ImplMap()
+	{
+		for (Entry* e : mIndex)
+		{
+			e->~Entry();
+		}
+	}
+
+	ImplMap::Entry* ImplMap::newEntry(const LLSD::String& k, const LLSD& v)
+	{
+		Slot* slot = mFree;
+		if (slot)
+		{
+			mFree = slot->mNextFree;
+		}
+		else
+		{
+			if (!mNextLeft)
+			{
+				mNextLeft = INLINE_ENTRIES << (mBlocks.size() + 1);
+				mBlocks.emplace_back(new Slot[mNextLeft]);
+				mNext = mBlocks.back().get();
+			}
+			slot = mNext++;
+			--mNextLeft;
+		}
+		return new (&slot->mEntry) Entry(k, v);
+	}
+
+	void ImplMap::deleteEntry(Entry* e)
+	{
+		e->~Entry();
+		Slot* slot = reinterpret_cast<Slot*>(e);
+		slot->mNextFree = mFree;
+		mFree = slot;
+	}
+
+	template <typename ITER>
+	ITER ImplMap::lowerBound(ITER begin, ITER end, const LLSD::String& k)
+	{
+		// maps are usually built in key order, check for an append first
+		if (begin == end || (*(end - 1))->first < k)
+		{
+			return end;
+		}
+		return std::lower_bound(begin, end, k,
+								[](const Entry* e, const LLSD::String& key) { return e->first < key; });
+	}
+
+	ImplMap::Index::iterator ImplMap::find(const LLSD::String& k)
+	{
+		Index::iterator i = lowerBound(mIndex.begin(), mIndex.end(), k);
+		return (i != mIndex.end() && (*i)->first == k) ? i : mIndex.end();
+	}
+
+	ImplMap::Index::const_iterator ImplMap::find(const LLSD::String& k) const
+	{
+		Index::const_iterator i = lowerBound(mIndex.begin(), mIndex.end(), k);
+		return (i != mIndex.end() && (*i)->first == k) ? i : mIndex.end();
+	}
 	
 	ImplMap& ImplMap::makeMap(LLSD::Impl*& var)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
 		if (shared())
 		{
-			ImplMap* i = new ImplMap(mData);
+			ImplMap* i = new ImplMap(*this);
 			Impl::assign(var, i);
 			return *i;
 		}
@@ -428,26 +545,23 @@ namespace
 	bool ImplMap::has(const LLSD::String& k) const
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		DataMap::const_iterator i = mData.find(k);
-		return i != mData.end();
+		return find(k) != mIndex.end();
 	}
 	
 	LLSD ImplMap::get(const LLSD::String& k) const
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		DataMap::const_iterator i = mData.find(k);
-		return (i != mData.end()) ? i->second : LLSD();
+		Index::const_iterator i = find(k);
+		return (i != mIndex.end()) ? (*i)->second : LLSD();
 	}
 
 	LLSD ImplMap::getKeys() const
 	{ 
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
 		LLSD keys = LLSD::emptyArray();
-		DataMap::const_iterator iter = mData.begin();
-		while (iter != mData.end())
+		for (const Entry* e : mIndex)
 		{
-			keys.append((*iter).first);
-			iter++;
+			keys.append(e->first);
 		}
 		return keys;
 	}
@@ -455,34 +569,50 @@ namespace
 	void ImplMap::insert(const LLSD::String& k, const LLSD& v)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		mData.insert(DataMap::value_type(k, v));
+		// like std::map::insert(), leaves an existing value alone
+		Index::iterator i = lowerBound(mIndex.begin(), mIndex.end(), k);
+		if (i == mIndex.end() || (*i)->first != k)
+		{
+			mIndex.insert(i, newEntry(k, v));
+		}
 	}
 	
 	void ImplMap::erase(const LLSD::String& k)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		mData.erase(k);
+		Index::iterator i = find(k);
+		if (i != mIndex.end())
+		{
+			Entry* e = *i;
+			mIndex.erase(i);
+			deleteEntry(e);
+		}
 	}
 	
 	LLSD& ImplMap::ref(const LLSD::String& k)
 	{
-		return mData[k];
+		Index::iterator i = lowerBound(mIndex.begin(), mIndex.end(), k);
+		if (i == mIndex.end() || (*i)->first != k)
+		{
+			i = mIndex.insert(i, newEntry(k, LLSD()));
+		}
+		return (*i)->second;
 	}
 	
 	const LLSD& ImplMap::ref(const LLSD::String& k) const
 	{
-		DataMap::const_iterator i = mData.lower_bound(k);
-		if (i == mData.end()  ||  mData.key_comp()(k, i->first))
+		Index::const_iterator i = find(k);
+		if (i == mIndex.end())
 		{
 			return undef();
 		}
 		
-		return i->second;
+		return (*i)->second;
 	}
 
 	void ImplMap::dumpStats() const
 	{
-		std::cout << "Map size: " << mData.size() << std::endl;
+		std::cout << "Map size: " << mIndex.size() << std::endl;
 
 		std::cout << "LLSD Net Objects: " << llsd::sLLSDNetObjects << std::endl;
 		std::cout << "LLSD allocations: " << llsd::sLLSDAllocationCount << std::endl;
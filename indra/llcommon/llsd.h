@@ -27,8 +27,11 @@
 #ifndef LL_LLSD_NEW_H
 #define LL_LLSD_NEW_H
 
+#include <cstddef>
+#include <iterator>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "stdtypes.h"
@@ -37,6 +40,70 @@
 #include "lluri.h"
 #include "lluuid.h"
 
+namespace llsd
+{
+
+/**
+	Iterator over the entries of an LLSD map, in key order.
+
+	A map keeps its entries where they were first made and orders them with
+	a sorted vector of pointers, so this walks that vector.  References to
+	keys and values stay good while other keys are inserted or erased, but
+	like vector iterators, map iterators do not: don't insert into or erase
+	from a map while iterating over it.
+
+	ENTRY is std::pair<const LLSD::String, LLSD>, const for the const
+	iterator.  An iterator converts to the const iterator of the same map.
+*/
+template <typename ENTRY>
+class MapIterator
+{
+public:
+	typedef std::random_access_iterator_tag			iterator_category;
+	typedef typename std::remove_const<ENTRY>::type	value_type;
+	typedef std::ptrdiff_t							difference_type;
+	typedef ENTRY*									pointer;
+	typedef ENTRY&									reference;
+
+	MapIterator() : mPos(nullptr) { }
+	explicit MapIterator(ENTRY* const* pos) : mPos(pos) { }
+
+	template <typename OTHER,
+			  typename std::enable_if<std::is_convertible<OTHER*, ENTRY*>::value,
+									  bool>::type = true>
+	MapIterator(const MapIterator<OTHER>& other) : mPos(other.mPos) { }
+
+	reference operator*() const						{ return **mPos; }
+	pointer operator->() const						{ return *mPos; }
+	reference operator[](difference_type n) const	{ return *mPos[n]; }
+
+	MapIterator& operator++()						{ ++mPos; return *this; }
+	MapIterator& operator--()						{ --mPos; return *this; }
+	MapIterator operator++(int)						{ MapIterator i(*this); ++mPos; return i; }
+	MapIterator operator--(int)						{ MapIterator i(*this); --mPos; return i; }
+	MapIterator& operator+=(difference_type n)		{ mPos += n; return *this; }
+	MapIterator& operator-=(difference_type n)		{ mPos -= n; return *this; }
+
+	friend MapIterator operator+(MapIterator i, difference_type n)	{ return i += n; }
+	friend MapIterator operator+(difference_type n, MapIterator i)	{ return i += n; }
+	friend MapIterator operator-(MapIterator i, difference_type n)	{ return i -= n; }
+	friend difference_type operator-(const MapIterator& a, const MapIterator& b) { return a.mPos - b.mPos; }
+
+	friend bool operator==(const MapIterator& a, const MapIterator& b)	{ return a.mPos == b.mPos; }
+	friend bool operator!=(const MapIterator& a, const MapIterator& b)	{ return a.mPos != b.mPos; }
+	friend bool operator<(const MapIterator& a, const MapIterator& b)	{ return a.mPos < b.mPos; }
+	friend bool operator>(const MapIterator& a, const MapIterator& b)	{ return a.mPos > b.mPos; }
+	friend bool operator<=(const MapIterator& a, const MapIterator& b)	{ return a.mPos <= b.mPos; }
+	friend bool operator>=(const MapIterator& a, const MapIterator& b)	{ return a.mPos >= b.mPos; }
+
+private:
+	template <typename OTHER> friend class MapIterator;
+
+	ENTRY* const* mPos;
+};
+
+} // namespace llsd
+
 /**
 	LLSD provides a flexible data system similar to the data facilities of
 	dynamic languages like Perl and Python.  It is created to support exchange
@@ -342,8 +409,9 @@ public:
 	//@{
 		size_t size() const;
 
-		typedef std::map<String, LLSD>::iterator		map_iterator;
-		typedef std::map<String, LLSD>::const_iterator	map_const_iterator;
+		typedef std::pair<const String, LLSD>						map_entry;
+		typedef llsd::MapIterator<map_entry>						map_iterator;
+		typedef llsd::MapIterator<const map_entry>					map_const_iterator;
 		
 		map_iterator		beginMap();
 		map_iterator		endMap();
@@ -488,6 +556,9 @@ LL_COMMON_API std::ostream& operator<<(std::ostream& s, const LLSD& llsd);
 
 namespace llsd
 {
+	/// How many LLSD::Impl (hidden) objects are alive, for memory statistics.
+	/// @warn NOT ACCURATE IN A MULTI-THREADED ENVIRONMENT.
+	LL_COMMON_API U32 outstandingCount();
 
 #ifdef LLSD_DEBUG_INFO
 /** @name Unit Testing Interface */
@@ -499,7 +570,6 @@ namespace llsd
 	///
 	/// These counts track LLSD::Impl (hidden) objects.
 	LL_COMMON_API U32 allocationCount();	///< how many Impls have been made
-	LL_COMMON_API U32 outstandingCount();	///< how many Impls are still alive
 
 	/// These counts track LLSD (public) objects.
 	LL_COMMON_API extern S32 sLLSDAllocationCount;	///< Number of LLSD objects ever created
@@ -32,7 +32,8 @@
 #include "llstreamtools.h" // for fullread
 
 #include <iostream>
-#include "apr_base64.h"
+#include "llbase64.h"
+#include "lltextcodec.h"
 
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -885,16 +886,7 @@ bool LLSDNotationParser::parseBinary(std::istream& istr, LLSD& data) const
 		std::stringstream coded_stream;
 		get(istr, *(coded_stream.rdbuf()), '\"');
 		c = get(istr);
-		std::string encoded(coded_stream.str());
-		S32 len = apr_base64_decode_len(encoded.c_str());
-		std::vector<U8> value;
-		if(len)
-		{
-			value.resize(len);
-			len = apr_base64_decode_binary(&value[0], encoded.c_str());
-			value.resize(len);
-		}
-		data = value;
+		data = LLBase64::decode(coded_stream.str());
 	}
 	else if(0 == strncmp("b16", buf, 3))
 	{
@@ -947,10 +939,185 @@ LLSDBinaryParser::~LLSDBinaryParser()
 {
 }
 
-// virtual
-S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) const
+/**
+ * Reads through the LLSDParser istream helpers, so mMaxBytesLeft is
+ * accounted and checked as before.
+ */
+class LLSDBinaryParser::StreamSource
+{
+public:
+	StreamSource(const LLSDBinaryParser& parser, std::istream& istr) :
+		mParser(parser),
+		mStream(istr)
+	{
+	}
+
+	bool get(char& c)
+	{
+		c = mParser.get(mStream);
+		return mStream.good();
+	}
+
+	bool peek(char& c)
+	{
+		c = mStream.peek();
+		return mStream.good();
+	}
+
+	bool read(void* dest, size_t bytes)
+	{
+		mParser.read(mStream, (char*)dest, bytes);	 /*Flawfinder: ignore*/
+		return !mStream.fail();
+	}
+
+	// whether size more bytes may be read
+	bool fits(S32 size) const
+	{
+		return !mParser.mCheckLimits || (size <= mParser.mMaxBytesLeft);
+	}
+
+	bool readString(std::string& value, S32 size)
+	{
+		value.resize(size);
+		if (size)
+		{
+			mParser.account(fullread(mStream, &value[0], size));
+		}
+		return !mStream.fail();
+	}
+
+	bool readBinary(std::vector<U8>& value, S32 size)
+	{
+		if (size > 0)
+		{
+			value.resize(size);
+			mParser.account(fullread(mStream, (char*)&value[0], size));
+		}
+		return !mStream.fail();
+	}
+
+	// notation-style quoted string, the opening delimiter is already read
+	bool readDelimitedString(std::string& value, char delim)
+	{
+		llssize count = deserialize_string_delim(mStream, value, delim);
+		if (PARSE_FAILURE == count)
+		{
+			return false;
+		}
+		mParser.account(count);
+		return true;
+	}
+
+	bool failed() const { return mStream.fail(); }
+
+private:
+	const LLSDBinaryParser& mParser;
+	std::istream& mStream;
+};
+
+/**
+ * Reads a contiguous buffer in place, with its end standing in for
+ * mMaxBytesLeft.
+ */
+class LLSDBinaryParser::BufferSource
+{
+public:
+	BufferSource(const U8* buffer, llssize length) :
+		mStart(buffer),
+		mPos(buffer),
+		mEnd(buffer + length)
+	{
+	}
+
+	llssize getBytesRead() const { return mPos - mStart; }
+
+	bool get(char& c)
+	{
+		if (mPos >= mEnd)
+		{
+			return false;
+		}
+		c = (char)*mPos++;
+		return true;
+	}
+
+	bool peek(char& c)
+	{
+		if (mPos >= mEnd)
+		{
+			return false;
+		}
+		c = (char)*mPos;
+		return true;
+	}
+
+	bool read(void* dest, size_t bytes)
+	{
+		if ((llssize)bytes > remaining())
+		{
+			return false;
+		}
+		memcpy(dest, mPos, bytes);
+		mPos += bytes;
+		return true;
+	}
+
+	bool fits(S32 size) const
+	{
+		return size <= remaining();
+	}
+
+	bool readString(std::string& value, S32 size)
+	{
+		if (size > remaining())
+		{
+			return false;
+		}
+		value.assign((const char*)mPos, size);
+		mPos += size;
+		return true;
+	}
+
+	bool readBinary(std::vector<U8>& value, S32 size)
+	{
+		if (size > remaining())
+		{
+			return false;
+		}
+		if (size > 0)
+		{
+			value.assign(mPos, mPos + size);
+			mPos += size;
+		}
+		return true;
+	}
+
+	bool readDelimitedString(std::string& value, char delim)
+	{
+		boost::iostreams::stream<boost::iostreams::array_source> istr((const char*)mPos, remaining());
+		llssize count = deserialize_string_delim(istr, value, delim);
+		if (PARSE_FAILURE == count)
+		{
+			return false;
+		}
+		mPos += count;
+		return true;
+	}
+
+	// every read above reports its own underrun
+	bool failed() const { return false; }
+
+private:
+	llssize remaining() const { return mEnd - mPos; }
+
+	const U8* mStart;
+	const U8* mPos;
+	const U8* mEnd;
+};
+
+template <class Source>
+S32 LLSDBinaryParser::parseValue(Source& src, LLSD& data, S32 max_depth) const
 {
-	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
 /**
  * Undefined: '!'<br>
  * Boolean: '1' for true '0' for false<br>
@@ -968,8 +1135,7 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
  *  notation format.
  */
 	char c;
-	c = get(istr);
-	if(!istr.good())
+	if(!src.get(c))
 	{
 		return 0;
 	}
@@ -982,7 +1148,7 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	{
 	case '{':
 	{
-		S32 child_count = parseMap(istr, data, max_depth - 1);
+		S32 child_count = parseMap(src, data, max_depth - 1);
 		if((child_count == PARSE_FAILURE) || data.isUndefined())
 		{
 			parse_count = PARSE_FAILURE;
@@ -991,7 +1157,7 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 		{
 			parse_count += child_count;
 		}
-		if(istr.fail())
+		if(src.failed())
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary map." << LL_ENDL;
 			parse_count = PARSE_FAILURE;
@@ -1001,7 +1167,7 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 
 	case '[':
 	{
-		S32 child_count = parseArray(istr, data, max_depth - 1);
+		S32 child_count = parseArray(src, data, max_depth - 1);
 		if((child_count == PARSE_FAILURE) || data.isUndefined())
 		{
 			parse_count = PARSE_FAILURE;
@@ -1010,7 +1176,7 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 		{
 			parse_count += child_count;
 		}
-		if(istr.fail())
+		if(src.failed())
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary array." << LL_ENDL;
 			parse_count = PARSE_FAILURE;
@@ -1033,36 +1199,39 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	case 'i':
 	{
 		U32 value_nbo = 0;
-		read(istr, (char*)&value_nbo, sizeof(U32));	 /*Flawfinder: ignore*/
-		data = (S32)ntohl(value_nbo);
-		if(istr.fail())
+		if(!src.read(&value_nbo, sizeof(U32)))
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary integer." << LL_ENDL;
+			parse_count = PARSE_FAILURE;
+			break;
 		}
+		data = (S32)ntohl(value_nbo);
 		break;
 	}
 
 	case 'r':
 	{
 		F64 real_nbo = 0.0;
-		read(istr, (char*)&real_nbo, sizeof(F64));	 /*Flawfinder: ignore*/
-		data = ll_ntohd(real_nbo);
-		if(istr.fail())
+		if(!src.read(&real_nbo, sizeof(F64)))
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary real." << LL_ENDL;
+			parse_count = PARSE_FAILURE;
+			break;
 		}
+		data = ll_ntohd(real_nbo);
 		break;
 	}
 
 	case 'u':
 	{
 		LLUUID id;
-		read(istr, (char*)(&id.mData), UUID_BYTES);	 /*Flawfinder: ignore*/
-		data = id;
-		if(istr.fail())
+		if(!src.read(id.mData, UUID_BYTES))
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary uuid." << LL_ENDL;
+			parse_count = PARSE_FAILURE;
+			break;
 		}
+		data = id;
 		break;
 	}
 
@@ -1070,17 +1239,15 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	case '"':
 	{
 		std::string value;
-		auto cnt = deserialize_string_delim(istr, value, c);
-		if(PARSE_FAILURE == cnt)
+		if(!src.readDelimitedString(value, c))
 		{
 			parse_count = PARSE_FAILURE;
 		}
 		else
 		{
 			data = value;
-			account(cnt);
 		}
-		if(istr.fail())
+		if(src.failed())
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary (notation-style) string."
 				<< LL_ENDL;
@@ -1092,15 +1259,11 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	case 's':
 	{
 		std::string value;
-		if(parseString(istr, value))
+		if(parseString(src, value))
 		{
 			data = value;
 		}
 		else
-		{
-			parse_count = PARSE_FAILURE;
-		}
-		if(istr.fail())
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary string." << LL_ENDL;
 			parse_count = PARSE_FAILURE;
@@ -1111,15 +1274,11 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	case 'l':
 	{
 		std::string value;
-		if(parseString(istr, value))
+		if(parseString(src, value))
 		{
 			data = LLURI(value);
 		}
 		else
-		{
-			parse_count = PARSE_FAILURE;
-		}
-		if(istr.fail())
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary link." << LL_ENDL;
 			parse_count = PARSE_FAILURE;
@@ -1129,14 +1288,15 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 
 	case 'd':
 	{
+		// dates, unlike reals, were never in network byte order
 		F64 real = 0.0;
-		read(istr, (char*)&real, sizeof(F64));	 /*Flawfinder: ignore*/
-		data = LLDate(real);
-		if(istr.fail())
+		if(!src.read(&real, sizeof(F64)))
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary date." << LL_ENDL;
 			parse_count = PARSE_FAILURE;
+			break;
 		}
+		data = LLDate(real);
 		break;
 	}
 
@@ -1145,26 +1305,30 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 		// We probably have a valid raw binary stream. determine
 		// the size, and read it.
 		U32 size_nbo = 0;
-		read(istr, (char*)&size_nbo, sizeof(U32));	/*Flawfinder: ignore*/
-		S32 size = (S32)ntohl(size_nbo);
-		if(mCheckLimits && (size > mMaxBytesLeft))
+		std::vector<U8> value;
+		if(!src.read(&size_nbo, sizeof(U32)))
 		{
 			parse_count = PARSE_FAILURE;
 		}
 		else
 		{
-			std::vector<U8> value;
-			if(size > 0)
+			S32 size = (S32)ntohl(size_nbo);
+			if(!src.fits(size))
 			{
-				value.resize(size);
-				account(fullread(istr, (char*)&value[0], size));
+				parse_count = PARSE_FAILURE;
+			}
+			else if(src.readBinary(value, size))
+			{
+				data = value;
+			}
+			else
+			{
+				parse_count = PARSE_FAILURE;
 			}
-			data = value;
 		}
-		if(istr.fail())
+		if(PARSE_FAILURE == parse_count)
 		{
 			LL_INFOS() << "STREAM FAILURE reading binary." << LL_ENDL;
-			parse_count = PARSE_FAILURE;
 		}
 		break;
 	}
@@ -1182,37 +1346,43 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	return parse_count;
 }
 
-S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map, S32 max_depth) const
+template <class Source>
+S32 LLSDBinaryParser::parseMap(Source& src, LLSD& map, S32 max_depth) const
 {
 	map = LLSD::emptyMap();
 	U32 value_nbo = 0;
-	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	if(!src.read(&value_nbo, sizeof(U32)))
+	{
+		return PARSE_FAILURE;
+	}
 	S32 size = (S32)ntohl(value_nbo);
 	S32 parse_count = 0;
 	S32 count = 0;
-	char c = get(istr);
-	while(c != '}' && (count < size) && istr.good())
+	// reused for every key, so the key copy into the map is the only allocation
+	std::string name;
+	char c = 0;
+	bool more = src.get(c);
+	while(more && (c != '}') && (count < size))
 	{
-		std::string name;
+		name.clear();
 		switch(c)
 		{
 		case 'k':
-			if(!parseString(istr, name))
+			if(!parseString(src, name))
 			{
 				return PARSE_FAILURE;
 			}
 			break;
 		case '\'':
 		case '"':
-		{
-			auto cnt = deserialize_string_delim(istr, name, c);
-			if(PARSE_FAILURE == cnt) return PARSE_FAILURE;
-			account(cnt);
+			if(!src.readDelimitedString(name, c))
+			{
+				return PARSE_FAILURE;
+			}
 			break;
 		}
-		}
 		LLSD child;
-		S32 child_count = doParse(istr, child, max_depth);
+		S32 child_count = parseValue(src, child, max_depth);
 		if(child_count > 0)
 		{
 			// There must be a value for every key, thus child_count
@@ -1225,9 +1395,9 @@ S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map, S32 max_depth) con
 			return PARSE_FAILURE;
 		}
 		++count;
-		c = get(istr);
+		more = src.get(c);
 	}
-	if((c != '}') || (count < size))
+	if(!more || (c != '}') || (count < size))
 	{
 		// Make sure it is correctly terminated and we parsed as many
 		// as were said to be there.
@@ -1236,11 +1406,15 @@ S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map, S32 max_depth) con
 	return parse_count;
 }
 
-S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth) const
+template <class Source>
+S32 LLSDBinaryParser::parseArray(Source& src, LLSD& array, S32 max_depth) const
 {
 	array = LLSD::emptyArray();
 	U32 value_nbo = 0;
-	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	if(!src.read(&value_nbo, sizeof(U32)))
+	{
+		return PARSE_FAILURE;
+	}
 	S32 size = (S32)ntohl(value_nbo);
 
 	// *FIX: This would be a good place to reserve some space in the
@@ -1248,11 +1422,11 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth)
 
 	S32 parse_count = 0;
 	S32 count = 0;
-	char c = istr.peek();
-	while((c != ']') && (count < size) && istr.good())
+	char c = 0;
+	while(src.peek(c) && (c != ']') && (count < size))
 	{
 		LLSD child;
-		S32 child_count = doParse(istr, child, max_depth);
+		S32 child_count = parseValue(src, child, max_depth);
 		if(PARSE_FAILURE == child_count)
 		{
 			return PARSE_FAILURE;
@@ -1263,10 +1437,8 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth)
 			array.append(child);
 		}
 		++count;
-		c = istr.peek();
 	}
-	c = get(istr);
-	if((c != ']') || (count < size))
+	if(!src.get(c) || (c != ']') || (count < size))
 	{
 		// Make sure it is correctly terminated and we parsed as many
 		// as were said to be there.
@@ -1275,27 +1447,40 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth)
 	return parse_count;
 }
 
-bool LLSDBinaryParser::parseString(
-	std::istream& istr,
-	std::string& value) const
+template <class Source>
+bool LLSDBinaryParser::parseString(Source& src, std::string& value) const
 {
-	// *FIX: This is memory inefficient.
 	U32 value_nbo = 0;
-	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	if(!src.read(&value_nbo, sizeof(U32)))
+	{
+		return false;
+	}
 	S32 size = (S32)ntohl(value_nbo);
-	if(mCheckLimits && (size > mMaxBytesLeft)) return false;
+	if(!src.fits(size)) return false;
 	if(size < 0) return false;
-	std::vector<char> buf;
-	if(size)
+	return src.readString(value, size);
+}
+
+// virtual
+S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) const
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+	StreamSource src(*this, istr);
+	return parseValue(src, data, max_depth);
+}
+
+S32 LLSDBinaryParser::parseBuffer(const U8* buffer, llssize length, LLSD& data, S32 max_depth, llssize* bytes_read) const
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+	BufferSource src(buffer, length);
+	S32 parse_count = parseValue(src, data, max_depth);
+	if (bytes_read)
 	{
-		buf.resize(size);
-		account(fullread(istr, &buf[0], size));
-		value.assign(buf.begin(), buf.end());
+		*bytes_read = src.getBytesRead();
 	}
-	return true;
+	return parse_count;
 }
 
-
 /**
  * LLSDFormatter
  */
@@ -2092,13 +2277,20 @@ static const char* NOTATION_STRING_CHARACTERS[256] =
 
 void serialize_string(const std::string& value, std::ostream& str)
 {
-	std::string::const_iterator it = value.begin();
-	std::string::const_iterator end = value.end();
-	U8 c;
-	for(; it != end; ++it)
+	// Most characters stand for themselves, write them a run at a time
+	const char* data = value.data();
+	const size_t size = value.size();
+	size_t pos = 0;
+	while (pos < size)
 	{
-		c = (U8)(*it);
-		str << NOTATION_STRING_CHARACTERS[c];
+		size_t escape = pos + ll_find_notation_escape(data + pos, size - pos);
+		str.write(data + pos, escape - pos);
+		if (escape == size)
+		{
+			break;
+		}
+		str << NOTATION_STRING_CHARACTERS[(U8)data[escape]];
+		pos = escape + 1;
 	}
 }
 
@@ -2333,9 +2525,7 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
 	{
 		char* result_ptr = strip_deprecated_header((char*)result, cur_size);
 
-		boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-		
-		if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+		if (!LLSDSerialize::fromBinary(data, (const U8*)result_ptr, cur_size, UNZIP_LLSD_MAX_DEPTH))
 		{
 			free(result);
 			return ZR_PARSE_ERROR;
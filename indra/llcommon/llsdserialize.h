@@ -358,6 +358,23 @@ public:
 	 */
 	LLSDBinaryParser();
 
+	/** 
+	 * @brief Parse one LLSD object straight out of a buffer.
+	 *
+	 * Gives the same result as parse() on a stream over the same
+	 * bytes, but reads the buffer in place rather than a character at
+	 * a time, and never copies a string more than once.
+	 * @param buffer The binary LLSD, after any <? LLSD/Binary ?> header.
+	 * @param length Number of bytes in buffer.
+	 * @param data[out] The newly parse structured data.
+	 * @param max_depth Max depth parser will check before exiting
+	 *  with parse error, -1 - unlimited.
+	 * @param bytes_read[out] If not null, the number of bytes used.
+	 * @return Returns the number of LLSD objects parsed into
+	 * data. Returns PARSE_FAILURE (-1) on parse failure.
+	 */
+	S32 parseBuffer(const U8* buffer, llssize length, LLSD& data, S32 max_depth = -1, llssize* bytes_read = nullptr) const;
+
 protected:
 	/** 
 	 * @brief Call this method to parse a stream for LLSD.
@@ -378,34 +395,58 @@ protected:
 	virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
 private:
+	/**
+	 * Where the grammar below reads its bytes from. StreamSource goes
+	 * through the LLSDParser istream helpers and honors mMaxBytesLeft,
+	 * BufferSource reads a contiguous buffer in place and checks against
+	 * its end. Both are defined in llsdserialize.cpp.
+	 */
+	class StreamSource;
+	class BufferSource;
+
 	/** 
-	 * @brief Parse a map from the istream
+	 * @brief Parse one LLSD object from src.
 	 *
-	 * @param istr The input stream.
+	 * @param src The input source.
+	 * @param data[out] The newly parse structured data.
+	 * @param max_depth Allowed parsing depth.
+	 * @return Returns the number of LLSD objects parsed into
+	 * data. Returns -1 on parse failure.
+	 */
+	template <class Source>
+	S32 parseValue(Source& src, LLSD& data, S32 max_depth) const;
+
+	/** 
+	 * @brief Parse a map from src
+	 *
+	 * @param src The input source.
 	 * @param map The map to add the parsed data.
 	 * @param max_depth Allowed parsing depth.
 	 * @return Returns The number of LLSD objects parsed into data.
 	 */
-	S32 parseMap(std::istream& istr, LLSD& map, S32 max_depth) const;
+	template <class Source>
+	S32 parseMap(Source& src, LLSD& map, S32 max_depth) const;
 
 	/** 
-	 * @brief Parse an array from the istream.
+	 * @brief Parse an array from src.
 	 *
-	 * @param istr The input stream.
+	 * @param src The input source.
 	 * @param array The array to append the parsed data.
 	 * @param max_depth Allowed parsing depth.
 	 * @return Returns The number of LLSD objects parsed into data.
 	 */
-	S32 parseArray(std::istream& istr, LLSD& array, S32 max_depth) const;
+	template <class Source>
+	S32 parseArray(Source& src, LLSD& array, S32 max_depth) const;
 
 	/** 
-	 * @brief Parse a string from the istream and assign it to data.
+	 * @brief Parse a size prefixed string from src and assign it to value.
 	 *
-	 * @param istr The input stream.
+	 * @param src The input source.
 	 * @param value[out] The string to assign.
 	 * @return Retuns true if a complete string was parsed.
 	 */
-	bool parseString(std::istream& istr, std::string& value) const;
+	template <class Source>
+	bool parseString(Source& src, std::string& value) const;
 };
 
 
@@ -846,6 +887,12 @@ public:
 		(void)p->parse(str, sd, max_bytes, max_depth);
 		return sd;
 	}
+	// Prefer this over the stream version when the data is already in memory
+	static S32 fromBinary(LLSD& sd, const U8* buffer, llssize length, S32 max_depth = -1)
+	{
+		LLPointer<LLSDBinaryParser> p = new LLSDBinaryParser;
+		return p->parseBuffer(buffer, length, sd, max_depth);
+	}
 };
 
 class LL_COMMON_API LLUZipHelper : public LLRefCount
@@ -30,8 +30,8 @@
 #include <iostream>
 #include <deque>
 
-#include "apr_base64.h"
-#include <boost/regex.hpp>
+#include "llbase64.h"
+#include "lltextcodec.h"
 
 extern "C"
 {
@@ -42,6 +42,45 @@ extern "C"
 #endif
 }
 
+namespace
+{
+	const char* xml_entity(char c)
+	{
+		switch(c)
+		{
+		case '<':
+			return "&lt;";
+		case '>':
+			return "&gt;";
+		case '&':
+			return "&amp;";
+		case '\'':
+			return "&apos;";
+		default:
+			return "&quot;";
+		}
+	}
+
+	// Same as LLSDXMLFormatter::escapeString() without the copy
+	void write_escaped(std::ostream& ostr, const std::string& in)
+	{
+		const char* data = in.data();
+		const size_t size = in.size();
+		size_t pos = 0;
+		while (pos < size)
+		{
+			size_t escape = pos + ll_find_xml_escape(data + pos, size - pos);
+			ostr.write(data + pos, escape - pos);
+			if (escape == size)
+			{
+				break;
+			}
+			ostr << xml_entity(data[escape]);
+			pos = escape + 1;
+		}
+	}
+}
+
 /**
  * LLSDXMLFormatter
  */
@@ -105,7 +144,9 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 			LLSD::map_const_iterator end = data.endMap();
 			for(; iter != end; ++iter)
 			{
-				ostr << pre << "<key>" << escapeString((*iter).first) << "</key>" << post;
+				ostr << pre << "<key>";
+				write_escaped(ostr, (*iter).first);
+				ostr << "</key>" << post;
 				format_count += format_impl((*iter).second, ostr, options, level + 1);
 			}
 			ostr << pre <<  "</map>" << post;
@@ -173,7 +214,12 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 
 	case LLSD::TypeString:
 		if(data.asStringRef().empty()) ostr << pre << "<string />" << post;
-		else ostr << pre << "<string>" << escapeString(data.asStringRef()) <<"</string>" << post;
+		else
+		{
+			ostr << pre << "<string>";
+			write_escaped(ostr, data.asStringRef());
+			ostr << "</string>" << post;
+		}
 		break;
 
 	case LLSD::TypeDate:
@@ -181,7 +227,9 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 		break;
 
 	case LLSD::TypeURI:
-		ostr << pre << "<uri>" << escapeString(data.asString()) << "</uri>" << post;
+		ostr << pre << "<uri>";
+		write_escaped(ostr, data.asString());
+		ostr << "</uri>" << post;
 		break;
 
 	case LLSD::TypeBinary:
@@ -193,17 +241,8 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 		}
 		else
 		{
-			// *FIX: memory inefficient.
-			// *TODO: convert to use LLBase64
 			ostr << pre << "<binary encoding=\"base64\">";
-			int b64_buffer_length = apr_base64_encode_len(narrow(buffer.size()));
-			char* b64_buffer = new char[b64_buffer_length];
-			b64_buffer_length = apr_base64_encode_binary(
-				b64_buffer,
-				&buffer[0],
-				narrow(buffer.size()));
-			ostr.write(b64_buffer, b64_buffer_length - 1);
-			delete[] b64_buffer;
+			ostr << LLBase64::encode(&buffer[0], buffer.size());
 			ostr << "</binary>" << post;
 		}
 		break;
@@ -219,34 +258,23 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 // static
 std::string LLSDXMLFormatter::escapeString(const std::string& in)
 {
-	std::ostringstream out;
-	std::string::const_iterator it = in.begin();
-	std::string::const_iterator end = in.end();
-	for(; it != end; ++it)
+	std::string out;
+	out.reserve(in.size());
+	const char* data = in.data();
+	const size_t size = in.size();
+	size_t pos = 0;
+	while (pos < size)
 	{
-		switch((*it))
+		size_t escape = pos + ll_find_xml_escape(data + pos, size - pos);
+		out.append(data + pos, escape - pos);
+		if (escape == size)
 		{
-		case '<':
-			out << "&lt;";
-			break;
-		case '>':
-			out << "&gt;";
-			break;
-		case '&':
-			out << "&amp;";
-			break;
-		case '\'':
-			out << "&apos;";
-			break;
-		case '"':
-			out << "&quot;";
-			break;
-		default:
-			out << (*it);
 			break;
 		}
+		out += xml_entity(data[escape]);
+		pos = escape + 1;
 	}
-	return out.str();
+	return out;
 }
 
 
@@ -776,19 +804,18 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 		
 		case ELEMENT_BINARY:
 		{
-			// Regex is expensive, but only fix for whitespace in base64,
-			// created by python and other non-linden systems - DEV-39358
-			// Fortunately we have very little binary passing now,
-			// so performance impact shold be negligible. + poppy 2009-09-04
-			boost::regex r;
-			r.assign("\\s");
-			std::string stripped = boost::regex_replace(mCurrentContent, r, "");
-			S32 len = apr_base64_decode_len(stripped.c_str());
-			std::vector<U8> data;
-			data.resize(len);
-			len = apr_base64_decode_binary(&data[0], stripped.c_str());
-			data.resize(len);
-			value = data;
+			// Strip whitespace from base64 created by python and other
+			// non-linden systems - DEV-39358
+			std::string stripped;
+			stripped.reserve(mCurrentContent.size());
+			for (char c : mCurrentContent)
+			{
+				if (!isspace((U8)c))
+				{
+					stripped += c;
+				}
+			}
+			value = LLBase64::decode(stripped);
 			break;
 		}
 		
@@ -152,6 +152,7 @@ LLStringTableEntry* LLStringTable::checkStringEntry(const std::string& str)
 
 LLStringTableEntry* LLStringTable::checkStringEntry(const char *str)
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	if (str)
 	{
 		char *ret_val;
@@ -220,6 +221,7 @@ LLStringTableEntry* LLStringTable::addStringEntry(const std::string& str)
 
 LLStringTableEntry* LLStringTable::addStringEntry(const char *str)
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	if (str)
 	{
 		char *ret_val = NULL;
@@ -286,6 +288,7 @@ LLStringTableEntry* LLStringTable::addStringEntry(const char *str)
 
 void LLStringTable::removeString(const char *str)
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	if (str)
 	{
 		char *ret_val;
@@ -32,6 +32,7 @@
 #include "llformat.h"
 #include "llstl.h"
 #include <list>
+#include <mutex>
 #include <set>
 
 #if LL_WINDOWS
@@ -76,6 +77,9 @@ public:
 
 	S32 mMaxEntries;
 	S32 mUniqueEntries;
+
+	// XML files are parsed on worker threads too, so lookups and inserts lock.
+	std::mutex mMutex;
 	
 #if STRING_TABLE_HASH_MAP
 #if LL_WINDOWS
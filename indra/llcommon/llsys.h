@@ -90,6 +90,7 @@ public:
     bool hasSSE41() const;
     bool hasSSE42() const;
     bool hasSSE4a() const;
+    bool hasAVX2() const;
 	F64 getMHz() const;
 
 	// Family is "AMD Duron" or "Intel Pentium Pro"
@@ -103,6 +104,7 @@ private:
     bool mHasSSE41;
     bool mHasSSE42;
     bool mHasSSE4a;
+    bool mHasAVX2;
 	bool mHasAltivec;
 	F64 mCPUMHz;
 	std::string mFamily;
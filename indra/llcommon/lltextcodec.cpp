@@ -0,0 +1,214 @@
+/**
+ * @file lltextcodec.cpp
+ * @brief Hex coding and escape scanning for UUID and LLSD text
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltextcodec.h"
+
+#include <emmintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+
+namespace
+{
+	const char HEX_DIGITS[] = "0123456789abcdef";
+
+	inline size_t lowest_bit(U32 mask)
+	{
+#if LL_WINDOWS
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (size_t)index;
+#else
+		return (size_t)__builtin_ctz(mask);
+#endif
+	}
+
+	// value of a hex digit, or -1
+	inline S32 hex_value(char c)
+	{
+		if (c >= '0' && c <= '9')
+		{
+			return c - '0';
+		}
+		c |= 0x20;
+		if (c >= 'a' && c <= 'f')
+		{
+			return 10 + c - 'a';
+		}
+		return -1;
+	}
+
+	// 0..15 to '0'..'9', 'a'..'f'
+	inline __m128i nibbles_to_hex(__m128i nibbles)
+	{
+		const __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+		const __m128i digits = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+		return _mm_add_epi8(digits, _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+	}
+
+	// x <= limit, bytes compared unsigned
+	inline __m128i less_equal_u8(__m128i x, __m128i limit)
+	{
+		return _mm_cmpeq_epi8(_mm_min_epu8(x, limit), x);
+	}
+
+	// 16 hex digits to their values. valid gets a set byte for each digit.
+	inline __m128i hex_to_nibbles(__m128i chars, __m128i& valid)
+	{
+		const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+		const __m128i is_digit = less_equal_u8(digit, _mm_set1_epi8(9));
+		const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+		const __m128i is_letter = less_equal_u8(letter, _mm_set1_epi8(5));
+		valid = _mm_or_si128(is_digit, is_letter);
+		return _mm_or_si128(_mm_and_si128(is_digit, digit),
+							_mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+	}
+}
+
+void ll_hex_encode(const U8* in, size_t size, char* out)
+{
+	const __m128i low_nibble = _mm_set1_epi8(0x0F);
+	size_t pos = 0;
+	for (; pos + 16 <= size; pos += 16)
+	{
+		const __m128i bytes = _mm_loadu_si128((const __m128i*)(in + pos));
+		const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble);
+		const __m128i low = _mm_and_si128(bytes, low_nibble);
+		// the high digit of each byte comes first
+		_mm_storeu_si128((__m128i*)(out + 2 * pos), nibbles_to_hex(_mm_unpacklo_epi8(high, low)));
+		_mm_storeu_si128((__m128i*)(out + 2 * pos + 16), nibbles_to_hex(_mm_unpackhi_epi8(high, low)));
+	}
+	for (; pos < size; ++pos)
+	{
+		out[2 * pos] = HEX_DIGITS[in[pos] >> 4];
+		out[2 * pos + 1] = HEX_DIGITS[in[pos] & 0x0F];
+	}
+}
+
+bool ll_hex_decode(const char* in, size_t size, U8* out)
+{
+	const __m128i low_byte = _mm_set1_epi16(0x00FF);
+	size_t pos = 0;
+	for (; pos + 16 <= size; pos += 16)
+	{
+		__m128i valid_first;
+		__m128i valid_second;
+		const __m128i first = hex_to_nibbles(_mm_loadu_si128((const __m128i*)(in + 2 * pos)), valid_first);
+		const __m128i second = hex_to_nibbles(_mm_loadu_si128((const __m128i*)(in + 2 * pos + 16)), valid_second);
+		if (_mm_movemask_epi8(_mm_and_si128(valid_first, valid_second)) != 0xFFFF)
+		{
+			return false;
+		}
+		// each 16 bit lane holds the high digit in its low byte
+		const __m128i bytes_first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, low_byte), 4),
+												 _mm_srli_epi16(first, 8));
+		const __m128i bytes_second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, low_byte), 4),
+												  _mm_srli_epi16(second, 8));
+		_mm_storeu_si128((__m128i*)(out + pos), _mm_packus_epi16(bytes_first, bytes_second));
+	}
+	for (; pos < size; ++pos)
+	{
+		S32 high = hex_value(in[2 * pos]);
+		S32 low = hex_value(in[2 * pos + 1]);
+		if (high < 0 || low < 0)
+		{
+			return false;
+		}
+		out[pos] = (U8)((high << 4) | low);
+	}
+	return true;
+}
+
+size_t ll_find_xml_escape(const char* in, size_t size)
+{
+	const __m128i lt = _mm_set1_epi8('<');
+	const __m128i gt = _mm_set1_epi8('>');
+	const __m128i amp = _mm_set1_epi8('&');
+	const __m128i apos = _mm_set1_epi8('\'');
+	const __m128i quot = _mm_set1_epi8('"');
+	size_t pos = 0;
+	for (; pos + 16 <= size; pos += 16)
+	{
+		const __m128i chars = _mm_loadu_si128((const __m128i*)(in + pos));
+		__m128i found = _mm_or_si128(_mm_cmpeq_epi8(chars, lt), _mm_cmpeq_epi8(chars, gt));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, amp));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, apos));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, quot));
+		U32 mask = (U32)_mm_movemask_epi8(found);
+		if (mask)
+		{
+			return pos + lowest_bit(mask);
+		}
+	}
+	for (; pos < size; ++pos)
+	{
+		switch (in[pos])
+		{
+		case '<':
+		case '>':
+		case '&':
+		case '\'':
+		case '"':
+			return pos;
+		default:
+			break;
+		}
+	}
+	return size;
+}
+
+size_t ll_find_notation_escape(const char* in, size_t size)
+{
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i del = _mm_set1_epi8(0x7F);
+	const __m128i apos = _mm_set1_epi8('\'');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	size_t pos = 0;
+	for (; pos + 16 <= size; pos += 16)
+	{
+		const __m128i chars = _mm_loadu_si128((const __m128i*)(in + pos));
+		// signed, so bytes from 0x80 up count as below ' ' too
+		__m128i found = _mm_or_si128(_mm_cmplt_epi8(chars, space), _mm_cmpeq_epi8(chars, del));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, apos));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, backslash));
+		U32 mask = (U32)_mm_movemask_epi8(found);
+		if (mask)
+		{
+			return pos + lowest_bit(mask);
+		}
+	}
+	for (; pos < size; ++pos)
+	{
+		U8 c = (U8)in[pos];
+		if (c < ' ' || c >= 0x7F || c == '\'' || c == '\\')
+		{
+			return pos;
+		}
+	}
+	return size;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file lltextcodec.h
+ * @brief Hex coding and escape scanning for UUID and LLSD text
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTCODEC_H
+#define LL_LLTEXTCODEC_H
+
+#include "stdtypes.h"
+
+// Inner loops of UUID strings and of the LLSD text formatters. They work
+// 16 bytes at a time with SSE2, which every viewer build already assumes,
+// and finish the tail a byte at a time.
+
+// Write size bytes of in as 2 * size lowercase hex digits. out is not
+// null terminated.
+LL_COMMON_API void ll_hex_encode(const U8* in, size_t size, char* out);
+
+// Read 2 * size hex digits of either case into size bytes. Returns false,
+// with out partly written, if any of them is not a hex digit.
+LL_COMMON_API bool ll_hex_decode(const char* in, size_t size, U8* out);
+
+// Offset of the first byte that LLSDXMLFormatter::escapeString() replaces
+// with an entity: < > & ' or ". Returns size if there is none.
+LL_COMMON_API size_t ll_find_xml_escape(const char* in, size_t size);
+
+// Offset of the first byte that the notation formatter writes as an escape
+// sequence: ' \ and anything outside printable ASCII. Returns size if
+// there is none.
+LL_COMMON_API size_t ll_find_notation_escape(const char* in, size_t size);
+
+#endif // LL_LLTEXTCODEC_H
@@ -32,10 +32,15 @@
 #include <boost/fiber/timed_mutex.hpp>
 #include LLCOROS_CONDVAR_HEADER
 #include "llexception.h"
+#include "llmpmcring.h"
 #include "mutex.h"
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
 
 /*****************************************************************************
 *   LLThreadSafeQueue
@@ -587,4 +592,425 @@ bool LLThreadSafeQueue<ElementT, QueueT>::done()
     return mClosed && mStorage.empty();
 }
 
+
+/*****************************************************************************
+*   LLThreadSafeQueue on a lock-free ring
+*****************************************************************************/
+/**
+ * LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>> has the same API and
+ * semantics as the mutex-based LLThreadSafeQueue, but pushing and popping
+ * don't take a lock: while neither end has to wait, producers and consumers
+ * never contend for anything but the ring's head and tail.
+ *
+ * The ring holds at most RING_SIZE elements. Past that, up to capacity,
+ * elements spill into a deque under a plain mutex, which consumers move back
+ * into the ring as it empties, so a large capacity doesn't cost a large ring
+ * and each producer's elements still pop in the order it pushed them.
+ *
+ * A blocking pop() (or push() to a full queue) first retries for a few
+ * microseconds, since on a busy queue the next element is usually about to
+ * arrive, then waits on a fiber-aware condition variable. Only a side that
+ * sees a waiter pays for the notification.
+ *
+ * There is no canPop(): a lock-free consumer can't inspect the head without
+ * taking it. Subclasses that need it (ThreadSafeSchedule) use the mutex-based
+ * queue.
+ */
+template<typename ElementT>
+class LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>
+{
+public:
+	typedef ElementT value_type;
+
+	LLThreadSafeQueue(size_t capacity = 1024);
+	virtual ~LLThreadSafeQueue() {}
+
+	template <typename T>
+	void push(T&& element);
+	void pushFront(ElementT const & element) { return push(element); }
+
+	template <typename T>
+	bool pushIfOpen(T&& element);
+
+	template <typename T>
+	bool tryPush(T&& element);
+	bool tryPushFront(ElementT const & element) { return tryPush(element); }
+
+	template <typename Rep, typename Period, typename T>
+	bool tryPushFor(const std::chrono::duration<Rep, Period>& timeout,
+					T&& element);
+	template <typename Rep, typename Period>
+	bool tryPushFrontFor(const std::chrono::duration<Rep, Period>& timeout,
+						 ElementT const & element) { return tryPushFor(timeout, element); }
+
+	template <typename Clock, typename Duration, typename T>
+	bool tryPushUntil(const std::chrono::time_point<Clock, Duration>& until,
+					  T&& element);
+
+	ElementT pop(void);
+	ElementT popBack(void) { return pop(); }
+
+	bool tryPop(ElementT & element);
+	bool tryPopBack(ElementT & element) { return tryPop(element); }
+
+	template <typename Rep, typename Period>
+	bool tryPopFor(const std::chrono::duration<Rep, Period>& timeout, ElementT& element);
+
+	template <typename Clock, typename Duration>
+	bool tryPopUntil(const std::chrono::time_point<Clock, Duration>& until,
+					 ElementT& element);
+
+	size_t size();
+
+	U32 capacity() { return mCapacity; }
+
+	void close();
+
+	bool isClosed();
+	bool done();
+
+protected:
+	typedef LL::MPMCRing<ElementT> queue_type;
+
+	// the most elements kept in the ring itself
+	static constexpr size_t RING_SIZE = 1024;
+	// attempts before a blocking call waits on the condition variable
+	static constexpr U32 SPIN_COUNT = 64;
+
+	queue_type mStorage;
+	std::deque<ElementT> mOverflow;
+	std::mutex mOverflowLock;
+	std::atomic<size_t> mOverflowSize;
+	// includes elements still being pushed
+	std::atomic<size_t> mSize;
+	size_t mCapacity;
+	std::atomic<bool> mClosed;
+
+	// only used to wait
+	LLCoros::Mutex mLock;
+	typedef LLCoros::LockType lock_t;
+	LLCoros::ConditionVariable mCapacityCond;
+	LLCoros::ConditionVariable mEmptyCond;
+	std::atomic<U32> mPushWaiters;
+	std::atomic<U32> mPopWaiters;
+
+	// RETRY: full (push) or empty (pop); CLOSED: closed (push) or closed
+	// and drained (pop)
+	enum op_result { SUCCEEDED, RETRY, CLOSED };
+	// One attempt; element is only consumed on SUCCEEDED. These may run
+	// with mLock locked, so they don't notify: callers pass the result to
+	// pushed_() or popped_() once mLock is released.
+	template <typename T>
+	op_result push_(T&& element);
+	op_result pop_(ElementT& element);
+	op_result pushed_(op_result result)
+	{
+		// a push that backed out of close() may have been what a consumer
+		// waited on to see the queue drained
+		if (result != RETRY)
+			notify_(mEmptyCond, mPopWaiters);
+		return result;
+	}
+	op_result popped_(op_result result)
+	{
+		if (result == SUCCEEDED)
+			notify_(mCapacityCond, mPushWaiters);
+		return result;
+	}
+	// refill the empty ring from mOverflow, mOverflowLock locked
+	void refill_();
+	void notify_(LLCoros::ConditionVariable& cond, std::atomic<U32>& waiters);
+	// retry attempt() until it doesn't return RETRY or until passes, first
+	// spinning, then waiting on cond
+	template <typename Clock, typename Duration, typename ATTEMPT>
+	op_result wait_(LLCoros::ConditionVariable& cond, std::atomic<U32>& waiters,
+					const std::chrono::time_point<Clock, Duration>& until,
+					ATTEMPT&& attempt);
+};
+
+
+template<typename ElementT>
+LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::LLThreadSafeQueue(size_t capacity) :
+	mStorage(llmin(capacity, RING_SIZE)),
+	mOverflowSize(0),
+	mSize(0),
+	mCapacity(capacity),
+	mClosed(false),
+	mPushWaiters(0),
+	mPopWaiters(0)
+{
+}
+
+
+template<typename ElementT>
+template<typename T>
+typename LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::op_result
+LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::push_(T&& element)
+{
+	if (mClosed.load())
+		return CLOSED;
+
+	// Reserve room before pushing, so that concurrent pushes can't overshoot
+	// mCapacity.
+	size_t size = mSize.load();
+	do
+	{
+		if (size >= mCapacity)
+			return RETRY;
+	} while (! mSize.compare_exchange_weak(size, size + 1));
+
+	// close() may have come in between: back out, or a consumer that already
+	// saw the queue drained would never get this element
+	if (mClosed.load())
+	{
+		--mSize;
+		return CLOSED;
+	}
+
+	// Once anything has spilled, keep using the overflow until consumers
+	// have moved it all back to the ring: anything pushed to the ring now
+	// would overtake it.
+	if (mOverflowSize.load() || ! mStorage.tryPush(std::forward<T>(element)))
+	{
+		std::lock_guard<std::mutex> lock(mOverflowLock);
+		mOverflow.push_back(std::forward<T>(element));
+		mOverflowSize.store(mOverflow.size());
+	}
+	return SUCCEEDED;
+}
+
+
+template<typename ElementT>
+typename LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::op_result
+LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::pop_(ElementT& element)
+{
+	// The ring only holds elements older than any in the overflow, so it
+	// always comes first.
+	if (! mStorage.tryPop(element))
+	{
+		if (! mOverflowSize.load())
+		{
+			// mSize counts pushes still in progress: not drained yet
+			return (mClosed.load() && ! mSize.load())? CLOSED : RETRY;
+		}
+
+		std::lock_guard<std::mutex> lock(mOverflowLock);
+		if (mOverflow.empty())
+			return RETRY;
+		element = std::move(mOverflow.front());
+		mOverflow.pop_front();
+		refill_();
+	}
+	--mSize;
+	return SUCCEEDED;
+}
+
+
+template<typename ElementT>
+void LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::refill_()
+{
+	// Producers append to mOverflow only under mOverflowLock, and push to
+	// the ring only once mOverflowSize is zero, so nothing can overtake
+	// what we move.
+	while (! mOverflow.empty() && mStorage.tryPush(std::move(mOverflow.front())))
+	{
+		mOverflow.pop_front();
+	}
+	mOverflowSize.store(mOverflow.size());
+}
+
+
+template<typename ElementT>
+void LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::notify_(
+	LLCoros::ConditionVariable& cond, std::atomic<U32>& waiters)
+{
+	// Pairs with the fence in wait_(): either the waiter sees what we just
+	// did, or we see the waiter.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiters.load(std::memory_order_relaxed))
+	{
+		// Taking the lock makes sure a waiter that has registered is
+		// actually waiting before we notify it.
+		lock_t lock(mLock);
+		cond.notify_all();
+	}
+}
+
+
+template<typename ElementT>
+template <typename Clock, typename Duration, typename ATTEMPT>
+typename LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::op_result
+LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::wait_(
+	LLCoros::ConditionVariable& cond, std::atomic<U32>& waiters,
+	const std::chrono::time_point<Clock, Duration>& until,
+	ATTEMPT&& attempt)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	for (U32 spin = 0; spin < SPIN_COUNT; ++spin)
+	{
+		op_result result = attempt();
+		if (result != RETRY)
+			return result;
+		std::this_thread::yield();
+	}
+
+	lock_t lock(mLock);
+	++waiters;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	op_result result;
+	while ((result = attempt()) == RETRY)
+	{
+		if (until == std::chrono::time_point<Clock, Duration>::max())
+		{
+			cond.wait(lock);
+		}
+		else if (LLCoros::cv_status::timeout == cond.wait_until(lock, until))
+		{
+			result = attempt();
+			break;
+		}
+	}
+	--waiters;
+	return result;
+}
+
+
+template<typename ElementT>
+template<typename T>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::pushIfOpen(T&& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return pushed_(wait_(mCapacityCond, mPushWaiters,
+						 std::chrono::steady_clock::time_point::max(),
+						 [this, &element](){ return push_(std::forward<T>(element)); }))
+		== SUCCEEDED;
+}
+
+
+template<typename ElementT>
+template<typename T>
+void LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::push(T&& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	if (! pushIfOpen(std::forward<T>(element)))
+	{
+		LLTHROW(LLThreadSafeQueueInterrupt());
+	}
+}
+
+
+template<typename ElementT>
+template<typename T>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::tryPush(T&& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return pushed_(push_(std::forward<T>(element))) == SUCCEEDED;
+}
+
+
+template<typename ElementT>
+template <typename Rep, typename Period, typename T>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::tryPushFor(
+	const std::chrono::duration<Rep, Period>& timeout,
+	T&& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return tryPushUntil(std::chrono::steady_clock::now() + timeout,
+						std::forward<T>(element));
+}
+
+
+template<typename ElementT>
+template <typename Clock, typename Duration, typename T>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::tryPushUntil(
+	const std::chrono::time_point<Clock, Duration>& until,
+	T&& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return pushed_(wait_(mCapacityCond, mPushWaiters, until,
+						 [this, &element](){ return push_(std::forward<T>(element)); }))
+		== SUCCEEDED;
+}
+
+
+template<typename ElementT>
+ElementT LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::pop(void)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	ElementT value;
+	if (popped_(wait_(mEmptyCond, mPopWaiters,
+					  std::chrono::steady_clock::time_point::max(),
+					  [this, &value](){ return pop_(value); }))
+		!= SUCCEEDED)
+	{
+		LLTHROW(LLThreadSafeQueueInterrupt());
+	}
+	return value;
+}
+
+
+template<typename ElementT>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::tryPop(ElementT & element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return popped_(pop_(element)) == SUCCEEDED;
+}
+
+
+template<typename ElementT>
+template <typename Rep, typename Period>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::tryPopFor(
+	const std::chrono::duration<Rep, Period>& timeout,
+	ElementT& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return tryPopUntil(std::chrono::steady_clock::now() + timeout, element);
+}
+
+
+template<typename ElementT>
+template <typename Clock, typename Duration>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::tryPopUntil(
+	const std::chrono::time_point<Clock, Duration>& until,
+	ElementT& element)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	return popped_(wait_(mEmptyCond, mPopWaiters, until,
+						 [this, &element](){ return pop_(element); }))
+		== SUCCEEDED;
+}
+
+
+template<typename ElementT>
+size_t LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::size()
+{
+	return mSize.load();
+}
+
+
+template<typename ElementT>
+void LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::close()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+	mClosed.store(true);
+	// wake up any blocked pop() and push() calls
+	lock_t lock(mLock);
+	mEmptyCond.notify_all();
+	mCapacityCond.notify_all();
+}
+
+
+template<typename ElementT>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::isClosed()
+{
+	return mClosed.load();
+}
+
+
+template<typename ElementT>
+bool LLThreadSafeQueue<ElementT, LL::MPMCRing<ElementT>>::done()
+{
+	return mClosed.load() && ! mSize.load();
+}
+
 #endif
@@ -361,6 +361,28 @@ inline void disclaim_alloc(MemStatHandle& measurement, const T& value)
 #endif
 }
 
+// For footprints a subsystem totals itself: claims or disclaims the
+// difference between bytes and the last footprint recorded.
+inline void set_alloc(MemStatHandle& measurement, size_t bytes)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_STATS;
+#if LL_TRACE_ENABLED
+	MemAccumulator& accumulator = measurement.getCurrentAccumulator();
+	F64 last = accumulator.mSize.hasValue() ? accumulator.mSize.getLastValue() : 0.0;
+	F64 size = (F64)bytes;
+	if (accumulator.mSize.hasValue() && size == last) return;
+	accumulator.mSize.sample(size);
+	if (size > last)
+	{
+		accumulator.mAllocations.record(size - last);
+	}
+	else if (size < last)
+	{
+		accumulator.mDeallocations.add(last - size);
+	}
+#endif
+}
+
 }
 
 #endif // LL_LLTRACE_H
@@ -41,6 +41,7 @@
 #include "llerror.h"
 #include "llrand.h"
 #include "llstring.h"
+#include "lltextcodec.h"
 #include "lltimer.h"
 #include "llthread.h"
 #include "llmutex.h"
@@ -153,35 +154,37 @@ U32 janky_fast_random_seeded_bytes(U32 seed, U32 val)
 }
 #endif
 
+// Offsets of the dashes in the 8-4-4-4-12 string form
+static const S32 UUID_DASHES[] = { 8, 13, 18, 23 };
+
+// Writes the UUID_STR_LENGTH - 1 characters of the string form, no null.
+static void format_uuid(const U8* data, char* out)
+{
+    char hex[2 * UUID_BYTES];
+    ll_hex_encode(data, UUID_BYTES, hex);
+    memcpy(out, hex, 8);		/* Flawfinder: ignore */
+    out[8] = '-';
+    memcpy(out + 9, hex + 8, 4);		/* Flawfinder: ignore */
+    out[13] = '-';
+    memcpy(out + 14, hex + 12, 4);		/* Flawfinder: ignore */
+    out[18] = '-';
+    memcpy(out + 19, hex + 16, 4);		/* Flawfinder: ignore */
+    out[23] = '-';
+    memcpy(out + 24, hex + 20, 12);		/* Flawfinder: ignore */
+}
+
 // Common to all UUID implementations
 void LLUUID::toString(std::string& out) const
 {
-    out = llformat(
-        "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-        (U8)(mData[0]),
-        (U8)(mData[1]),
-        (U8)(mData[2]),
-        (U8)(mData[3]),
-        (U8)(mData[4]),
-        (U8)(mData[5]),
-        (U8)(mData[6]),
-        (U8)(mData[7]),
-        (U8)(mData[8]),
-        (U8)(mData[9]),
-        (U8)(mData[10]),
-        (U8)(mData[11]),
-        (U8)(mData[12]),
-        (U8)(mData[13]),
-        (U8)(mData[14]),
-        (U8)(mData[15]));
+    out.resize(UUID_STR_LENGTH - 1);
+    format_uuid(mData, &out[0]);
 }
 
 // *TODO: deprecate
 void LLUUID::toString(char* out) const
 {
-    std::string buffer;
-    toString(buffer);
-    strcpy(out, buffer.c_str()); /* Flawfinder: ignore */
+    format_uuid(mData, out);
+    out[UUID_STR_LENGTH - 1] = '\0';
 }
 
 void LLUUID::toCompressedString(std::string& out) const
@@ -227,6 +230,27 @@ BOOL LLUUID::set(const std::string& in_string, BOOL emit)
         return TRUE;
     }
 
+    if (in_string.length() == (UUID_STR_LENGTH - 1)
+        && in_string[UUID_DASHES[0]] == '-'
+        && in_string[UUID_DASHES[1]] == '-'
+        && in_string[UUID_DASHES[2]] == '-'
+        && in_string[UUID_DASHES[3]] == '-')
+    {
+        // Well formed, decode the digits all at once. Anything bad is
+        // reported by the loop below.
+        const char* in = in_string.data();
+        char hex[2 * UUID_BYTES];
+        memcpy(hex, in, 8);		/* Flawfinder: ignore */
+        memcpy(hex + 8, in + 9, 4);		/* Flawfinder: ignore */
+        memcpy(hex + 12, in + 14, 4);		/* Flawfinder: ignore */
+        memcpy(hex + 16, in + 19, 4);		/* Flawfinder: ignore */
+        memcpy(hex + 20, in + 24, 12);		/* Flawfinder: ignore */
+        if (ll_hex_decode(hex, UUID_BYTES, mData))
+        {
+            return TRUE;
+        }
+    }
+
     if (in_string.length() != (UUID_STR_LENGTH - 1))		/* Flawfinder: ignore */
     {
         // I'm a moron.  First implementation didn't have the right UUID format.
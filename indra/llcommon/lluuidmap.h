@@ -0,0 +1,446 @@
+/**
+ * @file   lluuidmap.h
+ * @date   2023-06-28
+ * @brief  Open addressing hash map keyed by LLUUID.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLUUIDMAP_H)
+#define LL_LLUUIDMAP_H
+
+#include "lluuid.h"
+
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+
+/**
+ * LLUUIDMap<T> stands in for std::map<LLUUID, T> or unordered_map<LLUUID, T>
+ * in big registries that are looked up all the time, such as the object
+ * list or the inventory. The entries live in one flat array, probed
+ * linearly from a slot picked by the key's own bits: UUIDs are random
+ * already, so there is nothing to gain from hashing them properly.
+ *
+ * It supports the commonly used subset of the std::map interface, with
+ * these differences:
+ * - iteration order is arbitrary;
+ * - inserting may grow the table, which invalidates every iterator,
+ *   pointer and reference into it;
+ * - erasing never moves other entries, so erase(iterator), including the
+ *   erase(it++) idiom, is safe while iterating.
+ */
+template <typename T>
+class LLUUIDMap
+{
+public:
+	typedef LLUUID key_type;
+	typedef T mapped_type;
+	typedef std::pair<const LLUUID, T> value_type;
+	typedef size_t size_type;
+
+private:
+	enum : U8 { EMPTY = 0, FULL, ERASED };
+
+	struct Slot
+	{
+		alignas(value_type) unsigned char mStorage[sizeof(value_type)];
+
+		value_type* get() { return std::launder(reinterpret_cast<value_type*>(mStorage)); }
+	};
+
+	template <typename MAP, typename VALUE>
+	class iterator_base
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef VALUE value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef VALUE* pointer;
+		typedef VALUE& reference;
+
+		iterator_base() : mMap(nullptr), mIndex(0) {}
+		iterator_base(MAP* map, size_t index) : mMap(map), mIndex(index) {}
+		// iterator converts to const_iterator
+		template <typename OTHERMAP, typename OTHERVALUE>
+		iterator_base(const iterator_base<OTHERMAP, OTHERVALUE>& other) :
+			mMap(other.mMap), mIndex(other.mIndex)
+		{}
+
+		reference operator*() const { return *mMap->mSlots[mIndex].get(); }
+		pointer operator->() const { return mMap->mSlots[mIndex].get(); }
+
+		iterator_base& operator++()
+		{
+			mIndex = mMap->next(mIndex + 1);
+			return *this;
+		}
+
+		iterator_base operator++(int)
+		{
+			iterator_base previous(*this);
+			++*this;
+			return previous;
+		}
+
+		template <typename OTHERMAP, typename OTHERVALUE>
+		bool operator==(const iterator_base<OTHERMAP, OTHERVALUE>& other) const
+		{
+			return mIndex == other.mIndex;
+		}
+
+		template <typename OTHERMAP, typename OTHERVALUE>
+		bool operator!=(const iterator_base<OTHERMAP, OTHERVALUE>& other) const
+		{
+			return mIndex != other.mIndex;
+		}
+
+	private:
+		template <typename, typename> friend class iterator_base;
+		friend class LLUUIDMap;
+
+		MAP* mMap;
+		size_t mIndex;
+	};
+
+public:
+	typedef iterator_base<LLUUIDMap, value_type> iterator;
+	typedef iterator_base<const LLUUIDMap, const value_type> const_iterator;
+
+	LLUUIDMap() :
+		mCapacity(0),
+		mShift(64),
+		mSize(0),
+		mErased(0)
+	{
+	}
+
+	LLUUIDMap(const LLUUIDMap& other) :
+		LLUUIDMap()
+	{
+		*this = other;
+	}
+
+	LLUUIDMap(LLUUIDMap&& other) noexcept :
+		LLUUIDMap()
+	{
+		swap(other);
+	}
+
+	~LLUUIDMap()
+	{
+		destroyAll();
+	}
+
+	LLUUIDMap& operator=(const LLUUIDMap& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			reserve(other.size());
+			for (const value_type& value : other)
+			{
+				emplace(value.first, value.second);
+			}
+		}
+		return *this;
+	}
+
+	LLUUIDMap& operator=(LLUUIDMap&& other) noexcept
+	{
+		LLUUIDMap temp(std::move(other));
+		swap(temp);
+		return *this;
+	}
+
+	void swap(LLUUIDMap& other) noexcept
+	{
+		std::swap(mStates, other.mStates);
+		std::swap(mSlots, other.mSlots);
+		std::swap(mCapacity, other.mCapacity);
+		std::swap(mShift, other.mShift);
+		std::swap(mSize, other.mSize);
+		std::swap(mErased, other.mErased);
+	}
+
+	iterator begin() { return iterator(this, next(0)); }
+	iterator end() { return iterator(this, mCapacity); }
+	const_iterator begin() const { return const_iterator(this, next(0)); }
+	const_iterator end() const { return const_iterator(this, mCapacity); }
+
+	size_t size() const { return mSize; }
+	bool empty() const { return ! mSize; }
+
+	iterator find(const LLUUID& key)
+	{
+		return iterator(this, lookup(key));
+	}
+
+	const_iterator find(const LLUUID& key) const
+	{
+		return const_iterator(this, lookup(key));
+	}
+
+	size_t count(const LLUUID& key) const
+	{
+		return (lookup(key) != mCapacity) ? 1 : 0;
+	}
+
+	T& operator[](const LLUUID& key)
+	{
+		return emplace(key).first->second;
+	}
+
+	/**
+	 * Construct the value from args unless key is already present, like
+	 * std::map::try_emplace(): args are left alone if it is.
+	 */
+	template <typename... ARGS>
+	std::pair<iterator, bool> emplace(const LLUUID& key, ARGS&&... args)
+	{
+		size_t index = lookup(key);
+		if (index != mCapacity)
+		{
+			return std::make_pair(iterator(this, index), false);
+		}
+
+		// keep at least one slot in eight empty, so probing stays short and
+		// a failed lookup always terminates
+		if ((mSize + mErased + 1) * 8 > mCapacity * 7)
+		{
+			// if it's mostly erased slots, rehashing at the same size will do
+			rehash((mSize + 1) * 2 > mCapacity ? mCapacity * 2 : mCapacity);
+		}
+
+		index = bucket(key);
+		while (mStates[index] == FULL)
+		{
+			index = (index + 1) & (mCapacity - 1);
+		}
+		if (mStates[index] == ERASED)
+		{
+			--mErased;
+		}
+		new (mSlots[index].mStorage) value_type(std::piecewise_construct,
+												std::forward_as_tuple(key),
+												std::forward_as_tuple(std::forward<ARGS>(args)...));
+		mStates[index] = FULL;
+		++mSize;
+		return std::make_pair(iterator(this, index), true);
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		return emplace(value.first, value.second);
+	}
+
+	std::pair<iterator, bool> insert(value_type&& value)
+	{
+		return emplace(value.first, std::move(value.second));
+	}
+
+	/// returns the iterator following the erased entry
+	iterator erase(const_iterator it)
+	{
+		size_t index = it.mIndex;
+		mSlots[index].get()->~value_type();
+		--mSize;
+		if (! mSize)
+		{
+			// nothing left to probe past
+			std::memset(mStates.get(), EMPTY, mCapacity);
+			mErased = 0;
+			return end();
+		}
+		// an empty slot can only end a probe sequence if the next slot
+		// doesn't continue it
+		if (mStates[(index + 1) & (mCapacity - 1)] == EMPTY)
+		{
+			mStates[index] = EMPTY;
+		}
+		else
+		{
+			mStates[index] = ERASED;
+			++mErased;
+		}
+		return iterator(this, next(index + 1));
+	}
+
+	iterator erase(iterator it)
+	{
+		return erase(const_iterator(it));
+	}
+
+	size_t erase(const LLUUID& key)
+	{
+		size_t index = lookup(key);
+		if (index == mCapacity)
+		{
+			return 0;
+		}
+		erase(const_iterator(this, index));
+		return 1;
+	}
+
+	/// destroys every entry but keeps the table for reuse
+	void clear()
+	{
+		destroyAll();
+		if (mCapacity)
+		{
+			std::memset(mStates.get(), EMPTY, mCapacity);
+		}
+		mSize = 0;
+		mErased = 0;
+	}
+
+	/// make room for count entries without any further rehashing
+	void reserve(size_t count)
+	{
+		size_t capacity = mCapacity ? mCapacity : MIN_CAPACITY;
+		while (count * 8 > capacity * 7)
+		{
+			capacity *= 2;
+		}
+		if (capacity != mCapacity)
+		{
+			rehash(capacity);
+		}
+	}
+
+	size_t capacity() const { return mCapacity; }
+
+private:
+	static constexpr size_t MIN_CAPACITY = 16;
+
+	size_t bucket(const LLUUID& key) const
+	{
+		// Fibonacci hashing: the multiply spreads the bits of the digest to
+		// the top, which is where we take the slot from
+		return size_t((key.getDigest64() * 0x9E3779B97F4A7C15ULL) >> mShift);
+	}
+
+	// LLUUID::operator==() is out of line; this is two compares
+	static bool equal(const LLUUID& a, const LLUUID& b)
+	{
+		return ! std::memcmp(a.mData, b.mData, UUID_BYTES);
+	}
+
+	// index of key's slot, or mCapacity
+	size_t lookup(const LLUUID& key) const
+	{
+		if (! mSize)
+		{
+			return mCapacity;
+		}
+		size_t index = bucket(key);
+		while (true)
+		{
+			U8 state = mStates[index];
+			if (state == EMPTY)
+			{
+				return mCapacity;
+			}
+			if (state == FULL && equal(mSlots[index].get()->first, key))
+			{
+				return index;
+			}
+			index = (index + 1) & (mCapacity - 1);
+		}
+	}
+
+	// first full slot at or after index, or mCapacity
+	size_t next(size_t index) const
+	{
+		while (index < mCapacity && mStates[index] != FULL)
+		{
+			++index;
+		}
+		return index;
+	}
+
+	void rehash(size_t capacity)
+	{
+		if (capacity < MIN_CAPACITY)
+		{
+			capacity = MIN_CAPACITY;
+		}
+		std::unique_ptr<U8[]> states(new U8[capacity]);
+		std::memset(states.get(), EMPTY, capacity);
+		std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+		U32 shift = 64;
+		for (size_t bits = capacity; bits > 1; bits >>= 1)
+		{
+			--shift;
+		}
+
+		std::swap(mStates, states);
+		std::swap(mSlots, slots);
+		size_t old_capacity = mCapacity;
+		mCapacity = capacity;
+		mShift = shift;
+		mErased = 0;
+
+		for (size_t i = 0; i < old_capacity; ++i)
+		{
+			if (states[i] == FULL)
+			{
+				value_type* value = slots[i].get();
+				size_t index = bucket(value->first);
+				while (mStates[index] == FULL)
+				{
+					index = (index + 1) & (mCapacity - 1);
+				}
+				new (mSlots[index].mStorage) value_type(std::move(*value));
+				mStates[index] = FULL;
+				value->~value_type();
+			}
+		}
+	}
+
+	void destroyAll()
+	{
+		if (mSize)
+		{
+			for (size_t i = 0; i < mCapacity; ++i)
+			{
+				if (mStates[i] == FULL)
+				{
+					mSlots[i].get()->~value_type();
+				}
+			}
+		}
+	}
+
+	std::unique_ptr<U8[]> mStates;
+	std::unique_ptr<Slot[]> mSlots;
+	size_t mCapacity;
+	// 64 - log2(mCapacity)
+	U32 mShift;
+	size_t mSize;
+	size_t mErased;
+};
+
+#endif /* ! defined(LL_LLUUIDMAP_H) */
@@ -0,0 +1,204 @@
+/**
+ * @file   taskgraph.cpp
+ * @date   2023-06-27
+ * @brief  Implementation for taskgraph.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "taskgraph.h"
+// STL headers
+#include <algorithm>
+// std headers
+// external library headers
+// other Linden headers
+
+namespace
+{
+    bool intersects(const std::vector<std::string>& a, const std::vector<std::string>& b)
+    {
+        for (const std::string& resource : a)
+        {
+            if (std::find(b.begin(), b.end(), resource) != b.end())
+                return true;
+        }
+        return false;
+    }
+}
+
+LL::TaskGraph::TaskGraph(const std::string& name):
+    mName(name),
+    mFinished(0)
+{
+}
+
+void LL::TaskGraph::add(const std::string& name, Affinity affinity,
+                        Resources reads, Resources writes, const Work& work)
+{
+    Task task;
+    task.mName = name;
+    task.mAffinity = affinity;
+    task.mWork = work;
+    task.mReads.assign(reads.begin(), reads.end());
+    task.mWrites.assign(writes.begin(), writes.end());
+    task.mDependencies = 0;
+    task.mPending = 0;
+
+    size_t index = mTasks.size();
+    for (Task& earlier : mTasks)
+    {
+        if (intersects(earlier.mWrites, task.mReads) ||
+            intersects(earlier.mWrites, task.mWrites) ||
+            intersects(earlier.mReads, task.mWrites))
+        {
+            earlier.mDependents.push_back(index);
+            ++task.mDependencies;
+        }
+    }
+    mTasks.push_back(task);
+}
+
+void LL::TaskGraph::run(WorkQueueBase* queue)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    if (! queue)
+    {
+        for (Task& task : mTasks)
+        {
+            task.mWork();
+        }
+        return;
+    }
+
+    std::vector<size_t> ready_any;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFinished = 0;
+        mException = nullptr;
+        mReadyMain.clear();
+        for (size_t i = 0; i < mTasks.size(); ++i)
+        {
+            Task& task = mTasks[i];
+            task.mPending = task.mDependencies;
+            if (! task.mPending)
+            {
+                if (task.mAffinity == MAIN_THREAD)
+                    mReadyMain.push_back(i);
+                else
+                    ready_any.push_back(i);
+            }
+        }
+    }
+    for (size_t task : ready_any)
+    {
+        post(queue, task);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mFinished < mTasks.size())
+    {
+        if (mReadyMain.empty())
+        {
+            // everything left is waiting on a worker
+            mCond.wait(lock);
+            continue;
+        }
+
+        // prefer declared order, the order these used to run in
+        auto next = std::min_element(mReadyMain.begin(), mReadyMain.end());
+        size_t task = *next;
+        mReadyMain.erase(next);
+        lock.unlock();
+
+        runTask(task);
+
+        ready_any.clear();
+        lock.lock();
+        finish(task, ready_any);
+        lock.unlock();
+        for (size_t ready : ready_any)
+        {
+            post(queue, ready);
+        }
+        lock.lock();
+    }
+
+    std::exception_ptr exception = mException;
+    mException = nullptr;
+    lock.unlock();
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+void LL::TaskGraph::runTask(size_t task)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    try
+    {
+        mTasks[task].mWork();
+    }
+    catch (...)
+    {
+        // finish the rest of the graph first: ANY_THREAD tasks may still be
+        // in flight
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (! mException)
+        {
+            mException = std::current_exception();
+        }
+    }
+}
+
+void LL::TaskGraph::finish(size_t task, std::vector<size_t>& ready_any)
+{
+    // mMutex locked
+    for (size_t dependent : mTasks[task].mDependents)
+    {
+        Task& next = mTasks[dependent];
+        if (! --next.mPending)
+        {
+            if (next.mAffinity == MAIN_THREAD)
+                mReadyMain.push_back(dependent);
+            else
+                ready_any.push_back(dependent);
+        }
+    }
+    ++mFinished;
+    // Notify with mMutex still locked: once run() sees the last task
+    // finished it may return, and the graph may go away.
+    mCond.notify_one();
+}
+
+void LL::TaskGraph::post(WorkQueueBase* queue, size_t task)
+{
+    bool posted = queue->post(
+        [this, queue, task]()
+        {
+            runTask(task);
+            std::vector<size_t> ready_any;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                finish(task, ready_any);
+            }
+            // anything in ready_any hasn't run yet, so run() is still
+            // waiting and this graph is still alive
+            for (size_t ready : ready_any)
+            {
+                post(queue, ready);
+            }
+        });
+    if (! posted)
+    {
+        // queue closed, e.g. during shutdown: run it on the main thread
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReadyMain.push_back(task);
+        mCond.notify_one();
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file   taskgraph.h
+ * @date   2023-06-27
+ * @brief  Run a fixed set of dependent tasks, overlapping the independent
+ *         ones on a WorkQueue.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_TASKGRAPH_H)
+#define LL_TASKGRAPH_H
+
+#include "workqueue.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace LL
+{
+
+    /**
+     * TaskGraph runs work that used to run as a fixed serial sequence, such
+     * as the phases of a frame. Declare the tasks once, in that serial
+     * order, each with the named resources it reads and writes. A task then
+     * depends on every earlier task that writes something it reads or
+     * writes, or reads something it writes, so running the graph gives the
+     * same results as running the tasks in declared order.
+     *
+     * run() executes every MAIN_THREAD task on the calling thread, in
+     * declared order as far as the dependencies allow. ANY_THREAD tasks are
+     * posted to the WorkQueue as soon as their dependencies are done, which
+     * lets them overlap with main thread tasks they don't conflict with.
+     * Without a WorkQueue, run() simply runs everything in declared order.
+     *
+     * Resource names are only compared to each other, nothing else: pick one
+     * per piece of state the tasks share, and be conservative. Forgetting a
+     * resource that an ANY_THREAD task touches is a data race.
+     */
+    class LL_COMMON_API TaskGraph
+    {
+    public:
+        using Work = std::function<void()>;
+        using Resources = std::initializer_list<const char*>;
+
+        enum Affinity { MAIN_THREAD, ANY_THREAD };
+
+        TaskGraph(const std::string& name);
+
+        /// append a task; may not be called while run() is in progress
+        void add(const std::string& name, Affinity affinity,
+                 Resources reads, Resources writes, const Work& work);
+
+        /**
+         * Run every task once and return when they have all finished. An
+         * exception thrown by an ANY_THREAD task is rethrown here, once the
+         * rest of the graph has run.
+         */
+        void run(WorkQueueBase* queue=nullptr);
+
+        size_t size() const { return mTasks.size(); }
+        const std::string& getName() const { return mName; }
+
+    private:
+        struct Task
+        {
+            std::string mName;
+            Affinity mAffinity;
+            Work mWork;
+            std::vector<std::string> mReads;
+            std::vector<std::string> mWrites;
+            std::vector<size_t> mDependents;
+            size_t mDependencies;
+            // dependencies not yet finished, during run()
+            size_t mPending;
+        };
+
+        // mark task done, collecting any dependents it made ready
+        void finish(size_t task, std::vector<size_t>& ready_any);
+        void post(WorkQueueBase* queue, size_t task);
+        void runTask(size_t task);
+
+        std::string mName;
+        std::vector<Task> mTasks;
+
+        // everything below is only used during run()
+        std::mutex mMutex;
+        std::condition_variable mCond;
+        // ready MAIN_THREAD tasks, plus ANY_THREAD tasks that couldn't be posted
+        std::vector<size_t> mReadyMain;
+        size_t mFinished;
+        std::exception_ptr mException;
+    };
+
+} // namespace LL
+
+#endif /* ! defined(LL_TASKGRAPH_H) */
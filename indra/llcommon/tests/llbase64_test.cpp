@@ -26,6 +26,7 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "linden_common.h"
 
@@ -74,4 +75,36 @@ namespace tut
 				(result == "c9+s/4xGMX3smy3HZRGkg+YTUEBwNYdi7QwaSH4OkY92xAuxhKnDhg==") );
 	}
 
+	template<> template<>
+	void base64_object::test<3>()
+	{
+		U8 blob[40] = { 115, 223, 172, 255, 140, 70, 49, 125, 236, 155, 45, 199, 101, 17, 164, 131, 230, 19, 80, 64, 112, 53, 135, 98, 237, 12, 26, 72, 126, 14, 145, 143, 118, 196, 11, 177, 132, 169, 195, 134 };
+		std::vector<U8> result = LLBase64::decode("c9+s/4xGMX3smy3HZRGkg+YTUEBwNYdi7QwaSH4OkY92xAuxhKnDhg==");
+		ensure("decode 40 bytes", result == std::vector<U8>(blob, blob + 40));
+
+		ensure("decode nothing", LLBase64::decode("").empty());
+
+		LLUUID id("526a1e07-a19d-baed-84c4-ff08a488d15e");
+		result = LLBase64::decode("UmoeB6Gduu2ExP8IpIjRXg==");
+		ensure("decode random uuid", result == std::vector<U8>(id.mData, id.mData + UUID_BYTES));
+
+		// stops at the first character outside the alphabet
+		result = LLBase64::decode("c9+s/4xGMX3smy3HZRGkg+YT\nUEBwNYdi7QwaSH4OkY92xAuxhKnDhg==");
+		ensure("decode up to a line break", result == std::vector<U8>(blob, blob + 18));
+	}
+
+	template<> template<>
+	void base64_object::test<4>()
+	{
+		// every length, so both the 12 byte blocks and the tail get used
+		std::vector<U8> data;
+		for (U32 size = 0; size < 100; ++size)
+		{
+			std::string encoded = LLBase64::encode(data.empty() ? NULL : &data[0], data.size());
+			ensure_equals("encoded size", encoded.size(), (size_t)((size + 2) / 3 * 4));
+			ensure("round trip", LLBase64::decode(encoded) == data);
+			data.push_back((U8)(size * 37 + 11));
+		}
+	}
+
 }
@@ -918,6 +918,49 @@ namespace tut
     }
 }
 
+namespace tut
+{
+    class AsyncTestRecorder : public TestRecorder
+    {
+    public:
+        virtual bool canRecordAsync() override { return true; }
+    };
+
+    template<> template<>
+    void ErrorTestObject::test<19>()
+        // async recording keeps order and is flushed by LL_ERRS
+    {
+        boost::shared_ptr<AsyncTestRecorder> async_recorder(new AsyncTestRecorder());
+        LLError::addRecorder(async_recorder);
+        LLError::setAsyncRecording(true);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            LL_INFOS() << "async " << i << LL_ENDL;
+        }
+        LLError::flushRecorders();
+        ensure_equals("async message count", async_recorder->countMessages(), 100);
+        ensure_message_count(100);
+        for (int i = 0; i < 100; ++i)
+        {
+            std::ostringstream expected;
+            expected << "async " << i;
+            ensure_ends_with("async message in order", async_recorder->message(i), expected.str());
+        }
+
+        LL_INFOS() << "before error" << LL_ENDL;
+        CATCH(LL_ERRS(), "error");
+        // no flushRecorders(), LL_ERRS has to have written everything
+        ensure("fatal callback called", fatalWasCalled);
+        ensure_equals("async messages after error", async_recorder->countMessages(), 102);
+        ensure_ends_with("before error", async_recorder->message(100), "before error");
+        ensure_ends_with("error", async_recorder->message(101), "error");
+
+        LLError::setAsyncRecording(false);
+        LLError::removeRecorder(async_recorder);
+    }
+}
+
 /* Tests left:
 	handling of classes without LOG_CLASS
 
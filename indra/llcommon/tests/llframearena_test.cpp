@@ -0,0 +1,127 @@
+/**
+ * @file   llframearena_test.cpp
+ * @date   2023-06-23
+ * @brief  Test for llframearena.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llframearena.h"
+// STL headers
+#include <thread>
+// std headers
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+	struct llframearena_data
+	{
+		llframearena_data()
+		{
+			LLFrameArena::instance().reset();
+		}
+	};
+	typedef test_group<llframearena_data> llframearena_group;
+	typedef llframearena_group::object object;
+	llframearena_group llframearenagrp("llframearena");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("reset reuses the same memory");
+		LLFrameArena& arena(LLFrameArena::instance());
+		const int* first;
+		{
+			LLFrameVector<int> ints;
+			ints.reserve(100);
+			ints.push_back(17);
+			first = ints.data();
+			ensure("used", arena.getUsed() >= 100 * sizeof(int));
+		}
+		arena.reset();
+		ensure_equals("nothing used", arena.getUsed(), 0);
+		LLFrameVector<int> ints;
+		ints.reserve(100);
+		ensure("same storage", ints.data() == first);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("freeing the last allocation gives it back");
+		LLFrameArena& arena(LLFrameArena::instance());
+		LLFrameVector<char> kept(1000);
+		size_t used = arena.getUsed();
+		{
+			LLFrameVector<char> chars(2000);
+			ensure("used", arena.getUsed() >= used + 2000);
+		}
+		ensure_equals("given back", arena.getUsed(), used);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("live allocations survive reset");
+		LLFrameArena& arena(LLFrameArena::instance());
+		LLFrameVector<int> kept(10, 5);
+		size_t used = arena.getUsed();
+		arena.reset();
+		ensure_equals("not reset", arena.getUsed(), used);
+		LLFrameVector<int> more(10, 6);
+		ensure_equals("kept intact", kept[9], 5);
+		ensure_equals("new one", more[9], 6);
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("blocks coalesce, stats report the high water mark");
+		LLFrameArena& arena(LLFrameArena::instance());
+		size_t reserved, high_water;
+		LLFrameArena::getStats(reserved, high_water);
+		{
+			LLFrameVector<char> a(100 * 1024);
+			LLFrameVector<char> b(300 * 1024);
+		}
+		arena.reset();
+		size_t after = arena.getReserved();
+		ensure("covers the frame", after >= 400 * 1024);
+		LLFrameArena::getStats(reserved, high_water);
+		ensure("high water", high_water >= 400 * 1024);
+		ensure("reserved", reserved >= arena.getReserved());
+		LLFrameArena::getStats(reserved, high_water);
+		ensure_equals("high water restarts", high_water, 0);
+
+		// the next frame of the same size fits in one block
+		LLFrameVector<char> a(100 * 1024);
+		LLFrameVector<char> b(300 * 1024);
+		ensure_equals("no growth", arena.getReserved(), after);
+	}
+
+	template<> template<>
+	void object::test<5>()
+	{
+		set_test_name("every thread has its own arena");
+		LLFrameArena* main_arena = &LLFrameArena::instance();
+		LLFrameArena* other_arena = NULL;
+		std::thread worker([&other_arena]()
+		{
+			other_arena = &LLFrameArena::instance();
+			LLFrameString str("frame string long enough to need the heap");
+			other_arena->reset();
+		});
+		worker.join();
+		ensure("different", other_arena != main_arena);
+	}
+} // namespace tut
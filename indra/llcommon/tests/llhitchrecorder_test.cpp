@@ -0,0 +1,134 @@
+/**
+ * @file   llhitchrecorder_test.cpp
+ * @date   2023-06-20
+ * @brief  Test for llhitchrecorder.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llhitchrecorder.h"
+// STL headers
+#include <fstream>
+#include <iterator>
+#include <thread>
+// std headers
+#include <stdio.h>
+// external library headers
+// other Linden headers
+#include "llfasttimer.h"
+#include "../test/lltut.h"
+
+namespace
+{
+	LLTrace::BlockTimerStatHandle FTM_HITCH_TEST_OUTER("hitch test outer");
+	LLTrace::BlockTimerStatHandle FTM_HITCH_TEST_INNER("hitch test \"inner\"");
+	LLTrace::BlockTimerStatHandle FTM_HITCH_TEST_OLD("hitch test old");
+
+	U64 now()
+	{
+		return LLTrace::BlockTimer::getCPUClockCount64();
+	}
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+	struct llhitchrecorder_data
+	{
+		llhitchrecorder_data()
+		{
+			LLHitchRecorder::setEnabled(true);
+		}
+		~llhitchrecorder_data()
+		{
+			LLHitchRecorder::setEnabled(false);
+		}
+
+		size_t count(const LLHitchRecorder::Capture& capture, const LLTrace::BlockTimerStatHandle& timer)
+		{
+			size_t found = 0;
+			for (const LLHitchRecorder::Event& event : capture.mEvents)
+			{
+				if (event.mTimer == &timer)
+				{
+					++found;
+				}
+			}
+			return found;
+		}
+	};
+	typedef test_group<llhitchrecorder_data> llhitchrecorder_group;
+	typedef llhitchrecorder_group::object object;
+	llhitchrecorder_group llhitchrecordergrp("llhitchrecorder");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("capture from two threads");
+		U64 start = now();
+		LLHitchRecorder::record(&FTM_HITCH_TEST_INNER, start, start + 1);
+		LLHitchRecorder::record(&FTM_HITCH_TEST_OUTER, start, start + 2);
+		std::thread other([start]()
+			{
+				LLHitchRecorder::record(&FTM_HITCH_TEST_INNER, start, start + 3);
+			});
+		other.join();
+
+		LLHitchRecorder::setEnabled(false);
+		LLHitchRecorder::record(&FTM_HITCH_TEST_OUTER, start, start + 4);
+
+		LLHitchRecorder::CapturePtr capture = LLHitchRecorder::capture(10.f);
+		ensure_equals("inner zones", count(*capture, FTM_HITCH_TEST_INNER), size_t(2));
+		ensure_equals("outer zones", count(*capture, FTM_HITCH_TEST_OUTER), size_t(1));
+		ensure("two threads", capture->mThreadNames.size() >= 2);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("old zones wrap out and age out");
+		U64 start = now();
+		U64 old = start - 60 * LLTrace::BlockTimer::countsPerSecond();
+		LLHitchRecorder::record(&FTM_HITCH_TEST_OLD, old, old + 1);
+		LLHitchRecorder::CapturePtr capture = LLHitchRecorder::capture(10.f);
+		ensure_equals("old zone outside the window", count(*capture, FTM_HITCH_TEST_OLD), size_t(0));
+		capture = LLHitchRecorder::capture(120.f);
+		ensure_equals("old zone inside the window", count(*capture, FTM_HITCH_TEST_OLD), size_t(1));
+
+		// more than any ring holds
+		for (U32 i = 0; i < (1 << 17); ++i)
+		{
+			LLHitchRecorder::record(&FTM_HITCH_TEST_INNER, start, start + i);
+		}
+		capture = LLHitchRecorder::capture(120.f);
+		ensure_equals("old zone wrapped out", count(*capture, FTM_HITCH_TEST_OLD), size_t(0));
+		ensure("ring is bounded", count(*capture, FTM_HITCH_TEST_INNER) < (1 << 17));
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("write trace");
+		U64 start = now();
+		LLHitchRecorder::record(&FTM_HITCH_TEST_INNER, start, start + 1);
+		LLHitchRecorder::CapturePtr capture = LLHitchRecorder::capture(10.f);
+
+		std::string filename(tmpnam(NULL));
+		ensure("written", LLHitchRecorder::writeChromeTrace(*capture, filename));
+		std::ifstream in(filename.c_str());
+		std::string trace((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		in.close();
+		remove(filename.c_str());
+
+		ensure_starts_with("json", trace, "{\"displayTimeUnit\"");
+		ensure_contains("escaped name", trace, "hitch test \\\"inner\\\"");
+		ensure_contains("main thread", trace, "\"Main\"");
+	}
+} // namespace tut
@@ -0,0 +1,104 @@
+/**
+ * @file   llinternedstring_test.cpp
+ * @date   2023-06-22
+ * @brief  Test for llinternedstring.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llinternedstring.h"
+// STL headers
+#include <thread>
+#include <unordered_map>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "stringize.h"
+#include "../test/lltut.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+	struct llinternedstring_data
+	{
+	};
+	typedef test_group<llinternedstring_data> llinternedstring_group;
+	typedef llinternedstring_group::object object;
+	llinternedstring_group llinternedstringgrp("llinternedstring");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("same string, same handle");
+		LLInternedString a("mPelvis");
+		LLInternedString b(std::string("mPel") + "vis");
+		LLInternedString c("mTorso");
+		ensure("equal", a == b);
+		ensure("same storage", &a.str() == &b.str());
+		ensure("different", a != c);
+		ensure_equals("str", b.str(), "mPelvis");
+		ensure_equals("hash", a.hash(), b.hash());
+		ensure_equals("stream", stringize(a), "mPelvis");
+
+		std::unordered_map<LLInternedString, int> map;
+		map[a] = 1;
+		map[c] = 2;
+		ensure_equals("map", map[b], 1);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("empty and find");
+		LLInternedString empty;
+		ensure("default is empty", empty.empty());
+		ensure("empty string", LLInternedString("") == empty);
+		ensure("null", LLInternedString((const char*)NULL) == empty);
+		ensure_equals("empty str", empty.str(), "");
+
+		ensure("find missing", LLInternedString::find("llinternedstring never interned").empty());
+		ensure("find doesn't add", LLInternedString::find("llinternedstring never interned").empty());
+		LLInternedString added("llinternedstring added");
+		ensure("find interned", LLInternedString::find("llinternedstring added") == added);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("intern from several threads");
+		const size_t THREADS = 4;
+		const size_t NAMES = 500;
+		std::vector<std::vector<LLInternedString> > results(THREADS);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < THREADS; ++t)
+		{
+			threads.emplace_back([&results, t, NAMES]()
+				{
+					for (size_t n = 0; n < NAMES; ++n)
+					{
+						results[t].push_back(LLInternedString(stringize("threaded ", n)));
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		for (size_t n = 0; n < NAMES; ++n)
+		{
+			for (size_t t = 1; t < THREADS; ++t)
+			{
+				ensure(stringize("name ", n, " thread ", t), results[t][n] == results[0][n]);
+			}
+			ensure_equals("value", results[0][n].str(), stringize("threaded ", n));
+		}
+	}
+} // namespace tut
@@ -0,0 +1,207 @@
+/**
+ * @file   llmpmcring_test.cpp
+ * @date   2023-06-26
+ * @brief  Test for llmpmcring and the LLThreadSafeQueue built on it.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llmpmcring.h"
+// STL headers
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+// std headers
+#include <chrono>
+// external library headers
+// other Linden headers
+#include "llthreadsafequeue.h"
+#include "../test/lltut.h"
+
+using namespace std::literals::chrono_literals; // ms suffix
+
+namespace
+{
+    typedef LLThreadSafeQueue<S32, LL::MPMCRing<S32>> RingQueue;
+
+    const S32 STRESS_THREADS = 4;
+    const S32 STRESS_ITEMS = 20000;     // per producer
+
+    // STRESS_THREADS producers and as many consumers through one queue;
+    // returns the sum of everything popped
+    S64 stress(RingQueue& queue)
+    {
+        std::atomic<S64> total(0);
+        std::vector<std::thread> consumers;
+        for (S32 c = 0; c < STRESS_THREADS; ++c)
+        {
+            consumers.emplace_back([&queue, &total]()
+            {
+                try
+                {
+                    while (true)
+                    {
+                        total += queue.pop();
+                    }
+                }
+                catch (const LLThreadSafeQueueInterrupt&)
+                {
+                }
+            });
+        }
+        std::vector<std::thread> producers;
+        for (S32 p = 0; p < STRESS_THREADS; ++p)
+        {
+            producers.emplace_back([&queue]()
+            {
+                for (S32 i = 0; i < STRESS_ITEMS; ++i)
+                {
+                    queue.push(i);
+                }
+            });
+        }
+        for (std::thread& producer : producers)
+        {
+            producer.join();
+        }
+        queue.close();
+        for (std::thread& consumer : consumers)
+        {
+            consumer.join();
+        }
+        return total;
+    }
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llmpmcring_data
+    {
+    };
+    typedef test_group<llmpmcring_data> llmpmcring_group;
+    typedef llmpmcring_group::object object;
+    llmpmcring_group llmpmcringgrp("llmpmcring");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("ring");
+        LL::MPMCRing<std::string> ring(5);
+        ensure_equals("rounded up", ring.capacity(), size_t(8));
+        ensure("empty", ring.empty());
+        std::string value;
+        ensure("nothing to pop", ! ring.tryPop(value));
+        for (S32 i = 0; i < 8; ++i)
+        {
+            ensure("push", ring.tryPush(std::to_string(i)));
+        }
+        std::string extra("extra");
+        ensure("full", ! ring.tryPush(std::move(extra)));
+        ensure_equals("not moved from", extra, "extra");
+        ensure_equals("size", ring.size(), size_t(8));
+        // go round a few times
+        for (S32 i = 0; i < 20; ++i)
+        {
+            ensure("pop", ring.tryPop(value));
+            ensure_equals("order", value, std::to_string(i));
+            ensure("push again", ring.tryPush(std::to_string(i + 8)));
+        }
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("queue past the ring size");
+        // bigger than the ring, so it has to spill
+        RingQueue queue(5000);
+        for (S32 i = 0; i < 5000; ++i)
+        {
+            queue.push(i);
+        }
+        ensure_equals("size", queue.size(), size_t(5000));
+        ensure("full", ! queue.tryPush(5000));
+        ensure("full with timeout", ! queue.tryPushFor(10ms, 5000));
+        for (S32 i = 0; i < 2500; ++i)
+        {
+            ensure_equals("first half", queue.pop(), i);
+        }
+        for (S32 i = 5000; i < 7500; ++i)
+        {
+            queue.push(i);
+        }
+        for (S32 i = 2500; i < 7500; ++i)
+        {
+            ensure_equals("in order", queue.pop(), i);
+        }
+        S32 value;
+        ensure("empty", ! queue.tryPop(value));
+        ensure("empty with timeout", ! queue.tryPopFor(10ms, value));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("close");
+        RingQueue queue;
+        queue.push(17);
+        queue.close();
+        ensure("closed", queue.isClosed());
+        ensure("can't push", ! queue.tryPush(18));
+        ensure("can't pushIfOpen", ! queue.pushIfOpen(18));
+        ensure("not drained", ! queue.done());
+        ensure_equals("drains", queue.pop(), 17);
+        ensure("drained", queue.done());
+        bool threw = false;
+        try
+        {
+            queue.pop();
+        }
+        catch (const LLThreadSafeQueueInterrupt&)
+        {
+            threw = true;
+        }
+        ensure("pop after drain", threw);
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("close wakes a blocked consumer");
+        RingQueue queue;
+        std::atomic<bool> interrupted(false);
+        std::thread consumer([&queue, &interrupted]()
+        {
+            try
+            {
+                queue.pop();
+            }
+            catch (const LLThreadSafeQueueInterrupt&)
+            {
+                interrupted = true;
+            }
+        });
+        std::this_thread::sleep_for(50ms);
+        queue.close();
+        consumer.join();
+        ensure("interrupted", interrupted);
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("contention");
+        // small capacity, so producers keep running into a full queue
+        RingQueue queue(256);
+        ensure_equals("lost items", stress(queue),
+                      S64(STRESS_THREADS) * STRESS_ITEMS * (STRESS_ITEMS - 1) / 2);
+    }
+} // namespace tut
@@ -0,0 +1,132 @@
+/**
+ * @file   llsd_test.cpp
+ * @date   2023-06-12
+ * @brief  Test for the LLSD map container.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llsd.h"
+// STL headers
+#include <map>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "stringize.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    // typical shape of a message or capability reply: a few short keys
+    const char* const KEYS[] = { "agent_id", "position", "region_id", "flags",
+                                 "name", "rotation", "scale", "type" };
+    const size_t NUM_KEYS = sizeof(KEYS) / sizeof(KEYS[0]);
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llsd_data
+    {
+    };
+    typedef test_group<llsd_data> llsd_group;
+    typedef llsd_group::object object;
+    llsd_group llsdgrp("llsd");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("map iterates in key order");
+        LLSD map;
+        std::map<std::string, LLSD> expected;
+        for (size_t k = 0; k < NUM_KEYS; ++k)
+        {
+            map[KEYS[k]] = LLSD::Integer(k);
+            expected[KEYS[k]] = LLSD::Integer(k);
+        }
+        ensure_equals("size", map.size(), expected.size());
+
+        std::map<std::string, LLSD>::const_iterator ei = expected.begin();
+        for (LLSD::map_const_iterator mi = map.beginMap(), mend = map.endMap();
+             mi != mend; ++mi, ++ei)
+        {
+            ensure_equals("key", mi->first, ei->first);
+            ensure_equals(mi->first, mi->second.asInteger(), ei->second.asInteger());
+        }
+        ensure("walked all entries", ei == expected.end());
+        ensure_equals("distance", LLSD::map_const_iterator(map.endMap()) - map.beginMap(),
+                      std::ptrdiff_t(NUM_KEYS));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("references survive inserts and erases");
+        LLSD map;
+        LLSD& first = map["m"];
+        first = "first";
+        std::vector<LLSD*> refs;
+        for (S32 i = 0; i < 100; ++i)
+        {
+            LLSD& value = map[stringize("key", i)];
+            value = i;
+            refs.push_back(&value);
+        }
+        for (S32 i = 0; i < 100; i += 2)
+        {
+            map.erase(stringize("key", i));
+        }
+        // refill the erased slots
+        for (S32 i = 0; i < 50; ++i)
+        {
+            map[stringize("new", i)] = -i;
+        }
+        ensure_equals("first", first.asString(), "first");
+        ensure("first is still the same value", &first == &map["m"]);
+        for (S32 i = 1; i < 100; i += 2)
+        {
+            ensure_equals(stringize("key", i), refs[i]->asInteger(), i);
+            ensure(stringize("key", i, " is still the same value"),
+                   refs[i] == &map[stringize("key", i)]);
+        }
+        ensure_equals("size", map.size(), size_t(1 + 50 + 50));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("insert, erase and copy on write");
+        LLSD map;
+        map.insert("a", 1);
+        map.insert("a", 2);
+        ensure_equals("insert doesn't replace", map["a"].asInteger(), 1);
+        map.erase("missing");
+        ensure_equals("erase missing key", map.size(), size_t(1));
+        ensure("has", map.has("a"));
+        ensure("hasn't", !map.has("b"));
+        const LLSD& cmap(map);
+        ensure("const ref of missing key", cmap["b"].isUndefined());
+        ensure("const ref doesn't insert", !map.has("b"));
+
+        LLSD copy(map);
+        copy["a"] = 3;
+        copy["b"] = 4;
+        ensure_equals("original untouched", map["a"].asInteger(), 1);
+        ensure("original has no b", !map.has("b"));
+        ensure_equals("copy", copy["a"].asInteger(), 3);
+
+        map.erase("a");
+        ensure_equals("empty", map.size(), size_t(0));
+        ensure("empty iteration", map.beginMap() == map.endMap());
+        const LLSD undefined;
+        ensure("undefined iteration", undefined.beginMap() == undefined.endMap());
+    }
+} // namespace tut
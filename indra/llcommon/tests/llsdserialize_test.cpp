@@ -602,6 +602,45 @@ namespace tut
 	};
 |*==========================================================================*/
 
+	template<> template<>
+	void TestLLSDSerializeObject::test<11>()
+	{
+		setFormatterParser(new LLSDBinaryFormatter(), new LLSDBinaryParser());
+		// parse the formatted bytes in place rather than from the stream
+		mParser = [](std::istream& istr, LLSD& data, llssize max_bytes)
+		{
+			std::string buffer((std::istreambuf_iterator<char>(istr)), std::istreambuf_iterator<char>());
+			return (LLSDSerialize::fromBinary(data, (const U8*)buffer.data(), buffer.size()) > 0);
+		};
+		doRoundTripTests("binary serialization from buffer");
+	}
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<12>()
+	{
+		LLSD v = LLSD::emptyMap();
+		v["name"] = "value";
+		v["list"].append(LLUUID::generateNewID());
+		v["list"].append(3.5);
+		std::stringstream stream;
+		LLSDSerialize::toBinary(v, stream);
+		std::string formatted = stream.str() + "trailing";
+		const llssize length = formatted.size() - strlen("trailing");
+
+		LLPointer<LLSDBinaryParser> parser = new LLSDBinaryParser;
+		LLSD w;
+		llssize bytes_read = 0;
+		ensure("buffer parse", parser->parseBuffer((const U8*)formatted.data(), formatted.size(), w, -1, &bytes_read) > 0);
+		ensure_equals("buffer parse result", w, v);
+		ensure_equals("stops after the object", bytes_read, length);
+
+		for (llssize truncated = 0; truncated < length; ++truncated)
+		{
+			ensure_equals("truncated buffer fails",
+						  parser->parseBuffer((const U8*)formatted.data(), truncated, w) > 0, false);
+		}
+	}
+
 	/**
 	 * @class TestLLSDParsing
 	 * @brief Base class for of a parse tester.
@@ -0,0 +1,129 @@
+/**
+ * @file lltextcodec_test.cpp
+ * @brief Tests for hex coding and escape scanning
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llstring.h"
+#include "../lltextcodec.h"
+#include "../lluuid.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct textcodec_data
+	{
+	};
+	typedef test_group<textcodec_data> textcodec_test;
+	typedef textcodec_test::object textcodec_object;
+	tut::textcodec_test textcodec("LLTextCodec");
+
+	template<> template<>
+	void textcodec_object::test<1>()
+	{
+		set_test_name("hex round trip");
+
+		// sizes on both sides of the 16 byte blocks
+		U8 bytes[40];
+		for (U32 i = 0; i < 40; ++i)
+		{
+			bytes[i] = (U8)(i * 73 + 5);
+		}
+		for (U32 size = 0; size <= 40; ++size)
+		{
+			std::string hex(2 * size, ' ');
+			ll_hex_encode(bytes, size, hex.empty() ? NULL : &hex[0]);
+			for (U32 i = 0; i < size; ++i)
+			{
+				ensure_equals("hex digits", hex.substr(2 * i, 2), llformat("%02x", bytes[i]));
+			}
+
+			LLStringUtil::toUpper(hex);
+			U8 decoded[40];
+			ensure("decode", ll_hex_decode(hex.data(), size, decoded));
+			ensure("same bytes", memcmp(bytes, decoded, size) == 0);
+		}
+	}
+
+	template<> template<>
+	void textcodec_object::test<2>()
+	{
+		set_test_name("hex rejects other characters");
+
+		// one 16 byte block and a tail of 4
+		std::string hex(40, '0');
+		U8 decoded[20];
+		for (U32 c = 0; c < 256; ++c)
+		{
+			bool digit = isxdigit(c) != 0;
+			// in a block and in the tail
+			for (U32 pos : { 5U, 35U })
+			{
+				std::string bad(hex);
+				bad[pos] = (char)c;
+				ensure_equals(llformat("character %u at %u", c, pos),
+							  ll_hex_decode(bad.data(), 20, decoded), digit);
+			}
+		}
+	}
+
+	template<> template<>
+	void textcodec_object::test<3>()
+	{
+		set_test_name("UUID strings");
+
+		LLUUID id("526a1e07-a19d-baed-84c4-ff08a488d15e");
+		ensure_equals("format", id.asString(), "526a1e07-a19d-baed-84c4-ff08a488d15e");
+		ensure_equals("upper case", LLUUID("526A1E07-A19D-BAED-84C4-FF08A488D15E"), id);
+
+		LLUUID bad;
+		ensure("bad digit", !bad.set("526a1e07-a19d-baed-84c4-ff08a488d15g", FALSE));
+		ensure("bad digit gives null", bad.isNull());
+		ensure("broken format", bad.set("526a1e07-a19d-baed-84c4ff08a488d15e", FALSE));
+		ensure_equals("broken format value", bad, id);
+	}
+
+	template<> template<>
+	void textcodec_object::test<4>()
+	{
+		set_test_name("escape scanning");
+
+		for (U32 c = 0; c < 256; ++c)
+		{
+			bool xml = c == '<' || c == '>' || c == '&' || c == '\'' || c == '"';
+			bool notation = c < ' ' || c >= 0x7F || c == '\'' || c == '\\';
+			for (U32 pos = 0; pos < 40; pos += 13)
+			{
+				std::string text(40, 'x');
+				text[pos] = (char)c;
+				ensure_equals(llformat("xml %u at %u", c, pos),
+							  ll_find_xml_escape(text.data(), text.size()), xml ? pos : text.size());
+				ensure_equals(llformat("notation %u at %u", c, pos),
+							  ll_find_notation_escape(text.data(), text.size()), notation ? pos : text.size());
+			}
+		}
+	}
+}
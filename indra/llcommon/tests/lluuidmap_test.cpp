@@ -0,0 +1,164 @@
+/**
+ * @file   lluuidmap_test.cpp
+ * @date   2023-06-28
+ * @brief  Test for lluuidmap.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lluuidmap.h"
+// STL headers
+#include <map>
+#include <string>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+
+namespace
+{
+	std::vector<LLUUID> make_ids(S32 count)
+	{
+		std::vector<LLUUID> ids(count);
+		for (LLUUID& id : ids)
+		{
+			id.generate();
+		}
+		return ids;
+	}
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+	struct lluuidmap_data
+	{
+	};
+	typedef test_group<lluuidmap_data> lluuidmap_group;
+	typedef lluuidmap_group::object object;
+	lluuidmap_group lluuidmapgrp("lluuidmap");
+
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("insert, find, erase");
+		LLUUIDMap<std::string> map;
+		ensure("empty", map.empty());
+		ensure("find in empty", map.find(LLUUID::null) == map.end());
+		ensure_equals("erase from empty", map.erase(LLUUID::null), size_t(0));
+
+		std::vector<LLUUID> ids(make_ids(1000));
+		for (const LLUUID& id : ids)
+		{
+			map[id] = id.asString();
+		}
+		ensure_equals("size", map.size(), size_t(1000));
+		ensure("not inserted twice", ! map.emplace(ids[0], "again").second);
+		ensure_equals("unchanged", map[ids[0]], ids[0].asString());
+		ensure("null absent", ! map.count(LLUUID::null));
+		for (const LLUUID& id : ids)
+		{
+			LLUUIDMap<std::string>::const_iterator it = map.find(id);
+			ensure("found", it != map.end());
+			ensure_equals("value", it->second, id.asString());
+		}
+
+		// erase every other one, then put them back
+		for (size_t i = 0; i < ids.size(); i += 2)
+		{
+			ensure_equals("erased", map.erase(ids[i]), size_t(1));
+		}
+		ensure_equals("half", map.size(), size_t(500));
+		for (size_t i = 0; i < ids.size(); ++i)
+		{
+			ensure_equals("right half left", map.count(ids[i]), size_t(i % 2));
+		}
+		for (size_t i = 0; i < ids.size(); i += 2)
+		{
+			ensure("reinserted", map.insert(std::make_pair(ids[i], ids[i].asString())).second);
+		}
+		ensure_equals("all back", map.size(), size_t(1000));
+
+		map.clear();
+		ensure("cleared", map.empty());
+		ensure("gone", map.find(ids[1]) == map.end());
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("iterate and erase");
+		LLUUIDMap<S32> map;
+		std::vector<LLUUID> ids(make_ids(500));
+		for (S32 i = 0; i < 500; ++i)
+		{
+			map[ids[i]] = i;
+		}
+		S64 sum = 0;
+		for (const auto& pair : map)
+		{
+			sum += pair.second;
+		}
+		ensure_equals("every entry once", sum, S64(500 * 499 / 2));
+
+		// the erase(it++) idiom, as used with std::map
+		for (LLUUIDMap<S32>::iterator it = map.begin(); it != map.end(); )
+		{
+			if (it->second % 3)
+			{
+				map.erase(it++);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		ensure_equals("multiples of 3", map.size(), size_t(167));
+		for (const auto& pair : map)
+		{
+			ensure_equals("kept", pair.second % 3, 0);
+		}
+
+		// copies are independent
+		LLUUIDMap<S32> copy(map);
+		map.clear();
+		ensure_equals("copy", copy.size(), size_t(167));
+		ensure_equals("copy value", copy[ids[3]], 3);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("agrees with std::map");
+		std::vector<LLUUID> ids(make_ids(2000));
+		LLUUIDMap<S32> uuid_map;
+		std::map<LLUUID, S32> std_map;
+		for (S32 i = 0; i < 2000; ++i)
+		{
+			uuid_map[ids[i]] = i;
+			std_map[ids[i]] = i;
+		}
+		// half hits, half misses
+		std::vector<LLUUID> lookups(ids.begin(), ids.begin() + 1000);
+		std::vector<LLUUID> misses(make_ids(1000));
+		lookups.insert(lookups.end(), misses.begin(), misses.end());
+		for (const LLUUID& id : lookups)
+		{
+			auto std_it = std_map.find(id);
+			auto uuid_it = uuid_map.find(id);
+			ensure_equals("found", uuid_it != uuid_map.end(), std_it != std_map.end());
+			if (std_it != std_map.end())
+			{
+				ensure_equals("value", uuid_it->second, std_it->second);
+			}
+		}
+	}
+} // namespace tut
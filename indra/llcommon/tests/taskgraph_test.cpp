@@ -0,0 +1,157 @@
+/**
+ * @file   taskgraph_test.cpp
+ * @date   2023-06-27
+ * @brief  Test for taskgraph.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "taskgraph.h"
+// STL headers
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+
+using namespace LL;
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct taskgraph_data
+    {
+        // record of what ran, in order
+        std::mutex mutex;
+        std::vector<std::string> log;
+
+        TaskGraph::Work record(const std::string& name)
+        {
+            return [this, name]()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                log.push_back(name);
+            };
+        }
+
+        size_t position(const std::string& name)
+        {
+            return std::find(log.begin(), log.end(), name) - log.begin();
+        }
+    };
+    typedef test_group<taskgraph_data> taskgraph_group;
+    typedef taskgraph_group::object object;
+    taskgraph_group taskgraphgrp("taskgraph");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("serial without a queue");
+        TaskGraph graph("serial");
+        graph.add("a", TaskGraph::ANY_THREAD, {}, { "x" }, record("a"));
+        graph.add("b", TaskGraph::MAIN_THREAD, {}, { "y" }, record("b"));
+        graph.add("c", TaskGraph::ANY_THREAD, { "x" }, {}, record("c"));
+        ensure_equals("size", graph.size(), size_t(3));
+        graph.run();
+        ensure_equals("count", log.size(), size_t(3));
+        ensure_equals("a", log[0], "a");
+        ensure_equals("b", log[1], "b");
+        ensure_equals("c", log[2], "c");
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("overlap on a worker, respecting dependencies");
+        WorkQueue queue("taskgraph");
+        std::thread worker([&queue](){ queue.runUntilClose(); });
+
+        std::thread::id main_id = std::this_thread::get_id();
+        std::atomic<bool> worker_ran(false);
+        std::atomic<bool> overlapped(false);
+        std::atomic<bool> slow_done(false);
+
+        TaskGraph graph("overlap");
+        graph.add("setup", TaskGraph::MAIN_THREAD, {}, { "data" }, record("setup"));
+        graph.add("slow", TaskGraph::ANY_THREAD, { "data" }, { "result" },
+                  [&]()
+                  {
+                      worker_ran = (std::this_thread::get_id() != main_id);
+                      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                      record("slow")();
+                      slow_done = true;
+                  });
+        // independent of "slow": runs on the main thread meanwhile
+        graph.add("other", TaskGraph::MAIN_THREAD, {}, { "unrelated" },
+                  [&]()
+                  {
+                      overlapped = ! slow_done;
+                      record("other")();
+                  });
+        // needs "slow"
+        graph.add("use", TaskGraph::MAIN_THREAD, { "result" }, {}, record("use"));
+        // writes what "slow" reads
+        graph.add("change", TaskGraph::MAIN_THREAD, {}, { "data" }, record("change"));
+
+        for (S32 i = 0; i < 2; ++i)
+        {
+            log.clear();
+            graph.run(&queue);
+            ensure_equals("count", log.size(), size_t(5));
+            ensure("on a worker", worker_ran);
+            ensure("overlapped", overlapped);
+            ensure("setup first", position("setup") < position("slow"));
+            ensure("use after", position("slow") < position("use"));
+            ensure("change after", position("slow") < position("change"));
+            slow_done = false;
+        }
+
+        queue.close();
+        worker.join();
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("exceptions");
+        WorkQueue queue("taskgraph");
+        std::thread worker([&queue](){ queue.runUntilClose(); });
+
+        TaskGraph graph("exceptions");
+        graph.add("throws", TaskGraph::ANY_THREAD, {}, { "x" },
+                  [](){ throw std::runtime_error("from the worker"); });
+        graph.add("after", TaskGraph::MAIN_THREAD, { "x" }, {}, record("after"));
+        std::string what;
+        try
+        {
+            graph.run(&queue);
+        }
+        catch (const std::runtime_error& e)
+        {
+            what = e.what();
+        }
+        ensure_equals("rethrown", what, "from the worker");
+        ensure_equals("rest still ran", log.size(), size_t(1));
+
+        queue.close();
+        worker.join();
+
+        // a closed queue: everything falls back to the main thread
+        log.clear();
+        TaskGraph fallback("fallback");
+        fallback.add("a", TaskGraph::ANY_THREAD, {}, {}, record("a"));
+        fallback.run(&queue);
+        ensure_equals("ran anyway", log.size(), size_t(1));
+    }
+} // namespace tut
@@ -21,6 +21,8 @@
 #include LLCOROS_MUTEX_HEADER
 #include "llerror.h"
 #include "llexception.h"
+#include "llframearena.h"
+#include "llthread.h"
 #include "stringize.h"
 
 using Mutex = LLCoros::Mutex;
@@ -115,6 +117,13 @@ void LL::WorkQueueBase::callWork(const Work& work)
         // thread must go on! Log our own instance name with the exception.
         LOG_UNHANDLED_EXCEPTION(getKey());
     }
+    // A work item is a worker thread's frame. The main thread resets its
+    // arena at the end of LLAppViewer::doFrame() instead, since the work it
+    // runs is nested inside the frame.
+    if (! on_main_thread())
+    {
+        LLFrameArena::instance().reset();
+    }
 }
 
 void LL::WorkQueueBase::error(const std::string& msg)
@@ -255,7 +255,9 @@ namespace LL
         bool tryPost(const Work&) override;
 
     private:
-        using Queue = LLThreadSafeQueue<Work>;
+        // Thread pools post work from the main thread at a high rate: keep
+        // those posts from contending with the workers for a lock.
+        using Queue = LLThreadSafeQueue<Work, LL::MPMCRing<Work>>;
         Queue mQueue;
 
         Work pop_() override;
@@ -0,0 +1,206 @@
+/**
+ * @file _httpcache.cpp
+ * @brief Definitions for the response cache entries
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "_httpcache.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "llstring.h"
+
+
+namespace
+{
+
+// Stored form is a line with this tag, one line per field
+// and per saved header, an empty line and the body.
+const std::string ENTRY_TAG("LLCORE-HTTP-CACHE 1");
+
+const char FIELD_EXPIRES('E');
+const char FIELD_ETAG('T');
+const char FIELD_LAST_MODIFIED('M');
+const char FIELD_CONTENT_TYPE('C');
+const char FIELD_HEADER('H');
+
+void append_field(std::string & data, char field, const std::string & value)
+{
+	data += field;
+	data += ' ';
+	data += value;
+	data += '\n';
+}
+
+} // end anonymous namespace
+
+
+namespace LLCore
+{
+
+
+HttpCacheEntry::HttpCacheEntry()
+	: mExpires(0)
+{}
+
+
+bool HttpCacheEntry::parse(const std::string & data)
+{
+	size_t pos(data.find('\n'));
+	if (std::string::npos == pos || data.compare(0, pos, ENTRY_TAG))
+	{
+		return false;
+	}
+	++pos;
+
+	while (pos < data.size())
+	{
+		size_t end(data.find('\n', pos));
+		if (std::string::npos == end)
+		{
+			return false;
+		}
+		if (end == pos)
+		{
+			// Blank line, the body follows
+			mBody.assign(data, end + 1, std::string::npos);
+			return true;
+		}
+		if (end - pos < 2)
+		{
+			return false;
+		}
+
+		const std::string value(data, pos + 2, end - pos - 2);
+		switch (data[pos])
+		{
+		case FIELD_EXPIRES:
+			mExpires = time_t(strtoll(value.c_str(), NULL, 10));
+			break;
+
+		case FIELD_ETAG:
+			mETag = value;
+			break;
+
+		case FIELD_LAST_MODIFIED:
+			mLastModified = value;
+			break;
+
+		case FIELD_CONTENT_TYPE:
+			mContentType = value;
+			break;
+
+		case FIELD_HEADER:
+			{
+				const size_t colon(value.find(':'));
+				if (! mHeaders)
+				{
+					mHeaders = HttpHeaders::ptr_t(new HttpHeaders);
+				}
+				mHeaders->append(value.substr(0, colon),
+								 std::string::npos == colon ? std::string() : value.substr(colon + 1));
+			}
+			break;
+
+		default:
+			// Unknown fields from a later format are skipped
+			break;
+		}
+		pos = end + 1;
+	}
+
+	return false;
+}
+
+
+void HttpCacheEntry::serialize(std::string & data) const
+{
+	data.clear();
+	data.reserve(mBody.size() + 256);
+	data += ENTRY_TAG;
+	data += '\n';
+	append_field(data, FIELD_EXPIRES, std::to_string((long long) mExpires));
+	if (! mETag.empty())
+	{
+		append_field(data, FIELD_ETAG, mETag);
+	}
+	if (! mLastModified.empty())
+	{
+		append_field(data, FIELD_LAST_MODIFIED, mLastModified);
+	}
+	if (! mContentType.empty())
+	{
+		append_field(data, FIELD_CONTENT_TYPE, mContentType);
+	}
+	if (mHeaders)
+	{
+		// Names never hold a colon and the header callback
+		// strips line ends so this splits back unambiguously.
+		for (HttpHeaders::const_iterator it(mHeaders->begin()); mHeaders->end() != it; ++it)
+		{
+			append_field(data, FIELD_HEADER, it->first + ":" + it->second);
+		}
+	}
+	data += '\n';
+	data += mBody;
+}
+
+
+long parse_cache_control(const std::string & value, bool & no_store)
+{
+	long max_age(-1L);
+	bool no_cache(false);
+
+	size_t pos(0);
+	while (pos < value.size())
+	{
+		size_t end(value.find(',', pos));
+		if (std::string::npos == end)
+		{
+			end = value.size();
+		}
+		std::string directive(value, pos, end - pos);
+		LLStringUtil::trim(directive);
+		LLStringUtil::toLower(directive);
+		pos = end + 1;
+
+		if ("no-store" == directive)
+		{
+			no_store = true;
+		}
+		else if ("no-cache" == directive)
+		{
+			no_cache = true;
+		}
+		else if (! directive.compare(0, 8, "max-age="))
+		{
+			max_age = (std::max)(0L, strtol(directive.c_str() + 8, NULL, 10));
+		}
+	}
+
+	return no_cache ? 0L : max_age;
+}
+
+
+}  // end namespace LLCore
@@ -0,0 +1,94 @@
+/**
+ * @file _httpcache.h
+ * @brief Internal declarations for the response cache entries
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef	_LLCORE_HTTP_CACHE_ENTRY_H_
+#define	_LLCORE_HTTP_CACHE_ENTRY_H_
+
+
+#include <ctime>
+#include <string>
+
+#include "httpheaders.h"
+
+
+namespace LLCore
+{
+
+
+/// HttpCacheEntry is one cached GET response as kept in an
+/// HttpCacheStore:  the body, the headers a caller may ask for
+/// and what is needed to decide when and how to revalidate it.
+///
+/// Freshness comes from Cache-Control max-age only.  Responses
+/// without it are stored when they carry a validator and are
+/// revalidated with a conditional request on every use, which
+/// still saves the body when the server answers 304.
+///
+/// Threading:  Worker thread only.
+class HttpCacheEntry
+{
+public:
+	HttpCacheEntry();
+
+	/// Fill in from the stored form, @return false if data
+	/// isn't a complete entry.
+	bool parse(const std::string & data);
+
+	/// Write out the stored form.
+	void serialize(std::string & data) const;
+
+	bool isFresh(time_t now) const
+	{
+		return now < mExpires;
+	}
+
+	/// A conditional request needs at least one validator.
+	bool canRevalidate() const
+	{
+		return ! mETag.empty() || ! mLastModified.empty();
+	}
+
+public:
+	time_t				mExpires;
+	std::string			mETag;
+	std::string			mLastModified;
+	std::string			mContentType;
+	HttpHeaders::ptr_t	mHeaders;		// May be NULL
+	std::string			mBody;
+};  // end class HttpCacheEntry
+
+
+/// Parse a Cache-Control header value.
+///
+/// @return			max-age in seconds, 0 if the response has
+///					to be revalidated before each use and -1 if
+///					neither was given.  no_store is set when the
+///					response may not be stored at all.
+long parse_cache_control(const std::string & value, bool & no_store);
+
+}  // end namespace LLCore
+
+#endif	// _LLCORE_HTTP_CACHE_ENTRY_H_
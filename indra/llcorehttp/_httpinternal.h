@@ -153,6 +153,19 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 multiplexing limits.  The maximum is the common
+// server SETTINGS_MAX_CONCURRENT_STREAMS value.
+const long HTTP_HTTP2_STREAMS_DEFAULT = 0L;
+const long HTTP_HTTP2_STREAMS_MAX = 100L;
+
+// Largest reply body reserved up front from the Content-Length
+// so that it arrives in a single, contiguous block.  Larger
+// bodies are gathered in regular blocks.
+const double HTTP_REPLY_RESERVE_MAX = 16.0 * 1024.0 * 1024.0;
+
+// Largest reply body kept in the response cache.
+const size_t HTTP_CACHE_ENTRY_MAX = 4 * 1024 * 1024;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
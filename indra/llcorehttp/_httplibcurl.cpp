@@ -60,6 +60,7 @@ namespace LLCore
 
 HttpLibcurl::HttpLibcurl(HttpService * service)
 	: mService(service),
+	  mShareHandle(),
 	  mHandleCache(),
 	  mPolicyCount(0),
 	  mMultiHandles(NULL),
@@ -487,7 +488,26 @@ void HttpLibcurl::policyUpdated(int policy_class)
 		policy.stallPolicy(policy_class, false);
 		mDirtyPolicy[policy_class] = false;
 
-		if (options.mPipelining > 1)
+		if (options.mHttp2Streams > 1)
+		{
+			// HTTP/2 streams multiplexed on as few connections as
+			// the per-host limit allows
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_PIPELINING,
+									 long(CURLPIPE_MULTIPLEX));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_HOST_CONNECTIONS,
+									 long(options.mPerHostConnectionLimit));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+									 long(options.mConnectionLimit));
+#if LIBCURL_VERSION_NUM >= 0x074300
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_CONCURRENT_STREAMS,
+									 long(options.mHttp2Streams));
+#endif
+		}
+		else if (options.mPipelining > 1)
 		{
 			// We'll try to do pipelining on this multihandle
 			check_curl_multi_setopt(multi_handle,
@@ -528,6 +548,63 @@ void HttpLibcurl::policyUpdated(int policy_class)
 	}
 }
 
+// ---------------------------------------
+// HttpLibcurl::ShareHandle
+// ---------------------------------------
+
+
+HttpLibcurl::ShareHandle::ShareHandle()
+	: mShare(curl_share_init())
+{
+	if (! mShare)
+	{
+		LL_WARNS(LOG_CORE) << "Unable to create libcurl share handle, connections won't share sessions."
+						   << LL_ENDL;
+		return;
+	}
+
+	curl_share_setopt(mShare, CURLSHOPT_LOCKFUNC, lockCallback);
+	curl_share_setopt(mShare, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+	curl_share_setopt(mShare, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+
+HttpLibcurl::ShareHandle::~ShareHandle()
+{
+	if (mShare)
+	{
+		CURLSHcode code(curl_share_cleanup(mShare));
+		if (CURLSHE_OK != code)
+		{
+			LL_WARNS(LOG_CORE) << "libcurl share handle still in use at shutdown, code:  "
+							   << code << LL_ENDL;
+		}
+		mShare = NULL;
+	}
+}
+
+
+void HttpLibcurl::ShareHandle::lockCallback(CURL *, curl_lock_data data,
+											 curl_lock_access, void * userptr)
+{
+	if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+	{
+		static_cast<ShareHandle *>(userptr)->mMutex[data].lock();
+	}
+}
+
+
+void HttpLibcurl::ShareHandle::unlockCallback(CURL *, curl_lock_data data, void * userptr)
+{
+	if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+	{
+		static_cast<ShareHandle *>(userptr)->mMutex[data].unlock();
+	}
+}
+
+
 // ---------------------------------------
 // HttpLibcurl::HandleCache
 // ---------------------------------------
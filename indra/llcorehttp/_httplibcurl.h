@@ -37,6 +37,7 @@
 #include "httprequest.h"
 #include "_httpservice.h"
 #include "_httpinternal.h"
+#include "_mutex.h"
 
 
 namespace LLCore
@@ -143,6 +144,16 @@ public:
 			return mHandleCache.getHandle();
 		}
 
+	/// Share handle attached to every request so that DNS
+	/// lookups and TLS sessions are reused across handles and
+	/// policy classes.  May be NULL if libcurl couldn't create it.
+	///
+	/// Threading:  called by worker thread.
+	CURLSH * getShareHandle() const
+		{
+			return mShareHandle.mShare;
+		}
+
 protected:
 	/// Invoked when libcurl has indicated a request has been processed
 	/// to completion and we need to move the request to a new state.
@@ -206,9 +217,39 @@ protected:
 		CURL *				mHandleTemplate;		// Template for duplicating new handles
 		handle_cache_t		mCache;					// Cache of old handles
 	}; // end class HandleCache
+
+	/// Owner of the libcurl share handle.
+	///
+	/// Easy handles hold on to their share and may be freed with
+	/// curl_easy_cleanup() outside of the worker thread so access
+	/// is serialized with one mutex per kind of shared data.
+	/// Must outlive every handle from the HandleCache.
+
+	class ShareHandle
+	{
+	public:
+		ShareHandle();
+		~ShareHandle();
+
+	private:
+		ShareHandle(const ShareHandle &);				// Not defined
+		void operator=(const ShareHandle &);			// Not defined
+
+	protected:
+		static void lockCallback(CURL * handle, curl_lock_data data,
+								 curl_lock_access access, void * userptr);
+		static void unlockCallback(CURL * handle, curl_lock_data data, void * userptr);
+
+	public:
+		CURLSH *				mShare;
+		
+	protected:
+		LLCoreInt::HttpMutex	mMutex[CURL_LOCK_DATA_LAST];
+	}; // end class ShareHandle
 	
 protected:
 	HttpService *		mService;			// Simple reference, not owner
+	ShareHandle			mShareHandle;		// Shared DNS and TLS session data, owner
 	HandleCache			mHandleCache;		// Handle allocator, owner
 	active_set_t		mActiveOps;
 	int					mPolicyCount;
@@ -27,6 +27,7 @@
 #include "_httpoprequest.h"
 
 #include <cstdio>
+#include <ctime>
 #include <algorithm>
 
 #include "httpcommon.h"
@@ -41,6 +42,7 @@
 #include "_httpservice.h"
 #include "_httppolicy.h"
 #include "_httppolicyglobal.h"
+#include "_httppolicyclass.h"
 #include "_httplibcurl.h"
 #include "_httpinternal.h"
 
@@ -150,10 +152,13 @@ HttpOpRequest::HttpOpRequest()
 	  mPolicyRetries(0),
 	  mPolicy503Retries(0),
 	  mPolicyRetryAt(HttpTime(0)),
+	  mPolicyActiveAt(HttpTime(0)),
 	  mPolicyRetryLimit(HTTP_RETRY_COUNT_DEFAULT),
 	  mPolicyMinRetryBackoff(HttpTime(HTTP_RETRY_BACKOFF_MIN_DEFAULT)),
 	  mPolicyMaxRetryBackoff(HttpTime(HTTP_RETRY_BACKOFF_MAX_DEFAULT)),
-	  mCallbackSSLVerify(NULL)
+	  mCallbackSSLVerify(NULL),
+	  mReplyMaxAge(-1L),
+	  mReplyNoStore(false)
 {
 	// *NOTE:  As members are added, retry initialization/cleanup
 	// may need to be extended in @see prepareRequest().
@@ -201,6 +206,12 @@ HttpOpRequest::~HttpOpRequest()
 void HttpOpRequest::stageFromRequest(HttpService * service)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	if (lookupCache(service))
+	{
+		// Answered without going to policy or transport
+		return;
+	}
+
     HttpOpRequest::ptr_t self(boost::dynamic_pointer_cast<HttpOpRequest>(shared_from_this()));
     service->getPolicy().addOp(self);			// transfers refcount
 }
@@ -210,6 +221,7 @@ void HttpOpRequest::stageFromReady(HttpService * service)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
     HttpOpRequest::ptr_t self(boost::dynamic_pointer_cast<HttpOpRequest>(shared_from_this()));
+	mPolicyActiveAt = totalTime();
     service->getTransport().addOp(self);		// transfers refcount
 }
 
@@ -294,6 +306,142 @@ void HttpOpRequest::visitNotifier(HttpRequest * request)
 // }
 
 
+bool HttpOpRequest::lookupCache(HttpService * service)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	HttpPolicyGlobal & gpolicy(service->getPolicy().getGlobalOptions());
+	if (! gpolicy.mCacheStore
+		|| HOR_GET != mReqMethod
+		|| mReqOffset
+		|| mReqLength
+		|| (mReqOptions && mReqOptions->getHeadersOnly())
+		|| ! service->getPolicy().getClassOptions(mReqPolicy).mResponseCache)
+	{
+		return false;
+	}
+
+	mCacheStore = gpolicy.mCacheStore;
+	mProcFlags |= PF_SCAN_CACHE_HEADERS;
+
+	std::string data;
+	std::unique_ptr<HttpCacheEntry> entry(new HttpCacheEntry);
+	if (! mCacheStore->read(mReqURL, data) || ! entry->parse(data))
+	{
+		return false;
+	}
+
+	if (entry->isFresh(time(NULL)))
+	{
+		if (mTracing > HTTP_TRACE_OFF)
+		{
+			LL_INFOS(LOG_CORE) << "TRACE, FromCache, Handle:  "
+							   << getHandle()
+							   << LL_ENDL;
+		}
+		replyFromCache(*entry);
+		addAsReply();
+		return true;
+	}
+
+	if (entry->canRevalidate())
+	{
+		mCacheEntry = std::move(entry);
+	}
+	return false;
+}
+
+
+void HttpOpRequest::replyFromCache(const HttpCacheEntry & entry)
+{
+	mStatus = HttpStatus(HTTP_OK);
+	if (mReplyBody)
+	{
+		mReplyBody->release();
+	}
+	mReplyBody = new BufferArray();
+	mReplyBody->append(entry.mBody.data(), entry.mBody.size());
+	mReplyConType = entry.mContentType;
+	if (mProcFlags & PF_SAVE_HEADERS)
+	{
+		mReplyHeaders = entry.mHeaders ? entry.mHeaders : HttpHeaders::ptr_t(new HttpHeaders);
+	}
+}
+
+
+void HttpOpRequest::updateCache()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	if (! mCacheStore)
+	{
+		return;
+	}
+
+	const time_t now(time(NULL));
+	const time_t max_age(mReplyMaxAge > 0L ? time_t(mReplyMaxAge) : time_t(0));
+	if (mCacheEntry && mStatus == HttpStatus(HTTP_NOT_MODIFIED))
+	{
+		// What we have is still good.  Answer with it and
+		// keep it under the validators and age just received.
+		if (! mReplyETag.empty())
+		{
+			mCacheEntry->mETag = mReplyETag;
+		}
+		if (! mReplyLastModified.empty())
+		{
+			mCacheEntry->mLastModified = mReplyLastModified;
+		}
+		mCacheEntry->mExpires = now + max_age;
+		replyFromCache(*mCacheEntry);
+
+		if (mReplyNoStore)
+		{
+			mCacheStore->remove(mReqURL);
+		}
+		else
+		{
+			std::string data;
+			mCacheEntry->serialize(data);
+			mCacheStore->write(mReqURL, data);
+		}
+	}
+	else if (mStatus == HttpStatus(HTTP_OK))
+	{
+		const size_t body_size(mReplyBody ? mReplyBody->size() : 0);
+		HttpCacheEntry entry;
+		entry.mExpires = now + max_age;
+		entry.mETag = mReplyETag;
+		entry.mLastModified = mReplyLastModified;
+		if (mReplyNoStore
+			|| body_size > HTTP_CACHE_ENTRY_MAX
+			|| (! max_age && ! entry.canRevalidate()))
+		{
+			// Nothing to gain from keeping this one, and an
+			// older entry would only be revalidated in vain.
+			if (mCacheEntry)
+			{
+				mCacheStore->remove(mReqURL);
+			}
+		}
+		else
+		{
+			entry.mContentType = mReplyConType;
+			entry.mHeaders = mReplyHeaders;
+			entry.mBody.resize(body_size);
+			if (body_size)
+			{
+				mReplyBody->read(0, &entry.mBody[0], body_size);
+			}
+
+			std::string data;
+			entry.serialize(data);
+			mCacheStore->write(mReqURL, data);
+		}
+	}
+
+	mCacheEntry.reset();
+}
+
+
 HttpStatus HttpOpRequest::cancel()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
@@ -318,6 +466,21 @@ HttpStatus HttpOpRequest::setupGet(HttpRequest::policy_t policy_id,
 }
 
 
+HttpStatus HttpOpRequest::setupPreconnect(HttpRequest::policy_t policy_id,
+										  const std::string & url)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	HttpOptions::ptr_t options(new HttpOptions);
+	options->setHeadersOnly(true);
+	options->setRetries(0);
+	setupCommon(policy_id, url, NULL, options, HttpHeaders::ptr_t());
+	mReqMethod = HOR_GET;
+	mProcFlags |= PF_PRECONNECT;
+	
+	return HttpStatus();
+}
+
+
 HttpStatus HttpOpRequest::setupGetByteRange(HttpRequest::policy_t policy_id,
 											const std::string & url,
 											size_t offset,
@@ -491,6 +654,10 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	mReplyFullLength = 0;
     mReplyHeaders.reset();
 	mReplyConType.clear();
+	mReplyETag.clear();
+	mReplyLastModified.clear();
+	mReplyMaxAge = -1L;
+	mReplyNoStore = false;
 	
 	// *FIXME:  better error handling later
 	HttpStatus status;
@@ -526,6 +693,9 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 
 	check_curl_easy_setopt(mCurlHandle, CURLOPT_COOKIEFILE, "");
 
+	// DNS entries and TLS sessions shared by all handles
+	check_curl_easy_setopt(mCurlHandle, CURLOPT_SHARE, service->getTransport().getShareHandle());
+
 	if (gpolicy.mSslCtxCallback)
 	{
 		check_curl_easy_setopt(mCurlHandle, CURLOPT_SSL_CTX_FUNCTION, curlSslCtxCallback);
@@ -695,6 +865,21 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 
 	mCurlHeaders = curl_slist_append(mCurlHeaders, "Pragma:");
 
+	// Revalidating a stale cached response
+	if (mCacheEntry)
+	{
+		if (! mCacheEntry->mETag.empty())
+		{
+			const std::string line("If-None-Match: " + mCacheEntry->mETag);
+			mCurlHeaders = curl_slist_append(mCurlHeaders, line.c_str());
+		}
+		if (! mCacheEntry->mLastModified.empty())
+		{
+			const std::string line("If-Modified-Since: " + mCacheEntry->mLastModified);
+			mCurlHeaders = curl_slist_append(mCurlHeaders, line.c_str());
+		}
+	}
+
 	// Request options
 	long timeout(HTTP_REQUEST_TIMEOUT_DEFAULT);
 	long xfer_timeout(HTTP_REQUEST_XFER_TIMEOUT_DEFAULT);
@@ -709,7 +894,17 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	{
 		xfer_timeout = timeout;
 	}
-	if (cpolicy.mPipelining > 1L)
+	if (cpolicy.mHttp2Streams > 1L)
+	{
+		// Ask for HTTP/2 on TLS connections, falling back to HTTP/1.1
+		// when the server doesn't offer it.  Streams don't queue behind
+		// one another the way pipelined requests do so the timeouts
+		// are left alone.  PIPEWAIT has the transfer wait briefly for a
+		// connection it can multiplex on rather than opening another.
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+	}
+	else if (cpolicy.mPipelining > 1L)
 	{
 		// Pipelining affects both connection and transfer timeout values.
 		// Requests that are added to a pipeling immediately have completed
@@ -762,7 +957,7 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	}
 	check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTPHEADER, mCurlHeaders);
 
-	if (mProcFlags & (PF_SCAN_RANGE_HEADER | PF_SAVE_HEADERS | PF_USE_RETRY_AFTER))
+	if (mProcFlags & (PF_SCAN_RANGE_HEADER | PF_SAVE_HEADERS | PF_USE_RETRY_AFTER | PF_SCAN_CACHE_HEADERS))
 	{
 		check_curl_easy_setopt(mCurlHandle, CURLOPT_HEADERFUNCTION, headerCallback);
 		check_curl_easy_setopt(mCurlHandle, CURLOPT_HEADERDATA, this);
@@ -784,6 +979,16 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
 	if (! op->mReplyBody)
 	{
 		op->mReplyBody = new BufferArray();
+
+		// When the length is known, receive the body into a single
+		// block that consumers can use in place or take over.
+		double content_length(-1.0);
+		if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &content_length)
+			&& content_length > 0.0
+			&& content_length <= HTTP_REPLY_RESERVE_MAX)
+		{
+			op->mReplyBody->reserve(size_t(content_length));
+		}
 	}
 	const size_t req_size(size * nmemb);
 	const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
@@ -863,6 +1068,9 @@ size_t HttpOpRequest::headerCallback(void * data, size_t size, size_t nmemb, voi
 	static const size_t status_line_len = sizeof(status_line) - 1;
 	static const char con_ran_line[] = "content-range";
 	static const char con_retry_line[] = "retry-after";
+	static const char etag_line[] = "etag";
+	static const char last_mod_line[] = "last-modified";
+	static const char cache_ctl_line[] = "cache-control";
 	
     HttpOpRequest::ptr_t op(HttpOpRequest::fromHandle<HttpOpRequest>(userdata));
 
@@ -878,6 +1086,10 @@ size_t HttpOpRequest::headerCallback(void * data, size_t size, size_t nmemb, voi
 		op->mReplyLength = 0;
 		op->mReplyFullLength = 0;
 		op->mReplyRetryAfter = 0;
+		op->mReplyETag.clear();
+		op->mReplyLastModified.clear();
+		op->mReplyMaxAge = -1L;
+		op->mReplyNoStore = false;
 		op->mStatus = HttpStatus();
 		if (op->mReplyHeaders)
 		{
@@ -955,6 +1167,29 @@ size_t HttpOpRequest::headerCallback(void * data, size_t size, size_t nmemb, voi
 		op->mReplyHeaders->append(name, value ? value : "");
 	}
 
+	// Validators and freshness for the response cache
+	if (is_header
+		&& op->mProcFlags & PF_SCAN_CACHE_HEADERS
+		&& value && *value)
+	{
+		if (! strcmp(name, etag_line))
+		{
+			op->mReplyETag = value;
+		}
+		else if (! strcmp(name, last_mod_line))
+		{
+			op->mReplyLastModified = value;
+		}
+		else if (! strcmp(name, cache_ctl_line))
+		{
+			const long max_age(parse_cache_control(value, op->mReplyNoStore));
+			if (max_age >= 0L)
+			{
+				op->mReplyMaxAge = max_age;
+			}
+		}
+	}
+
 	// From this point, header-specific processors are free to
 	// modify the header value.
 	
@@ -30,6 +30,7 @@
 
 #include "linden_common.h"		// Modifies curl/curl.h interfaces
 
+#include <memory>
 #include <string>
 #include <curl/curl.h>
 
@@ -38,6 +39,7 @@
 
 #include "httpcommon.h"
 #include "httprequest.h"
+#include "_httpcache.h"
 #include "_httpoperation.h"
 #include "_refcounted.h"
 
@@ -109,6 +111,9 @@ public:
 						const HttpOptions::ptr_t & options,
 						const HttpHeaders::ptr_t & headers);
 	
+	HttpStatus setupPreconnect(HttpRequest::policy_t policy_id,
+							   const std::string & url);
+
 	HttpStatus setupGetByteRange(HttpRequest::policy_t policy_id,
 								 const std::string & url,
 								 size_t offset,
@@ -156,8 +161,22 @@ public:
 	//
 	HttpStatus prepareRequest(HttpService * service);
 	
+	// Response cache upkeep for a finished request.  A 304
+	// answer to a revalidation becomes the cached response,
+	// a cacheable 200 answer is stored.
+	//
+	// Threading:  called by worker thread
+	//
+	void updateCache();
+
 	virtual HttpStatus cancel();
 
+	// Only there to warm up a connection, @see HttpRequest::requestPreconnect()
+	bool isPreconnect() const
+		{
+			return 0 != (mProcFlags & PF_PRECONNECT);
+		}
+
 protected:
 	// Common setup for all the request methods.
 	//
@@ -169,6 +188,15 @@ protected:
                      const HttpOptions::ptr_t & options,
 					 const HttpHeaders::ptr_t & headers);
 
+	// Looks the request up in the response cache of its class.
+	// Returns true if a fresh entry answered it, otherwise it
+	// may have kept a stale entry for revalidation.
+	//
+	// Threading:  called by worker thread
+	//
+	bool lookupCache(HttpService * service);
+	void replyFromCache(const HttpCacheEntry & entry);
+
 	// libcurl operational callbacks
 	//
 	// Threading:  called by worker thread
@@ -187,6 +215,8 @@ protected:
 	static const unsigned int	PF_SCAN_RANGE_HEADER = 0x00000001U;
 	static const unsigned int	PF_SAVE_HEADERS = 0x00000002U;
 	static const unsigned int	PF_USE_RETRY_AFTER = 0x00000004U;
+	static const unsigned int	PF_SCAN_CACHE_HEADERS = 0x00000008U;
+	static const unsigned int	PF_PRECONNECT = 0x00000010U;
 
 	HttpRequest::policyCallback_t	mCallbackSSLVerify;
 
@@ -223,9 +253,18 @@ public:
 	int					mPolicyRetries;
 	int					mPolicy503Retries;
 	HttpTime			mPolicyRetryAt;
+	HttpTime			mPolicyActiveAt;		// time the current attempt went to transport
 	int					mPolicyRetryLimit;
 	HttpTime			mPolicyMinRetryBackoff; // initial delay between retries (mcs)
 	HttpTime			mPolicyMaxRetryBackoff;
+
+	// Response cache data
+	HttpCacheStore::ptr_t	mCacheStore;		// Set when the reply may be cached
+	std::unique_ptr<HttpCacheEntry>	mCacheEntry;	// Stale entry being revalidated
+	std::string			mReplyETag;
+	std::string			mReplyLastModified;
+	long				mReplyMaxAge;			// -1 if not given
+	bool				mReplyNoStore;
 };  // end class HttpOpRequest
 
 
@@ -35,6 +35,7 @@
 
 #include "lltimer.h"
 #include "httpstats.h"
+#include "bufferarray.h"
 
 namespace
 {
@@ -248,10 +249,16 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 		}
 
 		int active(transport.getActiveCountInClass(policy_class));
-		int active_limit(state.mOptions.mPipelining > 1L
-						 ? (state.mOptions.mPerHostConnectionLimit
-							* state.mOptions.mPipelining)
-						 : state.mOptions.mConnectionLimit);
+		int active_limit(state.mOptions.mConnectionLimit);
+		if (state.mOptions.mHttp2Streams > 1L)
+		{
+			// Multiplexed, the limit is on streams rather than connections
+			active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mHttp2Streams;
+		}
+		else if (state.mOptions.mPipelining > 1L)
+		{
+			active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mPipelining;
+		}
 		int needed(active_limit - active);		// Expect negatives here
 
 		if (needed > 0)
@@ -373,6 +380,21 @@ bool HttpPolicy::cancel(HttpHandle handle)
 
 bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 {
+	if (op->isPreconnect())
+	{
+		// The connection is what was wanted, whatever the status.
+		// Kept out of the class stats as it only measures the handshake.
+		op->stageFromActive(mService);
+		return false;
+	}
+
+	// Every attempt counts, retries included, for anyone tuning
+	// class options from observed latency and throttling.
+	HTTPStats::instance().recordClassResult(op->mReqPolicy,
+											F64(totalTime() - op->mPolicyActiveAt) / 1.0e6,
+											op->mReplyBody ? op->mReplyBody->size() : 0,
+											op->mStatus.getType());
+
 	// Retry or finalize
 	if (! op->mStatus)
 	{
@@ -398,6 +420,8 @@ bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 	}
 
 	// This op is done, finalize it delivering it to the reply queue...
+	// A 304 answering a cache revalidation becomes the cached 200 here.
+	op->updateCache();
 	if (! op->mStatus)
 	{
 		LL_WARNS(LOG_CORE) << "HTTP request " << op->getHandle()
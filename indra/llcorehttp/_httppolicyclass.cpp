@@ -37,7 +37,9 @@ HttpPolicyClass::HttpPolicyClass()
 	: mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPerHostConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPipelining(HTTP_PIPELINING_DEFAULT),
-	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT)
+	  mHttp2Streams(HTTP_HTTP2_STREAMS_DEFAULT),
+	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT),
+	  mResponseCache(0L)
 {}
 
 
@@ -52,7 +54,9 @@ HttpPolicyClass & HttpPolicyClass::operator=(const HttpPolicyClass & other)
 		mConnectionLimit = other.mConnectionLimit;
 		mPerHostConnectionLimit = other.mPerHostConnectionLimit;
 		mPipelining = other.mPipelining;
+		mHttp2Streams = other.mHttp2Streams;
 		mThrottleRate = other.mThrottleRate;
+		mResponseCache = other.mResponseCache;
 	}
 	return *this;
 }
@@ -62,7 +66,9 @@ HttpPolicyClass::HttpPolicyClass(const HttpPolicyClass & other)
 	: mConnectionLimit(other.mConnectionLimit),
 	  mPerHostConnectionLimit(other.mPerHostConnectionLimit),
 	  mPipelining(other.mPipelining),
-	  mThrottleRate(other.mThrottleRate)
+	  mHttp2Streams(other.mHttp2Streams),
+	  mThrottleRate(other.mThrottleRate),
+	  mResponseCache(other.mResponseCache)
 {}
 
 
@@ -82,10 +88,18 @@ HttpStatus HttpPolicyClass::set(HttpRequest::EPolicyOption opt, long value)
 		mPipelining = llclamp(value, 0L, HTTP_PIPELINING_MAX);
 		break;
 
+	case HttpRequest::PO_HTTP2_STREAMS:
+		mHttp2Streams = llclamp(value, 0L, HTTP_HTTP2_STREAMS_MAX);
+		break;
+
 	case HttpRequest::PO_THROTTLE_RATE:
 		mThrottleRate = llclamp(value, 0L, 1000000L);
 		break;
 
+	case HttpRequest::PO_RESPONSE_CACHE:
+		mResponseCache = llclamp(value, 0L, 1L);
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -110,10 +124,18 @@ HttpStatus HttpPolicyClass::get(HttpRequest::EPolicyOption opt, long * value) co
 		*value = mPipelining;
 		break;
 
+	case HttpRequest::PO_HTTP2_STREAMS:
+		*value = mHttp2Streams;
+		break;
+
 	case HttpRequest::PO_THROTTLE_RATE:
 		*value = mThrottleRate;
 		break;
 
+	case HttpRequest::PO_RESPONSE_CACHE:
+		*value = mResponseCache;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -63,7 +63,9 @@ public:
 	long						mConnectionLimit;
 	long						mPerHostConnectionLimit;
 	long						mPipelining;
+	long						mHttp2Streams;
 	long						mThrottleRate;
+	long						mResponseCache;
 };  // end class HttpPolicyClass
 
 }  // end namespace LLCore
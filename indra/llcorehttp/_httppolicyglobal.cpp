@@ -54,6 +54,7 @@ HttpPolicyGlobal & HttpPolicyGlobal::operator=(const HttpPolicyGlobal & other)
 		mHttpProxy = other.mHttpProxy;
 		mTrace = other.mTrace;
 		mUseLLProxy = other.mUseLLProxy;
+		mCacheStore = other.mCacheStore;
 	}
 	return *this;
 }
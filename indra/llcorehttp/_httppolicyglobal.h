@@ -73,6 +73,7 @@ public:
 	long				mTrace;
 	long				mUseLLProxy;
 	HttpRequest::policyCallback_t	mSslCtxCallback;
+	HttpCacheStore::ptr_t			mCacheStore;
 };  // end class HttpPolicyGlobal
 
 }  // end namespace LLCore
@@ -54,31 +54,27 @@ class BufferArray::Block
 public:
 	~Block();
 
-	void operator delete(void *);
-	void operator delete(void *, size_t len);
-
 protected:
 	Block(size_t len);
 
 	Block(const Block &);						// Not defined
 	void operator=(const Block &);				// Not defined
 
-	// Allocate the block with the additional space for the
-	// buffered data at the end of the object.
-	void * operator new(size_t len, size_t addl_len);
-	
 public:
 	// Only public entry to get a block.
 	static Block * alloc(size_t len);
 
+	// Give up ownership of the data.  Block is empty afterwards.
+	char * detach();
+
 public:
 	size_t mUsed;
 	size_t mAlloced;
 
-	// *NOTE:  Must be last member of the object.  We'll
-	// overallocate as requested via operator new and index
-	// into the array at will.
-	char mData[1];		
+	// Kept in a separate aligned allocation, rather than at the
+	// end of the object, so that it can be handed over to a
+	// consumer without a copy.  @see detachData().
+	char * mData;
 };
 
 
@@ -177,6 +173,7 @@ void * BufferArray::appendBufferAlloc(size_t len)
 		mBlocks.reserve(mBlocks.size() + 5);
 	}
 	Block * block = Block::alloc((std::max)(BLOCK_ALLOC_SIZE, len));
+	memset(block->mData, 0, len);
 	block->mUsed = len;
 	mBlocks.push_back(block);
 	mLen += len;
@@ -184,6 +181,24 @@ void * BufferArray::appendBufferAlloc(size_t len)
 }
 
 
+void BufferArray::reserve(size_t len)
+{
+	if (! mBlocks.empty())
+	{
+		const Block & last(*mBlocks.back());
+		if (len <= last.mAlloced - last.mUsed)
+		{
+			return;
+		}
+	}
+	if (mBlocks.size() >= mBlocks.capacity())
+	{
+		mBlocks.reserve(mBlocks.size() + 5);
+	}
+	mBlocks.push_back(Block::alloc((std::max)(BLOCK_ALLOC_SIZE, len)));
+}
+
+
 size_t BufferArray::read(size_t pos, void * dst, size_t len)
 {
 	char * c_dst(static_cast<char *>(dst));
@@ -282,6 +297,50 @@ size_t BufferArray::write(size_t pos, const void * src, size_t len)
 }
 		
 
+const char * BufferArray::getContiguous(size_t pos, size_t len)
+{
+	size_t offset(0);
+	int block(findBlock(pos, &offset));
+	if (block < 0 || len > mBlocks[block]->mUsed - offset)
+	{
+		return NULL;
+	}
+	return &mBlocks[block]->mData[offset];
+}
+
+
+void * BufferArray::detachData(size_t * len)
+{
+	// Blocks that are empty don't count, reserve() can leave one behind
+	Block * found(NULL);
+	for (container_t::iterator it(mBlocks.begin()); it != mBlocks.end(); ++it)
+	{
+		if ((*it)->mUsed)
+		{
+			if (found)
+			{
+				return NULL;
+			}
+			found = *it;
+		}
+	}
+	if (! found)
+	{
+		return NULL;
+	}
+
+	*len = mLen;
+	void * data(found->detach());
+	for (container_t::iterator it(mBlocks.begin()); it != mBlocks.end(); ++it)
+	{
+		delete *it;
+	}
+	mBlocks.clear();
+	mLen = 0;
+	return data;
+}
+
+
 int BufferArray::findBlock(size_t pos, size_t * ret_offset)
 {
 	*ret_offset = 0;
@@ -325,42 +384,38 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
 
 BufferArray::Block::Block(size_t len)
 	: mUsed(0),
-	  mAlloced(len)
+	  mAlloced(len),
+	  mData(static_cast<char *>(ll_aligned_malloc_16((std::max)(len, size_t(1)))))
 {
-	memset(mData, 0, len);
+	if (! mData)
+	{
+		throw std::bad_alloc();
+	}
 }
 			
 
 BufferArray::Block::~Block()
 {
+	ll_aligned_free_16(mData);
+	mData = NULL;
 	mUsed = 0;
 	mAlloced = 0;
 }
 
 
-void * BufferArray::Block::operator new(size_t len, size_t addl_len)
-{
-	void * mem = new char[len + addl_len + sizeof(void *)];
-	return mem;
-}
-
-
-void BufferArray::Block::operator delete(void * mem)
+char * BufferArray::Block::detach()
 {
-	char * cmem = static_cast<char *>(mem);
-	delete [] cmem;
-}
-
-
-void BufferArray::Block::operator delete(void * mem, size_t)
-{
-	operator delete(mem);
+	char * data(mData);
+	mData = NULL;
+	mUsed = 0;
+	mAlloced = 0;
+	return data;
 }
 
 
 BufferArray::Block * BufferArray::Block::alloc(size_t len)
 {
-	Block * block = new (len) Block(len);
+	Block * block = new Block(len);
 	return block;
 }
 	
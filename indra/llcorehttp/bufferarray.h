@@ -104,6 +104,13 @@ public:
 	///					of BufferArray of 'len' size.
 	void * appendBufferAlloc(size_t len);
 
+	/// Hint that 'len' more bytes are about to be appended.
+	/// If they won't fit in the free space of the final block,
+	/// an empty block large enough for all of them is added
+	/// so that the appends land contiguously.  Doesn't change
+	/// size or data.
+	void reserve(size_t len);
+
 	/// Current count of bytes in BufferArray instance.
 	size_t size() const
 		{
@@ -120,6 +127,27 @@ public:
 	/// append data when current position is equal to the
 	/// size of the instance or do a mix of both.
 	size_t write(size_t pos, const void * src, size_t len);
+
+	/// Returns a pointer to the 'len' bytes of data starting
+	/// at 'pos' when they lie in a single block, letting the
+	/// caller use them in place rather than copy them out
+	/// with @see read().  Returns NULL if the range spans
+	/// blocks or extends beyond the data.  The pointer is
+	/// good until the next modifying call on the instance.
+	const char * getContiguous(size_t pos, size_t len);
+
+	/// Hands the storage of the single block holding all of
+	/// the data over to the caller, leaving the instance
+	/// empty.  The memory comes from ll_aligned_malloc_16()
+	/// and must be freed with ll_aligned_free_16().  Returns
+	/// NULL and leaves the instance unchanged when the data
+	/// spans more than one block or there is none.  Other
+	/// holders of a reference see the data disappear, so only
+	/// call this on an unshared instance.
+	///
+	/// @param len		Receives the count of bytes of data
+	/// @return			Pointer to the data, owned by caller
+	void * detachData(size_t * len);
 	
 protected:
 	int findBlock(size_t pos, size_t * ret_offset);
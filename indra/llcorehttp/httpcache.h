@@ -0,0 +1,75 @@
+/**
+ * @file httpcache.h
+ * @brief Public-facing declarations for the HttpCacheStore class
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef	_LLCORE_HTTP_CACHE_H_
+#define	_LLCORE_HTTP_CACHE_H_
+
+
+#include "httpcommon.h"
+
+#include <string>
+
+
+namespace LLCore
+{
+
+
+/// HttpCacheStore defines the storage behind the response
+/// cache that policy classes enable with PO_RESPONSE_CACHE.
+/// The library decides what is cached, for how long and how
+/// it is revalidated; the store only keeps opaque entries
+/// keyed by request URL.  Install one with
+/// @see HttpRequest::setStaticCacheStore().
+///
+/// Threading:  All methods are called on the worker thread
+/// and must not block for long.
+///
+/// Allocation:  Refcounted through shared_ptr, the library
+/// keeps a reference until the service is destroyed.
+class HttpCacheStore
+{
+public:
+	typedef boost::shared_ptr<HttpCacheStore> ptr_t;
+
+	virtual ~HttpCacheStore()
+	{}
+
+	/// Fetch the entry last written for url.
+	///
+	/// @return			True if an entry was found and
+	///					copied into data.
+	virtual bool read(const std::string & url, std::string & data) = 0;
+
+	/// Replace the entry for url.
+	virtual void write(const std::string & url, const std::string & data) = 0;
+
+	/// Drop any entry for url.
+	virtual void remove(const std::string & url) = 0;
+};  // end class HttpCacheStore
+
+}  // end namespace LLCore
+
+#endif	// _LLCORE_HTTP_CACHE_H_
@@ -124,6 +124,18 @@ HttpStatus HttpRequest::setStaticPolicyOption(EPolicyOption opt, policy_t pclass
 	return HttpService::instanceOf()->setPolicyOption(opt, pclass, value, ret_value);
 }
 
+
+HttpStatus HttpRequest::setStaticCacheStore(const HttpCacheStore::ptr_t & store)
+{
+	if (HttpService::RUNNING == HttpService::instanceOf()->getState())
+	{
+		return HttpStatus(HttpStatus::LLCORE, HE_OPT_NOT_DYNAMIC);
+	}
+
+	HttpService::instanceOf()->getPolicy().getGlobalOptions().mCacheStore = store;
+	return HttpStatus();
+}
+
 HttpHandle HttpRequest::setPolicyOption(EPolicyOption opt, policy_t pclass,
 										long value, HttpHandler::ptr_t handler)
 {
@@ -208,6 +220,31 @@ HttpHandle HttpRequest::requestGet(policy_t policy_id,
 }
 
 
+HttpHandle HttpRequest::requestPreconnect(policy_t policy_id,
+										  const std::string & url,
+										  HttpHandler::ptr_t user_handler)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	HttpStatus status;
+
+	HttpOpRequest::ptr_t op(new HttpOpRequest());
+	if (! (status = op->setupPreconnect(policy_id, url)))
+	{
+		mLastReqStatus = status;
+        return LLCORE_HTTP_HANDLE_INVALID;
+	}
+	op->setReplyPath(mReplyQueue, user_handler);
+	if (! (status = mRequestQueue->addOp(op)))			// transfers refcount
+	{
+		mLastReqStatus = status;
+        return LLCORE_HTTP_HANDLE_INVALID;
+	}
+	
+	mLastReqStatus = status;
+    return op->getHandle();
+}
+
+
 HttpHandle HttpRequest::requestGetByteRange(policy_t policy_id,
 											const std::string & url,
 											size_t offset,
@@ -29,6 +29,7 @@
 
 
 #include "httpcommon.h"
+#include "httpcache.h"
 #include "httphandler.h"
 
 #include "httpheaders.h"
@@ -232,6 +233,36 @@ public:
 		/// Global only
 		PO_SSL_VERIFY_CALLBACK,
 
+		/// If greater than 1, requests in this class negotiate
+		/// HTTP/2 over TLS and are multiplexed as concurrent
+		/// streams on shared connections.  Value gives the
+		/// maximum number of streams in flight on a connection.
+		///
+		/// When set, this takes precedence over PO_PIPELINING_DEPTH.
+		/// Libcurl manages connections as it does for pipelining
+		/// with PO_PER_HOST_CONNECTION_LIMIT giving the number of
+		/// connections per host and the in-flight request limit
+		/// for the class becoming PO_PER_HOST_CONNECTION_LIMIT
+		/// times this value.  Servers that don't offer HTTP/2
+		/// fall back to HTTP/1.1 on the same connection limits
+		/// with requests queued in libcurl for a free connection.
+		///
+		/// Per-class only
+		PO_HTTP2_STREAMS,
+
+		/// Long value that if non-zero keeps GET responses of
+		/// this class in the store given to @see setStaticCacheStore().
+		/// Responses fresh under their Cache-Control max-age are
+		/// answered without touching the network and stale ones
+		/// carrying an ETag or Last-Modified header are revalidated
+		/// with a conditional request, a 304 answer being turned
+		/// into the cached 200 response.  Byte range and
+		/// headers-only requests and responses marked no-store
+		/// are never cached.
+		///
+		/// Per-class only
+		PO_RESPONSE_CACHE,
+
 		PO_LAST  // Always at end
 	};
 
@@ -257,6 +288,14 @@ public:
 	static HttpStatus setStaticPolicyOption(EPolicyOption opt, policy_t pclass,
 											policyCallback_t value, policyCallback_t * ret_value);;
 
+	/// Set the storage used by classes with PO_RESPONSE_CACHE
+	/// enabled at startup time (prior to thread start).  Without
+	/// a store nothing is cached.
+	///
+	/// @param store		Store to use, may be empty.
+	/// @return				Standard status code.
+	static HttpStatus setStaticCacheStore(const HttpCacheStore::ptr_t & store);
+
 	/// Set a parameter on a class-based policy option.  Calls
 	/// made after the start of the servicing thread are
 	/// not honored and return an error status.
@@ -349,6 +388,31 @@ public:
 						  HttpHandler::ptr_t handler);
 
 
+	/// Queue a request that only warms up a connection to the
+	/// host of the URL:  the DNS lookup, the connection and the
+	/// TLS handshake are done and the connection is left in the
+	/// class's connection cache for the requests that follow.
+	/// DNS entries and TLS sessions are shared by all classes so
+	/// later connections to the host are cheaper as well.  One
+	/// connection is opened per request queued.
+	///
+	/// It goes out as a HEAD request whose status is of no
+	/// interest.  It isn't retried and a failure isn't logged.
+	///
+	/// @param	policy_id		Policy class whose requests will use
+	///							the connection.
+	/// @param	url				Any URL on the host, usually the root.
+	/// @param	handler			Optional handler, @see requestGet().
+	///
+	/// @return					The handle of the request if successfully
+	///							queued or LLCORE_HTTP_HANDLE_INVALID if the
+	///							request could not be queued.
+	///
+	HttpHandle requestPreconnect(policy_t policy_id,
+								 const std::string & url,
+								 HttpHandler::ptr_t handler);
+
+
 	/// Queue a full HTTP GET request to be issued with a 'Range' header.
 	/// The request is queued and serviced by the working thread and
 	/// notification of completion delivered to the optional HttpHandler
@@ -45,6 +45,9 @@ void HTTPStats::resetStats()
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
+
+    LLMutexLock lock(&mClassStatsMutex);
+    mClassStats.clear();
 }
 
 
@@ -61,6 +64,32 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordClassResult(S32 policy_class, F64 latency, size_t bytes, S32 code)
+{
+    LLMutexLock lock(&mClassStatsMutex);
+    ClassStats& stats(mClassStats[policy_class]);
+    ++stats.mCompleted;
+    if (429 == code || 503 == code)
+    {
+        ++stats.mThrottled;
+    }
+    stats.mLatencySum += latency;
+    stats.mBytesDown += bytes;
+}
+
+HTTPStats::ClassStats HTTPStats::sampleClassStats(S32 policy_class)
+{
+    LLMutexLock lock(&mClassStatsMutex);
+    ClassStats result;
+    std::map<S32, ClassStats>::iterator it(mClassStats.find(policy_class));
+    if (it != mClassStats.end())
+    {
+        result = it->second;
+        it->second = ClassStats();
+    }
+    return result;
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
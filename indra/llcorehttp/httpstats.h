@@ -31,6 +31,7 @@
 #include "lltrace.h"
 #include "llstatsaccumulator.h"
 #include "llsingleton.h"
+#include "llmutex.h"
 #include "llsd.h"
 
 namespace LLCore
@@ -59,6 +60,26 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        /// Results of the requests of one policy class.  Recorded on
+        /// the worker thread, sampled elsewhere.
+        struct ClassStats
+        {
+            ClassStats()
+                : mCompleted(0), mThrottled(0), mLatencySum(0.0), mBytesDown(0)
+            {}
+
+            U32     mCompleted;     // attempts finished, successfully or not
+            U32     mThrottled;     // of those, 429 and 503 replies
+            F64     mLatencySum;    // seconds from going active to completion
+            U64     mBytesDown;
+        };
+
+        void    recordClassResult(S32 policy_class, F64 latency, size_t bytes, S32 code);
+
+        /// Returns the results recorded for the class since the
+        /// previous call and starts gathering anew.
+        ClassStats sampleClassStats(S32 policy_class);
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
@@ -67,6 +88,9 @@ namespace LLCore
         S32              mRequests;
 
         std::map<S32, S32> mResutCodes;
+
+        LLMutex          mClassStatsMutex;
+        std::map<S32, ClassStats> mClassStats;
     };
 
 
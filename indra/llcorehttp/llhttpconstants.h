@@ -195,6 +195,7 @@ extern const std::string HTTP_IN_HEADER_X_FORWARDED_FOR;
 //// HTTP Content Types ////
 
 extern const std::string HTTP_CONTENT_LLSD_XML;
+extern const std::string HTTP_CONTENT_LLSD_BINARY;
 extern const std::string HTTP_CONTENT_OCTET_STREAM;
 extern const std::string HTTP_CONTENT_VND_LL_MESH;
 extern const std::string HTTP_CONTENT_XML;
@@ -38,6 +38,7 @@
 // Pull in each of the test sets
 #include "test_bufferarray.hpp"
 #include "test_bufferstream.hpp"
+#include "test_httpcache.hpp"
 #include "test_httpstatus.hpp"
 #include "test_refcounted.hpp"
 #include "test_httpoperation.hpp"
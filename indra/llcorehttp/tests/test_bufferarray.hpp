@@ -27,6 +27,7 @@
 #define TEST_LLCORE_BUFFER_ARRAY_H_
 
 #include "bufferarray.h"
+#include "llmemory.h"
 
 #include <iostream>
 
@@ -374,6 +375,55 @@ void BufferArrayTestObjectType::test<8>()
 	ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+	set_test_name("BufferArray reserve, getContiguous and detachData");
+
+	// create a new ref counted object with an implicit reference
+	BufferArray * ba = new BufferArray();
+
+	// reserve past a block and fill it in pieces
+	const size_t big_len(BufferArray::BLOCK_ALLOC_SIZE + 100);
+	char * big = new char[big_len];
+	for (size_t i(0); i < big_len; ++i)
+	{
+		big[i] = char('a' + i % 26);
+	}
+	ba->reserve(big_len);
+	ensure("Reserve doesn't change size", 0 == ba->size());
+	ba->append(big, 1000);
+	ba->append(big + 1000, big_len - 1000);
+	ensure("Appended length correct", big_len == ba->size());
+
+	const char * span(ba->getContiguous(0, big_len));
+	ensure("Reserved appends are contiguous", NULL != span);
+	ensure("Contiguous content correct", 0 == memcmp(span, big, big_len));
+	ensure("Span beyond data refused", NULL == ba->getContiguous(10, big_len));
+
+	size_t len(0);
+	char * data(static_cast<char *>(ba->detachData(&len)));
+	ensure("Single block detached", NULL != data);
+	ensure("Detached length correct", big_len == len);
+	ensure("Detached content correct", 0 == memcmp(data, big, big_len));
+	ensure("Nothing left after detach", 0 == ba->size());
+	ll_aligned_free_16(data);
+
+	// without a reserve, the same appends span blocks
+	ba->append(big, 1000);
+	ba->append(big + 1000, big_len - 1000);
+	ensure("Unreserved appends not contiguous", NULL == ba->getContiguous(0, big_len));
+	ensure("Partial span in first block", NULL != ba->getContiguous(10, 100));
+	data = static_cast<char *>(ba->detachData(&len));
+	ensure("Multiple blocks not detached", NULL == data);
+	ensure("Data kept after failed detach", big_len == ba->size());
+
+	delete [] big;
+
+	// release the implicit reference, causing the object to be released
+	ba->release();
+}
+
 }  // end namespace tut
 
 
@@ -0,0 +1,120 @@
+/**
+ * @file test_httpcache.hpp
+ * @brief unit tests for the response cache entries
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef TEST_LLCORE_HTTP_CACHE_H_
+#define TEST_LLCORE_HTTP_CACHE_H_
+
+#include "_httpcache.h"
+
+#include <iostream>
+
+
+using namespace LLCore;
+
+
+namespace tut
+{
+
+struct HttpCacheTestData
+{
+	// the test objects inherit from this so the member functions and variables
+	// can be referenced directly inside of the test functions.
+};
+
+typedef test_group<HttpCacheTestData> HttpCacheTestGroupType;
+typedef HttpCacheTestGroupType::object HttpCacheTestObjectType;
+HttpCacheTestGroupType HttpCacheTestGroup("HttpCache Tests");
+
+template <> template <>
+void HttpCacheTestObjectType::test<1>()
+{
+	set_test_name("HttpCacheEntry round trip");
+
+	HttpCacheEntry entry;
+	entry.mExpires = 1234567890;
+	entry.mETag = "\"abc\"";
+	entry.mLastModified = "Wed, 21 Oct 2015 07:28:00 GMT";
+	entry.mContentType = "application/llsd+xml";
+	entry.mHeaders = HttpHeaders::ptr_t(new HttpHeaders());
+	entry.mHeaders->append("content-type", "application/llsd+xml");
+	entry.mHeaders->append("x-empty", "");
+	entry.mBody = std::string("line one\n\nline\0three", 20);
+
+	std::string data;
+	entry.serialize(data);
+
+	HttpCacheEntry copy;
+	ensure("Stored form parses", copy.parse(data));
+	ensure_equals("Expiry kept", copy.mExpires, entry.mExpires);
+	ensure_equals("ETag kept", copy.mETag, entry.mETag);
+	ensure_equals("Last-Modified kept", copy.mLastModified, entry.mLastModified);
+	ensure_equals("Content type kept", copy.mContentType, entry.mContentType);
+	ensure_equals("Body kept, blank lines and NULs included", copy.mBody, entry.mBody);
+	ensure("Headers kept", copy.mHeaders && 2 == copy.mHeaders->size());
+	const std::string * value(copy.mHeaders->find("content-type"));
+	ensure("Header value kept", value && *value == "application/llsd+xml");
+	value = copy.mHeaders->find("x-empty");
+	ensure("Empty header value kept", value && value->empty());
+	ensure("Has validators", copy.canRevalidate());
+	ensure("Fresh before expiry", copy.isFresh(1234567889));
+	ensure("Stale at expiry", ! copy.isFresh(1234567890));
+}
+
+template <> template <>
+void HttpCacheTestObjectType::test<2>()
+{
+	set_test_name("HttpCacheEntry rejects damaged data");
+
+	HttpCacheEntry entry;
+	entry.mBody = "body";
+	std::string data;
+	entry.serialize(data);
+
+	HttpCacheEntry copy;
+	ensure("Empty data rejected", ! copy.parse(std::string()));
+	ensure("Unknown tag rejected", ! copy.parse("something else\n\nbody"));
+	ensure("Truncated fields rejected", ! copy.parse(data.substr(0, data.find("\n\n"))));
+	ensure("Entry without validators can't revalidate", ! entry.canRevalidate());
+}
+
+template <> template <>
+void HttpCacheTestObjectType::test<3>()
+{
+	set_test_name("Cache-Control parsing");
+
+	bool no_store(false);
+	ensure_equals("No directives", parse_cache_control("", no_store), -1L);
+	ensure_equals("max-age", parse_cache_control("public, max-age=300", no_store), 300L);
+	ensure_equals("Case and spaces", parse_cache_control(" Private ,MAX-AGE=60 ", no_store), 60L);
+	ensure_equals("no-cache wins", parse_cache_control("max-age=60, no-cache", no_store), 0L);
+	ensure("Still storable", ! no_store);
+	ensure_equals("Negative ages clamp", parse_cache_control("max-age=-5", no_store), 0L);
+	parse_cache_control("no-store", no_store);
+	ensure("no-store seen", no_store);
+}
+
+}  // end namespace tut
+
+#endif  // TEST_LLCORE_HTTP_CACHE_H_
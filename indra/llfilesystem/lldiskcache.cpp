@@ -41,14 +41,62 @@
 
 LLDiskCache::LLDiskCache(const std::string cache_dir,
                          const uintmax_t max_size_bytes,
-                         const bool enable_cache_debug_info) :
+                         const bool enable_cache_debug_info,
+                         const bool use_index,
+                         const bool use_packs) :
     mCacheDir(cache_dir),
     mMaxSizeBytes(max_size_bytes),
-    mEnableCacheDebugInfo(enable_cache_debug_info)
+    mEnableCacheDebugInfo(enable_cache_debug_info),
+    mUseIndex(use_index)
 {
     mCacheFilenamePrefix = "sl_cache";
 
     LLFile::mkdir(cache_dir);
+
+    if (mUseIndex && !mIndex.open(getIndexFilepath()))
+    {
+        if (mIndex.isOpen())
+        {
+            rebuildIndex();
+        }
+        else
+        {
+            LL_WARNS() << "Unable to open disk cache index, falling back to the file system" << LL_ENDL;
+            mUseIndex = false;
+        }
+    }
+
+    if (use_packs)
+    {
+        /**
+         * Fraction of the cache the packs may use, they only hold the small
+         * asset types so don't need much of it
+         */
+        const F64 PACK_SHARE = 0.25;
+
+        mPacks = std::make_unique<LLDiskCachePacks>(mCacheDir, (U64)(mMaxSizeBytes * PACK_SHARE));
+    }
+}
+
+LLDiskCache::~LLDiskCache()
+{
+    LLMutexLock lock(&mIndexMutex);
+    mIndex.close();
+}
+
+void LLDiskCache::compactPacks()
+{
+    if (mPacks)
+    {
+        mPacks->compact();
+    }
+}
+
+uintmax_t LLDiskCache::getMaxFileSizeBytes()
+{
+    // whatever the packs use comes out of the space for individual files
+    uintmax_t pack_size_bytes = mPacks ? mPacks->getDiskSize() : 0;
+    return mMaxSizeBytes - llmin(pack_size_bytes, mMaxSizeBytes);
 }
 
 // WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
@@ -81,6 +129,12 @@ LLDiskCache::LLDiskCache(const std::string cache_dir,
 // asset will have to be re-requested.
 void LLDiskCache::purge()
 {
+    if (mUseIndex)
+    {
+        purgeIndexed();
+        return;
+    }
+
     if (mEnableCacheDebugInfo)
     {
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
@@ -89,6 +143,8 @@ void LLDiskCache::purge()
     boost::system::error_code ec;
     auto start_time = std::chrono::high_resolution_clock::now();
 
+    const uintmax_t max_size_bytes = getMaxFileSizeBytes();
+
     typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
     std::vector<file_info_t> file_info;
 
@@ -130,7 +186,7 @@ void LLDiskCache::purge()
         return x.first > y.first;
     });
 
-    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
+    LL_INFOS() << "Purging cache to a maximum of " << max_size_bytes << " bytes" << LL_ENDL;
 
     std::vector<bool> file_removed;
     if (mEnableCacheDebugInfo)
@@ -142,7 +198,7 @@ void LLDiskCache::purge()
     {
         file_size_total += entry.second.first;
 
-        bool should_remove = file_size_total > mMaxSizeBytes;
+        bool should_remove = file_size_total > max_size_bytes;
         if (mEnableCacheDebugInfo)
         {
             file_removed.push_back(should_remove);
@@ -177,7 +233,7 @@ void LLDiskCache::purge()
             line << entry.first << "  ";
             line << entry.second.first << "  ";
             line << entry.second.second;
-            line << " (" << file_size_total << "/" << mMaxSizeBytes << ")";
+            line << " (" << file_size_total << "/" << max_size_bytes << ")";
             LL_INFOS() << line.str() << LL_ENDL;
         }
 
@@ -186,6 +242,136 @@ void LLDiskCache::purge()
     }
 }
 
+void LLDiskCache::purgeIndexed()
+{
+    /**
+     * Number of files picked for removal each time the index lock is taken,
+     * so a large purge (after the cache size is reduced, say) doesn't hold
+     * up the threads that are reading and writing assets
+     */
+    const size_t PURGE_BATCH_SIZE = 256;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    const uintmax_t max_size_bytes = getMaxFileSizeBytes();
+
+    size_t files_removed = 0;
+    uintmax_t bytes_removed = 0;
+    std::vector<std::string> file_paths;
+    file_paths.reserve(PURGE_BATCH_SIZE);
+
+    while (true)
+    {
+        file_paths.clear();
+        {
+            LLMutexLock lock(&mIndexMutex);
+            LLDiskCacheIndex::Entry entry;
+            while (file_paths.size() < PURGE_BATCH_SIZE &&
+                   mIndex.getTotalSize() > max_size_bytes &&
+                   mIndex.popOldest(entry))
+            {
+                file_paths.push_back(metaDataToFilepath(entry.mID.asString(), entry.mAssetType, ""));
+                bytes_removed += entry.mSize;
+            }
+
+            // this is where the access time updates since the last purge get written back
+            mIndex.flush();
+        }
+
+        if (file_paths.empty())
+        {
+            break;
+        }
+
+        for (const std::string& file_path : file_paths)
+        {
+            if (mEnableCacheDebugInfo)
+            {
+                LL_INFOS() << "DELETE: " << file_path << LL_ENDL;
+            }
+            // ENOENT: the index can outlive files removed behind our back
+            LLFile::remove(file_path, ENOENT);
+        }
+        files_removed += file_paths.size();
+    }
+
+    if (mEnableCacheDebugInfo || files_removed)
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+        LL_INFOS() << "Cache purge removed " << files_removed << " files (" << bytes_removed << " bytes) in "
+                   << execute_time << " ms to reach a maximum of " << max_size_bytes << " bytes" << LL_ENDL;
+    }
+}
+
+void LLDiskCache::rebuildIndex()
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    typedef std::pair<std::time_t, std::pair<uintmax_t, LLUUID>> file_info_t;
+    std::vector<file_info_t> file_info;
+
+    // cache filenames look like <prefix>_<uuid>_<extra info>.asset
+    const std::string id_prefix = mCacheFilenamePrefix + "_";
+    const size_t id_length = UUID_STR_LENGTH - 1;
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
+#else
+    std::string cache_path(mCacheDir);
+#endif
+    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    {
+        boost::filesystem::directory_iterator iter(cache_path, ec);
+        while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+        {
+            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
+            {
+                const std::string file_name = (*iter).path().filename().string();
+                LLUUID id;
+                if (file_name.compare(0, id_prefix.length(), id_prefix) == 0 &&
+                    file_name.length() > id_prefix.length() + id_length &&
+                    id.set(file_name.substr(id_prefix.length(), id_length), FALSE))
+                {
+                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
+                    if (!ec.failed())
+                    {
+                        const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
+                        if (!ec.failed())
+                        {
+                            file_info.push_back(file_info_t(file_time, { file_size, id }));
+                        }
+                    }
+                }
+            }
+            iter.increment(ec);
+        }
+    }
+
+    // oldest first, so the most recently used file ends up at the head of the index
+    std::sort(file_info.begin(), file_info.end(), [](const file_info_t& x, const file_info_t& y)
+    {
+        return x.first < y.first;
+    });
+
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mIndex.clear();
+        for (const file_info_t& entry : file_info)
+        {
+            // the asset type isn't part of the filename so can't be recovered here
+            mIndex.insert(entry.second.second, LLAssetType::AT_UNKNOWN, entry.second.first, entry.first);
+        }
+        mIndex.flush();
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    LL_INFOS() << "Rebuilt disk cache index from " << file_info.size() << " files in " << execute_time << " ms" << LL_ENDL;
+}
+
 const std::string LLDiskCache::assetTypeToString(LLAssetType::EType at)
 {
     /**
@@ -319,12 +505,72 @@ void LLDiskCache::updateFileAccessTime(const std::string file_path)
     }
 }
 
+bool LLDiskCache::findIndexedFile(const LLUUID& id, U64& size)
+{
+    if (!mUseIndex)
+    {
+        return false;
+    }
+
+    LLMutexLock lock(&mIndexMutex);
+    LLDiskCacheIndex::Entry entry;
+    if (!mIndex.find(id, entry))
+    {
+        return false;
+    }
+
+    size = entry.mSize;
+    return true;
+}
+
+void LLDiskCache::addIndexedFile(const LLUUID& id, LLAssetType::EType at, U64 size)
+{
+    if (mUseIndex)
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mIndex.insert(id, at, size, std::time(nullptr));
+    }
+}
+
+void LLDiskCache::touchIndexedFile(const LLUUID& id)
+{
+    if (mUseIndex)
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mIndex.touch(id, std::time(nullptr));
+    }
+}
+
+void LLDiskCache::removeIndexedFile(const LLUUID& id)
+{
+    if (mUseIndex)
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mIndex.remove(id);
+    }
+}
+
 const std::string LLDiskCache::getCacheInfo()
 {
     std::ostringstream cache_info;
 
+    uintmax_t used_bytes = 0;
+    if (mUseIndex)
+    {
+        LLMutexLock lock(&mIndexMutex);
+        used_bytes = mIndex.getTotalSize();
+    }
+    else
+    {
+        used_bytes = dirFileSize(mCacheDir);
+    }
+    if (mPacks)
+    {
+        used_bytes += mPacks->getDiskSize();
+    }
+
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0 * 1024.0);
-    F32 percent_used = ((F32)dirFileSize(mCacheDir) / (F32)mMaxSizeBytes) * 100.0;
+    F32 percent_used = ((F32)used_bytes / (F32)mMaxSizeBytes) * 100.0;
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -367,6 +613,34 @@ void LLDiskCache::clearCache()
             iter.increment(ec);
         }
     }
+
+    if (mUseIndex)
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mIndex.clear();
+    }
+
+    if (mPacks)
+    {
+        mPacks->clear();
+    }
+}
+
+void LLDiskCache::removeUnusedIndex()
+{
+    if (!mUseIndex)
+    {
+        LLFile::remove(getIndexFilepath(), ENOENT);
+    }
+}
+
+const std::string LLDiskCache::getIndexFilepath()
+{
+    /**
+     * Deliberately doesn't start with mCacheFilenamePrefix so that the index
+     * is never mistaken for an asset by the directory scanning code
+     */
+    return mCacheDir + gDirUtilp->getDirDelimiter() + "index.cache";
 }
 
 void LLDiskCache::removeOldVFSFiles()
@@ -457,5 +731,6 @@ void LLPurgeDiskCacheThread::run()
     while (LLApp::instance()->sleep(CHECK_INTERVAL))
     {
         LLDiskCache::instance().purge();
+        LLDiskCache::instance().compactPacks();
     }
 }
@@ -30,7 +30,17 @@
  *    the files is less than the maximum size specified.
  * 4/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
- * 5/ Performance on my modest system seems very acceptable. For
+ * 5/ Optionally (see 'DiskCacheUseIndex') the size and time of last
+ *    access of every file is also kept in a memory mapped index file
+ *    (see lldiskcacheindex.h). In that mode, reads update the index
+ *    rather than the file on disk, lookups do not touch the filesystem
+ *    and the purge removes the least recently used files a batch at a
+ *    time without scanning the cache directory.
+ * 6/ Optionally (see 'DiskCacheUsePackFiles') small assets are appended
+ *    to a few large pack files instead of a file each (see
+ *    lldiskcachepacks.h), which LLFileSystem uses for those asset types.
+ *    Space used by the packs comes out of the space for individual files.
+ * 7/ Performance on my modest system seems very acceptable. For
  *    example, in testing, I was able to purge a directory of
  *    10,000 files, deleting about half of them in ~ 1700ms. For
  *    the same sized directory of files, writing the last updated
@@ -63,6 +73,11 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "llmutex.h"
+#include "lldiskcacheindex.h"
+#include "lldiskcachepacks.h"
+
+#include <memory>
 
 class LLDiskCache :
     public LLParamSingleton<LLDiskCache>
@@ -92,9 +107,20 @@ class LLDiskCache :
                      * if there are bugs, we can ask uses to enable this
                      * setting and send us their logs
                      */
-                    const bool enable_cache_debug_info);
+                    const bool enable_cache_debug_info,
+                    /**
+                     * Keep the cache contents in a memory mapped index
+                     * file rather than relying on the file system alone.
+                     * Based on the setting at 'DiskCacheUseIndex'
+                     */
+                    const bool use_index,
+                    /**
+                     * Store small assets in pack files rather than a file
+                     * each. Based on the setting at 'DiskCacheUsePackFiles'
+                     */
+                    const bool use_packs);
 
-        virtual ~LLDiskCache() = default;
+        virtual ~LLDiskCache();
 
     public:
         /**
@@ -115,6 +141,44 @@ class LLDiskCache :
          */
         void updateFileAccessTime(const std::string file_path);
 
+        /**
+         * True when the cache contents are tracked by the index, in which case
+         * LLFileSystem uses the functions below instead of updateFileAccessTime
+         */
+        bool useIndex() const { return mUseIndex; }
+
+        /**
+         * Look up the size of a cached file in the index without going to the
+         * file system. Returns false if the index has no record of the file.
+         */
+        bool findIndexedFile(const LLUUID& id, U64& size);
+
+        /**
+         * Record a file that was just written (or found on disk) at its current size
+         */
+        void addIndexedFile(const LLUUID& id, LLAssetType::EType at, U64 size);
+
+        /**
+         * Index equivalent of updateFileAccessTime(), only touches memory
+         */
+        void touchIndexedFile(const LLUUID& id);
+
+        /**
+         * Drop a file that was removed (or renamed) from the index
+         */
+        void removeIndexedFile(const LLUUID& id);
+
+        /**
+         * The pack files for small assets, or NULL when they're not in use
+         */
+        LLDiskCachePacks* getPacks() const { return mPacks.get(); }
+
+        /**
+         * Reclaim deleted space in the pack files. Slow, so like purge() it
+         * is called by LLPurgeDiskCacheThread
+         */
+        void compactPacks();
+
         /**
          * Purge the oldest items in the cache so that the combined size of all files
          * is no bigger than mMaxSizeBytes.
@@ -142,6 +206,14 @@ class LLDiskCache :
 
         void removeOldVFSFiles();
 
+        /**
+         * Delete the index file when the index is not in use. Files written in
+         * the meantime are never recorded in it, so this makes sure it gets
+         * rebuilt from scratch if it is ever turned back on. Must not be called
+         * by a viewer that is sharing the cache with another instance.
+         */
+        void removeUnusedIndex();
+
     private:
         /**
          * Utility function to gather the total size the files in a given
@@ -150,6 +222,30 @@ class LLDiskCache :
          */
         uintmax_t dirFileSize(const std::string dir);
 
+        /**
+         * Full path to the index file in the cache directory
+         */
+        const std::string getIndexFilepath();
+
+        /**
+         * mMaxSizeBytes less the space taken by the pack files, the limit purge()
+         * applies to the individual files
+         */
+        uintmax_t getMaxFileSizeBytes();
+
+        /**
+         * Populate an empty index from the files in the cache directory. Only
+         * needed the first time the index is used, or when it was not closed
+         * cleanly, as every later change goes through the index
+         */
+        void rebuildIndex();
+
+        /**
+         * purge() for the indexed mode: remove the least recently used files
+         * in small batches, holding the index lock only while picking them
+         */
+        void purgeIndexed();
+
         /**
          * Utility function to convert an LLAssetType enum into a
          * string that we use as part of the cache file filename
@@ -187,6 +283,24 @@ class LLDiskCache :
          * various parts of the code
          */
         bool mEnableCacheDebugInfo;
+
+        /**
+         * Set when the index file is in use, see 'DiskCacheUseIndex'
+         */
+        bool mUseIndex;
+
+        /**
+         * The index itself and the mutex that guards it - the index is
+         * used from the threads that read and write assets as well as
+         * from LLPurgeDiskCacheThread
+         */
+        LLDiskCacheIndex mIndex;
+        LLMutex mIndexMutex;
+
+        /**
+         * Set when small assets are kept in pack files, see 'DiskCacheUsePackFiles'
+         */
+        std::unique_ptr<LLDiskCachePacks> mPacks;
 };
 
 class LLPurgeDiskCacheThread : public LLThread
@@ -0,0 +1,592 @@
+/**
+ * @file lldiskcacheindex.cpp
+ * @brief Memory mapped index of the files held by the disk cache.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiskcacheindex.h"
+
+#if LL_WINDOWS
+#include "llwin32headers.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <vector>
+
+namespace
+{
+    const U32 INDEX_MAGIC = 0x58444943;     // "CIDX"
+    const U32 INDEX_VERSION = 1;
+
+    // must be a power of two, 16K entries is well under 1 MB of index
+    const U32 MIN_CAPACITY = 16 * 1024;
+
+    const S32 NO_SLOT = -1;
+
+    enum
+    {
+        SLOT_EMPTY = 0,
+        SLOT_USED,
+        SLOT_DELETED
+    };
+}
+
+struct LLDiskCacheIndex::Header
+{
+    U32 mMagic;
+    U32 mVersion;
+    U32 mCapacity;      // number of records that follow the header
+    U32 mCount;         // records in use
+    U32 mDeleted;       // records that are free but still part of a probe sequence
+    S32 mHead;          // most recently used record
+    S32 mTail;          // least recently used record
+    U32 mDirty;         // set while the index is open, so a crash forces a rebuild
+    U64 mTotalSize;     // sum of mSize over the records in use
+    U64 mPad[3];
+};
+
+struct LLDiskCacheIndex::Record
+{
+    U8 mID[UUID_BYTES];
+    U64 mSize;
+    S64 mLastAccess;
+    S32 mPrev;          // next more recently used record
+    S32 mNext;          // next less recently used record
+    S32 mAssetType;
+    U32 mState;
+};
+
+LLDiskCacheIndex::LLDiskCacheIndex() :
+    mBase(nullptr),
+    mMappedBytes(0),
+#if LL_WINDOWS
+    mFile(INVALID_HANDLE_VALUE),
+    mMapping(nullptr)
+#else
+    mFile(-1)
+#endif
+{
+    static_assert(sizeof(Header) == 64, "disk cache index header layout changed, bump INDEX_VERSION");
+    static_assert(sizeof(Record) == 48, "disk cache index record layout changed, bump INDEX_VERSION");
+}
+
+LLDiskCacheIndex::~LLDiskCacheIndex()
+{
+    close();
+}
+
+bool LLDiskCacheIndex::open(const std::string& filename)
+{
+    close();
+
+    size_t file_size = 0;
+#if LL_WINDOWS
+    mFile = CreateFileW(utf8str_to_utf16str(filename).c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        LL_WARNS() << "Unable to open disk cache index " << filename << ": " << GetLastError() << LL_ENDL;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(mFile, &size))
+    {
+        file_size = (size_t)size.QuadPart;
+    }
+#else
+    mFile = ::open(filename.c_str(), O_RDWR | O_CREAT, 0600);
+    if (mFile < 0)
+    {
+        LL_WARNS() << "Unable to open disk cache index " << filename << ": " << strerror(errno) << LL_ENDL;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(mFile, &st) == 0)
+    {
+        file_size = (size_t)st.st_size;
+    }
+#endif
+
+    bool valid = false;
+    if (file_size >= sizeof(Header) && mapFile(file_size))
+    {
+        const Header* header = getHeader();
+        valid = header->mMagic == INDEX_MAGIC &&
+                header->mVersion == INDEX_VERSION &&
+                header->mCapacity >= MIN_CAPACITY &&
+                (header->mCapacity & (header->mCapacity - 1)) == 0 &&
+                file_size == bytesForCapacity(header->mCapacity) &&
+                !header->mDirty;
+    }
+
+    if (!valid)
+    {
+        if (!mapFile(bytesForCapacity(MIN_CAPACITY)))
+        {
+            closeFile();
+            return false;
+        }
+        reset(MIN_CAPACITY);
+    }
+
+    getHeader()->mDirty = 1;
+    flush();
+
+    return valid;
+}
+
+void LLDiskCacheIndex::close()
+{
+    if (mBase)
+    {
+        getHeader()->mDirty = 0;
+#if LL_WINDOWS
+        FlushViewOfFile(mBase, 0);
+        FlushFileBuffers(mFile);
+#else
+        msync(mBase, mMappedBytes, MS_SYNC);
+#endif
+    }
+    unmapFile();
+    closeFile();
+}
+
+void LLDiskCacheIndex::clear()
+{
+    if (mBase && mapFile(bytesForCapacity(MIN_CAPACITY)))
+    {
+        reset(MIN_CAPACITY);
+        getHeader()->mDirty = 1;
+    }
+}
+
+bool LLDiskCacheIndex::find(const LLUUID& id, Entry& entry) const
+{
+    S32 slot = findSlot(id);
+    if (slot == NO_SLOT)
+    {
+        return false;
+    }
+
+    const Record& record = getRecords()[slot];
+    entry.mID = id;
+    entry.mAssetType = (LLAssetType::EType)record.mAssetType;
+    entry.mSize = record.mSize;
+    entry.mLastAccess = (std::time_t)record.mLastAccess;
+    return true;
+}
+
+void LLDiskCacheIndex::insert(const LLUUID& id, LLAssetType::EType at, U64 size, std::time_t access_time)
+{
+    if (!mBase)
+    {
+        return;
+    }
+
+    Header* header = getHeader();
+    S32 slot = findSlot(id);
+    if (slot != NO_SLOT)
+    {
+        unlink(slot);
+        header->mTotalSize -= getRecords()[slot].mSize;
+    }
+    else
+    {
+        if (!reserveSlot())
+        {
+            return;
+        }
+        header = getHeader();
+
+        // first free slot on the probe sequence, findSlot() has told us id isn't further along it
+        U32 mask = header->mCapacity - 1;
+        U32 i = (U32)id.getDigest64() & mask;
+        while (getRecords()[i].mState == SLOT_USED)
+        {
+            i = (i + 1) & mask;
+        }
+
+        if (getRecords()[i].mState == SLOT_DELETED)
+        {
+            header->mDeleted--;
+        }
+        header->mCount++;
+        slot = (S32)i;
+    }
+
+    Record& record = getRecords()[slot];
+    memcpy(record.mID, id.mData, UUID_BYTES);
+    record.mSize = size;
+    record.mLastAccess = (S64)access_time;
+    record.mAssetType = (S32)at;
+    record.mState = SLOT_USED;
+    header->mTotalSize += size;
+    link(slot);
+}
+
+bool LLDiskCacheIndex::touch(const LLUUID& id, std::time_t access_time)
+{
+    S32 slot = findSlot(id);
+    if (slot == NO_SLOT)
+    {
+        return false;
+    }
+
+    getRecords()[slot].mLastAccess = (S64)access_time;
+    if (getHeader()->mHead != slot)
+    {
+        unlink(slot);
+        link(slot);
+    }
+    return true;
+}
+
+bool LLDiskCacheIndex::remove(const LLUUID& id)
+{
+    S32 slot = findSlot(id);
+    if (slot == NO_SLOT)
+    {
+        return false;
+    }
+
+    release(slot);
+    return true;
+}
+
+bool LLDiskCacheIndex::popOldest(Entry& entry)
+{
+    if (!mBase || getHeader()->mTail == NO_SLOT)
+    {
+        return false;
+    }
+
+    S32 slot = getHeader()->mTail;
+    const Record& record = getRecords()[slot];
+    memcpy(entry.mID.mData, record.mID, UUID_BYTES);
+    entry.mAssetType = (LLAssetType::EType)record.mAssetType;
+    entry.mSize = record.mSize;
+    entry.mLastAccess = (std::time_t)record.mLastAccess;
+
+    release(slot);
+    return true;
+}
+
+U32 LLDiskCacheIndex::getCount() const
+{
+    return mBase ? getHeader()->mCount : 0;
+}
+
+U64 LLDiskCacheIndex::getTotalSize() const
+{
+    return mBase ? getHeader()->mTotalSize : 0;
+}
+
+void LLDiskCacheIndex::flush()
+{
+    if (mBase)
+    {
+#if LL_WINDOWS
+        FlushViewOfFile(mBase, 0);
+#else
+        msync(mBase, mMappedBytes, MS_ASYNC);
+#endif
+    }
+}
+
+LLDiskCacheIndex::Header* LLDiskCacheIndex::getHeader() const
+{
+    return (Header*)mBase;
+}
+
+LLDiskCacheIndex::Record* LLDiskCacheIndex::getRecords() const
+{
+    return (Record*)(mBase + sizeof(Header));
+}
+
+// static
+size_t LLDiskCacheIndex::bytesForCapacity(U32 capacity)
+{
+    return sizeof(Header) + (size_t)capacity * sizeof(Record);
+}
+
+S32 LLDiskCacheIndex::findSlot(const LLUUID& id) const
+{
+    if (!mBase)
+    {
+        return NO_SLOT;
+    }
+
+    const Header* header = getHeader();
+    const Record* records = getRecords();
+    U32 mask = header->mCapacity - 1;
+    U32 i = (U32)id.getDigest64() & mask;
+    for (U32 probes = 0; probes < header->mCapacity; ++probes, i = (i + 1) & mask)
+    {
+        const Record& record = records[i];
+        if (record.mState == SLOT_EMPTY)
+        {
+            break;
+        }
+        if (record.mState == SLOT_USED && memcmp(record.mID, id.mData, UUID_BYTES) == 0)
+        {
+            return (S32)i;
+        }
+    }
+    return NO_SLOT;
+}
+
+bool LLDiskCacheIndex::reserveSlot()
+{
+    const Header* header = getHeader();
+
+    // keep at least a quarter of the table empty so probe sequences stay short
+    if ((header->mCount + header->mDeleted + 1) * 4 > header->mCapacity * 3)
+    {
+        // double if mostly in use, otherwise just clear out the deleted records
+        U32 capacity = header->mCapacity;
+        if ((header->mCount + 1) * 2 > capacity)
+        {
+            capacity *= 2;
+        }
+        rehash(capacity);
+    }
+
+    // a failed rehash may have left the index unmapped, or still full
+    return mBase && getHeader()->mCount < getHeader()->mCapacity;
+}
+
+void LLDiskCacheIndex::reset(U32 capacity)
+{
+    memset(mBase, 0, mMappedBytes);
+
+    Header* header = getHeader();
+    header->mMagic = INDEX_MAGIC;
+    header->mVersion = INDEX_VERSION;
+    header->mCapacity = capacity;
+    header->mHead = NO_SLOT;
+    header->mTail = NO_SLOT;
+}
+
+void LLDiskCacheIndex::rehash(U32 capacity)
+{
+    // copy out the live records, oldest first, so inserting them in order rebuilds the same LRU list
+    std::vector<Record> records;
+    records.reserve(getHeader()->mCount);
+    for (S32 slot = getHeader()->mTail; slot != NO_SLOT; slot = getRecords()[slot].mPrev)
+    {
+        records.push_back(getRecords()[slot]);
+    }
+
+    if (!mapFile(bytesForCapacity(capacity)))
+    {
+        // mapFile() restores the old mapping if it couldn't resize the file, so carry on with it
+        LL_WARNS() << "Unable to resize disk cache index to " << capacity << " entries" << LL_ENDL;
+        return;
+    }
+    reset(capacity);
+    getHeader()->mDirty = 1;
+
+    for (const Record& record : records)
+    {
+        LLUUID id;
+        memcpy(id.mData, record.mID, UUID_BYTES);
+        insert(id, (LLAssetType::EType)record.mAssetType, record.mSize, (std::time_t)record.mLastAccess);
+    }
+}
+
+void LLDiskCacheIndex::link(S32 slot)
+{
+    Header* header = getHeader();
+    Record& record = getRecords()[slot];
+
+    record.mPrev = NO_SLOT;
+    record.mNext = header->mHead;
+    if (header->mHead != NO_SLOT)
+    {
+        getRecords()[header->mHead].mPrev = slot;
+    }
+    header->mHead = slot;
+    if (header->mTail == NO_SLOT)
+    {
+        header->mTail = slot;
+    }
+}
+
+void LLDiskCacheIndex::unlink(S32 slot)
+{
+    Header* header = getHeader();
+    Record& record = getRecords()[slot];
+
+    if (record.mPrev != NO_SLOT)
+    {
+        getRecords()[record.mPrev].mNext = record.mNext;
+    }
+    else
+    {
+        header->mHead = record.mNext;
+    }
+
+    if (record.mNext != NO_SLOT)
+    {
+        getRecords()[record.mNext].mPrev = record.mPrev;
+    }
+    else
+    {
+        header->mTail = record.mPrev;
+    }
+
+    record.mPrev = record.mNext = NO_SLOT;
+}
+
+void LLDiskCacheIndex::release(S32 slot)
+{
+    Header* header = getHeader();
+    Record& record = getRecords()[slot];
+
+    unlink(slot);
+    header->mTotalSize -= record.mSize;
+    header->mCount--;
+    header->mDeleted++;
+    record.mState = SLOT_DELETED;
+    record.mSize = 0;
+}
+
+bool LLDiskCacheIndex::mapFile(size_t bytes)
+{
+#if LL_WINDOWS
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    // the file can't be resized while it is mapped
+    size_t old_bytes = mMappedBytes;
+    bool was_mapped = mBase != nullptr;
+    unmapFile();
+
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)bytes;
+    if (!SetFilePointerEx(mFile, size, NULL, FILE_BEGIN) || !SetEndOfFile(mFile))
+    {
+        LL_WARNS() << "Unable to resize disk cache index: " << GetLastError() << LL_ENDL;
+        if (was_mapped && bytes != old_bytes)
+        {
+            mapFile(old_bytes);
+        }
+        return false;
+    }
+
+    mMapping = CreateFileMappingW(mFile, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+    if (!mMapping)
+    {
+        LL_WARNS() << "Unable to map disk cache index: " << GetLastError() << LL_ENDL;
+        return false;
+    }
+
+    mBase = (U8*)MapViewOfFile(mMapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!mBase)
+    {
+        LL_WARNS() << "Unable to map disk cache index: " << GetLastError() << LL_ENDL;
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+        return false;
+    }
+#else
+    if (mFile < 0)
+    {
+        return false;
+    }
+
+    size_t old_bytes = mMappedBytes;
+    bool was_mapped = mBase != nullptr;
+    unmapFile();
+
+    if (ftruncate(mFile, (off_t)bytes) != 0)
+    {
+        LL_WARNS() << "Unable to resize disk cache index: " << strerror(errno) << LL_ENDL;
+        if (was_mapped && bytes != old_bytes)
+        {
+            mapFile(old_bytes);
+        }
+        return false;
+    }
+
+    void* base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0);
+    if (base == MAP_FAILED)
+    {
+        LL_WARNS() << "Unable to map disk cache index: " << strerror(errno) << LL_ENDL;
+        return false;
+    }
+    mBase = (U8*)base;
+#endif
+
+    mMappedBytes = bytes;
+    return true;
+}
+
+void LLDiskCacheIndex::unmapFile()
+{
+#if LL_WINDOWS
+    if (mBase)
+    {
+        UnmapViewOfFile(mBase);
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+    }
+#else
+    if (mBase)
+    {
+        munmap(mBase, mMappedBytes);
+    }
+#endif
+    mBase = nullptr;
+    mMappedBytes = 0;
+}
+
+void LLDiskCacheIndex::closeFile()
+{
+#if LL_WINDOWS
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFile);
+        mFile = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (mFile >= 0)
+    {
+        ::close(mFile);
+        mFile = -1;
+    }
+#endif
+}
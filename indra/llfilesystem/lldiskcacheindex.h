@@ -0,0 +1,170 @@
+/**
+ * @file lldiskcacheindex.h
+ * @brief Memory mapped index of the files held by the disk cache.
+ *
+ * @Description:
+ * The index is a single file in the cache folder that holds an open
+ * addressing hash table of fixed size records, one per cached asset,
+ * keyed on the asset UUID (the part of the cache filename that identifies
+ * a file - see LLDiskCache::metaDataToFilepath). Each record also holds
+ * the asset type, the size of the file and the time it was last accessed,
+ * and the records are threaded on a doubly linked list in order of last
+ * access so that the least recently used file can be found without
+ * looking at the filesystem.
+ *
+ * The file is mapped into memory, so lookups and access time updates are
+ * plain memory operations and the OS writes the dirty pages back in its
+ * own time (or when flush() is called).
+ *
+ * This class does no locking of its own - LLDiskCache wraps it in a mutex.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef _LLDISKCACHEINDEX
+#define _LLDISKCACHEINDEX
+
+#include "llassettype.h"
+#include "lluuid.h"
+
+#include <ctime>
+
+class LLDiskCacheIndex
+{
+    public:
+        /**
+         * What the index knows about one cached file
+         */
+        struct Entry
+        {
+            LLUUID mID;
+            LLAssetType::EType mAssetType;
+            U64 mSize;
+            std::time_t mLastAccess;
+        };
+
+        LLDiskCacheIndex();
+        ~LLDiskCacheIndex();
+
+        /**
+         * Open (creating if needed) and map the index file. Returns true if
+         * an existing index was loaded. Returns false if the index had to be
+         * started from scratch - because it did not exist, was written by a
+         * different version or was not closed cleanly - in which case the
+         * caller should repopulate it from the files in the cache folder,
+         * or if the file could not be opened at all, in which case isOpen()
+         * will also return false.
+         */
+        bool open(const std::string& filename);
+
+        /**
+         * Write everything back to disk, mark the index as cleanly closed
+         * and unmap it
+         */
+        void close();
+
+        bool isOpen() const { return mBase != nullptr; }
+
+        /**
+         * Remove every entry
+         */
+        void clear();
+
+        /**
+         * Look up the entry for id, returns false if there isn't one
+         */
+        bool find(const LLUUID& id, Entry& entry) const;
+
+        /**
+         * Add an entry for id, or replace the existing one, and make it the
+         * most recently used
+         */
+        void insert(const LLUUID& id, LLAssetType::EType at, U64 size, std::time_t access_time);
+
+        /**
+         * Update the access time of the entry for id and make it the most
+         * recently used. Returns false if there is no entry for id.
+         */
+        bool touch(const LLUUID& id, std::time_t access_time);
+
+        /**
+         * Remove the entry for id, returns false if there wasn't one
+         */
+        bool remove(const LLUUID& id);
+
+        /**
+         * Remove the least recently used entry, copying it to entry.
+         * Returns false if the index is empty.
+         */
+        bool popOldest(Entry& entry);
+
+        /**
+         * Number of entries and the combined size of their files
+         */
+        U32 getCount() const;
+        U64 getTotalSize() const;
+
+        /**
+         * Ask the OS to start writing the mapped pages back to disk. Updates
+         * between calls are only in memory so this is what batches them up.
+         */
+        void flush();
+
+    private:
+        struct Header;
+        struct Record;
+
+        Header* getHeader() const;
+        Record* getRecords() const;
+
+        static size_t bytesForCapacity(U32 capacity);
+
+        // returns the slot holding id or -1
+        S32 findSlot(const LLUUID& id) const;
+        // grows or compacts the table if another insert would load it too much,
+        // returns false if there is no room for another entry
+        bool reserveSlot();
+        void reset(U32 capacity);
+        void rehash(U32 capacity);
+
+        void link(S32 slot);
+        void unlink(S32 slot);
+        void release(S32 slot);
+
+        // (re)size the open file to bytes and map all of it
+        bool mapFile(size_t bytes);
+        void unmapFile();
+        void closeFile();
+
+    private:
+        U8* mBase;
+        size_t mMappedBytes;
+
+#if LL_WINDOWS
+        void* mFile;      // HANDLE
+        void* mMapping;   // HANDLE
+#else
+        int mFile;
+#endif
+};
+
+#endif // _LLDISKCACHEINDEX
@@ -0,0 +1,554 @@
+/**
+ * @file lldiskcachepacks.cpp
+ * @brief Pack file storage for small disk cache assets.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiskcachepacks.h"
+
+#include "lldir.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+
+namespace
+{
+    const U32 RECORD_MAGIC = 0x4b434150;    // "PACK"
+
+    const U32 RECORD_LIVE = 0;
+    const U32 RECORD_DELETED = 1;
+
+    // start a new pack once the newest reaches this size, also keeps offsets well inside 32 bits
+    const U32 PACK_MAX_BYTES = 64 * 1024 * 1024;
+
+    // packs with less than this fraction of their size still in use get compacted
+    const F32 COMPACT_LIVE_RATIO = 0.5f;
+
+    const char PACK_FILENAME_PREFIX[] = "assets_";
+    const char PACK_FILENAME_SUFFIX[] = ".pack";
+
+    struct RecordHeader
+    {
+        U32 mMagic;
+        U32 mFlags;
+        U8 mID[UUID_BYTES];
+        U64 mSequence;
+        S32 mAssetType;
+        U32 mSize;
+    };
+
+    static_assert(sizeof(RecordHeader) == 40, "pack record header layout changed, existing packs will be unreadable");
+}
+
+LLDiskCachePacks::LLDiskCachePacks(const std::string& dir, U64 max_size_bytes) :
+    mDir(dir),
+    mMaxSizeBytes(max_size_bytes),
+    mNextSequence(1)
+{
+    LLMutexLock lock(&mMutex);
+    load();
+}
+
+LLDiskCachePacks::~LLDiskCachePacks()
+{
+    LLMutexLock lock(&mMutex);
+    mEntries.clear();
+    mPacks.clear();
+}
+
+// static
+bool LLDiskCachePacks::isPackedType(LLAssetType::EType at)
+{
+    switch (at)
+    {
+        case LLAssetType::AT_SOUND:
+        case LLAssetType::AT_CALLINGCARD:
+        case LLAssetType::AT_LANDMARK:
+        case LLAssetType::AT_SCRIPT:
+        case LLAssetType::AT_CLOTHING:
+        case LLAssetType::AT_NOTECARD:
+        case LLAssetType::AT_LSL_TEXT:
+        case LLAssetType::AT_LSL_BYTECODE:
+        case LLAssetType::AT_BODYPART:
+        case LLAssetType::AT_ANIMATION:
+        case LLAssetType::AT_GESTURE:
+        case LLAssetType::AT_SETTINGS:
+        case LLAssetType::AT_MATERIAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool LLDiskCachePacks::getSize(const LLUUID& id, S32& size)
+{
+    LLMutexLock lock(&mMutex);
+    entry_map_t::iterator iter = mEntries.find(id);
+    if (iter == mEntries.end())
+    {
+        return false;
+    }
+
+    size = (S32)iter->second.mSize;
+    return true;
+}
+
+S32 LLDiskCachePacks::read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes)
+{
+    LLMutexLock lock(&mMutex);
+    entry_map_t::iterator iter = mEntries.find(id);
+    if (iter == mEntries.end() || offset < 0 || bytes <= 0 || (U32)offset >= iter->second.mSize)
+    {
+        return 0;
+    }
+
+    U32 count = llmin((U32)bytes, iter->second.mSize - (U32)offset);
+    return readData(iter->second, (U32)offset, buffer, count) ? (S32)count : 0;
+}
+
+S32 LLDiskCachePacks::write(const LLUUID& id, LLAssetType::EType at, S32 offset, const U8* buffer, S32 bytes, bool truncate)
+{
+    LLMutexLock lock(&mMutex);
+
+    // records are never rewritten in place, so build the whole asset and append it as a new record
+    std::vector<U8> data;
+    entry_map_t::iterator iter = mEntries.find(id);
+    if (!truncate && iter != mEntries.end())
+    {
+        data.resize(iter->second.mSize);
+        if (!data.empty() && !readData(iter->second, 0, data.data(), (U32)data.size()))
+        {
+            return -1;
+        }
+    }
+
+    if (offset < 0)
+    {
+        offset = (S32)data.size();
+    }
+    if (data.size() < (size_t)(offset + bytes))
+    {
+        data.resize(offset + bytes);
+    }
+    if (bytes > 0)
+    {
+        memcpy(data.data() + offset, buffer, bytes);
+    }
+
+    if (!appendRecord(id, at, data.data(), (U32)data.size()))
+    {
+        return -1;
+    }
+    return (S32)data.size();
+}
+
+bool LLDiskCachePacks::remove(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    entry_map_t::iterator iter = mEntries.find(id);
+    if (iter == mEntries.end())
+    {
+        return false;
+    }
+
+    markDeleted(iter->second);
+    mEntries.erase(iter);
+    return true;
+}
+
+bool LLDiskCachePacks::rename(const LLUUID& old_id, const LLUUID& new_id, LLAssetType::EType new_at)
+{
+    LLMutexLock lock(&mMutex);
+    entry_map_t::iterator iter = mEntries.find(old_id);
+    if (iter == mEntries.end())
+    {
+        return false;
+    }
+    if (old_id == new_id && iter->second.mAssetType == (S32)new_at)
+    {
+        return true;
+    }
+
+    // copied rather than relabelled in place, a torn header write must never leave data under the wrong id
+    std::vector<U8> data(iter->second.mSize);
+    if (!data.empty() && !readData(iter->second, 0, data.data(), (U32)data.size()))
+    {
+        return false;
+    }
+
+    Location old_location = iter->second;
+    if (!appendRecord(new_id, new_at, data.data(), (U32)data.size()))
+    {
+        return false;
+    }
+
+    if (old_id != new_id)
+    {
+        markDeleted(old_location);
+        mEntries.erase(old_id);
+    }
+    return true;
+}
+
+void LLDiskCachePacks::compact()
+{
+    std::vector<U32> sparse_packs;
+    {
+        LLMutexLock lock(&mMutex);
+
+        // over budget: drop whole packs, oldest first, but always keep the one being written to
+        U64 disk_size = 0;
+        for (pack_map_t::value_type& pack : mPacks)
+        {
+            disk_size += pack.second.mSize;
+        }
+        while (mPacks.size() > 1 && disk_size > mMaxSizeBytes)
+        {
+            disk_size -= mPacks.begin()->second.mSize;
+            LL_INFOS() << "Dropping the oldest disk cache pack to stay under " << mMaxSizeBytes << " bytes" << LL_ENDL;
+            deletePack(mPacks.begin()->first);
+        }
+
+        U32 active_pack = mPacks.empty() ? 0 : mPacks.rbegin()->first;
+        for (pack_map_t::value_type& pack : mPacks)
+        {
+            if (pack.first != active_pack && pack.second.mLiveBytes < pack.second.mSize * COMPACT_LIVE_RATIO)
+            {
+                sparse_packs.push_back(pack.first);
+            }
+        }
+    }
+
+    // move the live records out a record at a time so readers and writers aren't held up for long
+    std::vector<LLUUID> ids;
+    std::vector<U8> data;
+    for (U32 number : sparse_packs)
+    {
+        ids.clear();
+        {
+            LLMutexLock lock(&mMutex);
+            for (entry_map_t::value_type& entry : mEntries)
+            {
+                if (entry.second.mPack == number)
+                {
+                    ids.push_back(entry.first);
+                }
+            }
+        }
+
+        for (const LLUUID& id : ids)
+        {
+            LLMutexLock lock(&mMutex);
+            entry_map_t::iterator iter = mEntries.find(id);
+            if (iter == mEntries.end() || iter->second.mPack != number)
+            {
+                // removed or rewritten since we looked
+                continue;
+            }
+
+            Location location = iter->second;
+            data.resize(location.mSize);
+            if (!data.empty() && !readData(location, 0, data.data(), location.mSize))
+            {
+                continue;
+            }
+            appendRecord(id, (LLAssetType::EType)location.mAssetType, data.data(), location.mSize);
+        }
+
+        LLMutexLock lock(&mMutex);
+        // anything that couldn't be moved goes with the pack
+        deletePack(number);
+    }
+
+    if (!sparse_packs.empty())
+    {
+        LL_INFOS() << "Compacted " << sparse_packs.size() << " disk cache packs" << LL_ENDL;
+    }
+}
+
+void LLDiskCachePacks::clear()
+{
+    LLMutexLock lock(&mMutex);
+    while (!mPacks.empty())
+    {
+        deletePack(mPacks.begin()->first);
+    }
+    mEntries.clear();
+}
+
+U64 LLDiskCachePacks::getDiskSize()
+{
+    LLMutexLock lock(&mMutex);
+    U64 disk_size = 0;
+    for (pack_map_t::value_type& pack : mPacks)
+    {
+        disk_size += pack.second.mSize;
+    }
+    return disk_size;
+}
+
+void LLDiskCachePacks::load()
+{
+    const std::string prefix(PACK_FILENAME_PREFIX);
+    const std::string suffix(PACK_FILENAME_SUFFIX);
+
+    std::vector<U32> numbers;
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(mDir));
+#else
+    std::string cache_path(mDir);
+#endif
+    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    {
+        boost::filesystem::directory_iterator iter(cache_path, ec);
+        while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+        {
+            const std::string file_name = (*iter).path().filename().string();
+            if (file_name.length() > prefix.length() + suffix.length() &&
+                file_name.compare(0, prefix.length(), prefix) == 0 &&
+                file_name.compare(file_name.length() - suffix.length(), suffix.length(), suffix) == 0)
+            {
+                const std::string number = file_name.substr(prefix.length(), file_name.length() - prefix.length() - suffix.length());
+                if (number.length() <= 9 && number.find_first_not_of("0123456789") == std::string::npos)
+                {
+                    numbers.push_back((U32)std::stoul(number));
+                }
+            }
+            iter.increment(ec);
+        }
+    }
+
+    // in order, so that a duplicate record in a later pack is seen after the one it replaced
+    std::sort(numbers.begin(), numbers.end());
+    for (U32 number : numbers)
+    {
+        loadPack(number);
+    }
+
+    LL_INFOS() << "Loaded " << mEntries.size() << " assets from " << mPacks.size() << " disk cache packs" << LL_ENDL;
+}
+
+void LLDiskCachePacks::loadPack(U32 number)
+{
+    const std::string file_path = getPackFilepath(number);
+
+    Pack& pack = mPacks[number];
+    pack.mFile = LLFile::fopen(file_path, "r+b");
+    pack.mSize = 0;
+    pack.mLiveBytes = 0;
+    if (!pack.mFile)
+    {
+        LL_WARNS() << "Unable to open disk cache pack " << file_path << LL_ENDL;
+        mPacks.erase(number);
+        return;
+    }
+
+    fseek(pack.mFile, 0, SEEK_END);
+    const long file_size = ftell(pack.mFile);
+
+    long offset = 0;
+    RecordHeader header;
+    while (fseek(pack.mFile, offset, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, pack.mFile) == 1)
+    {
+        const long record_size = (long)(sizeof(header) + header.mSize);
+        if (header.mMagic != RECORD_MAGIC || header.mSize > PACK_MAX_BYTES || offset + record_size > file_size)
+        {
+            break;
+        }
+
+        if (header.mFlags == RECORD_LIVE)
+        {
+            LLUUID id;
+            memcpy(id.mData, header.mID, UUID_BYTES);
+            Location location = { number, (U32)offset, header.mSize, header.mAssetType, header.mSequence };
+            pack.mLiveBytes += (U32)record_size;
+
+            std::pair<entry_map_t::iterator, bool> result = mEntries.emplace(id, location);
+            if (!result.second)
+            {
+                // the viewer stopped between writing a new copy and flagging the old one
+                Location& existing = result.first->second;
+                if (existing.mSequence < location.mSequence)
+                {
+                    markDeleted(existing);
+                    existing = location;
+                }
+                else
+                {
+                    markDeleted(location);
+                }
+            }
+            mNextSequence = llmax(mNextSequence, header.mSequence + 1);
+        }
+
+        offset += record_size;
+    }
+
+    if (offset < file_size)
+    {
+        // the end of the last record written didn't make it to disk, cut the pack back to the last complete one
+        LL_WARNS() << "Truncating disk cache pack " << file_path << " from " << file_size << " to " << offset << " bytes" << LL_ENDL;
+        pack.mFile.close();
+        boost::system::error_code ec;
+#if LL_WINDOWS
+        boost::filesystem::resize_file(utf8str_to_utf16str(file_path), offset, ec);
+#else
+        boost::filesystem::resize_file(file_path, offset, ec);
+#endif
+        pack.mFile = LLFile::fopen(file_path, "r+b");
+        if (ec.failed() || !pack.mFile)
+        {
+            deletePack(number);
+            return;
+        }
+    }
+
+    pack.mSize = (U32)offset;
+}
+
+LLDiskCachePacks::Pack* LLDiskCachePacks::getActivePack()
+{
+    if (!mPacks.empty() && mPacks.rbegin()->second.mSize < PACK_MAX_BYTES)
+    {
+        return &mPacks.rbegin()->second;
+    }
+
+    U32 number = mPacks.empty() ? 0 : mPacks.rbegin()->first + 1;
+    const std::string file_path = getPackFilepath(number);
+
+    Pack pack;
+    pack.mFile = LLFile::fopen(file_path, "w+b");
+    pack.mSize = 0;
+    pack.mLiveBytes = 0;
+    if (!pack.mFile)
+    {
+        LL_WARNS() << "Unable to create disk cache pack " << file_path << LL_ENDL;
+        return nullptr;
+    }
+
+    return &(mPacks[number] = std::move(pack));
+}
+
+bool LLDiskCachePacks::appendRecord(const LLUUID& id, LLAssetType::EType at, const U8* data, U32 size)
+{
+    Pack* pack = getActivePack();
+    if (!pack)
+    {
+        return false;
+    }
+    const U32 number = mPacks.rbegin()->first;
+
+    RecordHeader header;
+    header.mMagic = RECORD_MAGIC;
+    header.mFlags = RECORD_LIVE;
+    memcpy(header.mID, id.mData, UUID_BYTES);
+    header.mSequence = mNextSequence++;
+    header.mAssetType = (S32)at;
+    header.mSize = size;
+
+    // a failure part way leaves junk past mSize, which the next record overwrites
+    if (fseek(pack->mFile, pack->mSize, SEEK_SET) != 0 ||
+        fwrite(&header, sizeof(header), 1, pack->mFile) != 1 ||
+        (size && fwrite(data, size, 1, pack->mFile) != 1) ||
+        fflush(pack->mFile) != 0)
+    {
+        LL_WARNS() << "Failed to write " << id << " to disk cache pack " << number << LL_ENDL;
+        return false;
+    }
+
+    // only flag the old copy once the new one is safely written
+    entry_map_t::iterator iter = mEntries.find(id);
+    if (iter != mEntries.end())
+    {
+        markDeleted(iter->second);
+    }
+
+    Location location = { number, pack->mSize, size, (S32)at, header.mSequence };
+    mEntries[id] = location;
+
+    const U32 record_size = sizeof(header) + size;
+    pack->mSize += record_size;
+    pack->mLiveBytes += record_size;
+    return true;
+}
+
+bool LLDiskCachePacks::readData(const Location& location, U32 offset, U8* buffer, U32 bytes)
+{
+    pack_map_t::iterator iter = mPacks.find(location.mPack);
+    if (iter == mPacks.end())
+    {
+        return false;
+    }
+
+    LLFILE* file = iter->second.mFile;
+    return fseek(file, location.mOffset + sizeof(RecordHeader) + offset, SEEK_SET) == 0 &&
+           fread(buffer, bytes, 1, file) == 1;
+}
+
+void LLDiskCachePacks::markDeleted(const Location& location)
+{
+    pack_map_t::iterator iter = mPacks.find(location.mPack);
+    if (iter == mPacks.end())
+    {
+        return;
+    }
+
+    // not flushed: if this is lost, the sequence number (for a replaced record) or
+    // the next removal (for a removed one) sorts it out
+    Pack& pack = iter->second;
+    if (fseek(pack.mFile, location.mOffset + offsetof(RecordHeader, mFlags), SEEK_SET) == 0)
+    {
+        fwrite(&RECORD_DELETED, sizeof(RECORD_DELETED), 1, pack.mFile);
+    }
+    pack.mLiveBytes -= llmin(pack.mLiveBytes, (U32)sizeof(RecordHeader) + location.mSize);
+}
+
+void LLDiskCachePacks::deletePack(U32 number)
+{
+    for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); )
+    {
+        if (iter->second.mPack == number)
+        {
+            iter = mEntries.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    mPacks.erase(number);
+    LLFile::remove(getPackFilepath(number), ENOENT);
+}
+
+const std::string LLDiskCachePacks::getPackFilepath(U32 number) const
+{
+    std::ostringstream file_path;
+    file_path << mDir << gDirUtilp->getDirDelimiter() << PACK_FILENAME_PREFIX
+              << std::setw(5) << std::setfill('0') << number << PACK_FILENAME_SUFFIX;
+    return file_path.str();
+}
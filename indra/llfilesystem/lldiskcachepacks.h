@@ -0,0 +1,163 @@
+/**
+ * @file lldiskcachepacks.h
+ * @brief Pack file storage for small disk cache assets.
+ *
+ * @Description:
+ * Most assets in the disk cache are small (gestures, notecards, animations,
+ * sounds etc.) and giving each one its own file costs an inode and an
+ * open() call every time it is touched. These assets are instead appended
+ * to a handful of large pack files:
+ * 1/ Each pack file is a sequence of records - a fixed size header with
+ *    the asset UUID, type, size and a sequence number, followed by the
+ *    asset data.
+ * 2/ Records are never modified except to flag them as deleted, so an
+ *    asset that changes is written again as a new record at the end of
+ *    the newest pack and the old record is flagged. When two live records
+ *    exist for the same asset (a crash between writing one and flagging
+ *    the other) the one with the higher sequence number wins.
+ * 3/ The offset index is held in memory and built by reading the record
+ *    headers of every pack file when the cache starts.
+ * 4/ Deleted records are reclaimed by compact(), which is called from
+ *    LLPurgeDiskCacheThread and copies the live records out of packs that
+ *    are mostly garbage before deleting them. It also drops the oldest
+ *    pack entirely when the packs grow past their share of the cache.
+ *
+ * All public functions lock, so the packs can be used from any thread.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef _LLDISKCACHEPACKS
+#define _LLDISKCACHEPACKS
+
+#include "llassettype.h"
+#include "llfile.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class LLDiskCachePacks
+{
+    public:
+        /**
+         * dir is the disk cache folder, the packs are kept in it alongside
+         * the regular cache files. max_size_bytes is how much of the cache
+         * the packs may use before compact() starts dropping old packs.
+         */
+        LLDiskCachePacks(const std::string& dir, U64 max_size_bytes);
+        ~LLDiskCachePacks();
+
+        /**
+         * True for the asset types that are stored in packs rather than in
+         * a file of their own. Large assets (textures, meshes) are not.
+         */
+        static bool isPackedType(LLAssetType::EType at);
+
+        /**
+         * Size of the asset in bytes, returns false if it isn't in the packs
+         */
+        bool getSize(const LLUUID& id, S32& size);
+
+        /**
+         * Copy up to bytes of the asset starting at offset into buffer and
+         * return the number of bytes copied (0 if it isn't in the packs)
+         */
+        S32 read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes);
+
+        /**
+         * Write bytes of buffer to the asset at offset, keeping the rest of the
+         * existing data unless truncate is set. An offset of -1 appends.
+         * Returns the new size of the asset, or -1 if it couldn't be written.
+         */
+        S32 write(const LLUUID& id, LLAssetType::EType at, S32 offset, const U8* buffer, S32 bytes, bool truncate);
+
+        /**
+         * Remove an asset, returns false if it wasn't in the packs
+         */
+        bool remove(const LLUUID& id);
+
+        /**
+         * Give an asset a new id (and type), replacing any asset that already
+         * has that id. Returns false if old_id wasn't in the packs.
+         */
+        bool rename(const LLUUID& old_id, const LLUUID& new_id, LLAssetType::EType new_at);
+
+        /**
+         * Reclaim the space used by deleted records and keep the packs within
+         * their share of the cache. Slow - call from a background thread.
+         */
+        void compact();
+
+        /**
+         * Delete every pack
+         */
+        void clear();
+
+        /**
+         * Combined size of the pack files, including deleted records
+         */
+        U64 getDiskSize();
+
+    private:
+        struct Location
+        {
+            U32 mPack;          // pack number
+            U32 mOffset;        // offset of the record header in the pack
+            U32 mSize;          // size of the data that follows the header
+            S32 mAssetType;
+            U64 mSequence;
+        };
+
+        struct Pack
+        {
+            LLUniqueFile mFile;
+            U32 mSize;          // file size, new records are written here
+            U32 mLiveBytes;     // size of the records that haven't been deleted
+        };
+
+        typedef std::unordered_map<LLUUID, Location> entry_map_t;
+        typedef std::map<U32, Pack> pack_map_t;
+
+        // everything below must be called with mMutex locked
+        void load();
+        void loadPack(U32 number);
+        Pack* getActivePack();
+        bool appendRecord(const LLUUID& id, LLAssetType::EType at, const U8* data, U32 size);
+        bool readData(const Location& location, U32 offset, U8* buffer, U32 bytes);
+        void markDeleted(const Location& location);
+        void deletePack(U32 number);
+        const std::string getPackFilepath(U32 number) const;
+
+    private:
+        std::string mDir;
+        U64 mMaxSizeBytes;
+
+        LLMutex mMutex;
+        entry_map_t mEntries;
+        pack_map_t mPacks;
+        U64 mNextSequence;
+};
+
+#endif // _LLDISKCACHEPACKS
@@ -41,6 +41,13 @@ const S32 LLFileSystem::APPEND      = 0x00000006;  // 0x00000004 & LLFileSystem:
 
 static LLTrace::BlockTimerStatHandle FTM_VFILE_WAIT("VFile Wait");
 
+// the disk cache packs if assets of this type are written to them, NULL if they get a file of their own
+static LLDiskCachePacks* get_packs(const LLAssetType::EType file_type)
+{
+    LLDiskCachePacks* packs = LLDiskCache::getInstance()->getPacks();
+    return packs && LLDiskCachePacks::isPackedType(file_type) ? packs : NULL;
+}
+
 LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode)
 {
     mFileType = file_type;
@@ -52,7 +59,16 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     // This block of code was originally called in the read() method but after comments here:
     // https://bitbucket.org/lindenlab/viewer/commits/e28c1b46e9944f0215a13cab8ee7dded88d7fc90#comment-10537114
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
-    if (mode == LLFileSystem::READ)
+    if (mode == LLFileSystem::READ && get_packs(mFileType))
+    {
+        // pack files don't track access times, old packs are dropped as a whole
+    }
+    else if (mode == LLFileSystem::READ && LLDiskCache::getInstance()->useIndex())
+    {
+        // the index keeps the access time itself so there is no need to go to the file system
+        LLDiskCache::getInstance()->touchIndexedFile(mFileID);
+    }
+    else if (mode == LLFileSystem::READ)
     {
         // build the filename (TODO: we do this in a few places - perhaps we should factor into a single function)
         std::string id;
@@ -79,6 +95,20 @@ LLFileSystem::~LLFileSystem()
 // static
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
+    LLDiskCachePacks* packs = get_packs(file_type);
+    S32 packed_size = 0;
+    if (packs && packs->getSize(file_id, packed_size))
+    {
+        return packed_size > 0;
+    }
+
+    // not in the packs, but could be a file written before they were turned on
+    U64 indexed_size = 0;
+    if (LLDiskCache::getInstance()->findIndexedFile(file_id, indexed_size))
+    {
+        return indexed_size > 0;
+    }
+
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -88,7 +118,13 @@ bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType fil
     if (file.is_open())
     {
         file.seekg(0, std::ios::end);
-        return file.tellg() > 0;
+        S64 file_size = file.tellg();
+        if (file_size > 0)
+        {
+            // not in the index (yet) but on disk, remember it so the next lookup is quick
+            LLDiskCache::getInstance()->addIndexedFile(file_id, file_type, file_size);
+            return true;
+        }
     }
     return false;
 }
@@ -101,7 +137,15 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
     const std::string extra_info = "";
     const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
 
+    LLDiskCachePacks* packs = get_packs(file_type);
+    if (packs && packs->remove(file_id))
+    {
+        // there may still be a file from before the packs were turned on
+        suppress_error = ENOENT;
+    }
+
     LLFile::remove(filename.c_str(), suppress_error);
+    LLDiskCache::getInstance()->removeIndexedFile(file_id);
 
     return true;
 }
@@ -122,6 +166,31 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
     // Rename needs the new file to not exist.
     LLFileSystem::removeFile(new_file_id, new_file_type, ENOENT);
 
+    LLDiskCachePacks* old_packs = get_packs(old_file_type);
+    LLDiskCachePacks* new_packs = get_packs(new_file_type);
+    S32 packed_size = 0;
+    if (old_packs && new_packs && old_packs->rename(old_file_id, new_file_id, new_file_type))
+    {
+        return TRUE;
+    }
+    else if (new_packs || (old_packs && old_packs->getSize(old_file_id, packed_size)))
+    {
+        // moving between the packs and a file of its own, copy it across
+        S32 file_size = LLFileSystem::getFileSize(old_file_id, old_file_type);
+        std::vector<U8> data(file_size);
+        if (file_size > 0)
+        {
+            LLFileSystem old_file(old_file_id, old_file_type, LLFileSystem::READ);
+            LLFileSystem new_file(new_file_id, new_file_type, LLFileSystem::WRITE);
+            if (!old_file.read(data.data(), file_size) || !new_file.write(data.data(), file_size))
+            {
+                LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_id_str << LL_ENDL;
+            }
+        }
+        LLFileSystem::removeFile(old_file_id, old_file_type, ENOENT);
+        return TRUE;
+    }
+
     if (LLFile::rename(old_filename, new_filename) != 0)
     {
         // We would like to return FALSE here indicating the operation
@@ -130,6 +199,15 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return FALSE;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_id_str << " reason: "  << strerror(errno) << LL_ENDL;
     }
+    else
+    {
+        U64 file_size = 0;
+        if (LLDiskCache::getInstance()->findIndexedFile(old_file_id, file_size))
+        {
+            LLDiskCache::getInstance()->removeIndexedFile(old_file_id);
+            LLDiskCache::getInstance()->addIndexedFile(new_file_id, new_file_type, file_size);
+        }
+    }
 
     return TRUE;
 }
@@ -137,6 +215,19 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
 // static
 S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
+    LLDiskCachePacks* packs = get_packs(file_type);
+    S32 packed_size = 0;
+    if (packs && packs->getSize(file_id, packed_size))
+    {
+        return packed_size;
+    }
+
+    U64 indexed_size = 0;
+    if (LLDiskCache::getInstance()->findIndexedFile(file_id, indexed_size))
+    {
+        return (S32)indexed_size;
+    }
+
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -150,6 +241,11 @@ S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType fi
         file_size = file.tellg();
     }
 
+    if (file_size > 0)
+    {
+        LLDiskCache::getInstance()->addIndexedFile(file_id, file_type, file_size);
+    }
+
     return file_size;
 }
 
@@ -157,6 +253,15 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
 {
     BOOL success = FALSE;
 
+    LLDiskCachePacks* packs = get_packs(mFileType);
+    S32 packed_size = 0;
+    if (packs && packs->getSize(mFileID, packed_size))
+    {
+        mBytesRead = packs->read(mFileID, mPosition, buffer, bytes);
+        mPosition += mBytesRead;
+        return mBytesRead > 0;
+    }
+
     std::string id;
     mFileID.toString(id);
     const std::string extra_info = "";
@@ -209,6 +314,21 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
 
     BOOL success = FALSE;
 
+    LLDiskCachePacks* packs = get_packs(mFileType);
+    if (packs)
+    {
+        // same offsets as the file code below, WRITE replaces the whole asset every time
+        const S32 offset = mMode == APPEND ? -1 : (mMode == READ_WRITE ? mPosition : 0);
+        const S32 new_size = packs->write(mFileID, mFileType, offset, buffer, bytes, mMode != APPEND && mMode != READ_WRITE);
+        if (new_size < 0)
+        {
+            return FALSE;
+        }
+
+        mPosition = mMode == APPEND ? new_size : mPosition + bytes;
+        return TRUE;
+    }
+
     if (mMode == APPEND)
     {
         llofstream ofs(filename, std::ios::app | std::ios::binary);
@@ -259,6 +379,15 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
         }
     }
 
+    if (success && LLDiskCache::getInstance()->useIndex())
+    {
+        llstat file_status;
+        if (LLFile::stat(filename, &file_status) == 0)
+        {
+            LLDiskCache::getInstance()->addIndexedFile(mFileID, mFileType, file_status.st_size);
+        }
+    }
+
     return success;
 }
 
@@ -0,0 +1,156 @@
+/**
+ * @file lldiskcacheindex_test.cpp
+ * @date 2023-06
+ * @brief LLDiskCacheIndex test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../lldiskcacheindex.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+namespace tut
+{
+    struct LLDiskCacheIndexFixture
+    {
+        LLDiskCacheIndexFixture() :
+            mPath(NamedTempFile::temp_path("cacheindex", ".bin").string())
+        {
+        }
+
+        ~LLDiskCacheIndexFixture()
+        {
+            mIndex.close();
+            boost::system::error_code ec;
+            boost::filesystem::remove(mPath, ec);
+        }
+
+        std::string mPath;
+        LLDiskCacheIndex mIndex;
+    };
+    typedef test_group<LLDiskCacheIndexFixture> LLDiskCacheIndexTest_factory;
+    typedef LLDiskCacheIndexTest_factory::object LLDiskCacheIndexTest_t;
+    LLDiskCacheIndexTest_factory tf("LLDiskCacheIndex");
+
+    template<> template<>
+    void LLDiskCacheIndexTest_t::test<1>()
+    {
+        set_test_name("insert, find and remove");
+
+        ensure("new index reports it needs populating", !mIndex.open(mPath));
+        ensure("index is open", mIndex.isOpen());
+
+        LLUUID a, b;
+        a.generate();
+        b.generate();
+        mIndex.insert(a, LLAssetType::AT_TEXTURE, 100, 1);
+        mIndex.insert(b, LLAssetType::AT_SOUND, 50, 2);
+        ensure_equals("count", mIndex.getCount(), 2U);
+        ensure_equals("total size", mIndex.getTotalSize(), U64(150));
+
+        LLDiskCacheIndex::Entry entry;
+        ensure("find a", mIndex.find(a, entry));
+        ensure_equals("a size", entry.mSize, U64(100));
+        ensure_equals("a type", entry.mAssetType, LLAssetType::AT_TEXTURE);
+
+        // replacing an entry must not count it twice
+        mIndex.insert(a, LLAssetType::AT_TEXTURE, 10, 3);
+        ensure_equals("count after replace", mIndex.getCount(), 2U);
+        ensure_equals("total size after replace", mIndex.getTotalSize(), U64(60));
+
+        ensure("remove b", mIndex.remove(b));
+        ensure("b gone", !mIndex.find(b, entry));
+        ensure("remove b again", !mIndex.remove(b));
+        ensure_equals("total size after remove", mIndex.getTotalSize(), U64(10));
+    }
+
+    template<> template<>
+    void LLDiskCacheIndexTest_t::test<2>()
+    {
+        set_test_name("least recently used order");
+
+        mIndex.open(mPath);
+
+        std::vector<LLUUID> ids(4);
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            ids[i].generate();
+            mIndex.insert(ids[i], LLAssetType::AT_TEXTURE, 1, i);
+        }
+
+        // reading the oldest makes it the newest
+        ensure("touch", mIndex.touch(ids[0], 10));
+
+        LLDiskCacheIndex::Entry entry;
+        ensure("pop 1", mIndex.popOldest(entry));
+        ensure_equals("oldest", entry.mID, ids[1]);
+        ensure("pop 2", mIndex.popOldest(entry));
+        ensure_equals("next oldest", entry.mID, ids[2]);
+        ensure("pop 3", mIndex.popOldest(entry));
+        ensure_equals("then", entry.mID, ids[3]);
+        ensure("pop 4", mIndex.popOldest(entry));
+        ensure_equals("touched last", entry.mID, ids[0]);
+        ensure_equals("touched access time", entry.mLastAccess, std::time_t(10));
+        ensure("empty", !mIndex.popOldest(entry));
+        ensure_equals("total size when empty", mIndex.getTotalSize(), U64(0));
+    }
+
+    template<> template<>
+    void LLDiskCacheIndexTest_t::test<3>()
+    {
+        set_test_name("growth and reopening");
+
+        mIndex.open(mPath);
+
+        // enough to force the table to grow more than once
+        const U32 COUNT = 50000;
+        std::vector<LLUUID> ids(COUNT);
+        for (U32 i = 0; i < COUNT; ++i)
+        {
+            ids[i].generate();
+            mIndex.insert(ids[i], LLAssetType::AT_MESH, i, i);
+        }
+        for (U32 i = 0; i < COUNT; i += 2)
+        {
+            mIndex.remove(ids[i]);
+        }
+        mIndex.close();
+
+        ensure("clean index is reused", mIndex.open(mPath));
+        ensure_equals("count survives reopen", mIndex.getCount(), COUNT / 2);
+
+        LLDiskCacheIndex::Entry entry;
+        ensure("removed stays removed", !mIndex.find(ids[0], entry));
+        ensure("find after reopen", mIndex.find(ids[COUNT - 1], entry));
+        ensure_equals("size after reopen", entry.mSize, U64(COUNT - 1));
+        ensure("oldest after reopen", mIndex.popOldest(entry));
+        ensure_equals("oldest is first survivor", entry.mID, ids[1]);
+
+        // an index that was never closed can't be trusted
+        LLDiskCacheIndex other;
+        ensure("index left open is rebuilt", !other.open(mPath));
+        ensure_equals("rebuilt index is empty", other.getCount(), 0U);
+    }
+}
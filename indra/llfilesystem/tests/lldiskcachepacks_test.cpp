@@ -0,0 +1,147 @@
+/**
+ * @file lldiskcachepacks_test.cpp
+ * @date 2023-06
+ * @brief LLDiskCachePacks test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../lldiskcachepacks.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+namespace tut
+{
+    struct LLDiskCachePacksFixture
+    {
+        LLDiskCachePacksFixture() :
+            mDir(NamedTempFile::temp_path("cachepacks").string())
+        {
+            boost::filesystem::create_directory(mDir);
+        }
+
+        ~LLDiskCachePacksFixture()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+        }
+
+        std::string readAll(LLDiskCachePacks& packs, const LLUUID& id)
+        {
+            S32 size = 0;
+            if (!packs.getSize(id, size))
+            {
+                return "<missing>";
+            }
+            std::string data(size, '\0');
+            if (size > 0)
+            {
+                packs.read(id, 0, (U8*)&data[0], size);
+            }
+            return data;
+        }
+
+        void write(LLDiskCachePacks& packs, const LLUUID& id, const std::string& data, S32 offset = 0, bool truncate = true)
+        {
+            packs.write(id, LLAssetType::AT_NOTECARD, offset, (const U8*)data.data(), (S32)data.size(), truncate);
+        }
+
+        std::string mDir;
+    };
+    typedef test_group<LLDiskCachePacksFixture> LLDiskCachePacksTest_factory;
+    typedef LLDiskCachePacksTest_factory::object LLDiskCachePacksTest_t;
+    LLDiskCachePacksTest_factory tf("LLDiskCachePacks");
+
+    template<> template<>
+    void LLDiskCachePacksTest_t::test<1>()
+    {
+        set_test_name("write, append, rename and remove");
+
+        LLDiskCachePacks packs(mDir, 1024 * 1024 * 1024);
+        LLUUID a, b;
+        a.generate();
+        b.generate();
+
+        write(packs, a, "hello");
+        ensure_equals("write", readAll(packs, a), "hello");
+        write(packs, a, " world", -1, false);
+        ensure_equals("append", readAll(packs, a), "hello world");
+        write(packs, a, "J", 0, false);
+        ensure_equals("overwrite in place", readAll(packs, a), "Jello world");
+        write(packs, a, "bye");
+        ensure_equals("truncate", readAll(packs, a), "bye");
+
+        U8 partial[2];
+        ensure_equals("read at offset", packs.read(a, 1, partial, 5), 2);
+        ensure("read at offset content", partial[0] == 'y' && partial[1] == 'e');
+
+        ensure("rename", packs.rename(a, b, LLAssetType::AT_GESTURE));
+        ensure_equals("renamed from", readAll(packs, a), "<missing>");
+        ensure_equals("renamed to", readAll(packs, b), "bye");
+
+        ensure("remove", packs.remove(b));
+        ensure("remove again", !packs.remove(b));
+        ensure_equals("removed", readAll(packs, b), "<missing>");
+    }
+
+    template<> template<>
+    void LLDiskCachePacksTest_t::test<2>()
+    {
+        set_test_name("reload and compaction");
+
+        const S32 COUNT = 200;
+        std::vector<LLUUID> ids(COUNT);
+        {
+            LLDiskCachePacks packs(mDir, 1024 * 1024 * 1024);
+            for (S32 i = 0; i < COUNT; ++i)
+            {
+                ids[i].generate();
+                write(packs, ids[i], std::string(1000, 'a'));
+                // rewriting leaves the first copy behind as garbage
+                write(packs, ids[i], std::string(i, 'b'));
+            }
+            for (S32 i = 0; i < COUNT; i += 2)
+            {
+                packs.remove(ids[i]);
+            }
+        }
+
+        LLDiskCachePacks packs(mDir, 1024 * 1024 * 1024);
+        ensure_equals("removed stays removed", readAll(packs, ids[0]), "<missing>");
+        ensure_equals("latest copy wins", readAll(packs, ids[COUNT - 1]), std::string(COUNT - 1, 'b'));
+
+        // it's all in one (active) pack so nothing to compact yet, but it must be harmless
+        U64 size_before = packs.getDiskSize();
+        packs.compact();
+        ensure_equals("active pack left alone", packs.getDiskSize(), size_before);
+        for (S32 i = 1; i < COUNT; i += 2)
+        {
+            ensure_equals("survives compaction", readAll(packs, ids[i]), std::string(i, 'b'));
+        }
+
+        packs.clear();
+        ensure_equals("clear", readAll(packs, ids[1]), "<missing>");
+        ensure_equals("clear size", packs.getDiskSize(), U64(0));
+    }
+}
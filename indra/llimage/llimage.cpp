@@ -39,8 +39,10 @@
 #include "llimagepng.h"
 #include "llimagedxt.h"
 #include "llmemory.h"
+#include "llsys.h"
 
 #include <boost/preprocessor.hpp>
+#include <immintrin.h>
 
 //..................................................................................
 //..................................................................................
@@ -556,6 +558,196 @@ inline void bilinear_scale(
 	} //else
 }
 
+//..................................................................................
+// SIMD kernels. Each one produces exactly the bytes of the scalar code it
+// replaces, so the two can be switched with LLImage::sUseSIMD.
+//..................................................................................
+namespace
+{
+#if LL_MSVC
+#define LL_TARGET_AVX2
+#else
+#define LL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+	// Four channels of one pixel in 32 bit lanes
+	inline __m128i load_px4(const U8* pix)
+	{
+		S32 v;
+		memcpy(&v, pix, 4);
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+	}
+
+	inline void store_px4(U8* dptr, __m128i comp)
+	{
+		comp = _mm_and_si128(comp, _mm_set1_epi32(0xff));
+		comp = _mm_packs_epi32(comp, comp);
+		S32 v = _mm_cvtsi128_si32(_mm_packus_epi16(comp, comp));
+		memcpy(dptr, &v, 4);
+	}
+
+	// px * val for px in load_px4() form and 0 <= val < 32768
+	inline __m128i mul_px4(__m128i px, S32 val)
+	{
+		return _mm_madd_epi16(px, _mm_set1_epi32(val));
+	}
+
+	// Low 32 bits of a * val in all four lanes, SSE2 has no _mm_mullo_epi32
+	inline __m128i mullo_px4(__m128i a, S32 val)
+	{
+		const __m128i b = _mm_set1_epi32(val);
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), b);
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+								  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	// One source row of a downscaled output pixel, see the "scale x/y - down"
+	// case of bilinear_scale<>()
+	inline __m128i scale_down_row4(const U8* pix, S32 Cx, S32 xap)
+	{
+		__m128i cx = mul_px4(load_px4(pix), xap);
+		pix += 4;
+		S32 i;
+		for (i = (1 << 14) - xap; i > Cx; i -= Cx)
+		{
+			cx = _mm_add_epi32(cx, mul_px4(load_px4(pix), Cx));
+			pix += 4;
+		}
+		if (i > 0)
+		{
+			cx = _mm_add_epi32(cx, mul_px4(load_px4(pix), i));
+		}
+		return _mm_srli_epi32(cx, 5);
+	}
+
+	// bilinear_scale<4>() when both dimensions shrink, one pixel per vector
+	void bilinear_scale_down4_sse2(const U8* src, U32 srcW, U32 srcH, U32 srcStride, U8* dst, U32 dstW, U32 dstH, U32 dstStride)
+	{
+		scale_info<4> info(src, srcW, srcH, dstW, dstH, srcStride);
+
+		for (U32 y = 0; y < dstH; ++y)
+		{
+			const S32 Cy = info.yapoints[y] >> 16;
+			const S32 yap = info.yapoints[y] & 0xffff;
+			U8* dptr = dst + (y * dstStride);
+
+			for (U32 x = 0; x < dstW; ++x)
+			{
+				const S32 Cx = info.xapoints[x] >> 16;
+				const S32 xap = info.xapoints[x] & 0xffff;
+
+				const U8* sptr = info.ystrides[y] + info.xpoints[x] * 4;
+				__m128i comp = mullo_px4(scale_down_row4(sptr, Cx, xap), yap);
+				sptr += srcStride;
+
+				S32 j;
+				for (j = (1 << 14) - yap; j > Cy; j -= Cy)
+				{
+					comp = _mm_add_epi32(comp, mullo_px4(scale_down_row4(sptr, Cx, xap), Cy));
+					sptr += srcStride;
+				}
+				if (j > 0)
+				{
+					comp = _mm_add_epi32(comp, mullo_px4(scale_down_row4(sptr, Cx, xap), j));
+				}
+
+				store_px4(dptr, _mm_srai_epi32(comp, 23));
+				dptr += 4;
+			}
+		}
+	}
+
+	// Drop the fourth byte of each pixel. Stores run 8 bytes past the 24
+	// written for 8 pixels, so callers stop 11 pixels short of the end and
+	// finish with the scalar loop.
+	LL_TARGET_AVX2 S32 copy4onto3_avx2(const U8* src, U8* dst, S32 pixels)
+	{
+		const __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+											  0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+		S32 i = 0;
+		for (; i + 11 <= pixels; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+			s = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(s, shuf), pack);
+			_mm256_storeu_si256((__m256i*)(dst + i * 3), s);
+		}
+		return i;
+	}
+
+	// Spread 3 byte pixels to 4 bytes with the fourth byte set to alpha.
+	// Loads run 8 bytes past the 24 read for 8 pixels, like copy4onto3_avx2().
+	LL_TARGET_AVX2 inline __m256i load3as4_avx2(const U8* src, __m256i alpha)
+	{
+		const __m256i spread = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+		const __m256i shuf = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+											  0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		__m256i s = _mm256_loadu_si256((const __m256i*)src);
+		s = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(s, spread), shuf);
+		return _mm256_or_si256(s, alpha);
+	}
+
+	LL_TARGET_AVX2 S32 copy3onto4_avx2(const U8* src, U8* dst, S32 pixels)
+	{
+		const __m256i alpha = _mm256_set1_epi32(0xff000000);
+		S32 i = 0;
+		for (; i + 11 <= pixels; i += 8)
+		{
+			_mm256_storeu_si256((__m256i*)(dst + i * 4), load3as4_avx2(src + i * 3, alpha));
+		}
+		return i;
+	}
+
+	// LLImageRaw::fastFractionalMult() in 16 bit lanes
+	LL_TARGET_AVX2 inline __m256i fractional_mult_avx2(__m256i a, __m256i b)
+	{
+		__m256i i = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(i, _mm256_srli_epi16(i, 8)), 8);
+	}
+
+	// dst = dst * (255 - a) + src * a, per 8 pixels. Alpha 0 and 255 come out
+	// the same as the scalar early outs.
+	LL_TARGET_AVX2 S32 composite4onto3_avx2(const U8* src, U8* dst, S32 pixels)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i ff = _mm256_set1_epi16(0xff);
+		const __m256i alpha_shuf = _mm256_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15,
+													3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+		const __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+											  0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+		const __m256i store_mask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+		S32 i = 0;
+		for (; i + 11 <= pixels; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+			__m256i d = load3as4_avx2(dst + i * 3, zero);
+			__m256i a = _mm256_shuffle_epi8(s, alpha_shuf);
+
+			__m256i a_lo = _mm256_unpacklo_epi8(a, zero);
+			__m256i a_hi = _mm256_unpackhi_epi8(a, zero);
+			__m256i lo = _mm256_add_epi16(fractional_mult_avx2(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(ff, a_lo)),
+										  fractional_mult_avx2(_mm256_unpacklo_epi8(s, zero), a_lo));
+			__m256i hi = _mm256_add_epi16(fractional_mult_avx2(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(ff, a_hi)),
+										  fractional_mult_avx2(_mm256_unpackhi_epi8(s, zero), a_hi));
+			// the scalar sum is truncated to U8, mask rather than saturate
+			__m256i out = _mm256_packus_epi16(_mm256_and_si256(lo, ff), _mm256_and_si256(hi, ff));
+			out = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(out, shuf), pack);
+			// dst is also the input, leave the bytes past this block alone
+			_mm256_maskstore_epi32((int*)(dst + i * 3), store_mask, out);
+		}
+		return i;
+	}
+
+	bool use_avx2()
+	{
+		static const bool has_avx2 = gSysCPU.hasAVX2();
+		return LLImage::sUseSIMD && has_avx2;
+	}
+}
+
 //wrapper
 static void bilinear_scale(const U8 *src, U32 srcW, U32 srcH, U32 srcCh, U32 srcStride, U8 *dst, U32 dstW, U32 dstH, U32 dstCh, U32 dstStride)
 {
@@ -570,7 +762,14 @@ static void bilinear_scale(const U8 *src, U32 srcW, U32 srcH, U32 srcCh, U32 src
 		bilinear_scale<3>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
 		break;
 	case 4:
-		bilinear_scale<4>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+		if (LLImage::sUseSIMD && dstW < srcW && dstH < srcH)
+		{
+			bilinear_scale_down4_sse2(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+		}
+		else
+		{
+			bilinear_scale<4>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+		}
 		break;
 	default:
 		llassert(!"Implement if need");
@@ -588,6 +787,7 @@ std::string LLImage::sLastErrorMessage;
 LLMutex* LLImage::sMutex = NULL;
 bool LLImage::sUseNewByteRange = false;
 S32  LLImage::sMinimalReverseByteRangePercent = 75;
+bool LLImage::sUseSIMD = true;
 
 //static
 void LLImage::initClass(bool use_new_byte_range, S32 minimal_reverse_byte_range_percent)
@@ -799,15 +999,18 @@ U8* LLImageBase::allocateDataSize(S32 width, S32 height, S32 ncomponents, S32 si
 //---------------------------------------------------------------------------
 
 S32 LLImageRaw::sRawImageCount = 0;
+std::atomic<S64> LLImageRaw::sGlobalRawMemory(0);
 
 LLImageRaw::LLImageRaw()
-	: LLImageBase()
+	: LLImageBase(),
+	  mTrackedDataSize(0)
 {
 	++sRawImageCount;
 }
 
 LLImageRaw::LLImageRaw(U16 width, U16 height, S8 components)
-	: LLImageBase()
+	: LLImageBase(),
+	  mTrackedDataSize(0)
 {
 	//llassert( S32(width) * S32(height) * S32(components) <= MAX_IMAGE_DATA_SIZE );
 	allocateDataSize(width, height, components);
@@ -815,7 +1018,8 @@ LLImageRaw::LLImageRaw(U16 width, U16 height, S8 components)
 }
 
 LLImageRaw::LLImageRaw(const U8* data, U16 width, U16 height, S8 components)
-    : LLImageBase()
+    : LLImageBase(),
+      mTrackedDataSize(0)
 {
     if (allocateDataSize(width, height, components))
     {
@@ -824,7 +1028,8 @@ LLImageRaw::LLImageRaw(const U8* data, U16 width, U16 height, S8 components)
 }
 
 LLImageRaw::LLImageRaw(U8 *data, U16 width, U16 height, S8 components, bool no_copy)
-	: LLImageBase()
+	: LLImageBase(),
+	  mTrackedDataSize(0)
 {
 	if(no_copy)
 	{
@@ -855,6 +1060,7 @@ LLImageRaw::~LLImageRaw()
 U8* LLImageRaw::allocateData(S32 size)
 {
 	U8* res = LLImageBase::allocateData(size);
+	updateRawMemory();
 	return res;
 }
 
@@ -862,6 +1068,7 @@ U8* LLImageRaw::allocateData(S32 size)
 U8* LLImageRaw::reallocateData(S32 size)
 {
 	U8* res = LLImageBase::reallocateData(size);
+	updateRawMemory();
 	return res;
 }
 
@@ -869,12 +1076,24 @@ void LLImageRaw::releaseData()
 {
     LLImageBase::setSize(0, 0, 0);
     LLImageBase::setDataAndSize(nullptr, 0);
+    updateRawMemory();
 }
 
 // virtual
 void LLImageRaw::deleteData()
 {
 	LLImageBase::deleteData();
+	updateRawMemory();
+}
+
+void LLImageRaw::updateRawMemory()
+{
+	S32 size = isBufferInvalid() ? 0 : getDataSize();
+	if (size != mTrackedDataSize)
+	{
+		sGlobalRawMemory += size - mTrackedDataSize;
+		mTrackedDataSize = size;
+	}
 }
 
 void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components) 
@@ -888,6 +1107,7 @@ void LLImageRaw::setDataAndSize(U8 *data, S32 width, S32 height, S8 components)
 
 	LLImageBase::setSize(width, height, components) ;
 	LLImageBase::setDataAndSize(data, width * height * components) ;
+	updateRawMemory();
 }
 
 bool LLImageRaw::resize(U16 width, U16 height, S8 components)
@@ -1180,6 +1400,13 @@ void LLImageRaw::compositeUnscaled4onto3( LLImageRaw* src )
 	U8* src_data = src->getData();
 	U8* dst_data = dst->getData();
 	S32 pixels = getWidth() * getHeight();
+	if (use_avx2())
+	{
+		S32 done = composite4onto3_avx2(src_data, dst_data, pixels);
+		src_data += done * 4;
+		dst_data += done * 3;
+		pixels -= done;
+	}
 	while( pixels-- )
 	{
 		U8 alpha = src_data[3];
@@ -1377,7 +1604,14 @@ void LLImageRaw::copyUnscaled4onto3( LLImageRaw* src )
 	S32 pixels = getWidth() * getHeight();
 	U8* src_data = src->getData();
 	U8* dst_data = dst->getData();
-	for( S32 i=0; i<pixels; i++ )
+	S32 i = 0;
+	if (use_avx2())
+	{
+		i = copy4onto3_avx2(src_data, dst_data, pixels);
+		src_data += i * 4;
+		dst_data += i * 3;
+	}
+	for( ; i<pixels; i++ )
 	{
 		dst_data[0] = src_data[0];
 		dst_data[1] = src_data[1];
@@ -1399,7 +1633,14 @@ void LLImageRaw::copyUnscaled3onto4( LLImageRaw* src )
 	S32 pixels = getWidth() * getHeight();
 	U8* src_data = src->getData();
 	U8* dst_data = dst->getData();
-	for( S32 i=0; i<pixels; i++ )
+	S32 i = 0;
+	if (use_avx2())
+	{
+		i = copy3onto4_avx2(src_data, dst_data, pixels);
+		src_data += i * 3;
+		dst_data += i * 4;
+	}
+	for( ; i<pixels; i++ )
 	{
 		dst_data[0] = src_data[0];
 		dst_data[1] = src_data[1];
@@ -2297,6 +2538,51 @@ void LLImageBase::setDataAndSize(U8 *data, S32 size)
 	mDataSize = size; 
 }	
 
+// 2x2 box filter of one output row, 4 output pixels at a time. Returns
+// the number of pixels done.
+static S32 generate_mip_row4_sse2(const U8* row0, const U8* row1, U8* out, S32 width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	S32 w = 0;
+	for (; w + 4 <= width; w += 4)
+	{
+		__m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + w * 8));
+		__m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + w * 8 + 16));
+		__m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + w * 8));
+		__m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + w * 8 + 16));
+
+		// vertical pairs, two input pixels per vector
+		__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+		__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+		__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+		__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+		// horizontal pairs
+		__m128i p01 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+		__m128i p23 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+		_mm_storeu_si128((__m128i*)(out + w * 4), _mm_packus_epi16(_mm_srli_epi16(p01, 2), _mm_srli_epi16(p23, 2)));
+	}
+	return w;
+}
+
+// Single channel version of generate_mip_row4_sse2(), 8 output pixels at a time
+static S32 generate_mip_row1_sse2(const U8* row0, const U8* row1, U8* out, S32 width)
+{
+	const __m128i lo_bytes = _mm_set1_epi16(0xff);
+	S32 w = 0;
+	for (; w + 8 <= width; w += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(row0 + w * 2));
+		__m128i b = _mm_loadu_si128((const __m128i*)(row1 + w * 2));
+		__m128i s = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, lo_bytes), _mm_srli_epi16(a, 8)),
+								  _mm_add_epi16(_mm_and_si128(b, lo_bytes), _mm_srli_epi16(b, 8)));
+		s = _mm_srli_epi16(s, 2);
+		_mm_storel_epi64((__m128i*)(out + w), _mm_packus_epi16(s, s));
+	}
+	return w;
+}
+
 //static
 void LLImageBase::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
 {
@@ -2305,7 +2591,21 @@ void LLImageBase::generateMip(const U8* indata, U8* mipdata, S32 width, S32 heig
 	S32 in_width = width*2;
 	for (S32 h=0; h<height; h++)
 	{
-		for (S32 w=0; w<width; w++)
+		S32 done = 0;
+		if (LLImage::sUseSIMD)
+		{
+			if (nchannels == 4)
+			{
+				done = generate_mip_row4_sse2(indata, indata + 4 * in_width, data, width);
+			}
+			else if (nchannels == 1)
+			{
+				done = generate_mip_row1_sse2(indata, indata + in_width, data, width);
+			}
+			indata += nchannels * 2 * done;
+			data += nchannels * done;
+		}
+		for (S32 w=done; w<width; w++)
 		{
 			switch(nchannels)
 			{
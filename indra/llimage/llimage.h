@@ -32,6 +32,8 @@
 #include "llpointer.h"
 #include "lltrace.h"
 
+#include <atomic>
+
 const S32 MIN_IMAGE_MIP =  2; // 4x4, only used for expand/contract power of 2
 const S32 MAX_IMAGE_MIP = 11; // 2048x2048
 
@@ -100,6 +102,10 @@ public:
 	
 	static bool useNewByteRange() { return sUseNewByteRange; }
 	static S32  getReverseByteRangePercent() { return sMinimalReverseByteRangePercent; }
+
+	// Use the SSE2/AVX2 kernels for scaling, mips, compositing and channel
+	// conversion where the CPU has them. Off runs the scalar code, for comparison.
+	static bool sUseSIMD;
 	
 protected:
 	static LLMutex* sMutex;
@@ -281,9 +287,15 @@ protected:
 
 public:
 	static S32 sRawImageCount;
+	// bytes of pixel data held by all raw images, kept from any thread
+	static std::atomic<S64> sGlobalRawMemory;
 
 private:
 	bool validateSrcAndDst(std::string func, LLImageRaw* src, LLImageRaw* dst);
+
+	// bring sGlobalRawMemory in line with this image's current data
+	void updateRawMemory();
+	S32 mTrackedDataSize;
 };
 
 // Compressed representation of image.
@@ -0,0 +1,261 @@
+/**
+ * @file llimagebc.cpp
+ * @brief Block compression (BC1/BC3, aka DXT1/DXT5) of raw image data.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagebc.h"
+
+#include <utility>
+
+namespace
+{
+	// Gather a 4x4 block as RGBA, repeating the last row/column for blocks
+	// that hang over the edge of the image.
+	void fetch_block(const U8* in, S32 width, S32 height, S32 components, S32 bx, S32 by, U8 block[16][4])
+	{
+		for (S32 y = 0; y < 4; ++y)
+		{
+			S32 sy = llmin(by + y, height - 1);
+			for (S32 x = 0; x < 4; ++x)
+			{
+				S32 sx = llmin(bx + x, width - 1);
+				const U8* pixel = in + (sy * width + sx) * components;
+				U8* out = block[y * 4 + x];
+				out[0] = pixel[0];
+				out[1] = pixel[1];
+				out[2] = pixel[2];
+				out[3] = components == 4 ? pixel[3] : 255;
+			}
+		}
+	}
+
+	U16 pack_565(const S32 color[3])
+	{
+		S32 r = (color[0] * 31 + 127) / 255;
+		S32 g = (color[1] * 63 + 127) / 255;
+		S32 b = (color[2] * 31 + 127) / 255;
+		return (U16)((r << 11) | (g << 5) | b);
+	}
+
+	void unpack_565(U16 packed, S32 color[3])
+	{
+		S32 r = (packed >> 11) & 31;
+		S32 g = (packed >> 5) & 63;
+		S32 b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	void write_u16(U8* out, U16 value)
+	{
+		out[0] = (U8)(value & 0xff);
+		out[1] = (U8)(value >> 8);
+	}
+
+	void encode_color_block(const U8 block[16][4], U8* out)
+	{
+		S32 min_color[3] = { 255, 255, 255 };
+		S32 max_color[3] = { 0, 0, 0 };
+		for (S32 i = 0; i < 16; ++i)
+		{
+			for (S32 c = 0; c < 3; ++c)
+			{
+				min_color[c] = llmin(min_color[c], (S32)block[i][c]);
+				max_color[c] = llmax(max_color[c], (S32)block[i][c]);
+			}
+		}
+
+		// pull the endpoints in by 1/16 of the range, the extremes are
+		// usually outliers and the palette covers the bulk better for it
+		for (S32 c = 0; c < 3; ++c)
+		{
+			S32 inset = (max_color[c] - min_color[c]) >> 4;
+			min_color[c] = llmin(min_color[c] + inset, 255);
+			max_color[c] = llmax(max_color[c] - inset, 0);
+		}
+
+		U16 c0 = pack_565(max_color);
+		U16 c1 = pack_565(min_color);
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+		}
+		write_u16(out, c0);
+		write_u16(out + 2, c1);
+
+		U32 indices = 0;
+		// c0 == c1 is the three color mode, index 0 is still c0 so leave all
+		// the indices at 0
+		if (c0 != c1)
+		{
+			S32 palette[4][3];
+			unpack_565(c0, palette[0]);
+			unpack_565(c1, palette[1]);
+			for (S32 c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (S32 i = 0; i < 16; ++i)
+			{
+				S32 best = 0;
+				S32 best_dist = S32_MAX;
+				for (S32 p = 0; p < 4; ++p)
+				{
+					S32 dr = block[i][0] - palette[p][0];
+					S32 dg = block[i][1] - palette[p][1];
+					S32 db = block[i][2] - palette[p][2];
+					S32 dist = dr * dr + dg * dg + db * db;
+					if (dist < best_dist)
+					{
+						best_dist = dist;
+						best = p;
+					}
+				}
+				indices |= (U32)best << (i * 2);
+			}
+		}
+		out[4] = (U8)(indices & 0xff);
+		out[5] = (U8)((indices >> 8) & 0xff);
+		out[6] = (U8)((indices >> 16) & 0xff);
+		out[7] = (U8)(indices >> 24);
+	}
+
+	void encode_alpha_block(const U8 block[16][4], U8* out)
+	{
+		S32 a0 = 0;
+		S32 a1 = 255;
+		for (S32 i = 0; i < 16; ++i)
+		{
+			a0 = llmax(a0, (S32)block[i][3]);
+			a1 = llmin(a1, (S32)block[i][3]);
+		}
+		out[0] = (U8)a0;
+		out[1] = (U8)a1;
+
+		U64 indices = 0;
+		// a0 == a1 picks the six value mode, but index 0 is still a0
+		if (a0 != a1)
+		{
+			// a0 > a1 is the eight value mode: a0, a1, then six steps from
+			// a0 towards a1
+			S32 palette[8];
+			palette[0] = a0;
+			palette[1] = a1;
+			for (S32 p = 1; p < 7; ++p)
+			{
+				palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+			}
+
+			for (S32 i = 0; i < 16; ++i)
+			{
+				S32 best = 0;
+				S32 best_dist = S32_MAX;
+				for (S32 p = 0; p < 8; ++p)
+				{
+					S32 dist = llabs(block[i][3] - palette[p]);
+					if (dist < best_dist)
+					{
+						best_dist = dist;
+						best = p;
+					}
+				}
+				indices |= (U64)best << (i * 3);
+			}
+		}
+		for (S32 b = 0; b < 6; ++b)
+		{
+			out[2 + b] = (U8)((indices >> (b * 8)) & 0xff);
+		}
+	}
+}
+
+//static
+S32 LLImageBC::calcDataSize(EFormat format, S32 width, S32 height)
+{
+	S32 blocks = ((width + 3) / 4) * ((height + 3) / 4);
+	return blocks * (format == BC1 ? 8 : 16);
+}
+
+//static
+void LLImageBC::encode(EFormat format, const U8* in, S32 width, S32 height, S32 components, U8* out)
+{
+	llassert(components == 3 || components == 4);
+	llassert(format == BC1 || components == 4);
+
+	U8 block[16][4];
+	for (S32 by = 0; by < height; by += 4)
+	{
+		for (S32 bx = 0; bx < width; bx += 4)
+		{
+			fetch_block(in, width, height, components, bx, by, block);
+			if (format == BC3)
+			{
+				encode_alpha_block(block, out);
+				out += 8;
+			}
+			encode_color_block(block, out);
+			out += 8;
+		}
+	}
+}
+
+//static
+bool LLImageBC::isOpaque(const U8* in, S32 width, S32 height)
+{
+	S32 count = width * height;
+	for (S32 i = 0; i < count; ++i)
+	{
+		if (in[i * 4 + 3] != 255)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//static
+void LLImageBC::downsample(const U8* in, S32 width, S32 height, S32 components, U8* out)
+{
+	S32 out_width = llmax(width / 2, 1);
+	S32 out_height = llmax(height / 2, 1);
+	for (S32 y = 0; y < out_height; ++y)
+	{
+		const U8* row0 = in + (y * 2) * width * components;
+		const U8* row1 = in + llmin(y * 2 + 1, height - 1) * width * components;
+		for (S32 x = 0; x < out_width; ++x)
+		{
+			S32 x0 = x * 2 * components;
+			S32 x1 = llmin(x * 2 + 1, width - 1) * components;
+			for (S32 c = 0; c < components; ++c)
+			{
+				*out++ = (U8)(((U32)row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+			}
+		}
+	}
+}
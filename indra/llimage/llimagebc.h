@@ -0,0 +1,64 @@
+/**
+ * @file llimagebc.h
+ * @brief Block compression (BC1/BC3, aka DXT1/DXT5) of raw image data.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEBC_H
+#define LL_LLIMAGEBC_H
+
+#include "stdtypes.h"
+
+// Fast CPU encoder for the block compressed formats every desktop GPU can
+// sample from. Endpoints come from the inset bounding box of each 4x4 block,
+// which is several times faster than a principal axis search and close
+// enough in quality for textures that are going to be viewed mipmapped.
+class LLImageBC
+{
+public:
+	enum EFormat
+	{
+		BC1,	// 8 bytes per block, opaque RGB
+		BC3,	// 16 bytes per block, RGB + interpolated alpha
+	};
+
+	// Size of the encoded image. Partial blocks at the right and bottom
+	// edges take a whole block.
+	static S32 calcDataSize(EFormat format, S32 width, S32 height);
+
+	// Encode width x height pixels of 3 or 4 component data into out, which
+	// must hold calcDataSize() bytes. BC3 requires 4 components, BC1 ignores
+	// the alpha of 4 component data.
+	static void encode(EFormat format, const U8* in, S32 width, S32 height, S32 components, U8* out);
+
+	// True if every alpha value of 4 component data is 255, so BC1 loses
+	// nothing over BC3 at half the size.
+	static bool isOpaque(const U8* in, S32 width, S32 height);
+
+	// Box filter in down to max(width/2, 1) x max(height/2, 1). Unlike
+	// LLImageBase::generateMip this handles 1 pixel wide or tall levels, so
+	// it can build a complete mip chain for non-square images.
+	static void downsample(const U8* in, S32 width, S32 height, S32 components, U8* out);
+};
+
+#endif // LL_LLIMAGEBC_H
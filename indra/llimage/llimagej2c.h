@@ -73,6 +73,12 @@ public:
 	void setReversible(const bool reversible); // Use non-lossy?
 	void setMaxBytes(S32 max_bytes);
 	S32 getMaxBytes() const { return mMaxBytes; }
+	void setEncodeThreads(U32 threads) { mEncodeThreads = threads; } // 0 encodes on the calling thread only
+	U32 getEncodeThreads() const { return mEncodeThreads; }
+
+	// Decode accessors
+	void setDecodeThreads(U32 threads) { mDecodeThreads = threads; } // 0 decodes on the calling thread only
+	U32 getDecodeThreads() const { return mDecodeThreads; }
 
 	static S32 calcHeaderSizeJ2C();
 	static S32 calcDataSizeJ2C(S32 w, S32 h, S32 comp, S32 discard_level, F32 rate = DEFAULT_COMPRESSION_RATE);
@@ -95,6 +101,8 @@ protected:
 	S8  mRawDiscardLevel;
 	F32 mRate;
 	bool mReversible;
+	U32 mEncodeThreads;
+	U32 mDecodeThreads;
 	boost::scoped_ptr<LLImageJ2CImpl> mImpl;
 	std::string mLastError;
 
@@ -28,6 +28,7 @@
 
 #include "llimageworker.h"
 #include "llimagedxt.h"
+#include "llimagej2c.h"
 #include "threadpool.h"
 
 /*--------------------------------------------------------------------------*/
@@ -39,7 +40,8 @@ public:
 				 const LLPointer<LLImageDecodeThread::Responder>& responder);
 	virtual ~ImageRequest();
 
-	/*virtual*/ bool processRequest();
+	// max_threads is how many threads the decode may use, including this one
+	/*virtual*/ bool processRequest(U32 max_threads);
 	/*virtual*/ void finishRequest(bool completed);
 
 private:
@@ -61,15 +63,22 @@ private:
 //----------------------------------------------------------------------------
 
 // MAIN THREAD
-LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/)
+LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/, size_t pool_size)
+	: mLastHandle(0),
+	  mMaxThreadsPerImage(0),
+	  mActive(0)
 {
-    mThreadPool.reset(new LL::ThreadPool("ImageDecode", 8));
+    mThreadPool.reset(new LL::ThreadPool("ImageDecode", pool_size));
     mThreadPool->start();
 }
 
 //virtual 
 LLImageDecodeThread::~LLImageDecodeThread()
-{}
+{
+    // join the pool threads while the pending requests they pick from still
+    // exist
+    mThreadPool.reset();
+}
 
 // MAIN THREAD
 // virtual
@@ -81,35 +90,117 @@ size_t LLImageDecodeThread::update(F32 max_time_ms)
 
 size_t LLImageDecodeThread::getPending()
 {
-    return mThreadPool->getQueue().size();
+    LLMutexLock lock(&mPendingMutex);
+    return mPendingRequests.size();
 }
 
 LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
     const LLPointer<LLImageFormatted>& image, 
     S32 discard,
     BOOL needs_aux,
-    const LLPointer<LLImageDecodeThread::Responder>& responder)
+    const LLPointer<LLImageDecodeThread::Responder>& responder,
+    F32 priority)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 
-    // Instantiate the ImageRequest right in the lambda, why not?
+    handle_t handle;
+    {
+        LLMutexLock lock(&mPendingMutex);
+        // It's important to our consumer (LLTextureFetchWorker) that we
+        // return a nonzero handle.
+        if (++mLastHandle == 0)
+        {
+            ++mLastHandle;
+        }
+        handle = mLastHandle;
+        PendingRequest& pending = mPendingRequests[handle];
+        pending.mPriority = priority;
+        pending.mRequest = std::make_shared<ImageRequest>(image, discard, needs_aux, responder);
+        mPendingPriorities.insert(priority_key_t(priority, handle));
+    }
+
     bool posted = mThreadPool->getQueue().post(
-        [req = ImageRequest(image, discard, needs_aux, responder)]
-        () mutable
+        [this]()
         {
-            auto done = req.processRequest();
-            req.finishRequest(done);
+            processHighestPriority();
         });
     if (! posted)
     {
         LL_DEBUGS() << "Tried to start decoding on shutdown" << LL_ENDL;
+        abortRequest(handle);
         // should this return 0?
     }
 
-    // It's important to our consumer (LLTextureFetchWorker) that we return a
-    // nonzero handle. It is NOT important that the nonzero handle be unique:
-    // nothing is ever done with it except to compare it to zero, or zero it.
-    return 17;
+    return handle;
+}
+
+bool LLImageDecodeThread::setPriority(handle_t handle, F32 priority)
+{
+    LLMutexLock lock(&mPendingMutex);
+    request_map_t::iterator iter = mPendingRequests.find(handle);
+    if (iter == mPendingRequests.end())
+    {
+        return false;
+    }
+    if (iter->second.mPriority != priority)
+    {
+        mPendingPriorities.erase(priority_key_t(iter->second.mPriority, handle));
+        mPendingPriorities.insert(priority_key_t(priority, handle));
+        iter->second.mPriority = priority;
+    }
+    return true;
+}
+
+bool LLImageDecodeThread::abortRequest(handle_t handle)
+{
+    std::shared_ptr<ImageRequest> request;
+    {
+        LLMutexLock lock(&mPendingMutex);
+        request_map_t::iterator iter = mPendingRequests.find(handle);
+        if (iter == mPendingRequests.end())
+        {
+            return false;
+        }
+        mPendingPriorities.erase(priority_key_t(iter->second.mPriority, handle));
+        request = iter->second.mRequest;
+        mPendingRequests.erase(iter);
+    }
+    // the token posted for it will find some other request, or none, and the
+    // request itself is released outside the lock
+    return true;
+}
+
+// ImageDecode thread
+void LLImageDecodeThread::processHighestPriority()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    std::shared_ptr<ImageRequest> request;
+    size_t pending;
+    {
+        LLMutexLock lock(&mPendingMutex);
+        if (mPendingPriorities.empty())
+        {
+            return; // aborted
+        }
+        priority_set_t::iterator top = mPendingPriorities.begin();
+        request_map_t::iterator iter = mPendingRequests.find(top->second);
+        llassert(iter != mPendingRequests.end());
+        request = iter->second.mRequest;
+        mPendingRequests.erase(iter);
+        mPendingPriorities.erase(top);
+        pending = mPendingRequests.size();
+    }
+
+    // pool threads that are neither decoding nor about to pick up a request
+    // can lend their cores to this one
+    U32 active = ++mActive;
+    size_t width = mThreadPool->getWidth();
+    size_t spare = width > active + pending ? width - active - pending : 0;
+    U32 max_threads = llmin((U32)mMaxThreadsPerImage, (U32)(1 + spare));
+
+    auto done = request->processRequest(max_threads);
+    --mActive;
+    request->finishRequest(done);
 }
 
 void LLImageDecodeThread::shutdown()
@@ -146,7 +237,7 @@ ImageRequest::~ImageRequest()
 
 
 // Returns true when done, whether or not decode was successful.
-bool ImageRequest::processRequest()
+bool ImageRequest::processRequest(U32 max_threads)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 	const F32 decode_time_slice = 0.f; //disable time slicing
@@ -173,6 +264,15 @@ bool ImageRequest::processRequest()
 											  mFormattedImage->getHeight(),
 											  mFormattedImage->getComponents());
 		}
+		if (mFormattedImage->getCodec() == IMG_CODEC_J2C)
+		{
+			// below this many pixels per thread the extra threads cost more
+			// than they save
+			const U32 PIXELS_PER_THREAD = 512 * 512;
+			U32 pixels = mFormattedImage->getWidth() * mFormattedImage->getHeight();
+			U32 threads = llclamp(pixels / PIXELS_PER_THREAD, 1U, llmax(max_threads, 1U));
+			((LLImageJ2C*)mFormattedImage.get())->setDecodeThreads(threads > 1 ? threads : 0);
+		}
 		done = mFormattedImage->decode(mDecodedImageRaw, decode_time_slice);
 		// some decoders are removing data when task is complete and there were errors
 		mDecodedRaw = done && mDecodedImageRaw->getData();
@@ -28,9 +28,17 @@
 #define LL_LLIMAGEWORKER_H
 
 #include "llimage.h"
+#include "llmutex.h"
 #include "llpointer.h"
 #include "threadpool_fwd.h"
 
+#include <atomic>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+class ImageRequest;
+
 class LLImageDecodeThread
 {
 public:
@@ -43,23 +51,69 @@ public:
 	};
 
 public:
-	LLImageDecodeThread(bool threaded = true);
+	// pool_size is the "ImageDecode" pool width unless ThreadPoolSizes overrides it
+	LLImageDecodeThread(bool threaded = true, size_t pool_size = 8);
 	virtual ~LLImageDecodeThread();
 
 	// meant to resemble LLQueuedThread::handle_t
 	typedef U32 handle_t;
+	// Requests with a higher priority are decoded first, requests of equal
+	// priority in the order they were made.
 	handle_t decodeImage(const LLPointer<LLImageFormatted>& image,
 						 S32 discard, BOOL needs_aux,
-						 const LLPointer<Responder>& responder);
+						 const LLPointer<Responder>& responder,
+						 F32 priority = 0.f);
+	// Change the priority of a request that hasn't started decoding yet.
+	// Returns false if it has already started (or finished).
+	bool setPriority(handle_t handle, F32 priority);
+	// Drop a request that hasn't started decoding yet, its responder is
+	// never called. Returns false if it has already started (or finished).
+	bool abortRequest(handle_t handle);
 	size_t getPending();
 	size_t update(F32 max_time_ms);
 	void shutdown();
 
+	// Most threads a single JPEG2000 image may decode on.  An image only gets
+	// more than one when it is large and there are pool threads with nothing
+	// to do, so a big texture doesn't hold up the queue on a single core.
+	// 0 or 1 decodes each image on its pool thread only.
+	void setMaxThreadsPerImage(U32 threads) { mMaxThreadsPerImage = threads; }
+
 private:
 	// As of SL-17483, LLImageDecodeThread is no longer itself an
 	// LLQueuedThread - instead this is the API by which we submit work to the
 	// "ImageDecode" ThreadPool.
 	std::unique_ptr<LL::ThreadPool> mThreadPool;
+
+	// The pool's own queue is FIFO, so each decodeImage() only posts a token
+	// to it and the token decodes whichever pending request has the highest
+	// priority when a pool thread gets around to it.
+	void processHighestPriority();
+
+	typedef std::pair<F32, handle_t> priority_key_t;
+	struct HigherPriority
+	{
+		bool operator()(const priority_key_t& lhs, const priority_key_t& rhs) const
+		{
+			return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+		}
+	};
+	typedef std::set<priority_key_t, HigherPriority> priority_set_t;
+
+	struct PendingRequest
+	{
+		F32 mPriority;
+		std::shared_ptr<ImageRequest> mRequest;
+	};
+	typedef std::unordered_map<handle_t, PendingRequest> request_map_t;
+
+	LLMutex mPendingMutex;
+	priority_set_t mPendingPriorities;	// mPendingMutex
+	request_map_t mPendingRequests;		// mPendingMutex
+	handle_t mLastHandle;				// mPendingMutex
+
+	std::atomic<U32> mMaxThreadsPerImage;
+	std::atomic<U32> mActive;			// pool threads decoding right now
 };
 
 #endif
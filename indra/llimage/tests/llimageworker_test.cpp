@@ -68,6 +68,7 @@ U8* LLImageRaw::allocateData(S32 size) { return NULL; }
 U8* LLImageRaw::reallocateData(S32 size) { return NULL; }
 const U8* LLImageBase::getData() const { return NULL; }
 U8* LLImageBase::getData() { return NULL; }
+S8 LLImageFormatted::getCodec() const { return IMG_CODEC_INVALID; }
 
 // End Stubbing
 // -------------------------------------------------------------------------------------------
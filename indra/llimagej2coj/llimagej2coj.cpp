@@ -333,13 +333,21 @@ public:
         return true;
     }
 
-    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level)
+    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level, U32 threads)
     {
         parameters.flags &= ~OPJ_DPARAMETERS_DUMP_FLAG;
 
         decoder = opj_create_decompress(OPJ_CODEC_J2K);
         opj_setup_decoder(decoder, &parameters);
 
+        // Let OpenJPEG decode the code-blocks of each tile on its own workers,
+        // has to be set between opj_setup_decoder and opj_read_header
+        if (threads > 1 && opj_has_thread_support()
+            && !opj_codec_set_threads(decoder, (int)threads))
+        {
+            LL_DEBUGS("Openjpeg") << "Could not decode with " << threads << " threads" << LL_ENDL;
+        }
+
         opj_set_info_handler(decoder, opj_info, this);
         opj_set_warning_handler(decoder, opj_warn, this);
         opj_set_error_handler(decoder, opj_error, this);
@@ -487,7 +495,7 @@ public:
         comment_text = nullptr;
     }
 
-    bool encode(const LLImageRaw& rawImageIn, LLImageJ2C &compressedImageOut)
+    bool encode(const LLImageRaw& rawImageIn, LLImageJ2C &compressedImageOut, U32 threads)
     {
         setImage(rawImageIn);
 
@@ -507,6 +515,13 @@ public:
         opj_set_warning_handler(encoder, opj_warn, this);
         opj_set_error_handler(encoder, opj_error, this);
 
+        // Let OpenJPEG encode the code-blocks of each tile on its own workers
+        if (threads > 1 && opj_has_thread_support()
+            && !opj_codec_set_threads(encoder, (int)threads))
+        {
+            LL_DEBUGS("Openjpeg") << "Could not encode with " << threads << " threads" << LL_ENDL;
+        }
+
         U32 tile_count = (rawImageIn.getWidth() >> 6) * (rawImageIn.getHeight() >> 6);
         U32 data_size_guess = tile_count * TILE_SIZE;
 
@@ -738,7 +753,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     U32 image_channels = 0;
     S32 data_size = base.getDataSize();
     S32 max_bytes = (base.getMaxBytes() ? base.getMaxBytes() : data_size);
-    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel, base.getDecodeThreads());
 
     // set correct channel count early so failed decodes don't miss it...
     S32 channels = (S32)image_channels - first_channel;
@@ -809,7 +824,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 bool LLImageJ2COJ::encodeImpl(LLImageJ2C &base, const LLImageRaw &raw_image, const char* comment_text, F32 encode_time, bool reversible)
 {
     JPEG2KEncode encode(comment_text, reversible);
-    bool encoded = encode.encode(raw_image, base);
+    bool encoded = encode.encode(raw_image, base, base.getEncodeThreads());
     if (encoded)
     {
         LL_WARNS() << "Openjpeg encoding implementation isn't complete, returning false" << LL_ENDL;
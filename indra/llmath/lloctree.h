@@ -32,6 +32,8 @@
 #include "llvector4a.h"
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
+
 #define OCT_ERRS LL_WARNS("OctreeErrors")
 
 #define OCTREE_DEBUG_COLOR_REMOVE   0x0000FF // r
@@ -86,12 +88,47 @@ public:
 template <class T, typename T_PTR>
 class alignas(16) LLOctreeNode : public LLTreeNode<T>
 {
-    LL_ALIGN_NEW
 public:
+    // Nodes come and go with every object that moves between them, so
+    // freed nodes are kept on a per thread free list for each node type
+    // and handed out again before going to the heap.
+    static void* operator new(size_t size)
+    {
+        if (size == sizeof(LLOctreeNode))
+        {
+            std::vector<void*>* free_nodes = getFreeNodes();
+            if (free_nodes && !free_nodes->empty())
+            {
+                void* ptr = free_nodes->back();
+                free_nodes->pop_back();
+                return ptr;
+            }
+        }
+        return ll_aligned_malloc_16(size);
+    }
+
+    static void operator delete(void* ptr, size_t size)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+        if (size == sizeof(LLOctreeNode))
+        {
+            std::vector<void*>* free_nodes = getFreeNodes();
+            if (free_nodes && free_nodes->size() < MAX_FREE_NODES)
+            {
+                free_nodes->push_back(ptr);
+                return;
+            }
+        }
+        ll_aligned_free_16(ptr);
+    }
 
     typedef LLOctreeTraveler<T, T_PTR>                          oct_traveler;
     typedef LLTreeTraveler<T>                                   tree_traveler;
-    typedef std::vector<T_PTR>                                  element_list;
+    // most nodes only hold a handful of elements, keep those in the node
+    typedef boost::container::small_vector<T_PTR, 4>            element_list;
     typedef typename element_list::iterator                     element_iter;
     typedef typename element_list::const_iterator               const_element_iter;
 	typedef typename std::vector<LLTreeListener<T>*>::iterator	tree_listener_iter;
@@ -655,6 +692,37 @@ protected:
 		MIN = 3
 	} eDName;
 
+	static const size_t MAX_FREE_NODES = 4096;
+
+	struct FreeNodes
+	{
+		FreeNodes(bool& destroyed) : mDestroyed(destroyed) {}
+		~FreeNodes()
+		{
+			for (void* ptr : mNodes)
+			{
+				ll_aligned_free_16(ptr);
+			}
+			mDestroyed = true;
+		}
+
+		std::vector<void*> mNodes;
+		bool& mDestroyed;
+	};
+
+	// NULL once this thread's free list is gone, e.g. nodes deleted
+	// during static destruction after thread locals
+	static std::vector<void*>* getFreeNodes()
+	{
+		static thread_local bool destroyed = false;
+		if (destroyed)
+		{
+			return NULL;
+		}
+		static thread_local FreeNodes free_nodes(destroyed);
+		return &free_nodes.mNodes;
+	}
+
 	LLVector4a mCenter;
 	LLVector4a mSize;
 	LLVector4a mMax;
@@ -45,6 +45,7 @@
 #include "llmatrix3a.h"
 #include "lloctree.h"
 #include "llvolume.h"
+#include "llvolumebvh.h"
 #include "llvolumeoctree.h"
 #include "llstl.h"
 #include "llsdserialize.h"
@@ -2046,7 +2047,9 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+std::atomic<S32> LLVolume::sNumMeshPoints { 0 };
+std::atomic<U32> LLVolume::sFaceUseStamp { 0 };
+bool LLVolumeFace::sUseBVH = false;
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -2058,6 +2061,8 @@ LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL ge
 	mSurfaceArea = 1.f; //only calculated for sculpts, defaults to 1 for all other prims
 	mIsMeshAssetLoaded = false;
     mIsMeshAssetUnavaliable = false;
+	mFacesCompressed = false;
+	mLastFaceUse = sFaceUseStamp.load();
 	mLODScaleBias.setVec(1,1,1);
 	mHullPoints = NULL;
 	mHullIndices = NULL;
@@ -2088,6 +2093,7 @@ LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL ge
 void LLVolume::resizePath(S32 length)
 {
 	mPathp->resizePath(length);
+	discardCompressedFaces();
 	mVolumeFaces.clear();
 	setDirty();
 }
@@ -2101,6 +2107,7 @@ void LLVolume::regen()
 void LLVolume::genTangents(S32 face)
 {
     // generate legacy tangents for the specified face
+    touchFaces();
     llassert(!isMeshAssetLoaded() || mVolumeFaces[face].mTangents != nullptr); // if this is a complete mesh asset, we should already have tangents
     mVolumeFaces[face].createTangents();
 }
@@ -2423,6 +2430,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 			return false;
 		}
 
+		discardCompressedFaces();
 		mVolumeFaces.resize(face_count);
 
 		for (size_t i = 0; i < face_count; ++i)
@@ -2804,6 +2812,526 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 	return true;
 }
 
+// Layout of the block written by packProcessedFaces().  Everything is little
+// endian and every section starts 16 byte aligned, so the block can be read
+// in place from a mapped file:
+//
+//   ProcessedHeader
+//   for each face:
+//     ProcessedFace
+//     mNumVertices ProcessedVertex
+//     mNumVertices LLVector4a weights (PF_WEIGHTS only)
+//     mNumIndices U16, padded to 16 bytes
+//
+// Positions, texture coordinates and weights are stored as is, normals and
+// tangents are octahedron encoded to 16 bits per component.
+static const U32 PROCESSED_FACES_MAGIC = 0x4650564c; // "LVPF"
+static const U32 PROCESSED_FACES_VERSION = 1;
+
+enum
+{
+	PF_TANGENTS = 1 << 0,
+	PF_WEIGHTS = 1 << 1,
+};
+
+struct ProcessedHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U32 mNumFaces;
+	U32 mSize;
+};
+
+struct ProcessedFace
+{
+	S32 mNumVertices;
+	S32 mNumIndices;
+	U32 mFlags;
+	F32 mNormalizedScale[3];
+	F32 mExtents[8];
+	F32 mTexCoordExtents[4];
+	U32 mPad[2];
+};
+
+struct ProcessedVertex
+{
+	F32 mPosition[3];
+	F32 mTexCoord[2];
+	S16 mNormal[2];
+	S16 mTangent[2];
+	S16 mTangentSign;
+	S16 mPad;
+};
+
+static_assert(sizeof(ProcessedHeader) % 16 == 0, "ProcessedHeader must keep the faces aligned");
+static_assert(sizeof(ProcessedFace) % 16 == 0, "ProcessedFace must keep the vertices aligned");
+static_assert(sizeof(ProcessedVertex) % 16 == 0, "ProcessedVertex must keep the weights aligned");
+
+static S32 processed_indices_size(S32 num_indices)
+{
+	return ((num_indices * sizeof(U16)) + 0xF) & ~0xF;
+}
+
+static void encode_octahedron(const LLVector4a& v, S16* out)
+{
+	const F32* f = v.getF32ptr();
+	F32 len = fabsf(f[0]) + fabsf(f[1]) + fabsf(f[2]);
+	F32 x = len > 0.f ? f[0] / len : 0.f;
+	F32 y = len > 0.f ? f[1] / len : 0.f;
+	if (f[2] < 0.f)
+	{ // fold the lower hemisphere over the diagonals
+		F32 fx = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		F32 fy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = fx;
+		y = fy;
+	}
+	out[0] = (S16)ll_round(llclamp(x, -1.f, 1.f) * 32767.f);
+	out[1] = (S16)ll_round(llclamp(y, -1.f, 1.f) * 32767.f);
+}
+
+static void decode_octahedron(const S16* in, LLVector4a& v)
+{
+	F32 x = in[0] / 32767.f;
+	F32 y = in[1] / 32767.f;
+	F32 z = 1.f - fabsf(x) - fabsf(y);
+	if (z < 0.f)
+	{
+		F32 fx = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		F32 fy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = fx;
+		y = fy;
+	}
+	v.set(x, y, z, 0.f);
+	v.normalize3();
+}
+
+bool LLVolume::packProcessedFaces(std::vector<U8>& out) const
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	touchFaces();
+	if (mVolumeFaces.empty())
+	{
+		return false;
+	}
+
+	size_t size = sizeof(ProcessedHeader);
+	for (const LLVolumeFace& face : mVolumeFaces)
+	{
+		if (!face.mOptimized)
+		{ // only worth keeping once cacheOptimize() has been through it
+			return false;
+		}
+		size += sizeof(ProcessedFace) + face.mNumVertices * sizeof(ProcessedVertex);
+		if (face.mWeights)
+		{
+			size += face.mNumVertices * sizeof(LLVector4a);
+		}
+		size += processed_indices_size(face.mNumIndices);
+	}
+
+	out.clear();
+	out.resize(size, 0);
+	U8* dst = out.data();
+
+	ProcessedHeader header;
+	header.mMagic = PROCESSED_FACES_MAGIC;
+	header.mVersion = PROCESSED_FACES_VERSION;
+	header.mNumFaces = mVolumeFaces.size();
+	header.mSize = size;
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+
+	for (const LLVolumeFace& face : mVolumeFaces)
+	{
+		ProcessedFace pf;
+		memset(&pf, 0, sizeof(pf));
+		pf.mNumVertices = face.mNumVertices;
+		pf.mNumIndices = face.mNumIndices;
+		pf.mFlags = (face.mTangents ? PF_TANGENTS : 0) | (face.mWeights ? PF_WEIGHTS : 0);
+		memcpy(pf.mNormalizedScale, face.mNormalizedScale.mV, sizeof(pf.mNormalizedScale));
+		memcpy(pf.mExtents, face.mExtents[0].getF32ptr(), sizeof(F32) * 4);
+		memcpy(pf.mExtents + 4, face.mExtents[1].getF32ptr(), sizeof(F32) * 4);
+		memcpy(pf.mTexCoordExtents, face.mTexCoordExtents[0].mV, sizeof(F32) * 2);
+		memcpy(pf.mTexCoordExtents + 2, face.mTexCoordExtents[1].mV, sizeof(F32) * 2);
+		memcpy(dst, &pf, sizeof(pf));
+		dst += sizeof(pf);
+
+		for (S32 i = 0; i < face.mNumVertices; ++i)
+		{
+			ProcessedVertex v;
+			memcpy(v.mPosition, face.mPositions[i].getF32ptr(), sizeof(v.mPosition));
+			memcpy(v.mTexCoord, face.mTexCoords[i].mV, sizeof(v.mTexCoord));
+			encode_octahedron(face.mNormals[i], v.mNormal);
+			if (face.mTangents)
+			{
+				encode_octahedron(face.mTangents[i], v.mTangent);
+				v.mTangentSign = face.mTangents[i].getF32ptr()[3] < 0.f ? -1 : 1;
+			}
+			else
+			{
+				v.mTangent[0] = v.mTangent[1] = 0;
+				v.mTangentSign = 1;
+			}
+			v.mPad = 0;
+			memcpy(dst, &v, sizeof(v));
+			dst += sizeof(v);
+		}
+
+		if (face.mWeights)
+		{
+			memcpy(dst, face.mWeights, face.mNumVertices * sizeof(LLVector4a));
+			dst += face.mNumVertices * sizeof(LLVector4a);
+		}
+
+		if (face.mNumIndices)
+		{
+			memcpy(dst, face.mIndices, face.mNumIndices * sizeof(U16));
+		}
+		dst += processed_indices_size(face.mNumIndices);
+	}
+
+	llassert(dst == out.data() + out.size());
+	return true;
+}
+
+bool LLVolume::unpackProcessedFaces(const U8* in_data, S32 size)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	ProcessedHeader header;
+	if (!in_data || size < (S32)sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, in_data, sizeof(header));
+	if (header.mMagic != PROCESSED_FACES_MAGIC
+		|| header.mVersion != PROCESSED_FACES_VERSION
+		|| header.mSize != (U32)size
+		|| header.mNumFaces == 0)
+	{
+		return false;
+	}
+
+	discardCompressedFaces();
+	mVolumeFaces.clear();
+	mVolumeFaces.resize(header.mNumFaces);
+
+	size_t offset = sizeof(header);
+	for (LLVolumeFace& face : mVolumeFaces)
+	{
+		ProcessedFace pf;
+		if (offset + sizeof(pf) > (size_t)size)
+		{
+			mVolumeFaces.clear();
+			return false;
+		}
+		memcpy(&pf, in_data + offset, sizeof(pf));
+		offset += sizeof(pf);
+
+		size_t vertex_size = sizeof(ProcessedVertex) + ((pf.mFlags & PF_WEIGHTS) ? sizeof(LLVector4a) : 0);
+		if (pf.mNumVertices < 0 || pf.mNumVertices > 65536
+			|| pf.mNumIndices < 0 || pf.mNumIndices % 3 != 0
+			|| offset + pf.mNumVertices * vertex_size + processed_indices_size(pf.mNumIndices) > (size_t)size)
+		{
+			mVolumeFaces.clear();
+			return false;
+		}
+
+		if (pf.mNumVertices)
+		{
+			face.resizeVertices(pf.mNumVertices);
+			if (pf.mFlags & PF_TANGENTS)
+			{
+				face.allocateTangents(pf.mNumVertices);
+			}
+			if (pf.mFlags & PF_WEIGHTS)
+			{
+				face.allocateWeights(pf.mNumVertices);
+			}
+		}
+		if (pf.mNumIndices)
+		{
+			face.resizeIndices(pf.mNumIndices);
+		}
+
+		if ((pf.mNumVertices && !face.mPositions)
+			|| ((pf.mFlags & PF_TANGENTS) && pf.mNumVertices && !face.mTangents)
+			|| ((pf.mFlags & PF_WEIGHTS) && pf.mNumVertices && !face.mWeights)
+			|| (pf.mNumIndices && !face.mIndices))
+		{
+			LL_WARNS() << "Failed to allocate " << pf.mNumVertices << " vertices and " << pf.mNumIndices << " indices" << LL_ENDL;
+			mVolumeFaces.clear();
+			return false;
+		}
+
+		for (S32 i = 0; i < pf.mNumVertices; ++i)
+		{
+			ProcessedVertex v;
+			memcpy(&v, in_data + offset, sizeof(v));
+			offset += sizeof(v);
+
+			face.mPositions[i].load3(v.mPosition);
+			face.mTexCoords[i].set(v.mTexCoord[0], v.mTexCoord[1]);
+			decode_octahedron(v.mNormal, face.mNormals[i]);
+			if (face.mTangents)
+			{
+				decode_octahedron(v.mTangent, face.mTangents[i]);
+				face.mTangents[i].getF32ptr()[3] = v.mTangentSign < 0 ? -1.f : 1.f;
+			}
+		}
+
+		if (face.mWeights)
+		{
+			memcpy(face.mWeights, in_data + offset, pf.mNumVertices * sizeof(LLVector4a));
+			offset += pf.mNumVertices * sizeof(LLVector4a);
+		}
+
+		if (pf.mNumIndices)
+		{
+			memcpy(face.mIndices, in_data + offset, pf.mNumIndices * sizeof(U16));
+			for (S32 i = 0; i < pf.mNumIndices; ++i)
+			{
+				if (face.mIndices[i] >= pf.mNumVertices)
+				{
+					mVolumeFaces.clear();
+					return false;
+				}
+			}
+		}
+		offset += processed_indices_size(pf.mNumIndices);
+
+		face.mNormalizedScale.set(pf.mNormalizedScale);
+		face.mExtents[0].loadua(pf.mExtents);
+		face.mExtents[1].loadua(pf.mExtents + 4);
+		face.mTexCoordExtents[0].set(pf.mTexCoordExtents[0], pf.mTexCoordExtents[1]);
+		face.mTexCoordExtents[1].set(pf.mTexCoordExtents[2], pf.mTexCoordExtents[3]);
+		face.mOptimized = TRUE;
+	}
+
+	mSculptLevel = 0;
+
+	return true;
+}
+
+// vertex layout of a compressed face, before meshopt's vertex codec
+struct CompactVertex
+{
+	U16 mPosition[3];
+	S16 mTangentSign;
+	S16 mNormal[2];
+	S16 mTangent[2];
+	F32 mTexCoord[2];
+};
+
+static_assert(sizeof(CompactVertex) % 4 == 0, "meshopt vertex codec needs 4 byte multiples");
+
+bool LLVolume::compressFaces()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	std::lock_guard<std::mutex> lock(mFaceCompressMutex);
+	if (mFacesCompressed)
+	{
+		return true;
+	}
+	if (!mIsMeshAssetLoaded || mVolumeFaces.empty())
+	{ // prims and sculpts regenerate their faces, only mesh faces stay as loaded
+		return false;
+	}
+
+	std::vector<CompressedFace> compressed(mVolumeFaces.size());
+	std::vector<CompactVertex> vertices;
+	for (size_t f = 0; f < mVolumeFaces.size(); ++f)
+	{
+		const LLVolumeFace& face = mVolumeFaces[f];
+		CompressedFace& out = compressed[f];
+		out.mNumVertices = face.mNumVertices;
+		out.mNumIndices = face.mNumIndices;
+		out.mHasTangents = face.mTangents != NULL;
+		out.mHasWeights = face.mWeights != NULL;
+		out.mExpandedSize = 0;
+
+		if (face.mNumVertices > 0)
+		{
+			LLVector4a min = face.mPositions[0];
+			LLVector4a max = face.mPositions[0];
+			for (S32 i = 1; i < face.mNumVertices; ++i)
+			{
+				min.setMin(min, face.mPositions[i]);
+				max.setMax(max, face.mPositions[i]);
+			}
+			LLVector4a range;
+			range.setSub(max, min);
+
+			F32 inv_range[3];
+			for (S32 c = 0; c < 3; ++c)
+			{
+				out.mPositionMin[c] = min[c];
+				out.mPositionRange[c] = range[c];
+				inv_range[c] = range[c] > 0.f ? 1.f / range[c] : 0.f;
+			}
+
+			vertices.resize(face.mNumVertices);
+			for (S32 i = 0; i < face.mNumVertices; ++i)
+			{
+				CompactVertex& v = vertices[i];
+				const F32* p = face.mPositions[i].getF32ptr();
+				for (S32 c = 0; c < 3; ++c)
+				{
+					v.mPosition[c] = LLMeshOptimizer::quantizeUnorm16((p[c] - out.mPositionMin[c]) * inv_range[c]);
+				}
+				encode_octahedron(face.mNormals[i], v.mNormal);
+				if (face.mTangents)
+				{
+					encode_octahedron(face.mTangents[i], v.mTangent);
+					v.mTangentSign = face.mTangents[i].getF32ptr()[3] < 0.f ? -1 : 1;
+				}
+				else
+				{
+					v.mTangent[0] = v.mTangent[1] = 0;
+					v.mTangentSign = 1;
+				}
+				v.mTexCoord[0] = face.mTexCoords[i].mV[0];
+				v.mTexCoord[1] = face.mTexCoords[i].mV[1];
+			}
+
+			if (!LLMeshOptimizer::encodeVertexBuffer(out.mVertices, vertices.data(), face.mNumVertices, sizeof(CompactVertex))
+				|| (face.mWeights && !LLMeshOptimizer::encodeVertexBuffer(out.mWeights, face.mWeights, face.mNumVertices, sizeof(LLVector4a))))
+			{
+				return false;
+			}
+
+			// positions, normals and texture coordinates share one allocation
+			out.mExpandedSize += sizeof(LLVector4a) * 2 * face.mNumVertices + (((face.mNumVertices * sizeof(LLVector2)) + 0xF) & ~0xF);
+			out.mExpandedSize += (face.mTangents ? sizeof(LLVector4a) * face.mNumVertices : 0);
+			out.mExpandedSize += (face.mWeights ? sizeof(LLVector4a) * face.mNumVertices : 0);
+		}
+
+		if (face.mNumIndices > 0)
+		{
+			if (!LLMeshOptimizer::encodeIndexBufferU16(out.mIndices, face.mIndices, face.mNumIndices, face.mNumVertices))
+			{
+				return false;
+			}
+			out.mExpandedSize += ((face.mNumIndices * sizeof(U16)) + 0xF) & ~0xF;
+		}
+	}
+
+	for (LLVolumeFace& face : mVolumeFaces)
+	{
+		face.freeData();
+		face.mNumVertices = 0;
+		face.mNumAllocatedVertices = 0;
+		face.mNumIndices = 0;
+		face.mWeightsScrubbed = FALSE;
+		face.mJointRiggingInfoTab.clear();
+	}
+
+	mCompressedFaces.swap(compressed);
+	mFacesCompressed.store(true, std::memory_order_release);
+	return true;
+}
+
+void LLVolume::expandFaces()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	if (!mFacesCompressed)
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mFaceCompressMutex);
+	if (!mFacesCompressed)
+	{ // another thread expanded them while this one waited
+		return;
+	}
+
+	std::vector<CompactVertex> vertices;
+	for (size_t f = 0; f < mVolumeFaces.size() && f < mCompressedFaces.size(); ++f)
+	{
+		LLVolumeFace& face = mVolumeFaces[f];
+		const CompressedFace& in = mCompressedFaces[f];
+
+		bool success = true;
+		if (in.mNumVertices > 0)
+		{
+			vertices.resize(in.mNumVertices);
+			face.resizeVertices(in.mNumVertices);
+			if (in.mHasTangents)
+			{
+				face.allocateTangents(in.mNumVertices);
+			}
+			if (in.mHasWeights)
+			{
+				face.allocateWeights(in.mNumVertices);
+			}
+
+			success = face.mPositions
+				&& (!in.mHasTangents || face.mTangents)
+				&& (!in.mHasWeights || face.mWeights)
+				&& LLMeshOptimizer::decodeVertexBuffer(vertices.data(), in.mNumVertices, sizeof(CompactVertex), in.mVertices)
+				&& (!in.mHasWeights || LLMeshOptimizer::decodeVertexBuffer(face.mWeights, in.mNumVertices, sizeof(LLVector4a), in.mWeights));
+
+			for (S32 i = 0; success && i < in.mNumVertices; ++i)
+			{
+				const CompactVertex& v = vertices[i];
+				face.mPositions[i].set(in.mPositionMin[0] + v.mPosition[0] * in.mPositionRange[0] / 65535.f,
+									   in.mPositionMin[1] + v.mPosition[1] * in.mPositionRange[1] / 65535.f,
+									   in.mPositionMin[2] + v.mPosition[2] * in.mPositionRange[2] / 65535.f,
+									   0.f);
+				decode_octahedron(v.mNormal, face.mNormals[i]);
+				if (face.mTangents)
+				{
+					decode_octahedron(v.mTangent, face.mTangents[i]);
+					face.mTangents[i].getF32ptr()[3] = v.mTangentSign < 0 ? -1.f : 1.f;
+				}
+				face.mTexCoords[i].set(v.mTexCoord[0], v.mTexCoord[1]);
+			}
+		}
+
+		if (success && in.mNumIndices > 0)
+		{
+			face.resizeIndices(in.mNumIndices);
+			success = face.mIndices && LLMeshOptimizer::decodeIndexBufferU16(face.mIndices, in.mNumIndices, in.mIndices);
+		}
+
+		if (!success)
+		{ // out of memory, drop the face rather than hand out garbage
+			LL_WARNS() << "Failed to expand " << in.mNumVertices << " vertices and " << in.mNumIndices << " indices" << LL_ENDL;
+			face.freeData();
+			face.mNumVertices = 0;
+			face.mNumAllocatedVertices = 0;
+			face.mNumIndices = 0;
+		}
+	}
+
+	mCompressedFaces.clear();
+	// only now may other threads use the arrays
+	mFacesCompressed.store(false, std::memory_order_release);
+}
+
+S32 LLVolume::getCompressionSavings() const
+{
+	S32 savings = 0;
+	std::lock_guard<std::mutex> lock(mFaceCompressMutex);
+	if (mFacesCompressed)
+	{
+		for (const CompressedFace& face : mCompressedFaces)
+		{
+			savings += face.mExpandedSize - (S32)(face.mVertices.capacity() + face.mWeights.capacity() + face.mIndices.capacity());
+		}
+	}
+	return savings;
+}
+
+void LLVolume::discardCompressedFaces()
+{
+	std::lock_guard<std::mutex> lock(mFaceCompressMutex);
+	mCompressedFaces.clear();
+	mFacesCompressed = false;
+}
+
 
 bool LLVolume::isMeshAssetLoaded()
 {
@@ -2835,23 +3363,46 @@ bool LLVolume::isMeshAssetUnavaliable()
 
 void LLVolume::copyFacesTo(std::vector<LLVolumeFace> &faces) const 
 {
+	touchFaces();
 	faces = mVolumeFaces;
 }
 
 void LLVolume::copyFacesFrom(const std::vector<LLVolumeFace> &faces)
 {
+	discardCompressedFaces();
 	mVolumeFaces = faces;
 	mSculptLevel = 0;
 }
 
+void LLVolume::swapSculpt(LLVolume* volume)
+{
+	llassert(volume->mParams == mParams && volume->mDetail == mDetail);
+
+	discardCompressedFaces();
+	volume->discardCompressedFaces();
+
+	std::swap(mPathp, volume->mPathp);
+	std::swap(mProfilep, volume->mProfilep);
+	std::swap(mMesh.mArray, volume->mMesh.mArray);
+	std::swap(mMesh.mElementCount, volume->mMesh.mElementCount);
+	std::swap(mMesh.mCapacity, volume->mMesh.mCapacity);
+	mVolumeFaces.swap(volume->mVolumeFaces);
+	std::swap(mFaceMask, volume->mFaceMask);
+	std::swap(mSurfaceArea, volume->mSurfaceArea);
+	std::swap(mSculptLevel, volume->mSculptLevel);
+}
+
 void LLVolume::copyVolumeFaces(const LLVolume* volume)
 {
+	volume->touchFaces();
+	discardCompressedFaces();
 	mVolumeFaces = volume->mVolumeFaces;
 	mSculptLevel = 0;
 }
 
 bool LLVolume::cacheOptimize(bool gen_tangents)
 {
+	touchFaces();
 	for (S32 i = 0; i < mVolumeFaces.size(); ++i)
 	{
 		if (!mVolumeFaces[i].cacheOptimize(gen_tangents))
@@ -2873,6 +3424,8 @@ void LLVolume::createVolumeFaces()
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
 
+	touchFaces();
+
 	if (mGenerateSingleFace)
 	{
 		// do nothing
@@ -3811,12 +4364,24 @@ S32 LLVolume::getNumTriangles(S32* vcount) const
 	U32 triangle_count = 0;
 	U32 vertex_count = 0;
 
-	for (S32 i = 0; i < getNumVolumeFaces(); ++i)
+	std::lock_guard<std::mutex> lock(mFaceCompressMutex);
+	if (mFacesCompressed)
+	{ // no need to expand for the counts
+		for (const CompressedFace& face : mCompressedFaces)
+		{
+			triangle_count += face.mNumIndices/3;
+			vertex_count += face.mNumVertices;
+		}
+	}
+	else
 	{
-		const LLVolumeFace& face = getVolumeFace(i);
-		triangle_count += face.mNumIndices/3;
+		for (S32 i = 0; i < getNumVolumeFaces(); ++i)
+		{
+			const LLVolumeFace& face = mVolumeFaces[i];
+			triangle_count += face.mNumIndices/3;
 
-		vertex_count += face.mNumVertices;
+			vertex_count += face.mNumVertices;
+		}
 	}
 
 
@@ -3841,6 +4406,8 @@ void LLVolume::generateSilhouetteVertices(std::vector<LLVector3> &vertices,
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
 
+	touchFaces();
+
 	LLMatrix4a mat;
 	mat.loadu(mat_in);
 
@@ -4096,10 +4663,79 @@ void LLVolume::generateSilhouetteVertices(std::vector<LLVector3> &vertices,
 	}
 }
 
+// fill in the optional outputs of lineSegmentIntersect for a hit at
+// barycentric (a, b) of the triangle starting at face.mIndices[index]
+static void interpolate_hit(const LLVolumeFace& face, S32 index, F32 a, F32 b, F32 t,
+							const LLVector4a& start, const LLVector4a& dir,
+							LLVector4a* intersection, LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent_out)
+{
+	U16 idx0 = face.mIndices[index+0];
+	U16 idx1 = face.mIndices[index+1];
+	U16 idx2 = face.mIndices[index+2];
+
+	if (intersection != NULL)
+	{
+		LLVector4a intersect = dir;
+		intersect.mul(t);
+		intersect.add(start);
+		*intersection = intersect;
+	}
+
+	if (tex_coord != NULL)
+	{
+		LLVector2* tc = (LLVector2*) face.mTexCoords;
+		*tex_coord = ((1.f - a - b)  * tc[idx0] +
+			a              * tc[idx1] +
+			b              * tc[idx2]);
+	}
+
+	if (normal != NULL)
+	{
+		LLVector4a* norm = face.mNormals;
+
+		LLVector4a n1,n2,n3;
+		n1 = norm[idx0];
+		n1.mul(1.f-a-b);
+
+		n2 = norm[idx1];
+		n2.mul(a);
+
+		n3 = norm[idx2];
+		n3.mul(b);
+
+		n1.add(n2);
+		n1.add(n3);
+
+		*normal = n1;
+	}
+
+	if (tangent_out != NULL && face.mTangents)
+	{
+		LLVector4a* tangents = face.mTangents;
+
+		LLVector4a t1,t2,t3;
+		t1 = tangents[idx0];
+		t1.mul(1.f-a-b);
+
+		t2 = tangents[idx1];
+		t2.mul(a);
+
+		t3 = tangents[idx2];
+		t3.mul(b);
+
+		t1.add(t2);
+		t1.add(t3);
+
+		*tangent_out = t1;
+	}
+}
+
 S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& end, 
 								   S32 face,
 								   LLVector4a* intersection,LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent_out)
 {
+	touchFaces();
+
 	S32 hit_face = -1;
 	
 	S32 start_face;
@@ -4228,6 +4864,23 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 					}
 				}
 			}
+			else if (LLVolumeFace::sUseBVH)
+			{
+				const LLVolumeBVH* bvh = face.getBVH();
+				if (!bvh || !bvh->isValidFor(face))
+				{
+					face.createBVH();
+					bvh = face.getBVH();
+				}
+
+				F32 a, b;
+				S32 hit_index = bvh->intersect(face, start, dir, closest_t, a, b);
+				if (hit_index >= 0)
+				{
+					hit_face = i;
+					interpolate_hit(face, hit_index, a, b, closest_t, start, dir, intersection, tex_coord, normal, tangent_out);
+				}
+			}
 			else
 			{
                 if (!face.getOctree())
@@ -4792,6 +5445,7 @@ LLVolumeFace::LLVolumeFace() :
     mWeightsScrubbed(FALSE),
 	mOctree(NULL),
     mOctreeTriangles(NULL),
+    mBVH(NULL),
 	mOptimized(FALSE)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
@@ -4822,7 +5476,8 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
 #endif
     mWeightsScrubbed(FALSE),
     mOctree(NULL),
-    mOctreeTriangles(NULL)
+    mOctreeTriangles(NULL),
+    mBVH(NULL)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mCenter = mExtents+2;
@@ -4965,6 +5620,7 @@ void LLVolumeFace::freeData()
 #endif
 
     destroyOctree();
+    destroyBVH();
 }
 
 BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
@@ -4973,6 +5629,7 @@ BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
 
 	//tree for this face is no longer valid
     destroyOctree();
+    destroyBVH();
 
 	LL_CHECK_MEMORY
 	BOOL ret = FALSE ;
@@ -5082,6 +5739,45 @@ void LLVolumeFace::remap()
     mNumAllocatedVertices = remap_vertices_count;
 }
 
+bool LLVolumeFace::simplify(F32 index_ratio, F32 target_error)
+{
+    if (!mIndices || mNumIndices < 3 || index_ratio >= 1.f)
+    {
+        return false;
+    }
+
+    U64 target_indices = llmax((U64)(mNumIndices * index_ratio) / 3 * 3, (U64)3);
+    std::vector<U16> simplified(mNumIndices);
+    U64 new_count = LLMeshOptimizer::simplify(simplified.data(),
+        mIndices,
+        mNumIndices,
+        mPositions,
+        mNumVertices,
+        sizeof(LLVector4a),
+        target_indices,
+        target_error,
+        false,
+        NULL);
+
+    if (new_count < 3 || new_count >= (U64)mNumIndices)
+    {
+        return false;
+    }
+
+    resizeIndices((S32)new_count);
+    if (!mIndices)
+    {
+        return false;
+    }
+    memcpy(mIndices, simplified.data(), new_count * sizeof(U16));
+
+    // adjacency and picking structures describe the old triangles
+    mEdge.clear();
+    destroyOctree();
+    destroyBVH();
+    return true;
+}
+
 void LLVolumeFace::optimize(F32 angle_cutoff)
 {
 	LLVolumeFace new_face;
@@ -5755,6 +6451,33 @@ const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* LLVolumeFace::getOctree
     return mOctree;
 }
 
+void LLVolumeFace::createBVH()
+{
+    if (!mBVH)
+    {
+        mBVH = new LLVolumeBVH();
+    }
+    mBVH->build(*this);
+}
+
+void LLVolumeFace::destroyBVH()
+{
+    delete mBVH;
+    mBVH = NULL;
+}
+
+void LLVolumeFace::refitBVH()
+{
+    if (!mBVH)
+    {
+        createBVH();
+    }
+    else
+    {
+        mBVH->refit(*this);
+    }
+}
+
 
 void LLVolumeFace::swapData(LLVolumeFace& rhs)
 {
@@ -5765,6 +6488,10 @@ void LLVolumeFace::swapData(LLVolumeFace& rhs)
 	llswap(rhs.mIndices,mIndices);
 	llswap(rhs.mNumVertices, mNumVertices);
 	llswap(rhs.mNumIndices, mNumIndices);
+
+    // built against the old positions
+    destroyBVH();
+    rhs.destroyBVH();
 }
 
 void	LerpPlanarVertex(LLVolumeFace::VertexData& v0,
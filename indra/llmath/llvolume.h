@@ -27,7 +27,9 @@
 #ifndef LL_LLVOLUME_H
 #define LL_LLVOLUME_H
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
 
 class LLProfileParams;
 class LLPathParams;
@@ -41,6 +43,7 @@ template <class T, typename T_PTR> class LLOctreeNode;
 class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
+class LLVolumeBVH;
 
 #include "lluuid.h"
 #include "v4color.h"
@@ -867,6 +870,7 @@ public:
 
 	~LLVolumeFace();
 private:
+	friend class LLVolume;	// frees the arrays of compressed faces
 	void freeData();
 public:
 
@@ -907,6 +911,12 @@ public:
     // normals and texture coordinates into account.
     void remap();
 
+    // Drop triangles with meshoptimizer until about index_ratio of the
+    // indices are left or the shape would move by more than target_error
+    // (relative to its extents).  Vertices are left alone, so nothing that
+    // refers to them changes.  Returns false if nothing was removed.
+    bool simplify(F32 index_ratio, F32 target_error);
+
 	void optimize(F32 angle_cutoff = 2.f);
 	bool cacheOptimize(bool gen_tangents = false);
 
@@ -915,6 +925,18 @@ public:
     // Get a reference to the octree, which may be null
     const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* getOctree() const;
 
+    // Flat triangle hierarchy used for picking when sUseBVH is set.
+    // Unlike the octree it can be refit after the positions move.
+    void createBVH();
+    void destroyBVH();
+    // update bounds after mPositions changed, builds the tree if needed
+    void refitBVH();
+    // may be null
+    const LLVolumeBVH* getBVH() const { return mBVH; }
+
+    // see settings.xml "RenderPickBVH"
+    static bool sUseBVH;
+
 	enum
 	{
 		SINGLE_MASK =	0x0001,
@@ -989,6 +1011,7 @@ public:
 private:
     LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* mOctree;
     LLVolumeTriangle* mOctreeTriangles;
+    LLVolumeBVH* mBVH;
 
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
@@ -1070,16 +1093,43 @@ public:
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
-	static S32 sNumMeshPoints;
+	// volumes may be generated off the main thread, see LLVolumeMgr::setBuildQueue()
+	static std::atomic<S32> sNumMeshPoints;
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
 																				// conversion if *(LLVolume*) to LLVolume&
-	const LLVolumeFace &getVolumeFace(const S32 f) const {return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
+	const LLVolumeFace &getVolumeFace(const S32 f) const {touchFaces(); return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
 	
-	LLVolumeFace &getVolumeFace(const S32 f) {return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
-
-	face_list_t& getVolumeFaces() { return mVolumeFaces; }
+	LLVolumeFace &getVolumeFace(const S32 f) {touchFaces(); return mVolumeFaces[f];} // DO NOT DELETE VOLUME WHILE USING THIS REFERENCE, OR HOLD A POINTER TO THIS VOLUMEFACE
+
+	face_list_t& getVolumeFaces() { touchFaces(); return mVolumeFaces; }
+
+	// Quantize and meshopt encode the faces and free their vertex and index
+	// arrays, for volumes that aren't needed on the CPU for a while (mesh
+	// assets whose vertex buffers are built).  Anything that gets at the
+	// faces afterwards expands them again.  Positions are quantized to 16
+	// bits within the face bounds and normals and tangents are octahedron
+	// encoded, texture coordinates and weights are kept exact.  Returns false
+	// and leaves the faces alone if they can't be encoded.
+	//
+	// Main thread only, and never while another thread may be holding on to
+	// a face: the pipeline's parallel batches are over by the time the mesh
+	// repository sweeps, and the upload and decomposition threads work on
+	// LLModels, which are never mesh assets.  Expanding may happen on any
+	// thread, concurrent expands of the same volume wait on each other.
+	bool compressFaces();
+	void expandFaces();
+	bool isCompressed() const { return mFacesCompressed.load(std::memory_order_acquire); }
+
+	// bytes the faces would take expanded less what they take now
+	S32 getCompressionSavings() const;
+
+	// value of sFaceUseStamp when the faces were last asked for
+	U32 getLastFaceUse() const { return mLastFaceUse.load(std::memory_order_relaxed); }
+
+	// advanced by whatever compresses volumes that haven't been used lately
+	static std::atomic<U32> sFaceUseStamp;
 
 	U32					mFaceMask;			// bit array of which faces exist in this volume
 	LLVector3			mLODScaleBias;		// vector for biasing LOD based on scale
@@ -1088,6 +1138,9 @@ public:
 	void copyVolumeFaces(const LLVolume* volume);
 	void copyFacesTo(std::vector<LLVolumeFace> &faces) const;
 	void copyFacesFrom(const std::vector<LLVolumeFace> &faces);
+	// trade the sculpted shape with another volume of the same params and
+	// detail, e.g. one that was sculpted on another thread
+	void swapSculpt(LLVolume* volume);
 
     // use meshoptimizer to optimize index buffer for vertex shader cache
     //  gen_tangents - if true, generate MikkTSpace tangents if needed before optimizing index buffer
@@ -1107,6 +1160,11 @@ protected:
 public:
 	bool unpackVolumeFaces(std::istream& is, S32 size);
 	bool unpackVolumeFaces(U8* in_data, S32 size);
+
+	// faces as they are after unpackVolumeFaces(), in a flat block that
+	// unpackProcessedFaces() restores without decompressing or optimizing
+	bool packProcessedFaces(std::vector<U8>& out) const;
+	bool unpackProcessedFaces(const U8* in_data, S32 size);
 private:
 	bool unpackVolumeFacesInternal(const LLSD& mdl);
 
@@ -1133,6 +1191,36 @@ public:
 	BOOL mGenerateSingleFace;
 	face_list_t mVolumeFaces;
 
+	void touchFaces() const
+	{
+		mLastFaceUse.store(sFaceUseStamp.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		if (mFacesCompressed.load(std::memory_order_acquire))
+		{
+			const_cast<LLVolume*>(this)->expandFaces();
+		}
+	}
+	void discardCompressedFaces();
+
+	// encoded copy of a face while mFacesCompressed, see compressFaces()
+	struct CompressedFace
+	{
+		S32 mNumVertices;
+		S32 mNumIndices;
+		bool mHasTangents;
+		bool mHasWeights;
+		F32 mPositionMin[3];
+		F32 mPositionRange[3];
+		S32 mExpandedSize;
+		std::vector<U8> mVertices;
+		std::vector<U8> mWeights;
+		std::vector<U8> mIndices;
+	};
+	std::vector<CompressedFace> mCompressedFaces;
+	// cleared only once the faces are whole again, guarded by mFaceCompressMutex
+	std::atomic<bool> mFacesCompressed;
+	mutable std::atomic<U32> mLastFaceUse;
+	mutable std::mutex mFaceCompressMutex;
+
 public:
 	LLVector4a* mHullPoints;
 	U16* mHullIndices;
@@ -0,0 +1,314 @@
+/**
+ * @file llvolumebvh.cpp
+ * @brief Flat bounding volume hierarchy over the triangles of a volume face.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumebvh.h"
+
+#include "llvolume.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    const U32 MAX_LEAF_TRIANGLES = 4;
+    // median splits keep the depth near log2(triangles / MAX_LEAF_TRIANGLES),
+    // 64 covers far more than the 16 bit index buffers can address
+    const S32 MAX_STACK_DEPTH = 64;
+
+    // slab test of the segment start + t * dir against a node's box,
+    // t_near is where the segment enters the box
+    bool ray_box(const LLVector4a& box_min, const LLVector4a& box_max,
+                 const LLVector4a& start, const LLVector4a& inv_dir, F32 max_t, F32& t_near)
+    {
+        LLVector4a t0, t1;
+        t0.setSub(box_min, start);
+        t0.mul(inv_dir);
+        t1.setSub(box_max, start);
+        t1.mul(inv_dir);
+
+        LLVector4a t_min, t_max;
+        t_min.setMin(t0, t1);
+        t_max.setMax(t0, t1);
+
+        F32 t_enter = llmax(llmax(t_min[0], t_min[1]), t_min[2]);
+        F32 t_exit = llmin(llmin(t_max[0], t_max[1]), t_max[2]);
+
+        t_near = t_enter;
+        return t_exit >= llmax(t_enter, 0.f) && t_enter <= max_t;
+    }
+}
+
+LLVolumeBVH::LLVolumeBVH()
+    : mNumIndices(0)
+{
+}
+
+void LLVolumeBVH::build(const LLVolumeFace& face)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    mNodes.clear();
+    mTriangles.clear();
+    mNumIndices = face.mNumIndices;
+
+    U32 tri_count = face.mNumIndices / 3;
+    if (tri_count == 0)
+    {
+        return;
+    }
+
+    std::vector<LLVector4a> centers(tri_count);
+    mTriangles.resize(tri_count);
+    for (U32 i = 0; i < tri_count; ++i)
+    {
+        const LLVector4a& v0 = face.mPositions[face.mIndices[i * 3 + 0]];
+        const LLVector4a& v1 = face.mPositions[face.mIndices[i * 3 + 1]];
+        const LLVector4a& v2 = face.mPositions[face.mIndices[i * 3 + 2]];
+
+        LLVector4a min, max;
+        min.setMin(v0, v1);
+        min.setMin(min, v2);
+        max.setMax(v0, v1);
+        max.setMax(max, v2);
+
+        centers[i].setAdd(min, max);
+        centers[i].mul(0.5f);
+        mTriangles[i] = i;
+    }
+
+    mNodes.reserve(tri_count * 2 / MAX_LEAF_TRIANGLES + 1);
+    buildNode(face, centers, 0, tri_count);
+}
+
+U32 LLVolumeBVH::buildNode(const LLVolumeFace& face, std::vector<LLVector4a>& centers, U32 first, U32 count)
+{
+    U32 index = (U32)mNodes.size();
+    mNodes.emplace_back();
+
+    if (count <= MAX_LEAF_TRIANGLES)
+    {
+        Node& leaf = mNodes[index];
+        leaf.mFirst = first;
+        leaf.mCount = count;
+        boundTriangles(face, leaf);
+        return index;
+    }
+
+    // split at the median along the longest axis of the triangle centers
+    LLVector4a center_min = centers[mTriangles[first]];
+    LLVector4a center_max = center_min;
+    for (U32 i = first + 1; i < first + count; ++i)
+    {
+        center_min.setMin(center_min, centers[mTriangles[i]]);
+        center_max.setMax(center_max, centers[mTriangles[i]]);
+    }
+
+    LLVector4a extent;
+    extent.setSub(center_max, center_min);
+    S32 axis = 0;
+    if (extent[1] > extent[axis])
+    {
+        axis = 1;
+    }
+    if (extent[2] > extent[axis])
+    {
+        axis = 2;
+    }
+
+    U32 mid = first + count / 2;
+    std::nth_element(mTriangles.begin() + first, mTriangles.begin() + mid, mTriangles.begin() + first + count,
+                     [&centers, axis](U32 lhs, U32 rhs) { return centers[lhs][axis] < centers[rhs][axis]; });
+
+    U32 left = buildNode(face, centers, first, mid - first);
+    U32 right = buildNode(face, centers, mid, first + count - mid);
+
+    // children were appended, so look the node up again
+    Node& node = mNodes[index];
+    node.mFirst = right;
+    node.mCount = 0;
+    node.mMin.setMin(mNodes[left].mMin, mNodes[right].mMin);
+    node.mMax.setMax(mNodes[left].mMax, mNodes[right].mMax);
+    return index;
+}
+
+void LLVolumeBVH::boundTriangles(const LLVolumeFace& face, Node& node) const
+{
+    const LLVector4a& first = face.mPositions[face.mIndices[mTriangles[node.mFirst] * 3]];
+    node.mMin = first;
+    node.mMax = first;
+
+    for (U32 i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+    {
+        U32 tri = mTriangles[i];
+        for (U32 k = 0; k < 3; ++k)
+        {
+            const LLVector4a& v = face.mPositions[face.mIndices[tri * 3 + k]];
+            node.mMin.setMin(node.mMin, v);
+            node.mMax.setMax(node.mMax, v);
+        }
+    }
+}
+
+void LLVolumeBVH::refit(const LLVolumeFace& face)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (!isValidFor(face))
+    {
+        build(face);
+        return;
+    }
+
+    // children always come after their parent, so walking backwards
+    // updates both children before the node that encloses them
+    for (S32 i = (S32)mNodes.size() - 1; i >= 0; --i)
+    {
+        Node& node = mNodes[i];
+        if (node.mCount)
+        {
+            boundTriangles(face, node);
+        }
+        else
+        {
+            node.mMin.setMin(mNodes[i + 1].mMin, mNodes[node.mFirst].mMin);
+            node.mMax.setMax(mNodes[i + 1].mMax, mNodes[node.mFirst].mMax);
+        }
+    }
+}
+
+bool LLVolumeBVH::isValidFor(const LLVolumeFace& face) const
+{
+    return !mNodes.empty() && mNumIndices == face.mNumIndices;
+}
+
+S32 LLVolumeBVH::intersect(const LLVolumeFace& face, const LLVector4a& start, const LLVector4a& dir,
+                           F32& closest_t, F32& hit_a, F32& hit_b) const
+{
+    if (mNodes.empty())
+    {
+        return -1;
+    }
+
+    // keep the slab test finite for axis aligned rays
+    F32 inv[3];
+    for (S32 i = 0; i < 3; ++i)
+    {
+        F32 d = dir[i];
+        if (fabsf(d) < 1e-20f)
+        {
+            d = d < 0.f ? -1e-20f : 1e-20f;
+        }
+        inv[i] = 1.f / d;
+    }
+    LLVector4a inv_dir(inv[0], inv[1], inv[2]);
+
+    F32 t_near;
+    if (!ray_box(mNodes[0].mMin, mNodes[0].mMax, start, inv_dir, llmin(closest_t, 1.f), t_near))
+    {
+        return -1;
+    }
+
+    // nodes waiting to be visited along with where the segment enters them
+    std::pair<U32, F32> stack[MAX_STACK_DEPTH];
+    S32 top = 0;
+    stack[top++] = std::make_pair(0U, t_near);
+
+    S32 hit = -1;
+    while (top > 0)
+    {
+        U32 index = stack[top - 1].first;
+        F32 entry_t = stack[top - 1].second;
+        --top;
+        if (entry_t > closest_t)
+        {   // a hit found since this node was pushed is already closer
+            continue;
+        }
+
+        const Node& node = mNodes[index];
+
+        if (node.mCount)
+        {
+            for (U32 i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+            {
+                U32 tri = mTriangles[i];
+                const LLVector4a& v0 = face.mPositions[face.mIndices[tri * 3 + 0]];
+                const LLVector4a& v1 = face.mPositions[face.mIndices[tri * 3 + 1]];
+                const LLVector4a& v2 = face.mPositions[face.mIndices[tri * 3 + 2]];
+
+                F32 a, b, t;
+                if (LLTriangleRayIntersect(v0, v1, v2, start, dir, a, b, t) &&
+                    t >= 0.f && t <= 1.f && t < closest_t)
+                {
+                    closest_t = t;
+                    hit_a = a;
+                    hit_b = b;
+                    hit = (S32)(tri * 3);
+                }
+            }
+            continue;
+        }
+
+        U32 left = index + 1;
+        U32 right = node.mFirst;
+        F32 max_t = llmin(closest_t, 1.f);
+        F32 t_left, t_right;
+        bool hit_left = ray_box(mNodes[left].mMin, mNodes[left].mMax, start, inv_dir, max_t, t_left);
+        bool hit_right = ray_box(mNodes[right].mMin, mNodes[right].mMax, start, inv_dir, max_t, t_right);
+
+        if (top + 2 > MAX_STACK_DEPTH)
+        {
+            llassert(false);
+            break;
+        }
+
+        // push the far child first so the near one is visited first
+        if (hit_left && hit_right)
+        {
+            if (t_left < t_right)
+            {
+                stack[top++] = std::make_pair(right, t_right);
+                stack[top++] = std::make_pair(left, t_left);
+            }
+            else
+            {
+                stack[top++] = std::make_pair(left, t_left);
+                stack[top++] = std::make_pair(right, t_right);
+            }
+        }
+        else if (hit_left)
+        {
+            stack[top++] = std::make_pair(left, t_left);
+        }
+        else if (hit_right)
+        {
+            stack[top++] = std::make_pair(right, t_right);
+        }
+    }
+
+    return hit;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file llvolumebvh.h
+ * @brief Flat bounding volume hierarchy over the triangles of a volume face.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEBVH_H
+#define LL_LLVOLUMEBVH_H
+
+#include "llmath.h"
+#include "llvector4a.h"
+
+#include <vector>
+
+class LLVolumeFace;
+
+// Raycast acceleration for a single volume face. Nodes live in one array in
+// depth first order and only refer to triangles by index, so when a face is
+// re-skinned the tree can be refit to the new positions in one pass instead
+// of being rebuilt the way the triangle octree has to be.
+class LLVolumeBVH
+{
+public:
+    LLVolumeBVH();
+
+    void build(const LLVolumeFace& face);
+
+    // recompute bounds after the face's positions changed, indices must not have
+    void refit(const LLVolumeFace& face);
+
+    // true if built for a face with this many indices
+    bool isValidFor(const LLVolumeFace& face) const;
+
+    // Closest triangle hit along start + t * dir with 0 <= t <= 1 and
+    // t < closest_t. Returns the index of its first vertex index in the
+    // face's index buffer, or -1 if nothing closer was hit.
+    S32 intersect(const LLVolumeFace& face, const LLVector4a& start, const LLVector4a& dir,
+                  F32& closest_t, F32& hit_a, F32& hit_b) const;
+
+    size_t getNodeCount() const { return mNodes.size(); }
+
+private:
+    struct alignas(16) Node
+    {
+        LLVector4a mMin;
+        LLVector4a mMax;
+        // leaf: first slot in mTriangles; inner: index of the second child,
+        // the first child is always the next node
+        U32 mFirst;
+        // triangles in a leaf, 0 for inner nodes
+        U32 mCount;
+    };
+
+    U32 buildNode(const LLVolumeFace& face, std::vector<LLVector4a>& centers, U32 first, U32 count);
+    void boundTriangles(const LLVolumeFace& face, Node& node) const;
+
+    std::vector<Node> mNodes;
+    // triangle numbers in leaf order
+    std::vector<U32> mTriangles;
+    S32 mNumIndices;
+};
+
+#endif // LL_LLVOLUMEBVH_H
@@ -40,11 +40,21 @@ F32 LLVolumeLODGroup::mDetailThresholds[NUM_LODS] = {BASE_THRESHOLD,
 //static
 F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 
+//static
+std::atomic<bool> LLVolumeLODGroup::sSimplifyLODs(false);
+
+// angle a pixel covers at typical window sizes, simplified LODs may move
+// the surface by about this much at the size they are shown
+const F32 SIMPLIFY_PIXEL_ANGLE = 0.001f;
+
 
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
-:	mDataMutex(NULL)
+:	mDataMutex(NULL),
+	mFinishedBuilds(std::make_shared<FinishedBuilds>()),
+	mRetainedBytes(0),
+	mRetentionBudget(0)
 {
 	// the LLMutex magic interferes with easy unit testing,
 	// so you now must manually call useMutex() to use it
@@ -62,6 +72,7 @@ LLVolumeMgr::~LLVolumeMgr()
 BOOL LLVolumeMgr::cleanup()
 {
 	BOOL no_refs = TRUE;
+	mPendingSculpts.clear();
 	if (mDataMutex)
 	{
 		mDataMutex->lock();
@@ -78,6 +89,8 @@ BOOL LLVolumeMgr::cleanup()
  		delete volgroupp;
 	}
 	mVolumeLODGroups.clear();
+	mRetainedGroups.clear();
+	mRetainedBytes = 0;
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
@@ -96,20 +109,147 @@ LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32
 	{
 		mDataMutex->lock();
 	}
-	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
-	if( iter == mVolumeLODGroups.end() )
+	volgroupp = findOrCreateGroup(volume_params);
+	if (mDataMutex)
 	{
-		volgroupp = createNewGroup(volume_params);
+		mDataMutex->unlock();
 	}
-	else
+	return volgroupp->refLOD(lod);
+}
+
+void LLVolumeMgr::setBuildQueue(const post_t& post)
+{
+	mBuildPost = post;
+}
+
+LLVolume* LLVolumeMgr::refVolumeOrClosest(const LLVolumeParams &volume_params, const S32 detail)
+{
+	if (!mBuildPost ||
+		detail == 0 ||
+		volume_params.getSculptType() != LL_SCULPT_TYPE_NONE ||
+		volume_params.getSculptID().notNull() ||
+		volume_params.getPathParams().getCurveType() == LL_PCODE_PATH_FLEXIBLE)
 	{
-		volgroupp = iter->second;
+		return refVolume(volume_params, detail);
+	}
+
+	LLVolumeLODGroup* volgroupp;
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
 	}
+	volgroupp = findOrCreateGroup(volume_params);
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
 	}
-	return volgroupp->refLOD(lod);
+
+	if (volgroupp->hasLOD(detail))
+	{
+		return volgroupp->refLOD(detail);
+	}
+
+	if (!volgroupp->isLODPending(detail))
+	{
+		LLVolumeParams params = volume_params;
+		std::shared_ptr<FinishedBuilds> finished = mFinishedBuilds;
+		bool posted = mBuildPost([params, detail, finished]()
+			{
+				LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("volume build");
+				LLPointer<LLVolume> volumep = LLVolumeLODGroup::createVolume(params, detail);
+				// hand our reference over under the lock, LLRefCount isn't atomic
+				LLMutexLock lock(&finished->mMutex);
+				finished->mVolumes.emplace_back(detail, std::move(volumep));
+			});
+
+		if (!posted)
+		{
+			return volgroupp->refLOD(detail);
+		}
+		volgroupp->setLODPending(detail, true);
+	}
+
+	LLVolume* volumep = volgroupp->refClosestLOD(detail);
+	return volumep ? volumep : volgroupp->refLOD(0);
+}
+
+bool LLVolumeMgr::isLODReady(const LLVolumeParams &volume_params, const S32 detail) const
+{
+	LLVolumeLODGroup* volgroupp = getGroup(volume_params);
+	return volgroupp && volgroupp->hasLOD(detail);
+}
+
+bool LLVolumeMgr::queueSculpt(LLVolume* volumep, const sculpt_func_t& generate, const sculpt_func_t& done)
+{
+	if (!mBuildPost)
+	{
+		return false;
+	}
+
+	// the job only gets copies, volumep itself stays on this thread
+	LLVolumeParams params = volumep->getParams();
+	F32 detail = volumep->getDetail();
+	std::shared_ptr<FinishedBuilds> finished = mFinishedBuilds;
+	bool posted = mBuildPost([volumep, params, detail, generate, finished]()
+		{
+			LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("sculpt build");
+			LLPointer<LLVolume> sculpted = new LLVolume(params, detail);
+			generate(sculpted);
+			// as in refVolumeOrClosest(), give up our reference under the lock
+			LLMutexLock lock(&finished->mMutex);
+			finished->mSculpts.emplace_back(volumep, std::move(sculpted));
+		});
+
+	if (posted)
+	{
+		PendingSculpt& pending = mPendingSculpts[volumep];
+		pending.mVolume = volumep;
+		pending.mDone = done;
+	}
+	return posted;
+}
+
+void LLVolumeMgr::updateBuilds()
+{
+	std::vector<std::pair<S32, LLPointer<LLVolume> > > volumes;
+	std::vector<std::pair<LLVolume*, LLPointer<LLVolume> > > sculpts;
+	{
+		LLMutexLock lock(&mFinishedBuilds->mMutex);
+		volumes.swap(mFinishedBuilds->mVolumes);
+		sculpts.swap(mFinishedBuilds->mSculpts);
+	}
+
+	for (auto& sculpted : sculpts)
+	{
+		auto iter = mPendingSculpts.find(sculpted.first);
+		if (iter == mPendingSculpts.end() ||
+			iter->second.mVolume->getParams() != sculpted.second->getParams())
+		{ // dropped by cleanup(), the address may have been reused since
+			continue;
+		}
+
+		PendingSculpt pending = iter->second;
+		mPendingSculpts.erase(iter);
+		pending.mVolume->swapSculpt(sculpted.second);
+		if (pending.mDone)
+		{
+			pending.mDone(pending.mVolume);
+		}
+	}
+
+	for (auto& finished : volumes)
+	{
+		// nothing to do if every object using the shape went away in the meantime
+		LLVolumeLODGroup* volgroupp = getGroup(finished.second->getParams());
+		if (volgroupp)
+		{
+			volgroupp->setLODPending(finished.first, false);
+			if (!volgroupp->mRetained)
+			{ // retained groups keep the size they were accounted at
+				volgroupp->setLOD(finished.first, finished.second);
+			}
+		}
+	}
 }
 
 // virtual
@@ -159,7 +299,7 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 		LLVolumeLODGroup* volgroupp = iter->second;
 
 		volgroupp->derefLOD(volumep);
-		if (volgroupp->getNumRefs() == 0)
+		if (volgroupp->getNumRefs() == 0 && !retainGroup(volgroupp))
 		{
 			mVolumeLODGroups.erase(params);
 			delete volgroupp;
@@ -186,6 +326,105 @@ LLVolumeLODGroup* LLVolumeMgr::createNewGroup(const LLVolumeParams& volume_param
 	return volgroup;
 }
 
+// protected
+LLVolumeLODGroup* LLVolumeMgr::findOrCreateGroup(const LLVolumeParams& volume_params)
+{
+	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+	if (iter == mVolumeLODGroups.end())
+	{
+		return createNewGroup(volume_params);
+	}
+
+	LLVolumeLODGroup* volgroupp = iter->second;
+	if (volgroupp->mRetained)
+	{
+		mRetainedGroups.erase(volgroupp->mRetainedIter);
+		mRetainedBytes -= volgroupp->mRetainedBytes;
+		volgroupp->mRetained = false;
+	}
+	return volgroupp;
+}
+
+// protected
+bool LLVolumeMgr::retainGroup(LLVolumeLODGroup* volgroupp)
+{
+	const LLVolumeParams* params = volgroupp->getVolumeParams();
+	if (!mRetentionBudget ||
+		params->getSculptType() != LL_SCULPT_TYPE_NONE ||
+		params->getSculptID().notNull() ||
+		params->getPathParams().getCurveType() == LL_PCODE_PATH_FLEXIBLE)
+	{ // only plain prims are generated from their params alone
+		return false;
+	}
+
+	U32 bytes = volgroupp->getFaceBytes();
+	if (bytes > mRetentionBudget)
+	{
+		return false;
+	}
+
+	volgroupp->mRetained = true;
+	volgroupp->mRetainedBytes = bytes;
+	volgroupp->mRetainedIter = mRetainedGroups.insert(mRetainedGroups.end(), volgroupp);
+	mRetainedBytes += bytes;
+
+	trimRetained(mRetentionBudget);
+	return true;
+}
+
+// protected
+void LLVolumeMgr::trimRetained(U64 budget)
+{
+	while (mRetainedBytes > budget && !mRetainedGroups.empty())
+	{
+		LLVolumeLODGroup* volgroupp = mRetainedGroups.front();
+		mRetainedGroups.pop_front();
+		mRetainedBytes -= volgroupp->mRetainedBytes;
+		mVolumeLODGroups.erase(volgroupp->getVolumeParams());
+		delete volgroupp;
+	}
+}
+
+void LLVolumeMgr::setRetentionBudget(U64 bytes)
+{
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	mRetentionBudget = bytes;
+	trimRetained(bytes);
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+}
+
+void LLVolumeMgr::getFaceBytes(U64 bytes[LLVolumeLODGroup::NUM_LODS]) const
+{
+	for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; i++)
+	{
+		bytes[i] = 0;
+	}
+
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	for (volume_lod_group_map_t::const_iterator iter = mVolumeLODGroups.begin(),
+			 end = mVolumeLODGroups.end();
+		 iter != end; iter++)
+	{
+		for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; i++)
+		{
+			bytes[i] += iter->second->getFaceBytes(i);
+		}
+	}
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+}
+
 // virtual
 void LLVolumeMgr::dump()
 {
@@ -247,7 +486,10 @@ std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 
 LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	: mVolumeParams(params),
-	  mRefs(0)
+	  mRefs(0),
+	  mPendingLODs(0),
+	  mRetained(false),
+	  mRetainedBytes(0)
 {
 	for (S32 i = 0; i < NUM_LODS; i++)
 	{
@@ -295,12 +537,124 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 lod)
 	mRefs++;
 	if (mVolumeLODs[lod].isNull())
 	{
-		mVolumeLODs[lod] = new LLVolume(mVolumeParams, mDetailScales[lod]);
+		mVolumeLODs[lod] = createVolume(mVolumeParams, lod);
 	}
 	mLODRefs[lod]++;
 	return mVolumeLODs[lod];
 }
 
+//static
+LLVolume* LLVolumeLODGroup::createVolume(const LLVolumeParams& params, const S32 detail)
+{
+	LLVolume* volumep = new LLVolume(params, mDetailScales[detail]);
+
+	if (!sSimplifyLODs ||
+		detail >= NUM_LODS - 1 ||
+		params.getSculptType() != LL_SCULPT_TYPE_NONE ||
+		params.getSculptID().notNull() ||
+		params.getPathParams().getCurveType() == LL_PCODE_PATH_FLEXIBLE)
+	{
+		return volumep;
+	}
+
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	LLPointer<LLVolume> high = new LLVolume(params, mDetailScales[NUM_LODS - 1]);
+	if (high->getNumVolumeFaces() != volumep->getNumVolumeFaces())
+	{
+		return volumep;
+	}
+
+	// Aim for the triangle count the coarser tessellation would have, which
+	// grows with the square of the detail scale, but keep whatever it takes
+	// to stay within a pixel or so at the largest size this LOD is shown.
+	F32 ratio = mDetailScales[detail] / mDetailScales[NUM_LODS - 1];
+	ratio *= ratio;
+	F32 target_error = SIMPLIFY_PIXEL_ANGLE / mDetailThresholds[detail];
+
+	std::vector<LLVolumeFace> faces;
+	high->copyFacesTo(faces);
+	bool simplified = false;
+	for (LLVolumeFace& face : faces)
+	{
+		simplified |= face.simplify(ratio, target_error);
+	}
+
+	if (simplified)
+	{
+		volumep->copyFacesFrom(faces);
+	}
+	return volumep;
+}
+
+LLVolume* LLVolumeLODGroup::refClosestLOD(const S32 detail)
+{
+	for (S32 i = 1; i < NUM_LODS; i++)
+	{
+		if (detail - i >= 0 && hasLOD(detail - i))
+		{
+			return refLOD(detail - i);
+		}
+		if (detail + i < NUM_LODS && hasLOD(detail + i))
+		{
+			return refLOD(detail + i);
+		}
+	}
+	return NULL;
+}
+
+void LLVolumeLODGroup::setLOD(const S32 detail, LLVolume* volumep)
+{
+	llassert(detail >= 0 && detail < NUM_LODS);
+	if (mVolumeLODs[detail].isNull())
+	{
+		mVolumeLODs[detail] = volumep;
+	}
+}
+
+U32 LLVolumeLODGroup::getFaceBytes() const
+{
+	U32 bytes = 0;
+	for (S32 i = 0; i < NUM_LODS; i++)
+	{
+		bytes += getFaceBytes(i);
+	}
+	return bytes;
+}
+
+U32 LLVolumeLODGroup::getFaceBytes(const S32 detail) const
+{
+	const LLVolume* volumep = mVolumeLODs[detail];
+	if (!volumep)
+	{
+		return 0;
+	}
+
+	U32 bytes = 0;
+	for (S32 f = 0; f < volumep->getNumVolumeFaces(); f++)
+	{
+		const LLVolumeFace& face = volumep->getVolumeFace(f);
+		// positions, normals and texture coordinates share one allocation
+		bytes += sizeof(LLVector4a) * 2 * face.mNumVertices + sizeof(LLVector2) * face.mNumVertices;
+		bytes += face.mTangents ? sizeof(LLVector4a) * face.mNumVertices : 0;
+		bytes += face.mWeights ? sizeof(LLVector4a) * face.mNumVertices : 0;
+		bytes += sizeof(U16) * face.mNumIndices;
+	}
+	return bytes;
+}
+
+void LLVolumeLODGroup::setLODPending(const S32 detail, bool pending)
+{
+	if (pending)
+	{
+		mPendingLODs |= (1 << detail);
+	}
+	else
+	{
+		mPendingLODs &= ~(1 << detail);
+	}
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
 	llassert_always(mRefs > 0);
@@ -27,7 +27,12 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <atomic>
+#include <functional>
+#include <list>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "llvolume.h"
 #include "llpointer.h"
@@ -39,6 +44,7 @@ class LLVolumeLODGroup;
 class LLVolumeLODGroup
 {
 	LOG_CLASS(LLVolumeLODGroup);
+	friend class LLVolumeMgr;
 	
 public:
 	enum
@@ -55,9 +61,31 @@ public:
 	static F32 getVolumeScaleFromDetail(const S32 detail);
 	static S32 getVolumeDetailFromScale(F32 scale);
 
+	// Build the shape for a LOD.  With simplification on, the lower LODs of
+	// plain prims are the full detail shape with the triangles that wouldn't
+	// be visible at that LOD's distance removed, rather than a coarser
+	// tessellation.  Only affects shapes built from then on.
+	static LLVolume* createVolume(const LLVolumeParams& params, const S32 detail);
+	static void setSimplifyLODs(bool simplify) { sSimplifyLODs = simplify; }
+
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
 	S32 getNumRefs() const { return mRefs; }
+
+	bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
+	// reference the generated LOD nearest to detail, lower ones first, or return NULL if there are none
+	LLVolume* refClosestLOD(const S32 detail);
+	// adopt a LOD generated elsewhere, unless it has been generated here in the meantime
+	void setLOD(const S32 detail, LLVolume* volumep);
+
+	// LODs being generated on the volume manager's build queue
+	bool isLODPending(const S32 detail) const { return mPendingLODs & (1 << detail); }
+	void setLODPending(const S32 detail, bool pending);
+
+	// bytes taken by the faces of the generated LODs
+	U32 getFaceBytes() const;
+	// same for one LOD, 0 if it hasn't been generated
+	U32 getFaceBytes(const S32 detail) const;
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
 
@@ -72,7 +100,14 @@ protected:
 	LLPointer<LLVolume> mVolumeLODs[NUM_LODS];
 	static F32 mDetailThresholds[NUM_LODS];
 	static F32 mDetailScales[NUM_LODS];
+	static std::atomic<bool> sSimplifyLODs;
 	S32		mAccessCount[NUM_LODS];
+	U8		mPendingLODs;
+
+	// kept by LLVolumeMgr after the last reference went away, see setRetentionBudget()
+	bool	mRetained;
+	U32		mRetainedBytes;
+	std::list<LLVolumeLODGroup*>::iterator mRetainedIter;
 };
 
 class LLVolumeMgr
@@ -90,6 +125,50 @@ public:
 	virtual LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail);
 	virtual void unrefVolume(LLVolume *volumep);
 
+	// Posts work to another thread, returns false if it couldn't be queued.
+	typedef std::function<bool(const std::function<void()>&)> post_t;
+
+	// Generate LODs that haven't been seen yet with post rather than on the
+	// thread asking for them, see refVolumeOrClosest()
+	void setBuildQueue(const post_t& post);
+
+	// Like refVolume(), but a LOD that hasn't been generated yet is queued on
+	// the build queue and the nearest LOD the shape already has is returned in
+	// its place, generating the cheap lowest LOD on the spot if there is none.
+	// Ask again once isLODReady() says the real one has arrived.  Sculpts,
+	// meshes and flexis depend on more than their params and always go
+	// through refVolume(), as does everything when there is no build queue.
+	LLVolume* refVolumeOrClosest(const LLVolumeParams &volume_params, const S32 detail);
+
+	// true if detail of this shape has been generated
+	bool isLODReady(const LLVolumeParams &volume_params, const S32 detail) const;
+
+	// Regenerate a sculpted volume on the build queue.  generate is given a
+	// fresh volume with the same params and detail to sculpt there, and once
+	// it's done updateBuilds() swaps the result into volumep and calls done
+	// with it.  Returns false if there is no build queue or it wouldn't take
+	// the work, in which case sculpt on the spot.
+	typedef std::function<void(LLVolume*)> sculpt_func_t;
+	bool queueSculpt(LLVolume* volumep, const sculpt_func_t& generate, const sculpt_func_t& done);
+
+	// true between queueSculpt() and the result being swapped in
+	bool isSculptPending(LLVolume* volumep) const { return mPendingSculpts.count(volumep) > 0; }
+
+	// Hand LODs and sculpts finished on the build queue over to their groups
+	// and volumes.  Call regularly from the thread that refs volumes.
+	void updateBuilds();
+
+	// Keep up to bytes worth of prim shapes that nothing references any more
+	// instead of deleting them, so a shape that comes back isn't generated
+	// again.  The ones released longest ago go first when over budget, 0
+	// turns retention off.
+	void setRetentionBudget(U64 bytes);
+	U64 getRetainedBytes() const { return mRetainedBytes; }
+
+	// face bytes of every generated shape, retained ones included, by LOD
+	void getFaceBytes(U64 bytes[LLVolumeLODGroup::NUM_LODS]) const;
+	U32 getRetainedCount() const { return (U32)mRetainedGroups.size(); }
+
 	void dump();
 
 	// manually call this for mutex magic
@@ -102,11 +181,47 @@ protected:
 	// Overridden in llphysics/abstract/utils/llphysicsvolumemanager.h
 	virtual LLVolumeLODGroup* createNewGroup(const LLVolumeParams& volume_params);
 
+	// look up or create the group for volume_params, bringing it back from
+	// the retained list if it's there, caller must hold mDataMutex
+	LLVolumeLODGroup* findOrCreateGroup(const LLVolumeParams& volume_params);
+	// take a group without references into the retained list, false if it
+	// shouldn't be kept, caller must hold mDataMutex
+	bool retainGroup(LLVolumeLODGroup* volgroupp);
+	// free retained groups until they fit in budget, caller must hold mDataMutex
+	void trimRetained(U64 budget);
+
 protected:
 	typedef std::map<const LLVolumeParams*, LLVolumeLODGroup*, LLVolumeParams::compare> volume_lod_group_map_t;
 	volume_lod_group_map_t mVolumeLODGroups;
 
 	LLMutex* mDataMutex;
+
+	// LODs finished on the build queue, shared with the jobs so that they
+	// have somewhere to go if the manager is destroyed before they finish
+	struct FinishedBuilds
+	{
+		LLMutex mMutex;
+		std::vector<std::pair<S32, LLPointer<LLVolume> > > mVolumes;
+		// sculpted on the build queue, keyed by the volume to swap into
+		std::vector<std::pair<LLVolume*, LLPointer<LLVolume> > > mSculpts;
+	};
+
+	// Volumes waiting for a sculpt.  Only touched by the thread that refs
+	// volumes, which keeps them alive until the result has been swapped in.
+	struct PendingSculpt
+	{
+		LLPointer<LLVolume> mVolume;
+		sculpt_func_t mDone;
+	};
+	std::map<LLVolume*, PendingSculpt> mPendingSculpts;
+
+	post_t mBuildPost;
+	std::shared_ptr<FinishedBuilds> mFinishedBuilds;
+
+	// groups without references, released longest ago first
+	std::list<LLVolumeLODGroup*> mRetainedGroups;
+	U64 mRetainedBytes;
+	U64 mRetentionBudget;
 };
 
 #endif // LL_LLVOLUMEMGR_H
@@ -0,0 +1,160 @@
+/**
+ * @file   lloctree_test.cpp
+ * @date   2023-07-12
+ * @brief  Test for lloctree.h.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../lloctree.h"
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace
+{
+    class OctreeTestElement
+    {
+    public:
+        OctreeTestElement(const LLVector4a& position, F32 radius) :
+            mPosition(position),
+            mRadius(radius),
+            mBinIndex(-1)
+        {}
+
+        const LLVector4a& getPositionGroup() const { return mPosition; }
+        F32 getBinRadius() const { return mRadius; }
+        S32 getBinIndex() const { return mBinIndex; }
+        void setBinIndex(S32 idx) const { mBinIndex = idx; }
+
+    private:
+        LLVector4a mPosition;
+        F32 mRadius;
+        mutable S32 mBinIndex;
+    };
+
+    typedef LLOctreeNode<OctreeTestElement, OctreeTestElement*> TestNode;
+    typedef LLOctreeRoot<OctreeTestElement, OctreeTestElement*> TestRoot;
+
+    class CountTraveler : public LLOctreeTraveler<OctreeTestElement, OctreeTestElement*>
+    {
+    public:
+        void visit(const TestNode* branch) override
+        {
+            ++mNodes;
+            mElements += branch->getElementCount();
+            // each element's bin index points back at its slot
+            S32 index = 0;
+            for (TestNode::const_element_iter it = branch->getDataBegin(); it != branch->getDataEnd(); ++it, ++index)
+            {
+                if ((*it)->getBinIndex() != index)
+                {
+                    ++mBadBins;
+                }
+            }
+        }
+
+        U32 mNodes = 0;
+        U32 mElements = 0;
+        U32 mBadBins = 0;
+    };
+
+    // deterministic scatter so failures reproduce
+    std::vector<OctreeTestElement> makeElements(U32 count)
+    {
+        std::vector<OctreeTestElement> elements;
+        elements.reserve(count);
+        U32 seed = 12345;
+        auto next = [&seed]()
+        {
+            seed = seed * 1664525 + 1013904223;
+            return (F32)(seed >> 8) / (F32)(1 << 24);
+        };
+        for (U32 i = 0; i < count; ++i)
+        {
+            LLVector4a pos(next() * 256.f, next() * 256.f, next() * 256.f);
+            elements.emplace_back(pos, 0.1f + next());
+        }
+        return elements;
+    }
+}
+
+namespace tut
+{
+    struct octree_data
+    {
+        octree_data()
+        {
+            mMaxCapacity = gOctreeMaxCapacity;
+            mMinSize = gOctreeMinSize;
+            gOctreeMaxCapacity = 8;
+            gOctreeMinSize = 0.25f;
+        }
+
+        ~octree_data()
+        {
+            gOctreeMaxCapacity = mMaxCapacity;
+            gOctreeMinSize = mMinSize;
+        }
+
+        U32 mMaxCapacity;
+        F32 mMinSize;
+    };
+    typedef test_group<octree_data> octree_group;
+    typedef octree_group::object object;
+    octree_group octreegrp("LLOctree");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("insert, traverse and remove");
+        const U32 COUNT = 20000;
+        std::vector<OctreeTestElement> elements = makeElements(COUNT);
+
+        LLVector4a center(128.f, 128.f, 128.f);
+        LLVector4a size(128.f, 128.f, 128.f);
+        TestRoot* root = new TestRoot(center, size, NULL);
+
+        for (OctreeTestElement& element : elements)
+        {
+            root->insert(&element);
+        }
+
+        CountTraveler traveler;
+        traveler.traverse(root);
+        ensure_equals("every element is in the tree", traveler.mElements, COUNT);
+        ensure("elements were spread over child nodes", traveler.mNodes > 1);
+        ensure_equals("bin indexes match the node lists", traveler.mBadBins, 0U);
+
+        for (OctreeTestElement& element : elements)
+        {
+            ensure("element has a bin", element.getBinIndex() >= 0);
+            root->remove(&element);
+            ensure_equals("removed element has no bin", element.getBinIndex(), -1);
+        }
+
+        CountTraveler empty;
+        empty.traverse(root);
+        ensure_equals("tree is empty", empty.mElements, 0U);
+
+        delete root;
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("freed nodes are reused");
+        LLVector4a center(0.f, 0.f, 0.f);
+        LLVector4a size(16.f, 16.f, 16.f);
+
+        TestNode* first = new TestNode(center, size, NULL);
+        ensure("node is 16 byte aligned", ((uintptr_t)first & 0xF) == 0);
+        delete first;
+        TestNode* second = new TestNode(center, size, NULL);
+        ensure("freed node was handed out again", first == second);
+        delete second;
+    }
+}
@@ -337,3 +337,51 @@ U64 LLMeshOptimizer::simplify(U16 *destination,
     }
 }
 
+//static
+bool LLMeshOptimizer::encodeVertexBuffer(std::vector<U8>& out,
+    const void* vertices,
+    U64 vertex_count,
+    U64 vertex_size)
+{
+    out.resize(meshopt_encodeVertexBufferBound(vertex_count, vertex_size));
+    size_t size = meshopt_encodeVertexBuffer(out.data(), out.size(), vertices, vertex_count, vertex_size);
+    out.resize(size);
+    out.shrink_to_fit();
+    return size > 0;
+}
+
+//static
+bool LLMeshOptimizer::decodeVertexBuffer(void* destination,
+    U64 vertex_count,
+    U64 vertex_size,
+    const std::vector<U8>& data)
+{
+    return meshopt_decodeVertexBuffer(destination, vertex_count, vertex_size, data.data(), data.size()) == 0;
+}
+
+//static
+bool LLMeshOptimizer::encodeIndexBufferU16(std::vector<U8>& out,
+    const U16* indices,
+    U64 index_count,
+    U64 vertex_count)
+{
+    out.resize(meshopt_encodeIndexBufferBound(index_count, vertex_count));
+    size_t size = meshopt_encodeIndexBuffer<unsigned short>(out.data(), out.size(), indices, index_count);
+    out.resize(size);
+    out.shrink_to_fit();
+    return size > 0;
+}
+
+//static
+bool LLMeshOptimizer::decodeIndexBufferU16(U16* destination,
+    U64 index_count,
+    const std::vector<U8>& data)
+{
+    return meshopt_decodeIndexBuffer<unsigned short>(destination, index_count, data.data(), data.size()) == 0;
+}
+
+//static
+U16 LLMeshOptimizer::quantizeUnorm16(F32 v)
+{
+    return (U16)meshopt_quantizeUnorm(v, 16);
+}
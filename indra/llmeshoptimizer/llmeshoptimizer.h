@@ -28,6 +28,8 @@
 
 #include "linden_common.h"
 
+#include <vector>
+
 class LLVector4a;
 class LLVector2;
 
@@ -150,6 +152,36 @@ public:
         F32 target_error,
         bool sloppy,
         F32* result_error);
+
+    // Compression
+
+    // Lossless vertex codec, vertex_size must be a multiple of 4 and no
+    // more than 256.  Works best when vertices have been cache optimized
+    // and quantized.  Returns false if out can't be filled.
+    static bool encodeVertexBuffer(std::vector<U8>& out,
+        const void* vertices,
+        U64 vertex_count,
+        U64 vertex_size);
+
+    // Returns false if the data is damaged or wasn't encoded with the same
+    // vertex_count and vertex_size
+    static bool decodeVertexBuffer(void* destination,
+        U64 vertex_count,
+        U64 vertex_size,
+        const std::vector<U8>& data);
+
+    // Lossless triangle list codec, index_count must be a multiple of 3
+    static bool encodeIndexBufferU16(std::vector<U8>& out,
+        const U16* indices,
+        U64 index_count,
+        U64 vertex_count);
+
+    static bool decodeIndexBufferU16(U16* destination,
+        U64 index_count,
+        const std::vector<U8>& data);
+
+    // [0, 1] to 16 bit unsigned normalized
+    static U16 quantizeUnorm16(F32 v);
 private:
 };
 
@@ -116,6 +116,10 @@ LLAvatarNameCache::LLAvatarNameCache()
 
     mUsePeopleAPI = true;
 
+    mLastExpireCheck = 0.0;
+    mBinaryCacheFile = NULL;
+    mBinaryCacheDirty = false;
+
     sHttpRequest = LLCore::HttpRequest::ptr_t(new LLCore::HttpRequest());
     sHttpHeaders = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders());
     sHttpOptions = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions());
@@ -124,6 +128,7 @@ LLAvatarNameCache::LLAvatarNameCache()
 
 LLAvatarNameCache::~LLAvatarNameCache()
 {
+    closeBinaryCache();
     sHttpRequest.reset();
     sHttpHeaders.reset();
     sHttpOptions.reset();
@@ -268,7 +273,7 @@ void LLAvatarNameCache::handleAvNameCacheSuccess(const LLSD &data, const LLSD &h
 // Provide some fallback for agents that return errors
 void LLAvatarNameCache::handleAgentError(const LLUUID& agent_id)
 {
-	std::map<LLUUID,LLAvatarName>::iterator existing = mCache.find(agent_id);
+	cache_t::iterator existing = mCache.find(agent_id);
 	if (existing == mCache.end())
     {
         // there is no existing cache entry, so make a temporary name from legacy
@@ -303,7 +308,7 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
 
     bool updated_account = true; // assume obsolete value for new arrivals by default
 
-    std::map<LLUUID, LLAvatarName>::iterator it = mCache.find(agent_id);
+    cache_t::iterator it = mCache.find(agent_id);
     if (it != mCache.end()
         && (*it).second.getAccountName() == av_name.getAccountName())
     {
@@ -313,6 +318,11 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
 	// Add to the cache
 	mCache[agent_id] = av_name;
 
+	if (mBinaryCacheFile && av_name.isValidName())
+	{
+		mBinaryCacheDirty |= writeBinaryRecord(mBinaryCacheFile, agent_id, av_name);
+	}
+
 	// Suppress request from the queue
 	mPendingQueue.erase(agent_id);
 
@@ -410,7 +420,7 @@ void LLAvatarNameCache::legacyNameCallback(const LLUUID& agent_id,
 	// Retrieve the name and set it to never (or almost never...) expire: when we are using the legacy
 	// protocol, we do not get an expiration date for each name and there's no reason to ask the 
 	// data again and again so we set the expiration time to the largest value admissible.
-	std::map<LLUUID,LLAvatarName>::iterator av_record = LLAvatarNameCache::getInstance()->mCache.find(agent_id);
+	cache_t::iterator av_record = LLAvatarNameCache::getInstance()->mCache.find(agent_id);
 	LLAvatarName& av_name = av_record->second;
 	av_name.setExpires(MAX_UNREFRESHED_TIME);
 }
@@ -508,6 +518,127 @@ void LLAvatarNameCache::exportFile(std::ostream& ostr)
 	LLSDSerialize::toPrettyXML(data, ostr);
 }
 
+// Binary store layout: header, then records of
+// [agent id][U32 payload size][binary LLSD of LLAvatarName::asLLSD()]
+// Later records for an id supersede earlier ones.
+static const char BINARY_CACHE_MAGIC[4] = { 'A', 'V', 'N', 'C' };
+static const U32 BINARY_CACHE_VERSION = 1;
+static const size_t BINARY_CACHE_HEADER_SIZE = sizeof(BINARY_CACHE_MAGIC) + sizeof(U32);
+static const size_t BINARY_RECORD_HEADER_SIZE = UUID_BYTES + sizeof(U32);
+
+//static
+bool LLAvatarNameCache::writeBinaryRecord(LLFILE* fp, const LLUUID& agent_id, const LLAvatarName& av_name)
+{
+	std::ostringstream ostr;
+	LLSDSerialize::toBinary(av_name.asLLSD(), ostr);
+	const std::string payload = ostr.str();
+	U32 size = (U32)payload.size();
+	return fwrite(agent_id.mData, UUID_BYTES, 1, fp) == 1
+		&& fwrite(&size, sizeof(size), 1, fp) == 1
+		&& fwrite(payload.data(), 1, size, fp) == size;
+}
+
+bool LLAvatarNameCache::rewriteBinaryCache(const std::string& filename)
+{
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		return false;
+	}
+	bool success = fwrite(BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC), 1, fp) == 1
+		&& fwrite(&BINARY_CACHE_VERSION, sizeof(U32), 1, fp) == 1;
+	F64 max_unrefreshed = LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME;
+	for (cache_t::const_iterator it = mCache.begin(); success && it != mCache.end(); ++it)
+	{
+		if (it->second.isValidName(max_unrefreshed))
+		{
+			success = writeBinaryRecord(fp, it->first, it->second);
+		}
+	}
+	success = (fclose(fp) == 0) && success;
+	if (!success || LLFile::rename(temp_filename, filename) != 0)
+	{
+		LLFile::remove(temp_filename);
+		return false;
+	}
+	return true;
+}
+
+bool LLAvatarNameCache::openBinaryCache(const std::string& filename)
+{
+	closeBinaryCache();
+
+	S32 records = 0;
+	S32 loaded = 0;
+	bool valid = false;
+	{
+		LLMappedFile mapped;
+		if (mapped.open(filename)
+			&& mapped.getSize() >= BINARY_CACHE_HEADER_SIZE
+			&& !memcmp(mapped.getData(), BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC))
+			&& !memcmp(mapped.getData() + sizeof(BINARY_CACHE_MAGIC), &BINARY_CACHE_VERSION, sizeof(U32)))
+		{
+			valid = true;
+			F64 max_unrefreshed = LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME;
+			const U8* data = mapped.getData();
+			size_t offset = BINARY_CACHE_HEADER_SIZE;
+			LLUUID agent_id;
+			LLAvatarName av_name;
+			LLSD sd;
+			while (offset + BINARY_RECORD_HEADER_SIZE <= mapped.getSize())
+			{
+				U32 size;
+				memcpy(agent_id.mData, data + offset, UUID_BYTES);
+				memcpy(&size, data + offset + UUID_BYTES, sizeof(U32));
+				offset += BINARY_RECORD_HEADER_SIZE;
+				if (size > mapped.getSize() - offset
+					|| LLSDSerialize::fromBinary(sd, data + offset, size) == LLSDParser::PARSE_FAILURE)
+				{
+					// truncated by a crash, keep what was read so far
+					LL_WARNS("AvNameCache") << "Avatar name cache " << filename << " truncated at " << offset << LL_ENDL;
+					break;
+				}
+				offset += size;
+				++records;
+
+				av_name.fromLLSD(sd);
+				if (av_name.isValidName(max_unrefreshed))
+				{
+					mCache[agent_id] = av_name;
+					++loaded;
+				}
+			}
+		}
+	}
+	LL_INFOS("AvNameCache") << "LLAvatarNameCache loaded " << loaded << " of " << records
+		<< " binary records, cache has " << mCache.size() << LL_ENDL;
+
+	// Compact once superseded and expired records dominate, or start
+	// the file from whatever is cached (e.g. imported from xml).
+	if (!valid || records > 2 * (S32)mCache.size())
+	{
+		if (!rewriteBinaryCache(filename))
+		{
+			LL_WARNS("AvNameCache") << "Failed to write " << filename << LL_ENDL;
+			return false;
+		}
+	}
+
+	mBinaryCacheFile = LLFile::fopen(filename, "ab");
+	return mBinaryCacheFile != NULL;
+}
+
+void LLAvatarNameCache::closeBinaryCache()
+{
+	if (mBinaryCacheFile)
+	{
+		fclose(mBinaryCacheFile);
+		mBinaryCacheFile = NULL;
+		mBinaryCacheDirty = false;
+	}
+}
+
 void LLAvatarNameCache::setNameLookupURL(const std::string& name_lookup_url)
 {
 	mNameLookupURL = name_lookup_url;
@@ -563,6 +694,13 @@ void LLAvatarNameCache::idle()
 
     // erase anything that has not been refreshed for more than MAX_UNREFRESHED_TIME
     eraseUnrefreshed();
+
+    if (mBinaryCacheDirty)
+    {
+        // names arrive in batches, push each batch out once
+        fflush(mBinaryCacheFile);
+        mBinaryCacheDirty = false;
+    }
 }
 
 bool LLAvatarNameCache::isRequestPending(const LLUUID& agent_id)
@@ -623,7 +761,7 @@ bool LLAvatarNameCache::getName(const LLUUID& agent_id, LLAvatarName *av_name)
 	if (mRunning)
 	{
 		// ...only do immediate lookups when cache is running
-		std::map<LLUUID,LLAvatarName>::iterator it = mCache.find(agent_id);
+		cache_t::iterator it = mCache.find(agent_id);
 		if (it != mCache.end())
 		{
 			*av_name = it->second;
@@ -674,7 +812,7 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNameCallback(cons
 	if (mRunning)
 	{
 		// ...only do immediate lookups when cache is running
-		std::map<LLUUID,LLAvatarName>::iterator it = mCache.find(agent_id);
+		cache_t::iterator it = mCache.find(agent_id);
 		if (it != mCache.end())
 		{
 			const LLAvatarName& av_name = it->second;
@@ -713,6 +851,21 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNameCallback(cons
 	return connection;
 }
 
+void LLAvatarNameCache::requestNames(const uuid_vec_t& agent_ids)
+{
+	F64 now = LLFrameTimer::getTotalSeconds();
+	for (const LLUUID& agent_id : agent_ids)
+	{
+		cache_t::const_iterator it = mCache.find(agent_id);
+		if ((it == mCache.end() || it->second.mExpires <= now)
+			&& agent_id.notNull()
+			&& !isRequestPending(agent_id))
+		{
+			mAskQueue.insert(agent_id);
+		}
+	}
+}
+
 
 void LLAvatarNameCache::setUseDisplayNames(bool use)
 {
@@ -745,8 +898,8 @@ void LLAvatarNameCache::insert(const LLUUID& agent_id, const LLAvatarName& av_na
 
 LLUUID LLAvatarNameCache::findIdByName(const std::string& name)
 {
-    std::map<LLUUID, LLAvatarName>::iterator it;
-    std::map<LLUUID, LLAvatarName>::iterator end = mCache.end();
+    cache_t::iterator it;
+    cache_t::iterator end = mCache.end();
     for (it = mCache.begin(); it != end; ++it)
     {
         if (it->second.getUserName() == name)
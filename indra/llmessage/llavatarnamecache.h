@@ -29,12 +29,13 @@
 #define LLAVATARNAMECACHE_H
 
 #include "llavatarname.h"	// for convenience
+#include "llfile.h"
 #include "llsingleton.h"
+#include "lluuidmap.h"
 #include <boost/signals2.hpp>
 #include <set>
 
 class LLSD;
-class LLUUID;
 
 class LLAvatarNameCache : public LLSingleton<LLAvatarNameCache>
 {
@@ -48,6 +49,13 @@ public:
 	bool importFile(std::istream& istr);
 	void exportFile(std::ostream& ostr);
 
+	// Binary store: the file is mapped and read once, then every name
+	// received is appended to it, so nothing has to be written at exit.
+	// Expired and superseded records are dropped when the file is reopened.
+	bool openBinaryCache(const std::string& filename);
+	void closeBinaryCache();
+	bool isBinaryCacheOpen() const { return mBinaryCacheFile != NULL; }
+
 	// On the viewer, usually a simulator capabilities.
 	// If empty, name cache will fall back to using legacy name lookup system.
 	void setNameLookupURL(const std::string& name_lookup_url);
@@ -79,6 +87,10 @@ public:
 	static callback_connection_t get(const LLUUID& agent_id, callback_slot_t slot);
 	callback_connection_t getNameCallback(const LLUUID& agent_id, callback_slot_t slot);
 
+	// Queues every uncached name in one go, for lists about to look up
+	// many rows. The next idle() sends them in as few requests as fit.
+	void requestNames(const uuid_vec_t& agent_ids);
+
 	// Set display name: flips the switch and triggers the callbacks.
 	void setUseDisplayNames(bool use);
 	
@@ -136,6 +148,9 @@ private:
 
     bool expirationFromCacheControl(const LLSD& headers, F64 *expires);
 
+    static bool writeBinaryRecord(LLFILE* fp, const LLUUID& agent_id, const LLAvatarName& av_name);
+    bool rewriteBinaryCache(const std::string& filename);
+
     // This is a coroutine.
     static void requestAvatarNameCache_(std::string url, std::vector<LLUUID> agentIds);
 
@@ -177,11 +192,15 @@ private:
     signal_map_t mSignalMap;
 
     // The cache at last, i.e. avatar names we know about.
-    typedef std::map<LLUUID, LLAvatarName> cache_t;
+    typedef LLUUIDMap<LLAvatarName> cache_t;
     cache_t mCache;
 
     // Time when unrefreshed cached names were checked last.
     F64 mLastExpireCheck;
+
+    // Append handle of the binary store, NULL when not in use
+    LLFILE* mBinaryCacheFile;
+    bool mBinaryCacheDirty;
 };
 
 // Parse a cache-control header to get the max-age delta-seconds.
@@ -87,6 +87,7 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mPingDelayAveraged(INITIAL_PING_VALUE_MSEC), 
 	mUnackedPacketCount(0),
 	mUnackedPacketBytes(0),
+	mNextResendTime(0.0),
 	mLastPacketInTime(0.0),
 	mLocalEndPointID(),
 	mPacketsOut(0),
@@ -281,6 +282,15 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 	// I'm not going to worry about this for now - djs
 	//
 
+	// Nothing expires before mNextResendTime, so most frames don't need to
+	// walk the lists at all.  Acks only remove packets, which can leave the
+	// time early but never late.
+	if (now <= mNextResendTime)
+	{
+		return mUnackedPacketCount;
+	}
+	F64Seconds next_resend_time(F64_MAX);
+
 	reliable_iter iter;
 	BOOL have_resend_overflow = FALSE;
 	for (iter = mUnackedPackets.begin(); iter != mUnackedPackets.end();)
@@ -311,6 +321,7 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 				}
 				else
 				{
+					next_resend_time = llmin(next_resend_time, packetp->mExpirationTime);
 					++iter;
 				}
 				// Move on to the next unacked packet.
@@ -324,6 +335,8 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 						<< " bytes of reliable messages waiting" << LL_ENDL;
 			}
 			// Stop resending.  There are less than 512000 unacked packets.
+			// The rest weren't looked at, so check again next time.
+			next_resend_time = now;
 			break;
 		}
 
@@ -372,12 +385,14 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 			else
 			{
 				// Don't remove it yet, it still gets to try to resend at least once.
+				next_resend_time = llmin(next_resend_time, packetp->mExpirationTime);
 				++iter;
 			}
 		}
 		else
 		{
 			// Don't need to do anything with this packet, keep iterating.
+			next_resend_time = llmin(next_resend_time, packetp->mExpirationTime);
 			++iter;
 		}
 	}
@@ -418,10 +433,12 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 		}
 		else
 		{
+			next_resend_time = llmin(next_resend_time, packetp->mExpirationTime);
 			++iter;
 		}
 	}
 
+	mNextResendTime = next_resend_time;
 	return mUnackedPacketCount;
 }
 
@@ -570,6 +587,7 @@ void LLCircuitData::addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLR
 
 	mUnackedPacketCount++;
 	mUnackedPacketBytes += packet_info->mBufferLength;
+	mNextResendTime = llmin(mNextResendTime, packet_info->mExpirationTime);
 
 	if (params && params->mRetries)
 	{
@@ -1101,6 +1119,11 @@ void LLCircuit::sendAcks(F32 collect_time)
 		{
 			if (count>0)
 			{
+				// duplicate resends collect the same id again while waiting
+				std::sort(cd->mAcks.begin(), cd->mAcks.end());
+				cd->mAcks.erase(std::unique(cd->mAcks.begin(), cd->mAcks.end()), cd->mAcks.end());
+				count = (S32)cd->mAcks.size();
+
 				// send the packet acks
 				S32 acks_this_packet = 0;
 				for(S32 i = 0; i < count; ++i)
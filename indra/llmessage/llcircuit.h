@@ -248,6 +248,7 @@ protected:
 
 	S32										mUnackedPacketCount;
 	S32										mUnackedPacketBytes;
+	F64Seconds								mNextResendTime;		// Earliest expiration on either list, nothing is due before it
 
 	F64Seconds								mLastPacketInTime;		// Time of last packet arrival
 
@@ -32,12 +32,19 @@
 #include "llcoproceduremanager.h"
 
 #include <chrono>
+#include <set>
 
 #include <boost/fiber/buffered_channel.hpp>
 
 #include "llexception.h"
+#include "llmutex.h"
+#include "lltimer.h"
+#include "lltrace.h"
 #include "stringize.h"
 
+static LLTrace::EventStatHandle<F64Seconds> sCoprocQueueWait("coprocqueuewait", "Time coprocedures wait in their pool's queue");
+static LLTrace::EventStatHandle<F64Seconds> sCoprocInteractiveWait("coprocinteractivewait", "Time interactive coprocedures wait in their pool's queue");
+
 //=========================================================================
 // Map of pool sizes for known pools
 static const std::map<std::string, U32> DefaultPoolSizes{
@@ -57,6 +64,7 @@ class LLCoprocedurePool: private boost::noncopyable
 {
 public:
     typedef LLCoprocedureManager::CoProcedure_t CoProcedure_t;
+    typedef LLCoprocedureManager::EPriority EPriority;
 
     LLCoprocedurePool(const std::string &name, size_t size);
     ~LLCoprocedurePool();
@@ -67,7 +75,7 @@ public:
     /// @param proc Is a bound function to be executed 
     /// 
     /// @return This method returns a UUID that can be used later to cancel execution.
-    LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc);
+    LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc, EPriority priority, F32 deadline);
 
     /// Returns the number of coprocedures in the queue awaiting processing.
     ///
@@ -97,17 +105,47 @@ private:
     {
         typedef boost::shared_ptr<QueuedCoproc> ptr_t;
 
-        QueuedCoproc(const std::string &name, const LLUUID &id, CoProcedure_t proc) :
+        QueuedCoproc(const std::string &name, const LLUUID &id, CoProcedure_t proc,
+                     EPriority priority, F64 deadline, U64 sequence) :
             mName(name),
             mId(id),
-            mProc(proc)
+            mProc(proc),
+            mPriority(priority),
+            mDeadline(deadline),
+            mSequence(sequence),
+            mQueuedTime(LLTimer::getTotalSeconds())
         {}
 
         std::string mName;
         LLUUID mId;
         CoProcedure_t mProc;
+        EPriority mPriority;
+        F64 mDeadline; // absolute, 0 if none
+        U64 mSequence;
+        F64 mQueuedTime;
+    };
+
+    // Highest class first, then first come first served
+    struct ByPriority
+    {
+        bool operator()(const QueuedCoproc::ptr_t& a, const QueuedCoproc::ptr_t& b) const
+        {
+            return a->mPriority != b->mPriority ? a->mPriority > b->mPriority : a->mSequence < b->mSequence;
+        }
+    };
+    struct ByDeadline
+    {
+        bool operator()(const QueuedCoproc::ptr_t& a, const QueuedCoproc::ptr_t& b) const
+        {
+            return a->mDeadline != b->mDeadline ? a->mDeadline < b->mDeadline : a->mSequence < b->mSequence;
+        }
     };
 
+    // Removes and returns the coprocedure to run next, overdue ones first
+    QueuedCoproc::ptr_t takeNextCoproc();
+
+    // The channel only carries one wake-up token per queued coprocedure,
+    // workers take the actual work from mReady in priority order.
     // we use a buffered_channel here rather than unbuffered_channel since we want to be able to 
     // push values without blocking,even if there's currently no one calling a pop operation (due to
     // fiber running right now)
@@ -127,6 +165,11 @@ private:
 
     CoroAdapterMap_t mCoroMapping;
 
+    LLMutex mReadyMutex;
+    std::set<QueuedCoproc::ptr_t, ByPriority> mReady;
+    std::set<QueuedCoproc::ptr_t, ByDeadline> mDeadlines;
+    U64 mSequence;
+
     void coprocedureInvokerCoro(CoprocQueuePtr pendingCoprocs,
                                 LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter);
 };
@@ -188,7 +231,8 @@ void LLCoprocedureManager::initializePool(const std::string &poolName)
 }
 
 //-------------------------------------------------------------------------
-LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc)
+LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc,
+                                                EPriority priority, F32 deadline)
 {
     // Attempt to find the pool and enqueue the procedure.  If the pool does 
     // not exist, create it.
@@ -202,7 +246,7 @@ LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const s
     }
 
     poolPtr_t targetPool = it->second;
-    return targetPool->enqueueCoprocedure(name, proc);
+    return targetPool->enqueueCoprocedure(name, proc, priority, deadline);
 }
 
 void LLCoprocedureManager::setPropertyMethods(SettingQuery_t queryfn, SettingUpdate_t updatefn)
@@ -303,7 +347,8 @@ LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size):
     mPending(0),
     mPendingCoprocs(boost::make_shared<CoprocQueue_t>(LLCoprocedureManager::DEFAULT_QUEUE_SIZE)),
     mHTTPPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
-    mCoroMapping()
+    mCoroMapping(),
+    mSequence(0)
 {
     try
     {
@@ -360,7 +405,8 @@ LLCoprocedurePool::~LLCoprocedurePool()
 }
 
 //-------------------------------------------------------------------------
-LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoprocedurePool::CoProcedure_t proc)
+LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoprocedurePool::CoProcedure_t proc,
+                                             EPriority priority, F32 deadline)
 {
     LLUUID id(LLUUID::generateNewID());
 
@@ -384,13 +430,31 @@ LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoproced
         LL_INFOS("CoProcMgr") << "Coprocedure(" << name << ") enqueuing with id=" << id.asString() << " in pool \"" << mPoolName << "\" at "
                               << mPending << LL_ENDL;
     }
-    auto pushed = mPendingCoprocs->try_push(boost::make_shared<QueuedCoproc>(name, id, proc));
+    QueuedCoproc::ptr_t coproc;
+    {
+        LLMutexLock lock(&mReadyMutex);
+        coproc = boost::make_shared<QueuedCoproc>(name, id, proc, priority,
+            deadline > 0.f ? LLTimer::getTotalSeconds().value() + deadline : 0.0, mSequence++);
+        mReady.insert(coproc);
+        if (coproc->mDeadline > 0.0)
+        {
+            mDeadlines.insert(coproc);
+        }
+    }
+    // push an empty token, the coprocedure itself stays in mReady
+    auto pushed = mPendingCoprocs->try_push(QueuedCoproc::ptr_t());
     if (pushed == boost::fibers::channel_op_status::success)
     {
         ++mPending;
         return id;
     }
 
+    {
+        LLMutexLock lock(&mReadyMutex);
+        mReady.erase(coproc);
+        mDeadlines.erase(coproc);
+    }
+
     // Here we didn't succeed in pushing. Shutdown could be the reason.
     if (pushed == boost::fibers::channel_op_status::closed)
     {
@@ -403,6 +467,27 @@ LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoproced
     return {};                      // never executed, pacify the compiler
 }
 
+//-------------------------------------------------------------------------
+LLCoprocedurePool::QueuedCoproc::ptr_t LLCoprocedurePool::takeNextCoproc()
+{
+    LLMutexLock lock(&mReadyMutex);
+    QueuedCoproc::ptr_t coproc;
+    if (!mDeadlines.empty() && (*mDeadlines.begin())->mDeadline <= LLTimer::getTotalSeconds())
+    {
+        coproc = *mDeadlines.begin();
+    }
+    else if (!mReady.empty())
+    {
+        coproc = *mReady.begin();
+    }
+    if (coproc)
+    {
+        mReady.erase(coproc);
+        mDeadlines.erase(coproc);
+    }
+    return coproc;
+}
+
 //-------------------------------------------------------------------------
 void LLCoprocedurePool::coprocedureInvokerCoro(
     CoprocQueuePtr pendingCoprocs,
@@ -427,11 +512,11 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
         // - which tried to acquire the lock on pendingCoprocs... alas.
         // Using a fresh, clean ptr_t ensures that no previous value is
         // destroyed during pop_wait_for().
-        QueuedCoproc::ptr_t coproc;
+        QueuedCoproc::ptr_t token;
         boost::fibers::channel_op_status status;
         {
             LLCoros::TempStatus st("waiting for work for 10s");
-            status = pendingCoprocs->pop_wait_for(coproc, std::chrono::seconds(10));
+            status = pendingCoprocs->pop_wait_for(token, std::chrono::seconds(10));
         }
         if (status == boost::fibers::channel_op_status::closed)
         {
@@ -443,10 +528,22 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
             LL_DEBUGS_ONCE("CoProcMgr") << "pool '" << mPoolName << "' waiting." << LL_ENDL;
             continue;
         }
-        // we actually popped an item
+        // we actually popped a token, there is one queued coprocedure per token
+        QueuedCoproc::ptr_t coproc = takeNextCoproc();
+        if (!coproc)
+        {
+            continue;
+        }
         --mPending;
         mActiveCoprocsCount++;
 
+        F64Seconds waited(LLTimer::getTotalSeconds() - coproc->mQueuedTime);
+        LLTrace::record(sCoprocQueueWait, waited);
+        if (coproc->mPriority == LLCoprocedureManager::PRIORITY_INTERACTIVE)
+        {
+            LLTrace::record(sCoprocInteractiveWait, waited);
+        }
+
         LL_DEBUGS("CoProcMgr") << "Dequeued and invoking coprocedure(" << coproc->mName << ") with id=" << coproc->mId.asString() << " in pool \"" << mPoolName << "\" (" << mPending << " left)" << LL_ENDL;
 
         try
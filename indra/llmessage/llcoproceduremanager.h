@@ -46,13 +46,26 @@ public:
 
     typedef boost::function<void(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, const LLUUID &id)> CoProcedure_t;
 
+    /// Order in which queued coprocedures of a pool are started. Within a
+    /// class they start in the order they were queued.
+    typedef enum e_priority
+    {
+        PRIORITY_BACKGROUND = 0,    // bulk work nobody is waiting on
+        PRIORITY_NORMAL,
+        PRIORITY_INTERACTIVE,       // the user is waiting on the result
+    } EPriority;
+
     /// Places the coprocedure on the queue for processing. 
     /// 
     /// @param name Is used for debugging and should identify this coroutine.
     /// @param proc Is a bound function to be executed 
+    /// @param priority Class the coprocedure is scheduled in.
+    /// @param deadline If not 0, seconds after which the coprocedure starts
+    ///                 ahead of everything that is not overdue itself.
     /// 
     /// @return This method returns a UUID that can be used later to cancel execution.
-    LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc);
+    LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc,
+                              EPriority priority = PRIORITY_NORMAL, F32 deadline = 0.f);
 
     /// Cancel a coprocedure. If the coprocedure is already being actively executed 
     /// this method calls cancelYieldingOperation() on the associated HttpAdapter
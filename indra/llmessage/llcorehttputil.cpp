@@ -30,6 +30,7 @@
 #include <sstream>
 #include <algorithm>
 #include <iterator>
+#include <set>
 #include "llcorehttputil.h"
 #include "llhttpconstants.h"
 #include "llsd.h"
@@ -63,6 +64,73 @@ namespace
         return mBoolSettingGet(HTTP_LOGBODY_KEY);
     }
 
+    inline bool isBinaryLLSD(const std::string * content_type)
+    {
+        // Parameters may follow the media type
+        return content_type
+            && !content_type->compare(0, HTTP_CONTENT_LLSD_BINARY.size(), HTTP_CONTENT_LLSD_BINARY);
+    }
+
+    // Hosts that refused a binary LLSD body, they get XML from then on.
+    // Adapters only run on coroutines of the main thread.
+    std::set<std::string> sBinaryRefusedHosts;
+
+    std::string hostOf(const std::string & url)
+    {
+        std::string::size_type pos(url.find("://"));
+        return url.substr(0, url.find('/', std::string::npos == pos ? 0 : pos + 3));
+    }
+
+    // Body in the format named by the request's 'Content-Type:',
+    // binary LLSD if asked for, XML otherwise.
+    BufferArray * llsdToBody(const LLSD & body, const HttpHeaders::ptr_t & headers)
+    {
+        BufferArray * ba = new BufferArray();
+        BufferArrayStream bas(ba);
+        if (headers && isBinaryLLSD(headers->find(HTTP_OUT_HEADER_CONTENT_TYPE)))
+        {
+            LLSDSerialize::toBinary(body, bas);
+        }
+        else
+        {
+            LLSDSerialize::toXML(body, bas);
+        }
+        return ba;
+    }
+
+    bool binaryBodyToLLSD(BufferArray * body, LLSD & out_llsd)
+    {
+        size_t size(body->size());
+        const char * data(body->getContiguous(0, size));
+        std::string copy;
+        if (!data)
+        {
+            copy.resize(size);
+            body->read(0, &copy[0], size);
+            data = copy.data();
+        }
+
+        // Tolerate the '<? LLSD/Binary ?>' line LLSDSerialize::serialize() writes
+        if (size > 1 && '<' == data[0] && '?' == data[1])
+        {
+            const char * eol(static_cast<const char *>(memchr(data, '\n', size)));
+            if (!eol)
+            {
+                return false;
+            }
+            size -= eol + 1 - data;
+            data = eol + 1;
+        }
+
+        LLSD body_llsd;
+        if (LLSDParser::PARSE_FAILURE == LLSDSerialize::fromBinary(body_llsd, reinterpret_cast<const U8 *>(data), size))
+        {
+            return false;
+        }
+        out_llsd = body_llsd;
+        return true;
+    }
+
 }
 
 void setPropertyMethods(BoolSettingQuery_t queryfn, BoolSettingUpdate_t updatefn)
@@ -106,9 +174,6 @@ private:
 
 
 //=========================================================================
-// *TODO:  Currently converts only from XML content.  A mode
-// to convert using fromBinary() might be useful as well.  Mesh
-// headers could use it.
 bool responseToLLSD(HttpResponse * response, bool log, LLSD & out_llsd)
 {
     // Convert response to LLSD
@@ -118,6 +183,11 @@ bool responseToLLSD(HttpResponse * response, bool log, LLSD & out_llsd)
         return false;
     }
 
+    if (isBinaryLLSD(&response->getContentType()))
+    {
+        return binaryBodyToLLSD(body, out_llsd);
+    }
+
     LLCore::BufferArrayStream bas(body);
     LLSD body_llsd;
     S32 parse_status(LLSDSerialize::fromXML(body_llsd, bas, log));
@@ -139,9 +209,7 @@ HttpHandle requestPostWithLLSD(HttpRequest * request,
 {
     HttpHandle handle(LLCORE_HTTP_HANDLE_INVALID);
 
-    BufferArray * ba = new BufferArray();
-    BufferArrayStream bas(ba);
-    LLSDSerialize::toXML(body, bas);
+    BufferArray * ba = llsdToBody(body, headers);
 
     handle = request->requestPost(policy_id,
         url,
@@ -164,9 +232,7 @@ HttpHandle requestPutWithLLSD(HttpRequest * request,
 {
     HttpHandle handle(LLCORE_HTTP_HANDLE_INVALID);
 
-    BufferArray * ba = new BufferArray();
-    BufferArrayStream bas(ba);
-    LLSDSerialize::toXML(body, bas);
+    BufferArray * ba = llsdToBody(body, headers);
 
     handle = request->requestPut(policy_id,
         url,
@@ -188,9 +254,7 @@ HttpHandle requestPatchWithLLSD(HttpRequest * request,
 {
     HttpHandle handle(LLCORE_HTTP_HANDLE_INVALID);
 
-    BufferArray * ba = new BufferArray();
-    BufferArrayStream bas(ba);
-    LLSDSerialize::toXML(body, bas);
+    BufferArray * ba = llsdToBody(body, headers);
 
     handle = request->requestPatch(policy_id,
         url,
@@ -431,7 +495,7 @@ LLSD HttpCoroLLSDHandler::handleSuccess(LLCore::HttpResponse * response, LLCore:
         LLCore::HttpHeaders::ptr_t headers(response->getHeaders());
         const std::string *contentType = (headers) ? headers->find(HTTP_IN_HEADER_CONTENT_TYPE) : NULL;
 
-        if (contentType && (HTTP_CONTENT_LLSD_XML == *contentType))
+        if (contentType && (HTTP_CONTENT_LLSD_XML == *contentType || isBinaryLLSD(contentType)))
         {
             std::string thebody = LLCoreHttpUtil::responseToString(response);
             LL_WARNS("CoreHTTP") << "Failed to deserialize . " << response->getRequestURL() << " [status:" << response->getStatus().toString() << "] "
@@ -671,7 +735,8 @@ HttpCoroutineAdapter::HttpCoroutineAdapter(const std::string &name,
     mPolicyId(policyId),
     mYieldingHandle(LLCORE_HTTP_HANDLE_INVALID),
     mWeakRequest(),
-    mWeakHandler()
+    mWeakHandler(),
+    mBinaryLLSD(false)
 {
 }
 
@@ -696,23 +761,32 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     HttpCoroHandler::ptr_t &handler)
 {
     HttpRequestPumper pumper(request);
+    LLSD results;
 
-    checkDefaultHeaders(headers);
-
-    // The HTTPCoroHandler does not self delete, so retrieval of a the contained 
-    // pointer from the smart pointer is safe in this case.
-    LLCore::HttpHandle hhandle = requestPostWithLLSD(request,
-        mPolicyId, url, body, options, headers,
-        handler);
-
-    if (hhandle == LLCORE_HTTP_HANDLE_INVALID)
+    if (mBinaryLLSD && sBinaryRefusedHosts.count(hostOf(url)))
     {
-        return HttpCoroutineAdapter::buildImmediateErrorResult(request, url);
+        mBinaryLLSD = false;
     }
 
-    saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
-    cleanState();
+    do
+    {
+        checkDefaultHeaders(headers, true);
+
+        // The HTTPCoroHandler does not self delete, so retrieval of a the contained 
+        // pointer from the smart pointer is safe in this case.
+        LLCore::HttpHandle hhandle = requestPostWithLLSD(request,
+            mPolicyId, url, body, options, headers,
+            handler);
+
+        if (hhandle == LLCORE_HTTP_HANDLE_INVALID)
+        {
+            return HttpCoroutineAdapter::buildImmediateErrorResult(request, url);
+        }
+
+        saveState(hhandle, request, handler);
+        results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+        cleanState();
+    } while (retryAsXML(results, url, headers));
 
     return results;
 }
@@ -877,23 +951,32 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     HttpCoroHandler::ptr_t &handler)
 {
     HttpRequestPumper pumper(request);
+    LLSD results;
 
-    checkDefaultHeaders(headers);
-
-    // The HTTPCoroHandler does not self delete, so retrieval of a the contained 
-    // pointer from the smart pointer is safe in this case.
-    LLCore::HttpHandle hhandle = requestPutWithLLSD(request,
-        mPolicyId, url, body, options, headers,
-        handler);
-
-    if (hhandle == LLCORE_HTTP_HANDLE_INVALID)
+    if (mBinaryLLSD && sBinaryRefusedHosts.count(hostOf(url)))
     {
-        return HttpCoroutineAdapter::buildImmediateErrorResult(request, url);
+        mBinaryLLSD = false;
     }
 
-    saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
-    cleanState();
+    do
+    {
+        checkDefaultHeaders(headers, true);
+
+        // The HTTPCoroHandler does not self delete, so retrieval of a the contained 
+        // pointer from the smart pointer is safe in this case.
+        LLCore::HttpHandle hhandle = requestPutWithLLSD(request,
+            mPolicyId, url, body, options, headers,
+            handler);
+
+        if (hhandle == LLCORE_HTTP_HANDLE_INVALID)
+        {
+            return HttpCoroutineAdapter::buildImmediateErrorResult(request, url);
+        }
+
+        saveState(hhandle, request, handler);
+        results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+        cleanState();
+    } while (retryAsXML(results, url, headers));
 
     return results;
 }
@@ -1043,23 +1126,32 @@ LLSD HttpCoroutineAdapter::patchAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     HttpCoroHandler::ptr_t &handler)
 {
     HttpRequestPumper pumper(request);
+    LLSD results;
 
-    checkDefaultHeaders(headers);
-
-    // The HTTPCoroHandler does not self delete, so retrieval of a the contained 
-    // pointer from the smart pointer is safe in this case.
-    LLCore::HttpHandle hhandle = requestPatchWithLLSD(request,
-        mPolicyId, url, body, options, headers,
-        handler);
-
-    if (hhandle == LLCORE_HTTP_HANDLE_INVALID)
+    if (mBinaryLLSD && sBinaryRefusedHosts.count(hostOf(url)))
     {
-        return HttpCoroutineAdapter::buildImmediateErrorResult(request, url);
+        mBinaryLLSD = false;
     }
 
-    saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
-    cleanState();
+    do
+    {
+        checkDefaultHeaders(headers, true);
+
+        // The HTTPCoroHandler does not self delete, so retrieval of a the contained 
+        // pointer from the smart pointer is safe in this case.
+        LLCore::HttpHandle hhandle = requestPatchWithLLSD(request,
+            mPolicyId, url, body, options, headers,
+            handler);
+
+        if (hhandle == LLCORE_HTTP_HANDLE_INVALID)
+        {
+            return HttpCoroutineAdapter::buildImmediateErrorResult(request, url);
+        }
+
+        saveState(hhandle, request, handler);
+        results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+        cleanState();
+    } while (retryAsXML(results, url, headers));
 
     return results;
 }
@@ -1149,17 +1241,22 @@ LLSD HttpCoroutineAdapter::moveAndSuspend_(LLCore::HttpRequest::ptr_t &request,
 }
 
 
-void HttpCoroutineAdapter::checkDefaultHeaders(LLCore::HttpHeaders::ptr_t &headers)
+void HttpCoroutineAdapter::checkDefaultHeaders(LLCore::HttpHeaders::ptr_t &headers, bool llsdBody)
 {
     if (!headers)
         headers.reset(new LLCore::HttpHeaders);
     if (!headers->find(HTTP_OUT_HEADER_ACCEPT))
     {
-        headers->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_LLSD_XML);
+        // Services that don't know binary LLSD answer with XML
+        headers->append(HTTP_OUT_HEADER_ACCEPT, mBinaryLLSD
+            ? HTTP_CONTENT_LLSD_BINARY + ", " + HTTP_CONTENT_LLSD_XML + ";q=0.5"
+            : HTTP_CONTENT_LLSD_XML);
     }
     if (!headers->find(HTTP_OUT_HEADER_CONTENT_TYPE))
     {
-        headers->append(HTTP_OUT_HEADER_CONTENT_TYPE, HTTP_CONTENT_LLSD_XML);
+        headers->append(HTTP_OUT_HEADER_CONTENT_TYPE, (mBinaryLLSD && llsdBody)
+            ? HTTP_CONTENT_LLSD_BINARY
+            : HTTP_CONTENT_LLSD_XML);
     }
 
     if (!headers->find("X-SecondLife-UDP-Listen-Port") && gMessageSystem)
@@ -1169,6 +1266,32 @@ void HttpCoroutineAdapter::checkDefaultHeaders(LLCore::HttpHeaders::ptr_t &heade
 }
 
 
+bool HttpCoroutineAdapter::retryAsXML(const LLSD &results, const std::string &url, LLCore::HttpHeaders::ptr_t &headers)
+{
+    if (!mBinaryLLSD || !isBinaryLLSD(headers->find(HTTP_OUT_HEADER_CONTENT_TYPE)))
+    {
+        return false;
+    }
+
+    LLCore::HttpStatus status(getStatusFromLLSD(results[HTTP_RESULTS]));
+    if (status != LLCore::HttpStatus(HTTP_UNSUPPORTED_MEDIA_TYPE) && status != LLCore::HttpStatus(HTTP_BAD_REQUEST))
+    {
+        return false;
+    }
+
+    // The service didn't take the binary body.  Send XML to the host
+    // from now on, checkDefaultHeaders() puts back the headers removed here.
+    const std::string host(hostOf(url));
+    LL_INFOS("CoreHTTP") << mAdapterName << " binary LLSD refused by " << host << " with "
+        << status.toTerseString() << ", retrying as XML" << LL_ENDL;
+    sBinaryRefusedHosts.insert(host);
+    mBinaryLLSD = false;
+    headers->remove(HTTP_OUT_HEADER_CONTENT_TYPE);
+    headers->remove(HTTP_OUT_HEADER_ACCEPT);
+    return true;
+}
+
+
 void HttpCoroutineAdapter::cancelSuspendedOperation()
 {
     LLCore::HttpRequest::ptr_t request = mWeakRequest.lock();
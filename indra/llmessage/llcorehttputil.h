@@ -70,6 +70,8 @@ extern const F32 HTTP_REQUEST_EXPIRY_SECS;
 /// It is expected that the response body will be of non-zero
 /// length on input but basic checks will be performed and
 /// and error (false status) returned if there is no data.
+/// Binary LLSD is parsed when the response's content type
+/// says so, XML otherwise.
 /// If there is data but it cannot be successfully parsed,
 /// an error is also returned.  If successfully parsed,
 /// the output LLSD object, out_llsd, is written with the
@@ -102,7 +104,9 @@ std::string responseToString(LLCore::HttpResponse * response);
 /// same as with that method.  Caller is expected to provide
 /// an HttpHeaders object with a correct 'Content-Type:' header.
 /// One will not be provided by this call.  You might look after
-/// the 'Accept:' header as well.
+/// the 'Accept:' header as well.  The body is serialized as binary
+/// LLSD when that header names 'application/llsd+binary', as XML
+/// otherwise.  The same goes for the PUT and PATCH variants.
 ///
 /// @return				If request is successfully issued, the
 ///						HttpHandle representing the request.
@@ -323,6 +327,13 @@ public:
     HttpCoroutineAdapter(const std::string &name, LLCore::HttpRequest::policy_t policyId);
     ~HttpCoroutineAdapter();
 
+    /// Ask for binary LLSD instead of XML.  Responses are accepted in
+    /// either format, LLSD request bodies go out binary unless the
+    /// caller set a 'Content-Type:'.  If the service refuses a binary
+    /// body with 400 or 415 the request is sent again as XML and that
+    /// host only gets XML bodies from then on.  Off by default.
+    void setBinaryLLSD(bool binary) { mBinaryLLSD = binary; }
+
     /// Execute a Post transaction on the supplied URL and yield execution of 
     /// the coroutine until a result is available. 
     /// 
@@ -664,7 +675,8 @@ private:
     static void trivialPostCoro(std::string url, LLCore::HttpRequest::policy_t policyId, LLSD postData, completionCallback_t success, completionCallback_t failure);
     static void trivialDelCoro(std::string url, LLCore::HttpRequest::policy_t policyId, completionCallback_t success, completionCallback_t failure);
 
-    void checkDefaultHeaders(LLCore::HttpHeaders::ptr_t &headers);
+    void checkDefaultHeaders(LLCore::HttpHeaders::ptr_t &headers, bool llsdBody = false);
+    bool retryAsXML(const LLSD &results, const std::string &url, LLCore::HttpHeaders::ptr_t &headers);
 
     std::string                     mAdapterName;
     LLCore::HttpRequest::policy_t   mPolicyId;
@@ -672,6 +684,7 @@ private:
     LLCore::HttpHandle              mYieldingHandle;
     LLCore::HttpRequest::wptr_t     mWeakRequest;
     HttpCoroHandler::wptr_t         mWeakHandler;
+    bool                            mBinaryLLSD;
 };
 
 
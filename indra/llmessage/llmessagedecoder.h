@@ -0,0 +1,101 @@
+/**
+ * @file llmessagedecoder.h
+ * @brief Support for the typed message decoders in llmessagedecoders.h
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEDECODER_H
+#define LL_LLMESSAGEDECODER_H
+
+#include "message.h"
+
+// Length of a Variable field from its 1, 2 or 4 byte size prefix.
+inline S32 ll_msg_variable_size(const U8* data, S32 prefix_size)
+{
+	switch (prefix_size)
+	{
+	case 1:
+		return data[0];
+	case 2:
+	{
+		U16 size;
+		htolememcpy(&size, data, MVT_U16, 2);
+		return size;
+	}
+	default:
+	{
+		U32 size;
+		htolememcpy(&size, data, MVT_U32, 4);
+		return (S32)llmin(size, (U32)S32_MAX);
+	}
+	}
+}
+
+// The records of a Multiple or Variable block, pointing into the message
+// body. Records are decoded when they are read; a record type with fixed
+// size fields (SIZE > 0) is found by its offset, others by skipping over the
+// records before it. The body must outlive the array, which means the array
+// is only good inside the message handler.
+template<class RECORD>
+class LLMsgBlockArray
+{
+public:
+	LLMsgBlockArray()
+	:	mData(NULL),
+		mCount(0)
+	{
+	}
+
+	void set(const U8* data, S32 count)
+	{
+		mData = data;
+		mCount = count;
+	}
+
+	S32 size() const { return mCount; }
+	bool empty() const { return mCount == 0; }
+
+	RECORD operator[](S32 index) const
+	{
+		llassert(index >= 0 && index < mCount);
+		const U8* data = mData;
+		if (RECORD::SIZE > 0)
+		{
+			data += index * RECORD::SIZE;
+		}
+		else
+		{
+			// already checked against the body size by RECORD::measure()
+			data += RECORD::measure(data, S32_MAX, index);
+		}
+		RECORD record;
+		record.decode(data);
+		return record;
+	}
+
+private:
+	const U8* mData;
+	S32 mCount;
+};
+
+#endif // LL_LLMESSAGEDECODER_H
@@ -287,7 +287,8 @@ public:
 		mBanFromTrusted(false),
 		mBanFromUntrusted(false),
 		mHandlerFunc(NULL), 
-		mUserData(NULL)
+		mUserData(NULL),
+		mRawHandlerFunc(NULL)
 	{ 
 		mName = LLMessageStringTable::getInstance()->getString(name);
 	}
@@ -371,6 +372,29 @@ public:
 		return FALSE;
 	}
 
+	// A raw handler gets the undecoded message body and reads it with one of
+	// the generated decoders in llmessagedecoders.h, so the template reader
+	// skips building LLMsgData and the generic getters can't be used on it.
+	// It returns false if the body was malformed. Messages that come in as
+	// LLSD still go to the regular handler.
+	typedef bool (*raw_handler_func_t)(LLMessageSystem *msgsystem, const U8 *data, S32 size, void **user_data);
+
+	void setRawHandlerFunc(raw_handler_func_t handler_func, void **user_data)
+	{
+		mRawHandlerFunc = handler_func;
+		mUserData = user_data;
+	}
+
+	bool hasRawHandlerFunc() const
+	{
+		return mRawHandlerFunc != NULL;
+	}
+
+	bool callRawHandlerFunc(LLMessageSystem *msgsystem, const U8 *data, S32 size) const
+	{
+		return mRawHandlerFunc(msgsystem, data, size, mUserData);
+	}
+
 	bool isUdpBanned() const
 	{
 		return mDeprecation == MD_UDPBLACKLISTED;
@@ -416,6 +440,7 @@ private:
 	// message handler function (this is set by each application)
 	void									(*mHandlerFunc)(LLMessageSystem *msgsystem, void **user_data);
 	void									**mUserData;
+	raw_handler_func_t						mRawHandlerFunc;
 };
 
 #endif // LL_LLMESSAGETEMPLATE_H
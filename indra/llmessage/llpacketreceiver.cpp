@@ -0,0 +1,224 @@
+/** 
+ * @file llpacketreceiver.cpp
+ * @brief Batched UDP receive on a thread of its own.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreceiver.h"
+
+#if LL_WINDOWS
+	#include <winsock2.h>
+#else
+	#include <netinet/in.h>
+#endif
+
+// linden library includes
+#include "llcircuit.h"	// for LL_PACKET_ID_SIZE
+#include "lltimer.h"
+#include "llzerocode.h"
+#include "message.h"
+
+///////////////////////////////////////////////////////////
+LLReceivedPacket::LLReceivedPacket() :
+	mSize(0),
+	mMessage(mData),
+	mMessageSize(0),
+	mCompressedSize(0),
+	mMalformed(false),
+	mExpandOverflow(false),
+	mAckCount(0)
+{
+}
+
+///////////////////////////////////////////////////////////
+void LLReceivedPacket::parse()
+{
+	mMessage = mData;
+	mMessageSize = mSize;
+	mCompressedSize = 0;
+	mMalformed = false;
+	mExpandOverflow = false;
+	mAckCount = 0;
+
+	if (mSize < LL_MINIMUM_VALID_PACKET_SIZE)
+	{
+		// the consumer complains about these
+		return;
+	}
+
+	// note if packet acks are appended.
+	if (mData[0] & LL_ACK_FLAG)
+	{
+		S32 acks = mData[--mMessageSize];
+		if (mMessageSize < (S32)(acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE))
+		{
+			mMalformed = true;
+			return;
+		}
+
+		// the last one appended comes first
+		S32 pos = mMessageSize;
+		mMessageSize -= acks * sizeof(TPACKETID);
+		for (S32 i = 0; i < acks; ++i)
+		{
+			U32 mem_id = 0;
+			pos -= sizeof(TPACKETID);
+			memcpy(&mem_id, &mData[pos], sizeof(TPACKETID));	/* Flawfinder: ignore*/
+			mAcks[i] = ntohl(mem_id);
+		}
+		mAckCount = acks;
+	}
+
+	// if we're not zero-coded, the body stays where it is.
+	if (!(mData[0] & LL_ZERO_CODE_FLAG))
+	{
+		return;
+	}
+
+	mCompressedSize = mMessageSize;
+	mData[0] &= (~LL_ZERO_CODE_FLAG);
+
+	S32 expanded = ll_zero_expand(mData, mMessageSize, mExpanded, NET_BUFFER_SIZE);
+	if (expanded < 0)
+	{
+		// the consumer reports it and the header still reads the same
+		mExpandOverflow = true;
+		memcpy(mExpanded, mData, LL_PACKET_ID_SIZE);	/* Flawfinder: ignore */
+		expanded = LL_PACKET_ID_SIZE;
+	}
+
+	mMessage = mExpanded;
+	mMessageSize = expanded;
+}
+
+///////////////////////////////////////////////////////////
+LLPacketReceiver::LLPacketReceiver(S32 socket) :
+	LLThread("Packet receiver"),
+	mSocket(socket),
+	mHead(0),
+	mTail(0)
+{
+	for (U32 i = 0; i < RING_SIZE; ++i)
+	{
+		mSlots[i] = new LLReceivedPacket;
+	}
+}
+
+LLPacketReceiver::~LLPacketReceiver()
+{
+	shutdown();
+
+	for (U32 i = 0; i < RING_SIZE; ++i)
+	{
+		delete mSlots[i];
+	}
+}
+
+LLReceivedPacket* LLPacketReceiver::front()
+{
+	U32 tail = mTail.load(std::memory_order_relaxed);
+	if (tail == mHead.load(std::memory_order_acquire))
+	{
+		return NULL;
+	}
+	return slot(tail);
+}
+
+void LLPacketReceiver::pop()
+{
+	U32 tail = mTail.load(std::memory_order_relaxed);
+	llassert(tail != mHead.load(std::memory_order_acquire));
+	mTail.store(tail + 1, std::memory_order_release);
+}
+
+//virtual
+void LLPacketReceiver::run()
+{
+	char* buffers[MAX_BATCH];
+	S32 sizes[MAX_BATCH];
+	LLHost senders[MAX_BATCH];
+	LLHost receiving_ifs[MAX_BATCH];
+
+	while (!isQuitting())
+	{
+		U32 head = mHead.load(std::memory_order_relaxed);
+		S32 free_slots = (S32)(RING_SIZE - (head - mTail.load(std::memory_order_acquire)));
+		if (free_slots <= 0)
+		{
+			// the consumer is behind, leave the rest in the socket buffer
+			ms_sleep(1);
+			continue;
+		}
+
+		// short timeout so a shutdown doesn't wait on a quiet socket
+		if (!wait_for_packet(mSocket, 10))
+		{
+			continue;
+		}
+
+		S32 batch = llmin(free_slots, MAX_BATCH);
+		for (S32 i = 0; i < batch; ++i)
+		{
+			buffers[i] = (char*)slot(head + i)->mData;
+		}
+
+		S32 count = receive_packets(mSocket, buffers, NET_BUFFER_SIZE, sizes, senders, receiving_ifs, batch);
+
+		bool socks = LLProxy::isSOCKSProxyEnabled();
+		for (S32 i = 0; i < count; ++i)
+		{
+			LLReceivedPacket* packet = slot(head + i);
+			packet->mSize = sizes[i];
+			packet->mHost = senders[i];
+			packet->mReceivingIF = receiving_ifs[i];
+
+			if (socks)
+			{
+				if (packet->mSize > SOCKS_HEADER_SIZE)
+				{
+					// *FIX We are assuming ATYP is 0x01 (IPv4), not 0x03 (hostname) or 0x04 (IPv6)
+					proxywrap_t* header = static_cast<proxywrap_t*>(static_cast<void*>(packet->mData));
+					packet->mHost.setAddress(header->addr);
+					packet->mHost.setPort(ntohs(header->port));
+
+					packet->mSize -= SOCKS_HEADER_SIZE; // The unwrapped packet size
+					memmove(packet->mData, packet->mData + SOCKS_HEADER_SIZE, packet->mSize);
+				}
+				else
+				{
+					// no room for a message, the consumer skips empty slots
+					packet->mSize = 0;
+				}
+			}
+
+			packet->parse();
+		}
+
+		if (count > 0)
+		{
+			mHead.store(head + count, std::memory_order_release);
+		}
+	}
+}
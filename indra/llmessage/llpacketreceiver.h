@@ -0,0 +1,103 @@
+/** 
+ * @file llpacketreceiver.h
+ * @brief Batched UDP receive on a thread of its own, feeding parsed
+ * packets to the message system through a lock free ring.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETRECEIVER_H
+#define LL_LLPACKETRECEIVER_H
+
+#include <atomic>
+
+#include "llhost.h"
+#include "llproxy.h"	// for SOCKS_HEADER_SIZE
+#include "llthread.h"
+#include "net.h"		// for NET_BUFFER_SIZE
+
+// One datagram: the bytes off the wire, then what parse() makes of them.
+struct LLReceivedPacket
+{
+	LLReceivedPacket();
+
+	// Split off the appended acks and undo the zero coding.  Everything
+	// here only touches the packet itself, so it can run on any thread.
+	void parse();
+
+	// raw datagram, with room for the SOCKS header until it's unwrapped
+	U8		mData[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];	/* Flawfinder: ignore */
+	S32		mSize;
+	LLHost	mHost;
+	LLHost	mReceivingIF;
+
+	// message body, in mData or mExpanded
+	U8*		mMessage;
+	S32		mMessageSize;
+	// size before expansion, 0 if the body wasn't zero coded
+	S32		mCompressedSize;
+	// ack count doesn't fit in the packet
+	bool	mMalformed;
+	// expansion ran past the end of mExpanded
+	bool	mExpandOverflow;
+
+	// appended acks, already in host order
+	S32			mAckCount;
+	TPACKETID	mAcks[255];
+
+	U8		mExpanded[NET_BUFFER_SIZE];	/* Flawfinder: ignore */
+};
+
+// Reads the message socket on its own thread, in batches where the
+// platform has a call for it, and parses each datagram as it comes in.
+// The one consumer, the thread running LLMessageSystem::checkMessages(),
+// takes packets off the other end of a single producer single consumer
+// ring, so neither side ever takes a lock.  When the ring is full the
+// socket is left alone and the OS buffer takes the overflow.
+class LLPacketReceiver : public LLThread
+{
+public:
+	LLPacketReceiver(S32 socket);
+	~LLPacketReceiver();
+
+	// Oldest packet not yet popped, NULL if there isn't one.  Consumer side only.
+	LLReceivedPacket* front();
+	// Hand the front packet's slot back to the receive thread.  Consumer side only.
+	void pop();
+
+	/*virtual*/ void run();
+
+private:
+	static const U32 RING_SIZE = 256;	// power of two
+	static const S32 MAX_BATCH = 64;
+
+	LLReceivedPacket* slot(U32 index) { return mSlots[index & (RING_SIZE - 1)]; }
+
+	S32 mSocket;
+	LLReceivedPacket* mSlots[RING_SIZE];
+
+	// free running counts, the slot is the count modulo RING_SIZE
+	std::atomic<U32> mHead;		// next slot the receive thread fills
+	std::atomic<U32> mTail;		// next slot the consumer reads
+};
+
+#endif
@@ -55,7 +55,12 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mReceiver(NULL),
+	mHoldingPacket(false),
+	mLocalPacket(new LLReceivedPacket),
+	mCaptureFile(NULL),
+	mReplayFile(NULL)
 {
 }
 
@@ -63,6 +68,7 @@ LLPacketRing::LLPacketRing () :
 LLPacketRing::~LLPacketRing ()
 {
 	cleanup();
+	delete mLocalPacket;
 }
 	
 ///////////////////////////////////////////////////////////
@@ -70,6 +76,10 @@ void LLPacketRing::cleanup ()
 {
 	LLPacketBuffer *packetp;
 
+	stopReceiveThread();
+	stopCapture();
+	stopReplay();
+
 	while (!mReceiveQueue.empty())
 	{
 		packetp = mReceiveQueue.front();
@@ -270,6 +280,259 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	return packet_size;
 }
 
+///////////////////////////////////////////////////////////
+void LLPacketRing::startReceiveThread(S32 socket)
+{
+	if (!mReceiver && !mReplayFile)
+	{
+		mReceiver = new LLPacketReceiver(socket);
+		mReceiver->start();
+	}
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+	if (mReceiver)
+	{
+		delete mReceiver;
+		mReceiver = NULL;
+		mHoldingPacket = false;
+	}
+}
+
+///////////////////////////////////////////////////////////
+LLReceivedPacket* LLPacketRing::receiveParsedPacket(S32 socket)
+{
+	if (mReplayFile)
+	{
+		return replayPacket();
+	}
+
+	if (!mReceiver)
+	{
+		// no receive thread, read and parse right here
+		mLocalPacket->mSize = receivePacket(socket, (char *)mLocalPacket->mData);
+		if (mLocalPacket->mSize <= 0)
+		{
+			return NULL;
+		}
+		mLocalPacket->mHost = mLastSender;
+		mLocalPacket->mReceivingIF = mLastReceivingIF;
+		mLocalPacket->parse();
+		capturePacket(mLocalPacket);
+		return mLocalPacket;
+	}
+
+	if (mHoldingPacket)
+	{
+		mReceiver->pop();
+		mHoldingPacket = false;
+	}
+
+	// With the in throttle on, the receiver's ring stands in for the delay
+	// queue.  It holds packets rather than bytes, so it won't overflow the
+	// way mMaxBufferLength does.
+	while (LLReceivedPacket* packetp = mReceiver->front())
+	{
+		if (mUseInThrottle && mInThrottle.checkOverflow(0))
+		{
+			// We don't have enough bandwidth, leave it for later.
+			return NULL;
+		}
+
+		bool drop = packetp->mSize <= 0;
+		if (!drop)
+		{
+			if (mUseInThrottle)
+			{
+				mActualBitsIn += packetp->mSize * 8;
+				mInThrottle.throttleOverflow(packetp->mSize * 8.f);
+			}
+
+			// Fake packet loss
+			if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
+			{
+				mPacketsToDrop++;
+			}
+
+			if (mPacketsToDrop)
+			{
+				mPacketsToDrop--;
+				drop = true;
+			}
+		}
+
+		if (drop)
+		{
+			mReceiver->pop();
+			continue;
+		}
+
+		mLastSender = packetp->mHost;
+		mLastReceivingIF = packetp->mReceivingIF;
+		mHoldingPacket = true;
+		capturePacket(packetp);
+		return packetp;
+	}
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////
+bool LLPacketRing::startCapture(const std::string& filename)
+{
+	stopCapture();
+
+	mCaptureFile = LLFile::fopen(filename, "wb");
+	if (!mCaptureFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture " << filename << LL_ENDL;
+		return false;
+	}
+
+	LL_INFOS("Messaging") << "Capturing incoming packets to " << filename << LL_ENDL;
+	mCaptureTimer.reset();
+	return true;
+}
+
+void LLPacketRing::stopCapture()
+{
+	if (mCaptureFile)
+	{
+		LLFile::close(mCaptureFile);
+		mCaptureFile = NULL;
+	}
+}
+
+void LLPacketRing::capturePacket(const LLReceivedPacket* packetp)
+{
+	if (!mCaptureFile || packetp->mSize <= 0)
+	{
+		return;
+	}
+
+	CaptureRecord record;
+	record.mTime = mCaptureTimer.getElapsedTimeF64();
+	record.mSenderIP = packetp->mHost.getAddress();
+	record.mSenderPort = packetp->mHost.getPort();
+	record.mReceivingIP = packetp->mReceivingIF.getAddress();
+	record.mReceivingPort = packetp->mReceivingIF.getPort();
+	record.mSize = packetp->mSize;
+
+	// parse() clears the zero coding flag in place, put it back so the
+	// replayed packet expands the same way
+	U8 flags = packetp->mData[0];
+	if (packetp->mCompressedSize)
+	{
+		flags |= LL_ZERO_CODE_FLAG;
+	}
+
+	if (fwrite(&record, sizeof(record), 1, mCaptureFile) != 1 ||
+		fwrite(&flags, 1, 1, mCaptureFile) != 1 ||
+		fwrite(packetp->mData + 1, packetp->mSize - 1, 1, mCaptureFile) != 1)
+	{
+		LL_WARNS("Messaging") << "Packet capture write failed, stopping capture" << LL_ENDL;
+		stopCapture();
+	}
+}
+
+///////////////////////////////////////////////////////////
+bool LLPacketRing::startReplay(const std::string& filename)
+{
+	stopReplay();
+
+	mReplayFile = LLFile::fopen(filename, "rb");
+	if (!mReplayFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture " << filename << LL_ENDL;
+		return false;
+	}
+
+	// everything comes from the file from now on
+	stopReceiveThread();
+
+	if (fread(&mReplayNext, sizeof(mReplayNext), 1, mReplayFile) != 1)
+	{
+		mReplayNext.mSize = -1;
+	}
+
+	LL_INFOS("Messaging") << "Replaying incoming packets from " << filename << LL_ENDL;
+	mReplayTimer.reset();
+	return true;
+}
+
+void LLPacketRing::stopReplay()
+{
+	if (mReplayFile)
+	{
+		LLFile::close(mReplayFile);
+		mReplayFile = NULL;
+	}
+}
+
+LLReceivedPacket* LLPacketRing::replayPacket()
+{
+	if (mReplayNext.mSize < 0 || mReplayNext.mTime > mReplayTimer.getElapsedTimeF64())
+	{
+		// done, or not due yet
+		return NULL;
+	}
+
+	const CaptureRecord& record = mReplayNext;
+	if (record.mSize > NET_BUFFER_SIZE ||
+		fread(mLocalPacket->mData, record.mSize, 1, mReplayFile) != 1)
+	{
+		LL_WARNS("Messaging") << "Packet capture is truncated or corrupt, ending replay" << LL_ENDL;
+		mReplayNext.mSize = -1;
+		return NULL;
+	}
+
+	mLocalPacket->mSize = record.mSize;
+	mLocalPacket->mHost = LLHost(record.mSenderIP, record.mSenderPort);
+	mLocalPacket->mReceivingIF = LLHost(record.mReceivingIP, record.mReceivingPort);
+	mLastSender = mLocalPacket->mHost;
+	mLastReceivingIF = mLocalPacket->mReceivingIF;
+
+	if (fread(&mReplayNext, sizeof(mReplayNext), 1, mReplayFile) != 1)
+	{
+		LL_INFOS("Messaging") << "Packet replay finished" << LL_ENDL;
+		mReplayNext.mSize = -1;
+	}
+
+	mLocalPacket->parse();
+	return mLocalPacket;
+}
+
+//static
+bool LLPacketRing::readCapture(const std::string& filename, std::vector<std::vector<U8> >& packets)
+{
+	LLFILE* file = LLFile::fopen(filename, "rb");
+	if (!file)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture " << filename << LL_ENDL;
+		return false;
+	}
+
+	CaptureRecord record;
+	while (fread(&record, sizeof(record), 1, file) == 1)
+	{
+		if (record.mSize <= 0 || record.mSize > NET_BUFFER_SIZE)
+		{
+			LL_WARNS("Messaging") << "Packet capture " << filename << " is corrupt" << LL_ENDL;
+			break;
+		}
+		std::vector<U8> packet(record.mSize);
+		if (fread(&packet[0], record.mSize, 1, file) != 1)
+		{
+			break;
+		}
+		packets.push_back(packet);
+	}
+
+	LLFile::close(file);
+	return true;
+}
+
 BOOL LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
 {
 	BOOL status = TRUE;
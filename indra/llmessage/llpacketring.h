@@ -29,11 +29,14 @@
 #define LL_LLPACKETRING_H
 
 #include <queue>
+#include <vector>
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
+#include "llpacketreceiver.h"
 #include "llproxy.h"
 #include "llthrottle.h"
+#include "lltimer.h"
 #include "net.h"
 
 class LLPacketRing
@@ -53,6 +56,29 @@ public:
 	S32  receivePacket (S32 socket, char *datap);
 	S32  receiveFromRing (S32 socket, char *datap);
 
+	// Hand receiving over to a thread of its own, see LLPacketReceiver.
+	void startReceiveThread(S32 socket);
+	void stopReceiveThread();
+
+	// Next packet with its acks split off and its body expanded, NULL if
+	// none is waiting.  Valid until the next call.
+	LLReceivedPacket* receiveParsedPacket(S32 socket);
+
+	// Append every packet handed out by receiveParsedPacket() to filename,
+	// with its arrival time and sender, for replaying later.
+	bool startCapture(const std::string& filename);
+	void stopCapture();
+
+	// Hand out the packets of a capture at the pace they were recorded
+	// instead of reading the socket.  Stops the receive thread.
+	bool startReplay(const std::string& filename);
+	void stopReplay();
+	bool isReplaying() const					{ return mReplayFile != NULL; }
+
+	// Every datagram in a capture as it came off the wire, zero coding
+	// flag included, e.g. for benchmarks.  False if the file won't open.
+	static bool readCapture(const std::string& filename, std::vector<std::vector<U8> >& packets);
+
 	BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
 	inline LLHost getLastSender();
@@ -78,12 +104,36 @@ protected:
 	U32 mPacketsToDrop;				// drop next n packets
 
 	std::queue<LLPacketBuffer *> mReceiveQueue;
+
+	LLPacketReceiver* mReceiver;	// NULL unless receiving on a thread
+	bool mHoldingPacket;			// the receiver's front packet is out with the caller
+	LLReceivedPacket* mLocalPacket;	// for parsing on this thread without a receiver
 	std::queue<LLPacketBuffer *> mSendQueue;
 
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
 private:
+	// how each packet is stored in a capture, followed by mSize bytes
+	struct CaptureRecord
+	{
+		F64 mTime;				// seconds since the capture started
+		U32 mSenderIP;
+		U32 mSenderPort;
+		U32 mReceivingIP;
+		U32 mReceivingPort;
+		S32 mSize;
+	};
+
+	void capturePacket(const LLReceivedPacket* packetp);
+	LLReceivedPacket* replayPacket();
+
+	LLFILE* mCaptureFile;
+	LLTimer mCaptureTimer;
+	LLFILE* mReplayFile;
+	LLTimer mReplayTimer;
+	CaptureRecord mReplayNext;		// read ahead, mSize < 0 when the file is done
+
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
 };
 
@@ -545,6 +545,76 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 	U8 offset = buffer[PHL_OFFSET];
 	S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
 
+	// messages with a generated decoder are read by their handler
+	const bool raw = mCurrentRMessageTemplate->hasRawHandlerFunc();
+	if (!raw && !decodeBlocks(buffer, decode_pos, sender))
+	{
+		return FALSE;
+	}
+
+	{
+		static LLTimer decode_timer;
+
+		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		{
+			decode_timer.reset();
+		}
+
+		if (raw)
+		{
+			S32 body_size = llmax(mReceiveSize - decode_pos, 0);
+			if (!mCurrentRMessageTemplate->callRawHandlerFunc(gMessageSystem, buffer + decode_pos, body_size))
+			{
+				LL_WARNS() << "Malformed " << mCurrentRMessageTemplate->mName << " from " << sender
+						   << ", " << body_size << " byte body" << LL_ENDL;
+				gMessageSystem->callExceptionFunc(MX_RAN_OFF_END_OF_PACKET);
+				return FALSE;
+			}
+		}
+		else if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
+		{
+			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
+		}
+
+		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		{
+			F32 decode_time = decode_timer.getElapsedTimeF32();
+
+			if (gMessageSystem->getTimingCallback())
+			{
+				(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
+								decode_time,
+								gMessageSystem->getTimingCallbackData());
+			}
+
+			if (LLMessageReader::getTimeDecodes())
+			{
+				mCurrentRMessageTemplate->mDecodeTimeThisFrame += decode_time;
+
+				mCurrentRMessageTemplate->mTotalDecoded++;
+				mCurrentRMessageTemplate->mTotalDecodeTime += decode_time;
+
+				if( mCurrentRMessageTemplate->mMaxDecodeTimePerMsg < decode_time )
+				{
+					mCurrentRMessageTemplate->mMaxDecodeTimePerMsg = decode_time;
+				}
+
+
+				if(decode_time > LLMessageReader::getTimeDecodesSpamThreshold())
+				{
+					LL_DEBUGS() << "--------- Message " << mCurrentRMessageTemplate->mName << " decode took " << decode_time << " seconds. (" <<
+						mCurrentRMessageTemplate->mMaxDecodeTimePerMsg << " max, " <<
+						(mCurrentRMessageTemplate->mTotalDecodeTime / mCurrentRMessageTemplate->mTotalDecoded) << " avg)" << LL_ENDL;
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+// build mCurrentRMessageData for the generic getters
+BOOL LLTemplateMessageReader::decodeBlocks(const U8* buffer, S32 decode_pos, const LLHost& sender)
+{
 	// create base working data set
 	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
 	
@@ -701,52 +771,6 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 		return FALSE;
 	}
 
-	{
-		static LLTimer decode_timer;
-
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
-		{
-			decode_timer.reset();
-		}
-
-		if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
-		{
-			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
-		}
-
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
-		{
-			F32 decode_time = decode_timer.getElapsedTimeF32();
-
-			if (gMessageSystem->getTimingCallback())
-			{
-				(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
-								decode_time,
-								gMessageSystem->getTimingCallbackData());
-			}
-
-			if (LLMessageReader::getTimeDecodes())
-			{
-				mCurrentRMessageTemplate->mDecodeTimeThisFrame += decode_time;
-
-				mCurrentRMessageTemplate->mTotalDecoded++;
-				mCurrentRMessageTemplate->mTotalDecodeTime += decode_time;
-
-				if( mCurrentRMessageTemplate->mMaxDecodeTimePerMsg < decode_time )
-				{
-					mCurrentRMessageTemplate->mMaxDecodeTimePerMsg = decode_time;
-				}
-
-
-				if(decode_time > LLMessageReader::getTimeDecodesSpamThreshold())
-				{
-					LL_DEBUGS() << "--------- Message " << mCurrentRMessageTemplate->mName << " decode took " << decode_time << " seconds. (" <<
-						mCurrentRMessageTemplate->mMaxDecodeTimePerMsg << " max, " <<
-						(mCurrentRMessageTemplate->mTotalDecodeTime / mCurrentRMessageTemplate->mTotalDecoded) << " avg)" << LL_ENDL;
-				}
-			}
-		}
-	}
 	return TRUE;
 }
 
@@ -117,6 +117,7 @@ private:
 	void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
 	BOOL decodeData(const U8* buffer, const LLHost& sender );
+	BOOL decodeBlocks(const U8* buffer, S32 decode_pos, const LLHost& sender);
 
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
@@ -0,0 +1,172 @@
+/**
+ * @file llzerocode.cpp
+ * @brief Zero coding of message bodies
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llzerocode.h"
+
+#include <emmintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+
+#include "llcircuit.h"	// for LL_PACKET_ID_SIZE
+
+namespace
+{
+	inline S32 lowest_bit(U32 mask)
+	{
+#if LL_WINDOWS
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (S32)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// Length of the run at data made of bytes that are zero (zeroes) or not
+	// zero (!zeroes), at most size.
+	template <bool zeroes>
+	S32 run_length(const U8* data, S32 size)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		S32 pos = 0;
+		for (; pos + 16 <= size; pos += 16)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(data + pos));
+			// bit set for every byte that ends the run
+			U32 mask = (U32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero));
+			if (zeroes)
+			{
+				mask ^= 0xFFFF;
+			}
+			if (mask)
+			{
+				return pos + lowest_bit(mask);
+			}
+		}
+		while (pos < size && (data[pos] == 0) == zeroes)
+		{
+			++pos;
+		}
+		return pos;
+	}
+}
+
+S32 ll_zero_code(const U8* in, S32 size, U8* out)
+{
+	if (size <= LL_PACKET_ID_SIZE)
+	{
+		memcpy(out, in, size);	/* Flawfinder: ignore */
+		return size;
+	}
+
+	memcpy(out, in, LL_PACKET_ID_SIZE);	/* Flawfinder: ignore */
+	S32 in_pos = LL_PACKET_ID_SIZE;
+	S32 out_pos = LL_PACKET_ID_SIZE;
+
+	while (in_pos < size)
+	{
+		S32 literal = run_length<false>(in + in_pos, size - in_pos);
+		memcpy(out + out_pos, in + in_pos, literal);	/* Flawfinder: ignore */
+		in_pos += literal;
+		out_pos += literal;
+
+		S32 zeroes = run_length<true>(in + in_pos, size - in_pos);
+		in_pos += zeroes;
+		// the same 0 [1..255] pairs the byte at a time coder wrote
+		while (zeroes > 0)
+		{
+			S32 count = llmin(zeroes, 255);
+			out[out_pos++] = 0;
+			out[out_pos++] = (U8)count;
+			zeroes -= count;
+		}
+	}
+
+	return out_pos;
+}
+
+S32 ll_zero_expand(const U8* in, S32 size, U8* out, S32 out_size)
+{
+	if (size <= LL_PACKET_ID_SIZE)
+	{
+		if (size > out_size)
+		{
+			return -1;
+		}
+		memcpy(out, in, size);	/* Flawfinder: ignore */
+		return size;
+	}
+
+	if (out_size < LL_PACKET_ID_SIZE)
+	{
+		return -1;
+	}
+	memcpy(out, in, LL_PACKET_ID_SIZE);	/* Flawfinder: ignore */
+	S32 in_pos = LL_PACKET_ID_SIZE;
+	S32 out_pos = LL_PACKET_ID_SIZE;
+
+	while (in_pos < size)
+	{
+		S32 literal = run_length<false>(in + in_pos, size - in_pos);
+		if (out_pos + literal > out_size)
+		{
+			return -1;
+		}
+		memcpy(out + out_pos, in + in_pos, literal);	/* Flawfinder: ignore */
+		in_pos += literal;
+		out_pos += literal;
+
+		if (in_pos >= size)
+		{
+			break;
+		}
+
+		// 0, then 256 more for every extra 0, then the count
+		S32 zeroes = 1;
+		++in_pos;
+		while (in_pos < size && !in[in_pos])
+		{
+			zeroes += 256;
+			++in_pos;
+		}
+		if (in_pos < size)
+		{
+			zeroes += in[in_pos++] - 1;
+		}
+
+		if (out_pos + zeroes > out_size)
+		{
+			return -1;
+		}
+		memset(out + out_pos, 0, zeroes);
+		out_pos += zeroes;
+	}
+
+	return out_pos;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file llzerocode.h
+ * @brief Zero coding of message bodies
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLZEROCODE_H
+#define LL_LLZEROCODE_H
+
+#include "stdtypes.h"
+
+// Zero coded packets keep their LL_PACKET_ID_SIZE header as is. In the body
+// a run of zero bytes becomes 0 [count], with 0 0 [count] meaning 256 more
+// zeroes per extra 0. Both directions skip over runs 16 bytes at a time
+// with SSE2 and copy or clear whole runs at once.
+
+// Encode a packet of size bytes into out, which must hold 2 * size bytes.
+// Returns the encoded size; the caller only sends it if that is smaller.
+// The zero coding flag in the header is left alone.
+S32 ll_zero_code(const U8* in, S32 size, U8* out);
+
+// Expand a zero coded packet of size bytes into out. Returns the expanded
+// size, or -1 if it would not fit in out_size bytes.
+S32 ll_zero_expand(const U8* in, S32 size, U8* out, S32 out_size);
+
+#endif // LL_LLZEROCODE_H
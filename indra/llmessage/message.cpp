@@ -276,6 +276,7 @@ LLMessageSystem::LLMessageSystem(const std::string& filename, U32 port,
 	mMaxMessageTime   = F32Seconds(1.f);
 
 	mTrueReceiveSize = 0;
+	mReceivedPacket = NULL;
 
 	mReceiveTime = F32Seconds(0.f);
 }
@@ -324,6 +325,9 @@ LLMessageSystem::~LLMessageSystem()
 	
 	if (!mbError)
 	{
+		// the receive thread has to be off the socket before it closes
+		mPacketRing.stopReceiveThread();
+		mReceivedPacket = NULL;
 		end_net(mSocket);
 	}
 	mSocket = 0;
@@ -506,14 +510,12 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 		BOOL recv_reliable = FALSE;
 		BOOL recv_resent = FALSE;
 		S32 acks = 0;
-		S32 true_rcv_size = 0;
 
-		U8* buffer = mTrueReceiveBuffer;
-		
-		mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
+		mReceivedPacket = mPacketRing.receiveParsedPacket(mSocket);
 		// If you want to dump all received packets into SecondLife.log, uncomment this
 		//dumpPacketToLog();
-		
+
+		mTrueReceiveSize = mReceivedPacket ? mReceivedPacket->mSize : 0;
 		receive_size = mTrueReceiveSize;
 		mLastSender = mPacketRing.getLastSender();
 		mLastReceivingIF = mPacketRing.getLastReceivingInterface();
@@ -530,34 +532,40 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 			// no data in packet receive buffer
 			valid_packet = FALSE;
 		}
+		else if (mReceivedPacket->mMalformed)
+		{
+			// mal-formed packet. ignore it and continue with
+			// the next one
+			LL_WARNS("Messaging") << "Malformed packet received. Packet size "
+				<< receive_size - 1 << " with invalid no. of acks " << (S32)mReceivedPacket->mData[receive_size - 1]
+				<< LL_ENDL;
+			valid_packet = FALSE;
+		}
 		else
 		{
 			LLHost host;
 			LLCircuitData* cdp;
-			
-			// note if packet acks are appended.
-			if(buffer[0] & LL_ACK_FLAG)
+
+			// acks and zero coding were already dealt with in
+			// LLReceivedPacket::parse(), possibly on the receive thread
+			U8* buffer = mReceivedPacket->mMessage;
+			receive_size = mReceivedPacket->mMessageSize;
+			acks = mReceivedPacket->mAckCount;
+
+			mIncomingCompressedSize = mReceivedPacket->mCompressedSize;
+			mTotalBytesIn += mIncomingCompressedSize ? mIncomingCompressedSize : receive_size;
+			if (mIncomingCompressedSize)
 			{
-				acks += buffer[--receive_size];
-				true_rcv_size = receive_size;
-				if(receive_size >= ((S32)(acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE)))
-				{
-					receive_size -= acks * sizeof(TPACKETID);
-				}
-				else
-				{
-					// mal-formed packet. ignore it and continue with
-					// the next one
-					LL_WARNS("Messaging") << "Malformed packet received. Packet size "
-						<< receive_size << " with invalid no. of acks " << acks
-						<< LL_ENDL;
-					valid_packet = FALSE;
-					continue;
-				}
+				mCompressedPacketsIn++;
+				mCompressedBytesIn += mIncomingCompressedSize;
+				mUncompressedBytesIn += receive_size;
+			}
+			if (mReceivedPacket->mExpandOverflow)
+			{
+				LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size" << LL_ENDL;
+				callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
 			}
 
-			// process the message as normal
-			mIncomingCompressedSize = zeroCodeExpand(&buffer, &receive_size);
 			mCurrentRecvPacketID = ntohl(*((U32*)(&buffer[1])));
 			host = getSender();
 
@@ -568,18 +576,12 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 			// this message came in on if it's valid, and NULL if the
 			// circuit was bogus.
 
-			if(cdp && (acks > 0) && ((S32)(acks * sizeof(TPACKETID)) < (true_rcv_size)))
+			if(cdp && (acks > 0))
 			{
-				TPACKETID packet_id;
-				U32 mem_id=0;
 				for(S32 i = 0; i < acks; ++i)
 				{
-					true_rcv_size -= sizeof(TPACKETID);
-					memcpy(&mem_id, &mTrueReceiveBuffer[true_rcv_size], /* Flawfinder: ignore*/
-					     sizeof(TPACKETID));
-					packet_id = ntohl(mem_id);
-					//LL_INFOS("Messaging") << "got ack: " << packet_id << LL_ENDL;
-					cdp->ackReliablePacket(packet_id);
+					//LL_INFOS("Messaging") << "got ack: " << mReceivedPacket->mAcks[i] << LL_ENDL;
+					cdp->ackReliablePacket(mReceivedPacket->mAcks[i]);
 				}
 				if (!cdp->getUnackedPacketCount())
 				{
@@ -2816,100 +2818,6 @@ S32 LLMessageSystem::zeroCodeAdjustCurrentSendTotal()
 
 
 
-S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
-{
-	if ((*data_size ) < LL_MINIMUM_VALID_PACKET_SIZE)
-	{
-		LL_WARNS("Messaging") << "zeroCodeExpand() called with data_size of " << *data_size
-			<< LL_ENDL;
-	}
-
-	mTotalBytesIn += *data_size;
-
-	// if we're not zero-coded, simply return.
-	if (!(*data[0] & LL_ZERO_CODE_FLAG))
-	{
-		return 0;
-	}
-
-	S32 in_size = *data_size;
-	mCompressedPacketsIn++;
-	mCompressedBytesIn += *data_size;
-	
-	*data[0] &= (~LL_ZERO_CODE_FLAG);
-
-	S32 count = (*data_size);  
-	
-	U8 *inptr = (U8 *)*data;
-	U8 *outptr = (U8 *)mEncodedRecvBuffer;
-
-// skip the packet id field
-
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
-	{
-		count--;
-		*outptr++ = *inptr++;
-	}
-
-// reconstruct encoded packet, keeping track of net size gain
-
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-	while (count--)
-	{
-		if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
-		{
-			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
-			callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-			outptr = mEncodedRecvBuffer;					
-			break;
-		}
-		if (!((*outptr++ = *inptr++)))
-		{
-			while (((count--)) && (!(*inptr)))
-			{
-				*outptr++ = *inptr++;
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
-  				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;
-					count = -1;
-					break;
-  				}
-				memset(outptr,0,255);
-				outptr += 255;
-			}
-			
-			if (count < 0)
-			{
-				break;
-			}
-
-			else
-			{
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
-				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;					
-				}
-				memset(outptr,0,(*inptr) - 1);
-				outptr += ((*inptr) - 1);
-				inptr++;
-			}
-		}		
-	}
-	
-	*data = mEncodedRecvBuffer;
-	*data_size = (S32)(outptr - mEncodedRecvBuffer);
-	mUncompressedBytesIn += *data_size;
-
-	return(in_size);
-}
-
-
 void LLMessageSystem::addTemplate(LLMessageTemplate *templatep)
 {
 	if (mMessageTemplates.count(templatep->mName) > 0)
@@ -2935,6 +2843,19 @@ void LLMessageSystem::setHandlerFuncFast(const char *name, void (*handler_func)(
 	}
 }
 
+void LLMessageSystem::setRawHandlerFuncFast(const char *name, bool (*handler_func)(LLMessageSystem *msgsystem, const U8 *data, S32 size, void **user_data), void **user_data)
+{
+	LLMessageTemplate* msgtemplate = get_ptr_in_map(mMessageTemplates, name);
+	if (msgtemplate)
+	{
+		msgtemplate->setRawHandlerFunc(handler_func, user_data);
+	}
+	else
+	{
+		LL_ERRS("Messaging") << name << " is not a known message name!" << LL_ENDL;
+	}
+}
+
 bool LLMessageSystem::callHandler(const char *name,
 		bool trustedSource, LLMessageSystem* msg)
 {
@@ -3332,12 +3253,13 @@ void LLMessageSystem::dumpPacketToLog()
 	S32 i;
 	S32 cur_line_pos = 0;
 	S32 cur_line = 0;
+	S32 size = mReceivedPacket ? mTrueReceiveSize : 0;
 
-	for (i = 0; i < mTrueReceiveSize; i++)
+	for (i = 0; i < size; i++)
 	{
 		S32 offset = cur_line_pos * 3;
 		snprintf(line_buffer + offset, sizeof(line_buffer) - offset,
-				 "%02x ", mTrueReceiveBuffer[i]);	/* Flawfinder: ignore */
+				 "%02x ", mReceivedPacket->mData[i]);	/* Flawfinder: ignore */
 		cur_line_pos++;
 		if (cur_line_pos >= 16)
 		{
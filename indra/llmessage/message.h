@@ -385,6 +385,8 @@ public:
 	{
 		setHandlerFuncFast(LLMessageStringTable::getInstance()->getString(name), handler_func, user_data);
 	}
+	// typed decoder instead of the generic reader for UDP messages, see LLMessageTemplate
+	void	setRawHandlerFuncFast(const char *name, bool (*handler_func)(LLMessageSystem *msgsystem, const U8 *data, S32 size, void **user_data), void **user_data = NULL);
 
 	// Set a callback function for a message system exception.
 	void setExceptionFunc(EMessageException exception, msg_exception_callback func, void* data = NULL);
@@ -536,7 +538,6 @@ public:
 	//void	buildMessage();
 
 	S32     zeroCode(U8 **data, S32 *data_size);
-	S32		zeroCodeExpand(U8 **data, S32 *data_size);
 	S32		zeroCodeAdjustCurrentSendTotal();
 
 	// Uses ping-based retry
@@ -856,8 +857,8 @@ private:
 
 	LLMessagePollInfo						*mPollInfop;
 
-	U8	mEncodedRecvBuffer[MAX_BUFFER_SIZE];
-	U8	mTrueReceiveBuffer[MAX_BUFFER_SIZE];
+	// packet being handled by checkMessages(), owned by mPacketRing
+	LLReceivedPacket*	mReceivedPacket;
 	S32	mTrueReceiveSize;
 
 	// Must be valid during decode
@@ -36,6 +36,8 @@
 #else
 	#include <sys/types.h>
 	#include <sys/socket.h>
+	#include <sys/select.h>
+	#include <sys/time.h>
 	#include <netinet/in.h>
 	#include <arpa/inet.h>
 	#include <fcntl.h>
@@ -112,6 +114,19 @@ U32 get_receiving_interface_ip(void)
 	return gsnReceivingIFAddr;
 }
 
+BOOL wait_for_packet(int hSocket, S32 timeout_ms)
+{
+	fd_set read_fds;
+	FD_ZERO(&read_fds);
+	FD_SET(hSocket, &read_fds);
+
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+	return select(hSocket + 1, &read_fds, NULL, NULL, &timeout) > 0;
+}
+
 const char* u32_to_ip_string(U32 ip)
 {
 	static char buffer[MAXADDRSTR];	 /* Flawfinder: ignore */ 
@@ -338,6 +353,38 @@ S32 receive_packet(int hSocket, char * receiveBuffer)
 	return nRet;
 }
 
+S32 receive_packets(int hSocket, char ** buffers, S32 buffer_size, S32 * sizes, LLHost * senders, LLHost * receiving_ifs, S32 max_packets)
+{
+	// No batched receive on Windows, read until the socket runs dry
+	S32 count = 0;
+	while (count < max_packets)
+	{
+		SOCKADDR_IN src_addr;
+		int addr_size = sizeof(src_addr);
+		int nRet = recvfrom(hSocket, buffers[count], buffer_size, 0, (struct sockaddr*)&src_addr, &addr_size);
+		if (nRet == SOCKET_ERROR)
+		{
+			int error = WSAGetLastError();
+			if (WSAECONNRESET == error)
+			{
+				// port unreachable from an earlier send, not a datagram
+				continue;
+			}
+			if (WSAEWOULDBLOCK != error)
+			{
+				LL_INFOS() << "receivePackets() failed, Error: " << error << LL_ENDL;
+			}
+			break;
+		}
+
+		sizes[count] = nRet;
+		senders[count] = LLHost(src_addr.sin_addr.s_addr, ntohs(src_addr.sin_port));
+		receiving_ifs[count] = LLHost(INVALID_HOST_IP_ADDRESS, INVALID_PORT);
+		++count;
+	}
+	return count;
+}
+
 // Returns TRUE on success.
 BOOL send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort)
 {
@@ -598,6 +645,88 @@ int receive_packet(int hSocket, char * receiveBuffer)
 	return nRet;
 }
 
+#if LL_LINUX
+S32 receive_packets(int hSocket, char ** buffers, S32 buffer_size, S32 * sizes, LLHost * senders, LLHost * receiving_ifs, S32 max_packets)
+{
+	// One recvmmsg() call for the whole batch
+	const S32 MAX_BATCH = 64;
+	max_packets = llmin(max_packets, MAX_BATCH);
+	if (max_packets <= 0)
+	{
+		return 0;
+	}
+
+	struct mmsghdr msgs[MAX_BATCH];
+	struct iovec iovs[MAX_BATCH];
+	struct sockaddr_in addrs[MAX_BATCH];
+	char cmsgs[MAX_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+	memset(msgs, 0, sizeof(msgs[0]) * max_packets);
+	for (S32 i = 0; i < max_packets; ++i)
+	{
+		iovs[i].iov_base = buffers[i];
+		iovs[i].iov_len = buffer_size;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsgs[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+	}
+
+	int count = recvmmsg(hSocket, msgs, max_packets, MSG_DONTWAIT, NULL);
+	if (count <= 0)
+	{
+		return 0;
+	}
+
+	for (S32 i = 0; i < count; ++i)
+	{
+		U32 dstip = INVALID_HOST_IP_ADDRESS;
+		for (struct cmsghdr *cmsgptr = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgptr))
+		{
+			if (cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO)
+			{
+				// specified rather than routed, as in recvfrom_destip()
+				dstip = ((in_pktinfo *)CMSG_DATA(cmsgptr))->ipi_spec_dst.s_addr;
+			}
+		}
+
+		sizes[i] = msgs[i].msg_len;
+		senders[i] = LLHost(addrs[i].sin_addr.s_addr, ntohs(addrs[i].sin_port));
+		receiving_ifs[i] = LLHost(dstip, INVALID_PORT);
+	}
+	return count;
+}
+#else
+S32 receive_packets(int hSocket, char ** buffers, S32 buffer_size, S32 * sizes, LLHost * senders, LLHost * receiving_ifs, S32 max_packets)
+{
+	// No recvmmsg(), read until the socket runs dry
+	S32 count = 0;
+	while (count < max_packets)
+	{
+		struct sockaddr_in src_addr;
+		socklen_t addr_size = sizeof(src_addr);
+		int nRet = recvfrom(hSocket, buffers[count], buffer_size, 0, (struct sockaddr*)&src_addr, &addr_size);
+		if (nRet == -1)
+		{
+			if (errno == ECONNREFUSED)
+			{
+				// port unreachable from an earlier send, not a datagram
+				continue;
+			}
+			break;
+		}
+
+		sizes[count] = nRet;
+		senders[count] = LLHost(src_addr.sin_addr.s_addr, ntohs(src_addr.sin_port));
+		receiving_ifs[count] = LLHost(INVALID_HOST_IP_ADDRESS, INVALID_PORT);
+		++count;
+	}
+	return count;
+}
+#endif
+
 BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient, int nPort)
 {
 	int		ret;
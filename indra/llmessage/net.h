@@ -43,6 +43,16 @@ void	end_net(S32& socket_out);
 // returns size of packet or -1 in case of error
 S32		receive_packet(int hSocket, char * receiveBuffer);
 
+// Reads up to max_packets datagrams that are already waiting, without blocking.
+// Each one goes to buffers[i] (buffer_size bytes), with its size, sender and
+// receiving interface in the matching slots of the other arrays.  Does not touch
+// the state behind get_sender()/get_receiving_interface(), so it can run on a
+// thread of its own.  Returns the number of datagrams read.
+S32		receive_packets(int hSocket, char ** buffers, S32 buffer_size, S32 * sizes, LLHost * senders, LLHost * receiving_ifs, S32 max_packets);
+
+// Returns TRUE if a datagram is waiting on the socket, waiting up to timeout_ms for one.
+BOOL	wait_for_packet(int hSocket, S32 timeout_ms);
+
 BOOL	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
 //void	get_sender(char * tmp);
@@ -29,16 +29,18 @@
 #include "llmath.h"
 //#include "vmath.h"
 #include "v3math.h"
+#include "llvector4a.h"
 #include "patch_dct.h"
 
-LLGroupHeader	*gGOPP;
+// Decoder state is per thread, so layer data can be decoded on worker threads.
+thread_local LLGroupHeader	*gGOPP;
 
 void set_group_of_patch_header(LLGroupHeader *gopp)
 {
 	gGOPP = gopp;
 }
 
-F32 gPatchDequantizeTable[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+thread_local F32 gPatchDequantizeTable[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 void build_patch_dequantize_table(S32 size)
 {
 	S32 i, j;
@@ -51,9 +53,9 @@ void build_patch_dequantize_table(S32 size)
 	}
 }
 
-S32	gCurrentDeSize = 0;
+thread_local S32	gCurrentDeSize = 0;
 
-F32	gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+thread_local LL_ALIGN_16(F32 gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
 
 void setup_patch_icosines(S32 size)
 {
@@ -69,7 +71,7 @@ void setup_patch_icosines(S32 size)
 	}
 }
 
-S32	gDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+thread_local S32	gDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 
 void build_decopy_matrix(S32 size)
 {
@@ -146,444 +148,54 @@ void init_patch_decompressor(S32 size)
 	}
 }
 
-inline void idct_line(F32 *linein, F32 *lineout, S32 line)
+// Two passes of 1D inverse DCTs, four outputs at a time: the column pass
+// transposes into temp, the line pass transposes back into block.
+static void idct_patch(F32 *block, S32 size)
 {
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
+	LL_ALIGN_16(F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	const F32 *pcp = gPatchICosines;
+	const F32 oosob = 2.f/size;
+	LLVector4a total, term, coef;
 
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	F32 oosob = 2.f/16.f;
-	S32	line_size = line*NORMAL_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-
-
-	for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + line_size;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		*(lineout + line_size + n) = total*oosob;
-	}
-#else
-	F32 oosob = 2.f/size;
-	S32	size = gGOPP->patch_size;
-	S32	line_size = line*size;
-	S32 u;
-	for (n = 0; n < size; n++)
+	// temp[n][c] = sum over u of block[u][c]*cos[u][n]
+	for (S32 n = 0; n < size; n++)
 	{
-		total = OO_SQRT2*linein[line_size];
-		for (u = 1; u < size; u++)
+		for (S32 c = 0; c < size; c += 4)
 		{
-			total += linein[line_size + u]*pcp[u*size+n];
+			coef.splat(OO_SQRT2);
+			total.load4a(block + c);
+			total.mul(coef);
+			for (S32 u = 1; u < size; u++)
+			{
+				coef.splat(pcp[u*size + n]);
+				term.load4a(block + u*size + c);
+				term.mul(coef);
+				total.add(term);
+			}
+			total.store4a(temp + n*size + c);
 		}
-		lineout[line_size + n] = total*oosob;
-	}
-#endif
-}
-
-inline void idct_line_large_slow(F32 *linein, F32 *lineout, S32 line)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 oosob = 2.f/32.f;
-	S32	line_size = line*LARGE_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + line_size;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(lineout + line_size + n) = total*oosob;
-	}
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_line_large(F32 *linein, F32 *lineout, S32 line)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 oosob = 2.f/32.f;
-	S32	line_size = line*LARGE_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-	F32 *baselinein = linein + line_size;
-	F32 *baselineout = lineout + line_size;
-
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
-	{
-		tpcp = pcp++;
-		tlinein = baselinein;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp));
-
-		*baselineout++ = total*oosob;
-	}
-}
-
-inline void idct_column(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	F32 *tlinein, *tpcp;
-
-	for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + column;
-
-		total = OO_SQRT2*(*tlinein);
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		*(lineout + (n<<4) + column) = total;
 	}
 
-#else
-	S32	size = gGOPP->patch_size;
-	S32 u;
-	S32 u_size;
-
-	for (n = 0; n < size; n++)
+	// block[l][n] = oosob * sum over u of temp[l][u]*cos[u][n]
+	for (S32 l = 0; l < size; l++)
 	{
-		total = OO_SQRT2*linein[column];
-		for (u = 1; u < size; u++)
+		const F32 *line = temp + l*size;
+		for (S32 n = 0; n < size; n += 4)
 		{
-			u_size = u*size;
-			total += linein[u_size + column]*pcp[u_size+n];
+			coef.splat(OO_SQRT2*line[0]);
+			total.load4a(pcp + n);
+			total.mul(coef);
+			for (S32 u = 1; u < size; u++)
+			{
+				coef.splat(line[u]);
+				term.load4a(pcp + u*size + n);
+				term.mul(coef);
+				total.add(term);
+			}
+			total.mul(oosob);
+			total.store4a(block + l*size + n);
 		}
-		lineout[size*n + column] = total;
-	}
-#endif
-}
-
-inline void idct_column_large_slow(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 *tlinein, *tpcp;
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + column;
-
-		total = OO_SQRT2*(*tlinein);
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(lineout + (n<<5) + column) = total;
-	}
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_column_large(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n, m;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 *tlinein, *tpcp;
-	F32 *baselinein = linein + column;
-	F32 *baselineout = lineout + column;
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
-	{
-		tpcp = pcp++;
-		tlinein = baselinein;
-
-		total = OO_SQRT2*(*tlinein);
-		for (m = 1; m < NORMAL_PATCH_SIZE; m++)
-			total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(baselineout + (n<<5)) = total;
-	}
-}
-
-inline void idct_patch(F32 *block)
-{
-	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	idct_column(block, temp, 0);	
-	idct_column(block, temp, 1);	
-	idct_column(block, temp, 2);	
-	idct_column(block, temp, 3);	
-
-	idct_column(block, temp, 4);	
-	idct_column(block, temp, 5);	
-	idct_column(block, temp, 6);	
-	idct_column(block, temp, 7);	
-
-	idct_column(block, temp, 8);	
-	idct_column(block, temp, 9);	
-	idct_column(block, temp, 10);	
-	idct_column(block, temp, 11);	
-
-	idct_column(block, temp, 12);	
-	idct_column(block, temp, 13);	
-	idct_column(block, temp, 14);	
-	idct_column(block, temp, 15);	
-
-	idct_line(temp, block, 0);	
-	idct_line(temp, block, 1);	
-	idct_line(temp, block, 2);	
-	idct_line(temp, block, 3);	
-
-	idct_line(temp, block, 4);	
-	idct_line(temp, block, 5);	
-	idct_line(temp, block, 6);	
-	idct_line(temp, block, 7);	
-
-	idct_line(temp, block, 8);	
-	idct_line(temp, block, 9);	
-	idct_line(temp, block, 10);	
-	idct_line(temp, block, 11);	
-
-	idct_line(temp, block, 12);	
-	idct_line(temp, block, 13);	
-	idct_line(temp, block, 14);	
-	idct_line(temp, block, 15);	
-#else
-	S32 i;
-	S32	size = gGOPP->patch_size;
-	for (i = 0; i < size; i++)
-	{
-		idct_column(block, temp, i);	
-	}
-	for (i = 0; i < size; i++)
-	{
-		idct_line(temp, block, i);	
 	}
-#endif
-}
-
-inline void idct_patch_large(F32 *block)
-{
-	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-	idct_column_large_slow(block, temp, 0);	
-	idct_column_large_slow(block, temp, 1);	
-	idct_column_large_slow(block, temp, 2);	
-	idct_column_large_slow(block, temp, 3);	
-
-	idct_column_large_slow(block, temp, 4);	
-	idct_column_large_slow(block, temp, 5);	
-	idct_column_large_slow(block, temp, 6);	
-	idct_column_large_slow(block, temp, 7);	
-
-	idct_column_large_slow(block, temp, 8);	
-	idct_column_large_slow(block, temp, 9);	
-	idct_column_large_slow(block, temp, 10);	
-	idct_column_large_slow(block, temp, 11);	
-
-	idct_column_large_slow(block, temp, 12);	
-	idct_column_large_slow(block, temp, 13);	
-	idct_column_large_slow(block, temp, 14);	
-	idct_column_large_slow(block, temp, 15);	
-
-	idct_column_large_slow(block, temp, 16);	
-	idct_column_large_slow(block, temp, 17);	
-	idct_column_large_slow(block, temp, 18);	
-	idct_column_large_slow(block, temp, 19);	
-
-	idct_column_large_slow(block, temp, 20);	
-	idct_column_large_slow(block, temp, 21);	
-	idct_column_large_slow(block, temp, 22);	
-	idct_column_large_slow(block, temp, 23);	
-
-	idct_column_large_slow(block, temp, 24);	
-	idct_column_large_slow(block, temp, 25);	
-	idct_column_large_slow(block, temp, 26);	
-	idct_column_large_slow(block, temp, 27);	
-
-	idct_column_large_slow(block, temp, 28);	
-	idct_column_large_slow(block, temp, 29);	
-	idct_column_large_slow(block, temp, 30);	
-	idct_column_large_slow(block, temp, 31);	
-
-	idct_line_large_slow(temp, block, 0);	
-	idct_line_large_slow(temp, block, 1);	
-	idct_line_large_slow(temp, block, 2);	
-	idct_line_large_slow(temp, block, 3);	
-
-	idct_line_large_slow(temp, block, 4);	
-	idct_line_large_slow(temp, block, 5);	
-	idct_line_large_slow(temp, block, 6);	
-	idct_line_large_slow(temp, block, 7);	
-
-	idct_line_large_slow(temp, block, 8);	
-	idct_line_large_slow(temp, block, 9);	
-	idct_line_large_slow(temp, block, 10);	
-	idct_line_large_slow(temp, block, 11);	
-
-	idct_line_large_slow(temp, block, 12);	
-	idct_line_large_slow(temp, block, 13);	
-	idct_line_large_slow(temp, block, 14);	
-	idct_line_large_slow(temp, block, 15);	
-
-	idct_line_large_slow(temp, block, 16);	
-	idct_line_large_slow(temp, block, 17);	
-	idct_line_large_slow(temp, block, 18);	
-	idct_line_large_slow(temp, block, 19);	
-
-	idct_line_large_slow(temp, block, 20);	
-	idct_line_large_slow(temp, block, 21);	
-	idct_line_large_slow(temp, block, 22);	
-	idct_line_large_slow(temp, block, 23);	
-
-	idct_line_large_slow(temp, block, 24);	
-	idct_line_large_slow(temp, block, 25);	
-	idct_line_large_slow(temp, block, 26);	
-	idct_line_large_slow(temp, block, 27);	
-
-	idct_line_large_slow(temp, block, 28);	
-	idct_line_large_slow(temp, block, 29);	
-	idct_line_large_slow(temp, block, 30);	
-	idct_line_large_slow(temp, block, 31);	
 }
 
 S32	gDitherNoise = 128;
@@ -592,7 +204,8 @@ void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 {
 	S32		i, j;
 
-	F32		block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+	LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	F32		*tblock = block;
 	F32		*tpatch;
 
 	LLGroupHeader	*gopp = gGOPP;
@@ -615,14 +228,7 @@ void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
 	}
 
-	if (size == 16)
-	{
-		idct_patch(block);
-	}
-	else
-	{
-		idct_patch_large(block);
-	}
+	idct_patch(block, size);
 
 	for (j = 0; j < size; j++)
 	{
@@ -640,7 +246,8 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 {
 	S32		i, j;
 
-	F32			block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+	LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	F32			*tblock = block;
 	LLVector3	*tvec;
 
 	LLGroupHeader	*gopp = gGOPP;
@@ -666,10 +273,7 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
 	}
 
-	if (size == 16)
-		idct_patch(block);
-	else
-		idct_patch_large(block);
+	idct_patch(block, size);
 
 	for (j = 0; j < size; j++)
 	{
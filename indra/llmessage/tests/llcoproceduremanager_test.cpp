@@ -176,4 +176,31 @@ namespace tut
         LL_INFOS("CoMain") << "checking count" << LL_ENDL;
         ensure_equals("coprocedure failed to update counter", counter, 5);
     }
+
+    template<> template<>
+    void coproceduremanager_object_t::test<5>()
+    {
+        Sync sync;
+        std::string order;
+        auto proc = [&order, &sync](char tag)
+        {
+            return [&order, &sync, tag](LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, const LLUUID &) {
+                order += tag;
+                sync.bump();
+            };
+        };
+        // single worker, so queued coprocedures run strictly one at a time
+        LLCoprocedureManager::instance().initializePool("Upload");
+        LLCoprocedureManager::instance().enqueueCoprocedure("Upload", "Background", proc('b'),
+            LLCoprocedureManager::PRIORITY_BACKGROUND);
+        LLCoprocedureManager::instance().enqueueCoprocedure("Upload", "Normal1", proc('n'));
+        LLCoprocedureManager::instance().enqueueCoprocedure("Upload", "Interactive", proc('i'),
+            LLCoprocedureManager::PRIORITY_INTERACTIVE);
+        LLCoprocedureManager::instance().enqueueCoprocedure("Upload", "Normal2", proc('N'));
+
+        sync.yield(4);
+        ensure_equals("coprocedures ran out of priority order", order, "inNb");
+
+        LLCoprocedureManager::instance().close("Upload");
+    }
 }  // namespace tut
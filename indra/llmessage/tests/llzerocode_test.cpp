@@ -0,0 +1,116 @@
+/**
+ * @file llzerocode_test.cpp
+ * @brief Tests for zero coding of message bodies
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llzerocode.h"
+
+#include "../llcircuit.h"
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace tut
+{
+	struct zerocode_test
+	{
+		// header, then the body
+		std::vector<U8> packet(const std::vector<U8>& body)
+		{
+			std::vector<U8> data(LL_PACKET_ID_SIZE, 0x11);
+			data.insert(data.end(), body.begin(), body.end());
+			return data;
+		}
+
+		std::vector<U8> encode(const std::vector<U8>& data)
+		{
+			std::vector<U8> out(2 * data.size());
+			out.resize(ll_zero_code(&data[0], (S32)data.size(), &out[0]));
+			return out;
+		}
+
+		std::vector<U8> expand(const std::vector<U8>& data, S32 out_size = 4096)
+		{
+			std::vector<U8> out(out_size);
+			S32 size = ll_zero_expand(&data[0], (S32)data.size(), &out[0], out_size);
+			out.resize(llmax(size, 0));
+			return out;
+		}
+	};
+	typedef test_group<zerocode_test> zerocode_t;
+	typedef zerocode_t::object zerocode_object_t;
+	tut::zerocode_t tut_zerocode("LLZeroCode");
+
+	template<> template<>
+	void zerocode_object_t::test<1>()
+	{
+		// runs shorter and longer than a vector, and past one count byte
+		std::vector<U8> body;
+		body.push_back(7);
+		body.insert(body.end(), 3, 0);
+		body.insert(body.end(), 40, 9);
+		body.insert(body.end(), 300, 0);
+		body.push_back(1);
+		body.insert(body.end(), 17, 0);
+
+		std::vector<U8> data = packet(body);
+		std::vector<U8> encoded = encode(data);
+		ensure("encoded is smaller", encoded.size() < data.size());
+		ensure("header left alone", std::equal(data.begin(), data.begin() + LL_PACKET_ID_SIZE, encoded.begin()));
+		// 0 255 0 45 for the 300 zeroes
+		ensure_equals("encoded size", encoded.size(), (size_t)(LL_PACKET_ID_SIZE + 1 + 2 + 40 + 4 + 1 + 2));
+		ensure("round trip", expand(encoded) == data);
+	}
+
+	template<> template<>
+	void zerocode_object_t::test<2>()
+	{
+		// 0 0 [count] is 256 more zeroes than 0 [count]
+		std::vector<U8> encoded = packet(std::vector<U8>());
+		encoded.push_back(0);
+		encoded.push_back(0);
+		encoded.push_back(4);
+		encoded.push_back(5);
+		std::vector<U8> expanded = expand(encoded);
+		ensure_equals("expanded size", expanded.size(), (size_t)(LL_PACKET_ID_SIZE + 260 + 1));
+		ensure_equals("last byte", expanded.back(), 5);
+
+		// a trailing 0 without a count is one zero
+		encoded.resize(LL_PACKET_ID_SIZE + 1);
+		ensure_equals("trailing zero", expand(encoded).size(), (size_t)(LL_PACKET_ID_SIZE + 1));
+	}
+
+	template<> template<>
+	void zerocode_object_t::test<3>()
+	{
+		// expansion that doesn't fit
+		std::vector<U8> encoded = packet(std::vector<U8>());
+		encoded.push_back(0);
+		encoded.push_back(200);
+		std::vector<U8> out(100);
+		ensure_equals("overflow", ll_zero_expand(&encoded[0], (S32)encoded.size(), &out[0], (S32)out.size()), -1);
+	}
+}
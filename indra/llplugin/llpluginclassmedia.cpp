@@ -126,10 +126,12 @@ void LLPluginClassMedia::reset()
 	mRequestedVolume = 0.0f;
 	mPriority = PRIORITY_NORMAL;
 	mLowPrioritySizeLimit = LOW_PRIORITY_TEXTURE_SIZE_DEFAULT;
+	mFrameRateLimit = 0.f;
 	mAllowDownsample = false;
 	mPadding = 0;
 	mLastMouseX = 0;
 	mLastMouseY = 0;
+	mMouseMovePending = false;
 	mStatus = LLPluginClassMediaOwner::MEDIA_NONE;
 	mSleepTime = 1.0f / 100.0f;
 	mCanCut = false;
@@ -164,6 +166,8 @@ void LLPluginClassMedia::reset()
 
 void LLPluginClassMedia::idle(void)
 {
+	sendPendingMouseMove();
+
 	if(mPlugin)
 	{
 		mPlugin->idle();
@@ -588,6 +592,14 @@ void LLPluginClassMedia::mouseEvent(EMouseEventType type, int button, int x, int
 
 	message.setValue("modifiers", translateModifiers(modifiers));
 
+	if(type == MOUSE_EVENT_MOVE)
+	{
+		// Replaces any move not sent yet this frame.
+		mPendingMouseMove = message;
+		mMouseMovePending = true;
+		return;
+	}
+
 	sendMessage(message);
 }
 
@@ -862,6 +874,18 @@ void LLPluginClassMedia::setLowPrioritySizeLimit(int size)
 	}
 }
 
+void LLPluginClassMedia::setFrameRateLimit(F32 fps)
+{
+	if(mFrameRateLimit != fps)
+	{
+		mFrameRateLimit = fps;
+
+		LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_MEDIA, "set_frame_rate_limit");
+		message.setValueReal("fps", fps);
+		sendMessage(message);
+	}
+}
+
 F64 LLPluginClassMedia::getCPUUsage()
 {
 	F64 result = 0.0f;
@@ -1352,6 +1376,9 @@ void LLPluginClassMedia::mediaEvent(LLPluginClassMediaOwner::EMediaEvent event)
 
 void LLPluginClassMedia::sendMessage(const LLPluginMessage &message)
 {
+	// Keep the pending move in order with whatever is sent after it.
+	sendPendingMouseMove();
+
 	if(mPlugin && mPlugin->isRunning())
 	{
 		mPlugin->sendMessage(message);
@@ -1363,6 +1390,15 @@ void LLPluginClassMedia::sendMessage(const LLPluginMessage &message)
 	}
 }
 
+void LLPluginClassMedia::sendPendingMouseMove()
+{
+	if(mMouseMovePending)
+	{
+		mMouseMovePending = false;
+		sendMessage(mPendingMouseMove);
+	}
+}
+
 ////////////////////////////////////////////////////////////
 // MARK: media_browser class functions
 bool LLPluginClassMedia::pluginSupportsMediaBrowser(void)
@@ -189,6 +189,8 @@ public:
 	static const char* priorityToString(EPriority priority);
 	void setPriority(EPriority priority);
 	void setLowPrioritySizeLimit(int size);
+	// Ask the plugin to publish at most fps frames per second, 0 for no limit
+	void setFrameRateLimit(F32 fps);
 	
 	F64 getCPUUsage();
 	
@@ -345,6 +347,7 @@ protected:
 	void mediaEvent(LLPluginClassMediaOwner::EMediaEvent event);
 		
 	void sendMessage(const LLPluginMessage &message);  // Send message internally, either queueing or sending directly.
+	void sendPendingMouseMove();	// Send the latest mouse move, if any, ahead of other messages.
 	std::queue<LLPluginMessage> mSendQueue;		// Used to queue messages while the plugin initializes.
 	
 	void setSizeInternal(void);
@@ -400,6 +403,7 @@ protected:
 	// Priority of this media stream
 	EPriority	mPriority;
 	int			mLowPrioritySizeLimit;
+	F32			mFrameRateLimit;
 	
 	bool		mAllowDownsample;
 	int			mPadding;
@@ -414,6 +418,9 @@ protected:
 	std::string mCursorName;
 	int			mLastMouseX;
 	int			mLastMouseY;
+	// Mouse moves are held until the next idle() or other message, so only the latest one per frame is sent.
+	LLPluginMessage	mPendingMouseMove;
+	bool		mMouseMovePending;
 
 	LLPluginClassMediaOwner::EMediaStatus mStatus;
 	
@@ -32,6 +32,9 @@
 #include "llsdserialize.h"
 #include "u64.h"
 
+// What LLSDSerialize::serialize() writes ahead of binary LLSD
+const std::string LLPluginMessage::sBinaryHeader("<? LLSD/Binary ?>\n");
+
 /**
  * Constructor.
  */
@@ -364,6 +367,21 @@ std::string LLPluginMessage::generate(void) const
 	return result.str();
 }
 
+/**
+ * Flatten the message into binary LLSD, which is much cheaper to generate and parse than XML.
+ * The result starts with the usual binary LLSD header so parse() can tell it apart, and may contain
+ * null bytes, so it can only be sent to a process that negotiated binary messages.
+ *
+ * @return Binary message as a string
+ */
+std::string LLPluginMessage::generateBinary(void) const
+{
+	std::ostringstream result;
+	LLSDSerialize::serialize(mMessage, result, LLSDSerialize::LLSD_BINARY);
+
+	return result.str();
+}
+
 /**
  *	Parse an incoming message into component parts. Clears all existing state before starting the parse.
  *
@@ -374,9 +392,18 @@ int LLPluginMessage::parse(const std::string &message)
 	// clear any previous state
 	clear();
 
-	std::istringstream input(message);
-	
-	S32 parse_result = LLSDSerialize::fromXML(mMessage, input);
+	S32 parse_result;
+	if (message.compare(0, sBinaryHeader.size(), sBinaryHeader) == 0)
+	{
+		parse_result = LLSDSerialize::fromBinary(mMessage,
+			(const U8*)message.data() + sBinaryHeader.size(),
+			message.size() - sBinaryHeader.size());
+	}
+	else
+	{
+		std::istringstream input(message);
+		parse_result = LLSDSerialize::fromXML(mMessage, input);
+	}
 	
 	return (int)parse_result;
 }
@@ -88,6 +88,9 @@ public:
 	// Flatten the message into a string
 	std::string generate(void) const;
 
+	// Flatten the message into binary LLSD (see LLPluginProcessParent for when this may be used)
+	std::string generateBinary(void) const;
+
 	// Parse an incoming message into component parts
 	// (this clears out all existing state before starting the parse)
 	// Returns -1 on failure, otherwise returns the number of key/value pairs in the message.
@@ -96,6 +99,8 @@ public:
 	
 private:
 	
+	static const std::string sBinaryHeader;
+
 	LLSD mMessage;
 
 };
@@ -35,6 +35,11 @@
 
 static const char MESSAGE_DELIMITER = '\0';
 
+// Messages that contain the delimiter (binary LLSD) are sent as this marker, a 4 byte big endian
+// length and the message instead.  Text messages never start with the marker.
+static const char MESSAGE_FRAME_MARKER = '\1';
+static const size_t MESSAGE_FRAME_HEADER_SIZE = 5;
+
 LLPluginMessagePipeOwner::LLPluginMessagePipeOwner() :
 	mMessagePipe(NULL),
 	mSocketError(APR_SUCCESS)
@@ -121,8 +126,19 @@ bool LLPluginMessagePipe::addMessage(const std::string &message)
 		mOutputStartIndex = 0;
 	}
 		
-	mOutput += message;
-	mOutput += MESSAGE_DELIMITER;	// message separator
+	if (message.find(MESSAGE_DELIMITER) == std::string::npos)
+	{
+		mOutput += message;
+		mOutput += MESSAGE_DELIMITER;	// message separator
+	}
+	else
+	{
+		U32 size = (U32)message.size();
+		char header[MESSAGE_FRAME_HEADER_SIZE] = { MESSAGE_FRAME_MARKER,
+			(char)(size >> 24), (char)(size >> 16), (char)(size >> 8), (char)size };
+		mOutput.append(header, MESSAGE_FRAME_HEADER_SIZE);
+		mOutput += message;
+	}
 	
 	return true;
 }
@@ -370,19 +386,43 @@ bool LLPluginMessagePipe::pumpInput(F64 timeout)
 
 void LLPluginMessagePipe::processInput(void)
 {
-	// Look for input delimiter(s) in the input buffer.
-	int delim;
+	// Pull complete messages off the front of the input buffer, either delimited or framed.
 	mInputMutex.lock();
-	while((delim = mInput.find(MESSAGE_DELIMITER)) != std::string::npos)
-	{	
+	while(!mInput.empty())
+	{
+		std::string message;
+		if (mInput[0] == MESSAGE_FRAME_MARKER)
+		{
+			if (mInput.size() < MESSAGE_FRAME_HEADER_SIZE)
+			{
+				break;
+			}
+			const U8 *header = (const U8 *)mInput.data();
+			size_t size = ((size_t)header[1] << 24) | ((size_t)header[2] << 16) | ((size_t)header[3] << 8) | (size_t)header[4];
+			if (mInput.size() < MESSAGE_FRAME_HEADER_SIZE + size)
+			{
+				break;
+			}
+			message.assign(mInput, MESSAGE_FRAME_HEADER_SIZE, size);
+			mInput.erase(0, MESSAGE_FRAME_HEADER_SIZE + size);
+		}
+		else
+		{
+			size_t delim = mInput.find(MESSAGE_DELIMITER);
+			if (delim == std::string::npos)
+			{
+				break;
+			}
+			message.assign(mInput, 0, delim);
+			mInput.erase(0, delim + 1);
+		}
+
 		// Let the owner process this message
 		if (mOwner)
 		{
-			// Pull the message out of the input buffer before calling receiveMessageRaw.
+			// The message is pulled out of the input buffer before calling receiveMessageRaw.
 			// It's now possible for this function to get called recursively (in the case where the plugin makes a blocking request)
 			// and this guarantees that the messages will get dequeued correctly.
-			std::string message(mInput, 0, delim);
-			mInput.erase(0, delim + 1);
 			mInputMutex.unlock();
 			mOwner->receiveMessageRaw(message);
 			mInputMutex.lock();
@@ -46,6 +46,7 @@ LLPluginProcessChild::LLPluginProcessChild()
 	mCPUElapsed = 0.0f;
 	mBlockingRequest = false;
 	mBlockingResponseReceived = false;
+	mBinaryMessages = false;
 }
 
 LLPluginProcessChild::~LLPluginProcessChild()
@@ -335,7 +336,7 @@ void LLPluginProcessChild::sendMessageToPlugin(const LLPluginMessage &message)
 
 void LLPluginProcessChild::sendMessageToParent(const LLPluginMessage &message)
 {
-	std::string buffer = message.generate();
+	std::string buffer = mBinaryMessages ? message.generateBinary() : message.generate();
 
 	LL_DEBUGS("Plugin") << "Sending to parent: " << buffer << LL_ENDL;
 
@@ -384,6 +385,8 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 			{
 				mPluginFile = parsed.getValue("file");
 				mPluginDir = parsed.getValue("dir");
+				// The parent understands binary messages and will switch to them once we confirm.
+				mBinaryMessages = parsed.hasValue("binary_messages") && parsed.getValueBoolean("binary_messages");
 			}
 			else if (message_name == "shutdown_plugin")
 			{
@@ -498,12 +501,12 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 
 	// FIXME: how should we handle queueing here?
 
+	// Decode this message
+	LLPluginMessage parsed;
+	parsed.parse(message);
+
 	// Intercept certain base messages (responses to ones sent by this class)
 	{
-		// Decode this message
-		LLPluginMessage parsed;
-		parsed.parse(message);
-
 		if (parsed.hasValue("blocking_request"))
 		{
 			mBlockingRequest = true;
@@ -531,6 +534,11 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 					new_message.setValueLLSD("plugin_version", plugin_version);
 				}
 
+				if (mBinaryMessages)
+				{
+					new_message.setValueBoolean("binary_messages", true);
+				}
+
 				// Let the parent know it's loaded and initialized.
 				sendMessageToParent(new_message);
 			}
@@ -569,7 +577,15 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 	if (passMessage)
 	{
 		LL_DEBUGS("Plugin") << "Passing through to parent: " << message << LL_ENDL;
-		writeMessageRaw(message);
+		if (mBinaryMessages)
+		{
+			// The plugin talks XML, but we've already parsed it, so spare the parent from doing that again.
+			writeMessageRaw(parsed.generateBinary());
+		}
+		else
+		{
+			writeMessageRaw(message);
+		}
 	}
 
 	while (mBlockingRequest)
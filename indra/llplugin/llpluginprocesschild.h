@@ -106,6 +106,7 @@ private:
     F64		mCPUElapsed;
 	bool	mBlockingRequest;
 	bool	mBlockingResponseReceived;
+	bool	mBinaryMessages;	// send binary LLSD to the parent
 	std::queue<std::string> mMessageQueue;
     LLTimer mWaitGoodbye;
 	void deliverQueuedMessages();
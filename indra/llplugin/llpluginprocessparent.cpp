@@ -118,6 +118,7 @@ LLPluginProcessParent::LLPluginProcessParent(LLPluginProcessParentOwner *owner):
 	mDebug = false;
 	mBlocked = false;
 	mPolledInput = false;
+	mBinaryMessages = false;
 	mPollFD.client_data = NULL;
 
 	mPluginLaunchTimeout = 60.0f;
@@ -645,6 +646,8 @@ void LLPluginProcessParent::idle(void)
 					LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "load_plugin");
 					message.setValue("file", mPluginFile);
 					message.setValue("dir", mPluginDir);
+					// Offer binary messages; a plugin host that doesn't know about them ignores this.
+					message.setValueBoolean("binary_messages", true);
 					sendMessage(message);
 				}
 
@@ -779,7 +782,7 @@ void LLPluginProcessParent::sendMessage(const LLPluginMessage &message)
 		mHeartbeat.setTimerExpirySec(mPluginLockupTimeout);
 	}
 	
-	std::string buffer = message.generate();
+	std::string buffer = mBinaryMessages ? message.generateBinary() : message.generate();
 	LL_DEBUGS("Plugin") << "Sending: " << buffer << LL_ENDL;	
 	writeMessageRaw(buffer);
 	
@@ -1111,6 +1114,9 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
 				// Plugin has been loaded. 
 				
 				mPluginVersionString = message.getValue("plugin_version");
+
+				// The plugin host agreed to binary messages, use them from here on.
+				mBinaryMessages = message.hasValue("binary_messages") && message.getValueBoolean("binary_messages");
 				LL_INFOS("Plugin") << "plugin version string: " << mPluginVersionString << LL_ENDL;
 
 				// Check which message classes/versions the plugin supports.
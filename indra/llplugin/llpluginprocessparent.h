@@ -197,6 +197,7 @@ private:
 	bool mDebug;
 	bool mBlocked;
 	bool mPolledInput;
+	bool mBinaryMessages;	// send binary LLSD to the plugin host
 
 	LLProcessPtr mDebugger;
 	
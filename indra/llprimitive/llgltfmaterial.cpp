@@ -31,6 +31,9 @@
 
 #include "llsdserialize.h"
 
+#include <boost/functional/hash.hpp>
+#include <unordered_map>
+
 // NOTE -- this should be the one and only place tiny_gltf.h is included
 #include "tinygltf/tiny_gltf.h"
 #include "llgltfmaterial_templates.h"
@@ -799,6 +802,81 @@ LLUUID LLGLTFMaterial::getHash() const
     return hash;
 }
 
+size_t LLGLTFMaterial::getValueHash() const
+{
+    size_t seed = 0;
+    for (U32 i = 0; i < GLTF_TEXTURE_INFO_COUNT; ++i)
+    {
+        boost::hash_combine(seed, mTextureId[i]);
+        boost::hash_combine(seed, mTextureTransform[i].mOffset.mV[VX]);
+        boost::hash_combine(seed, mTextureTransform[i].mOffset.mV[VY]);
+        boost::hash_combine(seed, mTextureTransform[i].mScale.mV[VX]);
+        boost::hash_combine(seed, mTextureTransform[i].mScale.mV[VY]);
+        boost::hash_combine(seed, mTextureTransform[i].mRotation);
+    }
+    boost::hash_range(seed, mBaseColor.mV, mBaseColor.mV + 4);
+    boost::hash_range(seed, mEmissiveColor.mV, mEmissiveColor.mV + 3);
+    boost::hash_combine(seed, mMetallicFactor);
+    boost::hash_combine(seed, mRoughnessFactor);
+    boost::hash_combine(seed, mAlphaCutoff);
+    boost::hash_combine(seed, mDoubleSided);
+    boost::hash_combine(seed, (S32)mAlphaMode);
+    boost::hash_combine(seed, mOverrideDoubleSided);
+    boost::hash_combine(seed, mOverrideAlphaMode);
+    return seed;
+}
+
+namespace
+{
+    // shared overrides by value hash, the ones only referenced from here are
+    // dropped whenever the map doubles in size
+    typedef std::unordered_multimap<size_t, LLPointer<LLGLTFMaterial> > shared_override_map_t;
+    shared_override_map_t sSharedOverrides;
+    size_t sSharedOverridesPurgeSize = 1024;
+}
+
+// static
+LLPointer<LLGLTFMaterial> LLGLTFMaterial::shareOverride(LLGLTFMaterial* mat)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+    // frees mat if it is new and an equal override is already shared
+    LLPointer<LLGLTFMaterial> new_mat = mat;
+    if (!mat || mat->hasLocalTextures())
+    {
+        return new_mat;
+    }
+
+    size_t hash = mat->getValueHash();
+    auto range = sSharedOverrides.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == mat || *it->second == *mat)
+        {
+            return it->second;
+        }
+    }
+
+    if (sSharedOverrides.size() >= sSharedOverridesPurgeSize)
+    {
+        for (auto it = sSharedOverrides.begin(); it != sSharedOverrides.end(); )
+        {
+            if (it->second->getNumRefs() == 1)
+            {
+                it = sSharedOverrides.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        sSharedOverridesPurgeSize = llmax((size_t)1024, sSharedOverrides.size() * 2);
+    }
+
+    sSharedOverrides.emplace(hash, new_mat);
+    return new_mat;
+}
+
 void LLGLTFMaterial::addLocalTextureTracking(const LLUUID& tracking_id, const LLUUID& tex_id)
 {
     mTrackingIdToLocalTexture[tracking_id] = tex_id;
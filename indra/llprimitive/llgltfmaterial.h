@@ -28,6 +28,7 @@
 
 #include "llrefcount.h"
 #include "llmemory.h"
+#include "llpointer.h"
 #include "v4color.h"
 #include "v3color.h"
 #include "v2math.h"
@@ -132,6 +133,16 @@ public:
     // get a UUID based on a hash of this LLGLTFMaterial
     LLUUID getHash() const;
 
+    // hash of the values compared by operator==
+    size_t getValueHash() const;
+
+    // Overrides are shared between all the faces that use an equal override,
+    // so a shared override must not be changed, copy it first.
+    // Returns the shared override equal to mat, adding mat if there is none,
+    // use it in place of mat which is freed if nothing else references it.
+    // Overrides with local textures aren't shared. Main thread only.
+    static LLPointer<LLGLTFMaterial> shareOverride(LLGLTFMaterial* mat);
+
     //setters for various members (will clamp to acceptable ranges)
     // for_override - set to true if this value is being set as part of an override (important for handling override to default value)
 
@@ -225,7 +236,7 @@ public:
     // For local textures so that editor will know to track changes
     void addLocalTextureTracking(const LLUUID& tracking_id, const LLUUID &tex_id);
     void removeLocalTextureTracking(const LLUUID& tracking_id);
-    bool hasLocalTextures() { return !mTrackingIdToLocalTexture.empty(); }
+    bool hasLocalTextures() const { return !mTrackingIdToLocalTexture.empty(); }
     virtual bool replaceLocalTexture(const LLUUID& tracking_id, const LLUUID &old_id, const LLUUID& new_id);
     virtual void updateTextureTracking();
 
@@ -122,13 +122,15 @@ LLTextureEntry &LLTextureEntry::operator=(const LLTextureEntry &rhs)
             mGLTFMaterial->addTextureEntry(this);
         }
         
-        if (rhs.mGLTFMaterialOverrides.notNull())
+        // overrides are shared and never changed in place, except for the
+        // local textures being previewed on this face
+        if (rhs.mGLTFMaterialOverrides.notNull() && rhs.mGLTFMaterialOverrides->hasLocalTextures())
         {
             mGLTFMaterialOverrides = new LLGLTFMaterial(*rhs.mGLTFMaterialOverrides);
         }
         else
         {
-            mGLTFMaterialOverrides = nullptr;
+            mGLTFMaterialOverrides = rhs.mGLTFMaterialOverrides;
         }
 	}
 
@@ -304,19 +306,21 @@ bool LLTextureEntry::fromLLSD(const LLSD& sd)
     w = "gltf_override";
     if (sd.has(w))
     {
-        if (mGLTFMaterialOverrides.isNull())
-        {
-            mGLTFMaterialOverrides = new LLGLTFMaterial();
-        }
+        // the override may be shared, load into a copy
+        LLPointer<LLGLTFMaterial> override_mat = mGLTFMaterialOverrides.isNull() ? new LLGLTFMaterial() : new LLGLTFMaterial(*mGLTFMaterialOverrides);
 
         std::string warn_msg, error_msg;
-        if (!mGLTFMaterialOverrides->fromJSON(sd[w].asString(), warn_msg, error_msg))
+        if (!override_mat->fromJSON(sd[w].asString(), warn_msg, error_msg))
         {
             LL_WARNS() << llformat("Failed to parse GLTF json: %s -- %s", warn_msg.c_str(), error_msg.c_str()) << LL_ENDL;
             LL_WARNS() << sd[w].asString() << LL_ENDL;
 
             mGLTFMaterialOverrides = nullptr;
         }
+        else
+        {
+            mGLTFMaterialOverrides = LLGLTFMaterial::shareOverride(override_mat);
+        }
     }
 
 	return true;
@@ -578,8 +582,11 @@ S32 LLTextureEntry::setBaseMaterial()
 
     if (mGLTFMaterialOverrides)
     {
-        if (mGLTFMaterialOverrides->setBaseMaterial())
+        // the override may be shared, change a copy
+        LLPointer<LLGLTFMaterial> override_mat = new LLGLTFMaterial(*mGLTFMaterialOverrides);
+        if (override_mat->setBaseMaterial())
         {
+            mGLTFMaterialOverrides = LLGLTFMaterial::shareOverride(override_mat);
             changed = TEM_CHANGE_TEXTURE;
         }
 
@@ -366,4 +366,28 @@ namespace tut
             ensure_equals("LLGLTFMaterial: double sided override flag unset", material.mOverrideDoubleSided, false);
         }
     }
+
+    // Test sharing of equal overrides
+    template<> template<>
+    void llgltfmaterial_object_t::test<12>()
+    {
+        LLPointer<LLGLTFMaterial> first = new LLGLTFMaterial();
+        first->setBaseColorFactor(LLColor4(0.5f, 0.25f, 1.f, 1.f), true);
+        first->setTextureOffset(LLGLTFMaterial::GLTF_TEXTURE_INFO_NORMAL, LLVector2(0.5f, 0.f));
+        first = LLGLTFMaterial::shareOverride(first);
+
+        LLPointer<LLGLTFMaterial> second = new LLGLTFMaterial(*first);
+        ensure_equals("LLGLTFMaterial: equal overrides hash equal", second->getValueHash(), first->getValueHash());
+        second = LLGLTFMaterial::shareOverride(second);
+        ensure("LLGLTFMaterial: equal overrides are shared", second == first);
+
+        LLPointer<LLGLTFMaterial> third = new LLGLTFMaterial(*first);
+        third->setRoughnessFactor(0.5f, true);
+        third = LLGLTFMaterial::shareOverride(third);
+        ensure("LLGLTFMaterial: different overrides are not shared", third != first);
+
+        LLPointer<LLGLTFMaterial> local = new LLGLTFMaterial(*first);
+        local->addLocalTextureTracking(LLUUID::generateNewID(), LLUUID::generateNewID());
+        ensure("LLGLTFMaterial: overrides with local textures are not shared", LLGLTFMaterial::shareOverride(local) == local);
+    }
 }
@@ -168,6 +168,7 @@ void LLFontBitmapCache::reset()
 	
 	mBitmapWidth = 0;
 	mBitmapHeight = 0;
+	mGeneration++;
 }
 
 //static
@@ -29,6 +29,8 @@
 
 #include <vector>
 #include "lltrace.h"
+#include "llimage.h"
+#include "llimagegl.h"
 
 enum class EFontGlyphType : U32
 {
@@ -63,6 +65,8 @@ public:
 	U32 getNumBitmaps(EFontGlyphType bitmapType) const { return (bitmapType < EFontGlyphType::Count) ? mImageRawVec[static_cast<U32>(bitmapType)].size() : 0; }
 	S32 getBitmapWidth() const { return mBitmapWidth; }
 	S32 getBitmapHeight() const { return mBitmapHeight; }
+	// Bumped by reset(), which invalidates every glyph's bitmap position
+	U32 getGeneration() const { return mGeneration; }
 
 protected:
 	static U32 getNumComponents(EFontGlyphType bitmap_type);
@@ -74,6 +78,7 @@ private:
 	S32 mCurrentOffsetY[static_cast<U32>(EFontGlyphType::Count)] = { 1 };
 	S32 mMaxCharWidth = 0;
 	S32 mMaxCharHeight = 0;
+	U32 mGeneration = 0;
 	std::vector<LLPointer<LLImageRaw>> mImageRawVec[static_cast<U32>(EFontGlyphType::Count)];
 	std::vector<LLPointer<LLImageGL>> mImageGLVec[static_cast<U32>(EFontGlyphType::Count)];
 };
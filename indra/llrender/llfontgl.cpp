@@ -81,11 +81,15 @@ LLFontGL::~LLFontGL()
 
 void LLFontGL::reset()
 {
+	mGlyphRuns.clear();
+	mGlyphRunIndex.clear();
 	mFontFreetype->reset(sVertDPI, sHorizDPI);
 }
 
 void LLFontGL::destroyGL()
 {
+	mGlyphRuns.clear();
+	mGlyphRunIndex.clear();
 	mFontFreetype->destroyGL();
 }
 
@@ -185,10 +189,15 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 
 	// Depth translation, so that floating text appears 'in-world'
 	// and is correctly occluded.
-	gGL.translatef(0.f,0.f,sCurDepth);
+	// translatef() flushes, so skip it for flat UI text: that way glyphs from
+	// consecutive render() calls, across widgets, go out in one batch as long
+	// as nothing else binds a texture or changes the clip rect in between.
+	if (sCurDepth != 0.f)
+	{
+		gGL.translatef(0.f,0.f,sCurDepth);
+	}
 
 	S32 chars_drawn = 0;
-	S32 i;
 	S32 length;
 
 	if (-1 == max_chars)
@@ -200,7 +209,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 		length = llmin((S32)wstr.length() - begin_offset, max_chars );
 	}
 
-	F32 cur_x, cur_y, cur_render_x, cur_render_y;
+	F32 cur_x, cur_y;
 
  	// Not guaranteed to be set correctly
 	gGL.setSceneBlendType(LLRender::BT_ALPHA);
@@ -228,48 +237,35 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 		break;
 	}
 
+	// The layout only depends on where within a pixel the string starts, the
+	// rest is a whole pixel offset. The alignment below only moves the string
+	// by whole pixels, so it can use the width the run measured.
+	F32 base_x = floorf(cur_x);
+	F32 base_y = floorf(cur_y);
+	const GlyphRun& run = getGlyphRun(wstr, begin_offset, length, max_chars, scaled_max_pixels,
+									  cur_x - base_x, cur_y - base_y, use_ellipses, use_color);
+
 	switch (halign)
 	{
 	case LEFT:
 		break;
 	case RIGHT:
-	  	cur_x -= llmin(scaled_max_pixels, ll_round(getWidthF32(wstr.c_str(), begin_offset, length) * sScaleX));
+	  	cur_x -= llmin(scaled_max_pixels, ll_round(run.mWidth * sScaleX));
 		break;
 	case HCENTER:
-	    cur_x -= llmin(scaled_max_pixels, ll_round(getWidthF32(wstr.c_str(), begin_offset, length) * sScaleX)) / 2;
+	    cur_x -= llmin(scaled_max_pixels, ll_round(run.mWidth * sScaleX)) / 2;
 		break;
 	default:
 		break;
 	}
 
-	cur_render_y = cur_y;
-	cur_render_x = cur_x;
+	base_x = floorf(cur_x);
 
 	F32 start_x = (F32)ll_round(cur_x);
+	BOOL draw_ellipses = run.mDrawEllipses;
 
 	const LLFontBitmapCache* font_bitmap_cache = mFontFreetype->getFontBitmapCache();
 
-	F32 inv_width = 1.f / font_bitmap_cache->getBitmapWidth();
-	F32 inv_height = 1.f / font_bitmap_cache->getBitmapHeight();
-
-	const S32 LAST_CHARACTER = LLFontFreetype::LAST_CHAR_FULL;
-
-	BOOL draw_ellipses = FALSE;
-	if (use_ellipses)
-	{
-		// check for too long of a string
-		S32 string_width = ll_round(getWidthF32(wstr.c_str(), begin_offset, max_chars) * sScaleX);
-		if (string_width > scaled_max_pixels)
-		{
-			// use four dots for ellipsis width to generate padding
-			const LLWString dots(utf8str_to_wstring(std::string("....")));
-			scaled_max_pixels = llmax(0, scaled_max_pixels - ll_round(getWidthF32(dots.c_str())));
-			draw_ellipses = TRUE;
-		}
-	}
-
-	const LLFontGlyphInfo* next_glyph = NULL;
-
 	const S32 GLYPH_BATCH_SIZE = 30;
 	LLVector3 vertices[GLYPH_BATCH_SIZE * 4];
 	LLVector2 uvs[GLYPH_BATCH_SIZE * 4];
@@ -279,24 +275,10 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 
 	std::pair<EFontGlyphType, S32> bitmap_entry = std::make_pair(EFontGlyphType::Grayscale, -1);
 	S32 glyph_count = 0;
-	for (i = begin_offset; i < begin_offset + length; i++)
+	for (const GlyphRun::Glyph& glyph : run.mGlyphs)
 	{
-		llwchar wch = wstr[i];
-
-		const LLFontGlyphInfo* fgi = next_glyph;
-		next_glyph = NULL;
-		if(!fgi)
-		{
-			fgi = mFontFreetype->getGlyphInfo(wch, (!use_color) ? EFontGlyphType::Grayscale : EFontGlyphType::Color);
-		}
-		if (!fgi)
-		{
-			LL_ERRS() << "Missing Glyph Info" << LL_ENDL;
-			break;
-		}
 		// Per-glyph bitmap texture.
-		std::pair<EFontGlyphType, S32> next_bitmap_entry = fgi->mBitmapEntry;
-		if (next_bitmap_entry != bitmap_entry)
+		if (glyph.mBitmapEntry != bitmap_entry)
 		{
 			// Actually draw the queued glyphs before switching their texture;
 			// otherwise the queued glyphs will be taken from wrong textures.
@@ -310,29 +292,11 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 				glyph_count = 0;
 			}
 
-			bitmap_entry = next_bitmap_entry;
+			bitmap_entry = glyph.mBitmapEntry;
 			LLImageGL* font_image = font_bitmap_cache->getImageGL(bitmap_entry.first, bitmap_entry.second);
 			gGL.getTexUnit(0)->bind(font_image);
 		}
-	
-		if ((start_x + scaled_max_pixels) < (cur_x + fgi->mXBearing + fgi->mWidth))
-		{
-			// Not enough room for this character.
-			break;
-		}
 
-		// Draw the text at the appropriate location
-		//Specify vertices and texture coordinates
-		LLRectf uv_rect((fgi->mXBitmapOffset) * inv_width,
-				(fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
-				(fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
-				(fgi->mYBitmapOffset - PAD_UVY) * inv_height);
-		// snap glyph origin to whole screen pixel
-		LLRectf screen_rect((F32)ll_round(cur_render_x + (F32)fgi->mXBearing),
-				    (F32)ll_round(cur_render_y + (F32)fgi->mYBearing),
-				    (F32)ll_round(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
-				    (F32)ll_round(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
-		
 		if (glyph_count >= GLYPH_BATCH_SIZE)
 		{
 			gGL.begin(LLRender::QUADS);
@@ -344,30 +308,13 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 			glyph_count = 0;
 		}
 
-		drawGlyph(glyph_count, vertices, uvs, colors, screen_rect, uv_rect, (bitmap_entry.first == EFontGlyphType::Grayscale) ? text_color : LLColor4U::white, style_to_add, shadow, drop_shadow_strength);
-
-		chars_drawn++;
-		cur_x += fgi->mXAdvance;
-		cur_y += fgi->mYAdvance;
-
-		llwchar next_char = wstr[i+1];
-		if (next_char && (next_char < LAST_CHARACTER))
-		{
-			// Kern this puppy.
-			next_glyph = mFontFreetype->getGlyphInfo(next_char, (!use_color) ? EFontGlyphType::Grayscale : EFontGlyphType::Color);
-			cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
-		}
-
-		// Round after kerning.
-		// Must do this to cur_x, not just to cur_render_x, otherwise you
-		// will squish sub-pixel kerned characters too close together.
-		// For example, "CCCCC" looks bad.
-		cur_x = (F32)ll_round(cur_x);
-		//cur_y = (F32)ll_round(cur_y);
-
-		cur_render_x = cur_x;
-		cur_render_y = cur_y;
+		LLRectf screen_rect(glyph.mScreenRect);
+		screen_rect.translate(base_x, base_y);
+		drawGlyph(glyph_count, vertices, uvs, colors, screen_rect, glyph.mUVRect, (bitmap_entry.first == EFontGlyphType::Grayscale) ? text_color : LLColor4U::white, style_to_add, shadow, drop_shadow_strength);
 	}
+	chars_drawn = run.mCharsDrawn;
+	cur_x = base_x + run.mEndX;
+	cur_y = base_y + run.mEndY;
 
 	gGL.begin(LLRender::QUADS);
 	{
@@ -1205,6 +1152,175 @@ LLFontGL &LLFontGL::operator=(const LLFontGL &source)
 	return *this;
 }
 
+const LLFontGL::GlyphRun& LLFontGL::getGlyphRun(const LLWString& wstr, S32 begin_offset, S32 length, S32 max_chars, S32 scaled_max_pixels,
+												  F32 start_x, F32 start_y, BOOL use_ellipses, BOOL use_color) const
+{
+	const S32 MAX_GLYPH_RUNS = 512;
+	const LLFontBitmapCache* font_bitmap_cache = mFontFreetype->getFontBitmapCache();
+	const U32 generation = font_bitmap_cache->getGeneration();
+
+	// Kerning looks at the character after the last one drawn
+	const S32 text_length = llmin(length + 1, (S32)wstr.length() - begin_offset);
+	const llwchar* text = wstr.c_str() + begin_offset;
+
+	U64 hash = 14695981039346656037ULL;
+	auto hash_in = [&hash](U64 value)
+	{
+		hash = (hash ^ value) * 1099511628211ULL;
+	};
+	for (S32 i = 0; i < text_length; ++i)
+	{
+		hash_in(text[i]);
+	}
+	U32 bits;
+	memcpy(&bits, &start_x, sizeof(bits));
+	hash_in(bits);
+	memcpy(&bits, &start_y, sizeof(bits));
+	hash_in(bits);
+	memcpy(&bits, &sScaleX, sizeof(bits));
+	hash_in(bits);
+	hash_in((U64)(U32)length);
+	hash_in((U64)(U32)scaled_max_pixels);
+	hash_in((use_ellipses ? 2 : 0) | (use_color ? 1 : 0));
+
+	auto range = mGlyphRunIndex.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		glyph_run_list_t::iterator run_it = it->second;
+		if (run_it->mText.compare(0, LLWString::npos, text, text_length) == 0)
+		{
+			if (run_it->mGeneration != generation)
+			{
+				// glyphs moved in the bitmap cache, lay out again
+				mGlyphRunIndex.erase(it);
+				mGlyphRuns.erase(run_it);
+				break;
+			}
+			mGlyphRuns.splice(mGlyphRuns.begin(), mGlyphRuns, run_it);
+			return *run_it;
+		}
+	}
+
+	if ((S32)mGlyphRuns.size() >= MAX_GLYPH_RUNS)
+	{
+		// drop the least recently used
+		glyph_run_list_t::iterator oldest = --mGlyphRuns.end();
+		auto oldest_range = mGlyphRunIndex.equal_range(oldest->mHash);
+		for (auto it = oldest_range.first; it != oldest_range.second; ++it)
+		{
+			if (it->second == oldest)
+			{
+				mGlyphRunIndex.erase(it);
+				break;
+			}
+		}
+		mGlyphRuns.erase(oldest);
+	}
+
+	mGlyphRuns.emplace_front();
+	GlyphRun& run = mGlyphRuns.front();
+	mGlyphRunIndex.emplace(hash, mGlyphRuns.begin());
+	run.mHash = hash;
+	run.mText.assign(text, text_length);
+	run.mGeneration = generation;
+	run.mWidth = getWidthF32(wstr.c_str(), begin_offset, length);
+	run.mMaxPixels = scaled_max_pixels;
+	run.mDrawEllipses = false;
+
+	if (use_ellipses)
+	{
+		// check for too long of a string
+		S32 string_width = ll_round(getWidthF32(wstr.c_str(), begin_offset, max_chars) * sScaleX);
+		if (string_width > run.mMaxPixels)
+		{
+			// use four dots for ellipsis width to generate padding
+			const LLWString dots(utf8str_to_wstring(std::string("....")));
+			run.mMaxPixels = llmax(0, run.mMaxPixels - ll_round(getWidthF32(dots.c_str())));
+			run.mDrawEllipses = true;
+		}
+	}
+
+	F32 inv_width = 1.f / font_bitmap_cache->getBitmapWidth();
+	F32 inv_height = 1.f / font_bitmap_cache->getBitmapHeight();
+
+	const S32 LAST_CHARACTER = LLFontFreetype::LAST_CHAR_FULL;
+
+	F32 cur_x = start_x;
+	F32 cur_y = start_y;
+	F32 cur_render_x = cur_x;
+	F32 cur_render_y = cur_y;
+	F32 first_x = (F32)ll_round(cur_x);
+	S32 chars_drawn = 0;
+
+	const LLFontGlyphInfo* next_glyph = NULL;
+	for (S32 i = begin_offset; i < begin_offset + length; i++)
+	{
+		llwchar wch = wstr[i];
+
+		const LLFontGlyphInfo* fgi = next_glyph;
+		next_glyph = NULL;
+		if(!fgi)
+		{
+			fgi = mFontFreetype->getGlyphInfo(wch, (!use_color) ? EFontGlyphType::Grayscale : EFontGlyphType::Color);
+		}
+		if (!fgi)
+		{
+			LL_ERRS() << "Missing Glyph Info" << LL_ENDL;
+			break;
+		}
+
+		if ((first_x + run.mMaxPixels) < (cur_x + fgi->mXBearing + fgi->mWidth))
+		{
+			// Not enough room for this character.
+			break;
+		}
+
+		GlyphRun::Glyph glyph;
+		glyph.mBitmapEntry = fgi->mBitmapEntry;
+		// Specify vertices and texture coordinates
+		glyph.mUVRect = LLRectf((fgi->mXBitmapOffset) * inv_width,
+				(fgi->mYBitmapOffset + fgi->mHeight + PAD_UVY) * inv_height,
+				(fgi->mXBitmapOffset + fgi->mWidth) * inv_width,
+				(fgi->mYBitmapOffset - PAD_UVY) * inv_height);
+		// snap glyph origin to whole screen pixel
+		glyph.mScreenRect = LLRectf((F32)ll_round(cur_render_x + (F32)fgi->mXBearing),
+				    (F32)ll_round(cur_render_y + (F32)fgi->mYBearing),
+				    (F32)ll_round(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
+				    (F32)ll_round(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
+		run.mGlyphs.push_back(glyph);
+
+		chars_drawn++;
+		cur_x += fgi->mXAdvance;
+		cur_y += fgi->mYAdvance;
+
+		llwchar next_char = wstr[i+1];
+		if (next_char && (next_char < LAST_CHARACTER))
+		{
+			// Kern this puppy.
+			next_glyph = mFontFreetype->getGlyphInfo(next_char, (!use_color) ? EFontGlyphType::Grayscale : EFontGlyphType::Color);
+			cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+		}
+
+		// Round after kerning.
+		// Must do this to cur_x, not just to cur_render_x, otherwise you
+		// will squish sub-pixel kerned characters too close together.
+		// For example, "CCCCC" looks bad.
+		cur_x = (F32)ll_round(cur_x);
+		//cur_y = (F32)ll_round(cur_y);
+
+		cur_render_x = cur_x;
+		cur_render_y = cur_y;
+	}
+
+	run.mCharsDrawn = chars_drawn;
+	run.mEndX = cur_x;
+	run.mEndY = cur_y;
+
+	// getGlyphInfo() may have rendered new glyphs, but that only resets the
+	// bitmap cache when it starts over, which the next lookup will notice.
+	return run;
+}
+
 void LLFontGL::renderQuad(LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, F32 slant_amt) const
 {
 	S32 index = 0;
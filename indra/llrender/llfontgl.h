@@ -29,12 +29,16 @@
 #define LL_LLFONTGL_H
 
 #include "llcoord.h"
+#include "llfontbitmapcache.h"
 #include "llfontregistry.h"
 #include "llimagegl.h"
 #include "llpointer.h"
 #include "llrect.h"
 #include "v2math.h"
 
+#include <list>
+#include <unordered_map>
+
 class LLColor4;
 // Key used to request a font.
 class LLFontDescriptor;
@@ -236,6 +240,38 @@ private:
 	LLFontDescriptor mFontDescriptor;
 	LLPointer<LLFontFreetype> mFontFreetype;
 
+	// Glyph positions of one rendered string, relative to the whole pixel
+	// the string starts on, ready to be offset and turned into quads.
+	struct GlyphRun
+	{
+		struct Glyph
+		{
+			LLRectf mScreenRect;
+			LLRectf mUVRect;
+			std::pair<EFontGlyphType, S32> mBitmapEntry;
+		};
+
+		U64			mHash;
+		LLWString	mText;			// the characters laid out, plus the one after them (kerning)
+		U32			mGeneration;	// of the font bitmap cache the glyphs are in
+		std::vector<Glyph> mGlyphs;
+		S32			mCharsDrawn;
+		F32			mEndX;
+		F32			mEndY;
+		F32			mWidth;			// unscaled width of the whole string
+		S32			mMaxPixels;		// after reserving room for ellipses
+		bool		mDrawEllipses;
+	};
+	typedef std::list<GlyphRun> glyph_run_list_t;
+
+	const GlyphRun& getGlyphRun(const LLWString& wstr, S32 begin_offset, S32 length, S32 max_chars, S32 scaled_max_pixels,
+								F32 start_x, F32 start_y, BOOL use_ellipses, BOOL use_color) const;
+
+	// Most recently used first. Text drawn unchanged frame after frame is
+	// laid out once.
+	mutable glyph_run_list_t mGlyphRuns;
+	mutable std::unordered_multimap<U64, glyph_run_list_t::iterator> mGlyphRunIndex;
+
 	void renderQuad(LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, F32 slant_amt) const;
 	void drawGlyph(S32& glyph_count, LLVector3* vertex_out, LLVector2* uv_out, LLColor4U* colors_out, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4U& color, U8 style, ShadowType shadow, F32 drop_shadow_fade) const;
 
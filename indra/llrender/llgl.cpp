@@ -32,6 +32,7 @@
 #include "linden_common.h"
 
 #include "boost/tokenizer.hpp"
+#include <algorithm>
 
 #include "llsys.h"
 
@@ -1161,6 +1162,45 @@ bool LLGLManager::initGL()
 	// This is called here because it depends on the setting of mIsGF2or4MX, and sets up mHasMultitexture.
 	initExtensions();
 
+#if !LL_DARWIN && !LL_MESA_HEADLESS
+    // GL_KHR_parallel_shader_compile lets glLinkProgram return right away and
+    // GL_COMPLETION_STATUS_KHR be polled without blocking, but only once the
+    // driver has been told how many threads it may use
+    if (glGetStringi)
+    {
+        bool has_khr = false;
+        bool has_arb = false;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            std::string ext = ll_safe_string((const char*) glGetStringi(GL_EXTENSIONS, i));
+            has_khr = has_khr || ext == "GL_KHR_parallel_shader_compile";
+            has_arb = has_arb || ext == "GL_ARB_parallel_shader_compile";
+            mHasNVXGPUMemoryInfo = mHasNVXGPUMemoryInfo || ext == "GL_NVX_gpu_memory_info";
+            mHasATIMemInfo = mHasATIMemInfo || ext == "GL_ATI_meminfo";
+        }
+
+        typedef void (APIENTRYP max_compiler_threads_proc) (GLuint count);
+        max_compiler_threads_proc max_compiler_threads = nullptr;
+        if (has_khr)
+        {
+            max_compiler_threads = (max_compiler_threads_proc)GLH_EXT_GET_PROC_ADDRESS("glMaxShaderCompilerThreadsKHR");
+        }
+        else if (has_arb)
+        {
+            max_compiler_threads = (max_compiler_threads_proc)GLH_EXT_GET_PROC_ADDRESS("glMaxShaderCompilerThreadsARB");
+        }
+
+        if (max_compiler_threads)
+        {
+            // 0xFFFFFFFF is "as many as the implementation likes"
+            max_compiler_threads(0xFFFFFFFF);
+            mHasParallelShaderCompile = true;
+        }
+    }
+#endif
+
 	S32 old_vram = mVRAM;
 	mVRAM = 0;
 
@@ -1237,6 +1277,22 @@ bool LLGLManager::initGL()
 	return true;
 }
 
+S32 LLGLManager::getFreeVRAMMegabytes()
+{
+    // both report KB, GL_TEXTURE_FREE_MEMORY_ATI as the total free and three
+    // more numbers after it
+    GLint free_kb[4] = { -1, -1, -1, -1 };
+    if (mHasNVXGPUMemoryInfo)
+    {
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, free_kb);
+    }
+    else if (mHasATIMemInfo)
+    {
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, free_kb);
+    }
+    return free_kb[0] < 0 ? -1 : free_kb[0] / 1024;
+}
+
 void LLGLManager::getGLInfo(LLSD& info)
 {
 	if (gHeadlessClient)
@@ -1391,6 +1447,22 @@ void LLGLManager::initExtensions()
     mHasCubeMapArray = mGLVersion >= 3.99f; 
     mHasTransformFeedback = mGLVersion >= 3.99f;
     mHasDebugOutput = mGLVersion >= 4.29f;
+    mHasBufferStorage = mGLVersion >= 4.39f;
+
+    // S3TC is an extension, but one every desktop driver has, and the list of
+    // compressed formats can be queried without walking the extension strings
+    {
+        GLint num_formats = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &num_formats);
+        std::vector<GLint> formats(llmax(num_formats, 0));
+        if (num_formats > 0)
+        {
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        }
+        bool has_dxt1 = std::find(formats.begin(), formats.end(), GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) != formats.end();
+        bool has_dxt5 = std::find(formats.begin(), formats.end(), GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) != formats.end();
+        mHasS3TC = has_dxt1 && has_dxt5;
+    }
 
     // Misc
 	glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, (GLint*) &mGLMaxVertexRange);
@@ -2468,21 +2540,28 @@ void LLGLState::setEnabled(S32 enabled)
 	{
 		return;
 	}
+	LLGLboolean& cur_state = sStateMap[mState];
 	if (enabled == CURRENT_STATE)
 	{
-		enabled = sStateMap[mState] == GL_TRUE ? TRUE : FALSE;
+		enabled = cur_state == GL_TRUE ? TRUE : FALSE;
 	}
-	else if (enabled == TRUE && sStateMap[mState] != GL_TRUE)
+	else if (enabled == TRUE && cur_state != GL_TRUE)
 	{
 		gGL.flush();
 		glEnable(mState);
-		sStateMap[mState] = GL_TRUE;
+		cur_state = GL_TRUE;
+		LLRender::countStateChange(LLRender::SC_CAPABILITY, true);
 	}
-	else if (enabled == FALSE && sStateMap[mState] != GL_FALSE)
+	else if (enabled == FALSE && cur_state != GL_FALSE)
 	{
 		gGL.flush();
 		glDisable(mState);
-		sStateMap[mState] = GL_FALSE;
+		cur_state = GL_FALSE;
+		LLRender::countStateChange(LLRender::SC_CAPABILITY, true);
+	}
+	else
+	{
+		LLRender::countStateChange(LLRender::SC_CAPABILITY, false);
 	}
 	mIsEnabled = enabled;
 }
@@ -2521,6 +2600,7 @@ LLGLState::~LLGLState()
 				sStateMap[mState] = GL_FALSE;
 			}
 		}
+		LLRender::countStateChange(LLRender::SC_CAPABILITY, mIsEnabled != mWasEnabled);
 	}
 }
 
@@ -2735,6 +2815,7 @@ LLGLDepthTest::LLGLDepthTest(GLboolean depth_enabled, GLboolean write_enabled, G
 		write_enabled = FALSE;
 	}
 
+	LLRender::countStateChange(LLRender::SC_DEPTH, depth_enabled != sDepthEnabled);
 	if (depth_enabled != sDepthEnabled)
 	{
 		gGL.flush();
@@ -2742,12 +2823,14 @@ LLGLDepthTest::LLGLDepthTest(GLboolean depth_enabled, GLboolean write_enabled, G
 		else glDisable(GL_DEPTH_TEST);
 		sDepthEnabled = depth_enabled;
 	}
+	LLRender::countStateChange(LLRender::SC_DEPTH, depth_func != sDepthFunc);
 	if (depth_func != sDepthFunc)
 	{
 		gGL.flush();
 		glDepthFunc(depth_func);
 		sDepthFunc = depth_func;
 	}
+	LLRender::countStateChange(LLRender::SC_DEPTH, write_enabled != sWriteEnabled);
 	if (write_enabled != sWriteEnabled)
 	{
 		gGL.flush();
@@ -2759,6 +2842,7 @@ LLGLDepthTest::LLGLDepthTest(GLboolean depth_enabled, GLboolean write_enabled, G
 LLGLDepthTest::~LLGLDepthTest()
 {
 	checkState();
+	LLRender::countStateChange(LLRender::SC_DEPTH, sDepthEnabled != mPrevDepthEnabled);
 	if (sDepthEnabled != mPrevDepthEnabled )
 	{
 		gGL.flush();
@@ -2766,12 +2850,14 @@ LLGLDepthTest::~LLGLDepthTest()
 		else glDisable(GL_DEPTH_TEST);
 		sDepthEnabled = mPrevDepthEnabled;
 	}
+	LLRender::countStateChange(LLRender::SC_DEPTH, sDepthFunc != mPrevDepthFunc);
 	if (sDepthFunc != mPrevDepthFunc)
 	{
 		gGL.flush();
 		glDepthFunc(mPrevDepthFunc);
 		sDepthFunc = mPrevDepthFunc;
 	}
+	LLRender::countStateChange(LLRender::SC_DEPTH, sWriteEnabled != mPrevWriteEnabled);
 	if (sWriteEnabled != mPrevWriteEnabled )
 	{
 		gGL.flush();
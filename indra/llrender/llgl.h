@@ -92,10 +92,15 @@ public:
 	bool mHasCubeMapArray = false;
 	bool mHasDebugOutput = false;
     bool mHasTransformFeedback = false;
+    bool mHasBufferStorage = false;
     bool mHasAnisotropic = false;
+    bool mHasS3TC = false;      // DXT1 and DXT5 are in GL_COMPRESSED_TEXTURE_FORMATS
+    bool mHasParallelShaderCompile = false; // GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
 	
 	// Vendor-specific extensions
     bool mHasAMDAssociations = false;
+    bool mHasNVXGPUMemoryInfo = false;  // GL_NVX_gpu_memory_info
+    bool mHasATIMemInfo = false;        // GL_ATI_meminfo
 
 	BOOL mIsAMD;
 	BOOL mIsNVIDIA;
@@ -119,6 +124,10 @@ public:
 	std::string mGLVersionString;
 
 	S32 mVRAM; // VRAM in MB
+
+	// Video memory free right now in MB, from GL_NVX_gpu_memory_info or
+	// GL_ATI_meminfo.  -1 when the driver doesn't say.
+	S32 getFreeVRAMMegabytes();
 	
 	void getPixelFormat(); // Get the best pixel format
 
@@ -1060,6 +1060,12 @@ extern void glGetBufferPointervARB (GLenum, GLenum, GLvoid* *);
 #define GL_RENDERBUFFER_FREE_MEMORY_ATI            0x87FD
 #endif
 
+//GL_KHR_parallel_shader_compile constants (GL_ARB_parallel_shader_compile uses the same values)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR         0x91B0
+#define GL_COMPLETION_STATUS_KHR                   0x91B1
+#endif
+
 #if defined(TRACY_ENABLE) && LL_PROFILER_ENABLE_TRACY_OPENGL
     #include <tracy/TracyOpenGL.hpp>
 #endif
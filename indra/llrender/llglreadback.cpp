@@ -0,0 +1,208 @@
+/**
+ * @file llglreadback.cpp
+ * @brief Asynchronous framebuffer readback through pixel buffer objects
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llglreadback.h"
+
+LLGLReadback::LLGLReadback(U32 num_slots)
+	: mSlots(llmax(num_slots, 1U))
+{
+}
+
+LLGLReadback::~LLGLReadback()
+{
+	// GL resources must be freed with release() while the context is alive
+	llassert(!isPending());
+}
+
+S32 LLGLReadback::read(S32 x, S32 y, U32 width, U32 height, U32 format, U32 type)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	Slot& slot = mSlots[mNext];
+	if (slot.mFence || width == 0 || height == 0)
+	{
+		return -1;
+	}
+
+	U32 pixel_size = getPixelSize(format, type);
+	U32 size = width * height * pixel_size;
+
+	if (!slot.mBuffer)
+	{
+		glGenBuffers(1, &slot.mBuffer);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.mBuffer);
+	if (slot.mBufferSize < size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.mBufferSize = size;
+	}
+	glReadPixels(x, y, width, height, format, type, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.mWidth = width;
+	slot.mHeight = height;
+	slot.mPixelSize = pixel_size;
+	stop_glerror();
+
+	S32 ret = (S32)mNext;
+	mNext = (mNext + 1) % mSlots.size();
+	return ret;
+}
+
+bool LLGLReadback::isFull() const
+{
+	return mSlots[mNext].mFence != nullptr;
+}
+
+bool LLGLReadback::isPending() const
+{
+	for (const Slot& slot : mSlots)
+	{
+		if (slot.mFence)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+U32 LLGLReadback::poll(const callback_t& callback, bool wait)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	U32 count = 0;
+	bool block = wait;
+	U32 num_slots = (U32)mSlots.size();
+	for (U32 i = 0; i < num_slots; ++i)
+	{
+		U32 index = (mNext + i) % num_slots;
+		Slot& slot = mSlots[index];
+		if (!slot.mFence)
+		{
+			continue;
+		}
+
+		GLenum status;
+		if (block)
+		{
+			// flush so the fence is guaranteed to signal eventually
+			status = glClientWaitSync(slot.mFence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			block = false;
+		}
+		else
+		{
+			status = glClientWaitSync(slot.mFence, 0, 0);
+			if (status == GL_TIMEOUT_EXPIRED)
+			{
+				continue;
+			}
+		}
+
+		glDeleteSync(slot.mFence);
+		slot.mFence = nullptr;
+
+		if (status == GL_WAIT_FAILED)
+		{
+			continue;
+		}
+
+		U32 size = slot.mWidth * slot.mHeight * slot.mPixelSize;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.mBuffer);
+		const U8* data = (const U8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+		if (data)
+		{
+			callback((S32)index, data, slot.mWidth, slot.mHeight);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			++count;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	return count;
+}
+
+void LLGLReadback::release()
+{
+	for (Slot& slot : mSlots)
+	{
+		if (slot.mFence)
+		{
+			glDeleteSync(slot.mFence);
+			slot.mFence = nullptr;
+		}
+		if (slot.mBuffer)
+		{
+			glDeleteBuffers(1, &slot.mBuffer);
+			slot.mBuffer = 0;
+		}
+		slot.mBufferSize = 0;
+	}
+	mNext = 0;
+}
+
+//static
+U32 LLGLReadback::getPixelSize(U32 format, U32 type)
+{
+	U32 components = 4;
+	switch (format)
+	{
+	case GL_RED:
+	case GL_DEPTH_COMPONENT:
+		components = 1;
+		break;
+	case GL_RG:
+		components = 2;
+		break;
+	case GL_RGB:
+		components = 3;
+		break;
+	default:
+		break;
+	}
+
+	U32 bytes = 1;
+	switch (type)
+	{
+	case GL_HALF_FLOAT:
+	case GL_UNSIGNED_SHORT:
+		bytes = 2;
+		break;
+	case GL_FLOAT:
+	case GL_UNSIGNED_INT:
+		bytes = 4;
+		break;
+	default:
+		break;
+	}
+
+	// GL_PACK_ALIGNMENT is 1 (see LLRender::init), so rows are not padded
+	return components * bytes;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file llglreadback.h
+ * @brief Asynchronous framebuffer readback through pixel buffer objects
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLGLREADBACK_H
+#define LL_LLGLREADBACK_H
+
+#include "llgl.h"
+
+#include <functional>
+#include <vector>
+
+/*
+ Reads pixels from the bound read framebuffer into a ring of pixel buffer
+ objects. read() only queues the copy and drops a fence behind it, so the
+ GPU is never drained to hand the pixels back; poll() maps whichever copies
+ have finished, usually a frame or two later. Each slot can be tagged by the
+ caller with whatever state the pixels were rendered with, keyed by the slot
+ index read() returns.
+
+ SAMPLE USAGE:
+
+	S32 slot = readback.read(0, 0, w, h, GL_RED, GL_FLOAT);
+	if (slot >= 0)
+	{
+		mViewProj[slot] = view_proj;
+	}
+	...
+	readback.poll([this](S32 slot, const U8* data, U32 width, U32 height)
+		{
+			use((const F32*) data, width, height, mViewProj[slot]);
+		});
+*/
+class LLGLReadback
+{
+public:
+	typedef std::function<void(S32 slot, const U8* data, U32 width, U32 height)> callback_t;
+
+	// num_slots is the most readbacks that may be in flight at once
+	LLGLReadback(U32 num_slots);
+	~LLGLReadback();
+
+	// Queue a copy of the given rectangle of the bound read framebuffer.
+	// Returns the slot it went to, or -1 if every slot is still in flight.
+	S32 read(S32 x, S32 y, U32 width, U32 height, U32 format, U32 type);
+
+	// true if the next read() would fail for lack of a free slot
+	bool isFull() const;
+
+	// true if any read is still waiting to be picked up by poll()
+	bool isPending() const;
+
+	// Hand finished readbacks to callback, oldest first, and free their
+	// slots. With wait set, first blocks until the oldest one in flight has
+	// finished, for callers that need a slot or the pixels right now.
+	// Returns the number of readbacks handed over.
+	U32 poll(const callback_t& callback, bool wait = false);
+
+	// drop anything in flight and free the buffers
+	void release();
+
+	// bytes per pixel of a glReadPixels format and type pair
+	static U32 getPixelSize(U32 format, U32 type);
+
+private:
+	struct Slot
+	{
+		U32 mBuffer = 0;
+		U32 mBufferSize = 0;
+		GLsync mFence = nullptr;
+		U32 mWidth = 0;
+		U32 mHeight = 0;
+		U32 mPixelSize = 0;
+	};
+
+	std::vector<Slot> mSlots;
+	// slot the next read() goes to, slots after it are older
+	U32 mNext = 0;
+};
+
+#endif // LL_LLGLREADBACK_H
@@ -334,6 +334,12 @@ void LLGLSLShader::unloadInternal()
 {
     sInstances.erase(this);
 
+    if (mLinkPending)
+    { // don't pull the program out from under the link thread
+        LLShaderMgr::instance()->waitForLink(this);
+        mLinkPending = false;
+    }
+
     stop_glerror();
     mAttribute.clear();
     mTexture.clear();
@@ -451,6 +457,30 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString>* attributes,
         unloadInternal();
         return FALSE;
     }
+
+    // Binary programs are already linked, and only shaders with nothing extra
+    // to map can have the mapping put off until the link is done
+    if (success && !mUsingBinaryProgram && !attributes && !uniforms && !varying_count)
+    {
+        bindReservedAttributes();
+        if (LLShaderMgr::instance()->startAsyncLink(this))
+        {
+            mLinkPending = true;
+            return TRUE;
+        }
+    }
+
+    if (success && !mUsingBinaryProgram && varying_count > 0 && varyings)
+    {
+        // outputs captured by transform feedback have to be named before linking
+        glTransformFeedbackVaryings(mProgramObject, varying_count, varyings, GL_INTERLEAVED_ATTRIBS);
+    }
+
+    return finishCreateShader(attributes, uniforms, success);
+}
+
+BOOL LLGLSLShader::finishCreateShader(std::vector<LLStaticHashedString>* attributes, std::vector<LLStaticHashedString>* uniforms, BOOL success)
+{
     // Map attributes and uniforms
     if (success)
     {
@@ -602,6 +632,15 @@ void LLGLSLShader::attachObjects(GLuint* objects, S32 count)
     }
 }
 
+void LLGLSLShader::bindReservedAttributes()
+{
+    for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+    {
+        const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
+        glBindAttribLocation(mProgramObject, i, (const GLchar*)name);
+    }
+}
+
 BOOL LLGLSLShader::mapAttributes(const std::vector<LLStaticHashedString>* attributes)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
@@ -610,11 +649,7 @@ BOOL LLGLSLShader::mapAttributes(const std::vector<LLStaticHashedString>* attrib
 	if (!mUsingBinaryProgram)
 	{
 		//before linking, make sure reserved attributes always have consistent locations
-		for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
-		{
-			const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
-			glBindAttribLocation(mProgramObject, i, (const GLchar*)name);
-		}
+		bindReservedAttributes();
 
 		//link the program
 		res = link();
@@ -994,6 +1029,33 @@ BOOL LLGLSLShader::mapUniforms(const vector<LLStaticHashedString>* uniforms)
             glUniformBlockBinding(mProgramObject, UBOBlockIndex, BLOCKBINDING);
         }
     }
+
+    if (mFeatures.hasInstancedSkinning)
+    {
+        GLuint block_index = glGetUniformBlockIndex(mProgramObject, "SkinInstances");
+        if (block_index != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(mProgramObject, block_index, SKIN_INSTANCES_BINDING);
+        }
+    }
+
+    if (mFeatures.hasInstanceTransforms)
+    {
+        GLuint block_index = glGetUniformBlockIndex(mProgramObject, "InstanceTransforms");
+        if (block_index != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(mProgramObject, block_index, INSTANCE_TRANSFORMS_BINDING);
+        }
+    }
+
+    {
+        // any shader that links the atmospherics functions has this block when ATMOSPHERICS_UBO is defined
+        GLuint block_index = glGetUniformBlockIndex(mProgramObject, "AtmosphericsUniforms");
+        if (block_index != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(mProgramObject, block_index, ATMOSPHERICS_BINDING);
+        }
+    }
     unbind();
 
     LL_DEBUGS("ShaderUniform") << "Total Uniform Size: " << mTotalUniformSize << LL_ENDL;
@@ -1020,10 +1082,52 @@ BOOL LLGLSLShader::link(BOOL suppress_errors)
     return success;
 }
 
+BOOL LLGLSLShader::finishLink()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+    llassert(mLinkPending);
+
+    LLShaderMgr* mgr = LLShaderMgr::instance();
+    mgr->waitForLink(this);
+    mLinkPending = false;
+
+    BOOL success = mgr->checkLinkStatus(mProgramObject);
+    if (success)
+    {
+        mgr->saveCachedProgramBinary(this);
+
+        // as good as a binary program now, so mapAttributes won't link it again
+        mUsingBinaryProgram = true;
+        success = finishCreateShader(nullptr, nullptr, TRUE);
+    }
+
+    if (!success)
+    {
+        LL_SHADER_LOADING_WARNS() << "Background link failed for shader: " << mName << ", retrying synchronously" << LL_ENDL;
+
+        bool async_link = mgr->mAsyncLink;
+        mgr->mAsyncLink = false;
+        success = createShader(nullptr, nullptr);
+        mgr->mAsyncLink = async_link;
+
+        if (!success)
+        { // the loaders never got to pick a fallback for this one, have the application reload
+            mgr->mAsyncLinkFailed = true;
+        }
+    }
+
+    return success;
+}
+
 void LLGLSLShader::bind()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
 
+    if (mLinkPending && !finishLink())
+    {
+        return;
+    }
+
     llassert(mProgramObject != 0);
 
     gGL.flush();
@@ -1040,6 +1144,11 @@ void LLGLSLShader::bind()
         sCurBoundShaderPtr = this;
         placeProfileQuery();
         LLVertexBuffer::setupClientArrays(mAttributeMask);
+        LLRender::countStateChange(LLRender::SC_PROGRAM, true);
+    }
+    else
+    {
+        LLRender::countStateChange(LLRender::SC_PROGRAM, false);
     }
 
     if (mUniformsDirty)
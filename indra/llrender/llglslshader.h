@@ -27,6 +27,7 @@
 #ifndef LL_LLGLSLSHADER_H
 #define LL_LLGLSLSHADER_H
 
+#include "llatomic.h"
 #include "llgl.h"
 #include "llrender.h"
 #include "llstaticstringtable.h"
@@ -44,6 +45,8 @@ public:
     bool hasTransport = false; // implies no lighting (it's possible to have neither though)
     bool hasSkinning = false;
     bool hasObjectSkinning = false;
+    bool hasInstancedSkinning = false; // with hasObjectSkinning, joint palettes come per instance from the SkinInstances block
+    bool hasInstanceTransforms = false; // each instance of an instanced draw is placed by its matrix in the InstanceTransforms block
     bool hasAtmospherics = false;
     bool hasGamma = false;
     bool hasShadows = false;
@@ -252,6 +255,11 @@ public:
     S32 unbindTexture(S32 uniform, LLTexUnit::eTextureType mode = LLTexUnit::TT_TEXTURE);
 
     BOOL link(BOOL suppress_errors = FALSE);
+
+    // complete a createShader whose link was left running in the background
+    // (see LLShaderMgr::startAsyncLink), blocks until the link is done
+    BOOL finishLink();
+
     void bind();
     //helper to conditionally bind mRiggedVariant instead of this
     void bind(bool rigged);
@@ -317,15 +325,45 @@ public:
     // this pointer should be set to whichever shader represents this shader's rigged variant
     LLGLSLShader* mRiggedVariant = nullptr;
 
+    // set on a rigged variant to the shader that draws several instances of a
+    // rigged batch at once, each with its own palette (see hasInstancedSkinning)
+    LLGLSLShader* mSkinInstancedVariant = nullptr;
+
+    // uniform buffer binding point of the SkinInstances block
+    static const U32 SKIN_INSTANCES_BINDING = 2;
+
+    // uniform buffer binding point of the AtmosphericsUniforms block (see ATMOSPHERICS_UBO)
+    static const U32 ATMOSPHERICS_BINDING = 3;
+
+    // set to the shader that draws several copies of one vertex buffer at
+    // once, each with its own transform (see hasInstanceTransforms)
+    LLGLSLShader* mInstancedVariant = nullptr;
+
+    // uniform buffer binding point of the InstanceTransforms block
+    static const U32 INSTANCE_TRANSFORMS_BINDING = 4;
+
     // hacky flag used for optimization in LLDrawPoolAlpha
     bool mCanBindFast = false;
 
+    // true while mProgramObject is linking in the background, uniforms and
+    // attributes aren't mapped until finishLink
+    bool mLinkPending = false;
+
+    // set by LLShaderLinkThread once it's done with mProgramObject (null when the driver links in parallel)
+    std::shared_ptr<LLAtomicBool> mLinkDone;
+
 #ifdef LL_PROFILER_ENABLE_RENDER_DOC
     void setLabel(const char* label);
 #endif
 
 private:
     void unloadInternal();
+
+    // bind the reserved attributes to their fixed locations, must precede linking
+    void bindReservedAttributes();
+
+    // map attributes and uniforms of the linked program and finish setting up the shader
+    BOOL finishCreateShader(std::vector<LLStaticHashedString>* attributes, std::vector<LLStaticHashedString>* uniforms, BOOL success);
 };
 
 //UI shader (declared here so llui_libtest will link properly)
@@ -334,6 +372,8 @@ extern LLGLSLShader			gUIProgram;
 extern LLGLSLShader			gSolidColorProgram;
 //Alpha mask shader (declared here so llappearance can access properly)
 extern LLGLSLShader			gAlphaMaskProgram;
+//Avatar alpha gradient shader, see LLTexLayerParamAlpha::render()
+extern LLGLSLShader			gAlphaGradientProgram;
 
 #ifdef LL_PROFILER_ENABLE_RENDER_DOC
 #define LL_SET_SHADER_LABEL(shader) shader.setLabel(#shader)
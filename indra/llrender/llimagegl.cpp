@@ -34,6 +34,7 @@
 #include "llerror.h"
 #include "llfasttimer.h"
 #include "llimage.h"
+#include "llimagebc.h"
 
 #include "llmath.h"
 #include "llgl.h"
@@ -63,13 +64,10 @@ static U64 sTextureBytes = 0;
 
 // track a texture alloc on the currently bound texture.
 // asserts that no currently tracked alloc exists
-static void alloc_tex_image(U32 width, U32 height, U32 pixformat)
+static void alloc_tex_bytes(U64 size)
 {
     U32 texUnit = gGL.getCurrentTexUnitIndex();
     U32 texName = gGL.getTexUnit(texUnit)->getCurrTexture();
-    U64 size = LLImageGL::dataFormatBytes(pixformat, width, height);
-
-    llassert(size >= 0);
 
     sTexMemMutex.lock();
     llassert(sTextureAllocs.find(texName) == sTextureAllocs.end());
@@ -80,6 +78,15 @@ static void alloc_tex_image(U32 width, U32 height, U32 pixformat)
     sTexMemMutex.unlock();
 }
 
+static void alloc_tex_image(U32 width, U32 height, U32 pixformat)
+{
+    U64 size = LLImageGL::dataFormatBytes(pixformat, width, height);
+
+    llassert(size >= 0);
+
+    alloc_tex_bytes(size);
+}
+
 // track texture free on given texName
 static void free_tex_image(U32 texName)
 {
@@ -131,6 +138,7 @@ F32 LLImageGL::sLastFrameTime			= 0.f;
 BOOL LLImageGL::sAllowReadBackRaw       = FALSE ;
 LLImageGL* LLImageGL::sDefaultGLTexture = NULL ;
 bool LLImageGL::sCompressTextures = false;
+bool LLImageGL::sGPUTextureProcessing = false;
 std::set<LLImageGL*> LLImageGL::sImageList;
 
 
@@ -149,6 +157,36 @@ S32 LLImageGL::sMaxCategories = 1 ;
 //optimization for when we don't need to calculate mIsMask
 BOOL LLImageGL::sSkipAnalyzeAlpha;
 
+// Images at least this large have their alpha analyzed from a GPU generated
+// mip instead of the full resolution data when sGPUTextureProcessing is set.
+static const S32 GPU_ALPHA_MIN_PIXELS = 512 * 512;
+// Mip read back for alpha analysis, each level is a 2x2 box reduction of the last
+static const S32 GPU_ALPHA_READBACK_LEVEL = 2;
+
+namespace
+{
+	// An alpha readback in flight, owned by the main thread
+	struct AlphaReadback
+	{
+		LLImageGL* mImage;	// referenced until the readback is retired
+		U32 mBuffer;
+		GLsync mFence;
+		U32 mWidth;
+		U32 mHeight;
+		S32 mDiscardLevel;
+		U32 mSerial;
+	};
+
+	std::vector<AlphaReadback> sAlphaReadbacks;
+
+	void delete_alpha_readback(AlphaReadback& readback)
+	{
+		glDeleteSync(readback.mFence);
+		glDeleteBuffers(1, &readback.mBuffer);
+		readback.mImage->unref();
+	}
+}
+
 //------------------------
 //****************************************************************************************************
 //End for texture auditing use only
@@ -263,6 +301,13 @@ void LLImageGL::cleanupClass()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     LLImageGLThread::deleteSingleton();
+
+    for (AlphaReadback& readback : sAlphaReadbacks)
+    {
+        readback.mImage->mAlphaClassPending = false;
+        delete_alpha_readback(readback);
+    }
+    sAlphaReadbacks.clear();
 }
 
 
@@ -531,6 +576,12 @@ void LLImageGL::init(BOOL usemipmaps)
 	mNeedsAlphaAndPickMask = TRUE ;
 	mAlphaStride = 0 ;
 	mAlphaOffset = 0 ;
+	mAlphaClass = ALPHA_CLASS_UNKNOWN;
+	mAlphaClassDiscard = -1;
+	mKnownAlphaClass = ALPHA_CLASS_UNKNOWN;
+	mKnownAlphaDiscard = -1;
+	mAlphaClassPending = false;
+	mAlphaReadbackSerial = 0;
 
 	mGLTextureCreated = FALSE ;
 	mTexName = 0;
@@ -543,6 +594,8 @@ void LLImageGL::init(BOOL usemipmaps)
 	mTexelsInGLTexture = 0 ;
 
 	mAllowCompression = true;
+	mUseUnpackBuffer = false;
+	mUnpackBuffer = 0;
 	
 	mTarget = GL_TEXTURE_2D;
 	mBindTarget = LLTexUnit::TT_TEXTURE;
@@ -578,6 +631,11 @@ void LLImageGL::cleanup()
 	if (!gGLManager.mIsDisabled)
 	{
 		destroyGLTexture();
+		if (mUnpackBuffer)
+		{
+			glDeleteBuffers(1, &mUnpackBuffer);
+			mUnpackBuffer = 0;
+		}
 	}
 	freePickMask();
 
@@ -817,7 +875,11 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 		}
 		else if (!is_compressed)
 		{
-			if (mAutoGenMips)
+			if (mAutoGenMips && setTranscodedImage(data_in, getWidth(mCurrentDiscardLevel), getHeight(mCurrentDiscardLevel)))
+			{
+				stop_glerror();
+			}
+			else if (mAutoGenMips || (sGPUTextureProcessing && LLRender::sGLCoreProfile))
 			{
 				stop_glerror();
 				{
@@ -844,7 +906,6 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 								 w, h, 
 								 mFormatPrimary, mFormatType,
 								 data_in, mAllowCompression);
-					analyzeAlpha(data_in, w, h);
 					stop_glerror();
 
 					updatePickMask(w, h, data_in);
@@ -861,6 +922,11 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 						glGenerateMipmap(mTarget);
 					}	
 					stop_glerror();
+
+					if (!queueAlphaReadback(w, h))
+					{
+						analyzeAlpha(data_in, w, h);
+					}
 				}
 			}
 			else
@@ -1021,6 +1087,100 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 	return TRUE;
 }
 
+bool LLImageGL::setTranscodedImage(const U8* data_in, S32 w, S32 h)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+    // Encoding is too slow for the main thread, where the driver's own
+    // compression is the lesser evil. On the LLImageGLThread workers it
+    // replaces it: the driver's quality and speed vary wildly, and
+    // most can't generate mips for a compressed texture anyway.
+    if (!sCompressTextures || !mAllowCompression || !gGLManager.mHasS3TC || on_main_thread())
+    {
+        return false;
+    }
+    if (mTarget != GL_TEXTURE_2D || mFormatType != GL_UNSIGNED_BYTE || mFormatSwapBytes || w < 4 || h < 4)
+    {
+        return false;
+    }
+
+    bool srgb = false;
+    switch (mFormatInternal)
+    {
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_RGBA:
+    case GL_RGBA8:
+        break;
+    case GL_SRGB:
+    case GL_SRGB8:
+    case GL_SRGB_ALPHA:
+    case GL_SRGB8_ALPHA8:
+        srgb = true;
+        break;
+    default:
+        return false;
+    }
+    S32 components;
+    switch (mFormatPrimary)
+    {
+    case GL_RGB: components = 3; break;
+    case GL_RGBA: components = 4; break;
+    default: return false;
+    }
+
+    // BC1 blocks written by LLImageBC are always in four color mode, so the
+    // RGBA flavor of DXT1 samples as opaque
+    LLImageBC::EFormat bc_format = (components == 3 || LLImageBC::isOpaque(data_in, w, h)) ? LLImageBC::BC1 : LLImageBC::BC3;
+    GLenum gl_format;
+    if (bc_format == LLImageBC::BC1)
+    {
+        gl_format = srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    }
+    else
+    {
+        gl_format = srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+
+    std::vector<U8> encoded(LLImageBC::calcDataSize(bc_format, w, h));
+    std::vector<U8> mip[2];
+    const U8* level_data = data_in;
+    S32 level_w = w;
+    S32 level_h = h;
+    S32 level = 0;
+    free_cur_tex_image();
+    while (true)
+    {
+        S32 size = LLImageBC::calcDataSize(bc_format, level_w, level_h);
+        LLImageBC::encode(bc_format, level_data, level_w, level_h, components, encoded.data());
+        glCompressedTexImage2D(mTarget, level, gl_format, level_w, level_h, 0, size, encoded.data());
+        if (level == 0)
+        {
+            // same convention as setManualImage, only the top level counts
+            alloc_tex_bytes(size);
+        }
+
+        if (level_w == 1 && level_h == 1)
+        {
+            break;
+        }
+
+        std::vector<U8>& next = mip[level & 1];
+        next.resize(llmax(level_w / 2, 1) * llmax(level_h / 2, 1) * components);
+        LLImageBC::downsample(level_data, level_w, level_h, components, next.data());
+        level_data = next.data();
+        level_w = llmax(level_w / 2, 1);
+        level_h = llmax(level_h / 2, 1);
+        ++level;
+    }
+    stop_glerror();
+
+    mMipLevels = level;
+    analyzeAlpha(data_in, w, h);
+    updatePickMask(w, h, data_in);
+    return true;
+}
+
 BOOL LLImageGL::preAddToAtlas(S32 discard_level, const LLImageRaw* raw_image)
 {
 	//not compatible with core GL profile
@@ -1189,7 +1349,7 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
 	}
 	
 	// HACK: allow the caller to explicitly force the fast path (i.e. using glTexSubImage2D here instead of calling setImage) even when updating the full texture.
-	if (!force_fast_update && x_pos == 0 && y_pos == 0 && width == getWidth() && height == getHeight() && data_width == width && data_height == height)
+	if (!force_fast_update && !mUseUnpackBuffer && x_pos == 0 && y_pos == 0 && width == getWidth() && height == getHeight() && data_width == width && data_height == height)
 	{
 		setImage(datap, FALSE, tex_name);
 	}
@@ -1248,7 +1408,11 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
 		stop_glerror();
 
         const bool use_sub_image = should_stagger_image_set(isCompressed());
-        if (!use_sub_image)
+        if (mUseUnpackBuffer && !isCompressed() && setSubImageUnpackBuffer(sub_datap, data_width, x_pos, y_pos, width, height))
+        {
+            // queued from the unpack buffer, the driver copies it to the texture asynchronously
+        }
+        else if (!use_sub_image)
         {
             // *TODO: Why does this work here, in setSubImage, but not in
             // setManualImage? Maybe because it only gets called with the
@@ -1276,6 +1440,50 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
 	return TRUE;
 }
 
+// Copies just the updated rows into a freshly orphaned unpack buffer, so the driver hands
+// back new storage instead of waiting for the previous upload to drain, then sources the
+// texture update from the buffer. Expects the target texture to be bound.
+bool LLImageGL::setSubImageUnpackBuffer(const U8* sub_datap, S32 data_width, S32 x_pos, S32 y_pos, S32 width, S32 height)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    const S32 row_bytes = (width * getComponents() + 3) & ~3; // default GL_UNPACK_ALIGNMENT
+    const S32 src_stride = data_width * getComponents();
+    const S32 size = row_bytes * height;
+
+    if (!mUnpackBuffer)
+    {
+        glGenBuffers(1, &mUnpackBuffer);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mUnpackBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    U8* dst = (U8*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    for (S32 row = 0; row < height; ++row)
+    {
+        memcpy(dst + row * row_bytes, sub_datap + row * src_stride, width * getComponents());
+    }
+
+    bool res = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+    if (res)
+    {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexSubImage2D(mTarget, 0, x_pos, y_pos, width, height, mFormatPrimary, mFormatType, nullptr);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!res)
+    {
+        // buffer contents were lost, have the caller upload from client memory
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, data_width);
+    }
+    stop_glerror();
+    return res;
+}
+
 BOOL LLImageGL::setSubImage(const LLImageRaw* imageraw, S32 x_pos, S32 y_pos, S32 width, S32 height, BOOL force_fast_update /* = FALSE */, LLGLuint use_name)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
@@ -1499,7 +1707,24 @@ void LLImageGL::setManualImage(U32 target, S32 miplevel, S32 intformat, S32 widt
                 sub_image_lines(target, miplevel, 0, 0, width, height, pixformat, pixtype, src, width);
             }
         }
-        alloc_tex_image(width, height, pixformat);
+
+        GLint compressed = GL_FALSE;
+        if (compress && pixels)
+        {
+            glGetTexLevelParameteriv(target, miplevel, GL_TEXTURE_COMPRESSED, &compressed);
+        }
+        if (compressed)
+        {
+            // count what the driver actually allocated, or compressing
+            // wouldn't take any pressure off the VRAM budget
+            GLint compressed_size = 0;
+            glGetTexLevelParameteriv(target, miplevel, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+            alloc_tex_bytes(compressed_size);
+        }
+        else
+        {
+            alloc_tex_image(width, height, pixformat);
+        }
     }
     stop_glerror();
 
@@ -2089,6 +2314,12 @@ BOOL LLImageGL::getIsAlphaMask() const
 	return mIsMask;
 }
 
+void LLImageGL::setKnownAlphaClass(U8 alpha_class, S32 discard_level)
+{
+	mKnownAlphaClass = alpha_class;
+	mKnownAlphaDiscard = (S8)discard_level;
+}
+
 void LLImageGL::setTarget(const LLGLenum target, const LLTexUnit::eTextureType bind_target)
 {
 	mTarget = target;
@@ -2194,6 +2425,15 @@ void LLImageGL::analyzeAlpha(const void* data_in, U32 w, U32 h)
 		return ;
 	}
 
+	if (mKnownAlphaClass != ALPHA_CLASS_UNKNOWN && mKnownAlphaDiscard <= mCurrentDiscardLevel)
+	{
+		// already classified at this resolution or better
+		mIsMask = mKnownAlphaClass == ALPHA_CLASS_MASK;
+		mAlphaClass = mKnownAlphaClass;
+		mAlphaClassDiscard = mKnownAlphaDiscard;
+		return;
+	}
+
 	U32 length = w * h;
 	U32 alphatotal = 0;
 	
@@ -2286,6 +2526,104 @@ void LLImageGL::analyzeAlpha(const void* data_in, U32 w, U32 h)
 	{
 		mIsMask = TRUE;
 	}
+
+	mAlphaClass = mIsMask ? ALPHA_CLASS_MASK : ALPHA_CLASS_BLEND;
+	mAlphaClassDiscard = mCurrentDiscardLevel;
+}
+
+bool LLImageGL::queueAlphaReadback(S32 w, S32 h)
+{
+	// retire any readback still in flight from an earlier upload
+	U32 serial = ++mAlphaReadbackSerial;
+	mAlphaClassPending = false;
+
+	if (!sGPUTextureProcessing || sSkipAnalyzeAlpha || !mNeedsAlphaAndPickMask ||
+		w * h < GPU_ALPHA_MIN_PIXELS ||
+		mFormatSwapBytes || mFormatType != GL_UNSIGNED_BYTE || mAlphaStride < 1 || mAlphaOffset < 0 ||
+		(mKnownAlphaClass != ALPHA_CLASS_UNKNOWN && mKnownAlphaDiscard <= mCurrentDiscardLevel))
+	{
+		return false;
+	}
+
+	S32 level = llmin(GPU_ALPHA_READBACK_LEVEL, (S32)mMaxDiscardLevel - (S32)mCurrentDiscardLevel);
+	if (level <= 0)
+	{
+		return false;
+	}
+
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+	AlphaReadback readback;
+	readback.mWidth = w >> level;
+	readback.mHeight = h >> level;
+	readback.mDiscardLevel = mCurrentDiscardLevel;
+	readback.mSerial = serial;
+
+	// the mip chain generated on upload does the box reduction, only the
+	// histogram of the small level is left for the CPU
+	glGenBuffers(1, &readback.mBuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.mBuffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, readback.mWidth * readback.mHeight * mAlphaStride, nullptr, GL_STREAM_READ);
+	glGetTexImage(mTarget, level, mFormatPrimary, mFormatType, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// flush so the fence is visible to the main thread's context
+	glFlush();
+	stop_glerror();
+
+	mAlphaClassPending = true;
+	readback.mImage = this;
+	ref();
+
+	if (on_main_thread())
+	{
+		sAlphaReadbacks.push_back(readback);
+	}
+	else if (!LL::WorkQueue::postMaybe(mMainQueue, [=]() { sAlphaReadbacks.push_back(readback); }))
+	{
+		mAlphaClassPending = false;
+		delete_alpha_readback(readback);
+		return false;
+	}
+	return true;
+}
+
+//static
+void LLImageGL::updateAlphaReadbacks()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+	for (auto iter = sAlphaReadbacks.begin(); iter != sAlphaReadbacks.end(); )
+	{
+		AlphaReadback& readback = *iter;
+		LLImageGL* image = readback.mImage;
+		if (readback.mSerial == image->mAlphaReadbackSerial)
+		{
+			GLenum status = glClientWaitSync(readback.mFence, 0, 0);
+			if (status == GL_TIMEOUT_EXPIRED)
+			{
+				++iter;
+				continue;
+			}
+
+			if (status != GL_WAIT_FAILED)
+			{
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.mBuffer);
+				const U8* data = (const U8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+					readback.mWidth * readback.mHeight * image->mAlphaStride, GL_MAP_READ_BIT);
+				if (data)
+				{
+					image->analyzeAlpha(data, readback.mWidth, readback.mHeight);
+					image->mAlphaClassDiscard = readback.mDiscardLevel;
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+			image->mAlphaClassPending = false;
+		}
+
+		delete_alpha_readback(readback);
+		iter = sAlphaReadbacks.erase(iter);
+	}
 }
 
 //----------------------------------------------------------------------------
@@ -40,6 +40,8 @@
 #include "threadpool.h"
 #include "workqueue.h"
 
+#include <atomic>
+
 #define LL_IMAGEGL_THREAD_CHECK 0 //set to 1 to enable thread debugging for ImageGL
 
 class LLWindow;
@@ -102,6 +104,14 @@ protected:
 
 	void analyzeAlpha(const void* data_in, U32 w, U32 h);
 	void calcAlphaChannelOffsetAndStride();
+	// Block compress data_in and a full mip chain on the CPU and upload them
+	// to the bound texture. Returns false without touching GL if this image
+	// can't be transcoded, in which case the caller uploads it as usual.
+	bool setTranscodedImage(const U8* data_in, S32 w, S32 h);
+	// Queue an asynchronous readback of a GPU generated mip of the bound
+	// texture so analyzeAlpha can run on it later instead of on the full
+	// resolution data. Returns false if this image can't take that path.
+	bool queueAlphaReadback(S32 w, S32 h);
 
 public:
 	virtual void dump();	// debugging info to LL_INFOS()
@@ -109,6 +119,8 @@ public:
 	bool setSize(S32 width, S32 height, S32 ncomponents, S32 discard_level = -1);
 	void setComponents(S32 ncomponents) { mComponents = (S8)ncomponents ;}
 	void setAllowCompression(bool allow) { mAllowCompression = allow; }
+	// Stream sub image updates through a pixel unpack buffer (for frequently updated media textures)
+	void setUseUnpackBuffer(bool use) { mUseUnpackBuffer = use; }
 
 	static void setManualImage(U32 target, S32 miplevel, S32 intformat, S32 width, S32 height, U32 pixformat, U32 pixtype, const void *pixels, bool allow_compression = true);
     
@@ -158,6 +170,22 @@ public:
 
 	BOOL getIsAlphaMask() const;
 
+	enum EAlphaClass
+	{
+		ALPHA_CLASS_UNKNOWN = 0,
+		ALPHA_CLASS_BLEND,		// not suitable for masking
+		ALPHA_CLASS_MASK
+	};
+
+	// Supply the result of an earlier analyzeAlpha of this image at discard_level
+	// (ex. from the texture cache) so uploads at that level or below skip it.
+	void setKnownAlphaClass(U8 alpha_class, S32 discard_level);
+	// Result of the most recent alpha analysis and the discard level it ran at
+	U8 getAlphaClass() const { return mAlphaClass; }
+	S32 getAlphaClassDiscard() const { return mAlphaClassDiscard; }
+	// True while the alpha analysis of the last upload is waiting on the GPU
+	bool isAlphaClassPending() const { return mAlphaClassPending; }
+
 	BOOL getIsResident(BOOL test_now = FALSE); // not const
 
 	void setTarget(const LLGLenum target, const LLTexUnit::eTextureType bind_target);
@@ -215,6 +243,7 @@ private:
 	U32 createPickMask(S32 pWidth, S32 pHeight);
 	void freePickMask();
     bool isCompressed();
+    bool setSubImageUnpackBuffer(const U8* sub_datap, S32 data_width, S32 x_pos, S32 y_pos, S32 width, S32 height);
 
 	LLPointer<LLImageRaw> mSaveData; // used for destroyGL/restoreGL
 	LL::WorkQueue::weak_t mMainQueue;
@@ -229,6 +258,12 @@ private:
 	BOOL mNeedsAlphaAndPickMask;
 	S8   mAlphaStride ;
 	S8   mAlphaOffset ;
+	U8   mAlphaClass;
+	S8   mAlphaClassDiscard;
+	U8   mKnownAlphaClass;
+	S8   mKnownAlphaDiscard;
+	std::atomic<bool> mAlphaClassPending;
+	std::atomic<U32>  mAlphaReadbackSerial;
 
 	bool     mGLTextureCreated ;
 	LLGLuint mTexName;
@@ -242,6 +277,8 @@ private:
 	U32      mTexelsInGLTexture;
 
 	bool mAllowCompression;
+	bool mUseUnpackBuffer;
+	LLGLuint mUnpackBuffer;
 
 protected:
 	LLGLenum mTarget;		// Normally GL_TEXTURE2D, sometimes something else (ex. cube maps)
@@ -279,6 +316,7 @@ public:
 	static LLImageGL* sDefaultGLTexture ;	
 	static BOOL sAutomatedTest;
 	static bool sCompressTextures;			//use GL texture compression
+	static bool sGPUTextureProcessing;		//generate mips and reduce alpha analysis input on the GPU
 #if DEBUG_MISS
 	BOOL mMissed; // Missed on last bind?
 	BOOL getMissed() const { return mMissed; };
@@ -289,6 +327,8 @@ public:
 public:
 	static void initClass(LLWindow* window, S32 num_catagories, BOOL skip_analyze_alpha = false, bool thread_texture_loads = false, bool thread_media_updates = false);
 	static void cleanupClass() ;
+	// Finish alpha readbacks whose GPU work has completed, main thread only
+	static void updateAlphaReadbacks();
 
 private:
 	static S32 sMaxCategories;
@@ -63,6 +63,8 @@ F32 gGLInverseDeltaModelView[16];
 S32	gGLViewport[4];
 
 
+U32 LLRender::sStateChangesIssued[LLRender::NUM_STATE_CHANGES] = { 0 };
+U32 LLRender::sStateChangesElided[LLRender::NUM_STATE_CHANGES] = { 0 };
 U32 LLRender::sUICalls = 0;
 U32 LLRender::sUIVerts = 0;
 U32 LLTexUnit::sWhiteTexture = 0;
@@ -158,6 +160,11 @@ void LLTexUnit::activate(void)
 		gGL.flush();
 		glActiveTexture(GL_TEXTURE0 + mIndex);
 		gGL.mCurrTextureUnitIndex = mIndex;
+		LLRender::countStateChange(LLRender::SC_TEXTURE, true);
+	}
+	else
+	{
+		LLRender::countStateChange(LLRender::SC_TEXTURE, false);
 	}
 }
 
@@ -193,18 +200,39 @@ void LLTexUnit::bindFast(LLTexture* texture)
 {
     LLImageGL* gl_tex = texture->getGLTexture();
     texture->setActive();
-    glActiveTexture(GL_TEXTURE0 + mIndex);
-    gGL.mCurrTextureUnitIndex = mIndex;
-    mCurrTexture = gl_tex->getTexName();
-    if (!mCurrTexture)
+    if ((S32)gGL.mCurrTextureUnitIndex != mIndex || gGL.mDirty)
+    {
+        glActiveTexture(GL_TEXTURE0 + mIndex);
+        gGL.mCurrTextureUnitIndex = mIndex;
+        LLRender::countStateChange(LLRender::SC_TEXTURE, true);
+    }
+    else
+    {
+        LLRender::countStateChange(LLRender::SC_TEXTURE, false);
+    }
+
+    U32 tex_name = gl_tex->getTexName();
+    if (!tex_name)
     {
         LL_PROFILE_ZONE_NAMED("MISSING TEXTURE");
+        mCurrTexture = 0;
         //if deleted, will re-generate it immediately
         texture->forceImmediateUpdate();
         gl_tex->forceUpdateBindStats();
         texture->bindDefaultImage(mIndex);
+        glBindTexture(sGLTextureType[gl_tex->getTarget()], mCurrTexture);
+        LLRender::countStateChange(LLRender::SC_TEXTURE, true);
+    }
+    else if (mCurrTexture != tex_name || gGL.mDirty)
+    {
+        mCurrTexture = tex_name;
+        glBindTexture(sGLTextureType[gl_tex->getTarget()], mCurrTexture);
+        LLRender::countStateChange(LLRender::SC_TEXTURE, true);
+    }
+    else
+    {
+        LLRender::countStateChange(LLRender::SC_TEXTURE, false);
     }
-    glBindTexture(sGLTextureType[gl_tex->getTarget()], mCurrTexture);
     mHasMipMaps = gl_tex->mHasMipMaps;
 }
 
@@ -242,6 +270,11 @@ bool LLTexUnit::bind(LLTexture* texture, bool for_rendering, bool forceBind)
 						setTextureFilteringOption(gl_tex->mFilterOption);
                     }
                     setTextureColorSpace(mTexColorSpace);
+					LLRender::countStateChange(LLRender::SC_TEXTURE, true);
+				}
+				else
+				{
+					LLRender::countStateChange(LLRender::SC_TEXTURE, false);
 				}
 			}
 			else
@@ -319,6 +352,11 @@ bool LLTexUnit::bind(LLImageGL* texture, bool for_rendering, bool forceBind, S32
 			stop_glerror();
 		}
         setTextureColorSpace(mTexColorSpace);
+		LLRender::countStateChange(LLRender::SC_TEXTURE, true);
+	}
+	else
+	{
+		LLRender::countStateChange(LLRender::SC_TEXTURE, false);
 	}
 
 	stop_glerror();
@@ -839,6 +877,7 @@ LLRender::LLRender()
 	mCurrBlendAlphaSFactor = BF_UNDEF;
 	mCurrBlendColorDFactor = BF_UNDEF;
 	mCurrBlendAlphaDFactor = BF_UNDEF;
+	mPremultipliedAlphaTarget = false;
 
 	mMatrixMode = LLRender::MM_MODELVIEW;
 	
@@ -887,9 +926,9 @@ bool LLRender::init(bool needs_vertex_buffer)
 #endif
 
     { //bind a dummy vertex array object so we're core profile compliant
-        U32 ret;
-        glGenVertexArrays(1, &ret);
-        glBindVertexArray(ret);
+        glGenVertexArrays(1, &LLVertexBuffer::sDefaultVAO);
+        glBindVertexArray(LLVertexBuffer::sDefaultVAO);
+        LLVertexBuffer::sGLRenderVAO = 0;
     }
 
     if (needs_vertex_buffer)
@@ -1423,7 +1462,14 @@ void LLRender::setSceneBlendType(eBlendType type)
 	switch (type) 
 	{
 		case BT_ALPHA:
-			blendFunc(BF_SOURCE_ALPHA, BF_ONE_MINUS_SOURCE_ALPHA);
+			if (mPremultipliedAlphaTarget)
+			{
+				blendFunc(BF_SOURCE_ALPHA, BF_ONE_MINUS_SOURCE_ALPHA, BF_ONE, BF_ONE_MINUS_SOURCE_ALPHA);
+			}
+			else
+			{
+				blendFunc(BF_SOURCE_ALPHA, BF_ONE_MINUS_SOURCE_ALPHA);
+			}
 			break;
 		case BT_ADD:
 			blendFunc(BF_ONE, BF_ONE);
@@ -1453,8 +1499,10 @@ void LLRender::blendFunc(eBlendFactor sfactor, eBlendFactor dfactor)
 {
 	llassert(sfactor < BF_UNDEF);
 	llassert(dfactor < BF_UNDEF);
-	if (mCurrBlendColorSFactor != sfactor || mCurrBlendColorDFactor != dfactor ||
-	    mCurrBlendAlphaSFactor != sfactor || mCurrBlendAlphaDFactor != dfactor)
+	bool changed = mCurrBlendColorSFactor != sfactor || mCurrBlendColorDFactor != dfactor ||
+				   mCurrBlendAlphaSFactor != sfactor || mCurrBlendAlphaDFactor != dfactor;
+	countStateChange(SC_BLEND, changed);
+	if (changed)
 	{
 		mCurrBlendColorSFactor = sfactor;
 		mCurrBlendAlphaSFactor = sfactor;
@@ -1473,8 +1521,10 @@ void LLRender::blendFunc(eBlendFactor color_sfactor, eBlendFactor color_dfactor,
 	llassert(alpha_sfactor < BF_UNDEF);
 	llassert(alpha_dfactor < BF_UNDEF);
 	
-	if (mCurrBlendColorSFactor != color_sfactor || mCurrBlendColorDFactor != color_dfactor ||
-	    mCurrBlendAlphaSFactor != alpha_sfactor || mCurrBlendAlphaDFactor != alpha_dfactor)
+	bool changed = mCurrBlendColorSFactor != color_sfactor || mCurrBlendColorDFactor != color_dfactor ||
+				   mCurrBlendAlphaSFactor != alpha_sfactor || mCurrBlendAlphaDFactor != alpha_dfactor;
+	countStateChange(SC_BLEND, changed);
+	if (changed)
 	{
 		mCurrBlendColorSFactor = color_sfactor;
 		mCurrBlendAlphaSFactor = alpha_sfactor;
@@ -1662,16 +1712,38 @@ void LLRender::flush()
             // To leverage this, we maintain a running hash of the vertex stream being
             // built up before a flush, and then check that hash against a VB 
             // cache just before creating a vertex buffer in VRAM
+            //
+            // Geometry that only shows up once (particles, text that changes
+            // every frame) would never be drawn from the cache, so the first
+            // time a hash is seen it is drawn from the streaming ring instead
+            // and only remembered. A vertex buffer is made on the second sighting.
             std::unordered_map<U64, LLVBCache>::iterator cache = sVBCache.find(vhash);
 
             LLPointer<LLVertexBuffer> vb;
+            bool cache_hit = false;
+
+            U32 draw_mode = mMode;
+            if (mMode == LLRender::QUADS && sGLCoreProfile)
+            {
+                draw_mode = LLRender::TRIANGLES;
+                mQuadCycle = 1;
+            }
 
-            if (cache != sVBCache.end())
+            if (cache != sVBCache.end() && cache->second.vb.notNull())
             {
                 LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vb cache hit");
                 // cache hit, just use the cached buffer
                 vb = cache->second.vb;
                 cache->second.touched = std::chrono::steady_clock::now();
+                cache_hit = true;
+            }
+            else if (cache == sVBCache.end() &&
+                     LLVertexBuffer::drawStreamed(draw_mode, count, (LLVector4a*) mVerticesp.get(),
+                                                  (attribute_mask & LLVertexBuffer::MAP_TEXCOORD0) ? mTexcoordsp.get() : nullptr,
+                                                  (attribute_mask & LLVertexBuffer::MAP_COLOR) ? mColorsp.get() : nullptr))
+            {
+                LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vb cache stream");
+                sVBCache[vhash] = { nullptr, std::chrono::steady_clock::now() };
             }
             else
             {
@@ -1696,7 +1768,10 @@ void LLRender::flush()
                 vb->unbind();
 
                 sVBCache[vhash] = { vb , std::chrono::steady_clock::now() };
+            }
 
+            if (!cache_hit)
+            {
                 static U32 miss_count = 0;
                 miss_count++;
                 if (miss_count > 1024)
@@ -1706,7 +1781,7 @@ void LLRender::flush()
                     auto now = std::chrono::steady_clock::now();
 
                     using namespace std::chrono_literals;
-                    // every 1024 misses, clean the cache of any VBs that haven't been touched in the last second
+                    // every 1024 misses, clean the cache of any VBs (or streamed hashes) that haven't been touched in the last second
                     for (std::unordered_map<U64, LLVBCache>::iterator iter = sVBCache.begin(); iter != sVBCache.end(); )
                     {
                         if (now - iter->second.touched > 1s)
@@ -1721,16 +1796,10 @@ void LLRender::flush()
                 }
             }
 
-            vb->setBuffer();
-
-            if (mMode == LLRender::QUADS && sGLCoreProfile)
+            if (vb.notNull())
             {
-                vb->drawArrays(LLRender::TRIANGLES, 0, count);
-                mQuadCycle = 1;
-            }
-            else
-            {
-                vb->drawArrays(mMode, 0, count);
+                vb->setBuffer();
+                vb->drawArrays(draw_mode, 0, count);
             }
         }
         else
@@ -447,6 +447,12 @@ public:
 	void setColorMask(bool writeColorR, bool writeColorG, bool writeColorB, bool writeAlpha);
 	void setSceneBlendType(eBlendType type);
 
+	// While drawing into a transparent offscreen target, BT_ALPHA also
+	// accumulates alpha as coverage, leaving premultiplied color behind.
+	// Composite the result with blendFunc(BF_ONE, BF_ONE_MINUS_SOURCE_ALPHA).
+	void setPremultipliedAlphaTarget(bool premultiplied) { mPremultipliedAlphaTarget = premultiplied; }
+	bool getPremultipliedAlphaTarget() const { return mPremultipliedAlphaTarget; }
+
 	// applies blend func to both color and alpha
 	void blendFunc(eBlendFactor sfactor, eBlendFactor dfactor);
 	// applies separate blend functions to color and alpha
@@ -474,6 +480,36 @@ public:
 	};
 
 public:
+	// kinds of GL state change tracked for the render info display
+	enum eStateChange : U8
+	{
+		SC_CAPABILITY = 0,	// glEnable/glDisable through LLGLState
+		SC_DEPTH,			// depth test, func and mask through LLGLDepthTest
+		SC_BLEND,			// blendFunc
+		SC_TEXTURE,			// glActiveTexture/glBindTexture through LLTexUnit
+		SC_PROGRAM,			// glUseProgram
+		SC_BUFFER,			// vertex and index buffer binds in setBuffer
+		SC_VERTEX_FORMAT,	// attribute pointer setup, skipped when a cached vertex array is reused
+		NUM_STATE_CHANGES
+	};
+
+	// issued changes reached the driver, elided ones were dropped because the
+	// shadow state already matched; reset by whoever displays them
+	static U32 sStateChangesIssued[NUM_STATE_CHANGES];
+	static U32 sStateChangesElided[NUM_STATE_CHANGES];
+
+	static void countStateChange(eStateChange type, bool issued)
+	{
+		if (issued)
+		{
+			sStateChangesIssued[type]++;
+		}
+		else
+		{
+			sStateChangesElided[type]++;
+		}
+	}
+
 	static U32 sUICalls;
 	static U32 sUIVerts;
 	static bool sGLCoreProfile;
@@ -510,6 +546,7 @@ private:
 	eBlendFactor mCurrBlendColorDFactor;
 	eBlendFactor mCurrBlendAlphaSFactor;
 	eBlendFactor mCurrBlendAlphaDFactor;
+	bool mPremultipliedAlphaTarget;
 
 	std::vector<LLVector3> mUIOffset;
 	std::vector<LLVector3> mUIScale;
@@ -412,6 +412,18 @@ void LLRenderTarget::release()
     mResX = mResY = 0;
 }
 
+void LLRenderTarget::copyDepth(LLRenderTarget& src)
+{
+    LL_PROFILE_GPU_ZONE("rt copy depth");
+    llassert(mDepth && src.mDepth);
+    llassert(mResX == src.mResX && mResY == src.mResY);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, src.mFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFBO);
+    glBlitFramebuffer(0, 0, mResX, mResY, 0, 0, mResX, mResY, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, sCurFBO);
+}
+
 void LLRenderTarget::bindTarget()
 {
     LL_PROFILE_GPU_ZONE("bindTarget");
@@ -488,6 +500,40 @@ U32 LLRenderTarget::getNumTextures() const
     return mTex.size();
 }
 
+static U32 bytes_per_pixel(U32 internal_format)
+{
+    switch (internal_format)
+    {
+    case GL_R8:
+        return 1;
+    case GL_R16F:
+    case GL_RG8:
+        return 2;
+    case GL_RGB16F: // padded to four channels by most drivers
+    case GL_RGBA16F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+U64 LLRenderTarget::getBytesAllocated() const
+{
+    U64 pixels = (U64) mResX * mResY;
+    U64 bytes = 0;
+    for (U32 format : mInternalFormat)
+    {
+        bytes += pixels * bytes_per_pixel(format);
+    }
+    if (mDepth)
+    {
+        bytes += pixels * 4;
+    }
+    return bytes;
+}
+
 void LLRenderTarget::bindTexture(U32 index, S32 channel, LLTexUnit::eTextureFilterOptions filter_options)
 {
     gGL.getTexUnit(channel)->bindManual(mUsage, getTexture(index), filter_options == LLTexUnit::TFO_TRILINEAR || filter_options == LLTexUnit::TFO_ANISOTROPIC);
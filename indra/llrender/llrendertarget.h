@@ -116,6 +116,11 @@ public:
 	//share depth buffer with provided render target
 	void shareDepthBuffer(LLRenderTarget& target);
 
+	//copy the depth buffer of src into this target's depth buffer
+	//both must have a depth buffer and be the same size
+	//does not change the bound target
+	void copyDepth(LLRenderTarget& src);
+
 	//free any allocated resources
 	//safe to call redundantly
     // asserts that this target is not currently bound or present in the RT stack
@@ -149,6 +154,10 @@ public:
 
 	U32 getDepth(void) const { return mDepth; }
 
+	// estimated video memory held by this target's own attachments
+	// (a shared depth buffer is counted by its owner)
+	U64 getBytesAllocated() const;
+
 	void bindTexture(U32 index, S32 channel, LLTexUnit::eTextureFilterOptions filter_options = LLTexUnit::TFO_BILINEAR);
 
 	//flush rendering operations
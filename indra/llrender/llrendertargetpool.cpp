@@ -0,0 +1,139 @@
+/**
+ * @file llrendertargetpool.cpp
+ * @brief Pool of render targets that only live for part of a frame
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llrendertargetpool.h"
+
+LLRenderTargetPool::~LLRenderTargetPool()
+{
+    clear();
+}
+
+LLRenderTarget* LLRenderTargetPool::acquire(const std::string& name, U32 resx, U32 resy, U32 color_fmt, bool depth)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DISPLAY;
+
+    for (Entry& entry : mEntries)
+    {
+        if (!entry.mInUse &&
+            entry.mTarget->getWidth() == resx &&
+            entry.mTarget->getHeight() == resy &&
+            entry.mFormat == color_fmt &&
+            entry.mDepth == depth)
+        {
+            entry.mInUse = true;
+            entry.mLastUsedFrame = mFrame;
+            entry.mName = name;
+            return entry.mTarget.get();
+        }
+    }
+
+    Entry entry;
+    entry.mTarget.reset(new LLRenderTarget());
+    if (!entry.mTarget->allocate(resx, resy, color_fmt, depth))
+    {
+        LL_WARNS() << "Failed to allocate " << resx << "x" << resy << " render target for " << name << LL_ENDL;
+        entry.mTarget->release();
+        return NULL;
+    }
+
+    entry.mName = name;
+    entry.mFormat = color_fmt;
+    entry.mDepth = depth;
+    entry.mInUse = true;
+    entry.mLastUsedFrame = mFrame;
+    mEntries.push_back(std::move(entry));
+    return mEntries.back().mTarget.get();
+}
+
+void LLRenderTargetPool::release(LLRenderTarget* target)
+{
+    for (Entry& entry : mEntries)
+    {
+        if (entry.mTarget.get() == target)
+        {
+            llassert(entry.mInUse);
+            llassert(!target->isBoundInStack());
+            entry.mInUse = false;
+            return;
+        }
+    }
+
+    llassert(false); // not from this pool
+}
+
+void LLRenderTargetPool::trim(U32 frame, U32 max_idle_frames)
+{
+    mFrame = frame;
+
+    for (auto iter = mEntries.begin(); iter != mEntries.end();)
+    {
+        if (!iter->mInUse && frame - iter->mLastUsedFrame > max_idle_frames)
+        {
+            iter->mTarget->release();
+            iter = mEntries.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void LLRenderTargetPool::clear()
+{
+    for (Entry& entry : mEntries)
+    {
+        llassert(!entry.mInUse);
+        entry.mTarget->release();
+    }
+    mEntries.clear();
+}
+
+U64 LLRenderTargetPool::getBytesAllocated() const
+{
+    U64 bytes = 0;
+    for (const Entry& entry : mEntries)
+    {
+        bytes += entry.mTarget->getBytesAllocated();
+    }
+    return bytes;
+}
+
+void LLRenderTargetPool::getTargetInfo(std::vector<TargetInfo>& info) const
+{
+    for (const Entry& entry : mEntries)
+    {
+        TargetInfo target_info;
+        target_info.mName = entry.mName;
+        target_info.mWidth = entry.mTarget->getWidth();
+        target_info.mHeight = entry.mTarget->getHeight();
+        target_info.mBytes = entry.mTarget->getBytesAllocated();
+        target_info.mInUse = entry.mInUse;
+        info.push_back(target_info);
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file llrendertargetpool.h
+ * @brief Pool of render targets that only live for part of a frame
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLRENDERTARGETPOOL_H
+#define LL_LLRENDERTARGETPOOL_H
+
+#include "llrendertarget.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ Hands out render targets for passes that only need them between acquire()
+ and release(). Once released, a target serves the next acquire() with the
+ same size and format, so passes whose lifetimes don't overlap share one
+ allocation instead of each keeping its own. Targets nobody has asked for
+ in a while are freed by trim().
+
+ SAMPLE USAGE:
+
+	LLRenderTarget* scratch = pool.acquire("blur", w, h, GL_RGBA16F);
+	if (scratch)
+	{
+		scratch->bindTarget();
+		...
+		scratch->flush();
+		pool.release(scratch);
+	}
+*/
+class LLRenderTargetPool
+{
+public:
+	struct TargetInfo
+	{
+		std::string mName;
+		U32 mWidth;
+		U32 mHeight;
+		U64 mBytes;
+		bool mInUse;
+	};
+
+	~LLRenderTargetPool();
+
+	// Returns a target of exactly this description, allocating only when
+	// no released one matches. Returns NULL if allocation failed.
+	// name is for debug display and is taken from the most recent user.
+	LLRenderTarget* acquire(const std::string& name, U32 resx, U32 resy, U32 color_fmt, bool depth = false);
+
+	// give a target back; its contents are undefined at the next acquire
+	void release(LLRenderTarget* target);
+
+	// Call once per frame. Frees targets that haven't been acquired for
+	// more than max_idle_frames, e.g. after a resize or a feature toggle.
+	void trim(U32 frame, U32 max_idle_frames);
+
+	// free everything, nothing may be acquired
+	void clear();
+
+	U64 getBytesAllocated() const;
+	void getTargetInfo(std::vector<TargetInfo>& info) const;
+
+private:
+	struct Entry
+	{
+		std::unique_ptr<LLRenderTarget> mTarget;
+		std::string mName;
+		U32 mFormat;
+		bool mDepth;
+		bool mInUse;
+		U32 mLastUsedFrame;
+	};
+
+	std::vector<Entry> mEntries;
+	U32 mFrame = 0;
+};
+
+#endif // LL_LLRENDERTARGETPOOL_H
@@ -32,6 +32,9 @@
 #include "llsdutil.h"
 #include "llsdserialize.h"
 #include "hbxxh.h"
+#include "llwindow.h"
+
+#include <thread>
 
 #if LL_DARWIN
 #include "OpenGL/OpenGL.h"
@@ -168,7 +171,7 @@ BOOL LLShaderMgr::attachShaderFeatures(LLGLSLShader * shader)
 	if (features->hasObjectSkinning)
 	{
         shader->mRiggedVariant = shader;
-        if (!shader->attachVertexObject("avatar/objectSkinV.glsl"))
+        if (!shader->attachVertexObject(features->hasInstancedSkinning ? "avatar/objectSkinInstancedV.glsl" : "avatar/objectSkinV.glsl"))
 		{
 			return FALSE;
 		}
@@ -897,12 +900,17 @@ GLuint LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shader_lev
 
 BOOL LLShaderMgr::linkProgramObject(GLuint obj, BOOL suppress_errors)
 {
-	//check for errors
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_SHADER("glLinkProgram");
         glLinkProgram(obj);
     }
 
+    return checkLinkStatus(obj, suppress_errors);
+}
+
+BOOL LLShaderMgr::checkLinkStatus(GLuint obj, BOOL suppress_errors)
+{
+	//check for errors
     GLint success = GL_TRUE;
 
     {
@@ -928,6 +936,121 @@ BOOL LLShaderMgr::linkProgramObject(GLuint obj, BOOL suppress_errors)
 	return success;
 }
 
+bool LLShaderMgr::startAsyncLink(LLGLSLShader* shader)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    if (!mAsyncLink)
+    {
+        return false;
+    }
+
+    if (gGLManager.mHasParallelShaderCompile)
+    { // the driver links on its own threads, glLinkProgram returns right away
+        glLinkProgram(shader->mProgramObject);
+    }
+    else if (LLShaderLinkThread::instanceExists())
+    {
+        // the link thread must see the attachments and attribute bindings made on this context
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        GLuint program = shader->mProgramObject;
+        std::shared_ptr<LLAtomicBool> done = std::make_shared<LLAtomicBool>(false);
+        shader->mLinkDone = done;
+
+        bool posted = LLShaderLinkThread::getInstance()->post([program, fence, done]()
+            {
+                LL_PROFILE_ZONE_NAMED_CATEGORY_SHADER("link thread - link");
+                glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+                glDeleteSync(fence);
+
+                glLinkProgram(program);
+
+                // make sure the link is really done before the main context looks at the program
+                GLint status = GL_FALSE;
+                glGetProgramiv(program, GL_LINK_STATUS, &status);
+                glFinish();
+
+                *done = true;
+            });
+
+        if (!posted)
+        {
+            glDeleteSync(fence);
+            shader->mLinkDone.reset();
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    mPendingShaders.push_back(shader);
+    return true;
+}
+
+bool LLShaderMgr::isLinkDone(LLGLSLShader* shader)
+{
+    if (shader->mLinkDone)
+    {
+        return *shader->mLinkDone;
+    }
+
+    GLint done = GL_FALSE;
+    glGetProgramiv(shader->mProgramObject, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+void LLShaderMgr::waitForLink(LLGLSLShader* shader)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    if (shader->mLinkDone)
+    {
+        while (!*shader->mLinkDone)
+        {
+            std::this_thread::yield();
+        }
+        shader->mLinkDone.reset();
+    }
+    // with parallel compile the status query in LLGLSLShader::finishLink does the waiting
+
+    auto iter = std::find(mPendingShaders.begin(), mPendingShaders.end(), shader);
+    if (iter != mPendingShaders.end())
+    {
+        mPendingShaders.erase(iter);
+    }
+}
+
+U32 LLShaderMgr::updatePendingShaders()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    // finishLink removes the shader from mPendingShaders, work on a copy
+    std::vector<LLGLSLShader*> pending = mPendingShaders;
+    for (LLGLSLShader* shader : pending)
+    {
+        if (isLinkDone(shader))
+        {
+            shader->finishLink();
+        }
+    }
+
+    return mPendingShaders.size();
+}
+
+void LLShaderMgr::finishPendingShaders()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    while (!mPendingShaders.empty())
+    {
+        mPendingShaders.back()->finishLink();
+    }
+}
+
 BOOL LLShaderMgr::validateProgramObject(GLuint obj)
 {
 	//check program validity against current GL
@@ -1375,6 +1498,10 @@ void LLShaderMgr::initAttribsAndUniforms()
 	mReservedUniforms.push_back("detail_2");
 	mReservedUniforms.push_back("detail_3");
 	mReservedUniforms.push_back("alpha_ramp");
+	mReservedUniforms.push_back("height_field");
+	mReservedUniforms.push_back("composition_map");
+	mReservedUniforms.push_back("parcel_overlay");
+	mReservedUniforms.push_back("parcel_lines");
 
 	mReservedUniforms.push_back("origin");
 	mReservedUniforms.push_back("display_gamma");
@@ -1421,3 +1548,22 @@ void LLShaderMgr::initAttribsAndUniforms()
 	}
 }
 
+LLShaderLinkThread::LLShaderLinkThread(LLWindow* window)
+    // We want exactly one thread.
+    : LL::ThreadPool("LLShaderLink", 1)
+    , mWindow(window)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    mContext = mWindow->createSharedContext();
+    LL::ThreadPool::start();
+}
+
+void LLShaderLinkThread::run()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+    // the shared context has to be current on this thread before servicing the queue
+    mWindow->makeContextCurrent(mContext);
+    LL::ThreadPool::run();
+    mWindow->destroySharedContext(mContext);
+}
@@ -29,6 +29,10 @@
 
 #include "llgl.h"
 #include "llglslshader.h"
+#include "llsingleton.h"
+#include "threadpool.h"
+
+class LLWindow;
 
 class LLShaderMgr
 {
@@ -252,6 +256,10 @@ public:
         TERRAIN_DETAIL2,                    //  "detail_2"
         TERRAIN_DETAIL3,                    //  "detail_3"
         TERRAIN_ALPHARAMP,                  //  "alpha_ramp"
+        TERRAIN_HEIGHT_FIELD,               //  "height_field"
+        TERRAIN_COMPOSITION,                //  "composition_map"
+        TERRAIN_PARCEL_OVERLAY,             //  "parcel_overlay"
+        TERRAIN_PARCEL_LINES,               //  "parcel_lines"
 
         SHINY_ORIGIN,                       //  "origin"
         DISPLAY_GAMMA,                      //  "display_gamma"
@@ -300,6 +308,8 @@ public:
 	void dumpObjectLog(GLuint ret, BOOL warns = TRUE, const std::string& filename = "");
     void dumpShaderSource(U32 shader_code_count, GLchar** shader_code_text);
 	BOOL	linkProgramObject(GLuint obj, BOOL suppress_errors = FALSE);
+	// the status half of linkProgramObject, for programs whose glLinkProgram was issued elsewhere
+	BOOL	checkLinkStatus(GLuint obj, BOOL suppress_errors = FALSE);
 	BOOL	validateProgramObject(GLuint obj);
 	GLuint loadShaderFile(const std::string& filename, S32 & shader_level, GLenum type, std::map<std::string, std::string>* defines = NULL, S32 texture_index_channels = -1);
 
@@ -316,6 +326,24 @@ public:
     bool loadCachedProgramBinary(LLGLSLShader* shader);
     bool saveCachedProgramBinary(LLGLSLShader* shader);
 
+    // issue the link of shader's program without waiting on the result, either through
+    // GL_KHR_parallel_shader_compile or on LLShaderLinkThread
+    // returns false if async linking is off or neither is available, the caller should link as usual
+    bool startAsyncLink(LLGLSLShader* shader);
+
+    // true if the link started by startAsyncLink is done and the shader can be finished without blocking
+    bool isLinkDone(LLGLSLShader* shader);
+
+    // block until the link started by startAsyncLink is done and forget about it
+    void waitForLink(LLGLSLShader* shader);
+
+    // finish any pending shaders whose link is done, call once per frame
+    // returns the number of shaders still pending
+    U32 updatePendingShaders();
+
+    // finish all pending shaders now
+    void finishPendingShaders();
+
 public:
 	// Map of shader names to compiled
     std::map<std::string, GLuint> mVertexShaderObjects;
@@ -337,6 +365,17 @@ public:
     bool mShaderCacheEnabled = false;
     std::string mShaderCacheDir;
 
+    // if true, createShader links in the background where possible and the shader
+    // is finished on first bind or by updatePendingShaders, whichever comes first
+    bool mAsyncLink = false;
+
+    // set when a shader failed to finish a background link, and even a synchronous
+    // retry didn't help, the application should reload shaders with mAsyncLink off
+    bool mAsyncLinkFailed = false;
+
+    // shaders whose program is linking in the background
+    std::vector<LLGLSLShader*> mPendingShaders;
+
 protected:
 
 	// our parameter manager singleton instance
@@ -344,4 +383,25 @@ protected:
 
 }; //LLShaderMgr
 
+// Links shader programs in a GL context shared with the main one, for drivers
+// without GL_KHR_parallel_shader_compile (see LLShaderMgr::startAsyncLink)
+class LLShaderLinkThread : public LLSimpleton<LLShaderLinkThread>, LL::ThreadPool
+{
+public:
+    LLShaderLinkThread(LLWindow* window);
+
+    // post a function to be executed on the link thread
+    template <typename CALLABLE>
+    bool post(CALLABLE&& func)
+    {
+        return getQueue().post(std::forward<CALLABLE>(func));
+    }
+
+    void run() override;
+
+private:
+    LLWindow* mWindow;
+    void* mContext = nullptr;
+};
+
 #endif
@@ -358,6 +358,10 @@ public:
 
             mMisses++;
             name = gen_buffer();
+            if (type == GL_ELEMENT_ARRAY_BUFFER)
+            {
+                LLVertexBuffer::bindDefaultVAO();
+            }
             glBindBuffer(type, name);
             glBufferData(type, size, nullptr, GL_DYNAMIC_DRAW);
             if (type == GL_ELEMENT_ARRAY_BUFFER)
@@ -515,6 +519,117 @@ public:
 
 static LLVBOPool* sVBOPool = nullptr;
 
+//============================================================================
+// Persistently mapped ring for geometry that is drawn once and thrown away.
+// Writes go straight into the mapping, so there is no glBufferData/
+// glBufferSubData per draw. The ring is split into segments and a fence is
+// placed at the end of each one; wrapping around into a segment waits on its
+// fence, so the CPU never overwrites data the GPU hasn't read yet.
+
+class LLStreamRing
+{
+public:
+    static constexpr U32 SEGMENT_COUNT = 4;
+    static constexpr U32 SEGMENT_SIZE = 2 * 1024 * 1024;
+    static constexpr U32 RING_SIZE = SEGMENT_COUNT * SEGMENT_SIZE;
+
+    LLStreamRing()
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &mGLName);
+        glBindBuffer(GL_ARRAY_BUFFER, mGLName);
+        glBufferStorage(GL_ARRAY_BUFFER, RING_SIZE, nullptr, flags);
+        mData = (U8*)glMapBufferRange(GL_ARRAY_BUFFER, 0, RING_SIZE, flags);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        LLVertexBuffer::sGLRenderBuffer = 0;
+
+        if (!mData)
+        {
+            LL_WARNS() << "Failed to map vertex streaming ring, falling back to regular vertex buffers" << LL_ENDL;
+        }
+    }
+
+    ~LLStreamRing()
+    {
+        for (GLsync& fence : mFences)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+                fence = 0;
+            }
+        }
+        if (mGLName)
+        {
+            if (mData)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, mGLName);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &mGLName);
+        }
+        LLVertexBuffer::sGLRenderBuffer = 0;
+    }
+
+    bool isValid() const { return mData != nullptr; }
+    GLuint getGLName() const { return mGLName; }
+
+    // reserve size bytes (16 byte aligned), returns nullptr if size doesn't
+    // fit in a segment
+    U8* allocate(U32 size, U32& offset)
+    {
+        size = (size + 15) & ~15;
+        if (size > SEGMENT_SIZE)
+        {
+            return nullptr;
+        }
+
+        U32 segment_end = (mSegment + 1) * SEGMENT_SIZE;
+        if (mOffset + size > segment_end)
+        {
+            nextSegment();
+        }
+
+        offset = mOffset;
+        mOffset += size;
+        return mData + offset;
+    }
+
+private:
+    void nextSegment()
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        mFences[mSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mSegment = (mSegment + 1) % SEGMENT_COUNT;
+        mOffset = mSegment * SEGMENT_SIZE;
+
+        GLsync& fence = mFences[mSegment];
+        if (fence)
+        {
+            LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("stream ring wait");
+            // a whole ring of streamed geometry in flight is rare, when it
+            // happens we have to wait for the GPU
+            constexpr GLuint64 one_second = 1000000000;
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, one_second) == GL_TIMEOUT_EXPIRED)
+            {
+            }
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+
+    GLuint mGLName = 0;
+    U8* mData = nullptr;
+    U32 mSegment = 0;
+    U32 mOffset = 0;
+    GLsync mFences[SEGMENT_COUNT] = {};
+};
+
+static LLStreamRing* sStreamRing = nullptr;
+
 //static
 U64 LLVertexBuffer::getBytesAllocated()
 {
@@ -528,6 +643,11 @@ U32 LLVertexBuffer::sGLRenderBuffer = 0;
 U32 LLVertexBuffer::sGLRenderIndices = 0;
 U32 LLVertexBuffer::sLastMask = 0;
 U32 LLVertexBuffer::sVertexCount = 0;
+U32 LLVertexBuffer::sDrawCount = 0;
+bool LLVertexBuffer::sUseStreamRing = true;
+bool LLVertexBuffer::sUseVAOCache = false;
+U32 LLVertexBuffer::sDefaultVAO = 0;
+U32 LLVertexBuffer::sGLRenderVAO = 0;
 
 
 //NOTE: each component must be AT LEAST 4 bytes in size to avoid a performance penalty on AMD hardware
@@ -582,6 +702,8 @@ const U32 LLVertexBuffer::sGLMode[LLRender::NUM_MODES] =
 //static
 void LLVertexBuffer::setupClientArrays(U32 data_mask)
 {
+    bindDefaultVAO();
+
     if (sLastMask != data_mask)
     {
         for (U32 i = 0; i < TYPE_MAX; ++i)
@@ -623,6 +745,67 @@ void LLVertexBuffer::drawArrays(U32 mode, const std::vector<LLVector3>& pos)
     gGL.flush();
 }
 
+//static
+bool LLVertexBuffer::drawStreamed(U32 mode, U32 count, const LLVector4a* pos, const LLVector2* tc, const LLColor4U* colors)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+    llassert(LLGLSLShader::sCurBoundShaderPtr != NULL);
+
+    U32 data_mask = LLGLSLShader::sCurBoundShaderPtr->mAttributeMask;
+    if (!sStreamRing || (data_mask & ~(MAP_VERTEX | MAP_TEXCOORD0 | MAP_COLOR)))
+    {
+        return false;
+    }
+    if (!tc) data_mask &= ~MAP_TEXCOORD0;
+    if (!colors) data_mask &= ~MAP_COLOR;
+
+    U32 pos_size = count * sizeof(LLVector4a);
+    U32 tc_size = (data_mask & MAP_TEXCOORD0) ? count * sizeof(LLVector2) : 0;
+    U32 color_size = (data_mask & MAP_COLOR) ? count * sizeof(LLColor4U) : 0;
+
+    U32 offset = 0;
+    U8* dst = sStreamRing->allocate(pos_size + tc_size + color_size, offset);
+    if (!dst)
+    {
+        return false;
+    }
+    memcpy(dst, pos, pos_size);
+    if (tc_size)
+    {
+        memcpy(dst + pos_size, tc, tc_size);
+    }
+    if (color_size)
+    {
+        memcpy(dst + pos_size + tc_size, colors, color_size);
+    }
+
+    bindDefaultVAO();
+
+    if (sGLRenderBuffer != sStreamRing->getGLName())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, sStreamRing->getGLName());
+        sGLRenderBuffer = sStreamRing->getGLName();
+    }
+    // the ring's name never matches an LLVertexBuffer's, so the next
+    // setBuffer() rebinds and sets up its own attribute pointers
+
+    U8* base = nullptr;
+    glVertexAttribPointer(TYPE_VERTEX, 3, GL_FLOAT, GL_FALSE, sTypeSize[TYPE_VERTEX], base + offset);
+    if (tc_size)
+    {
+        glVertexAttribPointer(TYPE_TEXCOORD0, 2, GL_FLOAT, GL_FALSE, sTypeSize[TYPE_TEXCOORD0], base + offset + pos_size);
+    }
+    if (color_size)
+    {
+        glVertexAttribPointer(TYPE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sTypeSize[TYPE_COLOR], base + offset + pos_size + tc_size);
+    }
+
+    gGL.syncMatrices();
+    ++sDrawCount;
+    glDrawArrays(sGLMode[mode], 0, count);
+    return true;
+}
+
 //static
 void LLVertexBuffer::drawElements(U32 mode, const LLVector4a* pos, const LLVector2* tc, U32 num_indices, const U16* indicesp)
 {
@@ -738,13 +921,44 @@ void LLVertexBuffer::setLabel(const char* label) {
 void LLVertexBuffer::drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const
 {
     llassert(validateRange(start, end, count, indices_offset));
-    llassert(mGLBuffer == sGLRenderBuffer);
-    llassert(mGLIndices == sGLRenderIndices);
+    llassert(isBound());
     gGL.syncMatrices();
+    ++sDrawCount;
     glDrawRangeElements(sGLMode[mode], start, end, count, GL_UNSIGNED_SHORT,
         (GLvoid*) (indices_offset * sizeof(U16)));
 }
 
+void LLVertexBuffer::drawRangeInstanced(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset, U32 instances) const
+{
+    llassert(validateRange(start, end, count, indices_offset));
+    llassert(isBound());
+    gGL.syncMatrices();
+    ++sDrawCount;
+    glDrawElementsInstanced(sGLMode[mode], count, GL_UNSIGNED_SHORT,
+        (GLvoid*) (indices_offset * sizeof(U16)), instances);
+}
+
+void LLVertexBuffer::drawRanges(U32 mode, const U32* counts, const U32* indices_offsets, U32 num_ranges) const
+{
+    llassert(isBound());
+
+    // only ever called from the render thread
+    static std::vector<GLsizei> gl_counts;
+    static std::vector<const GLvoid*> gl_offsets;
+    gl_counts.resize(num_ranges);
+    gl_offsets.resize(num_ranges);
+    for (U32 i = 0; i < num_ranges; ++i)
+    {
+        llassert(indices_offsets[i] + counts[i] <= mNumIndices);
+        gl_counts[i] = counts[i];
+        gl_offsets[i] = (const GLvoid*)(indices_offsets[i] * sizeof(U16));
+    }
+
+    gGL.syncMatrices();
+    ++sDrawCount;
+    glMultiDrawElements(sGLMode[mode], gl_counts.data(), GL_UNSIGNED_SHORT, gl_offsets.data(), num_ranges);
+}
+
 void LLVertexBuffer::draw(U32 mode, U32 count, U32 indices_offset) const
 {
     drawRange(mode, 0, mNumVerts-1, count, indices_offset);
@@ -754,10 +968,10 @@ void LLVertexBuffer::draw(U32 mode, U32 count, U32 indices_offset) const
 void LLVertexBuffer::drawArrays(U32 mode, U32 first, U32 count) const
 {
     llassert(first + count <= mNumVerts);
-    llassert(mGLBuffer == sGLRenderBuffer);
-    llassert(mGLIndices == sGLRenderIndices);
+    llassert(isBound());
     
     gGL.syncMatrices();
+    ++sDrawCount;
     glDrawArrays(sGLMode[mode], first, count);
 }
 
@@ -767,6 +981,17 @@ void LLVertexBuffer::initClass(LLWindow* window)
     llassert(sVBOPool == nullptr);
     sVBOPool = new LLVBOPool();
 
+    llassert(sStreamRing == nullptr);
+    if (sUseStreamRing && gGLManager.mHasBufferStorage)
+    {
+        sStreamRing = new LLStreamRing();
+        if (!sStreamRing->isValid())
+        {
+            delete sStreamRing;
+            sStreamRing = nullptr;
+        }
+    }
+
 #if ENABLE_GL_WORK_QUEUE
     sQueue = new GLWorkQueue();
 
@@ -781,6 +1006,8 @@ void LLVertexBuffer::initClass(LLWindow* window)
 //static 
 void LLVertexBuffer::unbind()
 {
+    bindDefaultVAO();
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
@@ -796,6 +1023,9 @@ void LLVertexBuffer::cleanupClass()
     delete sVBOPool;
     sVBOPool = nullptr;
 
+    delete sStreamRing;
+    sStreamRing = nullptr;
+
 #if ENABLE_GL_WORK_QUEUE
     sQueue->close();
     for (int i = 0; i < THREAD_COUNT; ++i)
@@ -914,6 +1144,9 @@ void LLVertexBuffer::genIndices(U32 size)
 
 bool LLVertexBuffer::createGLBuffer(U32 size)
 {
+	// cached vertex arrays hold the old names and offsets
+	destroyVAOs();
+
 	if (mGLBuffer || mMappedData)
 	{
 		destroyGLBuffer();
@@ -937,6 +1170,9 @@ bool LLVertexBuffer::createGLBuffer(U32 size)
 
 bool LLVertexBuffer::createGLIndices(U32 size)
 {
+	// cached vertex arrays hold the old names and offsets
+	destroyVAOs();
+
 	if (mGLIndices)
 	{
 		destroyGLIndices();
@@ -960,6 +1196,8 @@ bool LLVertexBuffer::createGLIndices(U32 size)
 
 void LLVertexBuffer::destroyGLBuffer()
 {
+	destroyVAOs();
+
 	if (mGLBuffer || mMappedData)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
@@ -977,6 +1215,8 @@ void LLVertexBuffer::destroyGLBuffer()
 
 void LLVertexBuffer::destroyGLIndices()
 {
+	destroyVAOs();
+
 	if (mGLIndices || mMappedIndexData)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
@@ -1080,6 +1320,11 @@ U8* LLVertexBuffer::mapVertexBuffer(LLVertexBuffer::AttributeType type, U32 inde
         count = mNumVerts - index;
     }
 
+    if (mMappedEntire)
+    { // region bookkeeping already covers the whole buffer, and may be happening on more than one thread
+        return mMappedData+mOffsets[type]+sTypeSize[type]*index;
+    }
+
     U32 start = mOffsets[type] + sTypeSize[type] * index;
     U32 end = start + sTypeSize[type] * count-1;
 
@@ -1114,6 +1359,11 @@ U8* LLVertexBuffer::mapIndexBuffer(U32 index, S32 count)
 		count = mNumIndices-index;
 	}
 
+    if (mMappedEntire)
+    {
+        return mMappedIndexData + sizeof(U16)*index;
+    }
+
     U32 start = sizeof(U16) * index;
     U32 end = start + sizeof(U16) * count-1;
 
@@ -1165,6 +1415,23 @@ static void flush_vbo(GLenum target, U32 start, U32 end, void* data)
     }
 }
 
+void LLVertexBuffer::mapEntireBuffer()
+{
+    mMappedVertexRegions.clear();
+    if (mSize > 0)
+    {
+        mMappedVertexRegions.push_back({ 0, mSize - 1 });
+    }
+
+    mMappedIndexRegions.clear();
+    if (mIndicesSize > 0)
+    {
+        mMappedIndexRegions.push_back({ 0, mIndicesSize - 1 });
+    }
+
+    mMappedEntire = true;
+}
+
 void LLVertexBuffer::unmapBuffer()
 {
     struct SortMappedRegion
@@ -1175,6 +1442,8 @@ void LLVertexBuffer::unmapBuffer()
         }
     };
 
+    mMappedEntire = false;
+
 	if (!mMappedVertexRegions.empty())
 	{
         LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("unmapBuffer - vertex");
@@ -1213,10 +1482,16 @@ void LLVertexBuffer::unmapBuffer()
 	{
         LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("unmapBuffer - index");
 
-        if (mGLIndices != sGLRenderIndices)
+        // the index binding is vertex array state, so leave any cached vertex
+        // array alone unless it's one of ours and already has mGLIndices bound
+        if (!sGLRenderVAO || !isBound())
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mGLIndices);
-            sGLRenderIndices = mGLIndices;
+            bindDefaultVAO();
+            if (mGLIndices != sGLRenderIndices)
+            {
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mGLIndices);
+                sGLRenderIndices = mGLIndices;
+            }
         }
         U32 start = 0;
         U32 end = 0;
@@ -1370,23 +1645,125 @@ void LLVertexBuffer::setBuffer()
         "Attribute mask mismatch! mTypeMask should be a superset of data_mask.  data_mask: 0x" 
                 << std::hex << data_mask << " mTypeMask: 0x" << mTypeMask << " Missing: 0x" << (data_mask & ~mTypeMask) <<  std::dec);
 
+    if (sUseVAOCache)
+    {
+        U32 vao = 0;
+        for (const auto& entry : mVAOs)
+        {
+            if (entry.first == data_mask)
+            {
+                vao = entry.second;
+                break;
+            }
+        }
+
+        if (!vao)
+        { // first bind with this mask, record the attribute setup and index binding
+            glGenVertexArrays(1, &vao);
+            glBindVertexArray(vao);
+            sGLRenderVAO = vao;
+            mVAOs.push_back(std::make_pair(data_mask, vao));
+
+            glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
+            sGLRenderBuffer = mGLBuffer;
+            for (U32 i = 0; i < TYPE_MAX; ++i)
+            {
+                if (data_mask & (1 << i))
+                {
+                    glEnableVertexAttribArray(i);
+                }
+            }
+            setupVertexBuffer();
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mGLIndices);
+
+            LLRender::countStateChange(LLRender::SC_BUFFER, true);
+            LLRender::countStateChange(LLRender::SC_VERTEX_FORMAT, true);
+        }
+        else
+        {
+            LLRender::countStateChange(LLRender::SC_BUFFER, sGLRenderVAO != vao);
+            LLRender::countStateChange(LLRender::SC_VERTEX_FORMAT, false);
+            if (sGLRenderVAO != vao)
+            {
+                glBindVertexArray(vao);
+                sGLRenderVAO = vao;
+            }
+        }
+        return;
+    }
+
+    bindDefaultVAO();
+
     if (sGLRenderBuffer != mGLBuffer)
     {
         glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
         sGLRenderBuffer = mGLBuffer;
 
         setupVertexBuffer();
+        LLRender::countStateChange(LLRender::SC_BUFFER, true);
+        LLRender::countStateChange(LLRender::SC_VERTEX_FORMAT, true);
     }
     else if (sLastMask != data_mask)
     {
         setupVertexBuffer();
         sLastMask = data_mask;
+        LLRender::countStateChange(LLRender::SC_BUFFER, false);
+        LLRender::countStateChange(LLRender::SC_VERTEX_FORMAT, true);
+    }
+    else
+    {
+        LLRender::countStateChange(LLRender::SC_BUFFER, false);
+        LLRender::countStateChange(LLRender::SC_VERTEX_FORMAT, false);
     }
     
     if (mGLIndices != sGLRenderIndices)
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mGLIndices);
         sGLRenderIndices = mGLIndices;
+        LLRender::countStateChange(LLRender::SC_BUFFER, true);
+    }
+    else
+    {
+        LLRender::countStateChange(LLRender::SC_BUFFER, false);
+    }
+}
+
+bool LLVertexBuffer::isBound() const
+{
+    if (sGLRenderVAO)
+    {
+        for (const auto& entry : mVAOs)
+        {
+            if (entry.second == sGLRenderVAO)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    return mGLBuffer == sGLRenderBuffer && mGLIndices == sGLRenderIndices;
+}
+
+void LLVertexBuffer::destroyVAOs()
+{
+    for (auto& entry : mVAOs)
+    {
+        if (entry.second == sGLRenderVAO)
+        {
+            bindDefaultVAO();
+        }
+        glDeleteVertexArrays(1, &entry.second);
+    }
+    mVAOs.clear();
+}
+
+//static
+void LLVertexBuffer::bindDefaultVAO()
+{
+    if (sGLRenderVAO)
+    {
+        glBindVertexArray(sDefaultVAO);
+        sGLRenderVAO = 0;
     }
 }
 
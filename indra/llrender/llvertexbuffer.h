@@ -79,6 +79,12 @@ public:
 	static void drawArrays(U32 mode, const std::vector<LLVector3>& pos);
 	static void drawElements(U32 mode, const LLVector4a* pos, const LLVector2* tc, U32 num_indices, const U16* indicesp);
 
+	// Draw count vertices of one-off geometry out of the persistently mapped
+	// streaming ring without creating a vertex buffer for them. tc and colors
+	// may be null. Returns false, having drawn nothing, if the ring isn't
+	// available or the bound shader needs attributes other than these.
+	static bool drawStreamed(U32 mode, U32 count, const LLVector4a* pos, const LLVector2* tc, const LLColor4U* colors);
+
  	static void unbind(); //unbind any bound vertex buffer
 
 	//get the size of a vertex with the given typemask
@@ -139,6 +145,15 @@ protected:
 
 	void setupVertexBuffer();
 
+	// true if setBuffer() has made this buffer current for drawing
+	bool isBound() const;
+	void destroyVAOs();
+
+	// return to the vertex array that LLRender::init bound, whose state is
+	// what sGLRenderIndices and sLastMask track, before touching index
+	// bindings or attribute enables outside of a cached vertex array
+	static void bindDefaultVAO();
+
 	void	genBuffer(U32 size);
 	void	genIndices(U32 size);
 	bool	createGLBuffer(U32 size);
@@ -159,6 +174,11 @@ public:
 	U8*		mapIndexBuffer(U32 index, S32 count = -1);
     void	unmapBuffer();
 
+    // flag the whole buffer as mapped so getXXXStrider calls skip mapped region bookkeeping until the next
+    // unmapBuffer(), which then uploads the entire buffer.  While in this state, threads other than the GL
+    // thread may fill disjoint ranges of the buffer concurrently; unmapBuffer() must still be called on the GL thread.
+    void	mapEntireBuffer();
+
 	// set for rendering
     // assumes (and will assert on) the following:
     //      - this buffer has no pending unampBuffer call
@@ -213,6 +233,11 @@ public:
 	void draw(U32 mode, U32 count, U32 indices_offset) const;
 	void drawArrays(U32 mode, U32 offset, U32 count) const;
     void drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const;
+    // as drawRange, instances times over (see gl_InstanceID)
+    void drawRangeInstanced(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset, U32 instances) const;
+    // draw num_ranges index ranges of this buffer with one glMultiDrawElements,
+    // counts and indices_offsets are as for drawRange
+    void drawRanges(U32 mode, const U32* counts, const U32* indices_offsets, U32 num_ranges) const;
 
 	//for debugging, validate data in given range is valid
 	bool validateRange(U32 start, U32 end, U32 count, U32 offset) const;
@@ -239,6 +264,11 @@ protected:
 
 	std::vector<MappedRegion> mMappedVertexRegions;  // list of mMappedData byte ranges that must be sent to GL
 	std::vector<MappedRegion> mMappedIndexRegions;   // list of mMappedIndexData byte ranges that must be sent to GL
+    bool    mMappedEntire = false;                   // if true, mapEntireBuffer was called and mMapped*Regions cover the whole buffer
+
+    // (shader attribute mask, vertex array object) pairs when sUseVAOCache is set,
+    // a buffer rarely sees more than a couple of masks so a linear search is fine
+    std::vector<std::pair<U32, U32> > mVAOs;
 
 private:
     // DEPRECATED
@@ -264,6 +294,11 @@ public:
 	static U32 sGLRenderIndices;
 	static U32 sLastMask;
 	static U32 sVertexCount;
+	static U32 sDrawCount;      // draw calls issued, reset by whoever samples it
+	static bool sUseStreamRing; // use the streaming ring on GL 4.4 and up, read by initClass
+	static bool sUseVAOCache;   // capture each buffer's attribute setup in a vertex array object, set before any buffer is bound
+	static U32 sDefaultVAO;     // vertex array bound by LLRender::init
+	static U32 sGLRenderVAO;    // cached vertex array currently bound, 0 if sDefaultVAO is
 };
 
 #ifdef LL_PROFILER_ENABLE_RENDER_DOC
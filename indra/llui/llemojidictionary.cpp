@@ -125,14 +125,11 @@ LLEmojiDictionary::LLEmojiDictionary()
 {
 }
 
-// static
-void LLEmojiDictionary::initClass()
+void LLEmojiDictionary::initSingleton()
 {
-    LLEmojiDictionary* pThis = &LLEmojiDictionary::initParamSingleton();
-
-    pThis->loadTranslations();
-    pThis->loadGroups();
-    pThis->loadEmojis();
+    loadTranslations();
+    loadGroups();
+    loadEmojis();
 }
 
 LLWString LLEmojiDictionary::findMatchingEmojis(const std::string& needle) const
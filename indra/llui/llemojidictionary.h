@@ -27,7 +27,6 @@
 #pragma once
 
 #include "lldictionary.h"
-#include "llinitdestroyclass.h"
 #include "llsingleton.h"
 
 // ============================================================================
@@ -75,10 +74,12 @@ struct LLEmojiSearchResult
 // LLEmojiDictionary class
 //
 
-class LLEmojiDictionary : public LLParamSingleton<LLEmojiDictionary>, public LLInitClass<LLEmojiDictionary>
+class LLEmojiDictionary : public LLSingleton<LLEmojiDictionary>
 {
     LLSINGLETON(LLEmojiDictionary);
     ~LLEmojiDictionary() override {};
+    // loads on first use
+    void initSingleton() override;
 
 public:
     typedef std::map<std::string, std::string> cat2cat_map_t;
@@ -87,7 +88,6 @@ public:
     typedef std::map<std::string, const LLEmojiDescriptor*> code2descr_map_t;
     typedef std::map<std::string, std::vector<const LLEmojiDescriptor*>> cat2descrs_map_t;
 
-    static void initClass();
     LLWString findMatchingEmojis(const std::string& needle) const;
     static bool searchInShortCode(std::size_t& begin, std::size_t& end, const std::string& shortCode, const std::string& needle);
     void findByShortCode(std::vector<LLEmojiSearchResult>& result, const std::string& needle) const;
@@ -662,6 +662,11 @@ void LLFloater::openFloater(const LLSD& key)
 	LLViewerEventRecorder::instance().logVisibilityChange( getPathname(), getName(), true,"floater"); // Last param is event subtype or empty string
 
 	mKey = key; // in case we need to open ourselves again
+
+	if (!getInstanceName().empty() && (key.isUndefined() || mSingleInstance))
+	{
+		LLFloaterReg::setShownUnkeyed(getInstanceName());
+	}
 	
 	if (getSoundFlags() != SILENT 
 	// don't play open sound for hosted (tabbed) windows
@@ -43,6 +43,7 @@ LLFloaterReg::build_map_t LLFloaterReg::sBuildMap;
 std::map<std::string,std::string> LLFloaterReg::sGroupMap;
 bool LLFloaterReg::sBlockShowFloaters = false;
 std::set<std::string> LLFloaterReg::sAlwaysShowableList;
+std::set<std::string> LLFloaterReg::sShownUnkeyed;
 
 static LLFloaterRegListener sFloaterRegListener;
 
@@ -63,6 +64,13 @@ bool LLFloaterReg::isRegistered(const std::string& name)
     return sBuildMap.find(name) != sBuildMap.end();
 }
 
+//static
+std::string LLFloaterReg::getFloaterFile(const std::string& name)
+{
+	build_map_t::const_iterator found = sBuildMap.find(name);
+	return (found != sBuildMap.end()) ? found->second.mFile : LLStringUtil::null;
+}
+
 //static
 LLFloater* LLFloaterReg::getLastFloaterInGroup(const std::string& name)
 {
@@ -230,6 +238,24 @@ bool LLFloaterReg::destroyInstance(const std::string& name, const LLSD& key)
 	}
 }
 
+//static
+bool LLFloaterReg::prebuildInstance(const std::string& name)
+{
+	return findInstance(name) || getInstance(name);
+}
+
+//static
+void LLFloaterReg::setShownUnkeyed(const std::string& name)
+{
+	sShownUnkeyed.insert(name);
+}
+
+//static
+bool LLFloaterReg::wasShownUnkeyed(const std::string& name)
+{
+	return sShownUnkeyed.find(name) != sShownUnkeyed.end();
+}
+
 // Iterators
 //static
 LLFloaterReg::const_instance_list_t& LLFloaterReg::getFloaterList(const std::string& name)
@@ -71,6 +71,7 @@ private:
 	 * Defines list of floater names that can be shown despite state of sBlockShowFloaters.
 	 */
 	static std::set<std::string> sAlwaysShowableList;
+	static std::set<std::string> sShownUnkeyed;
 	
 public:
 	// Registration
@@ -86,6 +87,8 @@ public:
 	static void add(const std::string& name, const std::string& file, const LLFloaterBuildFunc& func,
 					const std::string& groupname = LLStringUtil::null);
 	static bool isRegistered(const std::string& name);
+	// XUI file a registered floater is built from, or empty
+	static std::string getFloaterFile(const std::string& name);
 
 	// Helpers
 	static LLFloater* getLastFloaterInGroup(const std::string& name);
@@ -96,6 +99,13 @@ public:
 	static LLFloater* getInstance(const std::string& name, const LLSD& key = LLSD());
 	static LLFloater* removeInstance(const std::string& name, const LLSD& key = LLSD());
 	static bool destroyInstance(const std::string& name, const LLSD& key = LLSD());
+	// Builds the unkeyed instance hidden, ahead of its first showInstance().
+	// Returns false if it couldn't be built.
+	static bool prebuildInstance(const std::string& name);
+	// Set by LLFloater::openFloater() when opened without a key or single
+	// instance, so prebuilding name would build the instance that is shown.
+	static void setShownUnkeyed(const std::string& name);
+	static bool wasShownUnkeyed(const std::string& name);
 	
 	// Iterators
 	static const_instance_list_t& getFloaterList(const std::string& name);
@@ -152,6 +152,7 @@ LLFolderView::Params::Params()
 	show_empty_message("show_empty_message", true),
 	suppress_folder_menu("suppress_folder_menu", false),
 	use_ellipses("use_ellipses", false),
+	virtualize_rows("virtualize_rows", false),
     options_menu("options_menu", "")
 {
 	folder_indentation = -4;
@@ -179,6 +180,10 @@ LLFolderView::LLFolderView(const Params& p)
 	mShowSelectionContext(FALSE),
 	mShowSingleSelection(FALSE),
 	mArrangeGeneration(0),
+	mVirtualizeRows(p.virtualize_rows),
+	mViewportTop(0),
+	mViewportBottom(0),
+	mLastVisibleTop(0),
 	mSignalSelectCallback(0),
 	mMinWidth(0),
 	mDragAndDropThisFrame(FALSE),
@@ -315,6 +320,11 @@ S32 LLFolderView::arrange( S32* unused_width, S32* unused_height )
 	mMinWidth = 0;
 	S32 target_height;
 
+	if (getVirtualizeRows())
+	{
+		updateViewport();
+	}
+
 	LLFolderViewFolder::arrange(&mMinWidth, &target_height);
 
 	LLRect scroll_rect = (mScrollContainer ? mScrollContainer->getContentWindowRect() : LLRect());
@@ -329,9 +339,61 @@ S32 LLFolderView::arrange( S32* unused_width, S32* unused_height )
 	// move item renamer text field to item's new position
 	updateRenamerPosition();
 
+	if (!mDeferredArranges.empty())
+	{
+		updateDeferredArranges();
+	}
+
 	return ll_round(mTargetHeight);
 }
 
+bool LLFolderView::isOutsideViewport(S32 top, S32 height) const
+{
+	return top > mViewportBottom || top + height < mViewportTop;
+}
+
+void LLFolderView::addDeferredArrange(LLFolderViewFolder* folder)
+{
+	folder->setArrangeDeferred(true);
+	mDeferredArranges.push_back(folder->getHandle());
+}
+
+// Keep a page of rows above and below the visible ones laid out, so ordinary
+// scrolling doesn't uncover stale rows before the next update().
+void LLFolderView::updateViewport()
+{
+	LLRect visible_rect = mScrollContainer->getVisibleContentRect();
+	S32 margin = visible_rect.getHeight();
+	S32 height = getRect().getHeight();
+	mLastVisibleTop = height - visible_rect.mTop;
+	mViewportTop = mLastVisibleTop - margin;
+	mViewportBottom = height - visible_rect.mBottom + margin;
+}
+
+// Deferred folders that arrange() has since moved into range, for instance
+// because an estimated height above them was corrected, need a real layout.
+void LLFolderView::updateDeferredArranges()
+{
+	deferred_arranges_t::iterator out = mDeferredArranges.begin();
+	for (deferred_arranges_t::iterator it = mDeferredArranges.begin(); it != mDeferredArranges.end(); ++it)
+	{
+		LLFolderViewFolder* folderp = static_cast<LLFolderViewFolder*>(it->get());
+		if (!folderp)
+		{
+			continue;
+		}
+		if (folderp->needsArrange()
+			&& !isOutsideViewport(folderp->getArrangeTop(), folderp->getRect().getHeight()))
+		{
+			folderp->setArrangeDeferred(false);
+			folderp->requestArrange();
+			continue;
+		}
+		*out++ = *it;
+	}
+	mDeferredArranges.erase(out, mDeferredArranges.end());
+}
+
 void LLFolderView::filter( LLFolderViewFilter& filter )
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
@@ -1761,6 +1823,26 @@ void LLFolderView::update()
 
   BOOL is_visible = isInVisibleChain() || mForceArrange;
 
+  // scrolled more than half the margin: lay out whatever was skipped
+  if (is_visible && !mDeferredArranges.empty() && getVirtualizeRows())
+  {
+    LLRect visible_rect = mScrollContainer->getVisibleContentRect();
+    S32 visible_top = getRect().getHeight() - visible_rect.mTop;
+    if (llabs(visible_top - mLastVisibleTop) * 2 > visible_rect.getHeight())
+    {
+      for (deferred_arranges_t::iterator it = mDeferredArranges.begin(); it != mDeferredArranges.end(); ++it)
+      {
+        LLFolderViewFolder* folderp = static_cast<LLFolderViewFolder*>(it->get());
+        if (folderp)
+        {
+          folderp->setArrangeDeferred(false);
+          folderp->requestArrange();
+        }
+      }
+      mDeferredArranges.clear();
+    }
+  }
+
   //Puts folders/items in proper positions
   // arrange() takes the model filter flag into account and call sort() if necessary (CHUI-849)
   // It also handles the open/close folder animation
@@ -94,7 +94,8 @@ public:
 								show_empty_message,
 								use_ellipses,
 								show_item_link_overlays,
-								suppress_folder_menu;
+								suppress_folder_menu,
+								virtualize_rows;
 		Mandatory<LLFolderViewModelInterface*>	view_model;
 		Optional<LLFolderViewGroupedItemModel*> grouped_item_model;
         Mandatory<std::string>   options_menu;
@@ -144,6 +145,15 @@ public:
 	void arrangeAll() { mArrangeGeneration++; }
 	S32 getArrangeGeneration() { return mArrangeGeneration; }
 
+	// With virtualize_rows, arrange() only does the full layout work for rows
+	// within a page of the scrolled view. Folders further away keep their
+	// last (or an estimated) height until scrolling brings them nearer.
+	bool getVirtualizeRows() const { return mVirtualizeRows && mScrollContainer; }
+	// top is the distance from the top of this view
+	bool isOutsideViewport(S32 top, S32 height) const;
+	// folder skipped some layout work, to be redone once it comes into view
+	void addDeferredArrange(LLFolderViewFolder* folder);
+
 	// applies filters to control visibility of items
 	virtual void filter( LLFolderViewFilter& filter);
 
@@ -266,6 +276,8 @@ public:
 private:
 	void updateMenuOptions(LLMenuGL* menu);
 	void updateRenamerPosition();
+	void updateViewport();
+	void updateDeferredArranges();
 
 protected:
 	LLScrollContainer* mScrollContainer;  // NULL if this is not a child of a scroll container.
@@ -321,6 +333,14 @@ protected:
 	LLFrameTimer					mMultiSelectionFadeTimer;
 	S32								mArrangeGeneration;
 
+	bool							mVirtualizeRows;
+	// band of rows laid out in full, as distances from the top of this view
+	S32								mViewportTop,
+									mViewportBottom,
+									mLastVisibleTop;
+	typedef std::vector<LLHandle<LLView> > deferred_arranges_t;
+	deferred_arranges_t				mDeferredArranges;
+
 	signal_t						mSelectSignal;
 	signal_t						mReshapeSignal;
 	S32								mSignalSelectCallback;
@@ -418,6 +418,26 @@ S32 LLFolderViewItem::arrange( S32* width, S32* height )
 	return *height;
 }
 
+// Same as arrange(), minus the suffix refresh and the font metrics: the label
+// keeps the width it had last time, if any, until the row gets near the view.
+S32 LLFolderViewItem::arrangeOffscreen( S32* width, S32* height )
+{
+	mIndentation = (getParentFolder())
+		? getParentFolder()->getIndentation() + mLocalIndentation
+		: 0;
+	if (!mLabelWidthDirty)
+	{
+		*width = llmax(*width, mLabelWidth);
+	}
+
+	if (getRoot()->getUseEllipses())
+	{
+		*width = llmin(*width, getRoot()->getRect().getWidth());
+	}
+	*height = getItemHeight();
+	return *height;
+}
+
 S32 LLFolderViewItem::getItemHeight() const
 {
 	return mItemHeight;
@@ -1077,7 +1097,9 @@ LLFolderViewFolder::LLFolderViewFolder( const LLFolderViewItem::Params& p ):
 	mIsFolderComplete(false), // folder might have children that are not loaded yet.
 	mAreChildrenInited(false), // folder might have children that are not built yet.
 	mLastArrangeGeneration( -1 ),
-	mLastCalculatedWidth(0)
+	mLastCalculatedWidth(0),
+	mArrangeTop(0),
+	mArrangeDeferred(false)
 {
 }
 
@@ -1196,6 +1218,9 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 		{
 			// Add sizes of children
 			S32 parent_item_height = getRect().getHeight();
+			LLFolderView* root = getRoot();
+			bool virtualize = root->getVirtualizeRows();
+			bool has_virtual_rows = false;
 
 			for(folders_t::iterator fit = mFolders.begin(); fit != mFolders.end(); ++fit)
 			{
@@ -1207,8 +1232,18 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 					S32 child_width = *width;
 					S32 child_height = 0;
 					S32 child_top = parent_item_height - ll_round(running_height);
-
-					target_height += folderp->arrange( &child_width, &child_height );
+					folderp->mArrangeTop = mArrangeTop + ll_round(running_height);
+
+					if (virtualize
+						&& folderp->needsArrange()
+						&& root->isOutsideViewport(folderp->mArrangeTop, folderp->getRect().getHeight()))
+					{
+						target_height += folderp->deferArrange( &child_width, &child_height );
+					}
+					else
+					{
+						target_height += folderp->arrange( &child_width, &child_height );
+					}
 
 					running_height += (F32)child_height;
 					*width = llmax(*width, child_width);
@@ -1227,7 +1262,16 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 					S32 child_height = 0;
 					S32 child_top = parent_item_height - ll_round(running_height);
 
-					target_height += itemp->arrange( &child_width, &child_height );
+					if (virtualize
+						&& root->isOutsideViewport(mArrangeTop + ll_round(running_height), itemp->getRect().getHeight()))
+					{
+						target_height += itemp->arrangeOffscreen( &child_width, &child_height );
+						has_virtual_rows = true;
+					}
+					else
+					{
+						target_height += itemp->arrange( &child_width, &child_height );
+					}
 					// don't change width, as this item is as wide as its parent folder by construction
 					itemp->reshape( itemp->getRect().getWidth(), child_height);
 
@@ -1236,6 +1280,11 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 					itemp->setOrigin( 0, child_top - itemp->getRect().getHeight() );
 				}
 			}
+
+			if (has_virtual_rows && !mArrangeDeferred)
+			{
+				root->addDeferredArrange(this);
+			}
 		}
 
 		mTargetHeight = target_height;
@@ -1295,6 +1344,42 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height )
 	return ll_round(mTargetHeight);
 }
 
+// Virtualized rows: a folder whose layout is out of date but which lies well
+// outside the visible area keeps its last height instead of rearranging its
+// whole subtree. If it was never laid out, guess a row per visible child.
+// needsArrange() stays true, so the root arranges it for real once it scrolls
+// into range.
+S32 LLFolderViewFolder::deferArrange( S32* width, S32* height )
+{
+	if (mTargetHeight <= 0.f)
+	{
+		S32 rows = 1;
+		if (isOpen())
+		{
+			for (items_t::iterator iit = mItems.begin(); iit != mItems.end(); ++iit)
+			{
+				rows += (*iit)->isPotentiallyVisible() ? 1 : 0;
+			}
+			for (folders_t::iterator fit = mFolders.begin(); fit != mFolders.end(); ++fit)
+			{
+				rows += (*fit)->isPotentiallyVisible() ? 1 : 0;
+			}
+		}
+		mTargetHeight = (F32)(rows * getItemHeight());
+		mCurHeight = mTargetHeight;
+		reshape(getRect().getWidth(), ll_round(mCurHeight));
+	}
+
+	*width = llmax(*width, mLastCalculatedWidth);
+	*height = ll_round(mCurHeight);
+
+	if (!mArrangeDeferred)
+	{
+		getRoot()->addDeferredArrange(this);
+	}
+	return ll_round(mTargetHeight);
+}
+
 BOOL LLFolderViewFolder::needsArrange()
 {
 	return mLastArrangeGeneration < getRoot()->getArrangeGeneration();
@@ -178,6 +178,8 @@ public:
 	// Finds width and height of this object and it's children.  Also
 	// makes sure that this view and it's children are the right size.
 	virtual S32 arrange( S32* width, S32* height );
+	// arrange() for a row well outside the visible area: skips measuring the label
+	S32 arrangeOffscreen( S32* width, S32* height );
 	virtual S32 getItemHeight() const;
     virtual S32 getLabelXPos();
     S32 getIconPad();
@@ -341,6 +343,8 @@ protected:
 	F32			mAutoOpenCountdown;
 	S32			mLastArrangeGeneration;
 	S32			mLastCalculatedWidth;
+	S32			mArrangeTop; // distance from the top of the root, for virtualized rows
+	bool		mArrangeDeferred; // registered with the root as needing layout later
 	bool		mIsFolderComplete; // indicates that some children were not loaded/added yet
 	bool		mAreChildrenInited; // indicates that no children were initialized
 
@@ -365,8 +369,12 @@ public:
 	// Finds width and height of this object and it's children.  Also
 	// makes sure that this view and it's children are the right size.
 	virtual S32 arrange( S32* width, S32* height );
+	// stands in for arrange() while the folder is far from the visible area
+	S32 deferArrange( S32* width, S32* height );
 
 	BOOL needsArrange();
+	S32 getArrangeTop() const { return mArrangeTop; }
+	void setArrangeDeferred(bool deferred) { mArrangeDeferred = deferred; }
 
 	bool descendantsPassedFilter(S32 filter_generation = -1);
 
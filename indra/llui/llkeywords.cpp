@@ -68,12 +68,15 @@ inline bool LLKeywordToken::isTail(const llwchar* s) const
 }
 
 LLKeywords::LLKeywords()
-:	mLoaded(false)
+:	mLoaded(false),
+	mMinWordLength(0),
+	mMaxWordLength(0)
 {
 }
 
 LLKeywords::~LLKeywords()
 {
+	mWordTokenIndex.clear();
 	std::for_each(mWordTokenMap.begin(), mWordTokenMap.end(), DeletePairedPointer());
 	mWordTokenMap.clear();
 	std::for_each(mLineTokenList.begin(), mLineTokenList.end(), DeletePointer());
@@ -110,7 +113,13 @@ void LLKeywords::addToken(LLKeywordToken::ETokenType type,
 	case LLKeywordToken::TT_SECTION:
 	case LLKeywordToken::TT_TYPE:
 	case LLKeywordToken::TT_WORD:
-		mWordTokenMap[key] = new LLKeywordToken(type, color, key, tool_tip, LLWStringUtil::null);
+		{
+			LLKeywordToken* token = new LLKeywordToken(type, color, key, tool_tip, LLWStringUtil::null);
+			mWordTokenMap[key] = token;
+			mWordTokenIndex[WStringMapIndex(token->getToken().data(), key.size())] = token;
+			mMinWordLength = mMinWordLength ? llmin(mMinWordLength, key.size()) : key.size();
+			mMaxWordLength = llmax(mMaxWordLength, key.size());
+		}
 		break;
 
 	case LLKeywordToken::TT_LINE:
@@ -475,32 +484,66 @@ bool LLKeywords::WStringMapIndex::operator<(const LLKeywords::WStringMapIndex &o
 	return result;
 }
 
+bool LLKeywords::WStringMapIndex::operator==(const LLKeywords::WStringMapIndex &other) const
+{
+	return mLength == other.mLength
+		&& (mData == other.mData || !memcmp(mData, other.mData, mLength * sizeof(llwchar)));
+}
+
+size_t LLKeywords::WStringMapIndex::Hash::operator()(const LLKeywords::WStringMapIndex& index) const
+{
+	// FNV-1a over the characters
+	U64 hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < index.mLength; ++i)
+	{
+		hash = (hash ^ (U64)index.mData[i]) * 1099511628211ULL;
+	}
+	return (size_t)hash;
+}
+
 LLTrace::BlockTimerStatHandle FTM_SYNTAX_COLORING("Syntax Coloring");
 
 // Walk through a string, applying the rules specified by the keyword token list and
 // create a list of color segments.
 void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLWString& wtext, const LLColor4 &defaultColor, LLTextEditor& editor)
 {
-	LL_RECORD_BLOCK_TIME(FTM_SYNTAX_COLORING);
-	seg_list->clear();
-
 	if( wtext.empty() )
 	{
+		seg_list->clear();
 		return;
 	}
 
+	findSegments(seg_list, wtext, defaultColor, editor, 0, S32_MAX, stop_check_t());
+}
+
+S32 LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLWString& wtext, const LLColor4 &defaultColor, LLTextEditor& editor,
+							 S32 start, S32 min_end, const stop_check_t& can_stop)
+{
+	LL_RECORD_BLOCK_TIME(FTM_SYNTAX_COLORING);
+	seg_list->clear();
+
 	S32 text_len = wtext.size() + 1;
+	S32 stop = text_len;
 
-	seg_list->push_back( new LLNormalTextSegment( defaultColor, 0, text_len, editor ) );
+	seg_list->push_back( new LLNormalTextSegment( defaultColor, start, text_len, editor ) );
 
 	const llwchar* base = wtext.c_str();
-	const llwchar* cur = base;
+	const llwchar* first = base + start;
+	const llwchar* cur = first;
 	while( *cur )
 	{
-		if( *cur == '\n' || cur == base )
+		if( *cur == '\n' || cur == first )
 		{
 			if( *cur == '\n' )
 			{
+				S32 line_break = cur - base;
+				if( line_break >= min_end && can_stop && can_stop( line_break ) )
+				{
+					// Everything past here colors the same as it did before.
+					stop = line_break;
+					break;
+				}
+
 				LLTextSegmentPtr text_segment = new LLLineBreakTextSegment(cur-base);
 				text_segment->setToken( 0 );
 				insertSegment( *seg_list, text_segment, text_len, defaultColor, editor);
@@ -672,9 +715,12 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
 				S32 seg_len = p - cur;
 				if( seg_len > 0 )
 				{
-					WStringMapIndex word( cur, seg_len );
-					word_token_map_t::iterator map_iter = mWordTokenMap.find(word);
-					if( map_iter != mWordTokenMap.end() )
+					std::unordered_map<WStringMapIndex, LLKeywordToken*, WStringMapIndex::Hash>::const_iterator map_iter = mWordTokenIndex.end();
+					if( (size_t)seg_len >= mMinWordLength && (size_t)seg_len <= mMaxWordLength )
+					{
+						map_iter = mWordTokenIndex.find(WStringMapIndex( cur, seg_len ));
+					}
+					if( map_iter != mWordTokenIndex.end() )
 					{
 						LLKeywordToken* cur_token = map_iter->second;
 						S32 seg_start = cur - base;
@@ -695,6 +741,20 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
 			}
 		}
 	}
+
+	if( stop < text_len )
+	{
+		// Drop the default run trailing off to the end of the text.
+		if( seg_list->back()->getStart() >= stop )
+		{
+			seg_list->pop_back();
+		}
+		else
+		{
+			seg_list->back()->setEnd( stop );
+		}
+	}
+	return stop;
 }
 
 void LLKeywords::insertSegments(const LLWString& wtext, std::vector<LLTextSegmentPtr>& seg_list, LLKeywordToken* cur_token, S32 text_len, S32 seg_start, S32 seg_end, const LLColor4 &defaultColor, LLTextEditor& editor )
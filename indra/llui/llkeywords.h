@@ -35,6 +35,8 @@
 #include <map>
 #include <list>
 #include <deque>
+#include <functional>
+#include <unordered_map>
 #include "llpointer.h"
 
 class LLTextSegment;
@@ -117,6 +119,18 @@ public:
 							 const LLWString& text,
 							 const LLColor4 &defaultColor,
 							 class LLTextEditor& editor);
+	// Colors text from start, which must begin a line outside any delimited
+	// run, and stops at the first line break at or after min_end for which
+	// can_stop returns true. The segments cover start up to the returned
+	// position, which is text.size() + 1 if the end of the text was reached.
+	typedef std::function<bool (S32 line_break)> stop_check_t;
+	S32			findSegments(std::vector<LLTextSegmentPtr> *seg_list,
+							 const LLWString& text,
+							 const LLColor4 &defaultColor,
+							 class LLTextEditor& editor,
+							 S32 start,
+							 S32 min_end,
+							 const stop_check_t& can_stop);
 	void		initialize(LLSD SyntaxXML);
 	void		processTokens();
 
@@ -145,6 +159,12 @@ public:
 		WStringMapIndex(const llwchar *start, size_t length);
 		~WStringMapIndex();
 		bool operator<(const WStringMapIndex &other) const;
+		bool operator==(const WStringMapIndex &other) const;
+
+		struct Hash
+		{
+			size_t operator()(const WStringMapIndex& index) const;
+		};
 	private:
 		void copyData(const llwchar *start, size_t length);
 		const llwchar *mData;
@@ -187,6 +207,11 @@ protected:
 	bool		mLoaded;
 	LLSD		mSyntax;
 	word_token_map_t mWordTokenMap;
+	// Lookup side of mWordTokenMap used while coloring. The keys point into
+	// the tokens' own strings.
+	std::unordered_map<WStringMapIndex, LLKeywordToken*, WStringMapIndex::Hash> mWordTokenIndex;
+	size_t		mMinWordLength;
+	size_t		mMaxWordLength;
 	typedef std::deque<LLKeywordToken*> token_list_t;
 	token_list_t mLineTokenList;
 	token_list_t mDelimiterTokenList;
@@ -30,6 +30,8 @@
 #include "llui.h"
 
 /*static*/ std::stack<LLRect> LLScreenClipRect::sClipRectStack;
+/*static*/ std::stack<std::pair<std::stack<LLRect>, LLCoordGL> > LLScreenClipRect::sOffscreenStack;
+/*static*/ LLCoordGL LLScreenClipRect::sScissorOffset(0, 0);
 
 
 LLScreenClipRect::LLScreenClipRect(const LLRect& rect, BOOL enabled)
@@ -77,6 +79,27 @@ void LLScreenClipRect::popClipRect()
 	sClipRectStack.pop();
 }
 
+//static
+void LLScreenClipRect::pushOffscreenTarget(const LLRect& screen_rect, S32 x_offset, S32 y_offset)
+{
+	gGL.flush();
+	sOffscreenStack.push(std::make_pair(sClipRectStack, sScissorOffset));
+	sClipRectStack = std::stack<LLRect>();
+	sClipRectStack.push(screen_rect);
+	sScissorOffset.set(x_offset, y_offset);
+	updateScissorRegion();
+}
+
+//static
+void LLScreenClipRect::popOffscreenTarget()
+{
+	gGL.flush();
+	sClipRectStack = sOffscreenStack.top().first;
+	sScissorOffset = sOffscreenStack.top().second;
+	sOffscreenStack.pop();
+	updateScissorRegion();
+}
+
 //static
 void LLScreenClipRect::updateScissorRegion()
 {
@@ -92,7 +115,7 @@ void LLScreenClipRect::updateScissorRegion()
 	y = llfloor(rect.mBottom * LLUI::getScaleFactor().mV[VY]);
 	w = llmax(0, llceil(rect.getWidth() * LLUI::getScaleFactor().mV[VX])) + 1;
 	h = llmax(0, llceil(rect.getHeight() * LLUI::getScaleFactor().mV[VY])) + 1;
-	glScissor( x,y,w,h );
+	glScissor( x - sScissorOffset.mX, y - sScissorOffset.mY, w, h );
 	stop_glerror();
 }
 
@@ -25,6 +25,7 @@
 #ifndef LLLOCALCLIPRECT_H
 #define LLLOCALCLIPRECT_H
 
+#include "llcoord.h"
 #include "llgl.h"
 #include "llrect.h"		// can't forward declare, it's templated
 #include <stack>
@@ -41,6 +42,12 @@ public:
 	LLScreenClipRect(const LLRect& rect, BOOL enabled = TRUE);
 	virtual ~LLScreenClipRect();
 
+	// While drawing into an offscreen target that covers screen_rect, with its
+	// lower left corner at pixel (x_offset, y_offset) of the window. Clip rects
+	// pushed meanwhile clip to screen_rect only, and scissor in target pixels.
+	static void pushOffscreenTarget(const LLRect& screen_rect, S32 x_offset, S32 y_offset);
+	static void popOffscreenTarget();
+
 private:
 	static void pushClipRect(const LLRect& rect);
 	static void popClipRect();
@@ -51,6 +58,8 @@ private:
 	BOOL			mEnabled;
 
 	static std::stack<LLRect> sClipRectStack;
+	static std::stack<std::pair<std::stack<LLRect>, LLCoordGL> > sOffscreenStack;
+	static LLCoordGL sScissorOffset;
 };
 
 class LLLocalClipRect : public LLScreenClipRect
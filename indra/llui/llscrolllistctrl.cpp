@@ -58,6 +58,7 @@
 #include "llmenugl.h"
 #include "llurlaction.h"
 #include "lltooltip.h"
+#include "workqueue.h"
 
 #include <boost/bind.hpp>
 
@@ -120,6 +121,67 @@ struct SortScrollListItem
 	const bool mAltSort;
 };
 
+// Lists at least this long are sorted on the "General" thread pool when
+// draw() finds them unsorted.
+static const size_t ASYNC_SORT_MIN_ITEMS = 2000;
+
+// The values SortScrollListItem would compare, taken once per item and
+// sort column instead of once per comparison.
+struct KeyedScrollListItem
+{
+	struct Key
+	{
+		std::string	mValue;
+		std::string	mAltValue;
+		bool		mValid;		// false when the item has no such cell
+	};
+
+	LLScrollListItem*	mItem;
+	std::vector<Key>	mKeys;		// in sort order list order
+};
+
+struct SortKeyedScrollListItem
+{
+	SortKeyedScrollListItem(const std::vector<std::pair<S32, BOOL> >& sort_orders, bool alternate_sort)
+	:	mSortOrders(sort_orders)
+	,	mAltSort(alternate_sort)
+	{}
+
+	bool operator()(const KeyedScrollListItem& i1, const KeyedScrollListItem& i2) const
+	{
+		// same precedence as SortScrollListItem: the last sort order first
+		S32 sort_result = 0;
+		for (S32 k = (S32)mSortOrders.size() - 1; k >= 0; --k)
+		{
+			const KeyedScrollListItem::Key& key1 = i1.mKeys[k];
+			const KeyedScrollListItem::Key& key2 = i2.mKeys[k];
+			if (!key1.mValid || !key2.mValid)
+			{
+				continue;
+			}
+
+			S32 order = mSortOrders[k].second ? 1 : -1;
+			if (mAltSort && !key1.mAltValue.empty() && !key2.mAltValue.empty())
+			{
+				sort_result = order * LLStringUtil::compareDict(key1.mAltValue, key2.mAltValue);
+			}
+			else
+			{
+				sort_result = order * LLStringUtil::compareDict(key1.mValue, key2.mValue);
+			}
+			if (sort_result != 0)
+			{
+				break;
+			}
+		}
+		return sort_result < 0;
+	}
+
+	// a copy, so that it can outlive the list on a worker thread
+	const std::vector<std::pair<S32, BOOL> > mSortOrders;
+	const bool mAltSort;
+};
+
 //---------------------------------------------------------------------------
 // LLScrollListCtrl
 //---------------------------------------------------------------------------
@@ -201,6 +263,8 @@ LLScrollListCtrl::LLScrollListCtrl(const LLScrollListCtrl::Params& p)
 	mTotalStaticColumnWidth(0),
 	mTotalColumnPadding(0),
 	mSorted(false),
+	mAsyncSortID(0),
+	mAsyncSortPending(false),
 	mDirty(false),
 	mOriginalSelection(-1),
 	mLastSelected(NULL),
@@ -628,16 +692,19 @@ BOOL LLScrollListCtrl::addItem( LLScrollListItem* item, EAddPosition pos, BOOL r
 			addColumn(col_params);
 		}
 
-		S32 num_cols = item->getNumColumns();
-		S32 i = 0;
-		for (LLScrollListCell* cell = item->getColumn(i); i < num_cols; cell = item->getColumn(++i))
+		if (item->isMaterialized())
 		{
-			if (i >= (S32)mColumnsIndexed.size()) break;
+			S32 num_cols = item->getNumColumns();
+			S32 i = 0;
+			for (LLScrollListCell* cell = item->getColumn(i); i < num_cols; cell = item->getColumn(++i))
+			{
+				if (i >= (S32)mColumnsIndexed.size()) break;
 
-			cell->setWidth(mColumnsIndexed[i]->getWidth());
-		}
+				cell->setWidth(mColumnsIndexed[i]->getWidth());
+			}
 
-		updateLineHeightInsert(item);
+			updateLineHeightInsert(item);
+		}
 
 		updateLayout();
 	}
@@ -668,6 +735,8 @@ S32 LLScrollListCtrl::calcMaxContentWidth()
 			item_list::iterator iter;
 			for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 			{
+				// virtual rows only count once they have been shown
+				if (!(*iter)->isMaterialized()) continue;
 				LLScrollListCell* cellp = (*iter)->getColumn(column->mIndex);
 				if (!cellp) continue;
 
@@ -722,6 +791,7 @@ void LLScrollListCtrl::updateLineHeight()
 	for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 	{
 		LLScrollListItem *itemp = *iter;
+		if (!itemp->isMaterialized()) continue;
 		S32 num_cols = itemp->getNumColumns();
 		S32 i = 0;
 		for (const LLScrollListCell* cell = itemp->getColumn(i); i < num_cols; cell = itemp->getColumn(++i))
@@ -811,6 +881,8 @@ void LLScrollListCtrl::updateColumns(bool force_update)
 		for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 		{
 			LLScrollListItem *itemp = *iter;
+			// virtual rows pick up the widths when they get their cells
+			if (!itemp->isMaterialized()) continue;
 			S32 num_cols = itemp->getNumColumns();
 			S32 i = 0;
 			for (LLScrollListCell* cell = itemp->getColumn(i); i < num_cols; cell = itemp->getColumn(++i))
@@ -828,6 +900,7 @@ void LLScrollListCtrl::updateColumns(bool force_update)
         for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
         {
             LLScrollListItem *itemp = *iter;
+            if (!itemp->isMaterialized()) continue;
             LLScrollListCell* cell = itemp->getColumn(index);
             if (cell)
             {
@@ -1706,7 +1779,15 @@ void LLScrollListCtrl::draw()
 	LLLocalClipRect clip(getLocalRect());
 
 	// if user specifies sort, make sure it is maintained
-	updateSort();
+	if (hasSortOrder() && !isSorted() && !mSortCallback && mItemList.size() >= ASYNC_SORT_MIN_ITEMS)
+	{
+		// long lists keep their current order until the sort comes back
+		startAsyncSort();
+	}
+	else
+	{
+		updateSort();
+	}
 
 	if (mNeedsScroll)
 	{
@@ -2785,16 +2866,128 @@ void LLScrollListCtrl::updateSort() const
 {
 	if (hasSortOrder() && !isSorted())
 	{
-		// do stable sort to preserve any previous sorts
-		std::stable_sort(
-			mItemList.begin(), 
-			mItemList.end(), 
-			SortScrollListItem(mSortColumns,mSortCallback, mAlternateSort));
+		// a synchronous sort wins over any sort still running
+		++mAsyncSortID;
+
+		if (mSortCallback)
+		{
+			// do stable sort to preserve any previous sorts
+			std::stable_sort(
+				mItemList.begin(), 
+				mItemList.end(), 
+				SortScrollListItem(mSortColumns,mSortCallback, mAlternateSort));
+		}
+		else
+		{
+			std::vector<KeyedScrollListItem> keyed_items;
+			getSortKeys(keyed_items);
+			std::stable_sort(keyed_items.begin(), keyed_items.end(), SortKeyedScrollListItem(mSortColumns, mAlternateSort));
+			for (size_t i = 0; i < keyed_items.size(); ++i)
+			{
+				mItemList[i] = keyed_items[i].mItem;
+			}
+		}
 
 		mSorted = true;
 	}
 }
 
+void LLScrollListCtrl::getSortKeys(std::vector<KeyedScrollListItem>& keyed_items) const
+{
+	keyed_items.resize(mItemList.size());
+	for (size_t i = 0; i < mItemList.size(); ++i)
+	{
+		LLScrollListItem* item = mItemList[i];
+		KeyedScrollListItem& keyed = keyed_items[i];
+		keyed.mItem = item;
+		keyed.mKeys.resize(mSortColumns.size());
+		for (size_t k = 0; k < mSortColumns.size(); ++k)
+		{
+			S32 col_idx = mSortColumns[k].first;
+			KeyedScrollListItem::Key& key = keyed.mKeys[k];
+
+			// virtual rows sort on their keys without building their cells
+			if (!item->isMaterialized()
+				&& col_idx < (S32)mColumnsIndexed.size()
+				&& mColumnsIndexed[col_idx]
+				&& item->mSortKeys.has(mColumnsIndexed[col_idx]->mName))
+			{
+				key.mValue = item->mSortKeys[mColumnsIndexed[col_idx]->mName].asString();
+				key.mValid = true;
+				continue;
+			}
+
+			const LLScrollListCell* cell = item->getColumn(col_idx);
+			key.mValid = (cell != NULL);
+			if (cell)
+			{
+				key.mValue = cell->getValue().asString();
+				if (mAlternateSort)
+				{
+					key.mAltValue = cell->getAltValue().asString();
+				}
+			}
+		}
+	}
+}
+
+void LLScrollListCtrl::startAsyncSort()
+{
+	if (mAsyncSortPending)
+	{
+		return;
+	}
+
+	LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!main_queue || !general_queue)
+	{
+		updateSort();
+		return;
+	}
+
+	// the keys are taken here, the worker only ever compares strings
+	std::shared_ptr<std::vector<KeyedScrollListItem> > keyed_items = std::make_shared<std::vector<KeyedScrollListItem> >();
+	getSortKeys(*keyed_items);
+	std::shared_ptr<item_list> snapshot = std::make_shared<item_list>(mItemList);
+	SortKeyedScrollListItem sorter(mSortColumns, mAlternateSort);
+	U32 sort_id = ++mAsyncSortID;
+	LLHandle<LLView> handle = getHandle();
+	mAsyncSortPending = true;
+
+	bool posted = main_queue->postTo(
+		general_queue,
+		[keyed_items, sorter]()
+		{
+			std::stable_sort(keyed_items->begin(), keyed_items->end(), sorter);
+		},
+		[handle, keyed_items, snapshot, sort_id]()
+		{
+			LLScrollListCtrl* self = static_cast<LLScrollListCtrl*>(handle.get());
+			if (!self)
+			{
+				return;
+			}
+			self->mAsyncSortPending = false;
+
+			// drop it when anything sorted, added or removed items meanwhile
+			if (sort_id != self->mAsyncSortID || *snapshot != self->mItemList)
+			{
+				return;
+			}
+			for (size_t i = 0; i < keyed_items->size(); ++i)
+			{
+				self->mItemList[i] = (*keyed_items)[i].mItem;
+			}
+			self->mSorted = true;
+		});
+	if (!posted)
+	{
+		mAsyncSortPending = false;
+		updateSort();
+	}
+}
+
 // for one-shot sorts, does not save sort column/order
 void LLScrollListCtrl::sortOnce(S32 column, BOOL ascending)
 {
@@ -3177,6 +3370,53 @@ LLScrollListItem* LLScrollListCtrl::addRow(LLScrollListItem *new_item, const LLS
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
 	if (!item_p.validateBlock() || !new_item) return NULL;
+	buildCells(new_item, item_p);
+	addItem(new_item, pos);
+	return new_item;
+}
+
+LLScrollListItem* LLScrollListCtrl::addVirtualRow(const LLSD& value, const LLSD& sort_keys, EAddPosition pos)
+{
+	if (mRowProvider.empty())
+	{
+		LL_WARNS() << "No row provider set for virtual rows in " << getName() << LL_ENDL;
+		return NULL;
+	}
+	if (mColumns.empty())
+	{
+		// needs the columns up front: a virtual row can't add any before
+		// it has been shown
+		LL_WARNS() << "Virtual rows need predefined columns in " << getName() << LL_ENDL;
+		return NULL;
+	}
+
+	LLScrollListItem::Params item_p;
+	item_p.value(value);
+	LLScrollListItem* new_item = new LLScrollListItem(item_p);
+	new_item->mVirtualOwner = this;
+	new_item->mSortKeys = sort_keys;
+	if (!addItem(new_item, pos))
+	{
+		delete new_item;
+		return NULL;
+	}
+	return new_item;
+}
+
+void LLScrollListCtrl::materializeRow(LLScrollListItem* item)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+	item->mVirtualOwner = NULL;
+
+	LLScrollListItem::Params item_p;
+	LLParamSDParser parser;
+	parser.readSD(mRowProvider(item->getValue()), item_p);
+	buildCells(item, item_p);
+	updateLineHeightInsert(item);
+}
+
+void LLScrollListCtrl::buildCells(LLScrollListItem* new_item, const LLScrollListItem::Params& item_p)
+{
 	new_item->setNumColumns(mColumns.size());
 
 	// Add any columns we don't already have
@@ -3276,9 +3516,6 @@ LLScrollListItem* LLScrollListCtrl::addRow(LLScrollListItem *new_item, const LLS
 			new_item->setColumn(column_idx, new LLScrollListSpacer(cell_p));
 		}
 	}
-
-	addItem(new_item, pos);
-	return new_item;
 }
 
 LLScrollListItem* LLScrollListCtrl::addSimpleElement(const std::string& value, EAddPosition pos, const LLSD& id)
@@ -49,6 +49,7 @@
 class LLScrollListCell;
 class LLTextBox;
 class LLContextMenu;
+struct KeyedScrollListItem;
 
 class LLScrollListCtrl : public LLUICtrl, public LLEditMenuHandler, 
 	public LLCtrlListInterface, public LLCtrlScrollInterface
@@ -191,6 +192,16 @@ public:
 	virtual void clearRows(); // clears all elements
 	virtual void sortByColumn(const std::string& name, BOOL ascending);
 
+	// Virtual rows, for lists with thousands of rows: the list only keeps
+	// each row's value and the sort_keys map of column name => value to
+	// sort on, and gets the rest of the row (an element as for addElement())
+	// from the row provider when the row is first shown or its cells are
+	// asked for. The columns must exist beforehand, and only shown rows
+	// count towards dynamic column widths.
+	typedef boost::function<LLSD (const LLSD& value)> row_provider_t;
+	void			setRowProvider(const row_provider_t& provider) { mRowProvider = provider; }
+	LLScrollListItem* addVirtualRow(const LLSD& value, const LLSD& sort_keys = LLSD(), EAddPosition pos = ADD_BOTTOM);
+
 	// These functions take and return an array of arrays of elements, as above
 	virtual void	setValue(const LLSD& value );
 	virtual LLSD	getValue() const;
@@ -456,9 +467,15 @@ protected:
 	void			updateLineHeight();
 
 private:
+	friend class LLScrollListItem;
+
 	void			drawItems();
 	
 	void            updateLineHeightInsert(LLScrollListItem* item);
+	void			buildCells(LLScrollListItem* new_item, const LLScrollListItem::Params& item_p);
+	void			materializeRow(LLScrollListItem* item);
+	void			getSortKeys(std::vector<KeyedScrollListItem>& keyed_items) const;
+	void			startAsyncSort();
 	void			reportInvalidInput();
 	BOOL			isRepeatedChars(const LLWString& string) const;
 	void			selectItem(LLScrollListItem* itemp, S32 cell, BOOL single_select = TRUE);
@@ -541,6 +558,9 @@ private:
 	S32				mTotalColumnPadding;
 
 	mutable bool	mSorted;
+	mutable U32		mAsyncSortID;		// bumped by every sort, stale async results are dropped
+	bool			mAsyncSortPending;
+	row_provider_t	mRowProvider;
 	
 	typedef std::map<std::string, LLScrollListColumn*> column_map_t;
 	column_map_t mColumns;
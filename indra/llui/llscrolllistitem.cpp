@@ -30,6 +30,7 @@
 #include "llscrolllistitem.h"
 
 #include "llrect.h"
+#include "llscrolllistctrl.h"
 #include "llui.h"
 
 
@@ -45,7 +46,8 @@ LLScrollListItem::LLScrollListItem( const Params& p )
 	mEnabled(p.enabled),
 	mUserdata(p.userdata),
 	mItemValue(p.value),
-	mItemAltValue(p.alt_value)
+	mItemAltValue(p.alt_value),
+	mVirtualOwner(NULL)
 {
 }
 
@@ -115,11 +117,13 @@ void LLScrollListItem::setColumn( S32 column, LLScrollListCell *cell )
 
 S32 LLScrollListItem::getNumColumns() const
 {
+	materialize();
 	return mColumns.size();
 }
 
 LLScrollListCell* LLScrollListItem::getColumn(const S32 i) const
 {
+	materialize();
 	if (0 <= i && i < (S32)mColumns.size())
 	{
 		return mColumns[i];
@@ -127,6 +131,14 @@ LLScrollListCell* LLScrollListItem::getColumn(const S32 i) const
 	return NULL;
 }
 
+void LLScrollListItem::materialize() const
+{
+	if (mVirtualOwner)
+	{
+		mVirtualOwner->materializeRow(const_cast<LLScrollListItem*>(this));
+	}
+}
+
 std::string LLScrollListItem::getContentsCSV() const
 {
 	std::string ret;
@@ -114,6 +114,11 @@ public:
 
 	LLScrollListCell *getColumn(const S32 i) const;
 
+	// Rows added with LLScrollListCtrl::addVirtualRow() have no cells until
+	// something draws them or asks for a cell.
+	bool	isMaterialized() const			{ return !mVirtualOwner; }
+	void	materialize() const;
+
 	std::string getContentsCSV() const;
 
 	virtual void draw(const LLRect& rect,
@@ -137,6 +142,10 @@ private:
 	LLSD	mItemAltValue;
 	std::vector<LLScrollListCell *> mColumns;
 	LLRect  mRectangle;
+
+	// Set until a virtual row has its cells
+	LLScrollListCtrl* mVirtualOwner;
+	LLSD	mSortKeys;
 };
 
 #endif
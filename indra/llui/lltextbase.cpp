@@ -1667,6 +1667,7 @@ void LLTextBase::reflow()
 
 		// shrink document to minimum size (visible portion of text widget)
 		// to force inlined widgets with follows set to shrink
+		S32 old_document_width = mDocumentView->getRect().getWidth();
 		if (mWordWrap)
 		{
 			mDocumentView->reshape(mVisibleTextRect.getWidth(), mDocumentView->getRect().getHeight());
@@ -1696,6 +1697,9 @@ void LLTextBase::reflow()
             }
 		}
 
+		// segments before this one keep their lines
+		segment_set_t::iterator first_reflowed_seg = seg_iter;
+
 		S32 line_height = 0;
 		S32 seg_line_offset = line_count + 1;
 
@@ -1786,9 +1790,15 @@ void LLTextBase::reflow()
 		}
 
 		// calculate visible region for diplaying text
-		updateRects();
+		bool lines_moved = updateRects();
 
-		for (segment_set_t::iterator segment_it = mSegments.begin();
+		// only segments on reflowed lines need new layout, unless the whole
+		// document moved or changed width
+		if (lines_moved || mDocumentView->getRect().getWidth() != old_document_width)
+		{
+			first_reflowed_seg = mSegments.begin();
+		}
+		for (segment_set_t::iterator segment_it = first_reflowed_seg;
 			segment_it != mSegments.end();
 			++segment_it)
 		{
@@ -2985,9 +2995,10 @@ S32 LLTextBase::getEditableIndex(S32 index, bool increasing_direction)
 	}
 }
 
-void LLTextBase::updateRects()
+bool LLTextBase::updateRects()
 {
 	LLRect old_text_rect = mVisibleTextRect;
+	bool lines_moved = false;
 	mVisibleTextRect = mScroller ? mScroller->getContentWindowRect() : getLocalRect();
 
 	if (mLineInfoList.empty()) 
@@ -3029,6 +3040,7 @@ void LLTextBase::updateRects()
 			it->mRect.translate(0, delta_pos);
 		}
 		mTextBoundingRect.translate(0, delta_pos);
+		lines_moved = (delta_pos != 0);
 	}
 
 	// update document container dimensions according to text contents
@@ -3106,6 +3118,7 @@ void LLTextBase::updateRects()
 				it->mRect.translate(0, delta_pos);
 			}
 			mTextBoundingRect.translate(0, delta_pos);
+			lines_moved = true;
 		}
 	}
 
@@ -3132,6 +3145,8 @@ void LLTextBase::updateRects()
 		}
 	}
 	mDocumentView->setShape(doc_rect);
+
+	return lines_moved;
 }
 
 
@@ -3772,13 +3787,15 @@ void LLInlineViewSegment::linkToDocument(LLTextBase* editor)
 	editor->addDocumentChild(mView);
 }
 
-LLLineBreakTextSegment::LLLineBreakTextSegment(S32 pos):LLTextSegment(pos,pos+1)
+LLLineBreakTextSegment::LLLineBreakTextSegment(S32 pos):LLTextSegment(pos,pos+1),
+	mToken(NULL)
 {
 	LLStyleSP s( new LLStyle(LLStyle::Params().visible(true)));
 
 	mFontHeight = s->getFont()->getLineHeight();
 }
-LLLineBreakTextSegment::LLLineBreakTextSegment(LLStyleConstSP style,S32 pos):LLTextSegment(pos,pos+1)
+LLLineBreakTextSegment::LLLineBreakTextSegment(LLStyleConstSP style,S32 pos):LLTextSegment(pos,pos+1),
+	mToken(NULL)
 {
 	mFontHeight = style->getFont()->getLineHeight();
 }
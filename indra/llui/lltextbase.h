@@ -254,8 +254,14 @@ public:
 	S32			getNumChars(S32 num_pixels, S32 segment_offset, S32 line_offset, S32 max_chars, S32 line_ind) const;
 	F32			draw(S32 start, S32 end, S32 selection_start, S32 selection_end, const LLRectf& draw_rect);
 
+	// Delimited run the break falls inside, if any, so syntax coloring can
+	// tell where it may restart.
+	/*virtual*/ void				setToken( LLKeywordToken* token )	{ mToken = token; }
+	/*virtual*/ LLKeywordToken*		getToken() const					{ return mToken; }
+
 private:
 	S32			mFontHeight;
+	LLKeywordToken* mToken;
 };
 
 class LLImageTextSegment : public LLTextSegment
@@ -637,7 +643,7 @@ protected:
 	void 							endSelection();
 
 	// misc
-	void							updateRects();
+	bool							updateRects(); // returns true if the lines moved
 	void							needsScroll() { mScrollNeeded = TRUE; }
 
 	struct URLLabelCallback;
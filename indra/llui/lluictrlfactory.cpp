@@ -31,7 +31,13 @@
 
 #include "llxmlnode.h"
 
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <boost/tokenizer.hpp>
 
 // other library includes
@@ -40,6 +46,8 @@
 #include "v4color.h"
 #include "v3dmath.h"
 #include "llquaternion.h"
+#include "lltimer.h"
+#include "workqueue.h"
 
 // this library includes
 #include "llpanel.h"
@@ -156,6 +164,124 @@ void LLUICtrlFactory::createChildren(LLView* viewp, LLXMLNodePtr node, const wid
 //-----------------------------------------------------------------------------
 // getLayeredXMLNode()
 //-----------------------------------------------------------------------------
+
+namespace
+{
+	const U32 XML_CACHE_MAGIC = 0x42495558; // "XUIB"
+	const U32 XML_CACHE_VERSION = 1;
+
+	std::string sXMLCacheDir;
+	// merged trees already read this session, by source paths
+	std::map<std::string, std::string> sXMLCacheEntries;
+	std::deque<std::string> sPrewarmQueue;
+	std::set<std::string> sPrewarmed;
+
+	struct PreloadedXML
+	{
+		PreloadedXML(const std::string& filename) : mFilename(filename), mDone(false), mSuccess(false), mSeconds(0.0) {}
+
+		std::string		mFilename;
+		LLXMLNodePtr	mRoot;
+		bool			mDone;
+		bool			mSuccess;
+		F64				mSeconds;
+	};
+	typedef std::shared_ptr<PreloadedXML> preloaded_xml_ptr_t;
+
+	std::mutex sPreloadMutex;
+	std::condition_variable sPreloadDone;
+	// preloads not yet taken by getLayeredXMLNode(), by source paths
+	std::map<std::string, preloaded_xml_ptr_t> sPreloads;
+	// preloads not yet reported by waitForPreloads()
+	std::vector<preloaded_xml_ptr_t> sPreloadJobs;
+
+	std::string xml_cache_key(const std::vector<std::string>& paths)
+	{
+		std::string key = paths.front();
+		for (size_t i = 1; i < paths.size(); ++i)
+		{
+			key += '\n' + paths[i];
+		}
+		return key;
+	}
+
+	void run_preload(const std::vector<std::string>& paths, preloaded_xml_ptr_t preload)
+	{
+		F64 start = LLTimer::getTotalSeconds();
+		LLXMLNodePtr root;
+		bool success = LLXMLNode::getLayeredXMLNode(root, paths);
+
+		std::lock_guard<std::mutex> lock(sPreloadMutex);
+		preload->mRoot = root;
+		preload->mSuccess = success;
+		preload->mSeconds = LLTimer::getTotalSeconds() - start;
+		preload->mDone = true;
+		sPreloadDone.notify_all();
+	}
+
+	// Hands over the preloaded tree for key, waiting for its parse if needed.
+	bool take_preloaded_xml(const std::string& key, LLXMLNodePtr& root, bool& success)
+	{
+		std::unique_lock<std::mutex> lock(sPreloadMutex);
+		std::map<std::string, preloaded_xml_ptr_t>::iterator found = sPreloads.find(key);
+		if (found == sPreloads.end())
+		{
+			return false;
+		}
+		preloaded_xml_ptr_t preload = found->second;
+		sPreloads.erase(found);
+		sPreloadDone.wait(lock, [preload]() { return preload->mDone; });
+		root = preload->mRoot;
+		success = preload->mSuccess;
+		return true;
+	}
+
+	// The source paths and their modification times and sizes, which a cache
+	// entry has to match to be used.
+	std::string xml_cache_stamp(const std::vector<std::string>& paths)
+	{
+		std::ostringstream stamp;
+		for (const std::string& path : paths)
+		{
+			llstat stat_data;
+			if (LLFile::stat(path, &stat_data) == 0)
+			{
+				stamp << path << '|' << (S64)stat_data.st_mtime << '|' << (S64)stat_data.st_size << '\n';
+			}
+			else
+			{
+				stamp << path << "|-\n";
+			}
+		}
+		return stamp.str();
+	}
+
+	std::string xml_cache_filename(const std::string& key)
+	{
+		return gDirUtilp->add(sXMLCacheDir, llformat("%016llx.xui", (U64)std::hash<std::string>()(key)));
+	}
+
+	bool read_xml_cache_entry(const std::string& data, const std::string& stamp, LLXMLNodePtr& root)
+	{
+		std::istringstream input(data);
+		U32 magic = 0;
+		U32 version = 0;
+		input.read((char*)&magic, sizeof(magic));
+		input.read((char*)&version, sizeof(version));
+		if (!input.good() || magic != XML_CACHE_MAGIC || version != XML_CACHE_VERSION)
+		{
+			return false;
+		}
+		std::string cached_stamp;
+		std::getline(input, cached_stamp, '\0');
+		if (cached_stamp != stamp)
+		{
+			return false;
+		}
+		return LLXMLNode::readBinary(input, root);
+	}
+}
+
 bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNodePtr& root,
                                         LLDir::ESkinConstraint constraint)
 {
@@ -169,7 +295,160 @@ bool LLUICtrlFactory::getLayeredXMLNode(const std::string &xui_filename, LLXMLNo
 		paths.push_back(xui_filename);
 	}
 
-	return LLXMLNode::getLayeredXMLNode(root, paths);
+	std::string key = xml_cache_key(paths);
+	bool preload_success = false;
+	if (take_preloaded_xml(key, root, preload_success))
+	{
+		return preload_success;
+	}
+
+	if (sXMLCacheDir.empty())
+	{
+		return LLXMLNode::getLayeredXMLNode(root, paths);
+	}
+
+	std::string stamp = xml_cache_stamp(paths);
+
+	std::map<std::string, std::string>::iterator found = sXMLCacheEntries.find(key);
+	if (found != sXMLCacheEntries.end() && read_xml_cache_entry(found->second, stamp, root))
+	{
+		return true;
+	}
+
+	std::string cache_filename = xml_cache_filename(key);
+	llifstream cache_file(cache_filename, std::ios::in | std::ios::binary);
+	if (cache_file.is_open())
+	{
+		std::ostringstream data;
+		data << cache_file.rdbuf();
+		cache_file.close();
+		if (read_xml_cache_entry(data.str(), stamp, root))
+		{
+			sXMLCacheEntries[key] = data.str();
+			return true;
+		}
+	}
+
+	if (!LLXMLNode::getLayeredXMLNode(root, paths))
+	{
+		return false;
+	}
+
+	std::ostringstream data;
+	data.write((const char*)&XML_CACHE_MAGIC, sizeof(XML_CACHE_MAGIC));
+	data.write((const char*)&XML_CACHE_VERSION, sizeof(XML_CACHE_VERSION));
+	data << stamp << '\0';
+	LLXMLNode::writeBinary(data, root);
+	sXMLCacheEntries[key] = data.str();
+
+	// write to a temporary name first, another viewer instance may be reading
+	std::string temp_filename = cache_filename + ".tmp";
+	llofstream out_file(temp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (out_file.is_open())
+	{
+		out_file << data.str();
+		out_file.close();
+		if (LLFile::rename(temp_filename, cache_filename, TRUE) != 0)
+		{
+			LLFile::remove(temp_filename);
+		}
+	}
+	return true;
+}
+
+//static
+void LLUICtrlFactory::setXMLCacheDir(const std::string& cache_dir)
+{
+	sXMLCacheDir = cache_dir;
+	sXMLCacheEntries.clear();
+	if (!sXMLCacheDir.empty() && !LLFile::isdir(sXMLCacheDir) && LLFile::mkdir(sXMLCacheDir) != 0)
+	{
+		LL_WARNS() << "Could not create XUI cache directory " << sXMLCacheDir << LL_ENDL;
+		sXMLCacheDir.clear();
+	}
+}
+
+//static
+void LLUICtrlFactory::preloadLayeredXMLNode(const std::string& filename, LLDir::ESkinConstraint constraint)
+{
+	std::vector<std::string> paths =
+		gDirUtilp->findSkinnedFilenames(LLDir::XUI, filename, constraint);
+	if (paths.empty())
+	{
+		paths.push_back(filename);
+	}
+	std::string key = xml_cache_key(paths);
+
+	preloaded_xml_ptr_t preload = std::make_shared<PreloadedXML>(filename);
+	{
+		std::lock_guard<std::mutex> lock(sPreloadMutex);
+		if (!sPreloads.insert(std::make_pair(key, preload)).second)
+		{
+			return;
+		}
+		sPreloadJobs.push_back(preload);
+	}
+
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!general_queue || !general_queue->post([paths, preload]() { run_preload(paths, preload); }))
+	{
+		run_preload(paths, preload);
+	}
+}
+
+//static
+void LLUICtrlFactory::waitForPreloads()
+{
+	std::unique_lock<std::mutex> lock(sPreloadMutex);
+	for (const preloaded_xml_ptr_t& preload : sPreloadJobs)
+	{
+		sPreloadDone.wait(lock, [&preload]() { return preload->mDone; });
+		LL_INFOS("AppInit") << "Parsed " << preload->mFilename << " in " << preload->mSeconds << " seconds"
+			<< (preload->mSuccess ? "" : " (failed)") << LL_ENDL;
+	}
+	sPreloadJobs.clear();
+}
+
+//static
+void LLUICtrlFactory::queuePrewarm(const std::string& filename)
+{
+	if (!filename.empty() && sPrewarmed.insert(filename).second)
+	{
+		sPrewarmQueue.push_back(filename);
+	}
+}
+
+//static
+bool LLUICtrlFactory::prewarmNext()
+{
+	if (sPrewarmQueue.empty())
+	{
+		return true;
+	}
+	std::string filename = sPrewarmQueue.front();
+	sPrewarmQueue.pop_front();
+
+	LLXMLNodePtr root;
+	if (getLayeredXMLNode(filename, root))
+	{
+		// panels and floaters built from their own files
+		std::vector<LLXMLNodePtr> nodes(1, root);
+		while (!nodes.empty())
+		{
+			LLXMLNodePtr node = nodes.back();
+			nodes.pop_back();
+			std::string referenced_filename;
+			if (node->getAttributeString("filename", referenced_filename))
+			{
+				queuePrewarm(referenced_filename);
+			}
+			for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+			{
+				nodes.push_back(child);
+			}
+		}
+	}
+	return sPrewarmQueue.empty();
 }
 
 
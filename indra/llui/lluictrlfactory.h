@@ -194,6 +194,23 @@ fail:
 	static bool getLayeredXMLNode(const std::string &filename, LLXMLNodePtr& root,
 								  LLDir::ESkinConstraint constraint=LLDir::CURRENT_SKIN);
 
+	// Keep the merged XML of each XUI file, for the current skin and language,
+	// in a binary cache in cache_dir, checked against the modification times
+	// of the files it was merged from. An empty cache_dir turns it off.
+	static void setXMLCacheDir(const std::string& cache_dir);
+	// Load filename, and the files its panels reference, into the cache ahead
+	// of time, one file per prewarmNext() call. prewarmNext() returns true once
+	// there is nothing left to load, to suit doOnIdleRepeating().
+	static void queuePrewarm(const std::string& filename);
+	static bool prewarmNext();
+	// Parse filename on the "General" thread pool. The next getLayeredXMLNode()
+	// of the same file waits for that parse and takes its tree, so independent
+	// files can be parsed side by side while startup goes on.
+	static void preloadLayeredXMLNode(const std::string& filename,
+									  LLDir::ESkinConstraint constraint=LLDir::CURRENT_SKIN);
+	// Block until every preload has finished, and log how long each one took.
+	static void waitForPreloads();
+
 private:
 	//NOTE: both friend declarations are necessary to keep both gcc and msvc happy
 	template <typename T> friend class LLChildRegistry;
@@ -46,6 +46,7 @@ public:
 	void logFloater(const std::string& floater);
 	void logPanel(const std::string& p);
 	LLSD asLLSD() const;
+	const std::map<std::string,U32>& getFloaterCounts() const { return mFloaterCounts; }
 	void clear();
 private:
 	std::map<std::string,U32> mCommandCounts;
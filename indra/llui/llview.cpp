@@ -36,6 +36,7 @@
 #include <boost/bind.hpp>
 
 #include "llrender.h"
+#include "llrendertarget.h"
 #include "llevent.h"
 #include "llfocusmgr.h"
 #include "llrect.h"
@@ -50,6 +51,7 @@
 #include "llsdserialize.h"
 #include "llviewereventrecorder.h"
 #include "llkeyboard.h"
+#include "lllocalcliprect.h"
 // for ui edit hack
 #include "llbutton.h"
 #include "lllineeditor.h"
@@ -68,12 +70,15 @@ bool	LLView::sDebugKeys = false;
 bool	LLView::sDebugMouseHandling = false;
 std::string LLView::sMouseHandlerMessage;
 BOOL	LLView::sForceReshape = FALSE;
+S32		LLView::sViewCount = 0;
 std::set<LLView*> LLView::sPreviewHighlightedElements;
 BOOL LLView::sHighlightingDiffs = FALSE;
 LLView* LLView::sPreviewClickedElement = NULL;
 BOOL	LLView::sDrawPreviewHighlights = FALSE;
 S32		LLView::sLastLeftXML = S32_MIN;
 S32		LLView::sLastBottomXML = S32_MIN;
+U32		LLView::sChildTreeGeneration = 1;
+bool	LLView::sInChildLookup = false;
 std::vector<LLViewDrawContext*> LLViewDrawContext::sDrawContextStack;
 
 LLView::DrilldownFunc LLView::sDrilldown =
@@ -143,6 +148,7 @@ LLView::Params::Params()
 LLView::LLView(const LLView::Params& p)
 :	mVisible(p.visible),
 	mInDraw(false),
+	mDrawCacheDirty(true),
 	mName(p.name),
 	mParentView(NULL),
 	mReshapeFlags(FOLLOWS_NONE),
@@ -157,15 +163,18 @@ LLView::LLView(const LLView::Params& p)
 	mDefaultTabGroup(p.default_tab_group),
 	mLastTabGroup(0),
 	mToolTipMsg((LLStringExplicit)p.tool_tip()),
-	mDefaultWidgets(NULL)
+	mDefaultWidgets(NULL),
+	mChildNameIndexGeneration(0)
 {
 	// create rect first, as this will supply initial follows flags
 	setShape(p.rect);
 	parseFollowsFlags(p);
+	++sViewCount;
 }
 
 LLView::~LLView()
 {
+	--sViewCount;
 	dirtyRect();
 	//LL_INFOS() << "Deleting view " << mName << ":" << (void*) this << LL_ENDL;
 	if (LLView::sIsDrawing)
@@ -264,6 +273,7 @@ void LLView::sendChildToFront(LLView* child)
 		{
 			mChildList.remove( child );
 			mChildList.push_front(child);
+			++sChildTreeGeneration;
 		}
 	}
 }
@@ -279,6 +289,7 @@ void LLView::sendChildToBack(LLView* child)
 		{
 			mChildList.remove( child );
 			mChildList.push_back(child);
+			++sChildTreeGeneration;
 		}
 	}
 }
@@ -304,6 +315,7 @@ bool LLView::addChild(LLView* child, S32 tab_group)
 
 	// add to front of child list, as normal
 	mChildList.push_front(child);
+	++sChildTreeGeneration;
 
 	// add to tab order list
 	if (tab_group != 0)
@@ -345,6 +357,7 @@ void LLView::removeChild(LLView* child)
 		llassert(child->mInDraw == false);
 		mChildList.remove( child );
 		child->mParentView = NULL;
+		++sChildTreeGeneration;
 		child_tab_order_t::iterator found = mTabOrder.find(child);
 		if(found != mTabOrder.end())
 		{
@@ -580,6 +593,7 @@ void LLView::deleteAllChildren()
 {
 	// clear out the control ordering
 	mTabOrder.clear();
+	++sChildTreeGeneration;
 
 	while (!mChildList.empty())
 	{
@@ -1213,7 +1227,14 @@ void LLView::drawChildren()
 						LLUI::translate((F32)viewp->getRect().mLeft, (F32)viewp->getRect().mBottom);
 						// flag the fact we are in draw here, in case overridden draw() method attempts to remove this widget
 						viewp->mInDraw = true;
-						viewp->draw();
+						if (viewp->mDrawCache)
+						{
+							viewp->drawCached();
+						}
+						else
+						{
+							viewp->draw();
+						}
 						viewp->mInDraw = false;
 
 						if (sDebugRects)
@@ -1238,6 +1259,8 @@ void LLView::drawChildren()
 
 void LLView::dirtyRect()
 {
+	invalidateDrawCache();
+
 	LLView* child = getParent();
 	LLView* parent = child ? child->getParent() : NULL;
 	LLView* cur = this;
@@ -1356,7 +1379,14 @@ void LLView::drawChild(LLView* childp, S32 x_offset, S32 y_offset, BOOL force_dr
 			LLUI::pushMatrix();
 			{
 				LLUI::translate((F32)childp->getRect().mLeft + x_offset, (F32)childp->getRect().mBottom + y_offset);
-				childp->draw();
+				if (childp->mDrawCache)
+				{
+					childp->drawCached();
+				}
+				else
+				{
+					childp->draw();
+				}
 			}
 			LLUI::popMatrix();
 		}
@@ -1365,6 +1395,134 @@ void LLView::drawChild(LLView* childp, S32 x_offset, S32 y_offset, BOOL force_dr
 	}
 }
 
+void LLView::setDrawCached(bool cached)
+{
+	if (cached && !mDrawCache)
+	{
+		mDrawCache.reset(new LLRenderTarget());
+		mDrawCacheDirty = true;
+	}
+	else if (!cached)
+	{
+		mDrawCache.reset();
+	}
+}
+
+void LLView::invalidateDrawCache()
+{
+	for (LLView* viewp = this; viewp; viewp = viewp->mParentView)
+	{
+		if (viewp->mDrawCache)
+		{
+			viewp->mDrawCacheDirty = true;
+		}
+	}
+}
+
+void LLView::drawCached()
+{
+	static LLUICachedControl<F32> refresh_interval("UIDrawCacheRefreshInterval", 0.25f);
+	// set while a cached view draws into its copy; cached views inside it draw live
+	static bool capturing = false;
+
+	LLRect screen_rect = calcScreenRect();
+	S32 mouse_x, mouse_y;
+	LLUI::getInstance()->getMousePositionScreen(&mouse_x, &mouse_y);
+	if (capturing
+		|| screen_rect.pointInRect(mouse_x, mouse_y)
+		|| gFocusMgr.childHasKeyboardFocus(this)
+		|| gFocusMgr.childHasMouseCapture(this)
+		|| LLView::sDebugRects)
+	{
+		// changing under the user's hands: draw live, and redraw the copy once
+		// they are done with it
+		mDrawCacheDirty = true;
+		draw();
+		return;
+	}
+
+	const LLVector2& scale = LLUI::getScaleFactor();
+	S32 left = llfloor(screen_rect.mLeft * scale.mV[VX]);
+	S32 bottom = llfloor(screen_rect.mBottom * scale.mV[VY]);
+	U32 width = (U32)llmax(1, llceil(screen_rect.mRight * scale.mV[VX]) - left);
+	U32 height = (U32)llmax(1, llceil(screen_rect.mTop * scale.mV[VY]) - bottom);
+
+	if (mDrawCacheDirty
+		|| screen_rect != mDrawCacheScreenRect
+		|| mDrawCacheAge.getElapsedTimeF32() > refresh_interval
+		|| !mDrawCache->isComplete()
+		|| mDrawCache->getWidth() != width
+		|| mDrawCache->getHeight() != height)
+	{
+		if (!mDrawCache->isComplete()
+			|| mDrawCache->getWidth() != width
+			|| mDrawCache->getHeight() != height)
+		{
+			mDrawCache->release();
+			if (!mDrawCache->allocate(width, height, GL_RGBA))
+			{
+				mDrawCache->release();
+				draw();
+				return;
+			}
+		}
+
+		gGL.flush();
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		GLfloat clear_color[4];
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+
+		mDrawCache->bindTarget();
+		// keep drawing in window coordinates, shifted onto the target
+		glViewport(viewport[0] - left, viewport[1] - bottom, viewport[2], viewport[3]);
+		gGL.setColorMask(true, true);
+		glClearColor(0.f, 0.f, 0.f, 0.f);
+		mDrawCache->clear();
+		glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+
+		capturing = true;
+		gGL.setPremultipliedAlphaTarget(true);
+		gGL.setSceneBlendType(LLRender::BT_ALPHA);
+		{
+			LLGLEnable scissor(GL_SCISSOR_TEST);
+			LLScreenClipRect::pushOffscreenTarget(screen_rect, left, bottom);
+			draw();
+			LLScreenClipRect::popOffscreenTarget();
+		}
+		gGL.setPremultipliedAlphaTarget(false);
+		gGL.setSceneBlendType(LLRender::BT_ALPHA);
+		capturing = false;
+
+		mDrawCache->flush();
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		gGL.setColorMask(true, false);
+
+		mDrawCacheScreenRect = screen_rect;
+		mDrawCacheAge.reset();
+		mDrawCacheDirty = false;
+	}
+
+	// the copy starts on the whole pixel at or below our origin
+	F32 x0 = (F32)left / scale.mV[VX] - (F32)screen_rect.mLeft;
+	F32 y0 = (F32)bottom / scale.mV[VY] - (F32)screen_rect.mBottom;
+	F32 x1 = x0 + (F32)width / scale.mV[VX];
+	F32 y1 = y0 + (F32)height / scale.mV[VY];
+
+	gGL.getTexUnit(0)->bind(mDrawCache.get());
+	gGL.blendFunc(LLRender::BF_ONE, LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+	gGL.color4f(1.f, 1.f, 1.f, 1.f);
+	gGL.begin(LLRender::TRIANGLE_STRIP);
+	{
+		gGL.texCoord2f(0.f, 0.f);	gGL.vertex2f(x0, y0);
+		gGL.texCoord2f(1.f, 0.f);	gGL.vertex2f(x1, y0);
+		gGL.texCoord2f(0.f, 1.f);	gGL.vertex2f(x0, y1);
+		gGL.texCoord2f(1.f, 1.f);	gGL.vertex2f(x1, y1);
+	}
+	gGL.end();
+	gGL.setSceneBlendType(LLRender::BT_ALPHA);
+	gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+}
 
 void LLView::reshape(S32 width, S32 height, BOOL called_from_parent)
 {
@@ -1612,7 +1770,41 @@ LLView* LLView::getChildView(const std::string& name, BOOL recurse) const
 LLView* LLView::findChildView(const std::string& name, BOOL recurse) const
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
-	
+
+	if (!recurse || sInChildLookup)
+	{
+		return searchChildView(name, recurse);
+	}
+
+	if (!mChildNameIndex)
+	{
+		mChildNameIndex.reset(new child_name_index_t());
+		mChildNameIndexGeneration = sChildTreeGeneration;
+	}
+	else if (mChildNameIndexGeneration != sChildTreeGeneration)
+	{
+		mChildNameIndex->clear();
+		mChildNameIndexGeneration = sChildTreeGeneration;
+	}
+	child_name_index_t::const_iterator found = mChildNameIndex->find(name);
+	if (found != mChildNameIndex->end())
+	{
+		return found->second;
+	}
+
+	sInChildLookup = true;
+	LLView* viewp = searchChildView(name, recurse);
+	sInChildLookup = false;
+	// a lookup that changed the tree can't be trusted to stay right
+	if (mChildNameIndexGeneration == sChildTreeGeneration)
+	{
+		(*mChildNameIndex)[name] = viewp;
+	}
+	return viewp;
+}
+
+LLView* LLView::searchChildView(const std::string& name, BOOL recurse) const
+{
     // Look for direct children *first*
 	BOOST_FOREACH(LLView* childp, mChildList)
 	{
@@ -47,12 +47,16 @@
 #include "lluictrlfactory.h"
 #include "lltreeiterators.h"
 #include "llfocusmgr.h"
+#include "llframetimer.h"
 
 #include <list>
+#include <memory>
+#include <unordered_map>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 
 class LLSD;
+class LLRenderTarget;
 
 const U32	FOLLOWS_NONE	= 0x00;
 const U32	FOLLOWS_LEFT	= 0x01;
@@ -237,7 +241,7 @@ public:
 	void		setFollowsAll()					{ mReshapeFlags |= FOLLOWS_ALL; }
 
 	void        setSoundFlags(U8 flags)			{ mSoundFlags = flags; }
-	void		setName(std::string name)			{ mName = name; }
+	void		setName(std::string name)			{ mName = name; ++sChildTreeGeneration; }
 	void		setUseBoundingRect( BOOL use_bounding_rect );
 	BOOL		getUseBoundingRect() const;
 
@@ -308,6 +312,14 @@ public:
 	void			popVisible()				{ setVisible(mLastVisible); }
 	BOOL			getLastVisible()	const	{ return mLastVisible; }
 
+	// Draw this view and its children from an offscreen copy, redrawn only
+	// after invalidateDrawCache(), a reshape or a move. While the mouse is
+	// over the view or it holds focus or capture, it draws live instead.
+	void			setDrawCached(bool cached);
+	bool			getDrawCached() const		{ return mDrawCache != nullptr; }
+	// Have the cached views containing this one redraw their copy
+	void			invalidateDrawCache();
+
 	U32			getFollows() const				{ return mReshapeFlags; }
 	BOOL		followsLeft() const				{ return mReshapeFlags & FOLLOWS_LEFT; }
 	BOOL		followsRight() const			{ return mReshapeFlags & FOLLOWS_RIGHT; }
@@ -337,7 +349,7 @@ public:
 	LLView*		findPrevSibling(LLView* child);
 	LLView*		findNextSibling(LLView* child);
 	S32			getChildCount()	const			{ return (S32)mChildList.size(); }
-	template<class _Pr3> void sortChildren(_Pr3 _Pred) { mChildList.sort(_Pred); }
+	template<class _Pr3> void sortChildren(_Pr3 _Pred) { mChildList.sort(_Pred); ++sChildTreeGeneration; }
 	BOOL		hasAncestor(const LLView* parentp) const;
 	BOOL		hasChild(const std::string& childname, BOOL recurse = FALSE) const;
 	BOOL 		childHasKeyboardFocus( const std::string& childname ) const;
@@ -539,6 +551,7 @@ protected:
 	void			drawDebugRect();
 	void			drawChild(LLView* childp, S32 x_offset = 0, S32 y_offset = 0, BOOL force_draw = FALSE);
 	void			drawChildren();
+	void			drawCached();
 	bool			visibleAndContains(S32 local_x, S32 local_Y);
 	bool			visibleEnabledAndContains(S32 local_x, S32 local_y);
 	void			logMouseEvent();
@@ -616,6 +629,11 @@ private:
 
 	bool		mInDraw;
 
+	std::unique_ptr<LLRenderTarget>	mDrawCache;
+	LLRect		mDrawCacheScreenRect;
+	LLFrameTimer mDrawCacheAge;
+	bool		mDrawCacheDirty;
+
 	static LLWindow* sWindow;	// All root views must know about their window.
 
 	typedef std::map<std::string, LLView*> default_widget_map_t;
@@ -624,6 +642,19 @@ private:
 
 	LLView& getDefaultWidgetContainer() const;
 
+	LLView* searchChildView(const std::string& name, BOOL recurse) const;
+
+	// Recursive findChildView() results by name, including misses, so
+	// floaters and panels that look their widgets up every frame only walk
+	// the tree once per name. Any change to any view tree bumps
+	// sChildTreeGeneration, which makes every index stale at once.
+	typedef std::unordered_map<std::string, LLView*> child_name_index_t;
+	mutable std::unique_ptr<child_name_index_t> mChildNameIndex;
+	mutable U32 mChildNameIndexGeneration;
+	static U32 sChildTreeGeneration;
+	// only the outermost lookup fills its index
+	static bool sInChildLookup;
+
 	// This allows special mouse-event targeting logic for testing.
 	typedef boost::function<bool(const LLView*, S32 x, S32 y)> DrilldownFunc;
 	static DrilldownFunc sDrilldown;
@@ -680,6 +711,9 @@ public:
 	static S32 sLastLeftXML;
 	static S32 sLastBottomXML;
 	static BOOL sForceReshape;
+
+	// views alive, for memory statistics
+	static S32 sViewCount;
 };
 
 namespace LLInitParam
@@ -479,10 +479,12 @@ void XMLCALL StartXMLNode(void *userData,
 		}
 
 		// only one attribute child per description
+		// one string table lookup serves the search and the new node
+		LLStringTableEntry* attr_entry = gStringTable.addStringEntry(attr_name);
 		LLXMLNodePtr attr_node;
-		if (!new_node->getAttribute(attr_name.c_str(), attr_node, FALSE))
+		if (!new_node->getAttribute(attr_entry, attr_node, FALSE))
 		{
-			attr_node = new LLXMLNode(attr_name.c_str(), TRUE);
+			attr_node = new LLXMLNode(attr_entry, TRUE);
 			attr_node->setLineNumber(XML_GetCurrentLineNumber(*new_node_ptr->mParser));
 		}
 		attr_node->setValue(attr_value);
@@ -531,7 +533,8 @@ void XMLCALL XMLData(void *userData,
                      int len)
 {
 	LLXMLNode* current_node = (LLXMLNode *)userData;
-	std::string value = current_node->getValue();
+	// expat delivers long text in pieces, append in place rather than
+	// copying the value so far for each one
 	if (LLXMLNode::sStripEscapedStrings)
 	{
 		if (s[0] == '\"' && s[len-1] == '\"')
@@ -555,13 +558,11 @@ void XMLCALL XMLData(void *userData,
 					unescaped_string.append(&s[pos], 1);
 				}
 			}
-			value.append(unescaped_string);
-			current_node->setValue(value);
+			current_node->appendValue(unescaped_string.data(), (S32)unescaped_string.size());
 			return;
 		}
 	}
-	value.append(std::string(s, len));
-	current_node->setValue(value);
+	current_node->appendValue(s, len);
 }
 
 
@@ -876,6 +877,136 @@ bool LLXMLNode::getLayeredXMLNode(LLXMLNodePtr& root,
 	return true;
 }
 
+static void write_binary_u32(std::ostream& output_stream, U32 value)
+{
+	output_stream.write((const char*)&value, sizeof(value));
+}
+
+static void write_binary_string(std::ostream& output_stream, const std::string& value)
+{
+	write_binary_u32(output_stream, (U32)value.size());
+	output_stream.write(value.data(), value.size());
+}
+
+static bool read_binary_u32(std::istream& input_stream, U32& value)
+{
+	input_stream.read((char*)&value, sizeof(value));
+	return input_stream.good();
+}
+
+static bool read_binary_string(std::istream& input_stream, std::string& value)
+{
+	// no single name or value in a UI file comes anywhere near this
+	const U32 MAX_STRING_LENGTH = 16 * 1024 * 1024;
+	U32 length;
+	if (!read_binary_u32(input_stream, length) || length > MAX_STRING_LENGTH)
+	{
+		return false;
+	}
+	value.resize(length);
+	input_stream.read(&value[0], length);
+	return input_stream.good();
+}
+
+// static
+void LLXMLNode::writeBinary(std::ostream& output_stream, const LLXMLNode* node)
+{
+	write_binary_string(output_stream, node->mName ? std::string(node->mName->mString) : std::string());
+	write_binary_string(output_stream, node->mValue);
+	write_binary_string(output_stream, node->mID);
+	write_binary_u32(output_stream, node->mIsAttribute ? 1 : 0);
+	write_binary_u32(output_stream, node->mVersionMajor);
+	write_binary_u32(output_stream, node->mVersionMinor);
+	write_binary_u32(output_stream, node->mLength);
+	write_binary_u32(output_stream, node->mPrecision);
+	write_binary_u32(output_stream, (U32)node->mType);
+	write_binary_u32(output_stream, (U32)node->mEncoding);
+	write_binary_u32(output_stream, (U32)node->mLineNumber);
+
+	write_binary_u32(output_stream, (U32)node->mAttributes.size());
+	for (LLXMLAttribList::const_iterator it = node->mAttributes.begin(); it != node->mAttributes.end(); ++it)
+	{
+		writeBinary(output_stream, it->second);
+	}
+
+	U32 child_count = 0;
+	for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+	{
+		++child_count;
+	}
+	write_binary_u32(output_stream, child_count);
+	for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+	{
+		writeBinary(output_stream, child);
+	}
+}
+
+// static
+bool LLXMLNode::readBinary(std::istream& input_stream, LLXMLNodePtr& node)
+{
+	std::string name;
+	U32 is_attribute;
+	if (!read_binary_string(input_stream, name)
+		|| name.empty())
+	{
+		return false;
+	}
+	std::string value;
+	std::string id;
+	U32 fields[8];
+	if (!read_binary_string(input_stream, value)
+		|| !read_binary_string(input_stream, id)
+		|| !read_binary_u32(input_stream, is_attribute))
+	{
+		return false;
+	}
+	for (U32 i = 0; i < 8; ++i)
+	{
+		if (!read_binary_u32(input_stream, fields[i]))
+		{
+			return false;
+		}
+	}
+
+	node = new LLXMLNode(name.c_str(), is_attribute ? TRUE : FALSE);
+	node->mValue = value;
+	node->mID = id;
+	node->mVersionMajor = fields[0];
+	node->mVersionMinor = fields[1];
+	node->mLength = fields[2];
+	node->mPrecision = fields[3];
+	node->mType = (ValueType)fields[4];
+	node->mEncoding = (Encoding)fields[5];
+	node->mLineNumber = (S32)fields[6];
+
+	U32 attribute_count = fields[7];
+	for (U32 i = 0; i < attribute_count; ++i)
+	{
+		LLXMLNodePtr attribute;
+		if (!readBinary(input_stream, attribute))
+		{
+			return false;
+		}
+		node->addChild(attribute);
+	}
+
+	U32 child_count;
+	if (!read_binary_u32(input_stream, child_count))
+	{
+		return false;
+	}
+	for (U32 i = 0; i < child_count; ++i)
+	{
+		LLXMLNodePtr child;
+		if (!readBinary(input_stream, child))
+		{
+			return false;
+		}
+		node->addChild(child);
+	}
+	return true;
+}
+
 // static
 void LLXMLNode::writeHeaderToFile(LLFILE *out_file)
 {
@@ -2586,6 +2717,15 @@ void LLXMLNode::setValue(const std::string& value)
 	mValue = value;
 }
 
+void LLXMLNode::appendValue(const char* value, S32 length)
+{
+	if (TYPE_CONTAINER == mType)
+	{
+		mType = TYPE_UNKNOWN;
+	}
+	mValue.append(value, length);
+}
+
 void LLXMLNode::setDefault(LLXMLNode *default_node)
 {
 	mDefault = default_node;
@@ -148,6 +148,12 @@ public:
 		LLXMLNodePtr& update_node);
 	
 	static bool getLayeredXMLNode(LLXMLNodePtr& root, const std::vector<std::string>& paths);
+
+	// Compact binary form of a parsed tree, much faster to load than the XML.
+	// Keeps child order, attributes and line numbers; not a stable format, only
+	// meant for caches.
+	static void writeBinary(std::ostream& output_stream, const LLXMLNode* node);
+	static bool readBinary(std::istream& input_stream, LLXMLNodePtr& node);
 	
 	
 	// Write standard XML file header:
@@ -286,7 +292,8 @@ public:
 	BOOL deleteChildren(const std::string& name);
 	BOOL deleteChildren(LLStringTableEntry* name);
 	void setAttributes(ValueType type, U32 precision, Encoding encoding, U32 length);
-// 	void appendValue(const std::string& value); // Unused
+	// Used by the parser as character data arrives
+	void appendValue(const char* value, S32 length);
 
 	// Unit Testing
 	void createUnitTest(S32 max_num_children);
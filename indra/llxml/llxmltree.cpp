@@ -27,6 +27,7 @@
 #include "linden_common.h"
 
 #include "llxmltree.h"
+#include "llmemory.h"
 #include "v3color.h"
 #include "v4color.h"
 #include "v4coloru.h"
@@ -42,9 +43,16 @@
 // static
 LLStdStringTable LLXmlTree::sAttributeKeys(1024);
 
+// avatar_lad.xml takes a few of these
+static const size_t XML_TREE_BLOCK_SIZE = 256 * 1024;
+static const size_t XML_TREE_ALIGNMENT = 16;
+
 LLXmlTree::LLXmlTree()
 	: mRoot( NULL ),
-	  mNodeNames(512)
+	  mNodeNames(512),
+	  mBlock(0),
+	  mPos(NULL),
+	  mEnd(NULL)
 {
 }
 
@@ -55,16 +63,75 @@ LLXmlTree::~LLXmlTree()
 
 void LLXmlTree::cleanup()
 {
-	delete mRoot;
-	mRoot = NULL;
+	destroyNodes();
 	mNodeNames.cleanup();
 }
 
+void LLXmlTree::destroyNodes()
+{
+	if (mRoot)
+	{
+		mRoot->~LLXmlTreeNode();
+		mRoot = NULL;
+	}
+	for (Block& block : mBlocks)
+	{
+		ll_aligned_free_16(block.mData);
+	}
+	mBlocks.clear();
+	mBlock = 0;
+	mPos = NULL;
+	mEnd = NULL;
+}
+
+void* LLXmlTree::allocate(size_t size)
+{
+	size = (size + XML_TREE_ALIGNMENT - 1) & ~(XML_TREE_ALIGNMENT - 1);
+	while ((size_t)(mEnd - mPos) < size)
+	{
+		// Blocks left over from a rewind are used again when big enough
+		if (mPos && mBlock + 1 < mBlocks.size() && mBlocks[mBlock + 1].mSize >= size)
+		{
+			++mBlock;
+		}
+		else
+		{
+			Block block;
+			block.mSize = llmax(XML_TREE_BLOCK_SIZE, size);
+			block.mData = (char*)ll_aligned_malloc_16(block.mSize);
+			mBlock = mPos ? mBlock + 1 : 0;
+			mBlocks.insert(mBlocks.begin() + mBlock, block);
+		}
+		mPos = mBlocks[mBlock].mData;
+		mEnd = mPos + mBlocks[mBlock].mSize;
+	}
+	void* ptr = mPos;
+	mPos += size;
+	return ptr;
+}
+
+void LLXmlTree::rewind(const Mark& mark)
+{
+	if (!mark.mPos)
+	{
+		// nothing was allocated yet when the mark was taken
+		if (!mBlocks.empty())
+		{
+			mBlock = 0;
+			mPos = mBlocks[0].mData;
+			mEnd = mPos + mBlocks[0].mSize;
+		}
+		return;
+	}
+	mBlock = mark.mBlock;
+	mPos = mark.mPos;
+	mEnd = mBlocks[mBlock].mData + mBlocks[mBlock].mSize;
+}
+
 
 BOOL LLXmlTree::parseFile(const std::string &path, BOOL keep_contents)
 {
-	delete mRoot;
-	mRoot = NULL;
+	destroyNodes();
 
 	LLXmlTreeParser parser(this);
 	BOOL success = parser.parseFile( path, &mRoot, keep_contents );
@@ -77,6 +144,22 @@ BOOL LLXmlTree::parseFile(const std::string &path, BOOL keep_contents)
 	return success;
 }
 
+BOOL LLXmlTree::parseFile(const std::string &path, const element_callback_t& on_element, BOOL keep_contents)
+{
+	destroyNodes();
+
+	LLXmlTreeParser parser(this);
+	BOOL success = parser.parseFile( path, on_element, keep_contents );
+	if( !success )
+	{
+		S32 line_number = parser.getCurrentLineNumber();
+		const char* error =  parser.getErrorString();
+		LL_WARNS() << "LLXmlTree parse failed.  Line " << line_number << ": " << error << LL_ENDL;
+	}
+	destroyNodes();
+	return success;
+}
+
 void LLXmlTree::dump()
 {
 	if( mRoot )
@@ -100,7 +183,16 @@ void LLXmlTree::dumpNode( LLXmlTreeNode* node, const std::string& prefix )
 // LLXmlTreeNode
 
 LLXmlTreeNode::LLXmlTreeNode( const std::string& name, LLXmlTreeNode* parent, LLXmlTree* tree )
-	: mName(name),
+	: mAttributes(NULL),
+	  mAttributeCount(0),
+	  mName(tree->mNodeNames.insert(name)),
+	  mFirstChild(NULL),
+	  mLastChild(NULL),
+	  mNextSibling(NULL),
+	  mChildCount(0),
+	  mChildIter(NULL),
+	  mNamedChildIter(NULL),
+	  mNamedChildName(NULL),
 	  mParent(parent),
 	  mTree(tree)
 {
@@ -108,29 +200,41 @@ LLXmlTreeNode::LLXmlTreeNode( const std::string& name, LLXmlTreeNode* parent, LL
 
 LLXmlTreeNode::~LLXmlTreeNode()
 {
-	attribute_map_t::iterator iter;
-	for (iter=mAttributes.begin(); iter != mAttributes.end(); iter++)
-		delete iter->second;
-        for(LLXmlTreeNode* node : mChildren)
-        {
-            delete node;
-        }
-        mChildren.clear();
+	for (S32 i = 0; i < mAttributeCount; ++i)
+	{
+		mAttributes[i].~Attribute();
+	}
+	removeChildren();
+}
+
+void LLXmlTreeNode::removeChildren()
+{
+	LLXmlTreeNode* child = mFirstChild;
+	while (child)
+	{
+		LLXmlTreeNode* next = child->mNextSibling;
+		child->~LLXmlTreeNode();
+		child = next;
+	}
+	mFirstChild = NULL;
+	mLastChild = NULL;
+	mChildCount = 0;
+	mChildIter = NULL;
+	mNamedChildIter = NULL;
 }
  
 void LLXmlTreeNode::dump( const std::string& prefix )
 {
-	LL_INFOS() << prefix << mName ;
+	LL_INFOS() << prefix << *mName ;
 	if( !mContents.empty() )
 	{
 		LL_CONT << " contents = \"" << mContents << "\"";
 	}
-	attribute_map_t::iterator iter;
-	for (iter=mAttributes.begin(); iter != mAttributes.end(); iter++)
+	for (S32 i = 0; i < mAttributeCount; ++i)
 	{
-		LLStdStringHandle key = iter->first;
-		const std::string* value = iter->second;
-		LL_CONT << prefix << " " << key << "=" << (value->empty() ? "NULL" : *value);
+		LLStdStringHandle key = mAttributes[i].mName;
+		const std::string& value = mAttributes[i].mValue;
+		LL_CONT << prefix << " " << *key << "=" << (value.empty() ? "NULL" : value);
 	}
 	LL_CONT << LL_ENDL;
 } 
@@ -138,59 +242,87 @@ void LLXmlTreeNode::dump( const std::string& prefix )
 BOOL LLXmlTreeNode::hasAttribute(const std::string& name)
 {
 	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
-	attribute_map_t::iterator iter = mAttributes.find(canonical_name);
-	return (iter == mAttributes.end()) ? false : true;
+	return getAttribute(canonical_name) ? TRUE : FALSE;
 }
 
-void LLXmlTreeNode::addAttribute(const std::string& name, const std::string& value)
+void LLXmlTreeNode::setAttributes(const char** atts)
 {
-	LLStdStringHandle canonical_name = LLXmlTree::sAttributeKeys.addString( name );
-	const std::string *newstr = new std::string(value);
-	mAttributes[canonical_name] = newstr; // insert + copy
+	S32 count = 0;
+	while (atts[2 * count] && atts[2 * count + 1])
+	{
+		++count;
+	}
+	if (!count)
+	{
+		return;
+	}
+
+	// expat has already rejected repeated names
+	mAttributes = (Attribute*)mTree->allocate(count * sizeof(Attribute));
+	for (S32 i = 0; i < count; ++i)
+	{
+		Attribute* attribute = new (&mAttributes[i]) Attribute;
+		attribute->mName = LLXmlTree::sAttributeKeys.addString(atts[2 * i]);
+		attribute->mValue = atts[2 * i + 1];
+		mAttributeCount = i + 1;
+	}
 }
 
 LLXmlTreeNode*	LLXmlTreeNode::getFirstChild()
 {
-	mChildrenIter = mChildren.begin();
+	mChildIter = mFirstChild;
 	return getNextChild();
 }
 LLXmlTreeNode*	LLXmlTreeNode::getNextChild()
 {
-	if (mChildrenIter == mChildren.end())
-		return 0;
-	else
-		return *mChildrenIter++;
+	LLXmlTreeNode* child = mChildIter;
+	if (child)
+	{
+		mChildIter = child->mNextSibling;
+	}
+	return child;
 }
 
 LLXmlTreeNode* LLXmlTreeNode::getChildByName(const std::string& name)
 {
-	LLStdStringHandle tableptr = mTree->mNodeNames.checkString(name);
-	mChildMapIter = mChildMap.lower_bound(tableptr);
-	mChildMapEndIter = mChildMap.upper_bound(tableptr);
+	mNamedChildName = mTree->mNodeNames.checkString(name);
+	mNamedChildIter = mNamedChildName ? mFirstChild : NULL;
 	return getNextNamedChild();
 }
 
 LLXmlTreeNode* LLXmlTreeNode::getNextNamedChild()
 {
-	if (mChildMapIter == mChildMapEndIter)
-		return NULL;
-	else
-		return (mChildMapIter++)->second;
+	// Names are unique in mNodeNames, comparing handles is enough
+	while (mNamedChildIter && mNamedChildIter->mName != mNamedChildName)
+	{
+		mNamedChildIter = mNamedChildIter->mNextSibling;
+	}
+	LLXmlTreeNode* child = mNamedChildIter;
+	if (child)
+	{
+		mNamedChildIter = child->mNextSibling;
+	}
+	return child;
 }
 
-void LLXmlTreeNode::appendContents(const std::string& str)
+void LLXmlTreeNode::appendContents(const char* s, int len)
 {
-	mContents.append( str );
+	mContents.append( s, len );
 }
 
 void LLXmlTreeNode::addChild(LLXmlTreeNode* child)
 {
 	llassert( child );
-	mChildren.push_back( child );
-
-	// Add a name mapping to this node
-	LLStdStringHandle tableptr = mTree->mNodeNames.insert(child->mName);
-	mChildMap.insert( child_map_t::value_type(tableptr, child));
+	if (mLastChild)
+	{
+		mLastChild->mNextSibling = child;
+	}
+	else
+	{
+		mFirstChild = child;
+	}
+	mLastChild = child;
+	++mChildCount;
 	
 	child->mParent = this;
 }
@@ -507,8 +639,12 @@ LLXmlTreeParser::LLXmlTreeParser(LLXmlTree* tree)
 	  mRoot( NULL ),
 	  mCurrent( NULL ),
 	  mDump( FALSE ),
-	  mKeepContents(FALSE)
+	  mKeepContents(FALSE),
+	  mOnElement(NULL),
+	  mSkipDepth(0),
+	  mSkipRest(false)
 {
+	mElementMark = mTree->getMark();
 }
 
 LLXmlTreeParser::~LLXmlTreeParser() 
@@ -536,6 +672,21 @@ BOOL LLXmlTreeParser::parseFile(const std::string &path, LLXmlTreeNode** root, B
 	return success;
 }
 
+BOOL LLXmlTreeParser::parseFile(const std::string &path, const LLXmlTree::element_callback_t& on_element, BOOL keep_contents)
+{
+	mOnElement = &on_element;
+	mSkipDepth = 0;
+	mSkipRest = false;
+
+	// The tree frees the root
+	LLXmlTreeNode* root = NULL;
+	BOOL success = parseFile(path, &root, keep_contents);
+	mTree->mRoot = root;
+
+	mOnElement = NULL;
+	return success;
+}
+
 
 const std::string& LLXmlTreeParser::tabs()
 {
@@ -563,15 +714,20 @@ void LLXmlTreeParser::startElement(const char* name, const char **atts)
 		}
 	}
 
-	LLXmlTreeNode* child = CreateXmlTreeNode( std::string(name), mCurrent );
+	if (mSkipDepth > 0 || (mSkipRest && mCurrent && mCurrent == mRoot))
+	{
+		++mSkipDepth;
+		return;
+	}
 
-	S32 i = 0;
-	while( atts[i] && atts[i+1] )
+	if (mOnElement && mCurrent && mCurrent == mRoot)
 	{
-		child->addAttribute( atts[i], atts[i+1] );
-		i += 2;
+		mElementMark = mTree->getMark();
 	}
 
+	LLXmlTreeNode* child = CreateXmlTreeNode( std::string(name), mCurrent );
+	child->setAttributes( atts );
+
 	if( mCurrent )
 	{
 		mCurrent->addChild( child );
@@ -587,7 +743,7 @@ void LLXmlTreeParser::startElement(const char* name, const char **atts)
 
 LLXmlTreeNode* LLXmlTreeParser::CreateXmlTreeNode(const std::string& name, LLXmlTreeNode* parent)
 {
-	return new LLXmlTreeNode(name, parent, mTree);
+	return new (mTree->allocate(sizeof(LLXmlTreeNode))) LLXmlTreeNode(name, parent, mTree);
 }
 
 
@@ -598,27 +754,42 @@ void LLXmlTreeParser::endElement(const char* name)
 		LL_INFOS() << tabs() << "endElement " << name << LL_ENDL;
 	}
 
+	if (mSkipDepth > 0)
+	{
+		--mSkipDepth;
+		return;
+	}
+
 	if( !mCurrent->mContents.empty() )
 	{
 		LLStringUtil::trim(mCurrent->mContents);
 		LLStringUtil::removeCRLF(mCurrent->mContents);
 	}
 
+	LLXmlTreeNode* node = mCurrent;
 	mCurrent = mCurrent->getParent();
+
+	if (mOnElement && mCurrent && mCurrent == mRoot)
+	{
+		// A child of the root is complete, hand it over and forget it
+		mSkipRest = !(*mOnElement)(mRoot, node);
+		mRoot->removeChildren();
+		mTree->rewind(mElementMark);
+	}
 }
 
 void LLXmlTreeParser::characterData(const char *s, int len) 
 {
-	std::string str;
-	if (s) str = std::string(s, len);
 	if( mDump )
 	{
+		std::string str;
+		if (s) str = std::string(s, len);
 		LL_INFOS() << tabs() << "CharacterData " << str << LL_ENDL;
 	}
 
-	if (mKeepContents)
+	if (mKeepContents && s && mSkipDepth == 0)
 	{
-		mCurrent->appendContents( str );
+		mCurrent->appendContents( s, len );
 	}
 }
 
@@ -28,8 +28,10 @@
 #ifndef LL_LLXMLTREE_H
 #define LL_LLXMLTREE_H
 
+#include <functional>
 #include <map>
 #include <list>
+#include <vector>
 #include "llstring.h"
 #include "llxmlparser.h"
 #include "llstringtable.h"
@@ -46,9 +48,12 @@ class LLXmlTreeParser;
 //////////////////////////////////////////////////////////////
 // LLXmlTree
 
+// Nodes, with their attributes, are carved out of blocks owned by the tree
+// and all go away together with it, or with the next parse.
 class LLXmlTree
 {
 	friend class LLXmlTreeNode;
+	friend class LLXmlTreeParser;
 	
 public:
 	LLXmlTree();
@@ -57,6 +62,14 @@ public:
 
 	virtual BOOL	parseFile(const std::string &path, BOOL keep_contents = TRUE);
 
+	// Streaming mode, for files read once from top to bottom: each child of
+	// the root element is handed to on_element as soon as its end tag is
+	// read, with its whole subtree, and freed when on_element returns. The
+	// root keeps its attributes but never has children. Return false to
+	// skip the rest of the file. getRoot() is NULL afterwards.
+	typedef std::function<bool(LLXmlTreeNode* root, LLXmlTreeNode* element)> element_callback_t;
+	BOOL			parseFile(const std::string &path, const element_callback_t& on_element, BOOL keep_contents = TRUE);
+
 	LLXmlTreeNode*	getRoot() { return mRoot; }
 
 	void			dump();
@@ -71,11 +84,35 @@ public:
 	// global
 	static LLStdStringTable sAttributeKeys;
 	
+protected:
+	void*			allocate(size_t size);
+	void			destroyNodes();
+
+	// Where the next allocation goes, to free what came after it
+	struct Mark
+	{
+		size_t	mBlock;
+		char*	mPos;
+	};
+	Mark			getMark() const { Mark mark = { mBlock, mPos }; return mark; }
+	void			rewind(const Mark& mark);
+
 protected:
 	LLXmlTreeNode* mRoot;
 
 	// local
 	LLStdStringTable mNodeNames;	
+
+private:
+	struct Block
+	{
+		char*	mData;
+		size_t	mSize;
+	};
+	std::vector<Block>	mBlocks;
+	size_t				mBlock;		// in use, if mPos is set
+	char*				mPos;
+	char*				mEnd;
 };
 
 //////////////////////////////////////////////////////////////
@@ -87,19 +124,19 @@ class LLXmlTreeNode
 	friend class LLXmlTreeParser;
 
 protected:
-	// Protected since nodes are only created and destroyed by friend classes and other LLXmlTreeNodes
+	// Protected since nodes are only created and destroyed by friend classes and other LLXmlTreeNodes.
+	// The memory belongs to the tree, so they are destroyed in place, never deleted.
 	LLXmlTreeNode( const std::string& name, LLXmlTreeNode* parent, LLXmlTree* tree );
+	virtual ~LLXmlTreeNode();
 	
 public:
-	virtual ~LLXmlTreeNode();
-
 	const std::string&	getName()
 	{
-		return mName;
+		return *mName;
 	}
 	BOOL hasName( const std::string& name )
 	{
-		return mName == name;
+		return *mName == name;
 	}
 
 	BOOL hasAttribute( const std::string& name );
@@ -151,40 +188,55 @@ public:
 	LLXmlTreeNode*	getParent()							{ return mParent; }
 	LLXmlTreeNode*	getFirstChild();
 	LLXmlTreeNode*	getNextChild();
-	S32				getChildCount()						{ return (S32)mChildren.size(); }
+	S32				getChildCount()						{ return mChildCount; }
 	LLXmlTreeNode*  getChildByName( const std::string& name );	// returns first child with name, NULL if none
 	LLXmlTreeNode*  getNextNamedChild();				// returns next child with name, NULL if none
 
 protected:
+	// Elements have a handful of attributes, a scan beats a map
 	const std::string* getAttribute( LLStdStringHandle name)
 	{
-		attribute_map_t::iterator iter = mAttributes.find(name);
-		return (iter == mAttributes.end()) ? 0 : iter->second;
+		for (S32 i = 0; i < mAttributeCount; ++i)
+		{
+			if (mAttributes[i].mName == name)
+			{
+				return &mAttributes[i].mValue;
+			}
+		}
+		return 0;
 	}
 
 private:
-	void			addAttribute( const std::string& name, const std::string& value );
-	void			appendContents( const std::string& str );
+	// atts as passed by expat, name/value pairs ending with a null
+	void			setAttributes( const char** atts );
+	void			appendContents( const char* s, int len );
 	void			addChild( LLXmlTreeNode* child );
+	void			removeChildren();
 
 	void			dump( const std::string& prefix );
 
 protected:
-	typedef std::map<LLStdStringHandle, const std::string*> attribute_map_t;
-	attribute_map_t						mAttributes;
+	struct Attribute
+	{
+		LLStdStringHandle	mName;		// in LLXmlTree::sAttributeKeys
+		std::string			mValue;
+	};
+	Attribute*							mAttributes;	// allocated by mTree
+	S32									mAttributeCount;
 
 private:
-	std::string							mName;
+	LLStdStringHandle					mName;			// in mTree->mNodeNames
 	std::string							mContents;
 	
-	typedef std::vector<class LLXmlTreeNode *> children_t;
-	children_t                          mChildren;
-	children_t::iterator				mChildrenIter;
-	
-	typedef std::multimap<LLStdStringHandle, LLXmlTreeNode *> child_map_t;
-	child_map_t							mChildMap;		// for fast name lookups
-	child_map_t::iterator				mChildMapIter;
-	child_map_t::iterator				mChildMapEndIter;
+	// Children in document order
+	LLXmlTreeNode*						mFirstChild;
+	LLXmlTreeNode*						mLastChild;
+	LLXmlTreeNode*						mNextSibling;
+	S32									mChildCount;
+
+	LLXmlTreeNode*						mChildIter;			// getNextChild()
+	LLXmlTreeNode*						mNamedChildIter;	// getNextNamedChild()
+	LLStdStringHandle					mNamedChildName;
 
 	LLXmlTreeNode*						mParent;
 	LLXmlTree*							mTree;
@@ -200,6 +252,7 @@ public:
 	virtual ~LLXmlTreeParser();
 
 	BOOL parseFile(const std::string &path, LLXmlTreeNode** root, BOOL keep_contents );
+	BOOL parseFile(const std::string &path, const LLXmlTree::element_callback_t& on_element, BOOL keep_contents );
 
 protected:
 	const std::string& tabs();
@@ -229,6 +282,12 @@ protected:
 	LLXmlTreeNode*  mCurrent;
 	BOOL			mDump;	// Dump parse tree to LL_INFOS() as it is read.
 	BOOL			mKeepContents;
+
+	// Streaming mode only
+	const LLXmlTree::element_callback_t* mOnElement;
+	LLXmlTree::Mark	mElementMark;	// where the current child of the root starts
+	S32				mSkipDepth;		// > 0 inside elements being skipped
+	bool			mSkipRest;		// on_element asked for no more
 };
 
 #endif  // LL_LLXMLTREE_H
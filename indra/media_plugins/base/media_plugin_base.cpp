@@ -31,6 +31,8 @@
 #include "linden_common.h"
 #include "media_plugin_base.h"
 
+#include <chrono>
+
 
 // TODO: Make sure that the only symbol exported from this library is LLPluginInitEntryPoint
 ////////////////////////////////////////////////////////////////////////////////
@@ -53,6 +55,9 @@ MediaPluginBase::MediaPluginBase(
 	mTextureHeight = 0;
 	mDepth = 0;
 	mStatus = STATUS_NONE;
+	mMinFrameInterval = 0.0;
+	mLastFrameTime = 0.0;
+	mFramePending = false;
 }
 
 /**
@@ -154,6 +159,50 @@ void MediaPluginBase::setDirty(int left, int top, int right, int bottom)
 	sendMessage(message);
 }
 
+/**
+ * Sets the most frames per second the plugin should publish, 0 for no limit.
+ *
+ * @param[in] fps Frame rate limit requested by the viewer
+ */
+void MediaPluginBase::setFrameRateLimit(double fps)
+{
+	mMinFrameInterval = (fps > 0.0) ? 1.0 / fps : 0.0;
+}
+
+/**
+ * Checks the frame rate limit before publishing a frame.
+ *
+ * @return True if the frame may be published now, false if it was held back
+ */
+bool MediaPluginBase::frameDue()
+{
+	if (mMinFrameInterval <= 0.0)
+	{
+		return true;
+	}
+
+	double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (now - mLastFrameTime < mMinFrameInterval)
+	{
+		mFramePending = true;
+		return false;
+	}
+
+	mLastFrameTime = now;
+	mFramePending = false;
+	return true;
+}
+
+/**
+ * Checks whether a frame held back by the frame rate limit can be published yet.
+ *
+ * @return True if a pending frame should be published now
+ */
+bool MediaPluginBase::pendingFrameDue()
+{
+	return mFramePending && frameDue();
+}
+
 /**
  * Sends "media_status" message to plugin loader shell ("loading", "playing", "paused", etc.)
  * 
@@ -32,6 +32,8 @@
 #include "llpluginmessage.h"
 #include "llpluginmessageclasses.h"
 
+#include <atomic>
+
 
 class MediaPluginBase
 {
@@ -77,6 +79,13 @@ protected:
 	/// Note: The quicktime plugin overrides this to add current time and duration to the message.
 	virtual void setDirty(int left, int top, int right, int bottom);
 
+   /** Set by the viewer's "set_frame_rate_limit" message, 0 for no limit. */
+	void setFrameRateLimit(double fps);
+   /** True if a new frame may be published now. Otherwise the frame is remembered as pending. */
+	bool frameDue();
+   /** True if a frame held back by the limit may now be published. Call from idle. */
+	bool pendingFrameDue();
+
    /** Map of shared memory names to shared memory. */
 	typedef std::map<std::string, SharedSegmentInfo> SharedSegmentMap;
 
@@ -105,6 +114,12 @@ protected:
 	EStatus mStatus;
    /** Map of shared memory segments. */
 	SharedSegmentMap mSharedSegments;
+   /** Minimum seconds between published frames, 0 for no limit. */
+	double mMinFrameInterval;
+   /** Time the last frame was published. */
+	std::atomic<double> mLastFrameTime;
+   /** A frame was held back by the frame rate limit. */
+	std::atomic<bool> mFramePending;
 
 };
 
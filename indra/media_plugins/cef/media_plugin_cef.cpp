@@ -190,7 +190,12 @@ void MediaPluginCEF::onPageChangedCallback(const unsigned char* pixels, int x, i
 		{
 			mCEFLib->setSize(mWidth, mHeight);
 		}
-		setDirty(0, 0, mWidth, mHeight);
+
+		// The pixels are kept current, only the viewer's update is held back
+		if (frameDue())
+		{
+			setDirty(0, 0, mWidth, mHeight);
+		}
 	}
 }
 
@@ -543,6 +548,11 @@ void MediaPluginCEF::receiveMessage(const char* message_string)
 			{
 				mCEFLib->update();
 
+				if (pendingFrameDue())
+				{
+					setDirty(0, 0, mWidth, mHeight);
+				}
+
 				mVolumeCatcher.pump();
 
 				// this seems bad but unless the state changes (it won't until we figure out
@@ -783,6 +793,10 @@ void MediaPluginCEF::receiveMessage(const char* message_string)
 				sendMessage(message);
 
 			}
+			else if (message_name == "set_frame_rate_limit")
+			{
+				setFrameRateLimit(message_in.getValueReal("fps"));
+			}
 			else if (message_name == "set_language_code")
 			{
 				mHostLanguage = message_in.getValue("language");
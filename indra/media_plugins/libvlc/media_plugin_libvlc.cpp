@@ -160,7 +160,10 @@ void MediaPluginLibVLC::display(void* data, void* id)
 {
 	struct mLibVLCContext* context = (mLibVLCContext*)data;
 
-	context->parent->setDirty(0, 0, context->parent->mWidth, context->parent->mHeight);
+	if (context->parent->frameDue())
+	{
+		context->parent->setDirty(0, 0, context->parent->mWidth, context->parent->mHeight);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -499,6 +502,11 @@ void MediaPluginLibVLC::receiveMessage(const char* message_string)
 			else if (message_name == "idle")
 			{
 				setStatus(mVlcStatus);
+
+				if (pendingFrameDue())
+				{
+					setDirty(0, 0, mWidth, mHeight);
+				}
 			}
 			else if (message_name == "cleanup")
 			{
@@ -565,6 +573,10 @@ void MediaPluginLibVLC::receiveMessage(const char* message_string)
 				message.setValueBoolean("coords_opengl", true);
 				sendMessage(message);
 			}
+			else if (message_name == "set_frame_rate_limit")
+			{
+				setFrameRateLimit(message_in.getValueReal("fps"));
+			}
 			else if (message_name == "size_change")
 			{
 				std::string name = message_in.getValue("name");
@@ -0,0 +1,70 @@
+/** 
+ * @file objectSkinInstancedV.glsl
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Same as objectSkinV.glsl, but each instance of an instanced draw reads its
+// own palette out of the SkinInstances block.
+
+in vec4 weight4;  
+
+layout (std140) uniform SkinInstances
+{
+    mat3x4 instancePalette[MAX_SKIN_INSTANCES*MAX_JOINTS_PER_MESH_OBJECT];
+};
+
+mat4 getObjectSkinnedTransform()
+{
+	vec4 w = fract(weight4);
+	vec4 index = floor(weight4);
+	
+    index = min(index, vec4(MAX_JOINTS_PER_MESH_OBJECT-1));
+    index = max(index, vec4( 0.0));
+
+    w *= 1.0/(w.x+w.y+w.z+w.w);
+
+    int base = gl_InstanceID*MAX_JOINTS_PER_MESH_OBJECT;
+	
+	int i1 = base+int(index.x);
+	int i2 = base+int(index.y);
+	int i3 = base+int(index.z);
+	int i4 = base+int(index.w);
+
+	mat3 mat = mat3(instancePalette[i1])*w.x;
+		 mat += mat3(instancePalette[i2])*w.y;
+		 mat += mat3(instancePalette[i3])*w.z;
+		 mat += mat3(instancePalette[i4])*w.w;
+
+	vec3 trans = vec3(instancePalette[i1][0].w,instancePalette[i1][1].w,instancePalette[i1][2].w)*w.x;
+		 trans += vec3(instancePalette[i2][0].w,instancePalette[i2][1].w,instancePalette[i2][2].w)*w.y;
+		 trans += vec3(instancePalette[i3][0].w,instancePalette[i3][1].w,instancePalette[i3][2].w)*w.z;
+		 trans += vec3(instancePalette[i4][0].w,instancePalette[i4][1].w,instancePalette[i4][2].w)*w.w;
+
+	mat4 ret;
+
+	ret[0] = vec4(mat[0], 0);
+	ret[1] = vec4(mat[1], 0);
+	ret[2] = vec4(mat[2], 0);
+	ret[3] = vec4(trans, 1.0);
+				
+	return ret;
+}
@@ -0,0 +1,85 @@
+/** 
+ * @file class1\deferred\gpuParticleUpdateV.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+/*[EXTRA_CODE_HERE]*/
+
+// One particle per point, see LLViewerPartSimGPU. Mirrors
+// LLViewerPartGroup::integrateParticles() for the particles the GPU takes.
+
+in vec4 pos_age;      // agent position, age
+in vec4 velocity;     // velocity, max age
+in vec4 accel_flags;  // acceleration, LLPartData flags
+in vec4 part_params;  // start glow, end glow, bounce height
+
+out vec4 out_pos_age;
+out vec4 out_velocity;
+
+uniform float delta_time;
+uniform vec3 wind_velocity;
+uniform vec3 agent_shift;    // region crossing since the last update
+uniform float bounce_offset; // bounce heights are relative to this
+
+const int LL_PART_BOUNCE_MASK = 0x04;
+const int LL_PART_WIND_MASK = 0x08;
+
+void main()
+{
+    vec3 pos = pos_age.xyz + agent_shift;
+    vec3 vel = velocity.xyz;
+    float age = pos_age.w;
+
+    // free slots stay free
+    if (age < velocity.w)
+    {
+        float dt = delta_time;
+        int flags = int(accel_flags.w);
+
+        if ((flags & LL_PART_WIND_MASK) != 0)
+        {
+            vel *= 1.0 - 0.1*dt;
+            vel += 0.1*dt*wind_velocity;
+        }
+
+        pos += dt*vel;
+        pos += 0.5*dt*dt*accel_flags.xyz;
+        vel += accel_flags.xyz*dt;
+
+        if ((flags & LL_PART_BOUNCE_MASK) != 0)
+        {
+            float dz = pos.z - (part_params.z + bounce_offset);
+            if (dz < 0.0)
+            {
+                pos.z += -2.0*dz;
+                vel.z *= -0.75;
+            }
+        }
+
+        age += dt;
+    }
+
+    out_pos_age = vec4(pos, age);
+    out_velocity = vec4(vel, velocity.w);
+}
@@ -0,0 +1,108 @@
+/** 
+ * @file class1\deferred\gpuParticleV.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+/*[EXTRA_CODE_HERE]*/
+
+// One instance per particle, see LLViewerPartSimGPU. Builds the same
+// billboard as LLVOPartGroup::getGeometry() for a triangle strip of four
+// vertices.
+
+uniform mat4 modelview_matrix;
+uniform mat4 modelview_projection_matrix;
+uniform vec3 camera_position; // agent space
+
+in vec4 pos_age;      // agent position, age
+in vec4 velocity;     // velocity, max age
+in vec4 accel_flags;  // acceleration, LLPartData flags
+in vec4 start_color;
+in vec4 end_color;
+in vec4 part_scale;   // start scale, end scale
+
+out vec3 vary_position;
+out vec4 vertex_color;
+out vec2 vary_texcoord0;
+
+void calcAtmospherics(vec3 inPositionEye);
+
+const int LL_PART_INTERP_COLOR_MASK = 0x01;
+const int LL_PART_INTERP_SCALE_MASK = 0x02;
+const int LL_PART_FOLLOW_VELOCITY_MASK = 0x20;
+
+void main()
+{
+    if (pos_age.w >= velocity.w)
+    {
+        // free slot
+        gl_Position = vec4(0.0, 0.0, -2.0, 1.0);
+        vary_position = vec3(0.0);
+        vertex_color = vec4(0.0);
+        vary_texcoord0 = vec2(0.0);
+        return;
+    }
+
+    int flags = int(accel_flags.w);
+    float frac = pos_age.w/velocity.w;
+
+    vec4 color = start_color;
+    if ((flags & LL_PART_INTERP_COLOR_MASK) != 0)
+    {
+        color = mix(start_color, end_color, frac);
+    }
+
+    vec2 scale = part_scale.xy;
+    if ((flags & LL_PART_INTERP_SCALE_MASK) != 0)
+    {
+        scale = mix(part_scale.xy, part_scale.zw, frac);
+    }
+
+    vec3 at = pos_age.xyz - camera_position;
+    vec3 right = normalize(cross(at, vec3(0.0, 0.0, 1.0)));
+    vec3 up = normalize(cross(right, at));
+
+    if ((flags & LL_PART_FOLLOW_VELOCITY_MASK) != 0 && dot(velocity.xyz, velocity.xyz) > 0.0)
+    {
+        vec3 normvel = normalize(velocity.xyz);
+        vec2 up_fracs = normalize(vec2(dot(normvel, right), dot(normvel, up)));
+        vec3 new_up = up_fracs.x*right + up_fracs.y*up;
+        vec3 new_right = up_fracs.y*right - up_fracs.x*up;
+        up = normalize(new_up);
+        right = normalize(new_right);
+    }
+
+    // strip order of the CPU quads: (-right, +up), (-right, -up), (+right, +up), (+right, -up)
+    vec2 corner = vec2((gl_VertexID & 2) != 0 ? 1.0 : -1.0, (gl_VertexID & 1) != 0 ? -1.0 : 1.0);
+    vec3 pos = pos_age.xyz + corner.x*0.5*scale.x*right + corner.y*0.5*scale.y*up;
+
+    vec4 vert = vec4(pos, 1.0);
+    vec4 pos_eye = modelview_matrix*vert;
+    gl_Position = modelview_projection_matrix*vert;
+    vary_position = pos_eye.xyz;
+    vary_texcoord0 = corner*0.5 + vec2(0.5);
+
+    calcAtmospherics(pos_eye.xyz);
+
+    vertex_color = color;
+}
@@ -0,0 +1,52 @@
+/** 
+ * @file hiZTileF.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+ 
+
+/*[EXTRA_CODE_HERE]*/
+
+// write the farthest depth of each TILE_SIZE x TILE_SIZE tile of depthMap
+// must match LLHiZOcclusion::TILE_SIZE
+#define TILE_SIZE 8
+
+out vec4 frag_color;
+
+uniform sampler2D depthMap;
+
+void main() 
+{
+    ivec2 last = textureSize(depthMap, 0) - ivec2(1);
+    ivec2 base = ivec2(gl_FragCoord.xy) * TILE_SIZE;
+
+    float depth = 0.0;
+    for (int y = 0; y < TILE_SIZE; ++y)
+    {
+        for (int x = 0; x < TILE_SIZE; ++x)
+        {
+            depth = max(depth, texelFetch(depthMap, min(base + ivec2(x, y), last), 0).r);
+        }
+    }
+
+    frag_color = vec4(depth);
+}
@@ -42,6 +42,29 @@ uniform vec3  lightnorm;
 uniform vec3  sunlight_color;
 uniform vec3  moonlight_color;
 uniform int   sun_up_factor;
+
+#ifdef ATMOSPHERICS_UBO
+// sky parameters shared by every shader, uploaded once per environment
+// update by LLEnvironment::updateAtmosphericsUBO, keep in sync with it
+// and with the other copies of this block
+layout (std140) uniform AtmosphericsUniforms
+{
+    vec3  ambient_color;
+    float haze_horizon;
+    vec3  blue_horizon;
+    float haze_density;
+    vec3  blue_density;
+    float cloud_shadow;
+    vec3  glow;
+    float density_multiplier;
+    float distance_multiplier;
+    float max_y;
+    float scene_light_strength;
+    float sun_moon_glow_factor;
+    float sky_sunlight_scale;
+    float sky_ambient_scale;
+};
+#else
 uniform vec3  ambient_color;
 uniform vec3  blue_horizon;
 uniform vec3  blue_density;
@@ -55,6 +78,7 @@ uniform float max_y;
 
 uniform vec3  glow;
 uniform float sun_moon_glow_factor;
+#endif
 
 uniform int cube_snapshot;
 
@@ -0,0 +1,64 @@
+/** 
+ * @file class1\deferred\terrainCompositeF.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+/*[EXTRA_CODE_HERE]*/
+
+out vec4 frag_color;
+
+uniform sampler2D detail_0;
+uniform sampler2D detail_1;
+uniform sampler2D detail_2;
+uniform sampler2D detail_3;
+uniform sampler2D composition_map;
+
+uniform vec2 comp_scale;   // composition grid points per composite texel
+uniform vec2 detail_scale; // detail texture repeats per composite texel
+uniform float comp_size;   // composition grid width
+
+void main()
+{
+    /// Note: This should duplicate LLVLComposition::generateTexture(), which it replaces.
+
+    // the render target is the whole composite texture, only the dirty
+    // tile's viewport gets drawn
+    vec2 texel = gl_FragCoord.xy - vec2(0.5);
+
+    // linear filtering at grid point centres is the same clamped bilinear
+    // lookup as LLViewerLayer::getValueScaled()
+    float comp = texture(composition_map, (texel*comp_scale + vec2(0.5))/comp_size).r;
+
+    // blend the two detail textures either side of the composition value
+    vec4 weight = clamp(vec4(1.0) - abs(vec4(comp) - vec4(0.0, 1.0, 2.0, 3.0)), 0.0, 1.0);
+    weight.x = comp < 0.0 ? 1.0 : weight.x;
+    weight.w = comp > 3.0 ? 1.0 : weight.w;
+
+    vec2 tc = texel*detail_scale;
+    vec3 color = texture(detail_0, tc).rgb*weight.x
+               + texture(detail_1, tc).rgb*weight.y
+               + texture(detail_2, tc).rgb*weight.z
+               + texture(detail_3, tc).rgb*weight.w;
+
+    frag_color = vec4(color, 1.0);
+}
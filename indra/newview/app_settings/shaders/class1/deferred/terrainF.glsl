@@ -40,6 +40,43 @@ in vec4 vary_texcoord1;
 
 vec2 encode_normal(vec3 n);
 
+#ifdef PARCEL_OVERLAY
+uniform sampler2D parcel_overlay; // ownership color per parcel cell
+uniform sampler2D parcel_lines;   // 1 where a cell has a property line on its west, south, east, north side
+uniform vec3 parcel_grid;         // x meters per cell, y cells per region edge, z property line width in meters
+uniform vec3 parcel_display;      // x ownership overlay opacity, y property line opacity, z water height
+
+in vec3 vary_region_pos;
+
+// Stands in for the ownership highlight pass and the property line strips
+// LLViewerParcelOverlay used to build on the CPU.
+vec3 applyParcelOverlay(vec3 color)
+{
+    vec2 cell = vary_region_pos.xy / parcel_grid.x;
+    vec2 tc = (floor(cell) + 0.5) / parcel_grid.y;
+    vec4 owner = texture(parcel_overlay, tc);
+    vec4 edges = texture(parcel_lines, tc);
+
+    // meters to the west, south, east and north sides of the cell
+    vec2 f = fract(cell) * parcel_grid.x;
+    vec4 dist = vec4(f, parcel_grid.x - f);
+
+    // lines are kept a pixel wide in the distance and fade by the width they gained
+    vec4 pixel = max(fwidth(vary_region_pos.xy).xyxy, vec4(1e-4));
+    vec4 width = max(vec4(parcel_grid.z), pixel);
+    vec4 line = edges * clamp((width - dist) / pixel, 0.0, 1.0) * (parcel_grid.z / width);
+    float line_alpha = max(max(line.x, line.y), max(line.z, line.w)) * owner.a * parcel_display.y;
+
+    if (vary_region_pos.z <= parcel_display.z)
+    {
+        line_alpha *= 0.5;
+    }
+
+    color = mix(color, owner.rgb, owner.a * parcel_display.x);
+    return mix(color, owner.rgb, line_alpha);
+}
+#endif
+
 void main()
 {
     /// Note: This should duplicate the blending functionality currently used for the terrain rendering.
@@ -54,6 +91,10 @@ void main()
     float alphaFinal = texture(alpha_ramp, vary_texcoord1.zw).a;
     vec4 outColor = mix( mix(color3, color2, alpha2), mix(color1, color0, alpha1), alphaFinal );
    
+#ifdef PARCEL_OVERLAY
+    outColor.rgb = applyParcelOverlay(outColor.rgb);
+#endif
+
     outColor.a = 0.0; // yes, downstream atmospherics 
     
     frag_data[0] = outColor;
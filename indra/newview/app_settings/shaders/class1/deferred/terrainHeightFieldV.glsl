@@ -0,0 +1,139 @@
+/** 
+ * @file class1\deferred\terrainHeightFieldV.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Draws one terrain patch from a grid shared by every patch drawn at the same
+// render stride. Heights, composition and detail noise come from the region's
+// height field texture (see LLSurface::getHeightFieldTexture).
+
+uniform mat3 normal_matrix;
+uniform mat4 texture_matrix0;
+uniform mat4 modelview_projection_matrix;
+
+uniform sampler2D height_field;
+uniform vec4 patch_origin;      // xy first grid of the patch, z render stride, w grids per patch edge
+uniform vec4 neighbor_stride;   // render strides of the west, east, south and north neighbours
+uniform vec2 grid_scale;        // x meters per grid, y grids per region edge
+
+in vec3 position;               // grid point within the patch
+
+#if defined(OWNERSHIP_PASS)
+out vec2 vary_texcoord0;
+#elif !defined(SHADOW_PASS)
+out vec3 pos;
+out vec3 vary_normal;
+out vec4 vary_texcoord0;
+out vec4 vary_texcoord1;
+#ifdef PARCEL_OVERLAY
+out vec3 vary_region_pos;
+#endif
+
+uniform vec4 object_plane_s;
+uniform vec4 object_plane_t;
+#endif
+
+vec3 sampleGrid(vec2 grid)
+{
+    ivec2 last = textureSize(height_field, 0) - ivec2(1);
+    return texelFetch(height_field, clamp(ivec2(patch_origin.xy + grid), ivec2(0), last), 0).rgb;
+}
+
+// Edge points of a patch next to a coarser one are moved onto the straight
+// edge the neighbour draws, so the two meet without cracks.
+vec3 sampleStitched(vec2 grid)
+{
+    float width = patch_origin.w;
+    float stride = patch_origin.z;
+    vec2 dir = vec2(0.0);
+    float along = 0.0;
+
+    if (grid.x == 0.0)
+    {
+        stride = max(stride, neighbor_stride.x);
+        dir = vec2(0.0, 1.0);
+        along = grid.y;
+    }
+    else if (grid.x == width)
+    {
+        stride = max(stride, neighbor_stride.y);
+        dir = vec2(0.0, 1.0);
+        along = grid.y;
+    }
+    else if (grid.y == 0.0)
+    {
+        stride = max(stride, neighbor_stride.z);
+        dir = vec2(1.0, 0.0);
+        along = grid.x;
+    }
+    else if (grid.y == width)
+    {
+        stride = max(stride, neighbor_stride.w);
+        dir = vec2(1.0, 0.0);
+        along = grid.x;
+    }
+
+    float rem = mod(along, stride);
+    vec3 a = sampleGrid(grid - dir*rem);
+    if (rem == 0.0)
+    {
+        return a;
+    }
+    vec3 b = sampleGrid(grid + dir*(stride - rem));
+    return mix(a, b, rem/stride);
+}
+
+void main()
+{
+    vec2 grid = position.xy;
+    vec3 texel = sampleStitched(grid);
+    vec2 region_grid = patch_origin.xy + grid;
+    vec3 region_pos = vec3(region_grid*grid_scale.x, texel.r);
+
+    gl_Position = modelview_projection_matrix * vec4(region_pos, 1.0);
+
+#if defined(OWNERSHIP_PASS)
+    vary_texcoord0 = (texture_matrix0 * vec4(region_pos.xy/grid_scale.y, 0, 1)).xy;
+#elif !defined(SHADOW_PASS)
+    pos = gl_Position.xyz;
+
+    float hw = sampleGrid(grid - vec2(1.0, 0.0)).r;
+    float he = sampleGrid(grid + vec2(1.0, 0.0)).r;
+    float hs = sampleGrid(grid - vec2(0.0, 1.0)).r;
+    float hn = sampleGrid(grid + vec2(0.0, 1.0)).r;
+    vec3 normal = normalize(vec3(hw - he, hs - hn, 2.0*grid_scale.x));
+    vary_normal = normalize(normal_matrix * normal);
+
+    // same texture coordinates terrainV.glsl gets from the patch geometry
+    vec4 tc = vec4(dot(vec4(region_pos, 1.0), object_plane_s), dot(vec4(region_pos, 1.0), object_plane_t), 0.0, 1.0);
+    vary_texcoord0.xy = (texture_matrix0 * tc).xy;
+
+    vec2 t = texel.gb;
+    vary_texcoord0.zw = t;
+    vary_texcoord1.xy = t - vec2(2.0, 0.0);
+    vary_texcoord1.zw = t - vec2(1.0, 0.0);
+#ifdef PARCEL_OVERLAY
+    vary_region_pos = region_pos;
+#endif
+#endif
+}
@@ -37,6 +37,9 @@ out vec3 pos;
 out vec3 vary_normal;
 out vec4 vary_texcoord0;
 out vec4 vary_texcoord1;
+#ifdef PARCEL_OVERLAY
+out vec3 vary_region_pos;
+#endif
 
 uniform vec4 object_plane_s;
 uniform vec4 object_plane_t;
@@ -74,4 +77,9 @@ void main()
     vary_texcoord0.zw = t.xy;
     vary_texcoord1.xy = t.xy-vec2(2.0, 0.0);
     vary_texcoord1.zw = t.xy-vec2(1.0, 0.0);
+
+#ifdef PARCEL_OVERLAY
+    // patch vertices are already relative to the region origin
+    vary_region_pos = position.xyz;
+#endif
 }
@@ -0,0 +1,50 @@
+/** 
+ * @file textureFeedbackF.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+ 
+
+/*[EXTRA_CODE_HERE]*/
+
+// write which texture is visible here and log2 of the texels per side it
+// needs for one texel per screen pixel, over 16
+// must match LLTextureFeedback::DIVISOR (log2 of it)
+#define FEEDBACK_SCALE 3.0
+
+out vec4 frag_color;
+
+uniform vec2 feedback_id;
+
+in vec2 vary_texcoord0;
+
+void main() 
+{
+    vec2 dx = dFdx(vary_texcoord0);
+    vec2 dy = dFdy(vary_texcoord0);
+    float footprint = max(dot(dx, dx), dot(dy, dy));
+
+    // each pixel of the feedback target covers DIVISOR screen pixels per side
+    float res = -0.5 * log2(max(footprint, 1e-12)) + FEEDBACK_SCALE;
+
+    frag_color = vec4(feedback_id, clamp(res, 0.0, 15.9) / 16.0, 1.0);
+}
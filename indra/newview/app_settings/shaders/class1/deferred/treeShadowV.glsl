@@ -31,10 +31,24 @@ in vec2 texcoord0;
 
 out vec2 vary_texcoord0;
 
+#ifdef HAS_INSTANCE_TRANSFORMS
+// one tree mesh drawn at many places, see LLDrawPoolTree
+layout (std140) uniform InstanceTransforms
+{
+    mat4 instanceTransform[MAX_INSTANCE_TRANSFORMS];
+};
+#endif
+
 void main()
 {
+#ifdef HAS_INSTANCE_TRANSFORMS
+	vec4 pos = instanceTransform[gl_InstanceID] * vec4(position.xyz, 1.0);
+#else
+	vec4 pos = vec4(position.xyz, 1.0);
+#endif
+
 	//transform vertex
-	gl_Position = modelview_projection_matrix*vec4(position.xyz, 1.0);
+	gl_Position = modelview_projection_matrix*pos;
 	
 	vary_texcoord0 = (texture_matrix0 * vec4(texcoord0,0,1)).xy;
 }
@@ -35,13 +35,30 @@ out vec3 vary_normal;
 out vec4 vertex_color;
 out vec2 vary_texcoord0;
 
+#ifdef HAS_INSTANCE_TRANSFORMS
+// one tree mesh drawn at many places, see LLDrawPoolTree
+layout (std140) uniform InstanceTransforms
+{
+    mat4 instanceTransform[MAX_INSTANCE_TRANSFORMS];
+};
+#endif
+
 void main()
 {
+#ifdef HAS_INSTANCE_TRANSFORMS
+	mat4 instance = instanceTransform[gl_InstanceID];
+	vec4 pos = instance * vec4(position.xyz, 1.0);
+	vec3 norm = mat3(instance) * normal;
+#else
+	vec4 pos = vec4(position.xyz, 1.0);
+	vec3 norm = normal;
+#endif
+
 	//transform vertex
-	gl_Position = modelview_projection_matrix * vec4(position.xyz, 1.0); 
+	gl_Position = modelview_projection_matrix * pos; 
 	vary_texcoord0 = (texture_matrix0 * vec4(texcoord0,0,1)).xy;
 	
-	vary_normal = normalize(normal_matrix * normal);
+	vary_normal = normalize(normal_matrix * norm);
 
 	vertex_color = vec4(1,1,1,1);
 }
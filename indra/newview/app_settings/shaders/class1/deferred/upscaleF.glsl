@@ -0,0 +1,64 @@
+/**
+ * @file upscaleF.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+/*[EXTRA_CODE_HERE]*/
+
+out vec4 frag_color;
+
+uniform sampler2D diffuseRect;
+uniform sampler2D depthMap;
+
+uniform vec2 source_res; // size of diffuseRect in texels
+uniform float sharpness; // 0 - plain bilinear, 1 - strongest sharpen
+
+in vec2 vary_fragcoord;
+
+// Bilinear upscale followed by a contrast adaptive sharpen along the lines
+// of FSR1's RCAS pass. The negative lobe shrinks where the neighborhood is
+// already close to clipping, which keeps high contrast edges from ringing.
+void main()
+{
+    vec2 tc = vary_fragcoord.xy;
+    vec2 texel = 1.0 / source_res;
+
+    vec4 diff = texture(diffuseRect, tc);
+    vec3 c = diff.rgb;
+    vec3 n = texture(diffuseRect, tc + vec2(0.0, texel.y)).rgb;
+    vec3 s = texture(diffuseRect, tc - vec2(0.0, texel.y)).rgb;
+    vec3 e = texture(diffuseRect, tc + vec2(texel.x, 0.0)).rgb;
+    vec3 w = texture(diffuseRect, tc - vec2(texel.x, 0.0)).rgb;
+
+    vec3 mn = min(c, min(min(n, s), min(e, w)));
+    vec3 mx = max(c, max(max(n, s), max(e, w)));
+
+    vec3 amp = clamp(min(mn, 1.0 - mx) / max(mx, vec3(1e-4)), 0.0, 1.0);
+    vec3 lobe = sqrt(amp) * (-0.2 * clamp(sharpness, 0.0, 1.0));
+
+    vec3 col = (c + (n + s + e + w) * lobe) / (1.0 + 4.0 * lobe);
+
+    frag_color = vec4(max(col, vec3(0.0)), diff.a);
+
+    gl_FragDepth = texture(depthMap, tc).r;
+}
@@ -0,0 +1,54 @@
+/** 
+ * @file alphagradientF.glsl
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+out vec4 frag_color;
+
+uniform sampler2D diffuseMap;
+
+// maps the gradient value to alpha the way LLImageTGA::decodeAndProcess()
+// does: a ramp of slope gradient_scale starting at gradient_bias, or a step
+// at gradient_threshold when gradient_scale is 0
+uniform float gradient_scale;
+uniform float gradient_bias;
+uniform float gradient_threshold;
+
+in vec2 vary_texcoord0;
+in vec4 vertex_color;
+
+void main() 
+{
+	float value = texture(diffuseMap, vary_texcoord0.xy).a;
+	float alpha;
+	if (gradient_scale > 0.0)
+	{
+		alpha = clamp(value * gradient_scale + gradient_bias, 0.0, 1.0);
+	}
+	else
+	{
+		alpha = step(gradient_threshold, value);
+	}
+
+	frag_color = vertex_color * vec4(0, 0, 0, alpha);
+}
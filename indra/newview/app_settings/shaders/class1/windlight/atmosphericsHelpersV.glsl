@@ -31,7 +31,30 @@ vec3 getAmblitColor();
 vec3 getAdditiveColor();
 vec3 getAtmosAttenuation();
 
+#ifdef ATMOSPHERICS_UBO
+// sky parameters shared by every shader, uploaded once per environment
+// update by LLEnvironment::updateAtmosphericsUBO, keep in sync with it
+// and with the other copies of this block
+layout (std140) uniform AtmosphericsUniforms
+{
+    vec3  ambient_color;
+    float haze_horizon;
+    vec3  blue_horizon;
+    float haze_density;
+    vec3  blue_density;
+    float cloud_shadow;
+    vec3  glow;
+    float density_multiplier;
+    float distance_multiplier;
+    float max_y;
+    float scene_light_strength;
+    float sun_moon_glow_factor;
+    float sky_sunlight_scale;
+    float sky_ambient_scale;
+};
+#else
 uniform float scene_light_strength;
+#endif
 
 vec3 atmosAmbient()
 {
@@ -79,6 +79,12 @@ uniform sampler2D screenTex;
 uniform sampler2D depthMap;
 #endif
 
+#ifdef WATER_SSR
+// the scene under the water from this frame, see LLDrawPoolWater
+uniform sampler2D sceneMap;
+float tapScreenSpaceReflection(int totalSamples, vec2 tc, vec3 viewPos, vec3 n, inout vec4 collectedColor, sampler2D source, float glossiness);
+#endif
+
 uniform sampler2D refTex;
 
 uniform float sunAngle;
@@ -237,6 +243,14 @@ void main()
     vec3  radiance  = vec3(0);
     sampleReflectionProbesWater(irradiance, radiance, distort2, pos.xyz, wave_ibl.xyz, gloss, amblit);
 
+#ifdef WATER_SSR
+    // where the reflected ray finds something on screen, use it instead of the probes
+    vec4 ssr = vec4(0);
+    tapScreenSpaceReflection(1, distort, pos.xyz, wave_ibl.xyz, ssr, sceneMap, 1.0);
+    // same fudge factor as sampleReflectionProbesWater
+    radiance = mix(radiance, ssr.rgb * 0.4, ssr.a);
+#endif
+
     irradiance       = vec3(0);
 
     vec3 diffuseColor = vec3(0);
@@ -33,6 +33,7 @@
 #include "llcorehttputil.h"
 #include "llexception.h"
 #include "stringize.h"
+#include "llviewercontrol.h"
 #include <algorithm>
 #include <iterator>
 
@@ -55,6 +56,7 @@ void LLAccountingCostManager::accountingCostCoro(std::string url,
     LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t
         httpAdapter(new LLCoreHttpUtil::HttpCoroutineAdapter("AccountingCost", httpPolicy));
     LLCore::HttpRequest::ptr_t httpRequest(new LLCore::HttpRequest);
+    httpAdapter->setBinaryLLSD(gSavedSettings.getBOOL("HttpBinaryLLSD"));
 
     try
     {
@@ -91,6 +91,7 @@
 #include "llviewerstats.h"
 #include "llviewerwindow.h"
 #include "llvoavatarself.h"
+#include "llvocache.h"
 #include "llwindow.h"
 #include "llworld.h"
 #include "llworldmap.h"
@@ -4312,6 +4313,8 @@ void LLAgent::teleportRequest(
 	{
 		LL_INFOS("Teleport") << "Sending TeleportLocationRequest: '" << region_handle << "':"
 							 << pos_local << LL_ENDL;
+		// the destination's object cache loads while the simulators talk
+		LLVOCache::getInstance()->prefetchRegion(region_handle);
 		LLMessageSystem* msg = gMessageSystem;
 		msg->newMessage("TeleportLocationRequest");
 		msg->nextBlockFast(_PREHASH_AgentData);
@@ -4479,6 +4482,7 @@ void LLAgent::doTeleportViaLocation(const LLVector3d& pos_global)
 		F32 region_x = (F32)(pos_global.mdV[VX]);
 		F32 region_y = (F32)(pos_global.mdV[VY]);
 		U64 region_handle = to_region_handle_global(region_x, region_y);
+		LLVOCache::getInstance()->prefetchRegion(region_handle);
 		msg->addU64Fast(_PREHASH_RegionHandle, region_handle);
 		msg->addVector3Fast(_PREHASH_Position, pos);
 		pos.mV[VX] += 1;
@@ -29,6 +29,7 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
 
 #include "llagentpilot.h"
 #include "llagent.h"
@@ -255,6 +256,7 @@ void LLAgentPilot::startPlayback()
 		mPlaying = TRUE;
 		mCurrentAction = 0;
 		mTimer.reset();
+		mFrameTimes.clear();
 
 		if (mActions.size())
 		{
@@ -275,6 +277,7 @@ void LLAgentPilot::stopPlayback()
 {
 	if (mPlaying)
 	{
+		reportFrameTimes();
 		mPlaying = FALSE;
 		mCurrentAction = 0;
 		mTimer.reset();
@@ -351,6 +354,7 @@ void LLAgentPilot::updateTarget()
 					}
 				}
 			}
+			mFrameTimes.push_back(gFrameIntervalSeconds.value());
 			if (mTimer.getElapsedTimeF32() > mActions[mCurrentAction].mTime)
 			{
 				//gAgent.stopAutoPilot();
@@ -400,6 +404,32 @@ void LLAgentPilot::updateTarget()
 	}
 }
 
+void LLAgentPilot::reportFrameTimes()
+{
+	if (mFrameTimes.empty())
+	{
+		return;
+	}
+
+	std::vector<F32> sorted(mFrameTimes);
+	std::sort(sorted.begin(), sorted.end());
+
+	F64 total = 0.0;
+	for (F32 frame_time : sorted)
+	{
+		total += frame_time;
+	}
+
+	auto percentile = [&sorted](F32 p) { return sorted[llmin((size_t)(p * sorted.size()), sorted.size() - 1)] * 1000.f; };
+
+	LL_INFOS() << "Pilot run frame times over " << sorted.size() << " frames (ms):"
+			   << " mean " << total / sorted.size() * 1000.0
+			   << " p50 " << percentile(0.5f)
+			   << " p95 " << percentile(0.95f)
+			   << " p99 " << percentile(0.99f)
+			   << " max " << sorted.back() * 1000.f << LL_ENDL;
+}
+
 void LLAgentPilot::addWaypoint()
 {
 	addAction(STRAIGHT);
@@ -61,6 +61,8 @@ public:
 
 	bool isRecording() { return mRecording; }
 	bool isPlaying() { return mPlaying; }
+	// reached the first waypoint, the recorded path is being flown
+	bool isStarted() { return mPlaying && mStarted; }
 	bool getOverrideCamera() { return mOverrideCamera; }
 	
 	void updateTarget();
@@ -89,6 +91,10 @@ private:
 
 	void setAutopilotTarget(const S32 id);
 
+	// log the spread of frame times seen since the last startPlayback()
+	void reportFrameTimes();
+	std::vector<F32> mFrameTimes;
+
 	BOOL	mRecording;
 	F32		mLastRecordTime;
 
@@ -39,6 +39,7 @@
 #include "llvoavatar.h"
 #include "llvoavatarself.h"
 #include "llviewercontrol.h"
+#include "workqueue.h"
 
 ///----------------------------------------------------------------------------
 /// Classes for AISv3 support.
@@ -788,9 +789,16 @@ void AISAPI::EnqueueAISCommand(const std::string &procName, LLCoprocedureManager
     LLCoprocedureManager &inst = LLCoprocedureManager::instance();
     S32 pending_in_pool = inst.countPending("AIS");
     std::string procFullName = "AIS(" + procName + ")";
-    if (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES)
+    // Bulk fetches go behind edits and COF fetches the user is waiting on,
+    // the latter don't need to wait for the postponed fetch backlog either.
+    bool background = procName.compare(0, 5, "Fetch") == 0 && procName != "FetchCOF";
+    if (!background)
     {
-        inst.enqueueCoprocedure("AIS", procFullName, proc);
+        inst.enqueueCoprocedure("AIS", procFullName, proc, LLCoprocedureManager::PRIORITY_NORMAL);
+    }
+    else if (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES)
+    {
+        inst.enqueueCoprocedure("AIS", procFullName, proc, LLCoprocedureManager::PRIORITY_BACKGROUND);
     }
     else
     {
@@ -819,7 +827,7 @@ void AISAPI::onIdle(void *userdata)
         while (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES && !sPostponedQuery.empty())
         {
             ais_query_item_t &item = sPostponedQuery.front();
-            inst.enqueueCoprocedure("AIS", item.first, item.second);
+            inst.enqueueCoprocedure("AIS", item.first, item.second, LLCoprocedureManager::PRIORITY_BACKGROUND);
             sPostponedQuery.pop_front();
             pending_in_pool++;
         }
@@ -866,6 +874,8 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
     LLCore::HttpHeaders::ptr_t httpHeaders;
 
     httpOptions->setTimeout(HTTP_TIMEOUT);
+    // Pool adapters are reused, the setting applies to each command
+    httpAdapter->setBinaryLLSD(gSavedSettings.getBOOL("HttpBinaryLLSD"));
 
     LL_DEBUGS("Inventory") << "Request url: " << url << LL_ENDL;
 
@@ -1038,9 +1048,97 @@ AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD&
 
     mTimer.setTimerExpirySec(AIS_EXPIRY_SECONDS);
     mTimer.start();
+
+    mBatchUpdates = gSavedSettings.getBOOL("InventoryAISBatchUpdates");
+    LL::WorkQueue::ptr_t general_queue = (mBatchUpdates && !LLCoros::getName().empty()) ? LL::WorkQueue::getInstance("General") : nullptr;
+    if (general_queue)
+    {
+        // Decode the response into inventory objects on a worker while this
+        // coroutine waits, then parse below only has to match them up with
+        // the model.
+        try
+        {
+            general_queue->waitForResult([this, &update]() { prepareObjects(update); });
+        }
+        catch (const LL::WorkQueue::Closed&)
+        {
+            mPreparedItems.clear();
+            mPreparedCategories.clear();
+        }
+    }
+
 	parseUpdate(update);
 }
 
+void AISUpdate::prepareObjects(const LLSD& content)
+{
+    if (content.has("item_id") && content.has("parent_id"))
+    {
+        LLPointer<LLViewerInventoryItem> new_item(new LLViewerInventoryItem);
+        if (new_item->unpackMessage(content))
+        {
+            mPreparedItems[content["item_id"].asUUID()] = new_item;
+        }
+    }
+    else if (content.has("category_id") && content.has("parent_id") && content.has("agent_id"))
+    {
+        LLPointer<LLViewerInventoryCategory> new_cat(new LLViewerInventoryCategory(content["agent_id"].asUUID()));
+        if (new_cat->unpackMessage(content))
+        {
+            mPreparedCategories[content["category_id"].asUUID()] = new_cat;
+        }
+    }
+
+    if (!content.has("_embedded"))
+    {
+        return;
+    }
+
+    const LLSD& embedded = content["_embedded"];
+    for (const char* key : { "links", "items", "categories" })
+    {
+        if (embedded.has(key))
+        {
+            const LLSD& objects = embedded[key];
+            for (LLSD::map_const_iterator it = objects.beginMap(), end = objects.endMap(); it != end; ++it)
+            {
+                prepareObjects(it->second);
+            }
+        }
+    }
+    for (const char* key : { "item", "category" })
+    {
+        if (embedded.has(key))
+        {
+            prepareObjects(embedded[key]);
+        }
+    }
+}
+
+LLPointer<LLViewerInventoryItem> AISUpdate::takePreparedItem(const LLUUID& item_id)
+{
+    LLPointer<LLViewerInventoryItem> new_item;
+    deferred_item_map_t::iterator it = mPreparedItems.find(item_id);
+    if (it != mPreparedItems.end())
+    {
+        new_item = it->second;
+        mPreparedItems.erase(it);
+    }
+    return new_item;
+}
+
+LLPointer<LLViewerInventoryCategory> AISUpdate::takePreparedCategory(const LLUUID& category_id)
+{
+    LLPointer<LLViewerInventoryCategory> new_cat;
+    deferred_category_map_t::iterator it = mPreparedCategories.find(category_id);
+    if (it != mPreparedCategories.end())
+    {
+        new_cat = it->second;
+        mPreparedCategories.erase(it);
+    }
+    return new_cat;
+}
+
 void AISUpdate::clearParseResults()
 {
 	mCatDescendentDeltas.clear();
@@ -1191,14 +1289,19 @@ void AISUpdate::parseContent(const LLSD& update)
 void AISUpdate::parseItem(const LLSD& item_map)
 {
 	LLUUID item_id = item_map["item_id"].asUUID();
-	LLPointer<LLViewerInventoryItem> new_item(new LLViewerInventoryItem);
 	LLViewerInventoryItem *curr_item = gInventory.getItem(item_id);
-	if (curr_item)
+	LLPointer<LLViewerInventoryItem> new_item = curr_item ? NULL : takePreparedItem(item_id);
+	BOOL rv = TRUE;
+	if (new_item.isNull())
 	{
-		// Default to current values where not provided.
-		new_item->copyViewerItem(curr_item);
+		new_item = new LLViewerInventoryItem;
+		if (curr_item)
+		{
+			// Default to current values where not provided.
+			new_item->copyViewerItem(curr_item);
+		}
+		rv = new_item->unpackMessage(item_map);
 	}
-	BOOL rv = new_item->unpackMessage(item_map);
 	if (rv)
 	{
         if (mFetch)
@@ -1236,14 +1339,19 @@ void AISUpdate::parseItem(const LLSD& item_map)
 void AISUpdate::parseLink(const LLSD& link_map, S32 depth)
 {
 	LLUUID item_id = link_map["item_id"].asUUID();
-	LLPointer<LLViewerInventoryItem> new_link(new LLViewerInventoryItem);
 	LLViewerInventoryItem *curr_link = gInventory.getItem(item_id);
-	if (curr_link)
+	LLPointer<LLViewerInventoryItem> new_link = curr_link ? NULL : takePreparedItem(item_id);
+	BOOL rv = TRUE;
+	if (new_link.isNull())
 	{
-		// Default to current values where not provided.
-		new_link->copyViewerItem(curr_link);
+		new_link = new LLViewerInventoryItem;
+		if (curr_link)
+		{
+			// Default to current values where not provided.
+			new_link->copyViewerItem(curr_link);
+		}
+		rv = new_link->unpackMessage(link_map);
 	}
-	BOOL rv = new_link->unpackMessage(link_map);
 	if (rv)
 	{
 		const LLUUID& parent_id = new_link->getParentUUID();
@@ -1322,11 +1430,17 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
         return;
     }
 
-	LLPointer<LLViewerInventoryCategory> new_cat;
-	if (curr_cat)
+	LLPointer<LLViewerInventoryCategory> new_cat = curr_cat ? NULL : takePreparedCategory(category_id);
+	BOOL rv = TRUE;
+	if (new_cat.notNull())
+	{
+		// already unpacked by prepareObjects()
+	}
+	else if (curr_cat)
 	{
 		// Default to current values where not provided.
         new_cat = new LLViewerInventoryCategory(curr_cat);
+        rv = new_cat->unpackMessage(category_map);
     }
     else
     {
@@ -1339,8 +1453,8 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
             LL_DEBUGS() << "No owner provided, folder might be assigned wrong owner" << LL_ENDL;
             new_cat = new LLViewerInventoryCategory(LLUUID::null);
         }
+        rv = new_cat->unpackMessage(category_map);
     }
-	BOOL rv = new_cat->unpackMessage(category_map);
 	// *NOTE: unpackMessage does not unpack version or descendent count.
 	if (rv)
 	{
@@ -1635,10 +1749,14 @@ void AISUpdate::doUpdate()
 		gInventory.updateCategory(new_category, LLInventoryObserver::CREATE);
 		LL_DEBUGS("Inventory") << "created category " << category_id << LL_ENDL;
 
-        // fetching can receive massive amount of items and folders
+        // fetching can receive massive amount of items and folders,
+        // unless batching, notify in chunks to spread the observer work
         if (gInventory.getChangedIDs().size() > MAX_UPDATE_BACKLOG)
         {
-            gInventory.notifyObservers();
+            if (!mBatchUpdates)
+            {
+                gInventory.notifyObservers();
+            }
             checkTimeout();
         }
 	}
@@ -1696,10 +1814,14 @@ void AISUpdate::doUpdate()
 		LL_DEBUGS("Inventory") << "created item " << item_id << LL_ENDL;
 		gInventory.updateItem(new_item, LLInventoryObserver::CREATE);
 
-        // fetching can receive massive amount of items and folders
+        // fetching can receive massive amount of items and folders,
+        // unless batching, notify in chunks to spread the observer work
         if (gInventory.getChangedIDs().size() > MAX_UPDATE_BACKLOG)
         {
-            gInventory.notifyObservers();
+            if (!mBatchUpdates)
+            {
+                gInventory.notifyObservers();
+            }
             checkTimeout();
         }
 	}
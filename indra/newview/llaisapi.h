@@ -129,6 +129,11 @@ public:
 private:
 	void clearParseResults();
     void checkTimeout();
+    // Unpacks every item, link and category in the response into new objects.
+    // Runs on a worker, so it touches nothing but its arguments and mPrepared*.
+    void prepareObjects(const LLSD& content);
+    LLPointer<LLViewerInventoryItem> takePreparedItem(const LLUUID& item_id);
+    LLPointer<LLViewerInventoryCategory> takePreparedCategory(const LLUUID& category_id);
 
     // Fetch can return large packets of data, throttle it to not cause lags
     // Todo: make throttle work over all fetch requests isntead of per-request
@@ -147,6 +152,10 @@ private:
 	deferred_category_map_t mCategoriesCreated;
 	deferred_category_map_t mCategoriesUpdated;
 
+	// Objects unpacked off the main thread, used when the model doesn't have them yet
+	deferred_item_map_t mPreparedItems;
+	deferred_category_map_t mPreparedCategories;
+
 	// These keep track of uuid's mentioned in meta values.
 	// Useful for filtering out which content we are interested in.
 	uuid_list_t mObjectsDeletedIds;
@@ -156,6 +165,7 @@ private:
     S32 mFetchDepth;
     LLTimer mTimer;
     AISAPI::COMMAND_TYPE mType;
+    bool mBatchUpdates;
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "llappcorehttp.h"
 
 #include "llappviewer.h"
+#include "llframetimer.h"
 #include "llviewercontrol.h"
 #include "llexception.h"
 #include "stringize.h"
@@ -39,6 +40,8 @@
 #include <curl/curl.h>
 
 #include "llcorehttputil.h"
+#include "lldiskcache.h"
+#include "llfilesystem.h"
 #include "httpstats.h"
 
 // Here is where we begin to get our connection usage under control.
@@ -51,6 +54,11 @@
 const F64 LLAppCoreHttp::MAX_THREAD_WAIT_TIME(10.0);
 const long LLAppCoreHttp::PIPELINING_DEPTH(5L);
 
+// Concurrency picked by the adaptive controller, for the statistics floater
+static LLTrace::SampleStatHandle<> sTextureConcurrency("httptextureconcurrency", "Texture fetch concurrency");
+static LLTrace::SampleStatHandle<> sMeshConcurrency("httpmeshconcurrency", "Mesh fetch concurrency");
+static LLTrace::SampleStatHandle<> sMesh2Concurrency("httpmesh2concurrency", "Mesh2 fetch concurrency");
+
 //  Default and dynamic values for classes
 static const struct
 {
@@ -59,70 +67,129 @@ static const struct
 	U32							mMax;
 	U32							mRate;
 	bool						mPipelined;
+	bool						mCached;		// GET responses may go in the response cache
 	std::string					mKey;
 	const char *				mUsage;
+	LLTrace::SampleStatHandle<> * mAdaptiveStat;	// Non-NULL if concurrency adapts, samples the value picked
 } init_data[LLAppCoreHttp::AP_COUNT] =
 {
 	{ // AP_DEFAULT
-		8,		8,		8,		0,		false,
+		8,		8,		8,		0,		false,	true,
 		"",
-		"other"
+		"other",
+		NULL
 	},
 	{ // AP_TEXTURE
-		8,		1,		12,		0,		true,
+		8,		1,		12,		0,		true,	false,
 		"TextureFetchConcurrency",
-		"texture fetch"
+		"texture fetch",
+		&sTextureConcurrency
 	},
 	{ // AP_MESH1
-		32,		1,		128,	0,		false,
+		32,		1,		128,	0,		false,	false,
 		"MeshMaxConcurrentRequests",
-		"mesh fetch"
+		"mesh fetch",
+		&sMeshConcurrency
 	},
 	{ // AP_MESH2
-		8,		1,		32,		0,		true,	
+		8,		1,		32,		0,		true,	false,
 		"Mesh2MaxConcurrentRequests",
-		"mesh2 fetch"
+		"mesh2 fetch",
+		&sMesh2Concurrency
 	},
 	{ // AP_LARGE_MESH
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	false,
 		"",
-		"large mesh fetch"
+		"large mesh fetch",
+		NULL
 	},
 	{ // AP_UPLOADS 
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	false,
 		"",
-		"asset upload"
+		"asset upload",
+		NULL
 	},
 	{ // AP_LONG_POLL
-		32,		32,		32,		0,		false,
+		32,		32,		32,		0,		false,	false,
 		"",
-		"long poll"
+		"long poll",
+		NULL
 	},
 	{ // AP_INVENTORY
-		4,		1,		4,		0,		false,
+		4,		1,		4,		0,		false,	false,
 		"",
-		"inventory"
+		"inventory",
+		NULL
 	},
 	{ // AP_MATERIALS
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	true,
 		"RenderMaterials",
-		"material manager requests"
+		"material manager requests",
+		NULL
 	},
 	{ // AP_AGENT
-		2,		1,		32,		0,		false,
+		2,		1,		32,		0,		false,	true,
 		"Agent",
-		"Agent requests"
+		"Agent requests",
+		NULL
 	}
 };
 
 static void setting_changed();
 static void ssl_verification_changed();
 
+namespace
+{
+
+// Keeps llcorehttp response cache entries in the disk cache under
+// an id hashed from the URL, so they are sized and purged with the
+// assets.  Runs on the HTTP worker thread.
+class LLHttpResponseStore : public LLCore::HttpCacheStore
+{
+public:
+	bool read(const std::string & url, std::string & data) override
+	{
+		if (! LLDiskCache::instanceExists())
+		{
+			return false;
+		}
+		LLFileSystem file(LLUUID::generateNewID(url), LLAssetType::AT_UNKNOWN, LLFileSystem::READ);
+		S32 size(file.getSize());
+		if (size <= 0)
+		{
+			return false;
+		}
+		data.resize(size);
+		return file.read(reinterpret_cast<U8 *>(&data[0]), size);
+	}
+
+	void write(const std::string & url, const std::string & data) override
+	{
+		if (LLDiskCache::instanceExists())
+		{
+			LLFileSystem file(LLUUID::generateNewID(url), LLAssetType::AT_UNKNOWN, LLFileSystem::WRITE);
+			file.write(reinterpret_cast<const U8 *>(data.data()), S32(data.size()));
+		}
+	}
+
+	void remove(const std::string & url) override
+	{
+		if (LLDiskCache::instanceExists())
+		{
+			LLFileSystem::removeFile(LLUUID::generateNewID(url), LLAssetType::AT_UNKNOWN);
+		}
+	}
+};
+
+} // end anonymous namespace
+
 
 LLAppCoreHttp::HttpClass::HttpClass()
 	: mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
 	  mConnLimit(0U),
-	  mPipelined(false)
+	  mPipelined(false),
+	  mAdaptiveLimit(0U),
+	  mMinLatency(0.0)
 {}
 
 
@@ -131,7 +198,10 @@ LLAppCoreHttp::LLAppCoreHttp()
 	  mStopHandle(LLCORE_HTTP_HANDLE_INVALID),
 	  mStopRequested(0.0),
 	  mStopped(false),
-	  mPipelined(true)
+	  mPipelined(true),
+	  mMultiplexed(false),
+	  mResponseCache(false),
+	  mAdaptTime(0.0)
 {}
 
 
@@ -229,6 +299,20 @@ void LLAppCoreHttp::init()
 															trace_level, NULL);
 	}
 	
+	// Response cache for the classes that allow it, see init_data
+	static const std::string http_response_cache("HttpResponseCache");
+	if (gSavedSettings.controlExists(http_response_cache) && gSavedSettings.getBOOL(http_response_cache))
+	{
+		mResponseCache = true;
+		status = LLCore::HttpRequest::setStaticCacheStore(LLCore::HttpCacheStore::ptr_t(new LLHttpResponseStore));
+		if (! status)
+		{
+			LL_WARNS("Init") << "Failed to set HTTP response cache.  Reason:  " << status.toString()
+							 << LL_ENDL;
+			mResponseCache = false;
+		}
+	}
+
 	// Setup default policy and constrain if directed to
 	mHttpClasses[AP_DEFAULT].mPolicy = LLCore::HttpRequest::DEFAULT_POLICY_ID;
 
@@ -261,6 +345,14 @@ void LLAppCoreHttp::init()
 	// Need a request object to handle dynamic options before setting them
 	mRequest = new LLCore::HttpRequest;
 
+	// Global HTTP/2 setting, replaces pipelining on the pipelined classes
+	static const std::string http_multiplexing("HttpMultiplexing");
+	if (gSavedSettings.controlExists(http_multiplexing))
+	{
+		mMultiplexed = gSavedSettings.getBOOL(http_multiplexing);
+		LL_INFOS("Init") << "HTTP/2 Multiplexing " << (mMultiplexed ? "enabled" : "disabled") << "!" << LL_ENDL;
+	}
+
 	// Apply initial settings
 	refreshSettings(true);
 	
@@ -415,6 +507,20 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 				}
 			}
 
+			if (mResponseCache && init_data[i].mCached)
+			{
+				status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_RESPONSE_CACHE,
+																	mHttpClasses[app_policy].mPolicy,
+																	1L,
+																	NULL);
+				if (! status)
+				{
+					LL_WARNS("Init") << "Unable to enable " << init_data[i].mUsage
+									 << " response cache.  Reason:  " << status.toString()
+									 << LL_ENDL;
+				}
+			}
+
 		}
 
 		// Init- or run-time settings.  Must use the queued request API.
@@ -427,10 +533,15 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 			{
 				// Pipeline election changing, set dynamic option via request
 
+				// With multiplexing the same depth becomes the number of
+				// HTTP/2 streams per connection so request concurrency,
+				// and the high water marks built on it, don't change.
 				LLCore::HttpHandle handle;
 				const long new_depth(to_pipeline ? PIPELINING_DEPTH : 0);
 				
-				handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_PIPELINING_DEPTH,
+				handle = mRequest->setPolicyOption((mMultiplexed
+													? LLCore::HttpRequest::PO_HTTP2_STREAMS
+													: LLCore::HttpRequest::PO_PIPELINING_DEPTH),
 												   mHttpClasses[app_policy].mPolicy,
 												   new_depth,
                                                    LLCore::HttpHandler::ptr_t());
@@ -510,6 +621,8 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 									  << " concurrency.  New value:  " << setting
 									  << LL_ENDL;
 					mHttpClasses[app_policy].mConnLimit = setting;
+					// Adaptive control starts over from the new target
+					mHttpClasses[app_policy].mAdaptiveLimit = 0U;
 					if (initial && setting != init_data[i].mDefault)
 					{
 						LL_INFOS("Init") << "Application settings overriding default " << init_data[i].mUsage
@@ -522,6 +635,166 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 	}
 }
 
+void LLAppCoreHttp::updateConcurrency()
+{
+	using namespace LLTrace;
+
+	// Adjust the concurrency of the fetch classes from the latency and
+	// throttling seen over the last period, in the manner of TCP Vegas.
+	// Latency near the lowest seen means the path has room so a busy
+	// class grows by one.  Latency well above it means requests are
+	// queueing somewhere so the class shrinks by one.  429 and 503
+	// replies mean the service is pushing back so it shrinks by a
+	// quarter.  The user's setting is only the starting point.
+	static const F64 ADAPT_PERIOD(2.0);
+	static LLCachedControl<bool> adaptive(gSavedSettings, "HttpAdaptiveConcurrency", false);
+
+	if (! mRequest || mStopHandle != LLCORE_HTTP_HANDLE_INVALID)
+	{
+		return;
+	}
+
+	if (! adaptive)
+	{
+		// Turned off, put back the user's values
+		for (int i(0); i < LL_ARRAY_SIZE(init_data); ++i)
+		{
+			HttpClass & http_class(mHttpClasses[i]);
+			if (http_class.mAdaptiveLimit)
+			{
+				setAdaptiveLimit(static_cast<EAppPolicy>(i), http_class.mConnLimit);
+				http_class.mAdaptiveLimit = 0U;
+				http_class.mMinLatency = 0.0;
+			}
+		}
+		return;
+	}
+
+	const F64 now(LLFrameTimer::getElapsedSeconds());
+	if (now - mAdaptTime < ADAPT_PERIOD)
+	{
+		return;
+	}
+	const F64 period(now - mAdaptTime);
+	mAdaptTime = now;
+
+	for (int i(0); i < LL_ARRAY_SIZE(init_data); ++i)
+	{
+		if (! init_data[i].mAdaptiveStat)
+		{
+			continue;
+		}
+
+		const EAppPolicy app_policy(static_cast<EAppPolicy>(i));
+		HttpClass & http_class(mHttpClasses[app_policy]);
+		const LLCore::HTTPStats::ClassStats stats(LLCore::HTTPStats::instance().sampleClassStats(http_class.mPolicy));
+		U32 limit(http_class.mAdaptiveLimit ? http_class.mAdaptiveLimit : http_class.mConnLimit);
+
+		if (stats.mCompleted)
+		{
+			const F64 latency(stats.mLatencySum / stats.mCompleted);
+
+			// Lowest latency seen, allowed to creep up so that it follows
+			// a path that got slower for good
+			http_class.mMinLatency = (http_class.mMinLatency > 0.0
+									  ? llmin(latency, http_class.mMinLatency * 1.05)
+									  : latency);
+
+			// Average requests in flight over the period (Little's law)
+			const F64 in_flight(stats.mLatencySum / period);
+
+			if (stats.mThrottled)
+			{
+				limit = limit * 3 / 4;
+			}
+			else if (latency > 2.0 * http_class.mMinLatency)
+			{
+				limit -= 1;
+			}
+			else if (latency < 1.5 * http_class.mMinLatency && in_flight >= 0.75 * limit)
+			{
+				limit += 1;
+			}
+			limit = llclamp(limit, init_data[i].mMin, init_data[i].mMax);
+		}
+
+		if (limit != (http_class.mAdaptiveLimit ? http_class.mAdaptiveLimit : http_class.mConnLimit))
+		{
+			setAdaptiveLimit(app_policy, limit);
+		}
+		http_class.mAdaptiveLimit = limit;
+		sample(*init_data[i].mAdaptiveStat, limit);
+	}
+}
+
+
+void LLAppCoreHttp::preconnect(EAppPolicy app_policy, const std::string & url)
+{
+	static LLCachedControl<U32> preconnect_count(gSavedSettings, "HttpPreconnect", 0U);
+
+	if (! preconnect_count || ! mRequest || mStopHandle != LLCORE_HTTP_HANDLE_INVALID)
+	{
+		return;
+	}
+
+	// Connections are kept per scheme, host and port, any path will do
+	const std::string::size_type scheme_end(url.find("://"));
+	if (std::string::npos == scheme_end)
+	{
+		return;
+	}
+	const std::string root(url.substr(0, url.find('/', scheme_end + 3)) + "/");
+
+	const HttpClass & http_class(mHttpClasses[app_policy]);
+	const U32 count(llmin(U32(preconnect_count),
+						  http_class.mAdaptiveLimit ? http_class.mAdaptiveLimit : http_class.mConnLimit));
+	for (U32 i(0); i < count; ++i)
+	{
+		LLCore::HttpHandle handle(mRequest->requestPreconnect(http_class.mPolicy,
+															  root,
+															  LLCore::HttpHandler::ptr_t()));
+		if (LLCORE_HTTP_HANDLE_INVALID == handle)
+		{
+			LL_WARNS_ONCE("CoreHttp") << "Unable to preconnect for " << init_data[app_policy].mUsage
+									  << ".  Reason:  " << mRequest->getStatus().toString()
+									  << LL_ENDL;
+			return;
+		}
+	}
+	LL_DEBUGS("CoreHttp") << "Preconnecting " << count << " " << init_data[app_policy].mUsage
+						  << " connections to " << root
+						  << LL_ENDL;
+}
+
+
+void LLAppCoreHttp::setAdaptiveLimit(EAppPolicy app_policy, U32 limit)
+{
+	// Same connection strategy as refreshSettings()
+	const HttpClass & http_class(mHttpClasses[app_policy]);
+	LLCore::HttpHandle handle;
+	handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
+									   http_class.mPolicy,
+									   (http_class.mPipelined ? 2 * limit : limit),
+									   LLCore::HttpHandler::ptr_t());
+	if (LLCORE_HTTP_HANDLE_INVALID != handle)
+	{
+		handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+										   http_class.mPolicy,
+										   limit,
+										   LLCore::HttpHandler::ptr_t());
+	}
+	if (LLCORE_HTTP_HANDLE_INVALID == handle)
+	{
+		LL_WARNS_ONCE("CoreHttp") << "Unable to adapt " << init_data[app_policy].mUsage
+								  << " concurrency.  Reason:  " << mRequest->getStatus().toString()
+								  << LL_ENDL;
+		return;
+	}
+	LL_DEBUGS("CoreHttp") << "Adapted " << init_data[app_policy].mUsage
+						  << " concurrency.  New value:  " << limit
+						  << LL_ENDL;
+}
+
 LLCore::HttpStatus LLAppCoreHttp::sslVerify(const std::string &url, 
 	const LLCore::HttpHandler::ptr_t &handler, void *appdata)
 {
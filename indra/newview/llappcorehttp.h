@@ -230,7 +230,20 @@ public:
 
 	// Apply initial or new settings from the environment.
 	void refreshSettings(bool initial);
+
+	// Adapt the concurrency of the fetch classes to observed latency
+	// and throttling when 'HttpAdaptiveConcurrency' is on.  Call once
+	// per frame, does its work every couple of seconds.
+	void updateConcurrency();
+
+	// Open connections to the host of url ahead of the first real
+	// requests so that DNS, TCP and TLS setup are already done.
+	// Count comes from 'HttpPreconnect', does nothing when it's 0.
+	void preconnect(EAppPolicy app_policy, const std::string & url);
 	
+private:
+	void setAdaptiveLimit(EAppPolicy app_policy, U32 limit);
+
 private:
 	static const F64			MAX_THREAD_WAIT_TIME;
 	
@@ -246,6 +259,8 @@ private:
 		policy_t					mPolicy;			// Policy class id for the class
 		U32							mConnLimit;
 		bool						mPipelined;
+		U32							mAdaptiveLimit;		// Concurrency picked by updateConcurrency(), 0 if none
+		F64							mMinLatency;		// Baseline request latency for adaptation
 		boost::signals2::connection mSettingsSignal;	// Signal to global setting that affect this class (if any)
 	};
 		
@@ -255,6 +270,9 @@ private:
 	bool						mStopped;
 	HttpClass					mHttpClasses[AP_COUNT];
 	bool						mPipelined;				// Global setting
+	bool						mMultiplexed;			// Global 'HttpMultiplexing' setting
+	bool						mResponseCache;			// Global 'HttpResponseCache' setting
+	F64							mAdaptTime;				// Time of last concurrency adaptation
 	boost::signals2::connection	mPipelinedSignal;		// Signal for 'HttpPipelining' setting
 	boost::signals2::connection	mSSLNoVerifySignal;		// Signal for 'NoVerifySSLCert' setting
 
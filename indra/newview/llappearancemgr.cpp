@@ -2191,6 +2191,22 @@ void LLAppearanceMgr::updateCOF(const LLUUID& category, bool append)
 	removeDuplicateItems(wear_items);
 	filterWearableItems(wear_items, 0, LLAgentWearables::MAX_CLOTHING_LAYERS);
 
+	// The new wearables are known now, start loading them while the COF
+	// links are being created so LLWearableHoldingPattern finds them ready.
+	static LLCachedControl<bool> prefetch_wearables(gSavedSettings, "OutfitChangePrefetch", false);
+	if (prefetch_wearables && isAgentAvatarValid())
+	{
+		LLInventoryModel::item_array_t prefetch_items(body_items);
+		std::copy(wear_items.begin(), wear_items.end(), std::back_inserter(prefetch_items));
+		for (LLViewerInventoryItem* item : prefetch_items)
+		{
+			if (item->isWearableType() && item->getAssetUUID().notNull())
+			{
+				LLWearableList::instance().prefetchAsset(item->getAssetUUID(), gAgentAvatarp, item->getType());
+			}
+		}
+	}
+
 	// - Attachments: include COF contents only if appending.
 	LLInventoryModel::item_array_t obj_items;
 	if (append)
@@ -37,6 +37,7 @@
 #include "llerrorcontrol.h"
 #include "lleventtimer.h"
 #include "llfile.h"
+#include "llframearena.h"
 #include "llviewertexturelist.h"
 #include "llgroupmgr.h"
 #include "llagent.h"
@@ -44,6 +45,7 @@
 #include "llagentlanguage.h"
 #include "llagentui.h"
 #include "llagentwearables.h"
+#include "llasyncpersist.h"
 #include "lldirpicker.h"
 #include "llfloaterimcontainer.h"
 #include "llimprocessing.h"
@@ -76,6 +78,7 @@
 #include "llviewermedia.h"
 #include "llviewerparcelaskplay.h"
 #include "llviewerparcelmedia.h"
+#include "llviewerpartsim.h"
 #include "llviewershadermgr.h"
 #include "llviewermediafocus.h"
 #include "llviewermessage.h"
@@ -87,6 +90,7 @@
 #include "llurldispatcher.h"
 #include "llurlhistory.h"
 #include "llrender.h"
+#include "llvertexbuffer.h"
 #include "llteleporthistory.h"
 #include "lltoast.h"
 #include "llsdutil_math.h"
@@ -105,7 +109,12 @@
 #include "llvopartgroup.h"
 #include "llweb.h"
 #include "llspellcheck.h"
+#include "llemojidictionary.h"
 #include "llscenemonitor.h"
+#include "llrenderbenchmark.h"
+#include "llbackgroundmode.h"
+#include "llframepacer.h"
+#include "llframetelemetry.h"
 #include "llavatarrenderinfoaccountant.h"
 #include "lllocalbitmaps.h"
 #include "llperfstats.h" 
@@ -198,11 +207,15 @@
 #include "llslurl.h"
 #include "llurlregistry.h"
 #include "llwatchdog.h"
+#include "llhitchrecorder.h"
+#include "llstallmonitor.h"
+#include "llstartupprofiler.h"
 
 // Included so that constants/settings might be initialized
 // in save_settings_to_globals()
 #include "llbutton.h"
 #include "llstatusbar.h"
+#include "llstreamingpriority.h"
 #include "llsurface.h"
 #include "llvosky.h"
 #include "llvotree.h"
@@ -225,6 +238,7 @@
 #include "llviewercontrol.h"
 #include "lleventnotifier.h"
 #include "llcallbacklist.h"
+#include "lldeferredinit.h"
 #include "lldeferredsounds.h"
 #include "pipeline.h"
 #include "llgesturemgr.h"
@@ -239,6 +253,7 @@
 #include "llavatariconctrl.h"
 #include "llgroupiconctrl.h"
 #include "llviewerassetstats.h"
+#include "taskgraph.h"
 #include "workqueue.h"
 using namespace LL;
 
@@ -541,11 +556,15 @@ static void settings_to_globals()
     LLRender::sGLCoreProfile = gSavedSettings.getBOOL("RenderGLContextCoreProfile");
 #endif
 	LLRender::sNsightDebugSupport = gSavedSettings.getBOOL("RenderNsightDebugSupport");
+	LLVertexBuffer::sUseStreamRing = gSavedSettings.getBOOL("RenderStreamRing");
+	LLVertexBuffer::sUseVAOCache = gSavedSettings.getBOOL("RenderUseVAO");
 	LLImageGL::sGlobalUseAnisotropic	= gSavedSettings.getBOOL("RenderAnisotropic");
 	LLImageGL::sCompressTextures		= gSavedSettings.getBOOL("RenderCompressTextures");
+	LLImageGL::sGPUTextureProcessing	= gSavedSettings.getBOOL("RenderGPUTextureProcessing");
 	LLVOVolume::sLODFactor				= llclamp(gSavedSettings.getF32("RenderVolumeLODFactor"), 0.01f, MAX_LOD_FACTOR);
 	LLVOVolume::sDistanceFactor			= 1.f-LLVOVolume::sLODFactor * 0.1f;
 	LLVolumeImplFlexible::sUpdateFactor = gSavedSettings.getF32("RenderFlexTimeFactor");
+	LLVolumeFace::sUseBVH				= gSavedSettings.getBOOL("RenderPickBVH");
 	LLVOTree::sTreeFactor				= gSavedSettings.getF32("RenderTreeLODFactor");
 	LLVOAvatar::sLODFactor				= llclamp(gSavedSettings.getF32("RenderAvatarLODFactor"), 0.f, MAX_AVATAR_LOD_FACTOR);
 	LLVOAvatar::sPhysicsLODFactor		= llclamp(gSavedSettings.getF32("RenderAvatarPhysicsLODFactor"), 0.f, MAX_AVATAR_LOD_FACTOR);
@@ -647,6 +666,7 @@ LLAppViewer::LLAppViewer()
 	mPurgeCache(false),
 	mPurgeCacheOnExit(false),
 	mPurgeUserDataOnExit(false),
+	mShutdownPersist(NULL),
 	mSecondInstance(false),
 	mUpdaterNotFound(false),
 	mSavedFinalSnapshot(false),
@@ -656,6 +676,7 @@ LLAppViewer::LLAppViewer()
 	mLastAgentControlFlags(0),
 	mLastAgentForceUpdate(0),
 	mMainloopTimeout(NULL),
+	mHitchTraceSeconds(10.f),
 	mAgentRegionLastAlive(false),
 	mRandomizeFramerate(LLCachedControl<bool>(gSavedSettings,"Randomize Framerate", FALSE)),
 	mPeriodicSlowFrame(LLCachedControl<bool>(gSavedSettings,"Periodic Slow Frame", FALSE)),
@@ -730,6 +751,8 @@ bool LLAppViewer::init()
 {
 	setupErrorHandling(mSecondInstance);
 
+	LLStartupProfiler::Scope init_scope("LLAppViewer::init");
+
 	//
 	// Start of the application
 	//
@@ -756,14 +779,17 @@ bool LLAppViewer::init()
 	init_default_trans_args();
 
     // inits from settings.xml and from strings.xml
+	LLStartupProfiler::begin("configuration");
 	if (!initConfiguration())
 		return false;
+	LLStartupProfiler::end();
 
 	LL_INFOS("InitInfo") << "Configuration initialized." << LL_ENDL ;
 
 	//set the max heap size.
 	initMaxHeapSize() ;
 	LLCoros::instance().setStackSize(gSavedSettings.getS32("CoroutineStackSize"));
+	LLCoros::instance().setStackPoolSize(gSavedSettings.getU32("CoroutineStackPoolSize"));
 
 
 	// Although initLoggingAndGetLastDuration() is the right place to mess with
@@ -782,7 +808,9 @@ bool LLAppViewer::init()
 
 	// Initialize the non-LLCurl libcurl library.  Should be called
 	// before consumers (LLTextureFetch).
+	LLStartupProfiler::begin("http");
 	mAppCoreHttp.init();
+	LLStartupProfiler::end();
 
 	LL_INFOS("InitInfo") << "LLCore::Http initialized." << LL_ENDL ;
 
@@ -797,9 +825,13 @@ bool LLAppViewer::init()
 		LLViewerAssetStatsFF::init();
 	}
 
+	LLStartupProfiler::begin("threads");
 	initThreads();
+	LLStartupProfiler::end();
 	LL_INFOS("InitInfo") << "Threads initialized." << LL_ENDL ;
 
+	LLStartupProfiler::begin("UI, strings and notifications");
+
 	// Initialize settings early so that the defaults for ignorable dialogs are
 	// picked up and then correctly re-saved after launching the updater (STORM-1268).
 	LLUI::settings_map_t settings_map;
@@ -819,6 +851,15 @@ bool LLAppViewer::init()
 	// that use findSkinnedFilenames(), will include the localized files.
 	gDirUtilp->setSkinFolder(gDirUtilp->getSkinFolder(), LLUI::getLanguage());
 
+	// Parse the XML read on the way to the login screen side by side on the
+	// General thread pool; each reader below waits for its own file.
+	// LLStartUp waits for all of them before showing the login panel.
+	LLUICtrlFactory::preloadLayeredXMLNode("strings.xml", LLDir::ALL_SKINS);
+	LLUICtrlFactory::preloadLayeredXMLNode("language_settings.xml");
+	LLUICtrlFactory::preloadLayeredXMLNode("notifications.xml", LLDir::ALL_SKINS);
+	LLUICtrlFactory::preloadLayeredXMLNode("role_actions.xml");
+	LLUICtrlFactory::preloadLayeredXMLNode("teleport_strings.xml");
+
 	// Setup LLTrans after LLUI::initClass has been called.
 	initStrings();
 
@@ -829,6 +870,7 @@ bool LLAppViewer::init()
 	// Setup notifications after LLUI::initClass() has been called.
 	LLNotifications::instance();
 	LL_INFOS("InitInfo") << "Notifications initialized." << LL_ENDL ;
+	LLStartupProfiler::end();
 
 	//////////////////////////////////////////////////////////////////////////////
 	//////////////////////////////////////////////////////////////////////////////
@@ -869,6 +911,7 @@ bool LLAppViewer::init()
 	LL_INFOS("InitInfo") << "UI initialization is done." << LL_ENDL ;
 
 	// Load translations for tooltips
+	LLStartupProfiler::begin("floater registry");
 	LLFloater::initClass();
 	LLUrlFloaterDispatchHandler::registerInDispatcher();
 
@@ -877,12 +920,21 @@ bool LLAppViewer::init()
 	LLToolMgr::getInstance(); // Initialize tool manager if not already instantiated
 
 	LLViewerFloaterReg::registerFloaters();
+	LLStartupProfiler::end();
+
+	// Text only draws emoji once the dictionary exists, anything that looks
+	// one up before then loads it.
+	LLDeferredInit::add("emoji dictionary", []()
+	{
+		LLEmojiDictionary::getInstance();
+	});
 
 	/////////////////////////////////////////////////
 	//
 	// Load settings files
 	//
 	//
+	LLStartupProfiler::begin("settings files");
 	LLGroupMgr::parseRoleActions("role_actions.xml");
 
 	LLAgent::parseTeleportMessages("teleport_strings.xml");
@@ -897,6 +949,7 @@ bool LLAppViewer::init()
 	mime_types_name = "mime_types.xml";
 #endif
 	LLMIMETypes::parseMIMETypes( mime_types_name );
+	LLStartupProfiler::end();
 
 	// Copy settings to globals. *TODO: Remove or move to appropriage class initializers
 	settings_to_globals();
@@ -911,11 +964,13 @@ bool LLAppViewer::init()
 	// do any necessary set-up for accepting incoming SLURLs from apps
 	initSLURLHandler();
 
+	LLStartupProfiler::begin("hardware test");
 	if(false == initHardwareTest())
 	{
 		// Early out from user choice.
 		return false;
 	}
+	LLStartupProfiler::end();
 	LL_INFOS("InitInfo") << "Hardware test initialization done." << LL_ENDL ;
 
 	// Prepare for out-of-memory situations, during which we will crash on
@@ -926,6 +981,7 @@ bool LLAppViewer::init()
 
 	// *Note: this is where gViewerStats used to be created.
 
+	LLStartupProfiler::begin("cache");
 	if (!initCache())
 	{
 		LL_WARNS("InitInfo") << "Failed to init cache" << LL_ENDL;
@@ -934,6 +990,7 @@ bool LLAppViewer::init()
 		OSMessageBox(msg.str(),LLStringUtil::null,OSMB_OK);
 		return 0;
 	}
+	LLStartupProfiler::end();
 	LL_INFOS("InitInfo") << "Cache initialization is done." << LL_ENDL ;
 
     // Initialize event recorder
@@ -943,7 +1000,9 @@ bool LLAppViewer::init()
 	// Initialize the window
 	//
 	gGLActive = TRUE;
+	LLStartupProfiler::begin("window");
 	initWindow();
+	LLStartupProfiler::end();
 	LL_INFOS("InitInfo") << "Window is initialized." << LL_ENDL ;
 
     // writeSystemInfo can be called after window is initialized (gViewerWindow non-null)
@@ -953,7 +1012,9 @@ bool LLAppViewer::init()
 	LLCubeMap::sUseCubeMaps = LLFeatureManager::getInstance()->isFeatureAvailable("RenderCubeMap");
 
 	// call all self-registered classes
+	LLStartupProfiler::begin("registered classes");
 	LLInitClassList::instance().fireCallbacks();
+	LLStartupProfiler::end();
 
 	LLFolderViewItem::initClass(); // SJB: Needs to happen after initWindow(), not sure why but related to fonts
 
@@ -1115,11 +1176,16 @@ bool LLAppViewer::init()
 	gSimLastTime = gRenderStartTime.getElapsedTimeF32();
 	gSimFrames = (F32)gFrameCount;
 
-    if (gSavedSettings.getBOOL("JoystickEnabled"))
+    // device enumeration can be slow and nothing before login flies
+    LLDeferredInit::add("joystick", []()
     {
-        LLViewerJoystick::getInstance()->init(false);
-    }
+        if (gSavedSettings.getBOOL("JoystickEnabled"))
+        {
+            LLViewerJoystick::getInstance()->init(false);
+        }
+    });
 
+	LLStartupProfiler::begin("secure storage");
 	try {
 		initializeSecHandler();
 	}
@@ -1127,6 +1193,7 @@ bool LLAppViewer::init()
 	{
 	  LLNotificationsUtil::add("CorruptedProtectedDataStore");
 	}
+	LLStartupProfiler::end();
 
 	gGLActive = FALSE;
 
@@ -1264,21 +1331,28 @@ bool LLAppViewer::init()
 
 	// Note: this is where gLocalSpeakerMgr and gActiveSpeakerMgr used to be instantiated.
 
+	// the login response hands the credentials to voice, so it can't wait
+	LLStartupProfiler::begin("voice");
 	LLVoiceChannel::initClass();
 	LLVoiceClient::initParamSingleton(gServicePump);
+	LLStartupProfiler::end();
 	LLVoiceChannel::setCurrentVoiceChannelChangedCallback(boost::bind(&LLFloaterIMContainer::onCurrentChannelChanged, _1), true);
 
 	joystick = LLViewerJoystick::getInstance();
 	joystick->setNeedsReset(true);
 	/*----------------------------------------------------------------------*/
 	// Load User's bindings
+	LLStartupProfiler::begin("key bindings");
 	loadKeyBindings();
+	LLStartupProfiler::end();
 
     //LLSimpleton creations
     LLEnvironment::createInstance();
     LLWorld::createInstance();
     LLSelectMgr::createInstance();
     LLViewerCamera::createInstance();
+    LLStallMonitor::createInstance();
+    LLFrameTelemetry::createInstance();
 
 #if LL_WINDOWS
     if (!mSecondInstance)
@@ -1355,9 +1429,71 @@ bool LLAppViewer::frame()
 		}
 	}
 
+	checkForHitch();
+
 	return ret;
 }
 
+// don't fill the logs folder when something hitches over and over
+static const F32 HITCH_TRACE_MIN_INTERVAL = 60.f;
+
+void LLAppViewer::checkForHitch()
+{
+	static LLCachedControl<F32> threshold(gSavedSettings, "HitchRecorderThreshold", 1.f);
+	static LLCachedControl<F32> seconds(gSavedSettings, "HitchRecorderSeconds", 10.f);
+	mHitchTraceSeconds = seconds;
+
+	F32 frame_time = mHitchFrameTimer.getElapsedTimeAndResetF32();
+	// login and teleport screens hitch by design
+	bool can_stall = LLStartUp::getStartupState() == STATE_STARTED && !gTeleportDisplay;
+	std::string trace_file;
+	if (threshold > 0.f
+		&& frame_time > threshold
+		&& LLHitchRecorder::isEnabled()
+		&& can_stall
+		&& mHitchTraceTimer.getElapsedTimeF32() > HITCH_TRACE_MIN_INTERVAL)
+	{
+		LL_INFOS() << "Frame took " << frame_time << " seconds, saving hitch trace" << LL_ENDL;
+		trace_file = saveHitchTrace("frame");
+		mHitchTraceTimer.reset();
+		// nor count the time saving took against the next frame
+		mHitchFrameTimer.reset();
+	}
+
+	if (LLStallMonitor::instanceExists())
+	{
+		LLStallMonitor::instance().endFrame(frame_time, can_stall, trace_file);
+
+		if (LLFrameTelemetry::instanceExists())
+		{
+			LLFrameTelemetry::instance().endFrame();
+		}
+	}
+}
+
+std::string LLAppViewer::saveHitchTrace(const std::string& reason, bool background)
+{
+	LLHitchRecorder::CapturePtr capture = LLHitchRecorder::capture(mHitchTraceSeconds);
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS,
+		"hitch_" + LLDate::now().toHTTPDateString("%Y%m%d_%H%M%S") + "_" + reason + ".json");
+
+	if (background)
+	{
+		LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+		if (general_queue)
+		{
+			general_queue->post([capture, filename]()
+				{
+					LLHitchRecorder::writeChromeTrace(*capture, filename);
+				});
+			return filename;
+		}
+	}
+
+	LLHitchRecorder::writeChromeTrace(*capture, filename);
+	return filename;
+}
+
 bool LLAppViewer::doFrame()
 {
     LL_RECORD_BLOCK_TIME(FTM_FRAME);
@@ -1394,6 +1530,12 @@ bool LLAppViewer::doFrame()
         //clear call stack records
         LL_CLEAR_CALLSTACKS();
     }
+    LLBackgroundMode::update();
+    {
+        // frame rate limiting sleeps here, so the input gathered below is fresh
+        LLPerfStats::RecordSceneTime T(LLPerfStats::StatType_t::RENDER_SLEEP);
+        LLFramePacer::beginFrame();
+    }
     {
         {
             LLPerfStats::RecordSceneTime T(LLPerfStats::StatType_t::RENDER_IDLE); // ensure we have the entire top scope of frame covered (input event and coro)
@@ -1480,6 +1622,7 @@ bool LLAppViewer::doFrame()
 				{
                     LLPerfStats::RecordSceneTime T (LLPerfStats::StatType_t::RENDER_IDLE);
                     LL_PROFILE_ZONE_NAMED_CATEGORY_APP("df idle");
+                    LLStallMonitor::Phase phase(LLStallMonitor::PHASE_IDLE);
 					idle();
 				}
 
@@ -1505,13 +1648,16 @@ bool LLAppViewer::doFrame()
 
 			// Render scene.
 			// *TODO: Should we run display() even during gHeadlessClient?  DK 2011-02-18
-            if (!LLApp::isExiting() && !gHeadlessClient && gViewerWindow)
+            if (!LLApp::isExiting() && !gHeadlessClient && gViewerWindow && !LLBackgroundMode::isActive())
             {
                 LL_PROFILE_ZONE_NAMED_CATEGORY_APP("df Display");
                 pingMainloopTimeout("Main:Display");
                 gGLActive = TRUE;
 
-                display();
+                {
+                    LLStallMonitor::Phase phase(LLStallMonitor::PHASE_DISPLAY);
+                    display();
+                }
 
                 {
                     LLPerfStats::RecordSceneTime T(LLPerfStats::StatType_t::RENDER_IDLE);
@@ -1659,7 +1805,22 @@ bool LLAppViewer::doFrame()
 
 		LL_INFOS() << "Exiting main_loop" << LL_ENDL;
 	}
-    }LLPerfStats::StatsRecorder::endFrame();
+    }
+	LLFrameArena::instance().reset();
+	{
+		size_t reserved, high_water;
+		LLFrameArena::getStats(reserved, high_water);
+		sample(LLStatViewer::FRAME_ARENA_MEM, F64Bytes(reserved));
+		sample(LLStatViewer::FRAME_ARENA_HIGH_WATER, F64Bytes(high_water));
+	}
+	{
+		U32 created, reused, pooled;
+		LLCoros::getStackStats(created, reused, pooled);
+		add(LLStatViewer::COROUTINE_STACKS_CREATED, created);
+		add(LLStatViewer::COROUTINE_STACKS_REUSED, reused);
+		sample(LLStatViewer::COROUTINE_STACKS_POOLED, pooled);
+	}
+	LLPerfStats::StatsRecorder::endFrame();
     LL_PROFILER_FRAME_END
 
 	return ! LLApp::isRunning();
@@ -1720,6 +1881,7 @@ bool LLAppViewer::cleanup()
 		{
             std::string dump_path = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "scene_monitor_results.csv");
 			LLSceneMonitor::instance().dumpToFile(dump_path);
+			LLSceneMonitor::instance().dumpLoadTimeline(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "scene_load_timeline.csv"));
 		}
 		LLSceneMonitor::deleteSingleton();
 	}
@@ -1866,7 +2028,8 @@ bool LLAppViewer::cleanup()
 
 	// Cleanup Inventory after the UI since it will delete any remaining observers
 	// (Deleted observers should have already removed themselves)
-	gInventory.cleanupInventory();
+	// In a fast shutdown the items and folders are left for the process exit.
+	gInventory.cleanupInventory(gSavedSettings.getBOOL("FastShutdown"));
 
 	LLCoros::getInstance()->printActiveCoroutines();
 
@@ -1971,6 +2134,7 @@ bool LLAppViewer::cleanup()
 	}
 	else
 	{
+		LLViewerFloaterReg::saveUsage();
 		gSavedPerAccountSettings.saveToFile(gSavedSettings.getString("PerAccountSettingsFile"), TRUE);
 		LL_INFOS() << "Saved settings" << LL_ENDL;
 
@@ -2000,6 +2164,15 @@ bool LLAppViewer::cleanup()
 
     clearSecHandler();
 
+	// Background writes must be done before the cache may be purged
+	if (mShutdownPersist)
+	{
+		LL_INFOS() << "Waiting for background saves" << LL_ENDL;
+		mShutdownPersist->wait();
+		delete mShutdownPersist;
+		mShutdownPersist = NULL;
+	}
+
 	if (mPurgeCacheOnExit)
 	{
 		LL_INFOS() << "Purging all cache files on exit" << LL_ENDL;
@@ -2156,6 +2329,12 @@ bool LLAppViewer::cleanup()
 	LLSelectMgr::deleteSingleton();
 	LLViewerEventRecorder::deleteSingleton();
     LLWorld::deleteSingleton();
+    if (LLFrameTelemetry::instanceExists() && !isSecondInstance())
+    {
+        LLFrameTelemetry::instance().exportToLogs();
+    }
+    LLFrameTelemetry::deleteSingleton();
+    LLStallMonitor::deleteSingleton();
     LLVoiceClient::deleteSingleton();
 
 	// It's not at first obvious where, in this long sequence, a generic cleanup
@@ -2169,6 +2348,10 @@ bool LLAppViewer::cleanup()
 	// deleteSingleton() methods.
 	LLSingletonBase::deleteAll();
 
+#if LL_REFCOUNT_AUDIT
+	LLRefCountAudit::dump();
+#endif
+
     LL_INFOS() << "Goodbye!" << LL_ENDL;
 
 	removeDumpDir();
@@ -2217,6 +2400,7 @@ bool LLAppViewer::initThreads()
 
 	// Image decoding
 	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
+	LLAppViewer::sImageDecodeThread->setMaxThreadsPerImage(gSavedSettings.getU32("Jpeg2000DecodeThreads"));
 	LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
 													enable_threads && true,
@@ -2225,6 +2409,15 @@ bool LLAppViewer::initThreads()
     // general task background thread (LLPerfStats, etc)
     LLAppViewer::instance()->initGeneralThread();
 
+	if (gSavedSettings.getBOOL("AsyncVolumeGeneration"))
+	{
+		LL::WorkQueue::weak_t general_queue = LL::WorkQueue::getInstance("General");
+		LLPrimitive::getVolumeManager()->setBuildQueue([general_queue](const std::function<void()>& work)
+			{
+				return LL::WorkQueue::postMaybe(general_queue, work);
+			});
+	}
+
 	LLAppViewer::sPurgeDiskCacheThread = new LLPurgeDiskCacheThread();
 
 	if (LLTrace::BlockTimer::sLog || LLTrace::BlockTimer::sMetricLog)
@@ -2795,18 +2988,23 @@ bool LLAppViewer::initConfiguration()
 								 gSavedSettings.getString("Language"));
 	}
 
-	if (gSavedSettings.getBOOL("SpellCheck"))
+	// Nothing on the login screen is spell checked. Reads the settings when
+	// it runs, so a change made in the meantime isn't undone.
+	LLDeferredInit::add("spell checker", []()
 	{
-		std::list<std::string> dict_list;
-		std::string dict_setting = gSavedSettings.getString("SpellCheckDictionary");
-		boost::split(dict_list, dict_setting, boost::is_any_of(std::string(",")));
-		if (!dict_list.empty())
+		if (gSavedSettings.getBOOL("SpellCheck"))
 		{
-			LLSpellChecker::setUseSpellCheck(dict_list.front());
-			dict_list.pop_front();
-			LLSpellChecker::instance().setSecondaryDictionaries(dict_list);
+			std::list<std::string> dict_list;
+			std::string dict_setting = gSavedSettings.getString("SpellCheckDictionary");
+			boost::split(dict_list, dict_setting, boost::is_any_of(std::string(",")));
+			if (!dict_list.empty())
+			{
+				LLSpellChecker::setUseSpellCheck(dict_list.front());
+				dict_list.pop_front();
+				LLSpellChecker::instance().setSecondaryDictionaries(dict_list);
+			}
 		}
-	}
+	});
 
 	if (gNonInteractive)
 	{
@@ -2918,6 +3116,8 @@ bool LLAppViewer::initConfiguration()
 	//LLVolumeMgr::initClass();
 	LLVolumeMgr* volume_manager = new LLVolumeMgr();
 	volume_manager->useMutex();	// LLApp and LLMutex magic must be manually enabled
+	volume_manager->setRetentionBudget((U64)gSavedSettings.getU32("RenderVolumeRetentionMB") * 1024 * 1024);
+	LLVolumeLODGroup::setSimplifyLODs(gSavedSettings.getBOOL("RenderVolumeSimplifyLODs"));
 	LLPrimitive::setVolumeManager(volume_manager);
 
 	// Note: this is where we used to initialize gFeatureManagerp.
@@ -3114,9 +3314,14 @@ bool LLAppViewer::initWindow()
 						<< " (setting = " << watchdog_enabled_setting << ")"
 						<< LL_ENDL;
 
+	LLHitchRecorder::setCapacity(gSavedSettings.getU32("HitchRecorderEvents"));
+	LLHitchRecorder::setEnabled(gSavedSettings.getBOOL("HitchRecorderEnabled"));
+
 	if (use_watchdog)
 	{
-		LLWatchdog::getInstance()->init();
+		// the watchdog is about to crash the viewer, write the trace there
+		// and then so it makes it into the logs
+		LLWatchdog::getInstance()->init([]() { LLAppViewer::instance()->saveHitchTrace("watchdog", false); });
 	}
 
 	LLNotificationsUI::LLNotificationManager::getInstance();
@@ -3160,6 +3365,19 @@ bool LLAppViewer::initWindow()
 	gSavedSettings.setBOOL("RenderInitError", FALSE);
 	gSavedSettings.saveToFile( gSavedSettings.getString("ClientSettingsFile"), TRUE );
 
+	// --warmshadercache (from the installer), or a cold cache after a viewer or driver update
+	bool warmup_and_quit = gSavedSettings.getBOOL("RenderShaderCacheWarmup");
+	if (warmup_and_quit ||
+		(gSavedSettings.getBOOL("RenderShaderCacheWarmupOnChange") && LLViewerShaderMgr::instance()->mShaderCacheInvalidated))
+	{
+		LLViewerShaderMgr::instance()->warmShaderCache();
+		if (warmup_and_quit)
+		{
+			LL_INFOS("AppInit") << "Shader cache warm up done, quitting" << LL_ENDL;
+			forceQuit();
+		}
+	}
+
 	//If we have a startup crash, it's usually near GL initialization, so simulate that.
 	if(gCrashOnStartup)
 	{
@@ -4262,7 +4480,10 @@ bool LLAppViewer::initCache()
 	}
 
 	const std::string cache_dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, cache_dir_name);
-    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info);
+    // a read only viewer (second instance) must leave the index and packs to the instance that owns the cache
+    const bool use_disk_cache_index = gSavedSettings.getBOOL("DiskCacheUseIndex") && !read_only;
+    const bool use_disk_cache_packs = gSavedSettings.getBOOL("DiskCacheUsePackFiles") && !read_only;
+    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, use_disk_cache_index, use_disk_cache_packs);
 
 	if (!read_only)
 	{
@@ -4277,6 +4498,8 @@ bool LLAppViewer::initCache()
         {
             LLDiskCache::getInstance()->removeOldVFSFiles();
         }
+
+        LLDiskCache::getInstance()->removeUnusedIndex();
         
         if (mPurgeCache)
 		{
@@ -4304,6 +4527,11 @@ bool LLAppViewer::initCache()
 
 	LLVOCache::getInstance()->initCache(LL_PATH_CACHE, gSavedSettings.getU32("CacheNumberOfRegionsForObjects"), getObjectCacheVersion());
 
+	if (gSavedSettings.getBOOL("XUIBinaryCache") && !read_only)
+	{
+		LLUICtrlFactory::setXMLCacheDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "xui"));
+	}
+
     return true;
 }
 
@@ -4493,18 +4721,33 @@ void LLAppViewer::saveFinalSnapshot()
 void LLAppViewer::loadNameCache()
 {
 	// display names cache
-	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
-	LL_INFOS("AvNameCache") << filename << LL_ENDL;
-	llifstream name_cache_stream(filename.c_str());
-	if(name_cache_stream.is_open())
+	std::string binary_filename =
+		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.bin");
+	bool use_binary = gSavedSettings.getBOOL("AvatarNameCacheBinary");
+	if (!use_binary || !LLFile::isfile(binary_filename))
+	{
+		// xml cache, also seeds a new binary cache
+		std::string filename =
+			gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
+		LL_INFOS("AvNameCache") << filename << LL_ENDL;
+		llifstream name_cache_stream(filename.c_str());
+		if(name_cache_stream.is_open())
+		{
+			if ( ! LLAvatarNameCache::getInstance()->importFile(name_cache_stream))
+			{
+				LL_WARNS("AppInit") << "removing invalid '" << filename << "'" << LL_ENDL;
+				name_cache_stream.close();
+				LLFile::remove(filename);
+			}
+		}
+	}
+	if (use_binary)
 	{
-		if ( ! LLAvatarNameCache::getInstance()->importFile(name_cache_stream))
-        {
-            LL_WARNS("AppInit") << "removing invalid '" << filename << "'" << LL_ENDL;
-            name_cache_stream.close();
-            LLFile::remove(filename);
-        }
+		LL_INFOS("AvNameCache") << binary_filename << LL_ENDL;
+		if (!LLAvatarNameCache::getInstance()->openBinaryCache(binary_filename))
+		{
+			LL_WARNS("AppInit") << "can't open '" << binary_filename << "', using xml name cache" << LL_ENDL;
+		}
 	}
 
 	if (!gCacheName) return;
@@ -4521,23 +4764,57 @@ void LLAppViewer::loadNameCache()
 void LLAppViewer::saveNameCache()
 {
 	// display names cache
-	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
-	llofstream name_cache_stream(filename.c_str());
-	if(name_cache_stream.is_open())
+	if (LLAvatarNameCache::getInstance()->isBinaryCacheOpen())
 	{
-		LLAvatarNameCache::getInstance()->exportFile(name_cache_stream);
-    }
+		// already on disk, names were appended as they arrived
+		LLAvatarNameCache::getInstance()->closeBinaryCache();
+	}
+	else
+	{
+		std::string filename =
+			gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
+		if (mShutdownPersist)
+		{
+			std::ostringstream str;
+			LLAvatarNameCache::getInstance()->exportFile(str);
+			std::string data = str.str();
+			mShutdownPersist->add("avatar name cache", [filename, data]()
+				{
+					return LLAsyncPersist::writeFile(filename, data);
+				});
+		}
+		else
+		{
+			llofstream name_cache_stream(filename.c_str());
+			if(name_cache_stream.is_open())
+			{
+				LLAvatarNameCache::getInstance()->exportFile(name_cache_stream);
+			}
+		}
+	}
 
     // real names cache
 	if (gCacheName)
     {
         std::string name_cache;
         name_cache = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "name.cache");
-        llofstream cache_file(name_cache.c_str());
-        if(cache_file.is_open())
+        if (mShutdownPersist)
         {
-            gCacheName->exportFile(cache_file);
+            std::ostringstream str;
+            gCacheName->exportFile(str);
+            std::string data = str.str();
+            mShutdownPersist->add("name cache", [name_cache, data]()
+                {
+                    return LLAsyncPersist::writeFile(name_cache, data);
+                });
+        }
+        else
+        {
+            llofstream cache_file(name_cache.c_str());
+            if(cache_file.is_open())
+            {
+                gCacheName->exportFile(cache_file);
+            }
         }
 	}
 }
@@ -4662,6 +4939,9 @@ void LLAppViewer::idle()
 		gGLActive = FALSE;
 	}
 
+	// subsystems left until the viewer is in world, a few each frame
+	LLDeferredInit::update();
+	LLViewerFloaterReg::updatePrebuild();
 
     F32 yaw = 0.f;				// radians
 
@@ -4689,6 +4969,9 @@ void LLAppViewer::idle()
 			gAgent.autoPilot(&yaw);
 		}
 
+		LLSceneMonitor::getInstance()->updateLoadTimeline();
+		LLRenderBenchmark::getInstance()->update();
+
 		static LLFrameTimer agent_update_timer;
 
 		// When appropriate, update agent location to the simulator.
@@ -4760,7 +5043,16 @@ void LLAppViewer::idle()
 	    // floating throughout the various object lists.
 	    //
 		idleNameCache();
-		idleNetwork();
+		{
+			LLStallMonitor::Phase phase(LLStallMonitor::PHASE_NETWORK);
+			idleNetwork();
+		}
+
+		// one batch of the GLTF overrides that arrived, newest per object
+		gGLTFMaterialList.applyPendingOverrides();
+
+		mAppCoreHttp.updateConcurrency();
+		LLStreamingPriority::update();
 
 
 		// Check for away from keyboard, kick idle agents.
@@ -4843,7 +5135,8 @@ void LLAppViewer::idle()
 	{
 		LL_RECORD_BLOCK_TIME(FTM_OBJECTLIST_UPDATE);
 
-        if (!(logoutRequestSent() && hasSavedFinalSnapshot()))
+        if (!(logoutRequestSent() && hasSavedFinalSnapshot())
+			&& LLBackgroundMode::isUpdateFrame())
 		{
 			gObjectList.update(gAgent);
 		}
@@ -4939,62 +5232,112 @@ void LLAppViewer::idle()
 	// Sort and cull in the new renderer are moved to pipeline.cpp
 	// Here, particles are updated and drawables are moved.
 	//
+	// The rest of the world update runs as a task graph: tasks are declared
+	// in the order they run serially, with the state they read and write,
+	// and with ParallelWorldUpdate the particle simulation overlaps with the
+	// tasks that don't conflict with it.
+	//
 
+	static LL::TaskGraph world_update("world update");
+	if (!world_update.size())
 	{
-		LL_PROFILE_ZONE_NAMED_CATEGORY_APP("world update"); //LL_RECORD_BLOCK_TIME(FTM_WORLD_UPDATE);
-		gPipeline.updateMove();
-	}
+		world_update.add("move", LL::TaskGraph::MAIN_THREAD, {}, { "drawables" }, []()
+			{
+				LL_PROFILE_ZONE_NAMED_CATEGORY_APP("world update"); //LL_RECORD_BLOCK_TIME(FTM_WORLD_UPDATE);
+				gPipeline.updateMove();
+			});
 
-	LLWorld::getInstance()->updateParticles();
+		world_update.add("camera", LL::TaskGraph::MAIN_THREAD, {}, { "camera", "drawables" }, []()
+			{
+				if (gAgentPilot.isPlaying() && gAgentPilot.getOverrideCamera())
+				{
+					gAgentPilot.moveCamera();
+				}
+				else if (LLViewerJoystick::getInstance()->getOverrideCamera())
+				{
+					LLViewerJoystick::getInstance()->moveFlycam();
+				}
+				else
+				{
+					if (LLToolMgr::getInstance()->inBuildMode())
+					{
+						LLViewerJoystick::getInstance()->moveObjects();
+					}
 
-	if (gAgentPilot.isPlaying() && gAgentPilot.getOverrideCamera())
-	{
-		gAgentPilot.moveCamera();
-	}
-	else if (LLViewerJoystick::getInstance()->getOverrideCamera())
-	{
-		LLViewerJoystick::getInstance()->moveFlycam();
-	}
-	else
-	{
-		if (LLToolMgr::getInstance()->inBuildMode())
-		{
-			LLViewerJoystick::getInstance()->moveObjects();
-		}
+					gAgentCamera.updateCamera();
+				}
+			});
 
-		gAgentCamera.updateCamera();
-	}
+		world_update.add("particle sources", LL::TaskGraph::MAIN_THREAD, { "camera" }, { "particles", "drawables" }, []()
+			{
+				if (LLBackgroundMode::isUpdateFrame())
+				{
+					LLViewerPartSim::getInstance()->updateSources();
+				}
+			});
 
-	// update media focus
-	LLViewerMediaFocus::getInstance()->update();
+		// only moves particles, reading their sources' positions and the wind
+		world_update.add("particle simulation", LL::TaskGraph::ANY_THREAD, { "drawables", "wind" }, { "particles" }, []()
+			{
+				if (LLBackgroundMode::isUpdateFrame())
+				{
+					LLViewerPartSim::getInstance()->simulateParticles();
+				}
+			});
 
-	// Update marketplace
-	LLMarketplaceInventoryImporter::update();
-	LLMarketplaceInventoryNotifications::update();
+		// update media focus
+		world_update.add("media focus", LL::TaskGraph::MAIN_THREAD, { "camera", "drawables" }, { "media" }, []()
+			{
+				LLViewerMediaFocus::getInstance()->update();
+			});
 
-	// objects and camera should be in sync, do LOD calculations now
-	{
-		LL_RECORD_BLOCK_TIME(FTM_LOD_UPDATE);
-		gObjectList.updateApparentAngles(gAgent);
-	}
+		// Update marketplace
+		world_update.add("marketplace", LL::TaskGraph::MAIN_THREAD, {}, { "inventory" }, []()
+			{
+				LLMarketplaceInventoryImporter::update();
+				LLMarketplaceInventoryNotifications::update();
+			});
 
-	// Update AV render info
-	LLAvatarRenderInfoAccountant::getInstance()->idle();
+		world_update.add("particle cleanup", LL::TaskGraph::MAIN_THREAD, { "camera" }, { "particles", "drawables" }, []()
+			{
+				if (LLBackgroundMode::isUpdateFrame())
+				{
+					LLViewerPartSim::getInstance()->finishSimulation();
+				}
+			});
 
-	{
-		LL_PROFILE_ZONE_NAMED_CATEGORY_APP("audio update"); //LL_RECORD_BLOCK_TIME(FTM_AUDIO_UPDATE);
+		// objects and camera should be in sync, do LOD calculations now
+		world_update.add("LOD", LL::TaskGraph::MAIN_THREAD, { "camera" }, { "drawables" }, []()
+			{
+				LL_RECORD_BLOCK_TIME(FTM_LOD_UPDATE);
+				gObjectList.updateApparentAngles(gAgent);
+			});
 
-		if (gAudiop)
-		{
-		    audio_update_volume(false);
-			audio_update_listener();
-			audio_update_wind(false);
+		// Update AV render info
+		world_update.add("render info", LL::TaskGraph::MAIN_THREAD, { "drawables" }, { "render info" }, []()
+			{
+				LLAvatarRenderInfoAccountant::getInstance()->idle();
+			});
 
-			// this line actually commits the changes we've made to source positions, etc.
-			gAudiop->idle();
-		}
+		world_update.add("audio", LL::TaskGraph::MAIN_THREAD, { "camera", "drawables", "wind" }, { "audio" }, []()
+			{
+				LL_PROFILE_ZONE_NAMED_CATEGORY_APP("audio update"); //LL_RECORD_BLOCK_TIME(FTM_AUDIO_UPDATE);
+
+				if (gAudiop)
+				{
+					audio_update_volume(false);
+					audio_update_listener();
+					audio_update_wind(false);
+
+					// this line actually commits the changes we've made to source positions, etc.
+					gAudiop->idle();
+				}
+			});
 	}
 
+	static LLCachedControl<bool> parallel_world_update(gSavedSettings, "ParallelWorldUpdate", false);
+	world_update.run(parallel_world_update ? gPipeline.getThreadPoolQueue() : NULL);
+
 	// Handle shutdown process, for example,
 	// wait for floaters to close, send quit message,
 	// forcibly quit if it has taken too long
@@ -5357,18 +5700,26 @@ void LLAppViewer::disconnectViewer()
 		LLSelectMgr::getInstance()->deselectAll();
 	}
 
+	// With 'FastShutdown' caches are snapshot here and written on
+	// background threads while the rest of the shutdown goes on
+	if (gSavedSettings.getBOOL("FastShutdown") && !mShutdownPersist)
+	{
+		mShutdownPersist = new LLAsyncPersist;
+	}
+
 	// save inventory if appropriate
     if (gInventory.isInventoryUsable()
         && gAgent.getID().notNull()) // Shouldn't be null at this stage
     {
-        gInventory.cache(gInventory.getRootFolderID(), gAgent.getID());
+        gInventory.cache(gInventory.getRootFolderID(), gAgent.getID(), mShutdownPersist);
         if (gInventory.getLibraryRootFolderID().notNull()
             && gInventory.getLibraryOwnerID().notNull()
             && !mSecondInstance) // agent is unique, library isn't
         {
             gInventory.cache(
                 gInventory.getLibraryRootFolderID(),
-                gInventory.getLibraryOwnerID());
+                gInventory.getLibraryOwnerID(),
+                mShutdownPersist);
         }
     }
 
@@ -5390,11 +5741,14 @@ void LLAppViewer::disconnectViewer()
 
 	// This is where we used to call gObjectList.destroy() and then delete gWorldp.
 	// Now we just ask the LLWorld singleton to cleanly shut down.
+	// Regions write their object caches as they go away
+	LLTimer vocache_timer;
 	if(LLWorld::instanceExists())
 	{
 		LLWorld::getInstance()->resetClass();
 	}
 	LLVOCache::deleteSingleton();
+	LL_INFOS() << "Saved region object caches in " << vocache_timer.getElapsedTimeF64() << "s" << LL_ENDL;
 
 	// call all self-registered classes
 	LLDestroyClassList::instance().fireCallbacks();
@@ -51,6 +51,7 @@
 #include "llappcorehttp.h"
 #include "threadpool_fwd.h"
 
+#include <atomic>
 #include <boost/signals2.hpp>
 
 class LLCommandLineParser;
@@ -63,6 +64,7 @@ class LLWatchdogTimeout;
 class LLViewerJoystick;
 class LLPurgeDiskCacheThread;
 class LLViewerRegion;
+class LLAsyncPersist;
 
 extern LLTrace::BlockTimerStatHandle FTM_FRAME;
 
@@ -188,6 +190,11 @@ public:
 	void resumeMainloopTimeout(const std::string& state = "", F32 secs = -1.0f);
 	void pingMainloopTimeout(const std::string& state, F32 secs = -1.0f);
 
+	// Save the hitch recorder's last HitchRecorderSeconds to the logs folder
+	// as a Chrome trace. The file is written on the general thread pool
+	// unless background is false. Returns the name of the file.
+	std::string saveHitchTrace(const std::string& reason, bool background = true);
+
 	// Handle the 'login completed' event.
 	// *NOTE:Mani Fix this for login abstraction!!
 	void handleLoginComplete();
@@ -302,6 +309,7 @@ private:
 	bool mPurgeCache;
 	bool mPurgeCacheOnExit;
 	bool mPurgeUserDataOnExit;
+	LLAsyncPersist* mShutdownPersist;	// caches being written at logout, 'FastShutdown' only
 	LLViewerJoystick* joystick;
 
 	bool mSavedFinalSnapshot;
@@ -317,6 +325,12 @@ private:
 
 	LLWatchdogTimeout* mMainloopTimeout;
 
+	// for saving a hitch trace when a frame runs long
+	void checkForHitch();
+	LLTimer mHitchFrameTimer;
+	LLTimer mHitchTraceTimer;
+	std::atomic<F32> mHitchTraceSeconds;
+
 	// For performance and metric gathering
 	class LLThread*	mFastTimerLogThread;
 
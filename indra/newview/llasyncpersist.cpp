@@ -0,0 +1,179 @@
+/**
+ * @file llasyncpersist.cpp
+ * @brief Writes cache and settings files on background threads at logout
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llasyncpersist.h"
+
+#include "llexception.h"
+#include "llfile.h"
+#include "lltimer.h"
+#include "lluuid.h"
+
+#ifdef LL_USESYSTEMLIBS
+#include <zlib.h>
+#else
+#include "zlib-ng/zlib.h"
+#endif
+
+#if LL_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Flushes the file's data to the disk, not just to the OS
+    bool sync_file(const std::string& filename)
+    {
+        LLFILE* fp = LLFile::fopen(filename, "rb+");
+        if (!fp)
+        {
+            return false;
+        }
+#if LL_WINDOWS
+        bool success = _commit(_fileno(fp)) == 0;
+#else
+        bool success = fsync(fileno(fp)) == 0;
+#endif
+        fclose(fp);
+        return success;
+    }
+
+    bool write_gzip(const std::string& filename, const std::string& data)
+    {
+#if LL_WINDOWS
+        llutf16string utf16filename = utf8str_to_utf16str(filename);
+        gzFile dst = gzopen_w(utf16filename.c_str(), "wb");
+#else
+        gzFile dst = gzopen(filename.c_str(), "wb");
+#endif
+        if (!dst)
+        {
+            return false;
+        }
+
+        // gzwrite() takes an unsigned int count
+        const size_t CHUNK_SIZE = 1 << 24;
+        bool success = true;
+        for (size_t pos = 0; success && pos < data.size(); pos += CHUNK_SIZE)
+        {
+            unsigned int count = (unsigned int)llmin(CHUNK_SIZE, data.size() - pos);
+            success = gzwrite(dst, data.data() + pos, count) == (int)count;
+        }
+        return gzclose(dst) == Z_OK && success;
+    }
+
+    bool write_plain(const std::string& filename, const std::string& data)
+    {
+        LLFILE* fp = LLFile::fopen(filename, "wb");
+        if (!fp)
+        {
+            return false;
+        }
+        bool success = data.empty() || fwrite(data.data(), data.size(), 1, fp) == 1;
+        return fclose(fp) == 0 && success;
+    }
+}
+
+LLAsyncPersist::LLAsyncPersist()
+{
+}
+
+LLAsyncPersist::~LLAsyncPersist()
+{
+    wait();
+}
+
+void LLAsyncPersist::add(const std::string& label, write_fn_t write_fn)
+{
+    mTasks.emplace_back(new Task);
+    Task* task = mTasks.back().get();
+    task->mLabel = label;
+    task->mWriteFn = std::move(write_fn);
+
+    // The thread only uses the task by pointer, the write function and
+    // whatever it captured are released by wait() on this thread.
+    task->mThread = std::thread([task]()
+        {
+            LLTimer timer;
+            try
+            {
+                task->mSuccess = task->mWriteFn();
+            }
+            catch (...)
+            {
+                LOG_UNHANDLED_EXCEPTION(task->mLabel);
+                task->mSuccess = false;
+            }
+            task->mSeconds = timer.getElapsedTimeF64();
+        });
+}
+
+bool LLAsyncPersist::wait()
+{
+    bool success = true;
+    for (std::unique_ptr<Task>& task : mTasks)
+    {
+        task->mThread.join();
+        if (task->mSuccess)
+        {
+            LL_INFOS() << "Saved " << task->mLabel << " in " << task->mSeconds << "s" << LL_ENDL;
+        }
+        else
+        {
+            LL_WARNS() << "Failed to save " << task->mLabel << " after " << task->mSeconds << "s" << LL_ENDL;
+            success = false;
+        }
+    }
+    mTasks.clear();
+    return success;
+}
+
+// static
+bool LLAsyncPersist::writeFile(const std::string& filename, const std::string& data, bool compress)
+{
+    // unique, a second instance may be saving the same file
+    std::string temp_file = filename + "." + LLUUID::generateNewID().asString();
+    if (!(compress ? write_gzip(temp_file, data) : write_plain(temp_file, data))
+        || !sync_file(temp_file))
+    {
+        LL_WARNS() << "Unable to write " << temp_file << LL_ENDL;
+        LLFile::remove(temp_file, ENOENT);
+        return false;
+    }
+#if LL_WINDOWS
+    // Rename in windows needs the destination to not exist.
+    LLFile::remove(filename, ENOENT);
+#endif
+    if (LLFile::rename(temp_file, filename) != 0)
+    {
+        LLFile::remove(temp_file, ENOENT);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file llasyncpersist.h
+ * @brief Writes cache and settings files on background threads at logout
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLASYNCPERSIST_H
+#define LL_LLASYNCPERSIST_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Shutdown used to save each cache one after the other on the main thread.
+// With 'FastShutdown' the main thread only takes a snapshot of the data, in
+// memory, and hands a write function to add(). Each one runs on a thread of
+// its own while shutdown goes on, wait() joins them and logs how long each
+// artifact took.
+//
+// A write function must only use what it owns: it runs while the main
+// thread tears down the structures the snapshot was taken from.
+class LLAsyncPersist
+{
+    LOG_CLASS(LLAsyncPersist);
+public:
+    typedef std::function<bool()> write_fn_t;
+
+    LLAsyncPersist();
+    ~LLAsyncPersist();
+
+    void add(const std::string& label, write_fn_t write_fn);
+
+    // Joins every writer, returns false if any of them failed
+    bool wait();
+
+    // Writes data next to filename, gzipped if asked, flushes it to the
+    // disk and renames it over filename. A crash or power loss leaves
+    // either the old or the new file, never a truncated one. Usable from
+    // any thread.
+    static bool writeFile(const std::string& filename, const std::string& data, bool compress = false);
+
+private:
+    struct Task
+    {
+        std::string mLabel;
+        write_fn_t  mWriteFn;
+        std::thread mThread;
+        F64         mSeconds = 0.0;
+        bool        mSuccess = false;
+    };
+
+    std::vector<std::unique_ptr<Task> > mTasks;
+};
+
+#endif // LL_LLASYNCPERSIST_H
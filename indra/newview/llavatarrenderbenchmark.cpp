@@ -0,0 +1,284 @@
+/**
+ * @file llavatarrenderbenchmark.cpp
+ * @brief Repeatable measurement of avatar rendering cost.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llavatarrenderbenchmark.h"
+
+#include "llagent.h"
+#include "llanimationstates.h"
+#include "llcallbacklist.h"
+#include "lldir.h"
+#include "llfile.h"
+#include "llviewercamera.h"
+#include "llviewercontrol.h"
+#include "llviewerobjectlist.h"
+#include "llvoavatar.h"
+#include "pipeline.h"
+
+#include <sstream>
+
+// Frames to wait for the GPU profile queries placed after sampling.
+static const U32 PROFILE_READBACK_FRAMES = 8;
+
+static const char* PHASE_NAMES[LLAvatarRenderBenchmark::PHASE_COUNT] =
+{
+	"motion",
+	"skinning",
+	"geometry",
+	"draw"
+};
+
+bool LLAvatarRenderBenchmark::sSampling = false;
+LLAvatarRenderBenchmark::EPhase LLAvatarRenderBenchmark::sCurrentPhase = LLAvatarRenderBenchmark::PHASE_NONE;
+U64 LLAvatarRenderBenchmark::sPhaseStart = 0;
+U64 LLAvatarRenderBenchmark::sPhaseTime[LLAvatarRenderBenchmark::PHASE_COUNT];
+
+LLAvatarRenderBenchmark::LLAvatarRenderBenchmark()
+:	mFrame(0),
+	mWarmupFrames(0),
+	mSampleFrames(0),
+	mSampleSeconds(0.f)
+{
+}
+
+void LLAvatarRenderBenchmark::cleanupSingleton()
+{
+	stop();
+}
+
+// static
+LLAvatarRenderBenchmark::EPhase LLAvatarRenderBenchmark::switchPhase(EPhase phase)
+{
+	U64 now = LLTimer::getTotalTime();
+	EPhase previous = sCurrentPhase;
+	if (previous != PHASE_NONE)
+	{
+		sPhaseTime[previous] += now - sPhaseStart;
+	}
+	sCurrentPhase = phase;
+	sPhaseStart = now;
+	return previous;
+}
+
+bool LLAvatarRenderBenchmark::start()
+{
+	if (isRunning() || !gAgent.getRegion())
+	{
+		return false;
+	}
+
+	std::vector<std::string> appearances;
+	LLStringUtil::getTokens(gSavedSettings.getString("AvatarBenchmarkAppearances"), appearances, ";");
+	std::vector<std::string> distance_tokens;
+	LLStringUtil::getTokens(gSavedSettings.getString("AvatarBenchmarkDistances"), distance_tokens, " ,");
+	std::vector<F32> distances;
+	for (const std::string& token : distance_tokens)
+	{
+		F32 distance = 0.f;
+		if (LLStringUtil::convertToF32(token, distance) && distance > 0.f)
+		{
+			distances.push_back(distance);
+		}
+	}
+	if (distances.empty())
+	{
+		distances.push_back(5.f);
+	}
+	U32 count = gSavedSettings.getU32("AvatarBenchmarkCount");
+	if (appearances.empty() || !count)
+	{
+		LL_WARNS("AvatarBenchmark") << "nothing to run, set AvatarBenchmarkAppearances and AvatarBenchmarkCount" << LL_ENDL;
+		return false;
+	}
+	for (std::string& filename : appearances)
+	{
+		LLStringUtil::trim(filename);
+		if (!LLFile::isfile(filename))
+		{
+			// dumps are written to the logs directory
+			filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, filename);
+		}
+	}
+
+	LLUUID animation_id(gSavedSettings.getString("AvatarBenchmarkAnimation"));
+	if (animation_id.isNull())
+	{
+		animation_id = ANIM_AGENT_STAND;
+	}
+
+	// Copies stand on rings around the camera, one ring per distance, spread
+	// across the horizontal field of view and facing the camera.
+	LLViewerCamera* camera = LLViewerCamera::getInstance();
+	LLVector3 origin = camera->getOrigin();
+	LLVector3 forward = camera->getAtAxis();
+	forward.mV[VZ] = 0.f;
+	if (forward.normalize() == 0.f)
+	{
+		forward = LLVector3::x_axis;
+	}
+	F32 ground_z = gAgent.getPositionAgent().mV[VZ];
+	F32 half_fov = 0.4f * camera->getView() * camera->getAspect();
+	U32 per_ring = (count + (U32)distances.size() - 1) / (U32)distances.size();
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		LLVOAvatar* avatar = (LLVOAvatar*)gObjectList.createObjectViewer(LL_PCODE_LEGACY_AVATAR, gAgent.getRegion());
+		if (!avatar)
+		{
+			continue;
+		}
+		mAvatars.push_back(avatar);
+		gPipeline.addObject(avatar);
+
+		U32 ring = i % (U32)distances.size();
+		U32 slot = i / (U32)distances.size();
+		F32 angle = half_fov * (2.f * (slot + 0.5f) / per_ring - 1.f);
+		LLVector3 direction = forward * LLQuaternion(angle, LLVector3::z_axis);
+		LLVector3 position = origin + direction * distances[ring];
+		position.mV[VZ] = ground_z;
+		avatar->setPositionAgent(position);
+		avatar->setRotation(LLQuaternion(atan2f(-direction.mV[VY], -direction.mV[VX]), LLVector3::z_axis));
+
+		avatar->loadAppearanceDump(appearances[i % appearances.size()]);
+		avatar->startMotion(animation_id);
+
+		// nothing random or driven by look at targets, so runs repeat
+		avatar->stopMotion(ANIM_AGENT_HEAD_ROT, TRUE);
+		avatar->stopMotion(ANIM_AGENT_EYE, TRUE);
+		avatar->stopMotion(ANIM_AGENT_BODY_NOISE, TRUE);
+	}
+	if (mAvatars.empty())
+	{
+		return false;
+	}
+
+	mFrame = 0;
+	mWarmupFrames = gSavedSettings.getU32("AvatarBenchmarkWarmupFrames");
+	mSampleFrames = llmax(gSavedSettings.getU32("AvatarBenchmarkFrames"), 1U);
+	gIdleCallbacks.addFunction(onIdle, this);
+
+	LL_INFOS("AvatarBenchmark") << "started with " << mAvatars.size() << " avatars from "
+								<< appearances.size() << " appearances" << LL_ENDL;
+	return true;
+}
+
+void LLAvatarRenderBenchmark::stop()
+{
+	if (!isRunning())
+	{
+		return;
+	}
+
+	sSampling = false;
+	sCurrentPhase = PHASE_NONE;
+	gIdleCallbacks.deleteFunction(onIdle, this);
+	for (LLVOAvatar* avatar : mAvatars)
+	{
+		if (!avatar->isDead())
+		{
+			avatar->markDead();
+		}
+	}
+	mAvatars.clear();
+}
+
+// static
+void LLAvatarRenderBenchmark::onIdle(void* user_data)
+{
+	((LLAvatarRenderBenchmark*)user_data)->idle();
+}
+
+void LLAvatarRenderBenchmark::idle()
+{
+	U32 frame = mFrame++;
+	if (frame == mWarmupFrames)
+	{
+		// textures and meshes have had their chance to load
+		for (U32 i = 0; i < PHASE_COUNT; ++i)
+		{
+			sPhaseTime[i] = 0;
+		}
+		sCurrentPhase = PHASE_NONE;
+		sSampling = true;
+		mSampleTimer.reset();
+	}
+	else if (frame == mWarmupFrames + mSampleFrames)
+	{
+		sSampling = false;
+		mSampleSeconds = mSampleTimer.getElapsedTimeF32();
+
+		// the results are read back over the next few frames
+		for (LLVOAvatar* avatar : mAvatars)
+		{
+			if (!avatar->isDead() && !avatar->isTooSlow())
+			{
+				gPipeline.profileAvatar(avatar);
+			}
+		}
+	}
+	else if (frame == mWarmupFrames + mSampleFrames + PROFILE_READBACK_FRAMES)
+	{
+		report();
+		stop();
+	}
+}
+
+void LLAvatarRenderBenchmark::report()
+{
+	LLSD results;
+	results["avatars"] = (LLSD::Integer)mAvatars.size();
+	results["frames"] = (LLSD::Integer)mSampleFrames;
+	results["seconds"] = mSampleSeconds;
+	results["fps"] = mSampleSeconds > 0.f ? mSampleFrames / mSampleSeconds : 0.f;
+
+	std::ostringstream summary;
+	summary << mAvatars.size() << " avatars, " << mSampleFrames << " frames in " << mSampleSeconds << "s;";
+	for (U32 i = 0; i < PHASE_COUNT; ++i)
+	{
+		F32 ms_per_frame = (F32)sPhaseTime[i] / 1000.f / mSampleFrames;
+		results["cpu_ms_per_frame"][PHASE_NAMES[i]] = ms_per_frame;
+		summary << " " << PHASE_NAMES[i] << " " << ms_per_frame << "ms";
+	}
+
+	// one draw of every copy, from LLPipeline::profileAvatar()
+	F32 gpu_ms = 0.f;
+	F32 cpu_ms = 0.f;
+	for (LLVOAvatar* avatar : mAvatars)
+	{
+		if (!avatar->isDead())
+		{
+			gpu_ms += avatar->getGPURenderTime();
+			cpu_ms += avatar->getCPURenderTime();
+		}
+	}
+	results["gpu_ms_per_draw"] = gpu_ms;
+	results["cpu_ms_per_draw"] = cpu_ms;
+	summary << "; drawing all copies once: gpu " << gpu_ms << "ms, cpu " << cpu_ms << "ms";
+
+	LL_INFOS("AvatarBenchmark") << summary.str() << LL_ENDL;
+	dump_sequential_xml("avatar_benchmark", results);
+}
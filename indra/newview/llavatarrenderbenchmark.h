@@ -0,0 +1,121 @@
+/**
+ * @file llavatarrenderbenchmark.h
+ * @brief Repeatable measurement of avatar rendering cost.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLAVATARRENDERBENCHMARK_H
+#define LL_LLAVATARRENDERBENCHMARK_H
+
+#include "llsingleton.h"
+#include "lltimer.h"
+#include "llpointer.h"
+
+#include <vector>
+
+class LLVOAvatar;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLAvatarRenderBenchmark
+//
+// Spawns local copies of recorded avatar appearances (files written by
+// "Dump XML" or DebugAvatarAppearanceMessage) around the camera, plays a fixed
+// animation on them, and reports the CPU time spent per phase of avatar
+// work and the GPU time to draw the copies. The report goes to the log and
+// to avatar_benchmark_NNNN.xml in the logs directory.
+//
+// The phase times cover every avatar in the scene, so run it on an empty
+// region, from the same spot, for numbers that compare between builds.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLAvatarRenderBenchmark : public LLSingleton<LLAvatarRenderBenchmark>
+{
+	LLSINGLETON(LLAvatarRenderBenchmark);
+	void cleanupSingleton() override;
+
+public:
+	enum EPhase
+	{
+		PHASE_MOTION,		// character updates, animation and physics
+		PHASE_SKINNING,		// joint matrix palettes
+		PHASE_GEOMETRY,		// avatar and attachment geometry updates
+		PHASE_DRAW,			// avatar and rigged mesh draw calls
+		PHASE_COUNT,
+		PHASE_NONE = PHASE_COUNT
+	};
+
+	// Charges the time spent in its scope to a phase while a benchmark is
+	// sampling. Nested scopes pause the outer one, so every microsecond is
+	// counted once. Main thread only.
+	class ScopedPhase
+	{
+	public:
+		ScopedPhase(EPhase phase, bool enabled = true)
+		:	mPrevious(PHASE_NONE),
+			mActive(sSampling && enabled)
+		{
+			if (mActive)
+			{
+				mPrevious = switchPhase(phase);
+			}
+		}
+		~ScopedPhase()
+		{
+			if (mActive)
+			{
+				switchPhase(mPrevious);
+			}
+		}
+
+	private:
+		EPhase	mPrevious;
+		bool	mActive;
+	};
+
+	// Reads the AvatarBenchmark* settings and spawns the copies. False if a
+	// benchmark is already running or nothing could be loaded.
+	bool start();
+	void stop();
+	bool isRunning() const { return !mAvatars.empty(); }
+
+private:
+	static void onIdle(void* user_data);
+	void idle();
+	void report();
+
+	// Returns the phase that was being timed.
+	static EPhase switchPhase(EPhase phase);
+
+	static bool		sSampling;
+	static EPhase	sCurrentPhase;
+	static U64		sPhaseStart;
+	static U64		sPhaseTime[PHASE_COUNT];
+
+	std::vector<LLPointer<LLVOAvatar> > mAvatars;
+	U32			mFrame;
+	U32			mWarmupFrames;
+	U32			mSampleFrames;
+	LLTimer		mSampleTimer;
+	F32			mSampleSeconds;
+};
+
+#endif // LL_LLAVATARRENDERBENCHMARK_H
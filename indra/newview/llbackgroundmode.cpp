@@ -0,0 +1,80 @@
+/**
+ * @file llbackgroundmode.cpp
+ * @brief Scaled down updates while the viewer is minimized or in the background
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llbackgroundmode.h"
+
+#include "llapp.h"
+#include "llfocusmgr.h"
+#include "llstartup.h"
+#include "llviewercontrol.h"
+#include "llviewerwindow.h"
+#include "llwindow.h"
+
+bool LLBackgroundMode::sActive = false;
+bool LLBackgroundMode::sUpdateFrame = true;
+LLTimer LLBackgroundMode::sBackgroundTimer;
+LLTimer LLBackgroundMode::sUpdateTimer;
+
+// static
+void LLBackgroundMode::update()
+{
+	static LLCachedControl<bool> enabled(gSavedSettings, "BackgroundModeEnabled", false);
+	static LLCachedControl<F32> delay(gSavedSettings, "BackgroundModeDelay", 10.f);
+	static LLCachedControl<F32> update_rate(gSavedSettings, "BackgroundModeUpdateRate", 2.f);
+
+	bool background = gViewerWindow
+		&& (gViewerWindow->getWindow()->getMinimized()
+			|| !gViewerWindow->getWindow()->getVisible()
+			|| !gFocusMgr.getAppHasFocus());
+	if (!background)
+	{
+		sBackgroundTimer.reset();
+	}
+
+	bool active = enabled
+		&& background
+		&& !LLApp::isExiting()
+		&& LLStartUp::getStartupState() == STATE_STARTED
+		&& sBackgroundTimer.getElapsedTimeF32() >= (F32)delay;
+	if (active != sActive)
+	{
+		LL_INFOS() << (active ? "Entering" : "Leaving") << " background mode" << LL_ENDL;
+		sActive = active;
+		sUpdateTimer.reset();
+	}
+
+	sUpdateFrame = true;
+	if (sActive)
+	{
+		F32 interval = 1.f / llmax((F32)update_rate, 0.1f);
+		sUpdateFrame = sUpdateTimer.getElapsedTimeF32() >= interval;
+		if (sUpdateFrame)
+		{
+			sUpdateTimer.reset();
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/**
+ * @file llbackgroundmode.h
+ * @brief Scaled down updates while the viewer is minimized or in the background
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLBACKGROUNDMODE_H
+#define LL_LLBACKGROUNDMODE_H
+
+#include "lltimer.h"
+
+// With BackgroundModeEnabled set, once the viewer window has been minimized,
+// hidden or without focus for BackgroundModeDelay seconds, nothing is drawn
+// any more.  That also stops new texture and mesh requests, which come from
+// drawing, while the ones already queued for what was on screen finish.
+// Object updates (and so avatar animation) and particles only run
+// BackgroundModeUpdateRate times a second, and media plugins are dropped to
+// hidden priority.  Messages and circuits carry on as usual.  Nothing is
+// released, so the scene is there as it was when the window comes back.
+// Main thread only.
+class LLBackgroundMode
+{
+	LOG_CLASS(LLBackgroundMode);
+public:
+	// once per frame, before anything that asks
+	static void update();
+
+	static bool isActive() { return sActive; }
+
+	// false on the frames that throttled updates skip in background mode
+	static bool isUpdateFrame() { return sUpdateFrame; }
+
+private:
+	static bool sActive;
+	static bool sUpdateFrame;
+	static LLTimer sBackgroundTimer;	// since the window went to the background
+	static LLTimer sUpdateTimer;		// since the last throttled update
+};
+
+#endif // LL_LLBACKGROUNDMODE_H
@@ -198,7 +198,8 @@ LLVector3 LLBreastMotion::calculateAcceleration_local(const LLVector3 &new_char_
 BOOL LLBreastMotion::onUpdate(F32 time, U8* joint_mask)
 {
 	// Skip if disabled globally.
-	if (!gSavedSettings.getBOOL("AvatarPhysics"))
+	static LLCachedControl<bool> avatar_physics(gSavedSettings, "AvatarPhysics");
+	if (!avatar_physics)
 	{
 		return TRUE;
 	}
@@ -320,7 +321,8 @@ BOOL LLBreastMotion::onUpdate(F32 time, U8* joint_mask)
 	mBreastVelocity_local_vec.clamp(-mBreastMaxVelocityParam*100.0, mBreastMaxVelocityParam*100.0);
 
 	// Temporary debugging setting to cause all avatars to move, for profiling purposes.
-	if (gSavedSettings.getBOOL("AvatarPhysicsTest"))
+	static LLCachedControl<bool> avatar_physics_test(gSavedSettings, "AvatarPhysicsTest");
+	if (avatar_physics_test)
 	{
 		mBreastVelocity_local_vec[0] = sin(mTimer.getElapsedTimeF32()*4.0)*5.0;
 		mBreastVelocity_local_vec[1] = sin(mTimer.getElapsedTimeF32()*3.0)*5.0;
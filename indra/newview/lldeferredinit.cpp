@@ -0,0 +1,78 @@
+/**
+ * @file lldeferredinit.cpp
+ * @brief Brings up subsystems the login screen doesn't need once in world.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "lldeferredinit.h"
+
+#include "llstartupprofiler.h"
+#include "lltimer.h"
+#include "llviewercontrol.h"
+
+// time spent per frame once the first subsystem of the frame is up
+static const U64 FRAME_BUDGET_USEC = 4000;
+
+LLDeferredInit::queue_t LLDeferredInit::sQueue;
+
+//static
+void LLDeferredInit::add(const std::string& name, init_func_t func)
+{
+	if (gSavedSettings.getBOOL("StartupDeferInit"))
+	{
+		sQueue.push_back(std::make_pair(name, func));
+	}
+	else
+	{
+		run(name, func);
+	}
+}
+
+//static
+void LLDeferredInit::update()
+{
+	U64 start = totalTime().value();
+	while (!sQueue.empty())
+	{
+		// popped first so an initializer that adds more doesn't lose its place
+		std::pair<std::string, init_func_t> entry = sQueue.front();
+		sQueue.pop_front();
+		run(entry.first, entry.second);
+
+		if (totalTime().value() - start > FRAME_BUDGET_USEC)
+		{
+			return;
+		}
+	}
+
+	LLStartupProfiler::report();
+}
+
+//static
+void LLDeferredInit::run(const std::string& name, const init_func_t& func)
+{
+	LL_PROFILE_ZONE_SCOPED;
+	LLStartupProfiler::Scope scope(name);
+	func();
+}
@@ -0,0 +1,58 @@
+/**
+ * @file lldeferredinit.h
+ * @brief Brings up subsystems the login screen doesn't need once in world.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDEFERREDINIT_H
+#define LL_LLDEFERREDINIT_H
+
+#include <deque>
+#include <functional>
+#include <string>
+
+// Subsystems that neither the login screen nor the first frame in world
+// need. With StartupDeferInit they are queued and brought up on idle once
+// the viewer is in world, a few milliseconds' worth per frame; without it
+// add() runs them at once, where they used to be initialized. Anything the
+// user can reach before then must still work uninitialized or initialize
+// itself on first use.
+// Main thread only.
+class LLDeferredInit
+{
+public:
+	typedef std::function<void()> init_func_t;
+
+	static void add(const std::string& name, init_func_t func);
+
+	// from idle once in world; reports the startup profile when done
+	static void update();
+
+private:
+	static void run(const std::string& name, const init_func_t& func);
+
+	typedef std::deque<std::pair<std::string, init_func_t> > queue_t;
+	static queue_t sQueue;
+};
+
+#endif // LL_LLDEFERREDINIT_H
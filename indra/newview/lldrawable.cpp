@@ -741,13 +741,37 @@ void LLDrawable::moveUpdatePipeline(BOOL moved)
 		makeActive();
 	}
 	
-	// Update the face centers.
+	// Update the face centers, later along with the rest of the move list if
+	// the pipeline is working through one.
+	if (!gPipeline.queueFaceCenterUpdate(this))
+	{
+		updateFaceCenters();
+	}
+}
+
+void LLDrawable::updateFaceCenters()
+{
+	if (!isActive())
+	{
+		for (S32 i = 0; i < getNumFaces(); i++)
+		{
+			LLFace* face = getFace(i);
+			if (face)
+			{
+				face->updateCenterAgent();
+			}
+		}
+		return;
+	}
+
+	LLMatrix4a render_matrix;
+	render_matrix.loadu(getRenderMatrix());
 	for (S32 i = 0; i < getNumFaces(); i++)
 	{
 		LLFace* face = getFace(i);
 		if (face)
 		{
-			face->updateCenterAgent();
+			face->updateCenterAgent(render_matrix);
 		}
 	}
 }
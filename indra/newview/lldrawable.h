@@ -215,6 +215,7 @@ public:
 protected:
 	~LLDrawable() { destroy(); }
 	void moveUpdatePipeline(BOOL moved);
+	void updateFaceCenters();
 	void updatePartition();
 	BOOL updateMoveDamped();
 	BOOL updateMoveUndamped();
@@ -31,6 +31,7 @@
 #include "llfasttimer.h"
 #include "llviewercontrol.h"
 
+#include "llavatarrenderbenchmark.h"
 #include "lldrawable.h"
 #include "lldrawpoolalpha.h"
 #include "lldrawpoolavatar.h"
@@ -52,6 +53,9 @@
 #include "llglcommonfunc.h"
 #include "llvoavatar.h"
 #include "llviewershadermgr.h"
+#include "llskinningutil.h"
+
+#include <boost/functional/hash.hpp>
 
 S32 LLDrawPool::sNumDrawPools = 0;
 
@@ -465,6 +469,7 @@ void LLRenderPass::pushUntexturedBatches(U32 type)
 void LLRenderPass::pushRiggedBatches(U32 type, bool texture, bool batch_textures)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_DRAW);
     
     if (texture)
     {
@@ -493,9 +498,163 @@ void LLRenderPass::pushRiggedBatches(U32 type, bool texture, bool batch_textures
     }
 }
 
+namespace
+{
+    // uniform buffer behind the SkinInstances block of instanced skinning shaders
+    GLuint sSkinInstanceUBO = 0;
+
+    // key of the instanced draw a rigged batch can join, 0 if it can't join one
+    U64 skin_instance_key(LLDrawInfo* params)
+    {
+        if (!params->mGeometryHash || params->mTextureMatrix || !params->mSkinInfo
+            || params->mAvatar.isNull() || !params->mAvatar->isControlAvatar())
+        {
+            return 0;
+        }
+        size_t seed = (size_t) params->mGeometryHash;
+        boost::hash_combine(seed, params->mSkinInfo->mHash);
+        boost::hash_combine(seed, params->mTexture.get());
+        for (const LLPointer<LLViewerTexture>& tex : params->mTextureList)
+        {
+            boost::hash_combine(seed, tex.get());
+        }
+        return (U64) seed | 1;
+    }
+}
+
+void LLRenderPass::pushInstancedRiggedBatches(U32 type, void (*setup_shader)(LLGLSLShader*))
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_DRAW);
+    LLGLSLShader* shader = LLGLSLShader::sCurBoundShaderPtr;
+    LLGLSLShader* instanced_shader = shader ? shader->mSkinInstancedVariant : nullptr;
+    U32 max_instances = LLViewerShaderMgr::sMaxSkinInstances;
+    if (!instanced_shader || max_instances < 2)
+    {
+        pushRiggedBatches(type, true, true);
+        return;
+    }
+
+    // bucket the batches of animesh copies, in order of first appearance
+    std::unordered_map<U64, U32> group_index;
+    std::vector<std::vector<LLDrawInfo*> > groups;
+    auto* begin = gPipeline.beginRenderMap(type);
+    auto* end = gPipeline.endRenderMap(type);
+    for (LLCullResult::drawinfo_iterator i = begin; i != end; )
+    {
+        LLDrawInfo* pparams = *i;
+        LLCullResult::increment_iterator(i, end);
+
+        U64 key = skin_instance_key(pparams);
+        if (key)
+        {
+            auto found = group_index.emplace(key, (U32) groups.size());
+            if (found.second)
+            {
+                groups.emplace_back();
+            }
+            groups[found.first->second].push_back(pparams);
+        }
+    }
+
+    // everything that has no copy to share a draw with goes out as usual
+    LLVOAvatar* lastAvatar = nullptr;
+    U64 lastMeshId = 0;
+    for (LLCullResult::drawinfo_iterator i = begin; i != end; )
+    {
+        LLDrawInfo* pparams = *i;
+        LLCullResult::increment_iterator(i, end);
+
+        U64 key = skin_instance_key(pparams);
+        if (key && groups[group_index[key]].size() > 1)
+        {
+            continue;
+        }
+        if (pparams->mAvatar.notNull() && (lastAvatar != pparams->mAvatar || lastMeshId != pparams->mSkinInfo->mHash))
+        {
+            uploadMatrixPalette(*pparams);
+            lastAvatar = pparams->mAvatar;
+            lastMeshId = pparams->mSkinInfo->mHash;
+        }
+        pushBatch(*pparams, true, true);
+    }
+
+    bool have_instances = false;
+    for (const std::vector<LLDrawInfo*>& group : groups)
+    {
+        have_instances = have_instances || group.size() > 1;
+    }
+    if (!have_instances)
+    {
+        return;
+    }
+
+    instanced_shader->bind();
+    setup_shader(instanced_shader);
+
+    if (!sSkinInstanceUBO)
+    {
+        glGenBuffers(1, &sSkinInstanceUBO);
+    }
+
+    // the block holds max_instances palettes of the full joint count,
+    // std140 packing a mat3x4 in the same 12 floats as mGLMp
+    const U32 stride = LLSkinningUtil::getMaxJointCount() * 12;
+    static std::vector<F32> palettes;
+    palettes.resize(max_instances * stride);
+
+    for (const std::vector<LLDrawInfo*>& group : groups)
+    {
+        if (group.size() < 2)
+        {
+            continue;
+        }
+
+        U32 instances = 0;
+        for (U32 member = 0; member < group.size(); ++member)
+        {
+            LLDrawInfo* pparams = group[member];
+            const LLVOAvatar::MatrixPaletteCache& mpc = pparams->mAvatar->updateSkinInfoMatrixPalette(pparams->mSkinInfo);
+            if (!mpc.mMatrixPalette.empty())
+            { // skin info not loaded yet means don't render, as in uploadMatrixPalette
+                U32 count = llmin((U32) mpc.mGLMp.size(), stride);
+                memcpy(&palettes[instances * stride], mpc.mGLMp.data(), count * sizeof(F32));
+                ++instances;
+            }
+
+            if (instances && (instances == max_instances || member + 1 == group.size()))
+            {
+                glBindBuffer(GL_UNIFORM_BUFFER, sSkinInstanceUBO);
+                glBufferData(GL_UNIFORM_BUFFER, palettes.size() * sizeof(F32), palettes.data(), GL_STREAM_DRAW);
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+                glBindBufferBase(GL_UNIFORM_BUFFER, LLGLSLShader::SKIN_INSTANCES_BINDING, sSkinInstanceUBO);
+
+                // every member draws the same vertex data, so the first one's
+                // vertex buffer stands in for all of them
+                pushBatch(*group[0], true, true, instances);
+                instances = 0;
+            }
+        }
+    }
+
+    shader->bind();
+    setup_shader(shader);
+}
+
+// static
+void LLRenderPass::releaseSkinInstanceBuffer()
+{
+    if (sSkinInstanceUBO)
+    {
+        glDeleteBuffers(1, &sSkinInstanceUBO);
+        sSkinInstanceUBO = 0;
+    }
+}
+
 void LLRenderPass::pushUntexturedRiggedBatches(U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_DRAW);
     LLVOAvatar* lastAvatar = nullptr;
     U64 lastMeshId = 0;
     auto* begin = gPipeline.beginRenderMap(type);
@@ -533,6 +692,7 @@ void LLRenderPass::pushMaskBatches(U32 type, bool texture, bool batch_textures)
 void LLRenderPass::pushRiggedMaskBatches(U32 type, bool texture, bool batch_textures)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_DRAW);
     LLVOAvatar* lastAvatar = nullptr;
     U64 lastMeshId = 0;
     auto* begin = gPipeline.beginRenderMap(type);
@@ -580,7 +740,7 @@ void LLRenderPass::applyModelMatrix(const LLDrawInfo& params)
 	}
 }
 
-void LLRenderPass::pushBatch(LLDrawInfo& params, bool texture, bool batch_textures)
+void LLRenderPass::pushBatch(LLDrawInfo& params, bool texture, bool batch_textures, U32 instance_count)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
     llassert(texture);
@@ -627,7 +787,14 @@ void LLRenderPass::pushBatch(LLDrawInfo& params, bool texture, bool batch_textur
 	}
 	
     params.mVertexBuffer->setBuffer();
-    params.mVertexBuffer->drawRange(LLRender::TRIANGLES, params.mStart, params.mEnd, params.mCount, params.mOffset);
+    if (instance_count > 1)
+    {
+        params.mVertexBuffer->drawRangeInstanced(LLRender::TRIANGLES, params.mStart, params.mEnd, params.mCount, params.mOffset, instance_count);
+    }
+    else
+    {
+        params.mVertexBuffer->drawRange(LLRender::TRIANGLES, params.mStart, params.mEnd, params.mCount, params.mOffset);
+    }
 
 	if (tex_setup)
 	{
@@ -662,6 +829,7 @@ bool LLRenderPass::uploadMatrixPalette(LLDrawInfo& params)
 //static
 bool LLRenderPass::uploadMatrixPalette(LLVOAvatar* avatar, LLMeshSkinInfo* skinInfo)
 {
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_SKINNING);
     if (!avatar)
     {
         return false;
@@ -716,34 +884,165 @@ void LLRenderPass::pushGLTFBatches(U32 type, bool textured)
     }
 }
 
-void LLRenderPass::pushGLTFBatches(U32 type)
+namespace
 {
-    LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
-    auto* begin = gPipeline.beginRenderMap(type);
-    auto* end = gPipeline.endRenderMap(type);
-    for (LLCullResult::drawinfo_iterator i = begin; i != end; )
+    // A run of consecutive GLTF draw infos that differ in nothing pushGLTFBatch
+    // sets up, so they can go to GL as one glMultiDrawElements.  Render maps
+    // are in visibility order with each group's draw infos back to back, so
+    // this mostly catches the faces of one object that share a material.
+    // The last bound material is remembered across runs so a draw that only
+    // changes vertex buffer or transform skips rebinding its textures and
+    // uniforms.
+    class LLGLTFDrawRun
     {
-        LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("pushGLTFBatch");
-        LLDrawInfo& params = **i;
-        LLCullResult::increment_iterator(i, end);
+    public:
+        LLGLTFDrawRun(bool textured)
+            : mTextured(textured)
+        {
+            static LLCachedControl<bool> multi_draw(gSavedSettings, "RenderGLTFMultiDraw", true);
+            mMultiDraw = multi_draw;
+        }
+
+        ~LLGLTFDrawRun()
+        {
+            flush();
+        }
+
+        // true if params can be drawn with the current run without any state change
+        bool canAppend(const LLDrawInfo& params) const
+        {
+            if (!mFirst || !mMultiDraw)
+            {
+                return false;
+            }
+
+            const LLDrawInfo& first = *mFirst;
+            if (params.mVertexBuffer != first.mVertexBuffer ||
+                params.mModelMatrix != first.mModelMatrix ||
+                params.mAvatar != first.mAvatar ||
+                (params.mAvatar.notNull() && params.mSkinInfo->mHash != first.mSkinInfo->mHash))
+            {
+                return false;
+            }
+
+            if (mTextured)
+            {
+                return params.mGLTFMaterial == first.mGLTFMaterial &&
+                    params.mTexture == first.mTexture &&
+                    !params.mTextureMatrix && !first.mTextureMatrix;
+            }
+
+            // without textures only the cull mode comes from the material
+            return params.mGLTFMaterial->mDoubleSided == first.mGLTFMaterial->mDoubleSided;
+        }
+
+        void append(LLDrawInfo& params)
+        {
+            llassert(mCounts.empty() || canAppend(params));
+            if (!mFirst)
+            {
+                mFirst = &params;
+            }
+            mCounts.push_back(params.mCount);
+            mOffsets.push_back(params.mOffset);
+        }
+
+        void flush()
+        {
+            if (!mFirst)
+            {
+                return;
+            }
+
+            LLDrawInfo& params = *mFirst;
+            auto& mat = params.mGLTFMaterial;
+
+            if (mTextured && (!mMultiDraw || mat.get() != mBoundMaterial || params.mTexture.get() != mBoundMedia))
+            {
+                mat->bind(params.mTexture);
+                mBoundMaterial = mat.get();
+                mBoundMedia = params.mTexture.get();
+            }
 
-        pushGLTFBatch(params);
+            LLGLDisable cull_face(mat->mDoubleSided ? GL_CULL_FACE : 0);
+
+            if (mTextured)
+            {
+                setup_texture_matrix(params);
+            }
+
+            LLRenderPass::applyModelMatrix(params);
+
+            params.mVertexBuffer->setBuffer();
+            if (mCounts.size() == 1)
+            {
+                params.mVertexBuffer->drawRange(LLRender::TRIANGLES, params.mStart, params.mEnd, params.mCount, params.mOffset);
+            }
+            else
+            {
+                params.mVertexBuffer->drawRanges(LLRender::TRIANGLES, mCounts.data(), mOffsets.data(), (U32)mCounts.size());
+            }
+
+            if (mTextured)
+            {
+                teardown_texture_matrix(params);
+            }
+
+            mFirst = nullptr;
+            mCounts.clear();
+            mOffsets.clear();
+        }
+
+    private:
+        LLDrawInfo* mFirst = nullptr;
+        std::vector<U32> mCounts;
+        std::vector<U32> mOffsets;
+        LLFetchedGLTFMaterial* mBoundMaterial = nullptr;
+        LLViewerTexture* mBoundMedia = nullptr;
+        bool mTextured;
+        bool mMultiDraw;
+    };
+
+    void push_gltf_runs(U32 type, bool textured, bool rigged)
+    {
+        LLGLTFDrawRun run(textured);
+        LLVOAvatar* lastAvatar = nullptr;
+        U64 lastMeshId = 0;
+
+        auto* begin = gPipeline.beginRenderMap(type);
+        auto* end = gPipeline.endRenderMap(type);
+        for (LLCullResult::drawinfo_iterator i = begin; i != end; )
+        {
+            LLDrawInfo& params = **i;
+            LLCullResult::increment_iterator(i, end);
+
+            if (!run.canAppend(params))
+            {
+                run.flush();
+
+                if (rigged && params.mAvatar.notNull() && (lastAvatar != params.mAvatar || lastMeshId != params.mSkinInfo->mHash))
+                {
+                    LLRenderPass::uploadMatrixPalette(params);
+                    lastAvatar = params.mAvatar;
+                    lastMeshId = params.mSkinInfo->mHash;
+                }
+            }
+
+            run.append(params);
+        }
     }
 }
 
-void LLRenderPass::pushUntexturedGLTFBatches(U32 type)
+void LLRenderPass::pushGLTFBatches(U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
-    auto* begin = gPipeline.beginRenderMap(type);
-    auto* end = gPipeline.endRenderMap(type);
-    for (LLCullResult::drawinfo_iterator i = begin; i != end; )
-    {
-        LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("pushGLTFBatch");
-        LLDrawInfo& params = **i;
-        LLCullResult::increment_iterator(i, end);
+    push_gltf_runs(type, true, false);
+}
 
-        pushUntexturedGLTFBatch(params);
-    }
+void LLRenderPass::pushUntexturedGLTFBatches(U32 type)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+    push_gltf_runs(type, false, false);
 }
 
 void LLRenderPass::pushGLTFBatch(LLDrawInfo& params)
@@ -791,40 +1090,15 @@ void LLRenderPass::pushRiggedGLTFBatches(U32 type, bool textured)
 void LLRenderPass::pushRiggedGLTFBatches(U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
-    LLVOAvatar* lastAvatar = nullptr;
-    U64 lastMeshId = 0;
-
-    auto* begin = gPipeline.beginRenderMap(type);
-    auto* end = gPipeline.endRenderMap(type);
-    for (LLCullResult::drawinfo_iterator i = begin; i != end; )
-    {
-        LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("pushRiggedGLTFBatch");
-        LLDrawInfo& params = **i;
-        LLCullResult::increment_iterator(i, end);
-
-        pushRiggedGLTFBatch(params, lastAvatar, lastMeshId);
-    }
+    push_gltf_runs(type, true, true);
 }
 
 void LLRenderPass::pushUntexturedRiggedGLTFBatches(U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
-    LLVOAvatar* lastAvatar = nullptr;
-    U64 lastMeshId = 0;
-
-    auto* begin = gPipeline.beginRenderMap(type);
-    auto* end = gPipeline.endRenderMap(type);
-    for (LLCullResult::drawinfo_iterator i = begin; i != end; )
-    {
-        LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("pushRiggedGLTFBatch");
-        LLDrawInfo& params = **i;
-        LLCullResult::increment_iterator(i, end);
-
-        pushUntexturedRiggedGLTFBatch(params, lastAvatar, lastMeshId);
-    }
+    push_gltf_runs(type, false, true);
 }
 
-
 void LLRenderPass::pushRiggedGLTFBatch(LLDrawInfo& params, LLVOAvatar*& lastAvatar, U64& lastMeshId)
 {
     if (params.mAvatar.notNull() && (lastAvatar != params.mAvatar || lastMeshId != params.mSkinInfo->mHash))
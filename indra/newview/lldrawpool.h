@@ -39,6 +39,7 @@ class LLSpatialGroup;
 class LLDrawInfo;
 class LLVOAvatar;
 class LLMeshSkinInfo;
+class LLGLSLShader;
 
 class LLDrawPool
 {
@@ -357,6 +358,13 @@ public:
     void pushRiggedBatches(U32 type, bool texture = true, bool batch_textures = false);
     void pushUntexturedRiggedBatches(U32 type);
 
+    // like pushRiggedBatches(type, true, true), but batches of animesh copies
+    // that draw the same geometry go out as one instanced draw through the
+    // bound shader's mSkinInstancedVariant, set up with setup_shader
+    void pushInstancedRiggedBatches(U32 type, void (*setup_shader)(LLGLSLShader*));
+    // release the uniform buffer pushInstancedRiggedBatches uploads palettes to
+    static void releaseSkinInstanceBuffer();
+
     // push full GLTF batches
     // assumes draw infos of given type have valid GLTF materials
     void pushGLTFBatches(U32 type);
@@ -381,7 +389,7 @@ public:
 
 	void pushMaskBatches(U32 type, bool texture = true, bool batch_textures = false);
     void pushRiggedMaskBatches(U32 type, bool texture = true, bool batch_textures = false);
-	void pushBatch(LLDrawInfo& params, bool texture, bool batch_textures = false);
+	void pushBatch(LLDrawInfo& params, bool texture, bool batch_textures = false, U32 instance_count = 1);
     void pushUntexturedBatch(LLDrawInfo& params);
 	void pushBumpBatch(LLDrawInfo& params, bool texture, bool batch_textures = false);
     static bool uploadMatrixPalette(LLDrawInfo& params);
@@ -48,6 +48,7 @@
 #include "lldrawpoolwater.h"
 #include "llspatialpartition.h"
 #include "llglcommonfunc.h"
+#include "llviewerpartsim.h"
 #include "llvoavatar.h"
 
 #include "llenvironment.h"
@@ -201,6 +202,11 @@ void LLDrawPoolAlpha::renderPostDeferred(S32 pass)
 
     prepare_alpha_shader(pbr_shader, false, true, water_sign);
 
+    if (gGPUParticleProgram.mProgramObject)
+    {
+        prepare_alpha_shader(&gGPUParticleProgram, true, true, water_sign);
+    }
+
     // explicitly unbind here so render loop doesn't make assumptions about the last shader
     // already being setup for rendering
     LLGLSLShader::unbind();
@@ -264,6 +270,12 @@ void LLDrawPoolAlpha::forwardRender(bool rigged)
     // We don't want the nearly invisible objects to cause of DoF effects
     renderAlpha(getVertexDataMask() | LLVertexBuffer::MAP_TEXTURE_INDEX | LLVertexBuffer::MAP_TANGENT | LLVertexBuffer::MAP_TEXCOORD1 | LLVertexBuffer::MAP_TEXCOORD2, false, rigged);
 
+    if (!rigged && getType() == LLDrawPool::POOL_ALPHA_POST_WATER && !LLPipeline::sRenderingHUDs && !LLPipeline::sImpostorRender && !gCubeSnapshot &&
+        gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES))
+    { // particles on the GPU go unsorted after the rest of the alpha
+        LLViewerPartSim::getInstance()->getGPUParticles().render();
+    }
+
     gGL.setColorMask(true, false);
 
     if (!rigged)
@@ -396,6 +408,31 @@ inline void Draw(LLDrawInfo* draw, U32 mask)
 	draw->mVertexBuffer->drawRange(LLRender::TRIANGLES, draw->mStart, draw->mEnd, draw->mCount, draw->mOffset);                    
 }
 
+// true if next can go in the same drawRange call as cur, whose run of merged
+// draws ends at index end_offset: same buffer, picks up exactly where the run
+// leaves off, and needs identical shader, texture, blend and matrix state
+static bool can_merge_alpha_draws(const LLDrawInfo& cur, U32 end_offset, const LLDrawInfo& next)
+{
+    return next.mVertexBuffer == cur.mVertexBuffer &&
+        next.mOffset == end_offset &&
+        next.mAvatar == cur.mAvatar &&
+        next.mSkinInfo == cur.mSkinInfo &&
+        next.mModelMatrix == cur.mModelMatrix &&
+        next.mTextureMatrix == cur.mTextureMatrix &&
+        next.mTexture == cur.mTexture &&
+        next.mTextureList == cur.mTextureList &&
+        next.mNormalMap == cur.mNormalMap &&
+        next.mSpecularMap == cur.mSpecularMap &&
+        next.mMaterial == cur.mMaterial &&
+        next.mGLTFMaterial == cur.mGLTFMaterial &&
+        next.mShaderMask == cur.mShaderMask &&
+        next.mFullbright == cur.mFullbright &&
+        next.mBlendFuncSrc == cur.mBlendFuncSrc &&
+        next.mBlendFuncDst == cur.mBlendFuncDst &&
+        next.mSpecColor == cur.mSpecColor &&
+        next.mEnvIntensity == cur.mEnvIntensity;
+}
+
 bool LLDrawPoolAlpha::TexSetup(LLDrawInfo* draw, bool use_material)
 {
     bool tex_setup = false;
@@ -607,6 +644,8 @@ void LLDrawPoolAlpha::renderAlpha(U32 mask, bool depth_only, bool rigged)
         above_water = !above_water;
     }
 
+    static LLCachedControl<bool> merge_draws(gSavedSettings, "RenderAlphaBatchMerge", false);
+
 
     for (LLCullResult::sg_iterator i = begin; i != end; ++i)
 	{
@@ -793,6 +832,9 @@ void LLDrawPoolAlpha::renderAlpha(U32 mask, bool depth_only, bool rigged)
 
                 bool tex_setup = TexSetup(&params, (mat != nullptr));
 
+                // last of the draws sent along with this one, see RenderAlphaBatchMerge
+                LLSpatialGroup::drawmap_elem_t::iterator last = k;
+
 				{
 					gGL.blendFunc((LLRender::eBlendFactor) params.mBlendFuncSrc, (LLRender::eBlendFactor) params.mBlendFuncDst, mAlphaSFactor, mAlphaDFactor);
 
@@ -804,9 +846,30 @@ void LLDrawPoolAlpha::renderAlpha(U32 mask, bool depth_only, bool rigged)
                         current_shader->setMinimumAlpha(0.f);
                         reset_minimum_alpha = true;
                     }
-                    
+
+                    // neighbors in the sorted list that continue this draw's
+                    // index range with the same state go out in one call
+                    U16 start = params.mStart;
+                    U16 end = params.mEnd;
+                    U32 count = params.mCount;
+                    if (merge_draws)
+                    {
+                        for (LLSpatialGroup::drawmap_elem_t::iterator next = k + 1; next != draw_info.end(); ++next)
+                        {
+                            LLDrawInfo& next_params = **next;
+                            if (!can_merge_alpha_draws(params, params.mOffset + count, next_params))
+                            {
+                                break;
+                            }
+                            start = llmin(start, next_params.mStart);
+                            end = llmax(end, next_params.mEnd);
+                            count += next_params.mCount;
+                            last = next;
+                        }
+                    }
+
                     params.mVertexBuffer->setBuffer();
-                    params.mVertexBuffer->drawRange(LLRender::TRIANGLES, params.mStart, params.mEnd, params.mCount, params.mOffset);
+                    params.mVertexBuffer->drawRange(LLRender::TRIANGLES, start, end, count, params.mOffset);
 
                     if (reset_minimum_alpha)
                     {
@@ -815,29 +878,34 @@ void LLDrawPoolAlpha::renderAlpha(U32 mask, bool depth_only, bool rigged)
 				}
 
 				// If this alpha mesh has glow, then draw it a second time to add the destination-alpha (=glow).  Interleaving these state-changing calls is expensive, but glow must be drawn Z-sorted with alpha.
+				// Merged draws share a vertex buffer, so they all have glow or none do.
 				if (getType() != LLDrawPool::POOL_ALPHA_PRE_WATER &&
 					params.mVertexBuffer->hasDataType(LLVertexBuffer::TYPE_EMISSIVE))
 				{
-                    if (params.mAvatar != nullptr)
-                    {
-                        if (params.mGLTFMaterial.isNull())
-                        {
-                            rigged_emissives.push_back(&params);
-                        }
-                        else
-                        {
-                            pbr_rigged_emissives.push_back(&params);
-                        }
-                    }
-                    else
+                    for (LLSpatialGroup::drawmap_elem_t::iterator e = k; e != last + 1; ++e)
                     {
-                        if (params.mGLTFMaterial.isNull())
+                        LLDrawInfo* emissive = *e;
+                        if (emissive->mAvatar != nullptr)
                         {
-                            emissives.push_back(&params);
+                            if (emissive->mGLTFMaterial.isNull())
+                            {
+                                rigged_emissives.push_back(emissive);
+                            }
+                            else
+                            {
+                                pbr_rigged_emissives.push_back(emissive);
+                            }
                         }
                         else
                         {
-                            pbr_emissives.push_back(&params);
+                            if (emissive->mGLTFMaterial.isNull())
+                            {
+                                emissives.push_back(emissive);
+                            }
+                            else
+                            {
+                                pbr_emissives.push_back(emissive);
+                            }
                         }
                     }
 				}
@@ -849,6 +917,9 @@ void LLDrawPoolAlpha::renderAlpha(U32 mask, bool depth_only, bool rigged)
 					gGL.loadIdentity();
 					gGL.matrixMode(LLRender::MM_MODELVIEW);
 				}
+
+                // skip the draws merged into this one
+                k = last;
 			}
 
             // render emissive faces into alpha channel for bloom effects
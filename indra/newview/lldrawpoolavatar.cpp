@@ -35,6 +35,7 @@
 #include "llmatrix4a.h"
 
 #include "llagent.h" //for gAgent.needsRenderAvatar()
+#include "llavatarrenderbenchmark.h"
 #include "lldrawable.h"
 #include "lldrawpoolbump.h"
 #include "llface.h"
@@ -499,6 +500,7 @@ void LLDrawPoolAvatar::endImpostor()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR
 
+	gPipeline.mImpostorAtlas.renderQuads(sDiffuseChannel, -1, -1);
 		gImpostorProgram.unbind();
 	gPipeline.enableLightsDynamic();
 }
@@ -557,6 +559,10 @@ void LLDrawPoolAvatar::endDeferredImpostor()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR
 
 	sShaderLevel = mShaderLevel;
+	bool bind_attachments = LLPipeline::sRenderDeferred && !LLPipeline::sReflectionRender;
+	gPipeline.mImpostorAtlas.renderQuads(sDiffuseChannel,
+		bind_attachments ? normal_channel : -1,
+		bind_attachments ? specular_channel : -1);
 	sVertexProgram->disableTexture(LLViewerShaderMgr::DEFERRED_NORMAL);
 	sVertexProgram->disableTexture(LLViewerShaderMgr::SPECULAR_MAP);
 	sVertexProgram->disableTexture(LLViewerShaderMgr::DIFFUSE_MAP);
@@ -658,6 +664,7 @@ void LLDrawPoolAvatar::endDeferredSkinned()
 void LLDrawPoolAvatar::renderAvatars(LLVOAvatar* single_avatar, S32 pass)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR; //LL_RECORD_BLOCK_TIME(FTM_RENDER_CHARACTERS);
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_DRAW);
 
 	if (pass == -1)
 	{
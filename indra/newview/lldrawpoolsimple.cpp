@@ -138,7 +138,7 @@ void LLDrawPoolSimple::renderDeferred(S32 pass)
 	
     //render rigged
     setup_simple_shader(gDeferredDiffuseProgram.mRiggedVariant);
-    pushRiggedBatches(LLRenderPass::PASS_SIMPLE_RIGGED, true, true);
+    pushInstancedRiggedBatches(LLRenderPass::PASS_SIMPLE_RIGGED, setup_simple_shader);
 }
 
 static LLTrace::BlockTimerStatHandle FTM_RENDER_ALPHA_MASK_DEFERRED("Deferred Alpha Mask");
@@ -29,6 +29,7 @@
 #include "lldrawpoolterrain.h"
 
 #include "llfasttimer.h"
+#include "llparcel.h"
 
 #include "llagent.h"
 #include "llviewercontrol.h"
@@ -56,6 +57,7 @@ int DebugDetailMap = 0;
 
 S32 LLDrawPoolTerrain::sDetailMode = 1;
 F32 LLDrawPoolTerrain::sDetailScale = DETAIL_SCALE;
+bool LLDrawPoolTerrain::sHeightField = false;
 static LLGLSLShader* sShader = NULL;
 static LLTrace::BlockTimerStatHandle FTM_SHADOW_TERRAIN("Terrain Shadow");
 
@@ -67,6 +69,7 @@ LLDrawPoolTerrain::LLDrawPoolTerrain(LLViewerTexture *texturep) :
 	// Hack!
 	sDetailScale = 1.f/gSavedSettings.getF32("RenderTerrainScale");
 	sDetailMode = gSavedSettings.getS32("RenderTerrainDetail");
+	sHeightField = gSavedSettings.getBOOL("RenderTerrainHeightField");
 	mAlphaRampImagep = LLViewerTextureManager::getFetchedTexture(IMG_ALPHA_GRAD);
 
 	//gGL.getTexUnit(0)->bind(mAlphaRampImagep.get());
@@ -106,6 +109,13 @@ U32 LLDrawPoolTerrain::getVertexDataMask()
 void LLDrawPoolTerrain::prerender()
 {
 	sDetailMode = gSavedSettings.getS32("RenderTerrainDetail");
+
+	if (sHeightField && !mDrawFace.empty())
+	{
+		// upload changed heights now, before any pass has its textures bound
+		LLVOSurfacePatch* patchp = (LLVOSurfacePatch*)mDrawFace[0]->getViewerObject();
+		patchp->getPatch()->getSurface()->getHeightFieldTexture();
+	}
 }
 
 //static
@@ -131,7 +141,7 @@ void LLDrawPoolTerrain::beginDeferredPass(S32 pass)
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL; //LL_RECORD_BLOCK_TIME(FTM_RENDER_TERRAIN);
 	LLFacePool::beginRenderPass(pass);
 
-	sShader = &gDeferredTerrainProgram;
+	sShader = sHeightField ? &gDeferredTerrainHeightFieldProgram : &gDeferredTerrainProgram;
 
 	sShader->bind();
 }
@@ -156,7 +166,7 @@ void LLDrawPoolTerrain::renderDeferred(S32 pass)
 	renderFullShader();
 
 	// Special-case for land ownership feedback
-	if (gSavedSettings.getBOOL("ShowParcelOwners"))
+	if (gSavedSettings.getBOOL("ShowParcelOwners") && !LLViewerShaderMgr::sTerrainParcelOverlay)
 	{
 		hilightParcelOwners();
 	}
@@ -168,17 +178,18 @@ void LLDrawPoolTerrain::beginShadowPass(S32 pass)
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL; //LL_RECORD_BLOCK_TIME(FTM_SHADOW_TERRAIN);
 	LLFacePool::beginRenderPass(pass);
 	gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
-	gDeferredShadowProgram.bind();
+	sShader = sHeightField ? &gDeferredTerrainHeightFieldShadowProgram : &gDeferredShadowProgram;
+	sShader->bind();
 
     LLEnvironment& environment = LLEnvironment::instance();
-    gDeferredShadowProgram.uniform1i(LLShaderMgr::SUN_UP_FACTOR, environment.getIsSunUp() ? 1 : 0);
+    sShader->uniform1i(LLShaderMgr::SUN_UP_FACTOR, environment.getIsSunUp() ? 1 : 0);
 }
 
 void LLDrawPoolTerrain::endShadowPass(S32 pass)
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL; //LL_RECORD_BLOCK_TIME(FTM_SHADOW_TERRAIN);
 	LLFacePool::endRenderPass(pass);
-	gDeferredShadowProgram.unbind();
+	sShader->unbind();
 }
 
 void LLDrawPoolTerrain::renderShadow(S32 pass)
@@ -195,8 +206,31 @@ void LLDrawPoolTerrain::renderShadow(S32 pass)
 }
 
 
+static void set_face_model_matrix(LLFace* facep)
+{
+	LLMatrix4* model_matrix = &(facep->getDrawable()->getRegion()->mRenderMatrix);
+
+	if (model_matrix != gGLLastMatrix)
+	{
+		llassert(gGL.getMatrixMode() == LLRender::MM_MODELVIEW);
+		gGLLastMatrix = model_matrix;
+		gGL.loadMatrix(gGLModelView);
+		if (model_matrix)
+		{
+			gGL.multMatrix((GLfloat*) model_matrix->mMatrix);
+		}
+		gPipeline.mMatrixOpCount++;
+	}
+}
+
 void LLDrawPoolTerrain::drawLoop()
 {
+	if (sHeightField)
+	{
+		drawHeightField();
+		return;
+	}
+
 	if (!mDrawFace.empty())
 	{
 		for (std::vector<LLFace*>::iterator iter = mDrawFace.begin();
@@ -204,25 +238,129 @@ void LLDrawPoolTerrain::drawLoop()
 		{
 			LLFace *facep = *iter;
 
-			LLMatrix4* model_matrix = &(facep->getDrawable()->getRegion()->mRenderMatrix);
-
-			if (model_matrix != gGLLastMatrix)
-			{
-				llassert(gGL.getMatrixMode() == LLRender::MM_MODELVIEW);
-				gGLLastMatrix = model_matrix;
-				gGL.loadMatrix(gGLModelView);
-				if (model_matrix)
-				{
-					gGL.multMatrix((GLfloat*) model_matrix->mMatrix);
-				}
-				gPipeline.mMatrixOpCount++;
-			}
+			set_face_model_matrix(facep);
 
 			facep->renderIndexed();
 		}
 	}
 }
 
+LLVertexBuffer* LLDrawPoolTerrain::getHeightFieldGrid(U32 stride, U32 patch_width)
+{
+	LLPointer<LLVertexBuffer>& grid = mHeightFieldGrids[stride];
+	if (grid.notNull())
+	{
+		return grid;
+	}
+
+	// (quads + 1)^2 points covering the whole patch, edges included
+	U32 quads = llmax(patch_width / stride, (U32)1);
+	U32 vert_size = quads + 1;
+	grid = new LLVertexBuffer(LLVertexBuffer::MAP_VERTEX);
+	if (!grid->allocateBuffer(vert_size * vert_size, quads * quads * 6))
+	{
+		LL_WARNS() << "Failed to allocate terrain height field grid for stride " << stride << LL_ENDL;
+		grid = NULL;
+		return NULL;
+	}
+
+	LLStrider<LLVector3> vertices;
+	LLStrider<U16> indices;
+	if (!grid->getVertexStrider(vertices) || !grid->getIndexStrider(indices))
+	{
+		grid = NULL;
+		return NULL;
+	}
+
+	for (U32 j = 0; j < vert_size; j++)
+	{
+		for (U32 i = 0; i < vert_size; i++)
+		{
+			(vertices++)->set((F32)(i * stride), (F32)(j * stride), 0.f);
+		}
+	}
+
+	// same winding as LLVOSurfacePatch::updateMainGeometry()
+	for (U32 j = 0; j < quads; j++)
+	{
+		for (U32 i = 0; i < quads; i++)
+		{
+			*(indices++) = i + j*vert_size;
+			*(indices++) = (i + 1) + (j + 1)*vert_size;
+			*(indices++) = i + (j + 1)*vert_size;
+
+			*(indices++) = i + j*vert_size;
+			*(indices++) = (i + 1) + j*vert_size;
+			*(indices++) = (i + 1) + (j + 1)*vert_size;
+		}
+	}
+
+	grid->unmapBuffer();
+	return grid;
+}
+
+void LLDrawPoolTerrain::drawHeightField()
+{
+	static LLStaticHashedString sPatchOrigin("patch_origin");
+	static LLStaticHashedString sNeighborStride("neighbor_stride");
+	static LLStaticHashedString sGridScale("grid_scale");
+
+	if (mDrawFace.empty())
+	{
+		return;
+	}
+
+	LLGLSLShader* shader = LLGLSLShader::sCurBoundShaderPtr;
+	llassert(shader);
+
+	LLSurface* surfacep = ((LLVOSurfacePatch*)mDrawFace[0]->getViewerObject())->getPatch()->getSurface();
+	U32 patch_width = surfacep->getGridsPerPatchEdge();
+	F32 meters_per_grid = surfacep->getMetersPerGrid();
+	shader->uniform2f(sGridScale, meters_per_grid, (F32)surfacep->getGridsPerEdge());
+
+	S32 channel = shader->enableTexture(LLShaderMgr::TERRAIN_HEIGHT_FIELD);
+	if (channel > -1)
+	{
+		gGL.getTexUnit(channel)->bindManual(LLTexUnit::TT_TEXTURE, surfacep->getHeightFieldTexture());
+	}
+
+	for (LLFace* facep : mDrawFace)
+	{
+		LLSurfacePatch* patchp = ((LLVOSurfacePatch*)facep->getViewerObject())->getPatch();
+		U32 stride = patchp->getRenderStride();
+		LLVertexBuffer* grid = getHeightFieldGrid(stride, patch_width);
+		if (!grid)
+		{
+			continue;
+		}
+
+		set_face_model_matrix(facep);
+
+		const LLVector3& origin = patchp->getOriginRegion();
+		F32 patch_origin[4] = { origin.mV[VX] / meters_per_grid, origin.mV[VY] / meters_per_grid,
+								(F32)stride, (F32)patch_width };
+		shader->uniform4fv(sPatchOrigin, 1, patch_origin);
+
+		// a missing neighbour (edge of the known world) leaves the edge as is
+		const U32 directions[] = { WEST, EAST, SOUTH, NORTH };
+		F32 neighbor_stride[4];
+		for (U32 i = 0; i < 4; i++)
+		{
+			LLSurfacePatch* neighborp = patchp->getNeighborPatch(directions[i]);
+			neighbor_stride[i] = (F32)(neighborp ? neighborp->getRenderStride() : stride);
+		}
+		shader->uniform4fv(sNeighborStride, 1, neighbor_stride);
+
+		grid->setBuffer();
+		grid->drawRange(LLRender::TRIANGLES, 0, grid->getNumVerts() - 1, grid->getNumIndices(), 0);
+	}
+
+	if (channel > -1)
+	{
+		shader->disableTexture(LLShaderMgr::TERRAIN_HEIGHT_FIELD);
+	}
+}
+
 void LLDrawPoolTerrain::renderFullShader()
 {
 	// Hack! Get the region that this draw pool is rendering from!
@@ -288,9 +426,42 @@ void LLDrawPoolTerrain::renderFullShader()
 	gGL.getTexUnit(alpha_ramp)->bind(m2DAlphaRampImagep);
     gGL.getTexUnit(alpha_ramp)->setTextureAddressMode(LLTexUnit::TAM_CLAMP);
 
+	//
+	// Parcel ownership and property lines
+	//
+	S32 parcel_overlay = -1;
+	S32 parcel_lines = -1;
+	if (LLViewerShaderMgr::sTerrainParcelOverlay)
+	{
+		static LLCachedControl<bool> show_owners(gSavedSettings, "ShowParcelOwners", false);
+		static LLCachedControl<bool> show_lines(gSavedSettings, "ShowPropertyLines", false);
+		static LLStaticHashedString sParcelGrid("parcel_grid");
+		static LLStaticHashedString sParcelDisplay("parcel_display");
+
+		LLViewerParcelOverlay* overlayp = regionp->getParcelOverlay();
+
+		parcel_overlay = sShader->enableTexture(LLViewerShaderMgr::TERRAIN_PARCEL_OVERLAY);
+		gGL.getTexUnit(parcel_overlay)->bind(overlayp->getTexture());
+		parcel_lines = sShader->enableTexture(LLViewerShaderMgr::TERRAIN_PARCEL_LINES);
+		gGL.getTexUnit(parcel_lines)->bind(overlayp->getLinesTexture());
+
+		// same width the CPU built property lines have
+		const F32 PROPERTY_LINE_WIDTH = 0.0625f;
+		sShader->uniform3f(sParcelGrid, PARCEL_GRID_STEP_METERS, regionp->getWidth() / PARCEL_GRID_STEP_METERS, PROPERTY_LINE_WIDTH);
+		sShader->uniform3f(sParcelDisplay, show_owners ? 1.f : 0.f, show_lines ? 1.f : 0.f, regionp->getWaterHeight());
+	}
+
 	// GL_BLEND disabled by default
 	drawLoop();
 
+	if (parcel_overlay > -1)
+	{
+		sShader->disableTexture(LLViewerShaderMgr::TERRAIN_PARCEL_OVERLAY);
+		gGL.getTexUnit(parcel_overlay)->unbind(LLTexUnit::TT_TEXTURE);
+		sShader->disableTexture(LLViewerShaderMgr::TERRAIN_PARCEL_LINES);
+		gGL.getTexUnit(parcel_lines)->unbind(LLTexUnit::TT_TEXTURE);
+	}
+
 	// Disable multitexture
 	sShader->disableTexture(LLViewerShaderMgr::TERRAIN_ALPHARAMP);
 	sShader->disableTexture(LLViewerShaderMgr::TERRAIN_DETAIL0);
@@ -327,7 +498,7 @@ void LLDrawPoolTerrain::hilightParcelOwners()
 	{ //use fullbright shader for highlighting
 		LLGLSLShader* old_shader = sShader;
 		sShader->unbind();
-		sShader = &gDeferredHighlightProgram;
+		sShader = sHeightField ? &gDeferredTerrainHeightFieldHighlightProgram : &gDeferredHighlightProgram;
 		sShader->bind();
 		gGL.diffuseColor4f(1, 1, 1, 1);
 		LLGLEnable polyOffset(GL_POLYGON_OFFSET_FILL);
@@ -744,11 +915,18 @@ void LLDrawPoolTerrain::renderOwnership()
 
 	const F32 TEXTURE_FUDGE = 257.f / 256.f;
 	gGL.scalef( TEXTURE_FUDGE, TEXTURE_FUDGE, 1.f );
-	for (std::vector<LLFace*>::iterator iter = mDrawFace.begin();
-		 iter != mDrawFace.end(); iter++)
+	if (sHeightField)
 	{
-		LLFace *facep = *iter;
-		facep->renderIndexed();
+		drawHeightField();
+	}
+	else
+	{
+		for (std::vector<LLFace*>::iterator iter = mDrawFace.begin();
+			 iter != mDrawFace.end(); iter++)
+		{
+			LLFace *facep = *iter;
+			facep->renderIndexed();
+		}
 	}
 
 	gGL.matrixMode(LLRender::MM_TEXTURE);
@@ -69,6 +69,7 @@ public:
 
 	static S32 sDetailMode;
 	static F32 sDetailScale; // meters per texture
+	static bool sHeightField; // RenderTerrainHeightField
 
 protected:
     void boostTerrainDetailTextures();
@@ -81,8 +82,15 @@ protected:
 	void renderFullShader();
 	void drawLoop();
 
+	// Draws every face's patch from the region's height field texture with
+	// the shared grid matching the patch's render stride.
+	void drawHeightField();
+	LLVertexBuffer* getHeightFieldGrid(U32 stride, U32 patch_width);
+
 private:
 	void hilightParcelOwners();
+
+	std::map<U32, LLPointer<LLVertexBuffer> > mHeightFieldGrids; // by render stride
 };
 
 #endif // LL_LLDRAWPOOLSIMPLE_H
@@ -41,6 +41,7 @@
 #include "llenvironment.h"
 
 S32 LLDrawPoolTree::sDiffTex = 0;
+U32 LLDrawPoolTree::sInstanceUBO = 0;
 static LLGLSLShader* shader = NULL;
 
 LLDrawPoolTree::LLDrawPoolTree(LLViewerTexture *texturep) :
@@ -75,6 +76,10 @@ void LLDrawPoolTree::renderDeferred(S32 pass)
     gGL.getTexUnit(sDiffTex)->bindFast(mTexturep);
     mTexturep->addTextureStats(1024.f * 1024.f); // <=== keep Linden tree textures at full res
 
+    LLGLSLShader* cur_shader = LLGLSLShader::sCurBoundShaderPtr;
+    bool instancing = cur_shader && cur_shader->mInstancedVariant;
+    instance_map_t instances;
+
     for (std::vector<LLFace*>::iterator iter = mDrawFace.begin();
         iter != mDrawFace.end(); iter++)
     {
@@ -85,6 +90,17 @@ void LLDrawPoolTree::renderDeferred(S32 pass)
         {
             LLMatrix4* model_matrix = &(face->getDrawable()->getRegion()->mRenderMatrix);
 
+            LLVOTree* tree = (LLVOTree*) face->getViewerObject();
+            if (tree && tree->isInstanced())
+            {
+                if (instancing)
+                { // trees sharing a mesh in the same region go out together below
+                    instances[std::make_pair(buff, model_matrix)].push_back(&tree->getInstanceTransform());
+                }
+                // the shared mesh means nothing without the instance transform
+                continue;
+            }
+
             if (model_matrix != gGLLastMatrix)
             {
                 gGLLastMatrix = model_matrix;
@@ -101,6 +117,78 @@ void LLDrawPoolTree::renderDeferred(S32 pass)
             buff->drawRange(LLRender::TRIANGLES, 0, buff->getNumVerts() - 1, buff->getNumIndices(), 0);
         }
     }
+
+    if (!instances.empty())
+    {
+        renderInstances(instances);
+    }
+}
+
+void LLDrawPoolTree::renderInstances(const instance_map_t& instances)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    LLGLSLShader* cur_shader = LLGLSLShader::sCurBoundShaderPtr;
+    LLGLSLShader* instanced_shader = cur_shader->mInstancedVariant;
+    U32 max_instances = LLViewerShaderMgr::sMaxTreeInstances;
+
+    instanced_shader->bind();
+    instanced_shader->setMinimumAlpha(0.5f);
+    instanced_shader->uniform1i(LLShaderMgr::SUN_UP_FACTOR, LLEnvironment::instance().getIsSunUp() ? 1 : 0);
+
+    if (!sInstanceUBO)
+    {
+        glGenBuffers(1, &sInstanceUBO);
+    }
+
+    static std::vector<LLMatrix4> transforms;
+    transforms.resize(max_instances);
+
+    for (const auto& batch : instances)
+    {
+        LLVertexBuffer* buff = batch.first.first;
+        LLMatrix4* model_matrix = batch.first.second;
+        const std::vector<const LLMatrix4*>& members = batch.second;
+
+        if (model_matrix != gGLLastMatrix)
+        {
+            gGLLastMatrix = model_matrix;
+            gGL.loadMatrix(gGLModelView);
+            gGL.multMatrix((GLfloat*)model_matrix->mMatrix);
+            gPipeline.mMatrixOpCount++;
+        }
+
+        buff->setBuffer();
+
+        for (U32 first = 0; first < members.size(); first += max_instances)
+        {
+            U32 count = llmin((U32) members.size() - first, max_instances);
+            for (U32 i = 0; i < count; ++i)
+            {
+                transforms[i] = *members[first + i];
+            }
+
+            // LLMatrix4 rows are the columns of a GLSL mat4, as with gGL.multMatrix
+            glBindBuffer(GL_UNIFORM_BUFFER, sInstanceUBO);
+            glBufferData(GL_UNIFORM_BUFFER, count * sizeof(LLMatrix4), transforms.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glBindBufferBase(GL_UNIFORM_BUFFER, LLGLSLShader::INSTANCE_TRANSFORMS_BINDING, sInstanceUBO);
+
+            buff->drawRangeInstanced(LLRender::TRIANGLES, 0, buff->getNumVerts() - 1, buff->getNumIndices(), 0, count);
+        }
+    }
+
+    cur_shader->bind();
+}
+
+// static
+void LLDrawPoolTree::releaseInstanceBuffer()
+{
+    if (sInstanceUBO)
+    {
+        glDeleteBuffers(1, &sInstanceUBO);
+        sInstanceUBO = 0;
+    }
 }
 
 void LLDrawPoolTree::endDeferredPass(S32 pass)
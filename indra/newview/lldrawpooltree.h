@@ -29,6 +29,8 @@
 
 #include "lldrawpool.h"
 
+#include <map>
+
 class LLDrawPoolTree : public LLFacePool
 {
 	LLPointer<LLViewerTexture> mTexturep;
@@ -60,7 +62,18 @@ public:
 	/*virtual*/ LLViewerTexture *getDebugTexture();
 	/*virtual*/ LLColor3 getDebugColor() const; // For AGP debug display
 
+	// free the uniform buffer instanced trees are drawn with
+	static void releaseInstanceBuffer();
+
 	static S32 sDiffTex;
+
+private:
+	// draw the instanced trees collected by renderDeferred with the bound
+	// shader's mInstancedVariant
+	typedef std::map<std::pair<LLVertexBuffer*, LLMatrix4*>, std::vector<const LLMatrix4*> > instance_map_t;
+	void renderInstances(const instance_map_t& instances);
+
+	static U32 sInstanceUBO;
 };
 
 #endif // LL_LLDRAWPOOLTREE_H
@@ -153,6 +153,7 @@ void LLDrawPoolWater::renderPostDeferred(S32 pass)
     bool                   moon_up         = environment.getIsMoonUp();
     bool                   has_normal_mips = gSavedSettings.getBOOL("RenderWaterMipNormal");
     bool                   underwater      = LLViewerCamera::getInstance()->cameraUnderWater();
+    bool                   water_ssr       = LLPipeline::useWaterScreenSpaceReflections();
     LLColor4               fog_color       = LLColor4(pwater->getWaterFogColor(), 0.f);
     LLColor3               fog_color_linear = linearColor3(fog_color);
 
@@ -208,6 +209,25 @@ void LLDrawPoolWater::renderPostDeferred(S32 pass)
 
         gPipeline.bindDeferredShader(*shader, nullptr, &gPipeline.mWaterDis);
 
+        if (water_ssr && shader == &gWaterProgram)
+        {
+            // trace against the scene as it was just before water, which is
+            // from this frame, so there is no camera motion to undo
+            S32 channel = shader->getTextureChannel(LLShaderMgr::SCENE_MAP);
+            if (channel > -1)
+            {
+                gGL.getTexUnit(channel)->bind(&gPipeline.mWaterDis);
+            }
+            channel = shader->getTextureChannel(LLShaderMgr::SCENE_DEPTH);
+            if (channel > -1)
+            {
+                gGL.getTexUnit(channel)->bind(&gPipeline.mWaterDis, true);
+            }
+            static const F32 identity[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+            shader->uniformMatrix4fv(LLShaderMgr::MODELVIEW_DELTA_MATRIX, 1, GL_FALSE, identity);
+            shader->uniformMatrix4fv(LLShaderMgr::INVERSE_MODELVIEW_DELTA_MATRIX, 1, GL_FALSE, identity);
+        }
+
         //bind normal map
         S32 bumpTex = shader->enableTexture(LLViewerShaderMgr::BUMP_MAP);
         S32 bumpTex2 = shader->enableTexture(LLViewerShaderMgr::BUMP_MAP2);
@@ -1837,6 +1837,11 @@ void LLEnvironment::updateSettingsUniforms()
     if (mCurrentEnvironment->getSky())
     {
         updateGLVariablesForSettings(mSkyUniforms, mCurrentEnvironment->getSky());
+
+        if (LLViewerShaderMgr::sUseAtmosphericsUBO)
+        {
+            updateAtmosphericsUBO();
+        }
     }
     else
     {
@@ -1844,6 +1849,105 @@ void LLEnvironment::updateSettingsUniforms()
     }
 }
 
+namespace
+{
+    // mirrors the std140 AtmosphericsUniforms block in atmosphericsFuncs.glsl and friends
+    struct AtmosphericsUniformBlock
+    {
+        LLVector3 mAmbientColor;
+        F32 mHazeHorizon;
+        LLVector3 mBlueHorizon;
+        F32 mHazeDensity;
+        LLVector3 mBlueDensity;
+        F32 mCloudShadow;
+        LLVector3 mGlow;
+        F32 mDensityMultiplier;
+        F32 mDistanceMultiplier;
+        F32 mMaxY;
+        F32 mSceneLightStrength;
+        F32 mSunMoonGlowFactor;
+        F32 mSkySunlightScale;
+        F32 mSkyAmbientScale;
+        F32 mPad[2];
+    };
+    static_assert(sizeof(AtmosphericsUniformBlock) == 96, "AtmosphericsUniformBlock must match the std140 layout");
+
+    // where a shared sky uniform lives in the block, nullptr if it isn't in it
+    F32* atmospherics_block_member(AtmosphericsUniformBlock& block, S32 key)
+    {
+        switch (key)
+        {
+        case LLShaderMgr::AMBIENT:              return block.mAmbientColor.mV;
+        case LLShaderMgr::HAZE_HORIZON:         return &block.mHazeHorizon;
+        case LLShaderMgr::BLUE_HORIZON:         return block.mBlueHorizon.mV;
+        case LLShaderMgr::HAZE_DENSITY:         return &block.mHazeDensity;
+        case LLShaderMgr::BLUE_DENSITY:         return block.mBlueDensity.mV;
+        case LLShaderMgr::CLOUD_SHADOW:         return &block.mCloudShadow;
+        case LLShaderMgr::GLOW:                 return block.mGlow.mV;
+        case LLShaderMgr::DENSITY_MULTIPLIER:   return &block.mDensityMultiplier;
+        case LLShaderMgr::DISTANCE_MULTIPLIER:  return &block.mDistanceMultiplier;
+        case LLShaderMgr::MAX_Y:                return &block.mMaxY;
+        case LLShaderMgr::SCENE_LIGHT_STRENGTH: return &block.mSceneLightStrength;
+        case LLShaderMgr::SUN_MOON_GLOW_FACTOR: return &block.mSunMoonGlowFactor;
+        case LLShaderMgr::SKY_SUNLIGHT_SCALE:   return &block.mSkySunlightScale;
+        case LLShaderMgr::SKY_AMBIENT_SCALE:    return &block.mSkyAmbientScale;
+        default:                                return nullptr;
+        }
+    }
+}
+
+void LLEnvironment::updateAtmosphericsUBO()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    AtmosphericsUniformBlock block;
+    memset(&block, 0, sizeof(block));
+
+    // settings were recorded in order and the last one for a uniform wins,
+    // same as when they're applied one by one
+    LLShaderUniforms& uniforms = mSkyUniforms[LLGLSLShader::SG_ANY];
+    uniforms.mFloats.erase(std::remove_if(uniforms.mFloats.begin(), uniforms.mFloats.end(),
+        [&block](const LLShaderUniforms::FloatSetting& setting)
+        {
+            F32* dst = atmospherics_block_member(block, setting.mUniform);
+            if (dst)
+            {
+                *dst = setting.mValue;
+            }
+            return dst != nullptr;
+        }), uniforms.mFloats.end());
+
+    uniforms.mVector3s.erase(std::remove_if(uniforms.mVector3s.begin(), uniforms.mVector3s.end(),
+        [&block](const LLShaderUniforms::Vector3Setting& setting)
+        {
+            F32* dst = atmospherics_block_member(block, setting.mUniform);
+            if (dst)
+            {
+                memcpy(dst, setting.mValue.mV, sizeof(F32) * 3);
+            }
+            return dst != nullptr;
+        }), uniforms.mVector3s.end());
+
+    if (mAtmosphericsUBO == 0)
+    {
+        glGenBuffers(1, &mAtmosphericsUBO);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, mAtmosphericsUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LLGLSLShader::ATMOSPHERICS_BINDING, mAtmosphericsUBO);
+}
+
+void LLEnvironment::releaseAtmosphericsUBO()
+{
+    if (mAtmosphericsUBO)
+    {
+        glDeleteBuffers(1, &mAtmosphericsUBO);
+        mAtmosphericsUBO = 0;
+    }
+}
+
 void LLEnvironment::recordEnvironment(S32 parcel_id, LLEnvironment::EnvironmentInfo::ptr_t envinfo, LLSettingsBase::Seconds transition)
 {
     if (!gAgent.getRegion())
@@ -143,6 +143,9 @@ public:
     // prepare settings to be applied to shaders (call whenever settings are updated)
     void                        updateSettingsUniforms();
 
+    // free the AtmosphericsUniforms buffer, it's recreated on the next settings update
+    void                        releaseAtmosphericsUBO();
+
     void                        setSelectedEnvironment(EnvSelection_t env, LLSettingsBase::Seconds transition = TRANSITION_DEFAULT, bool forced = false);
     EnvSelection_t              getSelectedEnvironment() const                  { return mSelectedEnvironment; }
 
@@ -372,6 +375,8 @@ private:
     LLVector2                   mCloudScrollDelta;  // cumulative cloud delta
     bool                        mCloudScrollPaused;
 
+    U32                         mAtmosphericsUBO = 0;
+
     InstanceArray_t             mEnvironments;
 
     EnvSelection_t              mSelectedEnvironment;
@@ -398,6 +403,10 @@ private:
 
     void                        updateCloudScroll();
 
+    // move the sky values every shader shares out of mSkyUniforms[SG_ANY]
+    // and into the AtmosphericsUniforms block (see ATMOSPHERICS_UBO)
+    void                        updateAtmosphericsUBO();
+
     void                        onRegionChange();
     void                        onParcelChange();
 
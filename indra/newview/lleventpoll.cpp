@@ -31,6 +31,7 @@
 #include "llagent.h"
 
 #include "llsdserialize.h"
+#include "llcallbacklist.h"
 #include "lleventtimer.h"
 #include "llviewerregion.h"
 #include "message.h"
@@ -39,14 +40,120 @@
 #include "lleventcoro.h"
 #include "llcorehttputil.h"
 #include "lleventfilter.h"
+#include "llviewercontrol.h"
 
 #include "boost/make_shared.hpp"
 
+#include <deque>
+
 namespace LLEventPolling
 {
 namespace Details
 {
 
+    // Spreads event queue messages over frames. Messages the agent is
+    // blocked on (teleports, region crossings) go ahead of the rest and
+    // aren't subject to the frame budget.
+    class LLEventPollDispatcher
+    {
+    public:
+        static bool isEnabled();
+        static void queue(const std::string& sender, const LLSD& content);
+
+    private:
+        typedef std::pair<std::string, LLSD> queued_message_t;
+
+        static bool isUrgent(const std::string& msg_name);
+        static void onIdle(void*);
+
+        static std::deque<queued_message_t> sUrgent;
+        static std::deque<queued_message_t> sNormal;
+    };
+
+    std::deque<LLEventPollDispatcher::queued_message_t> LLEventPollDispatcher::sUrgent;
+    std::deque<LLEventPollDispatcher::queued_message_t> LLEventPollDispatcher::sNormal;
+
+    static void dispatchEventPollMessage(const std::string& sender, const LLSD& content)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_APP;
+        std::string	msg_name = content["message"];
+        LLSD message;
+        message["sender"] = sender;
+        message["body"] = content["body"];
+
+        LLMessageSystem::dispatch(msg_name, message);
+    }
+
+    //static
+    bool LLEventPollDispatcher::isEnabled()
+    {
+        static LLCachedControl<F32> budget_ms(gSavedSettings, "EventPollDispatchBudgetMS", 0.f);
+        return budget_ms > 0.f;
+    }
+
+    //static
+    bool LLEventPollDispatcher::isUrgent(const std::string& msg_name)
+    {
+        return msg_name == "TeleportFinish"
+            || msg_name == "TeleportFailed"
+            || msg_name == "CrossedRegion"
+            || msg_name == "EstablishAgentCommunication"
+            || msg_name == "EnableSimulator";
+    }
+
+    //static
+    void LLEventPollDispatcher::queue(const std::string& sender, const LLSD& content)
+    {
+        if (sUrgent.empty() && sNormal.empty())
+        {
+            gIdleCallbacks.addFunction(onIdle, NULL);
+        }
+        if (isUrgent(content["message"].asString()))
+        {
+            sUrgent.emplace_back(sender, content);
+        }
+        else
+        {
+            sNormal.emplace_back(sender, content);
+        }
+    }
+
+    //static
+    void LLEventPollDispatcher::onIdle(void*)
+    {
+        static LLCachedControl<F32> budget_ms(gSavedSettings, "EventPollDispatchBudgetMS", 0.f);
+        LLTimer timer;
+
+        while (!sUrgent.empty())
+        {
+            queued_message_t msg = sUrgent.front();
+            sUrgent.pop_front();
+            dispatchEventPollMessage(msg.first, msg.second);
+        }
+
+        // always make some progress, even if the frame is already over budget
+        F32 budget = llmax((F32)budget_ms, 0.f) * 0.001f;
+        do
+        {
+            if (sNormal.empty())
+            {
+                break;
+            }
+            queued_message_t msg = sNormal.front();
+            sNormal.pop_front();
+            dispatchEventPollMessage(msg.first, msg.second);
+        } while (timer.getElapsedTimeF32() < budget && sUrgent.empty());
+
+        if (sUrgent.empty() && sNormal.empty())
+        {
+            gIdleCallbacks.deleteFunction(onIdle, NULL);
+        }
+        else if (!sNormal.empty())
+        {
+            LL_DEBUGS("LLEventPollImpl") << sNormal.size() << " event queue messages deferred to next frame" << LL_ENDL;
+        }
+    }
+
     class LLEventPollImpl: public std::enable_shared_from_this<LLEventPollImpl>
     {
     public:
@@ -102,13 +209,7 @@ namespace Details
 
     void LLEventPollImpl::handleMessage(const LLSD& content)
     {
-        LL_PROFILE_ZONE_SCOPED_CATEGORY_APP;
-        std::string	msg_name = content["message"];
-        LLSD message;
-        message["sender"] = mSenderIp;
-        message["body"] = content["body"];
-
-        LLMessageSystem::dispatch(msg_name, message);
+        dispatchEventPollMessage(mSenderIp, content);
     }
 
     void LLEventPollImpl::start(const std::string &url)
@@ -282,7 +383,11 @@ namespace Details
             {
                 if (i->has("message"))
                 {
-                    if (main_queue)
+                    if (LLEventPollDispatcher::isEnabled())
+                    {
+                        LLEventPollDispatcher::queue(mSenderIp, *i);
+                    }
+                    else if (main_queue)
                     { // shuttle to a sensible spot in the main thread instead
                         // of wherever this coroutine happens to be executing
                         const LLSD& msg = *i;
@@ -500,6 +500,15 @@ void LLFace::updateCenterAgent()
 	}
 }
 
+void LLFace::updateCenterAgent(const LLMatrix4a& render_matrix)
+{
+	LLVector4a center;
+	center.load3(mCenterLocal.mV);
+	LLVector4a center_agent;
+	render_matrix.affineTransform(center, center_agent);
+	mCenterAgent.set(center_agent.getF32ptr());
+}
+
 void LLFace::renderSelected(LLViewerTexture *imagep, const LLColor4& color)
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_FACE
@@ -2047,6 +2056,23 @@ void LLFace::resetVirtualSize()
 	mImportanceToCamera = 0.f;
 }
 
+void LLFace::setVirtualSize(F32 size)
+{
+	if (LLViewerTextureList::getPriorityBucket(size) != LLViewerTextureList::getPriorityBucket(mVSize))
+	{
+		// changed enough on screen to move its textures' priorities
+		for (U32 ch = 0; ch < LLRender::NUM_TEXTURE_CHANNELS; ++ch)
+		{
+			LLViewerFetchedTexture* tex = LLViewerTextureManager::staticCastToFetchedTexture(mTexture[ch].get());
+			if (tex)
+			{
+				gTextureList.markPriorityDirty(tex, size);
+			}
+		}
+	}
+	mVSize = size;
+}
+
 F32 LLFace::getTextureVirtualSize()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
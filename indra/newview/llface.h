@@ -41,6 +41,7 @@
 #include "lldrawable.h"
 
 class LLFacePool;
+class LLMatrix4a;
 class LLVolume;
 class LLViewerTexture;
 class LLTextureEntry;
@@ -118,7 +119,7 @@ public:
 	void			setState(U32 state)			{ mState |= state; }
 	void			clearState(U32 state)		{ mState &= ~state; }
 	BOOL			isState(U32 state)	const	{ return ((mState & state) != 0) ? TRUE : FALSE; }
-	void			setVirtualSize(F32 size) { mVSize = size; }
+	void			setVirtualSize(F32 size);
 	void			setPixelArea(F32 area)	{ mPixelArea = area; }
 	F32				getVirtualSize() const { return mVSize; }
 	F32				getPixelArea() const { return mPixelArea; }
@@ -190,6 +191,7 @@ public:
 	void		update();
 
 	void		updateCenterAgent(); // Update center when xform has changed.
+	void		updateCenterAgent(const LLMatrix4a& render_matrix); // Same for an active drawable, with its render matrix already loaded
 	void		renderSelectedUV();
 
 	void		renderSelected(LLViewerTexture *image, const LLColor4 &color);
@@ -62,6 +62,7 @@ LLVolumeImplFlexible::LLVolumeImplFlexible(LLViewerObject* vo, LLFlexibleObjectD
 	mID = seed++;
 	mInitialized = FALSE;
 	mUpdated = FALSE;
+	mSimulated = false;
 	mInitializedRes = -1;
 	mSimulateRes = 0;
 	mCollisionSphereRadius = 0.f;
@@ -109,6 +110,45 @@ void LLVolumeImplFlexible::updateClass()
 	}
 }
 
+//static
+void LLVolumeImplFlexible::updateBatch()
+{
+	static LLCachedControl<bool> flex_batched(gSavedSettings, "RenderFlexBatched", false);
+	if (!flex_batched || sInstanceList.empty())
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED;
+
+	// only flexis doUpdateGeometry() will get to this frame and that
+	// doFlexibleUpdate() would simulate without initializing them first
+	std::vector<LLVolumeImplFlexible*> batch;
+	for (LLVolumeImplFlexible* flex : sInstanceList)
+	{
+		LLDrawable* drawablep = flex->mVO->mDrawable;
+		if (drawablep
+			&& !drawablep->isDead()
+			&& drawablep->isState(LLDrawable::IN_REBUILD_Q)
+			&& flex->mVO->getVolume()
+			&& flex->mAttributes
+			&& flex->mInitialized
+			&& flex->mSimulateRes != 0
+			&& flex->mRenderRes >= 0
+			&& !flex->mSimulated
+			&& !flex->isImpostorFrozen())
+		{
+			batch.push_back(flex);
+		}
+	}
+
+	gPipeline.runParallel((U32)batch.size(), [&batch](U32 i)
+		{
+			batch[i]->simulateSections();
+			batch[i]->mSimulated = true;
+		});
+}
+
 LLVector3 LLVolumeImplFlexible::getFramePosition() const
 {
 	return mVO->getRenderPosition();
@@ -457,6 +497,79 @@ void LLVolumeImplFlexible::doFlexibleUpdate()
 		return;
 	}
 	
+	if (mSimulated)
+	{
+		mSimulated = false;
+	}
+	else
+	{
+		simulateSections();
+	}
+
+	S32 i;
+
+	// Create points
+	llassert(mRenderRes > -1);
+	S32 num_render_sections = 1<<mRenderRes;
+	if (path->getPathLength() != num_render_sections+1)
+	{
+		((LLVOVolume*) mVO)->mVolumeChanged = TRUE;
+		volume->resizePath(num_render_sections+1);
+	}
+
+	LLPath::PathPt *new_point;
+
+	LLFlexibleObjectSection newSection[ (1<<FLEXIBLE_OBJECT_MAX_SECTIONS)+1 ];
+	remapSections(mSection, mSimulateRes, newSection, mRenderRes);
+
+	//generate transform from global to prim space
+	LLVector3 delta_scale = LLVector3(1,1,1);
+	LLVector3 delta_pos;
+	LLQuaternion delta_rot;
+
+	delta_rot = ~getFrameRotation();
+	delta_pos = -getFramePosition()*delta_rot;
+		
+	// Vertex transform (4x4)
+	LLVector3 x_axis = LLVector3(delta_scale.mV[VX], 0.f, 0.f) * delta_rot;
+	LLVector3 y_axis = LLVector3(0.f, delta_scale.mV[VY], 0.f) * delta_rot;
+	LLVector3 z_axis = LLVector3(0.f, 0.f, delta_scale.mV[VZ]) * delta_rot;
+
+	LLMatrix4 rel_xform;
+	rel_xform.initRows(LLVector4(x_axis, 0.f),
+								LLVector4(y_axis, 0.f),
+								LLVector4(z_axis, 0.f),
+								LLVector4(delta_pos, 1.f));
+			
+	LL_CHECK_MEMORY
+	for (i=0; i<=num_render_sections; ++i)
+	{
+		new_point = &path->mPath[i];
+		LLVector3 pos = newSection[i].mPosition * rel_xform;
+		LLQuaternion rot = mSection[i].mAxisRotation * newSection[i].mRotation * delta_rot;
+	
+		LLVector3 np(new_point->mPos.getF32ptr());
+
+		if (!mUpdated || (np-pos).magVec()/mVO->mDrawable->mDistanceWRTCamera > 0.001f)
+		{
+			new_point->mPos.load3((newSection[i].mPosition * rel_xform).mV);
+			mUpdated = FALSE;
+		}
+
+		new_point->mRot.loadu(LLMatrix3(rot));
+		new_point->mScale.set(newSection[i].mScale.mV[0], newSection[i].mScale.mV[1], 0,1);
+		new_point->mTexT = ((F32)i)/(num_render_sections);
+	}
+	LL_CHECK_MEMORY
+}
+
+//---------------------------------------------------------------------------------
+// Advances the sections by the time since the last step.  Only reads shared
+// state, so updateBatch() can run it for many flexis at once.
+//---------------------------------------------------------------------------------
+void LLVolumeImplFlexible::simulateSections()
+{
+    LL_PROFILE_ZONE_SCOPED;
 	S32 num_sections = 1 << mSimulateRes;
 
     F32 secondsThisFrame = mTimer.getElapsedTimeAndResetF32();
@@ -663,59 +776,6 @@ void LLVolumeImplFlexible::doFlexibleUpdate()
 	// i = NumSections
 	mSection[i].mdPosition = (mSection[i].mPosition - mSection[i-1].mPosition) * inv_section_length;
 
-	// Create points
-	llassert(mRenderRes > -1);
-	S32 num_render_sections = 1<<mRenderRes;
-	if (path->getPathLength() != num_render_sections+1)
-	{
-		((LLVOVolume*) mVO)->mVolumeChanged = TRUE;
-		volume->resizePath(num_render_sections+1);
-	}
-
-	LLPath::PathPt *new_point;
-
-	LLFlexibleObjectSection newSection[ (1<<FLEXIBLE_OBJECT_MAX_SECTIONS)+1 ];
-	remapSections(mSection, mSimulateRes, newSection, mRenderRes);
-
-	//generate transform from global to prim space
-	LLVector3 delta_scale = LLVector3(1,1,1);
-	LLVector3 delta_pos;
-	LLQuaternion delta_rot;
-
-	delta_rot = ~getFrameRotation();
-	delta_pos = -getFramePosition()*delta_rot;
-		
-	// Vertex transform (4x4)
-	LLVector3 x_axis = LLVector3(delta_scale.mV[VX], 0.f, 0.f) * delta_rot;
-	LLVector3 y_axis = LLVector3(0.f, delta_scale.mV[VY], 0.f) * delta_rot;
-	LLVector3 z_axis = LLVector3(0.f, 0.f, delta_scale.mV[VZ]) * delta_rot;
-
-	LLMatrix4 rel_xform;
-	rel_xform.initRows(LLVector4(x_axis, 0.f),
-								LLVector4(y_axis, 0.f),
-								LLVector4(z_axis, 0.f),
-								LLVector4(delta_pos, 1.f));
-			
-	LL_CHECK_MEMORY
-	for (i=0; i<=num_render_sections; ++i)
-	{
-		new_point = &path->mPath[i];
-		LLVector3 pos = newSection[i].mPosition * rel_xform;
-		LLQuaternion rot = mSection[i].mAxisRotation * newSection[i].mRotation * delta_rot;
-	
-		LLVector3 np(new_point->mPos.getF32ptr());
-
-		if (!mUpdated || (np-pos).magVec()/mVO->mDrawable->mDistanceWRTCamera > 0.001f)
-		{
-			new_point->mPos.load3((newSection[i].mPosition * rel_xform).mV);
-			mUpdated = FALSE;
-		}
-
-		new_point->mRot.loadu(LLMatrix3(rot));
-		new_point->mScale.set(newSection[i].mScale.mV[0], newSection[i].mScale.mV[1], 0,1);
-		new_point->mTexT = ((F32)i)/(num_render_sections);
-	}
-	LL_CHECK_MEMORY
 	mLastSegmentRotation = parentSegmentRotation;
 }
 
@@ -756,23 +816,9 @@ BOOL LLVolumeImplFlexible::doUpdateGeometry(LLDrawable *drawable)
     LL_PROFILE_ZONE_SCOPED;
 	LLVOVolume *volume = (LLVOVolume*)mVO;
 
-	if (mVO->isAttachment())
-	{	//don't update flexible attachments for impostored avatars unless the 
-		//impostor is being updated this frame (w00!)
-		LLViewerObject* parent = (LLViewerObject*) mVO->getParent();
-		while (parent && !parent->isAvatar())
-		{
-			parent = (LLViewerObject*) parent->getParent();
-		}
-		
-		if (parent)
-		{
-			LLVOAvatar* avatar = (LLVOAvatar*) parent;
-			if (avatar->isImpostor() && !avatar->needsImpostorUpdate())
-			{
-				return TRUE;
-			}
-		}
+	if (isImpostorFrozen())
+	{
+		return TRUE;
 	}
 
 	if (volume->mDrawable.isNull())
@@ -832,6 +878,29 @@ BOOL LLVolumeImplFlexible::doUpdateGeometry(LLDrawable *drawable)
 	return TRUE;
 }
 
+bool LLVolumeImplFlexible::isImpostorFrozen() const
+{
+	if (mVO->isAttachment())
+	{	//don't update flexible attachments for impostored avatars unless the 
+		//impostor is being updated this frame (w00!)
+		LLViewerObject* parent = (LLViewerObject*) mVO->getParent();
+		while (parent && !parent->isAvatar())
+		{
+			parent = (LLViewerObject*) parent->getParent();
+		}
+		
+		if (parent)
+		{
+			LLVOAvatar* avatar = (LLVOAvatar*) parent;
+			if (avatar->isImpostor() && !avatar->needsImpostorUpdate())
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 //----------------------------------------------------------------------------------
 void LLVolumeImplFlexible::setCollisionSphere( LLVector3 p, F32 r )
 {
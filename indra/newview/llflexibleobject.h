@@ -76,6 +76,10 @@ private:
 
 	public:
 		static void updateClass();
+		// Simulates every flexi waiting in the build queue together on the
+		// "Pipeline" thread pool.  Called by LLPipeline::updateGeom before the
+		// queue is processed; doFlexibleUpdate() then only has to lay out the path.
+		static void updateBatch();
 
 		LLVolumeImplFlexible(LLViewerObject* volume, LLFlexibleObjectData* attributes);
 		~LLVolumeImplFlexible();
@@ -127,6 +131,7 @@ private:
 		LLQuaternion				mLastSegmentRotation;
 		BOOL						mInitialized;
 		BOOL						mUpdated;
+		bool						mSimulated;	// sections already advanced by updateBatch()
 		LLFlexibleObjectData*		mAttributes;
 		LLFlexibleObjectSection		mSection	[ (1<<FLEXIBLE_OBJECT_MAX_SECTIONS)+1 ];
 		S32							mInitializedRes;
@@ -142,6 +147,8 @@ private:
 		// private methods
 		//--------------------------------------
 		void setAttributesOfAllSections	(LLVector3* inScale = NULL);
+		void simulateSections();
+		bool isImpostorFrozen() const;
 
 		void remapSections(LLFlexibleObjectSection *source, S32 source_sections,
 										 LLFlexibleObjectSection *dest, S32 dest_sections);
@@ -51,12 +51,18 @@ LLFloaterConversationPreview::LLFloaterConversationPreview(const LLSD& session_i
 	mMessages(NULL),
 	mHistoryThreadsBusy(false),
 	mIsGroup(false),
-	mOpened(false)
+	mOpened(false),
+	mPaged(false),
+	mMessageCount(0)
 {
 }
 
 LLFloaterConversationPreview::~LLFloaterConversationPreview()
 {
+	if (mPaged)
+	{
+		delete mMessages;
+	}
 }
 
 BOOL LLFloaterConversationPreview::postBuild()
@@ -148,6 +154,35 @@ void LLFloaterConversationPreview::onOpen(const LLSD& key)
 		closeFloater();
 		return;
 	}
+	mPageSpinner = getChild<LLSpinCtrl>("history_page_spin");
+	mPageSpinner->setCommitCallback(boost::bind(&LLFloaterConversationPreview::onMoreHistoryBtnClick, this));
+	mPageSpinner->setMinValue(1);
+	mPageSpinner->set(1);
+	mPageSpinner->setEnabled(false);
+
+	// An indexed transcript is read a page at a time, so only the last page
+	// is parsed up front.
+	std::vector<S64> offsets;
+	if (LLLogChat::loadHistoryIndex(LLLogChat::makeLogFileName(mChatHistoryFileName), offsets, false)
+		&& !offsets.empty())
+	{
+		mPaged = true;
+		mMessageCount = offsets.size();
+		mCurrentPage = (mMessageCount - 1) / mPageSize;
+
+		mPageSpinner->setEnabled(true);
+		mPageSpinner->setMaxValue(mCurrentPage+1);
+		mPageSpinner->set(mCurrentPage+1);
+
+		std::string total_page_num = llformat("/ %d", mCurrentPage+1);
+		getChild<LLTextBox>("page_num_label")->setValue(total_page_num);
+
+		loadPage();
+		mShowHistory = true;
+		return;
+	}
+	mPaged = false;
+
 	LLSD load_params;
 	load_params["load_all_history"] = true;
 	load_params["cut_off_todays_date"] = false;
@@ -161,11 +196,6 @@ void LLFloaterConversationPreview::onOpen(const LLSD& key)
 	LLSD loading;
 	loading[LL_IM_TEXT] = LLTrans::getString("loading_chat_logs");
 	mMessages->push_back(loading);
-	mPageSpinner = getChild<LLSpinCtrl>("history_page_spin");
-	mPageSpinner->setCommitCallback(boost::bind(&LLFloaterConversationPreview::onMoreHistoryBtnClick, this));
-	mPageSpinner->setMinValue(1);
-	mPageSpinner->set(1);
-	mPageSpinner->setEnabled(false);
 
 	// The actual message list to load from file
 	// Will be deleted in a separate thread LLDeleteHistoryThread not to freeze UI
@@ -189,7 +219,13 @@ void LLFloaterConversationPreview::onOpen(const LLSD& key)
 void LLFloaterConversationPreview::onClose(bool app_quitting)
 {
 	mOpened = false;
-	if (!mHistoryThreadsBusy)
+	if (mPaged)
+	{
+		LLMutexLock lock(&mMutex);
+		delete mMessages;
+		mMessages = NULL;
+	}
+	else if (!mHistoryThreadsBusy)
 	{
 		LLDeleteHistoryThread* deleteThread = LLLogChat::getInstance()->getDeleteHistoryThread(mSessionID);
 		if (deleteThread)
@@ -203,7 +239,8 @@ void LLFloaterConversationPreview::showHistory()
 {
 	// additional protection to avoid changes of mMessages in setPages
 	LLMutexLock lock(&mMutex);
-	if(mMessages == NULL || !mMessages->size() || mCurrentPage * mPageSize >= mMessages->size())
+	size_t first_message = mPaged ? 0 : mCurrentPage * mPageSize;
+	if(mMessages == NULL || !mMessages->size() || first_message >= mMessages->size())
 	{
 		return;
 	}
@@ -211,7 +248,7 @@ void LLFloaterConversationPreview::showHistory()
 	mChatHistory->clear();
 	std::ostringstream message;
 	std::list<LLSD>::const_iterator iter = mMessages->begin();
-	std::advance(iter, mCurrentPage * mPageSize);
+	std::advance(iter, first_message);
 
 	for (int msg_num = 0; iter != mMessages->end() && msg_num < mPageSize; ++iter, ++msg_num)
 	{
@@ -269,5 +306,25 @@ void LLFloaterConversationPreview::onMoreHistoryBtnClick()
 	}
 
 	mCurrentPage--;
+	if (mPaged)
+	{
+		loadPage();
+	}
 	mShowHistory = true;
 }
+
+void LLFloaterConversationPreview::loadPage()
+{
+	LLSD load_params;
+	load_params["first_message"] = mCurrentPage * mPageSize;
+	load_params["message_count"] = mPageSize;
+	load_params["cut_off_todays_date"] = false;
+	load_params["is_group"] = mIsGroup;
+
+	std::list<LLSD>* page = new std::list<LLSD>();
+	LLLogChat::loadChatHistory(mChatHistoryFileName, *page, load_params, mIsGroup);
+
+	LLMutexLock lock(&mMutex);
+	delete mMessages;
+	mMessages = page;
+}
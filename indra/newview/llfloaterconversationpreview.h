@@ -51,6 +51,8 @@ public:
 private:
 	void onMoreHistoryBtnClick();
 	void showHistory();
+	// Reads just the current page through the transcript's index.
+	void loadPage();
 
 	LLMutex			mMutex;
 	LLSpinCtrl*		mPageSpinner;
@@ -67,6 +69,8 @@ private:
 	bool			mHistoryThreadsBusy;
 	bool			mOpened;
 	bool			mIsGroup;
+	bool			mPaged;			// mMessages holds the current page only
+	int				mMessageCount;
 };
 
 #endif /* LLFLOATERCONVERSATIONPREVIEW_H_ */
@@ -33,6 +33,7 @@
 #include "llavatarrendernotifier.h"
 #include "llcheckboxctrl.h"
 #include "llcombobox.h"
+#include "lldir.h"
 #include "llfeaturemanager.h"
 #include "llfloaterpreference.h" // LLAvatarComplexityControls
 #include "llfloaterreg.h"
@@ -41,8 +42,11 @@
 #include "llperfstats.h"
 #include "llpresetsmanager.h"
 #include "llradiogroup.h"
+#include "llscrolllistctrl.h"
 #include "llsliderctrl.h"
+#include "llstallmonitor.h"
 #include "lltextbox.h"
+#include "lltexteditor.h"
 #include "lltrans.h"
 #include "llviewerobjectlist.h"
 #include "llviewerwindow.h"
@@ -99,18 +103,26 @@ BOOL LLFloaterPerformance::postBuild()
     mSettingsPanel = getChild<LLPanel>("panel_performance_preferences");
     mHUDsPanel = getChild<LLPanel>("panel_performance_huds");
     mAutoadjustmentsPanel = getChild<LLPanel>("panel_performance_autoadjustments");
+    mStallsPanel = getChild<LLPanel>("panel_performance_stalls");
 
     getChild<LLPanel>("nearby_subpanel")->setMouseDownCallback(boost::bind(&LLFloaterPerformance::showSelectedPanel, this, mNearbyPanel));
     getChild<LLPanel>("complexity_subpanel")->setMouseDownCallback(boost::bind(&LLFloaterPerformance::showSelectedPanel, this, mComplexityPanel));
     getChild<LLPanel>("settings_subpanel")->setMouseDownCallback(boost::bind(&LLFloaterPerformance::showSelectedPanel, this, mSettingsPanel));
     getChild<LLPanel>("huds_subpanel")->setMouseDownCallback(boost::bind(&LLFloaterPerformance::showSelectedPanel, this, mHUDsPanel));
     getChild<LLPanel>("autoadjustments_subpanel")->setMouseDownCallback(boost::bind(&LLFloaterPerformance::showSelectedPanel, this, mAutoadjustmentsPanel));
+    getChild<LLPanel>("stalls_subpanel")->setMouseDownCallback(boost::bind(&LLFloaterPerformance::showSelectedPanel, this, mStallsPanel));
 
     initBackBtn(mNearbyPanel);
     initBackBtn(mComplexityPanel);
     initBackBtn(mSettingsPanel);
     initBackBtn(mHUDsPanel);
     initBackBtn(mAutoadjustmentsPanel);
+    initBackBtn(mStallsPanel);
+
+    mStallList = mStallsPanel->getChild<LLScrollListCtrl>("stall_list");
+    mStallList->setCommitOnSelectionChange(true);
+    mStallList->setCommitCallback(boost::bind(&LLFloaterPerformance::onStallSelected, this));
+    mStallDetails = mStallsPanel->getChild<LLTextEditor>("stall_details");
 
     mHUDList = mHUDsPanel->getChild<LLNameListCtrl>("hud_list");
     mHUDList->setNameListType(LLNameListCtrl::SPECIAL);
@@ -175,6 +187,10 @@ void LLFloaterPerformance::showSelectedPanel(LLPanel* selected_panel)
     {
         populateObjectList();
     }
+    else if (mStallsPanel == selected_panel)
+    {
+        populateStallList();
+    }
 }
 
 void LLFloaterPerformance::showAutoadjustmentsPanel()
@@ -203,6 +219,10 @@ void LLFloaterPerformance::draw()
         {
             populateObjectList();
         }
+        else if (mStallsPanel->getVisible())
+        {
+            populateStallList();
+        }
 
         mUpdateTimer->setTimerExpirySec(REFRESH_INTERVAL);
     }
@@ -224,6 +244,7 @@ void LLFloaterPerformance::hidePanels()
     mHUDsPanel->setVisible(FALSE);
     mSettingsPanel->setVisible(FALSE);
     mAutoadjustmentsPanel->setVisible(FALSE);
+    mStallsPanel->setVisible(FALSE);
 }
 
 void LLFloaterPerformance::initBackBtn(LLPanel* panel)
@@ -235,6 +256,67 @@ void LLFloaterPerformance::initBackBtn(LLPanel* panel)
     panel->getChild<LLTextBox>("back_lbl")->setClickedCallback(boost::bind(&LLFloaterPerformance::showMainPanel, this));
 }
 
+void LLFloaterPerformance::populateStallList()
+{
+    static LLCachedControl<F32> threshold(gSavedSettings, "StallMonitorThreshold", 0.25f);
+    mStallsPanel->getChild<LLTextBox>("stalls_desc")->setTextArg("[THRESHOLD]", llformat("%.2f", (F32)threshold));
+
+    if (!LLStallMonitor::instanceExists())
+    {
+        return;
+    }
+    const std::deque<LLStallMonitor::Stall>& stalls = LLStallMonitor::instance().getStalls();
+    U32 last_frame = stalls.empty() ? 0 : stalls.back().getFrame().mNumber;
+    if (last_frame == mLastStallFrame && mStallList->getItemCount() > 0)
+    {
+        // nothing new, keep the selection and scroll position
+        return;
+    }
+    mLastStallFrame = last_frame;
+
+    LLSD selected = mStallList->getSelectedValue();
+    mStallList->deleteAllItems();
+    for (std::deque<LLStallMonitor::Stall>::const_reverse_iterator it = stalls.rbegin(); it != stalls.rend(); ++it)
+    {
+        const LLStallMonitor::Frame& frame = it->getFrame();
+        LLSD item;
+        item["value"] = (S32)frame.mNumber;
+        LLSD& row = item["columns"];
+        row[0]["column"] = "time";
+        row[0]["value"] = it->mTime.toHTTPDateString("%Y-%m-%d %H:%M:%S");
+        row[1]["column"] = "frame_time";
+        row[1]["value"] = llformat("%.1f", frame.mTotal * 1000.f);
+        row[2]["column"] = "slowest";
+        row[2]["value"] = LLStallMonitor::getSlowestPhase(frame);
+        row[3]["column"] = "trace";
+        row[3]["value"] = gDirUtilp->getBaseFileName(it->mTraceFile);
+        mStallList->addElement(item);
+    }
+    if (selected.isDefined())
+    {
+        mStallList->setSelectedByValue(selected, TRUE);
+    }
+    onStallSelected();
+}
+
+void LLFloaterPerformance::onStallSelected()
+{
+    LLSD selected = mStallList->getSelectedValue();
+    std::string details;
+    if (selected.isDefined() && LLStallMonitor::instanceExists())
+    {
+        for (const LLStallMonitor::Stall& stall : LLStallMonitor::instance().getStalls())
+        {
+            if ((S32)stall.getFrame().mNumber == selected.asInteger())
+            {
+                details = LLStallMonitor::describe(stall);
+                break;
+            }
+        }
+    }
+    mStallDetails->setText(details);
+}
+
 void LLFloaterPerformance::populateHUDList()
 {
     S32 prev_pos = mHUDList->getScrollPos();
@@ -245,6 +327,7 @@ void LLFloaterPerformance::populateHUDList()
     LLVOAvatar* avatar = gAgentAvatarp;
 
     gPipeline.profileAvatar(avatar, true);
+    avatar->calculateUpdateRenderComplexity(); // complexity tooltips come from its per object cache
 
     LLVOAvatar::attachment_map_t::iterator iter;
     LLVOAvatar::attachment_map_t::iterator begin = avatar->mAttachmentPoints.begin();
@@ -309,6 +392,14 @@ void LLFloaterPerformance::populateHUDList()
                 row[2]["value"] = attached_object->getAttachmentItemName();
                 row[2]["font"]["name"] = "SANSSERIF";
 
+                const LLVOAvatar::ObjectComplexity* complexity = avatar->getObjectComplexity(attached_object->getID());
+                if (complexity && complexity->mHasVolume)
+                {
+                    LLStringUtil::format_map_t args;
+                    args["[COMPLEXITY]"] = llformat("%u", complexity->mHUDComplexity.objectsCost + complexity->mHUDComplexity.texturesCost);
+                    row[2]["tool_tip"] = getString("complexity_tooltip", args);
+                }
+
                 LLScrollListItem* obj = mHUDList->addElement(item);
                 if (obj)
                 {
@@ -336,6 +427,7 @@ void LLFloaterPerformance::populateObjectList()
     LLVOAvatar* avatar = gAgentAvatarp;
 
     gPipeline.profileAvatar(avatar, true);
+    avatar->calculateUpdateRenderComplexity(); // complexity tooltips come from its per object cache
 
     LLVOAvatar::attachment_map_t::iterator iter;
     LLVOAvatar::attachment_map_t::iterator begin = avatar->mAttachmentPoints.begin();
@@ -400,6 +492,14 @@ void LLFloaterPerformance::populateObjectList()
                     row[2]["value"] = attached_object->getAttachmentItemName();
                     row[2]["font"]["name"] = "SANSSERIF";
 
+                    const LLVOAvatar::ObjectComplexity* complexity = avatar->getObjectComplexity(attached_object->getID());
+                    if (complexity && complexity->mHasVolume)
+                    {
+                        LLStringUtil::format_map_t args;
+                        args["[COMPLEXITY]"] = llformat("%.f", complexity->mCost);
+                        row[2]["tool_tip"] = getString("complexity_tooltip", args);
+                    }
+
                     LLScrollListItem* obj = mObjectList->addElement(item);
                     if (obj)
                     {
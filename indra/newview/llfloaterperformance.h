@@ -31,6 +31,8 @@
 
 class LLCharacter;
 class LLNameListCtrl;
+class LLScrollListCtrl;
+class LLTextEditor;
 
 class LLFloaterPerformance : public LLFloater
 {
@@ -58,6 +60,8 @@ private:
     void populateHUDList();
     void populateObjectList();
     void populateNearbyList();
+    void populateStallList();
+    void onStallSelected();
     void setFPSText();
 
     void onClickAdvanced();
@@ -83,9 +87,12 @@ private:
     LLPanel* mHUDsPanel;
     LLPanel* mSettingsPanel;
     LLPanel* mAutoadjustmentsPanel;
+    LLPanel* mStallsPanel;
     LLNameListCtrl* mHUDList;
     LLNameListCtrl* mObjectList;
     LLNameListCtrl* mNearbyList;
+    LLScrollListCtrl* mStallList;
+    LLTextEditor* mStallDetails;
 
     LLButton* mStartAutotuneBtn;
     LLButton* mStopAutotuneBtn;
@@ -98,6 +105,9 @@ private:
     // -1.f if no profile has happened yet
     F32 mNearbyMaxGPUTime = -1.f;
 
+    // frame number of the newest stall in mStallList
+    U32 mLastStallFrame = 0;
+
     boost::signals2::connection	mMaxARTChangedSignal;
 };
 
@@ -100,6 +100,8 @@ BOOL LLFloaterTopObjects::postBuild()
     mObjectsScrollList->setDoubleClickCallback(onDoubleClickObjectsList, this);
     mObjectsScrollList->setCommitOnSelectionChange(TRUE);
     mObjectsScrollList->setCommitCallback(boost::bind(&LLFloaterTopObjects::onSelectionChanged, this));
+    // Reports can run to thousands of objects, only build the rows we show
+    mObjectsScrollList->setRowProvider(boost::bind(&LLFloaterTopObjects::getObjectListRow, this, _1));
 
 	setDefaultBtn("show_beacon_btn");
 
@@ -248,10 +250,16 @@ void LLFloaterTopObjects::handleReply(LLMessageSystem *msg, void** data)
 			columns[column_num++]["font"] = "SANSSERIF";
 		}
 		element["columns"] = columns;
-		list->addElement(element);
-		
+
+		LLSD sort_keys;
+		for (LLSD::array_const_iterator it = columns.beginArray(); it != columns.endArray(); ++it)
+		{
+			sort_keys[(*it)["column"].asString()] = (*it)["value"];
+		}
+		mObjectListIndex[task_id] = mObjectListData.size();
 		mObjectListData.append(element);
 		mObjectListIDs.push_back(task_id);
+		list->addVirtualRow(task_id, sort_keys);
 
 		mtotalScore += score;
 	}
@@ -413,6 +421,12 @@ void LLFloaterTopObjects::onReturnSelected()
 }
 
 
+LLSD LLFloaterTopObjects::getObjectListRow(const LLSD& value) const
+{
+	std::map<LLUUID, S32>::const_iterator found = mObjectListIndex.find(value.asUUID());
+	return (found != mObjectListIndex.end()) ? mObjectListData[found->second] : LLSD();
+}
+
 void LLFloaterTopObjects::clearList()
 {
 	LLCtrlListInterface *list = childGetListInterface("objects_list");
@@ -424,6 +438,7 @@ void LLFloaterTopObjects::clearList()
 
 	mObjectListData.clear();
 	mObjectListIDs.clear();
+	mObjectListIndex.clear();
 	mtotalScore = 0.f;
 
     onSelectionChanged();
@@ -74,6 +74,7 @@ private:
 	~LLFloaterTopObjects();
 
 	void initColumns(LLCtrlListInterface *list);
+	LLSD getObjectListRow(const LLSD& value) const;
 
 	void onCommitObjectsList();
     void onSelectionChanged();
@@ -99,6 +100,7 @@ private:
 
 	LLSD mObjectListData;
 	uuid_vec_t mObjectListIDs;
+	std::map<LLUUID, S32> mObjectListIndex; // task id => index in mObjectListData
 
 	U32 mCurrentMode;
 	U32 mFlags;
@@ -0,0 +1,180 @@
+/**
+ * @file llframepacer.cpp
+ * @brief Frame rate limiting ahead of input and a cap on GPU frames in flight
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llframepacer.h"
+
+#include "lltimer.h"
+#include "llviewercontrol.h"
+#include "llviewerstats.h"
+
+#include <thread>
+
+// sleep to within this much of the deadline, then yield until it
+static const U64 SPIN_MICROSECONDS = 1500;
+// don't wait forever on a GPU that is hung or lost
+static const GLuint64 MAX_WAIT_NANOSECONDS = 100000000;
+
+LLFramePacer::Frame LLFramePacer::sFrames[LLFramePacer::MAX_FRAMES];
+U32 LLFramePacer::sOldest = 0;
+U32 LLFramePacer::sInFlight = 0;
+U64 LLFramePacer::sNextFrameTime = 0;
+U64 LLFramePacer::sInputTime = 0;
+
+// static
+void LLFramePacer::beginFrame()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_APP;
+	static LLCachedControl<F32> max_fps(gSavedSettings, "MaxFPS", -1.f);
+
+	U64 now = totalTime();
+	if (max_fps > 0.f && !gNonInteractive)
+	{
+		U64 interval = (U64)(1000000.f / llmax((F32)max_fps, 1.f));
+		if (sNextFrameTime > now + interval)
+		{
+			// clock jumped or the setting changed, start over
+			sNextFrameTime = now;
+		}
+		if (sNextFrameTime > now)
+		{
+			LL_PROFILE_ZONE_NAMED_CATEGORY_APP("Frame Pacing Sleep");
+			if (sNextFrameTime - now > SPIN_MICROSECONDS)
+			{
+				ms_sleep((U32)((sNextFrameTime - now - SPIN_MICROSECONDS) / 1000));
+			}
+			while ((now = totalTime()) < sNextFrameTime)
+			{
+				std::this_thread::yield();
+			}
+		}
+		// keep to the schedule, but don't try to catch up on frames that ran long
+		sNextFrameTime = llmax(sNextFrameTime + interval, now);
+	}
+	else
+	{
+		sNextFrameTime = 0;
+	}
+	sInputTime = now;
+}
+
+// static
+void LLFramePacer::endFrame()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_APP;
+	static LLCachedControl<U32> max_in_flight(gSavedSettings, "RenderMaxFramesInFlight", 0);
+
+	if (!gGLManager.mInited)
+	{
+		return;
+	}
+
+	// pick up every frame the GPU has finished since the last swap
+	while (sInFlight > 0 && sFrames[sOldest].mFence.isCompleted())
+	{
+		retire(sFrames[sOldest]);
+	}
+
+	if (sInFlight == MAX_FRAMES)
+	{
+		// nowhere to put this frame, which only happens with a GPU that is
+		// MAX_FRAMES behind, so waiting on it costs nothing extra
+		glClientWaitSync(sFrames[sOldest].mFence.mSync, GL_SYNC_FLUSH_COMMANDS_BIT, MAX_WAIT_NANOSECONDS);
+		retire(sFrames[sOldest]);
+	}
+
+	Frame& frame = sFrames[(sOldest + sInFlight) % MAX_FRAMES];
+	if (!frame.mQuery)
+	{
+		glGenQueries(1, &frame.mQuery);
+	}
+	glQueryCounter(frame.mQuery, GL_TIMESTAMP);
+	glGetInteger64v(GL_TIMESTAMP, &frame.mGPUSubmitTime);
+	frame.mSubmitTime = totalTime();
+	frame.mInputTime = sInputTime;
+	frame.mFence.placeFence();
+	++sInFlight;
+
+	if (max_in_flight > 0)
+	{
+		LL_PROFILE_ZONE_NAMED_CATEGORY_APP("Wait For GPU");
+		// at 1 the CPU gets at most one frame ahead of the GPU
+		while (sInFlight > max_in_flight)
+		{
+			glClientWaitSync(sFrames[sOldest].mFence.mSync, GL_SYNC_FLUSH_COMMANDS_BIT, MAX_WAIT_NANOSECONDS);
+			retire(sFrames[sOldest]);
+		}
+	}
+}
+
+// static
+void LLFramePacer::retire(Frame& frame)
+{
+	// not there if a wait timed out, and reading it would block
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuiv(frame.mQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available)
+	{
+		GLuint64 gpu_done = 0;
+		glGetQueryObjectui64v(frame.mQuery, GL_QUERY_RESULT, &gpu_done);
+		// CPU time from input to the swap, plus GPU time from the swap call
+		// reaching the GPU to the GPU getting through it
+		F64 latency_us = (F64)(frame.mSubmitTime - frame.mInputTime);
+		if (gpu_done > (GLuint64)frame.mGPUSubmitTime)
+		{
+			latency_us += (F64)(gpu_done - (GLuint64)frame.mGPUSubmitTime) / 1000.0;
+		}
+		sample(LLStatViewer::INPUT_LATENCY, F64Milliseconds(latency_us / 1000.0));
+	}
+	if (frame.mFence.mSync)
+	{
+		glDeleteSync(frame.mFence.mSync);
+		frame.mFence.mSync = 0;
+	}
+	sOldest = (sOldest + 1) % MAX_FRAMES;
+	--sInFlight;
+}
+
+// static
+void LLFramePacer::destroyGL()
+{
+	for (U32 i = 0; i < MAX_FRAMES; ++i)
+	{
+		Frame& frame = sFrames[i];
+		if (frame.mFence.mSync)
+		{
+			glDeleteSync(frame.mFence.mSync);
+			frame.mFence.mSync = 0;
+		}
+		if (frame.mQuery)
+		{
+			glDeleteQueries(1, &frame.mQuery);
+			frame.mQuery = 0;
+		}
+		}
+	sOldest = 0;
+	sInFlight = 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file llframepacer.h
+ * @brief Frame rate limiting ahead of input and a cap on GPU frames in flight
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMEPACER_H
+#define LL_LLFRAMEPACER_H
+
+#include "llgl.h"
+
+// Paces frames so that input is sampled as late as possible before it is
+// rendered.  With MaxFPS set, the time left over from the previous frame is
+// slept at the start of the next one, before the window events are gathered,
+// instead of after the swap where it would only age the input of the coming
+// frame.  A fence is placed after every swap; with RenderMaxFramesInFlight set,
+// the CPU waits for the GPU before running further ahead than that many
+// frames, so the driver can't queue up frames of stale camera.  The time from
+// gathering input to the GPU finishing the frame is reported as the
+// "inputlatency" stat.
+// Main thread only.
+class LLFramePacer
+{
+public:
+	// Top of the frame, before processing window events and input.
+	static void beginFrame();
+	// Right after the swap.
+	static void endFrame();
+
+	static void destroyGL();
+
+private:
+	static const U32 MAX_FRAMES = 4;
+
+	struct Frame
+	{
+		LLGLSyncFence mFence;
+		GLuint mQuery = 0;
+		U64 mInputTime = 0;		// microseconds, when input was gathered
+		U64 mSubmitTime = 0;		// microseconds, after the swap
+		GLint64 mGPUSubmitTime = 0;	// nanoseconds, GPU clock at mSubmitTime
+	};
+
+	// sample the latency of a frame the GPU has finished and free its slot
+	static void retire(Frame& frame);
+
+	static Frame sFrames[MAX_FRAMES];
+	static U32 sOldest;
+	static U32 sInFlight;
+	static U64 sNextFrameTime;
+	static U64 sInputTime;
+};
+
+#endif // LL_LLFRAMEPACER_H
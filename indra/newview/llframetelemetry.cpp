@@ -0,0 +1,319 @@
+/**
+ * @file llframetelemetry.cpp
+ * @brief Per-frame CPU phase and GPU pass timings kept for export.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llframetelemetry.h"
+
+#include "llframetimer.h"
+#include "llimagegl.h"
+#include "llrendertarget.h"
+#include "llvertexbuffer.h"
+#include "llviewercontrol.h"
+
+#include <iomanip>
+
+bool LLFrameTelemetry::sEnabled = false;
+U32 LLFrameTelemetry::sTriangles = 0;
+
+static const char* PASS_NAMES[LLFrameTelemetry::PASS_COUNT] =
+{
+	"shadow",
+	"geometry",
+	"lighting",
+	"alpha",
+	"post",
+	"ui"
+};
+
+LLFrameTelemetry::LLFrameTelemetry()
+:	mCurrentSet(0),
+	mFrames(1)
+{
+	memset(mQuerySets, 0, sizeof(mQuerySets));
+}
+
+//static
+const char* LLFrameTelemetry::getPassName(EPass pass)
+{
+	return PASS_NAMES[pass];
+}
+
+LLFrameTelemetry::QuerySet* LLFrameTelemetry::currentSet()
+{
+	QuerySet* set = &mQuerySets[mCurrentSet];
+	if (!set->mOpen)
+	{
+		if (set->mPending)
+		{ // GPU is too far behind, leave this frame untimed rather than wait
+			return nullptr;
+		}
+		if (!set->mQueries[0])
+		{
+			glGenQueries(PASS_COUNT + 1, set->mQueries);
+		}
+		memset(set->mMarked, 0, sizeof(set->mMarked));
+		set->mFrame = LLFrameTimer::getFrameCount();
+		set->mOpen = true;
+	}
+	return set;
+}
+
+//static
+void LLFrameTelemetry::markPass(EPass pass)
+{
+	if (!sEnabled || !instanceExists())
+	{
+		return;
+	}
+
+	QuerySet* set = instance().currentSet();
+	if (set && !set->mMarked[pass])
+	{
+		glQueryCounter(set->mQueries[pass], GL_TIMESTAMP);
+		set->mMarked[pass] = true;
+	}
+}
+
+//static
+void LLFrameTelemetry::endPasses()
+{
+	if (!instanceExists())
+	{
+		return;
+	}
+
+	LLFrameTelemetry& self = instance();
+	QuerySet& set = self.mQuerySets[self.mCurrentSet];
+	if (set.mOpen)
+	{
+		glQueryCounter(set.mQueries[PASS_COUNT], GL_TIMESTAMP);
+		set.mOpen = false;
+		set.mPending = true;
+		self.mCurrentSet = (self.mCurrentSet + 1) % NUM_QUERY_SETS;
+	}
+}
+
+void LLFrameTelemetry::readQueries()
+{
+	for (U32 i = 0; i < NUM_QUERY_SETS; ++i)
+	{
+		QuerySet& set = mQuerySets[i];
+		if (!set.mPending)
+		{
+			continue;
+		}
+
+		// the end timestamp is written last
+		GLuint available = 0;
+		glGetQueryObjectuiv(set.mQueries[PASS_COUNT], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			continue;
+		}
+		set.mPending = false;
+
+		GLuint64 stamps[PASS_COUNT + 1];
+		for (S32 pass = 0; pass <= PASS_COUNT; ++pass)
+		{
+			stamps[pass] = 0;
+			if (pass == PASS_COUNT || set.mMarked[pass])
+			{
+				glGetQueryObjectui64v(set.mQueries[pass], GL_QUERY_RESULT, &stamps[pass]);
+			}
+		}
+
+		for (Frame& frame : mFrames)
+		{
+			if (frame.mNumber != set.mFrame)
+			{
+				continue;
+			}
+
+			for (S32 pass = 0; pass < PASS_COUNT; ++pass)
+			{
+				if (!set.mMarked[pass])
+				{
+					continue;
+				}
+				// runs until the next pass that was marked
+				S32 next = pass + 1;
+				while (next < PASS_COUNT && !set.mMarked[next])
+				{
+					++next;
+				}
+				frame.mGPU[pass] = (F32)(stamps[next] - stamps[pass]) / 1000000.f;
+			}
+			break;
+		}
+	}
+}
+
+void LLFrameTelemetry::endFrame()
+{
+	static LLCachedControl<bool> enabled(gSavedSettings, "FrameTelemetryEnabled", false);
+	static LLCachedControl<U32> max_frames(gSavedSettings, "FrameTelemetryFrames", 1000);
+	static LLCachedControl<F32> export_interval(gSavedSettings, "FrameTelemetryExportInterval", 0.f);
+
+	// a frame that was drawn without a swap (snapshots) still gets closed
+	endPasses();
+
+	U32 draw_calls = LLVertexBuffer::sDrawCount;
+	U32 triangles = sTriangles;
+	LLVertexBuffer::sDrawCount = 0;
+	sTriangles = 0;
+
+	sEnabled = enabled;
+	if (!sEnabled)
+	{
+		return;
+	}
+
+	if (mFrames.capacity() != llmax((U32)max_frames, 1U))
+	{
+		mFrames.set_capacity(llmax((U32)max_frames, 1U));
+	}
+
+	const LLStallMonitor::Frame& cpu = LLStallMonitor::instance().getLastFrame();
+
+	Frame frame;
+	frame.mNumber = cpu.mNumber;
+	frame.mTotal = cpu.mTotal * 1000.f;
+	for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+	{
+		frame.mCPU[i] = cpu.mPhases[i] * 1000.f;
+	}
+	for (S32 i = 0; i < PASS_COUNT; ++i)
+	{
+		frame.mGPU[i] = -1.f;
+	}
+	frame.mDrawCalls = draw_calls;
+	frame.mTriangles = triangles;
+	frame.mGPUMemory = (F32)(LLImageGL::getTextureBytesAllocated() + LLVertexBuffer::getBytesAllocated() + LLRenderTarget::sBytesAllocated) / (1024.f * 1024.f);
+	mFrames.push_back(frame);
+
+	readQueries();
+
+	if (export_interval > 0.f && mExportTimer.getElapsedTimeF32() > export_interval)
+	{
+		exportToLogs();
+		mExportTimer.reset();
+	}
+}
+
+void LLFrameTelemetry::destroyGL()
+{
+	for (U32 i = 0; i < NUM_QUERY_SETS; ++i)
+	{
+		if (mQuerySets[i].mQueries[0])
+		{
+			glDeleteQueries(PASS_COUNT + 1, mQuerySets[i].mQueries);
+		}
+	}
+	memset(mQuerySets, 0, sizeof(mQuerySets));
+	mCurrentSet = 0;
+}
+
+bool LLFrameTelemetry::exportFrames(const std::string& csv_file, const std::string& json_file) const
+{
+	llofstream csv(csv_file.c_str());
+	llofstream json(json_file.c_str());
+	if (!csv.is_open() || !json.is_open())
+	{
+		LL_WARNS() << "Unable to write frame telemetry to " << csv_file << " or " << json_file << LL_ENDL;
+		return false;
+	}
+
+	csv << std::fixed << std::setprecision(3);
+	json << std::fixed << std::setprecision(3);
+
+	csv << "frame,total_ms";
+	for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+	{
+		csv << ",cpu_" << LLStallMonitor::getPhaseName((LLStallMonitor::EPhase)i) << "_ms";
+	}
+	for (S32 i = 0; i < PASS_COUNT; ++i)
+	{
+		csv << ",gpu_" << PASS_NAMES[i] << "_ms";
+	}
+	csv << ",draw_calls,triangles,gpu_memory_mb\n";
+
+	json << "[\n";
+	bool first = true;
+	for (const Frame& frame : mFrames)
+	{
+		csv << frame.mNumber << "," << frame.mTotal;
+		for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+		{
+			csv << "," << frame.mCPU[i];
+		}
+		for (S32 i = 0; i < PASS_COUNT; ++i)
+		{
+			csv << ",";
+			if (frame.mGPU[i] >= 0.f)
+			{
+				csv << frame.mGPU[i];
+			}
+		}
+		csv << "," << frame.mDrawCalls << "," << frame.mTriangles << "," << frame.mGPUMemory << "\n";
+
+		json << (first ? "" : ",\n") << "{\"frame\":" << frame.mNumber << ",\"total_ms\":" << frame.mTotal << ",\"cpu_ms\":{";
+		for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+		{
+			json << (i ? "," : "") << "\"" << LLStallMonitor::getPhaseName((LLStallMonitor::EPhase)i) << "\":" << frame.mCPU[i];
+		}
+		json << "},\"gpu_ms\":{";
+		bool first_pass = true;
+		for (S32 i = 0; i < PASS_COUNT; ++i)
+		{
+			if (frame.mGPU[i] >= 0.f)
+			{
+				json << (first_pass ? "" : ",") << "\"" << PASS_NAMES[i] << "\":" << frame.mGPU[i];
+				first_pass = false;
+			}
+		}
+		json << "},\"draw_calls\":" << frame.mDrawCalls << ",\"triangles\":" << frame.mTriangles
+			 << ",\"gpu_memory_mb\":" << frame.mGPUMemory << "}";
+		first = false;
+	}
+	json << "\n]\n";
+
+	return true;
+}
+
+void LLFrameTelemetry::exportToLogs() const
+{
+	if (mFrames.empty())
+	{
+		return;
+	}
+
+	std::string csv_file = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "frame_telemetry.csv");
+	std::string json_file = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "frame_telemetry.json");
+	if (exportFrames(csv_file, json_file))
+	{
+		LL_INFOS() << "Saved " << mFrames.size() << " frames of telemetry to " << csv_file << LL_ENDL;
+	}
+}
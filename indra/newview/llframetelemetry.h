@@ -0,0 +1,118 @@
+/**
+ * @file llframetelemetry.h
+ * @brief Per-frame CPU phase and GPU pass timings kept for export.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMETELEMETRY_H
+#define LL_LLFRAMETELEMETRY_H
+
+#include "llsingleton.h"
+#include "llstallmonitor.h"
+#include "lltimer.h"
+
+#include <boost/circular_buffer.hpp>
+
+// Keeps one record per frame for the last FrameTelemetryFrames frames: the
+// LLStallMonitor CPU phases, GPU time of each render pass from timestamp
+// queries, draw calls, triangles and GPU memory. Records are written out as
+// CSV and JSON to the logs folder every FrameTelemetryExportInterval seconds,
+// when FrameTelemetryExport is set, and on exit.
+// Main thread only, and does nothing unless FrameTelemetryEnabled is set.
+class LLFrameTelemetry : public LLSimpleton<LLFrameTelemetry>
+{
+	LOG_CLASS(LLFrameTelemetry);
+public:
+	// in the order they are drawn, each pass runs until the next one marked
+	enum EPass
+	{
+		PASS_SHADOW,
+		PASS_GEOMETRY,
+		PASS_LIGHTING,
+		PASS_ALPHA,
+		PASS_POST,
+		PASS_UI,
+		PASS_COUNT
+	};
+
+	struct Frame
+	{
+		U32 mNumber;
+		F32 mTotal;									// milliseconds
+		F32 mCPU[LLStallMonitor::PHASE_COUNT];		// milliseconds
+		F32 mGPU[PASS_COUNT];						// milliseconds, < 0 if not timed (yet)
+		U32 mDrawCalls;
+		U32 mTriangles;
+		F32 mGPUMemory;								// MB in textures, vertex buffers and render targets
+	};
+
+	LLFrameTelemetry();
+
+	// Start timing a render pass on the GPU, ending the previous one.
+	// Cheap no-op when telemetry is off.
+	static void markPass(EPass pass);
+	// after the last pass of the frame, before the swap
+	static void endPasses();
+
+	static void addTriangles(U32 count) { sTriangles += count; }
+
+	// Record the frame LLStallMonitor just closed.
+	void endFrame();
+
+	// free the queries, pending GPU times are lost
+	void destroyGL();
+
+	// oldest first; GPU times of the newest few frames are still in flight
+	const boost::circular_buffer<Frame>& getFrames() const { return mFrames; }
+	static const char* getPassName(EPass pass);
+
+	bool exportFrames(const std::string& csv_file, const std::string& json_file) const;
+	// both files into the logs folder
+	void exportToLogs() const;
+
+private:
+	static const U32 NUM_QUERY_SETS = 4;
+
+	// timestamps of one frame's passes, read back a few frames later
+	struct QuerySet
+	{
+		U32 mQueries[PASS_COUNT + 1];	// the last one is the end of the frame
+		bool mMarked[PASS_COUNT];
+		U32 mFrame;
+		bool mOpen;
+		bool mPending;
+	};
+
+	QuerySet* currentSet();
+	void readQueries();
+
+	static bool sEnabled;
+	static U32 sTriangles;
+
+	QuerySet mQuerySets[NUM_QUERY_SETS];
+	U32 mCurrentSet;
+	boost::circular_buffer<Frame> mFrames;
+	LLTimer mExportTimer;
+};
+
+#endif // LL_LLFRAMETELEMETRY_H
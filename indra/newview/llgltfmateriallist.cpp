@@ -32,6 +32,7 @@
 #include "lldispatcher.h"
 #include "llfetchedgltfmaterial.h"
 #include "llfilesystem.h"
+#include "lllocalgltfmaterials.h"
 #include "llsdserialize.h"
 #include "lltinygltfhelper.h"
 #include "llviewercontrol.h"
@@ -201,7 +202,6 @@ void LLGLTFMaterialList::applyOverrideMessage(LLMessageSystem* msg, const std::s
         const LLSD& od = data["od"];
 
         constexpr U32 MAX_TES = 45;
-        bool has_te[MAX_TES] = { false };
 
         if (tes.isArray()) // NOTE: if no "te" array exists, this is a malformed message (null out all overrides will come in as an empty te array)
         { 
@@ -210,45 +210,120 @@ void LLGLTFMaterialList::applyOverrideMessage(LLMessageSystem* msg, const std::s
             cache.mObjectId = id;
             cache.mRegionHandle = region->getHandle();
 
+            // replaces any override of this object still waiting from earlier this frame
+            side_override_map_t* pending = obj ? &mPendingOverrides[id] : nullptr;
+            if (pending)
+            {
+                pending->clear();
+            }
+
             U32 count = llmin(tes.size(), MAX_TES);
             for (U32 i = 0; i < count; ++i)
             {
-                LLGLTFMaterial* mat = new LLGLTFMaterial(); // setTEGLTFMaterialOverride and cache will take ownership
-                mat->applyOverrideLLSD(od[i]);
-
                 S32 te = tes[i].asInteger();
+                if (te < 0 || te >= (S32)MAX_TES)
+                {
+                    continue;
+                }
+
+                LLPointer<LLGLTFMaterial> mat = new LLGLTFMaterial(); // setTEGLTFMaterialOverride and cache will share ownership
+                mat->applyOverrideLLSD(od[i]);
+                // faces with an equal override share it, so an unchanged override is a pointer compare in setTEGLTFMaterialOverride
+                mat = LLGLTFMaterial::shareOverride(mat);
 
-                has_te[te] = true;
                 cache.mSides[te] = od[i];
                 cache.mGLTFMaterial[te] = mat;
 
-                if (obj)
+                if (pending)
                 {
-                    obj->setTEGLTFMaterialOverride(te, mat);
-                    if (obj->getTE(te) && obj->getTE(te)->isSelected())
-                    {
-                        handle_gltf_override_message.doSelectionCallbacks(id, te);
-                    }
+                    (*pending)[te] = mat;
                 }
             }
 
-            if (obj)
-            { // null out overrides on TEs that shouldn't have them
-                U32 count = llmin(obj->getNumTEs(), MAX_TES);
-                for (U32 i = 0; i < count; ++i)
-                {
-                    LLTextureEntry* te = obj->getTE(i);
-                    if (!has_te[i] && te && te->getGLTFMaterialOverride())
-                    {
-                        obj->setTEGLTFMaterialOverride(i, nullptr);
-                        handle_gltf_override_message.doSelectionCallbacks(id, i);
-                    }
-                }
+            region->cacheFullUpdateGLTFOverride(cache);
+        }
+
+    }
+}
+
+void LLGLTFMaterialList::applyPendingOverrides()
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    constexpr U32 MAX_TES = 45;
+
+    for (pending_override_map_t::value_type& pending : mPendingOverrides)
+    {
+        const LLUUID& id = pending.first;
+        LLViewerObject* obj = gObjectList.findObject(id);
+        if (!obj || obj->isDead())
+        {
+            continue;
+        }
+
+        for (side_override_map_t::value_type& side : pending.second)
+        {
+            S32 te = side.first;
+            obj->setTEGLTFMaterialOverride(te, side.second);
+            if (obj->getTE(te) && obj->getTE(te)->isSelected())
+            {
+                handle_gltf_override_message.doSelectionCallbacks(id, te);
             }
+        }
 
-            region->cacheFullUpdateGLTFOverride(cache);
+        // null out overrides on TEs that shouldn't have them
+        U32 count = llmin(obj->getNumTEs(), MAX_TES);
+        for (U32 i = 0; i < count; ++i)
+        {
+            LLTextureEntry* te = obj->getTE(i);
+            if (te && te->getGLTFMaterialOverride() && !pending.second.count(i))
+            {
+                obj->setTEGLTFMaterialOverride(i, nullptr);
+                handle_gltf_override_message.doSelectionCallbacks(id, i);
+            }
         }
+    }
+
+    mPendingOverrides.clear();
+}
 
+LLPointer<LLFetchedGLTFMaterial> LLGLTFMaterialList::getRenderMaterial(LLFetchedGLTFMaterial* base, LLGLTFMaterial* override_mat)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    // local textures and local materials are edited in place per face, don't share those
+    if (override_mat->hasLocalTextures() || base->hasLocalTextures() || dynamic_cast<LLLocalGLTFMaterial*>(base))
+    {
+        LLPointer<LLFetchedGLTFMaterial> render_mat = new LLFetchedGLTFMaterial(*base);
+        render_mat->applyOverride(*override_mat);
+        return render_mat;
+    }
+
+    RenderMaterialEntry& entry = mRenderMaterials[render_material_key_t(base, override_mat)];
+    if (entry.mRender.isNull())
+    {
+        entry.mBase = base;
+        entry.mOverride = override_mat;
+        entry.mRender = new LLFetchedGLTFMaterial(*base);
+        entry.mRender->applyOverride(*override_mat);
+    }
+    return entry.mRender;
+}
+
+void LLGLTFMaterialList::purgeRenderMaterials()
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    for (render_material_map_t::iterator iter = mRenderMaterials.begin(); iter != mRenderMaterials.end(); )
+    {
+        if (iter->second.mRender->getNumRefs() == 1)
+        {
+            iter = mRenderMaterials.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
     }
 }
 
@@ -610,6 +685,15 @@ void LLGLTFMaterialList::flushMaterials()
     const F64 MAX_INACTIVE_TIME = 30.f;
     F64 cur_time = LLTimer::getTotalSeconds();
 
+    // shared render materials hold their base materials, let go of the
+    // unused ones before checking which base materials are unused
+    const F64 RENDER_MATERIAL_PURGE_PERIOD = 10.f;
+    if (cur_time > mNextRenderMaterialPurge)
+    {
+        purgeRenderMaterials();
+        mNextRenderMaterialPurge = cur_time + RENDER_MATERIAL_PURGE_PERIOD;
+    }
+
     // advance iter one past the last key we updated
     uuid_mat_map_t::iterator iter = mList.find(mLastUpdateKey);
     if (iter != mList.end()) {
@@ -32,6 +32,7 @@
 #include "llgltfmaterial.h"
 #include "llpointer.h"
 
+#include <boost/functional/hash.hpp>
 #include <unordered_map>
 
 class LLFetchedGLTFMaterial;
@@ -98,8 +99,18 @@ public:
     void applyQueuedOverrides(LLViewerObject* obj);
 
     // Apply an override update with the given data
+    // The region cache is updated right away, the objects' faces once per
+    // frame by applyPendingOverrides
     void applyOverrideMessage(LLMessageSystem* msg, const std::string& data);
 
+    // Apply the newest override update received for each object since the
+    // last call.  Called once per frame after network processing.
+    void applyPendingOverrides();
+
+    // Render material for base with override_mat applied.  Faces with the
+    // same base material and (shared) override get the same render material.
+    LLPointer<LLFetchedGLTFMaterial> getRenderMaterial(LLFetchedGLTFMaterial* base, LLGLTFMaterial* override_mat);
+
 private:
     friend class LLGLTFMaterialOverrideDispatchHandler;
     // save an override update that we got from the simulator for later (for example, if an override arrived for an unknown object)
@@ -125,6 +136,28 @@ protected:
 
     LLUUID mLastUpdateKey;
 
+    // newest override per side from the override messages for each object
+    // since the last applyPendingOverrides, sides without one are cleared
+    typedef std::unordered_map<S32, LLPointer<LLGLTFMaterial> > side_override_map_t;
+    typedef std::unordered_map<LLUUID, side_override_map_t> pending_override_map_t;
+    pending_override_map_t mPendingOverrides;
+
+    // render materials by base material and override, holding both so the
+    // pointers in the key stay valid
+    struct RenderMaterialEntry
+    {
+        LLPointer<LLFetchedGLTFMaterial> mBase;
+        LLPointer<LLGLTFMaterial> mOverride;
+        LLPointer<LLFetchedGLTFMaterial> mRender;
+    };
+    typedef std::pair<const LLGLTFMaterial*, const LLGLTFMaterial*> render_material_key_t;
+    typedef std::unordered_map<render_material_key_t, RenderMaterialEntry, boost::hash<render_material_key_t> > render_material_map_t;
+    render_material_map_t mRenderMaterials;
+    F64 mNextRenderMaterialPurge = 0.0;
+
+    // drop the render materials no face uses anymore
+    void purgeRenderMaterials();
+
     struct ModifyMaterialData
     {
         LLUUID object_id;
@@ -50,9 +50,12 @@
 #include "llnotificationsutil.h"
 #include "lluictrlfactory.h"
 #include "lltrans.h"
+#include "llviewercontrol.h"
 #include "llviewerregion.h"
 #include <boost/regex.hpp>
 #include "llcorehttputil.h"
+#include "llcoros.h"
+#include "lleventcoro.h"
 #include "lluiusage.h"
 
 
@@ -2158,6 +2161,7 @@ void LLGroupMgr::groupMembersRequestCoro(std::string url, LLUUID groupId)
         httpAdapter(new LLCoreHttpUtil::HttpCoroutineAdapter("groupMembersRequest", httpPolicy));
     LLCore::HttpRequest::ptr_t httpRequest(new LLCore::HttpRequest);
     LLCore::HttpOptions::ptr_t httpOpts = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions);
+    httpAdapter->setBinaryLLSD(gSavedSettings.getBOOL("HttpBinaryLLSD"));
 
     mMemberRequestInFlight = true;
 
@@ -2272,10 +2276,30 @@ void LLGroupMgr::processCapGroupMembersRequest(const LLSD& content)
 	// Compute this once, rather than every time.
 	U64	default_powers	= llstrtou64(defaults["default_powers"].asString().c_str(), NULL, 16);
 
+	// Large groups take seconds to unpack, spread them over several frames.
+	// This runs in the request coroutine, so only it waits.
+	static LLCachedControl<F32> slice_ms(gSavedSettings, "GroupMembersParseSliceMS", 0.f);
+	bool time_sliced = slice_ms > 0.f && !LLCoros::getName().empty();
+	LLTimer slice_timer;
+	slice_timer.setTimerExpirySec(slice_ms / 1000.f);
+
 	LLSD::map_const_iterator member_iter_start	= member_list.beginMap();
 	LLSD::map_const_iterator member_iter_end	= member_list.endMap();
 	for( ; member_iter_start != member_iter_end; ++member_iter_start)
 	{
+		if (time_sliced && slice_timer.hasExpired())
+		{
+			llcoro::suspend();
+			slice_timer.setTimerExpirySec(slice_ms / 1000.f);
+			// The group may have been dropped while we were away
+			group_datap = getGroupData(group_id);
+			if (!group_datap)
+			{
+				LL_DEBUGS("GrpMgr") << "Group " << group_id << " went away while receiving members" << LL_ENDL;
+				return;
+			}
+		}
+
 		// Reset defaults
 		online_status	= "unknown";
 		title			= titles[0].asString();
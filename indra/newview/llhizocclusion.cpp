@@ -0,0 +1,242 @@
+/**
+ * @file llhizocclusion.cpp
+ * @brief LLHiZOcclusion class implementation
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llhizocclusion.h"
+#include "llappviewer.h"
+#include "llviewershadermgr.h"
+#include "pipeline.h"
+
+// a pyramid older than this many frames is too far from the current view to cull with
+static const U32 MAX_PYRAMID_AGE = 4;
+
+void LLHiZOcclusion::capture(LLRenderTarget* depth_src, const F32* modelview, const F32* projection)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+    LL_PROFILE_GPU_ZONE("hiz capture");
+
+    if (mReadback.isFull())
+    { // the GPU is NUM_READBACKS frames behind, skip this one rather than stall
+        return;
+    }
+
+    U32 width = (depth_src->getWidth() + TILE_SIZE - 1) / TILE_SIZE;
+    U32 height = (depth_src->getHeight() + TILE_SIZE - 1) / TILE_SIZE;
+
+    if (mTiles.getWidth() != width || mTiles.getHeight() != height)
+    {
+        mTiles.release();
+        if (!mTiles.allocate(width, height, GL_R32F))
+        {
+            return;
+        }
+    }
+
+    mTiles.bindTarget();
+    {
+        LLGLDepthTest depth(GL_FALSE, GL_FALSE);
+        LLGLDisable blend(GL_BLEND);
+
+        gHiZTileProgram.bind();
+        gHiZTileProgram.bindTexture(LLShaderMgr::DEFERRED_DEPTH, depth_src, true, LLTexUnit::TFO_POINT);
+
+        gPipeline.mScreenTriangleVB->setBuffer();
+        gPipeline.mScreenTriangleVB->drawArrays(LLRender::TRIANGLES, 0, 3);
+
+        gHiZTileProgram.unbind();
+    }
+
+    S32 slot = mReadback.read(0, 0, width, height, GL_RED, GL_FLOAT);
+    mTiles.flush();
+    if (slot < 0)
+    {
+        return;
+    }
+
+    LLMatrix4a mv;
+    LLMatrix4a proj;
+    mv.loadu(modelview);
+    proj.loadu(projection);
+    matMul(mv, proj, mReadbackViewProj[slot]);
+    mReadbackFrame[slot] = gFrameCount;
+}
+
+void LLHiZOcclusion::update()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    // oldest first so the newest finished readback wins
+    mReadback.poll([this](S32 slot, const U8* data, U32 width, U32 height)
+        {
+            buildLevels((const F32*)data, width, height);
+            mViewProj = mReadbackViewProj[slot];
+            mFrame = mReadbackFrame[slot];
+        });
+}
+
+void LLHiZOcclusion::buildLevels(const F32* tiles, U32 width, U32 height)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    U32 count = 1;
+    for (U32 w = width, h = height; w > 1 || h > 1; w = (w + 1) / 2, h = (h + 1) / 2)
+    {
+        ++count;
+    }
+    mLevels.resize(count);
+
+    mLevels[0].mWidth = width;
+    mLevels[0].mHeight = height;
+    mLevels[0].mDepth.assign(tiles, tiles + width * height);
+
+    for (U32 l = 1; l < count; ++l)
+    {
+        const Level& src = mLevels[l - 1];
+        Level& dst = mLevels[l];
+        // round up so the last row and column of an odd level are still covered
+        dst.mWidth = (src.mWidth + 1) / 2;
+        dst.mHeight = (src.mHeight + 1) / 2;
+        dst.mDepth.resize(dst.mWidth * dst.mHeight);
+
+        for (U32 y = 0; y < dst.mHeight; ++y)
+        {
+            U32 y0 = y * 2;
+            U32 y1 = llmin(y0 + 1, src.mHeight - 1);
+            for (U32 x = 0; x < dst.mWidth; ++x)
+            {
+                U32 x0 = x * 2;
+                U32 x1 = llmin(x0 + 1, src.mWidth - 1);
+                F32 d = llmax(src.mDepth[y0 * src.mWidth + x0], src.mDepth[y0 * src.mWidth + x1]);
+                d = llmax(d, src.mDepth[y1 * src.mWidth + x0]);
+                d = llmax(d, src.mDepth[y1 * src.mWidth + x1]);
+                dst.mDepth[y * dst.mWidth + x] = d;
+            }
+        }
+    }
+}
+
+bool LLHiZOcclusion::isValid() const
+{
+    return !mLevels.empty() && gFrameCount - mFrame <= MAX_PYRAMID_AGE;
+}
+
+bool LLHiZOcclusion::isOccluded(const LLVector4a& center, const LLVector4a& size) const
+{
+    llassert(isValid());
+
+    LLVector4a min;
+    LLVector4a max;
+    min.setSub(center, size);
+    max.setAdd(center, size);
+
+    F32 min_x = 1.f;
+    F32 max_x = -1.f;
+    F32 min_y = 1.f;
+    F32 max_y = -1.f;
+    F32 min_z = 1.f;
+
+    for (U32 i = 0; i < 8; ++i)
+    {
+        LLVector4a corner;
+        corner.set(i & 1 ? max[0] : min[0],
+                   i & 2 ? max[1] : min[1],
+                   i & 4 ? max[2] : min[2],
+                   1.f);
+
+        LLVector4a clip = rowMul(corner, mViewProj);
+        F32 w = clip[3];
+        if (w <= F_APPROXIMATELY_ZERO)
+        { // box reaches behind the camera
+            return false;
+        }
+
+        F32 x = clip[0] / w;
+        F32 y = clip[1] / w;
+        min_x = llmin(min_x, x);
+        max_x = llmax(max_x, x);
+        min_y = llmin(min_y, y);
+        max_y = llmax(max_y, y);
+        min_z = llmin(min_z, clip[2] / w);
+    }
+
+    min_x = llmax(min_x, -1.f);
+    max_x = llmin(max_x, 1.f);
+    min_y = llmax(min_y, -1.f);
+    max_y = llmin(max_y, 1.f);
+    if (min_x >= max_x || min_y >= max_y)
+    { // off screen, that's for frustum culling to decide
+        return false;
+    }
+
+    // nearest point of the box as a depth buffer value
+    F32 box_depth = min_z * 0.5f + 0.5f;
+
+    // footprint in level 0 tiles
+    const Level& base = mLevels[0];
+    F32 x0 = (min_x * 0.5f + 0.5f) * base.mWidth;
+    F32 x1 = (max_x * 0.5f + 0.5f) * base.mWidth;
+    F32 y0 = (min_y * 0.5f + 0.5f) * base.mHeight;
+    F32 y1 = (max_y * 0.5f + 0.5f) * base.mHeight;
+
+    // coarsest level at which the footprint still spans no more than 2 texels,
+    // so at most 3x3 lookups
+    F32 extent = llmax(x1 - x0, y1 - y0);
+    U32 level = 0;
+    while (extent > 2.f && level + 1 < mLevels.size())
+    {
+        extent *= 0.5f;
+        ++level;
+    }
+
+    const Level& lvl = mLevels[level];
+    U32 scale = 1 << level;
+    U32 tx0 = llmin((U32)x0 / scale, lvl.mWidth - 1);
+    U32 tx1 = llmin((U32)x1 / scale, lvl.mWidth - 1);
+    U32 ty0 = llmin((U32)y0 / scale, lvl.mHeight - 1);
+    U32 ty1 = llmin((U32)y1 / scale, lvl.mHeight - 1);
+
+    for (U32 y = ty0; y <= ty1; ++y)
+    {
+        for (U32 x = tx0; x <= tx1; ++x)
+        {
+            if (lvl.mDepth[y * lvl.mWidth + x] >= box_depth)
+            { // something in this tile is at least as far as the box
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void LLHiZOcclusion::release()
+{
+    mReadback.release();
+
+    mTiles.release();
+    mLevels.clear();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file llhizocclusion.h
+ * @brief Occlusion culling against a hierarchical depth map of the previous frame
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#pragma once
+
+#include "llglreadback.h"
+#include "llmatrix4a.h"
+#include "llrendertarget.h"
+
+// Replacement for per group occlusion queries on the main camera.
+// Once per frame the opaque depth buffer is reduced on the GPU to the
+// farthest depth of each TILE_SIZE square tile and read back asynchronously.
+// When the readback lands a couple of frames later the rest of the max depth
+// pyramid is built on the CPU, and spatial groups are tested against it by
+// projecting their bounding boxes with the matrices the depth was rendered
+// with.  A test is a handful of lookups, so every group can be tested every
+// frame with no query objects and no waiting on a result.
+class alignas(16) LLHiZOcclusion
+{
+    LL_ALIGN_NEW
+public:
+    // size in pixels of the tiles the GPU pass reduces, must match hiZTileF.glsl
+    static const U32 TILE_SIZE = 8;
+
+    // reduce depth_src (the opaque depth of the main camera, rendered with
+    // modelview and projection) and start reading it back
+    void capture(LLRenderTarget* depth_src, const F32* modelview, const F32* projection);
+
+    // pick up the newest finished readback, if any
+    void update();
+
+    // true if there is a recent enough depth pyramid to test against
+    bool isValid() const;
+
+    // true if the box is entirely behind the depth pyramid.  center and size
+    // are agent space bounds, as for occlusion queries
+    bool isOccluded(const LLVector4a& center, const LLVector4a& size) const;
+
+    // release any GL state
+    void release();
+
+private:
+    void buildLevels(const F32* tiles, U32 width, U32 height);
+
+    struct Level
+    {
+        U32 mWidth;
+        U32 mHeight;
+        std::vector<F32> mDepth;
+    };
+
+    static const U32 NUM_READBACKS = 3;
+
+    // view projection of the pyramid in mLevels
+    LLMatrix4a mViewProj;
+
+    LLRenderTarget mTiles;
+    LLGLReadback mReadback { NUM_READBACKS };
+    // view projection and frame each readback slot was captured with
+    LLMatrix4a mReadbackViewProj[NUM_READBACKS];
+    U32 mReadbackFrame[NUM_READBACKS];
+
+    // level 0 is the tile map, each further level is the max of 2x2 of the one before
+    std::vector<Level> mLevels;
+    U32 mFrame = 0;
+};
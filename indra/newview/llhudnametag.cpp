@@ -102,7 +102,9 @@ LLHUDNameTag::LLHUDNameTag(const U8 type)
 	mTextAlignment(ALIGN_TEXT_CENTER),
 	mVertAlignment(ALIGN_VERT_CENTER),
 	mLOD(0),
-	mHidden(FALSE)
+	mHidden(FALSE),
+	mLayoutDirty(true),
+	mAlphaFactor(1.f)
 {
 	LLPointer<LLHUDNameTag> ptr(this);
 	sTextObjects.insert(ptr);
@@ -226,7 +228,7 @@ BOOL LLHUDNameTag::lineSegmentIntersect(const LLVector4a& start, const LLVector4
 void LLHUDNameTag::render()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
-	if (sDisplayText)
+	if (sDisplayText && !isBatched())
 	{
 		LLGLDepthTest gls_depth(GL_TRUE, GL_FALSE);
 		//LLGLDisable gls_stencil(GL_STENCIL_TEST);
@@ -234,6 +236,77 @@ void LLHUDNameTag::render()
 	}
 }
 
+//static
+bool LLHUDNameTag::isBatched()
+{
+	static LLCachedControl<bool> batch_name_tags(gSavedSettings, "RenderNameTagBatch", false);
+	return batch_name_tags;
+}
+
+//static
+void LLHUDNameTag::renderAllBatched()
+{
+	if (!sDisplayText || !isBatched() || sVisibleTextObjects.empty())
+	{
+		return;
+	}
+
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+
+	LLGLDepthTest gls_depth(GL_TRUE, GL_FALSE);
+	gGL.getTexUnit(0)->enable(LLTexUnit::TT_TEXTURE);
+	LLGLState gls_blend(GL_BLEND, TRUE);
+
+	// Backgrounds first, back to front. Every tag uses the same two images,
+	// so their quads go out in one batch per image switch.
+	std::vector<LLHUDNameTag*> tags;
+	tags.reserve(sVisibleTextObjects.size());
+	for (LLHUDNameTag* tag : sVisibleTextObjects)
+	{
+		if (!tag->mDead && tag->renderBackground())
+		{
+			tags.push_back(tag);
+		}
+	}
+
+	if (!tags.empty())
+	{
+		// Then the text of every tag under a single 2D projection. Each tag is
+		// projected to the screen once and its lines are laid out from there,
+		// so glyphs sharing a font atlas page go out together.
+		LLRect world_view_rect = gViewerWindow->getWorldViewRectRaw();
+
+		gGL.matrixMode(LLRender::MM_PROJECTION);
+		gGL.pushMatrix();
+		gGL.matrixMode(LLRender::MM_MODELVIEW);
+		gGL.pushMatrix();
+		LLUI::pushMatrix();
+
+		gl_state_for_2d(world_view_rect.getWidth(), world_view_rect.getHeight());
+		gViewerWindow->setup3DViewport();
+		gGL.loadIdentity();
+
+		for (LLHUDNameTag* tag : tags)
+		{
+			LLVector3 window_pos;
+			if (tag->projectToWindow(window_pos))
+			{
+				tag->renderSegments(&window_pos);
+			}
+		}
+
+		LLUI::popMatrix();
+		gGL.popMatrix();
+
+		gGL.matrixMode(LLRender::MM_PROJECTION);
+		gGL.popMatrix();
+		gGL.matrixMode(LLRender::MM_MODELVIEW);
+	}
+
+	/// Reset the default color to white.  The renderer expects this to be the default. 
+	gGL.color4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
 void LLHUDNameTag::renderText(BOOL for_select)
 {
 	if (!mVisible || mHidden)
@@ -258,29 +331,48 @@ void LLHUDNameTag::renderText(BOOL for_select)
 	}
 
 	LLGLState gls_blend(GL_BLEND, for_select ? FALSE : TRUE);
-	
-	LLColor4 shadow_color(0.f, 0.f, 0.f, 1.f);
-	F32 alpha_factor = 1.f;
+
+	if (renderBackground())
+	{
+		renderSegments(NULL);
+	}
+
+	/// Reset the default color to white.  The renderer expects this to be the default. 
+	gGL.color4f(1.0f, 1.0f, 1.0f, 1.0f);
+	if (for_select)
+	{
+		gGL.getTexUnit(0)->enable(LLTexUnit::TT_TEXTURE);
+	}
+}
+
+BOOL LLHUDNameTag::renderBackground()
+{
+	if (!mVisible || mHidden)
+	{
+		return FALSE;
+	}
+
 	LLColor4 text_color = mColor;
+	mAlphaFactor = 1.f;
 	if (mDoFade)
 	{
 		if (mLastDistance > mFadeDistance)
 		{
-			alpha_factor = llmax(0.f, 1.f - (mLastDistance - mFadeDistance)/mFadeRange);
-			text_color.mV[3] = text_color.mV[3]*alpha_factor;
+			mAlphaFactor = llmax(0.f, 1.f - (mLastDistance - mFadeDistance)/mFadeRange);
+			text_color.mV[3] = text_color.mV[3]*mAlphaFactor;
 		}
 	}
 	if (text_color.mV[3] < 0.01f)
 	{
-		return;
+		return FALSE;
 	}
-	shadow_color.mV[3] = text_color.mV[3];
 
 	mOffsetY = lltrunc(mHeight * ((mVertAlignment == ALIGN_VERT_CENTER) ? 0.5f : 1.f));
 
 	// *TODO: make this a per-text setting
+	static LLCachedControl<F32> chat_bubble_opacity(gSavedSettings, "ChatBubbleOpacity");
 	LLColor4 bg_color = LLUIColorTable::instance().getColor("NameTagBackground");
-	bg_color.setAlpha(gSavedSettings.getF32("ChatBubbleOpacity") * alpha_factor);
+	bg_color.setAlpha(chat_bubble_opacity * mAlphaFactor);
 
 	// scale screen size of borders down
 	//RN: for now, text on hud objects is never occluded
@@ -295,30 +387,86 @@ void LLHUDNameTag::renderText(BOOL for_select)
 
 	mRadius = (width_vec + height_vec).magVec() * 0.5f;
 
-	LLCoordGL screen_pos;
-	LLViewerCamera::getInstance()->projectPosAgentToScreen(mPositionAgent, screen_pos, FALSE);
-
 	LLVector2 screen_offset = updateScreenPos(mPositionOffset);
 
-	LLVector3 render_position = mPositionAgent  
+	mRenderPosition = mPositionAgent  
 			+ (x_pixel_vec * screen_offset.mV[VX])
 			+ (y_pixel_vec * screen_offset.mV[VY]);
 
 	LLGLDepthTest gls_depth(GL_TRUE, GL_FALSE);
 	LLRect screen_rect;
 	screen_rect.setCenterAndSize(0, static_cast<S32>(lltrunc(-mHeight / 2 + mOffsetY)), static_cast<S32>(lltrunc(mWidth)), static_cast<S32>(lltrunc(mHeight)));
-    mRoundedRectImgp->draw3D(render_position, x_pixel_vec, y_pixel_vec, screen_rect, bg_color);
+    mRoundedRectImgp->draw3D(mRenderPosition, x_pixel_vec, y_pixel_vec, screen_rect, bg_color);
 	if (mLabelSegments.size())
 	{
 		LLRect label_top_rect = screen_rect;
 		const S32 label_height = ll_round((mFontp->getLineHeight() * (F32)mLabelSegments.size() + (VERTICAL_PADDING / 3.f)));
 		label_top_rect.mBottom = label_top_rect.mTop - label_height;
 		LLColor4 label_top_color = text_color;
-		label_top_color.mV[VALPHA] = gSavedSettings.getF32("ChatBubbleOpacity") * alpha_factor;
+		label_top_color.mV[VALPHA] = chat_bubble_opacity * mAlphaFactor;
+
+        mRoundedRectTopImgp->draw3D(mRenderPosition, x_pixel_vec, y_pixel_vec, label_top_rect, label_top_color);
+	}
+	return TRUE;
+}
+
+BOOL LLHUDNameTag::projectToWindow(LLVector3& window_pos) const
+{
+	LLRect world_view_rect = gViewerWindow->getWorldViewRectRaw();
+	S32	viewport[4];
+	viewport[0] = world_view_rect.mLeft;
+	viewport[1] = world_view_rect.mBottom;
+	viewport[2] = world_view_rect.getWidth();
+	viewport[3] = world_view_rect.getHeight();
+
+	F64 mdlv[16];
+	F64 proj[16];
+	for (U32 i = 0; i < 16; i++)
+	{
+		mdlv[i] = (F64) gGLModelView[i];
+		proj[i] = (F64) gGLProjection[i];
+	}
+
+	F64 win_x, win_y, win_z;
+	if (!gluProject(mRenderPosition.mV[0], mRenderPosition.mV[1], mRenderPosition.mV[2],
+					mdlv, proj, (GLint*) viewport,
+					&win_x, &win_y, &win_z))
+	{
+		return FALSE;
+	}
+
+	window_pos.setVec((F32)(win_x - world_view_rect.mLeft),
+					  (F32)(win_y - world_view_rect.mBottom),
+					  -(((F32)win_z * 2.f) - 1.f));
+	return TRUE;
+}
 
-        mRoundedRectTopImgp->draw3D(render_position, x_pixel_vec, y_pixel_vec, label_top_rect, label_top_color);
+void LLHUDNameTag::renderSegment(const LLHUDTextSegment& segment, const LLFontGL& font, U8 style, LLFontGL::ShadowType shadow,
+								 F32 x_offset, F32 y_offset, const LLColor4& color, const LLVector3* window_pos)
+{
+	if (!window_pos)
+	{
+		hud_render_text(segment.getText(), mRenderPosition, font, style, shadow, x_offset, y_offset, color, FALSE);
+		return;
 	}
 
+	// Same placement as hud_render_text(), which offsets the text by whole
+	// pixels before projecting it.
+	const LLWString& text = segment.getText();
+	if (text.empty())
+	{
+		return;
+	}
+	LLUI::loadIdentity();
+	LLUI::translate((window_pos->mV[VX] + floorf(x_offset)) / LLFontGL::sScaleX,
+					(window_pos->mV[VY] + floorf(y_offset)) / LLFontGL::sScaleY,
+					window_pos->mV[VZ]);
+	F32 right_x;
+	font.render(text, 0, 0, 0, color, LLFontGL::LEFT, LLFontGL::BASELINE, style, shadow, text.length(), 1000, &right_x, /*use_ellipses*/false, /*use_color*/true);
+}
+
+void LLHUDNameTag::renderSegments(const LLVector3* window_pos)
+{
 	F32 y_offset = (F32)mOffsetY;
 		
 	// Render label
@@ -341,8 +489,8 @@ void LLHUDNameTag::renderText(BOOL for_select)
 			}
 
 			LLColor4 label_color(0.f, 0.f, 0.f, 1.f);
-			label_color.mV[VALPHA] = alpha_factor;
-			hud_render_text(segment_iter->getText(), render_position, *fontp, segment_iter->mStyle, LLFontGL::NO_SHADOW, x_offset, y_offset, label_color, FALSE);
+			label_color.mV[VALPHA] = mAlphaFactor;
+			renderSegment(*segment_iter, *fontp, segment_iter->mStyle, LLFontGL::NO_SHADOW, x_offset, y_offset, label_color, window_pos);
 		}
 	}
 
@@ -384,29 +532,25 @@ void LLHUDNameTag::renderText(BOOL for_select)
 				x_offset += 1;
 			}
 
-			text_color = segment_iter->mColor;
-			text_color.mV[VALPHA] *= alpha_factor;
+			LLColor4 text_color = segment_iter->mColor;
+			text_color.mV[VALPHA] *= mAlphaFactor;
 
-			hud_render_text(segment_iter->getText(), render_position, *fontp, style, shadow, x_offset, y_offset, text_color, FALSE);
+			renderSegment(*segment_iter, *fontp, style, shadow, x_offset, y_offset, text_color, window_pos);
 		}
 	}
-	/// Reset the default color to white.  The renderer expects this to be the default. 
-	gGL.color4f(1.0f, 1.0f, 1.0f, 1.0f);
-	if (for_select)
-	{
-		gGL.getTexUnit(0)->enable(LLTexUnit::TT_TEXTURE);
-	}
 }
 
 void LLHUDNameTag::setString(const std::string &text_utf8)
 {
 	mTextSegments.clear();
+	mLayoutDirty = true;
 	addLine(text_utf8, mColor);
 }
 
 void LLHUDNameTag::clearString()
 {
 	mTextSegments.clear();
+	mLayoutDirty = true;
 }
 
 
@@ -420,6 +564,7 @@ void LLHUDNameTag::addLine(const std::string &text_utf8,
 	LLWString wline = utf8str_to_wstring(text_utf8);
 	if (!wline.empty())
 	{
+		mLayoutDirty = true;
 		// use default font for segment if custom font not specified
 		if (!font)
 		{
@@ -486,6 +631,7 @@ void LLHUDNameTag::addLine(const std::string &text_utf8,
 void LLHUDNameTag::setLabel(const std::string &label_utf8)
 {
 	mLabelSegments.clear();
+	mLayoutDirty = true;
 	addLabel(label_utf8);
 }
 
@@ -494,6 +640,7 @@ void LLHUDNameTag::addLabel(const std::string& label_utf8, F32 max_pixels)
 	LLWString wstr = utf8string_to_wstring(label_utf8);
 	if (!wstr.empty())
 	{
+		mLayoutDirty = true;
 		LLWString seps(utf8str_to_wstring("\r\n"));
 		LLWString empty;
 
@@ -529,6 +676,7 @@ void LLHUDNameTag::setZCompare(const BOOL zcompare)
 
 void LLHUDNameTag::setFont(const LLFontGL* font)
 {
+	mLayoutDirty |= (font != mFontp);
 	mFontp = font;
 }
 
@@ -681,6 +829,14 @@ LLVector2 LLHUDNameTag::updateScreenPos(LLVector2 &offset)
 
 void LLHUDNameTag::updateSize()
 {
+	// Only lines, fonts and the LOD's line count shape the tag, so its size
+	// stays put until one of them changes.
+	if (!mLayoutDirty)
+	{
+		return;
+	}
+	mLayoutDirty = false;
+
 	F32 height = 0.f;
 	F32 width = 0.f;
 
@@ -854,6 +1010,7 @@ void LLHUDNameTag::updateAll()
 
 void LLHUDNameTag::setLOD(S32 lod)
 {
+	mLayoutDirty |= (lod != mLOD);
 	mLOD = lod;
 	//RN: uncomment this to visualize LOD levels
 	//std::string label = llformat("%d", lod);
@@ -917,6 +1074,7 @@ void LLHUDNameTag::reshape()
 	for (text_it = sTextObjects.begin(); text_it != sTextObjects.end(); ++text_it)
 	{
 		LLHUDNameTag* textp = (*text_it);
+		textp->mLayoutDirty = true;
 		std::vector<LLHUDTextSegment>::iterator segment_iter; 
 		for (segment_iter = textp->mTextSegments.begin();
 			 segment_iter != textp->mTextSegments.end(); ++segment_iter )
@@ -140,11 +140,25 @@ public:
 	static void reshape();
 	static void setDisplayText(BOOL flag) { sDisplayText = flag ; }
 
+	// With RenderNameTagBatch set, render() draws nothing and this draws every
+	// visible tag instead: all backgrounds, then all text under one 2D setup.
+	static void renderAllBatched();
+
 protected:
 	LLHUDNameTag(const U8 type);
 
 	/*virtual*/ void render();
 	void renderText(BOOL for_select);
+	// Draws the background and sets mRenderPosition and mAlphaFactor for
+	// renderSegments(). Returns FALSE if the tag is faded out.
+	BOOL renderBackground();
+	BOOL projectToWindow(LLVector3& window_pos) const;
+	// Draws the lines with hud_render_text(), or, given the tag's projected
+	// window position, straight into the current 2D projection.
+	void renderSegments(const LLVector3* window_pos);
+	void renderSegment(const LLHUDTextSegment& segment, const LLFontGL& font, U8 style, LLFontGL::ShadowType shadow,
+					   F32 x_offset, F32 y_offset, const LLColor4& color, const LLVector3* window_pos);
+	static bool isBatched();
 	static void updateAll();
 	void setLOD(S32 lod);
 	S32 getMaxLines();
@@ -180,6 +194,9 @@ private:
 	EVertAlignment	mVertAlignment;
 	S32				mLOD;
 	BOOL			mHidden;
+	bool			mLayoutDirty;	// lines, fonts or LOD changed since updateSize()
+	LLVector3		mRenderPosition;
+	F32				mAlphaFactor;
 	LLPointer<LLUIImage> mRoundedRectImgp;
 	LLPointer<LLUIImage> mRoundedRectTopImgp;
 
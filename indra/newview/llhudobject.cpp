@@ -291,6 +291,8 @@ void LLHUDObject::renderAll()
 		}
 	}
 
+	LLHUDNameTag::renderAllBatched();
+
 	LLVertexBuffer::unbind();
     gUIProgram.unbind();
 }
@@ -0,0 +1,166 @@
+/**
+ * @file llimpostoratlas.cpp
+ * @brief LLImpostorAtlas class implementation
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llimpostoratlas.h"
+#include "llrender.h"
+#include "pipeline.h"
+
+// defined in pipeline.cpp
+bool addDeferredAttachments(LLRenderTarget& target, bool for_impostor);
+
+S32 LLImpostorAtlas::allocateSlot()
+{
+    if (!mTarget.isComplete())
+    {
+        if (!mTarget.allocate(ATLAS_SIZE, ATLAS_SIZE, GL_RGBA, true)
+            || (LLPipeline::sRenderDeferred && !addDeferredAttachments(mTarget, true)))
+        {
+            mTarget.release();
+            return -1;
+        }
+
+        gGL.getTexUnit(0)->bind(&mTarget);
+        gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
+        gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+
+        // hand out low slots first
+        mFreeSlots.clear();
+        for (S32 slot = SLOTS_PER_ROW * SLOTS_PER_ROW - 1; slot >= 0; --slot)
+        {
+            mFreeSlots.push_back(slot);
+        }
+    }
+
+    if (mFreeSlots.empty())
+    {
+        return -1;
+    }
+    S32 slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    return slot;
+}
+
+void LLImpostorAtlas::freeSlot(S32 slot)
+{
+    if (slot >= 0 && mTarget.isComplete())
+    {
+        llassert(std::find(mFreeSlots.begin(), mFreeSlots.end(), slot) == mFreeSlots.end());
+        mFreeSlots.push_back(slot);
+    }
+}
+
+void LLImpostorAtlas::bindSlot(S32 slot, U32 res_x, U32 res_y)
+{
+    llassert(res_x <= SLOT_SIZE && res_y <= SLOT_SIZE);
+    GLint x = (slot % SLOTS_PER_ROW) * SLOT_SIZE;
+    GLint y = (slot / SLOTS_PER_ROW) * SLOT_SIZE;
+
+    mTarget.bindTarget();
+    glViewport(x, y, res_x, res_y);
+
+    LLGLEnable scissor(GL_SCISSOR_TEST);
+    glScissor(x, y, res_x, res_y);
+    mTarget.clear();
+}
+
+void LLImpostorAtlas::flushSlot()
+{
+    mTarget.flush();
+}
+
+// static
+LLVector4 LLImpostorAtlas::getTexRect(S32 slot, U32 res_x, U32 res_y)
+{
+    F32 left = (F32) ((slot % SLOTS_PER_ROW) * SLOT_SIZE) / ATLAS_SIZE;
+    F32 bottom = (F32) ((slot / SLOTS_PER_ROW) * SLOT_SIZE) / ATLAS_SIZE;
+    return LLVector4(left, bottom, left + (F32) res_x / ATLAS_SIZE, bottom + (F32) res_y / ATLAS_SIZE);
+}
+
+void LLImpostorAtlas::addQuad(const LLVector3* corners, const LLVector4& tex_rect, const LLColor4U& color)
+{
+    Quad quad;
+    for (U32 i = 0; i < 4; ++i)
+    {
+        quad.mCorners[i] = corners[i];
+    }
+    quad.mTexRect = tex_rect;
+    quad.mColor = color;
+    mQuads.push_back(quad);
+}
+
+void LLImpostorAtlas::renderQuads(S32 diffuse_channel, S32 normal_channel, S32 specular_channel)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    if (mQuads.empty())
+    {
+        return;
+    }
+    if (!mTarget.isComplete())
+    {
+        mQuads.clear();
+        return;
+    }
+
+    gGL.flush();
+    gGL.getTexUnit(diffuse_channel)->bind(&mTarget);
+    if (normal_channel > -1)
+    {
+        mTarget.bindTexture(2, normal_channel);
+    }
+    if (specular_channel > -1)
+    {
+        mTarget.bindTexture(1, specular_channel);
+    }
+
+    gGL.begin(LLRender::QUADS);
+    for (const Quad& quad : mQuads)
+    {
+        const LLVector4& rect = quad.mTexRect;
+        gGL.color4ubv(quad.mColor.mV);
+        gGL.texCoord2f(rect.mV[0], rect.mV[1]);
+        gGL.vertex3fv(quad.mCorners[0].mV);
+        gGL.texCoord2f(rect.mV[2], rect.mV[1]);
+        gGL.vertex3fv(quad.mCorners[1].mV);
+        gGL.texCoord2f(rect.mV[2], rect.mV[3]);
+        gGL.vertex3fv(quad.mCorners[2].mV);
+        gGL.texCoord2f(rect.mV[0], rect.mV[3]);
+        gGL.vertex3fv(quad.mCorners[3].mV);
+    }
+    gGL.end();
+    gGL.flush();
+
+    mQuads.clear();
+}
+
+void LLImpostorAtlas::release()
+{
+    mTarget.release();
+    mFreeSlots.clear();
+    mQuads.clear();
+}
@@ -0,0 +1,80 @@
+/**
+ * @file llimpostoratlas.h
+ * @brief LLImpostorAtlas class definition
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#pragma once
+
+#include "llrendertarget.h"
+#include "v3math.h"
+#include "v4coloru.h"
+#include "v4math.h"
+
+// Shared render target for avatar impostors (see RenderImpostorAtlas).
+// The atlas is split into SLOT_SIZE square slots, one per impostored
+// avatar, so many impostors cost one set of deferred attachments instead of
+// a render target each.  Impostors are queued with addQuad while the avatar
+// pool renders and drawn together by renderQuads with the atlas bound once.
+class LLImpostorAtlas
+{
+public:
+    static const U32 ATLAS_SIZE = 2048;
+    static const U32 SLOT_SIZE = 256;
+    static const U32 SLOTS_PER_ROW = ATLAS_SIZE / SLOT_SIZE;
+
+    // a free slot, allocating the atlas first if needed, or -1 if there is none
+    S32 allocateSlot();
+    void freeSlot(S32 slot);
+
+    // bind the atlas for rendering a res_x by res_y impostor into slot, and
+    // clear that part of it
+    void bindSlot(S32 slot, U32 res_x, U32 res_y);
+    void flushSlot();
+
+    // texture coordinates (left, bottom, right, top) of a res_x by res_y
+    // impostor rendered into slot
+    static LLVector4 getTexRect(S32 slot, U32 res_x, U32 res_y);
+
+    // queue an impostor quad, corners in the order renderImpostor draws them
+    void addQuad(const LLVector3* corners, const LLVector4& tex_rect, const LLColor4U& color);
+
+    // draw the queued quads with the atlas bound to the given channels
+    // (-1 to skip one)
+    void renderQuads(S32 diffuse_channel, S32 normal_channel, S32 specular_channel);
+
+    // release the atlas, every slot becomes free
+    void release();
+
+private:
+    struct Quad
+    {
+        LLVector3 mCorners[4];
+        LLVector4 mTexRect;
+        LLColor4U mColor;
+    };
+
+    LLRenderTarget mTarget;
+    std::vector<S32> mFreeSlots;
+    std::vector<Quad> mQuads;
+};
@@ -150,7 +150,7 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
 	}
 	else
 	{
-		passed = (mFilterSubString.size() ? desc.find(mFilterSubString) != std::string::npos : true);
+		passed = (mFilterSubString.size() ? checkAgainstFilterSubString(listener->getUUID(), desc) : true);
 	}
 
 	passed = passed && checkAgainstFilterType(listener);
@@ -532,6 +532,57 @@ bool LLInventoryFilter::checkAgainstClipboard(const LLUUID& object_id) const
 	return true;
 }
 
+bool LLInventoryFilter::checkAgainstFilterSubString(const LLUUID& object_id, const std::string& desc) const
+{
+	if (mSearchIndexResult && mSearchType == SEARCHTYPE_NAME)
+	{
+		// The index only knows the object's own name. The searchable name is
+		// the display name plus a label suffix, so the index result covers it
+		// only when the display name is that same name.
+		const std::string* name = LLInventorySearchIndex::instance().getIndexedName(object_id);
+		if (name && !desc.compare(0, name->size(), *name))
+		{
+			switch (mSearchIndexResult->getMatch(object_id))
+			{
+				case LLInventorySearchIndex::MATCH_YES:
+					return true;
+				case LLInventorySearchIndex::MATCH_NO:
+				{
+					// Not in the name, but a match may still start within the
+					// last characters of it and run into the suffix.
+					size_t start = (name->size() >= mFilterSubString.size()) ? name->size() - mFilterSubString.size() + 1 : 0;
+					return desc.find(mFilterSubString, start) != std::string::npos;
+				}
+				default:
+					break;
+			}
+		}
+	}
+	return desc.find(mFilterSubString) != std::string::npos;
+}
+
+void LLInventoryFilter::updateSearchIndexQuery()
+{
+	if (mSearchIndexResult)
+	{
+		mSearchIndexResult->cancel();
+		mSearchIndexResult.reset();
+	}
+
+	static LLCachedControl<bool> use_search_index(gSavedSettings, "InventorySearchIndex", false);
+	if (use_search_index
+		&& mSearchType == SEARCHTYPE_NAME
+		&& mFilterTokens.empty()
+		&& mExactToken.empty()
+		&& !mFilterSubString.empty()
+		&& LLStartUp::getStartupState() >= STATE_STARTED)
+	{
+		LLInventorySearchIndex::Query query;
+		query.mSubString = mFilterSubString;
+		mSearchIndexResult = LLInventorySearchIndex::instance().query(query);
+	}
+}
+
 bool LLInventoryFilter::checkAgainstPermissions(const LLFolderViewModelItemInventory* listener) const
 {
 	if (!listener) return FALSE;
@@ -722,6 +773,7 @@ void LLInventoryFilter::setSearchType(ESearchType type)
 	if(mSearchType != type)
 	{
 		mSearchType = type;
+		updateSearchIndexQuery();
 		setModified();
 	}
 }
@@ -966,6 +1018,7 @@ void LLInventoryFilter::setFilterSubString(const std::string& string)
 			&& !filter_sub_string_new.substr(0, mFilterSubString.size()).compare(mFilterSubString);
 
 		mFilterSubString = filter_sub_string_new;
+		updateSearchIndexQuery();
 		if (exact_token_changed)
 		{
 			setModified(FILTER_RESTART);
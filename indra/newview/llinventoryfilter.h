@@ -30,6 +30,7 @@
 #include "llinventorytype.h"
 #include "llpermissionsflags.h"
 #include "llfolderviewmodel.h"
+#include "llinventorysearchindex.h"
 
 class LLFolderViewItem;
 class LLFolderViewFolder;
@@ -349,6 +350,8 @@ private:
 	bool 				checkAgainstCreator(const class LLFolderViewModelItemInventory* listener) const;
 	bool				checkAgainstSearchVisibility(const class LLFolderViewModelItemInventory* listener) const;
 	bool				checkAgainstClipboard(const LLUUID& object_id) const;
+	bool				checkAgainstFilterSubString(const LLUUID& object_id, const std::string& desc) const;
+	void				updateSearchIndexQuery();
 
 	FilterOps				mFilterOps;
 	FilterOps				mDefaultFilterOps;
@@ -378,6 +381,9 @@ private:
 	std::vector<std::string> mFilterTokens;
 	std::string				 mExactToken;
 
+	// Background name search for mFilterSubString, see LLInventorySearchIndex
+	LLInventorySearchIndex::result_ptr_t mSearchIndexResult;
+
     bool mSingleFolderMode;
 };
 
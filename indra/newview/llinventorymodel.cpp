@@ -67,6 +67,9 @@
 #include "llcorehttputil.h"
 #include "hbxxh.h"
 #include "llstartup.h"
+#include "llxorcipher.h"
+#include "llasyncpersist.h"
+#include "pipeline.h"
 
 //#define DIFF_INVENTORY_FILES
 #ifdef DIFF_INVENTORY_FILES
@@ -463,9 +466,16 @@ LLInventoryModel::~LLInventoryModel()
 	cleanupInventory();
 }
 
-void LLInventoryModel::cleanupInventory()
+void LLInventoryModel::cleanupInventory(bool leak_contents)
 {
-	empty();
+	if (leak_contents)
+	{
+		abandon();
+	}
+	else
+	{
+		empty();
+	}
 	// Deleting one observer might erase others from the list, so always pop off the front
 	while (!mObservers.empty())
 	{
@@ -480,6 +490,7 @@ void LLInventoryModel::cleanupInventory()
         mBulkFecthCallbackSlot.disconnect();
     }
 	mObservers.clear();
+	mObserverFilters.clear();
 
 	// Run down HTTP transport
     mHttpHeaders.reset();
@@ -1695,7 +1706,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 		return;
 	}
 
-	if((object_id == cat_id) || !is_in_map(mCategoryMap, cat_id))
+	if((object_id == cat_id) || !mCategoryMap.count(cat_id))
 	{
 		LL_WARNS(LOG_INV) << "Could not move inventory object " << object_id << " to "
 						  << cat_id << LL_ENDL;
@@ -2031,7 +2042,7 @@ void LLInventoryModel::deleteObject(const LLUUID& id, bool fix_broken_links, boo
     
     // Note : We need to tell the inventory observers that those things are going to be deleted *before* the tree is cleared or they won't know what to delete (in views and view models)
 	addChangedMask(LLInventoryObserver::REMOVE, id);
-	gInventory.notifyObservers();
+	doNotifyObservers();
     
 	item_list = getUnlockedItemArray(id);
 	if(item_list)
@@ -2099,13 +2110,55 @@ void LLInventoryModel::rebuildLinkItems(LLInventoryModel::item_array_t& items)
 // Add/remove an observer. If the observer is destroyed, be sure to
 // remove it.
 void LLInventoryModel::addObserver(LLInventoryObserver* observer)
+{
+	addObserver(observer, LLInventoryObserver::ALL);
+}
+
+void LLInventoryModel::addObserver(LLInventoryObserver* observer, U32 mask_filter, const LLUUID& subtree_id)
 {
 	mObservers.insert(observer);
+	if (mask_filter == LLInventoryObserver::ALL && subtree_id.isNull())
+	{
+		mObserverFilters.erase(observer);
+	}
+	else
+	{
+		ObserverFilter& filter = mObserverFilters[observer];
+		filter.mMask = mask_filter;
+		filter.mSubtreeID = subtree_id;
+	}
 }
 	
 void LLInventoryModel::removeObserver(LLInventoryObserver* observer)
 {
 	mObservers.erase(observer);
+	mObserverFilters.erase(observer);
+}
+
+bool LLInventoryModel::filterAccepts(const ObserverFilter& filter) const
+{
+	if (!(mModifyMask & filter.mMask))
+	{
+		return false;
+	}
+	if (filter.mSubtreeID.isNull()
+		|| mChangedItemIDs.empty()
+		// Moved objects are reported by id only, they might have left the subtree
+		|| (mModifyMask & LLInventoryObserver::STRUCTURE))
+	{
+		return true;
+	}
+	for (const LLUUID& id : mChangedItemIDs)
+	{
+		if (id == filter.mSubtreeID
+			// Removed objects no longer know their parent
+			|| !getObject(id)
+			|| isObjectDescendentOf(id, filter.mSubtreeID))
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 BOOL LLInventoryModel::containsObserver(LLInventoryObserver* observer) const
@@ -2122,26 +2175,41 @@ void LLInventoryModel::idleNotifyObservers()
     {
         if (mModifyMask != LLInventoryObserver::NONE || (mChangedItemIDs.size() != 0))
         {
-            notifyObservers();
+            doNotifyObservers();
         }
         for (const LLUUID& link_id : mLinksRebuildList)
         {
             addChangedMask(LLInventoryObserver::REBUILD , link_id);
         }
         mLinksRebuildList.clear();
-        notifyObservers();
+        doNotifyObservers();
     }
 	
 	if (mModifyMask == LLInventoryObserver::NONE && (mChangedItemIDs.size() == 0))
 	{
 		return;
 	}
-	notifyObservers();
+	doNotifyObservers();
 }
 
 // Call this method when it's time to update everyone on a new state.
 void LLInventoryModel::notifyObservers()
 {
+	static LLCachedControl<bool> coalesce(gSavedSettings, "InventoryCoalesceNotifications", false);
+	if (coalesce)
+	{
+		// Changes keep accumulating (and deduplicating) in mChangedItemIDs,
+		// idleNotifyObservers() delivers them once per frame.
+		return;
+	}
+	doNotifyObservers();
+}
+
+static LLTrace::BlockTimerStatHandle FTM_NOTIFY_OBSERVERS("Inventory Notify Observers");
+
+void LLInventoryModel::doNotifyObservers()
+{
+	LL_RECORD_BLOCK_TIME(FTM_NOTIFY_OBSERVERS);
 	if (mIsNotifyObservers)
 	{
 		// Within notifyObservers, something called notifyObservers
@@ -2156,7 +2224,18 @@ void LLInventoryModel::notifyObservers()
 		 iter != mObservers.end(); )
 	{
 		LLInventoryObserver* observer = *iter;
-		observer->changed(mModifyMask);
+		observer_filter_map_t::const_iterator filter = mObserverFilters.find(observer);
+		if (filter == mObserverFilters.end() || filterAccepts(filter->second))
+		{
+			F64 start = LLTimer::getTotalSeconds();
+			observer->changed(mModifyMask);
+			F64 elapsed = LLTimer::getTotalSeconds() - start;
+			if (elapsed > 0.005)
+			{
+				LL_DEBUGS(LOG_INV) << "Observer " << typeid(*observer).name() << " took "
+					<< elapsed * 1000.0 << " ms, mask " << mModifyMask << LL_ENDL;
+			}
+		}
 
 		// safe way to increment since changed may delete entries! (@!##%@!@&*!)
 		iter = mObservers.upper_bound(observer); 
@@ -2319,7 +2398,8 @@ std::string LLInventoryModel::getInvCacheAddres(const LLUUID& owner_id)
 
 void LLInventoryModel::cache(
 	const LLUUID& parent_folder_id,
-	const LLUUID& agent_id)
+	const LLUUID& agent_id,
+	LLAsyncPersist* persist)
 {
 	LL_DEBUGS(LOG_INV) << "Caching " << parent_folder_id << " for " << agent_id
 					   << LL_ENDL;
@@ -2337,16 +2417,70 @@ void LLInventoryModel::cache(
 		items,
 		INCLUDE_TRASH,
 		can_cache);
+    std::string inventory_filename = getInvCacheAddres(agent_id);
+    std::string gzip_filename = inventory_filename + ".gz";
+    std::string binary_filename = inventory_filename + ".bin";
+    const bool use_binary = gSavedSettings.getBOOL("InventoryUseBinaryCache");
+    if (persist)
+    {
+        // Serialized here, the items may be gone by the time it's written
+        std::string data;
+        if (use_binary)
+        {
+            packBinaryCache(categories, items, data);
+        }
+        else
+        {
+            std::ostringstream str;
+            if (!saveToStream(str, categories, items))
+            {
+                return;
+            }
+            data = str.str();
+        }
+        persist->add("inventory cache " + agent_id.asString(),
+            [data, use_binary, binary_filename, gzip_filename]()
+            {
+                if (!LLAsyncPersist::writeFile(use_binary ? binary_filename : gzip_filename, data, !use_binary))
+                {
+                    return false;
+                }
+                // only one of the two caches may exist, loadSkeleton() prefers the binary one
+                LLFile::remove(use_binary ? gzip_filename : binary_filename, ENOENT);
+                return true;
+            });
+        return;
+    }
+
+    if (use_binary)
+    {
+        // Write next to the cache and move it into place, so other
+        // instances never map a partially written file
+        std::string temp_file = binary_filename + "." + LLUUID::generateNewID().asString();
+        if (saveToBinaryFile(temp_file, categories, items))
+        {
+            LLFile::remove(binary_filename, ENOENT);
+            if (LLFile::rename(temp_file, binary_filename) == 0)
+            {
+                // only one of the two caches may exist, loadSkeleton() prefers the binary one
+                LLFile::remove(gzip_filename, ENOENT);
+                return;
+            }
+        }
+        LL_WARNS(LOG_INV) << "Unable to write " << binary_filename << LL_ENDL;
+        LLFile::remove(temp_file, ENOENT);
+        return;
+    }
+
     // Use temporary file to avoid potential conflicts with other
     // instances (even a 'read only' instance unzips into a file)
     std::string temp_file = gDirUtilp->getTempFilename();
 	saveToFile(temp_file, categories, items);
-    std::string gzip_filename = getInvCacheAddres(agent_id);
-	gzip_filename.append(".gz");
 	if(gzip_file(temp_file, gzip_filename))
 	{
 		LL_DEBUGS(LOG_INV) << "Successfully compressed " << temp_file << " to " << gzip_filename << LL_ENDL;
 		LLFile::remove(temp_file);
+		LLFile::remove(binary_filename, ENOENT);
 	}
 	else
 	{
@@ -2528,6 +2662,18 @@ void LLInventoryModel::empty()
 	//mInventory.clear();
 }
 
+void LLInventoryModel::abandon()
+{
+	// Freeing a big inventory takes seconds, process exit gets the memory
+	// back at once. The containers move to heap copies that are never freed.
+	(new parent_cat_map_t)->swap(mParentChildCategoryTree);
+	(new parent_item_map_t)->swap(mParentChildItemTree);
+	(new backlink_mmap_t)->swap(mBacklinkMMap);
+	(new cat_map_t)->swap(mCategoryMap);
+	(new item_map_t)->swap(mItemMap);
+	mLastItem = NULL;
+}
+
 void LLInventoryModel::accountForUpdate(const LLCategoryUpdate& update) const
 {
 	LLViewerInventoryCategory* cat = getCategory(update.mCategoryID);
@@ -2704,26 +2850,37 @@ bool LLInventoryModel::loadSkeleton(
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+		std::string binary_filename(inventory_filename);
+		binary_filename.append(".bin");
 		bool remove_inventory_file = false;
-		if(fp)
+		bool is_cache_obsolete = false;
+		bool loaded = false;
+		if (LLFile::isfile(binary_filename))
 		{
-			fclose(fp);
-			fp = NULL;
-			if(gunzip_file(gzip_filename, inventory_filename))
-			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
-			}
-			else
+			loaded = loadFromBinaryFile(binary_filename, categories, items, categories_to_update, is_cache_obsolete);
+		}
+		else
+		{
+			LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+			if(fp)
 			{
-				LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+				fclose(fp);
+				fp = NULL;
+				if(gunzip_file(gzip_filename, inventory_filename))
+				{
+					// we only want to remove the inventory file if it was
+					// gzipped before we loaded, and we successfully
+					// gunziped it.
+					remove_inventory_file = true;
+				}
+				else
+				{
+					LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+				}
 			}
+			loaded = loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete);
 		}
-		bool is_cache_obsolete = false;
-		if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+		if (loaded)
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
@@ -2919,6 +3076,7 @@ bool LLInventoryModel::loadSkeleton(
 			// If out of date, remove the gzipped file too.
 			LL_WARNS(LOG_INV) << "Inv cache out of date, removing" << LL_ENDL;
 			LLFile::remove(gzip_filename);
+			LLFile::remove(binary_filename, ENOENT);
 		}
 		categories.clear(); // will unref and delete entries
 	}
@@ -3073,13 +3231,30 @@ void LLInventoryModel::buildParentChildMap()
 		}
 	}
 	count = items.size();
+
+	// Finding the folder of every item is most of the work with a large
+	// inventory, so look them all up on the pipeline workers first. The
+	// tree is only read there, the arrays are filled in order below.
+	// Nothing can hold a descendent lock while the map is being built.
+	const S32 PARENT_BATCH = 4096;
+	std::vector<item_array_t*> parent_arrays(count);
+	gPipeline.runParallel((count + PARENT_BATCH - 1) / PARENT_BATCH,
+		[&](U32 batch)
+		{
+			S32 end = llmin(count, (S32)(batch + 1) * PARENT_BATCH);
+			for (S32 j = (S32)batch * PARENT_BATCH; j < end; ++j)
+			{
+				parent_arrays[j] = get_ptr_in_map(mParentChildItemTree, items[j]->getParentUUID());
+			}
+		});
+
 	lost = 0;
 	uuid_vec_t lost_item_ids;
 	for(i = 0; i < count; ++i)
 	{
 		LLPointer<LLViewerInventoryItem> item;
 		item = items.at(i);
-		itemsp = getUnlockedItemArray(item->getParentUUID());
+		itemsp = parent_arrays[i];
 		if(itemsp)
 		{
 			itemsp->push_back(item);
@@ -3215,7 +3390,11 @@ void LLInventoryModel::initHttpRequest()
 		// mHttpOptions->setTrace(2);		// Do tracing of requests
         mHttpHeaders = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders);
 		mHttpHeaders->append(HTTP_OUT_HEADER_CONTENT_TYPE, HTTP_CONTENT_LLSD_XML);
-		mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_LLSD_XML);
+		// Fetch bodies stay XML, there's no way back from a refusal
+		// here.  Replies of either kind parse in responseToLLSD().
+		mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, gSavedSettings.getBOOL("HttpBinaryLLSD")
+							 ? HTTP_CONTENT_LLSD_BINARY + ", " + HTTP_CONTENT_LLSD_XML + ";q=0.5"
+							 : HTTP_CONTENT_LLSD_XML);
 		mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_INVENTORY);
 	}
 
@@ -3448,52 +3627,13 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
             return false;
         }
 
-        LLSD cache_ver;
-        cache_ver["inv_cache_version"] = sCurrentInvCacheVersion;
-
-        if (fileXML.fail())
+        if (!saveToStream(fileXML, categories, items))
         {
-            LL_WARNS(LOG_INV) << "Failed to write cache version to file. Unable to save inventory to: " << filename << LL_ENDL;
+            LL_WARNS(LOG_INV) << "Unable to save inventory to: " << filename << LL_ENDL;
             return false;
         }
 
-        fileXML << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
-
-        S32 count = categories.size();
-        S32 cat_count = 0;
-        S32 i;
-        for (i = 0; i < count; ++i)
-        {
-            LLViewerInventoryCategory* cat = categories[i];
-            if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
-            {
-                fileXML << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
-                cat_count++;
-            }
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write a folder to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
-        }
-
-        S32 it_count = items.size();
-        for (i = 0; i < it_count; ++i)
-        {
-            fileXML << LLSDOStreamer<LLSDNotationFormatter>(items[i]->asLLSD()) << std::endl;
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write an item to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
-        }
-        fileXML.flush();
-
         fileXML.close();
-
-        LL_INFOS(LOG_INV) << "Inventory saved: " << cat_count << " categories, " << it_count << " items." << LL_ENDL;
     }
     catch (...)
     {
@@ -3505,6 +3645,432 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
     return true;
 }
 
+// static
+bool LLInventoryModel::saveToStream(std::ostream& str,
+	const cat_array_t& categories,
+	const item_array_t& items)
+{
+    LLSD cache_ver;
+    cache_ver["inv_cache_version"] = sCurrentInvCacheVersion;
+
+    if (str.fail())
+    {
+        LL_WARNS(LOG_INV) << "Failed to write cache version." << LL_ENDL;
+        return false;
+    }
+
+    str << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
+
+    S32 count = categories.size();
+    S32 cat_count = 0;
+    S32 i;
+    for (i = 0; i < count; ++i)
+    {
+        LLViewerInventoryCategory* cat = categories[i];
+        if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
+        {
+            str << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
+            cat_count++;
+        }
+
+        if (str.fail())
+        {
+            LL_WARNS(LOG_INV) << "Failed to write a folder." << LL_ENDL;
+            return false;
+        }
+    }
+
+    S32 it_count = items.size();
+    for (i = 0; i < it_count; ++i)
+    {
+        str << LLSDOStreamer<LLSDNotationFormatter>(items[i]->asLLSD()) << std::endl;
+
+        if (str.fail())
+        {
+            LL_WARNS(LOG_INV) << "Failed to write an item." << LL_ENDL;
+            return false;
+        }
+    }
+    str.flush();
+
+    LL_INFOS(LOG_INV) << "Inventory saved: " << cat_count << " categories, " << it_count << " items." << LL_ENDL;
+    return !str.fail();
+}
+
+namespace
+{
+	// Binary inventory cache layout: a header, the category records, the
+	// item records and then a pool holding every name and description.
+	// Records are fixed size and 8 byte aligned so they can be used in
+	// place from a memory mapped file. Values are in native byte order, a
+	// cache written on a machine of the other endianness is just obsolete.
+	const char BINARY_CACHE_MAGIC[8] = { 'L', 'L', 'I', 'N', 'V', 'B', 'I', 'N' };
+	const U32 BINARY_CACHE_FORMAT = 1;         // bump if the records below change
+	const U32 BINARY_CACHE_BYTE_ORDER = 0x01020304;
+
+	// same key LLInventoryItem uses for the shadow_id of restricted items in the LLSD cache
+	const LLUUID BINARY_CACHE_SHADOW_KEY("3c115e51-04f4-523c-9fa6-98aff1034730");
+
+	// items are decoded in parallel in batches of this many
+	const U32 BINARY_CACHE_ITEM_BATCH = 4096;
+
+	struct BinaryCacheHeader
+	{
+		char mMagic[8];
+		U32 mByteOrder;
+		U32 mFormat;
+		S32 mInvCacheVersion;
+		U32 mCategoryCount;
+		U32 mItemCount;
+		U32 mStringPoolSize;
+	};
+
+	struct BinaryCacheString
+	{
+		U32 mOffset;
+		U32 mLength;
+	};
+
+	struct BinaryCacheCategory
+	{
+		LLUUID mID;
+		LLUUID mParentID;
+		LLUUID mOwnerID;
+		LLUUID mThumbnailID;
+		BinaryCacheString mName;
+		S32 mVersion;
+		S8 mType;
+		S8 mPreferredType;
+		U8 mPad[2];
+	};
+
+	struct BinaryCacheItem
+	{
+		LLUUID mID;
+		LLUUID mParentID;
+		LLUUID mAssetID;			// encrypted as a shadow id if mShadowed is set
+		LLUUID mThumbnailID;
+		LLUUID mCreatorID;
+		LLUUID mOwnerID;
+		LLUUID mLastOwnerID;
+		LLUUID mGroupID;
+		BinaryCacheString mName;
+		BinaryCacheString mDescription;
+		U32 mMaskBase;
+		U32 mMaskOwner;
+		U32 mMaskGroup;
+		U32 mMaskEveryone;
+		U32 mMaskNext;
+		U32 mFlags;
+		S64 mCreationDate;
+		S32 mSalePrice;
+		S8 mType;
+		S8 mInventoryType;
+		S8 mSaleType;
+		U8 mShadowed;
+	};
+
+	static_assert(sizeof(BinaryCacheHeader) % 8 == 0, "binary inventory cache header must keep records aligned");
+	static_assert(sizeof(BinaryCacheCategory) % 8 == 0, "binary inventory cache categories must keep records aligned");
+	static_assert(sizeof(BinaryCacheItem) % 8 == 0, "binary inventory cache items must keep records aligned");
+
+	BinaryCacheString add_to_string_pool(std::string& pool, const std::string& str)
+	{
+		BinaryCacheString rv;
+		rv.mOffset = (U32)pool.size();
+		rv.mLength = (U32)str.size();
+		pool.append(str);
+		return rv;
+	}
+
+	bool valid_pool_string(const BinaryCacheString& str, U32 pool_size)
+	{
+		return str.mOffset <= pool_size && str.mLength <= pool_size - str.mOffset;
+	}
+
+	std::string get_pool_string(const char* pool, const BinaryCacheString& str)
+	{
+		return std::string(pool + str.mOffset, str.mLength);
+	}
+}
+
+// static
+bool LLInventoryModel::loadFromBinaryFile(const std::string& filename,
+										  LLInventoryModel::cat_array_t& categories,
+										  LLInventoryModel::item_array_t& items,
+										  LLInventoryModel::changed_items_t& cats_to_update,
+										  bool &is_cache_obsolete)
+{
+	LL_PROFILE_ZONE_NAMED("inventory load from binary file");
+
+	LL_INFOS(LOG_INV) << "loading inventory from: (" << filename << ")" << LL_ENDL;
+
+	LLMappedFile file;
+	if (!file.open(filename))
+	{
+		LL_INFOS(LOG_INV) << "unable to load inventory from: " << filename << LL_ENDL;
+		return false;
+	}
+
+	is_cache_obsolete = true; // Obsolete until proven current
+
+	const U8* data = file.getData();
+	const size_t size = file.getSize();
+	if (size < sizeof(BinaryCacheHeader))
+	{
+		LL_WARNS(LOG_INV) << "Inventory cache is truncated" << LL_ENDL;
+		return false;
+	}
+
+	const BinaryCacheHeader* header = reinterpret_cast<const BinaryCacheHeader*>(data);
+	if (memcmp(header->mMagic, BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC)) != 0
+		|| header->mByteOrder != BINARY_CACHE_BYTE_ORDER
+		|| header->mFormat != BINARY_CACHE_FORMAT
+		|| header->mInvCacheVersion != sCurrentInvCacheVersion)
+	{
+		LL_WARNS(LOG_INV) << "Inventory cache is out of date" << LL_ENDL;
+		return false;
+	}
+
+	const size_t cats_offset = sizeof(BinaryCacheHeader);
+	const size_t items_offset = cats_offset + (size_t)header->mCategoryCount * sizeof(BinaryCacheCategory);
+	const size_t pool_offset = items_offset + (size_t)header->mItemCount * sizeof(BinaryCacheItem);
+	const U32 pool_size = header->mStringPoolSize;
+	if (pool_offset + pool_size != size)
+	{
+		LL_WARNS(LOG_INV) << "Inventory cache is truncated" << LL_ENDL;
+		return false;
+	}
+
+	const BinaryCacheCategory* cat_records = reinterpret_cast<const BinaryCacheCategory*>(data + cats_offset);
+	const BinaryCacheItem* item_records = reinterpret_cast<const BinaryCacheItem*>(data + items_offset);
+	const char* pool = reinterpret_cast<const char*>(data + pool_offset);
+
+	for (U32 i = 0; i < header->mCategoryCount; ++i)
+	{
+		const BinaryCacheCategory& record = cat_records[i];
+		if (!valid_pool_string(record.mName, pool_size))
+		{
+			LL_WARNS(LOG_INV) << "Parsing inventory cache failed" << LL_ENDL;
+			return false;
+		}
+
+		LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(record.mID,
+			record.mParentID,
+			(LLFolderType::EType)record.mPreferredType,
+			get_pool_string(pool, record.mName),
+			record.mOwnerID);
+		inv_cat->setType((LLAssetType::EType)record.mType);
+		inv_cat->setThumbnailUUID(record.mThumbnailID);
+		inv_cat->setVersion(record.mVersion);
+		categories.push_back(inv_cat);
+	}
+
+	// Items are most of the cache, build them on the pipeline workers.
+	// Each batch only writes its own slots, anything that fails to decode
+	// stays null and spoils the whole cache below.
+	const U32 item_count = header->mItemCount;
+	std::vector<LLPointer<LLViewerInventoryItem> > loaded(item_count);
+	gPipeline.runParallel((item_count + BINARY_CACHE_ITEM_BATCH - 1) / BINARY_CACHE_ITEM_BATCH,
+		[&](U32 batch)
+		{
+			U32 end = llmin(item_count, (batch + 1) * BINARY_CACHE_ITEM_BATCH);
+			for (U32 i = batch * BINARY_CACHE_ITEM_BATCH; i < end; ++i)
+			{
+				const BinaryCacheItem& record = item_records[i];
+				if (!valid_pool_string(record.mName, pool_size) || !valid_pool_string(record.mDescription, pool_size))
+				{
+					continue;
+				}
+
+				LLPermissions perm;
+				perm.init(record.mCreatorID, record.mOwnerID, record.mLastOwnerID, record.mGroupID);
+				// same as ll_permissions_from_sd(), initMasks() would also apply the fair use fix
+				perm.setMaskBase(record.mMaskBase);
+				perm.setMaskOwner(record.mMaskOwner);
+				perm.setMaskEveryone(record.mMaskEveryone);
+				perm.setMaskGroup(record.mMaskGroup);
+				perm.setMaskNext(record.mMaskNext);
+				perm.fix();
+
+				LLUUID asset_id(record.mAssetID);
+				if (record.mShadowed)
+				{
+					LLXORCipher cipher(BINARY_CACHE_SHADOW_KEY.mData, UUID_BYTES);
+					cipher.decrypt(asset_id.mData, UUID_BYTES);
+				}
+
+				LLViewerInventoryItem* inv_item = new LLViewerInventoryItem(record.mID,
+					record.mParentID,
+					perm,
+					asset_id,
+					(LLAssetType::EType)record.mType,
+					(LLInventoryType::EType)record.mInventoryType,
+					get_pool_string(pool, record.mName),
+					get_pool_string(pool, record.mDescription),
+					LLSaleInfo((LLSaleInfo::EForSale)record.mSaleType, record.mSalePrice),
+					record.mFlags,
+					(time_t)record.mCreationDate);
+				inv_item->setThumbnailUUID(record.mThumbnailID);
+				// match the LLSD cache, which leaves cached items to be fetched again when needed
+				inv_item->setComplete(false);
+				loaded[i] = inv_item;
+			}
+		});
+
+	for (U32 i = 0; i < item_count; ++i)
+	{
+		LLPointer<LLViewerInventoryItem>& inv_item = loaded[i];
+		if (inv_item.isNull())
+		{
+			LL_WARNS(LOG_INV) << "Parsing inventory cache failed" << LL_ENDL;
+			categories.clear();
+			items.clear();
+			cats_to_update.clear();
+			return false;
+		}
+
+		if (inv_item->getUUID().isNull())
+		{
+			LL_DEBUGS(LOG_INV) << "Ignoring inventory with null item id: "
+				<< inv_item->getName() << LL_ENDL;
+		}
+		else if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
+		{
+			cats_to_update.insert(inv_item->getParentUUID());
+		}
+		else
+		{
+			items.push_back(inv_item);
+		}
+	}
+
+	is_cache_obsolete = false;
+	return true;
+}
+
+// static
+bool LLInventoryModel::saveToBinaryFile(const std::string& filename,
+										const cat_array_t& categories,
+										const item_array_t& items)
+{
+	if (filename.empty())
+	{
+		LL_ERRS(LOG_INV) << "Filename is Null!" << LL_ENDL;
+		return false;
+	}
+
+	LL_INFOS(LOG_INV) << "saving inventory to: (" << filename << ")" << LL_ENDL;
+
+	std::string data;
+	packBinaryCache(categories, items, data);
+
+	LLUniqueFile file = LLFile::fopen(filename, "wb");
+	if (!file)
+	{
+		LL_WARNS(LOG_INV) << "Failed to open file. Unable to save inventory to: " << filename << LL_ENDL;
+		return false;
+	}
+	if (fwrite(data.data(), 1, data.size(), file) != data.size())
+	{
+		LL_WARNS(LOG_INV) << "Failed to write to file. Unable to save inventory to: " << filename << LL_ENDL;
+		return false;
+	}
+	return true;
+}
+
+// static
+void LLInventoryModel::packBinaryCache(const cat_array_t& categories,
+									   const item_array_t& items,
+									   std::string& data)
+{
+	std::string pool;
+	std::vector<BinaryCacheCategory> cat_records;
+	cat_records.reserve(categories.size());
+	for (const LLPointer<LLViewerInventoryCategory>& cat : categories)
+	{
+		if (cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN)
+		{
+			continue;
+		}
+
+		BinaryCacheCategory record;
+		memset(&record, 0, sizeof(record));
+		record.mID = cat->getUUID();
+		record.mParentID = cat->getParentUUID();
+		record.mOwnerID = cat->getOwnerID();
+		record.mThumbnailID = cat->getThumbnailUUID();
+		record.mName = add_to_string_pool(pool, cat->getName());
+		record.mVersion = cat->getVersion();
+		record.mType = (S8)cat->getType();
+		record.mPreferredType = (S8)cat->getPreferredType();
+		cat_records.push_back(record);
+	}
+
+	std::vector<BinaryCacheItem> item_records;
+	item_records.reserve(items.size());
+	for (const LLPointer<LLViewerInventoryItem>& item : items)
+	{
+		// the item's own fields, as asLLSD() writes them, not those of whatever it links to
+		const LLInventoryItem* raw = item.get();
+		const LLPermissions& perm = raw->LLInventoryItem::getPermissions();
+		const LLSaleInfo& sale_info = raw->LLInventoryItem::getSaleInfo();
+
+		BinaryCacheItem record;
+		memset(&record, 0, sizeof(record));
+		record.mID = raw->getUUID();
+		record.mParentID = raw->getParentUUID();
+		record.mAssetID = raw->LLInventoryItem::getAssetUUID();
+		record.mThumbnailID = raw->LLInventoryItem::getThumbnailUUID();
+		record.mCreatorID = perm.getCreator();
+		record.mOwnerID = perm.getOwner();
+		record.mLastOwnerID = perm.getLastOwner();
+		record.mGroupID = perm.getGroup();
+		record.mName = add_to_string_pool(pool, raw->LLInventoryItem::getName());
+		record.mDescription = add_to_string_pool(pool, raw->LLInventoryItem::getDescription());
+		record.mMaskBase = perm.getMaskBase();
+		record.mMaskOwner = perm.getMaskOwner();
+		record.mMaskGroup = perm.getMaskGroup();
+		record.mMaskEveryone = perm.getMaskEveryone();
+		record.mMaskNext = perm.getMaskNextOwner();
+		record.mFlags = raw->LLInventoryItem::getFlags();
+		record.mCreationDate = (S64)raw->LLInventoryItem::getCreationDate();
+		record.mSalePrice = sale_info.getSalePrice();
+		record.mType = (S8)raw->LLInventoryItem::getType();
+		record.mInventoryType = (S8)raw->LLInventoryItem::getInventoryType();
+		record.mSaleType = (S8)sale_info.getSaleType();
+		if ((perm.getMaskBase() & PERM_ITEM_UNRESTRICTED) != PERM_ITEM_UNRESTRICTED
+			&& record.mAssetID.notNull())
+		{
+			LLXORCipher cipher(BINARY_CACHE_SHADOW_KEY.mData, UUID_BYTES);
+			cipher.encrypt(record.mAssetID.mData, UUID_BYTES);
+			record.mShadowed = 1;
+		}
+		item_records.push_back(record);
+	}
+
+	BinaryCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mMagic, BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC));
+	header.mByteOrder = BINARY_CACHE_BYTE_ORDER;
+	header.mFormat = BINARY_CACHE_FORMAT;
+	header.mInvCacheVersion = sCurrentInvCacheVersion;
+	header.mCategoryCount = (U32)cat_records.size();
+	header.mItemCount = (U32)item_records.size();
+	header.mStringPoolSize = (U32)pool.size();
+
+	const size_t cat_bytes = cat_records.size() * sizeof(BinaryCacheCategory);
+	const size_t item_bytes = item_records.size() * sizeof(BinaryCacheItem);
+	data.clear();
+	data.reserve(sizeof(header) + cat_bytes + item_bytes + pool.size());
+	data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	data.append(reinterpret_cast<const char*>(cat_records.data()), cat_bytes);
+	data.append(reinterpret_cast<const char*>(item_records.data()), item_bytes);
+	data.append(pool);
+
+	LL_INFOS(LOG_INV) << "Inventory saved: " << cat_records.size() << " categories, " << item_records.size() << " items." << LL_ENDL;
+}
+
 // message handling functionality
 // static
 void LLInventoryModel::registerCallbacks(LLMessageSystem* msg)
@@ -36,6 +36,7 @@
 #include "llfoldertype.h"
 #include "llframetimer.h"
 #include "lluuid.h"
+#include "lluuidmap.h"
 #include "llpermissionsflags.h"
 #include "llviewerinventory.h"
 #include "llstring.h"
@@ -53,6 +54,7 @@ class LLInventoryItem;
 class LLInventoryCategory;
 class LLMessageSystem;
 class LLInventoryCollectFunctor;
+class LLAsyncPersist;
 
 ///----------------------------------------------------------------------------
 /// LLInventoryValidationInfo 
@@ -149,9 +151,12 @@ public:
 public:
 	LLInventoryModel();
 	~LLInventoryModel();
-	void cleanupInventory();
+	// leak_contents is for a process about to exit: the items and
+	// folders are dropped without being freed one by one.
+	void cleanupInventory(bool leak_contents = false);
 protected:
 	void empty(); // empty the entire contents
+	void abandon(); // forget the contents without freeing them
 
 	//--------------------------------------------------------------------
 	// Initialization
@@ -194,16 +199,17 @@ public:
 
 	static std::string getInvCacheAddres(const LLUUID& owner_id);
 
-	// Call on logout to save a terse representation.
-	void cache(const LLUUID& parent_folder_id, const LLUUID& agent_id);
+	// Call on logout to save a terse representation. With persist the
+	// data is only snapshot here and written on a background thread.
+	void cache(const LLUUID& parent_folder_id, const LLUUID& agent_id, LLAsyncPersist* persist = NULL);
 private:
 	// Information for tracking the actual inventory. We index this
 	// information in a lot of different ways so we can access
 	// the inventory using several different identifiers.
 	// mInventory member data is the 'master' list of inventory, and
 	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	typedef LLUUIDMap<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef LLUUIDMap<LLPointer<LLViewerInventoryItem> > item_map_t;
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
 	// This last set of indices is used to map parents to children.
@@ -573,6 +579,8 @@ protected:
 	// Updates all linked items pointing to this id.
 	void addChangedMaskForLinks(const LLUUID& object_id, U32 mask);
 private:
+	// Delivers pending changes right away, even when notifications are coalesced.
+	void doNotifyObservers();
 	// Flag set when notifyObservers is being called, to look for bugs
 	// where it's called recursively.
 	BOOL mIsNotifyObservers;
@@ -596,11 +604,23 @@ private:
 public:
 	// If the observer is destroyed, be sure to remove it.
 	void addObserver(LLInventoryObserver* observer);
+	// The observer is only called when the pending changes intersect
+	// mask_filter and, if subtree_id is set, touch that category subtree.
+	void addObserver(LLInventoryObserver* observer, U32 mask_filter, const LLUUID& subtree_id = LLUUID::null);
 	void removeObserver(LLInventoryObserver* observer);
 	BOOL containsObserver(LLInventoryObserver* observer) const;
 private:
+	struct ObserverFilter
+	{
+		U32 mMask;
+		LLUUID mSubtreeID;
+	};
+	bool filterAccepts(const ObserverFilter& filter) const;
+
 	typedef std::set<LLInventoryObserver*> observer_list_t;
 	observer_list_t mObservers;
+	typedef std::map<LLInventoryObserver*, ObserverFilter> observer_filter_map_t;
+	observer_filter_map_t mObserverFilters;
 	
 /**                    Notifications
  **                                                                            **
@@ -666,6 +686,23 @@ protected:
 	static bool saveToFile(const std::string& filename,
 						   const cat_array_t& categories,
 						   const item_array_t& items); 
+	static bool saveToStream(std::ostream& str,
+							 const cat_array_t& categories,
+							 const item_array_t& items);
+
+	// Binary cache: fixed size records plus a string pool, read straight
+	// out of a memory mapped file. Same contract as the LLSD functions above.
+	static bool loadFromBinaryFile(const std::string& filename,
+								   cat_array_t& categories,
+								   item_array_t& items,
+								   changed_items_t& cats_to_update,
+								   bool& is_cache_obsolete);
+	static bool saveToBinaryFile(const std::string& filename,
+								 const cat_array_t& categories,
+								 const item_array_t& items);
+	static void packBinaryCache(const cat_array_t& categories,
+								const item_array_t& items,
+								std::string& data);
 
 	//--------------------------------------------------------------------
 	// Message handling functionality
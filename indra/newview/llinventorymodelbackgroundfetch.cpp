@@ -195,7 +195,10 @@ LLInventoryModelBackgroundFetch::LLInventoryModelBackgroundFetch():
     mAllRecursiveFoldersFetched(false),
 	mRecursiveInventoryFetchStarted(false),
 	mRecursiveLibraryFetchStarted(false),
-	mMinTimeBetweenFetches(0.3f)
+	mMinTimeBetweenFetches(0.3f),
+    mAISConcurrency(1.f),
+    mFetchStartTime(0.0),
+    mFetchStartItemCount(0)
 {}
 
 LLInventoryModelBackgroundFetch::~LLInventoryModelBackgroundFetch()
@@ -294,6 +297,8 @@ void LLInventoryModelBackgroundFetch::start(const LLUUID& id, bool recursive)
 			if (! mRecursiveInventoryFetchStarted)
 			{
 				mRecursiveInventoryFetchStarted |= recursive;
+                mFetchStartTime = LLTimer::getTotalSeconds();
+                mFetchStartItemCount = gInventory.getItemCount();
                 if (recursive && AISAPI::isAvailable())
                 {
                     // Not only root folder can be massive, but
@@ -458,7 +463,22 @@ void LLInventoryModelBackgroundFetch::setAllFoldersFetched()
     // For now only informs about initial fetch being done
     mFoldersFetchedSignal();
 
-	LL_INFOS(LOG_INV) << "Inventory background fetch completed" << LL_ENDL;
+	LL_INFOS(LOG_INV) << "Inventory background fetch completed, "
+		<< gInventory.getItemCount() << " items, " << getFetchRate() << " items/s" << LL_ENDL;
+}
+
+F32 LLInventoryModelBackgroundFetch::getFetchRate() const
+{
+    if (!mRecursiveInventoryFetchStarted)
+    {
+        return 0.f;
+    }
+    F64 elapsed = LLTimer::getTotalSeconds() - mFetchStartTime;
+    if (elapsed <= 0.0)
+    {
+        return 0.f;
+    }
+    return (F32)((gInventory.getItemCount() - mFetchStartItemCount) / elapsed);
 }
 
 boost::signals2::connection LLInventoryModelBackgroundFetch::setFetchCompletionCallback(folders_fetched_callback_t cb)
@@ -507,6 +527,47 @@ void LLInventoryModelBackgroundFetch::incrFetchFolderCount(S32 fetching)
     }
 }
 
+// Additive increase, multiplicative decrease on the number of outstanding
+// AIS requests. Failures (including 503 throttling, which surfaces as a null
+// response once retries are exhausted) halve the window, slow responses
+// shrink it by one and fast ones grow it by about one per round trip.
+void LLInventoryModelBackgroundFetch::onAISResponse(F64 request_time, bool success)
+{
+    static LLCachedControl<bool> adaptive(gSavedSettings, "InventoryFetchAdaptive", false);
+    if (!adaptive)
+    {
+        return;
+    }
+
+    static LLCachedControl<F32> target_latency(gSavedSettings, "InventoryFetchTargetLatency", 2.f);
+    F64 latency = LLTimer::getTotalSeconds() - request_time;
+    if (!success)
+    {
+        mAISConcurrency = llmax(mAISConcurrency * 0.5f, 1.f);
+    }
+    else if (latency > target_latency)
+    {
+        mAISConcurrency = llmax(mAISConcurrency - 1.f, 1.f);
+    }
+    else
+    {
+        mAISConcurrency += 1.f / mAISConcurrency;
+    }
+    LL_DEBUGS(LOG_INV, "AIS3") << "Response in " << latency << "s, success: " << success
+        << ", concurrency: " << mAISConcurrency << LL_ENDL;
+}
+
+// A recursive request for a large folder returns one huge response that AIS
+// is likely to time out on, so fetch such folders one level at a time.
+bool LLInventoryModelBackgroundFetch::useShallowFetch(const LLViewerInventoryCategory* cat) const
+{
+    static LLCachedControl<bool> adaptive(gSavedSettings, "InventoryFetchAdaptive", false);
+    static LLCachedControl<U32> recursive_limit(gSavedSettings, "InventoryFetchRecursiveLimit", 5000);
+    return adaptive
+        && cat->getDescendentCount() != LLViewerInventoryCategory::DESCENDENT_COUNT_UNKNOWN
+        && (U32)cat->getDescendentCount() > recursive_limit;
+}
+
 void ais_simple_item_callback(const LLUUID& inv_id)
 {
     LL_DEBUGS(LOG_INV , "AIS3") << "Response for " << inv_id << LL_ENDL;
@@ -682,7 +743,15 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
     static LLCachedControl<U32> ais_pool(gSavedSettings, "PoolSizeAIS", 20);
     // Don't have too many requests at once, AIS throttles
     // Reserve one request for actions outside of fetch (like renames)
-    const U32 max_concurrent_fetches = llclamp(ais_pool - 1, 1, 50);
+    U32 max_concurrent_fetches = llclamp(ais_pool - 1, 1, 50);
+
+    static LLCachedControl<bool> adaptive(gSavedSettings, "InventoryFetchAdaptive", false);
+    if (adaptive)
+    {
+        // Start small and let onAISResponse() grow the window
+        mAISConcurrency = llclamp(mAISConcurrency, 1.f, (F32)max_concurrent_fetches);
+        max_concurrent_fetches = (U32)mAISConcurrency;
+    }
 
     if (mFetchCount >= max_concurrent_fetches)
     {
@@ -722,6 +791,7 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
         LL_DEBUGS(LOG_INV , "AIS3") << "Total active fetches: " << mLastFetchCount << "->" << last_fetch_count << "->" << mFetchCount
             << ", scheduled folder fetches: " << (S32)mFetchFolderQueue.size()
             << ", scheduled item fetches: " << (S32)mFetchItemQueue.size()
+            << ", items/s: " << getFetchRate()
             << LL_ENDL;
         mLastFetchCount = mFetchCount;
 
@@ -811,6 +881,13 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                             continue;
                         }
 
+                        if (useShallowFetch(child_cat))
+                        {
+                            // too big for a single recursive request, walk it separately
+                            mFetchFolderQueue.push_back(FetchQueueInfo(child_cat->getUUID(), FT_FOLDER_AND_CONTENT));
+                            continue;
+                        }
+
                         if (child_cat->getPreferredType() == LLFolderType::FT_MARKETPLACE_LISTINGS)
                         {
                             // special case
@@ -849,8 +926,10 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
 
                         EFetchType type = fetch_info.mFetchType;
                         LLUUID cat_id = cat->getUUID(); // need a copy for lambda
-                        AISAPI::completion_t cb = [cat_id, children, type](const LLUUID& response_id)
+                        F64 request_time = LLTimer::getTotalSeconds();
+                        AISAPI::completion_t cb = [cat_id, children, type, request_time](const LLUUID& response_id)
                         {
+                            LLInventoryModelBackgroundFetch::instance().onAISResponse(request_time, response_id.notNull());
                             LLInventoryModelBackgroundFetch::instance().onAISContentCalback(cat_id, children, response_id, type);
                         };
 
@@ -902,9 +981,15 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                         mExpectedFolderIds.push_back(cat_id);
 
                         EFetchType type = fetch_info.mFetchType;
+                        if (type == FT_RECURSIVE && useShallowFetch(cat))
+                        {
+                            type = FT_FOLDER_AND_CONTENT;
+                        }
                         LLUUID cat_id = cat->getUUID();
-                        AISAPI::completion_t cb = [cat_id , type](const LLUUID& response_id)
+                        F64 request_time = LLTimer::getTotalSeconds();
+                        AISAPI::completion_t cb = [cat_id , type, request_time](const LLUUID& response_id)
                         {
+                            LLInventoryModelBackgroundFetch::instance().onAISResponse(request_time, response_id.notNull());
                             LLInventoryModelBackgroundFetch::instance().onAISFolderCalback(cat_id , response_id , type);
                         };
 
@@ -35,6 +35,8 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 
+class LLViewerInventoryCategory;
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Class LLInventoryModelBackgroundFetch
 //
@@ -78,6 +80,7 @@ public:
 	bool isBulkFetchProcessingComplete() const;
     bool isFolderFetchProcessingComplete() const;
 	void setAllFoldersFetched();
+	F32 getFetchRate() const; // items per second since the recursive fetch started
 
     typedef boost::function<void()> folders_fetched_callback_t;
     boost::signals2::connection setFetchCompletionCallback(folders_fetched_callback_t cb);
@@ -112,6 +115,8 @@ protected:
     void onAISFolderCalback(const LLUUID &request_id, const LLUUID &response_id, EFetchType fetch_type);
     void bulkFetchViaAis();
     void bulkFetchViaAis(const FetchQueueInfo& fetch_info);
+    void onAISResponse(F64 request_time, bool success);
+    bool useShallowFetch(const LLViewerInventoryCategory* cat) const;
 	void bulkFetch();
 
 	void backgroundFetch();
@@ -134,6 +139,9 @@ private:
 
 	LLFrameTimer mFetchTimer;
 	F32 mMinTimeBetweenFetches;
+    F32 mAISConcurrency; // adaptive limit on outstanding AIS requests
+    F64 mFetchStartTime;
+    S32 mFetchStartItemCount;
 	fetch_queue_t mFetchFolderQueue;
     fetch_queue_t mFetchItemQueue;
     std::list<LLUUID> mExpectedFolderIds; // for debug, should this track time?
@@ -214,6 +214,10 @@ LLFolderView * LLInventoryPanel::createFolderRoot(LLUUID root_id )
     p.root = NULL;
     p.allow_drop = mParams.allow_drop_on_root;
     p.options_menu = "menu_inventory.xml";
+    if (!p.virtualize_rows.isProvided())
+    {
+        p.virtualize_rows = gSavedSettings.getBOOL("InventoryVirtualizeRows");
+    }
 
 	LLFolderView* fv = LLUICtrlFactory::create<LLFolderView>(p);
 	fv->setCallbackRegistrar(&mCommitCallbackRegistrar);
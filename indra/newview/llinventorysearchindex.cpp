@@ -0,0 +1,365 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Name index of the agent's inventory, queried off the main thread.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include "llinventorymodel.h"
+#include "llviewerinventory.h"
+#include "workqueue.h"
+
+#include <algorithm>
+#include <mutex>
+
+// Candidates checked per lock of the index, and per batch of matches sent
+// back to the main thread.
+static const size_t SEARCH_BATCH_SIZE = 2048;
+
+LLInventorySearchIndex::EMatch LLInventorySearchIndex::Result::getMatch(const LLUUID& id) const
+{
+	if (mDirty.count(id))
+	{
+		return MATCH_UNKNOWN;
+	}
+	if (mMatches.count(id))
+	{
+		return MATCH_YES;
+	}
+	return mComplete ? MATCH_NO : MATCH_UNKNOWN;
+}
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mBuilt(false)
+{
+	gInventory.addObserver(this);
+}
+
+LLInventorySearchIndex::~LLInventorySearchIndex()
+{
+	if (gInventory.containsObserver(this))
+	{
+		gInventory.removeObserver(this);
+	}
+}
+
+// static
+U32 LLInventorySearchIndex::trigram(const std::string& str, size_t pos)
+{
+	return ((U32)(U8)str[pos] << 16) | ((U32)(U8)str[pos + 1] << 8) | (U32)(U8)str[pos + 2];
+}
+
+const std::string* LLInventorySearchIndex::getIndexedName(const LLUUID& id) const
+{
+	LLUUIDMap<U32>::const_iterator found = mRowIndex.find(id);
+	return (found != mRowIndex.end()) ? &mRows[found->second].mName : NULL;
+}
+
+void LLInventorySearchIndex::changed(U32 mask)
+{
+	if (!mBuilt)
+	{
+		// Nothing to keep up to date until the first query.
+		return;
+	}
+	if (!(mask & (LABEL | INTERNAL | ADD | REMOVE | REBUILD | CREATE | UPDATE_CREATE)))
+	{
+		return;
+	}
+
+	const LLInventoryModel::changed_items_t& changed_ids = gInventory.getChangedIDs();
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	for (const LLUUID& id : changed_ids)
+	{
+		updateObject(id);
+	}
+	lock.unlock();
+
+	for (std::vector<std::weak_ptr<Result> >::iterator it = mResults.begin(); it != mResults.end(); )
+	{
+		result_ptr_t result = it->lock();
+		if (!result)
+		{
+			it = mResults.erase(it);
+			continue;
+		}
+		for (const LLUUID& id : changed_ids)
+		{
+			result->mDirty[id] = true;
+		}
+		++it;
+	}
+}
+
+void LLInventorySearchIndex::rebuild()
+{
+	std::unique_lock<std::shared_mutex> lock(mMutex);
+	mRows.clear();
+	mFreeRows.clear();
+	mRowIndex.clear();
+	mTrigrams.clear();
+
+	const LLUUID roots[] = { gInventory.getRootFolderID(), gInventory.getLibraryRootFolderID() };
+	for (const LLUUID& root_id : roots)
+	{
+		LLViewerInventoryCategory* root = gInventory.getCategory(root_id);
+		if (!root)
+		{
+			continue;
+		}
+		addRow(root);
+
+		LLInventoryModel::cat_array_t cats;
+		LLInventoryModel::item_array_t items;
+		gInventory.collectDescendents(root_id, cats, items, LLInventoryModel::INCLUDE_TRASH);
+		mRows.reserve(mRows.size() + cats.size() + items.size());
+		for (LLViewerInventoryCategory* cat : cats)
+		{
+			addRow(cat);
+		}
+		for (LLViewerInventoryItem* item : items)
+		{
+			addRow(item);
+		}
+	}
+	mBuilt = true;
+}
+
+void LLInventorySearchIndex::updateObject(const LLUUID& id)
+{
+	LLUUIDMap<U32>::iterator found = mRowIndex.find(id);
+	if (found != mRowIndex.end())
+	{
+		removeRow(found->second);
+	}
+	LLInventoryObject* obj = gInventory.getObject(id);
+	if (obj)
+	{
+		addRow(obj);
+	}
+}
+
+void LLInventorySearchIndex::addRow(const LLInventoryObject* obj)
+{
+	U32 row_id;
+	if (!mFreeRows.empty())
+	{
+		row_id = mFreeRows.back();
+		mFreeRows.pop_back();
+	}
+	else
+	{
+		row_id = (U32)mRows.size();
+		mRows.emplace_back();
+	}
+
+	Row& row = mRows[row_id];
+	row.mID = obj->getUUID();
+	row.mName = obj->getName();
+	LLStringUtil::toUpper(row.mName);
+	const LLInventoryItem* item = dynamic_cast<const LLInventoryItem*>(obj);
+	if (item)
+	{
+		row.mType = item->getInventoryType();
+		row.mPermissions = item->getPermissions().getMaskOwner();
+		row.mCreationDate = item->getCreationDate();
+	}
+	else
+	{
+		row.mType = LLInventoryType::IT_CATEGORY;
+		row.mPermissions = PERM_ALL;
+		row.mCreationDate = 0;
+	}
+	mRowIndex[row.mID] = row_id;
+
+	for (size_t pos = 0; pos + 3 <= row.mName.size(); ++pos)
+	{
+		row_list_t& rows = mTrigrams[trigram(row.mName, pos)];
+		// A name that repeats a trigram is listed once.
+		if (rows.empty() || rows.back() != row_id)
+		{
+			rows.push_back(row_id);
+		}
+	}
+}
+
+void LLInventorySearchIndex::removeRow(U32 row_id)
+{
+	Row& row = mRows[row_id];
+	for (size_t pos = 0; pos + 3 <= row.mName.size(); ++pos)
+	{
+		std::unordered_map<U32, row_list_t>::iterator found = mTrigrams.find(trigram(row.mName, pos));
+		if (found == mTrigrams.end())
+		{
+			continue;
+		}
+		row_list_t& rows = found->second;
+		row_list_t::iterator it = std::find(rows.begin(), rows.end(), row_id);
+		if (it != rows.end())
+		{
+			*it = rows.back();
+			rows.pop_back();
+		}
+		if (rows.empty())
+		{
+			mTrigrams.erase(found);
+		}
+	}
+
+	mRowIndex.erase(mRowIndex.find(row.mID));
+	row.mID.setNull();
+	row.mName.clear();
+	mFreeRows.push_back(row_id);
+}
+
+bool LLInventorySearchIndex::rowMatches(const Row& row, const Query& query) const
+{
+	if (row.mID.isNull())
+	{
+		return false;
+	}
+	if (row.mType >= 0 && !(query.mObjectTypes & (1ULL << row.mType)))
+	{
+		return false;
+	}
+	if ((row.mPermissions & query.mPermissions) != query.mPermissions)
+	{
+		return false;
+	}
+	if ((query.mMinDate || query.mMaxDate)
+		&& (row.mCreationDate < query.mMinDate || row.mCreationDate > query.mMaxDate))
+	{
+		return false;
+	}
+	return query.mSubString.empty() || row.mName.find(query.mSubString) != std::string::npos;
+}
+
+LLInventorySearchIndex::result_ptr_t LLInventorySearchIndex::query(const Query& query)
+{
+	if (!mBuilt)
+	{
+		rebuild();
+	}
+
+	mResults.erase(std::remove_if(mResults.begin(), mResults.end(),
+								  [](const std::weak_ptr<Result>& ptr) { return ptr.expired(); }),
+				   mResults.end());
+	result_ptr_t result = std::make_shared<Result>(query);
+	mResults.push_back(result);
+
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!general_queue || !general_queue->post([this, result]() { search(result); }))
+	{
+		// No worker to hand it to: search right here.
+		search(result);
+	}
+	return result;
+}
+
+void LLInventorySearchIndex::search(result_ptr_t result)
+{
+	const Query& query = result->getQuery();
+	LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+
+	// Hands a batch of matches to the main thread, or adds it in place when
+	// there is no main loop queue to post to.
+	auto deliver = [main_queue, result](const uuid_vec_t& matches, bool complete)
+	{
+		auto add = [result, matches, complete]()
+		{
+			for (const LLUUID& id : matches)
+			{
+				result->mMatches[id] = true;
+			}
+			result->mComplete = complete;
+		};
+		if (!main_queue || !main_queue->post(add))
+		{
+			add();
+		}
+	};
+
+	// Only rows holding every trigram of the string can match. Start from
+	// the shortest list of them; without trigrams, every row is a candidate.
+	row_list_t candidates;
+	{
+		std::shared_lock<std::shared_mutex> lock(mMutex);
+		const row_list_t* shortest = NULL;
+		bool any_trigram = false;
+		for (size_t pos = 0; pos + 3 <= query.mSubString.size(); ++pos)
+		{
+			any_trigram = true;
+			std::unordered_map<U32, row_list_t>::const_iterator found = mTrigrams.find(trigram(query.mSubString, pos));
+			if (found == mTrigrams.end())
+			{
+				shortest = NULL;
+				break;
+			}
+			if (!shortest || found->second.size() < shortest->size())
+			{
+				shortest = &found->second;
+			}
+		}
+		if (shortest)
+		{
+			candidates = *shortest;
+		}
+		else if (!any_trigram)
+		{
+			candidates.reserve(mRows.size());
+			for (U32 row_id = 0; row_id < (U32)mRows.size(); ++row_id)
+			{
+				candidates.push_back(row_id);
+			}
+		}
+	}
+
+	// Rows may change between batches; each row is checked against its
+	// current contents, and the main thread marks the changed ones dirty.
+	size_t next = 0;
+	do
+	{
+		if (result->isCancelled())
+		{
+			return;
+		}
+		uuid_vec_t matches;
+		{
+			std::shared_lock<std::shared_mutex> lock(mMutex);
+			size_t end = llmin(next + SEARCH_BATCH_SIZE, candidates.size());
+			for ( ; next < end; ++next)
+			{
+				U32 row_id = candidates[next];
+				if (row_id < mRows.size() && rowMatches(mRows[row_id], query))
+				{
+					matches.push_back(mRows[row_id].mID);
+				}
+			}
+		}
+		deliver(matches, next >= candidates.size());
+	}
+	while (next < candidates.size());
+}
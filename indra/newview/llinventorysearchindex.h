@@ -0,0 +1,152 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Name index of the agent's inventory, queried off the main thread.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include "llinventoryobserver.h"
+#include "llinventorytype.h"
+#include "llpermissionsflags.h"
+#include "llsingleton.h"
+#include "lluuidmap.h"
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventorySearchIndex
+//
+// Keeps one row per inventory object with its upper case name (the case
+// LLInventoryFilter searches in), inventory type, owner permissions and
+// creation date, plus a trigram index over the names. The rows are kept up
+// to date from inventory observer notifications on the main thread.
+//
+// query() runs on the "General" thread pool. Matches are handed back to the
+// main thread in batches, so a filter can start using them before the whole
+// inventory has been searched.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventorySearchIndex : public LLInventoryObserver, public LLSingleton<LLInventorySearchIndex>
+{
+	LLSINGLETON(LLInventorySearchIndex);
+	virtual ~LLInventorySearchIndex();
+
+public:
+	struct Query
+	{
+		Query()
+		:	mObjectTypes(~0ULL),
+			mPermissions(PERM_NONE),
+			mMinDate(0),
+			mMaxDate(0)
+		{}
+
+		std::string		mSubString;		// upper case; empty matches every name
+		U64				mObjectTypes;	// bit (1 << LLInventoryType::EType) per accepted type
+		PermissionMask	mPermissions;	// owner permissions every match must have
+		time_t			mMinDate;		// creation date range, ignored when both are 0
+		time_t			mMaxDate;
+	};
+
+	enum EMatch
+	{
+		MATCH_UNKNOWN,	// not searched yet, or changed since
+		MATCH_YES,
+		MATCH_NO
+	};
+
+	// Matches of one query. Only ever touched on the main thread, apart from
+	// the cancelled flag.
+	class Result
+	{
+	public:
+		Result(const Query& query) : mQuery(query), mComplete(false), mCancelled(false) {}
+
+		const Query& getQuery() const { return mQuery; }
+		bool isComplete() const { return mComplete; }
+		EMatch getMatch(const LLUUID& id) const;
+
+		// Stops the search at the next batch. The filter that started the
+		// query calls this when it moves on to a different string.
+		void cancel() { mCancelled = true; }
+		bool isCancelled() const { return mCancelled; }
+
+	private:
+		friend class LLInventorySearchIndex;
+
+		const Query			mQuery;
+		LLUUIDMap<bool>		mMatches;
+		LLUUIDMap<bool>		mDirty;		// objects changed after the search started
+		bool				mComplete;
+		std::atomic<bool>	mCancelled;
+	};
+	typedef std::shared_ptr<Result> result_ptr_t;
+
+	result_ptr_t query(const Query& query);
+
+	// Name the index holds for id, or NULL. Main thread only.
+	const std::string* getIndexedName(const LLUUID& id) const;
+
+	virtual void changed(U32 mask) override;
+
+private:
+	struct Row
+	{
+		LLUUID					mID;
+		std::string				mName;
+		LLInventoryType::EType	mType;
+		PermissionMask			mPermissions;
+		time_t					mCreationDate;
+	};
+	typedef std::vector<U32> row_list_t;
+
+	void rebuild();
+	void updateObject(const LLUUID& id);
+	void addRow(const class LLInventoryObject* obj);
+	void removeRow(U32 row);
+	bool rowMatches(const Row& row, const Query& query) const;
+
+	// Runs on a worker thread.
+	void search(result_ptr_t result);
+
+	static U32 trigram(const std::string& str, size_t pos);
+
+	// Written on the main thread only, so the main thread reads without
+	// locking. The worker takes a shared lock.
+	mutable std::shared_mutex	mMutex;
+	std::vector<Row>			mRows;		// a null mID marks a free row
+	row_list_t					mFreeRows;
+	LLUUIDMap<U32>				mRowIndex;
+	std::unordered_map<U32, row_list_t> mTrigrams;
+	bool						mBuilt;
+
+	// Live results, told about objects that change after they were searched.
+	std::vector<std::weak_ptr<Result> > mResults;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
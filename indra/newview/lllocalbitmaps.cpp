@@ -45,7 +45,12 @@
 #include <time.h>
 #include <ctime>
 
+#include <atomic>
+
 /* misc headers */
+#include "llappviewer.h"
+#include "llfilewatcher.h"
+#include "llimageworker.h"
 #include "llgltfmaterial.h"
 #include "llscrolllistctrl.h"
 #include "lllocaltextureobject.h"
@@ -81,6 +86,38 @@ static const S32 LL_LOCAL_UPDATE_RETRIES    = 5;
 /*=======================================*/
 /*  LLLocalBitmap: unit class            */
 /*=======================================*/ 
+
+// Receives a re-decoded file from the image decode pool, scaled there as well.
+class LLLocalBitmap::DecodeResponder : public LLImageDecodeThread::Responder
+{
+public:
+	DecodeResponder(bool rgb_only)
+		: mRGBOnly(rgb_only)
+		, mDone(false)
+	{
+	}
+
+	// called on a decode pool thread
+	void completed(bool success, LLImageRaw* raw, LLImageRaw* aux) override
+	{
+		if (success && raw && (!mRGBOnly || (raw->getComponents() == 3) || (raw->getComponents() == 4)))
+		{
+			raw->biasedScaleToPowerOfTwo(LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT);
+			mRawImage = raw;
+		}
+		mDone = true;
+	}
+
+	bool isDone() const { return mDone; }
+	// null if the decode failed, only valid once isDone()
+	LLPointer<LLImageRaw> getRawImage() const { return mRawImage; }
+
+private:
+	bool mRGBOnly;
+	LLPointer<LLImageRaw> mRawImage;
+	std::atomic<bool> mDone;
+};
+
 LLLocalBitmap::LLLocalBitmap(std::string filename)
 	: mFilename(filename)
 	, mShortName(gDirUtilp->getBaseFileName(filename, true))
@@ -88,6 +125,8 @@ LLLocalBitmap::LLLocalBitmap(std::string filename)
 	, mLastModified()
 	, mLinkStatus(LS_ON)
 	, mUpdateRetries(LL_LOCAL_UPDATE_RETRIES)
+	, mWatched(false)
+	, mWatchChanges(0)
 {
 	mTrackingID.generate();
 
@@ -117,6 +156,9 @@ LLLocalBitmap::LLLocalBitmap(std::string filename)
 		return; // no valid extension.
 	}
 
+	LLFileWatcher::instance().watch(mFilename);
+	mWatched = true;
+
 	/* next phase of unit creation is nearly the same as an update cycle.
 	   we're running updateSelf as a special case with the optional UT_FIRSTUSE
 	   which omits the parts associated with removing the outdated texture */
@@ -125,6 +167,11 @@ LLLocalBitmap::LLLocalBitmap(std::string filename)
 
 LLLocalBitmap::~LLLocalBitmap()
 {
+	if (mWatched && LLFileWatcher::instanceExists())
+	{
+		LLFileWatcher::instance().unwatch(mFilename);
+	}
+
 	// replace IDs with defaults, if set to do so.
 	if(LL_LOCAL_REPLACE_ON_DEL && mValid && gAgentAvatarp) // fix for STORM-1837
 	{
@@ -183,6 +230,27 @@ bool LLLocalBitmap::updateSelf(EUpdateType optional_firstupdate)
 	
 	if (mLinkStatus == LS_ON)
 	{
+		if (mDecodeResponder.notNull())
+		{
+			// a changed file is being decoded on the image decode pool, pick it up once it's done
+			if (!mDecodeResponder->isDone())
+			{
+				return false;
+			}
+			LLPointer<LLImageRaw> raw_image = mDecodeResponder->getRawImage();
+			mDecodeResponder = NULL;
+			return applyBitmap(raw_image, mDecodeModified, optional_firstupdate);
+		}
+
+		// nothing to look at if the file watcher saw no change, unless a failed decode is being retried
+		U32 changes = 0;
+		bool watching = LLFileWatcher::instance().getChangeCount(mFilename, changes);
+		if (watching && (changes == mWatchChanges) && (mUpdateRetries == LL_LOCAL_UPDATE_RETRIES))
+		{
+			return false;
+		}
+		mWatchChanges = watching ? changes : 0;
+
 		// verifying that the file exists
 		if (gDirUtilp->fileExists(mFilename))
 		{
@@ -197,70 +265,33 @@ bool LLLocalBitmap::updateSelf(EUpdateType optional_firstupdate)
 
 			if (mLastModified.asString() != new_last_modified.asString())
 			{
-				/* loading the image file and decoding it, here is a critical point which,
-				   if fails, invalidates the whole update (or unit creation) process. */
-				LLPointer<LLImageRaw> raw_image = new LLImageRaw();
-				if (decodeBitmap(raw_image))
+				LLImageDecodeThread* decode_thread = LLAppViewer::getImageDecodeThread();
+				if ((optional_firstupdate == UT_FIRSTUSE) || !decode_thread)
 				{
-					// decode is successful, we can safely proceed.
-					LLUUID old_id = LLUUID::null;
-					if ((optional_firstupdate != UT_FIRSTUSE) && !mWorldID.isNull())
+					/* loading the image file and decoding it, here is a critical point which,
+					   if fails, invalidates the whole update (or unit creation) process. */
+					LLPointer<LLImageRaw> raw_image = new LLImageRaw();
+					if (!decodeBitmap(raw_image))
 					{
-						old_id = mWorldID;
+						raw_image = NULL;
 					}
-					mWorldID.generate();
-					mLastModified = new_last_modified;
-
-					LLPointer<LLViewerFetchedTexture> texture = new LLViewerFetchedTexture
-						("file://"+mFilename, FTT_LOCAL_FILE, mWorldID, LL_LOCAL_USE_MIPMAPS);
-
-					texture->createGLTexture(LL_LOCAL_DISCARD_LEVEL, raw_image);
-					texture->setCachedRawImage(LL_LOCAL_DISCARD_LEVEL, raw_image);
-					texture->ref(); 
-
-					gTextureList.addImage(texture, TEX_LIST_STANDARD);
-			
-					if (optional_firstupdate != UT_FIRSTUSE)
-					{
-						// seek out everything old_id uses and replace it with mWorldID
-						replaceIDs(old_id, mWorldID);
-
-						// remove old_id from gimagelist
-						LLViewerFetchedTexture* image = gTextureList.findImage(old_id, TEX_LIST_STANDARD);
-						if (image != NULL)
-						{
-							gTextureList.deleteImage(image);
-							image->unref();
-						}
-					}
-
-					mUpdateRetries = LL_LOCAL_UPDATE_RETRIES;
-					updated = true;
+					updated = applyBitmap(raw_image, new_last_modified, optional_firstupdate);
 				}
-
-				// if decoding failed, we get here and it will attempt to decode it in the next cycles
-				// until mUpdateRetries runs out. this is done because some software lock the bitmap while writing to it
 				else
 				{
-					if (mUpdateRetries)
+					// later updates only read the file here, the decode and scaling run on the image decode pool
+					LLPointer<LLImageFormatted> image = loadBitmap();
+					if (image.notNull())
 					{
-						mUpdateRetries--;
+						mDecodeResponder = new DecodeResponder(mExtension == ET_IMG_TGA);
+						mDecodeModified = new_last_modified;
+						decode_thread->decodeImage(image, LL_LOCAL_DISCARD_LEVEL, FALSE, LLPointer<LLImageDecodeThread::Responder>(mDecodeResponder));
 					}
 					else
 					{
-						LL_WARNS() << "During the update process the following file was found" << "\n"
-							    << "but could not be opened or decoded for " << LL_LOCAL_UPDATE_RETRIES << " attempts." << "\n"
-								<< "Filename: " << mFilename << "\n"
-								<< "Disabling further update attempts for this file." << LL_ENDL;
-
-						LLSD notif_args;
-						notif_args["FNAME"] = mFilename;
-						notif_args["NRETRIES"] = LL_LOCAL_UPDATE_RETRIES;
-						LLNotificationsUtil::add("LocalBitmapsUpdateFailedFinal", notif_args);
-
-						mLinkStatus = LS_BROKEN;
+						applyBitmap(NULL, new_last_modified, optional_firstupdate);
 					}
-				}		
+				}
 			}
 			
 		} // end if file exists
@@ -282,6 +313,75 @@ bool LLLocalBitmap::updateSelf(EUpdateType optional_firstupdate)
 	return updated;
 }
 
+bool LLLocalBitmap::applyBitmap(LLPointer<LLImageRaw> raw_image, const LLSD& new_last_modified, EUpdateType optional_firstupdate)
+{
+	bool updated = false;
+
+	if (raw_image.notNull())
+	{
+		// decode is successful, we can safely proceed.
+		LLUUID old_id = LLUUID::null;
+		if ((optional_firstupdate != UT_FIRSTUSE) && !mWorldID.isNull())
+		{
+			old_id = mWorldID;
+		}
+		mWorldID.generate();
+		mLastModified = new_last_modified;
+
+		LLPointer<LLViewerFetchedTexture> texture = new LLViewerFetchedTexture
+			("file://"+mFilename, FTT_LOCAL_FILE, mWorldID, LL_LOCAL_USE_MIPMAPS);
+
+		texture->createGLTexture(LL_LOCAL_DISCARD_LEVEL, raw_image);
+		texture->setCachedRawImage(LL_LOCAL_DISCARD_LEVEL, raw_image);
+		texture->ref(); 
+
+		gTextureList.addImage(texture, TEX_LIST_STANDARD);
+
+		if (optional_firstupdate != UT_FIRSTUSE)
+		{
+			// seek out everything old_id uses and replace it with mWorldID
+			replaceIDs(old_id, mWorldID);
+
+			// remove old_id from gimagelist
+			LLViewerFetchedTexture* image = gTextureList.findImage(old_id, TEX_LIST_STANDARD);
+			if (image != NULL)
+			{
+				gTextureList.deleteImage(image);
+				image->unref();
+			}
+		}
+
+		mUpdateRetries = LL_LOCAL_UPDATE_RETRIES;
+		updated = true;
+	}
+
+	// if decoding failed, we get here and it will attempt to decode it in the next cycles
+	// until mUpdateRetries runs out. this is done because some software lock the bitmap while writing to it
+	else
+	{
+		if (mUpdateRetries)
+		{
+			mUpdateRetries--;
+		}
+		else
+		{
+			LL_WARNS() << "During the update process the following file was found" << "\n"
+				    << "but could not be opened or decoded for " << LL_LOCAL_UPDATE_RETRIES << " attempts." << "\n"
+					<< "Filename: " << mFilename << "\n"
+					<< "Disabling further update attempts for this file." << LL_ENDL;
+
+			LLSD notif_args;
+			notif_args["FNAME"] = mFilename;
+			notif_args["NRETRIES"] = LL_LOCAL_UPDATE_RETRIES;
+			LLNotificationsUtil::add("LocalBitmapsUpdateFailedFinal", notif_args);
+
+			mLinkStatus = LS_BROKEN;
+		}
+	}
+
+	return updated;
+}
+
 boost::signals2::connection LLLocalBitmap::setChangedCallback(const LLLocalTextureCallback& cb)
 {
     return mChangedSignal.connect(cb);
@@ -317,54 +417,33 @@ void LLLocalBitmap::addGLTFMaterial(LLGLTFMaterial* mat)
     mGLTFMaterialWithLocalTextures.push_back(mat);
 }
 
-bool LLLocalBitmap::decodeBitmap(LLPointer<LLImageRaw> rawimg)
+LLPointer<LLImageFormatted> LLLocalBitmap::loadBitmap()
 {
-	bool decode_successful = false;
+	LLPointer<LLImageFormatted> image;
 
 	switch (mExtension)
 	{
 		case ET_IMG_BMP:
 		{
-			LLPointer<LLImageBMP> bmp_image = new LLImageBMP;
-			if (bmp_image->load(mFilename) && bmp_image->decode(rawimg, 0.0f))
-			{
-				rawimg->biasedScaleToPowerOfTwo(LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT);
-				decode_successful = true;
-			}
+			image = new LLImageBMP;
 			break;
 		}
 
 		case ET_IMG_TGA:
 		{
-			LLPointer<LLImageTGA> tga_image = new LLImageTGA;
-			if ((tga_image->load(mFilename) && tga_image->decode(rawimg))
-			&& ((tga_image->getComponents() == 3) || (tga_image->getComponents() == 4)))
-			{
-				rawimg->biasedScaleToPowerOfTwo(LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT);
-				decode_successful = true;
-			}
+			image = new LLImageTGA;
 			break;
 		}
 
 		case ET_IMG_JPG:
 		{
-			LLPointer<LLImageJPEG> jpeg_image = new LLImageJPEG;
-			if (jpeg_image->load(mFilename) && jpeg_image->decode(rawimg, 0.0f))
-			{
-				rawimg->biasedScaleToPowerOfTwo(LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT);
-				decode_successful = true;
-			}
+			image = new LLImageJPEG;
 			break;
 		}
 
 		case ET_IMG_PNG:
 		{
-			LLPointer<LLImagePNG> png_image = new LLImagePNG;
-			if (png_image->load(mFilename) && png_image->decode(rawimg, 0.0f))
-			{
-				rawimg->biasedScaleToPowerOfTwo(LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT);
-				decode_successful = true;
-			}
+			image = new LLImagePNG;
 			break;
 		}
 
@@ -378,10 +457,33 @@ bool LLLocalBitmap::decodeBitmap(LLPointer<LLImageRaw> rawimg)
 			LL_WARNS() << "Filename: " << mFilename << LL_ENDL;
 		    LL_WARNS() << "Disabling further update attempts for this file." << LL_ENDL;
 			mLinkStatus = LS_BROKEN;
+			return NULL;
 		}
 	}
 
-	return decode_successful;
+	if (!image->load(mFilename))
+	{
+		return NULL;
+	}
+	return image;
+}
+
+bool LLLocalBitmap::decodeBitmap(LLPointer<LLImageRaw> rawimg)
+{
+	LLPointer<LLImageFormatted> image = loadBitmap();
+	if (image.isNull() || !image->decode(rawimg, 0.0f))
+	{
+		return false;
+	}
+
+	// targa can hold other than rgb(a)
+	if ((mExtension == ET_IMG_TGA) && (image->getComponents() != 3) && (image->getComponents() != 4))
+	{
+		return false;
+	}
+
+	rawimg->biasedScaleToPowerOfTwo(LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT);
+	return true;
 }
 
 void LLLocalBitmap::replaceIDs(const LLUUID& old_id, LLUUID new_id)
@@ -34,6 +34,7 @@
 #include "llwearabletype.h"
 
 class LLScrollListCtrl;
+class LLImageFormatted;
 class LLImageRaw;
 class LLViewerObject;
 class LLGLTFMaterial;
@@ -68,7 +69,10 @@ class LLLocalBitmap
         void addGLTFMaterial(LLGLTFMaterial* mat);
 
 	private: /* self update private section */
+		class DecodeResponder;
+		LLPointer<LLImageFormatted> loadBitmap();
 		bool decodeBitmap(LLPointer<LLImageRaw> raw);
+		bool applyBitmap(LLPointer<LLImageRaw> raw, const LLSD& last_modified, EUpdateType type);
         void replaceIDs(const LLUUID &old_id, LLUUID new_id);
 		std::vector<LLViewerObject*> prepUpdateObjects(LLUUID old_id, U32 channel);
 		void updateUserPrims(LLUUID old_id, LLUUID new_id, U32 channel);
@@ -102,6 +106,10 @@ class LLLocalBitmap
 		EExtension  mExtension;
 		ELinkStatus mLinkStatus;
 		S32         mUpdateRetries;
+		bool        mWatched;       // registered with LLFileWatcher
+		U32         mWatchChanges;  // LLFileWatcher change count at the last look at the file
+		LLPointer<DecodeResponder> mDecodeResponder; // re-decode of a changed file in flight
+		LLSD        mDecodeModified; // modification time of the file being decoded
         LLLocalTextureChangedSignal	mChangedSignal;
 
         // Store a list of accosiated materials
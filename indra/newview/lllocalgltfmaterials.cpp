@@ -39,6 +39,7 @@
 #include <ctime>
 
 /* misc headers */
+#include "llfilewatcher.h"
 #include "llgltfmateriallist.h"
 #include "llimage.h"
 #include "llinventoryicon.h"
@@ -66,6 +67,8 @@ LLLocalGLTFMaterial::LLLocalGLTFMaterial(std::string filename, S32 index)
     , mLinkStatus(LS_ON)
     , mUpdateRetries(LL_LOCAL_UPDATE_RETRIES)
     , mMaterialIndex(index)
+    , mWatched(false)
+    , mWatchChanges(0)
 {
     mTrackingID.generate();
 
@@ -86,10 +89,18 @@ LLLocalGLTFMaterial::LLLocalGLTFMaterial(std::string filename, S32 index)
             << "Filename: " << mFilename << LL_ENDL;
         return; // no valid extension.
     }
+
+    LLFileWatcher::instance().watch(mFilename);
+    mWatched = true;
 }
 
 LLLocalGLTFMaterial::~LLLocalGLTFMaterial()
 {
+    if (mWatched && LLFileWatcher::instanceExists())
+    {
+        LLFileWatcher::instance().unwatch(mFilename);
+    }
+
     // gGLTFMaterialList will clean itself
 }
 
@@ -126,6 +137,15 @@ bool LLLocalGLTFMaterial::updateSelf()
 
     if (mLinkStatus == LS_ON)
     {
+        // nothing to look at if the file watcher saw no change, unless a failed load is being retried
+        U32 changes = 0;
+        bool watching = LLFileWatcher::instance().getChangeCount(mFilename, changes);
+        if (watching && (changes == mWatchChanges) && (mUpdateRetries == LL_LOCAL_UPDATE_RETRIES))
+        {
+            return false;
+        }
+        mWatchChanges = watching ? changes : 0;
+
         // verifying that the file exists
         if (gDirUtilp->fileExists(mFilename))
         {
@@ -78,6 +78,8 @@ private: /* members */
     ELinkStatus mLinkStatus;
     S32         mUpdateRetries;
     S32         mMaterialIndex; // Single file can have more than one
+    bool        mWatched;       // registered with LLFileWatcher
+    U32         mWatchChanges;  // LLFileWatcher change count at the last look at the file
 };
 
 class LLLocalGLTFMaterialTimer : public LLEventTimer
@@ -425,8 +425,10 @@ LLLocationInputCtrl::LLLocationInputCtrl(const LLLocationInputCtrl::Params& p)
 
 	mRemoveLandmarkObserver	= new LLRemoveLandmarkObserver(this);
 	mAddLandmarkObserver	= new LLAddLandmarkObserver(this);
-	gInventory.addObserver(mRemoveLandmarkObserver);
-	gInventory.addObserver(mAddLandmarkObserver);
+	gInventory.addObserver(mRemoveLandmarkObserver,
+		~(LLInventoryObserver::LABEL | LLInventoryObserver::INTERNAL | LLInventoryObserver::ADD
+		  | LLInventoryObserver::CREATE | LLInventoryObserver::UPDATE_CREATE));
+	gInventory.addObserver(mAddLandmarkObserver, LLInventoryObserver::ADD);
 
 	mParcelChangeObserver = new LLParcelChangeObserver(this);
 	LLViewerParcelMgr::getInstance()->addObserver(mParcelChangeObserver);
@@ -144,6 +144,44 @@ const char* remove_utf8_bom(const char* buf)
 	return start;
 }
 
+// Side file holding the offset of every message in a transcript, so a range
+// of messages can be read without parsing the file from the start.
+std::string make_history_index_name(const std::string& log_file_name)
+{
+	return log_file_name + ".idx";
+}
+
+// Seeks to the messages selected by the "first_message" and "message_count"
+// load params. Returns false when no range was asked for or the transcript
+// has no usable index; end_offset is -1 when the range runs to end of file.
+bool seek_to_message_range(LLFILE* fptr, const std::string& log_file_name, const LLSD& load_params, S64& end_offset)
+{
+	end_offset = -1;
+	if (!load_params.has("message_count"))
+	{
+		return false;
+	}
+
+	std::vector<S64> offsets;
+	if (!LLLogChat::loadHistoryIndex(log_file_name, offsets) || offsets.empty())
+	{
+		return false;
+	}
+
+	size_t first = (size_t)llmax(load_params["first_message"].asInteger(), 0);
+	size_t last = first + (size_t)llmax(load_params["message_count"].asInteger(), 0);
+	if (first >= offsets.size())
+	{
+		// Nothing in range: park at end of file.
+		return 0 == fseek(fptr, 0, SEEK_END);
+	}
+	if (last < offsets.size())
+	{
+		end_offset = offsets[last];
+	}
+	return 0 == fseek(fptr, (long)offsets[first], SEEK_SET);
+}
+
 class LLLogChatTimeScanner: public LLSingleton<LLLogChatTimeScanner>
 {
 	LLSINGLETON(LLLogChatTimeScanner);
@@ -301,6 +339,7 @@ void LLLogChat::renameLogFile(const std::string& old_filename, const std::string
     if (!LLFile::isfile(new_name) && LLFile::isfile(old_name))
     {
         LLFile::rename(old_name, new_name);
+        LLFile::remove(make_history_index_name(old_name));
     }
 }
 
@@ -364,7 +403,18 @@ void LLLogChat::saveHistory(const std::string& filename,
 		return;
 	}
 
-	llofstream file(LLLogChat::makeLogFileName(filename).c_str(), std::ios_base::app);
+	std::string log_file_name = LLLogChat::makeLogFileName(filename);
+	std::string index_file_name = make_history_index_name(log_file_name);
+
+	// Extend the index only while it still covers the whole transcript;
+	// otherwise it is rebuilt the next time a range is read.
+	llstat log_stat;
+	llstat index_stat;
+	bool extend_index = !LLFile::stat(log_file_name, &log_stat)
+		&& !LLFile::stat(index_file_name, &index_stat)
+		&& index_stat.st_mtime >= log_stat.st_mtime;
+
+	llofstream file(log_file_name.c_str(), std::ios_base::app);
 	if (!file.is_open())
 	{
 		LL_WARNS() << "Couldn't open chat history log! - " + filename << LL_ENDL;
@@ -393,6 +443,16 @@ void LLLogChat::saveHistory(const std::string& filename,
 
 	file.close();
 
+	if (extend_index)
+	{
+		llofstream index(index_file_name, std::ios_base::app | std::ios_base::binary);
+		if (index.is_open())
+		{
+			S64 offset = log_stat.st_size;
+			index.write((const char*)&offset, sizeof(offset));
+		}
+	}
+
 	LLLogChat::getInstance()->triggerHistorySignal();
 }
 
@@ -459,8 +519,13 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
 	char *bptr;
 	S32 len;
 	bool firstline = TRUE;
+	S64 end_offset = -1;
 
-	if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
+	if (seek_to_message_range(fptr, log_file_name, load_params, end_offset))
+	{	// Index gave us the exact start of the first message asked for.
+		firstline = FALSE;
+	}
+	else if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
 	{	//We need to load the whole historyFile or it's smaller than recall size, so get it all.
 		firstline = FALSE;
 		if (fseek(fptr, 0, SEEK_SET))
@@ -469,7 +534,7 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
 			return;
 		}
 	}
-	while (fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
+	while ((end_offset < 0 || ftell(fptr) < end_offset) && fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
 	{
 		len = strlen(buffer) - 1;		/*Flawfinder: ignore*/
         // backfill any end of line characters with nulls
@@ -511,6 +576,86 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
         << " file mod time " << (F64)stat_data.st_mtime << LL_ENDL;
 }
 
+// static
+bool LLLogChat::loadHistoryIndex(const std::string& log_file_name, std::vector<S64>& offsets, bool rebuild_if_stale)
+{
+	offsets.clear();
+
+	llstat log_stat;
+	if (LLFile::stat(log_file_name, &log_stat))
+	{
+		return false;
+	}
+
+	std::string index_file_name = make_history_index_name(log_file_name);
+	llstat index_stat;
+	if (!LLFile::stat(index_file_name, &index_stat) && index_stat.st_mtime >= log_stat.st_mtime)
+	{
+		llifstream index(index_file_name, std::ios_base::binary);
+		if (index.is_open())
+		{
+			offsets.resize(index_stat.st_size / sizeof(S64));
+			if (!offsets.empty())
+			{
+				index.read((char*)&offsets[0], offsets.size() * sizeof(S64));
+			}
+			if (index && (offsets.empty() || offsets.back() < (S64)log_stat.st_size))
+			{
+				return true;
+			}
+		}
+		offsets.clear();
+	}
+
+	if (!rebuild_if_stale)
+	{
+		return false;
+	}
+
+	// Same rules the loaders use: a line starting with a space, or an empty
+	// line, continues the previous message.
+	LLFILE* fptr = LLFile::fopen(log_file_name, "r");		/*Flawfinder: ignore*/
+	if (!fptr)
+	{
+		return false;
+	}
+	char buffer[LOG_RECALL_SIZE];		/*Flawfinder: ignore*/
+	bool line_start = true;
+	S64 offset = ftell(fptr);
+	while (fgets(buffer, LOG_RECALL_SIZE, fptr))
+	{
+		const char* line = (0 == offset) ? remove_utf8_bom(buffer) : buffer;
+		if (line_start && ' ' != line[0] && '\n' != line[0] && '\r' != line[0])
+		{
+			offsets.push_back(offset);
+		}
+		// A line longer than the buffer comes back in pieces.
+		size_t len = strlen(buffer);		/*Flawfinder: ignore*/
+		line_start = len > 0 && '\n' == buffer[len - 1];
+		offset = ftell(fptr);
+	}
+	fclose(fptr);
+
+	std::string temp_name = index_file_name + ".tmp";
+	{
+		llofstream index(temp_name, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+		if (!index.is_open())
+		{
+			return true;
+		}
+		if (!offsets.empty())
+		{
+			index.write((const char*)&offsets[0], offsets.size() * sizeof(S64));
+		}
+	}
+	LLFile::remove(index_file_name);
+	if (LLFile::rename(temp_name, index_file_name))
+	{
+		LLFile::remove(temp_name);
+	}
+	return true;
+}
+
 bool LLLogChat::historyThreadsFinished(LLUUID session_id)
 {
 	LLMutexLock lock(historyThreadsMutex());
@@ -806,6 +951,7 @@ void LLLogChat::deleteTranscripts()
 				{
 					LL_WARNS("LLLogChat::deleteTranscripts") << "Successfully removed " << fullpath << LL_ENDL;
 				}
+				LLFile::remove(make_history_index_name(fullpath));
 				break;
 			}			
 		}
@@ -1124,6 +1270,13 @@ void LLLoadHistoryThread::run()
 		loadHistory(mFileName, mMessages, mLoadParams);
 		int count = mMessages->size();
 		LL_INFOS() << "mMessages->size(): " << count << LL_ENDL;
+		if (mLoadParams["load_all_history"].asBoolean())
+		{
+			// Index the transcript while we are off the main thread, so the
+			// next preview can read it a page at a time.
+			std::vector<S64> offsets;
+			LLLogChat::loadHistoryIndex(LLLogChat::makeLogFileName(mFileName), offsets);
+		}
 		setFinished();
 	}
 }
@@ -1171,8 +1324,13 @@ void LLLoadHistoryThread::loadHistory(const std::string& file_name, std::list<LL
 	char *bptr;
 	S32 len;
 	bool firstline = TRUE;
+	S64 end_offset = -1;
 
-	if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
+	if (seek_to_message_range(fptr, LLLogChat::makeLogFileName(file_name), load_params, end_offset))
+	{	// Index gave us the exact start of the first message asked for.
+		firstline = FALSE;
+	}
+	else if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
 	{	//We need to load the whole historyFile or it's smaller than recall size, so get it all.
 		firstline = FALSE;
 		if (fseek(fptr, 0, SEEK_SET))
@@ -1185,7 +1343,7 @@ void LLLoadHistoryThread::loadHistory(const std::string& file_name, std::list<LL
 	}
 
 
-	while (fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
+	while ((end_offset < 0 || ftell(fptr) < end_offset) && fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
 	{
 		len = strlen(buffer) - 1;		/*Flawfinder: ignore*/
 
@@ -109,6 +109,13 @@ public:
 
 	static void loadChatHistory(const std::string& file_name, std::list<LLSD>& messages, const LLSD& load_params = LLSD(), bool is_group = false);
 
+	// Offsets of the messages in a transcript, read from the index kept next
+	// to it. A missing or out of date index is rebuilt from the transcript
+	// unless rebuild_if_stale is false, in which case this returns false.
+	// The "first_message" and "message_count" load params read a range of
+	// messages through this index.
+	static bool loadHistoryIndex(const std::string& log_file_name, std::vector<S64>& offsets, bool rebuild_if_stale = true);
+
 	typedef boost::signals2::signal<void ()> save_history_signal_t;
 	boost::signals2::connection setSaveHistorySignal(const save_history_signal_t::slot_type& cb);
 
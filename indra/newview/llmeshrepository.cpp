@@ -35,6 +35,7 @@
 
 #include "llagent.h"
 #include "llappviewer.h"
+#include "llbase64.h"
 #include "llbufferstream.h"
 #include "llcallbacklist.h"
 #include "lldatapacker.h"
@@ -49,14 +50,18 @@
 #include "llsdutil_math.h"
 #include "llsdserialize.h"
 #include "llthread.h"
+#include "threadpool.h"
 #include "llfilesystem.h"
 #include "llviewercontrol.h"
+#include "llviewercamera.h"
 #include "llviewerinventory.h"
 #include "llviewermenufile.h"
 #include "llviewermessage.h"
 #include "llviewerobjectlist.h"
 #include "llviewerregion.h"
 #include "llviewerstatsrecorder.h"
+#include "llversioninfo.h"
+#include "llvocache.h"
 #include "llviewertexturelist.h"
 #include "llvolume.h"
 #include "llvolumemgr.h"
@@ -74,12 +79,11 @@
 #include "llcorehttputil.h"
 #include "lltrans.h"
 #include "llstatusbar.h"
+#include "llstreamingpriority.h"
 #include "llinventorypanel.h"
 #include "lluploaddialog.h"
 #include "llfloaterreg.h"
 
-#include "boost/iostreams/device/array.hpp"
-#include "boost/iostreams/stream.hpp"
 #include "boost/lexical_cast.hpp"
 
 #ifndef LL_WINDOWS
@@ -112,6 +116,7 @@
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
 //   decom    Worker thread for mesh decomposition requests
+//   decode   MeshDecode thread pool, inflates and unpacks LOD blocks
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
 //
@@ -152,8 +157,13 @@
 //                             onCompleted() invoked for GET
 //                               data copied
 //                               lodReceived() invoked
-//                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                                 post decode to mDecodePool
+//                             ...
+//                             decodeMeshLOD() on a decode thread
+//                               unpack data into LLVolume
+//                               write decoded faces to cache
+//                               append LoadedMesh to mLoadedQ once
+//                                 earlier LODs have been
 //                             ...
 //         notifyLoadedMeshes() invoked again
 //           scan mLoadedQ
@@ -227,6 +237,11 @@
 //     sCacheBytesWritten              "
 //     sCacheReads                     "
 //     sCacheWrites                    "
+//     sPrefetchRequestCount           "
+//     sPrefetchHits                   "
+//     sPrefetchMisses                 "
+//     sProcessedLODReads              "
+//     sFaceCompressionSavings         none            rw.main.none
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -237,6 +252,9 @@
 //     mPendingDecompositionRequests   mMeshMutex [4]  rw.main.mMeshMutex
 //     mLoadingPhysicsShapes           mMeshMutex [4]  rw.main.mMeshMutex
 //     mPendingPhysicsShapeRequests    mMeshMutex [4]  rw.main.mMeshMutex
+//     mPendingPrefetches              none            rw.main.none
+//     mPrefetchScanned                none            rw.main.none
+//     mPrefetchLODs                   none            rw.main.none
 //     mUploads                        none            rw.main.none (upload thread accessing objects)
 //     mUploadWaitList                 none            rw.main.none (upload thread accessing objects)
 //     mInventoryQ                     mMeshMutex [4]  rw.main.mMeshMutex, ro.main.none [5]
@@ -256,8 +274,16 @@
 //     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
+//     mPrefetchReqQ            mMutex        ro.repo.none [5], rw.repo.mMutex, rw.main.mMutex
+//     mPrefetchedLODs          none          rw.repo.none
+//     sPrefetchBytesPerSec     none          wo.main.none, ro.repo.none [1]
+//     sProcessedLODCache       none          wo.main.none, ro.repo.none, ro.decode.none [1]
+//     mProcessedLODVersion     none          ro.repo.none, ro.decode.none
 //     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
 //     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mDecodedMeshes           mMutex        rw.decode.mMutex
+//     mNextDeliveryID          mMutex        rw.decode.mMutex
+//     mNextDecodeID            none          rw.repo.none
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -356,6 +382,15 @@ const long LARGE_MESH_XFER_TIMEOUT = 600L;				// Seconds to complete xfer, large
 const U32 DOWNLOAD_RETRY_LIMIT = 8;
 const F32 DOWNLOAD_RETRY_DELAY = 0.5f; // seconds
 
+const F32 PREFETCH_INTERVAL = 0.5f;				// seconds between looks ahead along the camera's path
+const F32 PREFETCH_MIN_SPEED = 2.f;				// m/s, any slower and rezzing keeps up by itself
+const F32 PREFETCH_MAX_SPEED = 512.f;			// m/s, faster is a teleport or region crossing glitch
+const U32 PREFETCH_MAX_PER_UPDATE = 32;			// LODs predicted per look ahead
+const U32 PREFETCH_MAX_QUEUED = 256;			// predictions kept waiting for capacity, oldest go first
+const U32 PREFETCH_MAX_SCANNED = 16384;			// cache entries remembered as looked at
+
+const F32 FACE_COMPRESS_MIN_IDLE_TIME = 2.f;	// seconds, shortest MeshCompressIdleTime honored
+
 // Would normally like to retry on uploads as some
 // retryable failures would be recoverable.  Unfortunately,
 // the mesh service is using 500 (retryable) rather than
@@ -391,6 +426,11 @@ U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
 U32 LLMeshRepository::sCacheWrites = 0;
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
+U32 LLMeshRepository::sPrefetchRequestCount = 0;
+U32 LLMeshRepository::sPrefetchHits = 0;
+U32 LLMeshRepository::sPrefetchMisses = 0;
+U32 LLMeshRepository::sProcessedLODReads = 0;
+U64 LLMeshRepository::sFaceCompressionSavings = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
 
@@ -552,6 +592,8 @@ U32	LLMeshRepoThread::sMaxConcurrentRequests = 1;
 S32 LLMeshRepoThread::sRequestLowWater = REQUEST2_LOW_WATER_MIN;
 S32 LLMeshRepoThread::sRequestHighWater = REQUEST2_HIGH_WATER_MIN;
 S32 LLMeshRepoThread::sRequestWaterLevel = 0;
+U32 LLMeshRepoThread::sPrefetchBytesPerSec = 0;
+bool LLMeshRepoThread::sProcessedLODCache = true;
 
 // Base handler class for all mesh users of llcorehttp.
 // This is roughly equivalent to a Responder class in
@@ -585,10 +627,14 @@ public:
 		  mHttpHandle(LLCORE_HTTP_HANDLE_INVALID),
 		  mOffset(offset),
 		  mRequestedBytes(requested_bytes)
-		{}
+		{
+			LLStreamingPriority::addInFlight(LLStreamingPriority::STREAM_MESH, requested_bytes);
+		}
 
 	virtual ~LLMeshHandlerBase()
-		{}
+		{
+			LLStreamingPriority::removeInFlight(LLStreamingPriority::STREAM_MESH, mRequestedBytes);
+		}
 
 protected:
 	LLMeshHandlerBase(const LLMeshHandlerBase &);				// Not defined
@@ -640,9 +686,10 @@ class LLMeshLODHandler : public LLMeshHandlerBase
 {
 public:
 	LOG_CLASS(LLMeshLODHandler);
-	LLMeshLODHandler(const LLVolumeParams & mesh_params, S32 lod, U32 offset, U32 requested_bytes)
+	LLMeshLODHandler(const LLVolumeParams & mesh_params, S32 lod, U32 offset, U32 requested_bytes, bool prefetch = false)
 		: LLMeshHandlerBase(offset, requested_bytes),
-		  mLOD(lod)
+		  mLOD(lod),
+		  mPrefetch(prefetch)
 	{
 			mMeshParams = mesh_params;
 			LLMeshRepoThread::incActiveLODRequests();
@@ -659,6 +706,7 @@ public:
 
 public:
 	S32 mLOD;
+	bool mPrefetch;		// only fill in the cache, nothing is waiting on it
 };
 
 
@@ -828,7 +876,11 @@ LLMeshRepoThread::LLMeshRepoThread()
   mHttpLargeOptions(),
   mHttpHeaders(),
   mHttpPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
-  mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID)
+  mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
+  mPrefetchBudget(0.f),
+  mNextDecodeID(0),
+  mNextDeliveryID(0),
+  mDecodePool(NULL)
 {
 	LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
 
@@ -846,6 +898,13 @@ LLMeshRepoThread::LLMeshRepoThread()
 	mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_VND_LL_MESH);
 	mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
 	mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+	// decode is the slow part of loading a mesh, let several go at once.
+	// Width can be overridden with "MeshDecode" in ThreadPoolSizes
+	mDecodePool = new LL::ThreadPool("MeshDecode", 2);
+	mDecodePool->start();
+
+	mProcessedLODVersion = LLVersionInfo::instance().getChannelAndVersion();
 }
 
 
@@ -854,8 +913,19 @@ LLMeshRepoThread::~LLMeshRepoThread()
 	LL_INFOS(LOG_MESH) << "Small GETs issued:  " << LLMeshRepository::sHTTPRequestCount
 					   << ", Large GETs issued:  " << LLMeshRepository::sHTTPLargeRequestCount
 					   << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
+					   << ", Prefetches:  " << LLMeshRepository::sPrefetchRequestCount
+					   << ", Prefetch Hits/Misses:  " << LLMeshRepository::sPrefetchHits
+					   << "/" << LLMeshRepository::sPrefetchMisses
+					   << ", Processed LOD Reads:  " << LLMeshRepository::sProcessedLODReads
 					   << LL_ENDL;
 
+	if (mDecodePool)
+	{
+		mDecodePool->close();
+		delete mDecodePool;
+		mDecodePool = NULL;
+	}
+
 	mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
@@ -926,7 +996,7 @@ void LLMeshRepoThread::run()
         if (!mLODReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
         {
             std::list<LODRequest> incomplete;
-            while (!mLODReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
+            while (!mLODReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater && LLStreamingPriority::hasBudget())
             {
                 if (!mMutex)
                 {
@@ -975,7 +1045,7 @@ void LLMeshRepoThread::run()
         if (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
         {
             std::list<HeaderRequest> incomplete;
-            while (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
+            while (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater && LLStreamingPriority::hasBudget())
             {
                 if (!mMutex)
                 {
@@ -1016,6 +1086,54 @@ void LLMeshRepoThread::run()
             }
         }
 
+        // Prefetches only get what the on demand queues leave spare, keeping
+        // below the low water mark so they never hold up a real request for
+        // long, and no more bytes than the budget allows.
+        if (!mPrefetchReqQ.empty()
+            && mLODReqQ.empty()
+            && mHeaderReqQ.empty()
+            && mHttpRequestSet.size() < sRequestLowWater)
+        {
+            F32 budget_per_sec = (F32)sPrefetchBytesPerSec;
+            F32 elapsed = mPrefetchBudgetTimer.getElapsedTimeAndResetF32();
+            mPrefetchBudget = llmin(mPrefetchBudget + elapsed * budget_per_sec, budget_per_sec);
+
+            std::list<LODRequest> incomplete;
+            while (!mPrefetchReqQ.empty()
+                   && mPrefetchBudget > 0.f
+                   && mHttpRequestSet.size() < sRequestLowWater)
+            {
+                mMutex->lock();
+                LODRequest req = mPrefetchReqQ.front();
+                mPrefetchReqQ.pop();
+                mMutex->unlock();
+                if (req.isDelayed())
+                {
+                    incomplete.push_back(req);
+                }
+                else if (!fetchPrefetchLOD(req) && req.canRetry())
+                {
+                    // waiting on the header or a cap
+                    req.updateTime();
+                    incomplete.push_back(req);
+                }
+            }
+
+            if (!incomplete.empty())
+            {
+                LLMutexLock locker(mMutex);
+                for (std::list<LODRequest>::iterator iter = incomplete.begin(); iter != incomplete.end(); iter++)
+                {
+                    mPrefetchReqQ.push(*iter);
+                }
+            }
+        }
+        else if (mPrefetchReqQ.empty())
+        {
+            // nothing to spend it on, don't let the budget pile up
+            mPrefetchBudgetTimer.reset();
+        }
+
         // For the final three request lists, similar goal to above but
         // slightly different queue structures.  Stay off the mutex when
         // performing long-duration actions.
@@ -1222,6 +1340,17 @@ void LLMeshRepoThread::loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 	}
 }
 
+// Mutex:  must be holding mMutex when called
+void LLMeshRepoThread::prefetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
+{
+	// the camera has moved on from the oldest predictions
+	while (mPrefetchReqQ.size() >= PREFETCH_MAX_QUEUED)
+	{
+		mPrefetchReqQ.pop();
+	}
+	mPrefetchReqQ.push(LODRequest(mesh_params, lod));
+}
+
 // Mutex:  must be holding mMutex when called
 void LLMeshRepoThread::setGetMeshCap(const std::string & mesh_cap)
 {
@@ -1762,6 +1891,12 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
 		{
+			//check cache for an already decoded copy of this LOD
+			if (sProcessedLODCache && fetchProcessedLOD(mesh_params, lod))
+			{
+				countPrefetchHit(mesh_id, lod);
+				return true;
+			}
 
 			//check cache for mesh asset
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
@@ -1789,7 +1924,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 
 				if (!zero)
 				{ //attempt to parse
-					if (lodReceived(mesh_params, lod, buffer, size) == MESH_OK)
+					if (lodReceived(mesh_params, lod, buffer, size, true) == MESH_OK)
 					{
 						delete[] buffer;
 
@@ -1797,6 +1932,8 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 						mesh_id.toString(mid);
 						LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the cache." << LL_ENDL;
 
+						countPrefetchHit(mesh_id, lod);
+
 						return true;
 					}
 				}
@@ -1814,6 +1951,11 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				mesh_id.toString(mid);
 				LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the simulator." << LL_ENDL;
 
+				if (sPrefetchBytesPerSec > 0)
+				{
+					++LLMeshRepository::sPrefetchMisses;
+				}
+
                 LLMeshHandlerBase::ptr_t handler(new LLMeshLODHandler(mesh_params, lod, offset, size));
 				LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
 				if (LLCORE_HTTP_HANDLE_INVALID == handle)
@@ -1856,6 +1998,108 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 	return retval;
 }
 
+// Fetch a predicted LOD into the cache without decoding it.  False if it
+// can't be fetched yet, because the header or the cap isn't there, and
+// should be tried again later.  The header is asked for on the first try.
+//
+// Thread:  repo
+bool LLMeshRepoThread::fetchPrefetchLOD(LODRequest& req)
+{
+	const LLUUID& mesh_id = req.mMeshParams.getSculptID();
+	S32 lod = req.mLOD;
+
+	if (!hasHeader(mesh_id))
+	{
+		if (req.getRetries() > 0)
+		{
+			// still waiting on the header we asked for
+			return false;
+		}
+
+		{
+			LLMutexLock lock(mMutex);
+			if (mPendingLOD.find(mesh_id) != mPendingLOD.end())
+			{
+				// already on its way for something that wants it now
+				return true;
+			}
+		}
+
+		// may come straight from the cache
+		mPrefetchBudget -= MESH_HEADER_SIZE;
+		if (!fetchMeshHeader(req.mMeshParams) || !hasHeader(mesh_id))
+		{
+			return false;
+		}
+	}
+
+	S32 offset = -1;
+	S32 size = 0;
+	{
+		LLMutexLock lock(mHeaderMutex);
+		mesh_header_map::iterator iter = mMeshHeader.find(mesh_id);
+		if (iter != mMeshHeader.end() && iter->second.first > 0)
+		{
+			const LLMeshHeader& header = iter->second.second;
+			if (!header.m404 && header.mVersion <= MAX_MESH_VERSION)
+			{
+				offset = iter->second.first + header.mLodOffset[lod];
+				size = header.mLodSize[lod];
+			}
+		}
+	}
+
+	if (offset < 0 || size <= 0)
+	{
+		// nothing there to fetch
+		return true;
+	}
+
+	LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
+	if (file.getSize() >= offset + size)
+	{
+		// space for it is reserved with the header, see if it's filled in
+		U8 buffer[1024];
+		S32 bytes = llmin(size, (S32)sizeof(buffer));
+		file.seek(offset);
+		file.read(buffer, bytes);
+		for (S32 i = 0; i < bytes; ++i)
+		{
+			if (buffer[i])
+			{
+				return true;
+			}
+		}
+	}
+
+	std::string http_url;
+	constructUrl(mesh_id, &http_url);
+	if (http_url.empty())
+	{
+		return false;
+	}
+
+	LLMeshHandlerBase::ptr_t handler(new LLMeshLODHandler(req.mMeshParams, lod, offset, size, true));
+	LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
+	if (LLCORE_HTTP_HANDLE_INVALID == handle)
+	{
+		return false;
+	}
+	handler->mHttpHandle = handle;
+	mHttpRequestSet.insert(handler);
+
+	mPrefetchBudget -= size;
+	++LLMeshRepository::sPrefetchRequestCount;
+
+	if (mPrefetchedLODs.size() >= PREFETCH_MAX_SCANNED)
+	{
+		mPrefetchedLODs.clear();
+	}
+	mPrefetchedLODs[mesh_id] |= 1 << lod;
+
+	return true;
+}
+
 EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size)
 {
 	const LLUUID mesh_id = mesh_params.getSculptID();
@@ -1871,9 +2115,9 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 
 		data_size = dsize;
 
-		boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
-
-		if (!LLSDSerialize::fromBinary(header_data, stream, data_size))
+		llssize header_bytes = 0;
+		LLPointer<LLSDBinaryParser> parser = new LLSDBinaryParser;
+		if (!parser->parseBuffer((const U8*)result_ptr, data_size, header_data, -1, &header_bytes))
 		{
 			LL_WARNS(LOG_MESH) << "Mesh header parse error.  Not a valid mesh asset!  ID:  " << mesh_id
 							   << LL_ENDL;
@@ -1896,7 +2140,7 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 		// make sure there is at least one lod, function returns -1 and marks as 404 otherwise
 		else if (LLMeshRepository::getActualMeshLOD(header, 0) >= 0)
 		{
-			header_size += stream.tellg();
+			header_size += header_bytes;
 		}
 	}
 	else
@@ -1933,34 +2177,183 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 	return MESH_OK;
 }
 
-EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
+// Hand a LOD block to mDecodePool.  MESH_OK only means it was taken, the
+// block goes to mLoadedQ if it decodes and mUnavailableQ if it doesn't.
+// A bad block from the cache is dropped from it and fetched again.
+//
+// Thread:  repo
+EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, bool from_cache)
 {
 	if (data == NULL || data_size == 0)
 	{
 		return MESH_NO_DATA;
 	}
 
+	// data only lives as long as the response or the cache read
+	U32 id = mNextDecodeID++;
+	std::vector<U8> block(data, data + data_size);
+	auto decode = [this, id, mesh_params, lod, block = std::move(block), from_cache]()
+	{
+		decodeMeshLOD(id, mesh_params, lod, block, from_cache);
+	};
+	if (!mDecodePool->getQueue().post(decode))
+	{
+		// shutting down, keep the delivery order intact anyway
+		decode();
+	}
+
+	return MESH_OK;
+}
+
+// Thread:  decode pool
+void LLMeshRepoThread::decodeMeshLOD(U32 id, const LLVolumeParams& mesh_params, S32 lod, const std::vector<U8>& data, bool from_cache)
+{
 	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
-	if (volume->unpackVolumeFaces(data, data_size))
+	bool success = volume->unpackVolumeFaces((U8*)data.data(), (S32)data.size()) && volume->getNumFaces() > 0;
+
+	const LLUUID& mesh_id = mesh_params.getSculptID();
+	if (success && sProcessedLODCache)
 	{
-		if (volume->getNumFaces() > 0)
+		std::vector<U8> processed;
+		if (volume->packProcessedFaces(processed))
 		{
-			LoadedMesh mesh(volume, mesh_params, lod);
-			{
-				LLMutexLock lock(mMutex);
-				mLoadedQ.push_back(mesh);
-				// LLPointer is not thread safe, since we added this pointer into
-				// threaded list, make sure counter gets decreased inside mutex lock
-				// and won't affect mLoadedQ processing
-				volume = NULL;
-				// might be good idea to turn mesh into pointer to avoid making a copy
-				mesh.mVolume = NULL;
-			}
-			return MESH_OK;
+			LLFileSystem file(getProcessedLODID(mesh_params, lod), LLAssetType::AT_MESH, LLFileSystem::WRITE);
+			file.write(processed.data(), (S32)processed.size());
+		}
+	}
+	else if (!success)
+	{
+		LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_id
+						   << " LOD: " << lod
+						   << " Data size: " << data.size()
+						   << (from_cache ? " From cache, fetching again." : " Not retrying.")
+						   << LL_ENDL;
+		if (from_cache)
+		{
+			LLFileSystem::removeFile(mesh_id, LLAssetType::AT_MESH);
+		}
+		volume = NULL;
+	}
+
+	deliverDecodedMesh(id, volume, mesh_params, lod, from_cache);
+}
+
+// Read the decoded copy of a LOD left by decodeMeshLOD() and hand it to
+// mDecodePool.  Returns false if there is none.
+//
+// Thread:  repo
+bool LLMeshRepoThread::fetchProcessedLOD(const LLVolumeParams& mesh_params, S32 lod)
+{
+	LLFileSystem file(getProcessedLODID(mesh_params, lod), LLAssetType::AT_MESH);
+	S32 size = file.getSize();
+	if (size <= 0)
+	{
+		return false;
+	}
+
+	std::vector<U8> block(size);
+	if (!file.read(block.data(), size))
+	{
+		return false;
+	}
+	LLMeshRepository::sCacheBytesRead += size;
+	++LLMeshRepository::sCacheReads;
+	++LLMeshRepository::sProcessedLODReads;
+
+	U32 id = mNextDecodeID++;
+	auto decode = [this, id, mesh_params, lod, block = std::move(block)]()
+	{
+		decodeProcessedLOD(id, mesh_params, lod, block);
+	};
+	if (!mDecodePool->getQueue().post(decode))
+	{
+		decode();
+	}
+
+	return true;
+}
+
+// Thread:  decode pool
+void LLMeshRepoThread::decodeProcessedLOD(U32 id, const LLVolumeParams& mesh_params, S32 lod, const std::vector<U8>& data)
+{
+	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+	if (!volume->unpackProcessedFaces(data.data(), (S32)data.size()) || volume->getNumFaces() <= 0)
+	{
+		// stale or damaged, drop it and the retry decodes the asset instead
+		LL_WARNS(LOG_MESH) << "Error reading decoded mesh LOD.  ID:  " << mesh_params.getSculptID()
+						   << " LOD: " << lod
+						   << " Data size: " << data.size()
+						   << LL_ENDL;
+		LLFileSystem::removeFile(getProcessedLODID(mesh_params, lod), LLAssetType::AT_MESH);
+		volume = NULL;
+	}
+
+	deliverDecodedMesh(id, volume, mesh_params, lod, true);
+}
+
+// Queue a finished decode, NULL volume for a failed one, and release every
+// decode that is now next in line.  Takes the reference out of volume.
+//
+// Thread:  decode pool
+void LLMeshRepoThread::deliverDecodedMesh(U32 id, LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, S32 lod, bool from_cache)
+{
+	LLMutexLock lock(mMutex);
+
+	// LLPointer is not thread safe, only touch the volume's count inside
+	// the lock from here on, see notifyLoadedMeshes()
+	DecodedMesh& decoded = mDecodedMeshes[id];
+	decoded.mVolume = volume;
+	decoded.mMeshParams = mesh_params;
+	decoded.mLOD = lod;
+	decoded.mFromCache = from_cache;
+	volume = NULL;
+
+	for (decoded_mesh_map::iterator iter = mDecodedMeshes.find(mNextDeliveryID);
+		 iter != mDecodedMeshes.end() && iter->first == mNextDeliveryID;
+		 iter = mDecodedMeshes.erase(iter), ++mNextDeliveryID)
+	{
+		DecodedMesh& next = iter->second;
+		if (next.mVolume.notNull())
+		{
+			mLoadedQ.push_back(LoadedMesh(next.mVolume, next.mMeshParams, next.mLOD));
+		}
+		else if (next.mFromCache)
+		{
+			// cache entry is gone now, so this goes to the sim
+			mLODReqQ.push(LODRequest(next.mMeshParams, next.mLOD));
+			LLMeshRepository::sLODProcessing++;
+		}
+		else
+		{
+			mUnavailableQ.push_back(LODRequest(next.mMeshParams, next.mLOD));
 		}
 	}
+}
 
-	return MESH_UNKNOWN;
+// Cache id of the decoded copy of a mesh LOD.  The sculpt type is part of it
+// since mirroring and inverting are applied while decoding, and so is the
+// viewer version as another build may decode meshes differently.
+LLUUID LLMeshRepoThread::getProcessedLODID(const LLVolumeParams& mesh_params, S32 lod) const
+{
+	LLUUID id;
+	id.generate(llformat("%s:%d:%d:%s", mesh_params.getSculptID().asString().c_str(), (S32)mesh_params.getSculptType(),
+						 lod, mProcessedLODVersion.c_str()));
+	return id;
+}
+
+// Thread:  repo
+void LLMeshRepoThread::countPrefetchHit(const LLUUID& mesh_id, S32 lod)
+{
+	prefetched_lod_map::iterator prefetched = mPrefetchedLODs.find(mesh_id);
+	if (prefetched != mPrefetchedLODs.end() && (prefetched->second & (1 << lod)))
+	{
+		++LLMeshRepository::sPrefetchHits;
+		prefetched->second &= ~(1 << lod);
+		if (!prefetched->second)
+		{
+			mPrefetchedLODs.erase(prefetched);
+		}
+	}
 }
 
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
@@ -2165,6 +2558,7 @@ void LLMeshUploadThread::DecompRequest::completed()
 
 	llassert(mHull.size() == 1);
 	
+	LLMutexLock lock(mThread->mMutex);
 	mThread->mHullMap[mBaseModel] = mHull[0];
 }
 
@@ -2565,7 +2959,245 @@ void LLMeshUploadThread::wholeModelToLLSD(LLSD& dest, bool include_textures)
 	dest = result;
 }
 
+namespace
+{
+	// Formats pieces of a body that is written by hand around them
+	class LLMeshBodyFormatter : public LLSDXMLFormatter
+	{
+	public:
+		void formatElement(const LLSD& data, std::ostream& ostr) const
+		{
+			format_impl(data, ostr, LLSDFormatter::OPTIONS_NONE, 1);
+		}
+	};
+
+	void write_binary_element(std::ostream& ostr, const std::string& data)
+	{
+		if (data.empty())
+		{
+			ostr << "<binary />";
+		}
+		else
+		{
+			ostr << "<binary encoding=\"base64\">"
+				 << LLBase64::encode((const U8*)data.data(), data.size())
+				 << "</binary>";
+		}
+	}
+}
+
+bool LLMeshUploadThread::wholeModelToBody(LLCore::BufferArray* body, LLSD& dest)
+{
+	LLSD result;
+	result["folder_id"] = gInventory.findUserDefinedCategoryUUIDForType(LLFolderType::FT_OBJECT);
+	result["texture_folder_id"] = gInventory.findUserDefinedCategoryUUIDForType(LLFolderType::FT_TEXTURE);
+	result["asset_type"] = "mesh";
+	result["inventory_type"] = "object";
+	result["description"] = "(No Description)";
+	result["next_owner_mask"] = LLSD::Integer(LLFloaterPerms::getNextOwnerPerms("Uploads"));
+	result["group_mask"] = LLSD::Integer(LLFloaterPerms::getGroupPerms("Uploads"));
+	result["everyone_mask"] = LLSD::Integer(LLFloaterPerms::getEveryonePerms("Uploads"));
+
+	// Same order as wholeModelToLLSD(): submodels last, so that they are
+	// created after their parents.
+	std::vector<instance_map::iterator> models;
+	for (instance_map::iterator iter = mInstance.begin(); iter != mInstance.end(); ++iter)
+	{
+		if (!iter->first->mSubmodelID)
+		{
+			models.push_back(iter);
+		}
+	}
+	for (instance_map::iterator iter = mInstance.begin(); iter != mInstance.end(); ++iter)
+	{
+		if (iter->first->mSubmodelID)
+		{
+			models.push_back(iter);
+		}
+	}
+
+	// The decomposition thread works on the next hulls while this one
+	// writes out the models whose hulls are done.
+	requestHulls();
+
+	LLCore::BufferArrayStream ostr(body);
+	ostr.precision(25);
+	ostr << "<llsd><map>";
+
+	std::map<LLModel*, S32> mesh_index;
+	std::string model_name;
+
+	ostr << "<key>mesh_list</key><array>";
+	for (instance_map::iterator iter : models)
+	{
+		LLModel* base_model = iter->first;
+		LLModelInstance& first_instance = *(iter->second.begin());
+
+		if (model_name.empty())
+		{
+			model_name = base_model->getName();
+		}
+
+		LLModel::Decomposition& decomp =
+			first_instance.mLOD[LLModel::LOD_PHYSICS].notNull() ? 
+			first_instance.mLOD[LLModel::LOD_PHYSICS]->mPhysics : 
+			base_model->mPhysics;
+
+		if (!waitForHull(base_model, decomp.mBaseHull))
+		{
+			return false;
+		}
+
+		std::stringstream model_str;
+		LLModel::writeModel(
+			model_str,  
+			first_instance.mLOD[LLModel::LOD_PHYSICS],
+			first_instance.mLOD[LLModel::LOD_HIGH],
+			first_instance.mLOD[LLModel::LOD_MEDIUM],
+			first_instance.mLOD[LLModel::LOD_LOW],
+			first_instance.mLOD[LLModel::LOD_IMPOSTOR], 
+			decomp,
+			mUploadSkin,
+			mUploadJoints,
+			mLockScaleIfJointPosition,
+			FALSE,
+			FALSE,
+			base_model->mSubmodelID);
+
+		write_binary_element(ostr, model_str.str());
+		S32 mesh_num = (S32)mesh_index.size();
+		mesh_index[base_model] = mesh_num;
+	}
+	ostr << "</array>";
+
+	// Each texture is encoded and written when first used, the instances
+	// are small enough to collect first.
+	std::map<LLViewerTexture*, S32> texture_index;
+	LLSD instances = LLSD::emptyArray();
+
+	ostr << "<key>texture_list</key><array>";
+	for (instance_map::iterator iter : models)
+	{
+		LLModel* base_model = iter->first;
+
+		// For all instances that use this model
+		for (instance_list::iterator instance_iter = iter->second.begin();
+			 instance_iter != iter->second.end();
+			 ++instance_iter)
+		{
+			LLModelInstance& instance = *instance_iter;
+		
+			LLSD instance_entry;
+
+			LLVector3 pos, scale;
+			LLQuaternion rot;
+			LLMatrix4 transformation = instance.mTransform;
+			decomposeMeshMatrix(transformation,pos,rot,scale);
+			instance_entry["position"] = ll_sd_from_vector3(pos);
+			instance_entry["rotation"] = ll_sd_from_quaternion(rot);
+			instance_entry["scale"] = ll_sd_from_vector3(scale);
+		
+			instance_entry["material"] = LL_MCODE_WOOD;
+			if (base_model->mSubmodelID)
+			{
+				instance_entry["physics_shape_type"] = (U8)(LLViewerObject::PHYSICS_SHAPE_NONE);
+				instance_entry["mesh"] = mesh_index[base_model];
+			}
+			else
+			{
+				instance_entry["physics_shape_type"] = instance.mLOD[LLModel::LOD_PHYSICS].notNull() ? (U8)(LLViewerObject::PHYSICS_SHAPE_PRIM) : (U8)(LLViewerObject::PHYSICS_SHAPE_CONVEX_HULL);
+				instance_entry["mesh"] = mesh_index[base_model];
+				instance_entry["mesh_name"] = instance.mLabel;
+			}
+
+			instance_entry["face_list"] = LLSD::emptyArray();
+
+			S32 end = llmin((S32)instance.mMaterial.size(), instance.mModel->getNumVolumeFaces()) ;
+
+			for (S32 face_num = 0; face_num < end; face_num++)
+			{
+				LLImportMaterial& material = instance.mMaterial[base_model->mMaterialList[face_num]];
+				LLSD face_entry = LLSD::emptyMap();
+
+				LLViewerFetchedTexture *texture = NULL;
+
+				if (material.mDiffuseMapFilename.size())
+				{
+					texture = FindViewerTexture(material);
+				}
+
+				if (texture != NULL &&
+					mUploadTextures &&
+					texture_index.find(texture) == texture_index.end())
+				{
+					std::string texture_str;
+					if (texture->hasSavedRawImage())
+					{
+						LLPointer<LLImageJ2C> upload_file =
+							LLViewerTextureList::convertToUploadFile(texture->getSavedRawImage());
+
+						if (!upload_file.isNull() && upload_file->getDataSize())
+						{
+							texture_str.assign((const char*) upload_file->getData(), upload_file->getDataSize());
+						}
+					}
+
+					write_binary_element(ostr, texture_str);
+					S32 texture_num = (S32)texture_index.size();
+					texture_index[texture] = texture_num;
+				}
+
+				// Subset of TextureEntry fields.
+				if (texture != NULL && mUploadTextures)
+				{
+					face_entry["image"] = texture_index[texture];
+					face_entry["scales"] = 1.0;
+					face_entry["scalet"] = 1.0;
+					face_entry["offsets"] = 0.0;
+					face_entry["offsett"] = 0.0;
+					face_entry["imagerot"] = 0.0;
+				}
+				face_entry["diffuse_color"] = ll_sd_from_color4(material.mDiffuseColor);
+				face_entry["fullbright"] = material.mFullbright;
+				instance_entry["face_list"][face_num] = face_entry;
+			}
+
+			instances.append(instance_entry);
+		}
+	}
+	ostr << "</array>";
+
+	LLPointer<LLMeshBodyFormatter> formatter = new LLMeshBodyFormatter;
+	ostr << "<key>instance_list</key>";
+	formatter->formatElement(instances, ostr);
+	ostr << "<key>metric</key><string>MUT_Unspecified</string>";
+	ostr << "</map></llsd>\n";
+	ostr.flush();
+
+	if (model_name.empty()) model_name = "mesh model";
+	result["name"] = model_name;
+	dest = result;
+	return true;
+}
+
 void LLMeshUploadThread::generateHulls()
+{
+	if (requestHulls())
+	{
+		// *NOTE:  Interesting livelock condition on shutdown.  If there
+		// is an upload request in generateHulls() when shutdown starts,
+		// the main thread isn't available to manage communication between
+		// the decomposition thread and the upload thread and this loop
+		// wouldn't complete in turn stalling the main thread.  The check
+		// on isDiscarded() prevents that.
+		while (! mPhysicsComplete && ! isDiscarded())
+		{
+			apr_sleep(100);
+		}
+	}	
+}
+
+bool LLMeshUploadThread::requestHulls()
 {
 	bool has_valid_requests = false ;
 
@@ -2606,24 +3238,39 @@ void LLMeshUploadThread::generateHulls()
 		DecompRequest* request = new DecompRequest(physics, data.mBaseModel, this);
 		if(request->isValid())
 		{
+			mHullRequests.insert(data.mBaseModel);
 			gMeshRepo.mDecompThread->submitRequest(request);
 			has_valid_requests = true ;
 		}
 	}
-		
-	if (has_valid_requests)
+
+	return has_valid_requests;
+}
+
+// Copies out the hull of one model, waiting for it if its decomposition
+// is still queued. The same livelock note as in generateHulls() applies.
+bool LLMeshUploadThread::waitForHull(LLModel* base_model, std::vector<LLVector3>& hull)
+{
+	if (!mHullRequests.count(base_model))
+	{
+		hull.clear();
+		return true;
+	}
+
+	while (! isDiscarded())
 	{
-		// *NOTE:  Interesting livelock condition on shutdown.  If there
-		// is an upload request in generateHulls() when shutdown starts,
-		// the main thread isn't available to manage communication between
-		// the decomposition thread and the upload thread and this loop
-		// wouldn't complete in turn stalling the main thread.  The check
-		// on isDiscarded() prevents that.
-		while (! mPhysicsComplete && ! isDiscarded())
 		{
-			apr_sleep(100);
+			LLMutexLock lock(mMutex);
+			hull_map::iterator iter = mHullMap.find(base_model);
+			if (iter != mHullMap.end())
+			{
+				hull = iter->second;
+				return true;
+			}
 		}
-	}	
+		apr_sleep(100);
+	}
+	return false;
 }
 
 void LLMeshUploadThread::doWholeModelUpload()
@@ -2637,22 +3284,51 @@ void LLMeshUploadThread::doWholeModelUpload()
 	}
 	else
 	{
-		generateHulls();
-		LL_DEBUGS(LOG_MESH) << "Hull generation completed." << LL_ENDL;
-
+		LLCore::HttpHandle handle = LLCORE_HTTP_HANDLE_INVALID;
 		mModelData = LLSD::emptyMap();
-		wholeModelToLLSD(mModelData, true);
-		LLSD body = mModelData["asset_resources"];
-
-		dump_llsd_to_file(body, make_dump_name("whole_model_body_", dump_num));
-
-		LLCore::HttpHandle handle = LLCoreHttpUtil::requestPostWithLLSD(mHttpRequest,
-																		mHttpPolicyClass,
-																		mWholeModelUploadURL,
-																		body,
-																		mHttpOptions,
-																		mHttpHeaders,
-                                                                        LLCore::HttpHandler::ptr_t(this, &NoOpDeletor));
+
+		if (gSavedSettings.getBOOL("MeshUploadLogXML"))
+		{
+			// The logs want the whole body as LLSD
+			generateHulls();
+			LL_DEBUGS(LOG_MESH) << "Hull generation completed." << LL_ENDL;
+
+			wholeModelToLLSD(mModelData, true);
+			LLSD body = mModelData["asset_resources"];
+
+			dump_llsd_to_file(body, make_dump_name("whole_model_body_", dump_num));
+
+			handle = LLCoreHttpUtil::requestPostWithLLSD(mHttpRequest,
+														 mHttpPolicyClass,
+														 mWholeModelUploadURL,
+														 body,
+														 mHttpOptions,
+														 mHttpHeaders,
+														 LLCore::HttpHandler::ptr_t(this, &NoOpDeletor));
+		}
+		else
+		{
+			LLCore::BufferArray* body = new LLCore::BufferArray();
+			bool built = wholeModelToBody(body, mModelData);
+			if (built)
+			{
+				LL_DEBUGS(LOG_MESH) << "Upload body built, " << body->size() << " bytes." << LL_ENDL;
+				handle = mHttpRequest->requestPost(mHttpPolicyClass,
+												   mWholeModelUploadURL,
+												   body,
+												   mHttpOptions,
+												   mHttpHeaders,
+												   LLCore::HttpHandler::ptr_t(this, &NoOpDeletor));
+			}
+			body->release();
+
+			if (!built)
+			{
+				LL_DEBUGS(LOG_MESH) << "Mesh upload operation discarded." << LL_ENDL;
+				return;
+			}
+		}
+
 		if (LLCORE_HTTP_HANDLE_INVALID == handle)
 		{
 			mHttpStatus = mHttpRequest->getStatus();
@@ -3078,6 +3754,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 		LLCore::BufferArray * body(response->getBody());
 		S32 body_offset(0);
 		U8 * data(NULL);
+		bool data_copied(false);
 		S32 data_size(body ? body->size() : 0);
 
 		if (data_size > 0)
@@ -3130,15 +3807,22 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 				goto common_exit;
 			}
 			
-			// *TODO: Try to get rid of data copying and add interfaces
-			// that support BufferArray directly.  Introduce a two-phase
-			// handler, optional first that takes a body, fallback second
-			// that requires a temporary allocation and data copy.
+			// Bodies received into a single block are handed to
+			// processData() in place, the handlers only read them.
+			// Otherwise fall back to a temporary copy.
 			body_offset = mOffset - offset;
-			data = new(std::nothrow) U8[data_size - body_offset];
+			data = (U8 *) body->getContiguous(body_offset, data_size - body_offset);
+			if (! data)
+			{
+				data = new(std::nothrow) U8[data_size - body_offset];
+				if (data)
+				{
+					body->read(body_offset, (char *) data, data_size - body_offset);
+					data_copied = true;
+				}
+			}
 			if (data)
 			{
-				body->read(body_offset, (char *) data, data_size - body_offset);
 				LLMeshRepository::sBytesReceived += data_size;
 			}
 			else
@@ -3150,7 +3834,10 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 
 		processData(body, body_offset, data, data_size - body_offset);
 
-		delete [] data;
+		if (data_copied)
+		{
+			delete [] data;
+		}
 	}
 
 	// Release handler
@@ -3306,7 +3993,7 @@ LLMeshLODHandler::~LLMeshLODHandler()
 {
 	if (! LLApp::isExiting())
 	{
-		if (! mProcessed)
+		if (! mProcessed && ! mPrefetch)
 		{
 			LL_WARNS(LOG_MESH) << "Mesh LOD fetch canceled unexpectedly, retrying." << LL_ENDL;
 			gMeshRepo.mThread->lockAndLoadMeshLOD(mMeshParams, mLOD);
@@ -3322,8 +4009,11 @@ void LLMeshLODHandler::processFailure(LLCore::HttpStatus status)
 					   << " (" << status.toTerseString() << ").  Not retrying."
 					   << LL_ENDL;
 
-	LLMutexLock lock(gMeshRepo.mThread->mMutex);
-	gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+	if (! mPrefetch)
+	{
+		LLMutexLock lock(gMeshRepo.mThread->mMutex);
+		gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+	}
 }
 
 void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
@@ -3332,7 +4022,19 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 	if ((!MESH_LOD_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
+		// a prefetch is decoded when it's asked for, from the cache
+		EMeshProcessingResult result = MESH_OK;
+		if (mPrefetch)
+		{
+			if (data_size < (S32)mRequestedBytes)
+			{
+				result = MESH_NO_DATA;
+			}
+		}
+		else
+		{
+			result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
+		}
 		if (result == MESH_OK)
 		{
 			// good fetch from sim, write to cache
@@ -3359,8 +4061,11 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 							   << " Data size: " << data_size
 							   << " Not retrying."
 							   << LL_ENDL;
-			LLMutexLock lock(gMeshRepo.mThread->mMutex);
-			gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+			if (! mPrefetch)
+			{
+				LLMutexLock lock(gMeshRepo.mThread->mMutex);
+				gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+			}
 		}
 	}
 	else
@@ -3370,8 +4075,11 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 						   << " LOD: " << mLOD
 						   << " Data size: " << data_size
 						   << LL_ENDL;
-		LLMutexLock lock(gMeshRepo.mThread->mMutex);
-		gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+		if (! mPrefetch)
+		{
+			LLMutexLock lock(gMeshRepo.mThread->mMutex);
+			gMeshRepo.mThread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mMeshParams, mLOD));
+		}
 	}
 }
 
@@ -3754,6 +4462,12 @@ void LLMeshRepository::notifyLoadedMeshes()
     LLMeshRepoThread::sRequestLowWater = llclamp(LLMeshRepoThread::sRequestHighWater / 2,
                                                  REQUEST2_LOW_WATER_MIN,
                                                  REQUEST2_LOW_WATER_MAX);
+
+    static LLCachedControl<U32> prefetch_bandwidth(gSavedSettings, "MeshPrefetchBandwidth", 128);
+    LLMeshRepoThread::sPrefetchBytesPerSec = prefetch_bandwidth * 1024;
+
+    static LLCachedControl<bool> processed_lod_cache(gSavedSettings, "MeshProcessedLODCache", true);
+    LLMeshRepoThread::sProcessedLODCache = processed_lod_cache;
 	
 	//clean up completed upload threads
 	for (std::vector<LLMeshUploadThread*>::iterator iter = mUploads.begin(); iter != mUploads.end(); )
@@ -3854,6 +4568,9 @@ void LLMeshRepository::notifyLoadedMeshes()
 		//LL_INFOS() << "Skin info cache elements:" << mSkinMap.size() << " Memory: " << U64Kilobytes(skinbytes) << LL_ENDL;
 	}
 
+	updatePrefetch();
+	updateCompressedFaces();
+
 	// For major operations, attempt to get the required locks
 	// without blocking and punt if they're not available.  The
 	// longest run of holdoffs is kept in sMaxLockHoldoffs just
@@ -3932,7 +4649,7 @@ void LLMeshRepository::notifyLoadedMeshes()
 								LLDrawable* drawable = object->mDrawable;
 								if (drawable)
 								{
-									F32 cur_score = drawable->getRadius()/llmax(drawable->mDistanceWRTCamera, 1.f);
+									F32 cur_score = LLStreamingPriority::calcImportance(drawable->getPositionAgent(), drawable->getRadius(), drawable->isVisible());
 									max_score = llmax(max_score, cur_score);
 								}
 							}
@@ -3956,6 +4673,7 @@ void LLMeshRepository::notifyLoadedMeshes()
 			while (!mPendingRequests.empty() && push_count > 0)
 			{
 				LLMeshRepoThread::LODRequest& request = mPendingRequests.front();
+				LLStreamingPriority::noteIssued(LLStreamingPriority::STREAM_MESH, request.mScore);
 				mThread->loadMeshLOD(request.mMeshParams, request.mLOD);
 				mPendingRequests.erase(mPendingRequests.begin());
 				LLMeshRepository::sLODPending--;
@@ -3963,6 +4681,13 @@ void LLMeshRepository::notifyLoadedMeshes()
 			}
 		}
 
+		//send prefetches, the repo thread holds on to them until it has capacity to spare
+		for (const LLMeshRepoThread::LODRequest& request : mPendingPrefetches)
+		{
+			mThread->prefetchMeshLOD(request.mMeshParams, request.mLOD);
+		}
+		mPendingPrefetches.clear();
+
 		//send skin info requests
 		while (!mPendingSkinRequests.empty())
 		{
@@ -4046,6 +4771,189 @@ void LLMeshRepository::notifyDecompositionReceived(LLModel::Decomposition* decom
 	}
 }
 
+// Compress the faces of mesh volumes nobody has asked for in
+// MeshCompressIdleTime seconds, they expand themselves when they're wanted
+// again.  Also totals the savings per region, a volume counts once in each
+// region with an object using it.
+void LLMeshRepository::updateCompressedFaces()
+{ //called from main thread
+	static LLCachedControl<bool> compress_faces(gSavedSettings, "MeshCompressIdleFaces", false);
+	static LLCachedControl<F32> idle_time(gSavedSettings, "MeshCompressIdleTime", 30.f);
+
+	// sweep twice per idle time, a volume not used for two sweeps in a row
+	// has been idle for at least that long
+	F32 interval = llmax((F32)idle_time, FACE_COMPRESS_MIN_IDLE_TIME) * 0.5f;
+	if (mFaceCompressTimer.getElapsedTimeF32() < interval)
+	{
+		return;
+	}
+	mFaceCompressTimer.reset();
+
+	if (!compress_faces && !sFaceCompressionSavings)
+	{
+		return;
+	}
+
+	++LLVolume::sFaceUseStamp;
+
+	typedef std::map<LLViewerRegion*, std::set<LLVolume*> > region_volume_map;
+	region_volume_map region_volumes;
+	std::set<LLVolume*> compressed;
+	for (S32 i = 0; i < gObjectList.getNumObjects(); ++i)
+	{
+		LLViewerObject* objectp = gObjectList.getObject(i);
+		if (!objectp || objectp->isDead() || !objectp->isMesh())
+		{
+			continue;
+		}
+
+		LLVolume* volume = objectp->getVolume();
+		if (!volume || !volume->isMeshAssetLoaded())
+		{
+			continue;
+		}
+
+		if (!compress_faces)
+		{ // turned off, put back what's left
+			volume->expandFaces();
+		}
+		else if (!volume->isCompressed() && LLVolume::sFaceUseStamp - volume->getLastFaceUse() > 2)
+		{
+			volume->compressFaces();
+		}
+
+		if (volume->isCompressed())
+		{
+			region_volumes[objectp->getRegion()].insert(volume);
+			compressed.insert(volume);
+		}
+	}
+
+	for (LLViewerRegion* regionp : LLWorld::getInstance()->getRegionList())
+	{
+		U64 savings = 0;
+		region_volume_map::iterator iter = region_volumes.find(regionp);
+		if (iter != region_volumes.end())
+		{
+			for (LLVolume* volume : iter->second)
+			{
+				savings += volume->getCompressionSavings();
+			}
+		}
+		regionp->setMeshFaceSavings(savings);
+	}
+
+	sFaceCompressionSavings = 0;
+	for (LLVolume* volume : compressed)
+	{
+		sFaceCompressionSavings += volume->getCompressionSavings();
+	}
+}
+
+// Look ahead along the camera's path for cached objects that haven't been
+// rezzed yet, and predict the mesh LODs they'll want when they are.  The
+// repo thread fetches those into the cache as it has capacity and budget
+// to spare, so the real requests that follow decode them straight from
+// disk instead of waiting on the network.
+void LLMeshRepository::updatePrefetch()
+{ //called from main thread
+	static LLCachedControl<F32> look_ahead(gSavedSettings, "MeshPrefetchLookAhead", 4.f);
+	static LLCachedControl<F32> prefetch_radius(gSavedSettings, "MeshPrefetchRadius", 64.f);
+
+	if (!LLMeshRepoThread::sPrefetchBytesPerSec || mPrefetchTimer.getElapsedTimeF32() < PREFETCH_INTERVAL)
+	{
+		return;
+	}
+	F32 elapsed = mPrefetchTimer.getElapsedTimeAndResetF32();
+
+	LLVector3d pos = gAgent.getPosGlobalFromAgent(LLViewerCamera::getInstance()->getOrigin());
+	LLVector3d velocity = mPrefetchLastPos.isExactlyZero() ? LLVector3d::zero : (pos - mPrefetchLastPos) / elapsed;
+	mPrefetchLastPos = pos;
+	if (velocity.magVec() > PREFETCH_MAX_SPEED)
+	{
+		velocity.setZero();
+	}
+	mPrefetchVelocity = lerp(mPrefetchVelocity, velocity, 0.5);
+	if (mPrefetchVelocity.magVec() < PREFETCH_MIN_SPEED)
+	{
+		// rezzing asks for everything in view by itself
+		return;
+	}
+
+	// the region about to be entered when the camera crosses over,
+	// otherwise the part of this one about to come into view
+	LLVector3d predicted = pos + mPrefetchVelocity * look_ahead;
+	LLViewerRegion* region = LLWorld::getInstance()->getRegionFromPosGlobal(predicted);
+	if (!region)
+	{
+		return;
+	}
+
+	LLVector3 pos_region = region->getPosRegionFromGlobal(predicted);
+	std::vector<LLVOCacheEntry*> entries;
+	region->getIdleCacheEntries(pos_region, prefetch_radius, entries);
+
+	if (mPrefetchScanned.size() >= PREFETCH_MAX_SCANNED)
+	{
+		mPrefetchScanned.clear();
+		mPrefetchLODs.clear();
+	}
+
+	LLVector4a center;
+	center.load3(pos_region.mV);
+	for (U32 i = 0; i < entries.size() && mPendingPrefetches.size() < PREFETCH_MAX_PER_UPDATE; ++i)
+	{
+		LLVOCacheEntry* root = entries[i];
+		LLVector4a offset;
+		offset.setSub(root->getPositionGroup(), center);
+		F32 distance = llmax(offset.getLength3().getF32(), 1.f);
+
+		// children sit with their root as far as distance goes
+		std::vector<LLVOCacheEntry*> linkset(1, root);
+		linkset.insert(linkset.end(), root->getChildren().begin(), root->getChildren().end());
+		for (LLVOCacheEntry* entry : linkset)
+		{
+			std::pair<prefetch_scanned_map::iterator, bool> scanned =
+				mPrefetchScanned.insert(std::make_pair(std::make_pair(region->getHandle(), entry->getLocalID()), LLUUID::null));
+			if (scanned.second)
+			{
+				LLDataPackerBinaryBuffer* dp = entry->getDP();
+				U8 pcode = 0;
+				LLSculptParams sculpt;
+				if (dp)
+				{
+					LLViewerObject::unpackU8(dp, pcode, "PCode");
+				}
+				if (pcode == LL_PCODE_VOLUME
+					&& LLViewerObject::unpackSculptParams(dp, sculpt)
+					&& (sculpt.getSculptType() & LL_SCULPT_TYPE_MASK) == LL_SCULPT_TYPE_MESH)
+				{
+					scanned.first->second = sculpt.getSculptTexture();
+				}
+			}
+
+			const LLUUID& mesh_id = scanned.first->second;
+			if (mesh_id.isNull())
+			{
+				continue;
+			}
+
+			S32 lod = LLVOVolume::computeLODDetail(distance, entry->getBinRadius(), LLVOVolume::sLODFactor);
+			prefetch_lod_map::iterator predicted_lod = mPrefetchLODs.find(mesh_id);
+			if ((predicted_lod != mPrefetchLODs.end() && predicted_lod->second >= lod)
+				|| mLoadingMeshes[lod].find(mesh_id) != mLoadingMeshes[lod].end())
+			{
+				continue;
+			}
+			mPrefetchLODs[mesh_id] = lod;
+
+			LLVolumeParams mesh_params;
+			mesh_params.setSculptID(mesh_id, LL_SCULPT_TYPE_MESH);
+			mPendingPrefetches.push_back(LLMeshRepoThread::LODRequest(mesh_params, lod));
+		}
+	}
+}
+
 void LLMeshRepository::notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume)
 { //called from main thread
 	S32 detail = LLVolumeLODGroup::getVolumeDetailFromScale(volume->getDetail());
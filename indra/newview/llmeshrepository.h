@@ -31,6 +31,7 @@
 #include "llassettype.h"
 #include "llmodel.h"
 #include "lluuid.h"
+#include "lluuidmap.h"
 #include "llviewertexture.h"
 #include "llvolume.h"
 #include "lldeadmantimer.h"
@@ -40,6 +41,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "threadpool_fwd.h"
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -261,13 +263,15 @@ public:
 	static S32 sRequestLowWater;
 	static S32 sRequestHighWater;
 	static S32 sRequestWaterLevel;			// Stats-use only, may read outside of thread
+	static U32 sPrefetchBytesPerSec;		// Byte budget for prefetches, 0 to not prefetch
+	static bool sProcessedLODCache;			// Keep decoded LODs in the cache next to the assets
 
 	LLMutex*	mMutex;
 	LLMutex*	mHeaderMutex;
 	LLCondition* mSignal;
 
 	//map of known mesh headers
-	typedef boost::unordered_map<LLUUID, std::pair<U32, LLMeshHeader>> mesh_header_map; // pair is header_size and data
+	typedef LLUUIDMap<std::pair<U32, LLMeshHeader>> mesh_header_map; // pair is header_size and data
 	mesh_header_map mMeshHeader;
 
 	class HeaderRequest : public RequestStats
@@ -361,12 +365,44 @@ public:
 	//queue of requested LODs
 	std::queue<LODRequest> mLODReqQ;
 
+	//queue of LODs predicted to be wanted soon, fetched into the cache
+	//with request capacity the other queues leave spare
+	std::queue<LODRequest> mPrefetchReqQ;
+
+	//LODs fetched into the cache by prefetches and not asked for since,
+	//as a mask of LODs per mesh.  Repo thread only
+	typedef boost::unordered_map<LLUUID, U8> prefetched_lod_map;
+	prefetched_lod_map mPrefetchedLODs;
+	F32 mPrefetchBudget;		//bytes prefetches may still fetch
+	LLTimer mPrefetchBudgetTimer;
+
 	//queue of unavailable LODs (either asset doesn't exist or asset doesn't have desired LOD)
 	std::deque<LODRequest> mUnavailableQ;
 
 	//queue of successfully loaded meshes
 	std::deque<LoadedMesh> mLoadedQ;
 
+	//LOD blocks are inflated and unpacked on mDecodePool, several at once.
+	//Finished ones wait here until those received before them are done, so
+	//they're delivered in the order they came in
+	class DecodedMesh
+	{
+	public:
+		LLPointer<LLVolume> mVolume;	//NULL if the block didn't decode
+		LLVolumeParams mMeshParams;
+		S32 mLOD;
+		bool mFromCache;
+	};
+	typedef std::map<U32, DecodedMesh> decoded_mesh_map;
+	decoded_mesh_map mDecodedMeshes;
+	U32 mNextDecodeID;		//repo thread only
+	U32 mNextDeliveryID;
+
+	LL::ThreadPool* mDecodePool;
+
+	//salt for getProcessedLODID(), set once before the thread starts
+	std::string mProcessedLODVersion;
+
 	//map of pending header requests and currently desired LODs
 	typedef boost::unordered_map<LLUUID, std::vector<S32> > pending_lod_map;
 	pending_lod_map mPendingLOD;
@@ -392,11 +428,19 @@ public:
 
 	void lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
+	void prefetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
 	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+	bool fetchPrefetchLOD(LODRequest& req);
 	EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
-	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, bool from_cache = false);
+	void decodeMeshLOD(U32 id, const LLVolumeParams& mesh_params, S32 lod, const std::vector<U8>& data, bool from_cache);
+	bool fetchProcessedLOD(const LLVolumeParams& mesh_params, S32 lod);
+	void decodeProcessedLOD(U32 id, const LLVolumeParams& mesh_params, S32 lod, const std::vector<U8>& data);
+	void deliverDecodedMesh(U32 id, LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, S32 lod, bool from_cache);
+	LLUUID getProcessedLODID(const LLVolumeParams& mesh_params, S32 lod) const;
+	void countPrefetchHit(const LLUUID& mesh_id, S32 lod);
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
@@ -480,7 +524,8 @@ public:
 	volatile bool	mPhysicsComplete;
 
 	typedef std::map<LLPointer<LLModel>, std::vector<LLVector3> > hull_map;
-	hull_map		mHullMap;
+	hull_map		mHullMap;		// filled on the main thread, locked by mMutex
+	std::set<LLModel*> mHullRequests;	// base models with a decomposition pending or done
 
 	typedef std::vector<LLModelInstance> instance_list;
 	instance_list	mInstanceList;
@@ -516,12 +561,19 @@ public:
 	bool isDiscarded() const;
 
 	void generateHulls();
+	bool requestHulls();
+	bool waitForHull(LLModel* base_model, std::vector<LLVector3>& hull);
 
 	void doWholeModelUpload();
 	void requestWholeModelFee();
 
 	void wholeModelToLLSD(LLSD& dest, bool include_textures);
 
+	// Writes the upload body as XML LLSD straight into body, a model at a
+	// time as its hull arrives. dest gets the fields wholeModelToLLSD()
+	// puts around "asset_resources". Returns false if discarded meanwhile.
+	bool wholeModelToBody(LLCore::BufferArray* body, LLSD& dest);
+
 	void decomposeMeshMatrix(LLMatrix4& transformation,
 							 LLVector3& result_pos,
 							 LLQuaternion& result_rot,
@@ -618,6 +670,11 @@ public:
 	static U32 sCacheReads;						
 	static U32 sCacheWrites;
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
+	static U32 sPrefetchRequestCount;			// LODs fetched ahead of being asked for
+	static U32 sPrefetchHits;					// LODs asked for and already in cache thanks to a prefetch
+	static U32 sPrefetchMisses;					// LODs asked for that had to be fetched while prefetching
+	static U32 sProcessedLODReads;				// LODs loaded from the cache already decoded
+	static U64 sFaceCompressionSavings;			// Bytes saved by compressing idle mesh faces
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
 
@@ -640,6 +697,8 @@ public:
 	S32 loadMesh(LLVOVolume* volume, const LLVolumeParams& mesh_params, S32 detail = 0, S32 last_lod = -1);
 	
 	void notifyLoadedMeshes();
+	void updatePrefetch();
+	void updateCompressedFaces();
 	void notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume);
 	void notifyMeshUnavailable(const LLVolumeParams& mesh_params, S32 lod);
 	void notifySkinInfoReceived(LLMeshSkinInfo* info);
@@ -706,6 +765,24 @@ public:
 
 	//list of mesh ids that need to send physics shape fetch requests
 	std::queue<LLUUID> mPendingPhysicsShapeRequests;
+
+	//predicted LODs for the repo thread to prefetch, see updatePrefetch()
+	std::vector<LLMeshRepoThread::LODRequest> mPendingPrefetches;
+
+	//mesh of each idle cache entry looked at, by region handle and local id,
+	//null if it isn't a mesh
+	typedef std::map<std::pair<U64, U32>, LLUUID> prefetch_scanned_map;
+	prefetch_scanned_map mPrefetchScanned;
+
+	//highest LOD predicted for each mesh
+	typedef boost::unordered_map<LLUUID, S32> prefetch_lod_map;
+	prefetch_lod_map mPrefetchLODs;
+	LLFrameTimer mPrefetchTimer;
+	LLVector3d mPrefetchLastPos;
+	LLVector3d mPrefetchVelocity;
+
+	//paces updateCompressedFaces()
+	LLFrameTimer mFaceCompressTimer;
 	
 	U32 mMeshThreadCount;
 	
@@ -1234,10 +1234,11 @@ void LLModelPreview::generateNormals()
             }
         }
 
-        for (LLModelLoader::model_list::iterator it = mBaseModel.begin(), itE = mBaseModel.end(); it != itE; ++it)
+        LLModelLoader::model_list& base_models = mBaseModel;
+        gPipeline.runParallel((U32)base_models.size(), [&base_models, angle_cutoff](U32 i)
         {
-            (*it)->generateNormals(angle_cutoff);
-        }
+            base_models[i]->generateNormals(angle_cutoff);
+        });
 
         mVertexBuffer[5].clear();
     }
@@ -1255,10 +1256,14 @@ void LLModelPreview::generateNormals()
             (*it)->copyFacesTo(faces);
             mModelFacesCopy[which_lod].push_back(faces);
         }
-
-        (*it)->generateNormals(angle_cutoff);
     }
 
+    LLModelLoader::model_list& models = mModel[which_lod];
+    gPipeline.runParallel((U32)models.size(), [&models, angle_cutoff](U32 i)
+    {
+        models[i]->generateNormals(angle_cutoff);
+    });
+
     mVertexBuffer[which_lod].clear();
     refresh();
     updateStatusMessages();
@@ -1839,8 +1844,9 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         mModel[lod].resize(mBaseModel.size());
         mVertexBuffer[lod].clear();
 
-
-        for (U32 mdl_idx = 0; mdl_idx < mBaseModel.size(); ++mdl_idx)
+        // Each model is simplified on its own, so spread them over the
+        // "Pipeline" thread pool. Every job only writes its own mModel slot.
+        gPipeline.runParallel((U32)mBaseModel.size(), [&](U32 mdl_idx)
         {
             LLModel* base = mBaseModel[mdl_idx];
 
@@ -2028,7 +2034,7 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
             {
                 LL_ERRS() << "Invalid model generated when creating LODs" << LL_ENDL;
             }
-        }
+        });
 
         //rebuild scene based on mBaseScene
         mScene[lod].clear();
@@ -33,6 +33,7 @@
 #include "indra_constants.h"
 #include "llavatarnamecache.h"
 #include "llmath.h"
+#include "llfloater.h"
 #include "llfloaterreg.h"
 #include "llfocusmgr.h"
 #include "lllocalcliprect.h"
@@ -181,7 +182,6 @@ void LLNetMap::draw()
         return;
     }
     LL_PROFILE_ZONE_SCOPED;
- 	static LLFrameTimer map_timer;
 	static LLUIColor map_avatar_color = LLUIColorTable::instance().getColor("MapAvatarColor", LLColor4::white);
 	static LLUIColor map_avatar_friend_color = LLUIColorTable::instance().getColor("MapAvatarFriendColor", LLColor4::white);
 	static LLUIColor map_track_color = LLUIColorTable::instance().getColor("MapTrackColor", LLColor4::white);
@@ -332,8 +332,21 @@ void LLNetMap::draw()
             gGL.flush();
 		}
 
-		// Redraw object layer periodically
-		if (mUpdateNow || (map_timer.getElapsedTimeF32() > 0.5f))
+		// Redraw object layer periodically, less often while the map is in the background
+		static LLCachedControl<F32> unfocused_interval(gSavedSettings, "MiniMapUnfocusedUpdateInterval", 0.f);
+		F32 update_interval = 0.5f;
+		if (unfocused_interval > update_interval && !mPanning)
+		{
+			S32 mouse_x, mouse_y;
+			LLUI::getInstance()->getMousePositionLocal(this, &mouse_x, &mouse_y);
+			LLFloater* floater = getParentByType<LLFloater>();
+			if (!pointInView(mouse_x, mouse_y) && !(floater && floater->isFrontmost()))
+			{
+				update_interval = unfocused_interval;
+			}
+		}
+
+		if (mUpdateNow || (mObjectUpdateTimer.getElapsedTimeF32() > update_interval))
 		{
 			mUpdateNow = false;
 
@@ -353,7 +366,7 @@ void LLNetMap::draw()
 
 			mObjectImagep->setSubImage(mObjectRawImagep, 0, 0, mObjectImagep->getWidth(), mObjectImagep->getHeight());
 			
-			map_timer.reset();
+			mObjectUpdateTimer.reset();
 		}
 
 		LLVector3 map_center_agent = gAgent.getPosAgentFromGlobal(mObjectImageCenterGlobal);
@@ -402,27 +415,58 @@ void LLNetMap::draw()
 
 		LLWorld::getInstance()->getAvatars(&avatar_ids, &positions, gAgentCamera.getCameraPositionGlobal());
 
-		// Draw avatars
+		// Work out every avatar's marker first and draw them grouped by
+		// marker image, so the dots share a texture bind instead of
+		// flushing the batch whenever the height class changes.
+		struct AvatarDot
+		{
+			LLUUID			mID;
+			LLVector3		mPosMap;
+			LLColor4		mColor;
+			LLUIImagePtr	mImage;
+		};
+		std::vector<AvatarDot> dots;
+		dots.reserve(avatar_ids.size());
 		for (U32 i = 0; i < avatar_ids.size(); i++)
 		{
-			LLUUID uuid = avatar_ids[i];
+			const LLUUID& uuid = avatar_ids[i];
 			// Skip self, we'll draw it later
 			if (uuid == gAgent.getID()) continue;
 
-			pos_map = globalPosToView(positions[i]);
+			AvatarDot dot;
+			dot.mID = uuid;
+			dot.mPosMap = globalPosToView(positions[i]);
 
 			bool show_as_friend = (LLAvatarTracker::instance().getBuddyInfo(uuid) != NULL);
-
-			LLColor4 color = show_as_friend ? map_avatar_friend_color : map_avatar_color;
+			dot.mColor = show_as_friend ? map_avatar_friend_color : map_avatar_color;
 
 			unknown_relative_z = positions[i].mdV[VZ] >= COARSEUPDATE_MAX_Z &&
 					camera_position.mV[VZ] >= COARSEUPDATE_MAX_Z;
+			dot.mImage = LLWorldMapView::getAvatarImage(dot.mPosMap.mV[VZ], unknown_relative_z);
+			dots.push_back(dot);
+		}
+
+		std::stable_sort(dots.begin(), dots.end(), [](const AvatarDot& lhs, const AvatarDot& rhs)
+			{
+				return lhs.mImage.get() < rhs.mImage.get();
+			});
+
+		// Draw avatars
+		S32 avatar_dot_width = ll_round(mDotRadius * 2.f);
+		for (const AvatarDot& dot : dots)
+		{
+			dot.mImage->draw(ll_round(dot.mPosMap.mV[VX] - mDotRadius),
+							 ll_round(dot.mPosMap.mV[VY] - mDotRadius),
+							 avatar_dot_width,
+							 avatar_dot_width,
+							 dot.mColor);
+		}
 
-			LLWorldMapView::drawAvatar(
-				pos_map.mV[VX], pos_map.mV[VY], 
-				color, 
-				pos_map.mV[VZ], mDotRadius,
-				unknown_relative_z);
+		for (const AvatarDot& dot : dots)
+		{
+			const LLUUID& uuid = dot.mID;
+			pos_map = dot.mPosMap;
+			const LLColor4& color = dot.mColor;
 
 			if(uuid.notNull())
 			{
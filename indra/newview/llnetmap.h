@@ -34,6 +34,7 @@
 #include "v4color.h"
 #include "llpointer.h"
 #include "llcoord.h"
+#include "llframetimer.h"
 
 class LLColor4U;
 class LLImageRaw;
@@ -135,6 +136,7 @@ private:
     LLCoordGL       mMouseDown; // pointer position at start of drag
 
 	LLVector3d		mObjectImageCenterGlobal;
+	LLFrameTimer	mObjectUpdateTimer;		// since the object layer was last redrawn
 	LLPointer<LLImageRaw> mObjectRawImagep;
 	LLPointer<LLViewerTexture>	mObjectImagep;
 
@@ -798,7 +798,9 @@ void LLOutfitGallery::updateAddedCategory(LLUUID cat_id)
     if (mOutfitsObserver == NULL)
     {
         mOutfitsObserver = new LLInventoryCategoriesObserver();
-        gInventory.addObserver(mOutfitsObserver);
+        // Outfits only change inside "My Outfits", ignore the rest of inventory
+        gInventory.addObserver(mOutfitsObserver, LLInventoryObserver::ALL,
+            gInventory.findCategoryUUIDForType(LLFolderType::FT_MY_OUTFITS));
     }
 
     // Start observing changes in "My Outfits" category.
@@ -816,7 +816,7 @@ void LLOutfitListBase::onOpen(const LLSD& info)
         if (!category)
             return;
 
-        gInventory.addObserver(mCategoriesObserver);
+        gInventory.addObserver(mCategoriesObserver, LLInventoryObserver::ALL, outfits);
 
         // Start observing changes in "My Outfits" category.
         mCategoriesObserver->addCategory(outfits,
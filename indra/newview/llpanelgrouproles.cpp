@@ -1797,6 +1797,16 @@ void LLPanelGroupMembersSubTab::updateMembers()
 	if(mMemberProgress == gdatap->mMembers.begin())
 	{
 		mMembersList->deleteAllItems();
+
+		// The list is filled over several frames, ask for all the names up
+		// front so they go out in full batches
+		uuid_vec_t member_ids;
+		member_ids.reserve(gdatap->mMembers.size());
+		for (const auto& member : gdatap->mMembers)
+		{
+			member_ids.push_back(member.first);
+		}
+		LLAvatarNameCache::getInstance()->requestNames(member_ids);
 	}
 
 	LLGroupMgrGroupData::member_list_t::iterator end = gdatap->mMembers.end();
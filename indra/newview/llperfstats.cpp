@@ -82,6 +82,7 @@ namespace LLPerfStats
         if( tuningFlag & UserTargetFPS ){ gSavedSettings.setU32("TargetFPS", userTargetFPS); };
         // Note: The Max ART slider is logarithmic and thus we have an intermediate proxy value
         if( tuningFlag & UserARTCutoff ){ gSavedSettings.setF32("RenderAvatarMaxART", userARTCutoffSliderValue); };
+        if( tuningFlag & ResolutionScale ){ gSavedSettings.setF32("RenderResolutionScale", resolutionScale); };
         resetChanges();
     }
 
@@ -121,6 +122,7 @@ namespace LLPerfStats
         // the following variables are two way and have "push" in llviewercontrol 
         LLPerfStats::tunables.userMinDrawDistance = gSavedSettings.getF32("AutoTuneRenderFarClipMin");
         LLPerfStats::tunables.userTargetDrawDistance = gSavedSettings.getF32("AutoTuneRenderFarClipTarget");
+        LLPerfStats::tunables.userMinResolutionScale = llclamp(gSavedSettings.getF32("AutoTuneResolutionScaleMin"), 0.5f, 1.f);
         LLPerfStats::tunables.userImpostorDistance = gSavedSettings.getF32("AutoTuneImpostorFarAwayDistance");
         LLPerfStats::tunables.userImpostorDistanceTuningEnabled = gSavedSettings.getBOOL("AutoTuneImpostorByDistEnabled");
         LLPerfStats::tunables.userFPSTuningStrategy = gSavedSettings.getU32("TuningFPSStrategy");
@@ -442,6 +444,15 @@ namespace LLPerfStats
                         }
                         else // deliberately "else" here so we only do one of these in any given frame
 #endif
+                        // render at a lower resolution before giving up draw distance,
+                        // one step per update as each change reallocates the screen targets
+                        if(LLPipeline::RenderResolutionScale - RES_SCALE_STEP >= tunables.userMinResolutionScale - F_APPROXIMATELY_ZERO)
+                        {
+                            LLPerfStats::tunables.updateResolutionScale( LLPipeline::RenderResolutionScale - RES_SCALE_STEP );
+                            LLPerfStats::lastGlobalPrefChange = gFrameCount;
+                            return;
+                        }
+                        else // only one change in any given frame
                         {
                             // step down the DD by 10m per update
                             auto new_dd = (LLPipeline::RenderFarClip - DD_STEP > tunables.userMinDrawDistance)?(LLPipeline::RenderFarClip - DD_STEP) : tunables.userMinDrawDistance;
@@ -532,6 +543,13 @@ namespace LLPerfStats
                         LLPerfStats::lastGlobalPrefChange = gFrameCount;
                         return;
                     }
+                    if( LLPipeline::RenderResolutionScale < 1.f )
+                    {
+                        // resolution was the first thing given up so it is the last restored
+                        LLPerfStats::tunables.updateResolutionScale( std::min(LLPipeline::RenderResolutionScale + RES_SCALE_STEP, 1.f) );
+                        LLPerfStats::lastGlobalPrefChange = gFrameCount;
+                        return;
+                    }
                     if( (tot_frame_time_raw * 1.5) < target_frame_time_raw )
                     {
                         // if everything else is "max" and we have >50% headroom let's knock the water quality up a notch at a time.
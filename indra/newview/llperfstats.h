@@ -55,6 +55,7 @@ namespace LLPerfStats
     static constexpr F32 PREFERRED_DD{180};
     static constexpr U32 SMOOTHING_PERIODS{50};
     static constexpr U32 DD_STEP{10};
+    static constexpr F32 RES_SCALE_STEP{0.1f};
 
     static constexpr U32 TUNE_AVATARS_ONLY{0};
     static constexpr U32 TUNE_SCENE_AND_AVATARS{1};
@@ -118,6 +119,7 @@ namespace LLPerfStats
         static constexpr U32 UserAutoTuneEnabled{256};
         static constexpr U32 UserTargetFPS{512};
         static constexpr U32 UserARTCutoff{1024};
+        static constexpr U32 ResolutionScale{2048};
         static constexpr U32 UserAutoTuneLock{4096};
 
         U32 tuningFlag{0}; // bit mask for changed settings
@@ -135,6 +137,8 @@ namespace LLPerfStats
         bool userAutoTuneLock{true};
         U32 userTargetFPS{0};
         F32 userARTCutoffSliderValue{0};
+        F32 resolutionScale{1.0};
+        F32 userMinResolutionScale{1.0};
         S32 userTargetReflections{0};
         bool autoTuneTimeout{true};
         bool vsyncEnabled{true};
@@ -151,6 +155,7 @@ namespace LLPerfStats
         void updateUserARTCutoffSlider(F32 nv){userARTCutoffSliderValue=nv; tuningFlag |= UserARTCutoff;};
         void updateUserAutoTuneEnabled(bool nv){userAutoTuneEnabled=nv; tuningFlag |= UserAutoTuneEnabled;};
         void updateUserAutoTuneLock(bool nv){userAutoTuneLock=nv; tuningFlag |= UserAutoTuneLock;};
+        void updateResolutionScale(F32 nv){resolutionScale=nv; tuningFlag |= ResolutionScale;};
 
         void resetChanges(){tuningFlag=Nothing;};
         void initialiseFromSettings();
@@ -35,10 +35,15 @@
 
 #include "llphysicsmotion.h"
 #include "llagent.h"
+#include "llavatarrenderbenchmark.h"
 #include "llcharacter.h"
 #include "llviewercontrol.h"
 #include "llviewervisualparam.h"
 #include "llvoavatarself.h"
+#include "pipeline.h"
+
+#include <algorithm>
+#include <mutex>
 
 typedef std::map<std::string, std::string> controller_map_t;
 typedef std::map<std::string, F32> default_controller_map_t;
@@ -47,6 +52,8 @@ typedef std::map<std::string, F32> default_controller_map_t;
 // we use TIME_ITERATION_STEP_MAX in division operation, make sure this is a simple
 // value and devision result won't end with repeated/recurring tail like 1.333(3)
 #define TIME_ITERATION_STEP_MAX 0.05f // minimal step size will end up as 0.025
+// step size of the batched simulation, see LLPhysicsMotionController::updateBatch()
+#define TIME_FIXED_STEP 0.025f
 
 inline F64 llsgn(const F64 a)
 {
@@ -108,9 +115,13 @@ public:
                 mParamControllers(controllers),
                 mCharacter(character),
                 mLastTime(0),
+                mTimeAccumulated(0),
                 mPosition_local(0),
                 mVelocityJoint_local(0),
-                mPositionLastUpdate_local(0)
+                mPositionLastUpdate_local(0),
+                mPendingValue_local(0),
+                mPendingMaxEffect(0),
+                mHasPendingValue(false)
         {
                 mJointState = new LLJointState;
 
@@ -126,6 +137,15 @@ public:
 
         BOOL onUpdate(F32 time);
 
+        // onUpdate() in two halves.  simulate() only advances the spring and
+        // leaves the new position pending, so it may run on a worker thread
+        // while nothing else touches the character.  applyParamValues() then
+        // writes the pending position into the visual params on the main thread.
+        // With fixed_step the spring advances in TIME_FIXED_STEP steps and
+        // carries the remainder over to the next call.
+        BOOL simulate(F32 time, bool fixed_step);
+        void applyParamValues();
+
         LLPointer<LLJointState> getJointState() 
         {
                 return mJointState;
@@ -196,6 +216,12 @@ private:
         LLCharacter *mCharacter;
 
         F32 mLastTime;
+        F32 mTimeAccumulated; // time not yet simulated by fixed steps
+
+        // result of simulate() waiting for applyParamValues()
+        F32 mPendingValue_local;
+        F32 mPendingMaxEffect;
+        bool mHasPendingValue;
         
 		LLVisualParam* mParamCache[NUM_PARAMS];
 
@@ -233,15 +259,34 @@ BOOL LLPhysicsMotion::initialize()
         return TRUE;
 }
 
+LLPhysicsMotionController::motion_controller_vec_t LLPhysicsMotionController::sBatch;
+LLPhysicsMotionController::motion_controller_vec_t LLPhysicsMotionController::sPendingVisuals;
+std::mutex LLPhysicsMotionController::sBatchMutex;
+
 LLPhysicsMotionController::LLPhysicsMotionController(const LLUUID &id) : 
         LLMotion(id),
-        mCharacter(NULL)
+        mCharacter(NULL),
+        mBatchTime(0),
+        mInBatch(false),
+        mVisualsPending(false)
 {
         mName = "breast_motion";
 }
 
 LLPhysicsMotionController::~LLPhysicsMotionController()
 {
+        {
+                std::lock_guard<std::mutex> lock(sBatchMutex);
+                if (mInBatch)
+                {
+                        sBatch.erase(std::find(sBatch.begin(), sBatch.end(), this));
+                }
+                if (mVisualsPending)
+                {
+                        sPendingVisuals.erase(std::find(sPendingVisuals.begin(), sPendingVisuals.end(), this));
+                }
+        }
+
         for (motion_vec_t::iterator iter = mMotions.begin();
              iter != mMotions.end();
              ++iter)
@@ -455,11 +500,26 @@ BOOL LLPhysicsMotionController::onUpdate(F32 time, U8* joint_mask)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
         // Skip if disabled globally.
-        if (!gSavedSettings.getBOOL("AvatarPhysics"))
+        static LLCachedControl<bool> avatar_physics(gSavedSettings, "AvatarPhysics");
+        if (!avatar_physics)
         {
                 return TRUE;
         }
         
+        // Leave the simulation to updateBatch().
+        static LLCachedControl<bool> avatar_physics_batched(gSavedSettings, "AvatarPhysicsBatched", false);
+        if (avatar_physics_batched)
+        {
+                std::lock_guard<std::mutex> lock(sBatchMutex);
+                if (!mInBatch)
+                {
+                        sBatch.push_back(this);
+                        mInBatch = true;
+                }
+                mBatchTime = time;
+                return TRUE;
+        }
+
         BOOL update_visuals = FALSE;
         for (motion_vec_t::iterator iter = mMotions.begin();
              iter != mMotions.end();
@@ -469,14 +529,95 @@ BOOL LLPhysicsMotionController::onUpdate(F32 time, U8* joint_mask)
                 update_visuals |= motion->onUpdate(time);
         }
                 
+        // This may be running on a "Pipeline" thread, and updateVisualParams()
+        // starts motions and resizes the avatar, so leave it to updateBatch().
         if (update_visuals)
-                mCharacter->updateVisualParams();
+        {
+                std::lock_guard<std::mutex> lock(sBatchMutex);
+                if (!mVisualsPending)
+                {
+                        sPendingVisuals.push_back(this);
+                        mVisualsPending = true;
+                }
+        }
         
         return TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// updateBatch()
+// Called once a frame after every avatar's motions have been evaluated.
+// The springs of all queued controllers are integrated on the "Pipeline"
+// thread pool, each job owning one character.  Writing the visual params
+// and updateVisualParams() stay on the main thread, and the latter runs at
+// most once per character however many of its motions moved.  The
+// updateVisualParams() calls the unbatched onUpdate() deferred run here too.
+//-----------------------------------------------------------------------------
+//static
+void LLPhysicsMotionController::updateBatch()
+{
+        motion_controller_vec_t batch;
+        motion_controller_vec_t pending_visuals;
+        {
+                std::lock_guard<std::mutex> lock(sBatchMutex);
+                batch.swap(sBatch);
+                for (LLPhysicsMotionController* controller : batch)
+                {
+                        controller->mInBatch = false;
+                }
+                pending_visuals.swap(sPendingVisuals);
+                for (LLPhysicsMotionController* controller : pending_visuals)
+                {
+                        controller->mVisualsPending = false;
+                }
+        }
+
+        for (LLPhysicsMotionController* controller : pending_visuals)
+        {
+                controller->mCharacter->updateVisualParams();
+        }
+
+        if (batch.empty())
+        {
+                return;
+        }
+
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+        LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_MOTION);
+
+        std::vector<U8> update_visuals(batch.size(), FALSE);
+        gPipeline.runParallel((U32)batch.size(), [&batch, &update_visuals](U32 i)
+                {
+                        LLPhysicsMotionController* controller = batch[i];
+                        for (LLPhysicsMotion* motion : controller->mMotions)
+                        {
+                                update_visuals[i] |= motion->simulate(controller->mBatchTime, true);
+                        }
+                });
+
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+                LLPhysicsMotionController* controller = batch[i];
+                for (LLPhysicsMotion* motion : controller->mMotions)
+                {
+                        motion->applyParamValues();
+                }
+                if (update_visuals[i])
+                {
+                        controller->mCharacter->updateVisualParams();
+                }
+        }
+}
+
 // Return TRUE if character has to update visual params.
 BOOL LLPhysicsMotion::onUpdate(F32 time)
+{
+        BOOL update_visuals = simulate(time, false);
+        applyParamValues();
+        return update_visuals;
+}
+
+BOOL LLPhysicsMotion::simulate(F32 time, bool fixed_step)
 {
         // static FILE *mFileWrite = fopen("c:\\temp\\avatar_data.txt","w");
         
@@ -486,6 +627,7 @@ BOOL LLPhysicsMotion::onUpdate(F32 time)
         if (!mLastTime || mLastTime >= time)
         {
                 mLastTime = time;
+                mTimeAccumulated = 0;
                 return FALSE;
         }
 
@@ -499,6 +641,7 @@ BOOL LLPhysicsMotion::onUpdate(F32 time)
         if (time_delta > 1.0)
         {
                 mLastTime = time;
+                mTimeAccumulated = 0;
                 return FALSE;
         }
 
@@ -566,6 +709,16 @@ BOOL LLPhysicsMotion::onUpdate(F32 time)
 	// irregularity at higher fps looks to be insignificant so it works good enough for low fps.
 	U32 steps = (U32)(time_delta / TIME_ITERATION_STEP_MAX) + 1;
 	F32 time_iteration_step = time_delta / (F32)steps; //minimal step size ends up as 0.025
+	F32 time_accumulated = 0;
+	if (fixed_step)
+	{
+		// Same behavior at every framerate, not just roughly the same. A frame
+		// shorter than a step only adds to the time the next frame simulates.
+		time_accumulated = mTimeAccumulated + time_delta;
+		steps = (U32)(time_accumulated / TIME_FIXED_STEP);
+		time_iteration_step = TIME_FIXED_STEP;
+		time_accumulated -= (F32)steps * TIME_FIXED_STEP;
+	}
 	for (U32 i = 0; i < steps; i++)
 	{
 		// mPositon_local should be in normalized 0,1 range already.  Just making sure...
@@ -663,24 +816,10 @@ BOOL LLPhysicsMotion::onUpdate(F32 time)
 							       0.0f,
 							       1.0f);
 
-		LLDriverParam *driver_param = dynamic_cast<LLDriverParam *>(mParamDriver);
-		llassert_always(driver_param);
-		if (driver_param)
-		{
-			// If this is one of our "hidden" driver params, then make sure it's
-			// the default value.
-			if ((driver_param->getGroup() != VISUAL_PARAM_GROUP_TWEAKABLE) &&
-			    (driver_param->getGroup() != VISUAL_PARAM_GROUP_TWEAKABLE_NO_TRANSMIT))
-			{
-				mCharacter->setVisualParamWeight(driver_param, 0);
-			}
-			S32 num_driven = driver_param->getDrivenParamsCount();
-			for (S32 i = 0; i < num_driven; ++i)
-			{
-				const LLViewerVisualParam *driven_param = driver_param->getDrivenParam(i);
-				setParamValue(driven_param,position_new_local_clamped, behavior_maxeffect);
-			}
-		}
+		// Only the last step's value is seen, applyParamValues() writes it.
+		mPendingValue_local = position_new_local_clamped;
+		mPendingMaxEffect = behavior_maxeffect;
+		mHasPendingValue = true;
         
 		//
 		// End calculate new params
@@ -721,6 +860,7 @@ BOOL LLPhysicsMotion::onUpdate(F32 time)
 		mPosition_local = position_new_local;
 	}
 	mLastTime = time;
+	mTimeAccumulated = time_accumulated;
 	mPosition_world = joint->getWorldPosition();
 	mVelocityJoint_local = velocity_joint_local;
 
@@ -756,6 +896,34 @@ BOOL LLPhysicsMotion::onUpdate(F32 time)
         return update_visuals;
 }
 
+void LLPhysicsMotion::applyParamValues()
+{
+	if (!mHasPendingValue)
+	{
+		return;
+	}
+	mHasPendingValue = false;
+
+	LLDriverParam *driver_param = dynamic_cast<LLDriverParam *>(mParamDriver);
+	llassert_always(driver_param);
+	if (driver_param)
+	{
+		// If this is one of our "hidden" driver params, then make sure it's
+		// the default value.
+		if ((driver_param->getGroup() != VISUAL_PARAM_GROUP_TWEAKABLE) &&
+		    (driver_param->getGroup() != VISUAL_PARAM_GROUP_TWEAKABLE_NO_TRANSMIT))
+		{
+			mCharacter->setVisualParamWeight(driver_param, 0);
+		}
+		S32 num_driven = driver_param->getDrivenParamsCount();
+		for (S32 i = 0; i < num_driven; ++i)
+		{
+			const LLViewerVisualParam *driven_param = driver_param->getDrivenParam(i);
+			setParamValue(driven_param, mPendingValue_local, mPendingMaxEffect);
+		}
+	}
+}
+
 // Range of new_value_local is assumed to be [0 , 1] normalized.
 void LLPhysicsMotion::setParamValue(const LLViewerVisualParam *param,
                                     F32 new_value_normalized,
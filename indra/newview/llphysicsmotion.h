@@ -33,6 +33,8 @@
 #include "llmotion.h"
 #include "llframetimer.h"
 
+#include <mutex>
+
 #define PHYSICS_MOTION_FADEIN_TIME 1.0f
 #define PHYSICS_MOTION_FADEOUT_TIME 1.0f
 
@@ -105,6 +107,12 @@ public:
 
 	LLCharacter* getCharacter() { return mCharacter; }
 
+	// With AvatarPhysicsBatched set, onUpdate() only queues the controller
+	// and this simulates every queued one at once.  Without it, this runs the
+	// updateVisualParams() calls onUpdate() left for the main thread.
+	// Main thread only.
+	static void updateBatch();
+
 protected:
 	void addMotion(LLPhysicsMotion *motion);
 private:
@@ -112,6 +120,16 @@ private:
 
 	typedef std::vector<LLPhysicsMotion *> motion_vec_t;
 	motion_vec_t mMotions;
+
+	F32					mBatchTime;	// time passed to the last queued onUpdate()
+	bool				mInBatch;	// guarded by sBatchMutex
+	bool				mVisualsPending;	// guarded by sBatchMutex
+
+	// onUpdate() may run on the "Pipeline" threads, see AvatarParallelMotions
+	typedef std::vector<LLPhysicsMotionController *> motion_controller_vec_t;
+	static motion_controller_vec_t	sBatch;
+	static motion_controller_vec_t	sPendingVisuals;
+	static std::mutex				sBatchMutex;
 };
 
 #endif // LL_LLPHYSICSMOTION_H
@@ -101,6 +101,9 @@ public:
     // probe has had at least one full update and is ready to render
     bool mComplete = false;
 
+    // geometry inside this probe's influence changed since its last update started
+    bool mContentsChanged = false;
+
     // fade in parameter for this probe
     F32 mFadeIn = 0.f;
 
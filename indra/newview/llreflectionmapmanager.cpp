@@ -85,8 +85,32 @@ static F32 update_score(LLReflectionMap* p)
     return gFrameTimeSeconds - p->mLastUpdateTime  - p->mDistance*0.1f;
 }
 
+// rough fraction of the view the probe's influence covers, 1 when the camera is inside it
+static F32 screen_coverage(LLReflectionMap* p)
+{
+    if (p->mDistance <= 0.f)
+    {
+        return 1.f;
+    }
+
+    F32 r = p->mRadius / (p->mDistance + p->mRadius);
+    return r * r;
+}
+
+// update_score for UpdateSchedule::PRIORITY
+// staleness weighted by how much of the view the probe covers, probes whose contents changed come first
+static F32 scheduled_update_score(LLReflectionMap* p)
+{
+    F32 weight = 0.1f + screen_coverage(p);
+    if (p->mContentsChanged)
+    {
+        weight *= 4.f;
+    }
+    return (gFrameTimeSeconds - p->mLastUpdateTime) * weight;
+}
+
 // return true if a is higher priority for an update than b
-static bool check_priority(LLReflectionMap* a, LLReflectionMap* b)
+static bool check_priority(LLReflectionMap* a, LLReflectionMap* b, F32 (*score)(LLReflectionMap*))
 {
     if (a->mCubeIndex == -1)
     { // not a candidate for updating
@@ -102,7 +126,7 @@ static bool check_priority(LLReflectionMap* a, LLReflectionMap* b)
     }
     else if (a->mComplete && b->mComplete)
     { //both probes are complete, use update_score metric
-        return update_score(a) > update_score(b);
+        return score(a) > score(b);
     }
 
     // a or b is not complete,
@@ -183,10 +207,18 @@ void LLReflectionMapManager::update()
     }
 
 
-    bool did_update = false;
-    
     static LLCachedControl<S32> sDetail(gSavedSettings, "RenderReflectionProbeDetail", -1);
     static LLCachedControl<S32> sLevel(gSavedSettings, "RenderReflectionProbeLevel", 3);
+    static LLCachedControl<S32> sSchedule(gSavedSettings, "RenderReflectionProbeSchedule", 0);
+
+    bool scheduled = sSchedule == (S32)UpdateSchedule::PRIORITY;
+    F32 (*score)(LLReflectionMap*) = scheduled ? scheduled_update_score : update_score;
+
+    if (scheduled)
+    {
+        updateFaceTimers();
+        applyDirtyBounds();
+    }
 
     bool realtime = sDetail >= (S32)LLReflectionMapManager::DetailLevel::REALTIME;
     
@@ -195,12 +227,16 @@ void LLReflectionMapManager::update()
     LLReflectionMap* oldestProbe = nullptr;
     LLReflectionMap* oldestOccluded = nullptr;
 
+    mFacesLeft = getFaceBudget();
+
     if (mUpdatingProbe != nullptr)
     {
-        did_update = true;
         doProbeUpdate();
     }
 
+    // a probe that finished within this frame's budget leaves room to start the next one
+    bool did_update = mFacesLeft == 0;
+
     // update distance to camera for all probes
     std::sort(mProbes.begin()+1, mProbes.end(), CompareProbeDistance());
     llassert(mProbes[0] == mDefaultProbe);
@@ -300,7 +336,7 @@ void LLReflectionMapManager::update()
             if (!did_update &&
                 i < mReflectionProbeCount &&
                 (oldestProbe == nullptr ||
-                    check_priority(probe, oldestProbe)))
+                    check_priority(probe, oldestProbe, score)))
             {
                oldestProbe = probe;
             }
@@ -359,6 +395,7 @@ void LLReflectionMapManager::update()
 
         sUpdateCount++;
         mUpdatingProbe = probe;
+        probe->mContentsChanged = false;
         doProbeUpdate();
     }
 
@@ -541,33 +578,209 @@ void LLReflectionMapManager::doProbeUpdate()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DISPLAY;
     llassert(mUpdatingProbe != nullptr);
+    llassert(mFacesLeft > 0);
 
-    updateProbeFace(mUpdatingProbe, mUpdatingFace);
-    
-    bool debug_updates = gPipeline.hasRenderDebugMask(LLPipeline::RENDER_DEBUG_PROBE_UPDATES) && mUpdatingProbe->mViewerObject;
+    FaceTimer* timer = beginFaceTimer();
 
-    if (++mUpdatingFace == 6)
+    do
     {
-        if (debug_updates)
+        --mFacesLeft;
+        updateProbeFace(mUpdatingProbe, mUpdatingFace);
+
+        if (timer)
         {
-            mUpdatingProbe->mViewerObject->setDebugText(llformat("%.1f", (F32)gFrameTimeSeconds), LLColor4(1, 1, 1, 1));
+            ++timer->mFaces;
         }
-        updateNeighbors(mUpdatingProbe);
-        mUpdatingFace = 0;
-        if (isRadiancePass())
+
+        bool debug_updates = gPipeline.hasRenderDebugMask(LLPipeline::RENDER_DEBUG_PROBE_UPDATES) && mUpdatingProbe->mViewerObject;
+
+        if (++mUpdatingFace == 6)
         {
-            mUpdatingProbe->mComplete = true;
-            mUpdatingProbe = nullptr;
-            mRadiancePass = false;
+            if (debug_updates)
+            {
+                mUpdatingProbe->mViewerObject->setDebugText(llformat("%.1f", (F32)gFrameTimeSeconds), LLColor4(1, 1, 1, 1));
+            }
+            updateNeighbors(mUpdatingProbe);
+            mUpdatingFace = 0;
+            if (isRadiancePass())
+            {
+                mUpdatingProbe->mComplete = true;
+                mUpdatingProbe = nullptr;
+                mRadiancePass = false;
+            }
+            else
+            {
+                mRadiancePass = true;
+            }
         }
-        else
+        else if (debug_updates)
         {
-            mRadiancePass = true;
+            mUpdatingProbe->mViewerObject->setDebugText(llformat("%.1f", (F32)gFrameTimeSeconds), LLColor4(1, 1, 0, 1));
         }
+    } while (mUpdatingProbe != nullptr && mFacesLeft > 0);
+
+    endFaceTimer(timer);
+}
+
+U32 LLReflectionMapManager::getFaceBudget()
+{
+    static LLCachedControl<S32> sSchedule(gSavedSettings, "RenderReflectionProbeSchedule", 0);
+    static LLCachedControl<F32> sBudget(gSavedSettings, "RenderReflectionProbeUpdateBudget", 1.f);
+
+    if (sSchedule != (S32)UpdateSchedule::PRIORITY || mFaceCost <= 0.f)
+    { // one face per frame until there's a measurement to budget with
+        return 1;
     }
-    else if (debug_updates)
+
+    // never more than one full probe (irradiance + radiance) per frame
+    return (U32)llclamp((S32)(sBudget / mFaceCost), 1, 12);
+}
+
+void LLReflectionMapManager::markDirty(LLSpatialGroup* group)
+{
+    static LLCachedControl<S32> sSchedule(gSavedSettings, "RenderReflectionProbeSchedule", 0);
+    if (sSchedule != (S32)UpdateSchedule::PRIORITY || mAllDirty)
     {
-        mUpdatingProbe->mViewerObject->setDebugText(llformat("%.1f", (F32)gFrameTimeSeconds), LLColor4(1, 1, 0, 1));
+        return;
+    }
+
+    // bridge bounds are not in agent space, and whatever moves is handled by dynamic probes anyway
+    LLSpatialPartition* part = group->getSpatialPartition();
+    U32 type = part->mPartitionType;
+    if (part->asBridge() ||
+        (type != LLViewerRegion::PARTITION_VOLUME && type != LLViewerRegion::PARTITION_TERRAIN && type != LLViewerRegion::PARTITION_TREE))
+    {
+        return;
+    }
+
+    // past a handful of changes a region is loading in, just flag everything
+    const U32 MAX_DIRTY_GROUPS = 64;
+    if (mDirtyBounds.size() >= MAX_DIRTY_GROUPS)
+    {
+        mAllDirty = true;
+        mDirtyBounds.clear();
+        return;
+    }
+
+    const LLVector4a* bounds = group->getBounds();
+    LLVector4a min;
+    LLVector4a max;
+    min.setSub(bounds[0], bounds[1]);
+    max.setAdd(bounds[0], bounds[1]);
+    mDirtyBounds.emplace_back(LLVector3(min.getF32ptr()), LLVector3(max.getF32ptr()));
+}
+
+void LLReflectionMapManager::applyDirtyBounds()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DISPLAY;
+
+    if (!mAllDirty && mDirtyBounds.empty())
+    {
+        return;
+    }
+
+    for (U32 i = 1; i < mProbes.size(); ++i)
+    {
+        LLReflectionMap* probe = mProbes[i];
+        if (probe->mContentsChanged || probe->mCubeIndex == -1)
+        {
+            continue;
+        }
+
+        if (mAllDirty)
+        {
+            probe->mContentsChanged = true;
+            continue;
+        }
+
+        F32 radius_sq = probe->mRadius * probe->mRadius;
+        for (auto& bounds : mDirtyBounds)
+        {
+            LLVector4a min;
+            LLVector4a max;
+            min.load3(bounds.first.mV);
+            max.load3(bounds.second.mV);
+
+            // closest point of the box to the probe
+            LLVector4a d;
+            d.setMax(min, probe->mOrigin);
+            d.setMin(d, max);
+            d.sub(probe->mOrigin);
+
+            if (d.dot3(d).getF32() <= radius_sq)
+            {
+                probe->mContentsChanged = true;
+                break;
+            }
+        }
+    }
+
+    mDirtyBounds.clear();
+    mAllDirty = false;
+}
+
+LLReflectionMapManager::FaceTimer* LLReflectionMapManager::beginFaceTimer()
+{
+    static LLCachedControl<S32> sSchedule(gSavedSettings, "RenderReflectionProbeSchedule", 0);
+
+    // shader profiling has its own GL_TIME_ELAPSED queries open, which can't nest
+    if (sSchedule != (S32)UpdateSchedule::PRIORITY || LLGLSLShader::sProfileEnabled)
+    {
+        return nullptr;
+    }
+
+    FaceTimer* timer = &mFaceTimers[mNextFaceTimer];
+    if (timer->mPending)
+    { // GPU is too far behind, skip this sample rather than wait
+        return nullptr;
+    }
+
+    if (!timer->mQuery)
+    {
+        glGenQueries(1, &timer->mQuery);
+    }
+
+    timer->mFaces = 0;
+    glBeginQuery(GL_TIME_ELAPSED, timer->mQuery);
+    return timer;
+}
+
+void LLReflectionMapManager::endFaceTimer(FaceTimer* timer)
+{
+    if (timer)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        timer->mPending = true;
+        mNextFaceTimer = (mNextFaceTimer + 1) % NUM_FACE_TIMERS;
+    }
+}
+
+void LLReflectionMapManager::updateFaceTimers()
+{
+    for (U32 i = 0; i < NUM_FACE_TIMERS; ++i)
+    {
+        FaceTimer& timer = mFaceTimers[i];
+        if (!timer.mPending)
+        {
+            continue;
+        }
+
+        GLuint available = 0;
+        glGetQueryObjectuiv(timer.mQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            continue;
+        }
+
+        GLuint64 time_elapsed = 0;
+        glGetQueryObjectui64v(timer.mQuery, GL_QUERY_RESULT, &time_elapsed);
+        timer.mPending = false;
+
+        if (timer.mFaces > 0)
+        {
+            F32 face_cost = time_elapsed / 1000000.f / timer.mFaces;
+            mFaceCost = mFaceCost > 0.f ? lerp(mFaceCost, face_cost, 0.1f) : face_cost;
+        }
     }
 }
 
@@ -1363,6 +1576,20 @@ void LLReflectionMapManager::cleanup()
     mDefaultProbe = nullptr;
     mUpdatingProbe = nullptr;
 
+    for (U32 i = 0; i < NUM_FACE_TIMERS; ++i)
+    {
+        if (mFaceTimers[i].mQuery)
+        {
+            glDeleteQueries(1, &mFaceTimers[i].mQuery);
+        }
+        mFaceTimers[i] = FaceTimer();
+    }
+    mNextFaceTimer = 0;
+    mFaceCost = 0.f;
+
+    mDirtyBounds.clear();
+    mAllDirty = false;
+
     glDeleteBuffers(1, &mUBO);
     mUBO = 0;
 
@@ -54,6 +54,13 @@ public:
         REALTIME = 2
     };
 
+    // policy used to pick which probe to update next (RenderReflectionProbeSchedule)
+    enum class UpdateSchedule
+    {
+        ROUND_ROBIN = 0,    // one face per frame, oldest probe first
+        PRIORITY = 1        // as many faces as fit in RenderReflectionProbeUpdateBudget, scored by coverage, distance and changes
+    };
+
     // allocate an environment map of the given resolution 
     LLReflectionMapManager();
 
@@ -106,6 +113,10 @@ public:
     // perform occlusion culling on all active reflection probes
     void doOcclusion();
 
+    // called by LLSpatialGroup when its geometry is rebuilt or destroyed
+    // under the priority schedule, probes that can see group jump the update queue
+    void markDirty(LLSpatialGroup* group);
+
 private:
     friend class LLPipeline;
 
@@ -151,6 +162,26 @@ private:
 
     // update the specified face of the specified probe
     void updateProbeFace(LLReflectionMap* probe, U32 face);
+
+    // number of probe faces to render this frame under the current schedule
+    U32 getFaceBudget();
+
+    // flag probes whose influence overlaps mDirtyBounds as changed
+    void applyDirtyBounds();
+
+    // collect finished GPU timer queries into mFaceCost
+    void updateFaceTimers();
+
+    struct FaceTimer
+    {
+        U32 mQuery = 0;
+        U32 mFaces = 0;
+        bool mPending = false;
+    };
+
+    // start timing the faces rendered by doProbeUpdate, returns nullptr if no free query
+    FaceTimer* beginFaceTimer();
+    void endFaceTimer(FaceTimer* timer);
     
     // list of active reflection maps
     std::vector<LLPointer<LLReflectionMap> > mProbes;
@@ -170,6 +201,23 @@ private:
     LLReflectionMap* mUpdatingProbe = nullptr;
     U32 mUpdatingFace = 0;
 
+    // number of faces doProbeUpdate may still render this frame (see getFaceBudget)
+    U32 mFacesLeft = 0;
+
+    // timer queries around doProbeUpdate, read back a few frames later so nothing waits on the GPU
+    static const U32 NUM_FACE_TIMERS = 8;
+    FaceTimer mFaceTimers[NUM_FACE_TIMERS];
+    U32 mNextFaceTimer = 0;
+
+    // running average of GPU milliseconds spent on one probe face, 0 until the first measurement lands
+    F32 mFaceCost = 0.f;
+
+    // agent space bounds of static geometry that changed since the last update
+    std::vector<std::pair<LLVector3, LLVector3> > mDirtyBounds;
+
+    // too many changes to track, treat every probe as changed
+    bool mAllDirty = false;
+
     // if true, we're generating the radiance map for the current probe, otherwise we're generating the irradiance map.
     // Update sequence should be to generate the irradiance map from render of the world that has no irradiance,
     // then generate the radiance map from a render of the world that includes irradiance.
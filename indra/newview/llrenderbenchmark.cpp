@@ -0,0 +1,365 @@
+/**
+ * @file llrenderbenchmark.cpp
+ * @brief Render benchmark mode over recorded camera paths.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llrenderbenchmark.h"
+
+#include "llagentpilot.h"
+#include "llappviewer.h"
+#include "llfeaturemanager.h"
+#include "llframetimer.h"
+#include "llgl.h"
+#include "llpresetsmanager.h"
+#include "llviewercontrol.h"
+
+#include <iomanip>
+
+// GPU times of a frame are read back a few frames after it was drawn
+static const U32 GPU_RESULT_FRAMES = 8;
+
+LLRenderBenchmark::LLRenderBenchmark()
+:	mState(STATE_IDLE),
+	mCurrentEntry(0),
+	mFirstFrame(0),
+	mLastFrame(0),
+	mNextFrame(0),
+	mTelemetryWasEnabled(false),
+	mPilotLoop(FALSE)
+{
+}
+
+void LLRenderBenchmark::start()
+{
+	if (!gSavedSettings.getBOOL("RenderBenchmarkEnabled") || isRunning())
+	{
+		return;
+	}
+
+	if (gAgentPilot.getReplaySession())
+	{
+		LL_WARNS() << "Render benchmark can't run with ReplaySession, which quits after one run" << LL_ENDL;
+		return;
+	}
+
+	mEntries.clear();
+	LLStringUtil::getTokens(gSavedSettings.getString("RenderBenchmarkLevels"), mEntries, ",");
+	for (std::string& entry : mEntries)
+	{
+		LLStringUtil::trim(entry);
+	}
+	if (mEntries.empty())
+	{
+		// just the current settings
+		mEntries.push_back(std::string());
+	}
+
+	mResults.clear();
+	mCurrentEntry = 0;
+	mTelemetryWasEnabled = gSavedSettings.getBOOL("FrameTelemetryEnabled");
+	gSavedSettings.setBOOL("FrameTelemetryEnabled", TRUE);
+	mPilotLoop = gAgentPilot.getLoop();
+	gAgentPilot.setLoop(FALSE);
+
+	LL_INFOS() << "Starting render benchmark of " << mEntries.size() << " entries" << LL_ENDL;
+	applyNextEntry();
+}
+
+void LLRenderBenchmark::applyNextEntry()
+{
+	const std::string& entry = mEntries[mCurrentEntry];
+	if (!entry.empty())
+	{
+		U32 level = 0;
+		if (LLStringUtil::convertToU32(entry, level))
+		{
+			if (LLFeatureManager::instance().isValidGraphicsLevel(level))
+			{
+				LLFeatureManager::getInstance()->setGraphicsLevel(level, false);
+				gSavedSettings.setU32("RenderQualityPerformance", level);
+			}
+			else
+			{
+				LL_WARNS() << "Render benchmark skipping invalid graphics level " << level << LL_ENDL;
+			}
+		}
+		else
+		{
+			LLPresetsManager::getInstance()->loadPreset(PRESETS_GRAPHIC, entry);
+		}
+	}
+
+	LL_INFOS() << "Render benchmark entry '" << entry << "', settling" << LL_ENDL;
+	mSettleTimer.reset();
+	mState = STATE_SETTLING;
+}
+
+void LLRenderBenchmark::update()
+{
+	if (mState == STATE_IDLE)
+	{
+		return;
+	}
+
+	static LLCachedControl<F32> settle_time(gSavedSettings, "RenderBenchmarkSettleTime", 10.f);
+	U32 current_frame = LLFrameTimer::getFrameCount();
+
+	switch (mState)
+	{
+	case STATE_SETTLING:
+		if (mSettleTimer.getElapsedTimeF32() > settle_time)
+		{
+			gAgentPilot.startPlayback();
+			if (!gAgentPilot.isPlaying())
+			{
+				LL_WARNS() << "Render benchmark has no pilot path to fly, record one first" << LL_ENDL;
+				finish();
+				return;
+			}
+			mFirstFrame = 0;
+			mCollected.clear();
+			mState = STATE_FLYING;
+		}
+		break;
+
+	case STATE_FLYING:
+		if (!mFirstFrame && gAgentPilot.isStarted())
+		{
+			// the walk to the first waypoint isn't measured
+			mFirstFrame = current_frame;
+			mNextFrame = current_frame;
+		}
+		if (!gAgentPilot.isPlaying())
+		{
+			mLastFrame = current_frame;
+			mState = STATE_DRAINING;
+		}
+		if (mFirstFrame)
+		{
+			collectFrames(current_frame);
+		}
+		break;
+
+	case STATE_DRAINING:
+		if (mFirstFrame)
+		{
+			collectFrames(current_frame);
+		}
+		if (current_frame > mLastFrame + GPU_RESULT_FRAMES)
+		{
+			finishEntry();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void LLRenderBenchmark::collectFrames(U32 current_frame)
+{
+	if (!LLFrameTelemetry::instanceExists())
+	{
+		return;
+	}
+
+	for (const LLFrameTelemetry::Frame& frame : LLFrameTelemetry::instance().getFrames())
+	{
+		if (frame.mNumber < mNextFrame || frame.mNumber + GPU_RESULT_FRAMES > current_frame)
+		{
+			continue;
+		}
+		if (mState == STATE_DRAINING && frame.mNumber > mLastFrame)
+		{
+			break;
+		}
+		mCollected.push_back(frame);
+		mNextFrame = frame.mNumber + 1;
+	}
+}
+
+void LLRenderBenchmark::finishEntry()
+{
+	Result result;
+	result.mName = mEntries[mCurrentEntry].empty() ? "current" : mEntries[mCurrentEntry];
+	result.mFrames = (U32)mCollected.size();
+	result.mFrameMean = result.mFrameP50 = result.mFrameP95 = result.mFrameP99 = 0.f;
+	result.mDrawCalls = result.mTriangles = 0.f;
+
+	F64 cpu[LLStallMonitor::PHASE_COUNT] = {};
+	F64 gpu[LLFrameTelemetry::PASS_COUNT] = {};
+	U32 gpu_frames[LLFrameTelemetry::PASS_COUNT] = {};
+	std::vector<F32> totals;
+	totals.reserve(mCollected.size());
+	F64 total = 0.0;
+	F64 draw_calls = 0.0;
+	F64 triangles = 0.0;
+
+	for (const LLFrameTelemetry::Frame& frame : mCollected)
+	{
+		totals.push_back(frame.mTotal);
+		total += frame.mTotal;
+		for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+		{
+			cpu[i] += frame.mCPU[i];
+		}
+		for (S32 i = 0; i < LLFrameTelemetry::PASS_COUNT; ++i)
+		{
+			if (frame.mGPU[i] >= 0.f)
+			{
+				gpu[i] += frame.mGPU[i];
+				++gpu_frames[i];
+			}
+		}
+		draw_calls += frame.mDrawCalls;
+		triangles += frame.mTriangles;
+	}
+
+	F64 count = llmax((F64)mCollected.size(), 1.0);
+	for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+	{
+		result.mCPU[i] = (F32)(cpu[i] / count);
+	}
+	for (S32 i = 0; i < LLFrameTelemetry::PASS_COUNT; ++i)
+	{
+		result.mGPU[i] = gpu_frames[i] ? (F32)(gpu[i] / gpu_frames[i]) : -1.f;
+	}
+	if (!totals.empty())
+	{
+		std::sort(totals.begin(), totals.end());
+		size_t last = totals.size() - 1;
+		result.mFrameMean = (F32)(total / count);
+		result.mFrameP50 = totals[llmin((size_t)(totals.size() * 0.50), last)];
+		result.mFrameP95 = totals[llmin((size_t)(totals.size() * 0.95), last)];
+		result.mFrameP99 = totals[llmin((size_t)(totals.size() * 0.99), last)];
+		result.mDrawCalls = (F32)(draw_calls / count);
+		result.mTriangles = (F32)(triangles / count);
+	}
+
+	LL_INFOS() << "Render benchmark entry '" << result.mName << "': " << result.mFrames << " frames, mean "
+			   << result.mFrameMean << "ms, p95 " << result.mFrameP95 << "ms, p99 " << result.mFrameP99 << "ms" << LL_ENDL;
+	mResults.push_back(result);
+	mCollected.clear();
+
+	if (++mCurrentEntry < mEntries.size())
+	{
+		applyNextEntry();
+	}
+	else
+	{
+		finish();
+	}
+}
+
+void LLRenderBenchmark::finish()
+{
+	mState = STATE_IDLE;
+	gSavedSettings.setBOOL("FrameTelemetryEnabled", mTelemetryWasEnabled);
+	gAgentPilot.setLoop(mPilotLoop);
+
+	if (!mResults.empty())
+	{
+		std::string csv_file = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "render_benchmark.csv");
+		std::string json_file = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "render_benchmark.json");
+		if (writeResults(csv_file, json_file))
+		{
+			LL_INFOS() << "Saved render benchmark results to " << csv_file << LL_ENDL;
+		}
+	}
+
+	if (gSavedSettings.getBOOL("RenderBenchmarkQuit"))
+	{
+		LLAppViewer::instance()->forceQuit();
+	}
+}
+
+bool LLRenderBenchmark::writeResults(const std::string& csv_file, const std::string& json_file) const
+{
+	llofstream csv(csv_file.c_str());
+	llofstream json(json_file.c_str());
+	if (!csv.is_open() || !json.is_open())
+	{
+		LL_WARNS() << "Unable to write render benchmark results to " << csv_file << " or " << json_file << LL_ENDL;
+		return false;
+	}
+
+	csv << std::fixed << std::setprecision(3);
+	json << std::fixed << std::setprecision(3);
+
+	csv << "entry,frames,frame_mean_ms,frame_p50_ms,frame_p95_ms,frame_p99_ms";
+	for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+	{
+		csv << ",cpu_" << LLStallMonitor::getPhaseName((LLStallMonitor::EPhase)i) << "_ms";
+	}
+	for (S32 i = 0; i < LLFrameTelemetry::PASS_COUNT; ++i)
+	{
+		csv << ",gpu_" << LLFrameTelemetry::getPassName((LLFrameTelemetry::EPass)i) << "_ms";
+	}
+	csv << ",draw_calls,triangles\n";
+
+	json << "{\"gpu\":\"" << gGLManager.mGLRenderer << "\",\"results\":[\n";
+	bool first = true;
+	for (const Result& result : mResults)
+	{
+		csv << result.mName << "," << result.mFrames << "," << result.mFrameMean << "," << result.mFrameP50
+			<< "," << result.mFrameP95 << "," << result.mFrameP99;
+		for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+		{
+			csv << "," << result.mCPU[i];
+		}
+		for (S32 i = 0; i < LLFrameTelemetry::PASS_COUNT; ++i)
+		{
+			csv << ",";
+			if (result.mGPU[i] >= 0.f)
+			{
+				csv << result.mGPU[i];
+			}
+		}
+		csv << "," << result.mDrawCalls << "," << result.mTriangles << "\n";
+
+		json << (first ? "" : ",\n") << "{\"entry\":\"" << result.mName << "\",\"frames\":" << result.mFrames
+			 << ",\"frame_mean_ms\":" << result.mFrameMean << ",\"frame_p50_ms\":" << result.mFrameP50
+			 << ",\"frame_p95_ms\":" << result.mFrameP95 << ",\"frame_p99_ms\":" << result.mFrameP99 << ",\"cpu_ms\":{";
+		for (S32 i = 0; i < LLStallMonitor::PHASE_COUNT; ++i)
+		{
+			json << (i ? "," : "") << "\"" << LLStallMonitor::getPhaseName((LLStallMonitor::EPhase)i) << "\":" << result.mCPU[i];
+		}
+		json << "},\"gpu_ms\":{";
+		bool first_pass = true;
+		for (S32 i = 0; i < LLFrameTelemetry::PASS_COUNT; ++i)
+		{
+			if (result.mGPU[i] >= 0.f)
+			{
+				json << (first_pass ? "" : ",") << "\"" << LLFrameTelemetry::getPassName((LLFrameTelemetry::EPass)i) << "\":" << result.mGPU[i];
+				first_pass = false;
+			}
+		}
+		json << "},\"draw_calls\":" << result.mDrawCalls << ",\"triangles\":" << result.mTriangles << "}";
+		first = false;
+	}
+	json << "\n]}\n";
+
+	return true;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file llrenderbenchmark.h
+ * @brief Render benchmark mode over recorded camera paths.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLRENDERBENCHMARK_H
+#define LL_LLRENDERBENCHMARK_H
+
+#include "llframetelemetry.h"
+#include "llsingleton.h"
+#include "llstallmonitor.h"
+#include "lltimer.h"
+
+#include <string>
+#include <vector>
+
+// Full render benchmark, as opposed to the few milliseconds of gpu_benchmark()
+// LLFeatureManager uses to pick a graphics level. For each entry of
+// RenderBenchmarkLevels (a graphics quality level or a graphics preset name)
+// it applies the entry, waits RenderBenchmarkSettleTime seconds, then flies
+// the recorded LLAgentPilot path once while LLFrameTelemetry records frames.
+// Frame time percentiles, mean CPU phase times, mean GPU pass times, draw
+// calls and triangles per entry go to render_benchmark.csv and .json in the
+// logs folder. Combine with PacketReplayFile for a reproducible scene.
+// The last entry's graphics settings are left applied.
+class LLRenderBenchmark : public LLSingleton<LLRenderBenchmark>
+{
+	LLSINGLETON(LLRenderBenchmark);
+	LOG_CLASS(LLRenderBenchmark);
+public:
+	// after login, does nothing unless RenderBenchmarkEnabled is set
+	void start();
+	// once per frame from idle
+	void update();
+
+	bool isRunning() const { return mState != STATE_IDLE; }
+
+private:
+	enum EState
+	{
+		STATE_IDLE,
+		STATE_SETTLING,		// entry applied, shaders and textures catching up
+		STATE_FLYING,		// pilot playing back
+		STATE_DRAINING		// pilot done, waiting on the last GPU times
+	};
+
+	struct Result
+	{
+		std::string mName;
+		U32 mFrames;
+		F32 mFrameMean;									// milliseconds
+		F32 mFrameP50;
+		F32 mFrameP95;
+		F32 mFrameP99;
+		F32 mCPU[LLStallMonitor::PHASE_COUNT];			// mean milliseconds
+		F32 mGPU[LLFrameTelemetry::PASS_COUNT];			// mean milliseconds over timed frames, < 0 if none
+		F32 mDrawCalls;									// mean per frame
+		F32 mTriangles;
+	};
+
+	void applyNextEntry();
+	void collectFrames(U32 current_frame);
+	void finishEntry();
+	void finish();
+	bool writeResults(const std::string& csv_file, const std::string& json_file) const;
+
+	EState mState;
+	std::vector<std::string> mEntries;
+	U32 mCurrentEntry;
+	LLTimer mSettleTimer;
+	U32 mFirstFrame;
+	U32 mLastFrame;
+	U32 mNextFrame;		// first telemetry frame not collected yet
+	std::vector<LLFrameTelemetry::Frame> mCollected;
+	std::vector<Result> mResults;
+	bool mTelemetryWasEnabled;
+	BOOL mPilotLoop;
+};
+
+#endif // LL_LLRENDERBENCHMARK_H
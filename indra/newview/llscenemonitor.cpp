@@ -41,6 +41,11 @@
 #include "pipeline.h"
 #include "llviewerparcelmgr.h"
 #include "llviewerpartsim.h"
+#include "llviewerobjectlist.h"
+#include "llviewertexturelist.h"
+#include "lltexturefetch.h"
+#include "llmeshrepository.h"
+#include "llvoavatar.h"
 
 LLSceneMonitorView* gSceneMonitorView = NULL;
 
@@ -64,7 +69,15 @@ LLSceneMonitor::LLSceneMonitor() :
 	mDiffState(WAITING_FOR_NEXT_DIFF),
 	mDebugViewerVisible(false),
 	mQueryObject(0),
-	mDiffPixelRatio(0.5f)
+	mDiffPixelRatio(0.5f),
+	mLoadActive(false),
+	mLoadWasTeleporting(true),
+	mLoadTimeToFirstFrame(-1.f),
+	mLoadTimeTo90Mesh(-1.f),
+	mLoadTimeToStable(-1.f),
+	mLoadIdleSince(-1.f),
+	mLoadPeakMeshes(0),
+	mLoadMeshBytes(0)
 {
 	mFrames[0] = NULL;
 	mFrames[1] = NULL;
@@ -679,6 +692,247 @@ void LLSceneMonitor::dumpToFile(const std::string &file_name)
 	}
 }
 
+bool LLSceneMonitor::LoadSample::isIdle() const
+{
+	if (mOrphans || mAvatars || mTextureHTTP || mMeshHTTP)
+	{
+		return false;
+	}
+	for (S32 lod = 0; lod < 4; ++lod)
+	{
+		if (mMeshes[lod])
+		{
+			return false;
+		}
+	}
+	for (S32 discard = 0; discard < MAX_DISCARD_LEVEL + 2; ++discard)
+	{
+		if (mTextures[discard])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void LLSceneMonitor::startLoadTimeline()
+{
+	mLoadTimeline.clear();
+	mLoadTimer.reset();
+	mLoadActive = true;
+	mLoadTimeToFirstFrame = -1.f;
+	mLoadTimeTo90Mesh = -1.f;
+	mLoadTimeToStable = -1.f;
+	mLoadIdleSince = -1.f;
+	mLoadPeakMeshes = 0;
+	mLoadMeshBytes = LLMeshRepository::sBytesReceived;
+}
+
+void LLSceneMonitor::updateLoadTimeline()
+{
+	static LLCachedControl<bool> timeline_enabled(gSavedSettings, "SceneLoadTimelineEnabled");
+	static LLCachedControl<F32> sample_time(gSavedSettings, "SceneLoadTimelineSampleTime");
+	// everything has to stay quiet this long before the scene counts as stable
+	const F32 STABLE_TIME = 2.f;
+	// give up on a load that never settles
+	const F32 MAX_LOAD_TIME = 600.f;
+
+	if (!timeline_enabled)
+	{
+		mLoadActive = false;
+		return;
+	}
+
+	if (gAgent.getTeleportState() != LLAgent::TELEPORT_NONE)
+	{
+		if (!mLoadWasTeleporting)
+		{
+			// timing starts when the teleport does
+			if (mLoadActive)
+			{
+				finishLoadTimeline();
+			}
+			startLoadTimeline();
+			mLoadWasTeleporting = true;
+		}
+	}
+	else if (mLoadWasTeleporting)
+	{
+		mLoadWasTeleporting = false;
+		if (!mLoadActive)
+		{
+			// login
+			startLoadTimeline();
+		}
+	}
+
+	if (!mLoadActive)
+	{
+		return;
+	}
+
+	F32 elapsed = mLoadTimer.getElapsedTimeF32();
+	if (mLoadTimeToFirstFrame < 0.f && !mLoadWasTeleporting && !gTeleportDisplay)
+	{
+		mLoadTimeToFirstFrame = elapsed;
+	}
+
+	if (!mLoadTimeline.empty() && elapsed - mLoadTimeline.back().mTime < sample_time)
+	{
+		return;
+	}
+
+	LoadSample sample;
+	sample.mTime = elapsed;
+	sampleLoadTimeline(sample);
+	mLoadTimeline.push_back(sample);
+
+	if (mLoadWasTeleporting)
+	{
+		// the old region is still in the counts
+		return;
+	}
+
+	S32 meshes = 0;
+	for (S32 lod = 0; lod < 4; ++lod)
+	{
+		meshes += sample.mMeshes[lod];
+	}
+	if (meshes > mLoadPeakMeshes)
+	{
+		mLoadPeakMeshes = meshes;
+		mLoadTimeTo90Mesh = -1.f;
+	}
+	else if (mLoadTimeTo90Mesh < 0.f && mLoadPeakMeshes > 0 && meshes * 10 <= mLoadPeakMeshes)
+	{
+		mLoadTimeTo90Mesh = elapsed;
+	}
+
+	if (!sample.isIdle())
+	{
+		mLoadIdleSince = -1.f;
+	}
+	else if (mLoadIdleSince < 0.f)
+	{
+		mLoadIdleSince = elapsed;
+	}
+
+	if (mLoadIdleSince >= 0.f && elapsed - mLoadIdleSince >= STABLE_TIME)
+	{
+		mLoadTimeToStable = mLoadIdleSince;
+		finishLoadTimeline();
+	}
+	else if (elapsed > MAX_LOAD_TIME)
+	{
+		finishLoadTimeline();
+	}
+}
+
+void LLSceneMonitor::sampleLoadTimeline(LoadSample& sample)
+{
+	sample.mOrphans = gObjectList.getOrphanCount();
+
+	for (S32 lod = 0; lod < 4; ++lod)
+	{
+		sample.mMeshes[lod] = (S32)gMeshRepo.mLoadingMeshes[lod].size();
+	}
+
+	for (S32 discard = 0; discard < MAX_DISCARD_LEVEL + 2; ++discard)
+	{
+		sample.mTextures[discard] = 0;
+	}
+	for (const LLPointer<LLViewerFetchedTexture>& imagep : gTextureList.mImageList)
+	{
+		if (imagep->hasFetcher())
+		{
+			S32 discard = imagep->getDiscardLevel();
+			sample.mTextures[discard < 0 ? MAX_DISCARD_LEVEL + 1 : llmin(discard, MAX_DISCARD_LEVEL)]++;
+		}
+	}
+
+	sample.mAvatars = 0;
+	for (LLCharacter* character : LLCharacter::sInstances)
+	{
+		LLVOAvatar* avatarp = (LLVOAvatar*)character;
+		if (!avatarp->isDead() && !avatarp->isFullyLoaded())
+		{
+			sample.mAvatars++;
+		}
+	}
+
+	LLTextureFetch* fetcher = LLAppViewer::getTextureFetch();
+	sample.mTextureHTTP = fetcher ? fetcher->getNumHTTPRequests() : 0;
+	sample.mTextureKbps = fetcher ? fetcher->getTextureBandwidth() : 0.f;
+	sample.mMeshHTTP = LLMeshRepoThread::sActiveHeaderRequests + LLMeshRepoThread::sActiveLODRequests;
+	sample.mMeshBytes = LLMeshRepository::sBytesReceived - mLoadMeshBytes;
+	mLoadMeshBytes = LLMeshRepository::sBytesReceived;
+}
+
+void LLSceneMonitor::finishLoadTimeline()
+{
+	mLoadActive = false;
+
+	LL_INFOS("SceneMonitor") << "Scene load:"
+		<< " first frame " << mLoadTimeToFirstFrame
+		<< "s, 90% mesh " << mLoadTimeTo90Mesh
+		<< "s, stable " << mLoadTimeToStable
+		<< "s (-1 if not reached)" << LL_ENDL;
+}
+
+//dump the most recent load timeline to a file, scene_load_timeline.csv
+void LLSceneMonitor::dumpLoadTimeline(const std::string &file_name)
+{
+	if (mLoadTimeline.empty()) return;
+
+	LL_INFOS("SceneMonitor") << "Saving scene load timeline to " << file_name << LL_ENDL;
+	try
+	{
+		llofstream os(file_name.c_str());
+
+		os << std::setprecision(10);
+
+		os << "# time_to_first_frame, " << mLoadTimeToFirstFrame << '\n';
+		os << "# time_to_90_percent_mesh, " << mLoadTimeTo90Mesh << '\n';
+		os << "# time_to_stable, " << mLoadTimeToStable << '\n';
+
+		os << "Time(s), Orphans";
+		for (S32 lod = 0; lod < 4; ++lod)
+		{
+			os << ", Meshes LOD" << lod;
+		}
+		for (S32 discard = 0; discard <= MAX_DISCARD_LEVEL; ++discard)
+		{
+			os << ", Textures discard " << discard;
+		}
+		os << ", Textures no data, Avatars loading, Texture HTTP, Mesh HTTP, Texture(kbps), Mesh(bytes)\n";
+
+		for (const LoadSample& sample : mLoadTimeline)
+		{
+			os << sample.mTime << ", " << sample.mOrphans;
+			for (S32 lod = 0; lod < 4; ++lod)
+			{
+				os << ", " << sample.mMeshes[lod];
+			}
+			for (S32 discard = 0; discard < MAX_DISCARD_LEVEL + 2; ++discard)
+			{
+				os << ", " << sample.mTextures[discard];
+			}
+			os << ", " << sample.mAvatars
+			   << ", " << sample.mTextureHTTP
+			   << ", " << sample.mMeshHTTP
+			   << ", " << sample.mTextureKbps
+			   << ", " << sample.mMeshBytes << '\n';
+		}
+
+		os.flush();
+		os.close();
+	}
+	catch (const std::ios_base::failure &e)
+	{
+		LL_WARNS() << "Unable to dump scene load timeline: " << e.what() << LL_ENDL;
+	}
+}
+
 //-------------------------------------------------------------------------------------------------------------
 //definition of class LLSceneMonitorView
 //-------------------------------------------------------------------------------------------------------------
@@ -32,6 +32,7 @@
 #include "llfloater.h"
 #include "llcharacter.h"
 #include "lltracerecording.h"
+#include "llimage.h"
 
 class LLCharacter;
 class LLRenderTarget;
@@ -66,7 +67,32 @@ public:
 
 	void reset();
 
+	// Scene load timeline: what was still loading, sampled over the time
+	// since login or the last teleport, plus a few headline load times.
+	// Restarts itself on teleport, call once per frame.
+	void updateLoadTimeline();
+	void dumpLoadTimeline(const std::string &file_name);
+
 private:
+	struct LoadSample
+	{
+		F32 mTime;								// seconds since the load started
+		S32 mOrphans;							// objects waiting on their parent
+		S32 mMeshes[4];							// meshes waiting on each LOD
+		S32 mTextures[MAX_DISCARD_LEVEL + 2];	// fetching textures by current discard, last is no data yet
+		S32 mAvatars;							// avatars not fully loaded
+		S32 mTextureHTTP;						// requests in flight per fetcher
+		S32 mMeshHTTP;
+		F32 mTextureKbps;
+		U32 mMeshBytes;							// mesh bytes received since the previous sample
+
+		bool isIdle() const;
+	};
+
+	void startLoadTimeline();
+	void sampleLoadTimeline(LoadSample& sample);
+	void finishLoadTimeline();
+
 	void freezeScene();
 	void unfreezeScene();
 
@@ -105,6 +131,17 @@ private:
 	LLTimer									mRecordingTimer;
 	LLTrace::ExtendablePeriodicRecording	mSceneLoadRecording;
 	LLTrace::Recording						mMonitorRecording;
+
+	std::vector<LoadSample>					mLoadTimeline;
+	LLTimer									mLoadTimer;
+	bool									mLoadActive,
+											mLoadWasTeleporting;
+	F32										mLoadTimeToFirstFrame,
+											mLoadTimeTo90Mesh,
+											mLoadTimeToStable,
+											mLoadIdleSince;	// start of the current quiet stretch, < 0 while busy
+	S32										mLoadPeakMeshes;
+	U32										mLoadMeshBytes;
 };
 
 class LLSceneMonitorView : public LLFloater
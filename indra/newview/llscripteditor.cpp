@@ -43,6 +43,9 @@ LLScriptEditor::Params::Params()
 LLScriptEditor::LLScriptEditor(const Params& p)
 :	LLTextEditor(p)
 ,	mShowLineNumbers(p.show_line_numbers)
+,	mHighlightDirtyStart(S32_MAX)
+,	mHighlightDirtyEnd(0)
+,	mHighlightLength(0)
 {
 	if (mShowLineNumbers)
 	{
@@ -152,27 +155,109 @@ void LLScriptEditor::loadKeywords()
 	{
 		insert_it = mSegments.insert(insert_it, *list_it);
 	}
+	mHighlightDirtyStart = S32_MAX;
+	mHighlightLength = getLength();
 }
 
 void LLScriptEditor::updateSegments()
 {
-	if (mReflowIndex < S32_MAX && mKeywords.isLoaded() && mParseOnTheFly)
+	if (mReflowIndex < S32_MAX && mKeywords.isLoaded() && mParseOnTheFly && mHighlightDirtyStart < S32_MAX)
 	{
         LL_PROFILE_ZONE_SCOPED;
 		// HACK:  No non-ascii keywords for now
+		// Only the lines from the first edit up to where the coloring falls
+		// back in step with the old segments are lexed again.
+		const LLWString& text = getWText();
+		S32 restart = getHighlightRestart(mHighlightDirtyStart);
 		segment_vec_t segment_list;
-		mKeywords.findSegments(&segment_list, getWText(), mDefaultColor.get(), *this);
-		
-		clearSegments();
+		S32 stop = mKeywords.findSegments(&segment_list, text, mDefaultColor.get(), *this,
+										  restart, mHighlightDirtyEnd,
+										  boost::bind(&LLScriptEditor::isRestingLineBreak, this, _1));
+
+		if (restart == 0 && stop > (S32)text.size())
+		{
+			clearSegments();
+		}
 		for (segment_vec_t::iterator list_it = segment_list.begin(); list_it != segment_list.end(); ++list_it)
 		{
 			insertSegment(*list_it);
 		}
+		mHighlightDirtyStart = S32_MAX;
 	}
 	
 	LLTextBase::updateSegments();
 }
 
+void LLScriptEditor::onValueChange(S32 start, S32 end)
+{
+	S32 length = getLength();
+	S32 delta = length - mHighlightLength;
+	mHighlightLength = length;
+
+	if (mHighlightDirtyStart == S32_MAX)
+	{
+		mHighlightDirtyStart = start;
+		mHighlightDirtyEnd = end;
+	}
+	else
+	{
+		if (mHighlightDirtyEnd >= start)
+		{
+			// earlier dirty text moved with this edit
+			mHighlightDirtyEnd = llmax(mHighlightDirtyEnd + delta, start);
+		}
+		mHighlightDirtyStart = llmin(mHighlightDirtyStart, start);
+		mHighlightDirtyEnd = llmax(mHighlightDirtyEnd, end);
+	}
+
+	LLTextEditor::onValueChange(start, end);
+}
+
+S32 LLScriptEditor::getHighlightRestart(S32 pos)
+{
+	const LLWString& text = getWText();
+	S32 line_start = llclamp(pos, 0, (S32)text.size());
+	while (line_start > 0 && text[line_start - 1] != '\n')
+	{
+		--line_start;
+	}
+
+	while (line_start > 0)
+	{
+		segment_set_t::iterator seg_it = getSegIterContaining(line_start - 1);
+		if (seg_it == mSegments.end() || (*seg_it)->getStart() > line_start - 1)
+		{
+			break;
+		}
+		LLKeywordToken* token = (*seg_it)->getToken();
+		if (!token
+			|| (token->getType() != LLKeywordToken::TT_TWO_SIDED_DELIMITER
+				&& token->getType() != LLKeywordToken::TT_DOUBLE_QUOTATION_MARKS))
+		{
+			break;
+		}
+		// the line break belongs to a multi-line string or comment
+		--line_start;
+		while (line_start > 0 && text[line_start - 1] != '\n')
+		{
+			--line_start;
+		}
+	}
+	return line_start;
+}
+
+bool LLScriptEditor::isRestingLineBreak(S32 pos)
+{
+	segment_set_t::iterator seg_it = getSegIterContaining(pos);
+	if (seg_it == mSegments.end())
+	{
+		return false;
+	}
+	LLTextSegmentPtr segment = *seg_it;
+	return segment->getStart() == pos && segment->getEnd() == pos + 1 && !segment->getToken()
+		&& dynamic_cast<LLLineBreakTextSegment*>(segment.get());
+}
+
 void LLScriptEditor::clearSegments()
 {
 	if (!mSegments.empty())
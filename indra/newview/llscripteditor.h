@@ -59,12 +59,24 @@ protected:
 private:
 	void	drawLineNumbers();
 	/* virtual */ void	updateSegments();
+	/* virtual */ void	onValueChange(S32 start, S32 end);
+	// Start of the line holding pos, moved back to where a string or comment
+	// running into that line begins.
+	S32		getHighlightRestart(S32 pos);
+	// True when the existing segments put a line break outside any
+	// delimited run at pos, so coloring can stop there.
+	bool	isRestingLineBreak(S32 pos);
 	/* virtual */ void	drawSelectionBackground();
 	void	loadKeywords(const std::string& filename_keywords,
 						 const std::string& filename_colors);
 	
 	LLKeywords	mKeywords;
 	bool		mShowLineNumbers;
+
+	// Text changed since the segments were last colored, S32_MAX when none.
+	S32			mHighlightDirtyStart;
+	S32			mHighlightDirtyEnd;
+	S32			mHighlightLength;
 };
 
 #endif // LL_SCRIPTEDITOR_H
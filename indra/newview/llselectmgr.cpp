@@ -5623,6 +5623,35 @@ void LLSelectMgr::sendListToRegions(LLObjectSelectionHandle selected_handle,
 	{
 		return;
 	}
+
+	// A new message is started every time the region changes, so bring each
+	// region's nodes together.  The sort is stable, which keeps roots/children
+	// ordering and the link root within a region.
+	{
+		std::vector<LLSelectNode*> nodes;
+		nodes.reserve(nodes_to_send.size());
+		while (!nodes_to_send.empty())
+		{
+			nodes.push_back(nodes_to_send.front());
+			nodes_to_send.pop();
+		}
+		std::unordered_map<LLViewerRegion*, S32> region_rank;
+		for (LLSelectNode* nodep : nodes)
+		{
+			region_rank.emplace(nodep->getObject()->getRegion(), (S32)region_rank.size());
+		}
+		if (region_rank.size() > 1)
+		{
+			std::stable_sort(nodes.begin(), nodes.end(), [&region_rank](LLSelectNode* lhs, LLSelectNode* rhs)
+				{
+					return region_rank[lhs->getObject()->getRegion()] < region_rank[rhs->getObject()->getRegion()];
+				});
+		}
+		for (LLSelectNode* nodep : nodes)
+		{
+			nodes_to_send.push(nodep);
+		}
+	}
 	
 	node = nodes_to_send.front();
 	nodes_to_send.pop();
@@ -7632,6 +7661,7 @@ void LLObjectSelection::cleanupNodes()
 		if (node->getObject() == NULL || node->getObject()->isDead())
 		{
 			mList.erase(curiter);
+			mNodeIterators.erase(node);
 			delete node;
 		}
 	}
@@ -7650,6 +7680,7 @@ void LLObjectSelection::addNode(LLSelectNode *nodep)
 {
 	llassert_always(nodep->getObject() && !nodep->getObject()->isDead());
 	mList.push_front(nodep);
+	mNodeIterators[nodep] = mList.begin();
 	mSelectNodeMap[nodep->getObject()] = nodep;
 }
 
@@ -7657,13 +7688,23 @@ void LLObjectSelection::addNodeAtEnd(LLSelectNode *nodep)
 {
 	llassert_always(nodep->getObject() && !nodep->getObject()->isDead());
 	mList.push_back(nodep);
+	mNodeIterators[nodep] = std::prev(mList.end());
 	mSelectNodeMap[nodep->getObject()] = nodep;
 }
 
 void LLObjectSelection::moveNodeToFront(LLSelectNode *nodep)
 {
-	mList.remove(nodep);
-	mList.push_front(nodep);
+	auto found_it = mNodeIterators.find(nodep);
+	if (found_it != mNodeIterators.end())
+	{
+		// splice keeps the stored iterator valid
+		mList.splice(mList.begin(), mList, found_it->second);
+	}
+	else
+	{
+		mList.push_front(nodep);
+		mNodeIterators[nodep] = mList.begin();
+	}
 }
 
 void LLObjectSelection::removeNode(LLSelectNode *nodep)
@@ -7674,13 +7715,19 @@ void LLObjectSelection::removeNode(LLSelectNode *nodep)
 		mPrimaryObject = NULL;
 	}
 	nodep->setObject(NULL); // Will get erased in cleanupNodes()
-	mList.remove(nodep);
+	auto found_it = mNodeIterators.find(nodep);
+	if (found_it != mNodeIterators.end())
+	{
+		mList.erase(found_it->second);
+		mNodeIterators.erase(found_it);
+	}
 }
 
 void LLObjectSelection::deleteAllNodes()
 {
 	std::for_each(mList.begin(), mList.end(), DeletePointer());
 	mList.clear();
+	mNodeIterators.clear();
 	mSelectNodeMap.clear();
 	mPrimaryObject = NULL;
 }
@@ -8125,43 +8172,32 @@ BOOL LLObjectSelection::contains(LLViewerObject* object)
 //-----------------------------------------------------------------------------
 BOOL LLObjectSelection::contains(LLViewerObject* object, S32 te)
 {
+	LLSelectNode* nodep = findNode(object);
+	if (!nodep || nodep->getObject() != object)
+	{
+		return FALSE;
+	}
+
 	if (te == SELECT_ALL_TES)
 	{
 		// ...all faces
-		for (LLObjectSelection::iterator iter = begin();
-			 iter != end(); iter++)
+		// Optimization
+		if (nodep->getTESelectMask() == TE_SELECT_MASK_ALL)
 		{
-			LLSelectNode* nodep = *iter;
-			if (nodep->getObject() == object)
-			{
-				// Optimization
-				if (nodep->getTESelectMask() == TE_SELECT_MASK_ALL)
-				{
-					return TRUE;
-				}
+			return TRUE;
+		}
 
-				BOOL all_selected = TRUE;
-				for (S32 i = 0; i < object->getNumTEs(); i++)
-				{
-					all_selected = all_selected && nodep->isTESelected(i);
-				}
-				return all_selected;
-			}
+		BOOL all_selected = TRUE;
+		for (S32 i = 0; i < object->getNumTEs(); i++)
+		{
+			all_selected = all_selected && nodep->isTESelected(i);
 		}
-		return FALSE;
+		return all_selected;
 	}
 	else
 	{
 		// ...one face
-		for (LLObjectSelection::iterator iter = begin(); iter != end(); iter++)
-		{
-			LLSelectNode* nodep = *iter;
-			if (nodep->getObject() == object && nodep->isTESelected(te))
-			{
-				return TRUE;
-			}
-		}
-		return FALSE;
+		return nodep->isTESelected(te);
 	}
 }
 
@@ -46,6 +46,7 @@
 #include "llmaterial.h"
 
 #include <deque>
+#include <unordered_map>
 #include <boost/iterator/filter_iterator.hpp>
 #include <boost/signals2.hpp>
 #include <boost/make_shared.hpp>	// boost::make_shared
@@ -403,6 +404,9 @@ private:
 
 private:
 	list_t mList;
+	// where each node sits in mList, so removing or reordering one node
+	// doesn't walk the whole list
+	std::unordered_map<LLSelectNode*, list_t::iterator> mNodeIterators;
 	const LLObjectSelection &operator=(const LLObjectSelection &);
 
 	LLPointer<LLViewerObject> mPrimaryObject;
@@ -33,6 +33,9 @@
 #include "llmeshrepository.h"
 #include "llvolume.h"
 #include "llrigginginfo.h"
+#include "llsys.h"
+
+#include <immintrin.h>
 
 #define DEBUG_SKINNING  LL_DEBUG
 
@@ -269,6 +272,238 @@ void LLSkinningUtil::getPerVertexSkinMatrix(
     (void)valid_weights;
 }
 
+void LLSkinningUtil::initBindShapeMatrixPalette(
+    LLMatrix4a* dst,
+    const LLMatrix4a* mat,
+    U32 count,
+    const LLMatrix4a& bind_shape_matrix)
+{
+    // affineTransform() ignores the last column, so drop it here too
+    // to get the same result as applying the two matrices in turn
+    LLMatrix4a bind_shape = bind_shape_matrix;
+    bind_shape.mMatrix[0].getF32ptr()[3] = 0.f;
+    bind_shape.mMatrix[1].getF32ptr()[3] = 0.f;
+    bind_shape.mMatrix[2].getF32ptr()[3] = 0.f;
+    bind_shape.mMatrix[3].getF32ptr()[3] = 1.f;
+
+    for (U32 j = 0; j < count; ++j)
+    {
+        matMulUnsafe(bind_shape, mat[j], dst[j]);
+    }
+}
+
+namespace
+{
+    // Both kernels decode the weights the same way the skinning shaders do -
+    // the integer part is the joint, the fraction is the weight - but for a
+    // batch of vertices at a time: the 4 weight vectors of a
+    // batch are transposed so each register holds one influence of every
+    // vertex in the batch.
+
+    // Palette indices and normalized weights of 4 vertices
+    LL_FORCE_INLINE void decode_weights_sse2(
+        const LLVector4a* weights,
+        __m128 max_idx,
+        S32 idx[4][4],
+        F32 wght[4][4])
+    {
+        __m128 w[4] = { weights[0], weights[1], weights[2], weights[3] };
+        _MM_TRANSPOSE4_PS(w[0], w[1], w[2], w[3]);
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 scale = zero;
+        for (U32 k = 0; k < 4; ++k)
+        {
+            // floor without SSE4.1: truncate, then step down where that rounded up
+            __m128 f = _mm_cvtepi32_ps(_mm_cvttps_epi32(w[k]));
+            f = _mm_sub_ps(f, _mm_and_ps(_mm_cmpgt_ps(f, w[k]), one));
+            _mm_store_si128((__m128i*)idx[k], _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(f, zero), max_idx)));
+            w[k] = _mm_sub_ps(w[k], f);
+            scale = _mm_add_ps(scale, w[k]);
+        }
+
+        // same fallback as handle_bad_scale, all of it on the first joint
+        __m128 bad = _mm_cmple_ps(scale, zero);
+        scale = _mm_or_ps(_mm_and_ps(bad, one), _mm_andnot_ps(bad, scale));
+        __m128 inv_scale = _mm_div_ps(one, scale);
+        w[0] = _mm_or_ps(_mm_and_ps(bad, one), _mm_andnot_ps(bad, w[0]));
+        w[1] = _mm_andnot_ps(bad, w[1]);
+        w[2] = _mm_andnot_ps(bad, w[2]);
+        w[3] = _mm_andnot_ps(bad, w[3]);
+        for (U32 k = 0; k < 4; ++k)
+        {
+            _mm_store_ps(wght[k], _mm_mul_ps(w[k], inv_scale));
+        }
+    }
+
+    void skin_positions_sse2(
+        const LLMatrix4a* mat,
+        U32 mat_count,
+        const LLVector4a* weights,
+        const LLVector4a* positions,
+        U32 count,
+        LLVector4a* dst)
+    {
+        const __m128 max_idx = _mm_set1_ps((F32)(mat_count - 1));
+        LL_ALIGN_16(S32 idx[4][4]);
+        LL_ALIGN_16(F32 wght[4][4]);
+
+        for (U32 j = 0; j < count; j += 4)
+        {
+            U32 batch = llmin(count - j, 4U);
+            LLVector4a w[4];
+            for (U32 v = 0; v < 4; ++v)
+            {
+                // pad a short last batch with a copy of its first vertex
+                w[v] = weights[j + (v < batch ? v : 0)];
+            }
+            decode_weights_sse2(w, max_idx, idx, wght);
+
+            for (U32 v = 0; v < batch; ++v)
+            {
+                LLMatrix4a final_mat;
+                final_mat.clear();
+                for (U32 k = 0; k < 4; ++k)
+                {
+                    LLMatrix4a src;
+                    src.setMul(mat[idx[k][v]], wght[k][v]);
+                    final_mat.add(src);
+                }
+                final_mat.affineTransform(positions[j + v], dst[j + v]);
+            }
+        }
+    }
+
+#if LL_MSVC
+#define LL_TARGET_AVX2
+#else
+#define LL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+    // Same as skin_positions_sse2() but for 8 vertices at a time, and each
+    // palette matrix is blended as two pairs of rows
+    LL_TARGET_AVX2 void skin_positions_avx2(
+        const LLMatrix4a* mat,
+        U32 mat_count,
+        const LLVector4a* weights,
+        const LLVector4a* positions,
+        U32 count,
+        LLVector4a* dst)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256 max_idx = _mm256_set1_ps((F32)(mat_count - 1));
+        alignas(32) S32 idx[4][8];
+        alignas(32) F32 wght[4][8];
+
+        for (U32 j = 0; j < count; j += 8)
+        {
+            U32 batch = llmin(count - j, 8U);
+            __m128 lo[4];
+            __m128 hi[4];
+            for (U32 v = 0; v < 4; ++v)
+            {
+                lo[v] = weights[j + (v < batch ? v : 0)];
+                hi[v] = weights[j + (v + 4 < batch ? v + 4 : 0)];
+            }
+            _MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+            _MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+
+            __m256 w[4];
+            __m256 scale = zero;
+            for (U32 k = 0; k < 4; ++k)
+            {
+                w[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[k]), hi[k], 1);
+                __m256 f = _mm256_floor_ps(w[k]);
+                _mm256_store_si256((__m256i*)idx[k], _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(f, zero), max_idx)));
+                w[k] = _mm256_sub_ps(w[k], f);
+                scale = _mm256_add_ps(scale, w[k]);
+            }
+
+            __m256 bad = _mm256_cmp_ps(scale, zero, _CMP_LE_OQ);
+            __m256 inv_scale = _mm256_div_ps(one, _mm256_blendv_ps(scale, one, bad));
+            w[0] = _mm256_blendv_ps(w[0], one, bad);
+            w[1] = _mm256_andnot_ps(bad, w[1]);
+            w[2] = _mm256_andnot_ps(bad, w[2]);
+            w[3] = _mm256_andnot_ps(bad, w[3]);
+            for (U32 k = 0; k < 4; ++k)
+            {
+                _mm256_store_ps(wght[k], _mm256_mul_ps(w[k], inv_scale));
+            }
+
+            for (U32 v = 0; v < batch; ++v)
+            {
+                // rows 0 and 1, rows 2 and 3
+                __m256 m01 = zero;
+                __m256 m23 = zero;
+                for (U32 k = 0; k < 4; ++k)
+                {
+                    const F32* m = mat[idx[k][v]].mMatrix[0].getF32ptr();
+                    __m256 s = _mm256_set1_ps(wght[k][v]);
+                    m01 = _mm256_add_ps(m01, _mm256_mul_ps(_mm256_loadu_ps(m), s));
+                    m23 = _mm256_add_ps(m23, _mm256_mul_ps(_mm256_loadu_ps(m + 8), s));
+                }
+
+                // x * row0 + y * row1 + z * row2 + row3
+                __m128 p = positions[j + v];
+                __m256 xy = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))),
+                                                 _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)), 1);
+                __m256 z1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))),
+                                                 _mm_set1_ps(1.f), 1);
+                __m256 sum = _mm256_add_ps(_mm256_mul_ps(xy, m01), _mm256_mul_ps(z1, m23));
+                dst[j + v] = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+            }
+        }
+    }
+}
+
+void LLSkinningUtil::skinPositions(
+    const LLMatrix4a* mat,
+    U32 mat_count,
+    const LLVector4a* weights,
+    const LLVector4a* positions,
+    U32 count,
+    LLVector4a* dst,
+    LLVector4a& min,
+    LLVector4a& max)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    static const bool use_avx2 = gSysCPU.hasAVX2();
+
+    llassert(mat_count > 0);
+    if (count == 0)
+    {
+        return;
+    }
+
+    // in chunks so the bounding box is taken while the results are still in cache
+    const U32 CHUNK_SIZE = 256;
+    for (U32 j = 0; j < count; j += CHUNK_SIZE)
+    {
+        U32 chunk = llmin(count - j, CHUNK_SIZE);
+        if (use_avx2)
+        {
+            skin_positions_avx2(mat, mat_count, weights + j, positions + j, chunk, dst + j);
+        }
+        else
+        {
+            skin_positions_sse2(mat, mat_count, weights + j, positions + j, chunk, dst + j);
+        }
+
+        if (j == 0)
+        {
+            min = max = dst[0];
+        }
+        for (U32 v = j; v < j + chunk; ++v)
+        {
+            min.setMin(min, dst[v]);
+            max.setMax(max, dst[v]);
+        }
+    }
+}
+
 void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
 {
     if (!skin->mJointNumsInitialized)
@@ -47,10 +47,22 @@ namespace LLSkinningUtil
     void scrubSkinWeights(LLVector4a* weights, U32 num_vertices, const LLMeshSkinInfo* skin);
     void getPerVertexSkinMatrix(F32* weights, const LLMatrix4a* mat, bool handle_bad_scale, LLMatrix4a& final_mat, U32 max_joints);
 
+    // Fold the bind shape matrix into each matrix of a skinning palette,
+    // so skinPositions() only has one transform to do per vertex
+    void initBindShapeMatrixPalette(LLMatrix4a* dst, const LLMatrix4a* mat, U32 count, const LLMatrix4a& bind_shape_matrix);
+
+    // Skin count positions into dst with a palette from initBindShapeMatrixPalette()
+    // and set min and max to the bounding box of the result. Same math as
+    // the skinning shaders (all four weights are normalized, unlike
+    // getPerVertexSkinMatrix()) for a batch of vertices at a time, with
+    // AVX2 when the CPU has it and SSE2 otherwise.
+    void skinPositions(const LLMatrix4a* mat, U32 mat_count, const LLVector4a* weights, const LLVector4a* positions,
+                       U32 count, LLVector4a* dst, LLVector4a& min, LLVector4a& max);
+
     LL_FORCE_INLINE void getPerVertexSkinMatrixWithIndices(
         F32*        weights,
         U8*         idx,
-        LLMatrix4a* mat,
+        const LLMatrix4a* mat,
         LLMatrix4a& final_mat,
         LLMatrix4a* src)
     {    
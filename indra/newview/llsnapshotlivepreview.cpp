@@ -31,6 +31,7 @@
 #include "llagentbenefits.h"
 #include "llagentcamera.h"
 #include "llagentui.h"
+#include "llcoros.h"
 #include "llfilesystem.h"
 #include "llcombobox.h"
 #include "llfloaterperms.h"
@@ -1010,35 +1011,40 @@ void LLSnapshotLivePreview::saveTexture(BOOL outfit_snapshot, std::string name)
 	scaled->biasedScaleToPowerOfTwo(MAX_TEXTURE_SIZE);
 	LL_DEBUGS("Snapshot") << "scaled texture to " << scaled->getWidth() << "x" << scaled->getHeight() << LL_ENDL;
 
-	if (formatted->encode(scaled, 0.0f))
+	// Encode on the thread pool from a coroutine so a large snapshot doesn't stall the viewer
+	LLCoros::instance().launch("LLSnapshotLivePreview::saveTexture",
+		[formatted, scaled, tid, new_asset_id, outfit_snapshot, name]()
 	{
-        LLFileSystem fmt_file(new_asset_id, LLAssetType::AT_TEXTURE, LLFileSystem::WRITE);
-        fmt_file.write(formatted->getData(), formatted->getDataSize());
-		std::string pos_string;
-		LLAgentUI::buildLocationString(pos_string, LLAgentUI::LOCATION_FORMAT_FULL);
-		std::string who_took_it;
-		LLAgentUI::buildFullname(who_took_it);
-		S32 expected_upload_cost = LLAgentBenefitsMgr::current().getTextureUploadCost();
-        std::string res_name = outfit_snapshot ? name : "Snapshot : " + pos_string;
-        std::string res_desc = outfit_snapshot ? "" : "Taken by " + who_took_it + " at " + pos_string;
-        LLFolderType::EType folder_type = outfit_snapshot ? LLFolderType::FT_NONE : LLFolderType::FT_SNAPSHOT_CATEGORY;
-        LLInventoryType::EType inv_type = outfit_snapshot ? LLInventoryType::IT_NONE : LLInventoryType::IT_SNAPSHOT;
-
-        LLResourceUploadInfo::ptr_t assetUploadInfo(new LLResourceUploadInfo(
-            tid, LLAssetType::AT_TEXTURE, res_name, res_desc, 0,
-            folder_type, inv_type,
-            PERM_ALL, LLFloaterPerms::getGroupPerms("Uploads"), LLFloaterPerms::getEveryonePerms("Uploads"),
-            expected_upload_cost, !outfit_snapshot));
-
-        upload_new_resource(assetUploadInfo);
-
-		gViewerWindow->playSnapshotAnimAndSound();
-	}
-	else
-	{
-		LLNotificationsUtil::add("ErrorEncodingSnapshot");
-		LL_WARNS("Snapshot") << "Error encoding snapshot" << LL_ENDL;
-	}
+		if (LLViewerTextureList::encodeForUpload(formatted, scaled))
+		{
+            LLFileSystem fmt_file(new_asset_id, LLAssetType::AT_TEXTURE, LLFileSystem::WRITE);
+            fmt_file.write(formatted->getData(), formatted->getDataSize());
+			std::string pos_string;
+			LLAgentUI::buildLocationString(pos_string, LLAgentUI::LOCATION_FORMAT_FULL);
+			std::string who_took_it;
+			LLAgentUI::buildFullname(who_took_it);
+			S32 expected_upload_cost = LLAgentBenefitsMgr::current().getTextureUploadCost();
+            std::string res_name = outfit_snapshot ? name : "Snapshot : " + pos_string;
+            std::string res_desc = outfit_snapshot ? "" : "Taken by " + who_took_it + " at " + pos_string;
+            LLFolderType::EType folder_type = outfit_snapshot ? LLFolderType::FT_NONE : LLFolderType::FT_SNAPSHOT_CATEGORY;
+            LLInventoryType::EType inv_type = outfit_snapshot ? LLInventoryType::IT_NONE : LLInventoryType::IT_SNAPSHOT;
+
+            LLResourceUploadInfo::ptr_t assetUploadInfo(new LLResourceUploadInfo(
+                tid, LLAssetType::AT_TEXTURE, res_name, res_desc, 0,
+                folder_type, inv_type,
+                PERM_ALL, LLFloaterPerms::getGroupPerms("Uploads"), LLFloaterPerms::getEveryonePerms("Uploads"),
+                expected_upload_cost, !outfit_snapshot));
+
+            upload_new_resource(assetUploadInfo);
+
+			gViewerWindow->playSnapshotAnimAndSound();
+		}
+		else
+		{
+			LLNotificationsUtil::add("ErrorEncodingSnapshot");
+			LL_WARNS("Snapshot") << "Error encoding snapshot" << LL_ENDL;
+		}
+	});
 
 	add(LLStatViewer::SNAPSHOT, 1);
 
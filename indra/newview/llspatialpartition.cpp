@@ -320,6 +320,12 @@ void LLSpatialGroup::rebuildGeom()
 {
 	if (!isDead())
 	{
+		if (hasState(LLSpatialGroup::GEOM_DIRTY))
+		{
+			gPipeline.markShadowCacheDirty(this);
+			gPipeline.mReflectionMapManager.markDirty(this);
+		}
+
 		getSpatialPartition()->rebuildGeom(this);
 
 		if (hasState(LLSpatialGroup::MESH_DIRTY))
@@ -333,6 +339,7 @@ void LLSpatialGroup::rebuildMesh()
 {
 	if (!isDead())
 	{
+		gPipeline.markShadowCacheDirty(this);
 		getSpatialPartition()->rebuildMesh(this);
 	}
 }
@@ -793,6 +800,8 @@ void LLSpatialGroup::handleDestruction(const TreeNode* node)
 	{
 		return;
 	}
+	gPipeline.markShadowCacheDirty(this);
+	gPipeline.mReflectionMapManager.markDirty(this);
 	setState(DEAD);	
 
 	for (element_iter i = getDataBegin(); i != getDataEnd(); ++i)
@@ -1039,7 +1048,7 @@ void LLSpatialPartition::shift(const LLVector4a &offset)
 class LLOctreeCull : public LLViewerOctreeCull
 {
 public:
-	LLOctreeCull(LLCamera* camera) : LLViewerOctreeCull(camera) {}
+	LLOctreeCull(LLCamera* camera, LLCullResult* result = NULL) : LLViewerOctreeCull(camera), mCullResult(result) {}
 
 	virtual bool earlyFail(LLViewerOctreeGroup* base_group)
 	{
@@ -1055,7 +1064,7 @@ public:
 		  	LLPipeline::sUseOcclusion &&			//ignore occlusion if disabled
 			group->isOcclusionState(LLSpatialGroup::OCCLUDED))
 		{
-			gPipeline.markOccluder(group);
+			gPipeline.markOccluder(group, mCullResult);
 			return true;
 		}
 		
@@ -1090,15 +1099,18 @@ public:
 		{
 			group->doOcclusion(mCamera);
 		}*/
-		gPipeline.markNotCulled(group, *mCamera);
+		gPipeline.markNotCulled(group, *mCamera, mCullResult);
 	}
+
+protected:
+	LLCullResult* mCullResult; // NULL means the pipeline's current LLCullResult
 };
 
 class LLOctreeCullNoFarClip : public LLOctreeCull
 {
 public: 
-	LLOctreeCullNoFarClip(LLCamera* camera) 
-		: LLOctreeCull(camera) { }
+	LLOctreeCullNoFarClip(LLCamera* camera, LLCullResult* result = NULL) 
+		: LLOctreeCull(camera, result) { }
 
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
 	{
@@ -1115,8 +1127,8 @@ public:
 class LLOctreeCullShadow : public LLOctreeCull
 {
 public:
-	LLOctreeCullShadow(LLCamera* camera)
-		: LLOctreeCull(camera) { }
+	LLOctreeCullShadow(LLCamera* camera, LLCullResult* result = NULL)
+		: LLOctreeCull(camera, result) { }
 
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
 	{
@@ -1441,6 +1453,12 @@ extern BOOL gCubeSnapshot;
 S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+	prepareCull();
+	return traverseCull(camera, NULL);
+}
+
+void LLSpatialPartition::prepareCull()
+{
 #if LL_OCTREE_PARANOIA_CHECK
 	((LLSpatialGroup*)mOctree->getListener(0))->checkStates();
 #endif
@@ -1450,20 +1468,24 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 #if LL_OCTREE_PARANOIA_CHECK
 	((LLSpatialGroup*)mOctree->getListener(0))->validate();
 #endif
+}
 
+S32 LLSpatialPartition::traverseCull(LLCamera& camera, LLCullResult* result)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
     if (LLPipeline::sShadowRender)
     {
-        LLOctreeCullShadow culler(&camera);
+        LLOctreeCullShadow culler(&camera, result);
         culler.traverse(mOctree);
     }
     else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
     {
-        LLOctreeCullNoFarClip culler(&camera);
+        LLOctreeCullNoFarClip culler(&camera, result);
         culler.traverse(mOctree);
     }
     else
     {
-        LLOctreeCull culler(&camera);
+        LLOctreeCull culler(&camera, result);
         culler.traverse(mOctree);
     }
 	
@@ -4116,6 +4138,34 @@ void LLCullResult::pushDrawInfo(U32 type, LLDrawInfo* draw_info)
 	mRenderMapEnd[type] = &(mRenderMap[type][mRenderMapSize[type]]);
 }
 
+void LLCullResult::append(LLCullResult& result)
+{
+	for (sg_iterator i = result.beginVisibleGroups(); i != result.endVisibleGroups(); ++i)
+	{
+		pushVisibleGroup(*i);
+	}
+
+	for (sg_iterator i = result.beginDrawableGroups(); i != result.endDrawableGroups(); ++i)
+	{
+		pushDrawableGroup(*i);
+	}
+
+	for (sg_iterator i = result.beginOcclusionGroups(); i != result.endOcclusionGroups(); ++i)
+	{
+		pushOcclusionGroup(*i);
+	}
+
+	for (drawable_iterator i = result.beginVisibleList(); i != result.endVisibleList(); ++i)
+	{
+		pushDrawable(*i);
+	}
+
+	for (bridge_iterator i = result.beginVisibleBridge(); i != result.endVisibleBridge(); ++i)
+	{
+		pushBridge(*i);
+	}
+}
+
 
 void LLCullResult::assertDrawMapsEmpty()
 {
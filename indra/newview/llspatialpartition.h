@@ -30,6 +30,7 @@
 #define SG_MIN_DIST_RATIO 0.00001f
 
 #include "lldrawable.h"
+#include "llframearena.h"
 #include "lloctree.h"
 #include "llpointer.h"
 #include "llrefcount.h"
@@ -55,6 +56,7 @@ class LLSpatialBridge;
 class LLSpatialGroup;
 class LLViewerRegion;
 class LLReflectionMap;
+class LLCullResult;
 
 void pushVerts(LLFace* face);
 
@@ -113,6 +115,10 @@ public:
     LLPointer<LLVOAvatar> mAvatar = nullptr;
     LLMeshSkinInfo* mSkinInfo = nullptr;
 
+    // for rigged animesh batches, hash of the faces' vertex data; batches of
+    // different animesh with the same hash draw identical geometry (0 = unknown)
+    U64 mGeometryHash = 0;
+
     // Material pointer here is likely for debugging only and are immaterial (zing!)
     LLPointer<LLMaterial> mMaterial;
 
@@ -416,6 +422,8 @@ public:
 
 	BOOL visibleObjectsInFrustum(LLCamera& camera);
 	/*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
+	void prepareCull(); // rebound the root group, must be called on the main thread before traverseCull
+	S32 traverseCull(LLCamera& camera, LLCullResult* result); // cull into result instead of the pipeline's current LLCullResult, safe to call off the main thread when sUseOcclusion < 2
 	S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results, BOOL for_select); // Cull on arbitrary frustum
 	
 	BOOL isVisible(const LLVector3& v);
@@ -543,6 +551,9 @@ public:
 	void pushDrawable(LLDrawable* drawable);
 	void pushBridge(LLSpatialBridge* bridge);
 	void pushDrawInfo(U32 type, LLDrawInfo* draw_info);
+
+	// append the groups, drawables and bridges of another cull result (as produced by a parallel cull) to this one
+	void append(LLCullResult& result);
 	
 	U32 getVisibleGroupsSize()		{ return mVisibleGroupsSize; }
 	U32	getAlphaGroupsSize()		{ return mAlphaGroupsSize; }
@@ -550,6 +561,7 @@ public:
 	U32	getDrawableGroupsSize()		{ return mDrawableGroupsSize; }
 	U32	getVisibleListSize()		{ return mVisibleListSize; }
 	U32	getVisibleBridgeSize()		{ return mVisibleBridgeSize; }
+	U32	getOcclusionGroupsSize()	{ return mOcclusionGroupsSize; }
 	U32	getRenderMapSize(U32 type)	{ return mRenderMapSize[type]; }
 
 	void assertDrawMapsEmpty();
@@ -682,6 +694,19 @@ class LLVolumeGeometryManager: public LLGeometryManager
 	void registerFace(LLSpatialGroup* group, LLFace* facep, U32 type);
 
 private:
+	// faces [mBegin, mEnd) packed into mBuffer by genDrawInfo
+	struct GeomBatch
+	{
+		LLPointer<LLVertexBuffer> mBuffer;
+		LLFace** mBegin;
+		LLFace** mEnd;
+		bool mBakeSunlight;
+	};
+
+	// copy face geometry into the (already allocated) vertex buffers of batches, spreading
+	// the work over the pipeline thread pool when RenderParallelGeometryRebuild is set
+	void fillGeometry(const LLFrameVector<GeomBatch>& batches);
+
 	void allocateFaces(U32 pMaxFaceCount);
 	void freeFaces();
 
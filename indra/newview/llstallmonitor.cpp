@@ -0,0 +1,153 @@
+/**
+ * @file llstallmonitor.cpp
+ * @brief Per-frame timings of the main loop phases, with a breakdown
+ *        logged whenever a frame stalls.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llstallmonitor.h"
+
+#include "llframetimer.h"
+#include "llviewercontrol.h"
+
+// stalls kept for the Performance floater
+static const size_t MAX_STALLS = 100;
+static const U32 MAX_PRECEDING_FRAMES = 120;
+
+U64 LLStallMonitor::sPhaseTimes[LLStallMonitor::PHASE_COUNT] = { 0 };
+
+LLStallMonitor::LLStallMonitor()
+:	mFrames(MAX_PRECEDING_FRAMES + 1)
+{
+}
+
+void LLStallMonitor::endFrame(F32 frame_time, bool can_stall, const std::string& trace_file)
+{
+	static LLCachedControl<F32> threshold(gSavedSettings, "StallMonitorThreshold", 0.25f);
+	static LLCachedControl<U32> preceding(gSavedSettings, "StallMonitorFrames", 10);
+
+	Frame frame;
+	frame.mNumber = LLFrameTimer::getFrameCount();
+	frame.mTotal = frame_time;
+	for (S32 i = 0; i < PHASE_COUNT; ++i)
+	{
+		frame.mPhases[i] = (F32)sPhaseTimes[i] / 1000000.f;
+		sPhaseTimes[i] = 0;
+	}
+	mFrames.push_back(frame);
+
+	if (!can_stall || threshold <= 0.f || frame_time <= threshold)
+	{
+		return;
+	}
+
+	if (mStalls.size() >= MAX_STALLS)
+	{
+		mStalls.pop_front();
+	}
+	mStalls.push_back(Stall());
+	Stall& stall = mStalls.back();
+	stall.mTime = LLDate::now();
+	stall.mTraceFile = trace_file;
+	size_t count = llmin((size_t)llmin((U32)preceding, MAX_PRECEDING_FRAMES) + 1, mFrames.size());
+	stall.mFrames.assign(mFrames.end() - count, mFrames.end());
+
+	LL_WARNS() << describe(stall) << LL_ENDL;
+}
+
+//static
+const char* LLStallMonitor::getPhaseName(EPhase phase)
+{
+	switch (phase)
+	{
+	case PHASE_IDLE:		return "idle";
+	case PHASE_NETWORK:		return "network";
+	case PHASE_DISPLAY:		return "display";
+	case PHASE_GEOMETRY:	return "geometry";
+	case PHASE_CULL:		return "cull";
+	case PHASE_TEXTURES:	return "textures";
+	default:				return "unknown";
+	}
+}
+
+//static
+std::string LLStallMonitor::getSlowestPhase(const Frame& frame)
+{
+	const F32* phases = frame.mPhases;
+	F32 display_children = phases[PHASE_GEOMETRY] + phases[PHASE_CULL] + phases[PHASE_TEXTURES];
+
+	F32 own[PHASE_COUNT];
+	for (S32 i = 0; i < PHASE_COUNT; ++i)
+	{
+		own[i] = phases[i];
+	}
+	own[PHASE_IDLE] -= phases[PHASE_NETWORK];
+	own[PHASE_DISPLAY] -= display_children;
+
+	std::string slowest("other");
+	F32 slowest_time = frame.mTotal - phases[PHASE_IDLE] - phases[PHASE_DISPLAY];
+	for (S32 i = 0; i < PHASE_COUNT; ++i)
+	{
+		if (own[i] > slowest_time)
+		{
+			slowest = getPhaseName((EPhase)i);
+			slowest_time = own[i];
+		}
+	}
+	return slowest;
+}
+
+//static
+std::string LLStallMonitor::describe(const Frame& frame)
+{
+	const F32* phases = frame.mPhases;
+	F32 other = llmax(frame.mTotal - phases[PHASE_IDLE] - phases[PHASE_DISPLAY], 0.f);
+	return llformat("frame %u: %.1f ms (idle %.1f [network %.1f], display %.1f [geometry %.1f, cull %.1f, textures %.1f], other %.1f)",
+					frame.mNumber, frame.mTotal * 1000.f,
+					phases[PHASE_IDLE] * 1000.f, phases[PHASE_NETWORK] * 1000.f,
+					phases[PHASE_DISPLAY] * 1000.f, phases[PHASE_GEOMETRY] * 1000.f,
+					phases[PHASE_CULL] * 1000.f, phases[PHASE_TEXTURES] * 1000.f,
+					other * 1000.f);
+}
+
+//static
+std::string LLStallMonitor::describe(const Stall& stall)
+{
+	std::ostringstream out;
+	out << "Stall in " << describe(stall.getFrame()) << ", slowest in "
+		<< getSlowestPhase(stall.getFrame());
+	if (!stall.mTraceFile.empty())
+	{
+		out << "\nHitch trace: " << stall.mTraceFile;
+	}
+	if (stall.mFrames.size() > 1)
+	{
+		out << "\nPreceding frames:";
+		for (size_t i = 0; i + 1 < stall.mFrames.size(); ++i)
+		{
+			out << "\n  " << describe(stall.mFrames[i]);
+		}
+	}
+	return out.str();
+}
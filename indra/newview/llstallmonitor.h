@@ -0,0 +1,114 @@
+/**
+ * @file llstallmonitor.h
+ * @brief Per-frame timings of the main loop phases, with a breakdown
+ *        logged whenever a frame stalls.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSTALLMONITOR_H
+#define LL_LLSTALLMONITOR_H
+
+#include "lldate.h"
+#include "llsingleton.h"
+#include "lltimer.h"
+
+#include <boost/circular_buffer.hpp>
+#include <deque>
+
+// Keeps how long each major phase of the last few frames took. When a frame
+// goes over StallMonitorThreshold the breakdown of that frame and the ones
+// before it is logged and kept for the Performance floater.
+// Main thread only.
+class LLStallMonitor : public LLSimpleton<LLStallMonitor>
+{
+	LOG_CLASS(LLStallMonitor);
+public:
+	// idle() contains idleNetwork(), display() contains the rest
+	enum EPhase
+	{
+		PHASE_IDLE,
+		PHASE_NETWORK,
+		PHASE_DISPLAY,
+		PHASE_GEOMETRY,
+		PHASE_CULL,
+		PHASE_TEXTURES,
+		PHASE_COUNT
+	};
+
+	struct Frame
+	{
+		U32 mNumber;
+		F32 mTotal;					// seconds
+		F32 mPhases[PHASE_COUNT];	// seconds
+	};
+
+	struct Stall
+	{
+		LLDate mTime;
+		std::vector<Frame> mFrames;	// oldest first, the stalled frame last
+		std::string mTraceFile;		// hitch trace saved for it, if any
+
+		const Frame& getFrame() const { return mFrames.back(); }
+	};
+
+	// times the enclosing scope into the current frame
+	class Phase
+	{
+	public:
+		Phase(EPhase phase)
+		:	mPhase(phase),
+			mStart(totalTime().value())
+		{}
+		~Phase() { sPhaseTimes[mPhase] += totalTime().value() - mStart; }
+
+	private:
+		EPhase mPhase;
+		U64 mStart;
+	};
+
+	LLStallMonitor();
+
+	// Closes the current frame. can_stall is false while slow frames are
+	// expected (login, teleport), trace_file is the hitch trace saved for
+	// this frame, if any.
+	void endFrame(F32 frame_time, bool can_stall, const std::string& trace_file);
+
+	// oldest first
+	const std::deque<Stall>& getStalls() const { return mStalls; }
+	// the frame endFrame() just closed
+	const Frame& getLastFrame() const { return mFrames.back(); }
+
+	static const char* getPhaseName(EPhase phase);
+	// the phase that took longest, not counting the phases inside it
+	static std::string getSlowestPhase(const Frame& frame);
+	static std::string describe(const Frame& frame);
+	static std::string describe(const Stall& stall);
+
+private:
+	static U64 sPhaseTimes[PHASE_COUNT];	// microseconds, this frame so far
+
+	boost::circular_buffer<Frame> mFrames;
+	std::deque<Stall> mStalls;
+};
+
+#endif // LL_LLSTALLMONITOR_H
@@ -38,6 +38,7 @@
 #include <memory>                   // std::unique_ptr
 
 #include "llviewermedia_streamingaudio.h"
+#include "llaudiodecodemgr.h"
 #include "llaudioengine.h"
 
 #ifdef LL_FMODSTUDIO
@@ -83,6 +84,7 @@
 #include "lluserrelations.h"
 #include "llversioninfo.h"
 #include "llviewercontrol.h"
+#include "llviewerfloaterreg.h"
 #include "llviewerhelp.h"
 #include "llxorcipher.h"	// saved password, MAC address
 #include "llwindow.h"
@@ -95,6 +97,8 @@
 #include "llagentpicksinfo.h"
 #include "llagentwearables.h"
 #include "llagentpilot.h"
+#include "llrenderbenchmark.h"
+#include "lldeferredinit.h"
 #include "llfloateravatarpicker.h"
 #include "llcallbacklist.h"
 #include "llcallingcard.h"
@@ -145,6 +149,7 @@
 #include "lltoolmgr.h"
 #include "lltrans.h"
 #include "llui.h"
+#include "lluictrlfactory.h"
 #include "lluiusage.h"
 #include "llurldispatcher.h"
 #include "llurlentry.h"
@@ -199,6 +204,7 @@
 #include "lllogin.h"
 #include "llevents.h"
 #include "llstartuplistener.h"
+#include "llstartupprofiler.h"
 #include "lltoolbarview.h"
 #include "llexperiencelog.h"
 #include "llcleanup.h"
@@ -255,6 +261,7 @@ static LLVector3 gAgentStartLookAt(1.0f, 0.f, 0.f);
 static std::string gAgentStartLocation = "safe";
 static bool mLoginStatePastUI = false;
 static bool mBenefitsSuccessfullyInit = false;
+static bool sInventorySkeletonLoaded = false;
 
 const F32 STATE_AGENT_WAIT_TIMEOUT = 240; //seconds
 const S32 MAX_SEED_CAP_ATTEMPTS_BEFORE_ABORT = 4; // Give region 4 chances
@@ -287,6 +294,7 @@ void apply_udp_blacklist(const std::string& csv);
 bool process_login_success_response();
 void on_benefits_failed_callback(const LLSD& notification, const LLSD& response);
 void transition_back_to_login_panel(const std::string& emsg);
+void load_inventory_skeleton();
 
 void callback_cache_name(const LLUUID& id, const std::string& full_name, bool is_group)
 {
@@ -403,6 +411,7 @@ bool idle_startup()
 			// Other phases get handled when startup state changes,
 			// need to capture the initial state as well.
 			LLStartUp::getPhases().startPhase(LLStartUp::getStartupStateString());
+			LLStartupProfiler::begin(LLStartUp::getStartupStateString());
 			first_call = false;
 		}
 
@@ -635,6 +644,23 @@ bool idle_startup()
 				msg->mPacketRing.setUseOutThrottle(TRUE);
 				msg->mPacketRing.setOutBandwidth(outBandwidth);
 			}
+
+			if (gSavedSettings.getBOOL("MessageReceiveThread"))
+			{
+				LL_INFOS("AppInit") << "Receiving UDP messages on a separate thread" << LL_ENDL;
+				msg->mPacketRing.startReceiveThread(msg->mSocket);
+			}
+
+			std::string replay_file = gSavedSettings.getString("PacketReplayFile");
+			std::string capture_file = gSavedSettings.getString("PacketCaptureFile");
+			if (!replay_file.empty())
+			{
+				msg->mPacketRing.startReplay(replay_file);
+			}
+			else if (!capture_file.empty())
+			{
+				msg->mPacketRing.startCapture(capture_file);
+			}
 		}
 
 		LL_INFOS("AppInit") << "Message System Initialized." << LL_ENDL;
@@ -692,6 +718,9 @@ bool idle_startup()
 						gAudiop->setStreamingAudioImpl(new LLStreamingAudio_MediaPlugins());
 					}
 
+					LLAudioDecodeMgr::getInstance()->setMemoryCacheSize(gSavedSettings.getU32("AudioDecodeMemoryCacheMB") * 1024 * 1024);
+					gAudiop->setSourceCullDistance(gSavedSettings.getF32("AudioSourceCullDistance"));
+
 					gAudiop->setMuted(TRUE);
 				}
 				else
@@ -762,6 +791,7 @@ bool idle_startup()
 		set_startup_status(0.03f, msg.c_str(), gAgent.mMOTD.c_str());
 		display_startup();
 		// LLViewerMedia::initBrowser();
+		LLUICtrlFactory::waitForPreloads();
 		LLStartUp::setStartupState( STATE_LOGIN_SHOW );
 		return FALSE;
 	}
@@ -1257,6 +1287,7 @@ bool idle_startup()
 				LLVoiceClient::getInstance()->userAuthorized(gUserCredential->userID(), gAgentID);
 				// create the default proximal channel
 				LLVoiceChannel::initClass();
+				LLStartUp::getPhases().startPhase("login to world");
 				LLStartUp::setStartupState( STATE_WORLD_INIT);
 				LLTrace::get_frame_recording().reset();
 			}
@@ -1649,6 +1680,13 @@ bool idle_startup()
 	{
 		LL_DEBUGS("AppInit") << "Waiting for simulator ack...." << LL_ENDL;
 		set_startup_status(0.59f, LLTrans::getString("LoginWaitingForRegionHandshake"), gAgent.mMOTD);
+		// The skeleton only needs the login response and the local
+		// inventory cache, load it while the region handshakes.
+		static LLCachedControl<bool> load_early(gSavedSettings, "StartupLoadInventoryEarly", false);
+		if (load_early && !sInventorySkeletonLoaded)
+		{
+			load_inventory_skeleton();
+		}
 		if(gGotUseCircuitCodeAck)
 		{
 			LLStartUp::setStartupState( STATE_AGENT_SEND );
@@ -1769,33 +1807,6 @@ bool idle_startup()
 		// Inform simulator of our language preference
 		LLAgentLanguage::update();
 
-		display_startup();
-		// unpack thin inventory
-		LLSD response = LLLoginInstance::getInstance()->getResponse();
-		//bool dump_buffer = false;
-
-		LLSD inv_lib_root = response["inventory-lib-root"];
-		if(inv_lib_root.isDefined())
-		{
-			// should only be one
-			LLSD id = inv_lib_root[0]["folder_id"];
-			if(id.isDefined())
-			{
-				gInventory.setLibraryRootFolderID(id.asUUID());
-			}
-		}
-		display_startup();
-
-		LLSD inv_lib_owner = response["inventory-lib-owner"];
-		if(inv_lib_owner.isDefined())
-		{
-			// should only be one
-			LLSD id = inv_lib_owner[0]["agent_id"];
-			if(id.isDefined())
-			{
-				gInventory.setLibraryOwnerID(LLUUID(id.asUUID()));
-			}
-		}
 		display_startup();
 		LLStartUp::setStartupState(STATE_INVENTORY_SKEL);
 		display_startup();
@@ -1806,27 +1817,9 @@ bool idle_startup()
     {
         LL_PROFILE_ZONE_NAMED("State inventory load skeleton")
 
-		LLSD response = LLLoginInstance::getInstance()->getResponse();
-
-        LLSD inv_skel_lib = response["inventory-skel-lib"];
-        if (inv_skel_lib.isDefined() && gInventory.getLibraryOwnerID().notNull())
+        if (!sInventorySkeletonLoaded)
         {
-            LL_PROFILE_ZONE_NAMED("load library inv")
-            if (!gInventory.loadSkeleton(inv_skel_lib, gInventory.getLibraryOwnerID()))
-            {
-                LL_WARNS("AppInit") << "Problem loading inventory-skel-lib" << LL_ENDL;
-            }
-        }
-        display_startup();
-
-        LLSD inv_skeleton = response["inventory-skeleton"];
-        if (inv_skeleton.isDefined())
-        {
-            LL_PROFILE_ZONE_NAMED("load personal inv")
-            if (!gInventory.loadSkeleton(inv_skeleton, gAgent.getID()))
-            {
-                LL_WARNS("AppInit") << "Problem loading inventory-skel-targets" << LL_ENDL;
-            }
+            load_inventory_skeleton();
         }
         display_startup();
         LLStartUp::setStartupState(STATE_INVENTORY_SEND2);
@@ -1998,10 +1991,14 @@ bool idle_startup()
 		LL_INFOS() << "Requesting Agent Data" << LL_ENDL;
 		gAgent.sendAgentDataUpdateRequest();
 		display_startup();
-		// Create the inventory views
-		LL_INFOS() << "Creating Inventory Views" << LL_ENDL;
-		LLFloaterReg::getInstance("inventory");
-		display_startup();
+		// Create the inventory views, or leave them for
+		// LLViewerFloaterReg::updatePrebuild() once in world
+		if (gSavedSettings.getBOOL("InventoryBuildAtLogin"))
+		{
+			LL_INFOS() << "Creating Inventory Views" << LL_ENDL;
+			LLFloaterReg::getInstance("inventory");
+			display_startup();
+		}
 		LLStartUp::setStartupState( STATE_MISC );
 		display_startup();
 
@@ -2367,6 +2364,10 @@ bool idle_startup()
 			LL_DEBUGS("AppInit") << "Starting automatic playback" << LL_ENDL;
 			gAgentPilot.startPlayback();
 		}
+		else if (gSavedSettings.getBOOL("RenderBenchmarkEnabled"))
+		{
+			LLRenderBenchmark::getInstance()->start();
+		}
 
 		show_debug_menus(); // Debug menu visiblity and First Use trigger
 		
@@ -2376,13 +2377,24 @@ bool idle_startup()
 		// Retrieve information about the land data
 		// (just accessing this the first time will fetch it,
 		// then the data is cached for the viewer's lifetime)
-		LLProductInfoRequestManager::instance();
+		LLDeferredInit::add("land product info", []()
+		{
+			LLProductInfoRequestManager::instance();
+		});
 		
 		// *FIX:Mani - What do I do here?
 		// Need we really clear the Auth response data?
 		// Clean up the userauth stuff.
 		// LLUserAuth::getInstance()->reset();
 
+		{
+			LLStartUp::getPhases().stopPhase("login to world");
+			F32 elapsed = 0.f;
+			bool completed = false;
+			LLStartUp::getPhases().getPhaseValues("login to world", elapsed, completed);
+			LL_INFOS("AppInit") << "Login response to in world took " << elapsed << "s" << LL_ENDL;
+		}
+
 		LLStartUp::setStartupState( STATE_STARTED );
 		display_startup();
 
@@ -2417,6 +2429,8 @@ bool idle_startup()
 
 		LLUIUsage::instance().clear();
 
+		LLViewerFloaterReg::queuePrebuild();
+
         LLPerfStats::StatsRecorder::setAutotuneInit();
 
 		return TRUE;
@@ -2606,7 +2620,7 @@ void use_circuit_callback(void**, S32 result)
 
 void register_viewer_callbacks(LLMessageSystem* msg)
 {
-	msg->setHandlerFuncFast(_PREHASH_LayerData,				process_layer_data );
+	msg->setRawHandlerFuncFast(_PREHASH_LayerData,			process_layer_data );
 	msg->setHandlerFuncFast(_PREHASH_ObjectUpdate,				process_object_update );
 	msg->setHandlerFunc("ObjectUpdateCompressed",				process_compressed_object_update );
 	msg->setHandlerFunc("ObjectUpdateCached",					process_cached_object_update );
@@ -2633,7 +2647,7 @@ void register_viewer_callbacks(LLMessageSystem* msg)
 
 	msg->setHandlerFuncFast(_PREHASH_NameValuePair,			process_name_value);
 	msg->setHandlerFuncFast(_PREHASH_RemoveNameValuePair,	process_remove_name_value);
-	msg->setHandlerFuncFast(_PREHASH_AvatarAnimation,		process_avatar_animation);
+	msg->setRawHandlerFuncFast(_PREHASH_AvatarAnimation,	process_avatar_animation);
 	msg->setHandlerFuncFast(_PREHASH_ObjectAnimation,		process_object_animation);
 	msg->setHandlerFuncFast(_PREHASH_AvatarAppearance,		process_avatar_appearance);
 	msg->setHandlerFuncFast(_PREHASH_CameraConstraint,		process_camera_constraint);
@@ -2648,7 +2662,7 @@ void register_viewer_callbacks(LLMessageSystem* msg)
 	msg->setHandlerFunc("ForceObjectSelect", LLSelectMgr::processForceObjectSelect);
 
 	msg->setHandlerFuncFast(_PREHASH_MoneyBalanceReply,		process_money_balance_reply,	NULL);
-	msg->setHandlerFuncFast(_PREHASH_CoarseLocationUpdate,		LLWorld::processCoarseUpdate, NULL);
+	msg->setRawHandlerFuncFast(_PREHASH_CoarseLocationUpdate,	LLWorld::processCoarseUpdate, NULL);
 	msg->setHandlerFuncFast(_PREHASH_ReplyTaskInventory, 		LLViewerObject::processTaskInv,	NULL);
 	msg->setHandlerFuncFast(_PREHASH_DerezContainer,			process_derez_container, NULL);
 	msg->setHandlerFuncFast(_PREHASH_ScriptRunningReply,
@@ -2979,8 +2993,25 @@ void LLStartUp::setStartupState( EStartupState state )
 		startupStateToString(state) << LL_ENDL;
 
 	getPhases().stopPhase(getStartupStateString());
+	LLStartupProfiler::end();
 	gStartupState = state;
 	getPhases().startPhase(getStartupStateString());
+	LLStartupProfiler::begin(getStartupStateString());
+
+	switch (state)
+	{
+	case STATE_LOGIN_WAIT:
+		LLStartupProfiler::mark("login screen");
+		break;
+	case STATE_LOGIN_CLEANUP:
+		LLStartupProfiler::mark("login");
+		break;
+	case STATE_STARTED:
+		LLStartupProfiler::mark("in world");
+		break;
+	default:
+		break;
+	}
 
 	postStartupState();
 }
@@ -2995,8 +3026,71 @@ void LLStartUp::postStartupState()
 }
 
 
+// Unpacks the library roots and loads both inventory skeletons from the
+// login response and the inventory cache.
+void load_inventory_skeleton()
+{
+	LL_PROFILE_ZONE_SCOPED;
+	LLStartUp::getPhases().startPhase("inventory skeleton");
+	sInventorySkeletonLoaded = true;
+
+	LLSD response = LLLoginInstance::getInstance()->getResponse();
+
+	LLSD inv_lib_root = response["inventory-lib-root"];
+	if(inv_lib_root.isDefined())
+	{
+		// should only be one
+		LLSD id = inv_lib_root[0]["folder_id"];
+		if(id.isDefined())
+		{
+			gInventory.setLibraryRootFolderID(id.asUUID());
+		}
+	}
+
+	LLSD inv_lib_owner = response["inventory-lib-owner"];
+	if(inv_lib_owner.isDefined())
+	{
+		// should only be one
+		LLSD id = inv_lib_owner[0]["agent_id"];
+		if(id.isDefined())
+		{
+			gInventory.setLibraryOwnerID(LLUUID(id.asUUID()));
+		}
+	}
+	display_startup();
+
+	LLSD inv_skel_lib = response["inventory-skel-lib"];
+	if (inv_skel_lib.isDefined() && gInventory.getLibraryOwnerID().notNull())
+	{
+		LL_PROFILE_ZONE_NAMED("load library inv")
+		if (!gInventory.loadSkeleton(inv_skel_lib, gInventory.getLibraryOwnerID()))
+		{
+			LL_WARNS("AppInit") << "Problem loading inventory-skel-lib" << LL_ENDL;
+		}
+	}
+	display_startup();
+
+	LLSD inv_skeleton = response["inventory-skeleton"];
+	if (inv_skeleton.isDefined())
+	{
+		LL_PROFILE_ZONE_NAMED("load personal inv")
+		if (!gInventory.loadSkeleton(inv_skeleton, gAgent.getID()))
+		{
+			LL_WARNS("AppInit") << "Problem loading inventory-skel-targets" << LL_ENDL;
+		}
+	}
+
+	LLStartUp::getPhases().stopPhase("inventory skeleton");
+	F32 elapsed = 0.f;
+	bool completed = false;
+	LLStartUp::getPhases().getPhaseValues("inventory skeleton", elapsed, completed);
+	LL_INFOS("AppInit") << "Inventory skeleton loaded in " << elapsed << "s during "
+						<< LLStartUp::getStartupStateString() << LL_ENDL;
+}
+
 void reset_login()
 {
+	sInventorySkeletonLoaded = false;
 	gAgentWearables.cleanup();
 	gAgentCamera.cleanup();
 	gAgent.cleanup();
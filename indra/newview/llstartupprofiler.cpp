@@ -0,0 +1,162 @@
+/**
+ * @file llstartupprofiler.cpp
+ * @brief Timings of the steps from launch to the login screen and in world.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llstartupprofiler.h"
+
+#include "lltimer.h"
+#include "llviewercontrol.h"
+
+#include <iomanip>
+
+// spans shorter than this are left out of the log, not the trace
+static const U64 LOG_THRESHOLD_USEC = 50000;
+
+std::vector<LLStartupProfiler::Span> LLStartupProfiler::sSpans;
+std::vector<size_t> LLStartupProfiler::sOpen;
+std::vector<std::pair<std::string, U64> > LLStartupProfiler::sMarks;
+U64 LLStartupProfiler::sLaunchTime = 0;
+bool LLStartupProfiler::sReported = false;
+
+//static
+U64 LLStartupProfiler::now()
+{
+	U64 time = totalTime().value();
+	if (!sLaunchTime)
+	{
+		sLaunchTime = time;
+	}
+	return time - sLaunchTime;
+}
+
+//static
+void LLStartupProfiler::begin(const std::string& name)
+{
+	if (sReported)
+	{
+		return;
+	}
+
+	Span span;
+	span.mName = name;
+	span.mStart = now();
+	span.mDuration = 0;
+	span.mDepth = (U32)sOpen.size();
+	sOpen.push_back(sSpans.size());
+	sSpans.push_back(span);
+}
+
+//static
+void LLStartupProfiler::end()
+{
+	if (sReported || sOpen.empty())
+	{
+		return;
+	}
+
+	Span& span = sSpans[sOpen.back()];
+	span.mDuration = now() - span.mStart;
+	sOpen.pop_back();
+}
+
+//static
+void LLStartupProfiler::mark(const std::string& name)
+{
+	if (sReported)
+	{
+		return;
+	}
+
+	U64 time = now();
+	sMarks.push_back(std::make_pair(name, time));
+	LL_INFOS("AppInit") << "Startup reached " << name << " after " << (F32)time / 1000000.f << "s" << LL_ENDL;
+}
+
+//static
+void LLStartupProfiler::report()
+{
+	if (sReported)
+	{
+		return;
+	}
+
+	while (!sOpen.empty())
+	{
+		end();
+	}
+	sReported = true;
+
+	std::ostringstream summary;
+	summary << std::fixed << std::setprecision(3);
+	for (const Span& span : sSpans)
+	{
+		if (span.mDuration >= LOG_THRESHOLD_USEC)
+		{
+			summary << "\n" << std::string(span.mDepth * 2, ' ') << span.mName << ": " << (F32)span.mDuration / 1000000.f << "s";
+		}
+	}
+	LL_INFOS("AppInit") << "Startup steps over " << LOG_THRESHOLD_USEC / 1000 << "ms:" << summary.str() << LL_ENDL;
+
+	if (gSavedSettings.getBOOL("StartupProfileExport"))
+	{
+		exportTrace(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "startup_profile.json"));
+	}
+
+	sSpans.clear();
+	sSpans.shrink_to_fit();
+	sMarks.clear();
+	sMarks.shrink_to_fit();
+}
+
+//static
+void LLStartupProfiler::exportTrace(const std::string& filename)
+{
+	llofstream out(filename.c_str());
+	if (!out.is_open())
+	{
+		LL_WARNS("AppInit") << "Unable to write startup profile to " << filename << LL_ENDL;
+		return;
+	}
+
+	// span and mark names are our own, nothing to escape
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const Span& span : sSpans)
+	{
+		out << (first ? "" : ",\n") << "{\"name\":\"" << span.mName << "\",\"ph\":\"X\",\"ts\":" << span.mStart
+			<< ",\"dur\":" << span.mDuration << ",\"pid\":1,\"tid\":1}";
+		first = false;
+	}
+	for (const auto& mark : sMarks)
+	{
+		out << (first ? "" : ",\n") << "{\"name\":\"" << mark.first << "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":" << mark.second
+			<< ",\"pid\":1,\"tid\":1}";
+		first = false;
+	}
+	out << "\n]}\n";
+
+	LL_INFOS("AppInit") << "Saved startup profile to " << filename << LL_ENDL;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file llstartupprofiler.h
+ * @brief Timings of the steps from launch to the login screen and in world.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSTARTUPPROFILER_H
+#define LL_LLSTARTUPPROFILER_H
+
+#include <string>
+#include <vector>
+
+// Times the steps of LLAppViewer::init(), each startup state and the
+// subsystems LLDeferredInit brings up afterwards. Spans nest, so a step
+// opened while a startup state is running is shown inside it. report() logs
+// the slowest spans and, with StartupProfileExport, writes all of them to
+// startup_profile.json in the logs folder in Chrome trace event format.
+// Main thread only.
+class LLStartupProfiler
+{
+public:
+	// times the enclosing scope
+	class Scope
+	{
+	public:
+		Scope(const std::string& name) { begin(name); }
+		~Scope() { end(); }
+	};
+
+	static void begin(const std::string& name);
+	// closes the span opened last
+	static void end();
+
+	// a point in time, e.g. the login screen first showing
+	static void mark(const std::string& name);
+
+	// Closes whatever is still open and writes everything out. Only the
+	// first call does anything.
+	static void report();
+
+private:
+	struct Span
+	{
+		std::string mName;
+		U64 mStart;		// microseconds since the first span
+		U64 mDuration;	// microseconds
+		U32 mDepth;
+	};
+
+	static U64 now();
+	static void exportTrace(const std::string& filename);
+
+	static std::vector<Span> sSpans;
+	static std::vector<size_t> sOpen;	// indices into sSpans, innermost last
+	static std::vector<std::pair<std::string, U64> > sMarks;
+	static U64 sLaunchTime;
+	static bool sReported;
+};
+
+#endif // LL_LLSTARTUPPROFILER_H
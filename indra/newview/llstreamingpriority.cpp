@@ -0,0 +1,100 @@
+/**
+ * @file llstreamingpriority.cpp
+ * @brief Shared importance measure and in-flight budget for streamed content.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llstreamingpriority.h"
+
+#include "llviewercamera.h"
+#include "llviewercontrol.h"
+
+// Off screen and occluded things still load, behind everything in view.
+static const F32 OFFSCREEN_IMPORTANCE_SCALE = 0.125f;
+
+std::atomic<S32> LLStreamingPriority::sInFlight[LLStreamingPriority::STREAM_COUNT];
+std::atomic<S32> LLStreamingPriority::sInFlightTotal(0);
+std::atomic<S32> LLStreamingPriority::sBudget(0);
+std::atomic<F32> LLStreamingPriority::sLastIssued[LLStreamingPriority::STREAM_COUNT];
+std::atomic<U32> LLStreamingPriority::sIssued[LLStreamingPriority::STREAM_COUNT];
+
+//static
+F32 LLStreamingPriority::calcImportance(const LLVector3& center_agent, F32 radius, bool visible)
+{
+	LLViewerCamera* camera = LLViewerCamera::getInstance();
+	F32 distance = llmax((center_agent - camera->getOrigin()).length() - radius, 1.f);
+	F32 pixels = radius * camera->getPixelMeterRatio() / distance;
+	F32 importance = F_PI * pixels * pixels;
+	if (!visible || !camera->sphereInFrustum(center_agent, radius))
+	{
+		importance *= OFFSCREEN_IMPORTANCE_SCALE;
+	}
+	return importance;
+}
+
+//static
+void LLStreamingPriority::update()
+{
+	static LLCachedControl<U32> budget_kb(gSavedSettings, "StreamingInFlightBudgetKB", 0);
+	sBudget = (S32)llmin((U32)budget_kb, (U32)(S32_MAX / 1024)) * 1024;
+}
+
+//static
+bool LLStreamingPriority::hasBudget()
+{
+	S32 budget = sBudget;
+	S32 in_flight = sInFlightTotal;
+	return !budget || !in_flight || in_flight < budget;
+}
+
+//static
+void LLStreamingPriority::addInFlight(EStream stream, S32 bytes)
+{
+	sInFlight[stream] += bytes;
+	sInFlightTotal += bytes;
+}
+
+//static
+void LLStreamingPriority::removeInFlight(EStream stream, S32 bytes)
+{
+	sInFlight[stream] -= bytes;
+	sInFlightTotal -= bytes;
+}
+
+//static
+void LLStreamingPriority::noteIssued(EStream stream, F32 importance)
+{
+	sLastIssued[stream] = importance;
+	++sIssued[stream];
+}
+
+//static
+std::string LLStreamingPriority::getDebugText()
+{
+	return llformat("Stream KB(Tex/Mesh/Budget): %d/%d/%d Last(Obj/Tex/Mesh): %.0f/%.0f/%.0f Issued: %u/%u/%u",
+					sInFlight[STREAM_TEXTURE] / 1024, sInFlight[STREAM_MESH] / 1024, sBudget / 1024,
+					(F32)sLastIssued[STREAM_OBJECT], (F32)sLastIssued[STREAM_TEXTURE], (F32)sLastIssued[STREAM_MESH],
+					(U32)sIssued[STREAM_OBJECT], (U32)sIssued[STREAM_TEXTURE], (U32)sIssued[STREAM_MESH]);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file llstreamingpriority.h
+ * @brief Shared importance measure and in-flight budget for streamed content.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSTREAMINGPRIORITY_H
+#define LL_LLSTREAMINGPRIORITY_H
+
+#include "v3math.h"
+
+#include <atomic>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLStreamingPriority
+//
+// What objects, textures and meshes have in common when deciding what to
+// load first. Importance is the projected pixel area of the thing's bounding
+// sphere, cut down when it is off screen or occluded, which is the scale
+// texture virtual sizes are already on. The mesh repository orders its
+// pending requests by it, and region cache entries report it as they are
+// turned into objects.
+//
+// Texture and mesh HTTP requests also share one budget of bytes in flight
+// (StreamingInFlightBudgetKB). Each queue keeps issuing in its own priority
+// order, but neither can flood the pipe while the other waits behind it.
+//
+// The importance of the last request each stream issued, and the bytes in
+// flight, show in the texture console, to follow the fill order.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLStreamingPriority
+{
+public:
+	enum EStream
+	{
+		STREAM_OBJECT,
+		STREAM_TEXTURE,
+		STREAM_MESH,
+		STREAM_COUNT
+	};
+
+	// Main thread.
+	static F32 calcImportance(const LLVector3& center_agent, F32 radius, bool visible);
+
+	// Main thread, once per frame: picks up the budget setting.
+	static void update();
+
+	// Any thread. True when under budget, or nothing is in flight so
+	// one request of any size can always go.
+	static bool hasBudget();
+	static void addInFlight(EStream stream, S32 bytes);
+	static void removeInFlight(EStream stream, S32 bytes);
+
+	// Any thread.
+	static void noteIssued(EStream stream, F32 importance);
+
+	// One line for the texture console.
+	static std::string getDebugText();
+
+private:
+	static std::atomic<S32>	sInFlight[STREAM_COUNT];
+	static std::atomic<S32>	sInFlightTotal;
+	static std::atomic<S32>	sBudget;				// bytes, 0 for no limit
+	static std::atomic<F32>	sLastIssued[STREAM_COUNT];
+	static std::atomic<U32>	sIssued[STREAM_COUNT];
+};
+
+#endif // LL_LLSTREAMINGPRIORITY_H
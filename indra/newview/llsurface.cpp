@@ -91,6 +91,8 @@ LLSurface::LLSurface(U32 type, LLViewerRegion *regionp) :
 	mVisiblePatchCount = 0;
 
 	mHasZData = FALSE;
+	mHeightFieldTexture = 0;
+	mHeightFieldDirty = TRUE;
 	// "uninitialized" min/max z
 	mMinZ = 10000.f;
 	mMaxZ = -10000.f;
@@ -114,6 +116,12 @@ LLSurface::~LLSurface()
 
 	delete [] mNorm;
 
+	if (mHeightFieldTexture)
+	{
+		LLImageGL::deleteTextures(1, &mHeightFieldTexture);
+		mHeightFieldTexture = 0;
+	}
+
 	mGridsPerEdge = 0;
 	mGridsPerPatchEdge = 0;
 	mPatchesPerEdge = 0;
@@ -691,70 +699,95 @@ BOOL LLSurface::idleUpdate(F32 max_update_time)
 	return did_update;
 }
 
-void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch) 
+U32 LLSurface::getHeightFieldTexture()
 {
+	if (!mHeightFieldTexture)
+	{
+		LLImageGL::generateTextures(1, &mHeightFieldTexture);
+		mHeightFieldDirty = TRUE;
+	}
+	if (!mHeightFieldDirty || !mSurfaceZ)
+	{
+		return mHeightFieldTexture;
+	}
+	mHeightFieldDirty = FALSE;
 
-	LLPatchHeader  ph;
-	S32 j, i;
-	S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-	LLSurfacePatch *patchp;
-
-	init_patch_decompressor(gopp->patch_size);
-	gopp->stride = mGridsPerEdge;
-	set_group_of_patch_header(gopp);
-
-	while (1)
+	// Same composition and noise values LLSurfacePatch::eval() puts in the
+	// second texture coordinate of the CPU built geometry.
+	const F32 xy_scale_inv = (1.f / (4.9215f*7.f))*(0.2222222222f);
+	std::vector<F32> texels(mGridsPerEdge * mGridsPerEdge * 3);
+	for (S32 j = 0; j < mGridsPerEdge; j++)
 	{
-		decode_patch_header(bitpack, &ph);
-		if (ph.quant_wbits == END_OF_PATCHES)
+		for (S32 i = 0; i < mGridsPerEdge; i++)
 		{
-			break;
+			F32* texel = &texels[(i + j*mGridsPerEdge) * 3];
+			texel[0] = mSurfaceZ[i + j*mGridsPerEdge];
+			texel[1] = mRegionp->getCompositionXY(llfloor(i*mMetersPerGrid), llfloor(j*mMetersPerGrid));
+
+			F32 vec[3] = {
+							(F32)fmod((F32)(mOriginGlobal.mdV[0] + i*mMetersPerGrid)*xy_scale_inv, 256.f),
+							(F32)fmod((F32)(mOriginGlobal.mdV[1] + j*mMetersPerGrid)*xy_scale_inv, 256.f),
+							0.f
+						};
+			texel[2] = llclamp(noise2(vec)* 0.75f + 0.5f, 0.f, 1.f);
 		}
+	}
 
-		i = ph.patchids >> 5;
-		j = ph.patchids & 0x1F;
+	LLTexUnit* unit = gGL.getTexUnit(0);
+	unit->bindManual(LLTexUnit::TT_TEXTURE, mHeightFieldTexture);
+	LLImageGL::setManualImage(GL_TEXTURE_2D, 0, GL_RGB32F, mGridsPerEdge, mGridsPerEdge, GL_RGB, GL_FLOAT, &texels[0], false);
+	unit->setTextureFilteringOption(LLTexUnit::TFO_POINT);
+	unit->setTextureAddressMode(LLTexUnit::TAM_CLAMP);
+	unit->unbind(LLTexUnit::TT_TEXTURE);
 
-		if ((i >= mPatchesPerEdge) || (j >= mPatchesPerEdge))
-		{
-			LL_WARNS() << "Received invalid terrain packet - patch header patch ID incorrect!" 
-				<< " patches per edge " << mPatchesPerEdge
-				<< " i " << i
-				<< " j " << j
-				<< " dc_offset " << ph.dc_offset
-				<< " range " << (S32)ph.range
-				<< " quant_wbits " << (S32)ph.quant_wbits
-				<< " patchids " << (S32)ph.patchids
-				<< LL_ENDL;
-			return;
-		}
+	return mHeightFieldTexture;
+}
 
-		patchp = &mPatchList[j*mPatchesPerEdge + i];
+void LLSurface::applyDCTPatch(U16 patch_ids, const F32 *data, S32 patch_size)
+{
+	LLSurfacePatch *patchp;
+	S32 i = patch_ids >> 5;
+	S32 j = patch_ids & 0x1F;
 
+	if ((i >= mPatchesPerEdge) || (j >= mPatchesPerEdge))
+	{
+		LL_WARNS() << "Received invalid terrain packet - patch header patch ID incorrect!" 
+			<< " patches per edge " << mPatchesPerEdge
+			<< " i " << i
+			<< " j " << j
+			<< " patchids " << (S32)patch_ids
+			<< LL_ENDL;
+		return;
+	}
 
-		decode_patch(bitpack, patch);
-		decompress_patch(patchp->getDataZ(), patch, &ph);
+	patchp = &mPatchList[j*mPatchesPerEdge + i];
 
-		// Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
-		patchp->updateNorthEdge();
-		patchp->updateEastEdge();
-		if (patchp->getNeighborPatch(WEST))
-		{
-			patchp->getNeighborPatch(WEST)->updateEastEdge();
-		}
-		if (patchp->getNeighborPatch(SOUTHWEST))
-		{
-			patchp->getNeighborPatch(SOUTHWEST)->updateEastEdge();
-			patchp->getNeighborPatch(SOUTHWEST)->updateNorthEdge();
-		}
-		if (patchp->getNeighborPatch(SOUTH))
-		{
-			patchp->getNeighborPatch(SOUTH)->updateNorthEdge();
-		}
+	F32 *dst = patchp->getDataZ();
+	for (S32 row = 0; row < patch_size; row++)
+	{
+		memcpy(dst + row*mGridsPerEdge, data + row*patch_size, patch_size*sizeof(F32));
+	}
 
-		// Dirty patch statistics, and flag that the patch has data.
-		patchp->dirtyZ();
-		patchp->setHasReceivedData();
+	// Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
+	patchp->updateNorthEdge();
+	patchp->updateEastEdge();
+	if (patchp->getNeighborPatch(WEST))
+	{
+		patchp->getNeighborPatch(WEST)->updateEastEdge();
+	}
+	if (patchp->getNeighborPatch(SOUTHWEST))
+	{
+		patchp->getNeighborPatch(SOUTHWEST)->updateEastEdge();
+		patchp->getNeighborPatch(SOUTHWEST)->updateNorthEdge();
+	}
+	if (patchp->getNeighborPatch(SOUTH))
+	{
+		patchp->getNeighborPatch(SOUTH)->updateNorthEdge();
 	}
+
+	// Dirty patch statistics, and flag that the patch has data.
+	patchp->dirtyZ();
+	patchp->setHasReceivedData();
 }
 
 
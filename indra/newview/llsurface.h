@@ -84,7 +84,9 @@ public:
 	void disconnectNeighbor(LLSurface *neighborp);
 	void disconnectAllNeighbors();
 
-	virtual void decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch);
+	// Stores the heights of one patch of a decoded land layer, patch_size
+	// values per row.
+	void applyDCTPatch(U16 patch_ids, const F32 *data, S32 patch_size);
 	virtual void updatePatchVisibilities(LLAgent &agent);
 
 	inline F32 getZ(const U32 k) const				{ return mSurfaceZ[k]; }
@@ -128,6 +130,12 @@ public:
 
 	LLViewerTexture *getSTexture();
 	LLViewerTexture *getWaterTexture();
+
+	// Height, composition and detail noise of every grid point as an RGB
+	// float texture, for drawing with RenderTerrainHeightField. Uploaded
+	// again on first use after any patch height changes.
+	U32 getHeightFieldTexture();
+
 	BOOL hasZData() const							{ return mHasZData; }
 
 	void dirtyAllPatches();	// Use this to dirty all patches when changing terrain parameters
@@ -214,6 +222,8 @@ protected:
 	LLPatchVertexArray mPVArray;
 
 	BOOL		mHasZData;				// We've received any patch data for this surface.
+	U32			mHeightFieldTexture;	// GL name, see getHeightFieldTexture()
+	BOOL		mHeightFieldDirty;
 	F32			mMinZ;					// min z for this region (during the session)
 	F32			mMaxZ;					// max z for this region (during the session)
 
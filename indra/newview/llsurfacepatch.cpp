@@ -40,6 +40,7 @@
 #include "llviewerregion.h"
 #include "llvlcomposition.h"
 #include "lldrawpool.h"
+#include "lldrawpoolterrain.h"
 #include "noise.h"
 
 extern bool gShiftFrame;
@@ -104,6 +105,7 @@ void LLSurfacePatch::dirty()
 
 	mDirtyZStats = TRUE;
 	mHeightsGenerated = FALSE;
+	mSurfacep->mHeightFieldDirty = TRUE;
 	
 	if (!mDirty)
 	{
@@ -891,7 +893,8 @@ void LLSurfacePatch::updateVisibility()
 		new_render_level = mVisInfo.mRenderLevel = mSurfacep->getRenderLevel(max_render_stride);
 		mVisInfo.mRenderStride = mSurfacep->getRenderStride(new_render_level);
 
-		if ((mVisInfo.mRenderStride != old_render_stride)) 
+		// The height field path picks the stride up at draw time.
+		if ((mVisInfo.mRenderStride != old_render_stride) && !LLDrawPoolTerrain::sHeightField) 
 			// The reason we check !mbIsVisible is because non-visible patches normals 
 			// are not updated when their data is changed.  When this changes we can get 
 			// rid of mbIsVisible altogether.
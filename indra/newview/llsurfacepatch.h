@@ -111,6 +111,7 @@ public:
 	
 
 	LLVector3 getOriginAgent() const;
+	const LLVector3 &getOriginRegion() const { return mOriginRegion; }
 	const LLVector3d &getOriginGlobal() const;
 	void setOriginGlobal(const LLVector3d &origin_global);
 	
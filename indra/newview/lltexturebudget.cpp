@@ -0,0 +1,200 @@
+/**
+ * @file lltexturebudget.cpp
+ * @brief Keeps texture memory under the VRAM budget, least valuable first.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturebudget.h"
+
+#include "llgl.h"
+#include "llviewercontrol.h"
+#include "llviewertexture.h"
+#include "llviewertexturelist.h"
+
+// llviewertexture.cpp
+extern F32 texmem_lower_bound_scale;
+
+static const F32 BUDGET_CHECK_INTERVAL = 1.f;	// seconds
+static const S32 MIN_FREE_VRAM_MB = 256;		// below this from the driver is over budget
+static const F32 EVICTION_HOLD_TIME = 10.f;		// seconds an evicted texture stays down at least
+static const F32 MAX_EVICTION_FRACTION = 0.125f; // of the evictable texture memory in one pass
+
+bool LLTextureBudget::sOverBudget = false;
+bool LLTextureBudget::sExhausted = false;
+S32 LLTextureBudget::sFreeMB = -1;
+S64 LLTextureBudget::sCategoryBytes[LLTextureBudget::CATEGORY_COUNT];
+U32 LLTextureBudget::sEvictedCount = 0;
+LLFrameTimer LLTextureBudget::sTimer;
+
+static LLTextureBudget::ECategory get_category(S32 boost_level)
+{
+	switch (boost_level)
+	{
+	case LLGLTexture::BOOST_AVATAR:
+	case LLGLTexture::BOOST_AVATAR_BAKED:
+	case LLGLTexture::BOOST_AVATAR_BAKED_SELF:
+	case LLGLTexture::BOOST_AVATAR_SELF:
+		return LLTextureBudget::CATEGORY_AVATAR;
+	case LLGLTexture::BOOST_HUD:
+	case LLGLTexture::BOOST_ICON:
+	case LLGLTexture::BOOST_THUMBNAIL:
+	case LLGLTexture::BOOST_UI:
+	case LLGLTexture::BOOST_PREVIEW:
+	case LLGLTexture::BOOST_MAP:
+	case LLGLTexture::BOOST_MAP_VISIBLE:
+		return LLTextureBudget::CATEGORY_UI;
+	default:
+		return LLTextureBudget::CATEGORY_SCENE;
+	}
+}
+
+//static
+bool LLTextureBudget::update(F32 used_mb, F32 target_mb)
+{
+	static LLCachedControl<bool> enabled(gSavedSettings, "RenderVRAMBudgetManager", false);
+
+	if (sTimer.getElapsedTimeF32() >= BUDGET_CHECK_INTERVAL)
+	{
+		sTimer.reset();
+		sFreeMB = gGLManager.getFreeVRAMMegabytes();
+		measure();
+		if (enabled)
+		{
+			check(used_mb, target_mb);
+		}
+	}
+
+	if (!enabled)
+	{
+		sOverBudget = false;
+		sExhausted = false;
+	}
+	return enabled;
+}
+
+//static
+void LLTextureBudget::check(F32 used_mb, F32 target_mb)
+{
+	F32 low_water_mb = target_mb * texmem_lower_bound_scale;
+
+	if (used_mb > target_mb || (sFreeMB >= 0 && sFreeMB < MIN_FREE_VRAM_MB))
+	{
+		sOverBudget = true;
+	}
+	else if (used_mb < low_water_mb && (sFreeMB < 0 || sFreeMB >= MIN_FREE_VRAM_MB * 2))
+	{
+		sOverBudget = false;
+		sExhausted = false;
+	}
+
+	if (sOverBudget)
+	{
+		// used_mb is twice the bytes we know about, see updateClass()
+		S64 bytes = (S64)(llmax(used_mb - low_water_mb, 0.f) * 0.5f * 1024.f * 1024.f);
+		if (sFreeMB >= 0)
+		{
+			bytes = llmax(bytes, (S64)(MIN_FREE_VRAM_MB * 2 - sFreeMB) * 1024 * 1024);
+		}
+		evict(bytes);
+	}
+}
+
+//static
+void LLTextureBudget::measure()
+{
+	for (S32 i = 0; i < CATEGORY_COUNT; ++i)
+	{
+		sCategoryBytes[i] = 0;
+	}
+
+	for (const LLPointer<LLViewerFetchedTexture>& imagep : gTextureList.mImageList)
+	{
+		if (imagep->hasGLTexture())
+		{
+			sCategoryBytes[get_category(imagep->getBoostLevel())] += imagep->getTextureMemory().value();
+		}
+	}
+	sCategoryBytes[CATEGORY_MEDIA] = LLViewerMediaTexture::getTotalTextureMemory();
+}
+
+//static
+void LLTextureBudget::evict(S64 bytes)
+{
+	// on screen size per byte, lowest goes first
+	typedef std::pair<F32, LLViewerLODTexture*> ranked_t;
+	std::vector<ranked_t> ranked;
+	ranked.reserve(gTextureList.mImageList.size());
+
+	S64 evictable = 0;
+	for (const LLPointer<LLViewerFetchedTexture>& imagep : gTextureList.mImageList)
+	{
+		if (imagep->getType() != LLViewerTexture::LOD_TEXTURE
+			|| !imagep->hasGLTexture()
+			|| imagep->getBoostLevel() >= LLGLTexture::BOOST_AVATAR_BAKED
+			|| imagep->getDontDiscard()
+			|| imagep->isInDebug()
+			|| imagep->isUnremovable())
+		{
+			continue;
+		}
+
+		S64 tex_bytes = imagep->getTextureMemory().value();
+		if (tex_bytes > 0)
+		{
+			evictable += tex_bytes;
+			ranked.push_back(ranked_t(imagep->getMaxVirtualSize() / (F32)tex_bytes, (LLViewerLODTexture*)imagep.get()));
+		}
+	}
+
+	// spread a big overshoot over a few passes
+	bytes = llmin(bytes, (S64)(evictable * MAX_EVICTION_FRACTION));
+	std::sort(ranked.begin(), ranked.end(),
+		[](const ranked_t& lhs, const ranked_t& rhs) { return lhs.first < rhs.first; });
+
+	F32 hold_until = LLViewerTexture::sCurrentTime + EVICTION_HOLD_TIME;
+	S64 freed = 0;
+	for (U32 i = 0; i < ranked.size() && freed < bytes; ++i)
+	{
+		S64 evicted = ranked[i].second->evictForBudget(hold_until);
+		if (evicted > 0)
+		{
+			freed += evicted;
+			++sEvictedCount;
+		}
+	}
+
+	sExhausted = freed < bytes;
+}
+
+//static
+std::string LLTextureBudget::getDebugText()
+{
+	static LLCachedControl<bool> enabled(gSavedSettings, "RenderVRAMBudgetManager", false);
+	const S64 MB = 1024 * 1024;
+	return llformat("VRAM MB(Scene/Av/UI/Media): %d/%d/%d/%d Drv Free: %d %s Evicted: %u",
+					(S32)(sCategoryBytes[CATEGORY_SCENE] / MB), (S32)(sCategoryBytes[CATEGORY_AVATAR] / MB),
+					(S32)(sCategoryBytes[CATEGORY_UI] / MB), (S32)(sCategoryBytes[CATEGORY_MEDIA] / MB),
+					sFreeMB, !enabled ? "Off" : sOverBudget ? (sExhausted ? "Over+Bias" : "Over") : "Under", sEvictedCount);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file lltexturebudget.h
+ * @brief Keeps texture memory under the VRAM budget, least valuable first.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREBUDGET_H
+#define LL_LLTEXTUREBUDGET_H
+
+#include "llframetimer.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLTextureBudget
+//
+// With RenderVRAMBudgetManager on, texture memory pressure is handled here
+// instead of by raising LLViewerTexture::sDesiredDiscardBias for everything.
+// Once a second the textures are ranked by on screen size per byte of video
+// memory, and while over budget the lowest ranked ones drop a mip until the
+// estimate is back under the low water mark.
+//
+// Over budget starts above the target LLViewerTexture::updateClass() works
+// out, or when the driver reports (GL_NVX_gpu_memory_info, GL_ATI_meminfo)
+// too little free, and ends only below texmem_lower_bound_scale of the
+// target.  Evicted textures stay down for a while after that as well, so
+// nothing blurs and sharpens over and over at the edge of the budget.
+// The discard bias still goes up if there's nothing left worth evicting.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLTextureBudget
+{
+public:
+	enum ECategory
+	{
+		CATEGORY_SCENE,
+		CATEGORY_AVATAR,
+		CATEGORY_UI,
+		CATEGORY_MEDIA,
+		CATEGORY_COUNT
+	};
+
+	// Main thread, once a frame.  used_mb and target_mb are the estimates
+	// from LLViewerTexture::updateClass().  False when the manager is off,
+	// the breakdown by category is kept up to date either way.
+	static bool update(F32 used_mb, F32 target_mb);
+
+	static bool isOverBudget()			{ return sOverBudget; }
+
+	// Over budget with nothing left to evict, the discard bias has to help.
+	static bool needsDiscardBias()		{ return sOverBudget && sExhausted; }
+
+	// One line for the texture console.
+	static std::string getDebugText();
+
+private:
+	static void measure();
+	static void check(F32 used_mb, F32 target_mb);
+	static void evict(S64 bytes);
+
+	static bool			sOverBudget;
+	static bool			sExhausted;
+	static S32			sFreeMB;			// from the driver, -1 if it doesn't say
+	static S64			sCategoryBytes[CATEGORY_COUNT];
+	static U32			sEvictedCount;
+	static LLFrameTimer	sTimer;
+};
+
+#endif // LL_LLTEXTUREBUDGET_H
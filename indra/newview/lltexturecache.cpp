@@ -30,10 +30,12 @@
 
 #include "llapr.h"
 #include "lldir.h"
+#include "lldiriterator.h"
 #include "llimage.h"
 #include "llimagej2c.h" // for version control
 #include "lllfsthread.h"
 #include "llviewercontrol.h"
+#include "workqueue.h"
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
 #include "llappviewer.h" 
@@ -46,6 +48,11 @@
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
 // cache/textures/[0-F]/UUID.texture
 //  Actual texture body files
+// cache/textures/assets_NNNNN.pack
+//  Texture bodies in slab files instead, when TextureCacheUseSlabFiles is set.
+//  texture.cache is then sized for every entry up front and mapped.
+// cache/textures/FastCacheMips.cache
+//  Small decoded mips of recently cached textures by id, when TextureFastMipCacheMB is set
 
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
@@ -54,9 +61,41 @@ const F32 TEXTURE_CACHE_LRU_SIZE = .10f; // % amount for LRU list (low overhead
 const S32 TEXTURE_FAST_CACHE_ENTRY_OVERHEAD = sizeof(S32) * 4; //w, h, c, level
 const S32 TEXTURE_FAST_CACHE_DATA_SIZE = 16 * 16 * 4;
 const S32 TEXTURE_FAST_CACHE_ENTRY_SIZE = TEXTURE_FAST_CACHE_DATA_SIZE + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD;
+const S32 TEXTURE_FAST_MIP_DATA_SIZE = 64 * 64 * 4;
+const U32 TEXTURE_FAST_MIP_MAGIC = 0x50494d46; // "FMIP"
+const U32 TEXTURE_FAST_MIP_VERSION = 1;
 const F32 TEXTURE_LAZY_PURGE_TIME_LIMIT = .004f; // 4ms. Would be better to autoadjust, but there is a major cache rework in progress.
 const F32 TEXTURE_PRUNING_MAX_TIME = 15.f;
 
+// Layout of the fast mip cache file: the header, a table of slots, then the
+// mip data of each slot from the first page boundary after the table
+namespace
+{
+	struct FastMipHeader
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U32 mSlots;
+		U32 mNextSlot; // oldest slot, reused by the next texture written
+	};
+
+	struct FastMipSlot
+	{
+		U8 mID[UUID_BYTES];
+		S32 mWidth;
+		S32 mHeight;
+		S32 mComponents; // 0 for an empty slot or one being written
+		S32 mDiscardLevel;
+	};
+
+	size_t fast_mip_data_offset(U32 slots)
+	{
+		const size_t PAGE_SIZE = 4096;
+		size_t table_end = sizeof(FastMipHeader) + slots * sizeof(FastMipSlot);
+		return (table_end + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+	}
+}
+
 class LLTextureCacheWorker : public LLWorkerClass
 {
 	friend class LLTextureCache;
@@ -410,8 +449,7 @@ bool LLTextureCacheRemoteWorker::doRead()
 		mReadData = (U8*)ll_aligned_malloc_16(size);
 		if (mReadData)
 		{
-			S32 bytes_read = LLAPRFile::readEx(mCache->mHeaderDataFileName, 
-												 mReadData, offset, size, mCache->getLocalAPRFilePool());
+			S32 bytes_read = mCache->readHeaderData(offset, mReadData, size);
 			if (bytes_read != size)
 			{
 				LL_WARNS() << "LLTextureCacheWorker: "  << mID
@@ -445,8 +483,7 @@ bool LLTextureCacheRemoteWorker::doRead()
 	// Fourth state / stage : read the rest of the data from the UUID based cached file
 	if (!done && (mState == BODY))
 	{
-		std::string filename = mCache->getTextureFileName(mID);
-		S32 filesize = LLAPRFile::size(filename, mCache->getLocalAPRFilePool());
+		S32 filesize = mCache->getBodySize(mID);
 
 		if (filesize && (filesize + TEXTURE_CACHE_ENTRY_SIZE) > mOffset)
 		{
@@ -487,10 +524,7 @@ bool LLTextureCacheRemoteWorker::doRead()
 				mReadData = data;
 
 				// Read the data at last
-				S32 bytes_read = LLAPRFile::readEx(filename, 
-												 mReadData + data_offset,
-												 file_offset, file_size,
-												 mCache->getLocalAPRFilePool());
+				S32 bytes_read = mCache->readBody(mID, file_offset, mReadData + data_offset, file_size);
 				if (bytes_read != file_size)
 				{
 					LL_WARNS() << "LLTextureCacheWorker: "  << mID
@@ -516,7 +550,7 @@ bool LLTextureCacheRemoteWorker::doRead()
 		{
 			// No body, we're done.
 			mDataSize = llmax(TEXTURE_CACHE_ENTRY_SIZE - mOffset, 0);
-			LL_DEBUGS() << "No body file for: " << filename << LL_ENDL;
+			LL_DEBUGS() << "No body file for: " << mID << LL_ENDL;
 		}	
 		// Nothing else to do at that point...
 		done = true;
@@ -599,6 +633,8 @@ bool LLTextureCacheRemoteWorker::doWrite()
 			}
 			else
 			{
+				mCache->writeToFastMipCache(mID, mRawImage, mRawDiscardLevel);
+
 				if (alreadyCached && (mDataSize <= TEXTURE_CACHE_ENTRY_SIZE))
 				{
 					// Small texture already cached case: we're done with writing
@@ -680,13 +716,7 @@ bool LLTextureCacheRemoteWorker::doWrite()
 			S32 file_size = mDataSize - TEXTURE_CACHE_ENTRY_SIZE;
 
 			{
-				// build the cache file name from the UUID
-				std::string filename = mCache->getTextureFileName(mID);
-				// 			LL_INFOS() << "Writing Body: " << filename << " Bytes: " << file_offset+file_size << LL_ENDL;
-				S32 bytes_written = LLAPRFile::writeEx(filename,
-													   mWriteData + TEXTURE_CACHE_ENTRY_SIZE,
-													   0, file_size,
-													   mCache->getLocalAPRFilePool());
+				S32 bytes_written = mCache->writeBody(mID, mWriteData + TEXTURE_CACHE_ENTRY_SIZE, file_size);
 				if (bytes_written <= 0)
 				{
 					LL_WARNS() << "LLTextureCacheWorker: " << mID
@@ -799,9 +829,11 @@ LLTextureCache::LLTextureCache(bool threaded)
 	  mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
 	  mTexturesSizeTotal(0),
 	  mDoPurge(FALSE),
+	  mLegacyBodies(FALSE),
 	  mFastCachep(NULL),
 	  mFastCachePoolp(NULL),
-	  mFastCachePadBuffer(NULL)
+	  mFastCachePadBuffer(NULL),
+	  mFastMipSlotCount(0)
 {
     mHeaderAPRFilePoolp = new LLVolatileAPRPool(); // is_local = true, because this pool is for headers, headers are under own mutex
 }
@@ -872,6 +904,73 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 	return filename;
 }
 
+// Called by workers. The mapping covers every header record once it is open,
+// otherwise this falls back to reading texture.cache.
+S32 LLTextureCache::readHeaderData(S32 offset, U8* buffer, S32 size)
+{
+	{
+		LLMutexLock lock(&mHeaderDataMutex);
+		if (mHeaderDataMapping.isOpen() && (size_t)(offset + size) <= mHeaderDataMapping.getSize())
+		{
+			memcpy(buffer, mHeaderDataMapping.getData() + offset, size);
+			return size;
+		}
+	}
+	return LLAPRFile::readEx(mHeaderDataFileName, buffer, offset, size, getLocalAPRFilePool());
+}
+
+// Called by workers. A body file left from before the slabs were turned on is
+// moved into them the first time it is asked for.
+S32 LLTextureCache::getBodySize(const LLUUID& id)
+{
+	S32 size = 0;
+	if (mBodyPacks && (mBodyPacks->getSize(id, size) || !mLegacyBodies))
+	{
+		return size;
+	}
+
+	std::string filename = getTextureFileName(id);
+	size = LLAPRFile::size(filename, getLocalAPRFilePool());
+	if (mBodyPacks && size > 0 && !mReadOnly)
+	{
+		std::vector<U8> data(size);
+		if (LLAPRFile::readEx(filename, data.data(), 0, size, getLocalAPRFilePool()) == size
+			&& mBodyPacks->write(id, LLAssetType::AT_TEXTURE, 0, data.data(), size, true) == size)
+		{
+			LLAPRFile::remove(filename, getLocalAPRFilePool());
+		}
+	}
+	return size;
+}
+
+// Called by workers
+S32 LLTextureCache::readBody(const LLUUID& id, S32 offset, U8* buffer, S32 size)
+{
+	if (mBodyPacks)
+	{
+		S32 bytes_read = mBodyPacks->read(id, offset, buffer, size);
+		if (bytes_read || !mLegacyBodies)
+		{
+			return bytes_read;
+		}
+	}
+	return LLAPRFile::readEx(getTextureFileName(id), buffer, offset, size, getLocalAPRFilePool());
+}
+
+// Called by workers, replaces the whole body
+S32 LLTextureCache::writeBody(const LLUUID& id, U8* buffer, S32 size)
+{
+	if (mBodyPacks)
+	{
+		if (mLegacyBodies)
+		{
+			LLFile::remove(getTextureFileName(id), ENOENT);
+		}
+		return mBodyPacks->write(id, LLAssetType::AT_TEXTURE, 0, buffer, size, true);
+	}
+	return LLAPRFile::writeEx(getTextureFileName(id), buffer, 0, size, getLocalAPRFilePool());
+}
+
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id) 
 {
@@ -923,7 +1022,7 @@ BOOL LLTextureCache::isInLocal(const LLUUID& id)
 //////////////////////////////////////////////////////////////////////////////
 
 //static
-F32 LLTextureCache::sHeaderCacheVersion = 1.71f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.72f;
 U32 LLTextureCache::sCacheMaxEntries = 1024 * 1024; //~1 million textures.
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 std::string LLTextureCache::sHeaderCacheEncoderVersion = LLImageJ2C::getEngineInfo();
@@ -940,6 +1039,7 @@ const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
 const char* fast_cache_filename = "FastCache.cache";
+const char* fast_mip_cache_filename = "FastCacheMips.cache";
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
@@ -949,6 +1049,7 @@ void LLTextureCache::setDirNames(ELLPath location)
 	mHeaderDataFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, cache_filename);
 	mTexturesDirName = gDirUtilp->getExpandedFilename(location, textures_dirname);
 	mFastCacheFileName =  gDirUtilp->getExpandedFilename(location, textures_dirname, fast_cache_filename);
+	mFastMipFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, fast_mip_cache_filename);
 }
 
 void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
@@ -1032,15 +1133,100 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 			LLFile::mkdir(dirname);
 		}
 	}
+	openBodySlabs();
 	readHeaderCache();
 	purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+	mapHeaderData();
 
 	llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
 	openFastCache(true);
 
+	U64 fast_mip_bytes = (U64)gSavedSettings.getU32("TextureFastMipCacheMB") * 1024 * 1024;
+	mFastMipSlotCount = (U32)llmin(fast_mip_bytes / (TEXTURE_FAST_MIP_DATA_SIZE + sizeof(FastMipSlot)), (U64)sCacheMaxEntries);
+	{
+		LLMutexLock lock(&mFastCacheMutex);
+		openFastMipCache();
+	}
+
 	return max_size; // unused cache space
 }
 
+// Bodies go in a few large slab files, rather than a file per texture, when
+// TextureCacheUseSlabFiles is set. Body files already in the cache are moved
+// over as they are read. Turning the setting off again clears the cache, as
+// the entries would otherwise point at bodies nothing reads.
+void LLTextureCache::openBodySlabs()
+{
+	std::string filename;
+	bool have_slabs = LLDirIterator(mTexturesDirName, "*.pack").next(filename);
+	if (!gSavedSettings.getBOOL("TextureCacheUseSlabFiles"))
+	{
+		if (have_slabs && !mReadOnly)
+		{
+			LL_INFOS("TextureCache") << "Texture cache slab files turned off, clearing the cache" << LL_ENDL;
+			mBodyPacks = std::make_shared<LLDiskCachePacks>(mTexturesDirName, 0);
+			purgeAllTextures(false);
+			mBodyPacks.reset();
+		}
+		return;
+	}
+
+	// the entries purge keeps the bodies under sCacheMaxTexturesSize, the
+	// slabs only drop whole files if garbage gets well past that
+	mBodyPacks = std::make_shared<LLDiskCachePacks>(mTexturesDirName, (U64)sCacheMaxTexturesSize * 2);
+
+	bool legacy_bodies = false;
+	const char* subdirs = "0123456789abcdef";
+	for (S32 i = 0; i < 16 && !legacy_bodies; i++)
+	{
+		std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[i];
+		legacy_bodies = LLDirIterator(dirname, "*.texture").next(filename);
+	}
+	mLegacyBodies = legacy_bodies;
+	if (legacy_bodies)
+	{
+		LL_INFOS("TextureCache") << "Moving texture cache bodies into slab files as they are read" << LL_ENDL;
+	}
+}
+
+// Reclaim the space of bodies that were replaced or purged, on the general
+// thread pool. The slabs are shared so they outlive the cache if need be.
+void LLTextureCache::compactBodySlabs()
+{
+	if (!mBodyPacks || mReadOnly)
+	{
+		return;
+	}
+	std::shared_ptr<LLDiskCachePacks> packs = mBodyPacks;
+	LL::WorkQueue::postMaybe(LL::WorkQueue::getInstance("General"), [packs]()
+	{
+		packs->compact();
+	});
+}
+
+// With slab files texture.cache is grown to hold every entry up front and
+// mapped, so reading a header is a copy rather than an open and a seek.
+void LLTextureCache::mapHeaderData()
+{
+	LLMutexLock lock(&mHeaderDataMutex);
+	mHeaderDataMapping.close();
+	if (!mBodyPacks)
+	{
+		return;
+	}
+
+	S32 full_size = (S32)sCacheMaxEntries * TEXTURE_CACHE_ENTRY_SIZE;
+	if (!mReadOnly && LLAPRFile::size(mHeaderDataFileName, mHeaderAPRFilePoolp) < full_size)
+	{
+		U8 zero = 0;
+		LLAPRFile::writeEx(mHeaderDataFileName, &zero, full_size - 1, 1, mHeaderAPRFilePoolp);
+	}
+	if (!mHeaderDataMapping.open(mHeaderDataFileName))
+	{
+		LL_WARNS("TextureCache") << "Unable to map " << mHeaderDataFileName << ", reading headers from the file" << LL_ENDL;
+	}
+}
+
 //----------------------------------------------------------------------------
 // mHeaderMutex must be locked for the following functions!
 
@@ -1163,6 +1349,8 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 				entry.mID = id ;
 				entry.mImageSize = -1 ; //mark it is a brand-new entry.					
 				entry.mBodySize = 0 ;
+				entry.mAlphaClass = 0 ;
+				entry.mAlphaDiscard = -1 ;
 			}
 		}
 	}
@@ -1217,6 +1405,7 @@ void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool
 	{
 		aprfile = openHeaderEntriesFile(false, offset);
 	}
+	applyAlphaClass(entry);
 	bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
 	if(bytes_written != sizeof(Entry))
 	{
@@ -1261,11 +1450,24 @@ void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
 		if (!mReadOnly)
 		{
 			entry.mTime = time(NULL);			
+			applyAlphaClass(entry);
 			mUpdatedEntryMap[idx] = entry ;
 		}
 	}
 }
 
+//mHeaderMutex is locked before calling this.
+//carry a classification set since the entry was read into it.
+void LLTextureCache::applyAlphaClass(Entry& entry)
+{
+	alpha_class_map_t::iterator iter = mAlphaClassMap.find(entry.mID);
+	if (iter != mAlphaClassMap.end())
+	{
+		entry.mAlphaClass = iter->second.first;
+		entry.mAlphaDiscard = iter->second.second;
+	}
+}
+
 //update an existing entry, write to header file immediately.
 bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
 {
@@ -1326,6 +1528,7 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 	U32 num_entries = mHeaderEntriesInfo.mEntries;
 
 	mHeaderIDMap.clear();
+	mAlphaClassMap.clear();
 	mTexturesSizeMap.clear();
 	mFreeList.clear();
 	mTexturesSizeTotal = 0;
@@ -1363,6 +1566,10 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 			mHeaderIDMap[entry.mID] = idx;
 			mTexturesSizeMap[entry.mID] = entry.mBodySize;
 			mTexturesSizeTotal += entry.mBodySize;
+			if (entry.mAlphaClass)
+			{
+				mAlphaClassMap[entry.mID] = std::make_pair(entry.mAlphaClass, entry.mAlphaDiscard);
+			}
 		}
 		else
 		{
@@ -1569,6 +1776,7 @@ void LLTextureCache::clearCorruptedCache()
 			LLFile::mkdir(dirname);
 		}
 	}
+	mapHeaderData();
 
 	return ;
 }
@@ -1577,6 +1785,22 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
 	if (!mReadOnly)
 	{
+		{
+			// a mapped file can't be deleted on Windows
+			LLMutexLock lock(&mHeaderDataMutex);
+			mHeaderDataMapping.close();
+		}
+		if (mBodyPacks)
+		{
+			mBodyPacks->clear();
+		}
+		mLegacyBodies = FALSE;
+		{
+			LLMutexLock lock(&mFastCacheMutex);
+			mFastMipMapping.close();
+			mFastMipSlots.clear();
+		}
+
 		const char* subdirs = "0123456789abcdef";
 		std::string delem = gDirUtilp->getDirDelimiter();
 		std::string mask = "*";
@@ -1606,6 +1830,7 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 		}
 	}
 	mHeaderIDMap.clear();
+	mAlphaClassMap.clear();
 	mTexturesSizeMap.clear();
 	mTexturesSizeTotal = 0;
 	mFreeList.clear();
@@ -1701,6 +1926,10 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 				writeEntryToHeaderImmediately(idx, entry);
 			}
 		}
+		if (mPurgeEntryList.empty())
+		{
+			compactBodySlabs();
+		}
 	}
 }
 
@@ -1782,8 +2011,12 @@ void LLTextureCache::purgeTextures(bool validate)
 			{
 				std::string filename = getTextureFileName(entries[idx].mID);
 				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
-				// mHeaderAPRFilePoolp because this is under header mutex in main thread
-				S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
+				S32 bodysize = 0;
+				if (!mBodyPacks || !mBodyPacks->getSize(entries[idx].mID, bodysize))
+				{
+					// mHeaderAPRFilePoolp because this is under header mutex in main thread
+					bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
+				}
 				if (bodysize != entries[idx].mBodySize)
 				{
 					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << filename << LL_ENDL;
@@ -1809,6 +2042,7 @@ void LLTextureCache::purgeTextures(bool validate)
 	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
 
 	writeEntriesAndClose(entries);
+	compactBodySlabs();
 	
 	// *FIX:Mani - watchdog back on.
 	LLAppViewer::instance()->resumeMainloopTimeout();
@@ -1989,6 +2223,12 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
 //called in the main thread
 LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
 {
+	LLPointer<LLImageRaw> mip = readFromFastMipCache(id, discardlevel);
+	if (mip.notNull())
+	{
+		return mip;
+	}
+
 	U32 offset;
 	{
 		LLMutexLock lock(&mHeaderMutex);
@@ -2120,6 +2360,174 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
 	return true;
 }
 
+// The fast mip cache keeps a decoded mip of up to TEXTURE_FAST_MIP_DATA_SIZE
+// bytes (64x64 RGBA) for the last TextureFastMipCacheMB worth of textures
+// written to the cache, so a revisited scene shows correct if blurry colors
+// without a J2C decode. It is keyed by id rather than header entry, so the
+// mips outlive purged bodies. Slots are reused oldest first.
+// Called with mFastCacheMutex locked.
+void LLTextureCache::openFastMipCache()
+{
+	mFastMipSlots.clear();
+	mFastMipMapping.close();
+	if (!mFastMipSlotCount)
+	{
+		return;
+	}
+
+	size_t data_offset = fast_mip_data_offset(mFastMipSlotCount);
+	size_t file_size = data_offset + (size_t)mFastMipSlotCount * TEXTURE_FAST_MIP_DATA_SIZE;
+	bool opened = mReadOnly ? mFastMipMapping.open(mFastMipFileName) : mFastMipMapping.openWritable(mFastMipFileName, file_size);
+	if (!opened || mFastMipMapping.getSize() < file_size)
+	{
+		LL_WARNS("TextureCache") << "Unable to map " << mFastMipFileName << ", fast mip cache disabled" << LL_ENDL;
+		mFastMipMapping.close();
+		mFastMipSlotCount = 0;
+		return;
+	}
+
+	const FastMipHeader* header = (const FastMipHeader*)mFastMipMapping.getData();
+	if (header->mMagic != TEXTURE_FAST_MIP_MAGIC || header->mVersion != TEXTURE_FAST_MIP_VERSION || header->mSlots != mFastMipSlotCount)
+	{
+		// new, or sized for a different number of slots: start over
+		U8* data = mFastMipMapping.getWritableData();
+		if (!data)
+		{
+			mFastMipMapping.close();
+			return;
+		}
+		memset(data, 0, data_offset);
+		FastMipHeader* new_header = (FastMipHeader*)data;
+		new_header->mMagic = TEXTURE_FAST_MIP_MAGIC;
+		new_header->mVersion = TEXTURE_FAST_MIP_VERSION;
+		new_header->mSlots = mFastMipSlotCount;
+		return;
+	}
+
+	const FastMipSlot* slots = (const FastMipSlot*)(mFastMipMapping.getData() + sizeof(FastMipHeader));
+	for (U32 i = 0; i < mFastMipSlotCount; ++i)
+	{
+		if (slots[i].mComponents > 0)
+		{
+			LLUUID id;
+			memcpy(id.mData, slots[i].mID, UUID_BYTES);
+			mFastMipSlots[id] = i;
+		}
+	}
+	LL_INFOS("TextureCache") << "Fast mip cache: " << mFastMipSlots.size() << " / " << mFastMipSlotCount << " mips" << LL_ENDL;
+}
+
+//called in the main thread
+LLPointer<LLImageRaw> LLTextureCache::readFromFastMipCache(const LLUUID& id, S32& discardlevel)
+{
+	LLMutexLock lock(&mFastCacheMutex);
+	id_map_t::const_iterator iter = mFastMipSlots.find(id);
+	if (iter == mFastMipSlots.end() || !mFastMipMapping.isOpen())
+	{
+		return NULL;
+	}
+
+	const U8* base = mFastMipMapping.getData();
+	const FastMipSlot& slot = ((const FastMipSlot*)(base + sizeof(FastMipHeader)))[iter->second];
+	S32 image_size = slot.mWidth * slot.mHeight * slot.mComponents;
+	if (image_size <= 0 || image_size > TEXTURE_FAST_MIP_DATA_SIZE || slot.mDiscardLevel < 0)
+	{
+		return NULL;
+	}
+
+	discardlevel = slot.mDiscardLevel;
+	const U8* data = base + fast_mip_data_offset(mFastMipSlotCount) + (size_t)iter->second * TEXTURE_FAST_MIP_DATA_SIZE;
+	return new LLImageRaw(data, slot.mWidth, slot.mHeight, slot.mComponents);
+}
+
+// Called by workers. Keeps the mip already stored for id unless raw is sharper.
+void LLTextureCache::writeToFastMipCache(const LLUUID& id, LLPointer<LLImageRaw> raw, S32 discardlevel)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+	if (mReadOnly || !mFastMipSlotCount || raw.isNull() || raw->isBufferInvalid() || !raw->getData())
+	{
+		return;
+	}
+
+	S32 w = raw->getWidth();
+	S32 h = raw->getHeight();
+	S32 c = raw->getComponents();
+	S32 i = 0;
+	while (((w >> i) * (h >> i) * c) > TEXTURE_FAST_MIP_DATA_SIZE)
+	{
+		++i;
+	}
+	w >>= i;
+	h >>= i;
+	if (w * h * c <= 0)
+	{
+		return;
+	}
+
+	{
+		LLMutexLock lock(&mFastCacheMutex);
+		id_map_t::const_iterator iter = mFastMipSlots.find(id);
+		if (iter != mFastMipSlots.end()
+			&& ((const FastMipSlot*)(mFastMipMapping.getData() + sizeof(FastMipHeader)))[iter->second].mDiscardLevel <= discardlevel + i)
+		{
+			return;
+		}
+	}
+
+	if (i)
+	{
+		// Make a duplicate to keep the original raw image untouched.
+		raw = raw->duplicate();
+		if (raw->isBufferInvalid())
+		{
+			return;
+		}
+		raw->scale(w, h);
+	}
+
+	LLMutexLock lock(&mFastCacheMutex);
+	if (!mFastMipMapping.isOpen())
+	{
+		// reopened after the cache was cleared
+		openFastMipCache();
+	}
+	U8* base = mFastMipMapping.getWritableData();
+	if (!base)
+	{
+		return;
+	}
+
+	FastMipHeader* header = (FastMipHeader*)base;
+	FastMipSlot* slots = (FastMipSlot*)(base + sizeof(FastMipHeader));
+	S32 slot;
+	id_map_t::iterator iter = mFastMipSlots.find(id);
+	if (iter != mFastMipSlots.end())
+	{
+		slot = iter->second;
+	}
+	else
+	{
+		slot = header->mNextSlot % mFastMipSlotCount;
+		header->mNextSlot = (slot + 1) % mFastMipSlotCount;
+		if (slots[slot].mComponents > 0)
+		{
+			LLUUID old_id;
+			memcpy(old_id.mData, slots[slot].mID, UUID_BYTES);
+			mFastMipSlots.erase(old_id);
+		}
+		mFastMipSlots[id] = slot;
+	}
+
+	// the slot reads as empty until the new mip is all there
+	slots[slot].mComponents = 0;
+	memcpy(base + fast_mip_data_offset(mFastMipSlotCount) + (size_t)slot * TEXTURE_FAST_MIP_DATA_SIZE, raw->getData(), w * h * c);
+	memcpy(slots[slot].mID, id.mData, UUID_BYTES);
+	slots[slot].mWidth = w;
+	slots[slot].mHeight = h;
+	slots[slot].mDiscardLevel = discardlevel + i;
+	slots[slot].mComponents = c;
+}
+
 void LLTextureCache::openFastCache(bool first_time)
 {
 	if(!mFastCachep)
@@ -2214,6 +2622,15 @@ void LLTextureCache::removeCachedTexture(const LLUUID& id)
 		mTexturesSizeMap.erase(id);
 	}
 	mHeaderIDMap.erase(id);
+	mAlphaClassMap.erase(id);
+	if (mBodyPacks)
+	{
+		mBodyPacks->remove(id);
+		if (!mLegacyBodies)
+		{
+			return;
+		}
+	}
 	// We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
 	// but getLocalAPRFilePool() is not safe, it might be in use by worker
 	LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
@@ -2224,9 +2641,16 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 {
  	bool file_maybe_exists = true;	// Always attempt to remove when idx is invalid.
 
+	if (idx >= 0 && mBodyPacks)
+	{
+		// only body files from before the slabs were turned on are left to remove
+		mBodyPacks->remove(entry.mID);
+		file_maybe_exists = mLegacyBodies;
+	}
+
 	if(idx >= 0) //valid entry
 	{
-		if (entry.mBodySize == 0)	// Always attempt to remove when mBodySize > 0.
+		if (file_maybe_exists && entry.mBodySize == 0)	// Always attempt to remove when mBodySize > 0.
 		{
 		  // Sanity check. Shouldn't exist when body size is 0.
 		  // We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
@@ -2245,6 +2669,7 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 		entry.mImageSize = -1;
 		entry.mBodySize = 0;
 		mHeaderIDMap.erase(entry.mID);
+		mAlphaClassMap.erase(entry.mID);
 		mTexturesSizeMap.erase(entry.mID);		
 		mFreeList.insert(idx);	
 	}
@@ -2278,6 +2703,62 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 	return ret ;
 }
 
+bool LLTextureCache::getAlphaClass(const LLUUID& id, U8& alpha_class, S32& discard_level)
+{
+	bool ret = false;
+	lockHeaders();
+	alpha_class_map_t::iterator iter = mAlphaClassMap.find(id);
+	if (iter != mAlphaClassMap.end())
+	{
+		alpha_class = (U8)iter->second.first;
+		discard_level = iter->second.second;
+		ret = true;
+	}
+	unlockHeaders();
+	return ret;
+}
+
+void LLTextureCache::setAlphaClass(const LLUUID& id, U8 alpha_class, S32 discard_level)
+{
+	if (mReadOnly || !alpha_class || discard_level < 0)
+	{
+		return;
+	}
+
+	lockHeaders();
+	id_map_t::iterator iter = mHeaderIDMap.find(id);
+	if (iter != mHeaderIDMap.end())
+	{
+		alpha_class_map_t::iterator class_iter = mAlphaClassMap.find(id);
+		// keep the analysis made at the highest resolution
+		if (class_iter == mAlphaClassMap.end() ||
+			discard_level < class_iter->second.second ||
+			(discard_level == class_iter->second.second && alpha_class != class_iter->second.first))
+		{
+			mAlphaClassMap[id] = std::make_pair((S16)alpha_class, (S16)discard_level);
+
+			// written with the other delayed entry updates
+			S32 idx = iter->second;
+			Entry entry;
+			idx_entry_map_t::iterator entry_iter = mUpdatedEntryMap.find(idx);
+			if (entry_iter != mUpdatedEntryMap.end())
+			{
+				entry = entry_iter->second;
+			}
+			else
+			{
+				readEntryFromHeaderImmediately(idx, entry);
+			}
+			if (idx >= 0 && entry.mID == id)
+			{
+				applyAlphaClass(entry);
+				mUpdatedEntryMap[idx] = entry;
+			}
+		}
+	}
+	unlockHeaders();
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 LLTextureCache::ReadResponder::ReadResponder()
@@ -28,6 +28,8 @@
 #define LL_LLTEXTURECACHE_H
 
 #include "lldir.h"
+#include "lldiskcachepacks.h"
+#include "llfile.h"
 #include "llstl.h"
 #include "llstring.h"
 #include "lluuid.h"
@@ -65,17 +67,21 @@ private:
         	Entry() :
 		        mBodySize(0),
 			mImageSize(0),
-			mTime(0)
+			mTime(0),
+			mAlphaClass(0),
+			mAlphaDiscard(-1)
 		{
 		}
 		Entry(const LLUUID& id, S32 imagesize, S32 bodysize, U32 time) :
-			mID(id), mImageSize(imagesize), mBodySize(bodysize), mTime(time) {}
-		void init(const LLUUID& id, U32 time) { mID = id, mImageSize = 0; mBodySize = 0; mTime = time; }
-		Entry& operator=(const Entry& entry) {mID = entry.mID, mImageSize = entry.mImageSize; mBodySize = entry.mBodySize; mTime = entry.mTime; return *this;}
+			mID(id), mImageSize(imagesize), mBodySize(bodysize), mTime(time), mAlphaClass(0), mAlphaDiscard(-1) {}
+		void init(const LLUUID& id, U32 time) { mID = id, mImageSize = 0; mBodySize = 0; mTime = time; mAlphaClass = 0; mAlphaDiscard = -1; }
+		Entry& operator=(const Entry& entry) {mID = entry.mID, mImageSize = entry.mImageSize; mBodySize = entry.mBodySize; mTime = entry.mTime; mAlphaClass = entry.mAlphaClass; mAlphaDiscard = entry.mAlphaDiscard; return *this;}
 		LLUUID mID; // 16 bytes
 		S32 mImageSize; // total size of image if known
 		S32 mBodySize; // size of body file in body cache
 		U32 mTime; // seconds since 1/1/1970
+		S16 mAlphaClass; // LLImageGL::EAlphaClass of the image, 0 if not analyzed yet
+		S16 mAlphaDiscard; // discard level mAlphaClass was analyzed at
 	};
 
 #if LL_WINDOWS
@@ -128,11 +134,17 @@ public:
 	handle_t writeToCache(const LLUUID& id, U8* data, S32 datasize, S32 imagesize, LLPointer<LLImageRaw> rawimage, S32 discardlevel,
 						  WriteResponder* responder);
 	LLPointer<LLImageRaw> readFromFastCache(const LLUUID& id, S32& discardlevel);
+	void writeToFastMipCache(const LLUUID& id, LLPointer<LLImageRaw> raw, S32 discardlevel);
 	bool writeComplete(handle_t handle, bool abort = false);
 	void prioritizeWrite(handle_t handle);
 
 	bool removeFromCache(const LLUUID& id);
 
+	// Alpha mask classification of a cached texture and the discard level it was
+	// analyzed at. Kept with the header entry so it is not redone on the next load.
+	bool getAlphaClass(const LLUUID& id, U8& alpha_class, S32& discard_level);
+	void setAlphaClass(const LLUUID& id, U8 alpha_class, S32 discard_level);
+
 	// For LLTextureCacheWorker::Responder
 	LLTextureCacheWorker* getReader(handle_t handle);
 	LLTextureCacheWorker* getWriter(handle_t handle);
@@ -154,6 +166,10 @@ protected:
 	std::string getLocalFileName(const LLUUID& id);
 	std::string getTextureFileName(const LLUUID& id);
 	void addCompleted(Responder* responder, bool success);
+	S32 readHeaderData(S32 offset, U8* buffer, S32 size);
+	S32 getBodySize(const LLUUID& id);
+	S32 readBody(const LLUUID& id, S32 offset, U8* buffer, S32 size);
+	S32 writeBody(const LLUUID& id, U8* buffer, S32 size);
 	
 protected:
 	//void setFileAPRPool(apr_pool_t* pool) { mFileAPRPool = pool ; }
@@ -165,6 +181,9 @@ private:
 	void purgeAllTextures(bool purge_directories);
 	void purgeTexturesLazy(F32 time_limit_sec);
 	void purgeTextures(bool validate);
+	void openBodySlabs();
+	void compactBodySlabs();
+	void mapHeaderData();
 	LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
 	void closeHeaderEntriesFile();
 	void readEntriesHeader();
@@ -173,6 +192,7 @@ private:
 	S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
 	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
 	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
+	void applyAlphaClass(Entry& entry);
 	U32 openAndReadEntries(std::vector<Entry>& entries);
 	void writeEntriesAndClose(const std::vector<Entry>& entries);
 	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
@@ -189,6 +209,8 @@ private:
 	void openFastCache(bool first_time = false);
 	void closeFastCache(bool forced = false);
 	bool writeToFastCache(LLUUID image_id, S32 cache_id, LLPointer<LLImageRaw> raw, S32 discardlevel);	
+	void openFastMipCache();
+	LLPointer<LLImageRaw> readFromFastMipCache(const LLUUID& id, S32& discardlevel);
 
 private:
 	// Internal
@@ -225,17 +247,31 @@ private:
 	std::set<LLUUID> mLRU;
 	typedef std::map<LLUUID, S32> id_map_t;
 	id_map_t mHeaderIDMap;
+	typedef std::map<LLUUID, std::pair<S16, S16> > alpha_class_map_t;
+	alpha_class_map_t mAlphaClassMap; // alpha class and discard level by id
+
+	LLMutex mHeaderDataMutex;
+	LLMappedFile mHeaderDataMapping; // texture.cache, mapped when the bodies are in slab files
 
 	LLAPRFile*   mFastCachep;
 	LLFrameTimer mFastCacheTimer;
 	U8*          mFastCachePadBuffer;
 
+	// FAST MIPS (decoded low resolution mips by id, see openFastMipCache())
+	std::string  mFastMipFileName;
+	LLMappedFile mFastMipMapping;
+	id_map_t     mFastMipSlots; // slot of each texture in the mip file
+	U32          mFastMipSlotCount;
+
 	// BODIES (TEXTURES minus headers)
 	std::string mTexturesDirName;
 	typedef std::map<LLUUID,S32> size_map_t;
 	size_map_t mTexturesSizeMap;
 	S64 mTexturesSizeTotal;
 	LLAtomicBool mDoPurge;
+	// slab files holding the bodies, null when each body has a file of its own
+	std::shared_ptr<LLDiskCachePacks> mBodyPacks;
+	LLAtomicBool mLegacyBodies; // body files from before the slabs were turned on are still around
 
 	typedef std::map<S32, Entry> idx_entry_map_t;
 	idx_entry_map_t mUpdatedEntryMap;
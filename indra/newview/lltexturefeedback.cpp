@@ -0,0 +1,247 @@
+/**
+ * @file lltexturefeedback.cpp
+ * @brief LLTextureFeedback class implementation
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturefeedback.h"
+#include "llappviewer.h"
+#include "lldrawpool.h"
+#include "llspatialpartition.h"
+#include "llviewershadermgr.h"
+#include "llviewertexture.h"
+#include "pipeline.h"
+
+// render the feedback every this many frames
+static const U32 RENDER_PERIOD = 4;
+
+// measurements older than this many frames no longer describe the view
+static const U32 MAX_FEEDBACK_AGE = 12;
+
+// ids are stored in two 8 bit channels, 0 is nothing drawn
+static const U32 MAX_TEXTURES = 65535;
+
+// opaque passes drawn with their diffuse texture in LLDrawInfo::mTexture
+static const U32 sFeedbackPasses[] =
+{
+    LLRenderPass::PASS_SIMPLE,
+    LLRenderPass::PASS_FULLBRIGHT,
+    LLRenderPass::PASS_SHINY,
+    LLRenderPass::PASS_FULLBRIGHT_SHINY,
+    LLRenderPass::PASS_BUMP,
+    LLRenderPass::PASS_MATERIAL,
+    LLRenderPass::PASS_MATERIAL_ALPHA_MASK,
+    LLRenderPass::PASS_MATERIAL_ALPHA_EMISSIVE,
+    LLRenderPass::PASS_SPECMAP,
+    LLRenderPass::PASS_SPECMAP_MASK,
+    LLRenderPass::PASS_SPECMAP_EMISSIVE,
+    LLRenderPass::PASS_NORMMAP,
+    LLRenderPass::PASS_NORMMAP_MASK,
+    LLRenderPass::PASS_NORMMAP_EMISSIVE,
+    LLRenderPass::PASS_NORMSPEC,
+    LLRenderPass::PASS_NORMSPEC_MASK,
+    LLRenderPass::PASS_NORMSPEC_EMISSIVE,
+    LLRenderPass::PASS_ALPHA_MASK,
+    LLRenderPass::PASS_FULLBRIGHT_ALPHA_MASK,
+};
+
+void LLTextureFeedback::render(LLCullResult* cull, U32 screen_width, U32 screen_height)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+    LL_PROFILE_GPU_ZONE("texture feedback");
+
+    if (gFrameCount - mLastRenderFrame < RENDER_PERIOD || mReadback.isFull())
+    { // the GPU is NUM_READBACKS renders behind, skip rather than stall
+        return;
+    }
+
+    U32 width = llmax(screen_width / DIVISOR, 1U);
+    U32 height = llmax(screen_height / DIVISOR, 1U);
+
+    if (mTarget.getWidth() != width || mTarget.getHeight() != height)
+    {
+        mTarget.release();
+        if (!mTarget.allocate(width, height, GL_RGBA8, true))
+        {
+            return;
+        }
+    }
+
+    mLastRenderFrame = gFrameCount;
+
+    std::vector<LLPointer<LLViewerFetchedTexture> > textures;
+    std::unordered_map<LLViewerFetchedTexture*, U32> ids;
+
+    mTarget.bindTarget();
+    mTarget.clear();
+    {
+        LLGLDepthTest depth(GL_TRUE, GL_TRUE);
+        LLGLDisable blend(GL_BLEND);
+
+        gGL.matrixMode(LLRender::MM_PROJECTION);
+        gGL.pushMatrix();
+        gGL.loadMatrix(gGLProjection);
+        gGL.matrixMode(LLRender::MM_MODELVIEW);
+        gGL.pushMatrix();
+        gGL.loadMatrix(gGLModelView);
+        gGLLastMatrix = NULL;
+
+        static LLStaticHashedString sFeedbackID("feedback_id");
+
+        gTextureFeedbackProgram.bind();
+
+        for (LLCullResult::sg_iterator iter = cull->beginVisibleGroups(); iter != cull->endVisibleGroups(); ++iter)
+        {
+            LLSpatialGroup* group = *iter;
+            if (group->isDead() ||
+                (LLPipeline::sUseOcclusion && group->isOcclusionState(LLSpatialGroup::OCCLUDED)))
+            {
+                continue;
+            }
+
+            for (U32 pass : sFeedbackPasses)
+            {
+                LLSpatialGroup::draw_map_t::iterator draw = group->mDrawMap.find(pass);
+                if (draw == group->mDrawMap.end())
+                {
+                    continue;
+                }
+
+                for (LLDrawInfo* params : draw->second)
+                {
+                    LLViewerFetchedTexture* tex = LLViewerTextureManager::staticCastToFetchedTexture(params->mTexture);
+                    if (!tex || !params->mCount || params->mAvatar.notNull())
+                    {
+                        continue;
+                    }
+
+                    U32 id;
+                    auto found = ids.find(tex);
+                    if (found != ids.end())
+                    {
+                        id = found->second;
+                    }
+                    else if (textures.size() < MAX_TEXTURES)
+                    {
+                        textures.push_back(tex);
+                        id = (U32)textures.size();
+                        ids[tex] = id;
+                    }
+                    else
+                    {
+                        continue;
+                    }
+
+                    gTextureFeedbackProgram.uniform2f(sFeedbackID, (id & 0xFF) / 255.f, (id >> 8) / 255.f);
+
+                    LLRenderPass::applyModelMatrix(*params);
+                    params->mVertexBuffer->setBuffer();
+                    params->mVertexBuffer->drawRange(LLRender::TRIANGLES, params->mStart, params->mEnd, params->mCount, params->mOffset);
+                }
+            }
+        }
+
+        gTextureFeedbackProgram.unbind();
+
+        gGL.matrixMode(LLRender::MM_PROJECTION);
+        gGL.popMatrix();
+        gGL.matrixMode(LLRender::MM_MODELVIEW);
+        gGL.popMatrix();
+        gGLLastMatrix = NULL;
+    }
+
+    S32 slot = mReadback.read(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+    mTarget.flush();
+    if (slot < 0)
+    {
+        return;
+    }
+
+    mReadbackTextures[slot].swap(textures);
+    mReadbackFrame[slot] = gFrameCount;
+}
+
+void LLTextureFeedback::update()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    // oldest first so the newest finished readback wins
+    mReadback.poll([this](S32 slot, const U8* data, U32 width, U32 height)
+        {
+            processReadback(slot, data, width, height);
+        });
+}
+
+void LLTextureFeedback::processReadback(S32 slot, const U8* data, U32 width, U32 height)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    std::vector<LLPointer<LLViewerFetchedTexture> >& textures = mReadbackTextures[slot];
+    mNeeded.assign(textures.size() + 1, 0);
+
+    const U8* end = data + width * height * 4;
+    for (const U8* pixel = data; pixel < end; pixel += 4)
+    {
+        U32 id = pixel[0] | (pixel[1] << 8);
+        if (id && id < mNeeded.size())
+        {
+            mNeeded[id] = llmax(mNeeded[id], (U16)(pixel[2] + 1));
+        }
+    }
+
+    U32 frame = mReadbackFrame[slot];
+    for (U32 id = 1; id < mNeeded.size(); ++id)
+    {
+        if (mNeeded[id])
+        {
+            // blue is log2 of the texels per side over 16, the virtual size is texels
+            F32 res = (mNeeded[id] - 1) * 16.f / 255.f;
+            LLViewerFetchedTexture* tex = textures[id - 1];
+            tex->mFeedbackVirtualSize = exp2f(res * 2.f);
+            tex->mFeedbackFrame = frame;
+        }
+    }
+
+    textures.clear();
+    mFrame = frame;
+}
+
+bool LLTextureFeedback::isMeasured(const LLViewerFetchedTexture* tex) const
+{
+    return mFrame && tex->mFeedbackFrame == mFrame && gFrameCount - mFrame <= MAX_FEEDBACK_AGE;
+}
+
+void LLTextureFeedback::release()
+{
+    mReadback.release();
+
+    mTarget.release();
+    for (U32 i = 0; i < NUM_READBACKS; ++i)
+    {
+        mReadbackTextures[i].clear();
+    }
+    mNeeded.clear();
+    mFrame = 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file lltexturefeedback.h
+ * @brief Measures the texture resolution visible faces need on the GPU
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#pragma once
+
+#include "llglreadback.h"
+#include "llpointer.h"
+#include "llrendertarget.h"
+
+#include <vector>
+
+class LLCullResult;
+class LLViewerFetchedTexture;
+
+// Every few frames the opaque groups of the main camera are drawn again into
+// a small target that stores, per pixel, which diffuse texture is visible
+// there and how many texels per side it needs for one texel per screen pixel
+// (from the texture coordinate derivatives, so UV density, repeats and
+// occlusion are all accounted for).  The target is read back asynchronously,
+// and when it lands each texture that was seen gets the largest size measured
+// for it.  LLViewerTextureList uses that in place of estimating the size from
+// the pixel area of every face of the texture.
+class LLTextureFeedback
+{
+public:
+    // the target is this many times smaller than the screen on each side,
+    // must match FEEDBACK_SCALE in textureFeedbackF.glsl
+    static const U32 DIVISOR = 8;
+
+    // draw the opaque groups of cull into the feedback target and start
+    // reading it back, every few frames.  Expects the main camera matrices.
+    void render(LLCullResult* cull, U32 screen_width, U32 screen_height);
+
+    // pick up finished readbacks and hand the sizes to their textures
+    void update();
+
+    // true if the texture was seen by the newest feedback that is still recent
+    bool isMeasured(const LLViewerFetchedTexture* tex) const;
+
+    // release any GL state
+    void release();
+
+private:
+    void processReadback(S32 slot, const U8* data, U32 width, U32 height);
+
+    static const U32 NUM_READBACKS = 3;
+
+    LLRenderTarget mTarget;
+    LLGLReadback mReadback { NUM_READBACKS };
+    // textures drawn for each readback slot, a pixel's id is its index + 1
+    std::vector<LLPointer<LLViewerFetchedTexture> > mReadbackTextures[NUM_READBACKS];
+    U32 mReadbackFrame[NUM_READBACKS];
+
+    // 1 + largest needed resolution seen per id while processing a readback,
+    // 0 if the id wasn't seen
+    std::vector<U16> mNeeded;
+
+    // frame of the newest feedback handed to the textures
+    U32 mFrame = 0;
+    U32 mLastRenderFrame = 0;
+};
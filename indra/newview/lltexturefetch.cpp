@@ -27,7 +27,9 @@
 #include "llviewerprecompiledheaders.h"
 
 #include <iostream>
+#include <list>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 
 #include "lltexturefetch.h"
@@ -53,6 +55,7 @@
 #include "llsdparam.h"
 #include "llsdutil.h"
 #include "llstartup.h"
+#include "llstreamingpriority.h"
 
 #include "httprequest.h"
 #include "httphandler.h"
@@ -71,6 +74,13 @@ LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexDecodeLatency("texture
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheWriteLatency("texture_write_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFetchLatency("texture_fetch_latency");
 
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sStateCacheReadLatency("texture_state_cache_read_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sStateCachePostLatency("texture_state_cache_post_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sStateHttpSendLatency("texture_state_http_send_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sStateHttpWaitLatency("texture_state_http_wait_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sStateDecodeLatency("texture_state_decode_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sStateCacheWriteLatency("texture_state_cache_write_latency");
+
 LLTextureFetchTester* LLTextureFetch::sTesterp = NULL ;
 const std::string sTesterName("TextureFetchTester");
 
@@ -156,6 +166,8 @@ const std::string sTesterName("TextureFetchTester");
 // 6.  Mwc      Mutex covering LLWorkerClass's members (base class of
 //              LLTextureFetchWorker).  One per request.
 // 7.  Mw       LLTextureFetchWorker's mutex.  One per request.
+// 8.  Mtr      LLTextureFetch's mutex covering the trace file, taken
+//              last and only by recordStateTime().
 //
 //
 // Lock Ordering Rules
@@ -495,12 +507,15 @@ private:
 	bool acquireHttpSemaphore()
 		{
 			llassert(! mHttpHasResource);
-			if (mFetcher->mHttpSemaphore >= mFetcher->mHttpHighWater)
+			if (mFetcher->mHttpSemaphore >= mFetcher->mHttpHighWater || !LLStreamingPriority::hasBudget())
 			{
 				return false;
 			}
 			mHttpHasResource = true;
 			mFetcher->mHttpSemaphore++;
+			mHttpReservedBytes = llmax(mDesiredSize, 0);
+			LLStreamingPriority::addInFlight(LLStreamingPriority::STREAM_TEXTURE, mHttpReservedBytes);
+			LLStreamingPriority::noteIssued(LLStreamingPriority::STREAM_TEXTURE, mImagePriority);
 			return true;
 		}
 
@@ -512,6 +527,8 @@ private:
 			mHttpHasResource = false;
 			mFetcher->mHttpSemaphore--;
 			llassert_always(mFetcher->mHttpSemaphore >= 0);
+			LLStreamingPriority::removeInFlight(LLStreamingPriority::STREAM_TEXTURE, mHttpReservedBytes);
+			mHttpReservedBytes = 0;
 		}
 	
 private:
@@ -549,6 +566,8 @@ private:
 	S32 mRequestedDiscard;
     S32 mLoadedDiscard;
     S32 mDecodedDiscard;
+	S32 mDecodeRequestDiscard;	// discard passed to the decoder
+	bool mDecodedFromCache;		// decode was satisfied by LLTextureFetch::DecodedCache
 	LLFrameTimer mRequestedDeltaTimer;
 	LLFrameTimer mFetchDeltaTimer;
 	LLTimer mCacheReadTimer;
@@ -618,6 +637,7 @@ private:
 	U32						mHttpReplySize,				// Actual received data size
 							mHttpReplyOffset;			// Actual received data offset
 	bool					mHttpHasResource;			// Counts against Fetcher's mHttpSemaphore
+	S32						mHttpReservedBytes;			// Counts against LLStreamingPriority's budget while mHttpHasResource
 
 	// State history
 	U32						mCacheReadCount,
@@ -627,6 +647,140 @@ private:
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Recently decoded images, so a texture that is fetched again from the
+// same data (it was dropped while off screen and came back into view,
+// typically while the camera pans) doesn't go through the decoder again.
+//
+// Neither OpenJPEG nor KDU (as we use it) can resume a decode when the
+// codestream grows, so only identical decodes are reused: same texture,
+// same number of bytes and same discard level. Entries are dropped once
+// they are older than TextureDecodeCacheTime or to keep the cache under
+// TextureDecodeCacheSize.
+class LLTextureFetch::DecodedCache
+{
+public:
+	// Threads:  T*
+	bool find(const LLUUID& id, S32 data_size, S32 discard, bool needs_aux,
+			  LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux, S32& decoded_discard)
+	{
+		LLMutexLock lock(&mMutex);
+		expire();
+
+		entry_map_t::iterator iter = mEntries.find(id);
+		if (iter == mEntries.end())
+		{
+			return false;
+		}
+		Entry& entry = iter->second;
+		if (entry.mDataSize != data_size || entry.mDiscard != discard || (needs_aux && entry.mAux.isNull()))
+		{
+			return false;
+		}
+
+		// the fetch owner may modify what it is given, hand out copies
+		raw = copyImage(entry.mRaw);
+		aux = needs_aux ? copyImage(entry.mAux) : LLPointer<LLImageRaw>();
+		decoded_discard = entry.mDecodedDiscard;
+		entry.mTime = LLTimer::getTotalSeconds();
+		mLRU.splice(mLRU.end(), mLRU, entry.mLRUIter);
+		++mHits;
+		return true;
+	}
+
+	// Threads:  T*
+	void insert(const LLUUID& id, S32 data_size, S32 discard, S32 decoded_discard,
+				LLImageRaw* raw, LLImageRaw* aux)
+	{
+		static LLCachedControl<U32> max_size_mb(gSavedSettings, "TextureDecodeCacheSize", 64);
+		S64 max_bytes = (S64)max_size_mb * 1024 * 1024;
+		S64 bytes = (S64)raw->getDataSize() + (aux ? (S64)aux->getDataSize() : 0);
+		if (bytes > max_bytes / 4)
+		{
+			// big images would flush everything else
+			return;
+		}
+
+		LLMutexLock lock(&mMutex);
+		expire();
+		erase(id);
+
+		Entry& entry = mEntries[id];
+		entry.mRaw = copyImage(raw);
+		entry.mAux = aux ? copyImage(aux) : LLPointer<LLImageRaw>();
+		entry.mDataSize = data_size;
+		entry.mDiscard = discard;
+		entry.mDecodedDiscard = decoded_discard;
+		entry.mBytes = bytes;
+		entry.mTime = LLTimer::getTotalSeconds();
+		entry.mLRUIter = mLRU.insert(mLRU.end(), id);
+		mBytes += bytes;
+
+		while (mBytes > max_bytes && !mLRU.empty())
+		{
+			erase(mLRU.front());
+		}
+	}
+
+	// Threads:  T*
+	void getStats(U32& entries, S64& bytes, U32& hits)
+	{
+		LLMutexLock lock(&mMutex);
+		entries = (U32)mEntries.size();
+		bytes = mBytes;
+		hits = mHits;
+	}
+
+private:
+	struct Entry
+	{
+		LLPointer<LLImageRaw> mRaw;
+		LLPointer<LLImageRaw> mAux;
+		S32 mDataSize;
+		S32 mDiscard;			// discard the decode was asked for
+		S32 mDecodedDiscard;	// discard it produced
+		S64 mBytes;
+		F64 mTime;
+		std::list<LLUUID>::iterator mLRUIter;
+	};
+	typedef std::unordered_map<LLUUID, Entry> entry_map_t;
+
+	static LLPointer<LLImageRaw> copyImage(LLImageRaw* image)
+	{
+		return new LLImageRaw(image->getData(), image->getWidth(), image->getHeight(), image->getComponents());
+	}
+
+	// must be called with mMutex locked
+	void erase(const LLUUID& id)
+	{
+		entry_map_t::iterator iter = mEntries.find(id);
+		if (iter != mEntries.end())
+		{
+			mBytes -= iter->second.mBytes;
+			mLRU.erase(iter->second.mLRUIter);
+			mEntries.erase(iter);
+		}
+	}
+
+	// must be called with mMutex locked
+	void expire()
+	{
+		static LLCachedControl<F32> max_age(gSavedSettings, "TextureDecodeCacheTime", 30.f);
+		F64 oldest = LLTimer::getTotalSeconds() - (F64)max_age;
+		while (!mLRU.empty() && mEntries.find(mLRU.front())->second.mTime < oldest)
+		{
+			erase(mLRU.front());
+		}
+	}
+
+	LLMutex mMutex;
+	entry_map_t mEntries;
+	std::list<LLUUID> mLRU;		// least recently used first
+	S64 mBytes = 0;
+	U32 mHits = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
 // Cross-thread messaging for asset metrics.
 
 /**
@@ -897,6 +1051,8 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mRequestedDiscard(-1),
 	  mLoadedDiscard(-1),
 	  mDecodedDiscard(-1),
+	  mDecodeRequestDiscard(-1),
+	  mDecodedFromCache(false),
 	  mCacheReadTime(0.f),
 	  mCacheWriteTime(0.f),
 	  mDecodeTime(0.f),
@@ -934,6 +1090,7 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mHttpReplySize(0U),
 	  mHttpReplyOffset(0U),
 	  mHttpHasResource(false),
+	  mHttpReservedBytes(0),
 	  mCacheReadCount(0U),
 	  mCacheWriteCount(0U),
 	  mResourceWaitCount(0U),
@@ -1038,6 +1195,11 @@ void LLTextureFetchWorker::setDesiredDiscard(S32 discard, S32 size)
 void LLTextureFetchWorker::setImagePriority(F32 priority)
 {
 	mImagePriority = priority; //should map to max virtual size, abort if zero
+	if (mDecodeHandle != 0)
+	{
+		// move a decode that is still queued along with the texture
+		LLAppViewer::getImageDecodeThread()->setPriority(mDecodeHandle, priority);
+	}
 }
 
 // Locks:  Mw
@@ -1679,7 +1841,21 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				mRequestedOffset += src_offset;
 			}
 
-			U8 * buffer = (U8 *)ll_aligned_malloc_16(total_size);
+			// A body received whole into a single block can become the
+			// image data as is rather than be copied out again.  Only
+			// safe when nothing else holds the body.
+			U8 * buffer(NULL);
+			if (! cur_size && ! src_offset && 1 == mHttpBufferArray->getRefCount())
+			{
+				size_t detached_size(0);
+				buffer = (U8 *) mHttpBufferArray->detachData(&detached_size);
+				llassert(! buffer || detached_size == size_t(total_size));
+			}
+			const bool buffer_adopted(NULL != buffer);
+			if (! buffer_adopted)
+			{
+				buffer = (U8 *)ll_aligned_malloc_16(total_size);
+			}
 			if (!buffer)
 			{
 				// abort. If we have no space for packet, we have not enough space to decode image
@@ -1709,12 +1885,15 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				mFileSize = total_size + 1 ; //flag the file is not fully loaded.
 			}
 
-			if (cur_size > 0)
+			if (! buffer_adopted)
 			{
-				// Copy previously collected data into buffer
-				memcpy(buffer, mFormattedImage->getData(), cur_size);
+				if (cur_size > 0)
+				{
+					// Copy previously collected data into buffer
+					memcpy(buffer, mFormattedImage->getData(), cur_size);
+				}
+				mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
 			}
-			mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
 
 			// NOTE: setData releases current data and owns new data (buffer)
 			mFormattedImage->setData(buffer, total_size);
@@ -1796,12 +1975,26 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		mAuxImage = NULL;
 		llassert_always(mFormattedImage.notNull());
 		S32 discard = mHaveAllData ? 0 : mLoadedDiscard;
+		mDecodeRequestDiscard = discard;
 		mDecoded  = FALSE;
 		setState(DECODE_IMAGE_UPDATE);
-		LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
-						   << " All Data: " << mHaveAllData << LL_ENDL;
-		mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage, discard, mNeedsAux,
-																  new DecodeResponder(mFetcher, mID, this));
+		if (mFetcher->mDecodedCache->find(mID, mFormattedImage->getDataSize(), discard, mNeedsAux,
+										  mRawImage, mAuxImage, mDecodedDiscard))
+		{
+			LL_DEBUGS(LOG_TXT) << mID << ": Reusing decode. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard << LL_ENDL;
+			mFormattedImage->setDiscardLevel(mDecodedDiscard);
+			mDecoded = TRUE;
+			mDecodedFromCache = true;
+		}
+		else
+		{
+			LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
+							   << " All Data: " << mHaveAllData << LL_ENDL;
+			mDecodedFromCache = false;
+			mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage, discard, mNeedsAux,
+																	  new DecodeResponder(mFetcher, mID, this),
+																	  mImagePriority);
+		}
 		// fall though
 	}
 	
@@ -1836,6 +2029,11 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				llassert_always(mRawImage.notNull());
 				LL_DEBUGS(LOG_TXT) << mID << ": Decoded. Discard: " << mDecodedDiscard
 								   << " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
+				if (!mDecodedFromCache)
+				{
+					mFetcher->mDecodedCache->insert(mID, mFormattedImage->getDataSize(), mDecodeRequestDiscard,
+													mDecodedDiscard, mRawImage, mAuxImage);
+				}
 				setState(WRITE_TO_CACHE);
 			}
 			// fall through
@@ -2048,7 +2246,9 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
 	LL_PROFILE_ZONE_SCOPED;
 	if (mDecodeHandle != 0)
 	{
-		// LL::ThreadPool has no operation to cancel a particular work item
+		// drops the decode if it hasn't started, otherwise callbackDecoded()
+		// ignores the result
+		LLAppViewer::getImageDecodeThread()->abortRequest(mDecodeHandle);
 		mDecodeHandle = 0;
 	}
 	mFormattedImage = NULL;
@@ -2179,9 +2379,7 @@ S32 LLTextureFetchWorker::callbackHttpGet(LLCore::HttpResponse * response,
 		LL_DEBUGS(LOG_TXT) << "HTTP RECEIVED: " << mID.asString() << " Bytes: " << data_size << LL_ENDL;
 		if (data_size > 0)
 		{
-			// *TODO: set the formatted image data here directly to avoid the copy
-
-			// Hold on to body for later copy
+			// Hold on to body for later copy, or adoption as the image data
 			llassert_always(NULL == mHttpBufferArray);
 			body->addRef();
 			mHttpBufferArray = body;
@@ -2433,6 +2631,9 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
 	  mTotalCacheReadCount(0U),
 	  mTotalCacheWriteCount(0U),
 	  mTotalResourceWaitCount(0U),
+	  mStateLatencyHistogram(LL_ARRAY_SIZE(e_state_name) * LATENCY_BUCKETS),
+	  mDecodedCache(new DecodedCache),
+	  mTraceFirstEvent(true),
 	  mFetchSource(LLTextureFetch::FROM_ALL),
 	  mOriginFetchSource(LLTextureFetch::FROM_ALL),
 	  mTextureInfoMainThread(false)
@@ -2440,6 +2641,25 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
 	mMaxBandwidth = gSavedSettings.getF32("ThrottleBandwidthKBPS");
 	mTextureInfo.setLogging(true);
 
+	std::string trace_file = gSavedSettings.getString("TextureFetchTraceFile");
+	if (!trace_file.empty())
+	{
+		std::string trace_path = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, trace_file);
+		mTraceFile.reset(new llofstream(trace_path.c_str()));
+		if (mTraceFile->is_open())
+		{
+			// JSON array format, which is still readable if we never get
+			// to write the closing bracket
+			*mTraceFile << "[\n";
+			LL_INFOS(LOG_TXT) << "Writing texture fetch trace to " << trace_path << LL_ENDL;
+		}
+		else
+		{
+			LL_WARNS(LOG_TXT) << "Unable to open texture fetch trace " << trace_path << LL_ENDL;
+			mTraceFile.reset();
+		}
+	}
+
 	LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
 	mHttpRequest = new LLCore::HttpRequest;
 	mHttpOptions = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions);
@@ -2483,9 +2703,118 @@ LLTextureFetch::~LLTextureFetch()
 	delete mHttpRequest;
 	mHttpRequest = NULL;
 
+	dumpStateLatencyHistograms();
+
+	if (mTraceFile)
+	{
+		*mTraceFile << "\n]\n";
+		mTraceFile->close();
+	}
+
 	// ~LLQueuedThread() called here
 }
 
+// Threads:  T*
+void LLTextureFetch::recordStateTime(const LLUUID& id, S32 state, S32 discard, F32 seconds)
+{
+	switch (state)
+	{
+	case LLTextureFetchWorker::LOAD_FROM_TEXTURE_CACHE:
+		sample(sStateCacheReadLatency, seconds);
+		break;
+	case LLTextureFetchWorker::CACHE_POST:
+		sample(sStateCachePostLatency, seconds);
+		break;
+	case LLTextureFetchWorker::SEND_HTTP_REQ:
+		sample(sStateHttpSendLatency, seconds);
+		break;
+	case LLTextureFetchWorker::WAIT_HTTP_REQ:
+		sample(sStateHttpWaitLatency, seconds);
+		break;
+	case LLTextureFetchWorker::DECODE_IMAGE:
+		sample(sStateDecodeLatency, seconds);
+		break;
+	case LLTextureFetchWorker::WRITE_TO_CACHE:
+		sample(sStateCacheWriteLatency, seconds);
+		break;
+	default:
+		break;
+	}
+
+	if (state >= 0 && state < (S32)LL_ARRAY_SIZE(e_state_name))
+	{
+		S32 bucket = 0;
+		for (U32 ms = (U32)(seconds * 1000.f); ms && bucket < LATENCY_BUCKETS - 1; ms >>= 1)
+		{
+			++bucket;
+		}
+		mStateLatencyHistogram[state * LATENCY_BUCKETS + bucket]++;
+	}
+
+	if (mTraceFile && state != LLTextureFetchWorker::INVALID)
+	{
+		U64 now = totalTime();
+		U64 duration = (U64)(seconds * 1000000.f);
+		std::string event = llformat("{\"name\":\"%s\",\"cat\":\"texture\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"id\":\"%s\",\"discard\":%d}}",
+									 e_state_name[state],
+									 (unsigned long long)(now - llmin(now, duration)),
+									 (unsigned long long)duration,
+									 id.getCRC32(),
+									 id.asString().c_str(),
+									 discard);
+
+		LLMutexLock lock(&mTraceMutex);										// +Mtr
+		if (!mTraceFirstEvent)
+		{
+			*mTraceFile << ",\n";
+		}
+		*mTraceFile << event;
+		mTraceFirstEvent = false;
+	}																		// -Mtr
+}
+
+// Threads:  T*
+void LLTextureFetch::getDecodedCacheStats(U32& entries, S64& bytes, U32& hits)
+{
+	mDecodedCache->getStats(entries, bytes, hits);
+}
+
+// Threads:  T*
+void LLTextureFetch::dumpStateLatencyHistograms()
+{
+	std::ostringstream header;
+	header << "state";
+	for (S32 bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+	{
+		if (bucket < LATENCY_BUCKETS - 1)
+		{
+			header << " <" << (1 << bucket) << "ms";
+		}
+		else
+		{
+			header << " more";
+		}
+	}
+	LL_INFOS(LOG_TXT) << "Texture fetch state latencies: " << header.str() << LL_ENDL;
+
+	for (S32 state = 0; state < (S32)LL_ARRAY_SIZE(e_state_name); ++state)
+	{
+		std::ostringstream line;
+		U32 total = 0;
+		line << e_state_name[state];
+		for (S32 bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+		{
+			U32 count = mStateLatencyHistogram[state * LATENCY_BUCKETS + bucket];
+			line << " " << count;
+			total += count;
+		}
+		if (total)
+		{
+			LL_INFOS(LOG_TXT) << line.str() << LL_ENDL;
+		}
+	}
+}
+
 S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const LLUUID& id, const LLHost& host, F32 priority,
 								   S32 w, S32 h, S32 c, S32 desired_discard, bool needs_aux, bool can_use_http)
 {
@@ -3101,6 +3430,8 @@ void LLTextureFetchWorker::setState(e_state new_state)
 		}
 	}
 
+	mFetcher->recordStateTime(mID, mState, mDesiredDiscard, d_time);
+
 	mStateTimer.reset();
 	mState = new_state;
 }
@@ -27,10 +27,13 @@
 #ifndef LL_LLTEXTUREFETCH_H
 #define LL_LLTEXTUREFETCH_H
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <map>
 
 #include "lldir.h"
+#include "llfile.h"
 #include "llimage.h"
 #include "lluuid.h"
 #include "llworkerthread.h"
@@ -64,6 +67,7 @@ public:
 	~LLTextureFetch();
 
 	class TFRequest;
+	class DecodedCache;
 	
     // Threads:  Tmain
 	/*virtual*/ size_t update(F32 max_time_ms);
@@ -288,7 +292,30 @@ private:
 	 * Threads:  Ttf
 	 */
 	void cmdDoWork();
-	
+
+	// Account for the time a worker spent in a state as it leaves it:
+	// the state's latency stat and histogram and, if enabled, the
+	// TextureFetchTraceFile trace.
+	//
+	// Threads:  T*
+	void recordStateTime(const LLUUID& id, S32 state, S32 discard, F32 seconds);
+
+public:
+	// Number of images in LLTextureFetch::DecodedCache, their size and
+	// the decodes they saved.
+	//
+	// Threads:  T*
+	void getDecodedCacheStats(U32& entries, S64& bytes, U32& hits);
+
+	// Log the per state latency histograms.
+	//
+	// Threads:  T*
+	void dumpStateLatencyHistograms();
+
+	// Histogram buckets are powers of two milliseconds, the first is
+	// under 1ms and the last is everything longer than 2^(N-2) ms.
+	static const S32 LATENCY_BUCKETS = 17;
+
 public:
 	LLUUID mDebugID;
 	S32 mDebugCount;
@@ -304,6 +331,14 @@ public:
     static LLTrace::SampleStatHandle<F32Seconds> sTexFetchLatency;
     static LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > sCacheHitRate;
 
+    // time spent by fetches in each stage, see recordStateTime()
+    static LLTrace::SampleStatHandle<F32Seconds> sStateCacheReadLatency;	// LOAD_FROM_TEXTURE_CACHE
+    static LLTrace::SampleStatHandle<F32Seconds> sStateCachePostLatency;	// CACHE_POST
+    static LLTrace::SampleStatHandle<F32Seconds> sStateHttpSendLatency;		// SEND_HTTP_REQ
+    static LLTrace::SampleStatHandle<F32Seconds> sStateHttpWaitLatency;		// WAIT_HTTP_REQ
+    static LLTrace::SampleStatHandle<F32Seconds> sStateDecodeLatency;		// DECODE_IMAGE
+    static LLTrace::SampleStatHandle<F32Seconds> sStateCacheWriteLatency;	// WRITE_TO_CACHE
+
 private:
 	LLMutex mQueueMutex;        //to protect mRequestMap and mCommands only
 	LLMutex mNetworkQueueMutex; //to protect mHTTPTextureQueue
@@ -374,6 +409,17 @@ private:
 	U32 mTotalCacheReadCount;											// Mfq
 	U32 mTotalCacheWriteCount;											// Mfq
 	U32 mTotalResourceWaitCount;										// Mfq
+
+	// Count of state exits per state and latency bucket.
+	std::vector<std::atomic<U32> > mStateLatencyHistogram;				// T*
+
+	std::unique_ptr<DecodedCache> mDecodedCache;						// T*
+
+	// Lifecycle of every fetch as Chrome trace events (chrome://tracing,
+	// ui.perfetto.dev), only open when TextureFetchTraceFile is set.
+	LLMutex mTraceMutex;
+	std::unique_ptr<llofstream> mTraceFile;							// Mtr
+	bool mTraceFirstEvent;												// Mtr
 	
 public:
 	// A probabilistically-correct indicator that the current
@@ -39,11 +39,14 @@
 
 #include "lltooltip.h"
 #include "llappviewer.h"
+#include "llkeyframemotion.h"
 #include "llmeshrepository.h"
 #include "llselectmgr.h"
 #include "llviewertexlayer.h"
+#include "lltexturebudget.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
+#include "llstreamingpriority.h"
 #include "llviewercontrol.h"
 #include "llviewerobject.h"
 #include "llviewerobjectlist.h"
@@ -54,6 +57,7 @@
 #include "llvovolume.h"
 #include "llviewerstats.h"
 #include "llworld.h"
+#include "pipeline.h"
 
 // For avatar texture view
 #include "llvoavatarself.h"
@@ -506,8 +510,9 @@ void LLGLTexMemBar::draw()
 	// const LLRect & rect(getRect());
 	// gl_rect_2d(-4, v_offset, rect.mRight - rect.mLeft + 2, v_offset + line_height*4);
 
-	std::string text = "";
-	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*6,
+	// video memory per render target, see LLPipeline::getRenderTargetDebugText
+	std::string text = gPipeline.getRenderTargetDebugText();
+	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*7,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
     LLTrace::Recording& recording = LLViewerStats::instance().getRecording();
@@ -538,7 +543,14 @@ void LLGLTexMemBar::draw()
 					cache_max_usage);
 	//, cache_entries, cache_max_entries
 
+	x_right = 0.0;
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*6,
+											 text_color, LLFontGL::LEFT, LLFontGL::TOP,
+											 LLFontGL::NORMAL, LLFontGL::NO_SHADOW, S32_MAX, S32_MAX, &x_right);
+
+	// Texture memory by category and what the budget manager is doing, see LLTextureBudget
+	text = " " + LLTextureBudget::getDebugText();
+	LLFontGL::getFontMonospace()->renderUTF8(text, 0, x_right, v_offset + line_height*6,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
 	U32 cache_read(0U), cache_write(0U), res_wait(0U);
@@ -557,7 +569,11 @@ void LLGLTexMemBar::draw()
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*5,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
-    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d",
+    U32 decoded_cache_entries(0U), decoded_cache_hits(0U);
+    S64 decoded_cache_bytes(0);
+    LLAppViewer::getTextureFetch()->getDecodedCacheStats(decoded_cache_entries, decoded_cache_bytes, decoded_cache_hits);
+
+    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d Decoded(Num/MB/Hits): %u/%.1f/%u",
                     cacheHitRate,
                     cacheReadLatMin,
                     cacheReadLatMed,
@@ -567,7 +583,10 @@ void LLGLTexMemBar::draw()
                     texDecodeLatMax,
                     texFetchLatMin,
                     texFetchLatMed,
-                    texFetchLatMax);
+                    texFetchLatMax,
+                    decoded_cache_entries,
+                    (F32)decoded_cache_bytes / (1024.f * 1024.f),
+                    decoded_cache_hits);
 
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*4,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
@@ -596,15 +615,35 @@ void LLGLTexMemBar::draw()
 	color[VALPHA] = text_color[VALPHA];
 	text = llformat("BW:%.0f/%.0f",bandwidth.value(), max_bandwidth.value());
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, x_right, v_offset + line_height*3,
-											 color, LLFontGL::LEFT, LLFontGL::TOP);
+											 color, LLFontGL::LEFT, LLFontGL::TOP,
+											 LLFontGL::NORMAL, LLFontGL::NO_SHADOW, S32_MAX, S32_MAX, &x_right);
+
+	// Shared streaming budget and fill order, see LLStreamingPriority
+	text = " " + LLStreamingPriority::getDebugText();
+	LLFontGL::getFontMonospace()->renderUTF8(text, 0, x_right, v_offset + line_height*3,
+											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 	
 	// Mesh status line
-	text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
+	text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d Pf(Req/Hit/Miss): %u/%u/%u",
 					LLMeshRepository::sMeshRequestCount, LLMeshRepository::sHTTPRequestCount, LLMeshRepository::sHTTPLargeRequestCount,
 					LLMeshRepository::sHTTPRetryCount, LLMeshRepository::sHTTPErrorCount,
 					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites,
-					LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater);
+					LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater,
+					LLMeshRepository::sPrefetchRequestCount, LLMeshRepository::sPrefetchHits, LLMeshRepository::sPrefetchMisses);
+	x_right = 0.0;
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*2,
+											 text_color, LLFontGL::LEFT, LLFontGL::TOP,
+											 LLFontGL::NORMAL, LLFontGL::NO_SHADOW, S32_MAX, S32_MAX, &x_right);
+
+	// Decoded animations shared between avatars
+	LLKeyframeDataCache::Stats anim_stats;
+	LLKeyframeDataCache::getStats(anim_stats);
+	text = llformat(" Anim(Cached/Motions): %u/%u Mem/Saved: %u/%u KB Decodes/Shared: %u/%u Time/Saved: %.0f/%.0f ms",
+					anim_stats.mAnimations, anim_stats.mMotions,
+					anim_stats.mBytes / 1024, anim_stats.mBytesSaved / 1024,
+					anim_stats.mDecodes, anim_stats.mShares,
+					anim_stats.mDecodeTime * 1000.0, anim_stats.mDecodeTimeSaved * 1000.0);
+	LLFontGL::getFontMonospace()->renderUTF8(text, 0, x_right, v_offset + line_height*2,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
 	// Header for texture table columns
@@ -650,7 +689,7 @@ BOOL LLGLTexMemBar::handleMouseDown(S32 x, S32 y, MASK mask)
 LLRect LLGLTexMemBar::getRequiredRect()
 {
 	LLRect rect;
-	rect.mTop = 78; //LLFontGL::getFontMonospace()->getLineHeight() * 6;
+	rect.mTop = 91; //LLFontGL::getFontMonospace()->getLineHeight() * 7;
 	return rect;
 }
 
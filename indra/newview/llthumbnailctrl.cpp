@@ -33,7 +33,9 @@
 #include "lluictrlfactory.h"
 #include "lluuid.h"
 #include "lltrans.h"
+#include "llthumbnailservice.h"
 #include "llviewborder.h"
+#include "llviewercontrol.h"
 #include "llviewertexture.h"
 #include "llviewertexturelist.h"
 #include "llwindow.h"
@@ -59,6 +61,7 @@ LLThumbnailCtrl::LLThumbnailCtrl(const LLThumbnailCtrl::Params& p)
 ,   mShowLoadingPlaceholder(p.show_loading())
 ,   mInited(false)
 ,   mInitImmediately(true)
+,   mUseAtlas(false)
 {
     mLoadingPlaceholderString = LLTrans::getString("texture_loading");
     
@@ -101,7 +104,32 @@ void LLThumbnailCtrl::draw()
 
     // If we're in a focused floater, don't apply the floater's alpha to the texture.
     const F32 alpha = getTransparencyType() == TT_ACTIVE ? 1.0f : getCurrentTransparency();
-    if( mTexturep )
+
+    LLThumbnailService::EState atlas_state = LLThumbnailService::MISSING;
+    LLRectf atlas_uv;
+    bool atlas_alpha = false;
+    if (mUseAtlas)
+    {
+        atlas_state = LLThumbnailService::getInstance()->getThumbnail(mImageAssetID, atlas_uv, atlas_alpha);
+    }
+
+    if (atlas_state == LLThumbnailService::READY)
+    {
+        if (atlas_alpha)
+        {
+            const LLColor4 color(.098f, .098f, .098f);
+            gl_rect_2d( draw_rect, color, TRUE);
+        }
+
+        gl_draw_scaled_image( draw_rect.mLeft, draw_rect.mBottom, draw_rect.getWidth(), draw_rect.getHeight(),
+                              LLThumbnailService::getInstance()->getAtlas(), UI_VERTEX_COLOR % alpha, atlas_uv);
+    }
+    else if (atlas_state == LLThumbnailService::LOADING)
+    {
+        const LLColor4 color(.098f, .098f, .098f);
+        gl_rect_2d( draw_rect, color % alpha, TRUE);
+    }
+    else if( mTexturep )
     {
         if( mTexturep->getComponents() == 4 )
         {
@@ -151,26 +179,26 @@ void LLThumbnailCtrl::draw()
     // Show "Loading..." string on the top left corner while this texture is loading.
     // Using the discard level, do not show the string if the texture is almost but not
     // fully loaded.
+    bool loading = atlas_state == LLThumbnailService::LOADING;
     if (mTexturep.notNull()
-        && mShowLoadingPlaceholder
         && !mTexturep->isFullyLoaded())
+    {
+        // Don't show as loaded if the texture is almost fully loaded (i.e. discard1) unless god
+        loading = (mTexturep->getDiscardLevel() > 1) || gAgent.isGodlike();
+    }
+    if (loading && mShowLoadingPlaceholder)
     {
         U32 v_offset = 25;
         LLFontGL* font = LLFontGL::getFontSansSerif();
-
-        // Don't show as loaded if the texture is almost fully loaded (i.e. discard1) unless god
-        if ((mTexturep->getDiscardLevel() > 1) || gAgent.isGodlike())
-        {
-            font->renderUTF8(
-                mLoadingPlaceholderString,
-                0,
-                llfloor(draw_rect.mLeft+3),
-                llfloor(draw_rect.mTop-v_offset),
-                LLColor4::white,
-                LLFontGL::LEFT,
-                LLFontGL::BASELINE,
-                LLFontGL::DROP_SHADOW);
-        }
+        font->renderUTF8(
+            mLoadingPlaceholderString,
+            0,
+            llfloor(draw_rect.mLeft+3),
+            llfloor(draw_rect.mTop-v_offset),
+            LLColor4::white,
+            LLFontGL::LEFT,
+            LLFontGL::BASELINE,
+            LLFontGL::DROP_SHADOW);
     }
 
     LLUICtrl::draw();
@@ -234,7 +262,18 @@ void LLThumbnailCtrl::initImage()
     if (tvalue.isUUID())
     {
         mImageAssetID = tvalue.asUUID();
-        if (mImageAssetID.notNull())
+        // Thumbnails that fit a cell of the shared atlas only need a
+        // small mip of the image, anything larger gets its own texture.
+        static LLCachedControl<bool> use_atlas(gSavedSettings, "ThumbnailAtlas", false);
+        LLRect rect = getLocalRect();
+        if (mImageAssetID.notNull()
+            && use_atlas
+            && rect.getWidth() <= LLThumbnailService::CELL_SIZE
+            && rect.getHeight() <= LLThumbnailService::CELL_SIZE)
+        {
+            mUseAtlas = true;
+        }
+        else if (mImageAssetID.notNull())
         {
             // Should it support baked textures?
             mTexturep = LLViewerTextureManager::getFetchedTexture(mImageAssetID, FTT_DEFAULT, MIPMAP_YES, LLGLTexture::BOOST_THUMBNAIL);
@@ -265,6 +304,7 @@ void LLThumbnailCtrl::unloadImage()
     mImageAssetID = LLUUID::null;
     mTexturep = nullptr;
     mImagep = nullptr;
+    mUseAtlas = false;
     mInited = false;
 }
 
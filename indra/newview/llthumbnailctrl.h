@@ -82,6 +82,7 @@ private:
     bool mShowLoadingPlaceholder;
     bool mInited;
     bool mInitImmediately;
+    bool mUseAtlas;	// drawn from LLThumbnailService instead of mTexturep
     std::string mLoadingPlaceholderString;
     LLUUID mImageAssetID;
     LLViewBorder* mBorder;
@@ -0,0 +1,313 @@
+/**
+ * @file llthumbnailservice.cpp
+ * @brief Small inventory and profile thumbnails packed into one atlas
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llthumbnailservice.h"
+
+#include "llframetimer.h"
+#include "llimage.h"
+#include "llimagegl.h"
+#include "llviewertexturelist.h"
+
+extern U32 gFrameCount;
+
+// loads that weren't drawn for this long are dropped
+static const F64 LOAD_TIMEOUT = 5.0;
+static const S32 CELLS_PER_ROW = LLThumbnailService::ATLAS_SIZE / LLThumbnailService::CELL_SIZE;
+
+LLThumbnailService::LLThumbnailService()
+{
+}
+
+LLThumbnailService::~LLThumbnailService()
+{
+}
+
+void LLThumbnailService::cleanupSingleton()
+{
+    for (entry_map_t::value_type& pair : mEntries)
+    {
+        stopLoading(pair.second);
+    }
+    LLLoadedCallbackEntry::cleanUpCallbackList(&mCallbackTextureList);
+    mEntries.clear();
+    mLRU.clear();
+    mFreeCells.clear();
+    mAtlas = NULL;
+}
+
+LLThumbnailService::EState LLThumbnailService::getThumbnail(const LLUUID& id, LLRectf& uv_rect, bool& has_alpha)
+{
+    if (mLastUpdateFrame != gFrameCount)
+    {
+        mLastUpdateFrame = gFrameCount;
+        update();
+    }
+
+    Entry& entry = mEntries[id];
+    if (entry.mMissing)
+    {
+        return MISSING;
+    }
+    if (entry.mCell >= 0)
+    {
+        mLRU.splice(mLRU.begin(), mLRU, entry.mLRUPos);
+        uv_rect = getCellRect(entry.mCell);
+        has_alpha = entry.mHasAlpha;
+        return READY;
+    }
+
+    entry.mLastUsedTime = LLFrameTimer::getElapsedSeconds();
+    updateLoading(id, entry);
+    return entry.mMissing ? MISSING : LOADING;
+}
+
+void LLThumbnailService::update()
+{
+    if (mAtlas.notNull() && !mAtlas->getGLTexture()->getHasGLTexture())
+    {
+        // the GL context went away, the cells have to be filled again
+        LL_INFOS() << "Thumbnail atlas lost its texture, reloading thumbnails" << LL_ENDL;
+        for (entry_map_t::iterator it = mEntries.begin(); it != mEntries.end(); )
+        {
+            if (it->second.mCell >= 0)
+            {
+                it = mEntries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        mLRU.clear();
+        mFreeCells.clear();
+        mAtlas = NULL;
+    }
+
+    F64 now = LLFrameTimer::getElapsedSeconds();
+    for (entry_map_t::iterator it = mEntries.begin(); it != mEntries.end(); )
+    {
+        Entry& entry = it->second;
+        if (entry.mTexture.notNull() && now - entry.mLastUsedTime > LOAD_TIMEOUT)
+        {
+            stopLoading(entry);
+            it = mEntries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void LLThumbnailService::updateLoading(const LLUUID& id, Entry& entry)
+{
+    if (entry.mTexture.isNull())
+    {
+        entry.mTexture = LLViewerTextureManager::getFetchedTexture(id, FTT_DEFAULT, MIPMAP_YES, LLGLTexture::BOOST_THUMBNAIL);
+        entry.mCallbackSet = false;
+    }
+
+    LLViewerFetchedTexture* texture = entry.mTexture;
+    if (texture->isMissingAsset())
+    {
+        stopLoading(entry);
+        entry.mMissing = true;
+        return;
+    }
+
+    // keeps the fetch going at the discard level that covers a cell
+    texture->setKnownDrawSize(CELL_SIZE, CELL_SIZE);
+
+    // A loaded callback asks for its discard level as soon as it is set, so
+    // wait for the header to tell the full size rather than ask for level 0.
+    if (!entry.mCallbackSet && texture->getFullWidth() > 0 && texture->getFullHeight() > 0)
+    {
+        S32 size = llmax(texture->getFullWidth(), texture->getFullHeight());
+        S32 discard = 0;
+        while (discard < MAX_DISCARD_LEVEL && (size >> (discard + 1)) >= CELL_SIZE)
+        {
+            ++discard;
+        }
+        entry.mCallbackSet = true;
+        texture->setLoadedCallback(onTextureLoaded, discard, TRUE, FALSE, new LLUUID(id), &mCallbackTextureList);
+    }
+}
+
+void LLThumbnailService::stopLoading(Entry& entry)
+{
+    if (entry.mTexture.isNull())
+    {
+        return;
+    }
+    // clear first so the callback fired by deleteCallbackEntry is ignored
+    LLPointer<LLViewerFetchedTexture> texture = entry.mTexture;
+    entry.mTexture = NULL;
+    if (entry.mCallbackSet)
+    {
+        entry.mCallbackSet = false;
+        texture->deleteCallbackEntry(&mCallbackTextureList);
+    }
+}
+
+// static
+void LLThumbnailService::onTextureLoaded(BOOL success, LLViewerFetchedTexture* src_vi, LLImageRaw* src, LLImageRaw* aux_src,
+                                         S32 discard_level, BOOL final, void* userdata)
+{
+    LLUUID* id = (LLUUID*)userdata;
+    if (instanceExists())
+    {
+        LLThumbnailService& self = instance();
+        entry_map_t::iterator it = self.mEntries.find(*id);
+        if (it != self.mEntries.end() && it->second.mTexture.get() == src_vi)
+        {
+            Entry& entry = it->second;
+            if (!success)
+            {
+                // the texture drops the callback after this
+                entry.mCallbackSet = false;
+                entry.mTexture = NULL;
+                entry.mMissing = true;
+            }
+            else if (final && src)
+            {
+                entry.mCallbackSet = false;
+                entry.mTexture = NULL;
+                self.finishLoading(*id, entry, src);
+            }
+        }
+    }
+
+    if (!success || final)
+    {
+        delete id;
+    }
+}
+
+void LLThumbnailService::finishLoading(const LLUUID& id, Entry& entry, LLImageRaw* raw)
+{
+    S32 width = raw->getWidth();
+    S32 height = raw->getHeight();
+    S32 components = raw->getComponents();
+    if (width <= 0 || height <= 0 || components < 1 || components > 4 || !raw->getData() || !createAtlas())
+    {
+        entry.mMissing = true;
+        return;
+    }
+
+    // the atlas is RGBA, LLImageRaw::copy() only converts between 3 and 4
+    LLPointer<LLImageRaw> rgba;
+    if (components == 4)
+    {
+        rgba = new LLImageRaw(raw->getData(), width, height, 4);
+    }
+    else
+    {
+        rgba = new LLImageRaw(width, height, 4);
+        const U8* in = raw->getData();
+        U8* out = rgba->getData();
+        for (S32 i = 0; i < width * height; ++i, in += components, out += 4)
+        {
+            if (components < 3)
+            {
+                out[0] = out[1] = out[2] = in[0];
+            }
+            else
+            {
+                out[0] = in[0];
+                out[1] = in[1];
+                out[2] = in[2];
+            }
+            out[3] = components == 2 ? in[1] : 255;
+        }
+    }
+    if (width != CELL_SIZE || height != CELL_SIZE)
+    {
+        rgba->scale(CELL_SIZE, CELL_SIZE);
+    }
+
+    S32 cell = allocateCell();
+    mAtlas->getGLTexture()->setSubImage(rgba, (cell % CELLS_PER_ROW) * CELL_SIZE, (cell / CELLS_PER_ROW) * CELL_SIZE,
+                                        CELL_SIZE, CELL_SIZE);
+
+    entry.mCell = cell;
+    entry.mHasAlpha = components == 2 || components == 4;
+    mLRU.push_front(id);
+    entry.mLRUPos = mLRU.begin();
+}
+
+bool LLThumbnailService::createAtlas()
+{
+    if (mAtlas.notNull())
+    {
+        return true;
+    }
+
+    LLPointer<LLImageRaw> raw = new LLImageRaw(ATLAS_SIZE, ATLAS_SIZE, 4);
+    if (!raw->getData())
+    {
+        LL_WARNS() << "Failed to allocate thumbnail atlas" << LL_ENDL;
+        return false;
+    }
+    raw->clear(0, 0, 0, 0);
+    mAtlas = LLViewerTextureManager::getLocalTexture(raw.get(), FALSE);
+
+    mFreeCells.clear();
+    for (S32 cell = CELLS_PER_ROW * CELLS_PER_ROW - 1; cell >= 0; --cell)
+    {
+        mFreeCells.push_back(cell);
+    }
+    return true;
+}
+
+S32 LLThumbnailService::allocateCell()
+{
+    if (!mFreeCells.empty())
+    {
+        S32 cell = mFreeCells.back();
+        mFreeCells.pop_back();
+        return cell;
+    }
+
+    // evict the least recently drawn thumbnail, it loads again if needed
+    llassert(!mLRU.empty());
+    entry_map_t::iterator it = mEntries.find(mLRU.back());
+    mLRU.pop_back();
+    S32 cell = it->second.mCell;
+    mEntries.erase(it);
+    return cell;
+}
+
+LLRectf LLThumbnailService::getCellRect(S32 cell) const
+{
+    // half a texel in from the edges so filtering doesn't pick up neighbours
+    const F32 texel = 1.f / ATLAS_SIZE;
+    F32 left = (F32)((cell % CELLS_PER_ROW) * CELL_SIZE) * texel;
+    F32 bottom = (F32)((cell / CELLS_PER_ROW) * CELL_SIZE) * texel;
+    F32 size = (F32)CELL_SIZE * texel;
+    return LLRectf(left + 0.5f * texel, bottom + size - 0.5f * texel, left + size - 0.5f * texel, bottom + 0.5f * texel);
+}
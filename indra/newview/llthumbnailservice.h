@@ -0,0 +1,114 @@
+/**
+ * @file llthumbnailservice.h
+ * @brief Small inventory and profile thumbnails packed into one atlas
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTHUMBNAILSERVICE_H
+#define LL_LLTHUMBNAILSERVICE_H
+
+#include "llsingleton.h"
+#include "llpointer.h"
+#include "llrect.h"
+#include "lluuid.h"
+#include "llviewertexture.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+class LLImageRaw;
+
+// Thumbnails drawn at CELL_SIZE pixels or less don't need their own full
+// resolution texture.  The service fetches each one only up to the discard
+// level that covers a cell, so just the first packets of the J2C stream are
+// downloaded and decoded, copies the result into a cell of one shared atlas
+// texture and lets the fetched texture go.  When the atlas is full the least
+// recently drawn thumbnail gives up its cell.
+class LLThumbnailService : public LLSingleton<LLThumbnailService>
+{
+    LLSINGLETON(LLThumbnailService);
+    ~LLThumbnailService();
+    LOG_CLASS(LLThumbnailService);
+
+public:
+    static const S32 CELL_SIZE = 128;
+    static const S32 ATLAS_SIZE = 2048;
+
+    enum EState
+    {
+        LOADING,
+        READY,
+        MISSING
+    };
+
+    // Looks up the thumbnail for id and starts loading it if needed, call it
+    // every frame the thumbnail is drawn.  When READY, uv_rect is the cell of
+    // the atlas holding it and has_alpha tells if the image had an alpha channel.
+    EState getThumbnail(const LLUUID& id, LLRectf& uv_rect, bool& has_alpha);
+
+    LLViewerTexture* getAtlas() const { return mAtlas; }
+
+private:
+    void cleanupSingleton() override;
+
+    typedef std::list<LLUUID> lru_list_t;
+
+    struct Entry
+    {
+        S32 mCell = -1;
+        lru_list_t::iterator mLRUPos; // valid while mCell is set
+        bool mHasAlpha = false;
+        bool mMissing = false;
+        // while loading
+        LLPointer<LLViewerFetchedTexture> mTexture;
+        bool mCallbackSet = false;
+        F64 mLastUsedTime = 0.0;
+    };
+    typedef std::map<LLUUID, Entry> entry_map_t;
+
+    static void onTextureLoaded(BOOL success, LLViewerFetchedTexture* src_vi, LLImageRaw* src, LLImageRaw* aux_src,
+                                S32 discard_level, BOOL final, void* userdata);
+
+    void updateLoading(const LLUUID& id, Entry& entry);
+    void finishLoading(const LLUUID& id, Entry& entry, LLImageRaw* raw);
+    void stopLoading(Entry& entry);
+    // once a frame, drops loads nobody has drawn for a while and starts
+    // over if the atlas lost its GL texture
+    void update();
+
+    bool createAtlas();
+    S32 allocateCell();
+    LLRectf getCellRect(S32 cell) const;
+
+    entry_map_t mEntries;
+    // ids of the entries that hold a cell, most recently drawn first
+    lru_list_t mLRU;
+    std::vector<S32> mFreeCells;
+
+    LLPointer<LLViewerTexture> mAtlas;
+    LLLoadedCallbackEntry::source_callback_list_t mCallbackTextureList;
+    U32 mLastUpdateFrame = 0;
+};
+
+#endif // LL_LLTHUMBNAILSERVICE_H
@@ -33,6 +33,7 @@
 #include "llwindow.h"	// getGamma()
 
 // For Listeners
+#include "llaudiodecodemgr.h"
 #include "llaudioengine.h"
 #include "llagent.h"
 #include "llagentcamera.h"
@@ -41,10 +42,12 @@
 #include "lldrawpoolterrain.h"
 #include "llflexibleobject.h"
 #include "llfeaturemanager.h"
+#include "llframetelemetry.h"
 #include "llviewershadermgr.h"
 
 #include "llsky.h"
 #include "llvieweraudio.h"
+#include "llviewerregion.h"
 #include "llviewermenu.h"
 #include "llviewertexturelist.h"
 #include "llviewerthrottle.h"
@@ -58,13 +61,19 @@
 #include "llviewerjoystick.h"
 #include "llviewerobjectlist.h"
 #include "llviewerparcelmgr.h"
+#include "llviewerparceloverlay.h"
 #include "llparcel.h"
 #include "llkeyboard.h"
 #include "llerrorcontrol.h"
+#include "llhitchrecorder.h"
 #include "llappviewer.h"
+#include "llcoros.h"
+#include "llimageworker.h"
 #include "llvosurfacepatch.h"
 #include "llvowlsky.h"
 #include "llrender.h"
+#include "llvertexbuffer.h"
+#include "llvolumemgr.h"
 #include "llnavigationbar.h"
 #include "llnotificationsutil.h"
 #include "llfloatertools.h"
@@ -73,6 +82,7 @@
 #include "llpaneltopinfobar.h"
 #include "llspellcheck.h"
 #include "llslurl.h"
+#include "llsurface.h"
 #include "llstartup.h"
 #include "llperfstats.h"
 
@@ -123,6 +133,17 @@ static bool handleTerrainDetailChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleTerrainHeightFieldChanged(const LLSD& newvalue)
+{
+	LLDrawPoolTerrain::sHeightField = newvalue.asBoolean();
+	// patch geometry switches between full and stand-in detail
+	for (LLViewerRegion* regionp : LLWorld::getInstance()->getRegionList())
+	{
+		regionp->getLand().dirtyAllPatches();
+	}
+	return true;
+}
+
 
 static bool handleDebugAvatarJointsChanged(const LLSD& newvalue)
 {
@@ -158,6 +179,17 @@ static bool handleSetShaderChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleTerrainParcelOverlayChanged(const LLSD& newvalue)
+{
+	handleSetShaderChanged(newvalue);
+	// property lines are only built on the CPU while the terrain shader isn't drawing them
+	for (LLViewerRegion* regionp : LLWorld::getInstance()->getRegionList())
+	{
+		regionp->getParcelOverlay()->setDirty();
+	}
+	return true;
+}
+
 static bool handleRenderPerfTestChanged(const LLSD& newvalue)
 {
        bool status = !newvalue.asBoolean();
@@ -301,6 +333,30 @@ static bool handleFlexLODChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handlePickBVHChanged(const LLSD& newvalue)
+{
+	LLVolumeFace::sUseBVH = newvalue.asBoolean();
+	return true;
+}
+
+static bool handleUseVAOChanged(const LLSD& newvalue)
+{
+	LLVertexBuffer::sUseVAOCache = newvalue.asBoolean();
+	return true;
+}
+
+static bool handleVolumeRetentionChanged(const LLSD& newvalue)
+{
+	LLPrimitive::getVolumeManager()->setRetentionBudget((U64)newvalue.asInteger() * 1024 * 1024);
+	return true;
+}
+
+static bool handleVolumeSimplifyLODsChanged(const LLSD& newvalue)
+{
+	LLVolumeLODGroup::setSimplifyLODs(newvalue.asBoolean());
+	return true;
+}
+
 static bool handleGammaChanged(const LLSD& newvalue)
 {
 	F32 gamma = (F32) newvalue.asReal();
@@ -368,6 +424,34 @@ static void handleAudioVolumeChanged(const LLSD& newvalue)
 	audio_update_volume(true);
 }
 
+static bool handleAudioDecodeMemoryCacheChanged(const LLSD& newvalue)
+{
+	LLAudioDecodeMgr::getInstance()->setMemoryCacheSize(newvalue.asInteger() * 1024 * 1024);
+	return true;
+}
+
+static bool handleAudioSourceCullDistanceChanged(const LLSD& newvalue)
+{
+	if (gAudiop)
+	{
+		gAudiop->setSourceCullDistance((F32) newvalue.asReal());
+	}
+	return true;
+}
+
+static bool handleFrameTelemetryExportChanged(const LLSD& newvalue)
+{
+	if (newvalue.asBoolean())
+	{
+		if (LLFrameTelemetry::instanceExists())
+		{
+			LLFrameTelemetry::instance().exportToLogs();
+		}
+		gSavedSettings.setBOOL("FrameTelemetryExport", FALSE);
+	}
+	return true;
+}
+
 static bool handleJoystickChanged(const LLSD& newvalue)
 {
 	LLViewerJoystick::getInstance()->setCameraNeedsUpdate(TRUE);
@@ -445,6 +529,21 @@ static bool handleDebugViewsChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleCoroutineStackPoolSizeChanged(const LLSD& newvalue)
+{
+	LLCoros::instance().setStackPoolSize((U32)newvalue.asInteger());
+	return true;
+}
+
+static bool handleJpeg2000DecodeThreadsChanged(const LLSD& newvalue)
+{
+	if (LLAppViewer::getImageDecodeThread())
+	{
+		LLAppViewer::getImageDecodeThread()->setMaxThreadsPerImage(newvalue.asInteger());
+	}
+	return true;
+}
+
 static bool handleLogFileChanged(const LLSD& newvalue)
 {
 	std::string log_filename = newvalue.asString();
@@ -635,6 +734,10 @@ void handlePerformanceStatsEnabledChanged(const LLSD& newValue)
     const auto newval = gSavedSettings.getBOOL("PerfStatsCaptureEnabled");
     LLPerfStats::StatsRecorder::setEnabled(newval);
 }
+void handleHitchRecorderEnabledChanged(const LLSD& newValue)
+{
+    LLHitchRecorder::setEnabled(newValue.asBoolean());
+}
 void handleUserImpostorByDistEnabledChanged(const LLSD& newValue)
 {
     const auto newval = gSavedSettings.getBOOL("AutoTuneImpostorByDistEnabled");
@@ -685,12 +788,17 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "FirstPersonAvatarVisible", handleRenderAvatarMouselookChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderFarClip", handleRenderFarClipChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderTerrainDetail", handleTerrainDetailChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderTerrainHeightField", handleTerrainHeightFieldChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderTerrainParcelOverlay", handleTerrainParcelOverlayChanged);
     setting_setup_signal_listener(gSavedSettings, "OctreeStaticObjectSizeFactor", handleRepartition);
     setting_setup_signal_listener(gSavedSettings, "OctreeDistanceFactor", handleRepartition);
     setting_setup_signal_listener(gSavedSettings, "OctreeMaxNodeCapacity", handleRepartition);
     setting_setup_signal_listener(gSavedSettings, "OctreeAlphaDistanceFactor", handleRepartition);
     setting_setup_signal_listener(gSavedSettings, "OctreeAttachmentSizeFactor", handleRepartition);
     setting_setup_signal_listener(gSavedSettings, "RenderMaxTextureIndex", handleSetShaderChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderInstancedAnimesh", handleSetShaderChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderTreeInstancing", handleSetShaderChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderAtmosphericsUBO", handleSetShaderChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderUIBuffer", handleWindowResized);
     setting_setup_signal_listener(gSavedSettings, "RenderDepthOfField", handleReleaseGLBufferChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderFSAASamples", handleReleaseGLBufferChanged);
@@ -712,6 +820,10 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "RenderTerrainLODFactor", handleTerrainLODChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderTreeLODFactor", handleTreeLODChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderFlexTimeFactor", handleFlexLODChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderPickBVH", handlePickBVHChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderUseVAO", handleUseVAOChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderVolumeRetentionMB", handleVolumeRetentionChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderVolumeSimplifyLODs", handleVolumeSimplifyLODsChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderGamma", handleGammaChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderFogRatio", handleFogRatioChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderMaxPartCount", handleMaxPartCountChanged);
@@ -720,6 +832,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "RenderDeferredNoise", handleReleaseGLBufferChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderDebugPipeline", handleRenderDebugPipelineChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderResolutionDivisor", handleRenderResolutionDivisorChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderResolutionScale", handleRenderResolutionDivisorChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderReflectionProbeLevel", handleReflectionProbeDetailChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderReflectionProbeDetail", handleReflectionProbeDetailChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderReflectionsEnabled", handleReflectionProbeDetailChanged);
@@ -732,7 +845,10 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "ConsoleMaxLines", handleConsoleMaxLinesChanged);
     setting_setup_signal_listener(gSavedSettings, "UploadBakedTexOld", handleUploadBakedTexOldChanged);
     setting_setup_signal_listener(gSavedSettings, "UseOcclusion", handleUseOcclusionChanged);
+    setting_setup_signal_listener(gSavedSettings, "AudioDecodeMemoryCacheMB", handleAudioDecodeMemoryCacheChanged);
     setting_setup_signal_listener(gSavedSettings, "AudioLevelMaster", handleAudioVolumeChanged);
+    setting_setup_signal_listener(gSavedSettings, "AudioSourceCullDistance", handleAudioSourceCullDistanceChanged);
+    setting_setup_signal_listener(gSavedSettings, "FrameTelemetryExport", handleFrameTelemetryExportChanged);
     setting_setup_signal_listener(gSavedSettings, "AudioLevelSFX", handleAudioVolumeChanged);
     setting_setup_signal_listener(gSavedSettings, "AudioLevelUI", handleAudioVolumeChanged);
     setting_setup_signal_listener(gSavedSettings, "AudioLevelAmbient", handleAudioVolumeChanged);
@@ -796,6 +912,8 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "BuildAxisDeadZone5", handleJoystickChanged);
     setting_setup_signal_listener(gSavedSettings, "DebugViews", handleDebugViewsChanged);
     setting_setup_signal_listener(gSavedSettings, "UserLogFile", handleLogFileChanged);
+    setting_setup_signal_listener(gSavedSettings, "CoroutineStackPoolSize", handleCoroutineStackPoolSizeChanged);
+    setting_setup_signal_listener(gSavedSettings, "Jpeg2000DecodeThreads", handleJpeg2000DecodeThreadsChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderHideGroupTitle", handleHideGroupTitleChanged);
     setting_setup_signal_listener(gSavedSettings, "HighResSnapshot", handleHighResSnapshotChanged);
     setting_setup_signal_listener(gSavedSettings, "EnableVoiceChat", handleVoiceClientPrefsChanged);
@@ -816,6 +934,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "ShowObjectRenderingCost", toggle_show_object_render_cost);
     setting_setup_signal_listener(gSavedSettings, "ForceShowGrid", handleForceShowGrid);
     setting_setup_signal_listener(gSavedSettings, "RenderTransparentWater", handleRenderTransparentWaterChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderWaterScreenSpaceReflections", handleRenderTransparentWaterChanged);
     setting_setup_signal_listener(gSavedSettings, "SpellCheck", handleSpellCheckChanged);
     setting_setup_signal_listener(gSavedSettings, "SpellCheckDictionary", handleSpellCheckChanged);
     setting_setup_signal_listener(gSavedSettings, "LoginLocation", handleLoginLocationChanged);
@@ -826,6 +945,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "AutoTuneLock", handleAutoTuneLockChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderAvatarMaxART", handleRenderAvatarMaxARTChanged);
     setting_setup_signal_listener(gSavedSettings, "PerfStatsCaptureEnabled", handlePerformanceStatsEnabledChanged);
+    setting_setup_signal_listener(gSavedSettings, "HitchRecorderEnabled", handleHitchRecorderEnabledChanged);
     setting_setup_signal_listener(gSavedSettings, "AutoTuneRenderFarClipTarget", handleUserTargetDrawDistanceChanged);
     setting_setup_signal_listener(gSavedSettings, "AutoTuneImpostorFarAwayDistance", handleUserImpostorDistanceChanged);
     setting_setup_signal_listener(gSavedSettings, "AutoTuneImpostorByDistEnabled", handleUserImpostorByDistEnabledChanged);
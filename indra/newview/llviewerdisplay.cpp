@@ -77,6 +77,9 @@
 #include "lldrawpoolbump.h"
 #include "llpostprocess.h"
 #include "llscenemonitor.h"
+#include "llstallmonitor.h"
+#include "llframepacer.h"
+#include "llframetelemetry.h"
 
 #include "llenvironment.h"
 #include "llperfstats.h"
@@ -193,7 +196,8 @@ void display_update_camera()
 	F32 final_far = gAgentCamera.mDrawDistance;
     if (gCubeSnapshot)
     {
-        final_far = gSavedSettings.getF32("RenderReflectionProbeDrawDistance");
+        static LLCachedControl<F32> probe_draw_distance(gSavedSettings, "RenderReflectionProbeDrawDistance", 64.f);
+        final_far = probe_draw_distance;
     }
     else if (CAMERA_MODE_CUSTOMIZE_AVATAR == gAgentCamera.getCameraMode())
         
@@ -214,7 +218,9 @@ void display_update_camera()
 void display_stats()
 {
 	LL_PROFILE_ZONE_SCOPED
-	F32 fps_log_freq = gSavedSettings.getF32("FPSLogFrequency");
+	static LLCachedControl<F32> fps_log_freq(gSavedSettings, "FPSLogFrequency", 10.f);
+	static LLCachedControl<F32> mem_log_freq(gSavedSettings, "MemoryLogFrequency", 600.f);
+	static LLCachedControl<F32> asset_storage_log_freq(gSavedSettings, "AssetStorageLogFrequency", 60.f);
 	if (fps_log_freq > 0.f && gRecentFPSTime.getElapsedTimeF32() >= fps_log_freq)
 	{
 		LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("DS - FPS");
@@ -223,7 +229,6 @@ void display_stats()
 		gRecentFrameCount = 0;
 		gRecentFPSTime.reset();
 	}
-	F32 mem_log_freq = gSavedSettings.getF32("MemoryLogFrequency");
 	if (mem_log_freq > 0.f && gRecentMemoryTime.getElapsedTimeF32() >= mem_log_freq)
 	{
 		LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("DS - Memory");
@@ -233,7 +238,6 @@ void display_stats()
 		LLMemory::logMemoryInfo(TRUE) ;
 		gRecentMemoryTime.reset();
 	}
-    F32 asset_storage_log_freq = gSavedSettings.getF32("AssetStorageLogFrequency");
     if (asset_storage_log_freq > 0.f && gAssetStorageLogTime.getElapsedTimeF32() >= asset_storage_log_freq)
     {
 		LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("DS - Asset Storage");
@@ -519,9 +523,12 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 	stop_glerror();
 
 	LLImageGL::updateStats(gFrameTimeSeconds);
+	LLImageGL::updateAlphaReadbacks();
 	
-	LLVOAvatar::sRenderName = gSavedSettings.getS32("AvatarNameTagMode");
-	LLVOAvatar::sRenderGroupTitles = (gSavedSettings.getBOOL("NameTagShowGroupTitles") && gSavedSettings.getS32("AvatarNameTagMode"));
+	static LLCachedControl<S32> name_tag_mode(gSavedSettings, "AvatarNameTagMode", 1);
+	static LLCachedControl<bool> show_group_titles(gSavedSettings, "NameTagShowGroupTitles", true);
+	LLVOAvatar::sRenderName = name_tag_mode;
+	LLVOAvatar::sRenderGroupTitles = show_group_titles && (name_tag_mode != 0);
 	
 	gPipeline.mBackfaceCull = TRUE;
 	gFrameCount++;
@@ -688,6 +695,7 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 
 		{
             LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("Update Geom");
+			LLStallMonitor::Phase phase(LLStallMonitor::PHASE_GEOMETRY);
 			const F32 max_geom_update_time = 0.005f*10.f*gFrameIntervalSeconds.value(); // 50 ms/second update time
 			gPipeline.createObjects(max_geom_update_time);
 			gPipeline.processPartitionQ();
@@ -719,7 +727,10 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 		static LLCullResult result;
 		LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
 		LLPipeline::sUnderWaterRender = LLViewerCamera::getInstance()->cameraUnderWater();
-		gPipeline.updateCull(*LLViewerCamera::getInstance(), result);
+		{
+			LLStallMonitor::Phase phase(LLStallMonitor::PHASE_CULL);
+			gPipeline.updateCull(*LLViewerCamera::getInstance(), result);
+		}
 		stop_glerror();
 
 		LLGLState::checkStates();
@@ -744,9 +755,12 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
                 if (gFrameCount > 1 && !for_snapshot)
                 { //for some reason, ATI 4800 series will error out if you 
                   //try to generate a shadow before the first frame is through
+                    LLFrameTelemetry::markPass(LLFrameTelemetry::PASS_SHADOW);
                     gPipeline.generateSunShadow(*LLViewerCamera::getInstance());
                 }
 
+				LLFrameTelemetry::markPass(LLFrameTelemetry::PASS_GEOMETRY);
+
 				LLVertexBuffer::unbind();
 
 				LLGLState::checkStates();
@@ -789,11 +803,13 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 
 			{
                 LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("Image Update Bump");
+				LLStallMonitor::Phase phase(LLStallMonitor::PHASE_TEXTURES);
 				gBumpImageList.updateImages();  // must be called before gTextureList version so that it's textures are thrown out first.
 			}
 
 			{
                 LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("List");
+				LLStallMonitor::Phase phase(LLStallMonitor::PHASE_TEXTURES);
 				F32 max_image_decode_time = 0.050f*gFrameIntervalSeconds.value(); // 50 ms/second decode time
 				max_image_decode_time = llclamp(max_image_decode_time, 0.002f, 0.005f ); // min 2ms/frame, max 5ms/frame)
 				gTextureList.updateImages(max_image_decode_time);
@@ -935,7 +951,8 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 			LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("display - 5")
 			LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
 
-			if (gSavedSettings.getBOOL("RenderDepthPrePass"))
+			static LLCachedControl<bool> depth_pre_pass(gSavedSettings, "RenderDepthPrePass", false);
+			if (depth_pre_pass)
 			{
 				gGL.setColorMask(false, false);
 
@@ -979,6 +996,7 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 
         if (LLPipeline::sRenderDeferred)
         {
+			LLFrameTelemetry::markPass(LLFrameTelemetry::PASS_LIGHTING);
 			gPipeline.renderDeferredLighting();
 		}
 
@@ -1155,7 +1173,8 @@ void render_hud_attachments()
 		hud_cam.setAxes(LLVector3(1,0,0), LLVector3(0,1,0), LLVector3(0,0,1));
 		LLViewerCamera::updateFrustumPlanes(hud_cam, TRUE);
 
-		bool render_particles = gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES) && gSavedSettings.getBOOL("RenderHUDParticles");
+		static LLCachedControl<bool> hud_particles(gSavedSettings, "RenderHUDParticles", false);
+		bool render_particles = gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES) && hud_particles;
 		
 		//only render hud objects
 		gPipeline.pushRenderTypeMask();
@@ -1357,7 +1376,9 @@ void render_ui(F32 zoom_factor, int subfield)
 	}
 
     // apply gamma correction and post effects
+    LLFrameTelemetry::markPass(LLFrameTelemetry::PASS_POST);
     gPipeline.renderFinalize();
+    LLFrameTelemetry::markPass(LLFrameTelemetry::PASS_UI);
 
 	{
         LLGLState::checkStates();
@@ -1416,9 +1437,11 @@ void swap()
     LLPerfStats::RecordSceneTime T ( LLPerfStats::StatType_t::RENDER_SWAP ); // render time capture - Swap buffer time - can signify excessive data transfer to/from GPU
     LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("Swap");
     LL_PROFILE_GPU_ZONE("swap");
+	LLFrameTelemetry::endPasses();
 	if (gDisplaySwapBuffers)
 	{
 		gViewerWindow->getWindow()->swapBuffers();
+		LLFramePacer::endFrame();
 	}
 	gDisplaySwapBuffers = TRUE;
 }
@@ -1516,7 +1539,8 @@ void render_ui_3d()
     gGL.color4f(1, 1, 1, 1);
 
 	// Coordinate axes
-	if (gSavedSettings.getBOOL("ShowAxes"))
+	static LLCachedControl<bool> show_axes(gSavedSettings, "ShowAxes", false);
+	if (show_axes)
 	{
 		draw_axes();
 	}
@@ -1582,7 +1606,8 @@ void render_ui_2d()
 	}
 	
 
-	if (gSavedSettings.getBOOL("RenderUIBuffer"))
+	static LLCachedControl<bool> render_ui_buffer(gSavedSettings, "RenderUIBuffer", false);
+	if (render_ui_buffer)
 	{
 		if (LLView::sIsRectDirty)
 		{
@@ -171,6 +171,8 @@
 #include "llpreviewtexture.h"
 #include "llscriptfloater.h"
 #include "llsyswellwindow.h"
+#include "llviewercontrol.h"
+#include "lluiusage.h"
 
 // *NOTE: Please add files in alphabetical order to keep merges easy.
 
@@ -508,3 +510,100 @@ void LLViewerFloaterReg::registerFloaters()
 	
 	LLFloaterReg::registerControlVariables(); // Make sure visibility and rect controls get preserved when saving
 }
+
+// floaters built hidden after login, most used first
+static std::deque<std::string> sPrebuildQueue;
+
+// counts from earlier sessions lose weight, so the list follows habits
+static const F64 USAGE_DECAY = 0.8;
+static const F64 USAGE_MIN_COUNT = 0.5;
+// frames between prebuilds, so the cost is spread out
+static const U32 PREBUILD_FRAME_INTERVAL = 15;
+
+//static
+void LLViewerFloaterReg::queuePrebuild()
+{
+	sPrebuildQueue.clear();
+
+	if (!gSavedSettings.getBOOL("InventoryBuildAtLogin"))
+	{
+		sPrebuildQueue.push_back("inventory");
+	}
+
+	U32 count = gSavedSettings.getU32("FloaterPrebuildCount");
+	if (!count)
+	{
+		return;
+	}
+
+	std::vector<std::pair<F64, std::string> > floaters;
+	LLSD usage = gSavedPerAccountSettings.getLLSD("FloaterUsageCounts");
+	for (LLSD::map_const_iterator it = usage.beginMap(); it != usage.endMap(); ++it)
+	{
+		if (LLFloaterReg::isRegistered(it->first))
+		{
+			floaters.push_back(std::make_pair(it->second.asReal(), it->first));
+		}
+	}
+	std::sort(floaters.rbegin(), floaters.rend());
+
+	for (U32 i = 0; i < floaters.size() && i < count; ++i)
+	{
+		if (std::find(sPrebuildQueue.begin(), sPrebuildQueue.end(), floaters[i].second) == sPrebuildQueue.end())
+		{
+			sPrebuildQueue.push_back(floaters[i].second);
+		}
+	}
+}
+
+//static
+void LLViewerFloaterReg::updatePrebuild()
+{
+	static LLCachedControl<F32> budget_ms(gSavedSettings, "FloaterPrebuildBudget", 5.f);
+
+	if (sPrebuildQueue.empty() || LLFrameTimer::getFrameCount() % PREBUILD_FRAME_INTERVAL)
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED;
+	LLTimer timer;
+	// a floater can't be built in parts, so one always goes
+	do
+	{
+		std::string name = sPrebuildQueue.front();
+		sPrebuildQueue.pop_front();
+		if (!LLFloaterReg::prebuildInstance(name))
+		{
+			LL_WARNS() << "Unable to prebuild floater " << name << LL_ENDL;
+		}
+	}
+	while (!sPrebuildQueue.empty() && timer.getElapsedTimeF32() * 1000.f < budget_ms);
+}
+
+//static
+void LLViewerFloaterReg::saveUsage()
+{
+	LLSD usage = gSavedPerAccountSettings.getLLSD("FloaterUsageCounts");
+	LLSD updated = LLSD::emptyMap();
+	for (LLSD::map_const_iterator it = usage.beginMap(); it != usage.endMap(); ++it)
+	{
+		F64 count = it->second.asReal() * USAGE_DECAY;
+		if (count >= USAGE_MIN_COUNT)
+		{
+			updated[it->first] = count;
+		}
+	}
+
+	// only floaters that were opened without a key, prebuilding the others
+	// would build an instance nobody shows
+	for (const auto& it : LLUIUsage::instance().getFloaterCounts())
+	{
+		if (LLFloaterReg::wasShownUnkeyed(it.first))
+		{
+			updated[it.first] = updated[it.first].asReal() + (F64)it.second;
+		}
+	}
+
+	gSavedPerAccountSettings.setLLSD("FloaterUsageCounts", updated);
+}
@@ -27,10 +27,21 @@
 #ifndef LL_LLVIEWERFLOATERREG_H
 #define LL_LLVIEWERFLOATERREG_H
 
+// Floaters are built on first open. Once in world, the FloaterPrebuildCount
+// floaters opened most over recent sessions (FloaterUsageCounts, kept per
+// account from LLUIUsage) are built hidden in the background instead, a few
+// milliseconds' worth per frame, so that first open doesn't hitch.
 class LLViewerFloaterReg
 {
 public:
 	static void registerFloaters();
+
+	// once in world
+	static void queuePrebuild();
+	// from idle
+	static void updatePrebuild();
+	// folds this session's floater opens into FloaterUsageCounts
+	static void saveUsage();
 };
 
 
@@ -32,6 +32,7 @@
 #include "llagentcamera.h"
 #include "llappviewer.h"
 #include "llaudioengine.h"  // for gAudiop
+#include "llbackgroundmode.h"
 #include "llcallbacklist.h"
 #include "lldir.h"
 #include "lldiriterator.h"
@@ -625,6 +626,32 @@ void LLViewerMedia::onIdle(void *dummy_arg)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
+// Texture update rate cap for an impl, 0 for none. Focused, UI and parcel media
+// run at full rate, other in-world media scales with its pixel area on screen.
+static F32 media_update_rate_limit(LLViewerMediaImpl* pimpl, LLPluginClassMedia::EPriority priority)
+{
+	static LLCachedControl<bool> throttle(gSavedSettings, "MediaUpdateThrottle", false);
+	static LLCachedControl<F32> min_fps(gSavedSettings, "MediaUpdateMinFPS", 2.f);
+	static LLCachedControl<F32> max_fps(gSavedSettings, "MediaUpdateMaxFPS", 30.f);
+	static LLCachedControl<F32> full_rate_area(gSavedSettings, "MediaUpdateFullRateArea", 262144.f);
+
+	if (!throttle || pimpl->hasFocus() || pimpl->getUsedInUI() || pimpl->isParcelMedia()
+		|| priority >= LLPluginClassMedia::PRIORITY_HIGH)
+	{
+		return 0.f;
+	}
+
+	F64 area = pimpl->getInterest();
+	if (area >= full_rate_area)
+	{
+		return 0.f;
+	}
+
+	F32 t = (F32)(area / llmax((F32)full_rate_area, 1.f));
+	// whole frames per second so small changes in area don't resend the limit to the plugin
+	return (F32)llmax(ll_round(lerp((F32)min_fps, (F32)max_fps, t)), 1);
+}
+
 void LLViewerMedia::updateMedia(void *dummy_arg)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_MEDIA; //LL_RECORD_BLOCK_TIME(FTM_MEDIA_UPDATE);
@@ -683,6 +710,7 @@ void LLViewerMedia::updateMedia(void *dummy_arg)
 	int impl_count_total = 0;
 	int impl_count_interest_low = 0;
 	int impl_count_interest_normal = 0;
+	int impl_count_web = 0;
 
 	std::vector<LLViewerMediaImpl*> proximity_order;
 
@@ -691,6 +719,7 @@ void LLViewerMedia::updateMedia(void *dummy_arg)
 	U32 max_instances = gSavedSettings.getU32("PluginInstancesTotal");
 	U32 max_normal = gSavedSettings.getU32("PluginInstancesNormal");
 	U32 max_low = gSavedSettings.getU32("PluginInstancesLow");
+	static LLCachedControl<U32> max_web(gSavedSettings, "PluginInstancesWeb", 0);
 	F32 max_cpu = gSavedSettings.getF32("PluginInstancesCPULimit");
 	// Setting max_cpu to 0.0 disables CPU usage checking.
 	bool check_cpu_usage = (max_cpu != 0.0f);
@@ -788,6 +817,21 @@ void LLViewerMedia::updateMedia(void *dummy_arg)
 				}
 			}
 
+			if(max_web && !pimpl->getUsedInUI() && (new_priority != LLPluginClassMedia::PRIORITY_UNLOADED)
+				&& (LLMIMETypes::implType(pimpl->getMimeType()) == "media_plugin_cef"))
+			{
+				// Every web instance runs its own browser process tree, so the heavy ones get a smaller pool of
+				// processes than the other plugins.  The list is sorted by interest, so the least interesting ones are unloaded.
+				if(impl_count_web >= (int)max_web)
+				{
+					new_priority = LLPluginClassMedia::PRIORITY_UNLOADED;
+				}
+				else
+				{
+					impl_count_web++;
+				}
+			}
+
 			if(!pimpl->getUsedInUI() && (new_priority != LLPluginClassMedia::PRIORITY_UNLOADED))
 			{
 				// This is a loadable inworld impl -- the last one in the list in this class defines the lowest loadable interest.
@@ -796,9 +840,10 @@ void LLViewerMedia::updateMedia(void *dummy_arg)
 				impl_count_total++;
 			}
 
-			// Overrides if the window is minimized or we lost focus (taking care
-			// not to accidentally "raise" the priority either)
-			if (!gViewerWindow->getActive() /* viewer window minimized? */
+			// Overrides if the window is minimized, in background mode or we lost
+			// focus (taking care not to accidentally "raise" the priority either)
+			if ((!gViewerWindow->getActive() /* viewer window minimized? */
+				 || LLBackgroundMode::isActive())
 				&& new_priority > LLPluginClassMedia::PRIORITY_HIDDEN)
 			{
 				new_priority = LLPluginClassMedia::PRIORITY_HIDDEN;
@@ -837,6 +882,7 @@ void LLViewerMedia::updateMedia(void *dummy_arg)
             }
 
 			pimpl->setPriority(new_priority);
+			pimpl->setUpdateRateLimit(media_update_rate_limit(pimpl, new_priority));
 
 			if(pimpl->getUsedInUI())
 			{
@@ -2870,7 +2916,12 @@ void LLViewerMediaImpl::update()
         return;
     }
 
-    
+    if (mUpdateRateLimit > 0.f && mTextureUpdateTimer.getElapsedTimeF32() < 1.f / mUpdateRateLimit)
+    {
+        // Too soon for this instance, the plugin's dirty rect keeps accumulating until next time
+        return;
+    }
+
     LLViewerMediaTexture* media_tex;
     U8* data;
     S32 data_width;
@@ -2882,6 +2933,8 @@ void LLViewerMediaImpl::update()
 
     if (preMediaTexUpdate(media_tex, data, data_width, data_height, x_pos, y_pos, width, height))
     {
+        mTextureUpdateTimer.reset();
+
         // Push update to worker thread
         auto main_queue = LLImageGLThread::sEnabledMedia ? mMainQueue.lock() : nullptr;
         if (main_queue)
@@ -2935,6 +2988,12 @@ bool LLViewerMediaImpl::preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*&
             // Since we're updating this texture, we know it's playing.  Tell the texture to do its replacement magic so it gets rendered.
             media_tex->setPlaying(TRUE);
 
+            static LLCachedControl<bool> use_unpack_buffer(gSavedSettings, "RenderMediaUnpackBuffer", false);
+            if (media_tex->getGLTexture())
+            {
+                media_tex->getGLTexture()->setUseUnpackBuffer(use_unpack_buffer);
+            }
+
             if (mMediaSource->getDirty(&dirty_rect))
             {
                 // Constrain the dirty rect to be inside the texture
@@ -3753,6 +3812,15 @@ void LLViewerMediaImpl::setLowPrioritySizeLimit(int size)
 	}
 }
 
+void LLViewerMediaImpl::setUpdateRateLimit(F32 fps)
+{
+	mUpdateRateLimit = fps;
+	if(mMediaSource)
+	{
+		mMediaSource->setFrameRateLimit(fps);
+	}
+}
+
 void LLViewerMediaImpl::setNavState(EMediaNavState state)
 {
 	mMediaNavState = state;
@@ -28,6 +28,7 @@
 #define LLVIEWERMEDIA_H
 
 #include "llfocusmgr.h"
+#include "llframetimer.h"
 #include "lleditmenuhandler.h"
 
 #include "llpanel.h"
@@ -381,6 +382,10 @@ public:
 
 	void setLowPrioritySizeLimit(int size);
 
+	// Cap texture updates (and ask the plugin to cap frames) to fps per second, 0 for no cap
+	void setUpdateRateLimit(F32 fps);
+	F32 getUpdateRateLimit() const { return mUpdateRateLimit; }
+
 	void setTextureID(LLUUID id = LLUUID::null);
 
 	bool isTrustedBrowser() { return mTrustedBrowser; }
@@ -453,6 +458,8 @@ private:
 	S32 mTextureUsedHeight;
 	bool mSuspendUpdates;
     bool mTextureUpdatePending = false;
+	F32 mUpdateRateLimit = 0.f;
+	LLFrameTimer mTextureUpdateTimer;
 	bool mVisible;
 	ECursorType mLastSetCursor;
 	EMediaNavState mMediaNavState;
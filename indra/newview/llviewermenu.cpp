@@ -51,6 +51,7 @@
 #include "llagentui.h"
 #include "llagentwearables.h"
 #include "llagentpilot.h"
+#include "llavatarrenderbenchmark.h"
 #include "llcompilequeue.h"
 #include "llconsole.h"
 #include "lldebugview.h"
@@ -7865,6 +7866,15 @@ class LLAdvancedClickRenderProfile: public view_listener_t
 	}
 };
 
+class LLAdvancedSaveHitchTrace : public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		LLAppViewer::instance()->saveHitchTrace("request");
+		return true;
+	}
+};
+
 F32 gpu_benchmark();
 
 class LLAdvancedClickRenderBenchmark: public view_listener_t
@@ -7876,6 +7886,23 @@ class LLAdvancedClickRenderBenchmark: public view_listener_t
 	}
 };
 
+class LLAdvancedClickAvatarRenderBenchmark: public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		LLAvatarRenderBenchmark* benchmark = LLAvatarRenderBenchmark::getInstance();
+		if (benchmark->isRunning())
+		{
+			benchmark->stop();
+		}
+		else
+		{
+			benchmark->start();
+		}
+		return true;
+	}
+};
+
 // these are used in the gl menus to set control values that require shader recompilation
 class LLToggleShaderControl : public view_listener_t
 {
@@ -9515,6 +9542,8 @@ void initialize_menus()
 	view_listener_t::addMenu(new LLAdvancedClickRenderShadowOption(), "Advanced.ClickRenderShadowOption");
 	view_listener_t::addMenu(new LLAdvancedClickRenderProfile(), "Advanced.ClickRenderProfile");
 	view_listener_t::addMenu(new LLAdvancedClickRenderBenchmark(), "Advanced.ClickRenderBenchmark");
+	view_listener_t::addMenu(new LLAdvancedClickAvatarRenderBenchmark(), "Advanced.ClickAvatarRenderBenchmark");
+	view_listener_t::addMenu(new LLAdvancedSaveHitchTrace(), "Advanced.SaveHitchTrace");
 	view_listener_t::addMenu(new LLAdvancedPurgeShaderCache(), "Advanced.ClearShaderCache");
 
 	#ifdef TOGGLE_HACKED_GODLIKE_VIEWER
@@ -40,6 +40,7 @@
 #include "llinventorydefines.h"
 #include "lllslconstants.h"
 #include "llmaterialtable.h"
+#include "llmessagedecoders.h"
 #include "llregionhandle.h"
 #include "llsd.h"
 #include "llsdserialize.h"
@@ -53,6 +54,7 @@
 #include "llagent.h"
 #include "llagentbenefits.h"
 #include "llagentcamera.h"
+#include "llappviewer.h"
 #include "llcallingcard.h"
 #include "llbuycurrencyhtml.h"
 #include "llcontrolavatar.h"
@@ -467,8 +469,14 @@ void process_logout_reply(LLMessageSystem* msg, void**)
     LLAppViewer::instance()->forceQuit();
 }
 
-void process_layer_data(LLMessageSystem *mesgsys, void **user_data)
+bool process_layer_data(LLMessageSystem *mesgsys, const U8 *data, S32 data_size, void **user_data)
 {
+	LLMsgLayerData layer;
+	if (!layer.decode(data, data_size))
+	{
+		return false;
+	}
+
 	LLViewerRegion *regionp = LLWorld::getInstance()->getRegion(mesgsys->getSender());
 
 	LL_DEBUGS_ONCE("SceneLoadTiming") << "Received layer data" << LL_ENDL;
@@ -476,28 +484,18 @@ void process_layer_data(LLMessageSystem *mesgsys, void **user_data)
 	if(!regionp)
 	{
 		LL_WARNS() << "Invalid region for layer data." << LL_ENDL;
-		return;
+		return true;
 	}
-	S32 size;
-	S8 type;
+	S32 size = layer.mLayerData.DataSize;
+	S8 type = (S8)layer.mLayerID.Type;
 
-	mesgsys->getS8Fast(_PREHASH_LayerID, _PREHASH_Type, type);
-	size = mesgsys->getSizeFast(_PREHASH_LayerData, _PREHASH_Data);
 	if (0 == size)
 	{
 		LL_WARNS("Messaging") << "Layer data has zero size." << LL_ENDL;
-		return;
-	}
-	if (size < 0)
-	{
-		// getSizeFast() is probably trying to tell us about an error
-		LL_WARNS("Messaging") << "getSizeFast() returned negative result: "
-			<< size
-			<< LL_ENDL;
-		return;
+		return true;
 	}
 	U8 *datap = new U8[size];
-	mesgsys->getBinaryDataFast(_PREHASH_LayerData, _PREHASH_Data, datap, size);
+	memcpy(datap, layer.mLayerData.Data, size);
 	LLVLData *vl_datap = new LLVLData(regionp, type, datap, size);
 	if (mesgsys->getReceiveCompressedSize())
 	{
@@ -507,6 +505,7 @@ void process_layer_data(LLMessageSystem *mesgsys, void **user_data)
 	{
 		gVLManager.addLayerData(vl_datap, (S32Bytes)mesgsys->getReceiveSize());
 	}
+	return true;
 }
 
 // S32 exported_object_count = 0;
@@ -3057,6 +3056,10 @@ void process_teleport_finish(LLMessageSystem* msg, void**)
 	gAgent.setTeleportState( LLAgent::TELEPORT_MOVING );
 	gAgent.setTeleportMessage(LLAgent::sTeleportProgressMessages["contacting"]);
 
+	// The destination's capability host is first known here, open
+	// its connections alongside the seed capability request.
+	LLAppViewer::instance()->getAppCoreHttp().preconnect(LLAppCoreHttp::AP_DEFAULT, seedCap);
+
 	LL_DEBUGS("CrossingCaps") << "Calling setSeedCapability(). Seed cap == "
 			<< seedCap << LL_ENDL;
 	regionp->setSeedCapability(seedCap);
@@ -4093,14 +4096,18 @@ void process_sim_stats(LLMessageSystem *msg, void **user_data)
 
 
 
-void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
+bool process_avatar_animation(LLMessageSystem *mesgsys, const U8 *data, S32 size, void **user_data)
 {
+	LLMsgAvatarAnimation msg;
+	if (!msg.decode(data, size))
+	{
+		return false;
+	}
+
 	LLUUID	animation_id;
-	LLUUID	uuid;
+	LLUUID	uuid = msg.mSender.ID;
 	S32		anim_sequence_id;
 	LLVOAvatar *avatarp = NULL;
-	
-	mesgsys->getUUIDFast(_PREHASH_Sender, _PREHASH_ID, uuid);
 
 	LLViewerObject *objp = gObjectList.findObject(uuid);
     if (objp)
@@ -4112,11 +4119,11 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 	{
 		// no agent by this ID...error?
 		LL_WARNS("Messaging") << "Received animation state for unknown avatar " << uuid << LL_ENDL;
-		return;
+		return true;
 	}
 
-	S32 num_blocks = mesgsys->getNumberOfBlocksFast(_PREHASH_AnimationList);
-	S32 num_source_blocks = mesgsys->getNumberOfBlocksFast(_PREHASH_AnimationSourceList);
+	S32 num_blocks = msg.mAnimationList.size();
+	S32 num_source_blocks = msg.mAnimationSourceList.size();
 
 	LL_DEBUGS("Messaging", "Motion") << "Processing " << num_blocks << " Animations" << LL_ENDL;
 
@@ -4129,8 +4136,9 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 
 		for( S32 i = 0; i < num_blocks; i++ )
 		{
-			mesgsys->getUUIDFast(_PREHASH_AnimationList, _PREHASH_AnimID, animation_id, i);
-			mesgsys->getS32Fast(_PREHASH_AnimationList, _PREHASH_AnimSequenceID, anim_sequence_id, i);
+			LLMsgAvatarAnimation::AnimationList animation = msg.mAnimationList[i];
+			animation_id = animation.AnimID;
+			anim_sequence_id = animation.AnimSequenceID;
 
 			avatarp->mSignaledAnimations[animation_id] = anim_sequence_id;
 
@@ -4147,7 +4155,7 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 
 			if (i < num_source_blocks)
 			{
-				mesgsys->getUUIDFast(_PREHASH_AnimationSourceList, _PREHASH_ObjectID, object_id, i);
+				object_id = msg.mAnimationSourceList[i].ObjectID;
 			
 				LLViewerObject* object = gObjectList.findObject(object_id);
 				if (object)
@@ -4185,8 +4193,9 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 	{
 		for( S32 i = 0; i < num_blocks; i++ )
 		{
-			mesgsys->getUUIDFast(_PREHASH_AnimationList, _PREHASH_AnimID, animation_id, i);
-			mesgsys->getS32Fast(_PREHASH_AnimationList, _PREHASH_AnimSequenceID, anim_sequence_id, i);
+			LLMsgAvatarAnimation::AnimationList animation = msg.mAnimationList[i];
+			animation_id = animation.AnimID;
+			anim_sequence_id = animation.AnimSequenceID;
 			avatarp->mSignaledAnimations[animation_id] = anim_sequence_id;
 		}
 	}
@@ -4195,6 +4204,7 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 	{
 		avatarp->processAnimationStateChanges();
 	}
+	return true;
 }
 
 
@@ -72,7 +72,7 @@ void send_join_group_response(LLUUID group_id,
 							  bool use_offline_cap);
 
 void process_logout_reply(LLMessageSystem* msg, void**);
-void process_layer_data(LLMessageSystem *mesgsys, void **user_data);
+bool process_layer_data(LLMessageSystem *mesgsys, const U8 *data, S32 size, void **user_data);
 void process_derez_ack(LLMessageSystem*, void**);
 void process_places_reply(LLMessageSystem* msg, void** data);
 void send_sound_trigger(const LLUUID& sound_id, F32 gain);
@@ -98,7 +98,7 @@ void process_energy_statistics(LLMessageSystem *mesgsys, void **user_data);
 void process_health_message(LLMessageSystem *mesgsys, void **user_data);
 void process_sim_stats(LLMessageSystem *mesgsys, void **user_data);
 void process_shooter_agent_hit(LLMessageSystem* msg, void** user_data);
-void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data);
+bool process_avatar_animation(LLMessageSystem *mesgsys, const U8 *data, S32 size, void **user_data);
 void process_object_animation(LLMessageSystem *mesgsys, void **user_data);
 void process_avatar_appearance(LLMessageSystem *mesgsys, void **user_data);
 void process_camera_constraint(LLMessageSystem *mesgsys, void **user_data);
@@ -297,6 +297,7 @@ LLViewerObject::LLViewerObject(const LLUUID &id, const LLPCode pcode, LLViewerRe
 	mSeatCount(0),
 	mNumFaces(0),
 	mRotTime(0.f),
+	mHiddenRotTime(0.f),
 	mAngularVelocityRot(),
 	mPreviousRotation(),
 	mAttachmentState(0),
@@ -720,6 +721,84 @@ U32 LLViewerObject::unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id)
 	return parent_id;
 }
 
+//static
+bool LLViewerObject::unpackSculptParams(LLDataPackerBinaryBuffer* dp, LLSculptParams& sculpt)
+{
+	dp->shift(sObjectDataMap["SpecialCode"]);
+	U32 value;
+	dp->unpackU32(value, "SpecialCode");
+
+	//skip to what follows ParentID, then along the rest of the update as
+	//processUpdateMessage() reads it
+	S32 offset = sObjectDataMap["ParentID"];
+	if (!(value & 0x80))
+	{
+		offset -= sizeof(LLVector3);
+	}
+	if (value & 0x20)
+	{
+		offset += sizeof(U32);
+	}
+	dp->shift(offset);
+
+	if (value & 0x2)
+	{
+		U8 tree_data;
+		dp->unpackU8(tree_data, "TreeData");
+	}
+	else if (value & 0x1)
+	{
+		U32 size;
+		dp->unpackU32(size, "ScratchPadSize");
+		S32 data_size;
+		dp->unpackS32(data_size, "PartData");
+		dp->shift(dp->getCurrentSize() + data_size);
+	}
+
+	if (value & 0x4)
+	{
+		std::string text;
+		dp->unpackString(text, "Text");
+		U8 color[4];
+		dp->unpackBinaryDataFixed(color, 4, "Color");
+	}
+
+	if (value & 0x200)
+	{
+		std::string media_url;
+		dp->unpackString(media_url, "MediaURL");
+	}
+
+	if (value & 0x8)
+	{
+		LLPartSysData part_sys;
+		part_sys.unpackLegacy(*dp);
+	}
+
+	bool found = false;
+	U8 num_parameters = 0;
+	dp->unpackU8(num_parameters, "num_params");
+	U8 param_block[MAX_OBJECT_PARAMS_SIZE];
+	for (U8 param = 0; param < num_parameters && !found; ++param)
+	{
+		U16 param_type;
+		S32 param_size;
+		dp->unpackU16(param_type, "param_type");
+		if (!dp->unpackBinaryData(param_block, param_size, "param_data"))
+		{
+			break;
+		}
+		if (param_type == LLNetworkData::PARAMS_SCULPT)
+		{
+			LLDataPackerBinaryBuffer dp2(param_block, param_size);
+			found = sculpt.unpack(dp2);
+		}
+	}
+	dp->reset();
+
+	return found;
+}
+
 // Replaces all name value pairs with data from \n delimited list
 // Does not update server
 void LLViewerObject::setNameValueList(const std::string& name_value_list)
@@ -2552,7 +2631,16 @@ void LLViewerObject::idleUpdate(LLAgent &agent, const F64 &frame_time)
 			F32 dt_raw = ((F64Seconds)frame_time - mLastInterpUpdateSecs).value();
 			F32 dt = time_dilation * dt_raw;
 
-			applyAngularVelocity(dt);
+			// Spins about a fixed axis add up, so an object nobody can see
+			// only needs to catch up every so often
+			static LLCachedControl<F32> hidden_period(gSavedSettings, "HiddenObjectAnimationPeriod", 0.f);
+			mHiddenRotTime += dt;
+			if (hidden_period <= 0.f || mHiddenRotTime >= hidden_period ||
+				mDrawable.isNull() || mDrawable->isVisible() || isAttachment() || isSeat())
+			{
+				applyAngularVelocity(mHiddenRotTime);
+				mHiddenRotTime = 0.f;
+			}
 
 			if (isAttachment())
 			{
@@ -4865,7 +4953,7 @@ void LLViewerObject::setNumTEs(const U8 num_tes)
                     LLGLTFMaterial* override_material = src->getGLTFMaterialOverride();
                     if (base_material && override_material)
                     {
-                        tep->setGLTFMaterialOverride(new LLGLTFMaterial(*override_material));
+                        tep->setGLTFMaterialOverride(LLGLTFMaterial::shareOverride(new LLGLTFMaterial(*override_material)));
 
                         LLGLTFMaterial* render_material = new LLFetchedGLTFMaterial();
                         *render_material = *base_material;
@@ -5471,9 +5559,7 @@ S32 LLViewerObject::setTEGLTFMaterialOverride(U8 te, LLGLTFMaterial* override_ma
     {
         if (override_mat)
         {
-            LLFetchedGLTFMaterial* render_mat = new LLFetchedGLTFMaterial(*src_mat);
-            render_mat->applyOverride(*override_mat);
-            tep->setGLTFRenderMaterial(render_mat);
+            tep->setGLTFRenderMaterial(gGLTFMaterialList.getRenderMaterial(src_mat, override_mat));
             retval = TEM_CHANGE_TEXTURE;
 
             for (LLGLTFMaterial::local_tex_map_t::value_type &val : override_mat->mTrackingIdToLocalTexture)
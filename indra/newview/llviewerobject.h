@@ -627,6 +627,8 @@ public:
 	static void unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name);
 	static void unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name);
 	static U32 unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id);
+	// sculpt params of a compressed update, false if it has none
+	static bool unpackSculptParams(LLDataPackerBinaryBuffer* dp, LLSculptParams& sculpt);
 
 public:
 	//counter-translation
@@ -867,6 +869,7 @@ protected:
 	S32				mNumFaces;
 
 	F32				mRotTime;					// Amount (in seconds) that object has rotated according to angular velocity (llSetTargetOmega)
+	F32				mHiddenRotTime;				// Angular velocity time not applied yet while the object is out of view
 	LLQuaternion	mAngularVelocityRot;		// accumulated rotation from the angular velocity computations
 	LLQuaternion	mPreviousRotation;
 
@@ -50,6 +50,7 @@
 #include "llhudnametag.h"
 #include "lldrawable.h"
 #include "llflexibleobject.h"
+#include "llphysicsmotion.h"
 #include "llviewertextureanim.h"
 #include "xform.h"
 #include "llsky.h"
@@ -112,6 +113,8 @@ LLViewerObjectList::LLViewerObjectList()
 	mWasPaused = FALSE;
 	mNumDeadObjectUpdates = 0;
 	mNumUnknownUpdates = 0;
+	mObjectCostBatchStart = 0.0;
+	mPhysicsFlagsBatchStart = 0.0;
 }
 
 LLViewerObjectList::~LLViewerObjectList()
@@ -952,7 +955,14 @@ void LLViewerObjectList::update(LLAgent &agent)
 		}
 	}
 
+	// every avatar has had its idle update, now they can be posed
+	LLVOAvatar::updateDeferredMotions();
 
+	// and their physics run against the new poses
+	LLPhysicsMotionController::updateBatch();
+
+	// attachment LOD changes from the last frame's culling
+	LLVOAvatar::processAttachmentLODRebuilds();
 
 	fetchObjectCosts();
 	fetchPhysicsFlags();
@@ -1020,10 +1030,34 @@ void LLViewerObjectList::update(LLAgent &agent)
 	sample(LLStatViewer::NUM_ACTIVE_OBJECTS, idle_count);
 }
 
+//static
+bool LLViewerObjectList::isBatchDue(F64& batch_start, size_t count)
+{
+	// Gather requests from consecutive frames into one round trip,
+	// unless the batch is already full.
+	static LLCachedControl<F32> coalesce_ms(gSavedSettings, "ObjectRequestCoalesceMS", 0.f);
+	if (coalesce_ms <= 0.f || count >= MAX_CONCURRENT_PHYSICS_REQUESTS)
+	{
+		batch_start = 0.0;
+		return true;
+	}
+	F64 now = LLFrameTimer::getTotalSeconds();
+	if (batch_start == 0.0)
+	{
+		batch_start = now;
+	}
+	if (now - batch_start < coalesce_ms * 0.001f)
+	{
+		return false;
+	}
+	batch_start = 0.0;
+	return true;
+}
+
 void LLViewerObjectList::fetchObjectCosts()
 {
 	// issue http request for stale object physics costs
-	if (!mStaleObjectCost.empty())
+	if (!mStaleObjectCost.empty() && isBatchDue(mObjectCostBatchStart, mStaleObjectCost.size()))
 	{
 		LLViewerRegion* regionp = gAgent.getRegion();
 
@@ -1062,6 +1096,7 @@ void LLViewerObjectList::fetchObjectCostsCoro(std::string url)
     LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t
         httpAdapter(new LLCoreHttpUtil::HttpCoroutineAdapter("genericPostCoro", httpPolicy));
     LLCore::HttpRequest::ptr_t httpRequest(new LLCore::HttpRequest);
+    httpAdapter->setBinaryLLSD(gSavedSettings.getBOOL("HttpBinaryLLSD"));
 
 
 
@@ -1148,7 +1183,7 @@ void LLViewerObjectList::fetchObjectCostsCoro(std::string url)
 void LLViewerObjectList::fetchPhysicsFlags()
 {
 	// issue http request for stale object physics flags
-	if (!mStalePhysicsFlags.empty())
+	if (!mStalePhysicsFlags.empty() && isBatchDue(mPhysicsFlagsBatchStart, mStalePhysicsFlags.size()))
 	{
 		LLViewerRegion* regionp = gAgent.getRegion();
 
@@ -1186,6 +1221,7 @@ void LLViewerObjectList::fetchPhisicsFlagsCoro(std::string url)
     LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t
         httpAdapter(new LLCoreHttpUtil::HttpCoroutineAdapter("genericPostCoro", httpPolicy));
     LLCore::HttpRequest::ptr_t httpRequest(new LLCore::HttpRequest);
+    httpAdapter->setBinaryLLSD(gSavedSettings.getBOOL("HttpBinaryLLSD"));
 
     LLSD idList;
     U32 objectIndex = 0;
@@ -33,6 +33,7 @@
 // common includes
 #include "llstring.h"
 #include "lltrace.h"
+#include "lluuidmap.h"
 
 // project includes
 #include "llviewerobject.h"
@@ -201,7 +202,7 @@ protected:
 
     uuid_set_t   mDeadObjects;
 
-	std::map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
+	LLUUIDMap<LLPointer<LLViewerObject> > mUUIDObjectMap;
 
 	//set of objects that need to update their cost
     uuid_set_t   mStaleObjectCost;
@@ -211,6 +212,10 @@ protected:
     uuid_set_t   mStalePhysicsFlags;
     uuid_set_t   mPendingPhysicsFlags;
 
+	// when the oldest unsent cost / physics flags request was queued, 0 if none
+	F64 mObjectCostBatchStart;
+	F64 mPhysicsFlagsBatchStart;
+
 	std::vector<LLDebugBeacon> mDebugBeacons;
 
 	S32 mCurLazyUpdateIndex;
@@ -223,6 +228,8 @@ protected:
 	friend class LLViewerObject;
 
 private:
+    static bool isBatchDue(F64& batch_start, size_t count);
+
     static void reportObjectCostFailure(LLSD &objectList);
     void fetchObjectCostsCoro(std::string url);
 
@@ -257,7 +264,7 @@ extern LLViewerObjectList gObjectList;
  */
 inline LLViewerObject *LLViewerObjectList::findObject(const LLUUID &id)
 {
-	std::map<LLUUID, LLPointer<LLViewerObject> >::iterator iter = mUUIDObjectMap.find(id);
+	LLUUIDMap<LLPointer<LLViewerObject> >::iterator iter = mUUIDObjectMap.find(id);
 	if(iter != mUUIDObjectMap.end())
 	{
 		return iter->second;
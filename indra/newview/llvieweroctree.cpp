@@ -1197,6 +1197,33 @@ void LLOcclusionCullingGroup::doOcclusion(LLCamera* camera, const LLVector4a* sh
 			clearOcclusionState(LLOcclusionCullingGroup::OCCLUDED, LLOcclusionCullingGroup::STATE_MODE_DIFF);
 			assert_states_valid(this);
 		}
+		else if (LLPipeline::RenderHiZOcclusion &&
+			LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD &&
+			mSpatialPartition->mDrawableType != LLPipeline::RENDER_TYPE_WATER &&
+			mSpatialPartition->mDrawableType != LLPipeline::RENDER_TYPE_VOIDWATER &&
+			gPipeline.mHiZOcclusion.isValid())
+		{ //test against the depth pyramid right away instead of issuing a query
+            LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("doOcclusion - hiz");
+
+			if (mOcclusionQuery[LLViewerCamera::sCurCameraID])
+			{ //left over from before hi-z was switched on
+				releaseOcclusionQueryObjectName(mOcclusionQuery[LLViewerCamera::sCurCameraID]);
+				mOcclusionQuery[LLViewerCamera::sCurCameraID] = 0;
+				clearOcclusionState(QUERY_PENDING | DISCARD_QUERY);
+			}
+
+			LLVector4a size;
+			size.set(bounds[1][0] + SG_OCCLUSION_FUDGE, bounds[1][1] + SG_OCCLUSION_FUDGE, bounds[1][2] + OCCLUSION_FUDGE_Z);
+
+			if (gPipeline.mHiZOcclusion.isOccluded(bounds[0], size))
+			{
+				setOcclusionState(LLOcclusionCullingGroup::OCCLUDED, LLOcclusionCullingGroup::STATE_MODE_DIFF);
+			}
+			else
+			{
+				clearOcclusionState(LLOcclusionCullingGroup::OCCLUDED, LLOcclusionCullingGroup::STATE_MODE_DIFF);
+			}
+		}
 		else
 		{
 			if (!isOcclusionState(QUERY_PENDING) || isOcclusionState(DISCARD_QUERY))
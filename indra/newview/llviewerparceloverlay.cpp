@@ -42,6 +42,7 @@
 #include "llviewercontrol.h"
 #include "llsurface.h"
 #include "llviewerregion.h"
+#include "llviewershadermgr.h"
 #include "llviewercamera.h"
 #include "llviewertexturelist.h"
 #include "llselectmgr.h"
@@ -60,7 +61,8 @@ LLViewerParcelOverlay::LLViewerParcelOverlay(LLViewerRegion* region, F32 region_
 	mOverlayTextureIdx(-1),
 	mVertexCount(0),
 	mVertexArray(NULL),
-	mColorArray(NULL)
+	mColorArray(NULL),
+	mMinimapLinesDirty(true)
 //	mTexCoordArray(NULL),
 {
 	// Create a texture to hold color information.
@@ -71,6 +73,12 @@ LLViewerParcelOverlay::LLViewerParcelOverlay(LLViewerRegion* region, F32 region_
 	mTexture->setAddressMode(LLTexUnit::TAM_CLAMP);
 	mTexture->setFilteringOption(LLTexUnit::TFO_POINT);
 
+	mLinesImageRaw = new LLImageRaw(mParcelGridsPerEdge, mParcelGridsPerEdge, OVERLAY_IMG_COMPONENTS);
+	mLinesImageRaw->clear(0, 0, 0, 0);
+	mLinesTexture = LLViewerTextureManager::getLocalTexture(mLinesImageRaw.get(), FALSE);
+	mLinesTexture->setAddressMode(LLTexUnit::TAM_CLAMP);
+	mLinesTexture->setFilteringOption(LLTexUnit::TFO_POINT);
+
 	//
 	// Initialize the GL texture with empty data.
 	//
@@ -111,6 +119,7 @@ LLViewerParcelOverlay::~LLViewerParcelOverlay()
 //	mTexCoordArray = NULL;
 
 	mImageRaw = NULL;
+	mLinesImageRaw = NULL;
 }
 
 //---------------------------------------------------------------------------
@@ -346,6 +355,7 @@ void LLViewerParcelOverlay::updateOverlayTexture()
 
 	// Create the base texture.
 	U8 *raw = mImageRaw->getData();
+	U8 *lines = mLinesImageRaw->getData();
 	const S32 COUNT = mParcelGridsPerEdge * mParcelGridsPerEdge;
 	S32 max = mOverlayTextureIdx + mParcelGridsPerEdge;
 	if (max > COUNT) max = COUNT;
@@ -409,6 +419,18 @@ void LLViewerParcelOverlay::updateOverlayTexture()
 		raw[pixel_index + 2] = (U8)b;
 		raw[pixel_index + 3] = (U8)a;
 
+		// Same sides updatePropertyLines() draws, east and north come
+		// from the neighbour's west and south lines or the region edge.
+		S32 row = i / mParcelGridsPerEdge;
+		S32 col = i % mParcelGridsPerEdge;
+		bool has_lines = (ownership & PARCEL_COLOR_MASK) != PARCEL_PUBLIC;
+		bool east = col == mParcelGridsPerEdge - 1 || (mOwnership[i + 1] & PARCEL_WEST_LINE);
+		bool north = row == mParcelGridsPerEdge - 1 || (mOwnership[i + mParcelGridsPerEdge] & PARCEL_SOUTH_LINE);
+		lines[pixel_index + 0] = (has_lines && (ownership & PARCEL_WEST_LINE)) ? 255 : 0;
+		lines[pixel_index + 1] = (has_lines && (ownership & PARCEL_SOUTH_LINE)) ? 255 : 0;
+		lines[pixel_index + 2] = (has_lines && east) ? 255 : 0;
+		lines[pixel_index + 3] = (has_lines && north) ? 255 : 0;
+
 		pixel_index += OVERLAY_IMG_COMPONENTS;
 	}
 	
@@ -420,6 +442,11 @@ void LLViewerParcelOverlay::updateOverlayTexture()
 			mTexture->createGLTexture(0, mImageRaw);
 		}
 		mTexture->setSubImage(mImageRaw, 0, 0, mParcelGridsPerEdge, mParcelGridsPerEdge);
+		if (!mLinesTexture->hasGLTexture())
+		{
+			mLinesTexture->createGLTexture(0, mLinesImageRaw);
+		}
+		mLinesTexture->setSubImage(mLinesImageRaw, 0, 0, mParcelGridsPerEdge, mParcelGridsPerEdge);
 		mOverlayTextureIdx = -1;
 	}
 	else
@@ -439,6 +466,7 @@ void LLViewerParcelOverlay::uncompressLandOverlay(S32 chunk, U8 *packed_overlay)
 
 	// Force property lines and overlay texture to update
 	setDirty();
+	mMinimapLinesDirty = true;
 }
 
 
@@ -876,7 +904,15 @@ void LLViewerParcelOverlay::idleUpdate(bool force_update)
 		if (force_update || mTimeSinceLastUpdate.getElapsedTimeF32() > 4.0f)
 		{
 			updateOverlayTexture();
-			updatePropertyLines();
+			if (LLViewerShaderMgr::sTerrainParcelOverlay)
+			{
+				// the terrain shader draws the lines from the textures
+				mDirty = FALSE;
+			}
+			else
+			{
+				updatePropertyLines();
+			}
 			mTimeSinceLastUpdate.reset();
 		}
 	}
@@ -884,7 +920,7 @@ void LLViewerParcelOverlay::idleUpdate(bool force_update)
 
 S32 LLViewerParcelOverlay::renderPropertyLines	() 
 {
-	if (!gSavedSettings.getBOOL("ShowPropertyLines"))
+	if (!gSavedSettings.getBOOL("ShowPropertyLines") || LLViewerShaderMgr::sTerrainParcelOverlay)
 	{
 		return 0;
 	}
@@ -1026,23 +1062,56 @@ S32 LLViewerParcelOverlay::renderPropertyLines	()
 	return drawn;
 }
 
-// Draw half of a single cell (no fill) in a grid drawn from left to right and from bottom to top
-void grid_2d_part_lines(const F32 left, const F32 top, const F32 right, const F32 bottom, bool has_left, bool has_bottom)
+// Collect the minimap's property lines once per overlay update.  Edges that
+// continue into the next cell are merged, so a parcel side is one segment
+// however many grid cells it spans.
+void LLViewerParcelOverlay::updateMinimapLines()
 {
-    gGL.begin(LLRender::LINES);
+    mMinimapLines.clear();
+    const S32 GRIDS_PER_EDGE = mParcelGridsPerEdge;
+    const F32 step           = PARCEL_GRID_STEP_METERS;
 
-    if (has_left)
+    // west edges, run along each column from bottom to top
+    for (S32 j = 0; j < GRIDS_PER_EDGE + 1; j++)
     {
-        gGL.vertex2f(left, bottom);
-        gGL.vertex2f(left, top);
+        S32 run_start = -1;
+        for (S32 i = 0; i < GRIDS_PER_EDGE + 1; i++)
+        {
+            const bool has_left = i != GRIDS_PER_EDGE && (j == GRIDS_PER_EDGE || (mOwnership[(i * GRIDS_PER_EDGE) + j] & PARCEL_WEST_LINE));
+            if (has_left && run_start < 0)
+            {
+                run_start = i;
+            }
+            else if (!has_left && run_start >= 0)
+            {
+                mMinimapLines.emplace_back(j * step, run_start * step);
+                mMinimapLines.emplace_back(j * step, i * step);
+                run_start = -1;
+            }
+        }
     }
-    if (has_bottom)
+
+    // south edges, run along each row from left to right
+    for (S32 i = 0; i < GRIDS_PER_EDGE + 1; i++)
     {
-        gGL.vertex2f(left, bottom);
-        gGL.vertex2f(right, bottom);
+        S32 run_start = -1;
+        for (S32 j = 0; j < GRIDS_PER_EDGE + 1; j++)
+        {
+            const bool has_bottom = j != GRIDS_PER_EDGE && (i == GRIDS_PER_EDGE || (mOwnership[(i * GRIDS_PER_EDGE) + j] & PARCEL_SOUTH_LINE));
+            if (has_bottom && run_start < 0)
+            {
+                run_start = j;
+            }
+            else if (!has_bottom && run_start >= 0)
+            {
+                mMinimapLines.emplace_back(run_start * step, i * step);
+                mMinimapLines.emplace_back(j * step, i * step);
+                run_start = -1;
+            }
+        }
     }
 
-    gGL.end();
+    mMinimapLinesDirty = false;
 }
 
 void LLViewerParcelOverlay::renderPropertyLinesOnMinimap(F32 scale_pixels_per_meter, const F32 *parcel_outline_color)
@@ -1056,31 +1125,23 @@ void LLViewerParcelOverlay::renderPropertyLinesOnMinimap(F32 scale_pixels_per_me
         return;
     }
 
+    if (mMinimapLinesDirty)
+    {
+        updateMinimapLines();
+    }
+
     LLVector3 origin_agent     = mRegion->getOriginAgent();
     LLVector3 rel_region_pos   = origin_agent - gAgentCamera.getCameraPositionAgent();
     F32       region_left      = rel_region_pos.mV[0] * scale_pixels_per_meter;
     F32       region_bottom    = rel_region_pos.mV[1] * scale_pixels_per_meter;
-    F32       map_parcel_width = PARCEL_GRID_STEP_METERS * scale_pixels_per_meter;
-    const S32 GRIDS_PER_EDGE   = mParcelGridsPerEdge;
 
     gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
     glLineWidth(1.0f);
     gGL.color4fv(parcel_outline_color);
-    for (S32 i = 0; i < GRIDS_PER_EDGE + 1; i++)
+    gGL.begin(LLRender::LINES);
+    for (const LLVector2& point : mMinimapLines)
     {
-        const F32 bottom = region_bottom + (i * map_parcel_width);
-        const F32 top    = bottom + map_parcel_width;
-        for (S32 j = 0; j < GRIDS_PER_EDGE + 1; j++)
-        {
-            const F32  left               = region_left + (j * map_parcel_width);
-            const F32  right              = left + map_parcel_width;
-            const bool is_region_boundary = i == GRIDS_PER_EDGE || j == GRIDS_PER_EDGE;
-            const U8   overlay            = is_region_boundary ? 0 : mOwnership[(i * GRIDS_PER_EDGE) + j];
-            // The property line vertices are three-dimensional, but here we only care about the x and y coordinates, as we are drawing on a
-            // 2D map
-            const bool has_left   = i != GRIDS_PER_EDGE && (j == GRIDS_PER_EDGE || (overlay & PARCEL_WEST_LINE));
-            const bool has_bottom = j != GRIDS_PER_EDGE && (i == GRIDS_PER_EDGE || (overlay & PARCEL_SOUTH_LINE));
-            grid_2d_part_lines(left, top, right, bottom, has_left, has_bottom);
-        }
+        gGL.vertex2f(region_left + point.mV[0] * scale_pixels_per_meter, region_bottom + point.mV[1] * scale_pixels_per_meter);
     }
+    gGL.end();
 }
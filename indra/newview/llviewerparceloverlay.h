@@ -49,6 +49,9 @@ public:
 
 	// ACCESS
 	LLViewerTexture*		getTexture() const		{ return mTexture; }
+	// Property line sides per parcel cell for the terrain shader,
+	// west, south, east and north in r, g, b and a.
+	LLViewerTexture*		getLinesTexture() const	{ return mLinesTexture; }
 
 	BOOL			isOwned(const LLVector3& pos) const;
 	BOOL			isOwnedSelf(const LLVector3& pos) const;
@@ -101,6 +104,7 @@ private:
 
 	void 	updateOverlayTexture();
 	void	updatePropertyLines();
+	void	updateMinimapLines();
 	
 private:
 	// Back pointer to the region that owns this structure.
@@ -110,6 +114,8 @@ private:
 
 	LLPointer<LLViewerTexture> mTexture;
 	LLPointer<LLImageRaw> mImageRaw;
+	LLPointer<LLViewerTexture> mLinesTexture;
+	LLPointer<LLImageRaw> mLinesImageRaw;
 	
 	// Size: mParcelGridsPerEdge * mParcelGridsPerEdge
 	// Each value is 0-3, PARCEL_AVAIL to PARCEL_SELF in the two low bits
@@ -124,6 +130,11 @@ private:
 	S32				mVertexCount;
 	F32*			mVertexArray;
 	U8*				mColorArray;
+
+	// Minimap property lines as pairs of end points in region meters,
+	// rebuilt from mOwnership only when a new overlay arrives.
+	std::vector<LLVector2> mMinimapLines;
+	bool			mMinimapLinesDirty;
 };
 
 #endif
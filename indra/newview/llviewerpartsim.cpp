@@ -65,6 +65,40 @@ const F32 LLViewerPartSim::PART_ADAPT_RATE_MULT_RECIP = 1.0f/PART_ADAPT_RATE_MUL
 
 U32 LLViewerPart::sNextPartID = 1;
 
+// Particles are created and destroyed by the thousand per second. They are
+// carved out of blocks that are kept for the session, and a freed particle is
+// the next one handed out, so its memory is likely still in cache.
+static const U32 PART_POOL_BLOCK_SIZE = 512;
+static std::vector<void*> sFreeParts;
+
+//static
+void* LLViewerPart::operator new(size_t size)
+{
+	llassert(size == sizeof(LLViewerPart));
+	if (sFreeParts.empty())
+	{
+		const size_t stride = (sizeof(LLViewerPart) + 15) & ~(size_t)15;
+		U8* block = (U8*)ll_aligned_malloc_16(stride * PART_POOL_BLOCK_SIZE);
+		sFreeParts.reserve(sFreeParts.capacity() + PART_POOL_BLOCK_SIZE);
+		for (U32 i = PART_POOL_BLOCK_SIZE; i > 0; --i)
+		{
+			sFreeParts.push_back(block + stride * (i - 1));
+		}
+	}
+	void* ptr = sFreeParts.back();
+	sFreeParts.pop_back();
+	return ptr;
+}
+
+//static
+void LLViewerPart::operator delete(void* ptr)
+{
+	if (ptr)
+	{
+		sFreeParts.push_back(ptr);
+	}
+}
+
 F32 calc_desired_size(LLViewerCamera* camera, LLVector3 pos, LLVector2 scale)
 {
 	F32 desired_size = (pos - camera->getOrigin()).magVec();
@@ -273,18 +307,14 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 }
 
 
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+void LLViewerPartGroup::integrateParticles(const F32 lastdt)
 {
 	F32 dt;
 	
 	LLVector3 gravity(0.f, 0.f, GRAVITY);
 
-	LLViewerPartSim::checkParticleCount(mParticles.size());
-
-	LLViewerCamera* camera = LLViewerCamera::getInstance();
 	LLViewerRegion *regionp = getRegion();
-	S32 end = (S32) mParticles.size();
-	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
 	{
 		LLVector3 a(0.f, 0.f, 0.f);
 		LLViewerPart* part = mParticles[i] ;
@@ -344,9 +374,23 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 		else
 		{
 			// Do velocity interpolation
-			part->mPosAgent += dt*part->mVelocity;
-			part->mPosAgent += 0.5f*dt*dt*part->mAccel;
-			part->mVelocity += part->mAccel*dt;
+			LLVector4a pos, vel, accel, delta;
+			pos.load3(part->mPosAgent.mV);
+			vel.load3(part->mVelocity.mV);
+			accel.load3(part->mAccel.mV);
+
+			// pos += (vel + 0.5*accel*dt)*dt
+			delta.setMul(accel, 0.5f*dt);
+			delta.add(vel);
+			delta.mul(dt);
+			pos.add(delta);
+
+			// vel += accel*dt
+			delta.setMul(accel, dt);
+			vel.add(delta);
+
+			part->mPosAgent.set(pos.getF32ptr());
+			part->mVelocity.set(vel.getF32ptr());
 		}
 
 		// Do a bounce test
@@ -373,12 +417,11 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 		// Do color interpolation
 		if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
 		{
-			part->mColor.setVec(part->mStartColor);
-			// note: LLColor4's v%k means multiply-alpha-only,
-			//       LLColor4's v*k means multiply-rgb-only
-			part->mColor *= 1.f - frac; // rgb*k
-			part->mColor %= 1.f - frac; // alpha*k
-			part->mColor += frac%(frac*part->mEndColor); // rgb,alpha
+			LLVector4a start_color, end_color, color;
+			start_color.loadua(part->mStartColor.mV);
+			end_color.loadua(part->mEndColor.mV);
+			color.setLerp(start_color, end_color, frac);
+			part->mColor.set(color.getF32ptr());
 		}
 
 		// Do scale interpolation
@@ -394,7 +437,18 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 
 		// Set the last update time to now.
 		part->mLastUpdateTime = cur_time;
+	}
+}
+
+void LLViewerPartGroup::settleParticles()
+{
+	LLViewerPartSim::checkParticleCount(mParticles.size());
 
+	LLViewerCamera* camera = LLViewerCamera::getInstance();
+	S32 end = (S32) mParticles.size();
+	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	{
+		LLViewerPart* part = mParticles[i] ;
 
 		// Kill dead particles (either flagged dead, or too old)
 		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
@@ -522,6 +576,8 @@ void LLViewerPartSim::destroyClass()
 
 	// Kill all of the sources 
 	mViewerPartSources.clear();
+
+	mGPUParticles.cleanup();
 }
 
 //static
@@ -558,6 +614,11 @@ void LLViewerPartSim::addPart(LLViewerPart* part)
 {
 	if (sParticleCount < MAX_PART_COUNT)
 	{
+		if (LLViewerPartSimGPU::isEnabled() && mGPUParticles.addPart(*part))
+		{
+			delete part;
+			return;
+		}
 		put(part);
 	}
 	else
@@ -654,16 +715,26 @@ void LLViewerPartSim::shift(const LLVector3 &offset)
 	{
 		mViewerPartGroups[i]->shift(offset);
 	}
+
+	mGPUParticles.shift(offset);
 }
 
 static LLTrace::BlockTimerStatHandle FTM_SIMULATE_PARTICLES("Simulate Particles");
 
 void LLViewerPartSim::updateSimulation()
+{
+	updateSources();
+	simulateParticles();
+	finishSimulation();
+}
+
+void LLViewerPartSim::updateSources()
 {
 	static LLFrameTimer update_timer;
 
 	const F32 dt = llmin(update_timer.getElapsedTimeAndResetF32(), 0.1f);
 
+	mUpdateGroups.clear();
  	if (!(gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES)))
 	{
 		return;
@@ -768,15 +839,7 @@ void LLViewerPartSim::updateSimulation()
 			{
 				gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_ALL);
 			}
-			mViewerPartGroups[i]->updateParticles(dt * visirate);
-			mViewerPartGroups[i]->mSkippedTime=0.0f;
-			if (!mViewerPartGroups[i]->getCount())
-			{
-				delete mViewerPartGroups[i];
-				mViewerPartGroups.erase(mViewerPartGroups.begin() + i);
-				i--;
-				count--;
-			}
+			mUpdateGroups.push_back(std::make_pair(mViewerPartGroups[i], dt * visirate));
 		}
 		else
 		{	
@@ -784,6 +847,35 @@ void LLViewerPartSim::updateSimulation()
 		}
 
 	}
+}
+
+void LLViewerPartSim::simulateParticles()
+{
+	LL_PROFILE_ZONE_SCOPED;
+	for (const auto& update : mUpdateGroups)
+	{
+		update.first->integrateParticles(update.second);
+		update.first->mSkippedTime = 0.0f;
+	}
+}
+
+void LLViewerPartSim::finishSimulation()
+{
+	LL_RECORD_BLOCK_TIME(FTM_SIMULATE_PARTICLES);
+	for (const auto& update : mUpdateGroups)
+	{
+		LLViewerPartGroup* group = update.first;
+		group->settleParticles();
+		if (!group->getCount())
+		{
+			mViewerPartGroups.erase(std::find(mViewerPartGroups.begin(), mViewerPartGroups.end(), group));
+			delete group;
+		}
+	}
+	mUpdateGroups.clear();
+
+	mGPUParticles.update();
+
 	if (LLDrawable::getCurrentFrame()%16==0)
 	{
 		if (sParticleCount > sMaxParticleCount * 0.875f
@@ -873,6 +965,7 @@ void LLViewerPartSim::clearParticlesByID(const U32 system_id)
 	{
 		(*g)->removeParticlesByID(system_id);
 	}
+	mGPUParticles.clearParticlesByID(system_id);
 	for (source_list_t::iterator i = mViewerPartSources.begin(); i != mViewerPartSources.end(); ++i)
 	{
 		if ((*i)->getID() == system_id)
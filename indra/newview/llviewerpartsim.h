@@ -31,6 +31,7 @@
 #include "llpointer.h"
 #include "llpartdata.h"
 #include "llviewerpartsource.h"
+#include "llviewerpartsimgpu.h"
 
 class LLViewerTexture;
 class LLViewerPart;
@@ -56,6 +57,10 @@ public:
 
 	void init(LLPointer<LLViewerPartSource> sourcep, LLViewerTexture *imagep, LLVPCallback cb);
 
+	// Particles come from a pool of fixed size blocks instead of the heap.
+	// Created and destroyed on the main thread only.
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
 
 	U32					mPartID;					// Particle ID used primarily for moving between groups
 	F32					mLastUpdateTime;			// Last time the particle was updated
@@ -97,7 +102,12 @@ public:
 
 	BOOL addPart(LLViewerPart* part, const F32 desired_size = -1.f);
 	
-	void updateParticles(const F32 lastdt);
+	// Moves and ages the particles. Only touches this group's particles and
+	// reads their sources, so it may run off the main thread.
+	void integrateParticles(const F32 lastdt);
+	// Main thread: kills and regroups the particles integrateParticles() left
+	// dead or out of bounds.
+	void settleParticles();
 
 	BOOL posInGroup(const LLVector3 &pos, const F32 desired_size = -1.f);
 
@@ -146,7 +156,16 @@ public:
 
 	void shift(const LLVector3 &offset);
 
+	// updateSimulation() runs the three steps below in order. They
+	// are also available separately, so that simulateParticles(), the bulk of
+	// the work, can overlap with unrelated frame work on a worker thread.
 	void updateSimulation();
+	// main thread: update the sources and pick the groups to update this frame
+	void updateSources();
+	// any thread, between updateSources() and finishSimulation()
+	void simulateParticles();
+	// main thread
+	void finishSimulation();
 
 	void addPartSource(LLPointer<LLViewerPartSource> sourcep);
 
@@ -175,6 +194,8 @@ public:
 
 	const source_list_t* getParticleSystemList() const { return &mViewerPartSources; }
 
+	LLViewerPartSimGPU& getGPUParticles()	{ return mGPUParticles; }
+
 	friend class LLViewerPartGroup;
 
 	BOOL aboveParticleLimit() const { return sParticleCount > sMaxParticleCount; }
@@ -192,7 +213,10 @@ protected:
 
 	group_list_t mViewerPartGroups;
 	source_list_t mViewerPartSources;
+	// groups updateSources() picked, with the time step for each
+	std::vector<std::pair<LLViewerPartGroup*, F32> > mUpdateGroups;
 	LLFrameTimer mSimulationTimer;
+	LLViewerPartSimGPU mGPUParticles;
 
 	static S32 sMaxParticleCount;
 	static S32 sParticleCount;
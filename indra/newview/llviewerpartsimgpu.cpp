@@ -0,0 +1,473 @@
+/**
+ * @file llviewerpartsimgpu.cpp
+ * @brief Particles simulated and drawn entirely on the GPU.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerpartsimgpu.h"
+
+#include "llagent.h"
+#include "llagentcamera.h"
+#include "llviewercontrol.h"
+#include "llviewerpartsim.h"
+#include "llviewerregion.h"
+#include "llviewershadermgr.h"
+#include "llviewertexture.h"
+#include "llvertexbuffer.h"
+
+// Flags of particles that follow their source or other particles after they
+// are emitted, which only the CPU path knows about.
+static const U32 CPU_ONLY_FLAGS = LLPartData::LL_PART_FOLLOW_SRC_MASK |
+								  LLPartData::LL_PART_TARGET_POS_MASK |
+								  LLPartData::LL_PART_TARGET_LINEAR_MASK |
+								  LLPartData::LL_PART_BEAM_MASK |
+								  LLPartData::LL_PART_RIBBON_MASK |
+								  LLPartData::LL_PART_HUD;
+
+// Batches are at most this many, the rest of the particles go to the CPU.
+static const U32 MAX_BATCHES = 64;
+
+// Seconds a batch keeps its buffers after its last particle died.
+static const F32 BATCH_IDLE_TIME = 10.f;
+
+// Texture area asked for on behalf of the particles of a batch.
+static const F32 PARTICLE_TEXTURE_AREA = 256.f * 256.f;
+
+const char* LLViewerPartSimGPU::sFeedbackVaryings[2] = { "out_pos_age", "out_velocity" };
+
+static const char* DYNAMIC_ATTRIBUTES[] = { "pos_age", "velocity" };
+static const char* STATIC_ATTRIBUTES[] = { "accel_flags", "part_params", "start_color", "end_color", "part_scale" };
+
+// Points the named vec4 attributes of program at consecutive vec4s of the
+// bound array buffer, and remembers the locations it enabled.
+static void enable_attributes(GLuint program, const char** names, U32 count, U32 stride, U32 divisor, std::vector<GLint>& enabled)
+{
+	for (U32 i = 0; i < count; ++i)
+	{
+		GLint loc = glGetAttribLocation(program, names[i]);
+		if (loc < 0)
+		{
+			continue;
+		}
+		glEnableVertexAttribArray(loc);
+		glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, stride, (const void*)(uintptr_t)(i * sizeof(F32) * 4));
+		glVertexAttribDivisor(loc, divisor);
+		enabled.push_back(loc);
+	}
+}
+
+static void disable_attributes(std::vector<GLint>& enabled)
+{
+	for (GLint loc : enabled)
+	{
+		glVertexAttribDivisor(loc, 0);
+		glDisableVertexAttribArray(loc);
+	}
+	enabled.clear();
+}
+
+LLViewerPartSimGPU::Batch::Batch()
+:	mBlendSrc(LLRender::BF_SOURCE_ALPHA),
+	mBlendDst(LLRender::BF_ONE_MINUS_SOURCE_ALPHA),
+	mStaticBuffer(0),
+	mCurrent(0),
+	mNext(0),
+	mLive(0),
+	mLastAddTime(0.f)
+{
+	mDynamicBuffers[0] = mDynamicBuffers[1] = 0;
+	mDeathTime.resize(BATCH_CAPACITY, -1.f);
+	mSourceIDs.resize(BATCH_CAPACITY, 0);
+}
+
+LLViewerPartSimGPU::LLViewerPartSimGPU()
+:	mTime(0.f)
+{
+}
+
+LLViewerPartSimGPU::~LLViewerPartSimGPU()
+{
+	cleanup();
+}
+
+// static
+bool LLViewerPartSimGPU::isEnabled()
+{
+	static LLCachedControl<bool> gpu_particles(gSavedSettings, "RenderParticlesGPU", false);
+	return gpu_particles && gGLManager.mHasTransformFeedback &&
+		gGPUParticleUpdateProgram.mProgramObject && gGPUParticleProgram.mProgramObject;
+}
+
+LLViewerPartSimGPU::Batch* LLViewerPartSimGPU::getBatch(const LLViewerPart& part)
+{
+	LLRender::eBlendFactor src = (LLRender::eBlendFactor) part.mBlendFuncSource;
+	LLRender::eBlendFactor dst = (LLRender::eBlendFactor) part.mBlendFuncDest;
+	for (Batch* batch : mBatches)
+	{
+		if (batch->mImagep == part.mImagep && batch->mBlendSrc == src && batch->mBlendDst == dst)
+		{
+			return batch;
+		}
+	}
+	if (mBatches.size() >= MAX_BATCHES)
+	{
+		return NULL;
+	}
+
+	Batch* batch = new Batch;
+	batch->mImagep = part.mImagep;
+	batch->mBlendSrc = src;
+	batch->mBlendDst = dst;
+	allocateBuffers(*batch);
+	mBatches.push_back(batch);
+	return batch;
+}
+
+void LLViewerPartSimGPU::allocateBuffers(Batch& batch)
+{
+	// age past max age marks a free slot for both passes
+	std::vector<DynamicState> dynamic(BATCH_CAPACITY);
+	memset(&dynamic[0], 0, dynamic.size() * sizeof(DynamicState));
+	for (DynamicState& state : dynamic)
+	{
+		state.mPosAge[3] = 1.f;
+	}
+	std::vector<StaticState> statics(BATCH_CAPACITY);
+	memset(&statics[0], 0, statics.size() * sizeof(StaticState));
+
+	glGenBuffers(2, batch.mDynamicBuffers);
+	glGenBuffers(1, &batch.mStaticBuffer);
+	for (U32 i = 0; i < 2; ++i)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, batch.mDynamicBuffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, dynamic.size() * sizeof(DynamicState), &dynamic[0], GL_DYNAMIC_COPY);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, batch.mStaticBuffer);
+	glBufferData(GL_ARRAY_BUFFER, statics.size() * sizeof(StaticState), &statics[0], GL_DYNAMIC_DRAW);
+	LLVertexBuffer::unbind();
+}
+
+void LLViewerPartSimGPU::releaseBuffers(Batch& batch)
+{
+	if (batch.mStaticBuffer)
+	{
+		glDeleteBuffers(2, batch.mDynamicBuffers);
+		glDeleteBuffers(1, &batch.mStaticBuffer);
+		batch.mDynamicBuffers[0] = batch.mDynamicBuffers[1] = 0;
+		batch.mStaticBuffer = 0;
+	}
+	if (batch.mLive)
+	{
+		LLViewerPartSim::decPartCount(batch.mLive);
+		LLViewerPartSim::sParticleCount2 -= batch.mLive;
+		batch.mLive = 0;
+	}
+}
+
+bool LLViewerPartSimGPU::addPart(const LLViewerPart& part)
+{
+	if ((part.mFlags & CPU_ONLY_FLAGS) || part.mVPCallback || part.mImagep.isNull() ||
+		part.mImagep->hasParcelMedia() || !part.mPosAgent.isFinite())
+	{
+		return false;
+	}
+
+	Batch* batch = getBatch(part);
+	if (!batch)
+	{
+		return false;
+	}
+
+	U32 slot = BATCH_CAPACITY;
+	for (U32 i = 0; i < BATCH_CAPACITY; ++i)
+	{
+		U32 candidate = (batch->mNext + i) % BATCH_CAPACITY;
+		if (batch->mDeathTime[candidate] < 0.f)
+		{
+			slot = candidate;
+			break;
+		}
+	}
+	if (slot == BATCH_CAPACITY)
+	{
+		return false;
+	}
+	batch->mNext = (slot + 1) % BATCH_CAPACITY;
+	batch->mDeathTime[slot] = mTime + part.mMaxAge - part.mLastUpdateTime;
+	batch->mSourceIDs[slot] = part.mPartSourcep.notNull() ? part.mPartSourcep->getID() : 0;
+	batch->mLastAddTime = mTime;
+	++batch->mLive;
+	LLViewerPartSim::incPartCount(1);
+	++LLViewerPartSim::sParticleCount2;
+
+	// The next update shifts everything by the pending shift, this one
+	// included.
+	LLVector3 pos = part.mPosAgent - mPendingShift;
+
+	DynamicState dynamic;
+	dynamic.mPosAge[0] = pos.mV[VX];
+	dynamic.mPosAge[1] = pos.mV[VY];
+	dynamic.mPosAge[2] = pos.mV[VZ];
+	dynamic.mPosAge[3] = part.mLastUpdateTime;
+	dynamic.mVelocity[0] = part.mVelocity.mV[VX];
+	dynamic.mVelocity[1] = part.mVelocity.mV[VY];
+	dynamic.mVelocity[2] = part.mVelocity.mV[VZ];
+	dynamic.mVelocity[3] = part.mMaxAge;
+
+	StaticState statics;
+	statics.mAccelFlags[0] = part.mAccel.mV[VX];
+	statics.mAccelFlags[1] = part.mAccel.mV[VY];
+	statics.mAccelFlags[2] = part.mAccel.mV[VZ];
+	statics.mAccelFlags[3] = (F32)(part.mFlags & 0xffff);
+	statics.mParams[0] = part.mStartGlow;
+	statics.mParams[1] = part.mEndGlow;
+	// The CPU path bounces off the source's current height, the GPU off the
+	// height at emission.
+	statics.mParams[2] = (part.mPartSourcep.notNull() ? part.mPartSourcep->mPosAgent.mV[VZ] : part.mPosAgent.mV[VZ]) - mShiftTotal.mV[VZ];
+	statics.mParams[3] = 0.f;
+	memcpy(statics.mStartColor, part.mStartColor.mV, sizeof(statics.mStartColor));
+	memcpy(statics.mEndColor, part.mEndColor.mV, sizeof(statics.mEndColor));
+	if (!(part.mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK))
+	{
+		memcpy(statics.mStartColor, part.mColor.mV, sizeof(statics.mStartColor));
+	}
+	LLVector2 start_scale = (part.mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK) ? part.mStartScale : part.mScale;
+	statics.mScale[0] = start_scale.mV[0];
+	statics.mScale[1] = start_scale.mV[1];
+	statics.mScale[2] = part.mEndScale.mV[0];
+	statics.mScale[3] = part.mEndScale.mV[1];
+
+	batch->mPendingSlots.push_back(slot);
+	batch->mPendingDynamic.push_back(dynamic);
+	batch->mPendingStatic.push_back(statics);
+	return true;
+}
+
+void LLViewerPartSimGPU::uploadPending(Batch& batch)
+{
+	U32 count = (U32)batch.mPendingSlots.size();
+	U32 start = 0;
+	while (start < count)
+	{
+		// one upload per run of consecutive slots
+		U32 end = start + 1;
+		while (end < count && batch.mPendingSlots[end] == batch.mPendingSlots[end - 1] + 1)
+		{
+			++end;
+		}
+		U32 slot = batch.mPendingSlots[start];
+		glBindBuffer(GL_ARRAY_BUFFER, batch.mDynamicBuffers[batch.mCurrent]);
+		glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(DynamicState), (end - start) * sizeof(DynamicState), &batch.mPendingDynamic[start]);
+		glBindBuffer(GL_ARRAY_BUFFER, batch.mStaticBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(StaticState), (end - start) * sizeof(StaticState), &batch.mPendingStatic[start]);
+		start = end;
+	}
+	batch.mPendingSlots.clear();
+	batch.mPendingDynamic.clear();
+	batch.mPendingStatic.clear();
+}
+
+void LLViewerPartSimGPU::update()
+{
+	LL_PROFILE_ZONE_SCOPED;
+	const F32 dt = llmin(mUpdateTimer.getElapsedTimeAndResetF32(), 0.1f);
+	if (mBatches.empty())
+	{
+		mPendingShift.clear();
+		return;
+	}
+	mTime += dt;
+
+	// The CPU path samples the wind at every particle, this uses the wind
+	// where the agent is for all of them.
+	LLVector3 wind;
+	LLViewerRegion* regionp = gAgent.getRegion();
+	if (regionp)
+	{
+		wind = regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(gAgent.getPositionAgent()));
+	}
+
+	LLVertexBuffer::unbind();
+	LLVertexBuffer::setupClientArrays(0);
+
+	LLGLSLShader* shader = &gGPUParticleUpdateProgram;
+	shader->bind();
+	static LLStaticHashedString sDeltaTime("delta_time");
+	static LLStaticHashedString sWindVelocity("wind_velocity");
+	static LLStaticHashedString sAgentShift("agent_shift");
+	static LLStaticHashedString sBounceOffset("bounce_offset");
+	shader->uniform1f(sDeltaTime, dt);
+	shader->uniform3fv(sWindVelocity, 1, wind.mV);
+	shader->uniform3fv(sAgentShift, 1, mPendingShift.mV);
+	shader->uniform1f(sBounceOffset, mShiftTotal.mV[VZ]);
+	mPendingShift.clear();
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	std::vector<GLint> enabled;
+	for (Batch* batch : mBatches)
+	{
+		uploadPending(*batch);
+
+		glBindBuffer(GL_ARRAY_BUFFER, batch->mDynamicBuffers[batch->mCurrent]);
+		enable_attributes(shader->mProgramObject, DYNAMIC_ATTRIBUTES, LL_ARRAY_SIZE(DYNAMIC_ATTRIBUTES), sizeof(DynamicState), 0, enabled);
+		glBindBuffer(GL_ARRAY_BUFFER, batch->mStaticBuffer);
+		enable_attributes(shader->mProgramObject, STATIC_ATTRIBUTES, LL_ARRAY_SIZE(STATIC_ATTRIBUTES), sizeof(StaticState), 0, enabled);
+
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, batch->mDynamicBuffers[1 - batch->mCurrent]);
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, 0, BATCH_CAPACITY);
+		glEndTransformFeedback();
+		disable_attributes(enabled);
+		batch->mCurrent = 1 - batch->mCurrent;
+
+		S32 died = 0;
+		for (F32& death_time : batch->mDeathTime)
+		{
+			if (death_time >= 0.f && death_time <= mTime)
+			{
+				death_time = -1.f;
+				++died;
+			}
+		}
+		if (died)
+		{
+			batch->mLive -= died;
+			LLViewerPartSim::decPartCount(died);
+			LLViewerPartSim::sParticleCount2 -= died;
+		}
+		if (batch->mLive)
+		{
+			batch->mImagep->addTextureStats(PARTICLE_TEXTURE_AREA);
+		}
+	}
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+	shader->unbind();
+	LLVertexBuffer::unbind();
+
+	for (std::vector<Batch*>::iterator it = mBatches.begin(); it != mBatches.end(); )
+	{
+		Batch* batch = *it;
+		if (!batch->mLive && mTime - batch->mLastAddTime > BATCH_IDLE_TIME)
+		{
+			releaseBuffers(*batch);
+			delete batch;
+			it = mBatches.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void LLViewerPartSimGPU::render()
+{
+	LL_PROFILE_ZONE_SCOPED;
+	if (mBatches.empty())
+	{
+		return;
+	}
+
+	LLGLSLShader* shader = &gGPUParticleProgram;
+	shader->bind();
+	gGL.syncMatrices();
+	static LLStaticHashedString sCameraPosition("camera_position");
+	shader->uniform3fv(sCameraPosition, 1, gAgentCamera.getCameraPositionAgent().mV);
+	S32 channel = shader->enableTexture(LLShaderMgr::DIFFUSE_MAP);
+
+	LLVertexBuffer::unbind();
+	LLVertexBuffer::setupClientArrays(0);
+
+	std::vector<GLint> enabled;
+	for (Batch* batch : mBatches)
+	{
+		if (!batch->mLive)
+		{
+			continue;
+		}
+		gGL.getTexUnit(channel)->bind(batch->mImagep);
+		gGL.blendFunc(batch->mBlendSrc, batch->mBlendDst, LLRender::BF_ZERO, LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+
+		glBindBuffer(GL_ARRAY_BUFFER, batch->mDynamicBuffers[batch->mCurrent]);
+		enable_attributes(shader->mProgramObject, DYNAMIC_ATTRIBUTES, LL_ARRAY_SIZE(DYNAMIC_ATTRIBUTES), sizeof(DynamicState), 1, enabled);
+		glBindBuffer(GL_ARRAY_BUFFER, batch->mStaticBuffer);
+		enable_attributes(shader->mProgramObject, STATIC_ATTRIBUTES, LL_ARRAY_SIZE(STATIC_ATTRIBUTES), sizeof(StaticState), 1, enabled);
+
+		// free slots collapse to a point in the vertex shader
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, BATCH_CAPACITY);
+		disable_attributes(enabled);
+	}
+
+	LLVertexBuffer::unbind();
+	shader->disableTexture(LLShaderMgr::DIFFUSE_MAP);
+	shader->unbind();
+	gGL.blendFunc(LLRender::BF_SOURCE_ALPHA, LLRender::BF_ONE_MINUS_SOURCE_ALPHA, LLRender::BF_ZERO, LLRender::BF_ONE_MINUS_SOURCE_ALPHA);
+}
+
+void LLViewerPartSimGPU::shift(const LLVector3& offset)
+{
+	mShiftTotal += offset;
+	mPendingShift += offset;
+}
+
+void LLViewerPartSimGPU::clearParticlesByID(U32 source_id)
+{
+	for (Batch* batch : mBatches)
+	{
+		for (U32 slot = 0; slot < BATCH_CAPACITY; ++slot)
+		{
+			if (batch->mDeathTime[slot] < 0.f || batch->mSourceIDs[slot] != source_id)
+			{
+				continue;
+			}
+			batch->mDeathTime[slot] = -1.f;
+			--batch->mLive;
+			LLViewerPartSim::decPartCount(1);
+			--LLViewerPartSim::sParticleCount2;
+
+			// overwrite the slot with a dead particle at the next update
+			DynamicState dynamic;
+			memset(&dynamic, 0, sizeof(dynamic));
+			dynamic.mPosAge[3] = 1.f;
+			StaticState statics;
+			memset(&statics, 0, sizeof(statics));
+			batch->mPendingSlots.push_back(slot);
+			batch->mPendingDynamic.push_back(dynamic);
+			batch->mPendingStatic.push_back(statics);
+		}
+	}
+}
+
+void LLViewerPartSimGPU::cleanup()
+{
+	for (Batch* batch : mBatches)
+	{
+		releaseBuffers(*batch);
+		delete batch;
+	}
+	mBatches.clear();
+	mPendingShift.clear();
+}
@@ -0,0 +1,138 @@
+/**
+ * @file llviewerpartsimgpu.h
+ * @brief Particles simulated and drawn entirely on the GPU.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVIEWERPARTSIMGPU_H
+#define LL_LLVIEWERPARTSIMGPU_H
+
+#include "llframetimer.h"
+#include "llpointer.h"
+#include "llrender.h"
+#include "v3math.h"
+
+#include <vector>
+
+class LLViewerPart;
+class LLViewerTexture;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLViewerPartSimGPU
+//
+// GPU backend of LLViewerPartSim (RenderParticlesGPU). Particles that need
+// nothing from their source after they are emitted are copied into a GPU
+// buffer when LLViewerPartSim::addPart() is handed them, instead of becoming
+// LLViewerParts in a LLViewerPartGroup. A transform feedback pass of
+// gGPUParticleUpdateProgram integrates them every frame, and
+// gGPUParticleProgram draws them as instanced billboards at the end of the
+// post water alpha pass.
+//
+// Particles are kept in batches, one per texture and blend function, of
+// ring buffers of BATCH_CAPACITY slots. The CPU only keeps when each slot
+// dies, for the particle count that throttles the sources.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLViewerPartSimGPU
+{
+public:
+	LLViewerPartSimGPU();
+	~LLViewerPartSimGPU();
+
+	// Setting on and transform feedback supported.
+	static bool isEnabled();
+
+	// Takes a copy of the particle if the GPU can simulate it. False if the
+	// particle needs the CPU path.
+	bool addPart(const LLViewerPart& part);
+
+	// Main thread, once per frame: uploads the particles added since the
+	// last update and integrates all of them.
+	void update();
+	void render();
+
+	void shift(const LLVector3& offset);
+	void clearParticlesByID(U32 source_id);
+
+	// Drops every particle and frees the GL buffers.
+	void cleanup();
+
+	// Outputs of gGPUParticleUpdateProgram captured by transform feedback.
+	static const char* sFeedbackVaryings[2];
+
+private:
+	static const U32 BATCH_CAPACITY = 1024;
+
+	// Changes every update, ping-ponged between two buffers.
+	struct DynamicState
+	{
+		F32 mPosAge[4];			// agent position, age
+		F32 mVelocity[4];		// velocity, max age
+	};
+
+	// Written once when the particle is added.
+	struct StaticState
+	{
+		F32 mAccelFlags[4];		// acceleration, LLPartData flags
+		F32 mParams[4];			// start glow, end glow, bounce height
+		F32 mStartColor[4];
+		F32 mEndColor[4];
+		F32 mScale[4];			// start scale, end scale
+	};
+
+	struct Batch
+	{
+		Batch();
+
+		LLPointer<LLViewerTexture>	mImagep;
+		LLRender::eBlendFactor		mBlendSrc;
+		LLRender::eBlendFactor		mBlendDst;
+
+		U32 mDynamicBuffers[2];
+		U32 mStaticBuffer;
+		U32 mCurrent;			// which dynamic buffer holds the current state
+
+		std::vector<F32> mDeathTime;	// per slot, negative when free
+		std::vector<U32> mSourceIDs;	// per slot
+		U32 mNext;				// where the search for a free slot starts
+		S32 mLive;
+		F32 mLastAddTime;
+
+		// Added since the last update.
+		std::vector<U32>			mPendingSlots;
+		std::vector<DynamicState>	mPendingDynamic;
+		std::vector<StaticState>	mPendingStatic;
+	};
+
+	Batch* getBatch(const LLViewerPart& part);
+	void allocateBuffers(Batch& batch);
+	void releaseBuffers(Batch& batch);
+	void uploadPending(Batch& batch);
+
+	std::vector<Batch*> mBatches;
+	LLFrameTimer	mUpdateTimer;
+	F32				mTime;			// simulated seconds, for the death times
+	LLVector3		mShiftTotal;	// bounce heights are kept relative to this
+	LLVector3		mPendingShift;	// not applied on the GPU yet
+};
+
+#endif // LL_LLVIEWERPARTSIMGPU_H
@@ -34,6 +34,7 @@
 #include "llavatarnamecache.h"		// name lookup cap url
 #include "llfloaterreg.h"
 #include "llmath.h"
+#include "llmessagedecoders.h"
 #include "llregionflags.h"
 #include "llregionhandle.h"
 #include "llsurface.h"
@@ -69,6 +70,7 @@
 #include "llvocache.h"
 #include "llworld.h"
 #include "llspatialpartition.h"
+#include "llstreamingpriority.h"
 #include "stringize.h"
 #include "llviewercontrol.h"
 #include "llsdserialize.h"
@@ -652,6 +654,7 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
 	mPaused(FALSE),
 	mRegionCacheHitCount(0),
 	mRegionCacheMissCount(0),
+	mMeshFaceSavings(0),
     mInterestListMode(IL_MODE_DEFAULT)
 {
 	mWidth = region_width_meters;
@@ -1502,6 +1505,11 @@ void LLViewerRegion::createVisibleObjects(F32 max_time)
 
 		if(vo_entry->getState() < LLVOCacheEntry::WAITING)
 		{
+			LLVector3 center_agent(vo_entry->getPositionGroup().getF32ptr());
+			center_agent += getOriginAgent();
+			LLStreamingPriority::noteIssued(LLStreamingPriority::STREAM_OBJECT,
+				LLStreamingPriority::calcImportance(center_agent, vo_entry->getBinRadius(), true));
+
 			addNewObject(vo_entry);
 			has_new_obj = TRUE;
 			if(throttle > 0 && !(--throttle) && update_timer.getElapsedTimeF32() > max_time)
@@ -1658,6 +1666,12 @@ void LLViewerRegion::idleCleanup(F32 max_update_time)
     {
         sRegionCacheCleanup.erase(sRegionCacheCleanup.begin());
     }
+
+    // regions saved this frame share one header write
+    if (LLVOCache::instanceExists())
+    {
+        LLVOCache::getInstance()->flushCacheHeader();
+    }
 }
 
 //update the throttling number for new object creation
@@ -2275,7 +2289,7 @@ LLHTTPRegistration<CoarseLocationUpdate>
 
 
 // the deprecated coarse location handler
-void LLViewerRegion::updateCoarseLocations(LLMessageSystem* msg)
+void LLViewerRegion::updateCoarseLocations(const LLMsgCoarseLocationUpdate& msg)
 {
 	//LL_INFOS() << "CoarseLocationUpdate" << LL_ENDL;
 	mMapAvatars.clear();
@@ -2287,22 +2301,21 @@ void LLViewerRegion::updateCoarseLocations(LLMessageSystem* msg)
 
 	U32 pos = 0x0;
 
-	S16 agent_index;
-	S16 target_index;
-	msg->getS16Fast(_PREHASH_Index, _PREHASH_You, agent_index);
-	msg->getS16Fast(_PREHASH_Index, _PREHASH_Prey, target_index);
+	S16 agent_index = msg.mIndex.You;
+	S16 target_index = msg.mIndex.Prey;
 
-	BOOL has_agent_data = msg->has(_PREHASH_AgentData);
-	S32 count = msg->getNumberOfBlocksFast(_PREHASH_Location);
+	BOOL has_agent_data = !msg.mAgentData.empty();
+	S32 count = msg.mLocation.size();
 	for(S32 i = 0; i < count; i++)
 	{
-		msg->getU8Fast(_PREHASH_Location, _PREHASH_X, x_pos, i);
-		msg->getU8Fast(_PREHASH_Location, _PREHASH_Y, y_pos, i);
-		msg->getU8Fast(_PREHASH_Location, _PREHASH_Z, z_pos, i);
+		LLMsgCoarseLocationUpdate::Location location = msg.mLocation[i];
+		x_pos = location.X;
+		y_pos = location.Y;
+		z_pos = location.Z;
 		LLUUID agent_id = LLUUID::null;
-		if(has_agent_data)
+		if(has_agent_data && i < msg.mAgentData.size())
 		{
-			msg->getUUIDFast(_PREHASH_AgentData, _PREHASH_AgentID, agent_id, i);
+			agent_id = msg.mAgentData[i].AgentID;
 		}
 
 		//LL_INFOS() << "  object X: " << (S32)x_pos << " Y: " << (S32)y_pos
@@ -2691,6 +2704,28 @@ LLVOCacheEntry* LLViewerRegion::getCacheEntry(U32 local_id, bool valid)
 	return NULL;
 }
 
+void LLViewerRegion::getIdleCacheEntries(const LLVector3& pos_region, F32 radius, std::vector<LLVOCacheEntry*>& entries)
+{
+	LLVector4a center;
+	center.load3(pos_region.mV);
+
+	for(LLVOCacheEntry::vocache_entry_map_t::iterator iter = mImpl->mCacheMap.begin(); iter != mImpl->mCacheMap.end(); ++iter)
+	{
+		LLVOCacheEntry* entry = iter->second;
+		if(!entry->hasState(LLVOCacheEntry::IN_VO_TREE) || !entry->isValid())
+		{
+			continue;
+		}
+
+		LLVector4a offset;
+		offset.setSub(entry->getPositionGroup(), center);
+		if(offset.getLength3().getF32() - entry->getBinRadius() <= radius)
+		{
+			entries.push_back(entry);
+		}
+	}
+}
+
 void LLViewerRegion::addCacheMiss(U32 id, LLViewerRegion::eCacheMissType cache_miss_type)
 {
 	mRegionCacheMissCount++;
@@ -2794,6 +2829,39 @@ void LLViewerRegion::requestCacheMisses()
 		return;
 	}
 
+	static LLCachedControl<F32> coalesce_ms(gSavedSettings, "ObjectRequestCoalesceMS", 0.f);
+	if (coalesce_ms > 0.f)
+	{
+		// Gather misses from consecutive frames into full messages, and
+		// ask once per object: a total miss covers a CRC miss.
+		if (mCacheMissList.size() < 255 && mCacheMissTimer.getElapsedTimeF32() * 1000.f < coalesce_ms)
+		{
+			return;
+		}
+		std::map<U32, eCacheMissType> misses;
+		for (const CacheMissItem& item : mCacheMissList)
+		{
+			std::map<U32, eCacheMissType>::iterator found = misses.find(item.mID);
+			if (found == misses.end())
+			{
+				misses[item.mID] = item.mType;
+			}
+			else
+			{
+				found->second = llmin(found->second, item.mType);
+			}
+		}
+		if (misses.size() < mCacheMissList.size())
+		{
+			mCacheMissList.clear();
+			for (const auto& miss : misses)
+			{
+				mCacheMissList.push_back(CacheMissItem(miss.first, miss.second));
+			}
+		}
+	}
+	mCacheMissTimer.reset();
+
 	LLMessageSystem* msg = gMessageSystem;
 	BOOL start_new_message = TRUE;
 	S32 blocks = 0;
@@ -3363,6 +3431,16 @@ void LLViewerRegion::setCapabilitiesReceived(bool received)
 
 		// Set the region to the desired interest list mode
         setInterestListMode(gAgent.getInterestListMode());
+
+		// Warm up the asset connections for the region the agent
+		// is in or teleporting to
+		if (!mViewerAssetUrl.empty()
+			&& (gAgent.getRegion() == this || gAgent.getTeleportState() != LLAgent::TELEPORT_NONE))
+		{
+			LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
+			app_core_http.preconnect(LLAppCoreHttp::AP_TEXTURE, mViewerAssetUrl);
+			app_core_http.preconnect(LLAppCoreHttp::AP_MESH2, mViewerAssetUrl);
+		}
 	}
 }
 
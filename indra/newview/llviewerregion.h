@@ -56,6 +56,7 @@ class LLEventPoll;
 class LLVLComposition;
 class LLViewerObject;
 class LLMessageSystem;
+struct LLMsgCoarseLocationUpdate;
 class LLNetMap;
 class LLViewerParcelOverlay;
 class LLSurface;
@@ -316,7 +317,7 @@ public:
 	BOOL isOwnedGroup(const LLVector3& pos);
 
 	// deal with map object updates in the world.
-	void updateCoarseLocations(LLMessageSystem* msg);
+	void updateCoarseLocations(const LLMsgCoarseLocationUpdate& msg);
 
 	F32 getLandHeightRegion(const LLVector3& region_pos);
 
@@ -366,9 +367,17 @@ public:
 
 	LLVOCacheEntry* getCacheEntryForOctree(U32 local_id);
 	LLVOCacheEntry* getCacheEntry(U32 local_id, bool valid = true);
+	// root entries of the object cache partition, cached objects not rezzed yet,
+	// that come within radius of pos_region
+	void getIdleCacheEntries(const LLVector3& pos_region, F32 radius, std::vector<LLVOCacheEntry*>& entries);
 	bool probeCache(U32 local_id, U32 crc, U32 flags, U8 &cache_miss_type);
 	U64 getRegionCacheHitCount() { return mRegionCacheHitCount; }
 	U64 getRegionCacheMissCount() { return mRegionCacheMissCount; }
+
+	// bytes saved by keeping this region's idle mesh faces compressed, see
+	// LLMeshRepository::updateCompressedFaces()
+	U64 getMeshFaceSavings() const { return mMeshFaceSavings; }
+	void setMeshFaceSavings(U64 bytes) { mMeshFaceSavings = bytes; }
 	void requestCacheMisses();
 	void addCacheMissFull(const U32 local_id);
 	//update object cache if the object receives a full-update or terse update
@@ -588,8 +597,10 @@ public:
 		typedef std::list<CacheMissItem> cache_miss_list_t;
 	};
 	CacheMissItem::cache_miss_list_t   mCacheMissList;
+	LLFrameTimer mCacheMissTimer; // since cache misses were last sent
 	U64 mRegionCacheHitCount;
 	U64 mRegionCacheMissCount;
+	U64 mMeshFaceSavings;
 
 	caps_received_signal_t mCapabilitiesReceivedSignal;		
 	caps_received_signal_t mSimulatorFeaturesReceivedSignal;		
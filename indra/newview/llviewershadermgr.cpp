@@ -32,6 +32,7 @@
 #include "llfeaturemanager.h"
 #include "llviewershadermgr.h"
 #include "llviewercontrol.h"
+#include "llviewerpartsimgpu.h"
 #include "llversioninfo.h"
 
 #include "llrender.h"
@@ -66,6 +67,10 @@ using std::string;
 
 BOOL				LLViewerShaderMgr::sInitialized = FALSE;
 bool				LLViewerShaderMgr::sSkipReload = false;
+U32					LLViewerShaderMgr::sMaxSkinInstances = 0;
+U32					LLViewerShaderMgr::sMaxTreeInstances = 0;
+bool				LLViewerShaderMgr::sTerrainParcelOverlay = false;
+bool				LLViewerShaderMgr::sUseAtmosphericsUBO = false;
 
 LLVector4			gShinyOrigin;
 
@@ -85,6 +90,7 @@ LLGLSLShader	gDebugProgram;
 LLGLSLShader    gSkinnedDebugProgram;
 LLGLSLShader	gClipProgram;
 LLGLSLShader	gAlphaMaskProgram;
+LLGLSLShader	gAlphaGradientProgram;
 LLGLSLShader	gBenchmarkProgram;
 LLGLSLShader    gReflectionProbeDisplayProgram;
 LLGLSLShader    gCopyProgram;
@@ -134,12 +140,21 @@ LLGLSLShader            gDeferredSkinnedDiffuseAlphaMaskProgram;
 LLGLSLShader			gDeferredNonIndexedDiffuseAlphaMaskProgram;
 LLGLSLShader			gDeferredNonIndexedDiffuseAlphaMaskNoColorProgram;
 LLGLSLShader			gDeferredSkinnedDiffuseProgram;
+LLGLSLShader			gDeferredSkinInstancedDiffuseProgram;
 LLGLSLShader			gDeferredSkinnedBumpProgram;
 LLGLSLShader			gDeferredBumpProgram;
 LLGLSLShader			gDeferredTerrainProgram;
+LLGLSLShader			gDeferredTerrainHeightFieldProgram;
+LLGLSLShader			gDeferredTerrainHeightFieldShadowProgram;
+LLGLSLShader			gDeferredTerrainHeightFieldHighlightProgram;
+LLGLSLShader			gTerrainCompositeProgram;
+LLGLSLShader			gGPUParticleProgram;
+LLGLSLShader			gGPUParticleUpdateProgram;
 LLGLSLShader			gDeferredTreeProgram;
 LLGLSLShader			gDeferredTreeShadowProgram;
 LLGLSLShader            gDeferredSkinnedTreeShadowProgram;
+LLGLSLShader			gDeferredTreeInstancedProgram;
+LLGLSLShader			gDeferredTreeShadowInstancedProgram;
 LLGLSLShader			gDeferredAvatarProgram;
 LLGLSLShader			gDeferredAvatarAlphaProgram;
 LLGLSLShader			gDeferredLightProgram;
@@ -187,8 +202,11 @@ LLGLSLShader            gNoPostGammaCorrectProgram;
 LLGLSLShader            gLegacyPostGammaCorrectProgram;
 LLGLSLShader			gExposureProgram;
 LLGLSLShader			gLuminanceProgram;
+LLGLSLShader            gHiZTileProgram;
+LLGLSLShader            gTextureFeedbackProgram;
 LLGLSLShader			gFXAAProgram;
 LLGLSLShader			gDeferredPostNoDoFProgram;
+LLGLSLShader			gUpscaleProgram;
 LLGLSLShader			gDeferredWLSkyProgram;
 LLGLSLShader			gDeferredWLCloudProgram;
 LLGLSLShader			gDeferredWLSunProgram;
@@ -231,6 +249,37 @@ bool make_rigged_variant(LLGLSLShader& shader, LLGLSLShader& riggedShader)
     return riggedShader.createShader(NULL, NULL);
 }
 
+//helper for making the instanced skinning variant of a rigged shader
+bool make_skin_instanced_variant(LLGLSLShader& riggedShader, LLGLSLShader& instancedShader)
+{
+    instancedShader.mName = llformat("Instanced %s", riggedShader.mName.c_str());
+    instancedShader.mFeatures = riggedShader.mFeatures;
+    instancedShader.mFeatures.hasInstancedSkinning = true;
+    instancedShader.mDefines = riggedShader.mDefines;
+    instancedShader.mShaderFiles = riggedShader.mShaderFiles;
+    instancedShader.mShaderLevel = riggedShader.mShaderLevel;
+    instancedShader.mShaderGroup = riggedShader.mShaderGroup;
+
+    riggedShader.mSkinInstancedVariant = &instancedShader;
+    return instancedShader.createShader(NULL, NULL);
+}
+
+//helper for making the variant of a shader that places each instance with its own transform
+bool make_instanced_variant(LLGLSLShader& shader, LLGLSLShader& instancedShader)
+{
+    instancedShader.mName = llformat("Instanced %s", shader.mName.c_str());
+    instancedShader.mFeatures = shader.mFeatures;
+    instancedShader.mFeatures.hasInstanceTransforms = true;
+    instancedShader.mDefines = shader.mDefines;    // NOTE: Must come before addPermutation
+    instancedShader.addPermutation("HAS_INSTANCE_TRANSFORMS", "1");
+    instancedShader.mShaderFiles = shader.mShaderFiles;
+    instancedShader.mShaderLevel = shader.mShaderLevel;
+    instancedShader.mShaderGroup = shader.mShaderGroup;
+
+    shader.mInstancedVariant = &instancedShader;
+    return instancedShader.createShader(NULL, NULL);
+}
+
 LLViewerShaderMgr::LLViewerShaderMgr() :
 	mShaderLevel(SHADER_COUNT, 0),
 	mMaxAvatarShaderLevel(0)
@@ -262,6 +311,7 @@ LLViewerShaderMgr::LLViewerShaderMgr() :
     mShaderList.push_back(&gHUDFullbrightAlphaMaskProgram);
     mShaderList.push_back(&gDeferredFullbrightAlphaMaskAlphaProgram);
     mShaderList.push_back(&gHUDFullbrightAlphaMaskAlphaProgram);
+    mShaderList.push_back(&gGPUParticleProgram);
 	mShaderList.push_back(&gDeferredFullbrightShinyProgram);
     mShaderList.push_back(&gHUDFullbrightShinyProgram);
     mShaderList.push_back(&gDeferredSkinnedFullbrightShinyProgram);
@@ -358,10 +408,15 @@ void LLViewerShaderMgr::setShaders()
 		{
 			HBXXH128 hash_obj;
 			hash_obj.update(LLVersionInfo::instance().getVersion());
+			// program binaries are only good for the driver that produced them
+			hash_obj.update(gGLManager.mGLVendor);
+			hash_obj.update(gGLManager.mGLRenderer);
+			hash_obj.update(gGLManager.mGLVersionString);
 			current_cache_version = hash_obj.digest();
 
 			old_cache_version = LLUUID(gSavedSettings.getString("RenderShaderCacheVersion"));
 			gSavedSettings.setString("RenderShaderCacheVersion", current_cache_version.asString());
+			mShaderCacheInvalidated = old_cache_version != current_cache_version;
 		}
 
 		initShaderCache(shader_cache_enabled, old_cache_version, current_cache_version);
@@ -374,6 +429,11 @@ void LLViewerShaderMgr::setShaders()
 
     reentrance = true;
 
+    // link in the background where possible, shaders are finished on first use or by updateShaderLinks
+    static LLCachedControl<bool> async_link(gSavedSettings, "RenderAsyncShaderLink", true);
+    mAsyncLink = async_link && !mAsyncLinkBroken;
+    mAsyncLinkFailed = false;
+
     // Make sure the compiled shader map is cleared before we recompile shaders.
     mVertexShaderObjects.clear();
     mFragmentShaderObjects.clear();
@@ -527,6 +587,72 @@ void LLViewerShaderMgr::setShaders()
     reentrance = false;
 }
 
+void LLViewerShaderMgr::warmShaderCache()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    if (!mShaderCacheEnabled)
+    {
+        LL_WARNS("ShaderLoading") << "Shader cache is disabled, nothing to warm up" << LL_ENDL;
+        return;
+    }
+
+    LLFeatureManager* features = LLFeatureManager::getInstance();
+
+    // setGraphicsLevel overwrites everything in the feature table, remember the user's values
+    std::vector<std::pair<LLControlVariablePtr, LLSD> > saved;
+    LLFeatureList* all = features->findMask("all");
+    if (all)
+    {
+        for (auto& feature : all->getFeatures())
+        {
+            LLControlVariablePtr ctrl = gSavedSettings.getControl(feature.first);
+            if (ctrl)
+            {
+                saved.emplace_back(ctrl, ctrl->getValue());
+            }
+        }
+    }
+
+    // every graphics level the feature table allows on this GPU, each one
+    // only compiles what earlier levels didn't already leave in the cache
+    for (U32 level = 0; level <= features->getMaxGraphicsLevel(); ++level)
+    {
+        LL_INFOS("ShaderLoading") << "Warming shader cache for graphics level " << features->getNameForGraphicsLevel(level) << LL_ENDL;
+        features->setGraphicsLevel(level, false);
+        finishPendingShaders();
+        persistShaderCacheMetadata();
+    }
+
+    sSkipReload = true;
+    for (auto& setting : saved)
+    {
+        setting.first->setValue(setting.second);
+    }
+    sSkipReload = false;
+
+    setShaders();
+    gPipeline.refreshCachedSettings();
+    mShaderCacheInvalidated = false;
+}
+
+void LLViewerShaderMgr::updateShaderLinks()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    if (!mPendingShaders.empty() && updatePendingShaders() == 0)
+    { // the last background link landed, save the program binaries it produced
+        persistShaderCacheMetadata();
+    }
+
+    if (mAsyncLinkFailed)
+    {
+        LL_WARNS("ShaderLoading") << "Background shader link failed, reloading shaders synchronously" << LL_ENDL;
+        mAsyncLinkBroken = true;
+        setShaders();
+    }
+}
+
 void LLViewerShaderMgr::unloadShaders()
 {
 	while (!LLGLSLShader::sInstances.empty())
@@ -583,6 +709,7 @@ std::string LLViewerShaderMgr::loadBasicShaders()
     shaders.push_back( make_pair( "environment/srgbF.glsl",                 1 ) );
 	shaders.push_back( make_pair( "avatar/avatarSkinV.glsl",                1 ) );
 	shaders.push_back( make_pair( "avatar/objectSkinV.glsl",                1 ) );
+	shaders.push_back( make_pair( "avatar/objectSkinInstancedV.glsl",       1 ) );
     shaders.push_back( make_pair( "deferred/textureUtilV.glsl",             1 ) );
 	if (gGLManager.mGLSLVersionMajor >= 2 || gGLManager.mGLSLVersionMinor >= 30)
 	{
@@ -594,6 +721,24 @@ std::string LLViewerShaderMgr::loadBasicShaders()
 	attribs["MAX_JOINTS_PER_MESH_OBJECT"] = 
 		boost::lexical_cast<std::string>(LLSkinningUtil::getMaxJointCount());
 
+	// as many palettes as fit in one uniform block, a std140 mat3x4 taking 48 bytes
+	GLint max_block_size = 0;
+	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &max_block_size);
+	U32 palettes_per_block = llclamp((U32) max_block_size / (LLSkinningUtil::getMaxJointCount() * 48), 1U, 16U);
+	attribs["MAX_SKIN_INSTANCES"] = std::to_string(palettes_per_block);
+	sMaxSkinInstances = (gSavedSettings.getBOOL("RenderInstancedAnimesh") && palettes_per_block > 1) ? palettes_per_block : 0;
+
+	// and as many instance transforms, a std140 mat4 taking 64 bytes
+	U32 transforms_per_block = llclamp((U32) max_block_size / 64, 1U, 256U);
+	attribs["MAX_INSTANCE_TRANSFORMS"] = std::to_string(transforms_per_block);
+	sMaxTreeInstances = (gSavedSettings.getBOOL("RenderTreeInstancing") && transforms_per_block > 1) ? transforms_per_block : 0;
+
+	sUseAtmosphericsUBO = gSavedSettings.getBOOL("RenderAtmosphericsUBO");
+	if (sUseAtmosphericsUBO)
+	{
+		attribs["ATMOSPHERICS_UBO"] = "1";
+	}
+
     BOOL ssr = gSavedSettings.getBOOL("RenderScreenSpaceReflections");
 
 	bool has_reflection_probes = gSavedSettings.getBOOL("RenderReflectionsEnabled") && gGLManager.mGLVersion > 3.99f;
@@ -661,7 +806,7 @@ std::string LLViewerShaderMgr::loadBasicShaders()
 	index_channels.push_back(-1);    shaders.push_back( make_pair( "deferred/shadowUtil.glsl",                      1) );
 	index_channels.push_back(-1);    shaders.push_back( make_pair( "deferred/aoUtil.glsl",                          1) );
     index_channels.push_back(-1);    shaders.push_back( make_pair( "deferred/reflectionProbeF.glsl",                has_reflection_probes ? 3 : 2) );
-    index_channels.push_back(-1);    shaders.push_back( make_pair( "deferred/screenSpaceReflUtil.glsl",             ssr ? 3 : 1) );
+    index_channels.push_back(-1);    shaders.push_back( make_pair( "deferred/screenSpaceReflUtil.glsl",             (ssr || LLPipeline::useWaterScreenSpaceReflections()) ? 3 : 1) );
 	index_channels.push_back(-1);    shaders.push_back( make_pair( "lighting/lightNonIndexedF.glsl",                    mShaderLevel[SHADER_LIGHTING] ) );
 	index_channels.push_back(-1);    shaders.push_back( make_pair( "lighting/lightAlphaMaskNonIndexedF.glsl",                   mShaderLevel[SHADER_LIGHTING] ) );
 	index_channels.push_back(ch);    shaders.push_back( make_pair( "lighting/lightF.glsl",                  mShaderLevel[SHADER_LIGHTING] ) );
@@ -716,6 +861,11 @@ BOOL LLViewerShaderMgr::loadShadersWater()
             gWaterProgram.addPermutation("TRANSPARENT_WATER", "1");
         }
 
+        if (LLPipeline::useWaterScreenSpaceReflections())
+        {
+            gWaterProgram.addPermutation("WATER_SSR", "1");
+        }
+
         if (use_sun_shadow)
         {
             gWaterProgram.addPermutation("HAS_SUN_SHADOW", "1");
@@ -867,8 +1017,13 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
 		gDeferredTreeProgram.unload();
 		gDeferredTreeShadowProgram.unload();
         gDeferredSkinnedTreeShadowProgram.unload();
+		gDeferredTreeInstancedProgram.unload();
+		gDeferredTreeShadowInstancedProgram.unload();
+		sMaxTreeInstances = 0;
+		sTerrainParcelOverlay = false;
 		gDeferredDiffuseProgram.unload();
         gDeferredSkinnedDiffuseProgram.unload();
+        gDeferredSkinInstancedDiffuseProgram.unload();
 		gDeferredDiffuseAlphaMaskProgram.unload();
         gDeferredSkinnedDiffuseAlphaMaskProgram.unload();
 		gDeferredNonIndexedDiffuseAlphaMaskProgram.unload();
@@ -877,6 +1032,12 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
         gDeferredSkinnedBumpProgram.unload();
 		gDeferredImpostorProgram.unload();
 		gDeferredTerrainProgram.unload();
+		gDeferredTerrainHeightFieldProgram.unload();
+		gDeferredTerrainHeightFieldShadowProgram.unload();
+		gDeferredTerrainHeightFieldHighlightProgram.unload();
+		gTerrainCompositeProgram.unload();
+		gGPUParticleProgram.unload();
+		gGPUParticleUpdateProgram.unload();
 		gDeferredLightProgram.unload();
 		for (U32 i = 0; i < LL_DEFERRED_MULTI_LIGHT_COUNT; ++i)
 		{
@@ -918,10 +1079,13 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
 		gDeferredDoFCombineProgram.unload();
         gExposureProgram.unload();
         gLuminanceProgram.unload();
+        gHiZTileProgram.unload();
+        gTextureFeedbackProgram.unload();
 		gDeferredPostGammaCorrectProgram.unload();
         gNoPostGammaCorrectProgram.unload();
         gLegacyPostGammaCorrectProgram.unload();
 		gFXAAProgram.unload();
+		gUpscaleProgram.unload();
 		gDeferredWLSkyProgram.unload();
 		gDeferredWLCloudProgram.unload();
         gDeferredWLSunProgram.unload();
@@ -981,6 +1145,18 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
 		success = success && gDeferredDiffuseProgram.createShader(NULL, NULL);
 	}
 
+	gDeferredSkinnedDiffuseProgram.mSkinInstancedVariant = nullptr;
+	if (success && sMaxSkinInstances > 0)
+	{
+		if (!make_skin_instanced_variant(gDeferredSkinnedDiffuseProgram, gDeferredSkinInstancedDiffuseProgram))
+		{
+			// not fatal, rigged batches are drawn one at a time without it
+			LL_WARNS("Shader") << "Instanced skinning unavailable" << LL_ENDL;
+			gDeferredSkinnedDiffuseProgram.mSkinInstancedVariant = nullptr;
+			sMaxSkinInstances = 0;
+		}
+	}
+
 	if (success)
 	{
 		gDeferredDiffuseAlphaMaskProgram.mName = "Deferred Diffuse Alpha Mask Shader";
@@ -1266,6 +1442,21 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
         llassert(success);
 	}
 
+	gDeferredTreeProgram.mInstancedVariant = nullptr;
+	gDeferredTreeShadowProgram.mInstancedVariant = nullptr;
+	if (success && sMaxTreeInstances > 0)
+	{
+		if (!make_instanced_variant(gDeferredTreeProgram, gDeferredTreeInstancedProgram) ||
+			!make_instanced_variant(gDeferredTreeShadowProgram, gDeferredTreeShadowInstancedProgram))
+		{
+			// not fatal, trees go back to baking their own meshes
+			LL_WARNS("Shader") << "Instanced trees unavailable" << LL_ENDL;
+			gDeferredTreeProgram.mInstancedVariant = nullptr;
+			gDeferredTreeShadowProgram.mInstancedVariant = nullptr;
+			sMaxTreeInstances = 0;
+		}
+	}
+
     if (success)
     {
         gDeferredSkinnedTreeShadowProgram.mName = "Deferred Skinned Tree Shadow Shader";
@@ -1681,6 +1872,38 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
         llassert(success);
     }
 
+    // optional, particles stay on the CPU without them
+    if (success && gGLManager.mHasTransformFeedback)
+    {
+        gGPUParticleProgram.mName = "GPU Particle Shader";
+        gGPUParticleProgram.mFeatures.calculatesAtmospherics = true;
+        gGPUParticleProgram.mFeatures.hasGamma = true;
+        gGPUParticleProgram.mFeatures.hasAtmospherics = true;
+        gGPUParticleProgram.mFeatures.hasSrgb = true;
+        gGPUParticleProgram.mFeatures.isDeferred = true;
+        gGPUParticleProgram.mFeatures.disableTextureIndex = true;
+        gGPUParticleProgram.mShaderFiles.clear();
+        gGPUParticleProgram.mShaderFiles.push_back(make_pair("deferred/gpuParticleV.glsl", GL_VERTEX_SHADER));
+        gGPUParticleProgram.mShaderFiles.push_back(make_pair("deferred/fullbrightF.glsl", GL_FRAGMENT_SHADER));
+        gGPUParticleProgram.clearPermutations();
+        gGPUParticleProgram.addPermutation("HAS_ALPHA_MASK", "1");
+        gGPUParticleProgram.addPermutation("IS_ALPHA", "1");
+        gGPUParticleProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+
+        gGPUParticleUpdateProgram.mName = "GPU Particle Update Shader";
+        gGPUParticleUpdateProgram.mShaderFiles.clear();
+        gGPUParticleUpdateProgram.mShaderFiles.push_back(make_pair("deferred/gpuParticleUpdateV.glsl", GL_VERTEX_SHADER));
+        gGPUParticleUpdateProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+
+        if (!gGPUParticleProgram.createShader(NULL, NULL) ||
+            !gGPUParticleUpdateProgram.createShader(NULL, NULL, (U32)LL_ARRAY_SIZE(LLViewerPartSimGPU::sFeedbackVaryings), LLViewerPartSimGPU::sFeedbackVaryings))
+        {
+            LL_WARNS("ShaderLoading") << "GPU particle shaders failed to load, particles stay on the CPU" << LL_ENDL;
+            gGPUParticleProgram.unload();
+            gGPUParticleUpdateProgram.unload();
+        }
+    }
+
 	if (success)
 	{
 		gDeferredFullbrightShinyProgram.mName = "Deferred FullbrightShiny Shader";
@@ -1950,6 +2173,8 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
         llassert(success);
 	}
 
+	sTerrainParcelOverlay = gSavedSettings.getBOOL("RenderTerrainParcelOverlay");
+
 	if (success)
 	{
 		gDeferredTerrainProgram.mName = "Deferred Terrain Shader";
@@ -1966,11 +2191,78 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
 		gDeferredTerrainProgram.mShaderFiles.clear();
 		gDeferredTerrainProgram.mShaderFiles.push_back(make_pair("deferred/terrainV.glsl", GL_VERTEX_SHADER));
 		gDeferredTerrainProgram.mShaderFiles.push_back(make_pair("deferred/terrainF.glsl", GL_FRAGMENT_SHADER));
+		gDeferredTerrainProgram.clearPermutations();
+		if (sTerrainParcelOverlay)
+		{
+			gDeferredTerrainProgram.addPermutation("PARCEL_OVERLAY", "1");
+		}
 		gDeferredTerrainProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
         success = gDeferredTerrainProgram.createShader(NULL, NULL);
 		llassert(success);
 	}
 
+	if (success)
+	{
+		gDeferredTerrainHeightFieldProgram.mName = "Deferred Terrain Height Field Shader";
+		gDeferredTerrainHeightFieldProgram.mFeatures.encodesNormal = true;
+		gDeferredTerrainHeightFieldProgram.mFeatures.hasSrgb = true;
+		gDeferredTerrainHeightFieldProgram.mFeatures.calculatesLighting = false;
+		gDeferredTerrainHeightFieldProgram.mFeatures.hasLighting = false;
+		gDeferredTerrainHeightFieldProgram.mFeatures.isAlphaLighting = true;
+		gDeferredTerrainHeightFieldProgram.mFeatures.disableTextureIndex = true;
+		gDeferredTerrainHeightFieldProgram.mFeatures.calculatesAtmospherics = true;
+		gDeferredTerrainHeightFieldProgram.mFeatures.hasAtmospherics = true;
+		gDeferredTerrainHeightFieldProgram.mFeatures.hasGamma = true;
+		gDeferredTerrainHeightFieldProgram.mShaderFiles.clear();
+		gDeferredTerrainHeightFieldProgram.mShaderFiles.push_back(make_pair("deferred/terrainHeightFieldV.glsl", GL_VERTEX_SHADER));
+		gDeferredTerrainHeightFieldProgram.mShaderFiles.push_back(make_pair("deferred/terrainF.glsl", GL_FRAGMENT_SHADER));
+		gDeferredTerrainHeightFieldProgram.clearPermutations();
+		if (sTerrainParcelOverlay)
+		{
+			gDeferredTerrainHeightFieldProgram.addPermutation("PARCEL_OVERLAY", "1");
+		}
+		gDeferredTerrainHeightFieldProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+		success = gDeferredTerrainHeightFieldProgram.createShader(NULL, NULL);
+		llassert(success);
+	}
+
+	if (success)
+	{
+		gDeferredTerrainHeightFieldShadowProgram.mName = "Deferred Terrain Height Field Shadow Shader";
+		gDeferredTerrainHeightFieldShadowProgram.mShaderFiles.clear();
+		gDeferredTerrainHeightFieldShadowProgram.mShaderFiles.push_back(make_pair("deferred/terrainHeightFieldV.glsl", GL_VERTEX_SHADER));
+		gDeferredTerrainHeightFieldShadowProgram.mShaderFiles.push_back(make_pair("deferred/shadowF.glsl", GL_FRAGMENT_SHADER));
+		gDeferredTerrainHeightFieldShadowProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+		gDeferredTerrainHeightFieldShadowProgram.clearPermutations();
+		gDeferredTerrainHeightFieldShadowProgram.addPermutation("SHADOW_PASS", "1");
+		success = gDeferredTerrainHeightFieldShadowProgram.createShader(NULL, NULL);
+		llassert(success);
+	}
+
+	if (success)
+	{
+		gDeferredTerrainHeightFieldHighlightProgram.mName = "Deferred Terrain Height Field Highlight Shader";
+		gDeferredTerrainHeightFieldHighlightProgram.mShaderFiles.clear();
+		gDeferredTerrainHeightFieldHighlightProgram.mShaderFiles.push_back(make_pair("deferred/terrainHeightFieldV.glsl", GL_VERTEX_SHADER));
+		gDeferredTerrainHeightFieldHighlightProgram.mShaderFiles.push_back(make_pair("deferred/highlightF.glsl", GL_FRAGMENT_SHADER));
+		gDeferredTerrainHeightFieldHighlightProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+		gDeferredTerrainHeightFieldHighlightProgram.clearPermutations();
+		gDeferredTerrainHeightFieldHighlightProgram.addPermutation("OWNERSHIP_PASS", "1");
+		success = gDeferredTerrainHeightFieldHighlightProgram.createShader(NULL, NULL);
+		llassert(success);
+	}
+
+	if (success)
+	{
+		gTerrainCompositeProgram.mName = "Terrain Composite Shader";
+		gTerrainCompositeProgram.mShaderFiles.clear();
+		gTerrainCompositeProgram.mShaderFiles.push_back(make_pair("deferred/postDeferredNoTCV.glsl", GL_VERTEX_SHADER));
+		gTerrainCompositeProgram.mShaderFiles.push_back(make_pair("deferred/terrainCompositeF.glsl", GL_FRAGMENT_SHADER));
+		gTerrainCompositeProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+		success = gTerrainCompositeProgram.createShader(NULL, NULL);
+		llassert(success);
+	}
+
 	if (success)
 	{
 		gDeferredAvatarProgram.mName = "Deferred Avatar Shader";
@@ -2048,6 +2340,30 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
         llassert(success);
     }
 
+    if (success)
+    {
+        gHiZTileProgram.mName = "Hi-Z Tile";
+        gHiZTileProgram.mShaderFiles.clear();
+        gHiZTileProgram.clearPermutations();
+        gHiZTileProgram.mShaderFiles.push_back(make_pair("deferred/postDeferredNoTCV.glsl", GL_VERTEX_SHADER));
+        gHiZTileProgram.mShaderFiles.push_back(make_pair("deferred/hiZTileF.glsl", GL_FRAGMENT_SHADER));
+        gHiZTileProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+        success = gHiZTileProgram.createShader(NULL, NULL);
+        llassert(success);
+    }
+
+    if (success)
+    {
+        gTextureFeedbackProgram.mName = "Texture Feedback";
+        gTextureFeedbackProgram.mShaderFiles.clear();
+        gTextureFeedbackProgram.clearPermutations();
+        gTextureFeedbackProgram.mShaderFiles.push_back(make_pair("interface/onetexturefilterV.glsl", GL_VERTEX_SHADER));
+        gTextureFeedbackProgram.mShaderFiles.push_back(make_pair("deferred/textureFeedbackF.glsl", GL_FRAGMENT_SHADER));
+        gTextureFeedbackProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+        success = gTextureFeedbackProgram.createShader(NULL, NULL);
+        llassert(success);
+    }
+
 	if (success)
 	{
 		gDeferredPostGammaCorrectProgram.mName = "Deferred Gamma Correction Post Process";
@@ -2153,6 +2469,18 @@ BOOL LLViewerShaderMgr::loadShadersDeferred()
 		llassert(success);
 	}
 
+	if (success)
+	{
+		gUpscaleProgram.mName = "Upscale Shader";
+		gUpscaleProgram.mFeatures.isDeferred = true;
+		gUpscaleProgram.mShaderFiles.clear();
+		gUpscaleProgram.mShaderFiles.push_back(make_pair("deferred/postDeferredNoTCV.glsl", GL_VERTEX_SHADER));
+		gUpscaleProgram.mShaderFiles.push_back(make_pair("deferred/upscaleF.glsl", GL_FRAGMENT_SHADER));
+		gUpscaleProgram.mShaderLevel = mShaderLevel[SHADER_DEFERRED];
+		success = gUpscaleProgram.createShader(NULL, NULL);
+		llassert(success);
+	}
+
 	if (success)
 	{
 		gDeferredWLSkyProgram.mName = "Deferred Windlight Sky Shader";
@@ -2709,6 +3037,16 @@ BOOL LLViewerShaderMgr::loadShadersInterface()
 		success = gAlphaMaskProgram.createShader(NULL, NULL);
 	}
 
+	if (success)
+	{
+		gAlphaGradientProgram.mName = "Alpha Gradient Shader";
+		gAlphaGradientProgram.mShaderFiles.clear();
+		gAlphaGradientProgram.mShaderFiles.push_back(make_pair("interface/alphamaskV.glsl", GL_VERTEX_SHADER));
+		gAlphaGradientProgram.mShaderFiles.push_back(make_pair("interface/alphagradientF.glsl", GL_FRAGMENT_SHADER));
+		gAlphaGradientProgram.mShaderLevel = mShaderLevel[SHADER_INTERFACE];
+		success = gAlphaGradientProgram.createShader(NULL, NULL);
+	}
+
     if (success)
     {
         gReflectionMipProgram.mName = "Reflection Mip Shader";
@@ -37,6 +37,18 @@ class LLViewerShaderMgr: public LLShaderMgr
 public:
 	static BOOL sInitialized;
 	static bool sSkipReload;
+	// instances one draw of an instanced skinning shader holds palettes for,
+	// 0 when those shaders are not in use (see RenderInstancedAnimesh)
+	static U32 sMaxSkinInstances;
+	// instances one draw of an instanced tree shader holds transforms for,
+	// 0 when those shaders are not in use (see RenderTreeInstancing)
+	static U32 sMaxTreeInstances;
+	// terrain shaders draw the parcel overlay and property lines
+	// themselves (see RenderTerrainParcelOverlay)
+	static bool sTerrainParcelOverlay;
+	// shaders read the shared sky values from the AtmosphericsUniforms
+	// block instead of per shader uniforms (see RenderAtmosphericsUBO)
+	static bool sUseAtmosphericsUBO;
 
 	LLViewerShaderMgr();
 	/* virtual */ ~LLViewerShaderMgr();
@@ -61,9 +73,23 @@ public:
 	BOOL loadShadersWater();
 	BOOL loadShadersInterface();
 
+    // compile every variant the feature table allows on this GPU so that the
+    // program binary cache is full, then restore the user's graphics settings
+    void warmShaderCache();
+
+    // finish shaders whose background link is done, reload synchronously
+    // if one failed, call once per frame
+    void updateShaderLinks();
+
 	std::vector<S32> mShaderLevel;
 	S32	mMaxAvatarShaderLevel;
 
+    // a background link failed this session, load everything synchronously from now on
+    bool mAsyncLinkBroken = false;
+
+    // the program binary cache was purged at startup because the viewer or the driver changed
+    bool mShaderCacheInvalidated = false;
+
 	enum EShaderClass
 	{
 		SHADER_LIGHTING,
@@ -204,14 +230,23 @@ extern LLGLSLShader         gPostScreenSpaceReflectionProgram;
 // Deferred rendering shaders
 extern LLGLSLShader			gDeferredImpostorProgram;
 extern LLGLSLShader			gDeferredDiffuseProgram;
+extern LLGLSLShader			gDeferredSkinInstancedDiffuseProgram;
 extern LLGLSLShader			gDeferredDiffuseAlphaMaskProgram;
 extern LLGLSLShader			gDeferredNonIndexedDiffuseAlphaMaskProgram;
 extern LLGLSLShader			gDeferredNonIndexedDiffuseAlphaMaskNoColorProgram;
 extern LLGLSLShader			gDeferredNonIndexedDiffuseProgram;
 extern LLGLSLShader			gDeferredBumpProgram;
 extern LLGLSLShader			gDeferredTerrainProgram;
+extern LLGLSLShader			gDeferredTerrainHeightFieldProgram;
+extern LLGLSLShader			gDeferredTerrainHeightFieldShadowProgram;
+extern LLGLSLShader			gDeferredTerrainHeightFieldHighlightProgram;
+extern LLGLSLShader			gTerrainCompositeProgram;
+extern LLGLSLShader			gGPUParticleProgram;
+extern LLGLSLShader			gGPUParticleUpdateProgram;
 extern LLGLSLShader			gDeferredTreeProgram;
 extern LLGLSLShader			gDeferredTreeShadowProgram;
+extern LLGLSLShader			gDeferredTreeInstancedProgram;
+extern LLGLSLShader			gDeferredTreeShadowInstancedProgram;
 extern LLGLSLShader			gDeferredLightProgram;
 extern LLGLSLShader			gDeferredMultiLightProgram[LL_DEFERRED_MULTI_LIGHT_COUNT];
 extern LLGLSLShader			gDeferredSpotLightProgram;
@@ -233,11 +268,14 @@ extern LLGLSLShader			gDeferredCoFProgram;
 extern LLGLSLShader			gDeferredDoFCombineProgram;
 extern LLGLSLShader			gFXAAProgram;
 extern LLGLSLShader			gDeferredPostNoDoFProgram;
+extern LLGLSLShader			gUpscaleProgram;
 extern LLGLSLShader			gDeferredPostGammaCorrectProgram;
 extern LLGLSLShader         gNoPostGammaCorrectProgram;
 extern LLGLSLShader         gLegacyPostGammaCorrectProgram;
 extern LLGLSLShader			gExposureProgram;
 extern LLGLSLShader			gLuminanceProgram;
+extern LLGLSLShader         gHiZTileProgram;
+extern LLGLSLShader         gTextureFeedbackProgram;
 extern LLGLSLShader			gDeferredAvatarShadowProgram;
 extern LLGLSLShader			gDeferredAvatarAlphaShadowProgram;
 extern LLGLSLShader			gDeferredAvatarAlphaMaskShadowProgram;
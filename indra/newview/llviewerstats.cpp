@@ -66,6 +66,14 @@
 #include "llinventorymodel.h"
 #include "lluiusage.h"
 #include "lltranslate.h"
+#include "llaudiodecodemgr.h"
+#include "llaudioengine.h"
+#include "llimagegl.h"
+#include "llrendertarget.h"
+#include "llvertexbuffer.h"
+#include "llviewerinventory.h"
+#include "llvolumemgr.h"
+#include "llvovolume.h"
 
 // "Minimal Vulkan" to get max API Version
 
@@ -140,7 +148,11 @@ LLTrace::CountStatHandle<>	FPS("FPS", "Frames rendered"),
 							FRAMETIME_DOUBLED("frametimedoubled", "Ratio of frames 2x longer than previous"),
 							TEX_BAKES("texbakes", "Number of times avatar textures have been baked"),
 							TEX_REBAKES("texrebakes", "Number of times avatar textures have been forced to rebake"),
-							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache");
+							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache"),
+							GROUPS_REBUILT("groupsrebuilt", "Spatial groups with volume geometry rebuilt"),
+							FACES_FILLED_PARALLEL("facesfilledparallel", "Faces packed into vertex buffers on pipeline worker threads"),
+							COROUTINE_STACKS_CREATED("corostackscreated", "Coroutine stacks newly allocated"),
+							COROUTINE_STACKS_REUSED("corostacksreused", "Coroutine stacks reused from the pool");
 
 LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > 
 							TRIANGLES_DRAWN("trianglesdrawnstat");
@@ -196,7 +208,9 @@ LLTrace::SampleStatHandle<>	FPS_SAMPLE("fpssample"),
 							SHADER_OBJECTS("shaderobjects", "Object Shaders"),
 							DRAW_DISTANCE("drawdistance", "Draw Distance"),
 							WINDOW_WIDTH("windowwidth", "Window width"),
-							WINDOW_HEIGHT("windowheight", "Window height");
+							WINDOW_HEIGHT("windowheight", "Window height"),
+							GROUP_REBUILD_QUEUE("grouprebuildqueue", "Spatial groups queued for priority rebuild"),
+							COROUTINE_STACKS_POOLED("corostackspooled", "Finished coroutine stacks kept for reuse");
 
 LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > 
 							PACKETS_LOST_PERCENT("packetslostpercentstat");
@@ -205,8 +219,25 @@ static LLTrace::SampleStatHandle<bool>
 							CHAT_BUBBLES("chatbubbles", "Chat Bubbles Enabled");
 
 LLTrace::SampleStatHandle<F64Megabytes > FORMATTED_MEM("formattedmemstat");
+
+LLTrace::MemStatHandle	MEM_TEXTURE_RAW("memtextureraw", "Decoded texture pixels in system memory"),
+						MEM_TEXTURE_FORMATTED("memtextureformatted", "Encoded texture data being fetched, read from the cache or decoded"),
+						MEM_TEXTURE_GL("memtexturegl", "Texture memory allocated through OpenGL"),
+						MEM_RENDER_TARGETS("memrendertargets", "Render target memory allocated through OpenGL"),
+						MEM_VERTEX_BUFFERS("memvertexbuffers", "Vertex and index buffer memory allocated through OpenGL"),
+						MEM_VOLUME_LOD0("memvolumelod0", "Prim and mesh face data at the lowest LOD"),
+						MEM_VOLUME_LOD1("memvolumelod1", "Prim and mesh face data at the low LOD"),
+						MEM_VOLUME_LOD2("memvolumelod2", "Prim and mesh face data at the medium LOD"),
+						MEM_VOLUME_LOD3("memvolumelod3", "Prim and mesh face data at the highest LOD"),
+						MEM_LLSD("memllsd", "LLSD values, estimated from how many there are"),
+						MEM_INVENTORY("meminventory", "Inventory items and folders, estimated from how many there are"),
+						MEM_UI("memui", "UI widgets, estimated from how many there are"),
+						MEM_AUDIO("memaudio", "Sound buffers and decoded sounds kept in memory"),
+						MEM_OBJECTS("memobjects", "Viewer objects, estimated from how many of each kind there are");
 LLTrace::SampleStatHandle<F64Kilobytes >	DELTA_BANDWIDTH("deltabandwidth", "Increase/Decrease in bandwidth based on packet loss"),
-															MAX_BANDWIDTH("maxbandwidth", "Max bandwidth setting");
+															MAX_BANDWIDTH("maxbandwidth", "Max bandwidth setting"),
+															FRAME_ARENA_MEM("framearenamem", "Memory held by the per-thread frame arenas"),
+															FRAME_ARENA_HIGH_WATER("framearenahighwater", "Most any frame arena used in one frame or work item");
 
 	
 SimMeasurement<F64Milliseconds >	SIM_FRAME_TIME("simframemsec", "", LL_SIM_STAT_FRAMEMS),
@@ -230,6 +261,7 @@ SimMeasurement<F64Megabytes >	SIM_PHYSICS_MEM("physicsmemoryallocated", "", LL_S
 LLTrace::SampleStatHandle<F64Milliseconds >	FRAMETIME_JITTER("frametimejitter", "Average delta between successive frame times"),
 											FRAMETIME_SLEW("frametimeslew", "Average delta between frame time and mean"),
 											FRAMETIME("frametime", "Measured frame time"),
+											INPUT_LATENCY("inputlatency", "Time from gathering input to the GPU finishing the frame"),
 											SIM_PING("simpingstat");
 
 LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Meters> > AGENT_POSITION_SNAP("agentpositionsnap", "agent position corrections");
@@ -372,6 +404,65 @@ U32Bytes			gTotalTextureBytesPerBoostLevel[LLViewerTexture::MAX_GL_IMAGE_CATEGOR
 extern U32  gVisCompared;
 extern U32  gVisTested;
 
+// Most subsystems keep their own byte totals, the rest are estimated from
+// object counts, which undercounts whatever those objects point to.
+static void sample_memory_breakdown()
+{
+	LL_PROFILE_ZONE_SCOPED;
+	using namespace LLStatViewer;
+
+	set_alloc(MEM_TEXTURE_RAW, (size_t)llmax(LLImageRaw::sGlobalRawMemory.load(), (S64)0));
+	set_alloc(MEM_TEXTURE_FORMATTED, (size_t)llmax(LLImageFormatted::sGlobalFormattedMemory, 0));
+	set_alloc(MEM_TEXTURE_GL, (size_t)LLImageGL::getTextureBytesAllocated());
+	set_alloc(MEM_RENDER_TARGETS, (size_t)LLRenderTarget::sBytesAllocated);
+	set_alloc(MEM_VERTEX_BUFFERS, (size_t)LLVertexBuffer::getBytesAllocated());
+
+	U64 volume_bytes[LLVolumeLODGroup::NUM_LODS];
+	LLPrimitive::getVolumeManager()->getFaceBytes(volume_bytes);
+	set_alloc(MEM_VOLUME_LOD0, (size_t)volume_bytes[0]);
+	set_alloc(MEM_VOLUME_LOD1, (size_t)volume_bytes[1]);
+	set_alloc(MEM_VOLUME_LOD2, (size_t)volume_bytes[2]);
+	set_alloc(MEM_VOLUME_LOD3, (size_t)volume_bytes[3]);
+
+	// a small map or string value with its allocation overhead
+	const size_t LLSD_VALUE_BYTES = 64;
+	set_alloc(MEM_LLSD, (size_t)llsd::outstandingCount() * LLSD_VALUE_BYTES);
+
+	set_alloc(MEM_INVENTORY, (size_t)gInventory.getItemCount() * sizeof(LLViewerInventoryItem)
+							 + (size_t)gInventory.getCategoryCount() * sizeof(LLViewerInventoryCategory));
+	set_alloc(MEM_UI, (size_t)LLView::sViewCount * sizeof(LLView));
+
+	size_t audio_bytes = 0;
+	if (gAudiop)
+	{
+		audio_bytes = (size_t)gAudiop->getBufferBytes() + LLAudioDecodeMgr::instance().getMemoryCacheBytes();
+	}
+	set_alloc(MEM_AUDIO, audio_bytes);
+
+	size_t object_bytes = 0;
+	for (S32 i = 0; i < gObjectList.getNumObjects(); i++)
+	{
+		LLViewerObject* objectp = gObjectList.getObject(i);
+		if (!objectp)
+		{
+			continue;
+		}
+		switch (objectp->getPCode())
+		{
+		case LL_PCODE_VOLUME:
+			object_bytes += sizeof(LLVOVolume);
+			break;
+		case LL_PCODE_LEGACY_AVATAR:
+			object_bytes += sizeof(LLVOAvatar);
+			break;
+		default:
+			object_bytes += sizeof(LLViewerObject);
+			break;
+		}
+	}
+	set_alloc(MEM_OBJECTS, object_bytes);
+}
+
 void update_statistics()
 {
     LL_PROFILE_ZONE_SCOPED;
@@ -459,6 +550,17 @@ void update_statistics()
 		}
 	}
 
+	// Memory breakdown once a second, it walks the volumes and objects
+	{
+		static const F32 memory_stats_freq = 1.f;
+		static LLFrameTimer memory_stats_timer;
+		if (memory_stats_timer.getElapsedTimeF32() >= memory_stats_freq)
+		{
+			sample_memory_breakdown();
+			memory_stats_timer.reset();
+		}
+	}
+
     if (LLFloaterReg::instanceVisible("scene_load_stats"))
     {
         static const F32 perf_stats_freq = 1;
@@ -138,7 +138,11 @@ extern LLTrace::CountStatHandle<>			FPS,
 											FRAMETIME_DOUBLED,
 											TEX_BAKES,
 											TEX_REBAKES,
-											NUM_NEW_OBJECTS;
+											NUM_NEW_OBJECTS,
+											GROUPS_REBUILT,
+											FACES_FILLED_PARALLEL,
+											COROUTINE_STACKS_CREATED,
+											COROUTINE_STACKS_REUSED;
 
 extern LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > TRIANGLES_DRAWN;
 
@@ -188,14 +192,34 @@ extern LLTrace::SampleStatHandle<>		FPS_SAMPLE,
 										SHADER_OBJECTS,
 										DRAW_DISTANCE,
 										WINDOW_WIDTH,
-										WINDOW_HEIGHT;
+										WINDOW_HEIGHT,
+										GROUP_REBUILD_QUEUE,
+										COROUTINE_STACKS_POOLED;
 
 extern LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > PACKETS_LOST_PERCENT;
 
 extern LLTrace::SampleStatHandle<F64Megabytes > FORMATTED_MEM;
 
+// memory by subsystem, see update_statistics()
+extern LLTrace::MemStatHandle	MEM_TEXTURE_RAW,
+								MEM_TEXTURE_FORMATTED,
+								MEM_TEXTURE_GL,
+								MEM_RENDER_TARGETS,
+								MEM_VERTEX_BUFFERS,
+								MEM_VOLUME_LOD0,
+								MEM_VOLUME_LOD1,
+								MEM_VOLUME_LOD2,
+								MEM_VOLUME_LOD3,
+								MEM_LLSD,
+								MEM_INVENTORY,
+								MEM_UI,
+								MEM_AUDIO,
+								MEM_OBJECTS;
+
 extern LLTrace::SampleStatHandle<F64Kilobytes >	DELTA_BANDWIDTH,
-																	MAX_BANDWIDTH;
+																	MAX_BANDWIDTH,
+																	FRAME_ARENA_MEM,
+																	FRAME_ARENA_HIGH_WATER;
 extern SimMeasurement<F64Milliseconds >	SIM_FRAME_TIME,
 															SIM_NET_TIME,
 															SIM_OTHER_TIME,
@@ -217,6 +241,7 @@ extern SimMeasurement<F64Megabytes >	SIM_PHYSICS_MEM;
 
 extern LLTrace::SampleStatHandle<F64Milliseconds >	FRAMETIME_JITTER,
 													FRAMETIME_SLEW,
+													INPUT_LATENCY,
 													SIM_PING;
 
 extern LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Meters> > AGENT_POSITION_SNAP;
@@ -47,6 +47,7 @@
 #include "lldrawpool.h"
 #include "lltexturefetch.h"
 #include "llviewertexturelist.h"
+#include "lltexturebudget.h"
 #include "llviewercontrol.h"
 #include "pipeline.h"
 #include "llappviewer.h"
@@ -547,10 +548,18 @@ void LLViewerTexture::updateClass()
     // try to leave half a GB for everyone else, but keep at least 768MB for ourselves
     F32 target = llmax(budget - 512.f, 768.f);
 
+    // the budget manager evicts the least valuable textures itself and only
+    // wants the bias when it runs out of them, and then lets it back down
+    // only once it's under its low water mark
+    bool managed = LLTextureBudget::update(used, target);
+
     F32 over_pct = llmax((used-target) / target, 0.f);
-    sDesiredDiscardBias = llmax(sDesiredDiscardBias, 1.f + over_pct);
+    if (!managed || LLTextureBudget::needsDiscardBias())
+    {
+        sDesiredDiscardBias = llmax(sDesiredDiscardBias, 1.f + over_pct);
+    }
 
-    if (sDesiredDiscardBias > 1.f)
+    if (sDesiredDiscardBias > 1.f && (!managed || !LLTextureBudget::isOverBudget()))
     {
         sDesiredDiscardBias -= gFrameIntervalSeconds * 0.01;
     }
@@ -1048,6 +1057,7 @@ void LLViewerFetchedTexture::init(bool firstinit)
 	if (firstinit)
 	{
 		mInImageList = 0;
+		mInPriorityQueue = FALSE;
 	}
 
 	// Only set mIsMissingAsset true when we know for certain that the database
@@ -1522,6 +1532,17 @@ BOOL LLViewerFetchedTexture::preCreateTexture(S32 usename/*= 0*/)
         }
     }
 
+    if (mFTType == FTT_DEFAULT && mRawImage->getComponents() == 4)
+    {
+        // skip analyzing alpha again if an earlier session already did
+        U8 alpha_class;
+        S32 alpha_discard;
+        if (LLAppViewer::getTextureCache()->getAlphaClass(mID, alpha_class, alpha_discard))
+        {
+            mGLTexturep->setKnownAlphaClass(alpha_class, alpha_discard);
+        }
+    }
+
     return res;
 }
 
@@ -1556,9 +1577,39 @@ void LLViewerFetchedTexture::postCreateTexture()
         destroyRawImage();
     }
 
+    if (mGLTexturep->isAlphaClassPending())
+    {
+        gTextureList.mAlphaClassPendingList.insert(this);
+    }
+    else
+    {
+        saveAlphaClass(false);
+    }
+
     mNeedsCreateTexture = false;
 }
 
+void LLViewerFetchedTexture::saveAlphaClass(bool dirty_faces)
+{
+    if (mFTType == FTT_DEFAULT)
+    {
+        LLAppViewer::getTextureCache()->setAlphaClass(mID, mGLTexturep->getAlphaClass(), mGLTexturep->getAlphaClassDiscard());
+    }
+
+    if (dirty_faces)
+    {
+        for (U32 j = 0; j < LLRender::NUM_TEXTURE_CHANNELS; ++j)
+        {
+            llassert(mNumFaces[j] <= mFaceList[j].size());
+
+            for (U32 i = 0; i < mNumFaces[j]; i++)
+            {
+                mFaceList[j][i]->dirtyTexture();
+            }
+        }
+    }
+}
+
 void LLViewerFetchedTexture::scheduleCreateTexture()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
@@ -3058,6 +3109,8 @@ void LLViewerLODTexture::init(bool firstinit)
 	mTexelsPerImage = 64.f*64.f;
 	mDiscardVirtualSize = 0.f;
 	mCalculatedDiscardLevel = -1.f;
+	mBudgetDiscardLevel = 0;
+	mBudgetHoldUntil = 0.f;
 }
 
 //virtual 
@@ -3149,6 +3202,19 @@ void LLViewerLODTexture::processTextureStats()
         // Clamp to min desired discard
         mDesiredDiscardLevel = llmin(mMinDesiredDiscardLevel, mDesiredDiscardLevel);
 
+        // Held down by the VRAM budget, long enough not to thrash
+        if (mBudgetDiscardLevel > mDesiredDiscardLevel)
+        {
+            if (sCurrentTime < mBudgetHoldUntil || LLTextureBudget::isOverBudget())
+            {
+                mDesiredDiscardLevel = llmin(getMaxDiscardLevel() + 1, (S32)mBudgetDiscardLevel);
+            }
+            else
+            {
+                mBudgetDiscardLevel = 0;
+            }
+        }
+
         //
         // At this point we've calculated the quality level that we want,
         // if possible.  Now we check to see if we have it, and take the
@@ -3190,6 +3256,29 @@ void LLViewerLODTexture::processTextureStats()
     }
 }
 
+S64 LLViewerLODTexture::evictForBudget(F32 hold_until)
+{
+	S32 current_discard = getDiscardLevel();
+	if (current_discard < 0 || current_discard >= getMaxDiscardLevel() || mNeedsCreateTexture)
+	{
+		return 0;
+	}
+
+	S64 bytes = getTextureMemory().value();
+	mBudgetDiscardLevel = current_discard + 1;
+	mBudgetHoldUntil = hold_until;
+	mDesiredDiscardLevel = llmax(mDesiredDiscardLevel, mBudgetDiscardLevel);
+
+	if (!scaleDown())
+	{
+		// comes back a mip lower
+		destroyTexture();
+	}
+
+	// one mip down is a quarter of the memory, whichever way it gets there
+	return bytes - bytes / 4;
+}
+
 bool LLViewerLODTexture::scaleDown()
 {
 	if(hasGLTexture() && mCachedRawDiscardLevel > getDiscardLevel())
@@ -3276,6 +3365,20 @@ LLViewerMediaTexture* LLViewerMediaTexture::findMediaTexture(const LLUUID& media
 	return media_tex;
 }
 
+//static
+S64 LLViewerMediaTexture::getTotalTextureMemory()
+{
+	S64 bytes = 0;
+	for (media_map_t::iterator iter = sMediaMap.begin(); iter != sMediaMap.end(); ++iter)
+	{
+		if (iter->second->hasGLTexture())
+		{
+			bytes += iter->second->getTextureMemory().value();
+		}
+	}
+	return bytes;
+}
+
 LLViewerMediaTexture::LLViewerMediaTexture(const LLUUID& id, BOOL usemipmaps, LLImageGL* gl_image) 
 	: LLViewerTexture(id, usemipmaps),
 	mMediaImplp(NULL),
@@ -265,6 +265,7 @@ class LLViewerFetchedTexture : public LLViewerTexture
 {
 	friend class LLTextureBar; // debug info only
 	friend class LLTextureView; // debug info only
+	friend class LLTextureFeedback;
 
 protected:
 	/*virtual*/ ~LLViewerFetchedTexture();
@@ -320,6 +321,9 @@ public:
 	BOOL createTexture(S32 usename = 0);
     void postCreateTexture();
     void scheduleCreateTexture();
+	// Store the alpha classification of the GL texture in the texture cache and
+	// rebuild faces using it, called once an asynchronous analysis completes.
+	void saveAlphaClass(bool dirty_faces);
 
 	void destroyTexture() ;
 
@@ -370,6 +374,7 @@ public:
 
 	U32 getFetchPriority() const { return mFetchPriority ;}
 	F32 getDownloadProgress() const {return mDownloadProgress ;}
+	F32 getFeedbackVirtualSize() const { return mFeedbackVirtualSize; }
 
 	LLImageRaw* reloadRawImage(S8 discard_level) ;
 	void destroyRawImage();
@@ -414,6 +419,8 @@ public:
 	void        loadFromFastCache();
 	void        setInFastCacheList(bool in_list) { mInFastCacheList = in_list; }
 	bool        isInFastCacheList() { return mInFastCacheList; }
+	void        setInPriorityQueue(bool in_queue) { mInPriorityQueue = in_queue; }
+	bool        isInPriorityQueue() const { return mInPriorityQueue; }
 
 	/*virtual*/bool  isActiveFetching() override; //is actively in fetching by the fetching pipeline.
 
@@ -438,6 +445,7 @@ private:
 	BOOL  mInDebug;
 	BOOL  mUnremovable;
 	BOOL  mInFastCacheList;
+	BOOL  mInPriorityQueue;
 	BOOL  mForceCallbackFetch;
 
 protected:		
@@ -519,6 +527,10 @@ protected:
 	BOOL   mForSculpt ; //a flag if the texture is used as sculpt data.
 	BOOL   mIsFetched ; //is loaded from remote or from cache, not generated locally.
 
+	// virtual size measured by LLTextureFeedback and the frame it was measured in
+	F32 mFeedbackVirtualSize = 0.f;
+	U32 mFeedbackFrame = 0;
+
 public:
     static F32 sMaxVirtualSize; //maximum possible value of mMaxVirtualSize
 	static LLPointer<LLViewerFetchedTexture> sMissingAssetImagep;	// Texture to show for an image asset that is not in the database
@@ -550,6 +562,11 @@ public:
 	/*virtual*/ void processTextureStats();
 	bool isUpdateFrozen() ;
 
+	// From LLTextureBudget: drop a mip, from the cached raw image if there
+	// is one or by fetching again otherwise, and don't come back up before
+	// hold_until or while the budget is still over.  Returns the bytes freed.
+	S64 evictForBudget(F32 hold_until);
+
 private:
 	void init(bool firstinit) ;
 	bool scaleDown() ;		
@@ -557,6 +574,8 @@ private:
 private:
 	F32 mDiscardVirtualSize;		// Virtual size used to calculate desired discard	
 	F32 mCalculatedDiscardLevel;    // Last calculated discard level
+	S8  mBudgetDiscardLevel;		// Lowest discard level allowed by evictForBudget()
+	F32 mBudgetHoldUntil;
 };
 
 //
@@ -619,6 +638,7 @@ public:
 
 	static LLViewerMediaTexture* findMediaTexture(const LLUUID& media_id) ;
 	static void removeMediaImplFromTexture(const LLUUID& media_id) ;
+	static S64 getTotalTextureMemory() ;
 
 private:
 	typedef std::map< LLUUID, LLPointer<LLViewerMediaTexture> > media_map_t ;
@@ -27,6 +27,8 @@
 #include "llviewerprecompiledheaders.h"
 
 #include "llviewertextureanim.h"
+#include "llappviewer.h"
+#include "llviewercontrol.h"
 #include "llvovolume.h"
 
 #include "llmath.h"
@@ -39,6 +41,7 @@ LLViewerTextureAnim::LLViewerTextureAnim(LLVOVolume* vobj) : LLTextureAnim()
 	mVObj = vobj;
 	mLastFrame = -1.f;	// Force an update initially
 	mLastTime = 0.f;
+	mLastUpdateTime = 0.f;
 	mOffS = mOffT = 0;
 	mScaleS = mScaleT = 1;
 	mRot = 0;
@@ -69,9 +72,21 @@ void LLViewerTextureAnim::reset()
 //static 
 void LLViewerTextureAnim::updateClass()
 {
+	// frames come from the timer, so an animation that skips a few updates
+	// while out of view is on the right frame as soon as it is drawn again
+	static LLCachedControl<F32> hidden_period(gSavedSettings, "HiddenObjectAnimationPeriod", 0.f);
+
 	for (std::vector<LLViewerTextureAnim*>::iterator iter = sInstanceList.begin(); iter != sInstanceList.end(); ++iter)
 	{
-		(*iter)->mVObj->animateTextures();
+		LLViewerTextureAnim* anim = *iter;
+		if (hidden_period > 0.f &&
+			(F32)gFrameTimeSeconds - anim->mLastUpdateTime < hidden_period &&
+			!anim->mVObj->isVisible())
+		{
+			continue;
+		}
+		anim->mLastUpdateTime = (F32)gFrameTimeSeconds;
+		anim->mVObj->animateTextures();
 	}
 }
 
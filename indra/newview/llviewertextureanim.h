@@ -63,5 +63,6 @@ protected:
 	LLFrameTimer mTimer;
 	F64 mLastTime;
 	F32 mLastFrame;
+	F32 mLastUpdateTime; // gFrameTimeSeconds of the last animateTextures() from updateClass()
 };
 #endif
@@ -41,6 +41,7 @@
 
 #include "llsdserialize.h"
 #include "llsys.h"
+#include "workqueue.h"
 #include "llfilesystem.h"
 #include "llxmltree.h"
 #include "message.h"
@@ -354,7 +355,12 @@ void LLViewerTextureList::shutdown()
 	// Flush all of the references
 	mLoadingStreamList.clear();
 	mCreateTextureList.clear();
+	mAlphaClassPendingList.clear();
 	mFastCacheList.clear();
+	for (S32 i = 0; i < NUM_PRIORITY_BUCKETS; ++i)
+	{
+		mPriorityBuckets[i].clear();
+	}
 	
 	mUUIDMap.clear();
 	
@@ -787,6 +793,18 @@ void LLViewerTextureList::dirtyImage(LLViewerFetchedTexture *image)
 	mDirtyTextureList.insert(image);
 }
 
+void LLViewerTextureList::markPriorityDirty(LLViewerFetchedTexture *image, F32 vsize)
+{
+	static LLCachedControl<bool> push_updates(gSavedSettings, "TexturePriorityPushUpdates", false);
+	if (!push_updates || image->isInPriorityQueue() || !image->isInImageList())
+	{
+		return;
+	}
+
+	image->setInPriorityQueue(true);
+	mPriorityBuckets[getPriorityBucket(vsize)].push_back(image);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 
 void LLViewerTextureList::updateImages(F32 max_time)
@@ -898,12 +916,27 @@ void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imag
 
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE
     {
+        // the feedback pass measured what the static opaque faces of this
+        // texture need, only estimate the faces it doesn't draw
+        bool measured = LLPipeline::RenderTextureFeedback && gPipeline.mTextureFeedback.isMeasured(imagep);
+        if (measured)
+        {
+            imagep->addTextureStats(imagep->getFeedbackVirtualSize() / LLViewerTexture::sDesiredDiscardBias);
+        }
+
         for (U32 i = 0; i < LLRender::NUM_TEXTURE_CHANNELS; ++i)
         {
             for (U32 fi = 0; fi < imagep->getNumFaces(i); ++fi)
             {
                 LLFace* face = (*(imagep->getFaceList(i)))[fi];
 
+                if (measured && i == LLRender::DIFFUSE_MAP && face && !face->isState(LLFace::RIGGED) &&
+                    face->getPoolType() != LLDrawPool::POOL_ALPHA &&
+                    !(face->getTextureEntry() && face->getTextureEntry()->getGLTFRenderMaterial()))
+                {
+                    continue;
+                }
+
                 if (face && face->getViewerObject() && face->getTextureEntry())
                 {
                     F32 vsize = face->getPixelArea();
@@ -1059,6 +1092,21 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
         }
 	}
 	mCreateTextureList.erase(mCreateTextureList.begin(), enditer);
+
+	for (image_list_t::iterator iter = mAlphaClassPendingList.begin();
+		 iter != mAlphaClassPendingList.end();)
+	{
+		image_list_t::iterator curiter = iter++;
+		LLViewerFetchedTexture *imagep = *curiter;
+		if (!imagep->getGLTexture() || !imagep->getGLTexture()->isAlphaClassPending())
+		{
+			if (imagep->getGLTexture())
+			{
+				imagep->saveAlphaClass(true);
+			}
+			mAlphaClassPendingList.erase(curiter);
+		}
+	}
 	return create_timer.getElapsedTimeF32();
 }
 
@@ -1121,6 +1169,36 @@ F32 LLViewerTextureList::updateImagesFetchTextures(F32 max_time)
     //update MIN_UPDATE_COUNT or 5% of other textures, whichever is greater
     update_count = llmax((U32) MIN_UPDATE_COUNT, (U32) mUUIDMap.size()/20);
     update_count = llmin(update_count, (U32) mUUIDMap.size());
+
+    LLTimer timer;
+
+    static LLCachedControl<bool> push_updates(gSavedSettings, "TexturePriorityPushUpdates", false);
+    if (push_updates)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("vtluift - dirty");
+
+        // textures whose faces changed size, the biggest first
+        for (S32 i = NUM_PRIORITY_BUCKETS - 1; i >= 0 && timer.getElapsedTimeF32() < max_time; --i)
+        {
+            std::vector<LLPointer<LLViewerFetchedTexture> >& bucket = mPriorityBuckets[i];
+            while (!bucket.empty() && timer.getElapsedTimeF32() < max_time)
+            {
+                LLPointer<LLViewerFetchedTexture> imagep = bucket.back();
+                bucket.pop_back();
+                imagep->setInPriorityQueue(false);
+
+                if (imagep->getNumRefs() > 1 && imagep->getGLTexture())
+                {
+                    updateImageDecodePriority(imagep);
+                    imagep->updateFetch();
+                }
+            }
+        }
+
+        // the sweep only has to catch what isn't pushed, textures going
+        // unreferenced and stats running down
+        update_count = llmin((U32) MIN_UPDATE_COUNT, (U32) mUUIDMap.size());
+    }
     
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("vtluift - copy");
@@ -1143,8 +1221,6 @@ F32 LLViewerTextureList::updateImagesFetchTextures(F32 max_time)
         }
     }
 
-    LLTimer timer;
-
     LLPointer<LLViewerTexture> last_imagep = nullptr;
 
     for (auto& imagep : entries)
@@ -1405,7 +1481,7 @@ LLPointer<LLImageJ2C> LLViewerTextureList::convertToUploadFile(LLPointer<LLImage
 		compressedImage->initEncode(*raw_image, block_size, precinct_size, 0);
 	}
 	
-	if (!compressedImage->encode(raw_image, 0.0f))
+	if (!encodeForUpload(compressedImage, raw_image))
 	{
 		LL_INFOS() << "convertToUploadFile : encode returns with error!!" << LL_ENDL;
 		// Clear up the pointer so we don't leak that one
@@ -1415,6 +1491,39 @@ LLPointer<LLImageJ2C> LLViewerTextureList::convertToUploadFile(LLPointer<LLImage
 	return compressedImage;
 }
 
+// static
+bool LLViewerTextureList::encodeForUpload(LLPointer<LLImageJ2C> compressed, LLPointer<LLImageRaw> raw_image)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+	// Everything read from settings is applied here, the encode itself never touches them
+	compressed->setEncodeThreads(gSavedSettings.getU32("Jpeg2000EncodeThreads"));
+
+	// compressed and raw_image keep both alive until this returns. Plain
+	// pointers also survive waitForResult() moving from the lambda, which
+	// the fallback below still calls.
+	LLImageJ2C* j2c = compressed;
+	const LLImageRaw* raw = raw_image;
+	auto encode = [j2c, raw]()
+	{
+		LL_PROFILE_ZONE_NAMED_CATEGORY_TEXTURE("encodeForUpload");
+		return j2c->encode(raw, 0.0f);
+	};
+
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (general_queue && !LLCoros::getName().empty())
+	{
+		try
+		{
+			return general_queue->waitForResult(encode);
+		}
+		catch (const LL::WorkQueue::Closed&)
+		{
+			// shutting down, fall through and encode here
+		}
+	}
+	return encode();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // We've been that the asset server does not contain the requested image id.
@@ -88,8 +88,10 @@ struct LLTextureKey
 class LLViewerTextureList
 {
 	friend class LLTextureView;
+	friend class LLTextureBudget;
 	friend class LLViewerTextureManager;
 	friend class LLLocalBitmap;
+	friend class LLSceneMonitor;
 	
 public:
     static bool createUploadFile(LLPointer<LLImageRaw> raw_image,
@@ -106,6 +108,9 @@ public:
                                                      const S32 max_image_dimentions = LLViewerFetchedTexture::MAX_IMAGE_SIZE_DEFAULT,
                                                      bool force_square = false,
                                                      bool force_lossless = false);
+	// Encodes raw_image into compressed on the "General" thread pool, suspending only
+	// the calling coroutine until it is done. Encodes inline on a thread's default coroutine.
+	static bool encodeForUpload(LLPointer<LLImageJ2C> compressed, LLPointer<LLImageRaw> raw_image);
 	static void processImageNotInDatabase( LLMessageSystem *msg, void **user_data );
 
 public:
@@ -124,6 +129,23 @@ public:
 	LLViewerFetchedTexture *findImage(const LLTextureKey &search_key);
 
 	void dirtyImage(LLViewerFetchedTexture *image);
+
+	// Queue a texture whose face moved to another priority bucket, so its
+	// priority is updated ahead of the sweep over the whole list.
+	void markPriorityDirty(LLViewerFetchedTexture *image, F32 vsize);
+
+	// Power of two of a virtual size, what a face has to move by before
+	// its textures are queued again.
+	static S32 getPriorityBucket(F32 vsize)
+	{
+		if (vsize < 1.f)
+		{
+			return 0;
+		}
+		int exponent;
+		frexpf(vsize, &exponent);
+		return llmin(exponent, NUM_PRIORITY_BUCKETS - 1);
+	}
 	
 	// Using image stats, determine what images are necessary, and perform image updates.
 	void updateImages(F32 max_time);
@@ -211,6 +233,7 @@ public:
 	typedef std::set<LLPointer<LLViewerFetchedTexture> > image_list_t;	
 	image_list_t mLoadingStreamList;
 	image_list_t mCreateTextureList;
+	image_list_t mAlphaClassPendingList;	// created, waiting on GPU alpha analysis
 	image_list_t mCallbackList;
 	image_list_t mFastCacheList;
 
@@ -227,6 +250,11 @@ private:
     typedef std::set < LLPointer<LLViewerFetchedTexture> > image_priority_list_t;
 	image_priority_list_t mImageList;
 
+	// textures queued by markPriorityDirty(), by the bucket of the face size
+	// that queued them.  Larger buckets are updated first.
+	static const S32 NUM_PRIORITY_BUCKETS = 32;
+	std::vector<LLPointer<LLViewerFetchedTexture> > mPriorityBuckets[NUM_PRIORITY_BUCKETS];
+
 	// simply holds on to LLViewerFetchedTexture references to stop them from being purged too soon
 	std::set<LLPointer<LLViewerFetchedTexture> > mImagePreloads;
 
@@ -39,6 +39,7 @@
 
 #include "llagent.h"
 #include "llagentcamera.h"
+#include "llcallbacklist.h"
 #include "llcommandhandler.h"
 #include "llcommunicationchannel.h"
 #include "llfloaterreg.h"
@@ -118,6 +119,7 @@
 #include "llfontfreetype.h"
 #include "llgesturemgr.h"
 #include "llglheaders.h"
+#include "llglreadback.h"
 #include "lltooltip.h"
 #include "llhudmanager.h"
 #include "llhudobject.h"
@@ -185,6 +187,7 @@
 #include "llviewerstats.h"
 #include "llvoavatarself.h"
 #include "llvopartgroup.h"
+#include "llvotree.h"
 #include "llvovolume.h"
 #include "llworld.h"
 #include "llworldmapview.h"
@@ -691,6 +694,24 @@ public:
 			LLRender::sUICalls = LLRender::sUIVerts = 0;
 			ypos += y_inc;
 
+			{
+				static const char* state_names[LLRender::NUM_STATE_CHANGES] = { "Enable", "Depth", "Blend", "Texture", "Program", "Buffer", "Format" };
+				U32 issued = 0;
+				U32 elided = 0;
+				std::string breakdown;
+				for (U32 i = 0; i < LLRender::NUM_STATE_CHANGES; ++i)
+				{
+					issued += LLRender::sStateChangesIssued[i];
+					elided += LLRender::sStateChangesElided[i];
+					breakdown += llformat(" %s %d/%d", state_names[i], LLRender::sStateChangesIssued[i], LLRender::sStateChangesElided[i]);
+					LLRender::sStateChangesIssued[i] = LLRender::sStateChangesElided[i] = 0;
+				}
+				addText(xpos, ypos, llformat("GL State Changes issued/elided: %d/%d", issued, elided));
+				ypos += y_inc;
+				addText(xpos, ypos, breakdown);
+				ypos += y_inc;
+			}
+
 			addText(xpos,ypos, llformat("%d/%d Nodes visible", gPipeline.mNumVisibleNodes, LLSpatialGroup::sNodeCount));
 			
 			ypos += y_inc;
@@ -732,6 +753,14 @@ public:
                 addText(xpos, ypos, llformat("%.3f MB Mesh Headers Memory", LLMeshRepository::sCacheBytesHeaders / (1024.f*1024.f)));
 
 				ypos += y_inc;
+
+				if (LLMeshRepository::sFaceCompressionSavings)
+				{
+					LLViewerRegion* regionp = gAgent.getRegion();
+					addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Face Compression Savings Region/Total",
+						(regionp ? regionp->getMeshFaceSavings() : 0) / (1024.f*1024.f), LLMeshRepository::sFaceCompressionSavings / (1024.f*1024.f)));
+					ypos += y_inc;
+				}
 			}
 
             gPipeline.mNumVisibleNodes = LLPipeline::sVisibleLightCount = 0;
@@ -1898,6 +1927,11 @@ LLViewerWindow::LLViewerWindow(const Params& p)
 	}
     else if (!LLViewerShaderMgr::sInitialized)
     {
+        if (gSavedSettings.getBOOL("RenderAsyncShaderLink") && !gGLManager.mHasParallelShaderCompile)
+        { // no parallel compile in the driver, link on a shared context instead
+            LLShaderLinkThread::createInstance(mWindow);
+        }
+
         //immediately initialize shaders
         LLViewerShaderMgr::sInitialized = TRUE;
         LLViewerShaderMgr::instance()->setShaders();
@@ -2091,6 +2125,7 @@ void LLViewerWindow::initBase()
 		if (toolbarp)
 		{
 			toolbarp->getCenterLayoutPanel()->setReshapeCallback(boost::bind(&LLFloaterView::setToolbarRect, gFloaterView, _1, _2));
+			toolbarp->setDrawCached(gSavedSettings.getBOOL("UICacheStaticViews"));
 		}
 	}
 	gFloaterView->setFloaterSnapView(main_view->getChild<LLView>("floater_snap_region")->getHandle());
@@ -2190,6 +2225,7 @@ void LLViewerWindow::initWorldUI()
 	gStatusBar->setShape(status_bar_container->getLocalRect());
 	// sync bg color with menu bar
 	gStatusBar->setBackgroundColor( gMenuBarView->getBackgroundColor().get() );
+	gStatusBar->setDrawCached(gSavedSettings.getBOOL("UICacheStaticViews"));
     // add InBack so that gStatusBar won't be drawn over menu
     status_bar_container->addChildInBack(gStatusBar, 2/*tab order, after menu*/);
     status_bar_container->setVisible(TRUE);
@@ -2279,6 +2315,16 @@ void LLViewerWindow::initWorldUI()
 			url = LLWeb::expandURLSubstitutions(url, LLSD());
 			avatar_picker->navigateTo(url, HTTP_CONTENT_TEXT_HTML);
 		}
+
+		if (gSavedSettings.getBOOL("XUIBinaryCache"))
+		{
+			// have the slowest floaters to build ready in the XUI cache by the
+			// time they are first opened
+			LLUICtrlFactory::queuePrewarm(LLFloaterReg::getFloaterFile("inventory"));
+			LLUICtrlFactory::queuePrewarm(LLFloaterReg::getFloaterFile("build"));
+			LLUICtrlFactory::queuePrewarm(LLFloaterReg::getFloaterFile("preferences"));
+			doOnIdleRepeating(&LLUICtrlFactory::prewarmNext);
+		}
 	}
 }
 
@@ -2384,6 +2430,12 @@ void LLViewerWindow::shutdownGL()
 
 	LLViewerTextureManager::cleanup() ;
 	SUBSYSTEM_CLEANUP(LLImageGL) ;
+
+	if (LLViewerShaderMgr::sInitialized)
+	{ // nothing may be left linking on the link thread
+		LLViewerShaderMgr::instance()->finishPendingShaders();
+	}
+	LLShaderLinkThread::deleteSingleton();
     
 	LL_INFOS() << "All textures and llimagegl images are destroyed!" << LL_ENDL ;
 
@@ -5040,9 +5092,43 @@ BOOL LLViewerWindow::rawSnapshot(LLImageRaw *raw, S32 image_width, S32 image_hei
 
 	S32 output_buffer_offset_y = 0;
 
+	// With async readback each tile is copied in one go into a pixel buffer
+	// object and stored by store_tile once the copy has finished, usually
+	// while the following tile renders, rather than stalling on every scanline.
+	static LLCachedControl<bool> async_readback(gSavedSettings, "RenderSnapshotAsyncReadback", false);
+	const bool use_readback = async_readback && !LLRender::sNsightDebugSupport;
+	LLGLReadback tile_readback(2);
+	S32 tile_offsets[2] = { 0, 0 };
+
 	F32 depth_conversion_factor_1 = (LLViewerCamera::getInstance()->getFar() + LLViewerCamera::getInstance()->getNear()) / (2.f * LLViewerCamera::getInstance()->getFar() * LLViewerCamera::getInstance()->getNear());
 	F32 depth_conversion_factor_2 = (LLViewerCamera::getInstance()->getFar() - LLViewerCamera::getInstance()->getNear()) / (2.f * LLViewerCamera::getInstance()->getFar() * LLViewerCamera::getInstance()->getNear());
 
+	auto store_tile = [&](S32 slot, const U8* data, U32 width, U32 height)
+	{
+		S32 row_bytes = raw->getWidth() * raw->getComponents();
+		for (U32 out_y = 0; out_y < height; ++out_y)
+		{
+			U8* dst = raw->getData() + tile_offsets[slot] + out_y * row_bytes;
+			if (type == LLSnapshotModel::SNAPSHOT_TYPE_COLOR)
+			{
+				memcpy(dst, data + out_y * width * 3, width * 3);
+			}
+			else // LLSnapshotModel::SNAPSHOT_TYPE_DEPTH
+			{
+				const F32* depth_line = (const F32*)data + out_y * width;
+				for (U32 i = 0; i < width; i++)
+				{
+					F32 linear_depth_float = 1.f / (depth_conversion_factor_1 - (depth_line[i] * depth_conversion_factor_2));
+					U8 depth_byte = F32_to_U8(linear_depth_float, LLViewerCamera::getInstance()->getNear(), LLViewerCamera::getInstance()->getFar());
+					for (S32 j = 0; j < raw->getComponents(); j++)
+					{
+						*(dst + (i * raw->getComponents()) + j) = depth_byte;
+					}
+				}
+			}
+		}
+	};
+
 	// Subimages are in fact partial rendering of the final view. This happens when the final view is bigger than the screen.
 	// In most common cases, scale_factor is 1 and there's no more than 1 iteration on x and y
 	for (int subimage_y = 0; subimage_y < scale_factor; ++subimage_y)
@@ -5076,54 +5162,77 @@ BOOL LLViewerWindow::rawSnapshot(LLImageRaw *raw, S32 image_width, S32 image_hei
 					render_ui(scale_factor, subfield);
 					swap();
 				}
-				
-				for (U32 out_y = 0; out_y < read_height ; out_y++)
+
+				if (use_readback)
 				{
-					S32 output_buffer_offset = ( 
-												(out_y * (raw->getWidth())) // ...plus iterated y...
-												+ (window_width * subimage_x) // ...plus subimage start in x...
-												+ (raw->getWidth() * window_height * subimage_y) // ...plus subimage start in y...
-												- output_buffer_offset_x // ...minus buffer padding x...
-												- (output_buffer_offset_y * (raw->getWidth()))  // ...minus buffer padding y...
-												) * raw->getComponents();
-				
-					// Ping the watchdog thread every 100 lines to keep us alive (arbitrary number, feel free to change)
-					if (out_y % 100 == 0)
+					if (tile_readback.isFull())
+					{
+						tile_readback.poll(store_tile, true);
+					}
+
+					S32 slot = type == LLSnapshotModel::SNAPSHOT_TYPE_COLOR ?
+						tile_readback.read(subimage_x_offset, subimage_y_offset, read_width, read_height, GL_RGB, GL_UNSIGNED_BYTE) :
+						tile_readback.read(subimage_x_offset, subimage_y_offset, read_width, read_height, GL_DEPTH_COMPONENT, GL_FLOAT);
+					if (slot >= 0)
 					{
-						LLAppViewer::instance()->pingMainloopTimeout("LLViewerWindow::rawSnapshot");
+						tile_offsets[slot] = ((window_width * subimage_x)
+											  + (raw->getWidth() * window_height * subimage_y)
+											  - output_buffer_offset_x
+											  - (output_buffer_offset_y * (raw->getWidth()))
+											  ) * raw->getComponents();
 					}
-					// disable use of glReadPixels when doing nVidia nSight graphics debugging
-					if (!LLRender::sNsightDebugSupport)
+					LLAppViewer::instance()->pingMainloopTimeout("LLViewerWindow::rawSnapshot");
+				}
+				else
+				{
+					for (U32 out_y = 0; out_y < read_height ; out_y++)
 					{
-						if (type == LLSnapshotModel::SNAPSHOT_TYPE_COLOR)
+						S32 output_buffer_offset = ( 
+													(out_y * (raw->getWidth())) // ...plus iterated y...
+													+ (window_width * subimage_x) // ...plus subimage start in x...
+													+ (raw->getWidth() * window_height * subimage_y) // ...plus subimage start in y...
+													- output_buffer_offset_x // ...minus buffer padding x...
+													- (output_buffer_offset_y * (raw->getWidth()))  // ...minus buffer padding y...
+													) * raw->getComponents();
+				
+						// Ping the watchdog thread every 100 lines to keep us alive (arbitrary number, feel free to change)
+						if (out_y % 100 == 0)
 						{
-							glReadPixels(
-									 subimage_x_offset, out_y + subimage_y_offset,
-									 read_width, 1,
-									 GL_RGB, GL_UNSIGNED_BYTE,
-									 raw->getData() + output_buffer_offset
-									 );
+							LLAppViewer::instance()->pingMainloopTimeout("LLViewerWindow::rawSnapshot");
 						}
-						else // LLSnapshotModel::SNAPSHOT_TYPE_DEPTH
+						// disable use of glReadPixels when doing nVidia nSight graphics debugging
+						if (!LLRender::sNsightDebugSupport)
 						{
-							LLPointer<LLImageRaw> depth_line_buffer = new LLImageRaw(read_width, 1, sizeof(GL_FLOAT)); // need to store floating point values
-							glReadPixels(
+							if (type == LLSnapshotModel::SNAPSHOT_TYPE_COLOR)
+							{
+								glReadPixels(
 										 subimage_x_offset, out_y + subimage_y_offset,
 										 read_width, 1,
-										 GL_DEPTH_COMPONENT, GL_FLOAT,
-										 depth_line_buffer->getData()// current output pixel is beginning of buffer...
+										 GL_RGB, GL_UNSIGNED_BYTE,
+										 raw->getData() + output_buffer_offset
 										 );
-
-							for (S32 i = 0; i < (S32)read_width; i++)
+							}
+							else // LLSnapshotModel::SNAPSHOT_TYPE_DEPTH
 							{
-								F32 depth_float = *(F32*)(depth_line_buffer->getData() + (i * sizeof(F32)));
-					
-								F32 linear_depth_float = 1.f / (depth_conversion_factor_1 - (depth_float * depth_conversion_factor_2));
-								U8 depth_byte = F32_to_U8(linear_depth_float, LLViewerCamera::getInstance()->getNear(), LLViewerCamera::getInstance()->getFar());
-								// write converted scanline out to result image
-								for (S32 j = 0; j < raw->getComponents(); j++)
+								LLPointer<LLImageRaw> depth_line_buffer = new LLImageRaw(read_width, 1, sizeof(GL_FLOAT)); // need to store floating point values
+								glReadPixels(
+											 subimage_x_offset, out_y + subimage_y_offset,
+											 read_width, 1,
+											 GL_DEPTH_COMPONENT, GL_FLOAT,
+											 depth_line_buffer->getData()// current output pixel is beginning of buffer...
+											 );
+
+								for (S32 i = 0; i < (S32)read_width; i++)
 								{
-									*(raw->getData() + output_buffer_offset + (i * raw->getComponents()) + j) = depth_byte;
+									F32 depth_float = *(F32*)(depth_line_buffer->getData() + (i * sizeof(F32)));
+					
+									F32 linear_depth_float = 1.f / (depth_conversion_factor_1 - (depth_float * depth_conversion_factor_2));
+									U8 depth_byte = F32_to_U8(linear_depth_float, LLViewerCamera::getInstance()->getNear(), LLViewerCamera::getInstance()->getFar());
+									// write converted scanline out to result image
+									for (S32 j = 0; j < raw->getComponents(); j++)
+									{
+										*(raw->getData() + output_buffer_offset + (i * raw->getComponents()) + j) = depth_byte;
+									}
 								}
 							}
 						}
@@ -5136,6 +5245,12 @@ BOOL LLViewerWindow::rawSnapshot(LLImageRaw *raw, S32 image_width, S32 image_hei
 		output_buffer_offset_y += subimage_y_offset;
 	}
 
+	while (tile_readback.isPending())
+	{
+		tile_readback.poll(store_tile, true);
+	}
+	tile_readback.release();
+
 	gDisplaySwapBuffers = FALSE;
 	gSnapshotNoPost = FALSE;
 	gDepthDirty = TRUE;
@@ -5700,6 +5815,7 @@ void LLViewerWindow::stopGL(BOOL save_state)
 		stop_glerror();
 
 		LLVOPartGroup::destroyGL();
+		LLVOTree::destroyGL();
 
 		LLViewerDynamicTexture::destroyGL();
 		stop_glerror();
@@ -38,6 +38,8 @@
 #include "noise.h"
 #include "llregionhandle.h" // for from_region_handle
 #include "llviewercontrol.h"
+#include "llviewershadermgr.h"
+#include "pipeline.h"
 
 
 
@@ -79,11 +81,19 @@ LLVLComposition::LLVLComposition(LLSurface *surfacep, const U32 width, const F32
 	mTexScaleX = 16.f;
 	mTexScaleY = 16.f;
 	mTexturesLoaded = FALSE;
+	mCompositionTexture = 0;
+	mCompositionDirty = TRUE;
 }
 
 
 LLVLComposition::~LLVLComposition()
 {
+	mCompositeTarget.release();
+	if (mCompositionTexture)
+	{
+		LLImageGL::deleteTextures(1, &mCompositionTexture);
+		mCompositionTexture = 0;
+	}
 }
 
 
@@ -206,6 +216,7 @@ BOOL LLVLComposition::generateHeights(const F32 x, const F32 y,
 			*(mDatap + i + j*mWidth) = scaled_noisy_height;
 		}
 	}
+	mCompositionDirty = TRUE;
 	return TRUE;
 }
 
@@ -259,6 +270,12 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 	llassert(x >= 0.f);
 	llassert(y >= 0.f);
 
+	static LLCachedControl<bool> gpu_composite(gSavedSettings, "RenderTerrainGPUComposite", false);
+	if (gpu_composite && gTerrainCompositeProgram.mProgramObject)
+	{
+		return generateTextureGPU(x, y, width, height);
+	}
+
 	LLTimer gen_timer;
 
 	///////////////////////////
@@ -469,6 +486,127 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 	return TRUE;
 }
 
+BOOL LLVLComposition::generateTextureGPU(const F32 x, const F32 y,
+										 const F32 width, const F32 height)
+{
+	LL_PROFILE_ZONE_SCOPED
+	llassert(mSurfacep);
+
+	// generateComposition() has already fetched them to at least BASE_SIZE.
+	for (S32 i = 0; i < CORNER_COUNT; i++)
+	{
+		if (!mDetailTextures[i]->hasGLTexture())
+		{
+			return FALSE;
+		}
+	}
+
+	LLViewerTexture *texturep = mSurfacep->getSTexture();
+	if (!texturep->hasGLTexture())
+	{
+		return FALSE;
+	}
+	S32 tex_width = texturep->getWidth();
+	S32 tex_height = texturep->getHeight();
+
+	// Same tile as the CPU path covers.
+	S32 x_begin = (S32)(x * mScaleInv);
+	S32 y_begin = (S32)(y * mScaleInv);
+	S32 x_end = llmin(ll_round( (x + width) * mScaleInv ), mWidth);
+	S32 y_end = llmin(ll_round( (y + width) * mScaleInv ), mWidth);
+
+	F32 tex_x_scalef = (F32)tex_width / (F32)mWidth;
+	F32 tex_y_scalef = (F32)tex_height / (F32)mWidth;
+	S32 tex_x_begin = (S32)((F32)x_begin * tex_x_scalef);
+	S32 tex_y_begin = (S32)((F32)y_begin * tex_y_scalef);
+	S32 tex_x_end = (S32)((F32)x_end * tex_x_scalef);
+	S32 tex_y_end = (S32)((F32)y_end * tex_y_scalef);
+	if (tex_x_end <= tex_x_begin || tex_y_end <= tex_y_begin)
+	{
+		return TRUE;
+	}
+
+	LLTexUnit* unit = gGL.getTexUnit(0);
+	if (!mCompositionTexture)
+	{
+		LLImageGL::generateTextures(1, &mCompositionTexture);
+		mCompositionDirty = TRUE;
+	}
+	if (mCompositionDirty)
+	{
+		mCompositionDirty = FALSE;
+		unit->bindManual(LLTexUnit::TT_TEXTURE, mCompositionTexture);
+		LLImageGL::setManualImage(GL_TEXTURE_2D, 0, GL_R32F, mWidth, mWidth, GL_RED, GL_FLOAT, mDatap, false);
+		unit->setTextureFilteringOption(LLTexUnit::TFO_BILINEAR);
+		unit->setTextureAddressMode(LLTexUnit::TAM_CLAMP);
+		unit->unbind(LLTexUnit::TT_TEXTURE);
+	}
+
+	if ((S32)mCompositeTarget.getWidth() != tex_width || (S32)mCompositeTarget.getHeight() != tex_height)
+	{
+		mCompositeTarget.release();
+		if (!mCompositeTarget.allocate(tex_width, tex_height, GL_RGB8))
+		{
+			return FALSE;
+		}
+	}
+
+	mCompositeTarget.bindTarget();
+	glViewport(tex_x_begin, tex_y_begin, tex_x_end - tex_x_begin, tex_y_end - tex_y_begin);
+	{
+		LLGLDisable blend(GL_BLEND);
+		LLGLDepthTest depth(GL_FALSE, GL_FALSE);
+
+		gTerrainCompositeProgram.bind();
+		for (S32 i = 0; i < CORNER_COUNT; i++)
+		{
+			S32 channel = gTerrainCompositeProgram.enableTexture(LLShaderMgr::TERRAIN_DETAIL0 + i);
+			if (channel > -1)
+			{
+				gGL.getTexUnit(channel)->bind(mDetailTextures[i]);
+				gGL.getTexUnit(channel)->setTextureAddressMode(LLTexUnit::TAM_WRAP);
+			}
+		}
+		S32 channel = gTerrainCompositeProgram.enableTexture(LLShaderMgr::TERRAIN_COMPOSITION);
+		if (channel > -1)
+		{
+			gGL.getTexUnit(channel)->bindManual(LLTexUnit::TT_TEXTURE, mCompositionTexture);
+		}
+
+		static LLStaticHashedString sCompScale("comp_scale");
+		static LLStaticHashedString sDetailScale("detail_scale");
+		static LLStaticHashedString sCompSize("comp_size");
+		gTerrainCompositeProgram.uniform2f(sCompScale, (F32)mWidth / tex_width, (F32)mWidth / tex_height);
+		gTerrainCompositeProgram.uniform2f(sDetailScale, (F32)mWidth / (tex_width * mTexScaleX), (F32)mWidth / (tex_height * mTexScaleY));
+		gTerrainCompositeProgram.uniform1f(sCompSize, (F32)mWidth);
+
+		gPipeline.mScreenTriangleVB->setBuffer();
+		gPipeline.mScreenTriangleVB->drawArrays(LLRender::TRIANGLES, 0, 3);
+
+		for (S32 i = 0; i < CORNER_COUNT; i++)
+		{
+			gTerrainCompositeProgram.disableTexture(LLShaderMgr::TERRAIN_DETAIL0 + i);
+		}
+		gTerrainCompositeProgram.disableTexture(LLShaderMgr::TERRAIN_COMPOSITION);
+		gTerrainCompositeProgram.unbind();
+
+		// Copy just the tile across while the target is still the read buffer.
+		texturep->getGLTexture()->setSubImageFromFrameBuffer(tex_x_begin, tex_y_begin, tex_x_begin, tex_y_begin,
+															 tex_x_end - tex_x_begin, tex_y_end - tex_y_begin);
+		unit->unbind(LLTexUnit::TT_TEXTURE);
+	}
+	mCompositeTarget.flush();
+
+	for (S32 i = 0; i < CORNER_COUNT; i++)
+	{
+		// Un-boost detail textures (will get re-boosted if rendering in high detail)
+		mDetailTextures[i]->setBoostLevel(LLGLTexture::BOOST_NONE);
+		mDetailTextures[i]->setMinDiscardLevel(MAX_DISCARD_LEVEL + 1);
+	}
+
+	return TRUE;
+}
+
 LLUUID LLVLComposition::getDetailTextureID(S32 corner)
 {
 	return mDetailTextures[corner]->getID();
@@ -27,6 +27,7 @@
 #ifndef LL_LLVLCOMPOSITION_H
 #define LL_LLVLCOMPOSITION_H
 
+#include "llrendertarget.h"
 #include "llviewerlayer.h"
 #include "llviewertexture.h"
 
@@ -45,6 +46,9 @@ public:
 	BOOL generateComposition();
 	// Generate texture from composition values.
 	BOOL generateTexture(const F32 x, const F32 y, const F32 width, const F32 height);		
+	// Same, blended by gTerrainCompositeProgram from the detail textures' GL
+	// images instead of read back raw images (RenderTerrainGPUComposite).
+	BOOL generateTextureGPU(const F32 x, const F32 y, const F32 width, const F32 height);
 
 	// Use these as indeces ito the get/setters below that use 'corner'
 	enum ECorner
@@ -81,6 +85,12 @@ protected:
 
 	F32 mTexScaleX;
 	F32 mTexScaleY;
+
+	// GPU composite: composition values as a float texture, reuploaded after
+	// generateHeights() changes them, and the target tiles are drawn into.
+	U32 mCompositionTexture;
+	BOOL mCompositionDirty;
+	LLRenderTarget mCompositeTarget;
 };
 
 #endif //LL_LLVLCOMPOSITION_H
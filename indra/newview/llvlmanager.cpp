@@ -35,13 +35,26 @@
 #include "llframetimer.h"
 #include "llsurface.h"
 #include "llbitpack.h"
+#include "llwind.h"
+#include "llworld.h"
+#include "workqueue.h"
 
 const	char	LAND_LAYER_CODE					= 'L';
 const	char	WIND_LAYER_CODE					= '7';
 const	char	CLOUD_LAYER_CODE				= '8';
 
+// Every patch id a 10 bit header can carry; bounds the decode of a
+// packet that is missing its end marker.
+const	S32		MAX_LAYER_PATCHES				= 32*32;
+
 LLVLManager gVLManager;
 
+LLVLManager::LLVLManager()
+:	mNextSequence(0),
+	mNextApplied(0)
+{
+}
+
 LLVLManager::~LLVLManager()
 {
 	S32 i;
@@ -76,38 +89,112 @@ void LLVLManager::addLayerData(LLVLData *vl_datap, const S32Bytes mesg_size)
 
 void LLVLManager::unpackData(const S32 num_packets)
 {
-	static LLFrameTimer decode_timer;
-	
-	S32 i;
-	for (i = 0; i < mPacketData.size(); i++)
+	LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+
+	for (LLVLData *datap : mPacketData)
 	{
-		LLVLData *datap = mPacketData[i];
+		std::shared_ptr<LLVLData> packet(datap);
+		std::shared_ptr<LLVLDecodedLayer> layer = std::make_shared<LLVLDecodedLayer>();
+		layer->mRegionHandle = datap->mRegionp->getHandle();
+		layer->mType = datap->mType;
+		U32 sequence = mNextSequence++;
+
+		bool posted = main_queue && general_queue
+			&& main_queue->postTo(general_queue,
+								  [packet, layer]() { decodeLayer(*packet, *layer); },
+								  [layer, sequence]() { gVLManager.onLayerDecoded(sequence, layer); });
+		if (!posted)
+		{
+			decodeLayer(*packet, *layer);
+			onLayerDecoded(sequence, layer);
+		}
+	}
+	mPacketData.clear();
+}
 
-		LLBitPack bit_pack(datap->mData, datap->mSize);
-		LLGroupHeader goph;
+// static
+void LLVLManager::decodeLayer(const LLVLData &data, LLVLDecodedLayer &layer)
+{
+	layer.mPatchSize = 0;
+	if (LAND_LAYER_CODE != data.mType && WIND_LAYER_CODE != data.mType)
+	{
+		// cloud layers are not used
+		return;
+	}
 
-		decode_patch_group_header(bit_pack, &goph);
-		if (LAND_LAYER_CODE == datap->mType)
+	LLBitPack bit_pack(data.mData, data.mSize);
+	LLGroupHeader goph;
+
+	decode_patch_group_header(bit_pack, &goph);
+	if (goph.patch_size != NORMAL_PATCH_SIZE && goph.patch_size != LARGE_PATCH_SIZE)
+	{
+		LL_WARNS() << "Received layer data with unsupported patch size " << (S32)goph.patch_size << LL_ENDL;
+		return;
+	}
+	layer.mPatchSize = goph.patch_size;
+
+	init_patch_decompressor(goph.patch_size);
+	// Each patch is decoded on its own; the region places it on the main
+	// thread.
+	goph.stride = goph.patch_size;
+	set_group_of_patch_header(&goph);
+
+	// Wind is always an x and a y velocity patch, with no end marker.
+	S32 max_patches = (WIND_LAYER_CODE == data.mType) ? 2 : MAX_LAYER_PATCHES;
+	S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+	LLPatchHeader ph;
+	while ((S32)layer.mPatches.size() < max_patches)
+	{
+		decode_patch_header(bit_pack, &ph);
+		if (LAND_LAYER_CODE == data.mType && ph.quant_wbits == END_OF_PATCHES)
 		{
-			datap->mRegionp->getLand().decompressDCTPatch(bit_pack, &goph, FALSE);
+			break;
 		}
-		else if (WIND_LAYER_CODE == datap->mType)
-		{
-			datap->mRegionp->mWind.decompress(bit_pack, &goph);
 
-		}
-		else if (CLOUD_LAYER_CODE == datap->mType)
-		{
+		layer.mPatches.emplace_back();
+		LLVLDecodedLayer::Patch &patch = layer.mPatches.back();
+		patch.mPatchIDs = ph.patchids;
+		patch.mData.resize(layer.mPatchSize * layer.mPatchSize);
+		decode_patch(bit_pack, cpatch);
+		decompress_patch(&patch.mData[0], cpatch, &ph);
+	}
+}
 
-		}
+void LLVLManager::onLayerDecoded(U32 sequence, const std::shared_ptr<LLVLDecodedLayer> &layer)
+{
+	// Packets can finish out of order; a later one may carry newer heights
+	// for the same patch.
+	mDecodedLayers[sequence] = layer;
+	std::map<U32, std::shared_ptr<LLVLDecodedLayer> >::iterator it = mDecodedLayers.begin();
+	while (it != mDecodedLayers.end() && it->first == mNextApplied)
+	{
+		applyLayer(*it->second);
+		mNextApplied++;
+		it = mDecodedLayers.erase(it);
 	}
+}
 
-	for (i = 0; i < mPacketData.size(); i++)
+void LLVLManager::applyLayer(const LLVLDecodedLayer &layer)
+{
+	// The region may have gone away while its packet was decoded.
+	LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(layer.mRegionHandle);
+	if (!regionp || !layer.mPatchSize)
 	{
-		delete mPacketData[i];
+		return;
 	}
-	mPacketData.clear();
 
+	if (LAND_LAYER_CODE == layer.mType)
+	{
+		for (const LLVLDecodedLayer::Patch &patch : layer.mPatches)
+		{
+			regionp->getLand().applyDCTPatch(patch.mPatchIDs, &patch.mData[0], layer.mPatchSize);
+		}
+	}
+	else if (WIND_LAYER_CODE == layer.mType && layer.mPatches.size() == 2)
+	{
+		regionp->mWind.setVelocities(&layer.mPatches[0].mData[0], &layer.mPatches[1].mData[0], layer.mPatchSize);
+	}
 }
 
 void LLVLManager::resetBitCounts()
@@ -31,18 +31,45 @@
 
 #include "stdtypes.h"
 
+#include <map>
+#include <memory>
+#include <vector>
+
 class LLVLData;
 class LLViewerRegion;
 
+// Patches of one layer data packet, decoded to values.
+class LLVLDecodedLayer
+{
+public:
+	struct Patch
+	{
+		U16					mPatchIDs;	// x in the upper 5 bits, y in the lower 5
+		std::vector<F32>	mData;		// mPatchSize * mPatchSize values, row by row
+	};
+
+	U64					mRegionHandle;
+	S8					mType;
+	S32					mPatchSize;
+	std::vector<Patch>	mPatches;
+};
+
 class LLVLManager
 {
 public:
+	LLVLManager();
 	~LLVLManager();
 
 	void addLayerData(LLVLData *vl_datap, const S32Bytes mesg_size);
 
+	// Hands the packets received since the last call to the "General" thread
+	// pool for decoding. Decoded packets are applied to their regions on the
+	// main thread, in the order they arrived.
 	void unpackData(const S32 num_packets = 10);
 
+	// Touches nothing but its arguments, so it runs on any thread.
+	static void decodeLayer(const LLVLData &data, LLVLDecodedLayer &layer);
+
 	S32Bytes getTotalBytes() const;
 
 	U32Bits getLandBits() const;
@@ -53,8 +80,13 @@ public:
 
 	void cleanupData(LLViewerRegion *regionp);
 protected:
+	void onLayerDecoded(U32 sequence, const std::shared_ptr<LLVLDecodedLayer> &layer);
+	void applyLayer(const LLVLDecodedLayer &layer);
 
 	std::vector<LLVLData *> mPacketData;
+	U32 mNextSequence;		// given to the next packet handed out
+	U32 mNextApplied;		// sequence of the next packet to apply
+	std::map<U32, std::shared_ptr<LLVLDecodedLayer> > mDecodedLayers;	// waiting on earlier packets
 	U32Bits mLandBits;
 	U32Bits mWindBits;
 	U32Bits mCloudBits;
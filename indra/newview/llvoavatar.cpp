@@ -74,6 +74,7 @@
 #include "llphysicsshapebuilderutil.h"
 #include "llquantize.h"
 #include "llrand.h"
+#include "llregex.h"
 #include "llregionhandle.h"
 #include "llresmgr.h"
 #include "llselectmgr.h"
@@ -98,6 +99,7 @@
 #include "llviewershadermgr.h"
 #include "llsky.h"
 #include "llanimstatelabels.h"
+#include "llavatarrenderbenchmark.h"
 #include "lltrans.h"
 #include "llappearancemgr.h"
 
@@ -593,6 +595,71 @@ F32 LLVOAvatar::sRenderDistance = 256.f;
 S32	LLVOAvatar::sNumVisibleAvatars = 0;
 S32	LLVOAvatar::sNumLODChangesThisFrame = 0;
 
+namespace
+{
+	// avatars whose motions updateCharacter() left for updateDeferredMotions()
+	struct DeferredMotionUpdate
+	{
+		DeferredMotionUpdate(LLVOAvatar* avatar, bool was_sit_ground_constrained)
+		:	mAvatar(avatar),
+			mWasSitGroundConstrained(was_sit_ground_constrained)
+		{
+		}
+
+		LLPointer<LLVOAvatar> mAvatar;
+		bool mWasSitGroundConstrained;
+	};
+	std::vector<DeferredMotionUpdate> sDeferredMotionUpdates;
+
+	// avatars with attachment LOD rebuilds waiting for processAttachmentLODRebuilds()
+	std::vector<LLPointer<LLVOAvatar> > sAvatarsWithLODRebuilds;
+
+	// Joint position overrides of a fully rigged mesh, resolved to joint
+	// numbers. They only depend on the mesh's skin info, and every avatar
+	// numbers its joints the same way, so avatars wearing the same mesh
+	// body or head share one entry.
+	struct MeshJointOverrides
+	{
+		struct JointPosition
+		{
+			S32			mJointNum;
+			LLVector3	mPosition;
+		};
+		std::vector<JointPosition> mJointPositions;
+		bool	mLockScale;
+	};
+	std::unordered_map<LLUUID, MeshJointOverrides> sMeshJointOverrides;
+
+	// Resolves the skin's joint names and bind translations the first time
+	// any avatar wears the mesh.
+	const MeshJointOverrides& get_mesh_joint_overrides(LLVOAvatar* avatar, const LLMeshSkinInfo* skin)
+	{
+		std::unordered_map<LLUUID, MeshJointOverrides>::iterator found = sMeshJointOverrides.find(skin->mMeshID);
+		if (found != sMeshJointOverrides.end())
+		{
+			return found->second;
+		}
+
+		MeshJointOverrides& overrides = sMeshJointOverrides[skin->mMeshID];
+		overrides.mLockScale = skin->mLockScaleIfJointPosition;
+		const S32 joint_count = llmin((S32)skin->mJointNames.size(), (S32)skin->mAlternateBindMatrix.size());
+		overrides.mJointPositions.reserve(joint_count);
+		for (S32 i = 0; i < joint_count; ++i)
+		{
+			LLJoint* joint = avatar->getJoint(skin->mJointNames[i]);
+			// skip anything outside the numbered skeleton, such as mRoot
+			if (joint && avatar->getJoint(joint->getJointNum()) == joint)
+			{
+				MeshJointOverrides::JointPosition joint_pos;
+				joint_pos.mJointNum = joint->getJointNum();
+				joint_pos.mPosition = LLVector3(skin->mAlternateBindMatrix[i].getTranslation());
+				overrides.mJointPositions.push_back(joint_pos);
+			}
+		}
+		return overrides;
+	}
+}
+
 const LLUUID LLVOAvatar::sStepSoundOnLand("e8af4a28-aa83-4310-a7c4-c047e15ea0df");
 const LLUUID LLVOAvatar::sStepSounds[LL_MCODE_END] =
 {
@@ -717,6 +784,7 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mSpeed = 0.f;
 	setAnimationData("Speed", &mSpeed);
 
+	mImpostorSlot = -1;
 	mNeedsImpostorUpdate = TRUE;
 	mLastImpostorUpdateReason = 0;
 	mNeedsAnimUpdate = TRUE;
@@ -855,6 +923,7 @@ void LLVOAvatar::markDead()
 	}
 	mVoiceVisualizer->markDead();
 	LLLoadedCallbackEntry::cleanUpCallbackList(&mCallbackTextureList) ;
+	releaseImpostorSlot();
 	LLViewerObject::markDead();
 }
 
@@ -1108,11 +1177,21 @@ void LLVOAvatar::resetImpostors()
 	{
 		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
 		avatar->mImpostor.release();
+		avatar->releaseImpostorSlot();
 		avatar->mNeedsImpostorUpdate = TRUE;
 		avatar->mLastImpostorUpdateReason = 1;
 	}
 }
 
+void LLVOAvatar::releaseImpostorSlot()
+{
+	if (mImpostorSlot >= 0)
+	{
+		gPipeline.mImpostorAtlas.freeSlot(mImpostorSlot);
+		mImpostorSlot = -1;
+	}
+}
+
 // static
 void LLVOAvatar::deleteCachedImages(bool clearAll)
 {	
@@ -1160,6 +1239,7 @@ void LLVOAvatar::initClass()
 
 void LLVOAvatar::cleanupClass()
 {
+	sAvatarsWithLODRebuilds.clear();
 }
 
 // virtual
@@ -2297,6 +2377,7 @@ void LLVOAvatar::restoreMeshData()
 //-----------------------------------------------------------------------------
 void LLVOAvatar::updateMeshData()
 {
+	LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_GEOMETRY);
 	if (mDrawable.notNull())
 	{
 		stop_glerror();
@@ -3035,6 +3116,7 @@ void LLVOAvatar::idleUpdateAppearanceAnimation()
 			}
 
 			// apply all params
+			LLScopedMorphBatch morph_batch;
 			for (param = getFirstVisualParam();
 				 param;
 				 param = getNextVisualParam())
@@ -3997,12 +4079,14 @@ void LLVOAvatar::updateDebugText()
 {
     // Leave mDebugText uncleared here, in case a derived class has added some state first
 
-	if (gSavedSettings.getBOOL("DebugAvatarAppearanceMessage"))
+	static LLCachedControl<bool> debug_appearance_message(gSavedSettings, "DebugAvatarAppearanceMessage", false);
+	static LLCachedControl<bool> debug_composite_baked(gSavedSettings, "DebugAvatarCompositeBaked", false);
+	if (debug_appearance_message)
 	{
         updateAppearanceMessageDebugText();
 	}
 
-	if (gSavedSettings.getBOOL("DebugAvatarCompositeBaked"))
+	if (debug_composite_baked)
 	{
 		if (!mBakedTextureDebugText.empty())
 			addDebugText(mBakedTextureDebugText);
@@ -4580,6 +4664,7 @@ bool LLVOAvatar::computeNeedsUpdate()
 //------------------------------------------------------------------------
 bool LLVOAvatar::updateCharacter(LLAgent &agent)
 {	
+	LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_MOTION);
 	updateDebugText();
 	
 	if (!mIsBuilt)
@@ -4681,6 +4766,7 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 	mSpeed = speed;
 
 	// update animations
+	static LLCachedControl<bool> parallel_motions(gSavedSettings, "AvatarParallelMotions", false);
 	if (!visible)
 	{
 		updateMotions(LLCharacter::HIDDEN_UPDATE);
@@ -4689,12 +4775,32 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 	{
 		updateMotions(LLCharacter::FORCE_UPDATE);
 	}
+	else if (parallel_motions && !isSelf() && !isUIAvatar())
+	{
+		if (prepareDeferredMotionUpdate())
+		{
+			// the rest of the update waits for the new pose
+			sDeferredMotionUpdates.push_back(DeferredMotionUpdate(this, was_sit_ground_constrained));
+			return visible;
+		}
+	}
 	else
 	{
 		// Might be better to do HIDDEN_UPDATE if cloud
 		updateMotions(LLCharacter::NORMAL_UPDATE);
 	}
 
+	updateCharacterPose(visible, was_sit_ground_constrained);
+
+	return visible;
+}
+
+//-----------------------------------------------------------------------------
+// updateCharacterPose()
+// The part of updateCharacter() that follows the motion update
+//-----------------------------------------------------------------------------
+void LLVOAvatar::updateCharacterPose(bool visible, bool was_sit_ground_constrained)
+{
 	// Special handling for sitting on ground.
 	if (!getParent() && (isSitting() || was_sit_ground_constrained))
 	{
@@ -4724,8 +4830,109 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 		// System avatar mesh vertices need to be reskinned.
 		mNeedsSkin = TRUE;
     }
+}
 
-	return visible;
+//-----------------------------------------------------------------------------
+// updateDeferredMotions()
+// Called once every avatar has had its idle update. Nothing else runs while
+// the motions are evaluated, so each job has its avatar to itself.
+//-----------------------------------------------------------------------------
+//static
+void LLVOAvatar::updateDeferredMotions()
+{
+	if (sDeferredMotionUpdates.empty())
+	{
+		return;
+	}
+
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_MOTION);
+
+	gPipeline.runParallel((U32)sDeferredMotionUpdates.size(), [](U32 i)
+		{
+			LLVOAvatar* avatar = sDeferredMotionUpdates[i].mAvatar;
+			if (!avatar->isDead())
+			{
+				avatar->getMotionController().evaluateDeferredUpdate();
+			}
+		});
+
+	for (const DeferredMotionUpdate& update : sDeferredMotionUpdates)
+	{
+		LLVOAvatar* avatar = update.mAvatar;
+		if (!avatar->isDead())
+		{
+			avatar->getMotionController().applyDeferredUpdate();
+			avatar->updateCharacterPose(true, update.mWasSitGroundConstrained);
+		}
+	}
+	sDeferredMotionUpdates.clear();
+}
+
+//-----------------------------------------------------------------------------
+// queueAttachmentLODRebuild()
+//-----------------------------------------------------------------------------
+void LLVOAvatar::queueAttachmentLODRebuild(LLDrawable* drawable)
+{
+	if (mPendingLODRebuilds.empty())
+	{
+		sAvatarsWithLODRebuilds.push_back(this);
+	}
+	if (std::find(mPendingLODRebuilds.begin(), mPendingLODRebuilds.end(), drawable) == mPendingLODRebuilds.end())
+	{
+		mPendingLODRebuilds.push_back(drawable);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// processAttachmentLODRebuilds()
+// Nearest avatars go first. An avatar's attachments are always rebuilt
+// together, so a mesh body and head never sit at different LODs for long,
+// and whatever doesn't fit in this frame's budget waits for the next one.
+// A camera zoom then spreads its rebuilds over several frames.
+//-----------------------------------------------------------------------------
+//static
+void LLVOAvatar::processAttachmentLODRebuilds()
+{
+	if (sAvatarsWithLODRebuilds.empty())
+	{
+		return;
+	}
+
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	std::sort(sAvatarsWithLODRebuilds.begin(), sAvatarsWithLODRebuilds.end(),
+		[](const LLPointer<LLVOAvatar>& lhs, const LLPointer<LLVOAvatar>& rhs)
+		{
+			F32 lhs_distance = lhs->mDrawable.notNull() ? lhs->mDrawable->mDistanceWRTCamera : 0.f;
+			F32 rhs_distance = rhs->mDrawable.notNull() ? rhs->mDrawable->mDistanceWRTCamera : 0.f;
+			return lhs_distance < rhs_distance;
+		});
+
+	static LLCachedControl<U32> rebuild_budget(gSavedSettings, "RenderAttachmentLODRebuildsPerFrame", 0);
+	U32 rebuilt = 0;
+	size_t processed = 0;
+	for ( ; processed < sAvatarsWithLODRebuilds.size(); ++processed)
+	{
+		LLVOAvatar* avatar = sAvatarsWithLODRebuilds[processed];
+		if (!avatar->isDead())
+		{
+			if (rebuild_budget && rebuilt > 0 && rebuilt + avatar->mPendingLODRebuilds.size() > rebuild_budget)
+			{
+				break;
+			}
+			for (LLDrawable* drawable : avatar->mPendingLODRebuilds)
+			{
+				if (!drawable->isDead())
+				{
+					gPipeline.markRebuild(drawable, LLDrawable::REBUILD_VOLUME);
+					++rebuilt;
+				}
+			}
+		}
+		avatar->mPendingLODRebuilds.clear();
+	}
+	sAvatarsWithLODRebuilds.erase(sAvatarsWithLODRebuilds.begin(), sAvatarsWithLODRebuilds.begin() + processed);
 }
 
 //-----------------------------------------------------------------------------
@@ -5255,7 +5462,7 @@ U32 LLVOAvatar::renderRigid()
 
 U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 {
-	if (!mImpostor.isComplete())
+	if (mImpostorSlot < 0 && !mImpostor.isComplete())
 	{
 		return 0;
 	}
@@ -5298,6 +5505,12 @@ U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 		gGL.end();
 		gGL.flush();
 	}
+	if (mImpostorSlot >= 0)
+	{ // drawn with every other atlas impostor when the avatar pool is done
+		LLVector3 corners[4] = { pos+left-up, pos-left-up, pos-left+up, pos+left+up };
+		gPipeline.mImpostorAtlas.addQuad(corners, mImpostorTexRect, color);
+	}
+	else
 	{
 	gGL.flush();
 
@@ -6154,7 +6367,7 @@ const LLUUID& LLVOAvatar::getID() const
 // getJoint()
 //-----------------------------------------------------------------------------
 // RN: avatar joints are multi-rooted to include screen-based attachments
-LLJoint *LLVOAvatar::getJoint( const std::string &name )
+LLJoint *LLVOAvatar::getJoint( const LLInternedString &name )
 {
 	joint_map_t::iterator iter = mJointMap.find(name);
 
@@ -6162,20 +6375,9 @@ LLJoint *LLVOAvatar::getJoint( const std::string &name )
 
 	if (iter == mJointMap.end() || iter->second == NULL)
 	{   //search for joint and cache found joint in lookup table
-		if (mJointAliasMap.empty())
-		{
-			getJointAliases();
-		}
-		joint_alias_map_t::const_iterator alias_iter = mJointAliasMap.find(name);
-		std::string canonical_name;
-		if (alias_iter != mJointAliasMap.end())
-		{
-			canonical_name = alias_iter->second;
-		}
-		else
-		{
-			canonical_name = name;
-		}
+		const interned_alias_map_t& aliases = getInternedJointAliases();
+		interned_alias_map_t::const_iterator alias_iter = aliases.find(name);
+		const LLInternedString& canonical_name = (alias_iter != aliases.end()) ? alias_iter->second : name;
 		jointp = mRoot->findJoint(canonical_name);
 		mJointMap[name] = jointp;
 	}
@@ -6397,13 +6599,20 @@ void LLVOAvatar::updateAttachmentOverrides()
 
 	// have to work with a copy because removeAttachmentOverrides() will change mActiveOverrideMeshes.
     std::set<LLUUID> active_override_meshes = mActiveOverrideMeshes; 
+    bool removed_any = false;
     for (std::set<LLUUID>::iterator it = active_override_meshes.begin(); it != active_override_meshes.end(); ++it)
     {
         if (meshes_seen.find(*it) == meshes_seen.end())
         {
-            removeAttachmentOverridesForObject(*it);
+            // one recalc for all of them below
+            removeAttachmentOverridesForObject(*it, false);
+            removed_any = true;
         }
     }
+    if (removed_any)
+    {
+        postPelvisSetRecalc();
+    }
 
 
 #ifdef ATTACHMENT_OVERRIDE_VALIDATION
@@ -6557,31 +6766,33 @@ void LLVOAvatar::addAttachmentOverridesForObject(LLViewerObject *vo, std::set<LL
 			bool fullRig = (jointCnt>=JOINT_COUNT_REQUIRED_FOR_FULLRIG) ? true : false;								
 			if ( fullRig && !mesh_overrides_loaded )
 			{								
-				for ( int i=0; i<jointCnt; ++i )
+				const MeshJointOverrides& overrides = get_mesh_joint_overrides(this, pSkinData);
+				LLJoint* pJointPelvis = getJoint("mPelvis");
+				const std::string av_string = avString();
+				for (const MeshJointOverrides::JointPosition& joint_pos : overrides.mJointPositions)
 				{
-					std::string lookingForJoint = pSkinData->mJointNames[i].c_str();
-					LLJoint* pJoint = getJoint( lookingForJoint );
+					LLJoint* pJoint = getJoint(joint_pos.mJointNum);
 					if (pJoint)
 					{   									
-						const LLVector3& jointPos = LLVector3(pSkinData->mAlternateBindMatrix[i].getTranslation());
+						const LLVector3& jointPos = joint_pos.mPosition;
                         if (pJoint->aboveJointPosThreshold(jointPos))
                         {
                             bool override_changed;
-                            pJoint->addAttachmentPosOverride( jointPos, mesh_id, avString(), override_changed );
+                            pJoint->addAttachmentPosOverride( jointPos, mesh_id, av_string, override_changed );
                             
                             if (override_changed)
                             {
                                 //If joint is a pelvis then handle old/new pelvis to foot values
-                                if ( lookingForJoint == "mPelvis" )
+                                if ( pJoint == pJointPelvis )
                                 {	
                                     pelvisGotSet = true;											
                                 }										
                             }
-                            if (pSkinData->mLockScaleIfJointPosition)
+                            if (overrides.mLockScale)
                             {
                                 // Note that unlike positions, there's no threshold check here,
                                 // just a lock at the default value.
-                                pJoint->addAttachmentScaleOverride(pJoint->getDefaultScale(), mesh_id, avString());
+                                pJoint->addAttachmentScaleOverride(pJoint->getDefaultScale(), mesh_id, av_string);
                             }
                         }
 					}										
@@ -6760,28 +6971,57 @@ void LLVOAvatar::removeAttachmentOverridesForObject(LLViewerObject *vo)
 //-----------------------------------------------------------------------------
 // removeAttachmentOverridesForObject
 //-----------------------------------------------------------------------------
-void LLVOAvatar::removeAttachmentOverridesForObject(const LLUUID& mesh_id)
+void LLVOAvatar::removeAttachmentOverridesForObject(const LLUUID& mesh_id, bool recalc)
 {	
 	LLJoint* pJointPelvis = getJoint("mPelvis");
     const std::string av_string = avString();
-    for (S32 joint_num = 0; joint_num < LL_CHARACTER_MAX_ANIMATED_JOINTS; joint_num++)
-	{
-        LLJoint *pJoint = getJoint(joint_num);
+    auto remove_overrides = [&](LLJoint* pJoint)
+    {
 		if ( pJoint )
 		{			
             bool dummy; // unused
 			pJoint->removeAttachmentPosOverride(mesh_id, av_string, dummy);
 			pJoint->removeAttachmentScaleOverride(mesh_id, av_string);
 		}		
-		if ( pJoint && pJoint == pJointPelvis)
-		{
-			removePelvisFixup( mesh_id );
-			// SL-315
-			pJoint->setPosition( LLVector3( 0.0f, 0.0f, 0.0f) );
-		}		
-	}	
+    };
+
+    std::unordered_map<LLUUID, MeshJointOverrides>::const_iterator found = sMeshJointOverrides.find(mesh_id);
+    if (found != sMeshJointOverrides.end())
+    {
+        // Only the joints the mesh names can hold its overrides.
+        for (const MeshJointOverrides::JointPosition& joint_pos : found->second.mJointPositions)
+        {
+            LLJoint* pJoint = getJoint(joint_pos.mJointNum);
+            if (pJoint != pJointPelvis)
+            {
+                remove_overrides(pJoint);
+            }
+        }
+    }
+    else
+    {
+        for (S32 joint_num = 0; joint_num < LL_CHARACTER_MAX_ANIMATED_JOINTS; joint_num++)
+        {
+            LLJoint* pJoint = getJoint(joint_num);
+            if (pJoint != pJointPelvis)
+            {
+                remove_overrides(pJoint);
+            }
+        }
+    }
+
+	if ( pJointPelvis )
+	{
+		remove_overrides(pJointPelvis);
+		removePelvisFixup( mesh_id );
+		// SL-315
+		pJointPelvis->setPosition( LLVector3( 0.0f, 0.0f, 0.0f) );
+	}		
 		
-	postPelvisSetRecalc();	
+	if (recalc)
+	{
+		postPelvisSetRecalc();	
+	}
 
     mActiveOverrideMeshes.erase(mesh_id);
     onActiveOverrideMeshesChanged();
@@ -7032,7 +7272,10 @@ void LLVOAvatar::updateVisualParams()
 		}
 	}
 
-	LLCharacter::updateVisualParams();
+	{
+		LLScopedMorphBatch morph_batch;
+		LLCharacter::updateVisualParams();
+	}
 
 	if (mLastSkeletonSerialNum != mSkeletonSerialNum)
 	{
@@ -7376,7 +7619,7 @@ const LLViewerJointAttachment *LLVOAvatar::attachObject(LLViewerObject *viewer_o
         updateAttachmentOverrides();
     }
 
-	updateVisualComplexity();
+	updateVisualComplexity(viewer_object);
 
 	if (viewer_object->isSelected())
 	{
@@ -8460,7 +8703,8 @@ LLMotion* LLVOAvatar::findMotion(const LLUUID& id) const
 // colorized if using deferred rendering.
 void LLVOAvatar::debugColorizeSubMeshes(U32 i, const LLColor4& color)
 {
-	if (gSavedSettings.getBOOL("DebugAvatarCompositeBaked"))
+	static LLCachedControl<bool> debug_composite_baked(gSavedSettings, "DebugAvatarCompositeBaked", false);
+	if (debug_composite_baked)
 	{
 		avatar_joint_mesh_list_t::iterator iter = mBakedTextureDatas[i].mJointMeshes.begin();
 		avatar_joint_mesh_list_t::iterator end  = mBakedTextureDatas[i].mJointMeshes.end();
@@ -9253,6 +9497,72 @@ void LLVOAvatar::dumpAppearanceMsgParams( const std::string& dump_prefix,
 	apr_file_printf(file, "</textures>\n");
 }
 
+//-----------------------------------------------------------------------------
+// loadAppearanceDump()
+// Applies the params and textures of a file written by dumpArchetypeXML() or
+// dumpAppearanceMsgParams() as if they had come in an appearance message.
+//-----------------------------------------------------------------------------
+bool LLVOAvatar::loadAppearanceDump(const std::string& filename)
+{
+	llifstream infile(filename.c_str());
+	if (!infile.is_open())
+	{
+		LL_WARNS("Avatar") << "can't open appearance dump " << filename << LL_ENDL;
+		return false;
+	}
+
+	LLPointer<LLAppearanceMessageContents> contents(new LLAppearanceMessageContents);
+	LLTEContents& tec = contents->mTEContents;
+	tec.face_count = 0;
+	contents->mHoverOffsetWasSet = false;
+
+	static const boost::regex param_expression("<param id=\"(-?[0-9]+)\".* value=\"([-0-9.eE]+)\"");
+	static const boost::regex texture_expression("<texture te=\"([0-9]+)\" uuid=\"([-0-9a-fA-F]+)\"");
+	std::string line;
+	while (std::getline(infile, line))
+	{
+		boost::smatch match;
+		if (ll_regex_search(line, match, param_expression))
+		{
+			LLVisualParam* param = getVisualParam(std::stoi(match[1].str()));
+			if (param)
+			{
+				contents->mParams.push_back(param);
+				contents->mParamWeights.push_back((F32)std::stod(match[2].str()));
+			}
+		}
+		else if (ll_regex_search(line, match, texture_expression))
+		{
+			U32 te = (U32)std::stoul(match[1].str());
+			if (te < LLTEContents::MAX_TES)
+			{
+				for ( ; tec.face_count <= te; ++tec.face_count)
+				{
+					// defaults, as the message would pack them
+					U32 i = tec.face_count;
+					tec.image_data[i] = IMG_DEFAULT_AVATAR;
+					tec.colors[i] = LLColor4U(0, 0, 0, 0);
+					tec.scale_s[i] = tec.scale_t[i] = 1.f;
+					tec.offset_s[i] = tec.offset_t[i] = tec.image_rot[i] = 0;
+					tec.bump[i] = tec.media_flags[i] = tec.glow[i] = 0;
+					tec.material_ids[i].clear();
+				}
+				tec.image_data[te].set(match[2].str());
+			}
+		}
+	}
+
+	if (contents->mParamWeights.size() <= 1)
+	{
+		LL_WARNS("Avatar") << "no visual params in appearance dump " << filename << LL_ENDL;
+		return false;
+	}
+
+	mLastProcessedAppearance = contents;
+	applyParsedAppearanceMessage(*contents, true);
+	return true;
+}
+
 void LLVOAvatar::parseAppearanceMessage(LLMessageSystem* mesgsys, LLAppearanceMessageContents& contents)
 {
 	parseTEMessage(mesgsys, _PREHASH_ObjectData, -1, contents.mTEContents);
@@ -10594,21 +10904,50 @@ void LLVOAvatar::updateImpostors()
 {
 	LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
 
-    std::vector<LLCharacter*> instances_copy = LLCharacter::sInstances;
-	for (std::vector<LLCharacter*>::iterator iter = instances_copy.begin();
-		iter != instances_copy.end(); ++iter)
+	std::vector<LLVOAvatar*> pending;
+	for (LLCharacter* character : LLCharacter::sInstances)
 	{
-		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
+		LLVOAvatar* avatar = (LLVOAvatar*) character;
 		if (!avatar->isDead()
 			&& avatar->isVisible()
 			&& avatar->isImpostor()
 			&& avatar->needsImpostorUpdate())
 		{
-            avatar->calcMutedAVColor();
-			gPipeline.generateImpostor(avatar);
+			pending.push_back(avatar);
 		}
 	}
 
+	// With a budget, refreshes that don't fit go to the next frames, and
+	// the stale impostors are drawn meanwhile. Avatars with no impostor at
+	// all go first, then the ones refreshed longest ago.
+	static LLCachedControl<F32> budget_ms(gSavedSettings, "RenderImpostorUpdateBudgetMS", 0.f);
+	if (budget_ms > 0.f)
+	{
+		std::stable_sort(pending.begin(), pending.end(),
+			[](LLVOAvatar* lhs, LLVOAvatar* rhs)
+			{
+				bool lhs_has = lhs->mImpostorSlot >= 0 || lhs->mImpostor.isComplete();
+				bool rhs_has = rhs->mImpostorSlot >= 0 || rhs->mImpostor.isComplete();
+				if (lhs_has != rhs_has)
+				{
+					return rhs_has;
+				}
+				return lhs->mLastImpostorUpdateFrameTime < rhs->mLastImpostorUpdateFrameTime;
+			});
+	}
+
+	LLTimer timer;
+	for (LLVOAvatar* avatar : pending)
+	{
+		if (budget_ms > 0.f && avatar != pending.front()
+			&& timer.getElapsedTimeF32() * 1000.f >= budget_ms)
+		{
+			break;
+		}
+		avatar->calcMutedAVColor();
+		gPipeline.generateImpostor(avatar);
+	}
+
 	LLCharacter::sAllowInstancesChange = TRUE;
 }
 
@@ -10865,23 +11204,46 @@ void LLVOAvatar::updateVisualComplexity()
 }
 
 
-// Account for the complexity of a single top-level object associated
-// with an avatar. This will be either an attached object or an animated
-// object.
-void LLVOAvatar::accountRenderComplexityForObject(
-    LLViewerObject *attached_object,
-    const F32 max_attachment_complexity,
-    LLVOVolume::texture_cost_t& textures,
-    U32& cost,
-    hud_complexity_list_t& hud_complexity_list,
-    object_complexity_list_t& object_complexity_list)
+void LLVOAvatar::updateVisualComplexity(LLViewerObject* changed_object)
+{
+	if (changed_object)
+	{
+		LLViewerObject* root = (LLViewerObject*) changed_object->getRootEdit();
+		mStaleObjectComplexity.insert(root ? root->getID() : changed_object->getID());
+	}
+	updateVisualComplexity();
+}
+
+const LLVOAvatar::ObjectComplexity* LLVOAvatar::getObjectComplexity(const LLUUID& object_id) const
+{
+	std::unordered_map<LLUUID, ObjectComplexity>::const_iterator found = mObjectComplexity.find(object_id);
+	return (found != mObjectComplexity.end()) ? &found->second : NULL;
+}
+
+// Cached complexity of a top level object, recomputed if the object is new
+// or was reported changed since.
+const LLVOAvatar::ObjectComplexity& LLVOAvatar::getUpdatedObjectComplexity(
+    LLViewerObject* attached_object,
+    LLVOVolume::texture_cost_t& textures)
 {
+    const LLUUID& id = attached_object->getID();
+    ObjectComplexity& entry = mObjectComplexity[id];
+    bool stale = mStaleObjectComplexity.erase(id) > 0;
+    if (entry.mObject == attached_object && !stale)
+    {
+        return entry;
+    }
+
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
-    if (attached_object && !attached_object->isHUDAttachment())
+    entry = ObjectComplexity();
+    entry.mObject = attached_object;
+    entry.mIsHUD = attached_object->isHUDAttachment();
+
+    if (!entry.mIsHUD)
     {
-        mAttachmentVisibleTriangleCount += attached_object->recursiveGetTriangleCount();
-        mAttachmentEstTriangleCount += attached_object->recursiveGetEstTrianglesMax();
-        mAttachmentSurfaceArea += attached_object->recursiveGetScaledSurfaceArea();
+        entry.mVisibleTriangles = attached_object->recursiveGetTriangleCount();
+        entry.mEstTriangles = attached_object->recursiveGetEstTrianglesMax();
+        entry.mSurfaceArea = attached_object->recursiveGetScaledSurfaceArea();
 
         textures.clear();
         const LLDrawable* drawable = attached_object->mDrawable;
@@ -10931,34 +11293,21 @@ void LLVOAvatar::accountRenderComplexityForObject(
                     << ", " << volume->numChildren()
                     << " children: " << attachment_children_cost
                     << LL_ENDL;
-                // Limit attachment complexity to avoid signed integer flipping of the wearer's ACI
-                cost += (U32)llclamp(attachment_total_cost, MIN_ATTACHMENT_COMPLEXITY, max_attachment_complexity);
-
-                if (isSelf())
-                {
-                    LLObjectComplexity object_complexity;
-                    object_complexity.objectName = attached_object->getAttachmentItemName();
-                    object_complexity.objectId = attached_object->getAttachmentItemID();
-                    object_complexity.objectCost = attachment_total_cost;
-                    object_complexity_list.push_back(object_complexity);
-                }
+                entry.mHasVolume = true;
+                entry.mCost = attachment_total_cost;
             }
         }
     }
-    if (isSelf()
-        && attached_object
-        && attached_object->isHUDAttachment()
-        && !attached_object->isTempAttachment()
-        && attached_object->mDrawable)
+    else if (isSelf() && !attached_object->isTempAttachment() && attached_object->mDrawable)
     {
         textures.clear();
-        mAttachmentSurfaceArea += attached_object->recursiveGetScaledSurfaceArea();
+        entry.mSurfaceArea = attached_object->recursiveGetScaledSurfaceArea();
 
         const LLVOVolume* volume = attached_object->mDrawable->getVOVolume();
         if (volume)
         {
             BOOL is_rigged_mesh = volume->isRiggedMeshFast();
-            LLHUDComplexity hud_object_complexity;
+            LLHUDComplexity& hud_object_complexity = entry.mHUDComplexity;
             hud_object_complexity.objectName = attached_object->getAttachmentItemName();
             hud_object_complexity.objectId = attached_object->getAttachmentItemID();
             std::string joint_name;
@@ -11013,7 +11362,58 @@ void LLVOAvatar::accountRenderComplexityForObject(
                     }
                 }
             }
-            hud_complexity_list.push_back(hud_object_complexity);
+            entry.mHasVolume = true;
+        }
+    }
+    return entry;
+}
+
+// Account for the complexity of a single top-level object associated
+// with an avatar. This will be either an attached object or an animated
+// object.
+void LLVOAvatar::accountRenderComplexityForObject(
+    LLViewerObject *attached_object,
+    const F32 max_attachment_complexity,
+    LLVOVolume::texture_cost_t& textures,
+    U32& cost,
+    hud_complexity_list_t& hud_complexity_list,
+    object_complexity_list_t& object_complexity_list)
+{
+    if (!attached_object)
+    {
+        return;
+    }
+    const ObjectComplexity& entry = getUpdatedObjectComplexity(attached_object, textures);
+
+    if (!entry.mIsHUD)
+    {
+        mAttachmentVisibleTriangleCount += entry.mVisibleTriangles;
+        mAttachmentEstTriangleCount += entry.mEstTriangles;
+        mAttachmentSurfaceArea += entry.mSurfaceArea;
+
+        if (entry.mHasVolume)
+        {
+            // Limit attachment complexity to avoid signed integer flipping of the wearer's ACI
+            cost += (U32)llclamp(entry.mCost, MIN_ATTACHMENT_COMPLEXITY, max_attachment_complexity);
+
+            if (isSelf())
+            {
+                LLObjectComplexity object_complexity;
+                object_complexity.objectName = attached_object->getAttachmentItemName();
+                object_complexity.objectId = attached_object->getAttachmentItemID();
+                object_complexity.objectCost = entry.mCost;
+                object_complexity_list.push_back(object_complexity);
+            }
+        }
+    }
+    else if (isSelf()
+        && !attached_object->isTempAttachment()
+        && attached_object->mDrawable)
+    {
+        mAttachmentSurfaceArea += entry.mSurfaceArea;
+        if (entry.mHasVolume)
+        {
+            hud_complexity_list.push_back(entry.mHUDComplexity);
         }
     }
 }
@@ -11075,6 +11475,10 @@ void LLVOAvatar::calculateUpdateRenderComplexity()
         mAttachmentVisibleTriangleCount = 0;
         mAttachmentEstTriangleCount = 0.f;
         mAttachmentSurfaceArea = 0.f;
+
+        // attachment and animated object costs come from mObjectComplexity,
+        // only objects reported changed are walked again
+        std::unordered_set<LLUUID> accounted;
         
         // A standalone animated object needs to be accounted for
         // using its associated volume. Attached animated objects
@@ -11087,6 +11491,7 @@ void LLVOAvatar::calculateUpdateRenderComplexity()
             {
                 accountRenderComplexityForObject(volp, max_attachment_complexity,
                                                  textures, cost, hud_complexity_list, object_complexity_list);
+                accounted.insert(volp->getID());
             }
         }
 
@@ -11103,9 +11508,27 @@ void LLVOAvatar::calculateUpdateRenderComplexity()
                 LLViewerObject* attached_object = attachment_iter->get();
                 accountRenderComplexityForObject(attached_object, max_attachment_complexity,
                                                  textures, cost, hud_complexity_list, object_complexity_list);
+                if (attached_object)
+                {
+                    accounted.insert(attached_object->getID());
+                }
 			}
 		}
 
+        // forget objects that are no longer attached
+        for (std::unordered_map<LLUUID, ObjectComplexity>::iterator it = mObjectComplexity.begin(); it != mObjectComplexity.end(); )
+        {
+            if (accounted.count(it->first))
+            {
+                ++it;
+            }
+            else
+            {
+                it = mObjectComplexity.erase(it);
+            }
+        }
+        mStaleObjectComplexity.clear();
+
         if ( cost != mVisualComplexity )
         {
             LL_DEBUGS("AvatarRender") << "Avatar "<< getID()
@@ -29,6 +29,8 @@
 #define LL_VOAVATAR_H
 
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <deque>
 #include <string>
 #include <vector>
@@ -201,7 +203,8 @@ public:
 	void					startDefaultMotions();
 	void					dumpAnimationState();
 
-	virtual LLJoint*		getJoint(const std::string &name);
+	using LLCharacter::getJoint;
+	virtual LLJoint*		getJoint(const LLInternedString &name);
 	LLJoint*		        getJoint(S32 num);
 
     //if you KNOW joint_num is a valid animated joint index, use getSkeletonJoint for efficiency
@@ -210,7 +213,7 @@ public:
 
     void 					notifyAttachmentMeshLoaded();
 	void 					addAttachmentOverridesForObject(LLViewerObject *vo, std::set<LLUUID>* meshes_seen = NULL, bool recursive = true);
-	void					removeAttachmentOverridesForObject(const LLUUID& mesh_id);
+	void					removeAttachmentOverridesForObject(const LLUUID& mesh_id, bool recalc = true);
 	void					removeAttachmentOverridesForObject(LLViewerObject *vo);
     bool					jointIsRiggedTo(const LLJoint *joint) const;
 	void					clearAttachmentOverrides();
@@ -271,11 +274,18 @@ public:
 	virtual void	updateDebugText();
 	virtual bool 	computeNeedsUpdate();
 	virtual bool 	updateCharacter(LLAgent &agent);
+	// evaluate the motions updateCharacter() left to the pipeline threads (see "AvatarParallelMotions")
+	static void		updateDeferredMotions();
+	// LOD rebuilds of another avatar's attachments wait here, then go out
+	// together once per frame within a global budget (see "RenderAttachmentLODRebuildsPerFrame")
+	void			queueAttachmentLODRebuild(LLDrawable* drawable);
+	static void		processAttachmentLODRebuilds();
     void			updateFootstepSounds();
     void			computeUpdatePeriod();
     void			updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
     void			updateTimeStep();
     void			updateRootPositionAndRotation(LLAgent &agent, F32 speed, bool was_sit_ground_constrained);
+    void			updateCharacterPose(bool visible, bool was_sit_ground_constrained);
     
 	void 			idleUpdateVoiceVisualizer(bool voice_enabled);
 	void 			idleUpdateMisc(bool detailed_update);
@@ -304,6 +314,27 @@ public:
 	void			calculateUpdateRenderComplexity();
 	static const U32 VISUAL_COMPLEXITY_UNKNOWN;
 	void			updateVisualComplexity();
+	// as above, and recompute the cached cost of the attachment or animated
+	// object whose linkset changed_object is part of
+	void			updateVisualComplexity(LLViewerObject* changed_object);
+
+	// What one top level object (an attachment, or the root of a standalone
+	// animated object) adds to the avatar's complexity. Kept per object and
+	// recomputed only when updateVisualComplexity is told the object changed.
+	struct ObjectComplexity
+	{
+		const LLViewerObject* mObject = nullptr;
+		bool	mIsHUD = false;
+		bool	mHasVolume = false;
+		F32		mCost = 0.f;			// volume, children and texture cost, before clamping
+		U32		mVisibleTriangles = 0;
+		F32		mEstTriangles = 0.f;
+		F32		mSurfaceArea = 0.f;
+		LLHUDComplexity mHUDComplexity;	// for the agent's own HUD attachments
+	};
+	// cached complexity of the object with the given id, NULL if it has
+	// not been accounted for (yet)
+	const ObjectComplexity* getObjectComplexity(const LLUUID& object_id) const;
 	
     void placeProfileQuery();
     void readProfileQuery(S32 retries);
@@ -553,6 +584,7 @@ private:
 	F32			mLastSkinTime; //value of gFrameTimeSeconds at last skin update
 
 	S32	 		mUpdatePeriod;
+	std::vector<LLPointer<LLDrawable> > mPendingLODRebuilds; // see queueAttachmentLODRebuild()
 	S32  		mNumInitFaces; //number of faces generated when creating the avatar drawable, does not inculde splitted faces due to long vertex buffer.
 
     // profile handle
@@ -571,6 +603,9 @@ private:
     // DEPRECATED -- obsolete avatar render cost values
 	mutable U32  mVisualComplexity;
 	mutable bool mVisualComplexityStale;
+	std::unordered_map<LLUUID, ObjectComplexity> mObjectComplexity;
+	std::unordered_set<LLUUID> mStaleObjectComplexity;
+	const ObjectComplexity& getUpdatedObjectComplexity(LLViewerObject* object, LLVOVolume::texture_cost_t& textures);
 	U32          mReportedVisualComplexity; // from other viewers through the simulator
 
 	mutable bool		mCachedInMuteList;
@@ -635,6 +670,9 @@ public:
 	static void	resetImpostors();
 	static void updateImpostors();
 	LLRenderTarget mImpostor;
+	S32			mImpostorSlot;		// slot in gPipeline.mImpostorAtlas used instead of mImpostor, or -1
+	LLVector4	mImpostorTexRect;	// texture coordinates of the impostor in its atlas slot
+	void		releaseImpostorSlot();
 	BOOL		mNeedsImpostorUpdate;
 	S32			mLastImpostorUpdateReason;
 	F32SecondsImplicit mLastImpostorUpdateFrameTime;
@@ -1166,6 +1204,7 @@ public:
 	void				dumpArchetypeXML(const std::string& prefix, bool group_by_wearables = false);
 	void 				dumpAppearanceMsgParams( const std::string& dump_prefix,
 												 const LLAppearanceMessageContents& contents);
+	bool				loadAppearanceDump(const std::string& filename);
 	static void			dumpBakedStatus();
 	const std::string 	getBakedStatusForPrintout() const;
 	void				dumpAvatarTEs(const std::string& context) const;
@@ -707,7 +707,7 @@ void LLVOAvatarSelf::idleUpdate(LLAgent &agent, const F64 &time)
 }
 
 // virtual
-LLJoint *LLVOAvatarSelf::getJoint(const std::string &name)
+LLJoint *LLVOAvatarSelf::getJoint(const LLInternedString &name)
 {
     LLJoint *jointp = NULL;
     jointp = LLVOAvatar::getJoint(name);
@@ -33,6 +33,9 @@
 #include "llviewerregion.h"
 #include "llagentcamera.h"
 #include "llsdserialize.h"
+#include "llsdutil.h"
+#include "threadpool.h"
+#include "workqueue.h"
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -100,9 +103,9 @@ bool LLGLTFOverrideCacheEntry::fromLLSD(const LLSD& data)
             {
                 S32 side_idx = sides[i].asInteger();
                 mSides[side_idx] = gltf_llsd[i];
-                LLGLTFMaterial* override_mat = new LLGLTFMaterial();
+                LLPointer<LLGLTFMaterial> override_mat = new LLGLTFMaterial();
                 override_mat->applyOverrideLLSD(gltf_llsd[i]);
-                mGLTFMaterial[side_idx] = override_mat;
+                mGLTFMaterial[side_idx] = LLGLTFMaterial::shareOverride(override_mat);
             }
         }
         else
@@ -163,7 +166,9 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
 	mSceneContrib(0.f),
 	mValid(TRUE),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mFileOffset(0),
+	mFileSize(0)
 {
 	mBuffer = new U8[dp.getBufferSize()];
 	mDP.assignBuffer(mBuffer, dp.getBufferSize());
@@ -183,7 +188,9 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mSceneContrib(0.f),
 	mValid(TRUE),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mFileOffset(0),
+	mFileSize(0)
 {
 	mDP.assignBuffer(mBuffer, 0);
 }
@@ -196,7 +203,9 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 	mSceneContrib(0.f),
 	mValid(FALSE),
 	mParentID(0),
-	mBSphereRadius(-1.0f)
+	mBSphereRadius(-1.0f),
+	mFileOffset(0),
+	mFileSize(0)
 {
 	S32 size = -1;
 	BOOL success;
@@ -253,6 +262,28 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 	}
 }
 
+LLVOCacheEntry::LLVOCacheEntry(const LLVOCacheRegionFile::Record& record, LLVOCacheRegionFile* file)
+:	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY), 
+	mLocalID(record.mLocalID),
+	mCRC(record.mCRC),
+	mUpdateFlags(-1),
+	mHitCount(record.mHitCount),
+	mDupeCount(record.mDupeCount),
+	mCRCChangeCount(record.mCRCChangeCount),
+	mBuffer(NULL),
+	mState(INACTIVE),
+	mSceneContrib(0.f),
+	mValid(FALSE),
+	mParentID(0),
+	mBSphereRadius(-1.0f),
+	mFile(file),
+	mFileOffset(record.mOffset),
+	mFileSize(record.mSize)
+{
+	// the body stays in the file until getDP() wants it
+	mDP.assignBuffer(mBuffer, 0);
+}
+
 LLVOCacheEntry::~LLVOCacheEntry()
 {
 	mDP.freeBuffer();
@@ -272,6 +303,9 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
 	mBuffer = new U8[dp.getBufferSize()];
 	mDP.assignBuffer(mBuffer, dp.getBufferSize());
 	mDP = dp;
+
+	// the copy in the cache file is stale now
+	mFile = NULL;
 }
 
 void LLVOCacheEntry::setParentID(U32 id) 
@@ -302,7 +336,7 @@ void LLVOCacheEntry::removeAllChildren()
 //virtual 
 void LLVOCacheEntry::setOctreeEntry(LLViewerOctreeEntry* entry)
 {
-	if(!entry && mDP.getBufferSize() > 0)
+	if(!entry && getDP())
 	{
 		LLUUID fullid;
 		LLViewerObject::unpackUUID(&mDP, fullid, "ID");
@@ -401,13 +435,57 @@ LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 {
 	if (mDP.getBufferSize() == 0)
 	{
-		//LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
-		return NULL;
+		if (mFile.isNull() || mFileSize <= 0)
+		{
+			//LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
+			return NULL;
+		}
+
+		// first use, copy the body out of the mapped file
+		mBuffer = new U8[mFileSize];
+		memcpy(mBuffer, mFile->getData(mFileOffset), mFileSize);
+		mDP.assignBuffer(mBuffer, mFileSize);
 	}
 	
 	return &mDP;
 }
 
+const U8* LLVOCacheEntry::getBody(S32& size) const
+{
+	if (mDP.getBufferSize() > 0)
+	{
+		size = mDP.getBufferSize();
+		return mBuffer;
+	}
+	if (mFile.notNull() && mFileSize > 0)
+	{
+		size = mFileSize;
+		return mFile->getData(mFileOffset);
+	}
+	size = 0;
+	return NULL;
+}
+
+void LLVOCacheEntry::detachFromCacheFile()
+{
+	if (mFile.notNull())
+	{
+		getDP();
+		mFile = NULL;
+	}
+}
+
+void LLVOCacheEntry::fillRecord(LLVOCacheRegionFile::Record& record, U32 offset, S32 size) const
+{
+	record.mLocalID = mLocalID;
+	record.mCRC = mCRC;
+	record.mHitCount = mHitCount;
+	record.mDupeCount = mDupeCount;
+	record.mCRCChangeCount = mCRCChangeCount;
+	record.mOffset = offset;
+	record.mSize = size;
+}
+
 void LLVOCacheEntry::recordHit()
 {
 	mHitCount++;
@@ -424,27 +502,6 @@ void LLVOCacheEntry::dump() const
 		<< LL_ENDL;
 }
 
-S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
-{
-    S32 size = mDP.getBufferSize();
-
-    if (size > MAX_ENTRY_BODY_SIZE)
-    {
-        LL_WARNS() << "Failed to write entry with size above allowed limit: " << size << LL_ENDL;
-        return 0;
-    }
-
-    memcpy(data_buffer, &mLocalID, sizeof(U32));
-    memcpy(data_buffer + sizeof(U32), &mCRC, sizeof(U32));
-    memcpy(data_buffer + (2 * sizeof(U32)), &mHitCount, sizeof(S32));
-    memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
-    memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
-    memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
-    memcpy(data_buffer + ENTRY_HEADER_SIZE, (void*)mBuffer, size);
-
-    return ENTRY_HEADER_SIZE + size;
-}
-
 #ifndef LL_TEST
 //static 
 void LLVOCacheEntry::updateDebugSettings()
@@ -974,18 +1031,37 @@ void LLVOCachePartition::selectBackObjects(LLCamera &camera, F32 pixel_threshold
 S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
 {
 	static LLCachedControl<bool> use_object_cache_occlusion(gSavedSettings,"UseObjectCacheOcclusion");
-	
-	if(!LLViewerRegion::sVOCacheCullingEnabled)
+
+	if(!prepareCull())
 	{
 		return 0;
 	}
+
+	S32 res = traverseCull(camera, do_occlusion && use_object_cache_occlusion);
+	if(res)
+	{
+		finishCull();
+	}
+	return res;
+}
+
+bool LLVOCachePartition::prepareCull()
+{
+	if(!LLViewerRegion::sVOCacheCullingEnabled)
+	{
+		return false;
+	}
 	if(mRegionp->isPaused())
 	{
-		return 0;
+		return false;
 	}
 
 	((LLViewerOctreeGroup*)mOctree->getListener(0))->rebound();
+	return true;
+}
 
+S32 LLVOCachePartition::traverseCull(LLCamera &camera, bool use_occlusion)
+{
 	if(LLViewerCamera::sCurCameraID != LLViewerCamera::CAMERA_WORLD)
 	{
 		return 0; //no need for those cameras.
@@ -1012,8 +1088,7 @@ S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
 			mFrontCull = FALSE;
 
 			//process back objects selection
-			selectBackObjects(camera, LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull), 
-				do_occlusion && use_object_cache_occlusion);
+			selectBackObjects(camera, LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull), use_occlusion);
 			return 0; //nothing changed, reduce frequency of culling
 		}
 	}
@@ -1027,15 +1102,19 @@ S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
 	camera.calcRegionFrustumPlanes(region_agent, gAgentCamera.mDrawDistance);
 
 	mFrontCull = TRUE;
-	LLVOCacheOctreeCull culler(&camera, mRegionp, region_agent, do_occlusion && use_object_cache_occlusion, 
+	LLVOCacheOctreeCull culler(&camera, mRegionp, region_agent, use_occlusion, 
 		LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull), this);
 	culler.traverse(mOctree);	
 
+	return 1;
+}
+
+void LLVOCachePartition::finishCull()
+{
 	if(!sNeedsOcclusionCheck)
 	{
 		sNeedsOcclusionCheck = !mOccludedGroups.empty();
 	}
-	return 1;
 }
 #endif // LL_TEST
 
@@ -1108,6 +1187,46 @@ void LLVOCachePartition::removeOccluder(LLVOCacheGroup* group)
 	}
 	mOccludedGroups.erase(group);
 }
+//-------------------------------------------------------------------
+//LLVOCacheRegionFile
+//-------------------------------------------------------------------
+bool LLVOCacheRegionFile::open(const std::string& filename)
+{
+	if (!mFile.open(filename))
+	{
+		return false;
+	}
+
+	if (mFile.getSize() < sizeof(Header))
+	{
+		mFile.close();
+		return false;
+	}
+
+	const Header& header = getHeader();
+	if (header.mMagic != MAGIC
+		|| header.mVersion != VERSION
+		|| header.mTableOffset < sizeof(Header)
+		|| header.mTableOffset % 4 != 0
+		|| header.mTableOffset > mFile.getSize()
+		|| header.mNumEntries > (mFile.getSize() - header.mTableOffset) / sizeof(Record))
+	{
+		mFile.close();
+		return false;
+	}
+
+	memcpy(mCacheID.mData, header.mCacheID, UUID_BYTES);
+	return true;
+}
+
+bool LLVOCacheRegionFile::isValidBody(U32 offset, S32 size) const
+{
+	return size > 0 && size <= MAX_ENTRY_BODY_SIZE
+		&& offset >= sizeof(Header)
+		&& offset <= getHeader().mTableOffset
+		&& (U32)size <= getHeader().mTableOffset - offset;
+}
+
 //-------------------------------------------------------------------
 //LLVOCache
 //-------------------------------------------------------------------
@@ -1120,6 +1239,27 @@ const U32 MIN_ENTRIES_TO_PURGE = 16 ;
 const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
+const char* temp_file_suffix = ".tmp";
+
+// Key for cache header writes in mPendingWrites.  Never a region handle,
+// those are multiples of the region width.
+const U64 CACHE_HEADER_WRITE = U64(-1);
+
+// Move a completely written temporary file over filename, so a crash part
+// way through writing leaves the old file as it was.
+static bool replace_file(const std::string& temp_filename, const std::string& filename)
+{
+#if LL_WINDOWS
+	// rename won't replace an existing file here
+	LLFile::remove(filename, ENOENT);
+#endif
+	if (LLFile::rename(temp_filename, filename) != 0)
+	{
+		LLFile::remove(temp_filename, ENOENT);
+		return false;
+	}
+	return true;
+}
 
 
 LLVOCache::LLVOCache(bool read_only) :
@@ -1127,16 +1267,34 @@ LLVOCache::LLVOCache(bool read_only) :
 	mReadOnly(read_only),
 	mNumEntries(0),
 	mCacheSize(1),
-    mEnabled(true)
+    mEnabled(true),
+	mPrefetchedHandle(0),
+	mHeaderDirty(false),
+	mWriterThread(NULL)
 {
 #ifndef LL_TEST
 	mEnabled = gSavedSettings.getBOOL("ObjectCacheEnabled");
 #endif
 	mLocalAPRFilePoolp = new LLVolatileAPRPool() ;
+
+	if (mEnabled)
+	{
+		// one thread, so a region's writes land in the order they were made
+		mWriterThread = new LL::ThreadPool("VOCacheWriter", 1);
+		mWriterThread->start();
+	}
 }
 
 LLVOCache::~LLVOCache()
 {
+	if (mWriterThread)
+	{
+		// finishes the writes already queued
+		mWriterThread->close();
+		delete mWriterThread;
+		mWriterThread = NULL;
+	}
+
 	if(mEnabled)
 	{
 		writeCacheHeader();
@@ -1218,6 +1376,8 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 
 	LL_INFOS() << "about to remove the object cache due to settings." << LL_ENDL ;
 
+	waitForAllWrites();
+
 	std::string mask = "*";
 	std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
 	LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
@@ -1242,6 +1402,8 @@ void LLVOCache::removeCache()
 		return ;
 	}
 
+	waitForAllWrites();
+
 	std::string mask = "*";
 	LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
@@ -1266,6 +1428,11 @@ void LLVOCache::removeEntry(HeaderEntryInfo* entry)
 	if(iter != mHeaderEntryQueue.end())
 	{		
 		mHandleEntryMap.erase(entry->mHandle);		
+		mRegionFiles.erase(entry->mHandle);
+		if (mPrefetchedHandle == entry->mHandle)
+		{
+			mPrefetchedFile = NULL;
+		}
 		mHeaderEntryQueue.erase(iter);
 		removeFromCache(entry);
 		delete entry;
@@ -1297,7 +1464,8 @@ void LLVOCache::clearCacheInMemory()
 		mHandleEntryMap.clear();
 		mNumEntries = 0 ;
 	}
-
+	mRegionFiles.clear();
+	mPrefetchedFile = NULL;
 }
 
 void LLVOCache::getObjectCacheFilename(U64 handle, std::string& filename) 
@@ -1328,11 +1496,13 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
+	waitForWrites(entry->mHandle);
+
 	std::string filename;
 	getObjectCacheFilename(entry->mHandle, filename);
 	LLAPRFile::remove(filename, mLocalAPRFilePoolp);
 	entry->mTime = INVALID_TIME ;
-	updateEntry(entry) ; //update the head file.
+	mHeaderDirty = true;
 }
 
 void LLVOCache::readCacheHeader()
@@ -1432,50 +1602,164 @@ void LLVOCache::writeCacheHeader()
 		return;
 	}
 
-	bool success = true ;
+	waitForWrites(CACHE_HEADER_WRITE);
+
+	std::vector<U8> data;
+	buildCacheHeader(data);
+	mHeaderDirty = false;
+
+	bool success = writeHeaderFile(mHeaderFileName, data);
+
+	if(!success)
+	{
+		clearCacheInMemory() ;
+		mReadOnly = TRUE ; //disable the cache.
+	}
+	return ;
+}
+
+void LLVOCache::buildCacheHeader(std::vector<U8>& data)
+{
+	data.clear();
+	data.reserve(sizeof(HeaderMetaInfo) + MAX_NUM_OBJECT_ENTRIES * sizeof(HeaderEntryInfo));
+
+	//the meta element
+	const U8* meta = (const U8*)&mMetaInfo;
+	data.insert(data.end(), meta, meta + sizeof(HeaderMetaInfo));
+
+	mNumEntries = 0 ;
+	for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ; iter != mHeaderEntryQueue.end(); ++iter)
 	{
-		LLAPRFile apr_file(mHeaderFileName, APR_CREATE|APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
+		(*iter)->mIndex = mNumEntries++ ;
+		const U8* entry = (const U8*)*iter;
+		data.insert(data.end(), entry, entry + sizeof(HeaderEntryInfo));
+	}
+
+	//fill the cache with the default entry.
+	HeaderEntryInfo empty_entry;
+	empty_entry.mTime = INVALID_TIME ;
+	for(U32 i = mNumEntries ; i < MAX_NUM_OBJECT_ENTRIES ; i++)
+	{
+		data.insert(data.end(), (const U8*)&empty_entry, (const U8*)&empty_entry + sizeof(HeaderEntryInfo));
+	}
+}
 
-		//write the meta element
-		success = check_write(&apr_file, &mMetaInfo, sizeof(HeaderMetaInfo)) ;
+//static
+bool LLVOCache::writeHeaderFile(const std::string& filename, const std::vector<U8>& data)
+{
+	std::string temp_filename = filename + temp_file_suffix;
+	bool success;
+	{
+		LLAPRFile apr_file(temp_filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE);
+		success = check_write(&apr_file, (void*)&data[0], (S32)data.size());
+	}
+	if (!success)
+	{
+		LLFile::remove(temp_filename, ENOENT);
+		return false;
+	}
+	return replace_file(temp_filename, filename);
+}
 
+void LLVOCache::flushCacheHeader()
+{
+	if (!mHeaderDirty || !mEnabled || !mInitialized || mReadOnly)
+	{
+		return;
+	}
+	mHeaderDirty = false;
 
-		mNumEntries = 0 ;	
-		for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ; success && iter != mHeaderEntryQueue.end(); ++iter)
+	// a region crossing can write several regions at once, they all go out
+	// in one header write
+	std::shared_ptr<std::vector<U8> > data = std::make_shared<std::vector<U8> >();
+	buildCacheHeader(*data);
+	std::string filename = mHeaderFileName;
+	postWrite(CACHE_HEADER_WRITE, [filename, data]()
+	{
+		if (!writeHeaderFile(filename, *data))
 		{
-			(*iter)->mIndex = mNumEntries++ ;
-			success = check_write(&apr_file, (void*)*iter, sizeof(HeaderEntryInfo));
+			LL_WARNS() << "Failed to write object cache header " << filename << LL_ENDL;
 		}
-	
-		mNumEntries = mHeaderEntryQueue.size() ;
-		if(success && mNumEntries < MAX_NUM_OBJECT_ENTRIES)
-		{
-			HeaderEntryInfo* entry = new HeaderEntryInfo() ;
-			entry->mTime = INVALID_TIME ;
-			for(S32 i = mNumEntries ; success && i < MAX_NUM_OBJECT_ENTRIES ; i++)
-			{
-				//fill the cache with the default entry.
-				success = check_write(&apr_file, entry, sizeof(HeaderEntryInfo)) ;			
+	});
+}
 
-			}
-			delete entry ;
-		}
+void LLVOCache::postWrite(U64 handle, const std::function<void()>& write)
+{
+	{
+		std::lock_guard<std::mutex> lock(mPendingMutex);
+		mPendingWrites[handle]++;
 	}
 
-	if(!success)
+	bool posted = mWriterThread && mWriterThread->getQueue().post([this, handle, write]()
 	{
-		clearCacheInMemory() ;
-		mReadOnly = TRUE ; //disable the cache.
+		write();
+		finishWrite(handle);
+	});
+	if (!posted)
+	{
+		// shutting down
+		write();
+		finishWrite(handle);
 	}
-	return ;
 }
 
-BOOL LLVOCache::updateEntry(const HeaderEntryInfo* entry)
+void LLVOCache::finishWrite(U64 handle)
 {
-	LLAPRFile apr_file(mHeaderFileName, APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
-	apr_file.seek(APR_SET, entry->mIndex * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)) ;
+	{
+		std::lock_guard<std::mutex> lock(mPendingMutex);
+		std::map<U64, S32>::iterator iter = mPendingWrites.find(handle);
+		if (iter != mPendingWrites.end() && --iter->second <= 0)
+		{
+			mPendingWrites.erase(iter);
+		}
+	}
+	mPendingCond.notify_all();
+}
 
-	return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
+bool LLVOCache::hasPendingWrites(U64 handle)
+{
+	std::lock_guard<std::mutex> lock(mPendingMutex);
+	return mPendingWrites.find(handle) != mPendingWrites.end();
+}
+
+void LLVOCache::waitForWrites(U64 handle)
+{
+	std::unique_lock<std::mutex> lock(mPendingMutex);
+	mPendingCond.wait(lock, [this, handle]() { return mPendingWrites.find(handle) == mPendingWrites.end(); });
+}
+
+void LLVOCache::waitForAllWrites()
+{
+	std::unique_lock<std::mutex> lock(mPendingMutex);
+	mPendingCond.wait(lock, [this]() { return mPendingWrites.empty(); });
+}
+
+void LLVOCache::prefetchRegion(U64 handle)
+{
+	if (!mEnabled || !mInitialized || mRegionFiles.count(handle) || mHandleEntryMap.find(handle) == mHandleEntryMap.end())
+	{
+		return; //already read, or nothing cached
+	}
+	if (hasPendingWrites(handle))
+	{
+		return; //the file is still being written, it's read when it's done
+	}
+	if (mPrefetchedFile.notNull() && mPrefetchedHandle == handle)
+	{
+		return;
+	}
+
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+
+	LLPointer<LLVOCacheRegionFile> region_file = new LLVOCacheRegionFile();
+	if (region_file->open(filename))
+	{
+		// the cache id is checked when the region arrives and reads it
+		region_file->willNeed();
+		mPrefetchedFile = region_file;
+		mPrefetchedHandle = handle;
+	}
 }
 
 void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) 
@@ -1494,11 +1778,54 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 		return ;
 	}
 
+	// left and come straight back
+	waitForWrites(handle);
+
 	bool success = true ;
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+
+	LLPointer<LLVOCacheRegionFile> region_file;
+	if (mPrefetchedFile.notNull() && mPrefetchedHandle == handle)
 	{
-		std::string filename;
+		region_file = mPrefetchedFile;
+	}
+	else
+	{
+		region_file = new LLVOCacheRegionFile();
+	}
+	mPrefetchedFile = NULL;
+
+	if (region_file->isOpen() || region_file->open(filename))
+	{
+		if (region_file->getCacheID() != id)
+		{
+			LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+			success = false;
+		}
+		else
+		{
+			// only the table is read here, entries pick up their bodies when they're used
+			const LLVOCacheRegionFile::Record* records = region_file->getRecords();
+			U32 num_entries = region_file->getHeader().mNumEntries;
+			for (U32 i = 0; i < num_entries; i++)
+			{
+				const LLVOCacheRegionFile::Record& record = records[i];
+				if (!record.mLocalID || !region_file->isValidBody(record.mOffset, record.mSize))
+				{
+					LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+					success = false;
+					break;
+				}
+				cache_entry_map[record.mLocalID] = new LLVOCacheEntry(record, region_file);
+			}
+			mRegionFiles[handle] = region_file;
+		}
+	}
+	else
+	{
+		// cache file from before the mapped format
 		LLUUID cache_id;
-		getObjectCacheFilename(handle, filename);
 		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
 	
 		success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
@@ -1536,6 +1863,9 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 	
 	if(!success)
 	{
+		// don't append to a file that didn't read back
+		mRegionFiles.erase(handle);
+
 		if(cache_entry_map.empty())
 		{
 			removeEntry(iter->second) ;
@@ -1561,6 +1891,8 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
         return;
     }
 
+    waitForWrites(handle);
+
     std::string filename(getObjectCacheExtrasFilename(handle));
     llifstream in(filename, std::ios::in | std::ios::binary);
 
@@ -1679,84 +2011,170 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		mHeaderEntryQueue.insert(entry) ;
 	}
 
-	//update cache header
-	if(!updateEntry(entry))
+	//this is the last use of the file the region was read from
+	LLPointer<LLVOCacheRegionFile> region_file;
+	region_file_map_t::iterator file_iter = mRegionFiles.find(handle);
+	if (file_iter != mRegionFiles.end())
 	{
-		LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
-		return ; //update failed.
+		if (file_iter->second->getCacheID() == id)
+		{
+			region_file = file_iter->second;
+		}
+		mRegionFiles.erase(file_iter);
 	}
 
+	//the header goes out with the next flushCacheHeader()
+	mHeaderDirty = true;
+
 	if(!dirty_cache)
 	{
 		LL_WARNS() << "Skipping write to cache for handle " << handle << ": cache not dirty" << LL_ENDL;
 		return ; //nothing changed, no need to update.
 	}
 
-	//write to cache file
-	bool success = true ;
+	std::vector<LLVOCacheEntry*> entries;
+	entries.reserve(cache_entry_map.size());
+	U32 kept_bytes = 0;		//bodies that stay where they are in region_file
+	U32 new_bytes = 0;		//bodies to append
+	for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
 	{
-		std::string filename;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
-	
-		if(success)
+		if (removal_enabled && !iter->second->isValid())
 		{
-			S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
-            {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    size_in_buffer = 0;
-                }
-            }
+			continue;
+		}
+
+		S32 size = 0;
+		if (!iter->second->getBody(size) || size > MAX_ENTRY_BODY_SIZE)
+		{
+			LL_WARNS() << "Skipping cache entry " << iter->first << " with body size " << size << LL_ENDL;
+			continue;
+		}
+
+		entries.push_back(iter->second);
+		if (iter->second->isInCacheFile(region_file))
+		{
+			kept_bytes += size;
+		}
+		else
+		{
+			new_bytes += size;
 		}
 	}
 
-	if(!success)
+	//copy out what goes in the file, the writer thread doesn't touch the entries
+	std::shared_ptr<RegionFileWrite> write = std::make_shared<RegionFileWrite>();
+	getObjectCacheFilename(handle, write->mFilename);
+	write->mAppend = false;
+	if (region_file.notNull())
 	{
-		removeEntry(entry) ;
+		//everything in the old file but the kept bodies goes dead
+		U32 dead_bytes = (U32)region_file->getSize() - sizeof(LLVOCacheRegionFile::Header) - kept_bytes;
+		if (dead_bytes <= kept_bytes + new_bytes)
+		{
+			write->mAppend = true;
+			write->mBodyOffset = region_file->getSize();
+			write->mHeader = region_file->getHeader();
+			write->mHeader.mDeadBytes = dead_bytes;
+		}
+		else
+		{
+			//mostly dead, start over.  Copy everything out of the mapping
+			//first, the file can't be replaced while it's mapped.
+			for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
+			{
+				iter->second->detachFromCacheFile();
+			}
+			region_file = NULL;
+		}
 	}
 
-	return ;
+	if (!write->mAppend)
+	{
+		write->mBodyOffset = sizeof(LLVOCacheRegionFile::Header);
+		write->mHeader.mMagic = LLVOCacheRegionFile::MAGIC;
+		write->mHeader.mVersion = LLVOCacheRegionFile::VERSION;
+		memcpy(write->mHeader.mCacheID, id.mData, UUID_BYTES);
+		write->mHeader.mDeadBytes = 0;
+	}
+
+	write->mBodies.reserve(write->mAppend ? new_bytes + 3 : kept_bytes + new_bytes + 3);
+	write->mRecords.resize(entries.size());
+	U32 offset = write->mBodyOffset;
+	for (U32 i = 0; i < entries.size(); ++i)
+	{
+		S32 size = 0;
+		const U8* body = entries[i]->getBody(size);
+		if (write->mAppend && entries[i]->isInCacheFile(region_file))
+		{
+			entries[i]->fillRecord(write->mRecords[i], entries[i]->getCacheFileOffset(), size);
+		}
+		else
+		{
+			write->mBodies.insert(write->mBodies.end(), body, body + size);
+			entries[i]->fillRecord(write->mRecords[i], offset, size);
+			offset += size;
+		}
+	}
+
+	//keep the table aligned for reading in place
+	U32 padding = (4 - offset % 4) % 4;
+	write->mBodies.resize(write->mBodies.size() + padding, 0);
+	write->mHeader.mTableOffset = offset + padding;
+	write->mHeader.mNumEntries = (U32)entries.size();
+
+	postWrite(handle, [handle, write]()
+	{
+		if (!writeRegionFile(*write))
+		{
+			LL_WARNS() << "Failed to write object cache file " << write->mFilename << LL_ENDL;
+			// forget the region rather than read a broken file back
+			LL::WorkQueue::postMaybe(LL::WorkQueue::getInstance("mainloop"), [handle]()
+			{
+				if (LLVOCache::instanceExists())
+				{
+					LLVOCache::getInstance()->removeEntry(handle);
+				}
+			});
+		}
+	});
+}
+
+// Writer thread.  Appending adds the new and changed bodies to the end of the
+// file, then a new table, and points the header at it last so a write that
+// doesn't finish leaves the old table in charge.  Anything else is written
+// to a temporary file that replaces the old one when it's complete.
+//static
+bool LLVOCache::writeRegionFile(const RegionFileWrite& write)
+{
+	std::string filename = write.mAppend ? write.mFilename : write.mFilename + temp_file_suffix;
+	bool success = true;
+	{
+		LLAPRFile apr_file(filename, write.mAppend ? APR_WRITE|APR_BINARY : APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE);
+		success = apr_file.seek(APR_SET, write.mBodyOffset) == (S32)write.mBodyOffset;
+		if (success && !write.mBodies.empty())
+		{
+			success = check_write(&apr_file, (void*)&write.mBodies[0], (S32)write.mBodies.size());
+		}
+		if (success && !write.mRecords.empty())
+		{
+			success = check_write(&apr_file, (void*)&write.mRecords[0], (S32)(write.mRecords.size() * sizeof(LLVOCacheRegionFile::Record)));
+		}
+		if (success)
+		{
+			success = apr_file.seek(APR_SET, 0) == 0 && check_write(&apr_file, (void*)&write.mHeader, sizeof(write.mHeader));
+		}
+	}
+
+	if (!write.mAppend)
+	{
+		if (!success)
+		{
+			LLFile::remove(filename, ENOENT);
+			return false;
+		}
+		success = replace_file(filename, write.mFilename);
+	}
+	return success;
 }
 
 void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, BOOL dirty_cache, bool removal_enabled)
@@ -1774,46 +2192,63 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
         return;
     }
 
-    std::string filename(getObjectCacheExtrasFilename(handle));
-    llofstream out(filename, std::ios::out | std::ios::binary);
-    if(!out.good())
+    // deep copies, the writer thread can't share LLSD with the main thread
+    std::shared_ptr<std::vector<LLSD> > entries = std::make_shared<std::vector<LLSD> >();
+    entries->reserve(cache_extras_entry_map.size());
+    for (auto const & entry : cache_extras_entry_map)
     {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        return;
-        // TODO - clean up broken cache file
+        LLSD entry_llsd = llsd_clone(entry.second.toLLSD());
+        entry_llsd["local_id"] = (S32)entry.first;
+        entries->push_back(entry_llsd);
     }
 
-    out << id << '\n';
-    if(!out.good())
+    std::string filename(getObjectCacheExtrasFilename(handle));
+    postWrite(handle, [handle, filename, id, entries]()
     {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        return;
-        // TODO - clean up broken cache file
-    }
+        writeExtrasFile(handle, filename, id, *entries);
+    });
+}
 
-    U32 num_entries = cache_extras_entry_map.size();
-    out << num_entries << '\n';
-    if(!out.good())
+//static
+void LLVOCache::writeExtrasFile(U64 handle, const std::string& filename, const LLUUID& id, const std::vector<LLSD>& entries)
+{
+    std::string temp_filename = filename + temp_file_suffix;
     {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        return;
-        // TODO - clean up broken cache file
-    }
+        llofstream out(temp_filename, std::ios::out | std::ios::binary);
+        if(!out.good())
+        {
+            LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
+            return;
+        }
+
+        out << id << '\n';
+        U32 num_entries = entries.size();
+        out << num_entries << '\n';
+
+        for (auto const & entry_llsd : entries)
+        {
+            LLSDSerialize::serialize(entry_llsd, out, LLSDSerialize::LLSD_XML);
+            out << '\n';
+            if(!out.good())
+            {
+                break;
+            }
+        }
 
-    for (auto const & entry : cache_extras_entry_map)
-    {
-        S32 local_id = entry.first;
-        LLSD entry_llsd = entry.second.toLLSD();
-        entry_llsd["local_id"] = local_id;
-        LLSDSerialize::serialize(entry_llsd, out, LLSDSerialize::LLSD_XML);
-        out << '\n';
         if(!out.good())
         {
             LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
+            out.close();
+            LLFile::remove(temp_filename, ENOENT);
             return;
-            // TODO - clean up broken cache file
         }
     }
 
-    LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << num_entries << " entries" << LL_ENDL;
+    if (!replace_file(temp_filename, filename))
+    {
+        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
+        return;
+    }
+
+    LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << entries.size() << " entries" << LL_ENDL;
 }
@@ -32,8 +32,14 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
+#include "llfile.h"
+#include "llrefcount.h"
 #include "llgltfmaterial.h"
+#include "threadpool_fwd.h"
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <unordered_map>
 
 //---------------------------------------------------------------------------
@@ -53,6 +59,59 @@ public:
     U64 mRegionHandle = 0;
 };
 
+// A region's object cache file, mapped into memory.  The file is a header,
+// the entry bodies, then a table with one Record per entry.  Entries read
+// from it keep it mapped and only copy their body out the first time it's
+// needed, most cached objects never are before the region is left.
+// Saving appends new and changed bodies and a new table, the bodies
+// already in the file stay where they are.
+class LLVOCacheRegionFile : public LLRefCount
+{
+public:
+	struct Header
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U8  mCacheID[UUID_BYTES];
+		U32 mTableOffset;
+		U32 mNumEntries;
+		U32 mDeadBytes;		// bodies and tables nothing refers to any more
+	};
+
+	struct Record
+	{
+		U32 mLocalID;
+		U32 mCRC;
+		S32 mHitCount;
+		S32 mDupeCount;
+		S32 mCRCChangeCount;
+		U32 mOffset;
+		S32 mSize;
+	};
+
+	static const U32 MAGIC = 0x32434f56; // "VOC2"
+	static const U32 VERSION = 1;
+
+	// Map filename.  False if it can't be mapped or isn't in this format,
+	// files from before it start with the cache id instead.
+	bool open(const std::string& filename);
+
+	const LLUUID& getCacheID() const		{ return mCacheID; }
+	const Header& getHeader() const			{ return *(const Header*)mFile.getData(); }
+	const Record* getRecords() const		{ return (const Record*)(mFile.getData() + getHeader().mTableOffset); }
+	const U8* getData(U32 offset) const		{ return mFile.getData() + offset; }
+	U32 getSize() const						{ return (U32)mFile.getSize(); }
+	void willNeed() const					{ mFile.willNeed(); }
+	bool isOpen() const						{ return mFile.isOpen(); }
+
+	// true if the body is entirely between the header and the table
+	bool isValidBody(U32 offset, S32 size) const;
+
+private:
+	LLMappedFile mFile;
+	LLUUID mCacheID;
+};
+
 class LLVOCacheEntry 
 :	public LLViewerOctreeEntryData
 {
@@ -107,6 +166,7 @@ protected:
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
 	LLVOCacheEntry(LLAPRFile* apr_file);
+	LLVOCacheEntry(const LLVOCacheRegionFile::Record& record, LLVOCacheRegionFile* file);
 	LLVOCacheEntry();	
 
 	void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -129,7 +189,14 @@ public:
 	F32 getSceneContribution() const             { return mSceneContrib;}
 
 	void dump() const;
-	S32 writeToBuffer(U8 *data_buffer) const;
+	// body for writing out, NULL if there isn't one
+	const U8* getBody(S32& size) const;
+	// true if the body hasn't changed since file was read
+	bool isInCacheFile(const LLVOCacheRegionFile* file) const { return file && mFile == file; }
+	U32 getCacheFileOffset() const { return mFileOffset; }
+	// take a copy of the body and let go of the file
+	void detachFromCacheFile();
+	void fillRecord(LLVOCacheRegionFile::Record& record, U32 offset, S32 size) const;
 	LLDataPackerBinaryBuffer *getDP();
 	void recordHit();
 	void recordDupe() { mDupeCount++; }
@@ -169,6 +236,8 @@ public:
 
     typedef std::unordered_map<U32, LLGLTFOverrideCacheEntry>  vocache_gltf_overrides_map_t;
 
+	const vocache_entry_set_t& getChildren() const {return mChildrenList;}
+
 	S32                         mLastCameraUpdated;
 protected:
 	U32							mLocalID;
@@ -180,6 +249,9 @@ protected:
 	S32							mCRCChangeCount;
 	LLDataPackerBinaryBuffer	mDP;
 	U8							*mBuffer;
+	LLPointer<LLVOCacheRegionFile> mFile; //file the body is in while it's unchanged
+	U32							mFileOffset;
+	S32							mFileSize;
 
 	F32                         mSceneContrib; //projected scene contributuion of this object.
 	U32                         mState; //high 16 bits reserved for special use.
@@ -219,6 +291,9 @@ public:
 	bool addEntry(LLViewerOctreeEntry* entry);
 	void removeEntry(LLViewerOctreeEntry* entry);
 	/*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion);
+	bool prepareCull(); // rebound the root group on the main thread before traverseCull, false if there is nothing to cull
+	S32 traverseCull(LLCamera &camera, bool use_occlusion); // changes camera's region planes, safe to call off the main thread without use_occlusion
+	void finishCull(); // main thread, after traverseCull returned 1
 	void addOccluders(LLViewerOctreeGroup* gp);
 	void resetOccluders();
 	void processOccluders(LLCamera* camera);
@@ -283,6 +358,7 @@ private:
 	};
 	typedef std::set<HeaderEntryInfo*, header_entry_less> header_entry_queue_t;
 	typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
+	typedef std::map<U64, LLPointer<LLVOCacheRegionFile> > region_file_map_t;
 
 public:
 	// We need this init to be separate from constructor, since we might construct cache, purge it, then init.
@@ -290,6 +366,9 @@ public:
 	void removeCache(ELLPath location, bool started = false) ;
 
 	void readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
+	// Maps the cache file of a region the agent is about to arrive in, and
+	// has the OS start reading it in, so readFromCache() finds it in memory.
+	void prefetchRegion(U64 handle);
     void readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map);
 
 	void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache, bool removal_enabled);
@@ -299,6 +378,10 @@ public:
 	U32 getCacheEntries() { return mNumEntries; }
 	U32 getCacheEntriesMax() { return mCacheSize; }
 
+	// Main thread, once per frame: hands the cache header to the writer if
+	// any region changed it since the last call.
+	void flushCacheHeader();
+
 private:
 	void setDirNames(ELLPath location);	
 	// determine the cache filename for the region from the region handle	
@@ -311,7 +394,33 @@ private:
 	void removeCache() ;
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
-	BOOL updateEntry(const HeaderEntryInfo* entry);
+	void buildCacheHeader(std::vector<U8>& data);
+
+	// Everything the writer thread needs to put a region's cache file on
+	// disk, copied out of the region's entries on the main thread.
+	struct RegionFileWrite
+	{
+		std::string mFilename;
+		bool mAppend;		//add to the end of the existing file, otherwise replace it
+		U32 mBodyOffset;	//where mBodies goes in the file
+		LLVOCacheRegionFile::Header mHeader;
+		std::vector<U8> mBodies;	//bodies not already in the file, padded to align the table
+		std::vector<LLVOCacheRegionFile::Record> mRecords;
+	};
+
+	// Writer thread.  Writes go through a temporary file where a crash part
+	// way would leave a broken file, appends write the header last instead.
+	static bool writeRegionFile(const RegionFileWrite& write);
+	static void writeExtrasFile(U64 handle, const std::string& filename, const LLUUID& id, const std::vector<LLSD>& entries);
+	static bool writeHeaderFile(const std::string& filename, const std::vector<U8>& data);
+
+	// Runs write on the writer thread, or right here if it's shut down.
+	// Reads and removals of a region's files wait for its writes first.
+	void postWrite(U64 handle, const std::function<void()>& write);
+	void finishWrite(U64 handle);
+	bool hasPendingWrites(U64 handle);
+	void waitForWrites(U64 handle);
+	void waitForAllWrites();
 	
 private:
 	bool                 mEnabled;
@@ -325,6 +434,14 @@ private:
 	LLVolatileAPRPool*   mLocalAPRFilePoolp ; 	
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
+	region_file_map_t    mRegionFiles; //mapped files of the regions read from cache, until they're written back
+	LLPointer<LLVOCacheRegionFile> mPrefetchedFile; //from prefetchRegion(), until it's read or replaced
+	U64                  mPrefetchedHandle;
+	bool                 mHeaderDirty; //the header file is behind mHeaderEntryQueue
+	LL::ThreadPool*      mWriterThread;
+	std::mutex           mPendingMutex;
+	std::condition_variable mPendingCond;
+	std::map<U64, S32>   mPendingWrites; //writes posted and not yet done, by region handle
 };
 
 #endif
@@ -113,24 +113,13 @@ void LLVOGrass::initClass()
 	
 	std::string xml_filename = gDirUtilp->getExpandedFilename(LL_PATH_APP_SETTINGS,"grass.xml");
 	
-	LLXmlTree grass_def_grass;
-
-	if (!grass_def_grass.parseFile(xml_filename))
-	{
-		LL_ERRS() << "Failed to parse grass file." << LL_ENDL;
-		return;
-	}
-
-	LLXmlTreeNode* rootp = grass_def_grass.getRoot();
-
-	for (LLXmlTreeNode* grass_def = rootp->getFirstChild();
-		grass_def;
-		grass_def = rootp->getNextChild())
+	// Each definition is read as soon as it is parsed, the tree is never built
+	auto parse_grass = [](LLXmlTreeNode* rootp, LLXmlTreeNode* grass_def) -> bool
 	{
 		if (!grass_def->hasName("grass"))
 		{
 			LL_WARNS() << "Invalid grass definition node " << grass_def->getName() << LL_ENDL;
-			continue;
+			return true;
 		}
 		F32 F32_val;
 		LLUUID id;
@@ -142,13 +131,13 @@ void LLVOGrass::initClass()
 		if (!grass_def->getFastAttributeS32(species_id_string, species))
 		{
 			LL_WARNS() << "No species id defined" << LL_ENDL;
-			continue;
+			return true;
 		}
 
 		if (species < 0)
 		{
 			LL_WARNS() << "Invalid species id " << species << LL_ENDL;
-			continue;
+			return true;
 		}
 
 		GrassSpeciesData* newGrass = new GrassSpeciesData();
@@ -170,7 +159,7 @@ void LLVOGrass::initClass()
 		{
 			LL_INFOS() << "Grass species " << species << " already defined! Duplicate discarded." << LL_ENDL;
 			delete newGrass;
-			continue;
+			return true;
 		}
 		else
 		{
@@ -186,6 +175,16 @@ void LLVOGrass::initClass()
 			grass_def->getFastAttributeString(name_string, name);
 			LL_WARNS() << "Incomplete definition of grass " << name << LL_ENDL;
 		}
+
+		return true;
+	};
+
+	LLXmlTree grass_def_grass;
+
+	if (!grass_def_grass.parseFile(xml_filename, parse_grass))
+	{
+		LL_ERRS() << "Failed to parse grass file." << LL_ENDL;
+		return;
 	}
 
 	BOOL have_all_grass = TRUE;
@@ -384,6 +384,8 @@ LLVivoxVoiceClient::LLVivoxVoiceClient() :
 
 LLVivoxVoiceClient::~LLVivoxVoiceClient()
 {
+	gIdleCallbacks.deleteFunction(idle, this);
+
 	if (mAvatarNameCacheConnection.connected())
 	{
 		mAvatarNameCacheConnection.disconnect();
@@ -660,6 +662,8 @@ void LLVivoxVoiceClient::setLoginInfo(
 
 void LLVivoxVoiceClient::idle(void* user_data)
 {
+	LLVivoxVoiceClient* self = static_cast<LLVivoxVoiceClient*>(user_data);
+	self->applyParticipantUpdates();
 }
 
 //=========================================================================
@@ -4308,6 +4312,7 @@ void LLVivoxVoiceClient::participantRemovedEvent(
         participantStatePtr_t participant(session->findParticipant(uriString));
 		if(participant)
 		{
+			mPendingParticipantUpdates.erase(std::make_pair(sessionHandle, uriString));
 			session->removeParticipant(participant);
 		}
 		else
@@ -4333,78 +4338,107 @@ void LLVivoxVoiceClient::participantUpdatedEvent(
 		int volume, 
 		F32 energy)
 {
-    sessionStatePtr_t session(findSession(sessionHandle));
-	if(session)
+	// only the latest update for each participant matters, they are applied
+	// together from idle()
+	participantUpdate& update = mPendingParticipantUpdates[std::make_pair(sessionHandle, uriString)];
+	update.mIsModeratorMuted = isModeratorMuted;
+	update.mIsSpeaking = isSpeaking;
+	update.mVolume = volume;
+	update.mEnergy = energy;
+}
+
+void LLVivoxVoiceClient::applyParticipantUpdates()
+{
+	if (mPendingParticipantUpdates.empty())
 	{
-		participantStatePtr_t participant(session->findParticipant(uriString));
-		
-		if(participant)
-		{
-            //LL_INFOS("Voice") << "Participant Update for " << participant->mDisplayName << LL_ENDL;
+		return;
+	}
 
-			participant->mIsSpeaking = isSpeaking;
-			participant->mIsModeratorMuted = isModeratorMuted;
+	bool updated = false;
+	bool agent_updated = false;
+	for (participantUpdateMap::value_type& pending : mPendingParticipantUpdates)
+	{
+		const std::string& sessionHandle = pending.first.first;
+		const std::string& uriString = pending.first.second;
+		const participantUpdate& update = pending.second;
 
-			// SLIM SDK: convert range: ensure that energy is set to zero if is_speaking is false
-			if (isSpeaking)
-			{
-				participant->mSpeakingTimeout.reset();
-				participant->mPower = energy;
-			}
-			else
-			{
-				participant->mPower = 0.0f;
-			}
+		sessionStatePtr_t session(findSession(sessionHandle));
+		if (!session)
+		{
+			LL_DEBUGS("Voice") << "unknown session " << sessionHandle << LL_ENDL;
+			continue;
+		}
 
-			// Ignore incoming volume level if it has been explicitly set, or there
-			//  is a volume or mute change pending.
-			if ( !participant->mVolumeSet && !participant->mVolumeDirty)
-			{
-				participant->mVolume = (F32)volume * VOLUME_SCALE_VIVOX;
-			}
-			
-			// *HACK: mantipov: added while working on EXT-3544                                                                                   
-			/*                                                                                                                                    
-			 Sometimes LLVoiceClient::participantUpdatedEvent callback is called BEFORE                                                            
-			 LLViewerChatterBoxSessionAgentListUpdates::post() sometimes AFTER.                                                                    
-			 
-			 participantUpdatedEvent updates voice participant state in particular participantState::mIsModeratorMuted                             
-			 Originally we wanted to update session Speaker Manager to fire LLSpeakerVoiceModerationEvent to fix the EXT-3544 bug.                 
-			 Calling of the LLSpeakerMgr::update() method was added into LLIMMgr::processAgentListUpdates.                                         
-			 
-			 But in case participantUpdatedEvent() is called after LLViewerChatterBoxSessionAgentListUpdates::post()                               
-			 voice participant mIsModeratorMuted is changed after speakers are updated in Speaker Manager                                          
-			 and event is not fired.                                                                                                               
-			 
-			 So, we have to call LLSpeakerMgr::update() here. 
-			 */
-			LLVoiceChannel* voice_cnl = LLVoiceChannel::getCurrentVoiceChannel();
-			
-			// ignore session ID of local chat                                                                                                    
-			if (voice_cnl && voice_cnl->getSessionID().notNull())
-			{
-				LLSpeakerMgr* speaker_manager = LLIMModel::getInstance()->getSpeakerManager(voice_cnl->getSessionID());
-				if (speaker_manager)
-				{
-					speaker_manager->update(true);
+		participantStatePtr_t participant(session->findParticipant(uriString));
+		if (!participant)
+		{
+			LL_WARNS("Voice") << "unknown participant: " << uriString << LL_ENDL;
+			continue;
+		}
 
-					// also initialize voice moderate_mode depend on Agent's participant. See EXT-6937.
-					// *TODO: remove once a way to request the current voice channel moderation mode is implemented.
-					if (gAgent.getID() == participant->mAvatarID)
-					{
-						speaker_manager->initVoiceModerateMode();
-					}
-				}
-			}
+		participant->mIsSpeaking = update.mIsSpeaking;
+		participant->mIsModeratorMuted = update.mIsModeratorMuted;
+
+		// SLIM SDK: convert range: ensure that energy is set to zero if is_speaking is false
+		if (update.mIsSpeaking)
+		{
+			participant->mSpeakingTimeout.reset();
+			participant->mPower = update.mEnergy;
 		}
 		else
 		{
-			LL_WARNS("Voice") << "unknown participant: " << uriString << LL_ENDL;
+			participant->mPower = 0.0f;
 		}
+
+		// Ignore incoming volume level if it has been explicitly set, or there
+		//  is a volume or mute change pending.
+		if ( !participant->mVolumeSet && !participant->mVolumeDirty)
+		{
+			participant->mVolume = (F32)update.mVolume * VOLUME_SCALE_VIVOX;
+		}
+
+		updated = true;
+		agent_updated = agent_updated || gAgent.getID() == participant->mAvatarID;
 	}
-	else
+	mPendingParticipantUpdates.clear();
+
+	if (!updated)
 	{
-		LL_DEBUGS("Voice") << "unknown session " << sessionHandle << LL_ENDL;
+		return;
+	}
+
+	// *HACK: mantipov: added while working on EXT-3544
+	/*
+	 Sometimes LLVoiceClient::participantUpdatedEvent callback is called BEFORE
+	 LLViewerChatterBoxSessionAgentListUpdates::post() sometimes AFTER.
+
+	 participantUpdatedEvent updates voice participant state in particular participantState::mIsModeratorMuted
+	 Originally we wanted to update session Speaker Manager to fire LLSpeakerVoiceModerationEvent to fix the EXT-3544 bug.
+	 Calling of the LLSpeakerMgr::update() method was added into LLIMMgr::processAgentListUpdates.
+
+	 But in case participantUpdatedEvent() is called after LLViewerChatterBoxSessionAgentListUpdates::post()
+	 voice participant mIsModeratorMuted is changed after speakers are updated in Speaker Manager
+	 and event is not fired.
+
+	 So, we have to call LLSpeakerMgr::update() here, once for all the updates of the frame.
+	 */
+	LLVoiceChannel* voice_cnl = LLVoiceChannel::getCurrentVoiceChannel();
+
+	// ignore session ID of local chat
+	if (voice_cnl && voice_cnl->getSessionID().notNull())
+	{
+		LLSpeakerMgr* speaker_manager = LLIMModel::getInstance()->getSpeakerManager(voice_cnl->getSessionID());
+		if (speaker_manager)
+		{
+			speaker_manager->update(true);
+
+			// also initialize voice moderate_mode depend on Agent's participant. See EXT-6937.
+			// *TODO: remove once a way to request the current voice channel moderation mode is implemented.
+			if (agent_updated)
+			{
+				speaker_manager->initVoiceModerateMode();
+			}
+		}
 	}
 }
 
@@ -463,6 +463,8 @@ protected:
 	void participantAddedEvent(std::string &sessionHandle, std::string &sessionGroupHandle, std::string &uriString, std::string &alias, std::string &nameString, std::string &displayNameString, int participantType);
 	void participantRemovedEvent(std::string &sessionHandle, std::string &sessionGroupHandle, std::string &uriString, std::string &alias, std::string &nameString);
 	void participantUpdatedEvent(std::string &sessionHandle, std::string &sessionGroupHandle, std::string &uriString, std::string &alias, bool isModeratorMuted, bool isSpeaking, int volume, F32 energy);
+	// apply the participant updates queued since the last frame
+	void applyParticipantUpdates();
 	void voiceServiceConnectionStateChangedEvent(int statusCode, std::string &statusString, std::string &build_id);
 	void auxAudioPropertiesEvent(F32 energy);
 	void messageEvent(std::string &sessionHandle, std::string &uriString, std::string &alias, std::string &messageHeader, std::string &messageBody, std::string &applicationString);
@@ -712,6 +714,20 @@ private:
 	int mLoginRetryCount;
 	
 	sessionMap mSessionsByHandle;				// Active sessions, indexed by session handle.  Sessions which are being initiated may not be in this map.
+
+	// Busy sessions send a stream of ParticipantUpdatedEvents.  They are kept
+	// here, the latest one per participant, and applied once a frame from
+	// idle() so the speaker list is updated once instead of once per event.
+	struct participantUpdate
+	{
+		bool mIsModeratorMuted;
+		bool mIsSpeaking;
+		int mVolume;
+		F32 mEnergy;
+	};
+	// by session handle and participant URI
+	typedef std::map<std::pair<std::string, std::string>, participantUpdate> participantUpdateMap;
+	participantUpdateMap mPendingParticipantUpdates;
 #if 0
 	sessionSet mSessions;						// All sessions, not indexed.  This is the canonical session list.
 #endif
@@ -116,6 +116,10 @@ void LLVOPartGroup::restoreGL()
 //static
 void LLVOPartGroup::destroyGL()
 {
+	if (LLViewerPartSim::instanceExists())
+	{
+		LLViewerPartSim::getInstance()->getGPUParticles().cleanup();
+	}
 }
 
 bool ll_is_part_idx_allocated(S32 idx, S32* start, S32* end)
@@ -643,6 +643,64 @@ void LLVOSky::createSkyTexture(const LLSettingsSky::ptr_t &psky, AtmosphericsVar
 	}
 }
 
+bool LLVOSky::loadCachedSky(const AtmosphericsVars& vars, bool low_end)
+{
+    for (std::list<CachedSky>::iterator iter = mSkyCache.begin(); iter != mSkyCache.end(); ++iter)
+    {
+        if (iter->mLowEnd != low_end || !approximatelyEqual(iter->mVars, vars, UPDATE_MIN_DELTA_THRESHOLD))
+        {
+            continue;
+        }
+
+        const U32 face_pixels = (U32)(SKYTEX_RESOLUTION * SKYTEX_RESOLUTION);
+        const LLColor4* src = iter->mSkyData.data();
+        for (S32 side = 0; side < NUM_CUBEMAP_FACES; ++side)
+        {
+            memcpy(mSkyTex[side].mSkyData, src + side * face_pixels, face_pixels * sizeof(LLColor4));
+            memcpy(mShinyTex[side].mSkyData, src + (NUM_CUBEMAP_FACES + side) * face_pixels, face_pixels * sizeof(LLColor4));
+        }
+        mSkyCache.splice(mSkyCache.begin(), mSkyCache, iter);
+        return true;
+    }
+    return false;
+}
+
+void LLVOSky::storeCachedSky(const AtmosphericsVars& vars, bool low_end)
+{
+    static LLCachedControl<U32> cache_size(gSavedSettings, "RenderSkyCacheSize", 0);
+    if (!cache_size)
+    {
+        mSkyCache.clear();
+        return;
+    }
+
+    if (!mSkyCache.empty() && mSkyCache.front().mLowEnd == low_end
+        && approximatelyEqual(mSkyCache.front().mVars, vars, UPDATE_MIN_DELTA_THRESHOLD))
+    {
+        // came from the cache
+        return;
+    }
+
+    while (mSkyCache.size() >= cache_size)
+    {
+        mSkyCache.pop_back();
+    }
+
+    mSkyCache.push_front(CachedSky());
+    CachedSky& entry = mSkyCache.front();
+    entry.mVars = vars;
+    entry.mLowEnd = low_end;
+
+    const U32 face_pixels = (U32)(SKYTEX_RESOLUTION * SKYTEX_RESOLUTION);
+    entry.mSkyData.resize(2 * NUM_CUBEMAP_FACES * face_pixels);
+    LLColor4* dst = entry.mSkyData.data();
+    for (S32 side = 0; side < NUM_CUBEMAP_FACES; ++side)
+    {
+        memcpy(dst + side * face_pixels, mSkyTex[side].mSkyData, face_pixels * sizeof(LLColor4));
+        memcpy(dst + (NUM_CUBEMAP_FACES + side) * face_pixels, mShinyTex[side].mSkyData, face_pixels * sizeof(LLColor4));
+    }
+}
+
 void LLVOSky::updateDirections(LLSettingsSky::ptr_t psky)
 {
     mSun.setDirection(psky->getSunDirection());
@@ -709,9 +767,10 @@ bool LLVOSky::updateSky()
 
         if (mNeedUpdate && (mForceUpdateThrottle.hasExpired() || mForceUpdate))
 		{
-            // start updating cube map sides
+            // start updating cube map sides, or go straight to finishing
+            // with faces computed earlier for the same atmospherics
             updateFog(LLViewerCamera::getInstance()->getFar());
-            mCubeMapUpdateStage = 0;
+            mCubeMapUpdateStage = loadCachedSky(m_atmosphericsVars, !gPipeline.canUseWindLightShaders()) ? NUM_CUBEMAP_FACES : 0;
             mForceUpdate = FALSE;
 		}
 	}
@@ -722,6 +781,8 @@ bool LLVOSky::updateSky()
 
         bool is_alm_wl_sky = gPipeline.canUseWindLightShaders();
 
+        storeCachedSky(m_atmosphericsVars, !is_alm_wl_sky);
+
         int tex = mSkyTex[0].getWhich(TRUE);
 
         for (int side = 0; side < NUM_CUBEMAP_FACES; side++)
@@ -38,6 +38,8 @@
 #include "llsettingssky.h"
 #include "lllegacyatmospherics.h"
 
+#include <list>
+
 const F32 SKY_BOX_MULT			= 16.0f;
 const F32 HEAVENLY_BODY_DIST	= HORIZON_DIST - 20.f;
 const F32 HEAVENLY_BODY_FACTOR	= 0.1f;
@@ -303,6 +305,11 @@ protected:
 	void initSkyTextureDirs(const S32 side, const S32 tile);
 	void createSkyTexture(const LLSettingsSky::ptr_t &psky, AtmosphericsVars& vars, const S32 side, const S32 tile);
 
+	// Sky faces already computed for atmospherics close enough to vars.
+	// Copies them into mSkyTex and mShinyTex if found.
+	bool loadCachedSky(const AtmosphericsVars& vars, bool low_end);
+	void storeCachedSky(const AtmosphericsVars& vars, bool low_end);
+
 	LLPointer<LLViewerFetchedTexture> mSunTexturep[2];
 	LLPointer<LLViewerFetchedTexture> mMoonTexturep[2];
     LLPointer<LLViewerFetchedTexture> mCloudNoiseTexturep[2];
@@ -355,6 +362,17 @@ protected:
     AtmosphericsVars    m_atmosphericsVars;
     AtmosphericsVars    m_lastAtmosphericsVars;
     LLAtmospherics      m_legacyAtmospherics;
+
+    // Recently computed sky faces (RenderSkyCacheSize), most recently used
+    // first, so flying back and forth between parcel environments or
+    // looping a day cycle does not recompute them.
+    struct CachedSky
+    {
+        AtmosphericsVars        mVars;
+        bool                    mLowEnd;
+        std::vector<LLColor4>   mSkyData;   // every mSkyTex face, then every mShinyTex face
+    };
+    std::list<CachedSky>    mSkyCache;
 };
 
 #endif
@@ -183,9 +183,21 @@ BOOL LLVOSurfacePatch::updateGeometry(LLDrawable *drawable)
 	render_stride = mPatchp->getRenderStride();
 	patch_width = mPatchp->getSurface()->getGridsPerPatchEdge();
 
+	if (LLDrawPoolTerrain::sHeightField)
+	{
+		// LLDrawPoolTerrain draws the patch from the height field; the face
+		// only keeps a coarse stand-in, so LOD changes never rebuild it.
+		render_stride = llmax(patch_width / 2, (U32)1);
+	}
+
 	length = patch_width / render_stride;
 
-	if (mPatchp->getNeighborPatch(NORTH))
+	if (LLDrawPoolTerrain::sHeightField)
+	{
+		north_stride = render_stride;
+		east_stride = render_stride;
+	}
+	else if (mPatchp->getNeighborPatch(NORTH))
 	{
 		north_stride = mPatchp->getNeighborPatch(NORTH)->getRenderStride();
 	}
@@ -54,6 +54,7 @@
 #include "llnotificationsutil.h"
 #include "raytrace.h"
 #include "llglslshader.h"
+#include "llviewershadermgr.h"
 
 extern LLPipeline gPipeline;
 
@@ -76,6 +77,7 @@ F32 LLVOTree::sLODAngles[sMAX_NUM_TREE_LOD_LEVELS] = {30.f, 20.f, 15.f, F_ALMOST
 F32 LLVOTree::sTreeFactor = 1.f;
 
 LLVOTree::SpeciesMap LLVOTree::sSpeciesTable;
+LLVOTree::InstanceMeshMap LLVOTree::sInstanceMeshes;
 S32 LLVOTree::sMaxTreeSpecies = 0;
 
 // Tree variables and functions
@@ -87,6 +89,7 @@ LLVOTree::LLVOTree(const LLUUID &id, const LLPCode pcode, LLViewerRegion *region
 	mFrameCount = 0;
 	mWind = mRegionp->mWind.getVelocity(getPositionRegion());
 	mTrunkLOD = 0;
+	mInstanced = false;
 
 	// if assert triggers, idleUpdate() needs to be revised and adjusted to new LOD levels
 	llassert(sMAX_NUM_TREE_LOD_LEVELS == LLVolumeLODGroup::NUM_LODS);
@@ -275,6 +278,13 @@ void LLVOTree::cleanupClass()
 {
 	std::for_each(sSpeciesTable.begin(), sSpeciesTable.end(), DeletePairedPointer());
 	sSpeciesTable.clear();
+	sInstanceMeshes.clear();
+}
+
+//static
+void LLVOTree::destroyGL()
+{
+	sInstanceMeshes.clear();
 }
 
 U32 LLVOTree::processUpdateMessage(LLMessageSystem *mesgsys,
@@ -382,6 +392,10 @@ void LLVOTree::idleUpdate(LLAgent &agent, const F64 &time)
 	{
 		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_ALL);
 	}
+	else if (mInstanced != (LLViewerShaderMgr::sMaxTreeInstances > 0))
+	{ // instancing was toggled or its shaders failed to load
+		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_ALL);
+	}
 	else
 	{
 		// we're not animating but we may *still* need to
@@ -910,6 +924,58 @@ void LLVOTree::updateMesh()
 
 	scale_mat *= rot_mat;
 
+	LLFace* facep = mDrawable->getFace(0);
+	if (!facep) return;
+
+	mInstanced = LLViewerShaderMgr::sMaxTreeInstances > 0;
+	if (mInstanced)
+	{
+		LLVertexBuffer* mesh = getInstanceMesh();
+		if (mesh)
+		{ // moving the tree only changes the transform
+			mInstanceTransform = scale_mat;
+			facep->setVertexBuffer(mesh);
+			return;
+		}
+		mInstanced = false;
+	}
+
+	LLPointer<LLVertexBuffer> buff = genMesh(scale_mat);
+	if (buff.isNull())
+	{
+		buff = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK);
+		buff->allocateBuffer(1, 3);
+		memset((U8*)buff->getMappedData(), 0, buff->getSize());
+		memset((U8*)buff->getMappedIndices(), 0, buff->getIndicesSize());
+		buff->unmapBuffer();
+		facep->setSize(1, 3);
+	}
+	facep->setVertexBuffer(buff);
+}
+
+LLVertexBuffer* LLVOTree::getInstanceMesh()
+{
+	U32 key = (U32)mSpecies * sMAX_NUM_TREE_LOD_LEVELS + mTrunkLOD;
+	InstanceMeshMap::iterator iter = sInstanceMeshes.find(key);
+	if (iter != sInstanceMeshes.end())
+	{
+		return iter->second;
+	}
+
+	// every tree of a species has the same shape, only placed differently
+	LLMatrix4 identity;
+	LLPointer<LLVertexBuffer> mesh = genMesh(identity);
+	if (mesh.isNull())
+	{ // try again with the next tree
+		return NULL;
+	}
+
+	sInstanceMeshes[key] = mesh;
+	return mesh;
+}
+
+LLPointer<LLVertexBuffer> LLVOTree::genMesh(LLMatrix4& matrix)
+{
 //	const F32 THRESH_ANGLE_FOR_BILLBOARD = 15.f;
 //	const F32 BLEND_RANGE_FOR_BILLBOARD = 3.f;
 
@@ -923,26 +989,16 @@ void LLVOTree::updateMesh()
 	
 	calcNumVerts(vert_count, index_count, mTrunkLOD, stop_depth, mDepth, mTrunkDepth, mBranches);
 
-	LLFace* facep = mDrawable->getFace(0);
-	if (!facep) return;
-	LLVertexBuffer* buff = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK);
+	LLPointer<LLVertexBuffer> buff = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK);
 	if (!buff->allocateBuffer(vert_count, index_count))
 	{
 		LL_WARNS() << "Failed to allocate Vertex Buffer on mesh update to "
 			<< vert_count << " vertices and "
 			<< index_count << " indices" << LL_ENDL;
-		buff->allocateBuffer(1, 3);
-		memset((U8*)buff->getMappedData(), 0, buff->getSize());
-		memset((U8*)buff->getMappedIndices(), 0, buff->getIndicesSize());
-		facep->setSize(1, 3);
-		facep->setVertexBuffer(buff);
 		mReferenceBuffer->unmapBuffer();
-		buff->unmapBuffer();
-		return;
+		return NULL;
 	}
 
-	facep->setVertexBuffer(buff);
-	
 	LLStrider<LLVector3> vertices;
 	LLStrider<LLVector3> normals;
 	LLStrider<LLVector2> tex_coords;
@@ -956,10 +1012,11 @@ void LLVOTree::updateMesh()
     buff->getColorStrider(colors);
 	buff->getIndexStrider(indices);
 
-	genBranchPipeline(vertices, normals, tex_coords, colors, indices, idx_offset, scale_mat, mTrunkLOD, stop_depth, mDepth, mTrunkDepth, 1.0, mTwist, droop, mBranches, alpha);
+	genBranchPipeline(vertices, normals, tex_coords, colors, indices, idx_offset, matrix, mTrunkLOD, stop_depth, mDepth, mTrunkDepth, 1.0, mTwist, droop, mBranches, alpha);
 	
 	mReferenceBuffer->unmapBuffer();
 	buff->unmapBuffer();
+	return buff;
 }
 
 void LLVOTree::appendMesh(LLStrider<LLVector3>& vertices, 
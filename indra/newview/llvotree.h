@@ -53,6 +53,8 @@ public:
 	static void initClass();
 	static void cleanupClass();
 	static bool isTreeRenderingStopped();
+	// free the meshes shared by instanced trees
+	static void destroyGL();
 
 	/*virtual*/ U32 processUpdateMessage(LLMessageSystem *mesgsys,
 											void **user_data,
@@ -77,6 +79,13 @@ public:
 
 	void updateMesh();
 
+	// With the instanced tree shaders loaded (see RenderTreeInstancing) a
+	// tree's face holds the mesh all trees of its species and trunk LOD
+	// share, and LLDrawPoolTree places it with the instance transform
+	// instead of the tree having its own copy with the transform baked in.
+	bool isInstanced() const { return mInstanced; }
+	const LLMatrix4& getInstanceTransform() const { return mInstanceTransform; }
+
 	void appendMesh(LLStrider<LLVector3>& vertices, 
 						 LLStrider<LLVector3>& normals, 
 						 LLStrider<LLVector2>& tex_coords,
@@ -182,9 +191,22 @@ protected:
 
 	U32 mFrameCount;
 
+	bool mInstanced;
+	LLMatrix4 mInstanceTransform;
+
+	// generate the mesh for this tree's species and trunk LOD transformed by matrix,
+	// NULL if it couldn't be allocated
+	LLPointer<LLVertexBuffer> genMesh(LLMatrix4& matrix);
+	// the shared mesh for this tree's species and trunk LOD, NULL if it couldn't be made
+	LLVertexBuffer* getInstanceMesh();
+
 	typedef std::map<U32, TreeSpeciesData*> SpeciesMap;
 	static SpeciesMap sSpeciesTable;
 
+	// keyed by species * sMAX_NUM_TREE_LOD_LEVELS + trunk LOD
+	typedef std::map<U32, LLPointer<LLVertexBuffer> > InstanceMeshMap;
+	static InstanceMeshMap sInstanceMeshes;
+
 	static S32 sLODIndexOffset[4];
 	static S32 sLODIndexCount[4];
 	static S32 sLODVertexOffset[4];
@@ -31,6 +31,7 @@
 #include "llvovolume.h"
 
 #include <sstream>
+#include <atomic>
 
 #include "llviewercontrol.h"
 #include "lldir.h"
@@ -47,6 +48,7 @@
 #include "message.h"
 #include "llpluginclassmedia.h" // for code in the mediaEvent handler
 #include "object_flags.h"
+#include "llavatarrenderbenchmark.h"
 #include "lldrawable.h"
 #include "lldrawpoolavatar.h"
 #include "lldrawpoolbump.h"
@@ -89,6 +91,9 @@
 #include "llsculptidsize.h"
 #include "llavatarappearancedefines.h"
 #include "llgltfmateriallist.h"
+#include "llviewerstats.h"
+
+#include <boost/functional/hash.hpp>
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
@@ -1178,12 +1183,12 @@ void LLVOVolume::updateVisualComplexity()
     LLVOAvatar* avatar = getAvatarAncestor();
     if (avatar)
     {
-        avatar->updateVisualComplexity();
+        avatar->updateVisualComplexity(this);
     }
     LLVOAvatar* rigged_avatar = getAvatar();
     if(rigged_avatar && (rigged_avatar != avatar))
     {
-        rigged_avatar->updateVisualComplexity();
+        rigged_avatar->updateVisualComplexity(this);
     }
 }
 
@@ -1323,7 +1328,44 @@ void LLVOVolume::sculpt()
 				mSculptTexture->updateBindStatsForTester() ;
 			}
 		}
-		getVolume()->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level, mSculptTexture->isMissingAsset());
+		bool visible_placeholder = mSculptTexture->isMissingAsset();
+
+		// Shared sculpts are regenerated on the volume build queue from a copy
+		// of the map, the objects using them keep their current shape until
+		// onSculptGenerated().  Flexible ones are unique and rewritten every
+		// frame, those stay here.
+		LLVolume* volumep = getVolume();
+		LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+		if (!volumep->isUnique())
+		{
+			if (volume_mgr->isSculptPending(volumep))
+			{ // sculpt() runs again when that one lands and picks up any newer map
+				return;
+			}
+
+			std::vector<U8> data;
+			if (sculpt_data)
+			{
+				data.assign(sculpt_data, sculpt_data + raw_image->getDataSize());
+			}
+			LLUUID sculpt_id = mSculptTexture->getID();
+			bool queued = volume_mgr->queueSculpt(volumep,
+				[data, sculpt_width, sculpt_height, sculpt_components, discard_level, visible_placeholder](LLVolume* sculpted)
+				{
+					sculpted->sculpt(sculpt_width, sculpt_height, sculpt_components, data.empty() ? NULL : data.data(),
+									 discard_level, visible_placeholder);
+				},
+				[sculpt_id](LLVolume* sculpted)
+				{
+					onSculptGenerated(sculpt_id, sculpted);
+				});
+			if (queued)
+			{
+				return;
+			}
+		}
+
+		volumep->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level, visible_placeholder);
 
 		//notify rebuild any other VOVolumes that reference this sculpty volume
 		for (S32 i = 0; i < mSculptTexture->getNumVolumes(LLRender::SCULPT_TEX); ++i)
@@ -1337,6 +1379,26 @@ void LLVOVolume::sculpt()
 	}
 }
 
+// static
+void LLVOVolume::onSculptGenerated(const LLUUID& sculpt_id, LLVolume* volumep)
+{
+	LLViewerFetchedTexture* sculpt_texture = LLViewerTextureManager::findFetchedTexture(sculpt_id, TEX_LIST_STANDARD);
+	if (!sculpt_texture)
+	{ // nothing shows it any more
+		return;
+	}
+
+	for (S32 i = 0; i < sculpt_texture->getNumVolumes(LLRender::SCULPT_TEX); ++i)
+	{
+		LLVOVolume* volume = (*(sculpt_texture->getVolumeList(LLRender::SCULPT_TEX)))[i];
+		if (volume->getVolume() == volumep && volume->mDrawable.notNull())
+		{
+			volume->mSculptChanged = TRUE;
+			gPipeline.markRebuild(volume->mDrawable, LLDrawable::REBUILD_VOLUME);
+		}
+	}
+}
+
 S32	LLVOVolume::computeLODDetail(F32 distance, F32 radius, F32 lod_factor)
 {
 	S32	cur_detail;
@@ -1567,9 +1629,28 @@ BOOL LLVOVolume::updateLOD()
 		return FALSE;
 	}
 
+	LLVolume* volume = getVolume();
+	if (!lod_changed && !volume->isUnique() && !isSculpted() &&
+		volume->getDetail() != LLVolumeLODGroup::getVolumeScaleFromDetail(mLOD) &&
+		LLPrimitive::getVolumeManager()->isLODReady(volume->getParams(), mLOD))
+	{ // a stand in was drawn while this LOD was generated on the build queue
+		lod_changed = TRUE;
+	}
+
 	if (lod_changed)
 	{
-		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_VOLUME);
+		// Other avatars' attachments rebuild in per avatar batches within
+		// the frame's budget, see LLVOAvatar::processAttachmentLODRebuilds().
+		static LLCachedControl<U32> rebuild_budget(gSavedSettings, "RenderAttachmentLODRebuildsPerFrame", 0);
+		LLVOAvatar* avatar = (rebuild_budget && isAttachment() && !isHUDAttachment()) ? getAvatarAncestor() : NULL;
+		if (avatar && !avatar->isSelf())
+		{
+			avatar->queueAttachmentLODRebuild(mDrawable);
+		}
+		else
+		{
+			gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_VOLUME);
+		}
 		mLODChanged = TRUE;
 	}
 	else
@@ -2017,6 +2098,7 @@ bool LLVOVolume::lodOrSculptChanged(LLDrawable *drawable, BOOL &compiled, BOOL &
 BOOL LLVOVolume::updateGeometry(LLDrawable *drawable)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+    LLAvatarRenderBenchmark::ScopedPhase benchmark_phase(LLAvatarRenderBenchmark::PHASE_GEOMETRY, isAttachment());
 	
 	if (mDrawable->isState(LLDrawable::REBUILD_RIGGED))
 	{
@@ -4876,11 +4958,25 @@ void LLRiggedVolume::update(
 	//build matrix palette
 	static const size_t kMaxJoints = LL_MAX_JOINTS_PER_MESH_OBJECT;
 
-	LLMatrix4a mat[kMaxJoints];
-	U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
-    LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
+    // the avatar caches the palette for the frame and shares it with the
+    // draw pools, so this costs nothing extra for a mesh that's on screen
+    const LLVOAvatar::MatrixPaletteCache& mpc = avatar->updateSkinInfoMatrixPalette(skin);
+    const LLMatrix4a* mat = mpc.mMatrixPalette.data();
+    U32 maxJoints = (U32)mpc.mMatrixPalette.size();
     const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
 
+    LLMatrix4a bound_mat[kMaxJoints];
+    U32 bound_count = 1;
+    if (maxJoints > 0)
+    {
+        LLSkinningUtil::initBindShapeMatrixPalette(bound_mat, mat, maxJoints, bind_shape_matrix);
+        bound_count = maxJoints;
+    }
+    else
+    {
+        bound_mat[0] = bind_shape_matrix;
+    }
+
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
     LLVector4a box_min, box_max;
@@ -4917,7 +5013,6 @@ void LLRiggedVolume::update(
 
 			if (pos && dst_face.mExtents)
 			{
-                U32 max_joints = LLSkinningUtil::getMaxJointCount();
                 rigged_vert_count += dst_face.mNumVertices;
                 rigged_face_count++;
 
@@ -4945,39 +5040,35 @@ void LLRiggedVolume::update(
                 else
             #endif
                 {
-				    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-				    {
-					    LLMatrix4a final_mat;
-                        LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
-				
-					    LLVector4a& v = vol_face.mPositions[j];
-					    LLVector4a t;
-					    LLVector4a dst;
-					    bind_shape_matrix.affineTransform(v, t);
-					    final_mat.affineTransform(t, dst);
-					    pos[j] = dst;
-				    }
+                    // also updates the bounding box
+                    // VFExtents change
+                    LLSkinningUtil::skinPositions(bound_mat, bound_count, weight, vol_face.mPositions, dst_face.mNumVertices,
+                                                  pos, dst_face.mExtents[0], dst_face.mExtents[1]);
                 }
 
-				//update bounding box
-				// VFExtents change
 				LLVector4a& min = dst_face.mExtents[0];
 				LLVector4a& max = dst_face.mExtents[1];
 
-				min = pos[0];
-				max = pos[1];
+            #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
+                if (vol_face.mJointIndices)
+                {
+                    //update bounding box
+                    min = pos[0];
+                    max = pos[0];
+                    for (U32 j = 1; j < dst_face.mNumVertices; ++j)
+                    {
+                        min.setMin(min, pos[j]);
+                        max.setMax(max, pos[j]);
+                    }
+                }
+            #endif
+
                 if (i==0)
                 {
                     box_min = min;
                     box_max = max;
                 }
 
-				for (U32 j = 1; j < dst_face.mNumVertices; ++j)
-				{
-					min.setMin(min, pos[j]);
-					max.setMax(max, pos[j]);
-				}
-
                 box_min.setMin(min,box_min);
                 box_max.setMax(max,box_max);
 
@@ -4986,7 +5077,14 @@ void LLRiggedVolume::update(
 
 			}
 
-            if (rebuild_face_octrees)
+            if (LLVolumeFace::sUseBVH)
+            { // same triangles in new places, refit instead of rebuilding
+                if (rebuild_face_octrees || dst_face.getBVH())
+                {
+                    dst_face.refitBVH();
+                }
+            }
+            else if (rebuild_face_octrees)
 			{
                 dst_face.destroyOctree();
                 dst_face.createOctree();
@@ -5078,6 +5176,51 @@ void LLControlAVBridge::updateSpatialExtents()
 	}
 }
 
+// Hash of everything that goes into the vertex data of a rigged animesh
+// face, so that copies of the same object can share one instanced draw
+// (see LLRenderPass::pushInstancedRiggedBatches). 0 for other faces.
+static U64 rigged_face_geometry_hash(LLFace* facep)
+{
+	if (!facep->mAvatar || !facep->mAvatar->isControlAvatar())
+	{
+		return 0;
+	}
+	LLViewerObject* vobj = facep->getViewerObject();
+	const LLVolume* volume = vobj ? vobj->getVolume() : nullptr;
+	if (!volume)
+	{
+		return 0;
+	}
+
+	const LLTextureEntry* te = facep->getTextureEntry();
+	const LLVector3& scale = vobj->getScale();
+	size_t seed = 0;
+	boost::hash_combine(seed, volume);
+	boost::hash_combine(seed, facep->getTEOffset());
+	for (U32 i = 0; i < 4; ++i)
+	{
+		boost::hash_combine(seed, te->getColor().mV[i]);
+	}
+	boost::hash_combine(seed, te->getScaleS());
+	boost::hash_combine(seed, te->getScaleT());
+	boost::hash_combine(seed, te->getOffsetS());
+	boost::hash_combine(seed, te->getOffsetT());
+	boost::hash_combine(seed, te->getRotation());
+	boost::hash_combine(seed, (S32) te->getTexGen());
+	boost::hash_combine(seed, te->getBumpShinyFullbright());
+	boost::hash_combine(seed, te->getGlow());
+	boost::hash_combine(seed, facep->getTextureIndex());
+	boost::hash_combine(seed, facep->getVertexBuffer()->getTypeMask());
+	boost::hash_combine(seed, facep->getGeomCount());
+	boost::hash_combine(seed, facep->getIndicesCount());
+	for (U32 i = 0; i < 3; ++i)
+	{
+		boost::hash_combine(seed, scale.mV[i]);
+	}
+	// never 0, which means "not instanceable"
+	return (U64) seed | 1;
+}
+
 bool can_batch_texture(LLFace* facep)
 {
 	if (facep->getTextureEntry()->getBumpmap())
@@ -5357,6 +5500,21 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 		info->mCount += facep->getIndicesCount();
 		info->mEnd += facep->getGeomCount();
 
+		if (info->mGeometryHash)
+		{
+			U64 face_hash = rigged_face_geometry_hash(facep);
+			if (face_hash)
+			{
+				size_t seed = (size_t) info->mGeometryHash;
+				boost::hash_combine(seed, face_hash);
+				info->mGeometryHash = (U64) seed | 1;
+			}
+			else
+			{
+				info->mGeometryHash = 0;
+			}
+		}
+
 		if (index < FACE_DO_NOT_BATCH_TEXTURES && index >= info->mTextureList.size())
 		{
 			info->mTextureList.resize(index+1);
@@ -5399,6 +5557,10 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
 		draw_info->mShaderMask = shader_mask;
         draw_info->mAvatar = facep->mAvatar;
         draw_info->mSkinInfo = facep->mSkinInfo;
+        if (rigged)
+        {
+            draw_info->mGeometryHash = rigged_face_geometry_hash(facep);
+        }
 
         if (gltf_mat)
         {
@@ -5512,6 +5674,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 	}
 
 	group->mBuilt = 1.f;
+	add(LLStatViewer::GROUPS_REBUILT, 1);
 	
 	LLSpatialBridge* bridge = group->getSpatialPartition()->asBridge();
     LLViewerObject *vobj = NULL;
@@ -6147,6 +6310,83 @@ struct CompareBatchBreakerRigged
     }
 };
 
+static bool fill_face_geometry(LLFace* facep)
+{
+	LLVOVolume* vobj = facep->getDrawable()->getVOVolume();
+	return facep->getGeometryVolume(*vobj->getVolume(), facep->getTEOffset(),
+		vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), facep->getGeomIndex(), true);
+}
+
+void LLVolumeGeometryManager::fillGeometry(const LLFrameVector<GeomBatch>& batches)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	//below this many faces the hand off to the pipeline thread pool costs more than it saves
+	const U32 MIN_PARALLEL_FACES = 64;
+
+	static LLCachedControl<bool> parallel_rebuild(gSavedSettings, "RenderParallelGeometryRebuild", false);
+
+	LLFrameVector<LLFace*> faces;
+
+	for (const GeomBatch& batch : batches)
+	{
+		//every face writes straight into the buffer's client side copy, unmapBuffer uploads it all at once
+		LLVertexBuffer* buffer = batch.mBuffer;
+		buffer->mapEntireBuffer();
+
+		for (LLFace** face_iter = batch.mBegin; face_iter < batch.mEnd; ++face_iter)
+		{
+			LLFace* facep = *face_iter;
+			LLDrawable* drawablep = facep->getDrawable();
+
+			if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+			{ //updateRelativeXform modifies the object, so these stay on the main thread
+				LLVOVolume* vobj = drawablep->getVOVolume();
+				vobj->updateRelativeXform(true);
+				if (!fill_face_geometry(facep))
+				{
+					LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+				}
+				vobj->updateRelativeXform(false);
+			}
+			else
+			{
+				faces.push_back(facep);
+			}
+		}
+	}
+
+	if (parallel_rebuild && faces.size() >= MIN_PARALLEL_FACES)
+	{
+		std::atomic<U32> failed { 0 };
+
+		gPipeline.runParallel((U32) faces.size(), [&faces, &failed](U32 i)
+			{
+				if (!fill_face_geometry(faces[i]))
+				{
+					++failed;
+				}
+			});
+
+		add(LLStatViewer::FACES_FILLED_PARALLEL, faces.size());
+
+		if (failed)
+		{
+			LL_WARNS() << "Failed to get geometry for " << failed.load() << " faces!" << LL_ENDL;
+		}
+	}
+	else
+	{
+		for (LLFace* facep : faces)
+		{
+			if (!fill_face_geometry(facep))
+			{
+				LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+			}
+		}
+	}
+}
+
 U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace** faces, U32 face_count, BOOL distance_sort, BOOL batch_textures, BOOL rigged)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
@@ -6205,6 +6445,8 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 
 	bool flexi = false;
 
+	LLFrameVector<GeomBatch> batches;
+
 	while (face_iter != end_faces)
 	{
 		//pull off next face
@@ -6378,11 +6620,16 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			buffer_map[mask][*face_iter].push_back(buffer);
 		}
 
-		//add face geometry
+		//assign faces to the new buffer, geometry is copied in below once every buffer exists
 
 		U32 indices_index = 0;
 		U16 index_offset = 0;
 
+		if (buffer)
+		{
+			batches.push_back({ buffer, face_iter, i, bake_sunlight });
+		}
+
         while (face_iter < i)
 		{
 			//update face indices for new buffer
@@ -6405,37 +6652,24 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 				LL_ERRS() << "Invalid texture index." << LL_ENDL;
 			}
 			
-			{
-				//for debugging, set last time face was updated vs moved
-				facep->updateRebuildFlags();
-
-				{ //copy face geometry into vertex buffer
-					LLDrawable* drawablep = facep->getDrawable();
-					LLVOVolume* vobj = drawablep->getVOVolume();
-					LLVolume* volume = vobj->getVolume();
-
-					if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
-					{
-						vobj->updateRelativeXform(true);
-					}
+			//for debugging, set last time face was updated vs moved
+			facep->updateRebuildFlags();
 
-					U32 te_idx = facep->getTEOffset();
+			index_offset += facep->getGeomCount();
+			indices_index += facep->getIndicesCount();
+			++face_iter;
+		}
+	}
 
-					if (!facep->getGeometryVolume(*volume, te_idx, 
-						vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
-					{
-						LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
-					}
+	fillGeometry(batches);
 
-					if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
-					{
-						vobj->updateRelativeXform(false);
-					}
-				}
-			}
+	for (const GeomBatch& batch : batches)
+	{
+		bool bake_sunlight = batch.mBakeSunlight;
 
-			index_offset += facep->getGeomCount();
-			indices_index += facep->getIndicesCount();
+		for (face_iter = batch.mBegin; face_iter < batch.mEnd; ++face_iter)
+		{
+			LLFace* facep = *face_iter;
 
 			//append face to appropriate render batch
 
@@ -6454,7 +6688,7 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 				fullbright = TRUE;
 			}
 			
-			tex = facep->getTexture();
+			LLViewerTexture* tex = facep->getTexture();
 
 			BOOL is_alpha = (facep->getPoolType() == LLDrawPool::POOL_ALPHA) ? TRUE : FALSE;
 
@@ -6774,14 +7008,10 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
                     registerFace(group, facep, LLRenderPass::PASS_GLOW);
                 }
 			}
-						
-			++face_iter;
 		}
 
-		if (buffer)
-		{
-			buffer->unmapBuffer();
-		}
+		LLVertexBuffer* buffer = batch.mBuffer;
+		buffer->unmapBuffer();
 	}
 
 	group->mBufferMap[mask].clear();
@@ -418,8 +418,10 @@ public:
 	//clear out rigged volume and revert back to non-rigged state for picking/LOD/distance updates
 	void clearRiggedVolume();
 
+	// detail an object of radius at distance from the camera wants
+	static S32 computeLODDetail(F32 distance, F32 radius, F32 lod_factor);
+
 protected:
-	S32	computeLODDetail(F32 distance, F32 radius, F32 lod_factor);
 	BOOL calcLOD();
 	LLFace* addFace(S32 face_index);
 	
@@ -436,6 +438,9 @@ protected:
 private:
     bool lodOrSculptChanged(LLDrawable *drawable, BOOL &compiled, BOOL &shouldUpdateOctreeBounds);
 
+	// rebuild the objects showing a sculpt that was regenerated on the volume build queue
+	static void onSculptGenerated(const LLUUID& sculpt_id, LLVolume* volumep);
+
 public:
 
 	static S32 getRenderComplexityMax() {return mRenderComplexity_last;}
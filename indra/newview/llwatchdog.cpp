@@ -174,10 +174,11 @@ void LLWatchdog::remove(LLWatchdogEntry* e)
 	unlockThread();
 }
 
-void LLWatchdog::init()
+void LLWatchdog::init(hung_callback_t hung_callback)
 {
 	if(!mSuspectsAccessMutex && !mTimer)
 	{
+		mHungCallback = hung_callback;
 		mSuspectsAccessMutex = new LLMutex();
 		mTimer = new LLWatchdogTimerThread();
 		mTimer->setSleepTime(WATCHDOG_SLEEP_TIME_USEC / 1000);
@@ -241,6 +242,11 @@ void LLWatchdog::run()
 				mTimer->stop();
 			}
 
+			if (mHungCallback)
+			{
+				mHungCallback();
+			}
+
             LL_ERRS() << "Watchdog timer expired; assuming viewer is hung and crashing" << LL_ENDL;
 		}
 	}
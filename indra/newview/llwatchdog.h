@@ -83,7 +83,10 @@ public:
 	void add(LLWatchdogEntry* e);
 	void remove(LLWatchdogEntry* e);
 
-	void init();
+	// hung_callback, if any, runs on the watchdog thread just before it
+	// crashes the viewer
+	typedef boost::function<void()> hung_callback_t;
+	void init(hung_callback_t hung_callback = hung_callback_t());
 	void run();
 	void cleanup();
     
@@ -96,6 +99,7 @@ private:
 	LLMutex* mSuspectsAccessMutex;
 	LLWatchdogTimerThread* mTimer;
 	U64 mLastClockCount;
+	hung_callback_t mHungCallback;
 };
 
 #endif // LL_LLTHREADWATCHDOG_H
@@ -94,6 +94,19 @@ void LLWearableList::getAsset(const LLAssetID& assetID, const std::string& weara
 	}
 }
 
+void LLWearableList::prefetchAsset(const LLAssetID& assetID, LLAvatarAppearance* avatarp, LLAssetType::EType asset_type)
+{
+	llassert( (asset_type == LLAssetType::AT_CLOTHING) || (asset_type == LLAssetType::AT_BODYPART) );
+	if (mList.find(assetID) == mList.end())
+	{
+		gAssetStorage->getAssetData(assetID,
+			asset_type,
+			LLWearableList::processGetAssetReply,
+			(void*)new LLWearableArrivedData( asset_type, LLStringUtil::null, avatarp, NULL, NULL ),
+			TRUE);
+	}
+}
+
 // static
 void LLWearableList::processGetAssetReply( const char* filename, const LLAssetID& uuid, void* userdata, S32 status, LLExtStat ext_status )
 {
@@ -182,11 +195,18 @@ void LLWearableList::processGetAssetReply( const char* filename, const LLAssetID
 
 	if (wearable) // success
 	{
-		LLWearableList::instance().mList[ uuid ] = wearable;
+		LLViewerWearable*& listed = LLWearableList::instance().mList[ uuid ];
+		if (listed)
+		{
+			// A prefetch and a request shared the download, keep the first copy
+			delete wearable;
+			wearable = listed;
+		}
+		listed = wearable;
 		LL_DEBUGS("Wearable") << "processGetAssetReply()" << LL_ENDL;
 		LL_DEBUGS("Wearable") << wearable << LL_ENDL;
 	}
-	else
+	else if (data->mCallback) // prefetches leave reporting to the request that needs the wearable
 	{
 		LLSD args;
 		args["TYPE"] =LLTrans::getString(LLAssetType::lookupHumanReadable(data->mAssetType));
@@ -54,6 +54,11 @@ public:
 								 LLAssetType::EType asset_type,
 								 void(*asset_arrived_callback)(LLViewerWearable*, void* userdata),
 								 void* userdata);
+	// Starts loading a wearable ahead of need, a later getAsset() will
+	// find it in the list or join the pending download.
+	void				prefetchAsset(const LLAssetID& assetID,
+									  LLAvatarAppearance *avatarp,
+									  LLAssetType::EType asset_type);
 
 	LLViewerWearable*			createCopy(const LLViewerWearable* old_wearable, const std::string& new_name = std::string());
 	LLViewerWearable*			createNewWearable(LLWearableType::EType type, LLAvatarAppearance *avatarp);
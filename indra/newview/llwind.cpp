@@ -37,8 +37,6 @@
 
 // linden libraries
 #include "llgl.h"
-#include "patch_dct.h"
-#include "patch_code.h"
 
 // viewer
 #include "noise.h"
@@ -86,68 +84,15 @@ void LLWind::init()
 }
 
 
-void LLWind::decompress(LLBitPack &bitpack, LLGroupHeader *group_headerp)
+void LLWind::setVelocities(const F32 *vel_x, const F32 *vel_y, S32 size)
 {
-	LLPatchHeader  patch_header;
-	S32 buffer[16*16];
-
-	init_patch_decompressor(group_headerp->patch_size);
-
-	// Don't use the packed group_header stride because the strides used on
-	// simulator and viewer are not equal.
-	group_headerp->stride = group_headerp->patch_size;	
-	set_group_of_patch_header(group_headerp);
-
-	// X component
-	decode_patch_header(bitpack, &patch_header);
-	decode_patch(bitpack, buffer);
-	decompress_patch(mVelX, buffer, &patch_header);
-
-	// Y component
-	decode_patch_header(bitpack, &patch_header);
-	decode_patch(bitpack, buffer);
-	decompress_patch(mVelY, buffer, &patch_header);
-
-	S32 i, j, k;
-
-	for (j=1; j<mSize-1; j++)
-	{
-		for (i=1; i<mSize-1; i++)
-		{
-			k = i + j * mSize;
-			*(mVelX + k) = *(mVelX + k);
-			*(mVelY + k) = *(mVelY + k);
-		}
-	}
-
-	i = mSize - 1;
-	for (j=1; j<mSize-1; j++)
-	{
-		k = i + j * mSize;
-		*(mVelX + k) = *(mVelX + k);
-		*(mVelY + k) = *(mVelY + k);
-	}
-	i = 0;
-	for (j=1; j<mSize-1; j++)
-	{
-		k = i + j * mSize;
-		*(mVelX + k) = *(mVelX + k);
-		*(mVelY + k) = *(mVelY + k);
-	}
-	j = mSize - 1;
-	for (i=1; i<mSize-1; i++)
-	{
-		k = i + j * mSize;
-		*(mVelX + k) = *(mVelX + k);
-		*(mVelY + k) = *(mVelY + k);
-	}
-	j = 0;
-	for (i=1; i<mSize-1; i++)
+	if (size != mSize)
 	{
-		k = i + j * mSize;
-		*(mVelX + k) = *(mVelX + k);
-		*(mVelY + k) = *(mVelY + k);
+		LL_WARNS() << "Wind layer of size " << size << " does not fit the " << mSize << " grid" << LL_ENDL;
+		return;
 	}
+	memcpy(mVelX, vel_x, mSize * mSize * sizeof(F32));
+	memcpy(mVelY, vel_y, mSize * mSize * sizeof(F32));
 }
 
 
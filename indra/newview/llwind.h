@@ -32,8 +32,6 @@
 #include "v3dmath.h"
 
 class LLVector3;
-class LLBitPack;
-class LLGroupHeader;
 
 const F32 WIND_SCALE_HACK		= 2.0f;	// hack to make wind speeds more realistic
 
@@ -47,7 +45,8 @@ public:
 	LLVector3 getVelocity(const LLVector3 &location); // "location" is region-local
 	LLVector3 getVelocityNoisy(const LLVector3 &location, const F32 dim);	// "location" is region-local
 
-	void decompress(LLBitPack &bitpack, LLGroupHeader *group_headerp);
+	// Velocity components from a decoded wind layer, size x size each.
+	void setVelocities(const F32 *vel_x, const F32 *vel_y, S32 size);
 	LLVector3 getAverage();
 
 	void setOriginGlobal(const LLVector3d &origin_global);
@@ -55,10 +55,12 @@
 #include "llvocache.h"
 #include "llvowater.h"
 #include "message.h"
+#include "llmessagedecoders.h"
 #include "pipeline.h"
 #include "llappviewer.h"		// for do_disconnect()
 #include "llscenemonitor.h"
 #include <deque>
+#include <unordered_set>
 #include <queue>
 #include <map>
 #include <cstring>
@@ -93,7 +95,8 @@ LLWorld::LLWorld() :
 	mLastPacketsIn(0),
 	mLastPacketsOut(0),
 	mLastPacketsLost(0),
-	mSpaceTimeUSec(0)
+	mSpaceTimeUSec(0),
+	mAvatarIndexFrame(U32_MAX)
 {
 	for (S32 i = 0; i < EDGE_WATER_OBJECTS_COUNT; i++)
 	{
@@ -839,13 +842,20 @@ void LLWorld::printPacketsLost()
 	}
 }
 
-void LLWorld::processCoarseUpdate(LLMessageSystem* msg, void** user_data)
+bool LLWorld::processCoarseUpdate(LLMessageSystem* msg, const U8* data, S32 size, void** user_data)
 {
+	LLMsgCoarseLocationUpdate update;
+	if (!update.decode(data, size))
+	{
+		return false;
+	}
+
 	LLViewerRegion* region = LLWorld::getInstance()->getRegion(msg->getSender());
 	if( region )
 	{
-		region->updateCoarseLocations(msg);
+		region->updateCoarseLocations(update);
 	}
+	return true;
 }
 
 F32 LLWorld::getLandFarClip() const
@@ -1308,18 +1318,36 @@ static LLVector3d unpackLocalToGlobalPosition(U32 compact_local, const LLVector3
 	return region_origin + pos_local;
 }
 
-void LLWorld::getAvatars(uuid_vec_t* avatar_ids, std::vector<LLVector3d>* positions, const LLVector3d& relative_to, F32 radius) const
+// size of the cells of the avatar index, a chat range query touches 4 of them
+static const F64 AVATAR_CELL_SIZE = 64.0;
+// queries spanning more cells than this on a side scan every avatar instead
+static const S32 AVATAR_MAX_QUERY_CELLS = 16;
+
+static S32 avatar_cell(F64 coord)
 {
-	F32 radius_squared = radius * radius;
-	
-	if(avatar_ids != NULL)
-	{
-		avatar_ids->clear();
-	}
-	if(positions != NULL)
+	return (S32)floor(coord / AVATAR_CELL_SIZE);
+}
+
+static U64 avatar_cell_key(S32 x, S32 y)
+{
+	return ((U64)(U32)x << 32) | (U32)y;
+}
+
+void LLWorld::updateAvatarIndex() const
+{
+	if (mAvatarIndexFrame == gFrameCount)
 	{
-		positions->clear();
+		return;
 	}
+	mAvatarIndexFrame = gFrameCount;
+
+	LL_PROFILE_ZONE_SCOPED;
+
+	mAvatarEntries.clear();
+	mAvatarCells.clear();
+
+	std::unordered_set<LLUUID> seen;
+
 	// get the list of avatars from the character list first, so distances are correct
 	// when agent is above 1020m and other avatars are nearby
 	for (std::vector<LLCharacter*>::iterator iter = LLCharacter::sInstances.begin();
@@ -1329,45 +1357,97 @@ void LLWorld::getAvatars(uuid_vec_t* avatar_ids, std::vector<LLVector3d>* positi
 
 		if (!pVOAvatar->isDead() && !pVOAvatar->mIsDummy && !pVOAvatar->isOrphaned())
 		{
-			LLVector3d pos_global = pVOAvatar->getPositionGlobal();
-			LLUUID uuid = pVOAvatar->getID();
-
-			if (!uuid.isNull()
-				&& dist_vec_squared(pos_global, relative_to) <= radius_squared)
+			const LLUUID& uuid = pVOAvatar->getID();
+			if (uuid.notNull() && seen.insert(uuid).second)
 			{
-				if(positions != NULL)
-				{
-					positions->push_back(pos_global);
-				}
-				if(avatar_ids !=NULL)
-				{
-					avatar_ids->push_back(uuid);
-				}
+				mAvatarEntries.push_back({ uuid, pVOAvatar->getPositionGlobal(), false });
 			}
 		}
 	}
+
 	// region avatars added for situations where radius is greater than RenderFarClip
-	for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin();
-		iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
+	for (LLWorld::region_list_t::const_iterator iter = getRegionList().begin();
+		iter != getRegionList().end(); ++iter)
 	{
 		LLViewerRegion* regionp = *iter;
 		const LLVector3d& origin_global = regionp->getOriginGlobal();
-		S32 count = regionp->mMapAvatars.size();
+		S32 count = (S32)llmin(regionp->mMapAvatars.size(), regionp->mMapAvatarIDs.size());
 		for (S32 i = 0; i < count; i++)
 		{
-			LLVector3d pos_global = unpackLocalToGlobalPosition(regionp->mMapAvatars.at(i), origin_global);
-			if(dist_vec_squared(pos_global, relative_to) <= radius_squared)
+			const LLUUID& uuid = regionp->mMapAvatarIDs.at(i);
+			// if this avatar isn't already in the list, add it
+			if (uuid.notNull() && seen.insert(uuid).second)
+			{
+				mAvatarEntries.push_back({ uuid, unpackLocalToGlobalPosition(regionp->mMapAvatars.at(i), origin_global), true });
+			}
+		}
+	}
+
+	mAvatarCells.reserve(mAvatarEntries.size());
+	for (U32 i = 0; i < mAvatarEntries.size(); ++i)
+	{
+		const LLVector3d& pos = mAvatarEntries[i].mPosition;
+		mAvatarCells.push_back(std::make_pair(avatar_cell_key(avatar_cell(pos.mdV[VX]), avatar_cell(pos.mdV[VY])), i));
+	}
+	std::sort(mAvatarCells.begin(), mAvatarCells.end());
+}
+
+void LLWorld::getAvatars(uuid_vec_t* avatar_ids, std::vector<LLVector3d>* positions, const LLVector3d& relative_to, F32 radius) const
+{
+	F64 radius_squared = (F64)radius * radius;
+	
+	if(avatar_ids != NULL)
+	{
+		avatar_ids->clear();
+	}
+	if(positions != NULL)
+	{
+		positions->clear();
+	}
+
+	updateAvatarIndex();
+
+	auto add = [&](const AvatarEntry& entry)
+	{
+		// coarse locations are only reported along with their ids
+		if ((entry.mCoarse && avatar_ids == NULL)
+			|| dist_vec_squared(entry.mPosition, relative_to) > radius_squared)
+		{
+			return;
+		}
+		if(positions != NULL)
+		{
+			positions->push_back(entry.mPosition);
+		}
+		if(avatar_ids != NULL)
+		{
+			avatar_ids->push_back(entry.mID);
+		}
+	};
+
+	if (radius >= AVATAR_CELL_SIZE * AVATAR_MAX_QUERY_CELLS)
+	{ // cheaper to look at every avatar than at every cell in range
+		for (const AvatarEntry& entry : mAvatarEntries)
+		{
+			add(entry);
+		}
+		return;
+	}
+
+	S32 min_x = avatar_cell(relative_to.mdV[VX] - radius);
+	S32 max_x = avatar_cell(relative_to.mdV[VX] + radius);
+	S32 min_y = avatar_cell(relative_to.mdV[VY] - radius);
+	S32 max_y = avatar_cell(relative_to.mdV[VY] + radius);
+
+	for (S32 x = min_x; x <= max_x; ++x)
+	{
+		for (S32 y = min_y; y <= max_y; ++y)
+		{
+			U64 key = avatar_cell_key(x, y);
+			for (auto iter = std::lower_bound(mAvatarCells.begin(), mAvatarCells.end(), std::make_pair(key, (U32)0));
+				iter != mAvatarCells.end() && iter->first == key; ++iter)
 			{
-				LLUUID uuid = regionp->mMapAvatarIDs.at(i);
-				// if this avatar doesn't already exist in the list, add it
-				if(uuid.notNull() && avatar_ids != NULL && std::find(avatar_ids->begin(), avatar_ids->end(), uuid) == avatar_ids->end())
-				{
-					if (positions != NULL)
-					{
-						positions->push_back(pos_global);
-					}
-					avatar_ids->push_back(uuid);
-				}
+				add(mAvatarEntries[iter->second]);
 			}
 		}
 	}
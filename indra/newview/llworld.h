@@ -132,7 +132,7 @@ public:
 	void requestCacheMisses();
 
 	// deal with map object updates in the world.
-	static void processCoarseUpdate(LLMessageSystem* msg, void** user_data);
+	static bool processCoarseUpdate(LLMessageSystem* msg, const U8* data, S32 size, void** user_data);
 
 	F32 getLandFarClip() const;
 	void setLandFarClip(const F32 far_clip);
@@ -178,6 +178,9 @@ private:
     void clearHoleWaterObjects();
     void clearEdgeWaterObjects();
 
+	// rebuild the avatar index if it wasn't built this frame yet
+	void updateAvatarIndex() const;
+
 	region_list_t	mActiveRegionList;
 	region_list_t	mRegionList;
 	region_list_t	mVisibleRegionList;
@@ -185,6 +188,20 @@ private:
 
 	region_remove_signal_t mRegionRemovedSignal;
 
+	// Every known avatar once, with its LLVOAvatar position if there is one
+	// and its coarse location otherwise, rebuilt once per frame by getAvatars
+	struct AvatarEntry
+	{
+		LLUUID		mID;
+		LLVector3d	mPosition;
+		bool		mCoarse;	// only known from the region's coarse locations
+	};
+	mutable std::vector<AvatarEntry> mAvatarEntries;
+	// (cell key, index into mAvatarEntries) sorted by cell, cells are
+	// AVATAR_CELL_SIZE meters on each side in global x and y
+	mutable std::vector<std::pair<U64, U32> > mAvatarCells;
+	mutable U32 mAvatarIndexFrame;
+
 	// Number of points on edge
 	static const U32 mWidth;
 
@@ -1185,23 +1185,7 @@ void LLWorldMapView::drawAvatar(F32 x_pixels,
 								F32 dot_radius,
 								bool unknown_relative_z)
 {
-	const F32 HEIGHT_THRESHOLD = 7.f;
-	LLUIImagePtr dot_image = sAvatarLevelImage;
-	if (unknown_relative_z && llabs(relative_z) > HEIGHT_THRESHOLD)
-	{
-		dot_image = sAvatarUnknownImage;
-	}
-	else
-	{
-		if(relative_z < -HEIGHT_THRESHOLD)
-		{
-			dot_image = sAvatarBelowImage; 
-		}
-		else if(relative_z > HEIGHT_THRESHOLD) 
-		{ 
-			dot_image = sAvatarAboveImage;
-		}
-	}
+	LLUIImagePtr dot_image = getAvatarImage(relative_z, unknown_relative_z);
 	S32 dot_width = ll_round(dot_radius * 2.f);
 	dot_image->draw(ll_round(x_pixels - dot_radius),
 					ll_round(y_pixels - dot_radius),
@@ -1210,6 +1194,25 @@ void LLWorldMapView::drawAvatar(F32 x_pixels,
 					color);
 }
 
+// static
+LLUIImagePtr LLWorldMapView::getAvatarImage(F32 relative_z, bool unknown_relative_z)
+{
+	const F32 HEIGHT_THRESHOLD = 7.f;
+	if (unknown_relative_z && llabs(relative_z) > HEIGHT_THRESHOLD)
+	{
+		return sAvatarUnknownImage;
+	}
+	if(relative_z < -HEIGHT_THRESHOLD)
+	{
+		return sAvatarBelowImage; 
+	}
+	if(relative_z > HEIGHT_THRESHOLD) 
+	{ 
+		return sAvatarAboveImage;
+	}
+	return sAvatarLevelImage;
+}
+
 // Pass relative Z of 0 to draw at same level.
 // static
 void LLWorldMapView::drawTrackingDot( F32 x_pixels, 
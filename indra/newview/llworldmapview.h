@@ -124,6 +124,8 @@ public:
 								F32 relative_z = 0.f,
 								F32 dot_radius = 3.f,
 								bool reached_max_z = false);
+	// the marker drawAvatar() uses for an avatar at relative_z
+	static LLUIImagePtr	getAvatarImage(F32 relative_z, bool unknown_relative_z);
 	static void		drawIconName(F32 x_pixels, 
 									F32 y_pixels, 
 									const LLColor4& color,
@@ -38,6 +38,7 @@
 #include "llpointer.h"
 #include "llprimitive.h"
 #include "llvolume.h"
+#include "llvolumemgr.h"
 #include "material_codes.h"
 #include "v3color.h"
 #include "llui.h" 
@@ -61,6 +62,9 @@
 #include "lldrawpoolwater.h"
 #include "llface.h"
 #include "llfeaturemanager.h"
+#include "llframepacer.h"
+#include "llframetelemetry.h"
+#include "llflexibleobject.h"
 #include "llfloatertelehub.h"
 #include "llfloaterreg.h"
 #include "llhudmanager.h"
@@ -112,10 +116,15 @@
 #include "llscenemonitor.h"
 #include "llprogressview.h"
 #include "llcleanup.h"
+#include "threadpool.h"
 
 #include "llenvironment.h"
 #include "llsettingsvo.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 extern BOOL gSnapshot;
 bool gShiftFrame = false;
 
@@ -125,6 +134,8 @@ bool LLPipeline::RenderDeferred;
 F32 LLPipeline::RenderDeferredSunWash;
 U32 LLPipeline::RenderFSAASamples;
 U32 LLPipeline::RenderResolutionDivisor;
+F32 LLPipeline::RenderResolutionScale;
+F32 LLPipeline::RenderUpscaleSharpness;
 bool LLPipeline::RenderUIBuffer;
 S32 LLPipeline::RenderShadowDetail;
 S32 LLPipeline::RenderShadowSplits;
@@ -191,6 +202,10 @@ F32 LLPipeline::CameraMaxCoF;
 F32 LLPipeline::CameraDoFResScale;
 F32 LLPipeline::RenderAutoHideSurfaceAreaLimit;
 bool LLPipeline::RenderScreenSpaceReflections;
+bool LLPipeline::RenderHiZOcclusion;
+bool LLPipeline::RenderTextureFeedback;
+bool LLPipeline::RenderShadowCache;
+F32 LLPipeline::RenderShadowCacheSunAngle;
 S32 LLPipeline::RenderScreenSpaceReflectionIterations;
 F32 LLPipeline::RenderScreenSpaceReflectionRayStep;
 F32 LLPipeline::RenderScreenSpaceReflectionDistanceBias;
@@ -337,6 +352,8 @@ LLPipeline::LLPipeline() :
 	mNumVisibleNodes(0),
 	mNumVisibleFaces(0),
 	mPoissonOffset(0),
+	mPipelineThreadPool(NULL),
+	mQueueFaceCenters(false),
 
 	mInitialized(false),
 	mShadersLoaded(false),
@@ -390,6 +407,12 @@ void LLPipeline::init()
 	
 	stop_glerror();
 
+	if (!mPipelineThreadPool)
+	{ //worker threads for runParallel, idle unless a parallel cull or rebuild is requested
+		mPipelineThreadPool = new LL::ThreadPool("Pipeline", 3);
+		mPipelineThreadPool->start();
+	}
+
 	//create render pass pools
 	getPool(LLDrawPool::POOL_ALPHA_PRE_WATER);
     getPool(LLDrawPool::POOL_ALPHA_POST_WATER);
@@ -483,6 +506,8 @@ void LLPipeline::init()
 	connectRefreshCachedSettingsSafe("RenderDeferredSunWash");
 	connectRefreshCachedSettingsSafe("RenderFSAASamples");
 	connectRefreshCachedSettingsSafe("RenderResolutionDivisor");
+	connectRefreshCachedSettingsSafe("RenderResolutionScale");
+	connectRefreshCachedSettingsSafe("RenderUpscaleSharpness");
 	connectRefreshCachedSettingsSafe("RenderUIBuffer");
 	connectRefreshCachedSettingsSafe("RenderShadowDetail");
     connectRefreshCachedSettingsSafe("RenderShadowSplits");
@@ -554,6 +579,10 @@ void LLPipeline::init()
     connectRefreshCachedSettingsSafe("RenderScreenSpaceReflectionDepthRejectBias");
     connectRefreshCachedSettingsSafe("RenderScreenSpaceReflectionAdaptiveStepMultiplier");
     connectRefreshCachedSettingsSafe("RenderScreenSpaceReflectionGlossySamples");
+    connectRefreshCachedSettingsSafe("RenderHiZOcclusion");
+    connectRefreshCachedSettingsSafe("RenderTextureFeedback");
+    connectRefreshCachedSettingsSafe("RenderShadowCache");
+    connectRefreshCachedSettingsSafe("RenderShadowCacheSunAngle");
 	connectRefreshCachedSettingsSafe("RenderBufferVisualization");
 	gSavedSettings.getControl("RenderAutoHideSurfaceAreaLimit")->getCommitSignal()->connect(boost::bind(&LLPipeline::refreshCachedSettings));
 }
@@ -630,6 +659,15 @@ void LLPipeline::cleanup()
     mMovedBridge.clear();
     mShiftList.clear();
 
+	if (mPipelineThreadPool)
+	{
+		mPipelineThreadPool->close();
+		delete mPipelineThreadPool;
+		mPipelineThreadPool = NULL;
+	}
+	mCullPartitions.clear();
+	mCullResults.clear();
+
 	mInitialized = false;
 
 	mDeferredVB = NULL;
@@ -651,12 +689,25 @@ void LLPipeline::destroyGL()
 	resetDrawOrders();
 
 	releaseGLBuffers();
+	LLRenderPass::releaseSkinInstanceBuffer();
+	LLDrawPoolTree::releaseInstanceBuffer();
+	if (LLEnvironment::instanceExists())
+	{
+		LLEnvironment::instance().releaseAtmosphericsUBO();
+	}
 
 	if (mMeshDirtyQueryObject)
 	{
 		glDeleteQueries(1, &mMeshDirtyQueryObject);
 		mMeshDirtyQueryObject = 0;
 	}
+
+	if (LLFrameTelemetry::instanceExists())
+	{
+		LLFrameTelemetry::instance().destroyGL();
+	}
+
+	LLFramePacer::destroyGL();
 }
 
 void LLPipeline::requestResizeScreenTexture()
@@ -689,6 +740,8 @@ void LLPipeline::resizeScreenTexture()
 			releaseScreenBuffers();
             releaseSunShadowTargets();
             releaseSpotShadowTargets();
+            // pooled targets are sized to the old screen
+            mTargetPool.clear();
 		    allocateScreenBuffer(resX,resY);
             gResizeScreenTexture = FALSE;
 		}
@@ -787,6 +840,14 @@ bool LLPipeline::allocateScreenBuffer(U32 resX, U32 resY, U32 samples)
 		resY /= res_mod;
 	}
 
+	// dynamic resolution (see LLPerfStats autotune), renderFinalize upscales
+	// the result to the window; reflection probe targets keep their size
+	if (mRT == &mMainRT && RenderResolutionScale < 1.f)
+	{
+		resX = llmax((U32) (resX * RenderResolutionScale) & ~1U, 2U);
+		resY = llmax((U32) (resY * RenderResolutionScale) & ~1U, 2U);
+	}
+
     //water reflection texture (always needed as scratch space whether or not transparent water is enabled)
     mWaterDis.allocate(resX, resY, GL_RGBA16F, true);
 
@@ -811,15 +872,6 @@ bool LLPipeline::allocateScreenBuffer(U32 resX, U32 resY, U32 samples)
 
     mRT->deferredScreen.shareDepthBuffer(mRT->screen);
 
-	if (samples > 0)
-	{
-		if (!mRT->fxaaBuffer.allocate(resX, resY, GL_RGBA)) return false;
-	}
-	else
-	{
-		mRT->fxaaBuffer.release();
-	}
-		
 	if (shadow_detail > 0 || ssao || RenderDepthOfField || samples > 0)
 	{ //only need mRT->deferredLight for shadows OR ssao OR dof OR fxaa
 		if (!mRT->deferredLight.allocate(resX, resY, GL_RGBA16F)) return false;
@@ -836,10 +888,6 @@ bool LLPipeline::allocateScreenBuffer(U32 resX, U32 resY, U32 samples)
         mSceneMap.allocate(resX, resY, GL_RGB, true);
     }
 
-	const bool post_hdr = gSavedSettings.getBOOL("RenderPostProcessingHDR");
-    const U32 post_color_fmt = post_hdr ? GL_RGBA16F : GL_RGBA;
-    mPostMap.allocate(resX, resY, post_color_fmt);
-
     //HACK make screenbuffer allocations start failing after 30 seconds
     if (gSavedSettings.getBOOL("SimulateFBOFailure"))
     {
@@ -951,6 +999,14 @@ void LLPipeline::updateRenderTransparentWater()
     sRenderTransparentWater = gSavedSettings.getBOOL("RenderTransparentWater");
 }
 
+//static
+bool LLPipeline::useWaterScreenSpaceReflections()
+{
+    static LLCachedControl<bool> water_ssr(gSavedSettings, "RenderWaterScreenSpaceReflections", false);
+    static LLCachedControl<bool> ssr(gSavedSettings, "RenderScreenSpaceReflections", false);
+    return water_ssr && !ssr && sRenderTransparentWater;
+}
+
 // static
 void LLPipeline::refreshCachedSettings()
 {
@@ -971,6 +1027,8 @@ void LLPipeline::refreshCachedSettings()
 	RenderDeferredSunWash = gSavedSettings.getF32("RenderDeferredSunWash");
 	RenderFSAASamples = LLFeatureManager::getInstance()->isFeatureAvailable("RenderFSAASamples") ? gSavedSettings.getU32("RenderFSAASamples") : 0;
 	RenderResolutionDivisor = gSavedSettings.getU32("RenderResolutionDivisor");
+	RenderResolutionScale = llclamp(gSavedSettings.getF32("RenderResolutionScale"), 0.5f, 1.f);
+	RenderUpscaleSharpness = llclamp(gSavedSettings.getF32("RenderUpscaleSharpness"), 0.f, 1.f);
 	RenderUIBuffer = gSavedSettings.getBOOL("RenderUIBuffer");
 	RenderShadowDetail = gSavedSettings.getS32("RenderShadowDetail");
     RenderShadowSplits = gSavedSettings.getS32("RenderShadowSplits");
@@ -1042,6 +1100,10 @@ void LLPipeline::refreshCachedSettings()
     RenderScreenSpaceReflectionDepthRejectBias = gSavedSettings.getF32("RenderScreenSpaceReflectionDepthRejectBias");
     RenderScreenSpaceReflectionAdaptiveStepMultiplier = gSavedSettings.getF32("RenderScreenSpaceReflectionAdaptiveStepMultiplier");
     RenderScreenSpaceReflectionGlossySamples = gSavedSettings.getS32("RenderScreenSpaceReflectionGlossySamples");
+    RenderHiZOcclusion = gSavedSettings.getBOOL("RenderHiZOcclusion");
+    RenderTextureFeedback = gSavedSettings.getBOOL("RenderTextureFeedback");
+    RenderShadowCache = gSavedSettings.getBOOL("RenderShadowCache");
+    RenderShadowCacheSunAngle = gSavedSettings.getF32("RenderShadowCacheSunAngle");
 	RenderBufferVisualization = gSavedSettings.getS32("RenderBufferVisualization");
     sReflectionProbesEnabled = LLFeatureManager::getInstance()->isFeatureAvailable("RenderReflectionsEnabled") && gSavedSettings.getBOOL("RenderReflectionsEnabled");
 	RenderSpotLight = nullptr;
@@ -1076,7 +1138,7 @@ void LLPipeline::releaseGLBuffers()
 	
     mSceneMap.release();
 
-    mPostMap.release();
+    mTargetPool.clear();
 
 	for (U32 i = 0; i < 3; i++)
 	{
@@ -1087,6 +1149,7 @@ void LLPipeline::releaseGLBuffers()
 
 	gBumpImageList.destroyGL();
 	LLVOAvatar::resetImpostors();
+	mImpostorAtlas.release();
 }
 
 void LLPipeline::releaseLUTBuffers()
@@ -1103,6 +1166,9 @@ void LLPipeline::releaseLUTBuffers()
     mLuminanceMap.release();
     mLastExposure.release();
 
+    mHiZOcclusion.release();
+    mTextureFeedback.release();
+
 }
 
 void LLPipeline::releaseShadowBuffers()
@@ -1115,7 +1181,6 @@ void LLPipeline::releaseScreenBuffers()
 {
     mRT->uiScreen.release();
     mRT->screen.release();
-    mRT->fxaaBuffer.release();
     mRT->deferredScreen.release();
     mRT->deferredLight.release();
 }
@@ -1124,6 +1189,12 @@ void LLPipeline::releaseSunShadowTarget(U32 index)
 {
     llassert(index < 4);
     mRT->shadow[index].release();
+
+    if (!gCubeSnapshot) // cube snapshots don't use the cache
+    {
+        mShadowCache[index].mDepth.release();
+        mShadowCache[index].mValid = false;
+    }
 }
 
 void LLPipeline::releaseSunShadowTargets()
@@ -1836,11 +1907,18 @@ void LLPipeline::updateMoveNormalAsync(LLDrawable* drawablep)
 void LLPipeline::updateMovedList(LLDrawable::drawable_vector_t& moved_list)
 {
     LL_PROFILE_ZONE_SCOPED;
-	for (LLDrawable::drawable_vector_t::iterator iter = moved_list.begin();
-		 iter != moved_list.end(); )
-	{
-		LLDrawable::drawable_vector_t::iterator curiter = iter++;
-		LLDrawable *drawablep = *curiter;
+	// Face centers only depend on the drawable's render matrix, so they are
+	// left until every transform on the list is up to date and then done in
+	// one pass (see queueFaceCenterUpdate)
+	llassert(!mQueueFaceCenters);
+	mQueueFaceCenters = true;
+
+	// which drawables are still moving, the list keeps every drawable
+	// referenced until the queued face centers are done
+	mMovedListDone.clear();
+	for (size_t i = 0; i < moved_list.size(); ++i)
+	{
+		LLDrawable *drawablep = moved_list[i];
 		bool done = true;
 		if (!drawablep->isDead() && (!drawablep->isState(LLDrawable::EARLY_MOVE)))
 		{
@@ -1864,9 +1942,68 @@ void LLPipeline::updateMovedList(LLDrawable::drawable_vector_t& moved_list)
 					drawablep->getVObj()->dirtySpatialGroup();
 				}
 			}
-			iter = moved_list.erase(curiter);
+		}
+		mMovedListDone.push_back(done);
+	}
+
+	mQueueFaceCenters = false;
+	updateMovedFaceCenters();
+
+	// Compact in place rather than erasing as we go: the drawables still
+	// moving are moved down over the finished ones, without any refcounting.
+	size_t keep = 0;
+	for (size_t i = 0; i < moved_list.size(); ++i)
+	{
+		if (!mMovedListDone[i])
+		{
+			if (keep != i)
+			{
+				moved_list[keep] = std::move(moved_list[i]);
+			}
+			++keep;
+		}
+	}
+	moved_list.resize(keep);
+}
+
+bool LLPipeline::queueFaceCenterUpdate(LLDrawable* drawablep)
+{
+	if (!mQueueFaceCenters)
+	{
+		return false;
+	}
+	mMovedFaceDrawables.push_back(drawablep);
+	return true;
+}
+
+void LLPipeline::updateMovedFaceCenters()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+	// each drawable only writes its own faces and reads its own or its
+	// parent's matrix, which are all final by now
+	static LLCachedControl<bool> parallel_move(gSavedSettings, "RenderParallelMoveUpdate", false);
+	const U32 count = (U32)mMovedFaceDrawables.size();
+	const U32 FACE_CENTER_BATCH = 256;
+	if (parallel_move && count > FACE_CENTER_BATCH && mPipelineThreadPool)
+	{
+		runParallel((count + FACE_CENTER_BATCH - 1) / FACE_CENTER_BATCH,
+			[&](U32 batch)
+			{
+				U32 end = llmin(count, (batch + 1) * FACE_CENTER_BATCH);
+				for (U32 i = batch * FACE_CENTER_BATCH; i < end; ++i)
+				{
+					mMovedFaceDrawables[i]->updateFaceCenters();
+				}
+			});
+	}
+	else
+	{
+		for (LLDrawable* drawablep : mMovedFaceDrawables)
+		{
+			drawablep->updateFaceCenters();
 		}
 	}
+	mMovedFaceDrawables.clear();
 }
 
 void LLPipeline::updateMove()
@@ -2266,28 +2403,38 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
 
 	sCull->clear();
 
-	for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
-			iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
+	// occlusion queries can only be read back on the GL thread, so the parallel path
+	// is limited to passes that don't touch them (shadows, or occlusion disabled)
+	static LLCachedControl<bool> parallel_cull(gSavedSettings, "RenderParallelCull", false);
+	if (parallel_cull && sUseOcclusion < 2 && mPipelineThreadPool)
 	{
-		LLViewerRegion* region = *iter;
-
-		for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+		parallelCull(camera);
+	}
+	else
+	{
+		for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
+				iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
 		{
-			LLSpatialPartition* part = region->getSpatialPartition(i);
-			if (part)
+			LLViewerRegion* region = *iter;
+
+			for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
 			{
-				if (hasRenderType(part->mDrawableType))
+				LLSpatialPartition* part = region->getSpatialPartition(i);
+				if (part)
 				{
-					part->cull(camera);
+					if (hasRenderType(part->mDrawableType))
+					{
+						part->cull(camera);
+					}
 				}
 			}
-		}
 
-		//scan the VO Cache tree
-		LLVOCachePartition* vo_part = region->getVOCachePartition();
-		if(vo_part)
-		{
-			vo_part->cull(camera, sUseOcclusion > 0);
+			//scan the VO Cache tree
+			LLVOCachePartition* vo_part = region->getVOCachePartition();
+			if(vo_part)
+			{
+				vo_part->cull(camera, sUseOcclusion > 0);
+			}
 		}
 	}
 
@@ -2311,7 +2458,172 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
     }
 }
 
-void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
+void LLPipeline::runParallel(U32 count, const std::function<void(U32)>& func, const std::function<void()>& main_thread_work)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    struct Jobs
+    {
+        std::atomic<U32>        mNext { 0 };
+        U32                     mPending = 0; // posted tasks that have not finished yet, guarded by mMutex
+        std::mutex              mMutex;
+        std::condition_variable mDone;
+    } jobs;
+
+    // claim indices until there are none left; the calling thread runs this too, so
+    // a busy or closed pool only costs parallelism, never correctness
+    auto claim = [&jobs, &func, count]()
+    {
+        for (U32 i = jobs.mNext++; i < count; i = jobs.mNext++)
+        {
+            func(i);
+        }
+    };
+
+    U32 tasks = mPipelineThreadPool ? llmin((U32)mPipelineThreadPool->getWidth(), count) : 0;
+    if (!main_thread_work && tasks > 0 && tasks == count)
+    { // leave one for the calling thread
+        --tasks;
+    }
+
+    jobs.mPending = tasks;
+    for (U32 i = 0; i < tasks; ++i)
+    {
+        bool posted = mPipelineThreadPool->getQueue().post(
+            [&jobs, claim]()
+            {
+                claim();
+                // notify while holding the lock so jobs can't go out of scope underneath us
+                std::lock_guard<std::mutex> lock(jobs.mMutex);
+                --jobs.mPending;
+                jobs.mDone.notify_one();
+            });
+
+        if (!posted)
+        {
+            std::lock_guard<std::mutex> lock(jobs.mMutex);
+            --jobs.mPending;
+        }
+    }
+
+    if (main_thread_work)
+    {
+        main_thread_work();
+    }
+
+    claim();
+
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_PIPELINE("runParallel - wait");
+        std::unique_lock<std::mutex> lock(jobs.mMutex);
+        jobs.mDone.wait(lock, [&jobs]() { return jobs.mPending == 0; });
+    }
+}
+
+LL::WorkQueueBase* LLPipeline::getThreadPoolQueue()
+{
+    return mPipelineThreadPool ? &mPipelineThreadPool->getQueue() : NULL;
+}
+
+void LLPipeline::parallelCull(LLCamera& camera)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+    llassert(sUseOcclusion < 2);
+
+    // collect partitions in the same order the serial path visits them, so that appending
+    // the per-partition results in index order reproduces the serial draw order exactly
+    mCullPartitions.clear();
+    for (LLViewerRegion* region : LLWorld::getInstance()->getRegionList())
+    {
+        for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+        {
+            LLSpatialPartition* part = region->getSpatialPartition(i);
+            if (part && hasRenderType(part->mDrawableType))
+            {
+                // rebound touches the octree listeners, keep it on this thread
+                part->prepareCull();
+                mCullPartitions.push_back(part);
+            }
+        }
+    }
+
+    const U32 count = (U32)mCullPartitions.size();
+    while (mCullResults.size() < count)
+    {
+        mCullResults.emplace_back(new LLCullResult());
+    }
+
+    // the VO cache trees only fill their own region's visible group list, which
+    // LLViewerRegion::idleUpdate turns into objects under its time budget.  Without
+    // object cache occlusion they don't read back queries either, so each region
+    // can be culled on a worker next to the spatial partitions.
+    static LLCachedControl<bool> use_object_cache_occlusion(gSavedSettings, "UseObjectCacheOcclusion");
+    const bool vo_occlusion = sUseOcclusion > 0 && use_object_cache_occlusion;
+    mCullVOPartitions.clear();
+    if (!vo_occlusion)
+    {
+        for (LLViewerRegion* region : LLWorld::getInstance()->getRegionList())
+        {
+            LLVOCachePartition* vo_part = region->getVOCachePartition();
+            if (vo_part && vo_part->prepareCull())
+            {
+                mCullVOPartitions.push_back(vo_part);
+            }
+        }
+    }
+    const U32 vo_count = (U32)mCullVOPartitions.size();
+    mCullVOResults.assign(vo_count, 0);
+
+    runParallel(count + vo_count,
+        [this, &camera, count](U32 i)
+        {
+            if (i < count)
+            {
+                LLCullResult* result = mCullResults[i].get();
+                result->clear();
+                mCullPartitions[i]->traverseCull(camera, result);
+            }
+            else
+            {
+                // traverseCull sets the region frustum planes, don't share them
+                LLCamera region_camera(camera);
+                mCullVOResults[i - count] = mCullVOPartitions[i - count]->traverseCull(region_camera, false);
+            }
+        },
+        [&camera, vo_occlusion]()
+        {
+            if (!vo_occlusion)
+            {
+                return;
+            }
+            // occlusion queries have to be read on this thread, scan the VO cache trees while the workers get going
+            for (LLViewerRegion* region : LLWorld::getInstance()->getRegionList())
+            {
+                LLVOCachePartition* vo_part = region->getVOCachePartition();
+                if (vo_part)
+                {
+                    vo_part->cull(camera, true);
+                }
+            }
+        });
+
+    for (U32 i = 0; i < count; ++i)
+    {
+        LLCullResult* result = mCullResults[i].get();
+        mNumVisibleNodes += result->getVisibleGroupsSize() + result->getDrawableGroupsSize();
+        sCull->append(*result);
+    }
+
+    for (U32 i = 0; i < vo_count; ++i)
+    {
+        if (mCullVOResults[i])
+        {
+            mCullVOPartitions[i]->finishCull();
+        }
+    }
+}
+
+void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera, LLCullResult* result)
 {
 	if (group->isEmpty())
 	{ 
@@ -2326,14 +2638,16 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
 	}
 	
 	assertInitialized();
+
+	LLCullResult* cull = result ? result : sCull;
 	
 	if (!group->getSpatialPartition()->mRenderByGroup)
 	{ //render by drawable
-		sCull->pushDrawableGroup(group);
+		cull->pushDrawableGroup(group);
 	}
 	else
 	{   //render by group
-		sCull->pushVisibleGroup(group);
+		cull->pushVisibleGroup(group);
 	}
 
     if (group->needsUpdate() ||
@@ -2341,20 +2655,25 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
     {
         // include this group in occlusion groups, not because it is an occluder, but because we want to run
         // an occlusion query to find out if it's an occluder
-        markOccluder(group);
+        markOccluder(group, result);
     }
-	mNumVisibleNodes++;
+
+	if (!result)
+	{ //parallelCull accounts for visible nodes when it merges its results
+		mNumVisibleNodes++;
+	}
 }
 
-void LLPipeline::markOccluder(LLSpatialGroup* group)
+void LLPipeline::markOccluder(LLSpatialGroup* group, LLCullResult* result)
 {
 	if (sUseOcclusion > 1 && group && !group->isOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION))
 	{
+		LLCullResult* cull = result ? result : sCull;
 		LLSpatialGroup* parent = group->getParent();
 
 		if (!parent || !parent->isOcclusionState(LLSpatialGroup::OCCLUDED))
 		{ //only mark top most occluders as active occlusion
-			sCull->pushOcclusionGroup(group);
+			cull->pushOcclusionGroup(group);
 			group->setOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION);
 				
 			if (parent && 
@@ -2362,7 +2681,7 @@ void LLPipeline::markOccluder(LLSpatialGroup* group)
 				parent->getElementCount() == 0 &&
 				parent->needsUpdate())
 			{
-				sCull->pushOcclusionGroup(group);
+				cull->pushOcclusionGroup(group);
 				parent->setOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION);
 			}
 		}
@@ -2395,6 +2714,11 @@ void LLPipeline::doOcclusion(LLCamera& camera)
         gGL.setColorMask(true, true);
     }
 
+    if (RenderHiZOcclusion && LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD)
+    {
+        mHiZOcclusion.update();
+    }
+
     if (LLPipeline::sUseOcclusion > 1 &&
 		(sCull->hasOcclusionGroups() || LLVOCachePartition::sNeedsOcclusionCheck))
 	{
@@ -2463,6 +2787,11 @@ void LLPipeline::updateGL()
 			LLGLUpdate::sGLQ.pop_front();
 		}
 	}
+
+    if (LLViewerShaderMgr::sInitialized)
+    {
+        LLViewerShaderMgr::instance()->updateShaderLinks();
+    }
 }
 
 void LLPipeline::clearRebuildGroups()
@@ -2470,6 +2799,8 @@ void LLPipeline::clearRebuildGroups()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
 	LLSpatialGroup::sg_vector_t	hudGroups;
 
+	sample(LLStatViewer::GROUP_REBUILD_QUEUE, mGroupQ1.size());
+
 	mGroupQ1Locked = true;
 	// Iterate through all drawables on the priority build queue,
 	for (LLSpatialGroup::sg_vector_t::iterator iter = mGroupQ1.begin();
@@ -2547,6 +2878,9 @@ void LLPipeline::rebuildPriorityGroups()
 	assertInitialized();
 
 	gMeshRepo.notifyLoadedMeshes();
+	LLPrimitive::getVolumeManager()->updateBuilds();
+
+	sample(LLStatViewer::GROUP_REBUILD_QUEUE, mGroupQ1.size());
 
 	mGroupQ1Locked = true;
 	// Iterate through all drawables on the priority build queue,
@@ -2558,7 +2892,9 @@ void LLPipeline::rebuildPriorityGroups()
 		group->clearState(LLSpatialGroup::IN_BUILD_Q1);
 	}
 
-	mGroupSaveQ1 = mGroupQ1;
+	// hand the references over instead of copying them, and keep both
+	// vectors' storage for the next frame
+	mGroupSaveQ1.swap(mGroupQ1);
 	mGroupQ1.clear();
 	mGroupQ1Locked = false;
 
@@ -2580,6 +2916,7 @@ void LLPipeline::updateGeom(F32 max_dtime)
 	// notify various object types to reset internal cost metrics, etc.
 	// for now, only LLVOVolume does this to throttle LOD changes
 	LLVOVolume::preUpdateGeom();
+	LLVolumeImplFlexible::updateBatch();
 
 	// Iterate through all drawables on the priority build queue,
 	for (LLDrawable::drawable_list_t::iterator iter = mBuildQ1.begin();
@@ -3294,6 +3631,90 @@ void renderSoundHighlights(LLDrawable *drawablep)
     }
 }
 
+// List of render pass types that use the prim volume as the shadow,
+// ignoring textures.
+static const U32 shadow_opaque_types[] = {
+    LLRenderPass::PASS_SIMPLE,
+    LLRenderPass::PASS_FULLBRIGHT,
+    LLRenderPass::PASS_SHINY,
+    LLRenderPass::PASS_BUMP,
+    LLRenderPass::PASS_FULLBRIGHT_SHINY,
+    LLRenderPass::PASS_MATERIAL,
+    LLRenderPass::PASS_MATERIAL_ALPHA_EMISSIVE,
+    LLRenderPass::PASS_SPECMAP,
+    LLRenderPass::PASS_SPECMAP_EMISSIVE,
+    LLRenderPass::PASS_NORMMAP,
+    LLRenderPass::PASS_NORMMAP_EMISSIVE,
+    LLRenderPass::PASS_NORMSPEC,
+    LLRenderPass::PASS_NORMSPEC_EMISSIVE
+};
+
+// true if draws of this pass type can go in a cached shadow map
+// alpha tested passes depend on texture contents that change as textures load, so they never can
+static bool is_static_shadow_pass(U32 type)
+{
+    if (type == LLRenderPass::PASS_GLTF_PBR)
+    {
+        return true;
+    }
+
+    for (U32 opaque : shadow_opaque_types)
+    {
+        if (type == opaque)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// true if group holds static geometry, anything that moves lives in a bridge
+static bool is_static_shadow_group(LLSpatialGroup* group)
+{
+    LLSpatialPartition* part = group->getSpatialPartition();
+    return !part->asBridge() && part->mPartitionType == LLViewerRegion::PARTITION_VOLUME;
+}
+
+void LLPipeline::markShadowCacheDirty(LLSpatialGroup* group)
+{
+    if (!RenderShadowCache || mShadowCacheAllDirty)
+    {
+        return;
+    }
+
+    U32 type = group->getSpatialPartition()->mPartitionType;
+    if (group->getSpatialPartition()->asBridge() ||
+        (type != LLViewerRegion::PARTITION_VOLUME && type != LLViewerRegion::PARTITION_TERRAIN))
+    {
+        return;
+    }
+
+    // more than a handful of changes in a frame is a region loading in, don't bother tracking them
+    const U32 MAX_DIRTY_GROUPS = 256;
+    if (mShadowCacheDirty.size() >= MAX_DIRTY_GROUPS)
+    {
+        mShadowCacheAllDirty = true;
+        mShadowCacheDirty.clear();
+        return;
+    }
+
+    const LLVector4a* bounds = group->getBounds();
+    mShadowCacheDirty.emplace_back(LLVector3(bounds[0].getF32ptr()), LLVector3(bounds[1].getF32ptr()));
+}
+
+// true if a and b are the same shadow matrix give or take float noise
+static bool shadow_matrix_matches(const glh::matrix4f& a, const glh::matrix4f& b)
+{
+    for (U32 i = 0; i < 16; ++i)
+    {
+        if (fabsf(a.m[i] - b.m[i]) > 1e-5f * (1.f + fabsf(b.m[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void LLPipeline::postSort(LLCamera &camera)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
@@ -3360,6 +3781,12 @@ void LLPipeline::postSort(LLCamera &camera)
             {
                 LLDrawInfo *info = *k;
 
+                if (sShadowRender && mShadowGeometry != SHADOW_GEOM_ALL &&
+                    (is_static_shadow_group(group) && is_static_shadow_pass(j->first) && info->mAvatar.isNull()) != (mShadowGeometry == SHADOW_GEOM_STATIC))
+                {
+                    continue;
+                }
+
                 sCull->pushDrawInfo(j->first, info);
                 if (!sShadowRender && !sReflectionRender && !gCubeSnapshot)
                 {
@@ -3422,12 +3849,40 @@ void LLPipeline::postSort(LLCamera &camera)
     }*/
 
     // pack vertex buffers for groups that chose to delay their updates
+    auto rebuild_mesh = [this]()
     {
         LL_PROFILE_GPU_ZONE("rebuildMesh");
         for (LLSpatialGroup::sg_vector_t::iterator iter = mMeshDirtyGroup.begin(); iter != mMeshDirtyGroup.end(); ++iter)
         {
             (*iter)->rebuildMesh();
         }
+    };
+
+    // the sorts only read the distances and render order filled in above, while the
+    // mesh rebuild only writes vertex buffers, so the sorts can run on the pipeline
+    // threads while this thread submits the buffer updates
+    static LLCachedControl<bool> parallel_post_sort(gSavedSettings, "RenderParallelPostSort", false);
+    bool sorted = false;
+    if (!sShadowRender && parallel_post_sort && mPipelineThreadPool)
+    {
+        runParallel(2,
+            [](U32 i)
+            {
+                if (i == 0)
+                {
+                    std::sort(sCull->beginAlphaGroups(), sCull->endAlphaGroups(), LLSpatialGroup::CompareDepthGreater());
+                }
+                else
+                {
+                    std::sort(sCull->beginRiggedAlphaGroups(), sCull->endRiggedAlphaGroups(), LLSpatialGroup::CompareRenderOrder());
+                }
+            },
+            rebuild_mesh);
+        sorted = true;
+    }
+    else
+    {
+        rebuild_mesh();
     }
 
     /*if (use_transform_feedback)
@@ -3437,7 +3892,7 @@ void LLPipeline::postSort(LLCamera &camera)
 
     mMeshDirtyGroup.clear();
 
-    if (!sShadowRender)
+    if (!sShadowRender && !sorted)
     {
         // order alpha groups by distance
         std::sort(sCull->beginAlphaGroups(), sCull->endAlphaGroups(), LLSpatialGroup::CompareDepthGreater());
@@ -3995,8 +4450,12 @@ void LLPipeline::renderGeomShadow(LLCamera& camera)
 		
 		cur_type = poolp->getType();
 
+		// terrain is the only pool drawn with the static casters
+		bool geometry_match = mShadowGeometry == SHADOW_GEOM_ALL ||
+			(cur_type == LLDrawPool::POOL_TERRAIN) == (mShadowGeometry == SHADOW_GEOM_STATIC);
+
 		pool_set_t::iterator iter2 = iter1;
-		if (hasRenderType(poolp->getType()) && poolp->getNumShadowPasses() > 0)
+		if (geometry_match && hasRenderType(poolp->getType()) && poolp->getNumShadowPasses() > 0)
 		{
 			poolp->prerender() ;
 
@@ -4055,6 +4514,7 @@ void LLPipeline::recordTrianglesDrawn()
     U32 count = sIndicesDrawnCount / 3;
     sIndicesDrawnCount = 0;
     add(LLStatViewer::TRIANGLES_DRAWN, LLUnits::Triangles::fromValue(count));
+    LLFrameTelemetry::addTriangles(count);
 }
 
 void LLPipeline::renderPhysicsDisplay()
@@ -4174,7 +4634,15 @@ void LLPipeline::renderDebug()
 
 				if ( pathfindingConsole->getVisible() || gAgentCamera.cameraMouselook() )
 				{				
-					F32 ambiance = gSavedSettings.getF32("PathfindingAmbiance");
+					static LLCachedControl<F32> pathfinding_ambiance(gSavedSettings, "PathfindingAmbiance", 0.5f);
+					static LLCachedControl<LLColor4> navmesh_clear(gSavedSettings, "PathfindingNavMeshClear", LLColor4::black);
+					static LLCachedControl<F32> line_offset(gSavedSettings, "PathfindingLineOffset", 2.3f);
+					static LLCachedControl<F32> line_width(gSavedSettings, "PathfindingLineWidth", 2.f);
+					static LLCachedControl<F32> xray_tint(gSavedSettings, "PathfindingXRayTint", 0.8f);
+					static LLCachedControl<F32> xray_opacity(gSavedSettings, "PathfindingXRayOpacity", 0.25f);
+					static LLCachedControl<bool> xray_wireframe(gSavedSettings, "PathfindingXRayWireframe", false);
+
+					F32 ambiance = pathfinding_ambiance;
 
 					gPathfindingProgram.bind();
 			
@@ -4184,7 +4652,7 @@ void LLPipeline::renderDebug()
 
 					if ( !pathfindingConsole->isRenderWorld() )
 					{
-						const LLColor4 clearColor = gSavedSettings.getColor4("PathfindingNavMeshClear");
+						const LLColor4 clearColor = navmesh_clear;
 						gGL.setColorMask(true, true);
 						glClearColor(clearColor.mV[0],clearColor.mV[1],clearColor.mV[2],0);
                         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT); // no stencil -- deprecated | GL_STENCIL_BUFFER_BIT);
@@ -4304,18 +4772,18 @@ void LLPipeline::renderDebug()
 								LLGLEnable lineOffset(GL_POLYGON_OFFSET_LINE);
 								glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );	
 						
-								F32 offset = gSavedSettings.getF32("PathfindingLineOffset");
+								F32 offset = line_offset;
 
 								if (pathfindingConsole->isRenderXRay())
 								{
-									gPathfindingProgram.uniform1f(sTint, gSavedSettings.getF32("PathfindingXRayTint"));
-									gPathfindingProgram.uniform1f(sAlphaScale, gSavedSettings.getF32("PathfindingXRayOpacity"));
+									gPathfindingProgram.uniform1f(sTint, xray_tint);
+									gPathfindingProgram.uniform1f(sAlphaScale, xray_opacity);
 									LLGLEnable blend(GL_BLEND);
 									LLGLDepthTest depth(GL_TRUE, GL_FALSE, GL_GREATER);
 								
 									glPolygonOffset(offset, -offset);
 								
-									if (gSavedSettings.getBOOL("PathfindingXRayWireframe"))
+									if (xray_wireframe)
 									{ //draw hidden wireframe as darker and less opaque
 										gPathfindingProgram.uniform1f(sAmbiance, 1.f);
 										llPathingLibInstance->renderNavMeshShapesVBO( render_order[i] );				
@@ -4335,7 +4803,7 @@ void LLPipeline::renderDebug()
 									gPathfindingProgram.uniform1f(sTint, 1.f);
 									gPathfindingProgram.uniform1f(sAlphaScale, 1.f);
 
-									glLineWidth(gSavedSettings.getF32("PathfindingLineWidth"));
+									glLineWidth(line_width);
 									LLGLDisable blendOut(GL_BLEND);
 									llPathingLibInstance->renderNavMeshShapesVBO( render_order[i] );				
 									gGL.flush();
@@ -4351,12 +4819,12 @@ void LLPipeline::renderDebug()
 
 					if ( pathfindingConsole->isRenderNavMesh() && pathfindingConsole->isRenderXRay() )
 					{	//render navmesh xray
-						F32 ambiance = gSavedSettings.getF32("PathfindingAmbiance");
+						F32 ambiance = pathfinding_ambiance;
 
 						LLGLEnable lineOffset(GL_POLYGON_OFFSET_LINE);
 						LLGLEnable polyOffset(GL_POLYGON_OFFSET_FILL);
 											
-						F32 offset = gSavedSettings.getF32("PathfindingLineOffset");
+						F32 offset = line_offset;
 						glPolygonOffset(offset, -offset);
 
 						LLGLEnable blend(GL_BLEND);
@@ -4365,10 +4833,10 @@ void LLPipeline::renderDebug()
 						glLineWidth(2.0f);	
 						LLGLEnable cull(GL_CULL_FACE);
 																		
-						gPathfindingProgram.uniform1f(sTint, gSavedSettings.getF32("PathfindingXRayTint"));
-						gPathfindingProgram.uniform1f(sAlphaScale, gSavedSettings.getF32("PathfindingXRayOpacity"));
+						gPathfindingProgram.uniform1f(sTint, xray_tint);
+						gPathfindingProgram.uniform1f(sAlphaScale, xray_opacity);
 								
-						if (gSavedSettings.getBOOL("PathfindingXRayWireframe"))
+						if (xray_wireframe)
 						{ //draw hidden wireframe as darker and less opaque
 							glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );	
 							gPathfindingProgram.uniform1f(sAmbiance, 1.f);
@@ -4383,8 +4851,8 @@ void LLPipeline::renderDebug()
 
 						//render edges
 						gPathfindingNoNormalsProgram.bind();
-						gPathfindingNoNormalsProgram.uniform1f(sTint, gSavedSettings.getF32("PathfindingXRayTint"));
-						gPathfindingNoNormalsProgram.uniform1f(sAlphaScale, gSavedSettings.getF32("PathfindingXRayOpacity"));
+						gPathfindingNoNormalsProgram.uniform1f(sTint, xray_tint);
+						gPathfindingNoNormalsProgram.uniform1f(sAlphaScale, xray_opacity);
 						llPathingLibInstance->renderNavMeshEdges();
 						gPathfindingProgram.bind();
 					
@@ -4500,7 +4968,8 @@ void LLPipeline::renderDebug()
         mReflectionMapManager.renderDebug();
     }
 
-    if (gSavedSettings.getBOOL("RenderReflectionProbeVolumes") && !hud_only)
+    static LLCachedControl<bool> probe_volumes(gSavedSettings, "RenderReflectionProbeVolumes", false);
+    if (probe_volumes && !hud_only)
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_PIPELINE("probe debug display");
 
@@ -6695,6 +7164,68 @@ void LLPipeline::visualizeBuffers(LLRenderTarget* src, LLRenderTarget* dst, U32
 	dst->flush();
 }
 
+std::string LLPipeline::getRenderTargetDebugText() const
+{
+	std::vector<LLRenderTargetPool::TargetInfo> info;
+	auto add = [&info](const std::string& name, const LLRenderTarget& target)
+	{
+		U64 bytes = target.getBytesAllocated();
+		if (bytes)
+		{
+			info.push_back({ name, target.getWidth(), target.getHeight(), bytes, true });
+		}
+	};
+
+	add("screen", mMainRT.screen);
+	add("deferred", mMainRT.deferredScreen);
+	add("light", mMainRT.deferredLight);
+	add("ui", mMainRT.uiScreen);
+	add("probe screen", mAuxillaryRT.screen);
+	add("probe deferred", mAuxillaryRT.deferredScreen);
+	add("probe light", mAuxillaryRT.deferredLight);
+	for (U32 i = 0; i < 4; i++)
+	{
+		add(llformat("sun%d", i), mMainRT.shadow[i]);
+		add(llformat("sun%d cache", i), mShadowCache[i].mDepth);
+	}
+	for (U32 i = 0; i < 2; i++)
+	{
+		add(llformat("spot%d", i), mSpotShadow[i]);
+	}
+	for (U32 i = 0; i < 3; i++)
+	{
+		add(llformat("glow%d", i), mGlow[i]);
+	}
+	add("water", mWaterDis);
+	add("scene", mSceneMap);
+	add("luminance", mLuminanceMap);
+
+	U64 persistent = 0;
+	for (const LLRenderTargetPool::TargetInfo& target : info)
+	{
+		persistent += target.mBytes;
+	}
+
+	size_t pooled_begin = info.size();
+	mTargetPool.getTargetInfo(info);
+	for (size_t i = pooled_begin; i < info.size(); ++i)
+	{
+		info[i].mName = (info[i].mInUse ? "pool " : "pool idle ") + info[i].mName;
+	}
+
+	std::sort(info.begin(), info.end(),
+		[](const LLRenderTargetPool::TargetInfo& lhs, const LLRenderTargetPool::TargetInfo& rhs) { return lhs.mBytes > rhs.mBytes; });
+
+	const F32 MB = 1024.f * 1024.f;
+	std::string text = llformat("RT: %.1f MB Pool: %.1f MB", persistent / MB, mTargetPool.getBytesAllocated() / MB);
+	const size_t MAX_LISTED = 8;
+	for (size_t i = 0; i < info.size() && i < MAX_LISTED; ++i)
+	{
+		text += llformat(" %s %ux%u %.1f", info[i].mName.c_str(), info[i].mWidth, info[i].mHeight, info[i].mBytes / MB);
+	}
+	return text;
+}
+
 void LLPipeline::generateLuminance(LLRenderTarget* src, LLRenderTarget* dst)
 {
 	// luminance sample and mipmap generation
@@ -6989,7 +7520,12 @@ void LLPipeline::applyFXAA(LLRenderTarget* src, LLRenderTarget* dst)
 {
 	{
 		llassert(!gCubeSnapshot);
-		bool multisample = RenderFSAASamples > 1 && mRT->fxaaBuffer.isComplete();
+		LLRenderTarget* fxaa_buffer = NULL;
+		if (RenderFSAASamples > 1)
+		{
+			fxaa_buffer = mTargetPool.acquire("fxaa", src->getWidth(), src->getHeight(), GL_RGBA);
+		}
+		bool multisample = fxaa_buffer != NULL;
 		LLGLSLShader* shader = &gGlowCombineProgram;
 
 		S32 width = dst->getWidth();
@@ -7000,7 +7536,7 @@ void LLPipeline::applyFXAA(LLRenderTarget* src, LLRenderTarget* dst)
 		{
 			LL_PROFILE_GPU_ZONE("aa");
 			// bake out texture2D with RGBL for FXAA shader
-			mRT->fxaaBuffer.bindTarget();
+			fxaa_buffer->bindTarget();
 
 			shader = &gGlowCombineFXAAProgram;
 			shader->bind();
@@ -7020,16 +7556,16 @@ void LLPipeline::applyFXAA(LLRenderTarget* src, LLRenderTarget* dst)
 			shader->disableTexture(LLShaderMgr::DEFERRED_DIFFUSE, src->getUsage());
 			shader->unbind();
 
-			mRT->fxaaBuffer.flush();
+			fxaa_buffer->flush();
 
 			dst->bindTarget();
 			shader = &gFXAAProgram;
 			shader->bind();
 
-			channel = shader->enableTexture(LLShaderMgr::DIFFUSE_MAP, mRT->fxaaBuffer.getUsage());
+			channel = shader->enableTexture(LLShaderMgr::DIFFUSE_MAP, fxaa_buffer->getUsage());
 			if (channel > -1)
 			{
-				mRT->fxaaBuffer.bindTexture(0, channel, LLTexUnit::TFO_BILINEAR);
+				fxaa_buffer->bindTexture(0, channel, LLTexUnit::TFO_BILINEAR);
 			}
 
 			gGLViewport[0] = gViewerWindow->getWorldViewRectRaw().mLeft;
@@ -7039,8 +7575,8 @@ void LLPipeline::applyFXAA(LLRenderTarget* src, LLRenderTarget* dst)
 
 			glViewport(gGLViewport[0], gGLViewport[1], gGLViewport[2], gGLViewport[3]);
 
-			F32 scale_x = (F32)width / mRT->fxaaBuffer.getWidth();
-			F32 scale_y = (F32)height / mRT->fxaaBuffer.getHeight();
+			F32 scale_x = (F32)width / fxaa_buffer->getWidth();
+			F32 scale_y = (F32)height / fxaa_buffer->getHeight();
 			shader->uniform2f(LLShaderMgr::FXAA_TC_SCALE, scale_x, scale_y);
 			shader->uniform2f(LLShaderMgr::FXAA_RCP_SCREEN_RES, 1.f / width * scale_x, 1.f / height * scale_y);
 			shader->uniform4f(LLShaderMgr::FXAA_RCP_FRAME_OPT, -0.5f / width * scale_x, -0.5f / height * scale_y,
@@ -7059,6 +7595,8 @@ void LLPipeline::applyFXAA(LLRenderTarget* src, LLRenderTarget* dst)
 
 			shader->unbind();
 			dst->flush();
+
+			mTargetPool.release(fxaa_buffer);
 		}
 		else {
 			copyRenderTarget(src, dst);
@@ -7274,7 +7812,7 @@ void LLPipeline::renderDoF(LLRenderTarget* src, LLRenderTarget* dst)
 			{ // combine result based on alpha
 				
 				dst->bindTarget();
-				if (RenderFSAASamples > 1 && mRT->fxaaBuffer.isComplete())
+				if (RenderFSAASamples > 1) // applyFXAA follows
                 {
 					glViewport(0, 0, dst->getWidth(), dst->getHeight());
 				}
@@ -7340,13 +7878,24 @@ void LLPipeline::renderFinalize()
 
     generateExposure(&mLuminanceMap, &mExposureMap);
 
-    gammaCorrect(&mRT->screen, &mPostMap);
+    static LLCachedControl<bool> post_hdr(gSavedSettings, "RenderPostProcessingHDR", false);
+    LLRenderTarget* post_map = mTargetPool.acquire("post", mRT->screen.getWidth(), mRT->screen.getHeight(),
+                                                   post_hdr ? GL_RGBA16F : GL_RGBA);
+    if (!post_map)
+    { // out of video memory, show what we have
+        post_map = &mRT->screen;
+    }
 
-    LLVertexBuffer::unbind();
+    if (post_map != &mRT->screen)
+    {
+        gammaCorrect(&mRT->screen, post_map);
+
+        LLVertexBuffer::unbind();
 
-    generateGlow(&mPostMap);
+        generateGlow(post_map);
 
-    combineGlow(&mPostMap, &mRT->screen);
+        combineGlow(post_map, &mRT->screen);
+    }
 
 	gGLViewport[0] = gViewerWindow->getWorldViewRectRaw().mLeft;
 	gGLViewport[1] = gViewerWindow->getWorldViewRectRaw().mBottom;
@@ -7354,13 +7903,16 @@ void LLPipeline::renderFinalize()
 	gGLViewport[3] = gViewerWindow->getWorldViewRectRaw().getHeight();
 	glViewport(gGLViewport[0], gGLViewport[1], gGLViewport[2], gGLViewport[3]);
 
-	renderDoF(&mRT->screen, &mPostMap);
+	if (post_map != &mRT->screen)
+	{
+		renderDoF(&mRT->screen, post_map);
 
-	applyFXAA(&mPostMap, &mRT->screen);
+		applyFXAA(post_map, &mRT->screen);
+	}
 	LLRenderTarget* finalBuffer = &mRT->screen;
-	if (RenderBufferVisualization > -1)
+	if (RenderBufferVisualization > -1 && post_map != &mRT->screen)
     {
-		finalBuffer = &mPostMap;
+		finalBuffer = post_map;
 		switch (RenderBufferVisualization)
 		{
 		case 0:
@@ -7378,11 +7930,27 @@ void LLPipeline::renderFinalize()
 
 	// Present the screen target.
 
-	gDeferredPostNoDoFProgram.bind();
+	// rendering below window resolution (divisor or dynamic scale) gets
+	// upscaled with a contrast adaptive sharpen instead of a plain copy
+	LLGLSLShader* present_shader = &gDeferredPostNoDoFProgram;
+	if (finalBuffer->getWidth() < mRT->width && gUpscaleProgram.isComplete())
+	{
+		present_shader = &gUpscaleProgram;
+	}
+
+	present_shader->bind();
 
 	// Whatever is last in the above post processing chain should _always_ be rendered directly here.  If not, expect problems.
-	gDeferredPostNoDoFProgram.bindTexture(LLShaderMgr::DEFERRED_DIFFUSE, finalBuffer);
-	gDeferredPostNoDoFProgram.bindTexture(LLShaderMgr::DEFERRED_DEPTH, &mRT->deferredScreen, true);
+	present_shader->bindTexture(LLShaderMgr::DEFERRED_DIFFUSE, finalBuffer);
+	present_shader->bindTexture(LLShaderMgr::DEFERRED_DEPTH, &mRT->deferredScreen, true);
+
+	if (present_shader == &gUpscaleProgram)
+	{
+		static LLStaticHashedString source_res("source_res");
+		static LLStaticHashedString sharpness("sharpness");
+		present_shader->uniform2f(source_res, (F32) finalBuffer->getWidth(), (F32) finalBuffer->getHeight());
+		present_shader->uniform1f(sharpness, RenderUpscaleSharpness);
+	}
 
 	{
 		LLGLDepthTest depth_test(GL_TRUE, GL_TRUE, GL_ALWAYS);
@@ -7390,7 +7958,14 @@ void LLPipeline::renderFinalize()
 		mScreenTriangleVB->drawArrays(LLRender::TRIANGLES, 0, 3);
 	}
 
-	gDeferredPostNoDoFProgram.unbind();
+	present_shader->unbind();
+
+	if (post_map != &mRT->screen)
+	{
+		mTargetPool.release(post_map);
+	}
+	// about a second of frames idle before a pooled target is freed
+	mTargetPool.trim(LLFrameTimer::getFrameCount(), 60);
 
     gGL.setSceneBlendType(LLRender::BT_ALPHA);
 
@@ -7732,6 +8307,142 @@ LLVector4 pow4fsrgb(LLVector4 v, F32 f)
 	return v;
 }
 
+// Pixel bounds of a light's box in a width x height target, the whole
+// target if the box reaches behind the eye.
+static LLRect light_screen_rect(const glh::matrix4f& mvp, const F32* c, F32 s, S32 width, S32 height)
+{
+    F32 min_x = 1.f;
+    F32 min_y = 1.f;
+    F32 max_x = -1.f;
+    F32 max_y = -1.f;
+    for (U32 i = 0; i < 8; ++i)
+    {
+        glh::vec4f p(c[0] + ((i & 1) ? s : -s), c[1] + ((i & 2) ? s : -s), c[2] + ((i & 4) ? s : -s), 1.f);
+        mvp.mult_matrix_vec(p);
+        if (p.v[3] <= 0.001f)
+        {
+            return LLRect(0, height, width, 0);
+        }
+        F32 x = p.v[0] / p.v[3];
+        F32 y = p.v[1] / p.v[3];
+        min_x = llmin(min_x, x);
+        min_y = llmin(min_y, y);
+        max_x = llmax(max_x, x);
+        max_y = llmax(max_y, y);
+    }
+    min_x = llclamp(min_x, -1.f, 1.f);
+    min_y = llclamp(min_y, -1.f, 1.f);
+    max_x = llclamp(max_x, -1.f, 1.f);
+    max_y = llclamp(max_y, -1.f, 1.f);
+    return LLRect(llfloor((min_x * 0.5f + 0.5f) * width), llceil((max_y * 0.5f + 0.5f) * height),
+                  llceil((max_x * 0.5f + 0.5f) * width), llfloor((min_y * 0.5f + 0.5f) * height));
+}
+
+void LLPipeline::renderTiledLights(LLRenderTarget* target, const std::vector<LLVector4>& lights,
+                                   const std::vector<LLVector4>& colors, const std::vector<LLRect>& rects)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+    LL_PROFILE_GPU_ZONE("tiled lights");
+
+    const S32 TILES = 16; // per side
+    const U32 max_count = LL_DEFERRED_MULTI_LIGHT_COUNT;
+
+    S32 width = target->getWidth();
+    S32 height = target->getHeight();
+    S32 tile_w = (width + TILES - 1) / TILES;
+    S32 tile_h = (height + TILES - 1) / TILES;
+    if (tile_w <= 0 || tile_h <= 0)
+    {
+        return;
+    }
+
+    static std::vector<U32> tile_lights[TILES * TILES];
+    for (std::vector<U32>& tile : tile_lights)
+    {
+        tile.clear();
+    }
+
+    for (U32 i = 0; i < lights.size(); ++i)
+    {
+        const LLRect& rect = rects[i];
+        if (rect.mRight <= rect.mLeft || rect.mTop <= rect.mBottom)
+        {
+            continue;
+        }
+        S32 x0 = llclamp(rect.mLeft / tile_w, 0, TILES - 1);
+        S32 x1 = llclamp((rect.mRight - 1) / tile_w, 0, TILES - 1);
+        S32 y0 = llclamp(rect.mBottom / tile_h, 0, TILES - 1);
+        S32 y1 = llclamp((rect.mTop - 1) / tile_h, 0, TILES - 1);
+        for (S32 y = y0; y <= y1; ++y)
+        {
+            for (S32 x = x0; x <= x1; ++x)
+            {
+                tile_lights[y * TILES + x].push_back(i);
+            }
+        }
+    }
+
+    LLGLDepthTest depth(GL_FALSE);
+    LLGLEnable scissor(GL_SCISSOR_TEST);
+
+    LLVector4 light[max_count];
+    LLVector4 col[max_count];
+
+    // Full batches of every tile go through one program, then the leftover
+    // lights of each tile grouped by count, so no program is bound twice.
+    for (U32 batch = max_count; batch > 0; --batch)
+    {
+        LLGLSLShader& shader = gDeferredMultiLightProgram[batch - 1];
+        bool bound = false;
+        for (S32 t = 0; t < TILES * TILES; ++t)
+        {
+            const std::vector<U32>& indices = tile_lights[t];
+            U32 full = (U32)indices.size() / max_count * max_count;
+            U32 begin = 0;
+            U32 end = full;
+            if (batch != max_count)
+            {
+                if (indices.size() - full != batch)
+                {
+                    continue;
+                }
+                begin = full;
+                end = (U32)indices.size();
+            }
+
+            for (U32 first = begin; first < end; first += batch)
+            {
+                if (!bound)
+                {
+                    bindDeferredShader(shader);
+                    mScreenTriangleVB->setBuffer();
+                    bound = true;
+                }
+
+                F32 far_z = 0.f;
+                for (U32 j = 0; j < batch; ++j)
+                {
+                    U32 idx = indices[first + j];
+                    light[j] = lights[idx];
+                    col[j] = colors[idx];
+                    far_z = llmin(light[j].mV[2] - light[j].mV[3], far_z);
+                }
+
+                glScissor((t % TILES) * tile_w, (t / TILES) * tile_h, tile_w, tile_h);
+                shader.uniform1i(LLShaderMgr::MULTI_LIGHT_COUNT, batch);
+                shader.uniform4fv(LLShaderMgr::MULTI_LIGHT, batch, (GLfloat*)light);
+                shader.uniform4fv(LLShaderMgr::MULTI_LIGHT_COL, batch, (GLfloat*)col);
+                shader.uniform1f(LLShaderMgr::MULTI_LIGHT_FAR_Z, far_z);
+                mScreenTriangleVB->drawArrays(LLRender::TRIANGLES, 0, 3);
+            }
+        }
+        if (bound)
+        {
+            unbindDeferredShader(shader);
+        }
+    }
+}
+
 void LLPipeline::renderDeferredLighting()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
@@ -7750,6 +8461,17 @@ void LLPipeline::renderDeferredLighting()
         light_scale = mReflectionMapManager.mLightScale;
     }
 
+    if (RenderHiZOcclusion && sUseOcclusion > 1 && !gCubeSnapshot)
+    { // keep this frame's opaque depth around for culling the next frames
+        mHiZOcclusion.capture(&mRT->deferredScreen, gGLModelView, gGLProjection);
+    }
+
+    if (RenderTextureFeedback && !gCubeSnapshot && LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD)
+    { // measure the texture resolutions this view needs for texture streaming
+        mTextureFeedback.update();
+        mTextureFeedback.render(sCull, mRT->screen.getWidth(), mRT->screen.getHeight());
+    }
+
     LLRenderTarget *screen_target         = &mRT->screen;
     LLRenderTarget* deferred_light_target = &mRT->deferredLight;
 
@@ -7949,6 +8671,15 @@ void LLPipeline::renderDeferredLighting()
 
             std::list<LLVector4> light_colors;
 
+            static LLCachedControl<bool> tiled_lights(gSavedSettings, "RenderDeferredTiledLights", false);
+            static std::vector<LLVector4> tiled_light_pos;
+            static std::vector<LLVector4> tiled_light_col;
+            static std::vector<LLRect> tiled_light_rect;
+            tiled_light_pos.clear();
+            tiled_light_col.clear();
+            tiled_light_rect.clear();
+            glh::matrix4f light_mvp = copy_matrix(gGLProjection) * mat;
+
             LLVertexBuffer::unbind();
 
             {
@@ -8029,6 +8760,17 @@ void LLPipeline::renderDeferredLighting()
                             continue;
                         }
 
+                        if (tiled_lights)
+                        {
+                            glh::vec3f tc(c);
+                            mat.mult_matrix_vec(tc);
+
+                            tiled_light_pos.push_back(LLVector4(tc.v[0], tc.v[1], tc.v[2], s));
+                            tiled_light_col.push_back(LLVector4(col.mV[0], col.mV[1], col.mV[2], volume->getLightFalloff(DEFERRED_LIGHT_FALLOFF)));
+                            tiled_light_rect.push_back(light_screen_rect(light_mvp, c, s, screen_target->getWidth(), screen_target->getHeight()));
+                            continue;
+                        }
+
                         gDeferredLightProgram.uniform3fv(LLShaderMgr::LIGHT_CENTER, 1, c);
                         gDeferredLightProgram.uniform1f(LLShaderMgr::LIGHT_SIZE, s);
                         gDeferredLightProgram.uniform3fv(LLShaderMgr::DIFFUSE_COLOR, 1, col.mV);
@@ -8101,6 +8843,11 @@ void LLPipeline::renderDeferredLighting()
                 unbindDeferredShader(gDeferredSpotLightProgram);
             }
 
+            if (!tiled_light_pos.empty())
+            {
+                renderTiledLights(screen_target, tiled_light_pos, tiled_light_col, tiled_light_rect);
+            }
+
             {
                 LL_PROFILE_ZONE_NAMED_CATEGORY_PIPELINE("renderDeferredLighting - fullscreen lights");
                 LLGLDepthTest depth(GL_FALSE);
@@ -8212,6 +8959,10 @@ void LLPipeline::renderDeferredLighting()
                           LLPipeline::RENDER_TYPE_WATER,
                           END_RENDER_TYPES);
 
+        if (!gCubeSnapshot)
+        {
+            LLFrameTelemetry::markPass(LLFrameTelemetry::PASS_ALPHA);
+        }
         renderGeomPostDeferred(*LLViewerCamera::getInstance());
         popRenderTypeMask();
     }
@@ -8748,35 +9499,18 @@ static LLTrace::BlockTimerStatHandle FTM_SHADOW_ALPHA_TREE("Alpha Tree");
 static LLTrace::BlockTimerStatHandle FTM_SHADOW_ALPHA_GRASS("Alpha Grass");
 static LLTrace::BlockTimerStatHandle FTM_SHADOW_FULLBRIGHT_ALPHA_MASKED("Fullbright Alpha Masked");
 
-void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera& shadow_cam, LLCullResult& result, bool depth_clamp)
+void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera& shadow_cam, LLCullResult& result, bool depth_clamp, U32 geometry)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE; //LL_RECORD_BLOCK_TIME(FTM_SHADOW_RENDER);
     LL_PROFILE_GPU_ZONE("renderShadow");
     
     LLPipeline::sShadowRender = true;
+    mShadowGeometry = geometry;
 
     // disable occlusion culling during shadow render
     U32 saved_occlusion = sUseOcclusion;
     sUseOcclusion = 0;
 
-    // List of render pass types that use the prim volume as the shadow,
-    // ignoring textures.
-    static const U32 types[] = {
-        LLRenderPass::PASS_SIMPLE,
-        LLRenderPass::PASS_FULLBRIGHT,
-        LLRenderPass::PASS_SHINY,
-        LLRenderPass::PASS_BUMP,
-        LLRenderPass::PASS_FULLBRIGHT_SHINY,
-        LLRenderPass::PASS_MATERIAL,
-        LLRenderPass::PASS_MATERIAL_ALPHA_EMISSIVE,
-        LLRenderPass::PASS_SPECMAP,
-        LLRenderPass::PASS_SPECMAP_EMISSIVE,
-        LLRenderPass::PASS_NORMMAP,
-        LLRenderPass::PASS_NORMMAP_EMISSIVE,
-        LLRenderPass::PASS_NORMSPEC,
-        LLRenderPass::PASS_NORMSPEC_EMISSIVE
-    };
-
     LLGLEnable cull(GL_CULL_FACE);
 
     //enable depth clamping if available
@@ -8820,10 +9554,8 @@ void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera
 
         gGL.diffuseColor4f(1, 1, 1, 1);
 
-        S32 shadow_detail = gSavedSettings.getS32("RenderShadowDetail");
-
         // if not using VSM, disable color writes
-        if (shadow_detail <= 2)
+        if (RenderShadowDetail <= 2)
         {
             gGL.setColorMask(false, false);
         }
@@ -8832,7 +9564,7 @@ void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera
         LL_PROFILE_GPU_ZONE("shadow simple");
         gGL.getTexUnit(0)->disable();
 
-        for (U32 type : types)
+        for (U32 type : shadow_opaque_types)
         {
             renderObjects(type, false, false, rigged);
         }
@@ -8853,6 +9585,7 @@ void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera
         renderGeomShadow(shadow_cam);
     }
 
+    if (geometry != SHADOW_GEOM_STATIC)
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_PIPELINE("shadow alpha");
         LL_PROFILE_GPU_ZONE("shadow alpha");
@@ -8950,9 +9683,10 @@ void LLPipeline::renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera
     // reset occlusion culling flag
     sUseOcclusion = saved_occlusion;
     LLPipeline::sShadowRender = false;
+    mShadowGeometry = SHADOW_GEOM_ALL;
 }
 
-bool LLPipeline::getVisiblePointCloud(LLCamera& camera, LLVector3& min, LLVector3& max, std::vector<LLVector3>& fp, LLVector3 light_dir)
+bool LLPipeline::getVisiblePointCloud(LLCamera& camera, LLVector3& min, LLVector3& max, LLFrameVector<LLVector3>& fp, LLVector3 light_dir)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
 	//get point cloud of intersection of frust and min, max
@@ -8972,7 +9706,7 @@ bool LLPipeline::getVisiblePointCloud(LLCamera& camera, LLVector3& min, LLVector
 		LLPlane(max, LLVector3(0,0,1))};
 	
 	//potential points
-	std::vector<LLVector3> pp;
+	LLFrameVector<LLVector3> pp;
 
 	//add corners of AABB
 	pp.push_back(LLVector3(min.mV[0], min.mV[1], min.mV[2]));
@@ -9309,6 +10043,19 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 	LLVector3 lightDir = -caster_dir;
 	lightDir.normVec();
 
+	bool use_shadow_cache = RenderShadowCache && !gCubeSnapshot;
+	if (use_shadow_cache)
+	{ // hold the shadow direction until the sun has moved far enough to matter, so cached cascades stay valid
+		if (!mShadowCacheLightDir.isExactlyZero() && lightDir * mShadowCacheLightDir >= cosf(RenderShadowCacheSunAngle * DEG_TO_RAD))
+		{
+			lightDir = mShadowCacheLightDir;
+		}
+		else
+		{
+			mShadowCacheLightDir = lightDir;
+		}
+	}
+
 	glh::vec3f light_dir(lightDir.mV);
 
 	//create light space camera matrix
@@ -9331,7 +10078,7 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 	F32 near_clip = 0.f;
 	{
 		//get visible point cloud
-		std::vector<LLVector3> fp;
+		LLFrameVector<LLVector3> fp;
 
 		main_camera.calcAgentFrustumPlanes(main_camera.mAgentFrustum);
 		
@@ -9418,6 +10165,11 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 	if (mSunDiffuse == LLColor4::black)
 	{ //sun diffuse is totally black shadows don't matter
         skipRenderingShadows();
+
+        for (U32 j = 0; j < 4; ++j)
+        { // changes aren't being checked against the cascades
+            mShadowCache[j].mValid = false;
+        }
 	}
 	else
 	{
@@ -9471,7 +10223,7 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 				mShadowCamera[j] = shadow_cam;
 			}
 
-			std::vector<LLVector3> fp;
+			LLFrameVector<LLVector3> fp;
 
 			if (!gPipeline.getVisiblePointCloud(shadow_cam, min, max, fp, lightDir)
                 || j > RenderShadowSplits)
@@ -9494,6 +10246,11 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 				mShadowError.mV[j] = 0.f;
 				mShadowFOV.mV[j] = 0.f;
 
+				if (use_shadow_cache)
+				{
+					mShadowCache[j].mValid = false;
+				}
+
 				continue;
 			}
 
@@ -9501,7 +10258,7 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 			{
 				mShadowExtents[j][0] = min;
 				mShadowExtents[j][1] = max;
-				mShadowFrustPoints[j] = fp;
+				mShadowFrustPoints[j].assign(fp.begin(), fp.end());
 			}
 				
 
@@ -9511,7 +10268,7 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 			//get a temporary view projection
 			view[j] = look(camera.getOrigin(), lightDir, -up);
 
-			std::vector<LLVector3> wpf;
+			LLFrameVector<LLVector3> wpf;
 
 			for (U32 i = 0; i < fp.size(); i++)
 			{
@@ -9743,6 +10500,30 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 				}
 			}
 
+			// 0 -- render everything, 1 -- reuse the cached static casters, 2 -- render and cache the static casters
+			U32 cache_mode = 0;
+			if (use_shadow_cache)
+			{
+				ShadowCache& cache = mShadowCache[j];
+				if (cache.mValid && !mShadowCacheAllDirty &&
+					shadow_matrix_matches(view[j], cache.mView) && shadow_matrix_matches(proj[j], cache.mProj))
+				{ // snap to the cached matrices so the static depth lines up exactly
+					view[j] = cache.mView;
+					proj[j] = cache.mProj;
+					cache_mode = 1;
+				}
+				else if (shadow_matrix_matches(view[j], cache.mLastView) && shadow_matrix_matches(proj[j], cache.mLastProj))
+				{ // camera has been still for a frame, worth caching
+					cache_mode = 2;
+				}
+				else
+				{ // still moving, caching would only add a copy
+					cache.mValid = false;
+				}
+				cache.mLastView = view[j];
+				cache.mLastProj = proj[j];
+			}
+
 			//shadow_cam.setFar(128.f);
 			shadow_cam.setOriginAndLookAt(eye, up, center);
 
@@ -9777,13 +10558,64 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 		
 			stop_glerror();
 
+			if (cache_mode == 1)
+			{ // drop the cache if a static caster inside this cascade changed
+				for (auto& dirty : mShadowCacheDirty)
+				{
+					LLVector4a dirty_center;
+					LLVector4a dirty_size;
+					dirty_center.load3(dirty.first.mV);
+					dirty_size.load3(dirty.second.mV);
+					if (shadow_cam.AABBInFrustum(dirty_center, dirty_size))
+					{
+						cache_mode = 2;
+						break;
+					}
+				}
+			}
+
 			mRT->shadow[j].bindTarget();
 			mRT->shadow[j].getViewport(gGLViewport);
-			mRT->shadow[j].clear();
 		
 			{
 				static LLCullResult result[4];
-				renderShadow(view[j], proj[j], shadow_cam, result[j], true);
+				ShadowCache& cache = mShadowCache[j];
+
+				if (cache_mode == 2 &&
+					(cache.mDepth.getWidth() != mRT->shadow[j].getWidth() || cache.mDepth.getHeight() != mRT->shadow[j].getHeight()))
+				{
+					cache.mValid = false;
+					if (!cache.mDepth.allocate(mRT->shadow[j].getWidth(), mRT->shadow[j].getHeight(), 0, true))
+					{
+						cache_mode = 0;
+					}
+				}
+
+				if (cache_mode == 1)
+				{
+					LLGLDepthTest depth(GL_TRUE, GL_TRUE);
+					mRT->shadow[j].copyDepth(cache.mDepth);
+					renderShadow(view[j], proj[j], shadow_cam, result[j], true, SHADOW_GEOM_DYNAMIC);
+				}
+				else if (cache_mode == 2)
+				{
+					mRT->shadow[j].clear();
+					renderShadow(view[j], proj[j], shadow_cam, result[j], true, SHADOW_GEOM_STATIC);
+					{
+						LLGLDepthTest depth(GL_TRUE, GL_TRUE);
+						cache.mDepth.copyDepth(mRT->shadow[j]);
+					}
+					renderShadow(view[j], proj[j], shadow_cam, result[j], true, SHADOW_GEOM_DYNAMIC);
+
+					cache.mView = view[j];
+					cache.mProj = proj[j];
+					cache.mValid = true;
+				}
+				else
+				{
+					mRT->shadow[j].clear();
+					renderShadow(view[j], proj[j], shadow_cam, result[j], true);
+				}
 			}
 
 			mRT->shadow[j].flush();
@@ -9977,6 +10809,12 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
 
 	popRenderTypeMask();
 
+	if (use_shadow_cache)
+	{ // every cascade has seen the changes now
+		mShadowCacheDirty.clear();
+		mShadowCacheAllDirty = false;
+	}
+
 	if (!skip_avatar_update)
 	{
 		gAgentAvatarp->updateAttachmentVisibility(gAgentCamera.getCameraMode());
@@ -10298,6 +11136,26 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar, bool
 		resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
 
         if (!for_profile)
+        {
+            static LLCachedControl<bool> use_atlas(gSavedSettings, "RenderImpostorAtlas", false);
+            if (use_atlas && avatar->mImpostorSlot < 0)
+            {
+                avatar->mImpostorSlot = mImpostorAtlas.allocateSlot();
+            }
+            else if (!use_atlas)
+            {
+                avatar->releaseImpostorSlot();
+            }
+        }
+
+        if (!for_profile && avatar->mImpostorSlot >= 0)
+        { // atlas full or not in use falls through to a target of its own
+            avatar->mImpostor.release();
+            resX = llmin(resX, LLImpostorAtlas::SLOT_SIZE);
+            resY = llmin(resY, LLImpostorAtlas::SLOT_SIZE);
+            mImpostorAtlas.bindSlot(avatar->mImpostorSlot, resX, resY);
+        }
+        else if (!for_profile)
         {
             if (!avatar->mImpostor.isComplete())
             {
@@ -10336,7 +11194,10 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar, bool
     }
     else
 	{
-		avatar->mImpostor.clear();
+		if (avatar->mImpostorSlot < 0)
+		{ // atlas slots are cleared by bindSlot
+			avatar->mImpostor.clear();
+		}
 		renderGeomDeferred(camera);
 
 		renderGeomPostDeferred(camera);		
@@ -10423,7 +11284,15 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar, bool
 
     if (!preview_avatar && !for_profile)
     {
-        avatar->mImpostor.flush();
+        if (avatar->mImpostorSlot >= 0)
+        {
+            mImpostorAtlas.flushSlot();
+            avatar->mImpostorTexRect = LLImpostorAtlas::getTexRect(avatar->mImpostorSlot, resX, resY);
+        }
+        else
+        {
+            avatar->mImpostor.flush();
+        }
         avatar->setImpostorDim(tdim);
     }
 
@@ -38,8 +38,15 @@
 #include "llgl.h"
 #include "lldrawable.h"
 #include "llrendertarget.h"
+#include "llrendertargetpool.h"
 #include "llreflectionmapmanager.h"
+#include "llhizocclusion.h"
+#include "lltexturefeedback.h"
+#include "llimpostoratlas.h"
+#include "threadpool_fwd.h"
 
+#include <functional>
+#include <memory>
 #include <stack>
 
 class LLViewerTexture;
@@ -49,6 +56,7 @@ class LLTextureEntry;
 class LLCullResult;
 class LLVOAvatar;
 class LLVOPartGroup;
+class LLVOCachePartition;
 class LLGLSLShader;
 class LLDrawPoolAlpha;
 class LLSettingsSky;
@@ -160,6 +168,9 @@ public:
 	void combineGlow(LLRenderTarget* src, LLRenderTarget* dst);
 	void visualizeBuffers(LLRenderTarget* src, LLRenderTarget* dst, U32 bufferIndex);
 
+	// video memory held by the pipeline's render targets, largest first, for the texture console
+	std::string getRenderTargetDebugText() const;
+
 	void init();
 	void cleanup();
 	bool isInit() { return mInitialized; };
@@ -187,10 +198,10 @@ public:
 
 	// Object related methods
 	void        markVisible(LLDrawable *drawablep, LLCamera& camera);
-	void		markOccluder(LLSpatialGroup* group);
+	void		markOccluder(LLSpatialGroup* group, LLCullResult* result = NULL);
 
 	void		doOcclusion(LLCamera& camera);
-	void		markNotCulled(LLSpatialGroup* group, LLCamera &camera);
+	void		markNotCulled(LLSpatialGroup* group, LLCamera &camera, LLCullResult* result = NULL);
 	void        markMoved(LLDrawable *drawablep, bool damped_motion = false);
 	void        markShift(LLDrawable *drawablep);
 	void        markTextured(LLDrawable *drawablep);
@@ -249,13 +260,27 @@ public:
 	void updateMoveDampedAsync(LLDrawable* drawablep);
 	void updateMoveNormalAsync(LLDrawable* drawablep);
 	void updateMovedList(LLDrawable::drawable_vector_t& move_list);
+	bool queueFaceCenterUpdate(LLDrawable* drawablep); // false unless updateMovedList is collecting face center updates
+	void updateMovedFaceCenters();
 	void updateMove();
 	bool visibleObjectsInFrustum(LLCamera& camera);
 	bool getVisibleExtents(LLCamera& camera, LLVector3 &min, LLVector3& max);
-	bool getVisiblePointCloud(LLCamera& camera, LLVector3 &min, LLVector3& max, std::vector<LLVector3>& fp, LLVector3 light_dir = LLVector3(0,0,0));
+	bool getVisiblePointCloud(LLCamera& camera, LLVector3 &min, LLVector3& max, LLFrameVector<LLVector3>& fp, LLVector3 light_dir = LLVector3(0,0,0));
 
     // Populate given LLCullResult with results of a frustum cull of the entire scene against the given LLCamera
 	void updateCull(LLCamera& camera, LLCullResult& result);
+
+    // Frustum cull the spatial partitions of every region on mPipelineThreadPool, each partition into its own
+    // LLCullResult, then append those results to sCull in the same order the serial path would have produced them.
+    // Only valid when no occlusion queries need to be read back (sUseOcclusion < 2), as that requires the GL thread.
+    void parallelCull(LLCamera& camera);
+
+    // Call func(i) for every i in [0, count) spread across mPipelineThreadPool and the calling thread, returning
+    // once every call has completed. main_thread_work, if any, runs on the calling thread while the workers start.
+    // Calls may happen in any order, so func must only touch state owned by index i.
+    void runParallel(U32 count, const std::function<void(U32)>& func, const std::function<void()>& main_thread_work = std::function<void()>());
+    // queue of mPipelineThreadPool, for work that schedules itself (e.g. LL::TaskGraph); NULL before init
+    LL::WorkQueueBase* getThreadPoolQueue();
 	void createObjects(F32 max_dtime);
 	void createObject(LLViewerObject* vobj);
 	void processPartitionQ();
@@ -319,6 +344,11 @@ public:
 
 	void renderDeferredLighting();
 
+    // shade local point lights with the multi light shaders, one pass per
+    // screen tile and batch of lights overlapping it
+    void renderTiledLights(LLRenderTarget* target, const std::vector<LLVector4>& lights,
+                           const std::vector<LLVector4>& colors, const std::vector<LLRect>& rects);
+
     // apply atmospheric haze based on contents of color and depth buffer
     // should be called just before rendering water when camera is under water 
     // and just before rendering alpha when camera is above water
@@ -336,7 +366,18 @@ public:
 
 	void renderHighlight(const LLViewerObject* obj, F32 fade);
 	
-	void renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera& camera, LLCullResult& result, bool depth_clamp);
+	// which casters renderShadow draws, so the static part of a sun shadow cascade can be cached
+	enum EShadowGeometry
+	{
+		SHADOW_GEOM_ALL,
+		SHADOW_GEOM_STATIC,		// opaque, unrigged geometry of region partitions and terrain
+		SHADOW_GEOM_DYNAMIC		// everything else
+	};
+
+	void renderShadow(glh::matrix4f& view, glh::matrix4f& proj, LLCamera& camera, LLCullResult& result, bool depth_clamp, U32 geometry = SHADOW_GEOM_ALL);
+
+	// a static shadow caster in group changed, invalidate the cached cascades it falls in
+	void markShadowCacheDirty(LLSpatialGroup* group);
 	void renderHighlights();
 	void renderDebug();
 	void renderPhysicsDisplay();
@@ -446,6 +487,11 @@ public:
 	static void setRenderHighlightTextureChannel(LLRender::eTexIndex channel); // sets which UV setup to display in highlight overlay
 
 	static void updateRenderTransparentWater();
+	// Water traces screen space reflections against the scene it copies for
+	// refraction (RenderWaterScreenSpaceReflections) instead of relying on the
+	// reflection probes alone. Off when general screen space reflections are
+	// on, since those already cover water.
+	static bool useWaterScreenSpaceReflections();
 	static void refreshCachedSettings();
 
 	void addDebugBlip(const LLVector3& position, const LLColor4& color);
@@ -459,6 +505,15 @@ public:
 
     LLReflectionMapManager mReflectionMapManager;
 
+    // depth pyramid of the last frames for occlusion culling the main camera
+    LLHiZOcclusion mHiZOcclusion;
+
+    // texture resolutions measured on the GPU for texture streaming
+    LLTextureFeedback mTextureFeedback;
+
+    // shared target of avatar impostors when RenderImpostorAtlas is on
+    LLImpostorAtlas mImpostorAtlas;
+
 private:
 	void unloadShaders();
 	void addToQuickLookup( LLDrawPool* new_poolp );
@@ -682,7 +737,6 @@ public:
         LLRenderTarget			screen;
         LLRenderTarget			uiScreen;
         LLRenderTarget			deferredScreen;
-        LLRenderTarget			fxaaBuffer;
         LLRenderTarget			edgeMap;
         LLRenderTarget			deferredLight;
 
@@ -712,13 +766,21 @@ public:
     LLRenderTarget          mExposureMap;
     LLRenderTarget          mLastExposure;
 
-    // tonemapped and gamma corrected render ready for post
-    LLRenderTarget          mPostMap;
+    // targets that only live within a pass or two of renderFinalize
+    // (tonemapped post map, FXAA scratch), shared between passes
+    LLRenderTargetPool      mTargetPool;
 
     LLCullResult            mSky;
     LLCullResult            mReflectedObjects;
     LLCullResult            mRefractedObjects;
 
+    // worker threads for runParallel and per-partition scratch results for parallelCull (see "RenderParallelCull")
+    LL::ThreadPool*                 mPipelineThreadPool;
+    std::vector<LLSpatialPartition*> mCullPartitions;
+    std::vector<std::unique_ptr<LLCullResult> > mCullResults;
+    std::vector<LLVOCachePartition*> mCullVOPartitions; // object cache trees culled on the workers, see parallelCull
+    std::vector<S32>                mCullVOResults;
+
 	//utility buffers for rendering post effects
 	LLPointer<LLVertexBuffer> mDeferredVB;
 
@@ -743,6 +805,24 @@ public:
 	glh::matrix4f			mShadowProjection[6];
     glh::matrix4f           mReflectionModelView;
 
+	// depth of the static casters of each sun shadow cascade, reused while
+	// the cascade's matrices stay put and nothing static inside it changes
+	struct ShadowCache
+	{
+		LLRenderTarget		mDepth;
+		glh::matrix4f		mView;		// matrices mDepth was rendered with
+		glh::matrix4f		mProj;
+		glh::matrix4f		mLastView;	// matrices of the last frame, to tell when the camera has come to rest
+		glh::matrix4f		mLastProj;
+		bool				mValid = false;
+	};
+	ShadowCache				mShadowCache[4];
+	LLVector3				mShadowCacheLightDir;
+	// center and half size of static groups that changed since the cascades were last checked
+	std::vector<std::pair<LLVector3, LLVector3> > mShadowCacheDirty;
+	bool					mShadowCacheAllDirty = false;
+	U32						mShadowGeometry = SHADOW_GEOM_ALL;
+
 	LLPointer<LLDrawable>	mShadowSpotLight[2];
 	F32						mSpotLightFade[2];
 	LLPointer<LLDrawable>	mTargetShadowSpotLight[2];
@@ -791,6 +871,9 @@ protected:
 	//
 	LLDrawable::drawable_vector_t	mMovedList;
 	LLDrawable::drawable_vector_t mMovedBridge;
+	std::vector<LLDrawable*>		mMovedFaceDrawables; // drawables on the move list whose face centers need updating
+	bool							mQueueFaceCenters;
+	std::vector<bool>				mMovedListDone;
 	LLDrawable::drawable_vector_t	mShiftList;
 
 	/////////////////////////////////////////////
@@ -973,6 +1056,8 @@ public:
 	static F32 RenderDeferredSunWash;
 	static U32 RenderFSAASamples;
 	static U32 RenderResolutionDivisor;
+	static F32 RenderResolutionScale;
+	static F32 RenderUpscaleSharpness;
 	static bool RenderUIBuffer;
 	static S32 RenderShadowDetail;
     static S32 RenderShadowSplits;
@@ -1040,6 +1125,10 @@ public:
 	static F32 CameraDoFResScale;
 	static F32 RenderAutoHideSurfaceAreaLimit;
 	static bool RenderScreenSpaceReflections;
+    static bool RenderHiZOcclusion;
+    static bool RenderTextureFeedback;
+    static bool RenderShadowCache;
+    static F32 RenderShadowCacheSunAngle;
     static S32 RenderScreenSpaceReflectionIterations;
 	static F32 RenderScreenSpaceReflectionRayStep;
 	static F32 RenderScreenSpaceReflectionDistanceBias;
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""\
+
+This script lists settings that are looked up by name on every call.
+
+$LicenseInfo:firstyear=2023&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2023, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+import argparse
+import os
+import re
+import sys
+
+usage_msg="""%(prog)s [options] [files]
+
+Finds gSavedSettings.getXXX("Name") calls, which hash the name and look
+it up in the control group every time they run, and prints them with
+the function they are in. Lookups in functions that only run on
+startup or on a settings change are skipped (see --skip). Anything left
+that runs per frame, per object or per draw should use a static
+LLCachedControl, or a cached static refreshed from
+LLPipeline::refreshCachedSettings() for pipeline settings.
+
+With no files, the render and avatar hot spots in indra/newview are
+checked.
+"""
+
+DEFAULT_FILES = ["pipeline.cpp", "llviewerdisplay.cpp", "llvoavatar.cpp"]
+DEFAULT_SKIP = ["refreshCachedSettings", "init", "initClass", "cleanupClass",
+                "createGLBuffers", "createLUTBuffers", "allocateScreenBuffer",
+                "updateRenderTransparentWater", "handleShadowDetailChanged",
+                "connectRefreshCachedSettingsSafe"]
+
+lookup_re = re.compile(r'gSavedSettings\.get(\w+)\(\s*"([^"]+)"')
+# a function definition starts at column 0
+function_re = re.compile(r'^[A-Za-z_][\w:<>,\s\*&]*?\b([\w~]+)\s*\([^;]*$')
+
+def scan(path, skip):
+    found = []
+    function = ""
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line_num, line in enumerate(f, 1):
+            match = function_re.match(line)
+            if match:
+                function = match.group(1)
+            stripped = line.strip()
+            if stripped.startswith("//"):
+                continue
+            for lookup in lookup_re.finditer(line):
+                if function in skip:
+                    continue
+                found.append((line_num, function, lookup.group(1), lookup.group(2)))
+    return found
+
+def main():
+    parser = argparse.ArgumentParser(description="List uncached settings lookups", usage=usage_msg)
+    parser.add_argument("files", nargs="*", help="source files to check")
+    parser.add_argument("--skip", action="append", default=None,
+                        help="function names whose lookups are fine (default: startup and change handlers)")
+    args = parser.parse_args()
+
+    files = args.files
+    if not files:
+        newview = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "indra", "newview")
+        files = [os.path.join(newview, name) for name in DEFAULT_FILES]
+    skip = set(args.skip if args.skip is not None else DEFAULT_SKIP)
+
+    total = 0
+    for path in files:
+        for line_num, function, type_name, name in scan(path, skip):
+            print("%s:%d: %s() get%s(\"%s\")" % (path, line_num, function, type_name, name))
+            total += 1
+    print("%d uncached lookups" % total)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,320 @@
+#!/usr/bin/env python3
+"""\
+@file generate_message_decoders.py
+@brief Generates typed decoders for messages in the message template.
+
+$LicenseInfo:firstyear=2023&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2023, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+"""generate_message_decoders writes a C++ header with one struct per named
+message, e.g. LLMsgCoarseLocationUpdate for CoarseLocationUpdate. Each block
+of the message becomes a nested record struct with typed members read at
+fixed offsets, and decode() checks the body against the template layout
+once, so handlers registered with LLMessageSystem::setRawHandlerFuncFast()
+can read fields without the generic reader's per-field lookups.
+
+usage: generate_message_decoders.py TEMPLATE OUTPUT MESSAGE...
+"""
+
+import sys
+import os.path
+
+def add_indra_lib_path():
+    root = os.path.realpath(__file__)
+    while root != os.path.sep:
+        root = os.path.dirname(root)
+        dir = os.path.join(root, 'indra', 'lib', 'python')
+        if os.path.isdir(dir):
+            if dir not in sys.path:
+                sys.path.insert(0, dir)
+            return
+    print("This script is not inside a valid installation.", file=sys.stderr)
+    sys.exit(1)
+
+add_indra_lib_path()
+
+from indra.ipc import llmessage
+
+# template type: (C++ type, message variable type, size in bytes, member of the
+# C++ type the bytes are copied to)
+FIXED_TYPES = {
+    'U8': ('U8', 'MVT_U8', 1, ''),
+    'S8': ('S8', 'MVT_S8', 1, ''),
+    'U16': ('U16', 'MVT_U16', 2, ''),
+    'S16': ('S16', 'MVT_S16', 2, ''),
+    'U32': ('U32', 'MVT_U32', 4, ''),
+    'S32': ('S32', 'MVT_S32', 4, ''),
+    'F32': ('F32', 'MVT_F32', 4, ''),
+    'U64': ('U64', 'MVT_U64', 8, ''),
+    'S64': ('S64', 'MVT_S64', 8, ''),
+    'F64': ('F64', 'MVT_F64', 8, ''),
+    'LLUUID': ('LLUUID', 'MVT_LLUUID', 16, '.mData'),
+    'LLVector3': ('LLVector3', 'MVT_LLVector3', 12, '.mV'),
+    'LLVector3d': ('LLVector3d', 'MVT_LLVector3d', 24, '.mdV'),
+    'LLVector4': ('LLVector4', 'MVT_LLVector4', 16, '.mV'),
+}
+
+INCLUDES = {
+    'LLUUID': 'lluuid.h',
+    'LLVector3': 'v3math.h',
+    'LLVector3d': 'v3dmath.h',
+    'LLVector4': 'v4math.h',
+    'LLQuaternion': 'llquaternion.h',
+}
+
+class Field:
+    def __init__(self, var, block_name):
+        # a member can't have the name of its struct
+        self.name = var.name if var.name != block_name else var.name + "Field"
+        self.type = var.type
+        if var.type == 'Variable':
+            self.prefix = int(var.size)
+            self.size = None
+        elif var.type == 'Fixed':
+            self.size = int(var.size)
+        elif var.type in ('BOOL',):
+            self.size = 1
+        elif var.type == 'LLQuaternion':
+            # sent as x, y, z with w inferred
+            self.size = 12
+        elif var.type in FIXED_TYPES:
+            self.size = FIXED_TYPES[var.type][2]
+        else:
+            raise ValueError("%s fields are not supported by the decoders" % var.type)
+
+    def members(self):
+        if self.type == 'Variable':
+            return ["const U8* %s;" % self.name, "S32 %sSize;" % self.name]
+        if self.type == 'Fixed':
+            return ["const U8* %s;	// %d bytes" % (self.name, self.size)]
+        if self.type == 'BOOL':
+            return ["bool %s;" % self.name]
+        if self.type == 'LLQuaternion':
+            return ["LLQuaternion %s;" % self.name]
+        return ["%s %s;" % (FIXED_TYPES[self.type][0], self.name)]
+
+    def decode(self, at):
+        """lines reading this field from data + at"""
+        if self.type == 'Variable':
+            return ["%sSize = ll_msg_variable_size(data + %s, %d);" % (self.name, at, self.prefix),
+                    "%s = data + %s + %d;" % (self.name, at, self.prefix)]
+        if self.type == 'Fixed':
+            return ["%s = data + %s;" % (self.name, at)]
+        if self.type == 'BOOL':
+            return ["%s = data[%s] != 0;" % (self.name, at)]
+        if self.type == 'LLQuaternion':
+            return ["{",
+                    "\tLLVector3 vec;",
+                    "\thtolememcpy(vec.mV, data + %s, MVT_LLVector3, 12);" % at,
+                    "\tif (vec.isFinite())",
+                    "\t{",
+                    "\t\t%s.unpackFromVector3(vec);" % self.name,
+                    "\t}",
+                    "\telse",
+                    "\t{",
+                    "\t\t%s.loadIdentity();" % self.name,
+                    "\t}",
+                    "}"]
+        ctype, mvt, size, member = FIXED_TYPES[self.type]
+        target = ("%s%s" % (self.name, member)) if member else ("&%s" % self.name)
+        lines = ["htolememcpy(%s, data + %s, %s, %d);" % (target, at, mvt, size)]
+        if self.type in ('LLVector3', 'LLVector3d', 'LLVector4'):
+            # same as the generic getters
+            lines.append("if (!%s.isFinite()) %s.%s();" % (self.name, self.name,
+                         'zeroVec' if self.type != 'LLVector4' else 'clear'))
+        return lines
+
+class Block:
+    def __init__(self, block):
+        self.name = block.name
+        self.repeat = block.repeat
+        self.count = block.count
+        self.fields = [Field(v, block.name) for v in block.variables]
+        if any(f.type == 'Variable' for f in self.fields):
+            self.size = 0
+        else:
+            self.size = sum(f.size for f in self.fields)
+
+    def emit(self, out):
+        out.append("\tstruct %s" % self.name)
+        out.append("\t{")
+        out.append("\t\tstatic const S32 SIZE = %d;%s" % (self.size,
+                   "" if self.size else "	// has Variable fields"))
+        out.append("")
+        for f in self.fields:
+            for m in f.members():
+                out.append("\t\t" + m)
+        out.append("")
+
+        # measure
+        out.append("\t\t// bytes taken by count records, -1 if they run past size")
+        out.append("\t\tstatic S32 measure(const U8* data, S32 size, S32 count)")
+        out.append("\t\t{")
+        if self.size:
+            out.append("\t\t\tS64 length = (S64)count * SIZE;")
+            out.append("\t\t\treturn length <= size ? (S32)length : -1;")
+        else:
+            out.append("\t\t\tS32 pos = 0;")
+            out.append("\t\t\tfor (S32 i = 0; i < count; ++i)")
+            out.append("\t\t\t{")
+            fixed = 0
+            for f in self.fields:
+                if f.type != 'Variable':
+                    fixed += f.size
+                    continue
+                out.append("\t\t\t\tif (pos + %d > size) return -1;" % (fixed + f.prefix))
+                at = ("pos + %d" % fixed) if fixed else "pos"
+                out.append("\t\t\t\tpos += %d + ll_msg_variable_size(data + %s, %d);" % (fixed + f.prefix, at, f.prefix))
+                fixed = 0
+            if fixed:
+                out.append("\t\t\t\tpos += %d;" % fixed)
+            out.append("\t\t\t\tif (pos > size) return -1;")
+            out.append("\t\t\t}")
+            out.append("\t\t\treturn pos;")
+        out.append("\t\t}")
+        out.append("")
+
+        # decode, offsets are constant up to the first Variable field
+        out.append("\t\tvoid decode(const U8* data)")
+        out.append("\t\t{")
+        variable = not self.size
+        if variable:
+            out.append("\t\t\tS32 pos = 0;")
+        last_variable = [f for f in self.fields if f.type == 'Variable'][-1] if variable else None
+        offset = 0
+        for f in self.fields:
+            if variable:
+                at = ("pos + %d" % offset) if offset else "pos"
+            else:
+                at = str(offset)
+            for line in f.decode(at):
+                out.append("\t\t\t" + line)
+            if f.type == 'Variable':
+                if f is not last_variable:
+                    out.append("\t\t\tpos += %d + %sSize;" % (offset + f.prefix, f.name))
+                offset = 0
+            else:
+                offset += f.size
+        out.append("\t\t}")
+        out.append("\t};")
+        out.append("")
+
+    def member(self):
+        if self.repeat == 'Single':
+            return "%s m%s;" % (self.name, self.name)
+        return "LLMsgBlockArray<%s> m%s;" % (self.name, self.name)
+
+    def emit_decode(self, out):
+        out.append("\t\t// %s, %s%s" % (self.name, self.repeat,
+                   (" %s" % self.count) if self.count else ""))
+        if self.repeat == 'Single':
+            out.append("\t\tcount = 1;")
+        elif self.repeat == 'Multiple':
+            out.append("\t\tcount = %s;" % self.count)
+        else:
+            # a missing count at the end of the body means no records
+            out.append("\t\tcount = pos < size ? data[pos++] : 0;")
+        out.append("\t\tlength = %s::measure(data + pos, size - pos, count);" % self.name)
+        out.append("\t\tif (length < 0) return false;")
+        if self.repeat == 'Single':
+            out.append("\t\tm%s.decode(data + pos);" % self.name)
+        else:
+            out.append("\t\tm%s.set(data + pos, count);" % self.name)
+        out.append("\t\tpos += length;")
+        out.append("")
+
+def emit_message(message, out):
+    blocks = [Block(b) for b in message.blocks]
+    out.append("// %s, %s %s" % (message.name, message.priority, message.number))
+    out.append("struct LLMsg%s" % message.name)
+    out.append("{")
+    for b in blocks:
+        b.emit(out)
+    for b in blocks:
+        out.append("\t" + b.member())
+    out.append("")
+    out.append("\t// false if the body is shorter than the template says")
+    out.append("\tbool decode(const U8* data, S32 size)")
+    out.append("\t{")
+    out.append("\t\tS32 pos = 0;")
+    out.append("\t\tS32 count;")
+    out.append("\t\tS32 length;")
+    out.append("")
+    for b in blocks:
+        b.emit_decode(out)
+    out.append("\t\treturn true;")
+    out.append("\t}")
+    out.append("};")
+    out.append("")
+
+def main(argv):
+    if len(argv) < 4:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 1
+    template_file, output_file, names = argv[1], argv[2], argv[3:]
+
+    with open(template_file) as f:
+        template = llmessage.parseTemplateString(f.read())
+
+    includes = set()
+    body = []
+    for name in names:
+        message = template.messages.get(name)
+        if message is None:
+            print("%s is not in %s" % (name, template_file), file=sys.stderr)
+            return 1
+        for block in message.blocks:
+            for var in block.variables:
+                if var.type in INCLUDES:
+                    includes.add(INCLUDES[var.type])
+        try:
+            emit_message(message, body)
+        except ValueError as e:
+            print("%s: %s" % (name, e), file=sys.stderr)
+            return 1
+
+    out = []
+    out.append("// Generated by generate_message_decoders.py from %s, do not edit."
+               % os.path.basename(template_file))
+    out.append("")
+    out.append("#ifndef LL_LLMESSAGEDECODERS_H")
+    out.append("#define LL_LLMESSAGEDECODERS_H")
+    out.append("")
+    out.append('#include "llmessagedecoder.h"')
+    for include in sorted(includes):
+        out.append('#include "%s"' % include)
+    out.append("")
+    out.extend(body)
+    out.append("#endif // LL_LLMESSAGEDECODERS_H")
+
+    text = "\n".join(out) + "\n"
+    # leave the header alone when nothing changed so dependents don't rebuild
+    if os.path.exists(output_file):
+        with open(output_file) as f:
+            if f.read() == text:
+                return 0
+    with open(output_file, "w") as f:
+        f.write(text)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))